@@ -0,0 +1,564 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* Scaling benchmarks of the collective algorithms of libsc.
+ *
+ * The communicator is split into the first 2, 4, 8, ... ranks and the
+ * whole world.  On each size, every sc_notify type is timed for several
+ * fan-outs and payload sizes, the allgather and reduce algorithms against
+ * native MPI, and the parallel sorts.  Each rank averages its call times,
+ * and the minimum, average and maximum over the ranks go into a CSV file.
+ * From the notify times on the whole world, the fastest type for each
+ * message size regime can be written in the format of
+ * sc_notify_auto_load to preset the tuning of SC_NOTIFY_AUTO.
+ *
+ * The maximum over the ranks of each timed call is also recorded in an
+ * sc_bench suite, which can be stored as or checked against a baseline.
+ */
+
+#include "sc_bench.h"
+#include <sc_allgather.h>
+#include <sc_notify.h>
+#include <sc_options.h>
+#include <sc_random.h>
+#include <sc_reduce.h>
+#include <sc_sort.h>
+#include <sc_statistics.h>
+
+/* the fan-outs of the notify benchmark, capped by the communicator size */
+static const int    bench_fanouts[] = { 1, 4, 16 };
+
+typedef struct bench_coll
+{
+  sc_MPI_Comm         comm;
+  int                 size, rank;
+  int                 world_size;
+  int                 samples;
+  int                 fanout;
+  size_t              bytes;
+  FILE               *csv;      /* only on rank 0 */
+  sc_bench_t         *bench;    /* results only on rank 0 */
+
+  /* notify */
+  sc_notify_t        *notify;
+  sc_array_t         *receivers, *senders, *in_payload, *out_payload;
+  double              auto_time[SC_NOTIFY_NUM_REGIMES][SC_NOTIFY_NUM_TYPES];
+  int                 auto_valid[SC_NOTIFY_NUM_REGIMES];
+
+  /* allgather, reduce and sort */
+  char               *sendbuf, *recvbuf;
+  size_t             *nmemb;
+  sc_rand_state_t     state;
+}
+bench_coll_t;
+
+typedef void        (*bench_coll_op_t) (bench_coll_t * bc);
+
+/* time an operation and record min, avg and max over the ranks */
+static double
+bench_coll_time (bench_coll_t * bc, const char *benchmark,
+                 const char *variant, bench_coll_op_t prepare,
+                 bench_coll_op_t op)
+{
+  int                 mpiret;
+  int                 i;
+  double              start, sum;
+  double             *times, *maxes;
+  char                name[SC_BENCH_NAME_LENGTH];
+  sc_statinfo_t       si;
+
+  snprintf (name, SC_BENCH_NAME_LENGTH, "%s/%s/%d/%d/%llu", benchmark,
+            variant, bc->size, bc->fanout, (unsigned long long) bc->bytes);
+  if (!sc_bench_wanted (bc->bench, name)) {
+    return -1.;
+  }
+
+  /* one untimed call to set up communication paths */
+  if (prepare != NULL) {
+    prepare (bc);
+  }
+  op (bc);
+
+  times = SC_ALLOC (double, 2 * bc->samples);
+  maxes = times + bc->samples;
+  sum = 0.;
+  for (i = 0; i < bc->samples; ++i) {
+    if (prepare != NULL) {
+      prepare (bc);
+    }
+    mpiret = sc_MPI_Barrier (bc->comm);
+    SC_CHECK_MPI (mpiret);
+    start = sc_MPI_Wtime ();
+    op (bc);
+    sum += times[i] = sc_MPI_Wtime () - start;
+  }
+  sc_stats_set1 (&si, sum / bc->samples, variant);
+  sc_stats_compute (bc->comm, 1, &si);
+
+  /* a collective call takes as long as its slowest process */
+  mpiret = sc_MPI_Reduce (times, maxes, bc->samples, sc_MPI_DOUBLE,
+                          sc_MPI_MAX, 0, bc->comm);
+  SC_CHECK_MPI (mpiret);
+  if (bc->rank == 0) {
+    for (i = 0; i < bc->samples; ++i) {
+      maxes[i] *= 1.e9;
+    }
+    sc_bench_record (bc->bench, name, 1, 1, bc->samples, maxes);
+  }
+  SC_FREE (times);
+
+  if (bc->csv != NULL) {
+    fprintf (bc->csv, "%s,%s,%d,%d,%llu,%d,%.6e,%.6e,%.6e\n",
+             benchmark, variant, bc->size, bc->fanout,
+             (unsigned long long) bc->bytes, bc->samples,
+             si.min, si.average, si.max);
+  }
+  return si.max;
+}
+
+/* the regime in which sc_notify_payload tunes a payload size */
+static              sc_notify_regime_t
+bench_coll_regime (bench_coll_t * bc)
+{
+  if (bc->bytes > 0 &&
+      bc->bytes <= sc_notify_get_eager_threshold (bc->notify)) {
+    return bc->bytes <= SC_NOTIFY_AUTO_SMALL ?
+      SC_NOTIFY_REGIME_SMALL : SC_NOTIFY_REGIME_EAGER;
+  }
+  return SC_NOTIFY_REGIME_NONE;
+}
+
+/* some algorithms modify their input, and the output must be empty */
+static void
+bench_coll_notify_prepare (bench_coll_t * bc)
+{
+  sc_array_truncate (bc->senders);
+  if (bc->in_payload != NULL) {
+    sc_array_resize (bc->in_payload, (size_t) bc->fanout);
+    sc_array_truncate (bc->out_payload);
+  }
+}
+
+static void
+bench_coll_notify (bench_coll_t * bc)
+{
+  sc_notify_payload (bc->receivers, bc->senders, bc->in_payload,
+                     bc->out_payload, 1, bc->notify);
+}
+
+static void
+bench_coll_notify_all (bench_coll_t * bc)
+{
+  int                 j, k, f, last;
+  int                *r;
+  double              t;
+  sc_notify_regime_t  regime;
+
+  bc->receivers = sc_array_new (sizeof (int));
+  bc->senders = sc_array_new (sizeof (int));
+  for (last = -1, f = 0;
+       f < (int) (sizeof (bench_fanouts) / sizeof (int)); ++f) {
+    if ((bc->fanout = SC_MIN (bench_fanouts[f], bc->size - 1)) == last) {
+      continue;
+    }
+    last = bc->fanout;
+
+    /* notify the next ranks in a cyclic order */
+    sc_array_resize (bc->receivers, (size_t) bc->fanout);
+    for (k = 0; k < bc->fanout; ++k) {
+      r = (int *) sc_array_index_int (bc->receivers, k);
+      *r = (bc->rank + 1 + k) % bc->size;
+    }
+    sc_array_sort (bc->receivers, sc_int_compare);
+
+    bc->in_payload = bc->out_payload = NULL;
+    if (bc->bytes > 0) {
+      bc->in_payload = sc_array_new_count (bc->bytes, (size_t) bc->fanout);
+      bc->out_payload = sc_array_new (bc->bytes);
+      if (bc->fanout > 0) {
+        memset (bc->in_payload->array, bc->rank & 0xff,
+                bc->in_payload->elem_count * bc->bytes);
+      }
+    }
+
+    for (j = 0; j < SC_NOTIFY_NUM_TYPES; ++j) {
+      /* the superset needs application knowledge, some algorithms
+         require a more recent MPI, and some MPI builds refuse to create
+         the window of rsx on a single process */
+      if (j == SC_NOTIFY_SUPERSET ||
+          (j == SC_NOTIFY_RSX && bc->size == 1) ||
+          ((j == SC_NOTIFY_PCX || j == SC_NOTIFY_RSX || j == SC_NOTIFY_NBX)
+           && !sc_notify_auto_is_candidate ((sc_notify_type_t) j))) {
+        continue;
+      }
+      bc->notify = sc_notify_new (bc->comm);
+      sc_notify_set_type (bc->notify, (sc_notify_type_t) j);
+      t = bench_coll_time (bc, "notify", sc_notify_type_strings[j],
+                           bench_coll_notify_prepare, bench_coll_notify);
+
+      /* the whole world decides the tuning table */
+      if (t >= 0. && bc->size == bc->world_size &&
+          sc_notify_auto_is_candidate ((sc_notify_type_t) j)) {
+        regime = bench_coll_regime (bc);
+        bc->auto_time[regime][j] += t;
+        bc->auto_valid[regime] = 1;
+      }
+      sc_notify_destroy (bc->notify);
+    }
+    if (bc->bytes > 0) {
+      sc_array_destroy (bc->in_payload);
+      sc_array_destroy (bc->out_payload);
+    }
+  }
+  sc_array_destroy (bc->receivers);
+  sc_array_destroy (bc->senders);
+  bc->fanout = 0;
+}
+
+static void
+bench_coll_prepare_block (bench_coll_t * bc)
+{
+  memcpy (bc->recvbuf + bc->rank * bc->bytes, bc->sendbuf, bc->bytes);
+}
+
+static void
+bench_coll_allgather (bench_coll_t * bc)
+{
+  sc_allgather (bc->sendbuf, (int) bc->bytes, sc_MPI_BYTE, bc->recvbuf,
+                (int) bc->bytes, sc_MPI_BYTE, bc->comm);
+}
+
+static void
+bench_coll_allgather_recursive (bench_coll_t * bc)
+{
+  sc_allgather_recursive (bc->comm, bc->recvbuf, bc->bytes, bc->size,
+                          bc->rank, bc->rank);
+}
+
+static void
+bench_coll_allgather_alltoall (bench_coll_t * bc)
+{
+  sc_allgather_alltoall (bc->comm, bc->recvbuf, bc->bytes, bc->size,
+                         bc->rank, bc->rank);
+}
+
+static void
+bench_coll_allgather_ring (bench_coll_t * bc)
+{
+  sc_allgather_ring (bc->comm, bc->recvbuf, bc->bytes, bc->size,
+                     bc->rank, bc->rank, SC_AG_SEGMENT);
+}
+
+static void
+bench_coll_allgather_bruck (bench_coll_t * bc)
+{
+  sc_allgather_bruck (bc->comm, bc->recvbuf, bc->bytes, bc->size,
+                      bc->rank, bc->rank);
+}
+
+static void
+bench_coll_allgather_native (bench_coll_t * bc)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Allgather (bc->sendbuf, (int) bc->bytes, sc_MPI_BYTE,
+                             bc->recvbuf, (int) bc->bytes, sc_MPI_BYTE,
+                             bc->comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+bench_coll_allreduce (bench_coll_t * bc)
+{
+  sc_allreduce (bc->sendbuf, bc->recvbuf, (int) (bc->bytes / 8),
+                sc_MPI_DOUBLE, sc_MPI_SUM, bc->comm);
+}
+
+static void
+bench_coll_reduce (bench_coll_t * bc)
+{
+  sc_reduce (bc->sendbuf, bc->recvbuf, (int) (bc->bytes / 8),
+             sc_MPI_DOUBLE, sc_MPI_SUM, 0, bc->comm);
+}
+
+static void
+bench_coll_allreduce_native (bench_coll_t * bc)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Allreduce (bc->sendbuf, bc->recvbuf, (int) (bc->bytes / 8),
+                             sc_MPI_DOUBLE, sc_MPI_SUM, bc->comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+bench_coll_reduce_native (bench_coll_t * bc)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Reduce (bc->sendbuf, bc->recvbuf, (int) (bc->bytes / 8),
+                          sc_MPI_DOUBLE, sc_MPI_SUM, 0, bc->comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+bench_coll_prepare_sort (bench_coll_t * bc)
+{
+  int                 i;
+  double             *items = (double *) bc->sendbuf;
+
+  for (i = 0; i < bc->size; ++i) {
+    bc->nmemb[i] = bc->bytes / sizeof (double);
+  }
+  for (i = 0; i < (int) (bc->bytes / sizeof (double)); ++i) {
+    items[i] = sc_rand (&bc->state);
+  }
+}
+
+static void
+bench_coll_psort (bench_coll_t * bc)
+{
+  sc_psort (bc->comm, bc->sendbuf, bc->nmemb, sizeof (double),
+            sc_double_compare);
+}
+
+static void
+bench_coll_psort_sample (bench_coll_t * bc)
+{
+  sc_psort_sample (bc->comm, bc->sendbuf, bc->nmemb, sizeof (double),
+                   sc_double_compare, NULL);
+}
+
+static void
+bench_coll_buffers (bench_coll_t * bc)
+{
+  size_t              zz;
+  double             *d;
+
+  bc->sendbuf = SC_ALLOC (char, bc->bytes);
+  bc->recvbuf = SC_ALLOC (char, bc->bytes * bc->size);
+  d = (double *) bc->sendbuf;
+  for (zz = 0; zz < bc->bytes / sizeof (double); ++zz) {
+    d[zz] = bc->rank + 1. / (zz + 1.);
+  }
+}
+
+static void
+bench_coll_sweep (bench_coll_t * bc, size_t max_bytes)
+{
+  for (bc->bytes = 0; bc->bytes <= max_bytes;
+       bc->bytes = bc->bytes == 0 ? 16 : 16 * bc->bytes) {
+    bench_coll_notify_all (bc);
+    if (bc->bytes == 0) {
+      continue;
+    }
+
+    bench_coll_buffers (bc);
+    bench_coll_time (bc, "allgather", "sc_allgather",
+                     bench_coll_prepare_block, bench_coll_allgather);
+    bench_coll_time (bc, "allgather", "recursive",
+                     bench_coll_prepare_block,
+                     bench_coll_allgather_recursive);
+    bench_coll_time (bc, "allgather", "alltoall",
+                     bench_coll_prepare_block,
+                     bench_coll_allgather_alltoall);
+    bench_coll_time (bc, "allgather", "ring",
+                     bench_coll_prepare_block, bench_coll_allgather_ring);
+    bench_coll_time (bc, "allgather", "bruck",
+                     bench_coll_prepare_block, bench_coll_allgather_bruck);
+    bench_coll_time (bc, "allgather", "native",
+                     NULL, bench_coll_allgather_native);
+
+    bench_coll_time (bc, "allreduce", "sc_allreduce",
+                     NULL, bench_coll_allreduce);
+    bench_coll_time (bc, "allreduce", "native",
+                     NULL, bench_coll_allreduce_native);
+    bench_coll_time (bc, "reduce", "sc_reduce", NULL, bench_coll_reduce);
+    bench_coll_time (bc, "reduce", "native", NULL, bench_coll_reduce_native);
+
+    bc->nmemb = SC_ALLOC (size_t, bc->size);
+    bench_coll_time (bc, "psort", "sc_psort",
+                     bench_coll_prepare_sort, bench_coll_psort);
+    bench_coll_time (bc, "psort", "sc_psort_sample",
+                     bench_coll_prepare_sort, bench_coll_psort_sample);
+    SC_FREE (bc->nmemb);
+    SC_FREE (bc->sendbuf);
+    SC_FREE (bc->recvbuf);
+  }
+}
+
+/* write the fastest candidate of each regime as tuning table */
+static void
+bench_coll_auto_table (bench_coll_t * bc, const char *filename)
+{
+  int                 r, j, best, num_regimes;
+  FILE               *file;
+  sc_notify_t        *notify;
+
+  if (bc->rank == 0) {
+    if ((file = fopen (filename, "w")) == NULL) {
+      SC_GLOBAL_LERRORF ("Could not open %s for writing\n", filename);
+    }
+    else {
+      fprintf (file, "sc_notify_auto %d\n", bc->world_size);
+      for (r = 0; r < SC_NOTIFY_NUM_REGIMES; ++r) {
+        if (!bc->auto_valid[r]) {
+          continue;
+        }
+        for (best = -1, j = 0; j < SC_NOTIFY_NUM_TYPES; ++j) {
+          if (sc_notify_auto_is_candidate ((sc_notify_type_t) j) &&
+              (best < 0 || bc->auto_time[r][j] < bc->auto_time[r][best])) {
+            best = j;
+          }
+        }
+        fprintf (file, "%s %s\n", sc_notify_regime_strings[r],
+                 sc_notify_type_strings[best]);
+      }
+      fclose (file);
+    }
+  }
+
+  /* verify that the table is accepted */
+  notify = sc_notify_new (bc->comm);
+  sc_notify_set_type (notify, SC_NOTIFY_AUTO);
+  num_regimes = sc_notify_auto_load (notify, filename);
+  sc_notify_destroy (notify);
+  SC_GLOBAL_PRODUCTIONF ("Notify tuning table %s sets %d regimes\n",
+                         filename, num_regimes);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, first;
+  int                 world_rank, size;
+  int                 num_regressions;
+  size_t              max_bytes;
+  double              tolerance;
+  const char         *output, *auto_table, *filter;
+  const char         *baseline, *write_baseline;
+  sc_options_t       *opt;
+  bench_coll_t        sbc, *bc = &sbc;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+
+  memset (bc, 0, sizeof (*bc));
+  opt = sc_options_new (argv[0]);
+  sc_options_add_int (opt, 's', "samples", &bc->samples, 10,
+                      "Timed calls per measurement");
+  sc_options_add_size_t (opt, 'b', "max-bytes", &max_bytes, 4096,
+                         "Largest message size in bytes");
+  sc_options_add_string (opt, 'o', "output", &output, NULL,
+                         "CSV output file, default stdout");
+  sc_options_add_string (opt, 'a', "auto-table", &auto_table, NULL,
+                         "Write a tuning table for SC_NOTIFY_AUTO");
+  sc_options_add_string (opt, 'f', "filter", &filter, NULL,
+                         "Run only benchmarks whose name contains this");
+  sc_options_add_string (opt, 'B', "baseline", &baseline, NULL,
+                         "Fail on regressions against this baseline");
+  sc_options_add_double (opt, 'T', "tolerance", &tolerance, .1,
+                         "Admissible relative slowdown");
+  sc_options_add_string (opt, 'w', "write-baseline", &write_baseline, NULL,
+                         "Store the medians as baseline file");
+  first = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first < 0 || first != argc || bc->samples < 1) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &bc->world_size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &world_rank);
+  SC_CHECK_MPI (mpiret);
+  if (world_rank == 0) {
+    bc->csv = output == NULL || !strcmp (output, "-") ? stdout :
+      fopen (output, "w");
+    SC_CHECK_ABORT (bc->csv != NULL, "Could not open CSV output");
+    fprintf (bc->csv, "benchmark,variant,ranks,fanout,bytes,samples,"
+             "min,avg,max\n");
+  }
+  bc->state = (sc_rand_state_t) (world_rank + 1);
+  bc->bench = sc_bench_new ("collectives", filter, bc->samples, 0.);
+
+  /* rank 0 of every sub-communicator is rank 0 of the world */
+  for (size = SC_MIN (2, bc->world_size);; size *= 2) {
+    size = SC_MIN (size, bc->world_size);
+    mpiret = sc_MPI_Comm_split (sc_MPI_COMM_WORLD,
+                                world_rank < size ? 0 : sc_MPI_UNDEFINED,
+                                world_rank, &bc->comm);
+    SC_CHECK_MPI (mpiret);
+    if (world_rank < size) {
+      bc->size = size;
+      bc->rank = world_rank;
+      bench_coll_sweep (bc, max_bytes);
+      mpiret = sc_MPI_Comm_free (&bc->comm);
+      SC_CHECK_MPI (mpiret);
+    }
+    mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    if (size == bc->world_size) {
+      break;
+    }
+  }
+
+  if (auto_table != NULL) {
+    bc->comm = sc_MPI_COMM_WORLD;
+    bc->rank = world_rank;
+    bench_coll_auto_table (bc, auto_table);
+  }
+  if (bc->csv != NULL && bc->csv != stdout) {
+    fclose (bc->csv);
+  }
+
+  /* the results are known on the first rank only */
+  num_regressions = 0;
+  if (world_rank == 0) {
+    if (write_baseline != NULL &&
+        sc_bench_write_baseline (bc->bench, write_baseline)) {
+      num_regressions = -1;
+    }
+    if (baseline != NULL && num_regressions == 0) {
+      num_regressions =
+        sc_bench_check_baseline (bc->bench, baseline, tolerance);
+    }
+  }
+  mpiret = sc_MPI_Bcast (&num_regressions, 1, sc_MPI_INT, 0,
+                         sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (num_regressions != 0) {
+    SC_GLOBAL_LERRORF ("Baseline check: %s\n", num_regressions < 0 ?
+                       "file error" : "performance regressed");
+  }
+  sc_bench_destroy (bc->bench);
+  sc_options_destroy (opt);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,502 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* Microbenchmarks of the serial containers and kernels of libsc. */
+
+#include "sc_bench.h"
+#include <sc_avl.h>
+#include <sc_dmatrix.h>
+#include <sc_options.h>
+#include <sc_random.h>
+#include <sc_search.h>
+
+/* the hash tables are timed at these multiples of the base size */
+static const double bench_hash_loads[] = { 1. / 16., 1., 8. };
+
+typedef struct bench_containers
+{
+  size_t              n;        /* base problem size */
+  size_t              size;     /* current size of the hash benchmarks */
+  uint32_t           *keys;     /* distinct keys in scrambled order */
+  int                *values;   /* random integers */
+  int64_t            *sorted64; /* sorted 64-bit integers */
+  int64_t            *targets;  /* random 64-bit search targets */
+  void              **ptrs;
+  sc_array_t          array;
+  sc_array_t          sorted;   /* the random integers sorted */
+  sc_array_t         *perm;     /* random permutation of n indices */
+  size_t              permute_bytes;    /* memory bound of the permute */
+  sc_mempool_t       *mempool;
+  sc_hash_t          *hash;
+  sc_hash_array_t    *hash_array;
+  avl_tree_t         *avl;
+  sc_dmatrix_t       *A, *B, *C;
+  volatile size_t     sink;     /* keeps results from being optimized out */
+}
+bench_containers_t;
+
+static int
+bench_equal_u32 (const void *v1, const void *v2, const void *u)
+{
+  return *(const uint32_t *) v1 == *(const uint32_t *) v2;
+}
+
+static int
+bench_compare_u32 (const void *v1, const void *v2)
+{
+  const uint32_t      a = *(const uint32_t *) v1;
+  const uint32_t      b = *(const uint32_t *) v2;
+
+  return a < b ? -1 : a > b;
+}
+
+static void
+bench_array_push (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  sc_array_init (&bc->array, sizeof (int));
+  for (zz = 0; zz < bc->n; ++zz) {
+    *(int *) sc_array_push (&bc->array) = (int) zz;
+  }
+  bc->sink += bc->array.elem_count;
+  sc_array_reset (&bc->array);
+}
+
+static void
+bench_array_resize (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  sc_array_init (&bc->array, sizeof (int));
+  for (zz = 1; zz <= bc->n; ++zz) {
+    sc_array_resize (&bc->array, zz);
+  }
+  for (zz = bc->n; zz > 0; --zz) {
+    sc_array_resize (&bc->array, zz - 1);
+  }
+  sc_array_reset (&bc->array);
+}
+
+static void
+bench_array_sort (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+
+  sc_array_resize (&bc->array, bc->n);
+  memcpy (bc->array.array, bc->values, bc->n * sizeof (int));
+  sc_array_sort (&bc->array, sc_int_compare);
+  bc->sink += *(int *) sc_array_index (&bc->array, 0);
+}
+
+static void
+bench_array_sort_uniq (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+
+  sc_array_resize (&bc->array, bc->n);
+  memcpy (bc->array.array, bc->values, bc->n * sizeof (int));
+  sc_array_sort (&bc->array, sc_int_compare);
+  sc_array_uniq (&bc->array, sc_int_compare);
+  bc->sink += bc->array.elem_count;
+}
+
+static void
+bench_array_uniq_unsorted (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+
+  sc_array_resize (&bc->array, bc->n);
+  memcpy (bc->array.array, bc->values, bc->n * sizeof (int));
+  sc_array_uniq_unsorted (&bc->array, NULL, NULL, NULL, 0, NULL);
+  bc->sink += bc->array.elem_count;
+}
+
+static void
+bench_array_checksum (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+
+  bc->sink += sc_array_checksum (&bc->sorted);
+}
+
+static void
+bench_array_crc32c (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+
+  bc->sink += sc_array_crc32c (&bc->sorted);
+}
+
+static void
+bench_array_bsearch (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  for (zz = 0; zz < bc->n; ++zz) {
+    bc->sink += sc_array_bsearch (&bc->sorted, &bc->values[zz],
+                                  sc_int_compare);
+  }
+}
+
+static void
+bench_array_permute (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  sc_array_t         *array = &bc->array;
+
+  sc_array_permute_multi (&array, 1, bc->perm, bc->permute_bytes);
+  bc->sink += *(size_t *) sc_array_index (&bc->array, 0);
+}
+
+static void
+bench_mempool (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  for (zz = 0; zz < bc->n; ++zz) {
+    bc->ptrs[zz] = sc_mempool_alloc (bc->mempool);
+  }
+  for (zz = bc->n; zz > 0; --zz) {
+    sc_mempool_free (bc->mempool, bc->ptrs[zz - 1]);
+  }
+}
+
+static void
+bench_hash_insert (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+  sc_hash_t          *hash;
+
+  hash = sc_hash_new (sc_hash_u32, bench_equal_u32, NULL, NULL);
+  for (zz = 0; zz < bc->size; ++zz) {
+    sc_hash_insert_unique (hash, &bc->keys[zz], NULL);
+  }
+  bc->sink += hash->elem_count;
+  sc_hash_destroy (hash);
+}
+
+static void
+bench_hash_lookup (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  for (zz = 0; zz < bc->size; ++zz) {
+    bc->sink += sc_hash_lookup (bc->hash, &bc->keys[bc->size - 1 - zz],
+                                NULL);
+  }
+}
+
+static void
+bench_hash_array_insert (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+  uint32_t           *k;
+
+  sc_hash_array_truncate (bc->hash_array);
+  for (zz = 0; zz < bc->size; ++zz) {
+    k = (uint32_t *) sc_hash_array_insert_unique (bc->hash_array,
+                                                  &bc->keys[zz], NULL);
+    *k = bc->keys[zz];
+  }
+}
+
+static void
+bench_hash_array_lookup (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz, position;
+
+  for (zz = 0; zz < bc->size; ++zz) {
+    sc_hash_array_lookup (bc->hash_array, &bc->keys[bc->size - 1 - zz],
+                          &position);
+    bc->sink += position;
+  }
+}
+
+static void
+bench_avl_insert (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+  avl_tree_t         *avl;
+
+  avl = avl_alloc_tree (bench_compare_u32, NULL);
+  for (zz = 0; zz < bc->n; ++zz) {
+    avl_insert (avl, &bc->keys[zz]);
+  }
+  bc->sink += avl_count (avl);
+  avl_free_tree (avl);
+}
+
+static void
+bench_avl_search (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  for (zz = 0; zz < bc->n; ++zz) {
+    bc->sink += avl_search (bc->avl, &bc->keys[bc->n - 1 - zz]) != NULL;
+  }
+}
+
+static void
+bench_dmatrix_multiply (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+
+  sc_dmatrix_multiply (SC_NO_TRANS, SC_NO_TRANS, 1., bc->A, bc->B, 0.,
+                       bc->C);
+  bc->sink += (size_t) bc->C->e[0][0];
+}
+
+static void
+bench_search (void *user)
+{
+  bench_containers_t *bc = (bench_containers_t *) user;
+  size_t              zz;
+
+  for (zz = 0; zz < bc->n; ++zz) {
+    bc->sink += sc_search_lower_bound64 (bc->targets[zz], bc->sorted64,
+                                         bc->n, bc->n / 2);
+  }
+}
+
+static void
+bench_hashes (sc_bench_t * bench, bench_containers_t * bc)
+{
+  int                 flat;
+  size_t              zz, k, size;
+  char                name[SC_BENCH_NAME_LENGTH];
+
+  for (zz = 0; zz < sizeof (bench_hash_loads) / sizeof (double); ++zz) {
+    bc->size = size = SC_MAX (1, (size_t) (bench_hash_loads[zz] * bc->n));
+
+    snprintf (name, SC_BENCH_NAME_LENGTH, "hash_insert/%llu",
+              (unsigned long long) size);
+    sc_bench_run (bench, name, size, bench_hash_insert, bc);
+    snprintf (name, SC_BENCH_NAME_LENGTH, "hash_lookup/%llu",
+              (unsigned long long) size);
+    if (sc_bench_wanted (bench, name)) {
+      bc->hash = sc_hash_new (sc_hash_u32, bench_equal_u32, NULL, NULL);
+      for (k = 0; k < size; ++k) {
+        sc_hash_insert_unique (bc->hash, &bc->keys[k], NULL);
+      }
+      sc_bench_run (bench, name, size, bench_hash_lookup, bc);
+      sc_hash_destroy (bc->hash);
+    }
+
+    /* the chained and the open addressing backend of the hash array */
+    for (flat = 0; flat < 2; ++flat) {
+      bc->hash_array = (flat ? sc_hash_array_new_flat : sc_hash_array_new)
+        (sizeof (uint32_t), sc_hash_u32, bench_equal_u32, NULL);
+      snprintf (name, SC_BENCH_NAME_LENGTH, "hash_array%s_insert/%llu",
+                flat ? "_flat" : "", (unsigned long long) size);
+      sc_bench_run (bench, name, size, bench_hash_array_insert, bc);
+      snprintf (name, SC_BENCH_NAME_LENGTH, "hash_array%s_lookup/%llu",
+                flat ? "_flat" : "", (unsigned long long) size);
+      if (sc_bench_wanted (bench, name)) {
+        bench_hash_array_insert (bc);
+        sc_bench_run (bench, name, size, bench_hash_array_lookup, bc);
+      }
+      sc_hash_array_destroy (bc->hash_array);
+    }
+  }
+}
+
+static void
+bench_dmatrices (sc_bench_t * bench, bench_containers_t * bc)
+{
+  int                 m;
+  char                name[SC_BENCH_NAME_LENGTH];
+
+  for (m = 8; m <= 128; m *= 4) {
+    bc->A = sc_dmatrix_new (m, m);
+    bc->B = sc_dmatrix_new (m, m);
+    bc->C = sc_dmatrix_new (m, m);
+    sc_dmatrix_set_value (bc->A, 1.);
+    sc_dmatrix_set_value (bc->B, .5);
+    snprintf (name, SC_BENCH_NAME_LENGTH, "dmatrix_multiply/%d", m);
+    sc_bench_run (bench, name, 1, bench_dmatrix_multiply, bc);
+    sc_dmatrix_destroy (bc->A);
+    sc_dmatrix_destroy (bc->B);
+    sc_dmatrix_destroy (bc->C);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, first;
+  int                 samples, num_regressions;
+  size_t              zz, n, maxkeys;
+  double              min_time, tolerance;
+  const char         *filter, *output, *baseline, *write_baseline;
+  sc_options_t       *opt;
+  sc_rand_state_t     state;
+  sc_bench_t         *bench;
+  bench_containers_t  sbc, *bc = &sbc;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_size_t (opt, 'n', "size", &n, 1 << 16,
+                         "Base number of elements");
+  sc_options_add_int (opt, 's', "samples", &samples, 10,
+                      "Timed samples per benchmark");
+  sc_options_add_double (opt, 't', "min-time", &min_time, .01,
+                         "Minimum seconds per sample");
+  sc_options_add_string (opt, 'f', "filter", &filter, NULL,
+                         "Run only benchmarks whose name contains this");
+  sc_options_add_string (opt, 'o', "output", &output, NULL,
+                         "JSON output file, default stdout");
+  sc_options_add_string (opt, 'B', "baseline", &baseline, NULL,
+                         "Fail on regressions against this baseline");
+  sc_options_add_double (opt, 'T', "tolerance", &tolerance, .1,
+                         "Admissible relative slowdown");
+  sc_options_add_string (opt, 'w', "write-baseline", &write_baseline, NULL,
+                         "Store the medians as baseline file");
+  first = sc_options_parse (sc_package_id, SC_LP_ERROR, opt, argc, argv);
+  if (first < 0 || first != argc || n < 2 || samples < 1) {
+    sc_options_print_usage (sc_package_id, SC_LP_ERROR, opt, NULL);
+    sc_abort_collective ("Option parsing failed");
+  }
+  sc_options_print_summary (sc_package_id, SC_LP_PRODUCTION, opt);
+
+  /* all input data is generated from a fixed seed */
+  memset (bc, 0, sizeof (*bc));
+  bc->n = n;
+  maxkeys = (size_t) (bench_hash_loads[2] * n);
+  bc->keys = SC_ALLOC (uint32_t, maxkeys);
+  for (zz = 0; zz < maxkeys; ++zz) {
+    /* multiplication by an odd number is a bijection of the integers */
+    bc->keys[zz] = (uint32_t) (zz * 2654435761u);
+  }
+  state = 20240101;
+  bc->values = SC_ALLOC (int, n);
+  bc->sorted64 = SC_ALLOC (int64_t, n);
+  bc->targets = SC_ALLOC (int64_t, n);
+  for (zz = 0; zz < n; ++zz) {
+    bc->values[zz] = (int) (sc_rand (&state) * INT_MAX);
+    bc->sorted64[zz] = (int64_t) (3 * zz);
+    bc->targets[zz] = (int64_t) (sc_rand (&state) * 3. * n);
+  }
+  sc_array_init (&bc->sorted, sizeof (int));
+  sc_array_resize (&bc->sorted, n);
+  memcpy (bc->sorted.array, bc->values, n * sizeof (int));
+  sc_array_sort (&bc->sorted, sc_int_compare);
+  bc->ptrs = SC_ALLOC (void *, n);
+  bc->mempool = sc_mempool_new (sizeof (double));
+
+  bench = sc_bench_new ("containers", filter, samples, min_time);
+  sc_bench_run (bench, "array_push", n, bench_array_push, bc);
+  sc_bench_run (bench, "array_resize", 2 * n, bench_array_resize, bc);
+  sc_array_init (&bc->array, sizeof (int));
+  sc_bench_run (bench, "array_sort", n, bench_array_sort, bc);
+  sc_bench_run (bench, "array_sort_uniq", n, bench_array_sort_uniq, bc);
+  sc_bench_run (bench, "array_uniq_unsorted", n, bench_array_uniq_unsorted,
+                bc);
+#ifdef SC_HAVE_ZLIB
+  sc_bench_run (bench, "array_checksum", n, bench_array_checksum, bc);
+#endif
+  sc_bench_run (bench, "array_crc32c", n, bench_array_crc32c, bc);
+  sc_array_reset (&bc->array);
+  if (sc_bench_wanted (bench, "array_permute_blocked") ||
+      sc_bench_wanted (bench, "array_permute_cycles")) {
+    bc->perm = sc_array_new_count (sizeof (size_t), n);
+    sc_array_init_count (&bc->array, sizeof (size_t), n);
+    for (zz = 0; zz < n; ++zz) {
+      *(size_t *) sc_array_index (bc->perm, zz) = zz;
+      *(size_t *) sc_array_index (&bc->array, zz) = zz;
+    }
+    for (zz = n; zz > 1; --zz) {
+      size_t             *pz = (size_t *) sc_array_index (bc->perm, zz - 1);
+      size_t             *pt = (size_t *) sc_array_index
+        (bc->perm, (size_t) (sc_rand (&state) * zz));
+      size_t              zt = *pz;
+
+      *pz = *pt;
+      *pt = zt;
+    }
+    bc->permute_bytes = (size_t) -1;
+    sc_bench_run (bench, "array_permute_blocked", n, bench_array_permute,
+                  bc);
+    bc->permute_bytes = 0;
+    sc_bench_run (bench, "array_permute_cycles", n, bench_array_permute, bc);
+    sc_array_reset (&bc->array);
+    sc_array_destroy (bc->perm);
+  }
+  sc_bench_run (bench, "array_bsearch", n, bench_array_bsearch, bc);
+  sc_bench_run (bench, "mempool_alloc_free", 2 * n, bench_mempool, bc);
+  bench_hashes (bench, bc);
+  sc_bench_run (bench, "avl_insert", n, bench_avl_insert, bc);
+  if (sc_bench_wanted (bench, "avl_search")) {
+    bc->avl = avl_alloc_tree (bench_compare_u32, NULL);
+    for (zz = 0; zz < n; ++zz) {
+      avl_insert (bc->avl, &bc->keys[zz]);
+    }
+    sc_bench_run (bench, "avl_search", n, bench_avl_search, bc);
+    avl_free_tree (bc->avl);
+  }
+  bench_dmatrices (bench, bc);
+  sc_bench_run (bench, "search_lower_bound64", n, bench_search, bc);
+
+  if (sc_bench_write_json (bench, output) ||
+      (write_baseline != NULL &&
+       sc_bench_write_baseline (bench, write_baseline))) {
+    sc_abort_collective ("Writing the results failed");
+  }
+  num_regressions = 0;
+  if (baseline != NULL &&
+      (num_regressions = sc_bench_check_baseline (bench, baseline,
+                                                  tolerance)) != 0) {
+    SC_GLOBAL_LERRORF ("Baseline %s: %s\n", baseline, num_regressions < 0 ?
+                       "not readable" : "performance regressed");
+  }
+  sc_bench_destroy (bench);
+
+  sc_mempool_destroy (bc->mempool);
+  SC_FREE (bc->ptrs);
+  sc_array_reset (&bc->sorted);
+  SC_FREE (bc->targets);
+  SC_FREE (bc->sorted64);
+  SC_FREE (bc->values);
+  SC_FREE (bc->keys);
+  sc_options_destroy (opt);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
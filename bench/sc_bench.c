@@ -0,0 +1,293 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include "sc_bench.h"
+#include <sc_statistics.h>
+
+sc_bench_t         *
+sc_bench_new (const char *suite, const char *filter,
+              int samples, double min_time)
+{
+  sc_bench_t         *bench;
+
+  SC_ASSERT (suite != NULL);
+  SC_ASSERT (samples > 0);
+
+  bench = SC_ALLOC (sc_bench_t, 1);
+  bench->suite = SC_STRDUP (suite);
+  bench->filter = filter != NULL && *filter ? SC_STRDUP (filter) : NULL;
+  bench->samples = samples;
+  bench->min_time = min_time;
+  sc_array_init (&bench->results, sizeof (sc_bench_result_t));
+
+  return bench;
+}
+
+void
+sc_bench_destroy (sc_bench_t * bench)
+{
+  sc_array_reset (&bench->results);
+  SC_FREE (bench->filter);
+  SC_FREE (bench->suite);
+  SC_FREE (bench);
+}
+
+int
+sc_bench_wanted (sc_bench_t * bench, const char *name)
+{
+  size_t              len;
+  const char         *f, *end, *n;
+
+  if (bench->filter == NULL) {
+    return 1;
+  }
+
+  /* the filter is a comma-separated list of substrings */
+  for (f = bench->filter;; f = end + 1) {
+    end = strchr (f, ',');
+    len = end != NULL ? (size_t) (end - f) : strlen (f);
+    for (n = name; len > 0 && strlen (n) >= len; ++n) {
+      if (!strncmp (n, f, len)) {
+        return 1;
+      }
+    }
+    if (end == NULL) {
+      return 0;
+    }
+  }
+}
+
+/* time a number of consecutive kernel calls */
+static double
+sc_bench_time (size_t calls, sc_bench_kernel_t kernel, void *user)
+{
+  size_t              zz;
+  double              start;
+
+  start = sc_MPI_Wtime ();
+  for (zz = 0; zz < calls; ++zz) {
+    kernel (user);
+  }
+  return sc_MPI_Wtime () - start;
+}
+
+const sc_bench_result_t *
+sc_bench_run (sc_bench_t * bench, const char *name, size_t ops,
+              sc_bench_kernel_t kernel, void *user)
+{
+  int                 i;
+  size_t              calls;
+  double              t, *times;
+  const sc_bench_result_t *res;
+
+  SC_ASSERT (ops > 0);
+
+  if (!sc_bench_wanted (bench, name)) {
+    return NULL;
+  }
+
+  /* warm up caches and allocators, then find the calls per sample */
+  kernel (user);
+  for (calls = 1;; calls *= 2) {
+    t = sc_bench_time (calls, kernel, user);
+    if (t >= bench->min_time) {
+      break;
+    }
+    if (t > .1 * bench->min_time) {
+      calls = (size_t) ceil (calls * bench->min_time / t);
+      break;
+    }
+  }
+
+  /* the samples are timed in nanoseconds per operation */
+  times = SC_ALLOC (double, bench->samples);
+  for (i = 0; i < bench->samples; ++i) {
+    times[i] = 1.e9 * sc_bench_time (calls, kernel, user) /
+      ((double) calls * ops);
+  }
+  res = sc_bench_record (bench, name, ops, calls, bench->samples, times);
+  SC_FREE (times);
+
+  return res;
+}
+
+const sc_bench_result_t *
+sc_bench_record (sc_bench_t * bench, const char *name, size_t ops,
+                 size_t calls, int samples, double *times)
+{
+  int                 i;
+  sc_statinfo_t       si;
+  sc_bench_result_t  *res;
+
+  SC_ASSERT (samples > 0);
+  SC_ASSERT (strlen (name) < SC_BENCH_NAME_LENGTH);
+
+  sc_stats_init (&si, name);
+  for (i = 0; i < samples; ++i) {
+    sc_stats_accumulate (&si, times[i]);
+  }
+  sc_stats_compute (sc_MPI_COMM_SELF, 1, &si);
+  qsort (times, samples, sizeof (double), sc_double_compare);
+
+  res = (sc_bench_result_t *) sc_array_push (&bench->results);
+  snprintf (res->name, SC_BENCH_NAME_LENGTH, "%s", name);
+  res->ops = ops;
+  res->calls = calls;
+  res->samples = samples;
+  res->median = samples % 2 ? times[samples / 2] :
+    .5 * (times[samples / 2 - 1] + times[samples / 2]);
+  res->mean = si.average;
+  res->stddev = si.standev;
+  res->min = si.min;
+  res->max = si.max;
+
+  SC_GLOBAL_PRODUCTIONF ("%-32s median %10.3f ns/op stddev %8.3f\n",
+                         res->name, res->median, res->stddev);
+  return res;
+}
+
+int
+sc_bench_write_json (sc_bench_t * bench, const char *filename)
+{
+  int                 retval;
+  size_t              zz;
+  FILE               *file;
+  sc_bench_result_t  *res;
+
+  if (filename == NULL || !strcmp (filename, "-")) {
+    file = stdout;
+  }
+  else if ((file = fopen (filename, "w")) == NULL) {
+    SC_GLOBAL_LERRORF ("Could not open %s for writing\n", filename);
+    return -1;
+  }
+
+  fprintf (file, "{\n  \"suite\": \"%s\",\n", bench->suite);
+  fprintf (file, "  \"samples\": %d,\n  \"min_time\": %g,\n",
+           bench->samples, bench->min_time);
+  fprintf (file, "  \"unit\": \"ns/op\",\n  \"results\": [");
+  for (zz = 0; zz < bench->results.elem_count; ++zz) {
+    res = (sc_bench_result_t *) sc_array_index (&bench->results, zz);
+    fprintf (file, "%s\n    {\"name\": \"%s\", \"ops\": %llu, "
+             "\"calls\": %llu,\n     \"median\": %.6g, \"mean\": %.6g, "
+             "\"stddev\": %.6g, \"min\": %.6g, \"max\": %.6g}",
+             zz > 0 ? "," : "", res->name, (unsigned long long) res->ops,
+             (unsigned long long) res->calls, res->median, res->mean,
+             res->stddev, res->min, res->max);
+  }
+  fprintf (file, "\n  ]\n}\n");
+
+  retval = 0;
+  if (file != stdout) {
+    retval = fclose (file) ? -1 : 0;
+  }
+  else {
+    fflush (file);
+  }
+  return retval;
+}
+
+int
+sc_bench_write_baseline (sc_bench_t * bench, const char *filename)
+{
+  int                 retval;
+  size_t              zz;
+  FILE               *file;
+  sc_bench_result_t  *res;
+
+  if ((file = fopen (filename, "w")) == NULL) {
+    SC_GLOBAL_LERRORF ("Could not open %s for writing\n", filename);
+    return -1;
+  }
+  fprintf (file, "# sc_bench baseline %s: name median_ns_per_op\n",
+           bench->suite);
+  for (zz = 0; zz < bench->results.elem_count; ++zz) {
+    res = (sc_bench_result_t *) sc_array_index (&bench->results, zz);
+    fprintf (file, "%s %.6g\n", res->name, res->median);
+  }
+  retval = ferror (file) ? -1 : 0;
+  if (fclose (file)) {
+    retval = -1;
+  }
+  return retval;
+}
+
+int
+sc_bench_check_baseline (sc_bench_t * bench, const char *filename,
+                         double tolerance)
+{
+  int                 num_regressions = 0;
+  int                 c;
+  size_t              zz;
+  double              base;
+  char                name[SC_BENCH_NAME_LENGTH];
+  FILE               *file;
+  sc_bench_result_t  *res;
+
+  if ((file = fopen (filename, "r")) == NULL) {
+    return -1;
+  }
+  for (;;) {
+    /* skip comment lines */
+    if ((c = fgetc (file)) == '#') {
+      while ((c = fgetc (file)) != EOF && c != '\n') {
+      }
+      continue;
+    }
+    if (c == EOF) {
+      break;
+    }
+    ungetc (c, file);
+    if (fscanf (file, "%63s %lg ", name, &base) != 2) {
+      SC_GLOBAL_LERRORF ("Invalid baseline entry in %s\n", filename);
+      num_regressions = -1;
+      break;
+    }
+    for (zz = 0; zz < bench->results.elem_count; ++zz) {
+      res = (sc_bench_result_t *) sc_array_index (&bench->results, zz);
+      if (strcmp (res->name, name)) {
+        continue;
+      }
+
+      /* the allowance grows by two standard errors of noisy samples,
+         and even the fastest sample must be slower than the baseline */
+      if (res->median > (1. + tolerance) * base +
+          2. * res->stddev / sqrt ((double) res->samples) &&
+          res->min > base) {
+        SC_GLOBAL_LERRORF ("Regression %-32s median %10.3f baseline"
+                           " %10.3f (%+.1f%%)\n", name, res->median, base,
+                           100. * (res->median / base - 1.));
+        ++num_regressions;
+      }
+      else {
+        SC_GLOBAL_PRODUCTIONF ("Within     %-32s median %10.3f baseline"
+                               " %10.3f (%+.1f%%)\n", name, res->median,
+                               base, 100. * (res->median / base - 1.));
+      }
+      break;
+    }
+  }
+  fclose (file);
+
+  return num_regressions;
+}
@@ -0,0 +1,167 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_bench.h
+ *
+ * A small harness for reproducible microbenchmarks.
+ *
+ * A kernel performs a fixed number of operations per call.  The harness
+ * runs it once to warm up, calibrates how many calls make up one sample of
+ * at least the minimum sample time, and times a fixed number of samples.
+ * Each result records the median, mean, standard deviation, minimum and
+ * maximum time per operation over the samples, and all results of a suite
+ * can be written as one JSON document.
+ *
+ * The medians can also be stored as a plain text baseline, one line of
+ * name and median per benchmark.  A later run is checked against such a
+ * file to detect performance regressions.
+ *
+ * The harness is compiled into the benchmark programs and is not part of
+ * the installed library.
+ */
+
+#ifndef SC_BENCH_H
+#define SC_BENCH_H
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Maximum length of a benchmark name including the terminating zero. */
+#define SC_BENCH_NAME_LENGTH 64
+
+/** A benchmark kernel executes its fixed amount of work once per call. */
+typedef void        (*sc_bench_kernel_t) (void *user);
+
+/** The timing result of one benchmark; all times in nanoseconds per op. */
+typedef struct sc_bench_result
+{
+  char                name[SC_BENCH_NAME_LENGTH];       /**< unique name */
+  size_t              ops;      /**< operations per kernel call */
+  size_t              calls;    /**< kernel calls per sample */
+  int                 samples;  /**< number of timed samples */
+  double              median;   /**< median over the samples */
+  double              mean;     /**< mean over the samples */
+  double              stddev;   /**< standard deviation of the samples */
+  double              min;      /**< fastest sample */
+  double              max;      /**< slowest sample */
+}
+sc_bench_result_t;
+
+/** A benchmark suite collects the results of its runs. */
+typedef struct sc_bench
+{
+  char               *suite;    /**< name of the suite */
+  char               *filter;   /**< comma-separated name substrings */
+  int                 samples;  /**< timed samples per benchmark */
+  double              min_time; /**< minimum seconds per sample */
+  sc_array_t          results;  /**< array of sc_bench_result_t */
+}
+sc_bench_t;
+
+/** Create a benchmark suite.
+ * \param [in] suite        Name of the suite written to the output.
+ * \param [in] filter       If not NULL, only benchmarks whose name contains
+ *                          one of these comma-separated strings are run.
+ * \param [in] samples      Number of timed samples, positive.
+ * \param [in] min_time     Minimum duration of one sample in seconds.
+ * \return                  Suite to be freed by \ref sc_bench_destroy.
+ */
+sc_bench_t         *sc_bench_new (const char *suite, const char *filter,
+                                  int samples, double min_time);
+
+/** Free a benchmark suite and its results. */
+void                sc_bench_destroy (sc_bench_t * bench);
+
+/** Query whether a benchmark passes the filter of the suite.
+ * Use this to skip expensive setup of benchmarks that are not run.
+ */
+int                 sc_bench_wanted (sc_bench_t * bench, const char *name);
+
+/** Time a kernel and record its result.
+ * \param [in,out] bench    Valid benchmark suite.
+ * \param [in] name         Name of the benchmark, unique in the suite.
+ * \param [in] ops          Number of operations per kernel call, positive.
+ * \param [in] kernel       Function to time.
+ * \param [in] user         Passed to the kernel.
+ * \return                  The result, valid until the next run, or NULL
+ *                          if the benchmark does not pass the filter.
+ */
+const sc_bench_result_t *sc_bench_run (sc_bench_t * bench, const char *name,
+                                       size_t ops, sc_bench_kernel_t kernel,
+                                       void *user);
+
+/** Record the result of samples timed by the caller.
+ * This is for benchmarks that need their own timing loop, for example
+ * collective operations that must run the same number of calls on all
+ * processes.
+ * \param [in,out] bench    Valid benchmark suite.
+ * \param [in] name         Name of the benchmark, unique in the suite.
+ * \param [in] ops          Number of operations per call, positive.
+ * \param [in] calls        Number of calls per sample, positive.
+ * \param [in] samples      Number of samples, positive.
+ * \param [in,out] times    Time of each sample in nanoseconds per
+ *                          operation.  Sorted on output.
+ * \return                  The result, valid until the next run.
+ */
+const sc_bench_result_t *sc_bench_record (sc_bench_t * bench,
+                                          const char *name, size_t ops,
+                                          size_t calls, int samples,
+                                          double *times);
+
+/** Write all results of a suite as JSON.
+ * \param [in] bench        Valid benchmark suite.
+ * \param [in] filename     Output file, or NULL or "-" for stdout.
+ * \return                  0 on success, -1 if the file cannot be written.
+ */
+int                 sc_bench_write_json (sc_bench_t * bench,
+                                         const char *filename);
+
+/** Write the medians of all results as a baseline file.
+ * \param [in] bench        Valid benchmark suite.
+ * \param [in] filename     Output file.
+ * \return                  0 on success, -1 if the file cannot be written.
+ */
+int                 sc_bench_write_baseline (sc_bench_t * bench,
+                                             const char *filename);
+
+/** Compare the results of a suite with a baseline file.
+ * A benchmark regresses if its median exceeds the baseline median by more
+ * than the relative tolerance plus two standard errors of the samples,
+ * and even its fastest sample is slower than the baseline.  This keeps
+ * noisy measurements from failing the check.
+ * Results without a baseline entry and entries without a result are
+ * ignored.  Every comparison is logged.
+ * \param [in] bench        Valid benchmark suite.
+ * \param [in] filename     Baseline written by \ref sc_bench_write_baseline.
+ * \param [in] tolerance    Admissible relative slowdown, e.g. 0.1.
+ * \return                  The number of regressions, or -1 if the file
+ *                          cannot be read or is invalid.
+ */
+int                 sc_bench_check_baseline (sc_bench_t * bench,
+                                             const char *filename,
+                                             double tolerance);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_BENCH_H */
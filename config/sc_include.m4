@@ -281,6 +281,8 @@ AC_DEFUN([SC_CHECK_LIBRARIES],
 [
 SC_REQUIRE_LIB([m], [fabs])
 SC_CHECK_LIB([z], [adler32_combine], [ZLIB], [$1])
+SC_CHECK_LIB([zstd], [ZSTD_compressStream2], [ZSTD], [$1])
+SC_CHECK_LIB([lz4], [LZ4F_compressBegin], [LZ4], [$1])
 SC_CHECK_LIB([lua53 lua5.3 lua52 lua5.2 lua51 lua5.1 lua lua5], [lua_createtable],
 	     [LUA], [$1])
 SC_CHECK_BLAS_LAPACK([$1])
@@ -290,6 +292,12 @@ SC_CHECK_OPENMP([$1])
 SC_CHECK_MEMALIGN([$1])
 SC_CHECK_V4L2([$1])
 dnl SC_CUDA([$1])
+if test -n "$$1_ENABLE_CUDA" -a "x$$1_ENABLE_CUDA" != xno ; then
+  SC_REQUIRE_LIB([cudart], [cudaMalloc])
+fi
+if test -n "$$1_ENABLE_HIP" -a "x$$1_ENABLE_HIP" != xno ; then
+  SC_REQUIRE_LIB([amdhip64], [hipMalloc])
+fi
 ])
 
 dnl SC_AS_SUBPACKAGE(PREFIX)
@@ -0,0 +1,153 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* Compare the speed of the single-threaded and the thread-safe mempool. */
+
+#include <sc_containers.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/** Allocate and free elements in a pattern resembling mesh adaptation. */
+static double
+bench_mempool (size_t elem_size, int num_elems, int num_rounds)
+{
+  int                 i, r;
+  void              **elems;
+  double              start;
+  sc_mempool_t       *pool;
+
+  elems = SC_ALLOC (void *, num_elems);
+  pool = sc_mempool_new (elem_size);
+  start = sc_MPI_Wtime ();
+  for (r = 0; r < num_rounds; ++r) {
+    for (i = 0; i < num_elems; ++i) {
+      elems[i] = sc_mempool_alloc (pool);
+    }
+    for (i = 0; i < num_elems; ++i) {
+      sc_mempool_free (pool, elems[i]);
+    }
+  }
+  start = sc_MPI_Wtime () - start;
+  sc_mempool_destroy (pool);
+  SC_FREE (elems);
+
+  return start;
+}
+
+/** Every thread allocates, then frees the elements of its neighbor. */
+static double
+bench_mempool_mt (size_t elem_size, int num_elems, int num_rounds,
+                  int num_threads)
+{
+  void              **elems;
+  double              start;
+  sc_mempool_mt_t    *pool;
+
+  elems = SC_ALLOC (void *, (size_t) num_elems * num_threads);
+  pool = sc_mempool_mt_new (elem_size);
+  start = sc_MPI_Wtime ();
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel num_threads (num_threads)
+#endif
+  {
+    int                 i, r, t, o;
+    sc_mempool_cache_t  cache;
+
+#ifdef SC_ENABLE_OPENMP
+    t = omp_get_thread_num ();
+    SC_ASSERT (omp_get_num_threads () == num_threads);
+#else
+    SC_ASSERT (num_threads == 1);
+    t = 0;
+#endif
+    o = (t + 1) % num_threads;
+    sc_mempool_cache_init (&cache, pool);
+    for (r = 0; r < num_rounds; ++r) {
+      for (i = 0; i < num_elems; ++i) {
+        elems[(size_t) t * num_elems + i] = sc_mempool_cache_alloc (&cache);
+      }
+#ifdef SC_ENABLE_OPENMP
+#pragma omp barrier
+#endif
+      for (i = 0; i < num_elems; ++i) {
+        sc_mempool_cache_free (&cache, elems[(size_t) o * num_elems + i]);
+      }
+#ifdef SC_ENABLE_OPENMP
+#pragma omp barrier
+#endif
+    }
+    sc_mempool_cache_reset (&cache);
+  }
+  start = sc_MPI_Wtime () - start;
+  sc_mempool_mt_destroy (pool);
+  SC_FREE (elems);
+
+  return start;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_elems, num_rounds;
+  int                 t, max_threads;
+  size_t              elem_size;
+  double              tser, tmt;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  elem_size = 32;
+  num_elems = argc > 1 ? atoi (argv[1]) : 100000;
+  num_rounds = argc > 2 ? atoi (argv[2]) : 100;
+  SC_CHECK_ABORT (num_elems > 0 && num_rounds > 0, "Invalid arguments");
+#ifdef SC_ENABLE_OPENMP
+  max_threads = omp_get_max_threads ();
+#else
+  max_threads = 1;
+#endif
+
+#ifdef SC_MEMPOOL_MSTAMP
+  SC_GLOBAL_PRODUCTION ("Mempool backend is sc_mstamp\n");
+#else
+  SC_GLOBAL_PRODUCTION ("Mempool backend is obstack\n");
+#endif
+  tser = bench_mempool (elem_size, num_elems, num_rounds);
+  SC_GLOBAL_PRODUCTIONF ("sc_mempool    threads 1 time %g ns/op %g\n",
+                         tser, 1.e9 * tser / (2. * num_elems * num_rounds));
+  for (t = 1; t <= max_threads; t *= 2) {
+    tmt = bench_mempool_mt (elem_size, num_elems, num_rounds, t);
+    SC_GLOBAL_PRODUCTIONF ("sc_mempool_mt threads %d time %g ns/op %g\n",
+                           t, tmt,
+                           1.e9 * tmt / (2. * num_elems * num_rounds * t));
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
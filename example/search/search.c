@@ -0,0 +1,123 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/* Compare the speed of the lower bound search kernels in sc_search. */
+
+#include <sc_search.h>
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              zz, nmemb, ntargets, k;
+  int64_t            *array, *targets, *eytz;
+  ssize_t            *positions;
+  double              start, t;
+  long long           sum;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  nmemb = argc > 1 ? (size_t) atol (argv[1]) : (size_t) 1 << 24;
+  ntargets = argc > 2 ? (size_t) atol (argv[2]) : (size_t) 1 << 22;
+  SC_CHECK_ABORT (nmemb > 0 && ntargets > 0, "Invalid arguments");
+
+  array = SC_ALLOC (int64_t, nmemb);
+  for (zz = 0; zz < nmemb; ++zz) {
+    array[zz] = (int64_t) (3 * zz);
+  }
+  targets = SC_ALLOC (int64_t, ntargets);
+  for (zz = 0; zz < ntargets; ++zz) {
+    targets[zz] = (int64_t) (((double) rand () / RAND_MAX) * 3. * nmemb);
+  }
+  positions = SC_ALLOC (ssize_t, ntargets);
+  eytz = SC_ALLOC (int64_t, nmemb + 1);
+  sc_search_eytzinger64_build (array, nmemb, eytz, NULL);
+
+  /* the sums keep the compiler from optimizing the searches away */
+  start = sc_MPI_Wtime ();
+  for (sum = 0, zz = 0; zz < ntargets; ++zz) {
+    sum += sc_search_lower_bound64 (targets[zz], array, nmemb, nmemb / 2);
+  }
+  t = sc_MPI_Wtime () - start;
+  SC_GLOBAL_PRODUCTIONF ("Binary     ns/search %8.2f sum %lld\n",
+                         1.e9 * t / ntargets, sum);
+
+  start = sc_MPI_Wtime ();
+  for (sum = 0, zz = 0; zz < ntargets; ++zz) {
+    sum += sc_search_lower_bound64_branchless (targets[zz], array, nmemb);
+  }
+  t = sc_MPI_Wtime () - start;
+  SC_GLOBAL_PRODUCTIONF ("Branchless ns/search %8.2f sum %lld\n",
+                         1.e9 * t / ntargets, sum);
+
+  start = sc_MPI_Wtime ();
+  sc_search_lower_bound64_many (targets, ntargets, array, nmemb, positions);
+  for (sum = 0, zz = 0; zz < ntargets; ++zz) {
+    sum += positions[zz];
+  }
+  t = sc_MPI_Wtime () - start;
+  SC_GLOBAL_PRODUCTIONF ("Lockstep   ns/search %8.2f sum %lld\n",
+                         1.e9 * t / ntargets, sum);
+
+  start = sc_MPI_Wtime ();
+  for (sum = 0, zz = 0; zz < ntargets; ++zz) {
+    k = sc_search_eytzinger64 (targets[zz], eytz, nmemb);
+    sum += k == 0 ? -1 : eytz[k] / 3;
+  }
+  t = sc_MPI_Wtime () - start;
+  SC_GLOBAL_PRODUCTIONF ("Eytzinger  ns/search %8.2f sum %lld\n",
+                         1.e9 * t / ntargets, sum);
+
+  /* sorted targets, all searched by bisection or by galloping */
+  qsort (targets, ntargets, sizeof (int64_t), sc_int64_compare);
+  start = sc_MPI_Wtime ();
+  for (sum = 0, zz = 0; zz < ntargets; ++zz) {
+    sum += sc_search_lower_bound64 (targets[zz], array, nmemb, nmemb / 2);
+  }
+  t = sc_MPI_Wtime () - start;
+  SC_GLOBAL_PRODUCTIONF ("Sorted     ns/search %8.2f sum %lld\n",
+                         1.e9 * t / ntargets, sum);
+
+  start = sc_MPI_Wtime ();
+  sc_search_lower_bound64_batch (targets, ntargets, array, nmemb, positions);
+  for (sum = 0, zz = 0; zz < ntargets; ++zz) {
+    sum += positions[zz];
+  }
+  t = sc_MPI_Wtime () - start;
+  SC_GLOBAL_PRODUCTIONF ("Galloping  ns/search %8.2f sum %lld\n",
+                         1.e9 * t / ntargets, sum);
+
+  SC_FREE (eytz);
+  SC_FREE (positions);
+  SC_FREE (targets);
+  SC_FREE (array);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -33,6 +33,8 @@ typedef struct v4l2_global
   unsigned            bytesperline;
   unsigned            sizeimage;
   sc_v4l2_device_t   *vd;
+  int                 streaming;
+  unsigned            num_buffers;
   size_t              wsiz;
   char               *wbuf;
 
@@ -71,10 +73,19 @@ v4l2_prepare (v4l2_global_t * g)
   fprintf (stderr, "Negotiated %ux%u with %u bytes per line %u size\n",
            g->width, g->height, g->bytesperline, g->sizeimage);
 
+  /* prefer rendering directly into a ring of device buffers */
+  g->wsiz = g->sizeimage;
+  if (sc_v4l2_device_is_streaming (g->vd)) {
+    g->num_buffers = 4;
+    retval = sc_v4l2_device_stream_start (g->vd, &g->num_buffers);
+    SC_CHECK_ABORT (!retval, "Failed to start streaming");
+    fprintf (stderr, "Streaming with %u buffers\n", g->num_buffers);
+    g->streaming = 1;
+    return 0;
+  }
+
   SC_CHECK_ABORT (sc_v4l2_device_is_readwrite (g->vd),
                   "Device does not support read/write I/O");
-
-  g->wsiz = g->sizeimage;
   g->wbuf = SC_ALLOC (char, g->wsiz);
 
   return 0;
@@ -86,7 +97,14 @@ v4l2_postpare (v4l2_global_t * g)
   SC_ASSERT (g != NULL);
   SC_ASSERT (g->vd != NULL);
 
-  SC_FREE (g->wbuf);
+  if (g->streaming) {
+    SC_CHECK_ABORT (!sc_v4l2_device_stream_stop (g->vd),
+                    "Failed to stop streaming");
+    g->wbuf = NULL;
+  }
+  else {
+    SC_FREE (g->wbuf);
+  }
 }
 
 #if 1
@@ -196,7 +214,7 @@ v4l2_loop (v4l2_global_t * g)
 
   SC_ASSERT (g != NULL);
   SC_ASSERT (g->vd != NULL);
-  SC_ASSERT (g->wbuf != NULL || g->wsiz == 0);
+  SC_ASSERT (g->streaming || g->wbuf != NULL || g->wsiz == 0);
   SC_ASSERT (g->tfinal >= 0.);
 
   /* simulation parameters */
@@ -216,8 +234,18 @@ v4l2_loop (v4l2_global_t * g)
   g->num_frames = 0;
   g->tlast = sc_MPI_Wtime ();
   while (!caught_sigint && g->t < g->tfinal) {
-    retval = sc_v4l2_device_select (g->vd, 10 * 1000);
-    SC_CHECK_ABORT (retval >= 0, "Failed to select on device");
+    if (g->streaming) {
+      retval = sc_v4l2_device_stream_acquire (g->vd, 10 * 1000, &g->wbuf);
+      SC_CHECK_ABORT (retval >= 0, "Failed to acquire device buffer");
+      if (retval == 0) {
+        /* no buffer returned by the device in time */
+        continue;
+      }
+    }
+    else {
+      retval = sc_v4l2_device_select (g->vd, 10 * 1000);
+      SC_CHECK_ABORT (retval >= 0, "Failed to select on device");
+    }
 
     tnow = sc_MPI_Wtime ();
     g->t += tnow - g->tlast;
@@ -226,7 +254,12 @@ v4l2_loop (v4l2_global_t * g)
     g->xy[1] = g->center[1] + g->radius * sin (g->omega * g->yfactor * g->t);
 
     paint_image (g);
-    retval = sc_v4l2_device_write (g->vd, g->wbuf);
+    if (g->streaming) {
+      retval = sc_v4l2_device_stream_queue (g->vd, g->wbuf);
+    }
+    else {
+      retval = sc_v4l2_device_write (g->vd, g->wbuf);
+    }
     SC_CHECK_ABORT (retval == 0, "Failed to write to device");
 
     ++g->num_frames;
@@ -12,6 +12,12 @@ For details, see http://sourceforge.net/projects/libb64
 
 #include "libb64.h"
 
+/* CB: vectorized bulk decoding, chosen at runtime on x86 */
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#define BASE64_X86
+#include <immintrin.h>
+#endif
+
 static inline char
 base64_decode_value (char value_in)
 {
@@ -29,6 +35,137 @@ base64_decode_value (char value_in)
     -1 : decoding[(int) value_in];
 }
 
+#ifdef BASE64_X86
+
+/* The x86 kernels follow the nibble lookup method of W. Mula.
+ * They stop at the first vector containing a character outside of the
+ * alphabet, such as padding or a line break, and leave it to the
+ * bytewise state machine. */
+
+__attribute__ ((target ("ssse3")))
+static size_t
+base64_decode_ssse3 (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done;
+  __m128i             v, hi_nibbles, lo_nibbles, roll;
+  const __m128i       lut_lo = _mm_setr_epi8
+    (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+     0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i       lut_hi = _mm_setr_epi8
+    (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+     0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i       lut_roll = _mm_setr_epi8
+    (0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i       mask_2f = _mm_set1_epi8 (0x2f);
+
+  /* each step consumes 16 characters and writes 16 bytes, 12 valid */
+  for (done = 0; length - done >= 16; done += 16, out += 12) {
+    v = _mm_loadu_si128 ((const __m128i *) (in + done));
+    hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (v, 4), mask_2f);
+    lo_nibbles = _mm_and_si128 (v, mask_2f);
+    if (_mm_movemask_epi8 (_mm_cmpgt_epi8 (_mm_and_si128
+                                           (_mm_shuffle_epi8
+                                            (lut_lo, lo_nibbles),
+                                            _mm_shuffle_epi8
+                                            (lut_hi, hi_nibbles)),
+                                           _mm_setzero_si128 ()))) {
+      break;
+    }
+
+    /* translate to six-bit values and pack them into 12 bytes */
+    roll = _mm_shuffle_epi8 (lut_roll, _mm_add_epi8
+                             (_mm_cmpeq_epi8 (v, mask_2f), hi_nibbles));
+    v = _mm_add_epi8 (v, roll);
+    v = _mm_maddubs_epi16 (v, _mm_set1_epi32 (0x01400140));
+    v = _mm_madd_epi16 (v, _mm_set1_epi32 (0x00011000));
+    v = _mm_shuffle_epi8 (v, _mm_setr_epi8
+                          (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                           -1, -1, -1, -1));
+    _mm_storeu_si128 ((__m128i *) out, v);
+  }
+  return done;
+}
+
+__attribute__ ((target ("avx2")))
+static size_t
+base64_decode_avx2 (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done;
+  __m256i             v, hi_nibbles, lo_nibbles, roll;
+  const __m256i       lut_lo = _mm256_broadcastsi128_si256 (_mm_setr_epi8
+    (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+     0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A));
+  const __m256i       lut_hi = _mm256_broadcastsi128_si256 (_mm_setr_epi8
+    (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+     0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+  const __m256i       lut_roll = _mm256_broadcastsi128_si256 (_mm_setr_epi8
+    (0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+  const __m256i       mask_2f = _mm256_set1_epi8 (0x2f);
+
+  /* each step consumes 32 characters and writes 32 bytes, 24 valid */
+  for (done = 0; length - done >= 32; done += 32, out += 24) {
+    v = _mm256_loadu_si256 ((const __m256i *) (in + done));
+    hi_nibbles = _mm256_and_si256 (_mm256_srli_epi32 (v, 4), mask_2f);
+    lo_nibbles = _mm256_and_si256 (v, mask_2f);
+    if (_mm256_movemask_epi8 (_mm256_cmpgt_epi8 (_mm256_and_si256
+                                                 (_mm256_shuffle_epi8
+                                                  (lut_lo, lo_nibbles),
+                                                  _mm256_shuffle_epi8
+                                                  (lut_hi, hi_nibbles)),
+                                                 _mm256_setzero_si256 ()))) {
+      break;
+    }
+    roll = _mm256_shuffle_epi8 (lut_roll, _mm256_add_epi8
+                                (_mm256_cmpeq_epi8 (v, mask_2f),
+                                 hi_nibbles));
+    v = _mm256_add_epi8 (v, roll);
+    v = _mm256_maddubs_epi16 (v, _mm256_set1_epi32 (0x01400140));
+    v = _mm256_madd_epi16 (v, _mm256_set1_epi32 (0x00011000));
+    v = _mm256_shuffle_epi8 (v, _mm256_broadcastsi128_si256 (_mm_setr_epi8
+                             (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                              -1, -1, -1, -1)));
+    v = _mm256_permutevar8x32_epi32 (v, _mm256_setr_epi32
+                                     (0, 1, 2, 4, 5, 6, 3, 7));
+    _mm256_storeu_si256 ((__m256i *) out, v);
+  }
+  return done;
+}
+
+#endif /* BASE64_X86 */
+
+/* Decode as many whole quadruples of alphabet characters as possible.
+ * Returns the number of characters consumed, a multiple of four.
+ * The output may be written up to the number of characters consumed. */
+static size_t
+base64_decode_bulk (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done = 0;
+  char                a, b, c, d;
+
+#ifdef BASE64_X86
+  if (length >= 32 && __builtin_cpu_supports ("avx2")) {
+    done = base64_decode_avx2 (in, length, out);
+  }
+  if (length - done >= 16 && __builtin_cpu_supports ("ssse3")) {
+    done += base64_decode_ssse3 (in + done, length - done,
+                                 out + done / 4 * 3);
+  }
+#endif
+  for (out += done / 4 * 3; length - done >= 4; done += 4, out += 3) {
+    a = base64_decode_value ((char) in[done]);
+    b = base64_decode_value ((char) in[done + 1]);
+    c = base64_decode_value ((char) in[done + 2]);
+    d = base64_decode_value ((char) in[done + 3]);
+    if ((a | b | c | d) < 0) {
+      break;
+    }
+    out[0] = (char) (a << 2 | b >> 4);
+    out[1] = (char) ((b & 0x0f) << 4 | c >> 2);
+    out[2] = (char) ((c & 0x03) << 6 | d);
+  }
+  return done;
+}
+
 void
 base64_init_decodestate (base64_decodestate * state_in)
 {
@@ -46,6 +183,16 @@ base64_decode_block (const char *code_in, size_t length_in,
   /*@unused@ */
   char                fragment;
 
+  /* CB: whole quadruples are decoded in bulk */
+  if (state_in->step == step_a) {
+    size_t              bulk;
+
+    bulk = base64_decode_bulk ((const unsigned char *) codechar,
+                               length_in, plainchar);
+    codechar += bulk;
+    plainchar += bulk / 4 * 3;
+  }
+
   *plainchar = state_in->plainchar;
 
   switch (state_in->step) {
@@ -12,15 +12,163 @@ For details, see http://sourceforge.net/projects/libb64
 
 #include "libb64.h"
 
+/* CB: vectorized bulk encoding, chosen at runtime on x86 */
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#define BASE64_X86
+#include <immintrin.h>
+#elif defined __GNUC__ && defined __aarch64__ && defined __ARM_NEON
+#define BASE64_NEON
+#include <arm_neon.h>
+#endif
+
 const int           CHARS_PER_LINE = 72;
 
+static const char   base64_encoding[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
 static inline char
 base64_encode_value (char value_in)
 {
-  static const char  *encoding =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  return value_in > 63 ? '=' : base64_encoding[(int) value_in];
+}
+
+#ifdef BASE64_X86
+
+/* The x86 kernels follow the pshufb method of W. Mula. */
+
+__attribute__ ((target ("ssse3")))
+static size_t
+base64_encode_ssse3 (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done;
+  __m128i             v, t0, t1;
+  const __m128i       shuffle = _mm_set_epi8
+    (10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m128i       shift = _mm_setr_epi8
+    ('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+     '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+  /* each step reads 16 bytes and consumes 12 of them */
+  for (done = 0; length - done >= 16; done += 12, out += 16) {
+    v = _mm_loadu_si128 ((const __m128i *) (in + done));
+    v = _mm_shuffle_epi8 (v, shuffle);
+
+    /* spread the 12 bytes to 16 six-bit indices */
+    t0 = _mm_mulhi_epu16 (_mm_and_si128 (v, _mm_set1_epi32 (0x0fc0fc00)),
+                          _mm_set1_epi32 (0x04000040));
+    t1 = _mm_mullo_epi16 (_mm_and_si128 (v, _mm_set1_epi32 (0x003f03f0)),
+                          _mm_set1_epi32 (0x01000010));
+    v = _mm_or_si128 (t0, t1);
 
-  return value_in > 63 ? '=' : encoding[(int) value_in];
+    /* translate the indices to ASCII by a per-range offset */
+    t0 = _mm_subs_epu8 (v, _mm_set1_epi8 (51));
+    t1 = _mm_cmpgt_epi8 (_mm_set1_epi8 (26), v);
+    t0 = _mm_or_si128 (t0, _mm_and_si128 (t1, _mm_set1_epi8 (13)));
+    v = _mm_add_epi8 (v, _mm_shuffle_epi8 (shift, t0));
+    _mm_storeu_si128 ((__m128i *) out, v);
+  }
+  return done;
+}
+
+__attribute__ ((target ("avx2")))
+static size_t
+base64_encode_avx2 (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done;
+  __m256i             v, t0, t1;
+  const __m256i       shuffle = _mm256_broadcastsi128_si256 (_mm_set_epi8
+    (10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m256i       shift = _mm256_broadcastsi128_si256 (_mm_setr_epi8
+    ('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+     '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+
+  /* each lane encodes 12 bytes; the upper load reads 4 bytes beyond */
+  for (done = 0; length - done >= 28; done += 24, out += 32) {
+    v = _mm256_inserti128_si256 (_mm256_castsi128_si256
+                                 (_mm_loadu_si128 ((const __m128i *)
+                                                   (in + done))),
+                                 _mm_loadu_si128 ((const __m128i *)
+                                                  (in + done + 12)), 1);
+    v = _mm256_shuffle_epi8 (v, shuffle);
+    t0 = _mm256_mulhi_epu16 (_mm256_and_si256
+                             (v, _mm256_set1_epi32 (0x0fc0fc00)),
+                             _mm256_set1_epi32 (0x04000040));
+    t1 = _mm256_mullo_epi16 (_mm256_and_si256
+                             (v, _mm256_set1_epi32 (0x003f03f0)),
+                             _mm256_set1_epi32 (0x01000010));
+    v = _mm256_or_si256 (t0, t1);
+    t0 = _mm256_subs_epu8 (v, _mm256_set1_epi8 (51));
+    t1 = _mm256_cmpgt_epi8 (_mm256_set1_epi8 (26), v);
+    t0 = _mm256_or_si256 (t0, _mm256_and_si256 (t1, _mm256_set1_epi8 (13)));
+    v = _mm256_add_epi8 (v, _mm256_shuffle_epi8 (shift, t0));
+    _mm256_storeu_si256 ((__m256i *) out, v);
+  }
+  return done;
+}
+
+#endif /* BASE64_X86 */
+
+#ifdef BASE64_NEON
+
+static size_t
+base64_encode_neon (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done;
+  uint8x16x3_t        v;
+  uint8x16x4_t        r, lut;
+
+  lut.val[0] = vld1q_u8 ((const uint8_t *) base64_encoding);
+  lut.val[1] = vld1q_u8 ((const uint8_t *) base64_encoding + 16);
+  lut.val[2] = vld1q_u8 ((const uint8_t *) base64_encoding + 32);
+  lut.val[3] = vld1q_u8 ((const uint8_t *) base64_encoding + 48);
+
+  /* deinterleaving loads split 48 bytes into the three bytes of a triple */
+  for (done = 0; length - done >= 48; done += 48, out += 64) {
+    v = vld3q_u8 (in + done);
+    r.val[0] = vshrq_n_u8 (v.val[0], 2);
+    r.val[1] = vorrq_u8 (vshlq_n_u8 (vandq_u8 (v.val[0], vdupq_n_u8 (3)), 4),
+                         vshrq_n_u8 (v.val[1], 4));
+    r.val[2] = vorrq_u8 (vshlq_n_u8 (vandq_u8 (v.val[1], vdupq_n_u8 (15)),
+                                     2), vshrq_n_u8 (v.val[2], 6));
+    r.val[3] = vandq_u8 (v.val[2], vdupq_n_u8 (63));
+    r.val[0] = vqtbl4q_u8 (lut, r.val[0]);
+    r.val[1] = vqtbl4q_u8 (lut, r.val[1]);
+    r.val[2] = vqtbl4q_u8 (lut, r.val[2]);
+    r.val[3] = vqtbl4q_u8 (lut, r.val[3]);
+    vst4q_u8 ((uint8_t *) out, r);
+  }
+  return done;
+}
+
+#endif /* BASE64_NEON */
+
+/* Encode as many whole triples as possible without line breaks.
+ * Returns the number of input bytes consumed, a multiple of three. */
+static size_t
+base64_encode_bulk (const unsigned char *in, size_t length, char *out)
+{
+  size_t              done = 0;
+  unsigned long       v;
+
+#ifdef BASE64_X86
+  if (length >= 28 && __builtin_cpu_supports ("avx2")) {
+    done = base64_encode_avx2 (in, length, out);
+  }
+  else if (length >= 16 && __builtin_cpu_supports ("ssse3")) {
+    done = base64_encode_ssse3 (in, length, out);
+  }
+#elif defined BASE64_NEON
+  done = base64_encode_neon (in, length, out);
+#endif
+  for (out += done / 3 * 4; length - done >= 3; done += 3, out += 4) {
+    v = (unsigned long) in[done] << 16 |
+      (unsigned long) in[done + 1] << 8 | (unsigned long) in[done + 2];
+    out[0] = base64_encoding[v >> 18];
+    out[1] = base64_encoding[(v >> 12) & 0x3f];
+    out[2] = base64_encoding[(v >> 6) & 0x3f];
+    out[3] = base64_encoding[v & 0x3f];
+  }
+  return done;
 }
 
 void
@@ -44,6 +192,19 @@ base64_encode_block (const char *plaintext_in, size_t length_in,
   /*@unused@ */
   char                fragment;
 
+#ifndef SC_BASE64_WRAP
+  /* CB: without wrapping, whole triples are encoded in bulk */
+  if (state_in->step == step_A) {
+    size_t              bulk;
+
+    bulk = base64_encode_bulk ((const unsigned char *) plainchar,
+                               length_in, codechar);
+    plainchar += bulk;
+    codechar += bulk / 3 * 4;
+    state_in->stepcount += (int) (bulk / 3);
+  }
+#endif
+
   result = state_in->result;
 
   switch (state_in->step) {
@@ -22,6 +22,12 @@
 */
 
 #include <sc_private.h>
+#include <sc_containers.h>
+#include <sc_prof.h>
+#include <sc_progress.h>
+#include <sc_taskpool.h>
+#include <sc_statistics.h>
+#include <sc_tracer.h>
 
 #ifdef SC_HAVE_SIGNAL_H
 #include <signal.h>
@@ -41,16 +47,117 @@ typedef void        (*sc_sig_t) (int);
 
 #ifdef SC_ENABLE_PTHREAD
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #endif
 
+#if defined SC_ENABLE_CUDA
+#include <cuda_runtime_api.h>
+#elif defined SC_ENABLE_HIP
+#include <hip/hip_runtime_api.h>
+#endif
+
+#if defined SC_ENABLE_PTHREAD || defined SC_ENABLE_OPENMP
+#if defined __GNUC__ && defined __ATOMIC_RELAXED
+/** Memory counters are atomic and spread over slots for the threads. */
+#define SC_MEMORY_ATOMIC
+#endif
+#endif
+
+#if defined SC_ENABLE_PTHREAD && defined __GNUC__ && defined __ATOMIC_RELAXED
+/** Asynchronous log messages go through per-thread rings to a flusher. */
+#define SC_LOG_THREADED
+#endif
+
+/** Bytes of the ring buffer of each logging thread. */
+#define SC_LOG_RING_BYTES (1 << 16)
+
+/** Bytes of buffered log output that trigger a write. */
+#define SC_LOG_BATCH_BYTES (1 << 20)
+
+/** Milliseconds between two wakeups of the flusher thread. */
+#define SC_LOG_FLUSH_MS 100
+
+/** Maximum length of a formatted log message. */
+#define SC_LOG_MESSAGE_BYTES (2 * BUFSIZ)
+
+#ifdef SC_MEMORY_ATOMIC
+#define SC_MEMORY_SLOTS 16
+#else
+#define SC_MEMORY_SLOTS 1
+#endif
+
+/** Bytes of a cache line that the memory slots are aligned to. */
+#define SC_MEMORY_SLOT_BYTES 64
+
+/** Allocation counters of a package updated by a subset of the threads.
+ * Each slot fills a cache line in order not to share it between threads.
+ * The slot arrays are allocated on a cache line boundary to this end.
+ */
+typedef struct sc_memory_slot
+{
+  int                 malloc_count;
+  int                 free_count;
+  char                padding[SC_MEMORY_SLOT_BYTES - 2 * sizeof (int)];
+}
+sc_memory_slot_t;
+
+/** Number of power-of-two size classes in the memory profile. */
+#define SC_MEMORY_CLASSES 48
+
+/** Number of allocation sites in the memory profile.
+ * Site zero collects untagged allocations and the overflow.
+ */
+#define SC_MEMORY_PROFILE_SITES 256
+
+/** Bytes in front of each profiled allocation to store its size. */
+#ifdef SC_ENABLE_MEMALIGN
+#define SC_MEMORY_HEADER SC_MAX (16, SC_MEMALIGN_BYTES)
+#else
+#define SC_MEMORY_HEADER 16
+#endif
+
+/** Header stored in front of each allocation of a profiled package. */
+typedef struct sc_memory_header
+{
+  size_t              size;
+  int                 site;
+}
+sc_memory_header_t;
+
+/** Allocations and bytes attributed to one source location. */
+typedef struct sc_memory_site
+{
+  const char         *file;
+  int                 line;
+  long                count;
+  size_t              current;
+  size_t              peak;
+}
+sc_memory_site_t;
+
+/** Byte-level accounting of a package, if enabled. */
+typedef struct sc_memory_profile
+{
+  size_t              current;
+  size_t              peak;
+  long                histogram[SC_MEMORY_CLASSES];
+  sc_memory_site_t    sites[SC_MEMORY_PROFILE_SITES];
+}
+sc_memory_profile_t;
+
 typedef struct sc_package
 {
   int                 is_registered;
   sc_log_handler_t    log_handler;
   int                 log_threshold;
   int                 log_indent;
-  int                 malloc_count;
-  int                 free_count;
+  sc_memory_slot_t   *memory;     /**< Aligned into memory_alloc. */
+  void               *memory_alloc;
+  sc_allocator_t      allocator;
+  sc_memory_profile_t *profile;
+  size_t              domain_current[SC_MEMORY_NUM_DOMAINS];
+  size_t              domain_peak[SC_MEMORY_NUM_DOMAINS];
   int                 rc_active;
   int                 abort_mismatch;
   const char         *name;
@@ -91,9 +198,20 @@ const int sc_log2_lookup_table[256] =
 int                 sc_package_id = -1;
 FILE               *sc_trace_file = NULL;
 int                 sc_trace_prio = SC_LP_STATISTICS;
+int                 sc_log_thresholds[SC_LOG_PACKAGES + 1];
+int                 sc_log_global_active = 1;
 
-static int          default_malloc_count = 0;
-static int          default_free_count = 0;
+#ifdef SC_MEMORY_ATOMIC
+static sc_memory_slot_t default_memory[SC_MEMORY_SLOTS]
+  __attribute__ ((aligned (SC_MEMORY_SLOT_BYTES)));
+#else
+static sc_memory_slot_t default_memory[SC_MEMORY_SLOTS];
+#endif
+static sc_allocator_t default_allocator;
+static sc_memory_profile_t *default_profile = NULL;
+static size_t       default_domain_current[SC_MEMORY_NUM_DOMAINS];
+static size_t       default_domain_peak[SC_MEMORY_NUM_DOMAINS];
+static int          sc_memory_profile_env = 0;
 static int          default_rc_active = 0;
 static int          default_abort_mismatch = 1;
 
@@ -113,6 +231,9 @@ static sc_sig_t     system_segv_handler = NULL;
 
 static int          sc_print_backtrace = 0;
 
+/** Prefix of the event trace written by sc_finalize or NULL. */
+static const char  *sc_tracer_file = NULL;
+
 static int          sc_num_packages = 0;
 static int          sc_num_packages_alloc = 0;
 static sc_package_t *sc_packages = NULL;
@@ -245,12 +366,16 @@ sc_set_signal_handler (int catch_signals)
   }
 }
 
-static void
-sc_log_handler (FILE * log_stream, const char *filename, int lineno,
-                int package, int category, int priority, const char *msg)
+/** Format a log message of the default log handler into a buffer.
+ * \return             The length of the message, truncated to size - 1.
+ */
+static size_t
+sc_log_format (char *buffer, size_t size, const char *filename, int lineno,
+               int package, int category, int priority, const char *msg)
 {
   int                 wp = 0, wi = 0;
   int                 lindent = 0;
+  int                 len = 0;
 
   if (package != -1) {
     if (!sc_package_is_registered (package))
@@ -263,46 +388,254 @@ sc_log_handler (FILE * log_stream, const char *filename, int lineno,
   wi = (category == SC_LC_NORMAL && sc_identifier >= 0);
 
   if (wp || wi) {
-    fputc ('[', log_stream);
-    if (wp)
-      fprintf (log_stream, "%s", sc_packages[package].name);
-    if (wp && wi)
-      fputc (' ', log_stream);
+    char                ident[BUFSIZ];
+
+    ident[0] = '\0';
     if (wi)
-      fprintf (log_stream, "%d", sc_identifier);
-    fprintf (log_stream, "] %*s", lindent, "");
+      snprintf (ident, BUFSIZ, "%s%d", wp ? " " : "", sc_identifier);
+    len += snprintf (buffer, size, "[%s%s] %*s",
+                     wp ? sc_packages[package].name : "", ident,
+                     lindent, "");
   }
 
-  if (priority == SC_LP_TRACE) {
+  if (priority == SC_LP_TRACE && (size_t) len < size) {
     char                bn[BUFSIZ], *bp;
 
     snprintf (bn, BUFSIZ, "%s", filename);
     bp = basename (bn);
-    fprintf (log_stream, "%s:%d ", bp, lineno);
+    len += snprintf (buffer + len, size - len, "%s:%d ", bp, lineno);
   }
 
-  fputs (msg, log_stream);
+  if ((size_t) len < size) {
+    len += snprintf (buffer + len, size - len, "%s", msg);
+  }
+  return SC_MIN ((size_t) len, size - 1);
+}
+
+static void
+sc_log_handler (FILE * log_stream, const char *filename, int lineno,
+                int package, int category, int priority, const char *msg)
+{
+  char                buffer[SC_LOG_MESSAGE_BYTES];
+
+  sc_log_format (buffer, SC_LOG_MESSAGE_BYTES, filename, lineno,
+                 package, category, priority, msg);
+  fputs (buffer, log_stream);
   fflush (log_stream);
 }
 
-static int         *
-sc_malloc_count (int package)
+static sc_memory_slot_t *
+sc_memory_slots (int package)
 {
   if (package == -1)
-    return &default_malloc_count;
+    return default_memory;
 
   SC_ASSERT (sc_package_is_registered (package));
-  return &sc_packages[package].malloc_count;
+  return sc_packages[package].memory;
+}
+
+#ifdef SC_MEMORY_ATOMIC
+
+/** Threads are assigned to the memory slots in round robin. */
+static int          sc_memory_next_slot = 0;
+static __thread int sc_memory_thread_slot = -1;
+
+#endif
+
+/** Count allocations and deallocations without locking if possible.
+ * With atomics, each thread updates its own slot and the slots are only
+ * summed up by \ref sc_memory_counts.  Otherwise, we lock the package.
+ */
+static void
+sc_memory_count (int package, int num_malloc, int num_free)
+{
+  sc_memory_slot_t   *slot = sc_memory_slots (package);
+
+#ifdef SC_MEMORY_ATOMIC
+  if (sc_memory_thread_slot < 0) {
+    sc_memory_thread_slot =
+      __atomic_fetch_add (&sc_memory_next_slot, 1, __ATOMIC_RELAXED) %
+      SC_MEMORY_SLOTS;
+  }
+  slot += sc_memory_thread_slot;
+  if (num_malloc) {
+    __atomic_fetch_add (&slot->malloc_count, num_malloc, __ATOMIC_RELAXED);
+  }
+  if (num_free) {
+    __atomic_fetch_add (&slot->free_count, num_free, __ATOMIC_RELAXED);
+  }
+#else
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+  slot->malloc_count += num_malloc;
+  slot->free_count += num_free;
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+#endif
+}
+
+/** Sum up the allocation counters of a package over all slots. */
+static void
+sc_memory_counts (int package, int *malloc_count, int *free_count)
+{
+  int                 i;
+  sc_memory_slot_t   *slots = sc_memory_slots (package);
+
+  *malloc_count = *free_count = 0;
+  for (i = 0; i < SC_MEMORY_SLOTS; ++i) {
+#ifdef SC_MEMORY_ATOMIC
+    *malloc_count += __atomic_load_n (&slots[i].malloc_count,
+                                      __ATOMIC_RELAXED);
+    *free_count += __atomic_load_n (&slots[i].free_count, __ATOMIC_RELAXED);
+#else
+    *malloc_count += slots[i].malloc_count;
+    *free_count += slots[i].free_count;
+#endif
+  }
 }
 
-static int         *
-sc_free_count (int package)
+/** Return the allocator backend of a package or NULL for the default. */
+static const sc_allocator_t *
+sc_package_allocator (int package)
+{
+  const sc_allocator_t *allocator;
+
+  if (package == -1) {
+    allocator = &default_allocator;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package));
+    allocator = &sc_packages[package].allocator;
+  }
+  return allocator->malloc_fn == NULL ? NULL : allocator;
+}
+
+/** Reset the allocation counters of a package. */
+/** Allocate the memory slots of a package entry on a cache line. */
+static void
+sc_memory_slots_alloc (sc_package_t * p)
+{
+  uintptr_t           addr;
+
+  p->memory_alloc = malloc (SC_MEMORY_SLOTS * sizeof (sc_memory_slot_t) +
+                            SC_MEMORY_SLOT_BYTES - 1);
+  SC_CHECK_ABORT (p->memory_alloc != NULL, "Failed to allocate memory");
+  addr = (uintptr_t) p->memory_alloc + SC_MEMORY_SLOT_BYTES - 1;
+  addr -= addr % SC_MEMORY_SLOT_BYTES;
+  p->memory = (sc_memory_slot_t *) addr;
+}
+
+static void
+sc_memory_reset (sc_memory_slot_t * slots)
+{
+  memset (slots, 0, SC_MEMORY_SLOTS * sizeof (sc_memory_slot_t));
+}
+
+/** Return the memory profile of a package or NULL if it is disabled. */
+static sc_memory_profile_t *
+sc_memory_profile_get (int package)
 {
   if (package == -1)
-    return &default_free_count;
+    return default_profile;
 
   SC_ASSERT (sc_package_is_registered (package));
-  return &sc_packages[package].free_count;
+  return sc_packages[package].profile;
+}
+
+/** Find or create the entry of an allocation site in the profile.
+ * Must be called with the profile locked.
+ */
+static int
+sc_memory_profile_site (sc_memory_profile_t * profile,
+                        const char *file, int line)
+{
+  int                 i, site;
+  sc_memory_site_t   *s;
+
+  if (file == NULL) {
+    return 0;
+  }
+  site = (int) (((unsigned) line * 2654435761U) %
+                (SC_MEMORY_PROFILE_SITES - 1)) + 1;
+  for (i = 1; i < SC_MEMORY_PROFILE_SITES; ++i) {
+    s = profile->sites + site;
+    if (s->file == NULL) {
+      s->file = file;
+      s->line = line;
+      return site;
+    }
+    if (s->line == line && (s->file == file || !strcmp (s->file, file))) {
+      return site;
+    }
+    if (++site == SC_MEMORY_PROFILE_SITES) {
+      site = 1;
+    }
+  }
+
+  /* the table is full */
+  return 0;
+}
+
+/** Account for a change in the size of an allocation.
+ * A new allocation is passed with site < 0 and returns its site.
+ * A deallocation is passed with new_size zero.
+ */
+static int
+sc_memory_profile_update (int package, int site,
+                          const char *file, int line,
+                          size_t old_size, size_t new_size)
+{
+  int                 c;
+  sc_memory_profile_t *profile = sc_memory_profile_get (package);
+  sc_memory_site_t   *s;
+
+  SC_ASSERT (profile != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+#if defined _OPENMP && !defined SC_ENABLE_PTHREAD
+#pragma omp critical (sc_memory_profile)
+#endif
+  {
+    if (site < 0) {
+      site = sc_memory_profile_site (profile, file, line);
+      c = new_size > 0 ? SC_LOG2_64 ((uint64_t) new_size) : 0;
+      ++profile->histogram[SC_MIN (c, SC_MEMORY_CLASSES - 1)];
+      ++profile->sites[site].count;
+    }
+    SC_ASSERT (0 <= site && site < SC_MEMORY_PROFILE_SITES);
+    SC_ASSERT (profile->current >= old_size);
+    profile->current += new_size - old_size;
+    profile->peak = SC_MAX (profile->peak, profile->current);
+
+    s = profile->sites + site;
+    SC_ASSERT (s->current >= old_size);
+    s->current += new_size - old_size;
+    s->peak = SC_MAX (s->peak, s->current);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+
+  return site;
+}
+
+/** Fill the header of a profiled allocation and return the user pointer. */
+static void        *
+sc_memory_profile_alloc (int package, void *base, size_t size,
+                         const char *file, int line)
+{
+  sc_memory_header_t *header = (sc_memory_header_t *) base;
+
+  SC_ASSERT (sizeof (sc_memory_header_t) <= SC_MEMORY_HEADER);
+  SC_ASSERT (base != NULL);
+
+  header->size = size;
+  header->site = sc_memory_profile_update (package, -1, file, line, 0, size);
+  return (char *) base + SC_MEMORY_HEADER;
 }
 
 #ifdef SC_ENABLE_MEMALIGN
@@ -503,97 +836,206 @@ sc_realloc_aligned (void *ptr, size_t alignment, size_t size)
 
 #endif /* SC_ENABLE_MEMALIGN */
 
-void               *
-sc_malloc (int package, size_t size)
+/** Allocate memory from the backend or the C library. */
+static void        *
+sc_malloc_base (const sc_allocator_t * allocator, size_t size)
 {
   void               *ret;
-  int                *malloc_count = sc_malloc_count (package);
 
-  /* allocate memory */
+  if (allocator != NULL) {
+    ret = allocator->malloc_fn (size, allocator->user);
+    if (size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (malloc size %lli)",
+                       (long long int) size);
+    }
+  }
+  else {
+#if defined SC_ENABLE_MEMALIGN
+    ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, size);
+#else
+    ret = malloc (size);
+    if (size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (malloc size %lli)",
+                       (long long int) size);
+    }
+#endif
+  }
+  return ret;
+}
+
+/** Allocate zeroed memory from the backend or the C library. */
+static void        *
+sc_calloc_base (const sc_allocator_t * allocator, size_t nmemb, size_t size)
+{
+  void               *ret;
+
+  if (allocator != NULL) {
+    if (allocator->calloc_fn != NULL) {
+      ret = allocator->calloc_fn (nmemb, size, allocator->user);
+    }
+    else {
+      ret = allocator->malloc_fn (nmemb * size, allocator->user);
+      if (ret != NULL) {
+        memset (ret, 0, nmemb * size);
+      }
+    }
+    if (nmemb * size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
+                       (long long int) size);
+    }
+  }
+  else {
 #if defined SC_ENABLE_MEMALIGN
-  ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, size);
+    ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, nmemb * size);
+    memset (ret, 0, nmemb * size);
 #else
-  ret = malloc (size);
-  if (size > 0) {
-    SC_CHECK_ABORTF (ret != NULL, "Allocation (malloc size %lli)",
+    ret = calloc (nmemb, size);
+    if (nmemb * size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
+                       (long long int) size);
+    }
+#endif
+  }
+  return ret;
+}
+
+/** Reallocate memory from the backend or the C library.
+ * The pointer must not be NULL and the size must be positive.
+ */
+static void        *
+sc_realloc_base (const sc_allocator_t * allocator, void *ptr, size_t size)
+{
+  void               *ret;
+
+  SC_ASSERT (ptr != NULL && size > 0);
+
+  if (allocator != NULL) {
+    ret = allocator->realloc_fn (ptr, size, allocator->user);
+    SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
                      (long long int) size);
+    return ret;
   }
+
+#if defined SC_ENABLE_MEMALIGN
+  ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
+#else
+  ret = realloc (ptr, size);
+  SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
+                   (long long int) size);
 #endif
+  return ret;
+}
 
-  /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
+/** Free memory to the backend or the C library. */
+static void
+sc_free_base (const sc_allocator_t * allocator, void *ptr)
+{
+  if (allocator != NULL) {
+    allocator->free_fn (ptr, allocator->user);
+    return;
+  }
+#if defined SC_ENABLE_MEMALIGN
+  sc_free_aligned (ptr, SC_MEMALIGN_BYTES);
+#else
+  free (ptr);
 #endif
-  if (size > 0) {
-    ++*malloc_count;
+}
+
+void               *
+sc_malloc (int package, size_t size)
+{
+  return sc_malloc_site (package, size, NULL, 0);
+}
+
+void               *
+sc_malloc_site (int package, size_t size, const char *file, int line)
+{
+  void               *ret;
+  const sc_allocator_t *allocator = sc_package_allocator (package);
+
+  /* allocate memory */
+  if (sc_memory_profile_get (package) == NULL) {
+    ret = sc_malloc_base (allocator, size);
   }
   else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
+    ret = sc_memory_profile_alloc
+      (package, sc_malloc_base (allocator, size + SC_MEMORY_HEADER),
+       size, file, line);
+  }
+
+  /* count the allocations */
+  if (size > 0 || ret != NULL) {
+    sc_memory_count (package, 1, 0);
   }
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
 
   return ret;
 }
 
 void               *
 sc_calloc (int package, size_t nmemb, size_t size)
+{
+  return sc_calloc_site (package, nmemb, size, NULL, 0);
+}
+
+void               *
+sc_calloc_site (int package, size_t nmemb, size_t size,
+                const char *file, int line)
 {
   void               *ret;
-  int                *malloc_count = sc_malloc_count (package);
+  const sc_allocator_t *allocator = sc_package_allocator (package);
 
   /* allocate memory */
-#if defined SC_ENABLE_MEMALIGN
-  ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, nmemb * size);
-  memset (ret, 0, nmemb * size);
-#else
-  ret = calloc (nmemb, size);
-  if (nmemb * size > 0) {
-    SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
-                     (long long int) size);
+  if (sc_memory_profile_get (package) == NULL) {
+    ret = sc_calloc_base (allocator, nmemb, size);
+  }
+  else {
+    ret = sc_memory_profile_alloc
+      (package, sc_calloc_base (allocator, 1, nmemb * size +
+                                SC_MEMORY_HEADER), nmemb * size, file, line);
   }
-#endif
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-  if (nmemb * size > 0) {
-    ++*malloc_count;
+  if (nmemb * size > 0 || ret != NULL) {
+    sc_memory_count (package, 1, 0);
   }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
-  }
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
-#endif
 
   return ret;
 }
 
 void               *
 sc_realloc (int package, void *ptr, size_t size)
+{
+  return sc_realloc_site (package, ptr, size, NULL, 0);
+}
+
+void               *
+sc_realloc_site (int package, void *ptr, size_t size,
+                 const char *file, int line)
 {
   if (ptr == NULL) {
-    return sc_malloc (package, size);
+    return sc_malloc_site (package, size, file, line);
   }
   else if (size == 0) {
     sc_free (package, ptr);
     return NULL;
   }
   else {
-    void               *ret;
+    const sc_allocator_t *allocator = sc_package_allocator (package);
+    sc_memory_header_t *header;
+    size_t              old_size;
 
-#if defined SC_ENABLE_MEMALIGN
-    ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
-#else
-    ret = realloc (ptr, size);
-    SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
-                     (long long int) size);
-#endif
+    if (sc_memory_profile_get (package) == NULL) {
+      return sc_realloc_base (allocator, ptr, size);
+    }
 
-    return ret;
+    /* the reallocation stays attributed to its original site */
+    header = (sc_memory_header_t *) ((char *) ptr - SC_MEMORY_HEADER);
+    old_size = header->size;
+    header = (sc_memory_header_t *)
+      sc_realloc_base (allocator, header, size + SC_MEMORY_HEADER);
+    header->size = size;
+    sc_memory_profile_update (package, header->site, NULL, 0, old_size, size);
+    return (char *) header + SC_MEMORY_HEADER;
   }
 }
 
@@ -615,74 +1057,546 @@ sc_strdup (int package, const char *s)
 }
 
 void
-sc_free (int package, void *ptr)
+sc_free (int package, void *ptr)
+{
+  const sc_allocator_t *allocator;
+
+  if (ptr == NULL) {
+    return;
+  }
+  else {
+    /* uncount the allocations */
+    sc_memory_count (package, 0, 1);
+  }
+
+  /* free memory */
+  allocator = sc_package_allocator (package);
+  if (sc_memory_profile_get (package) != NULL) {
+    sc_memory_header_t *header;
+
+    header = (sc_memory_header_t *) ((char *) ptr - SC_MEMORY_HEADER);
+    sc_memory_profile_update (package, header->site, NULL, 0,
+                              header->size, 0);
+    ptr = header;
+  }
+  sc_free_base (allocator, ptr);
+}
+
+int
+sc_memory_status (int package)
+{
+  int                 malloc_count, free_count;
+
+  sc_memory_counts (package, &malloc_count, &free_count);
+  return malloc_count - free_count;
+}
+
+void
+sc_package_set_abort_alloc_mismatch (int package_id, int set_abort)
+{
+  if (package_id == -1) {
+    default_abort_mismatch = set_abort;
+  }
+  else {
+    sc_package_t       *p;
+
+    SC_ASSERT (sc_package_is_registered (package_id));
+    p = sc_packages + package_id;
+    p->abort_mismatch = set_abort;
+  }
+}
+
+void
+sc_package_set_allocator (int package_id, const sc_allocator_t * allocator)
+{
+  sc_allocator_t     *dest;
+
+  SC_CHECK_ABORT (sc_memory_status (package_id) == 0,
+                  "Allocator change with memory in use");
+  if (package_id == -1) {
+    dest = &default_allocator;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package_id));
+    dest = &sc_packages[package_id].allocator;
+  }
+
+  if (allocator == NULL) {
+    memset (dest, 0, sizeof (sc_allocator_t));
+  }
+  else {
+    SC_CHECK_ABORT (allocator->malloc_fn != NULL &&
+                    allocator->realloc_fn != NULL &&
+                    allocator->free_fn != NULL, "Incomplete allocator");
+    *dest = *allocator;
+  }
+}
+
+void
+sc_package_set_memory_profile (int package_id, int enable)
+{
+  sc_memory_profile_t **dest;
+
+  SC_CHECK_ABORT (sc_memory_status (package_id) == 0,
+                  "Memory profile change with memory in use");
+  if (package_id == -1) {
+    dest = &default_profile;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package_id));
+    dest = &sc_packages[package_id].profile;
+  }
+
+  /* the profile itself is not counted as an allocation */
+  if (enable && *dest == NULL) {
+    *dest = (sc_memory_profile_t *) calloc (1, sizeof (sc_memory_profile_t));
+    SC_CHECK_ABORT (*dest != NULL, "Failed to allocate memory profile");
+  }
+  else if (!enable && *dest != NULL) {
+    free (*dest);
+    *dest = NULL;
+  }
+}
+
+int
+sc_memory_bytes (int package, size_t * current, size_t * peak)
+{
+  sc_memory_profile_t *profile = sc_memory_profile_get (package);
+
+  if (profile == NULL) {
+    if (current != NULL)
+      *current = 0;
+    if (peak != NULL)
+      *peak = 0;
+    return 0;
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+#if defined _OPENMP && !defined SC_ENABLE_PTHREAD
+#pragma omp critical (sc_memory_profile)
+#endif
+  {
+    if (current != NULL)
+      *current = profile->current;
+    if (peak != NULL)
+      *peak = profile->peak;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+  return 1;
+}
+
+/** An allocation in a non-host memory domain. */
+typedef struct sc_memory_domain_entry
+{
+  void               *ptr;
+  size_t              size;
+  int                 package;
+  int                 domain;
+}
+sc_memory_domain_entry_t;
+
+/* Open addressing table of the non-host allocations, since we cannot
+ * prepend a header to device memory to remember the size. */
+static sc_memory_domain_entry_t *sc_domain_table = NULL;
+static size_t       sc_domain_table_alloc = 0;
+static size_t       sc_domain_table_count = 0;
+
+#ifdef SC_ENABLE_PTHREAD
+static pthread_mutex_t sc_domain_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#if defined SC_ENABLE_CUDA
+
+static void        *
+sc_memory_cuda_malloc (sc_memory_domain_t domain, size_t size, void *user)
+{
+  void               *ptr = NULL;
+  cudaError_t         err;
+
+  if (domain == SC_MEMORY_PINNED) {
+    err = cudaMallocHost (&ptr, size);
+  }
+  else if (domain == SC_MEMORY_MANAGED) {
+    err = cudaMallocManaged (&ptr, size, cudaMemAttachGlobal);
+  }
+  else {
+    err = cudaMalloc (&ptr, size);
+  }
+  return err == cudaSuccess ? ptr : NULL;
+}
+
+static void
+sc_memory_cuda_free (sc_memory_domain_t domain, void *ptr, void *user)
+{
+  cudaError_t         err;
+
+  err = domain == SC_MEMORY_PINNED ? cudaFreeHost (ptr) : cudaFree (ptr);
+  SC_CHECK_ABORT (err == cudaSuccess, "CUDA free");
+}
+
+static void
+sc_memory_cuda_copy (void *dest, const void *src, size_t n, void *user)
+{
+  SC_CHECK_ABORT (cudaMemcpy (dest, src, n, cudaMemcpyDefault)
+                  == cudaSuccess, "CUDA memcpy");
+}
+
+static const sc_memory_backend_t sc_memory_builtin_backend =
+{
+  sc_memory_cuda_malloc, sc_memory_cuda_free, sc_memory_cuda_copy, 0, NULL
+};
+
+#elif defined SC_ENABLE_HIP
+
+static void        *
+sc_memory_hip_malloc (sc_memory_domain_t domain, size_t size, void *user)
+{
+  void               *ptr = NULL;
+  hipError_t          err;
+
+  if (domain == SC_MEMORY_PINNED) {
+    err = hipHostMalloc (&ptr, size, hipHostMallocDefault);
+  }
+  else if (domain == SC_MEMORY_MANAGED) {
+    err = hipMallocManaged (&ptr, size, hipMemAttachGlobal);
+  }
+  else {
+    err = hipMalloc (&ptr, size);
+  }
+  return err == hipSuccess ? ptr : NULL;
+}
+
+static void
+sc_memory_hip_free (sc_memory_domain_t domain, void *ptr, void *user)
+{
+  hipError_t          err;
+
+  err = domain == SC_MEMORY_PINNED ? hipHostFree (ptr) : hipFree (ptr);
+  SC_CHECK_ABORT (err == hipSuccess, "HIP free");
+}
+
+static void
+sc_memory_hip_copy (void *dest, const void *src, size_t n, void *user)
+{
+  SC_CHECK_ABORT (hipMemcpy (dest, src, n, hipMemcpyDefault)
+                  == hipSuccess, "HIP memcpy");
+}
+
+static const sc_memory_backend_t sc_memory_builtin_backend =
+{
+  sc_memory_hip_malloc, sc_memory_hip_free, sc_memory_hip_copy, 0, NULL
+};
+
+#else
+
+static void        *
+sc_memory_host_malloc (sc_memory_domain_t domain, size_t size, void *user)
+{
+  return malloc (size);
+}
+
+static void
+sc_memory_host_free (sc_memory_domain_t domain, void *ptr, void *user)
+{
+  free (ptr);
+}
+
+static void
+sc_memory_host_copy (void *dest, const void *src, size_t n, void *user)
+{
+  memcpy (dest, src, n);
+}
+
+static const sc_memory_backend_t sc_memory_builtin_backend =
+{
+  sc_memory_host_malloc, sc_memory_host_free, sc_memory_host_copy, 1, NULL
+};
+
+#endif
+
+static sc_memory_backend_t sc_memory_backend = { NULL, NULL, NULL, 0, NULL };
+
+/** Return the active backend of the non-host domains. */
+static const sc_memory_backend_t *
+sc_memory_get_backend (void)
+{
+  return sc_memory_backend.malloc_fn == NULL ?
+    &sc_memory_builtin_backend : &sc_memory_backend;
+}
+
+static size_t
+sc_memory_domain_slot (const void *ptr)
+{
+  uint64_t            h = (uint64_t) (uintptr_t) ptr;
+
+  h = (h >> 4) * 0x9E3779B97F4A7C15ULL;
+  return (size_t) (h >> 32) & (sc_domain_table_alloc - 1);
+}
+
+/** Insert an allocation into the table; call with the lock held. */
+static void
+sc_memory_domain_insert (const sc_memory_domain_entry_t * entry)
+{
+  size_t              z;
+
+  if (2 * (sc_domain_table_count + 1) > sc_domain_table_alloc) {
+    sc_memory_domain_entry_t *old = sc_domain_table;
+    size_t              old_alloc = sc_domain_table_alloc;
+
+    /* the table itself is not counted as an allocation */
+    sc_domain_table_alloc = SC_MAX (64, 2 * old_alloc);
+    sc_domain_table = (sc_memory_domain_entry_t *)
+      calloc (sc_domain_table_alloc, sizeof (sc_memory_domain_entry_t));
+    SC_CHECK_ABORT (sc_domain_table != NULL, "Memory domain table");
+    sc_domain_table_count = 0;
+    for (z = 0; z < old_alloc; ++z) {
+      if (old[z].ptr != NULL) {
+        sc_memory_domain_insert (old + z);
+      }
+    }
+    free (old);
+  }
+
+  z = sc_memory_domain_slot (entry->ptr);
+  while (sc_domain_table[z].ptr != NULL) {
+    z = (z + 1) & (sc_domain_table_alloc - 1);
+  }
+  sc_domain_table[z] = *entry;
+  ++sc_domain_table_count;
+}
+
+/** Remove an allocation from the table; call with the lock held. */
+static int
+sc_memory_domain_remove (void *ptr, sc_memory_domain_entry_t * entry)
+{
+  size_t              z, y, home, mask = sc_domain_table_alloc - 1;
+
+  if (sc_domain_table_count == 0) {
+    return 0;
+  }
+  for (z = sc_memory_domain_slot (ptr); sc_domain_table[z].ptr != ptr;
+       z = (z + 1) & mask) {
+    if (sc_domain_table[z].ptr == NULL) {
+      return 0;
+    }
+  }
+  *entry = sc_domain_table[z];
+  --sc_domain_table_count;
+
+  /* shift back the following entries of the cluster */
+  for (y = (z + 1) & mask; sc_domain_table[y].ptr != NULL;
+       y = (y + 1) & mask) {
+    home = sc_memory_domain_slot (sc_domain_table[y].ptr);
+    if (((y - home) & mask) >= ((y - z) & mask)) {
+      sc_domain_table[z] = sc_domain_table[y];
+      z = y;
+    }
+  }
+  sc_domain_table[z].ptr = NULL;
+  if (sc_domain_table_count == 0) {
+    free (sc_domain_table);
+    sc_domain_table = NULL;
+    sc_domain_table_alloc = 0;
+  }
+  return 1;
+}
+
+/** Add to the bytes of a package in a domain; call with the lock held. */
+static void
+sc_memory_domain_account (int package, int domain, size_t add, size_t sub)
+{
+  size_t             *current, *peak;
+
+  if (package == -1) {
+    current = default_domain_current;
+    peak = default_domain_peak;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package));
+    current = sc_packages[package].domain_current;
+    peak = sc_packages[package].domain_peak;
+  }
+  current[domain] += add;
+  current[domain] -= sub;
+  peak[domain] = SC_MAX (peak[domain], current[domain]);
+}
+
+void
+sc_memory_set_backend (const sc_memory_backend_t * backend)
+{
+  SC_CHECK_ABORT (sc_domain_table_count == 0,
+                  "Memory backend change with memory in use");
+  if (backend == NULL) {
+    memset (&sc_memory_backend, 0, sizeof (sc_memory_backend_t));
+  }
+  else {
+    SC_CHECK_ABORT (backend->malloc_fn != NULL && backend->free_fn != NULL
+                    && backend->copy_fn != NULL, "Incomplete backend");
+    sc_memory_backend = *backend;
+  }
+}
+
+int
+sc_memory_domain_is_host (sc_memory_domain_t domain)
+{
+  SC_ASSERT (0 <= domain && domain < SC_MEMORY_NUM_DOMAINS);
+  return domain != SC_MEMORY_DEVICE ||
+    sc_memory_get_backend ()->device_on_host;
+}
+
+void               *
+sc_malloc_domain (int package, sc_memory_domain_t domain, size_t size)
+{
+  const sc_memory_backend_t *backend;
+  sc_memory_domain_entry_t entry;
+
+  SC_ASSERT (0 <= domain && domain < SC_MEMORY_NUM_DOMAINS);
+  if (domain == SC_MEMORY_HOST) {
+    return sc_malloc (package, size);
+  }
+  if (size == 0) {
+    return NULL;
+  }
+
+  backend = sc_memory_get_backend ();
+  entry.ptr = backend->malloc_fn (domain, size, backend->user);
+  SC_CHECK_ABORTF (entry.ptr != NULL, "Allocation (domain %d size %lli)",
+                   (int) domain, (long long int) size);
+  entry.size = size;
+  entry.package = package;
+  entry.domain = (int) domain;
+  sc_memory_count (package, 1, 0);
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_domain_mutex);
+#endif
+#if defined _OPENMP && !defined SC_ENABLE_PTHREAD
+#pragma omp critical (sc_memory_domain)
+#endif
+  {
+    sc_memory_domain_insert (&entry);
+    sc_memory_domain_account (package, domain, size, 0);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_domain_mutex);
+#endif
+  return entry.ptr;
+}
+
+void
+sc_free_domain (int package, sc_memory_domain_t domain, void *ptr)
 {
+  const sc_memory_backend_t *backend;
+  sc_memory_domain_entry_t entry;
+  int                 found = 0;
+
+  SC_ASSERT (0 <= domain && domain < SC_MEMORY_NUM_DOMAINS);
+  if (domain == SC_MEMORY_HOST) {
+    sc_free (package, ptr);
+    return;
+  }
   if (ptr == NULL) {
     return;
   }
-  else {
-    /* uncount the allocations */
-    int                *free_count = sc_free_count (package);
 
 #ifdef SC_ENABLE_PTHREAD
-    sc_package_lock (package);
+  pthread_mutex_lock (&sc_domain_mutex);
 #endif
-    ++*free_count;
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_unlock (package);
+#if defined _OPENMP && !defined SC_ENABLE_PTHREAD
+#pragma omp critical (sc_memory_domain)
 #endif
+  {
+    found = sc_memory_domain_remove (ptr, &entry);
+    if (found) {
+      sc_memory_domain_account (entry.package, entry.domain, 0, entry.size);
+    }
   }
-
-  /* free memory */
-#if defined SC_ENABLE_MEMALIGN
-  sc_free_aligned (ptr, SC_MEMALIGN_BYTES);
-#else
-  free (ptr);
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_domain_mutex);
 #endif
+  SC_CHECK_ABORT (found, "Free of unknown domain memory");
+  SC_CHECK_ABORT (entry.package == package && entry.domain == (int) domain,
+                  "Free with mismatched package or domain");
+
+  sc_memory_count (package, 0, 1);
+  backend = sc_memory_get_backend ();
+  backend->free_fn (domain, ptr, backend->user);
 }
 
-int
-sc_memory_status (int package)
+void
+sc_memcpy_domain (void *dest, sc_memory_domain_t dest_domain,
+                  const void *src, sc_memory_domain_t src_domain, size_t n)
 {
-  sc_package_t       *p;
+  const sc_memory_backend_t *backend;
 
-  if (package == -1) {
-    return (default_malloc_count - default_free_count);
+  if (n == 0) {
+    return;
   }
-  else {
-    SC_ASSERT (sc_package_is_registered (package));
-    p = sc_packages + package;
-    return (p->malloc_count - p->free_count);
+  if (sc_memory_domain_is_host (dest_domain) &&
+      sc_memory_domain_is_host (src_domain)) {
+    memcpy (dest, src, n);
+    return;
   }
+  backend = sc_memory_get_backend ();
+  backend->copy_fn (dest, src, n, backend->user);
 }
 
-void
-sc_package_set_abort_alloc_mismatch (int package_id, int set_abort)
+int
+sc_memory_domain_bytes (int package, sc_memory_domain_t domain,
+                        size_t * current, size_t * peak)
 {
-  if (package_id == -1) {
-    default_abort_mismatch = set_abort;
+  const size_t       *pcurrent, *ppeak;
+
+  SC_ASSERT (0 <= domain && domain < SC_MEMORY_NUM_DOMAINS);
+  if (domain == SC_MEMORY_HOST) {
+    return sc_memory_bytes (package, current, peak);
+  }
+  if (package == -1) {
+    pcurrent = default_domain_current;
+    ppeak = default_domain_peak;
   }
   else {
-    sc_package_t       *p;
+    SC_ASSERT (sc_package_is_registered (package));
+    pcurrent = sc_packages[package].domain_current;
+    ppeak = sc_packages[package].domain_peak;
+  }
 
-    SC_ASSERT (sc_package_is_registered (package_id));
-    p = sc_packages + package_id;
-    p->abort_mismatch = set_abort;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_domain_mutex);
+#endif
+#if defined _OPENMP && !defined SC_ENABLE_PTHREAD
+#pragma omp critical (sc_memory_domain)
+#endif
+  {
+    if (current != NULL)
+      *current = pcurrent[domain];
+    if (peak != NULL)
+      *peak = ppeak[domain];
   }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_domain_mutex);
+#endif
+  return 1;
 }
 
 void
 sc_memory_check (int package)
 {
+  int                 malloc_count, free_count;
   sc_package_t       *p;
 
+  sc_memory_counts (package, &malloc_count, &free_count);
   if (package == -1) {
     SC_CHECK_ABORT (default_rc_active == 0, "Leftover references (default)");
     if (default_abort_mismatch) {
-      SC_CHECK_ABORT (default_malloc_count == default_free_count,
+      SC_CHECK_ABORT (malloc_count == free_count,
                       "Memory balance (default)");
     }
-    else if (default_malloc_count != default_free_count) {
+    else if (malloc_count != free_count) {
       SC_GLOBAL_LERROR ("Memory balance (default)\n");
     }
   }
@@ -691,10 +1605,10 @@ sc_memory_check (int package)
     p = sc_packages + package;
     SC_CHECK_ABORTF (p->rc_active == 0, "Leftover references (%s)", p->name);
     if (p->abort_mismatch) {
-      SC_CHECK_ABORTF (p->malloc_count == p->free_count,
+      SC_CHECK_ABORTF (malloc_count == free_count,
                        "Memory balance (%s)", p->name);
     }
-    else if (p->malloc_count != p->free_count) {
+    else if (malloc_count != free_count) {
       SC_GLOBAL_LERRORF ("Memory balance (%s)\n", p->name);
     }
   }
@@ -767,10 +1681,403 @@ sc_atol (const char *nptr)
   return strtol (nptr, NULL, 10);
 }
 
+/** Recompute the thresholds cached for the log macros.
+ * This is called whenever a threshold, the trace file or the rank change.
+ */
+static void
+sc_log_thresholds_update (void)
+{
+  int                 i, threshold;
+  sc_package_t       *p;
+
+  for (i = -1; i < SC_LOG_PACKAGES; ++i) {
+    threshold = sc_default_log_threshold;
+    if (i >= 0 && i < sc_num_packages_alloc && sc_packages[i].is_registered) {
+      p = sc_packages + i;
+      if (p->log_threshold != SC_LP_DEFAULT) {
+        threshold = p->log_threshold;
+      }
+    }
+    if (sc_trace_file != NULL) {
+      threshold = SC_MIN (threshold, sc_trace_prio);
+    }
+    sc_log_thresholds[i + 1] = threshold;
+  }
+  sc_log_global_active = sc_identifier <= 0;
+}
+
+/* asynchronous logging */
+
+/** Messages of one thread waiting for the flusher.
+ * The thread advances head and the flusher advances tail.
+ */
+typedef struct sc_log_ring
+{
+  size_t              head;
+  size_t              tail;
+  struct sc_log_ring *next;     /**< List of all rings. */
+  char                data[SC_LOG_RING_BYTES];
+}
+sc_log_ring_t;
+
+static int          sc_log_async = 0;
+static int          sc_log_per_node = 0;
+static char        *sc_log_batch = NULL;
+static size_t       sc_log_batch_count = 0;
+
+#ifdef SC_LOG_THREADED
+
+/** All rings of the threads, linked by their next member. */
+static sc_log_ring_t *sc_log_rings = NULL;
+
+/** Rings of a previous generation are no longer valid. */
+static int          sc_log_generation = 0;
+static __thread sc_log_ring_t *sc_log_thread_ring = NULL;
+static __thread int sc_log_thread_generation = -1;
+
+static pthread_t    sc_log_flusher;
+static int          sc_log_stop = 0;
+static pthread_cond_t sc_log_cond = PTHREAD_COND_INITIALIZER;
+
+#endif
+
+#ifdef SC_ENABLE_PTHREAD
+/** Protects the batch and the consumer side of the rings. */
+static pthread_mutex_t sc_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/** Write the batch to the log stream at once. */
+static void
+sc_log_batch_write (void)
+{
+  FILE               *log_stream =
+    sc_log_stream != NULL ? sc_log_stream : stdout;
+
+  if (sc_log_batch_count > 0) {
+    fwrite (sc_log_batch, 1, sc_log_batch_count, log_stream);
+    fflush (log_stream);
+    sc_log_batch_count = 0;
+  }
+}
+
+/** Append bytes to the batch and write it first if it would overflow. */
+static void
+sc_log_batch_append (const char *data, size_t len)
+{
+  if (sc_log_batch_count + len > SC_LOG_BATCH_BYTES) {
+    sc_log_batch_write ();
+  }
+  SC_ASSERT (len <= SC_LOG_BATCH_BYTES);
+  memcpy (sc_log_batch + sc_log_batch_count, data, len);
+  sc_log_batch_count += len;
+}
+
+#ifdef SC_LOG_THREADED
+
+/** Move the messages of all rings into the batch.
+ * Must be called with sc_log_mutex locked.
+ */
+static void
+sc_log_drain (void)
+{
+  size_t              head, tail, start, len;
+  sc_log_ring_t      *ring;
+
+  for (ring = __atomic_load_n (&sc_log_rings, __ATOMIC_ACQUIRE);
+       ring != NULL; ring = ring->next) {
+    head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+    tail = ring->tail;
+    while (tail != head) {
+      start = tail % SC_LOG_RING_BYTES;
+      len = SC_MIN (head - tail, SC_LOG_RING_BYTES - start);
+      sc_log_batch_append (ring->data + start, len);
+      tail += len;
+    }
+    __atomic_store_n (&ring->tail, tail, __ATOMIC_RELEASE);
+  }
+}
+
+/** Wake up periodically to write the drained messages. */
+static void        *
+sc_log_flusher_main (void *arg)
+{
+  struct timespec     ts;
+
+  pthread_mutex_lock (&sc_log_mutex);
+  while (!sc_log_stop) {
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ts.tv_nsec += SC_LOG_FLUSH_MS * 1000000L;
+    ts.tv_sec += ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait (&sc_log_cond, &sc_log_mutex, &ts);
+
+    /* with per-node output the batch waits for sc_log_collect */
+    sc_log_drain ();
+    if (!sc_log_per_node) {
+      sc_log_batch_write ();
+    }
+  }
+  pthread_mutex_unlock (&sc_log_mutex);
+  return NULL;
+}
+
+/** Return the ring of the calling thread and create it if necessary. */
+static sc_log_ring_t *
+sc_log_ring (void)
+{
+  sc_log_ring_t      *ring;
+
+  if (sc_log_thread_ring == NULL ||
+      sc_log_thread_generation != sc_log_generation) {
+    ring = (sc_log_ring_t *) malloc (sizeof (sc_log_ring_t));
+    SC_CHECK_ABORT (ring != NULL, "Failed to allocate log ring");
+    ring->head = ring->tail = 0;
+
+    /* remember the ring to drain and free it */
+    ring->next = __atomic_load_n (&sc_log_rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n (&sc_log_rings, &ring->next,
+                                         ring, 1, __ATOMIC_RELEASE,
+                                         __ATOMIC_RELAXED));
+    sc_log_thread_ring = ring;
+    sc_log_thread_generation = sc_log_generation;
+  }
+  return sc_log_thread_ring;
+}
+
+#endif /* SC_LOG_THREADED */
+
+/** Queue a formatted message without writing it. */
+static void
+sc_log_async_put (const char *msg, size_t len)
+{
+#ifdef SC_LOG_THREADED
+  size_t              head, start, first;
+  sc_log_ring_t      *ring = sc_log_ring ();
+
+  /* messages are never split to keep the lines of threads apart */
+  SC_ASSERT (len < SC_LOG_RING_BYTES);
+  head = ring->head;
+  while (head + len -
+         __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE) >
+         SC_LOG_RING_BYTES) {
+    pthread_cond_signal (&sc_log_cond);
+    sched_yield ();
+  }
+  start = head % SC_LOG_RING_BYTES;
+  first = SC_MIN (len, SC_LOG_RING_BYTES - start);
+  memcpy (ring->data + start, msg, first);
+  memcpy (ring->data, msg + first, len - first);
+  __atomic_store_n (&ring->head, head + len, __ATOMIC_RELEASE);
+
+  /* do not wait for the timer if the ring fills up */
+  if (head + len - ring->tail > SC_LOG_RING_BYTES / 2) {
+    pthread_cond_signal (&sc_log_cond);
+  }
+#else
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_log_mutex);
+#endif
+#ifdef _OPENMP
+#pragma omp critical (sc_log_async)
+#endif
+  sc_log_batch_append (msg, len);
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_log_mutex);
+#endif
+#endif
+}
+
+/** Move all queued messages into the batch and optionally write it. */
+static void
+sc_log_async_flush (int write)
+{
+  if (!sc_log_async) {
+    return;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_log_mutex);
+#endif
+#ifdef _OPENMP
+#pragma omp critical (sc_log_async)
+#endif
+  {
+#ifdef SC_LOG_THREADED
+    sc_log_drain ();
+#endif
+    if (write) {
+      sc_log_batch_write ();
+    }
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_log_mutex);
+#endif
+}
+
+void
+sc_log_flush (void)
+{
+  sc_log_async_flush (1);
+}
+
+/** Flush the log output on abort without waiting on a lock forever. */
+static void
+sc_log_abort_flush (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 i;
+
+  if (!sc_log_async) {
+    return;
+  }
+  for (i = 0; i < 10; ++i) {
+    if (pthread_mutex_trylock (&sc_log_mutex) == 0) {
+#ifdef SC_LOG_THREADED
+      sc_log_drain ();
+#endif
+      sc_log_batch_write ();
+      pthread_mutex_unlock (&sc_log_mutex);
+      return;
+    }
+    usleep (10000);
+  }
+#else
+  sc_log_flush ();
+#endif
+}
+
+void
+sc_log_collect (void)
+{
+#if defined(SC_ENABLE_MPI) && defined(SC_ENABLE_MPICOMMSHARED)
+  int                 mpiret;
+  int                 i, count, rank, size;
+  int                *counts = NULL, *displs = NULL;
+  char               *node_batch = NULL;
+  MPI_Comm            intranode, internode;
+
+  if (!sc_log_async || !sc_log_per_node) {
+    sc_log_flush ();
+    return;
+  }
+  sc_mpi_comm_get_node_comms (sc_mpicomm, &intranode, &internode);
+  SC_ASSERT (intranode != MPI_COMM_NULL);
+  mpiret = MPI_Comm_rank (intranode, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Comm_size (intranode, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* the first rank of the node writes the output of all in order */
+  sc_log_async_flush (0);
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_log_mutex);
+#endif
+  count = (int) sc_log_batch_count;
+  if (rank == 0) {
+    counts = (int *) malloc (2 * size * sizeof (int));
+    SC_CHECK_ABORT (counts != NULL, "Failed to allocate log counts");
+    displs = counts + size;
+  }
+  mpiret = MPI_Gather (&count, 1, MPI_INT, counts, 1, MPI_INT, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    displs[0] = 0;
+    for (i = 1; i < size; ++i) {
+      displs[i] = displs[i - 1] + counts[i - 1];
+    }
+    node_batch = (char *) malloc (SC_MAX (1, displs[size - 1] +
+                                          counts[size - 1]));
+    SC_CHECK_ABORT (node_batch != NULL, "Failed to allocate log batch");
+  }
+  mpiret = MPI_Gatherv (sc_log_batch, count, MPI_CHAR, node_batch,
+                        counts, displs, MPI_CHAR, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+  sc_log_batch_count = 0;
+  if (rank == 0) {
+    FILE               *log_stream =
+      sc_log_stream != NULL ? sc_log_stream : stdout;
+
+    fwrite (node_batch, 1, displs[size - 1] + counts[size - 1], log_stream);
+    fflush (log_stream);
+    free (node_batch);
+    free (counts);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_log_mutex);
+#endif
+#else
+  sc_log_flush ();
+#endif
+}
+
+void
+sc_set_log_async (int enable, int per_node)
+{
+  int                 node_comms = 0;
+
+#if defined(SC_ENABLE_MPI) && defined(SC_ENABLE_MPICOMMSHARED)
+  /* only look up the node comms when they are needed */
+  if (enable && per_node && sc_mpicomm != sc_MPI_COMM_NULL) {
+    MPI_Comm            intranode, internode;
+
+    sc_mpi_comm_get_node_comms (sc_mpicomm, &intranode, &internode);
+    node_comms = intranode != MPI_COMM_NULL;
+  }
+#endif
+
+  /* stop previous asynchronous output and write what it has queued */
+  if (sc_log_async) {
+#ifdef SC_LOG_THREADED
+    sc_log_ring_t      *ring, *next;
+
+    pthread_mutex_lock (&sc_log_mutex);
+    sc_log_stop = 1;
+    pthread_cond_signal (&sc_log_cond);
+    pthread_mutex_unlock (&sc_log_mutex);
+    pthread_join (sc_log_flusher, NULL);
+    sc_log_stop = 0;
+#endif
+    if (sc_log_per_node) {
+      sc_log_collect ();
+    }
+    sc_log_flush ();
+    sc_log_async = 0;
+#ifdef SC_LOG_THREADED
+    for (ring = sc_log_rings; ring != NULL; ring = next) {
+      next = ring->next;
+      free (ring);
+    }
+    sc_log_rings = NULL;
+    ++sc_log_generation;
+#endif
+    free (sc_log_batch);
+    sc_log_batch = NULL;
+  }
+  if (!enable) {
+    return;
+  }
+
+  sc_log_batch = (char *) malloc (SC_LOG_BATCH_BYTES);
+  SC_CHECK_ABORT (sc_log_batch != NULL, "Failed to allocate log batch");
+  sc_log_batch_count = 0;
+  sc_log_per_node = per_node && node_comms;
+  sc_log_async = 1;
+#ifdef SC_LOG_THREADED
+  {
+    int                 pth;
+
+    pth = pthread_create (&sc_log_flusher, NULL, sc_log_flusher_main, NULL);
+    SC_CHECK_ABORT (pth == 0, "Failed to create log flusher thread");
+  }
+#endif
+}
+
 void
 sc_set_log_defaults (FILE * log_stream,
                      sc_log_handler_t log_handler, int log_threshold)
 {
+  /* queued messages go to the stream they were meant for */
+  sc_log_flush ();
+
   sc_default_log_handler = log_handler != NULL ? log_handler : sc_log_handler;
 
   if (log_threshold == SC_LP_DEFAULT) {
@@ -783,6 +2090,7 @@ sc_set_log_defaults (FILE * log_stream,
   }
 
   sc_log_stream = log_stream;
+  sc_log_thresholds_update ();
 }
 
 void
@@ -816,6 +2124,18 @@ sc_log (const char *filename, int lineno,
   if (category == SC_LC_GLOBAL && sc_identifier > 0)
     return;
 
+  /* the default handler queues messages with asynchronous output */
+  if (sc_log_async && log_handler == sc_log_handler &&
+      priority >= log_threshold) {
+    char                buffer[SC_LOG_MESSAGE_BYTES];
+    size_t              len;
+
+    len = sc_log_format (buffer, SC_LOG_MESSAGE_BYTES, filename, lineno,
+                         package, category, priority, msg);
+    sc_log_async_put (buffer, len);
+    log_threshold = SC_LP_SILENT;
+  }
+
 #ifdef SC_ENABLE_PTHREAD
   sc_package_lock (package);
 #endif
@@ -909,6 +2229,7 @@ sc_set_abort_handler (sc_abort_handler_t abort_handler)
 void
 sc_abort (void)
 {
+  sc_log_abort_flush ();
   sc_default_abort_handler ();
   abort ();                     /* if the user supplied callback incorrecty returns, abort */
 }
@@ -951,6 +2272,7 @@ sc_abort_handler (void)
     SC_LERROR ("Abort\n");
   }
 
+  sc_log_abort_flush ();
   fflush (stdout);
   fflush (stderr);
   sleep (1);                    /* allow time for pending output */
@@ -1059,8 +2381,12 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
       p->log_handler = NULL;
       p->log_threshold = SC_LP_SILENT;
       p->log_indent = 0;
-      p->malloc_count = 0;
-      p->free_count = 0;
+      sc_memory_slots_alloc (p);
+      sc_memory_reset (p->memory);
+      memset (&p->allocator, 0, sizeof (sc_allocator_t));
+      p->profile = NULL;
+      memset (p->domain_current, 0, sizeof (p->domain_current));
+      memset (p->domain_peak, 0, sizeof (p->domain_peak));
       p->rc_active = 0;
       p->name = NULL;
       p->full = NULL;
@@ -1071,8 +2397,12 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   new_package->log_handler = log_handler;
   new_package->log_threshold = log_threshold;
   new_package->log_indent = 0;
-  new_package->malloc_count = 0;
-  new_package->free_count = 0;
+  sc_memory_reset (new_package->memory);
+  memset (&new_package->allocator, 0, sizeof (sc_allocator_t));
+  new_package->profile = NULL;
+  memset (new_package->domain_current, 0,
+          sizeof (new_package->domain_current));
+  memset (new_package->domain_peak, 0, sizeof (new_package->domain_peak));
   new_package->rc_active = 0;
   new_package->abort_mismatch = 1;
   new_package->name = name;
@@ -1086,6 +2416,11 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   SC_ASSERT (sc_num_packages <= sc_num_packages_alloc);
   SC_ASSERT (0 <= new_package_id && new_package_id < sc_num_packages);
 
+  if (sc_memory_profile_env) {
+    sc_package_set_memory_profile (new_package_id, 1);
+  }
+  sc_log_thresholds_update ();
+
   return new_package_id;
 }
 
@@ -1112,6 +2447,7 @@ sc_package_set_verbosity (int package_id, int log_priority)
 
   p = sc_packages + package_id;
   p->log_threshold = log_priority;
+  sc_log_thresholds_update ();
 }
 
 void
@@ -1130,7 +2466,12 @@ sc_package_unregister (int package_id)
   p->is_registered = 0;
   p->log_handler = NULL;
   p->log_threshold = SC_LP_DEFAULT;
-  p->malloc_count = p->free_count = 0;
+  sc_memory_reset (p->memory);
+  memset (&p->allocator, 0, sizeof (sc_allocator_t));
+  free (p->profile);
+  p->profile = NULL;
+  memset (p->domain_current, 0, sizeof (p->domain_current));
+  memset (p->domain_peak, 0, sizeof (p->domain_peak));
   p->rc_active = 0;
 #ifdef SC_ENABLE_PTHREAD
   i = pthread_mutex_destroy (&p->mutex);
@@ -1139,12 +2480,14 @@ sc_package_unregister (int package_id)
   p->name = p->full = NULL;
 
   --sc_num_packages;
+  sc_log_thresholds_update ();
 }
 
 void
 sc_package_print_summary (int log_priority)
 {
   int                 i;
+  int                 malloc_count, free_count;
   sc_package_t       *p;
 
   SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
@@ -1154,9 +2497,101 @@ sc_package_print_summary (int log_priority)
   for (i = 0; i < sc_num_packages_alloc; ++i) {
     p = sc_packages + i;
     if (p->is_registered) {
+      sc_memory_counts (i, &malloc_count, &free_count);
       SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
                    "   %3d: %-15s +%d-%d   %s\n",
-                   i, p->name, p->malloc_count, p->free_count, p->full);
+                   i, p->name, malloc_count, free_count, p->full);
+    }
+  }
+}
+
+/** Sort allocation sites by decreasing peak bytes. */
+static int
+sc_memory_site_compare (const void *v1, const void *v2)
+{
+  const sc_memory_site_t *s1 = (const sc_memory_site_t *) v1;
+  const sc_memory_site_t *s2 = (const sc_memory_site_t *) v2;
+
+  return s1->peak < s2->peak ? 1 : s1->peak > s2->peak ? -1 : 0;
+}
+
+/** Print the size classes and the top allocation sites of a profile. */
+static void
+sc_memory_profile_print (int log_priority, const char *name,
+                         sc_memory_profile_t * profile)
+{
+  int                 c, i;
+  sc_memory_site_t    sites[SC_MEMORY_PROFILE_SITES];
+
+  SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+               "Memory profile %s: size classes\n", name);
+  for (c = 0; c < SC_MEMORY_CLASSES; ++c) {
+    if (profile->histogram[c] > 0) {
+      SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+                   "   2^%-2d bytes: %ld\n", c, profile->histogram[c]);
+    }
+  }
+
+  /* sort a copy of the sites to keep the table intact */
+  memcpy (sites, profile->sites, sizeof (sites));
+  qsort (sites, SC_MEMORY_PROFILE_SITES, sizeof (sc_memory_site_t),
+         sc_memory_site_compare);
+  SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+               "Memory profile %s: top sites by peak bytes\n", name);
+  for (i = 0; i < SC_MEMORY_PROFILE_SITES && i < 10; ++i) {
+    if (sites[i].count == 0) {
+      break;
+    }
+    SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+                 "   %s:%d count %ld current %llu peak %llu\n",
+                 sites[i].file == NULL ? "(untagged)" : sites[i].file,
+                 sites[i].line, sites[i].count,
+                 (unsigned long long) sites[i].current,
+                 (unsigned long long) sites[i].peak);
+  }
+}
+
+void
+sc_package_print_memory_summary (sc_MPI_Comm mpicomm, int log_priority)
+{
+  int                 i, nvars;
+  size_t              current, peak;
+  char                variable[BUFSIZ];
+  const char         *name;
+  sc_statinfo_t      *stats;
+
+  /* two variables for the default and every registered package */
+  stats = SC_ALLOC (sc_statinfo_t, 2 * (sc_num_packages_alloc + 1));
+  nvars = 0;
+  for (i = -1; i < sc_num_packages_alloc; ++i) {
+    if (i >= 0 && !sc_packages[i].is_registered) {
+      continue;
+    }
+    name = i == -1 ? "default" : sc_packages[i].name;
+    sc_memory_bytes (i, &current, &peak);
+    snprintf (variable, BUFSIZ, "%s current bytes", name);
+    sc_stats_set1_ext (stats + nvars++, (double) current, variable, 1,
+                       sc_stats_group_all, sc_stats_prio_all);
+    snprintf (variable, BUFSIZ, "%s peak bytes", name);
+    sc_stats_set1_ext (stats + nvars++, (double) peak, variable, 1,
+                       sc_stats_group_all, sc_stats_prio_all);
+  }
+  sc_stats_compute (mpicomm, nvars, stats);
+  sc_stats_print (sc_package_id, log_priority, nvars, stats, 1, 0);
+  for (i = 0; i < nvars; ++i) {
+    sc_stats_reset (stats + i, 1);
+  }
+  SC_FREE (stats);
+
+  /* the local details are only printed by the root */
+  for (i = -1; i < sc_num_packages_alloc; ++i) {
+    if (i >= 0 && !sc_packages[i].is_registered) {
+      continue;
+    }
+    if (sc_memory_profile_get (i) != NULL) {
+      sc_memory_profile_print (log_priority,
+                               i == -1 ? "default" : sc_packages[i].name,
+                               sc_memory_profile_get (i));
     }
   }
 }
@@ -1169,6 +2604,10 @@ sc_init (sc_MPI_Comm mpicomm,
   int                 w;
   const char         *trace_file_name;
   const char         *trace_file_prio;
+  const char         *log_async;
+  const char         *progress;
+  const char         *taskpool;
+  const char         *tracer_events;
 
   sc_identifier = -1;
   sc_mpicomm = sc_MPI_COMM_NULL;
@@ -1183,6 +2622,7 @@ sc_init (sc_MPI_Comm mpicomm,
   }
 
   sc_set_signal_handler (catch_signals);
+  sc_memory_profile_env = getenv ("SC_MEMORY_PROFILE") != NULL;
   sc_package_id = sc_package_register (log_handler, log_threshold,
                                        "libsc", "The SC Library");
 
@@ -1231,6 +2671,17 @@ sc_init (sc_MPI_Comm mpicomm,
       }
     }
   }
+  sc_log_thresholds_update ();
+
+  sc_tracer_file = getenv ("SC_TRACER_FILE");
+  if (sc_tracer_file != NULL) {
+    tracer_events = getenv ("SC_TRACER_EVENTS");
+    sc_tracer_start (tracer_events != NULL ?
+                     (size_t) SC_MAX (0, sc_atol (tracer_events)) : 0);
+  }
+  if (getenv ("SC_MPI_STATS") != NULL) {
+    sc_mpi_stats_start ();
+  }
 
   w = 24;
   SC_GLOBAL_ESSENTIALF ("This is %s\n", SC_PACKAGE_STRING);
@@ -1255,26 +2706,30 @@ sc_init (sc_MPI_Comm mpicomm,
 
 #if defined(SC_ENABLE_MPI) && defined(SC_ENABLE_MPICOMMSHARED)
   if (mpicomm != MPI_COMM_NULL) {
-    int                 mpiret;
-    MPI_Comm            intranode, internode;
-
-    /* compute the node comms by default */
+    /* the node comms are determined on first use and cached */
     sc_mpi_comm_attach_node_comms (mpicomm, 0);
-    sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
-    if (intranode == MPI_COMM_NULL) {
-      SC_GLOBAL_STATISTICS ("No shared memory node communicators\n");
-    }
-    else {
-      int                 intrasize;
+  }
+#endif
 
-      mpiret = MPI_Comm_size (intranode, &intrasize);
-      SC_CHECK_MPI (mpiret);
+  log_async = getenv ("SC_LOG_ASYNC");
+  if (log_async != NULL) {
+    sc_set_log_async (1, !strcmp (log_async, "node"));
+  }
+
+  progress = getenv ("SC_PROGRESS_THREAD");
+  if (progress != NULL && sc_progress_start (sc_atoi (progress))) {
+    SC_GLOBAL_PRODUCTION ("Progress thread not available\n");
+  }
+
+  taskpool = getenv ("SC_TASKPOOL_THREADS");
+  if (taskpool != NULL) {
+    const char         *cpu = getenv ("SC_TASKPOOL_CPU");
 
-      SC_GLOBAL_STATISTICSF ("Shared memory node communicator size: %d\n",
-                             intrasize);
+    if (sc_taskpool_start (sc_atoi (taskpool),
+                           cpu != NULL ? sc_atoi (cpu) : -1)) {
+      SC_GLOBAL_PRODUCTION ("Task pool threads not available\n");
     }
   }
-#endif
 }
 
 void
@@ -1283,10 +2738,50 @@ sc_finalize (void)
   int                 i;
   int                 retval;
 
+  sc_taskpool_stop ();
+  sc_progress_stop ();
+
+  /* write all queued log messages while the node comms exist */
+  sc_set_log_async (0, 0);
+
+  /* report the communication counted since sc_init */
+  if (sc_mpi_stats_is_active ()) {
+    if (sc_mpicomm != sc_MPI_COMM_NULL) {
+      sc_mpi_stats_print (sc_mpicomm, sc_package_id, SC_LP_STATISTICS);
+    }
+    sc_mpi_stats_stop ();
+  }
+
 #if defined(SC_ENABLE_MPI) && defined(SC_ENABLE_MPICOMMSHARED)
   sc_mpi_comm_detach_node_comms (sc_mpicomm);
 #endif
 
+  /* write the event trace of this rank */
+  if (sc_tracer_file != NULL) {
+    char                buffer[BUFSIZ];
+    sc_io_sink_t       *sink;
+
+    snprintf (buffer, BUFSIZ, "%s.%d.json", sc_tracer_file,
+              SC_MAX (0, sc_identifier));
+    sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, buffer);
+    retval = sink == NULL;
+    if (!retval) {
+      retval = sc_tracer_write (sink, SC_MAX (0, sc_identifier));
+      retval = sc_io_sink_destroy (sink) || retval;
+    }
+    if (retval) {
+      SC_LERRORF ("Failed to write event trace %s\n", buffer);
+    }
+    sc_tracer_file = NULL;
+  }
+
+  /* the default arenas, the profiler and the tracer allocate from the
+     libsc package */
+  sc_arena_finalize ();
+  sc_prof_finalize ();
+  sc_tracer_stop ();
+
   /* sc_packages is static and thus initialized to all zeros */
   for (i = sc_num_packages_alloc - 1; i >= 0; --i)
     if (sc_packages[i].is_registered)
@@ -1295,6 +2790,8 @@ sc_finalize (void)
   SC_ASSERT (sc_num_packages == 0);
   sc_memory_check (-1);
 
+  for (i = 0; i < sc_num_packages_alloc; ++i)
+    free (sc_packages[i].memory_alloc);
   free (sc_packages);
   sc_packages = NULL;
   sc_num_packages_alloc = 0;
@@ -1304,6 +2801,7 @@ sc_finalize (void)
 
   sc_print_backtrace = 0;
   sc_identifier = -1;
+  sc_memory_profile_env = 0;
 
   /* close trace file */
   if (sc_trace_file != NULL) {
@@ -1312,6 +2810,7 @@ sc_finalize (void)
 
     sc_trace_file = NULL;
   }
+  sc_log_thresholds_update ();
 }
 
 int
@@ -150,6 +150,18 @@ extern FILE        *sc_trace_file;
 /** Optional minimum log priority for messages that go into the trace file. */
 extern int          sc_trace_prio;
 
+/** Number of package ids whose log threshold is cached for the macros. */
+#define SC_LOG_PACKAGES 64
+
+/** Lowest priority that produces any output, indexed by package id + 1.
+ * It is maintained by libsc for the log macros and meant to be read only.
+ * Ids of unregistered packages hold the default threshold.
+ */
+extern int          sc_log_thresholds[SC_LOG_PACKAGES + 1];
+
+/** False if messages of category SC_LC_GLOBAL are dropped on this rank. */
+extern int          sc_log_global_active;
+
 /** Define machine epsilon for the double type. */
 #define SC_EPS               2.220446049250313e-16
 
@@ -231,12 +243,22 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 #endif
 
 /* macros for memory allocation, will abort if out of memory */
+/* define SC_MEMORY_SITES to tag allocations for the memory profile */
 
+#ifndef SC_MEMORY_SITES
 #define SC_ALLOC(t,n)         (t *) sc_malloc (sc_package_id, (n) * sizeof(t))
 #define SC_ALLOC_ZERO(t,n)    (t *) sc_calloc (sc_package_id, \
                                                (size_t) (n), sizeof(t))
 #define SC_REALLOC(p,t,n)     (t *) sc_realloc (sc_package_id,          \
                                              (p), (n) * sizeof(t))
+#else
+#define SC_ALLOC(t,n)         (t *) sc_malloc_site (sc_package_id,      \
+                                       (n) * sizeof(t), __FILE__, __LINE__)
+#define SC_ALLOC_ZERO(t,n)    (t *) sc_calloc_site (sc_package_id,      \
+                          (size_t) (n), sizeof(t), __FILE__, __LINE__)
+#define SC_REALLOC(p,t,n)     (t *) sc_realloc_site (sc_package_id,     \
+                                (p), (n) * sizeof(t), __FILE__, __LINE__)
+#endif
 #define SC_STRDUP(s)                sc_strdup (sc_package_id, (s))
 #define SC_FREE(p)                  sc_free (sc_package_id, (p))
 
@@ -271,6 +293,14 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 #define SC_ATTR_ALIGN(n)
 #endif
 
+/** Hint the processor to load the cache line of an address for reading.
+ * This is a noop on compilers that do not provide a prefetch builtin. */
+#if (defined __GNUC__) || (defined __clang__)
+#define SC_PREFETCH(p) __builtin_prefetch ((const void *) (p))
+#else
+#define SC_PREFETCH(p) SC_NOOP ()
+#endif
+
 /**
  * Sets n elements of a memory range to zero.
  * Assumes the pointer p is of the correct type.
@@ -342,9 +372,30 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 #endif
 #endif
 
+/** The lowest log priority compiled into the log macros.
+ * Calls of lower priority are removed entirely.  It may be raised above
+ * SC_LP_THRESHOLD for a file by defining SC_LOG_MINIMUM before including
+ * this header.
+ */
+#ifdef SC_LOG_MINIMUM
+#define SC_LP_MINIMUM SC_MAX (SC_LOG_MINIMUM, SC_LP_THRESHOLD)
+#else
+#define SC_LP_MINIMUM SC_LP_THRESHOLD
+#endif
+
+/** Check whether a log call may produce output before evaluating its
+ * arguments.  The check against the cached thresholds is conservative:
+ * \ref sc_log filters again as before.
+ */
+#define SC_LOG_IS_ACTIVE(package,category,priority)                     \
+  ((priority) >= SC_LP_MINIMUM &&                                       \
+   ((unsigned) ((package) + 1) > (unsigned) SC_LOG_PACKAGES ||          \
+    ((priority) >= sc_log_thresholds[(package) + 1] &&                  \
+     ((category) != SC_LC_GLOBAL || sc_log_global_active))))
+
 /* generic log macros */
 #define SC_GEN_LOG(package,category,priority,s)                         \
-  ((priority) < SC_LP_THRESHOLD ? (void) 0 :                            \
+  (!SC_LOG_IS_ACTIVE ((package), (category), (priority)) ? (void) 0 :   \
    sc_log (__FILE__, __LINE__, (package), (category), (priority), (s)))
 #define SC_GLOBAL_LOG(p,s) SC_GEN_LOG (sc_package_id, SC_LC_GLOBAL, (p), (s))
 #define SC_LOG(p,s) SC_GEN_LOG (sc_package_id, SC_LC_NORMAL, (p), (s))
@@ -357,7 +408,7 @@ void                SC_LOGF (int priority, const char *fmt, ...)
   __attribute__ ((format (printf, 2, 3)));
 #ifndef __cplusplus
 #define SC_GEN_LOGF(package,category,priority,fmt,...)                  \
-  ((priority) < SC_LP_THRESHOLD ? (void) 0 :                            \
+  (!SC_LOG_IS_ACTIVE ((package), (category), (priority)) ? (void) 0 :   \
    sc_logf (__FILE__, __LINE__, (package), (category), (priority),      \
             (fmt), __VA_ARGS__))
 #define SC_GLOBAL_LOGF(p,fmt,...)                                       \
@@ -471,6 +522,22 @@ typedef void        (*sc_log_handler_t) (FILE * log_stream,
                                          int priority, const char *msg);
 typedef void        (*sc_abort_handler_t) (void);
 
+/** A memory allocator backend that replaces the C library for a package.
+ * The functions must behave like malloc, calloc, realloc and free.
+ * The counting of allocations in \ref sc_malloc and friends and the
+ * abort on running out of memory are kept for any backend.
+ */
+typedef struct sc_allocator
+{
+  void               *(*malloc_fn) (size_t size, void *user);
+  /** May be NULL to use malloc_fn and zero the memory. */
+  void               *(*calloc_fn) (size_t nmemb, size_t size, void *user);
+  void               *(*realloc_fn) (void *ptr, size_t size, void *user);
+  void                (*free_fn) (void *ptr, void *user);
+  void               *user;     /**< Passed to every function call. */
+}
+sc_allocator_t;
+
 /* memory allocation functions, will abort if out of memory */
 
 void               *sc_malloc (int package, size_t size);
@@ -481,6 +548,111 @@ void                sc_free (int package, void *ptr);
 int                 sc_memory_status (int package);
 void                sc_memory_check (int package);
 
+/* variants that attribute the allocation to a source location
+ * in the memory profile, see \ref sc_package_set_memory_profile */
+
+void               *sc_malloc_site (int package, size_t size,
+                                    const char *file, int line);
+void               *sc_calloc_site (int package, size_t nmemb, size_t size,
+                                    const char *file, int line);
+void               *sc_realloc_site (int package, void *ptr, size_t size,
+                                     const char *file, int line);
+
+/** Query the bytes allocated by a package with a memory profile.
+ * \param [in] package     Package id or -1 for the default package.
+ * \param [out] current    If not NULL, the bytes currently allocated.
+ * \param [out] peak       If not NULL, the maximum of bytes allocated.
+ * \return                 True if the package has a memory profile.
+ *                         Otherwise, the outputs are set to zero.
+ */
+int                 sc_memory_bytes (int package,
+                                     size_t * current, size_t * peak);
+
+/** Where the memory of \ref sc_malloc_domain lives. */
+typedef enum sc_memory_domain
+{
+  SC_MEMORY_HOST = 0,           /**< Pageable host memory of \ref sc_malloc. */
+  SC_MEMORY_PINNED,             /**< Page-locked host memory for transfers. */
+  SC_MEMORY_DEVICE,             /**< Memory of the accelerator. */
+  SC_MEMORY_MANAGED,            /**< Unified memory migrated on demand. */
+  SC_MEMORY_NUM_DOMAINS
+}
+sc_memory_domain_t;
+
+/** A backend for the memory domains other than \ref SC_MEMORY_HOST.
+ * With configure --enable-cuda or --enable-hip the built-in backend calls
+ * the respective runtime.  Otherwise, it emulates all domains with host
+ * memory, such that code written for accelerators runs unchanged.
+ */
+typedef struct sc_memory_backend
+{
+  /** Allocate in a domain other than host; return NULL on failure. */
+  void               *(*malloc_fn) (sc_memory_domain_t domain,
+                                    size_t size, void *user);
+  void                (*free_fn) (sc_memory_domain_t domain,
+                                  void *ptr, void *user);
+  /** Copy between any two domains like cudaMemcpyDefault. */
+  void                (*copy_fn) (void *dest, const void *src,
+                                  size_t n, void *user);
+  /** True if the device domain can be dereferenced on the host. */
+  int                 device_on_host;
+  void               *user;     /**< Passed to every function call. */
+}
+sc_memory_backend_t;
+
+/** Replace the backend of the non-host memory domains.
+ * No memory may be allocated in these domains when calling this.
+ * \param [in] backend     The backend is copied.  NULL restores the
+ *                         built-in backend.
+ */
+void                sc_memory_set_backend (const sc_memory_backend_t *
+                                           backend);
+
+/** Return true if memory of a domain can be dereferenced on the host. */
+int                 sc_memory_domain_is_host (sc_memory_domain_t domain);
+
+/** Allocate memory in a domain, abort if out of memory.
+ * The host domain is identical to \ref sc_malloc.  The other domains
+ * are counted in the allocations of the package, checked by
+ * \ref sc_memory_check, and their bytes are recorded per domain.
+ * \param [in] package     Package id or -1 for the default package.
+ * \param [in] domain      Where to allocate.
+ * \param [in] size        Bytes to allocate.  Zero returns NULL.
+ * \return                 Memory to be freed by \ref sc_free_domain.
+ */
+void               *sc_malloc_domain (int package,
+                                      sc_memory_domain_t domain,
+                                      size_t size);
+
+/** Free memory of \ref sc_malloc_domain.
+ * \param [in] package     Must match the allocation.
+ * \param [in] domain      Must match the allocation.
+ * \param [in] ptr         NULL is a noop.
+ */
+void                sc_free_domain (int package, sc_memory_domain_t domain,
+                                    void *ptr);
+
+/** Copy memory between domains.
+ * Uses memcpy if both domains are host accessible.
+ */
+void                sc_memcpy_domain (void *dest,
+                                      sc_memory_domain_t dest_domain,
+                                      const void *src,
+                                      sc_memory_domain_t src_domain,
+                                      size_t n);
+
+/** Query the bytes allocated by a package in a domain.
+ * For the host domain this is \ref sc_memory_bytes.
+ * \param [in] package     Package id or -1 for the default package.
+ * \param [in] domain      The memory domain to query.
+ * \param [out] current    If not NULL, the bytes currently allocated.
+ * \param [out] peak       If not NULL, the maximum of bytes allocated.
+ * \return                 True if the bytes are recorded.
+ */
+int                 sc_memory_domain_bytes (int package,
+                                            sc_memory_domain_t domain,
+                                            size_t * current, size_t * peak);
+
 /* comparison functions for various integer sizes */
 
 int                 sc_int_compare (const void *v1, const void *v2);
@@ -514,6 +686,35 @@ void                sc_set_log_defaults (FILE * log_stream,
                                          sc_log_handler_t log_handler,
                                          int log_thresold);
 
+/** Enable or disable buffered asynchronous output of the builtin handler.
+ * Messages are queued instead of written one by one and flushed in large
+ * writes.  With threads, every thread queues into its own lock-free
+ * ring, and a background thread writes the batch periodically.
+ * Other log handlers and the trace file are not affected.
+ * Queued messages are written by \ref sc_log_flush, on abort and by
+ * \ref sc_finalize.  Setting the environment variable SC_LOG_ASYNC to 1
+ * or node makes \ref sc_init enable this mode.
+ * This function must be called after \ref sc_init while no other thread
+ * is logging.  It is collective if per-node output is or was active.
+ * \param [in] enable        True to enable, false to write and disable.
+ * \param [in] per_node      If true and the node communicators of
+ *                           \ref sc_mpi_comm_attach_node_comms exist,
+ *                           the output of every node is gathered by
+ *                           \ref sc_log_collect and written by the
+ *                           first rank of the node.  A rank writes its
+ *                           output directly if it queues too much.
+ */
+void                sc_set_log_async (int enable, int per_node);
+
+/** Write all queued messages of the asynchronous output of this rank. */
+void                sc_log_flush (void);
+
+/** Gather the queued messages of a node and write them from its first rank.
+ * This function is collective over the communicator passed to sc_init.
+ * Without per-node output, it is equivalent to \ref sc_log_flush.
+ */
+void                sc_log_collect (void);
+
 /** Controls the default SC abort behavior.
  * \param [in] abort_handler Set default SC above handler (NULL selects
  *                           builtin).  ***This function should not return!***
@@ -630,6 +831,37 @@ void                sc_package_set_verbosity (int package_id,
 void                sc_package_set_abort_alloc_mismatch (int package_id,
                                                          int set_abort);
 
+/** Set the memory allocator backend of a package.
+ * All memory of the package, usually allocated by the SC_ALLOC family of
+ * macros, is taken from the backend afterwards.  This function must only
+ * be called while the package has no memory allocated, for example just
+ * after \ref sc_package_register, and before additional threads are
+ * created.
+ * \param[in] package_id    Must be -1 for the default package or
+ *                          the identifier of a registered package.
+ * \param[in] allocator     The allocator functions are copied.
+ *                          NULL restores the C library functions.
+ */
+void                sc_package_set_allocator (int package_id,
+                                              const sc_allocator_t *
+                                              allocator);
+
+/** Enable or disable the memory profile of a package.
+ * With the profile, the current and peak bytes, a histogram of the
+ * allocation sizes and the bytes per allocation site are recorded.
+ * Allocation sites are tagged when the code is compiled with
+ * SC_MEMORY_SITES defined and untagged otherwise.
+ * If the environment variable SC_MEMORY_PROFILE is set, \ref sc_init
+ * enables the profile for every package registered afterwards.
+ * This function must only be called while the package has no memory
+ * allocated and before additional threads are created.
+ * \param[in] package_id    Must be -1 for the default package or
+ *                          the identifier of a registered package.
+ * \param[in] enable        True to enable, false to disable the profile.
+ */
+void                sc_package_set_memory_profile (int package_id,
+                                                   int enable);
+
 /** Unregister a software package with SC.
  * This function must only be called after additional threads are finished.
  */
@@ -641,6 +873,18 @@ void                sc_package_unregister (int package_id);
  */
 void                sc_package_print_summary (int log_priority);
 
+/** Print the current and peak bytes of all packages reduced over ranks.
+ * Packages without a memory profile report zero bytes.
+ * The size classes and top allocation sites are printed per profiled
+ * package from the local data of the root rank.
+ * This function is collective and all ranks must have registered the
+ * same packages.
+ * \param [in] mpicomm          Communicator for the reduction.
+ * \param [in] log_priority     Priority passed to sc log functions.
+ */
+void                sc_package_print_memory_summary (sc_MPI_Comm mpicomm,
+                                                     int log_priority);
+
 /** Sets the global program identifier (e.g. the MPI rank) and some flags.
  * This function is optional.
  * This function must only be called before additional threads are created.
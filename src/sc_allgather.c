@@ -22,9 +22,10 @@
 */
 
 #include <sc_allgather.h>
+#include <sc_tracer.h>
 
 void
-sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data, int datasize,
+sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data, size_t datasize,
                        int groupsize, int myoffset, int myrank)
 {
   int                 j, peer;
@@ -42,13 +43,14 @@ sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data, int datasize,
     }
     peer = myrank - (myoffset - j);
 
-    mpiret = sc_MPI_Irecv (data + j * datasize, datasize, sc_MPI_BYTE,
-                           peer, SC_TAG_AG_ALLTOALL, mpicomm, request + j);
+    mpiret = sc_mpi_irecv_large (data + j * datasize, datasize,
+                                 peer, SC_TAG_AG_ALLTOALL, mpicomm,
+                                 request + j);
     SC_CHECK_MPI (mpiret);
 
-    mpiret = sc_MPI_Isend (data + myoffset * datasize, datasize, sc_MPI_BYTE,
-                           peer, SC_TAG_AG_ALLTOALL,
-                           mpicomm, request + groupsize + j);
+    mpiret = sc_mpi_isend_large (data + myoffset * datasize, datasize,
+                                 peer, SC_TAG_AG_ALLTOALL,
+                                 mpicomm, request + groupsize + j);
     SC_CHECK_MPI (mpiret);
   }
 
@@ -59,7 +61,7 @@ sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data, int datasize,
 }
 
 void
-sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, int datasize,
+sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, size_t datasize,
                         int groupsize, int myoffset, int myrank)
 {
   const int           g2 = groupsize / 2;
@@ -73,20 +75,20 @@ sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, int datasize,
     if (myoffset < g2) {
       sc_allgather_recursive (mpicomm, data, datasize, g2, myoffset, myrank);
 
-      mpiret = sc_MPI_Irecv (data + g2 * datasize, g2B * datasize,
-                             sc_MPI_BYTE, myrank + g2, SC_TAG_AG_RECURSIVE_B,
-                             mpicomm, request + 0);
+      mpiret = sc_mpi_irecv_large (data + g2 * datasize, g2B * datasize,
+                                   myrank + g2, SC_TAG_AG_RECURSIVE_B,
+                                   mpicomm, request + 0);
       SC_CHECK_MPI (mpiret);
 
-      mpiret = sc_MPI_Isend (data, g2 * datasize, sc_MPI_BYTE,
-                             myrank + g2, SC_TAG_AG_RECURSIVE_A,
-                             mpicomm, request + 1);
+      mpiret = sc_mpi_isend_large (data, g2 * datasize,
+                                   myrank + g2, SC_TAG_AG_RECURSIVE_A,
+                                   mpicomm, request + 1);
       SC_CHECK_MPI (mpiret);
 
       if (myoffset == g2 - 1 && g2 != g2B) {
-        mpiret = sc_MPI_Isend (data, g2 * datasize, sc_MPI_BYTE,
-                               myrank + g2B, SC_TAG_AG_RECURSIVE_C,
-                               mpicomm, request + 2);
+        mpiret = sc_mpi_isend_large (data, g2 * datasize,
+                                     myrank + g2B, SC_TAG_AG_RECURSIVE_C,
+                                     mpicomm, request + 2);
         SC_CHECK_MPI (mpiret);
       }
       else {
@@ -101,20 +103,20 @@ sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, int datasize,
         request[0] = sc_MPI_REQUEST_NULL;
         request[1] = sc_MPI_REQUEST_NULL;
 
-        mpiret = sc_MPI_Irecv (data, g2 * datasize, sc_MPI_BYTE,
-                               myrank - g2B, SC_TAG_AG_RECURSIVE_C,
-                               mpicomm, request + 2);
+        mpiret = sc_mpi_irecv_large (data, g2 * datasize,
+                                     myrank - g2B, SC_TAG_AG_RECURSIVE_C,
+                                     mpicomm, request + 2);
         SC_CHECK_MPI (mpiret);
       }
       else {
-        mpiret = sc_MPI_Irecv (data, g2 * datasize, sc_MPI_BYTE,
-                               myrank - g2, SC_TAG_AG_RECURSIVE_A,
-                               mpicomm, request + 0);
+        mpiret = sc_mpi_irecv_large (data, g2 * datasize,
+                                     myrank - g2, SC_TAG_AG_RECURSIVE_A,
+                                     mpicomm, request + 0);
         SC_CHECK_MPI (mpiret);
 
-        mpiret = sc_MPI_Isend (data + g2 * datasize, g2B * datasize,
-                               sc_MPI_BYTE, myrank - g2,
-                               SC_TAG_AG_RECURSIVE_B, mpicomm, request + 1);
+        mpiret = sc_mpi_isend_large (data + g2 * datasize, g2B * datasize,
+                                     myrank - g2, SC_TAG_AG_RECURSIVE_B,
+                                     mpicomm, request + 1);
         SC_CHECK_MPI (mpiret);
 
         request[2] = sc_MPI_REQUEST_NULL;
@@ -130,6 +132,111 @@ sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data, int datasize,
   }
 }
 
+void
+sc_allgather_ring (sc_MPI_Comm mpicomm, char *data, size_t datasize,
+                   int groupsize, int myoffset, int myrank, size_t segsize)
+{
+  int                 mpiret;
+  int                 step, j, nseg, cur, prev;
+  int                 left, right, sendblock, recvblock;
+  size_t              offset, bytes;
+  sc_MPI_Request     *recvreq, *sendreq;
+
+  SC_ASSERT (myoffset >= 0 && myoffset < groupsize);
+  SC_ASSERT (segsize > 0);
+
+  if (groupsize == 1 || datasize == 0) {
+    return;
+  }
+  nseg = (int) ((datasize + segsize - 1) / segsize);
+  left = myrank - myoffset + (myoffset + groupsize - 1) % groupsize;
+  right = myrank - myoffset + (myoffset + 1) % groupsize;
+
+  /* requests for the segments of two consecutive steps */
+  recvreq = SC_ALLOC (sc_MPI_Request, 4 * nseg);
+  sendreq = recvreq + 2 * nseg;
+  for (j = 0; j < 4 * nseg; ++j) {
+    recvreq[j] = sc_MPI_REQUEST_NULL;
+  }
+
+  for (step = 0; step < groupsize - 1; ++step) {
+    cur = step % 2;
+    prev = 1 - cur;
+    sendblock = (myoffset - step + groupsize) % groupsize;
+    recvblock = (myoffset - step - 1 + groupsize) % groupsize;
+
+    /* post the receives of this step */
+    for (j = 0; j < nseg; ++j) {
+      offset = j * segsize;
+      bytes = SC_MIN (segsize, datasize - offset);
+      mpiret = sc_mpi_irecv_large (data + recvblock * datasize + offset,
+                                   bytes, left, SC_TAG_AG_RING, mpicomm,
+                                   recvreq + cur * nseg + j);
+      SC_CHECK_MPI (mpiret);
+    }
+
+    /* forward each segment as soon as it has arrived */
+    for (j = 0; j < nseg; ++j) {
+      offset = j * segsize;
+      bytes = SC_MIN (segsize, datasize - offset);
+      mpiret = sc_MPI_Wait (recvreq + prev * nseg + j,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_mpi_isend_large (data + sendblock * datasize + offset,
+                                   bytes, right, SC_TAG_AG_RING, mpicomm,
+                                   sendreq + cur * nseg + j);
+      SC_CHECK_MPI (mpiret);
+    }
+
+    /* the sends of the previous step have had a full step to complete */
+    mpiret = sc_MPI_Waitall (nseg, sendreq + prev * nseg,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  mpiret = sc_MPI_Waitall (4 * nseg, recvreq, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (recvreq);
+}
+
+void
+sc_allgather_bruck (sc_MPI_Comm mpicomm, char *data, size_t datasize,
+                    int groupsize, int myoffset, int myrank)
+{
+  int                 mpiret;
+  int                 i, dist, count, base;
+  char               *temp;
+  sc_MPI_Request      request[2];
+
+  SC_ASSERT (myoffset >= 0 && myoffset < groupsize);
+
+  /* block i of the temporary buffer belongs to offset myoffset + i */
+  base = myrank - myoffset;
+  temp = SC_ALLOC (char, groupsize * datasize);
+  memcpy (temp, data + myoffset * datasize, datasize);
+  for (dist = 1; dist < groupsize; dist *= 2) {
+    count = SC_MIN (dist, groupsize - dist);
+    mpiret = sc_mpi_irecv_large (temp + dist * datasize, count * datasize,
+                                 base + (myoffset + dist) % groupsize,
+                                 SC_TAG_AG_BRUCK, mpicomm, request + 0);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_mpi_isend_large (temp, count * datasize,
+                                 base + (myoffset - dist + groupsize) %
+                                 groupsize, SC_TAG_AG_BRUCK, mpicomm,
+                                 request + 1);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Waitall (2, request, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* undo the rotation */
+  for (i = 1; i < groupsize; ++i) {
+    memcpy (data + ((myoffset + i) % groupsize) * datasize,
+            temp + i * datasize, datasize);
+  }
+  SC_FREE (temp);
+}
+
 int
 sc_allgather (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
               void *recvbuf, int recvcount, sc_MPI_Datatype recvtype,
@@ -154,14 +261,307 @@ sc_allgather (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
 
   SC_ASSERT (datasize == datasize2);
 
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_ALLGATHER);
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
   memcpy (((char *) recvbuf) + mpirank * datasize, sendbuf, datasize);
-  sc_allgather_recursive (mpicomm, (char *) recvbuf, (int) datasize,
-                          mpisize, mpirank, mpirank);
+  if (mpisize > SC_AG_ALLTOALL_MAX && datasize >= SC_AG_RING_MIN) {
+    sc_allgather_ring (mpicomm, (char *) recvbuf, datasize,
+                       mpisize, mpirank, mpirank, SC_AG_SEGMENT);
+  }
+  else if (mpisize > SC_AG_ALLTOALL_MAX &&
+           datasize * mpisize <= SC_AG_BRUCK_MAX &&
+           (mpisize & (mpisize - 1)) != 0) {
+    sc_allgather_bruck (mpicomm, (char *) recvbuf, datasize,
+                        mpisize, mpirank, mpirank);
+  }
+  else {
+    sc_allgather_recursive (mpicomm, (char *) recvbuf, datasize,
+                            mpisize, mpirank, mpirank);
+  }
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
+
+  return sc_MPI_SUCCESS;
+}
+
+void
+sc_allgatherv_alltoall (sc_MPI_Comm mpicomm, char *data,
+                        const size_t * sizes, const size_t * offsets,
+                        int groupsize, int myrank)
+{
+  int                 j;
+  int                 mpiret;
+  sc_MPI_Request     *request;
+
+  SC_ASSERT (myrank >= 0 && myrank < groupsize);
+
+  request = SC_ALLOC (sc_MPI_Request, 2 * groupsize);
+  for (j = 0; j < groupsize; ++j) {
+    if (j == myrank) {
+      request[j] = request[groupsize + j] = sc_MPI_REQUEST_NULL;
+      continue;
+    }
+    mpiret = sc_mpi_irecv_large (data + offsets[j], sizes[j], j,
+                                 SC_TAG_AG_ALLTOALL, mpicomm, request + j);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_mpi_isend_large (data + offsets[myrank], sizes[myrank], j,
+                                 SC_TAG_AG_ALLTOALL, mpicomm,
+                                 request + groupsize + j);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  mpiret = sc_MPI_Waitall (2 * groupsize, request, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+
+  SC_FREE (request);
+}
+
+void
+sc_allgatherv_ring (sc_MPI_Comm mpicomm, char *data,
+                    const size_t * sizes, const size_t * offsets,
+                    int groupsize, int myrank)
+{
+  int                 mpiret;
+  int                 step, left, right, sendblock, recvblock;
+  sc_MPI_Request      request[2];
+
+  SC_ASSERT (myrank >= 0 && myrank < groupsize);
+
+  left = (myrank + groupsize - 1) % groupsize;
+  right = (myrank + 1) % groupsize;
+  for (step = 0; step < groupsize - 1; ++step) {
+    sendblock = (myrank - step + groupsize) % groupsize;
+    recvblock = (myrank - step - 1 + groupsize) % groupsize;
+    mpiret = sc_mpi_irecv_large (data + offsets[recvblock], sizes[recvblock],
+                                 left, SC_TAG_AG_RING, mpicomm, request);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_mpi_isend_large (data + offsets[sendblock], sizes[sendblock],
+                                 right, SC_TAG_AG_RING, mpicomm,
+                                 request + 1);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Waitall (2, request, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+void
+sc_allgatherv_bruck (sc_MPI_Comm mpicomm, char *data,
+                     const size_t * sizes, const size_t * offsets,
+                     int groupsize, int myrank)
+{
+  int                 mpiret;
+  int                 i, dist, count, block;
+  size_t             *roffsets;
+  char               *temp;
+  sc_MPI_Request      request[2];
+
+  SC_ASSERT (myrank >= 0 && myrank < groupsize);
+
+  /* block i of the temporary buffer belongs to rank myrank + i */
+  roffsets = SC_ALLOC (size_t, groupsize + 1);
+  roffsets[0] = 0;
+  for (i = 0; i < groupsize; ++i) {
+    roffsets[i + 1] = roffsets[i] + sizes[(myrank + i) % groupsize];
+  }
+  temp = SC_ALLOC (char, roffsets[groupsize]);
+  memcpy (temp, data + offsets[myrank], sizes[myrank]);
+  for (dist = 1; dist < groupsize; dist *= 2) {
+    count = SC_MIN (dist, groupsize - dist);
+    mpiret = sc_mpi_irecv_large (temp + roffsets[dist],
+                                 roffsets[dist + count] - roffsets[dist],
+                                 (myrank + dist) % groupsize,
+                                 SC_TAG_AG_BRUCK, mpicomm, request + 0);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_mpi_isend_large (temp, roffsets[count],
+                                 (myrank - dist + groupsize) % groupsize,
+                                 SC_TAG_AG_BRUCK, mpicomm, request + 1);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Waitall (2, request, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* undo the rotation */
+  for (i = 1; i < groupsize; ++i) {
+    block = (myrank + i) % groupsize;
+    memcpy (data + offsets[block], temp + roffsets[i], sizes[block]);
+  }
+  SC_FREE (temp);
+  SC_FREE (roffsets);
+}
+
+int
+sc_allgatherv (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
+               void *recvbuf, int *recvcounts, int *displs,
+               sc_MPI_Datatype recvtype, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize;
+  int                 mpirank;
+  int                 p;
+  size_t              typesize, total;
+  size_t             *sizes, *offsets;
+
+  SC_ASSERT (sendcount >= 0);
+
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_ALLGATHER);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the byte size and offset of every block */
+  typesize = sc_mpi_sizeof (recvtype);
+  sizes = SC_ALLOC (size_t, 2 * mpisize);
+  offsets = sizes + mpisize;
+  for (total = 0, p = 0; p < mpisize; ++p) {
+    SC_ASSERT (recvcounts[p] >= 0 && displs[p] >= 0);
+    sizes[p] = (size_t) recvcounts[p] * typesize;
+    offsets[p] = (size_t) displs[p] * typesize;
+    total += sizes[p];
+  }
+  SC_ASSERT ((size_t) sendcount * sc_mpi_sizeof (sendtype) ==
+             sizes[mpirank]);
+
+  memcpy ((char *) recvbuf + offsets[mpirank], sendbuf, sizes[mpirank]);
+  if (mpisize <= SC_AG_ALLTOALL_MAX) {
+    sc_allgatherv_alltoall (mpicomm, (char *) recvbuf, sizes, offsets,
+                            mpisize, mpirank);
+  }
+  else if (total <= SC_AG_BRUCK_MAX) {
+    sc_allgatherv_bruck (mpicomm, (char *) recvbuf, sizes, offsets,
+                         mpisize, mpirank);
+  }
+  else {
+    sc_allgatherv_ring (mpicomm, (char *) recvbuf, sizes, offsets,
+                        mpisize, mpirank);
+  }
+  SC_FREE (sizes);
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
+
+  return sc_MPI_SUCCESS;
+}
+
+void               *
+sc_allgatherv_alloc (void *sendbuf, int sendcount, sc_MPI_Datatype type,
+                     int *recvcounts, int *displs, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize;
+  int                 p;
+  char               *recvbuf;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_allgather (&sendcount, 1, sc_MPI_INT, recvcounts, 1,
+                         sc_MPI_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  displs[0] = 0;
+  for (p = 0; p < mpisize; ++p) {
+    displs[p + 1] = displs[p] + recvcounts[p];
+  }
+  recvbuf = SC_ALLOC (char, (size_t) displs[mpisize] * sc_mpi_sizeof (type));
+  mpiret = sc_allgatherv (sendbuf, sendcount, type, recvbuf, recvcounts,
+                          displs, type, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  return recvbuf;
+}
+
+/** Ring allgather through a pinned host buffer for device memory.
+ * The block received in one step is copied to the device while the
+ * next step is in flight.  The own block is in place in \b data already.
+ */
+static void
+sc_allgather_staged (sc_MPI_Comm mpicomm, char *data, size_t datasize,
+                     int groupsize, int myrank, sc_memory_domain_t domain)
+{
+  int                 mpiret;
+  int                 step, left, right, sendblock, recvblock;
+  char               *host;
+  sc_MPI_Request      request[2];
+
+  if (groupsize == 1 || datasize == 0) {
+    return;
+  }
+  left = (myrank + groupsize - 1) % groupsize;
+  right = (myrank + 1) % groupsize;
+  host = (char *) sc_malloc_domain (sc_package_id, SC_MEMORY_PINNED,
+                                    groupsize * datasize);
+  sc_memcpy_domain (host + myrank * datasize, SC_MEMORY_PINNED,
+                    data + myrank * datasize, domain, datasize);
+
+  for (step = 0; step < groupsize - 1; ++step) {
+    sendblock = (myrank - step + groupsize) % groupsize;
+    recvblock = (myrank - step - 1 + groupsize) % groupsize;
+    mpiret = sc_mpi_irecv_large (host + recvblock * datasize, datasize,
+                                 left, SC_TAG_AG_RING, mpicomm, request);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_mpi_isend_large (host + sendblock * datasize, datasize,
+                                 right, SC_TAG_AG_RING, mpicomm,
+                                 request + 1);
+    SC_CHECK_MPI (mpiret);
+
+    /* the block sent now has been received in the previous step */
+    if (step > 0) {
+      sc_memcpy_domain (data + sendblock * datasize, domain,
+                        host + sendblock * datasize, SC_MEMORY_PINNED,
+                        datasize);
+    }
+    mpiret = sc_MPI_Waitall (2, request, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  recvblock = (myrank + 1) % groupsize;
+  sc_memcpy_domain (data + recvblock * datasize, domain,
+                    host + recvblock * datasize, SC_MEMORY_PINNED,
+                    datasize);
+  sc_free_domain (sc_package_id, SC_MEMORY_PINNED, host);
+}
+
+int
+sc_allgather_domain (void *sendbuf, int sendcount, sc_MPI_Datatype sendtype,
+                     void *recvbuf, int recvcount, sc_MPI_Datatype recvtype,
+                     sc_memory_domain_t domain, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 mpisize;
+  int                 mpirank;
+  size_t              datasize;
+
+  if (sc_memory_domain_is_host (domain)) {
+    return sc_allgather (sendbuf, sendcount, sendtype,
+                         recvbuf, recvcount, recvtype, mpicomm);
+  }
+  if (sc_mpi_is_device_aware ()) {
+    /* our algorithms copy on the host, so leave the device to MPI */
+    return sc_MPI_Allgather (sendbuf, sendcount, sendtype,
+                             recvbuf, recvcount, recvtype, mpicomm);
+  }
+
+  SC_ASSERT (sendcount >= 0 && recvcount >= 0);
+  datasize = (size_t) sendcount * sc_mpi_sizeof (sendtype);
+  SC_ASSERT (datasize == (size_t) recvcount * sc_mpi_sizeof (recvtype));
+
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_ALLGATHER);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_memcpy_domain ((char *) recvbuf + mpirank * datasize, domain,
+                    sendbuf, domain, datasize);
+  sc_allgather_staged (mpicomm, (char *) recvbuf, datasize,
+                       mpisize, mpirank, domain);
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
 
   return sc_MPI_SUCCESS;
 }
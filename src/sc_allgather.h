@@ -30,29 +30,145 @@
 #define SC_AG_ALLTOALL_MAX      5
 #endif
 
+/* total bytes up to which sc_allgather uses the Bruck algorithm */
+#ifndef SC_AG_BRUCK_MAX
+#define SC_AG_BRUCK_MAX         65536
+#endif
+
+/* bytes per process from which sc_allgather uses the pipelined ring */
+#ifndef SC_AG_RING_MIN
+#define SC_AG_RING_MIN          262144
+#endif
+
+/* bytes per segment of the pipelined ring */
+#ifndef SC_AG_SEGMENT
+#define SC_AG_SEGMENT           65536
+#endif
+
 SC_EXTERN_C_BEGIN;
 
 /** Allgather by direct point-to-point communication.
  * Only makes sense for small group sizes.
+ * The data size in bytes per process may exceed INT_MAX.
  */
 void                sc_allgather_alltoall (sc_MPI_Comm mpicomm, char *data,
-                                           int datasize, int groupsize,
+                                           size_t datasize, int groupsize,
                                            int myoffset, int myrank);
 
 /** Performs recursive bisection allgather.
  * When size becomes small enough, calls sc_ag_alltoall.
+ * Messages beyond INT_MAX bytes are sent with \ref sc_mpi_isend_large.
  */
 void                sc_allgather_recursive (sc_MPI_Comm mpicomm, char *data,
-                                            int datasize, int groupsize,
+                                            size_t datasize, int groupsize,
                                             int myoffset, int myrank);
 
+/** Allgather by passing the blocks around a ring in groupsize - 1 steps.
+ * Each block is split into segments of at most \b segsize bytes, and every
+ * segment is forwarded as soon as it has arrived.  This pipelining makes
+ * the time nearly independent of the group size for large blocks.
+ * \param [in] segsize  Positive number of bytes per segment.
+ */
+void                sc_allgather_ring (sc_MPI_Comm mpicomm, char *data,
+                                       size_t datasize, int groupsize,
+                                       int myoffset, int myrank,
+                                       size_t segsize);
+
+/** Allgather by the algorithm of Bruck et al. in ceil (log2 (groupsize))
+ * rounds for any group size.  It needs a temporary buffer for all data.
+ * Best for small blocks on groups whose size is not a power of two.
+ */
+void                sc_allgather_bruck (sc_MPI_Comm mpicomm, char *data,
+                                        size_t datasize, int groupsize,
+                                        int myoffset, int myrank);
+
 /** Drop-in allgather replacement.
+ * Groups of at most SC_AG_ALLTOALL_MAX processes use direct communication.
+ * Otherwise, blocks of at least SC_AG_RING_MIN bytes use the pipelined
+ * ring, small totals up to SC_AG_BRUCK_MAX bytes use the Bruck algorithm
+ * unless the group size is a power of two, and all others use the
+ * recursive bisection.
+ * To keep one copy of the result per node, see sc_shmem_allgather.
  */
 int                 sc_allgather (void *sendbuf, int sendcount,
                                   sc_MPI_Datatype sendtype, void *recvbuf,
                                   int recvcount, sc_MPI_Datatype recvtype,
                                   sc_MPI_Comm mpicomm);
 
+/** Allgather blocks of varying sizes by direct point-to-point messages.
+ * Only makes sense for small group sizes.
+ * \param [in,out] data    On input, our own block is in place.
+ *                         On output, all blocks are in place.
+ * \param [in] sizes       Byte size of the block of every process.
+ * \param [in] offsets     Byte offset of the block of every process.
+ */
+void                sc_allgatherv_alltoall (sc_MPI_Comm mpicomm, char *data,
+                                            const size_t * sizes,
+                                            const size_t * offsets,
+                                            int groupsize, int myrank);
+
+/** Allgather blocks of varying sizes around a ring in groupsize - 1 steps.
+ * Every block is received directly into its place.  Best for large totals.
+ * The arguments are as for \ref sc_allgatherv_alltoall.
+ */
+void                sc_allgatherv_ring (sc_MPI_Comm mpicomm, char *data,
+                                        const size_t * sizes,
+                                        const size_t * offsets,
+                                        int groupsize, int myrank);
+
+/** Allgather blocks of varying sizes by the algorithm of Bruck et al. in
+ * ceil (log2 (groupsize)) rounds, which doubles the number of known blocks
+ * in every round.  It needs a temporary buffer for all data.
+ * Best for small totals on many processes.
+ * The arguments are as for \ref sc_allgatherv_alltoall.
+ */
+void                sc_allgatherv_bruck (sc_MPI_Comm mpicomm, char *data,
+                                         const size_t * sizes,
+                                         const size_t * offsets,
+                                         int groupsize, int myrank);
+
+/** Drop-in replacement for MPI_Allgatherv.
+ * Groups of at most SC_AG_ALLTOALL_MAX processes use direct communication.
+ * Otherwise, totals up to SC_AG_BRUCK_MAX bytes use the Bruck algorithm
+ * and larger ones the ring.
+ * To keep one copy of the result per node, see sc_shmem_allgatherv.
+ */
+int                 sc_allgatherv (void *sendbuf, int sendcount,
+                                   sc_MPI_Datatype sendtype, void *recvbuf,
+                                   int *recvcounts, int *displs,
+                                   sc_MPI_Datatype recvtype,
+                                   sc_MPI_Comm mpicomm);
+
+/** Allgather contributions whose counts are not known in advance.
+ * The counts are exchanged by \ref sc_allgather first, then the data is
+ * gathered by \ref sc_allgatherv in the order of the ranks.
+ * \param [out] recvcounts Count of every process, one per process.
+ * \param [out] displs     Offset of every process, one per process plus
+ *                         one more for the total count.
+ * \return                 Allocated result of \b displs [size] items;
+ *                         free it with SC_FREE.
+ */
+void               *sc_allgatherv_alloc (void *sendbuf, int sendcount,
+                                         sc_MPI_Datatype type,
+                                         int *recvcounts, int *displs,
+                                         sc_MPI_Comm mpicomm);
+
+/** Allgather of buffers that live in a memory domain, see sc_malloc_domain.
+ * Host accessible buffers and device buffers with a device-aware MPI,
+ * see \ref sc_mpi_is_device_aware, are passed to MPI directly.
+ * Otherwise, the blocks are staged through a pinned host buffer and
+ * passed around a ring, where the copy of each received block to the
+ * device overlaps with the transfer of the next block.
+ * The arguments are as for \ref sc_allgather.
+ * \param [in] domain   Memory domain of both \b sendbuf and \b recvbuf.
+ */
+int                 sc_allgather_domain (void *sendbuf, int sendcount,
+                                         sc_MPI_Datatype sendtype,
+                                         void *recvbuf, int recvcount,
+                                         sc_MPI_Datatype recvtype,
+                                         sc_memory_domain_t domain,
+                                         sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_ALLGATHER_H */
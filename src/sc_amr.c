@@ -22,6 +22,25 @@
 */
 
 #include <sc_amr.h>
+#include <sc_reduce.h>
+
+/** The accumulator reduces the statistics and then the buckets */
+#define SC_AMR_ACCUM_FLAT 7
+
+/** Initialize the control members that derive from the global stats. */
+static void
+sc_amr_control_init (sc_amr_control_t * amr, sc_MPI_Comm mpicomm,
+                     int mpisize)
+{
+  const sc_statinfo_t *si = &amr->estats;
+
+  amr->mpicomm = mpicomm;
+  amr->num_procs_long = (long) mpisize;
+  amr->num_total_estimated = amr->num_total_elements = si->count;
+  amr->coarsen_threshold = si->min;
+  amr->refine_threshold = si->max;
+  amr->num_total_coarsen = amr->num_total_refine = 0;
+}
 
 void
 sc_amr_error_stats (sc_MPI_Comm mpicomm, long num_elements,
@@ -56,12 +75,188 @@ sc_amr_error_stats (sc_MPI_Comm mpicomm, long num_elements,
   si->variable = NULL;
   sc_stats_compute (mpicomm, 1, si);
 
-  amr->mpicomm = mpicomm;
-  amr->num_procs_long = (long) mpisize;
-  amr->num_total_estimated = amr->num_total_elements = si->count;
-  amr->coarsen_threshold = si->min;
-  amr->refine_threshold = si->max;
-  amr->num_total_coarsen = amr->num_total_refine = 0;
+  sc_amr_control_init (amr, mpicomm, mpisize);
+}
+
+sc_amr_accum_t     *
+sc_amr_accum_new (double relative_accuracy, double min_value,
+                  double max_value)
+{
+  sc_amr_accum_t     *acc;
+
+  SC_ASSERT (0. < relative_accuracy && relative_accuracy < 1.);
+  SC_ASSERT (0. < min_value && min_value <= max_value);
+
+  acc = SC_ALLOC_ZERO (sc_amr_accum_t, 1);
+  sc_stats_init (&acc->estats, NULL);
+  acc->min_value = min_value;
+  acc->log_gamma = log ((1. + relative_accuracy) / (1. - relative_accuracy));
+  acc->num_buckets = 2 + (int) ceil (log (max_value / min_value) /
+                                     acc->log_gamma);
+  acc->buckets = SC_ALLOC_ZERO (double, acc->num_buckets);
+
+  return acc;
+}
+
+void
+sc_amr_accum_destroy (sc_amr_accum_t * acc)
+{
+  SC_FREE (acc->buckets);
+  SC_FREE (acc);
+}
+
+void
+sc_amr_accum_add (sc_amr_accum_t * acc, double error)
+{
+  int                 k;
+
+  SC_ASSERT (!acc->finalized);
+
+  sc_stats_accumulate (&acc->estats, error);
+  if (error <= acc->min_value) {
+    k = 0;
+  }
+  else {
+    k = 1 + (int) (log (error / acc->min_value) / acc->log_gamma);
+    k = SC_MIN (k, acc->num_buckets - 1);
+  }
+  acc->buckets[k] += 1.;
+}
+
+/** Merge statistics as sc_stats_compute does and sum the buckets. */
+static void
+sc_amr_accum_reduce (void *sendbuf, void *recvbuf, int sendcount,
+                     sc_MPI_Datatype sendtype)
+{
+  int                 i;
+  const double       *in = (const double *) sendbuf;
+  double             *inout = (double *) recvbuf;
+
+  SC_ASSERT (sendtype == sc_MPI_DOUBLE);
+  if (!inout[0]) {
+    memcpy (inout, in, SC_AMR_ACCUM_FLAT * sizeof (double));
+  }
+  else if (in[0]) {
+    inout[0] += in[0];
+    inout[1] += in[1];
+    inout[2] += in[2];
+    if (in[3] < inout[3] || (in[3] == inout[3] && in[5] < inout[5])) {
+      inout[3] = in[3];
+      inout[5] = in[5];
+    }
+    if (in[4] > inout[4] || (in[4] == inout[4] && in[6] < inout[6])) {
+      inout[4] = in[4];
+      inout[6] = in[6];
+    }
+  }
+  for (i = SC_AMR_ACCUM_FLAT; i < sendcount; ++i) {
+    inout[i] += in[i];
+  }
+}
+
+void
+sc_amr_accum_finalize (sc_amr_accum_t * acc, sc_MPI_Comm mpicomm,
+                       sc_amr_control_t * amr)
+{
+  sc_statinfo_t      *si = &acc->estats;
+  int                 mpiret;
+  int                 mpisize, mpirank, count;
+  double             *flatin, *flatout;
+  double              cnt, avg;
+
+  SC_ASSERT (!acc->finalized);
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* statistics and quantile buckets travel in a single reduction */
+  count = SC_AMR_ACCUM_FLAT + acc->num_buckets;
+  flatin = SC_ALLOC_ZERO (double, 2 * count);
+  flatout = flatin + count;
+  if (si->count) {
+    flatin[0] = (double) si->count;
+    flatin[1] = si->sum_values;
+    flatin[2] = si->sum_squares;
+    flatin[3] = si->min;
+    flatin[4] = si->max;
+    flatin[5] = flatin[6] = (double) mpirank;
+  }
+  memcpy (flatin + SC_AMR_ACCUM_FLAT, acc->buckets,
+          acc->num_buckets * sizeof (double));
+  mpiret = sc_allreduce_custom (flatin, flatout, count, sc_MPI_DOUBLE,
+                                sc_amr_accum_reduce, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  cnt = flatout[0];
+  si->count = (long) cnt;
+  if (!cnt) {
+    si->sum_values = si->sum_squares = 0.;
+    si->min = DBL_MAX;
+    si->max = -DBL_MAX;
+    si->min_at_rank = si->max_at_rank = 0;
+    si->average = si->variance = si->variance_mean = 0.;
+  }
+  else {
+    si->sum_values = flatout[1];
+    si->sum_squares = flatout[2];
+    si->min = flatout[3];
+    si->max = flatout[4];
+    si->min_at_rank = (int) flatout[5];
+    si->max_at_rank = (int) flatout[6];
+    si->average = avg = si->sum_values / cnt;
+    si->variance = SC_MAX (si->sum_squares / cnt - avg * avg, 0.);
+    si->variance_mean = si->variance / cnt;
+  }
+  si->standev = sqrt (si->variance);
+  si->standev_mean = sqrt (si->variance_mean);
+  si->dirty = 0;
+  memcpy (acc->buckets, flatout + SC_AMR_ACCUM_FLAT,
+          acc->num_buckets * sizeof (double));
+  SC_FREE (flatin);
+  acc->finalized = 1;
+
+  if (amr != NULL) {
+    amr->errors = NULL;
+    amr->estats = *si;
+    sc_amr_control_init (amr, mpicomm, mpisize);
+  }
+}
+
+double
+sc_amr_accum_quantile (sc_amr_accum_t * acc, double q)
+{
+  const sc_statinfo_t *si = &acc->estats;
+  int                 k;
+  double              rank, seen, lower, value;
+
+  SC_ASSERT (acc->finalized);
+  SC_ASSERT (0. <= q && q <= 1.);
+
+  if (!si->count) {
+    return 0.;
+  }
+
+  /* find the bucket that contains the element of this rank */
+  rank = q * (si->count - 1);
+  seen = 0.;
+  for (k = 0; k < acc->num_buckets - 1; ++k) {
+    seen += acc->buckets[k];
+    if (seen > rank) {
+      break;
+    }
+  }
+
+  /* the harmonic mean of the bucket bounds has the relative accuracy */
+  if (k == 0) {
+    value = acc->min_value;
+  }
+  else {
+    lower = acc->min_value * exp ((k - 1) * acc->log_gamma);
+    value = 2. * lower / (1. + exp (-acc->log_gamma));
+  }
+  return SC_MAX (si->min, SC_MIN (value, si->max));
 }
 
 void
@@ -292,3 +487,201 @@ sc_amr_refine_search (int package_id, sc_amr_control_t * amr,
                "Estimated global number of elements = %ld\n",
                amr->num_total_estimated);
 }
+
+/** Histogram search shared by coarsening and refinement.
+ * The estimated number of elements is base + sign * count and decreases
+ * with the threshold in both cases.
+ * \return          The global count at the chosen threshold.
+ */
+static long
+sc_amr_search_histogram (int package_id, sc_amr_control_t * amr,
+                         double *threshold, double threshold_low,
+                         double threshold_high, long base, int sign,
+                         long num_total_low, long num_total_high,
+                         int num_bins, int max_passes,
+                         sc_amr_count_coarsen_fn count_fn, void *user_data)
+{
+  int                 mpiret;
+  int                 pass, k, kk, found;
+  long                estimated, result;
+  long               *local, *global;
+  double             *edges;
+
+  SC_ASSERT (num_bins >= 1 && max_passes >= 1);
+
+  edges = SC_ALLOC (double, num_bins + 1);
+  local = SC_ALLOC (long, 2 * (num_bins + 1));
+  global = local + num_bins + 1;
+  for (pass = 0;; ++pass) {
+
+    /* count locally at every bin edge without communication */
+    for (k = 0; k < num_bins; ++k) {
+      edges[k] = threshold_low > 0. ?
+        threshold_low * pow (threshold_high / threshold_low,
+                             k / (double) num_bins) :
+        threshold_low + (threshold_high - threshold_low) * k / num_bins;
+    }
+    edges[num_bins] = threshold_high;
+    for (k = 0; k <= num_bins; ++k) {
+      *threshold = edges[k];
+      local[k] = count_fn (amr, user_data);
+    }
+    mpiret = sc_MPI_Allreduce (local, global, num_bins + 1, sc_MPI_LONG,
+                               sc_MPI_SUM, amr->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+                 "Pass %d from %g estimated %ld to %g estimated %ld\n",
+                 pass, edges[0], base + sign * global[0],
+                 edges[num_bins], base + sign * global[num_bins]);
+
+    /* prefer the most adaptation within the window */
+    found = -1;
+    for (k = 0; k <= num_bins; ++k) {
+      kk = sign < 0 ? num_bins - k : k;
+      estimated = base + sign * global[kk];
+      if (num_total_low <= estimated && estimated <= num_total_high) {
+        found = kk;
+        break;
+      }
+    }
+    if (found >= 0) {
+      break;
+    }
+
+    /* find the bin where the estimate drops through the window */
+    kk = -1;
+    for (k = 0; k <= num_bins; ++k) {
+      if (base + sign * global[k] > num_total_high) {
+        kk = k;
+      }
+    }
+    if (kk < 0 || kk == num_bins) {
+      /* the target is outside of the threshold range */
+      found = kk < 0 ? 0 : num_bins;
+      break;
+    }
+    if (pass + 1 == max_passes) {
+      /* keep the side with less adaptation */
+      found = sign < 0 ? kk : kk + 1;
+      break;
+    }
+    threshold_low = edges[kk];
+    threshold_high = edges[kk + 1];
+  }
+  *threshold = edges[found];
+  result = global[found];
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Histogram search stopped after %d passes with threshold %g\n",
+               pass + 1, *threshold);
+
+  SC_FREE (local);
+  SC_FREE (edges);
+  return result;
+}
+
+void
+sc_amr_coarsen_search_histogram (int package_id, sc_amr_control_t * amr,
+                                 long num_total_low,
+                                 double coarsen_threshold_high,
+                                 double target_window, int num_bins,
+                                 int max_passes,
+                                 sc_amr_count_coarsen_fn cfn,
+                                 void *user_data)
+{
+  const sc_statinfo_t *errors = &amr->estats;
+  const long          num_total_elements = amr->num_total_elements;
+  const long          num_total_refine = amr->num_total_refine;
+  long                num_total_high;
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Histogram search for coarsen threshold"
+               " assuming %ld refinements\n", num_total_refine);
+
+  if (cfn == NULL ||
+      errors->min >= coarsen_threshold_high ||
+      num_total_elements + num_total_refine <= num_total_low) {
+
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+                 "Search for coarsening skipped with low = %g, up = %g\n",
+                 errors->min, coarsen_threshold_high);
+
+    amr->coarsen_threshold = errors->min;
+    amr->num_total_coarsen = 0;
+    amr->num_total_estimated = num_total_elements + num_total_refine;
+    return;
+  }
+
+  num_total_high = (long) (num_total_low / target_window);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_INFO,
+               "Range of acceptable total element counts %ld %ld\n",
+               num_total_low, num_total_high);
+
+  amr->num_total_coarsen =
+    sc_amr_search_histogram (package_id, amr, &amr->coarsen_threshold,
+                             errors->min, coarsen_threshold_high,
+                             num_total_elements + num_total_refine, -1,
+                             num_total_low, num_total_high, num_bins,
+                             max_passes, cfn, user_data);
+  amr->num_total_estimated =
+    num_total_elements + num_total_refine - amr->num_total_coarsen;
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Global number of coarsenings = %ld\n",
+               amr->num_total_coarsen);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_INFO,
+               "Estimated global number of elements = %ld\n",
+               amr->num_total_estimated);
+}
+
+void
+sc_amr_refine_search_histogram (int package_id, sc_amr_control_t * amr,
+                                long num_total_high,
+                                double refine_threshold_low,
+                                double target_window, int num_bins,
+                                int max_passes,
+                                sc_amr_count_refine_fn rfn, void *user_data)
+{
+  const sc_statinfo_t *errors = &amr->estats;
+  const long          num_total_elements = amr->num_total_elements;
+  const long          num_total_coarsen = amr->num_total_coarsen;
+  long                num_total_low;
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Histogram search for refine threshold"
+               " assuming %ld coarsenings\n", num_total_coarsen);
+
+  if (rfn == NULL ||
+      refine_threshold_low >= errors->max ||
+      num_total_elements - num_total_coarsen >= num_total_high) {
+
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+                 "Search for refinement skipped with low = %g, up = %g\n",
+                 refine_threshold_low, errors->max);
+
+    amr->refine_threshold = errors->max;
+    amr->num_total_refine = 0;
+    amr->num_total_estimated = num_total_elements - num_total_coarsen;
+    return;
+  }
+
+  num_total_low = (long) (num_total_high * target_window);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_INFO,
+               "Range of acceptable total element counts %ld %ld\n",
+               num_total_low, num_total_high);
+
+  amr->num_total_refine =
+    sc_amr_search_histogram (package_id, amr, &amr->refine_threshold,
+                             refine_threshold_low, errors->max,
+                             num_total_elements - num_total_coarsen, 1,
+                             num_total_low, num_total_high, num_bins,
+                             max_passes, rfn, user_data);
+  amr->num_total_estimated =
+    num_total_elements + amr->num_total_refine - num_total_coarsen;
+
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_STATISTICS,
+               "Global number of refinements = %ld\n", amr->num_total_refine);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, SC_LP_INFO,
+               "Estimated global number of elements = %ld\n",
+               amr->num_total_estimated);
+}
@@ -55,6 +55,62 @@ void                sc_amr_error_stats (sc_MPI_Comm mpicomm,
                                         const double *errors,
                                         sc_amr_control_t * amr);
 
+/** Accumulator for error statistics and quantiles during a traversal.
+ * Quantiles are tracked in a sketch of logarithmic buckets with a fixed
+ * relative accuracy, which merges across processes by summing counts.
+ */
+typedef struct sc_amr_accum
+{
+  sc_statinfo_t       estats;   /**< local until finalized, then global */
+  double              min_value;        /**< upper end of bucket 0 */
+  double              log_gamma;        /**< log of the bucket ratio */
+  int                 num_buckets;
+  int                 finalized;
+  double             *buckets;  /**< counts per bucket */
+}
+sc_amr_accum_t;
+
+/** Create an empty error accumulator.
+ * \param [in] relative_accuracy  Relative error of the quantiles (< 1).
+ * \param [in] min_value      Errors below are counted as this value (> 0).
+ * \param [in] max_value      Errors above are counted as this value.
+ * \return                    Accumulator to destroy with
+ *                            \ref sc_amr_accum_destroy.
+ */
+sc_amr_accum_t     *sc_amr_accum_new (double relative_accuracy,
+                                      double min_value, double max_value);
+
+/** Destroy an error accumulator. */
+void                sc_amr_accum_destroy (sc_amr_accum_t * acc);
+
+/** Add the error of one local element.
+ * \param [in,out] acc        Accumulator that is not yet finalized.
+ * \param [in] error          The error value.
+ */
+void                sc_amr_accum_add (sc_amr_accum_t * acc, double error);
+
+/** Merge the accumulators of all processes in one reduction.
+ * This function is collective.  Afterwards, the accumulator holds global
+ * statistics and may be queried with \ref sc_amr_accum_quantile.
+ * \param [in,out] acc        Accumulator that is not yet finalized.
+ * \param [in] mpicomm        MPI communicator to use.
+ * \param [out] amr           If not NULL, initialized as by
+ *                            \ref sc_amr_error_stats, except that the
+ *                            errors member is NULL.
+ */
+void                sc_amr_accum_finalize (sc_amr_accum_t * acc,
+                                           sc_MPI_Comm mpicomm,
+                                           sc_amr_control_t * amr);
+
+/** Estimate a global quantile of the errors.
+ * \param [in] acc            Finalized accumulator.
+ * \param [in] q              Quantile between 0 and 1, such as .5 for the
+ *                            median.
+ * \return                    The quantile within the relative accuracy,
+ *                            or 0 if no errors have been added.
+ */
+double              sc_amr_accum_quantile (sc_amr_accum_t * acc, double q);
+
 /** Count the local number of elements that will be coarsened.
  *
  * This is all elements whose error is below threshold
@@ -131,6 +187,64 @@ void                sc_amr_refine_search (int package_id,
                                           sc_amr_count_refine_fn rfn,
                                           void *user_data);
 
+/** Search for the coarsening threshold with few global reductions.
+ * Instead of one reduction per bisection step, each pass evaluates the
+ * callback locally at \a num_bins + 1 thresholds spaced logarithmically
+ * between the current bounds (linearly if the lower bound is not
+ * positive) and reduces all counts at once.  The next pass refines the
+ * bin containing the target, so two passes usually suffice.
+ * The callback must count a number of coarsenings that does not decrease
+ * with the threshold.  If the target window is not reached, the threshold
+ * with too little coarsening is kept.
+ *
+ * \param [in] package_id               Registered package id or -1.
+ * \param [in,out] amr                  AMR control structure.
+ * \param [in] num_total_ideal          Target number of global elements.
+ * \param [in] coarsen_threshold_high   Upper bound on the error indicator.
+ * \param [in] target_window            Relative target window (< 1).
+ * \param [in] num_bins                 Number of bins per pass (>= 1).
+ * \param [in] max_passes               Upper bound on reductions (>= 1).
+ * \param [in] cfn                      Callback to count local coarsenings.
+ * \param [in] user_data                Will be passed to the cfn callback.
+ */
+void                sc_amr_coarsen_search_histogram (int package_id,
+                                                     sc_amr_control_t * amr,
+                                                     long num_total_ideal,
+                                                     double
+                                                     coarsen_threshold_high,
+                                                     double target_window,
+                                                     int num_bins,
+                                                     int max_passes,
+                                                     sc_amr_count_coarsen_fn
+                                                     cfn, void *user_data);
+
+/** Search for the refinement threshold with few global reductions.
+ * The search works as in \ref sc_amr_coarsen_search_histogram.
+ * The callback must count a number of refinements that does not increase
+ * with the threshold.  If the target window is not reached, the threshold
+ * with too little refinement is kept.
+ *
+ * \param [in] package_id               Registered package id or -1.
+ * \param [in,out] amr                  AMR control structure.
+ * \param [in] num_total_ideal          Target number of global elements.
+ * \param [in] refine_threshold_low     Lower bound on the error indicator.
+ * \param [in] target_window            Relative target window (< 1).
+ * \param [in] num_bins                 Number of bins per pass (>= 1).
+ * \param [in] max_passes               Upper bound on reductions (>= 1).
+ * \param [in] rfn                      Callback to count local refinements.
+ * \param [in] user_data                Will be passed to the rfn callback.
+ */
+void                sc_amr_refine_search_histogram (int package_id,
+                                                    sc_amr_control_t * amr,
+                                                    long num_total_ideal,
+                                                    double
+                                                    refine_threshold_low,
+                                                    double target_window,
+                                                    int num_bins,
+                                                    int max_passes,
+                                                    sc_amr_count_refine_fn
+                                                    rfn, void *user_data);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_AMR_H */
@@ -0,0 +1,285 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_array_typed.h
+ *
+ * Typed access to \ref sc_array_t for elements of a fixed C type.
+ *
+ * The macro \ref SC_ARRAY_DECLARE generates a family of static inline
+ * functions for one element type, such as sc_array_int64_push for
+ * SC_ARRAY_DECLARE (int64, int64_t).  They operate on ordinary arrays
+ * created with that element size and may be mixed freely with the untyped
+ * functions.  Since the element size is a compile-time constant and the
+ * element order is an inline comparison instead of a function pointer,
+ * the compiler can fold the address arithmetic, inline the comparisons of
+ * sorting and searching, and vectorize loops over the data pointer.
+ *
+ * For every name the following functions are generated:
+ *  - sc_array_NAME_init, sc_array_NAME_new: create an array of the type.
+ *  - sc_array_NAME_data: return a pointer to the first element.
+ *  - sc_array_NAME_index: return a pointer to an element.
+ *  - sc_array_NAME_push, sc_array_NAME_push_count: append elements.
+ *  - sc_array_NAME_push_value: append one element by value.
+ *  - sc_array_NAME_sort: sort by introsort, see \ref sc_array_sort_intro.
+ *  - sc_array_NAME_bsearch: find the first element equal to a key.
+ *
+ * The sorting and searching kernels access the elements through restrict
+ * pointers.  Typed functions for the common scalar types are declared in
+ * this file.
+ */
+
+#ifndef SC_ARRAY_TYPED_H
+#define SC_ARRAY_TYPED_H
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Qualifier for the data pointers of typed arrays; C++ lacks restrict. */
+#ifdef __cplusplus
+#define SC_ARRAY_RESTRICT
+#else
+#define SC_ARRAY_RESTRICT _sc_restrict
+#endif
+
+/** Ranges up to this length are sorted by insertion sort. */
+#define SC_ARRAY_TYPED_SMALL 16
+
+/** The default strict weak order of typed arrays. */
+#define SC_ARRAY_LESS(a,b) ((a) < (b))
+
+/** Generate the typed array functions with the natural order of \a type.
+ * \param [in] name     Name of the family, inserted as sc_array_NAME_*.
+ * \param [in] type     Element type that can be compared by <.
+ */
+#define SC_ARRAY_DECLARE(name,type) \
+  SC_ARRAY_DECLARE_LESS (name, type, SC_ARRAY_LESS)
+
+/** Generate the typed array functions with a custom order.
+ * \param [in] name     Name of the family, inserted as sc_array_NAME_*.
+ * \param [in] type     Element type.
+ * \param [in] less     Function or macro less (a, b) that is true if the
+ *                      element a of \a type orders before the element b.
+ */
+#define SC_ARRAY_DECLARE_LESS(name,type,less)                               \
+                                                                            \
+static inline void                                                          \
+sc_array_##name##_init (sc_array_t * array)                                 \
+{                                                                           \
+  sc_array_init (array, sizeof (type));                                     \
+}                                                                           \
+                                                                            \
+static inline sc_array_t *                                                  \
+sc_array_##name##_new (void)                                                \
+{                                                                           \
+  return sc_array_new (sizeof (type));                                      \
+}                                                                           \
+                                                                            \
+static inline type *                                                        \
+sc_array_##name##_data (sc_array_t * array)                                 \
+{                                                                           \
+  SC_ASSERT (array->elem_size == sizeof (type));                            \
+  return (type *) array->array;                                             \
+}                                                                           \
+                                                                            \
+static inline type *                                                        \
+sc_array_##name##_index (sc_array_t * array, size_t iz)                     \
+{                                                                           \
+  SC_ASSERT (array->elem_size == sizeof (type));                            \
+  SC_ASSERT (iz < array->elem_count);                                       \
+  return (type *) array->array + iz;                                        \
+}                                                                           \
+                                                                            \
+static inline type *                                                        \
+sc_array_##name##_push_count (sc_array_t * array, size_t add_count)         \
+{                                                                           \
+  const size_t        old_count = array->elem_count;                        \
+  const size_t        new_count = old_count + add_count;                    \
+                                                                            \
+  SC_ASSERT (array->elem_size == sizeof (type));                            \
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));                                    \
+  if (sizeof (type) * new_count > (size_t) array->byte_alloc) {             \
+    sc_array_resize (array, new_count);                                     \
+  }                                                                         \
+  else {                                                                    \
+    array->elem_count = new_count;                                          \
+  }                                                                         \
+  return (type *) array->array + old_count;                                 \
+}                                                                           \
+                                                                            \
+static inline type *                                                        \
+sc_array_##name##_push (sc_array_t * array)                                 \
+{                                                                           \
+  return sc_array_##name##_push_count (array, 1);                           \
+}                                                                           \
+                                                                            \
+static inline void                                                          \
+sc_array_##name##_push_value (sc_array_t * array, type value)               \
+{                                                                           \
+  *sc_array_##name##_push_count (array, 1) = value;                         \
+}                                                                           \
+                                                                            \
+static inline void                                                          \
+sc_array_##name##_heapsort (type * SC_ARRAY_RESTRICT base, size_t n)        \
+{                                                                           \
+  size_t              start, end, root, child;                              \
+  type                t;                                                    \
+                                                                            \
+  for (end = n, start = n / 2; end > 1;) {                                  \
+    if (start > 0) {                                                        \
+      --start;                                                              \
+    }                                                                       \
+    else {                                                                  \
+      --end;                                                                \
+      t = base[0]; base[0] = base[end]; base[end] = t;                      \
+    }                                                                       \
+    for (root = start; (child = 2 * root + 1) < end; root = child) {        \
+      if (child + 1 < end && less (base[child], base[child + 1])) {         \
+        ++child;                                                            \
+      }                                                                     \
+      if (!less (base[root], base[child])) {                                \
+        break;                                                              \
+      }                                                                     \
+      t = base[root]; base[root] = base[child]; base[child] = t;            \
+    }                                                                       \
+  }                                                                         \
+}                                                                           \
+                                                                            \
+static inline void                                                          \
+sc_array_##name##_introsort (type * SC_ARRAY_RESTRICT base, size_t n,       \
+                             int depth)                                     \
+{                                                                           \
+  size_t              i, j, mid;                                            \
+  type                t;                                                    \
+                                                                            \
+  while (n > SC_ARRAY_TYPED_SMALL) {                                        \
+    if (depth-- == 0) {                                                     \
+      sc_array_##name##_heapsort (base, n);                                 \
+      return;                                                               \
+    }                                                                       \
+                                                                            \
+    /* move the median of three to the front as pivot */                    \
+    mid = n / 2;                                                            \
+    if (less (base[mid], base[0])) {                                        \
+      t = base[mid]; base[mid] = base[0]; base[0] = t;                      \
+    }                                                                       \
+    if (less (base[n - 1], base[mid])) {                                    \
+      t = base[n - 1]; base[n - 1] = base[mid]; base[mid] = t;              \
+      if (less (base[mid], base[0])) {                                      \
+        t = base[mid]; base[mid] = base[0]; base[0] = t;                    \
+      }                                                                     \
+    }                                                                       \
+    t = base[0]; base[0] = base[mid]; base[mid] = t;                        \
+                                                                            \
+    /* partition around the pivot in front; the last element stops i */    \
+    i = 0;                                                                  \
+    j = n;                                                                  \
+    for (;;) {                                                              \
+      do {                                                                  \
+        ++i;                                                                \
+      }                                                                     \
+      while (less (base[i], base[0]));                                      \
+      do {                                                                  \
+        --j;                                                                \
+      }                                                                     \
+      while (less (base[0], base[j]));                                      \
+      if (i >= j) {                                                         \
+        break;                                                              \
+      }                                                                     \
+      t = base[i]; base[i] = base[j]; base[j] = t;                          \
+    }                                                                       \
+    t = base[0]; base[0] = base[j]; base[j] = t;                            \
+                                                                            \
+    /* recurse into the smaller part, iterate on the larger one */          \
+    if (j < n - j - 1) {                                                    \
+      sc_array_##name##_introsort (base, j, depth);                         \
+      base += j + 1;                                                        \
+      n -= j + 1;                                                           \
+    }                                                                       \
+    else {                                                                  \
+      sc_array_##name##_introsort (base + j + 1, n - j - 1, depth);         \
+      n = j;                                                                \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  /* insertion sort for small ranges */                                     \
+  for (i = 1; i < n; ++i) {                                                 \
+    t = base[i];                                                            \
+    for (j = i; j > 0 && less (t, base[j - 1]); --j) {                      \
+      base[j] = base[j - 1];                                                \
+    }                                                                       \
+    base[j] = t;                                                            \
+  }                                                                         \
+}                                                                           \
+                                                                            \
+static inline void                                                          \
+sc_array_##name##_sort (sc_array_t * array)                                 \
+{                                                                           \
+  int                 depth;                                                \
+  size_t              n;                                                    \
+                                                                            \
+  /* limit the recursion depth to twice the logarithm of the count */       \
+  for (depth = 0, n = array->elem_count; n > 1; n >>= 1) {                  \
+    depth += 2;                                                             \
+  }                                                                         \
+  sc_array_##name##_introsort (sc_array_##name##_data (array),              \
+                               array->elem_count, depth);                   \
+}                                                                           \
+                                                                            \
+static inline ssize_t                                                       \
+sc_array_##name##_bsearch (sc_array_t * array, const type * key)            \
+{                                                                           \
+  const type         *SC_ARRAY_RESTRICT base =                              \
+    sc_array_##name##_data (array);                                         \
+  size_t              lo = 0, hi = array->elem_count, mid;                  \
+                                                                            \
+  /* the first element that does not order before the key */               \
+  while (lo < hi) {                                                         \
+    mid = lo + (hi - lo) / 2;                                               \
+    if (less (base[mid], *key)) {                                           \
+      lo = mid + 1;                                                         \
+    }                                                                       \
+    else {                                                                  \
+      hi = mid;                                                             \
+    }                                                                       \
+  }                                                                         \
+  return lo < array->elem_count && !less (*key, base[lo]) ?                 \
+    (ssize_t) lo : -1;                                                      \
+}
+
+/** Typed functions for int elements, such as sc_array_int_push. */
+SC_ARRAY_DECLARE (int, int)
+/** Typed functions for int32_t elements. */
+SC_ARRAY_DECLARE (int32, int32_t)
+/** Typed functions for int64_t elements. */
+SC_ARRAY_DECLARE (int64, int64_t)
+/** Typed functions for uint64_t elements. */
+SC_ARRAY_DECLARE (uint64, uint64_t)
+/** Typed functions for size_t elements. */
+SC_ARRAY_DECLARE (size_t, size_t)
+/** Typed functions for double elements. */
+SC_ARRAY_DECLARE (double, double)
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_ARRAY_TYPED_H */
@@ -178,12 +178,18 @@ avl_node_t *avl_search(const avl_tree_t *avltree, const void *item) {
 }
 
 avl_tree_t *avl_init_tree(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t freeitem) {
+	return avl_init_tree_mempool(rc, cmp, freeitem, NULL);
+}
+
+avl_tree_t *avl_init_tree_mempool(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t freeitem, sc_mempool_t *mempool) {
+	SC_ASSERT(mempool == NULL || mempool->elem_size == sizeof(avl_node_t));
 	if(rc) {
 		rc->head = NULL;
 		rc->tail = NULL;
 		rc->top = NULL;
 		rc->cmp = cmp;
 		rc->freeitem = freeitem;
+		rc->mempool = mempool;
 	}
 	return rc;
 }
@@ -192,6 +198,23 @@ avl_tree_t *avl_alloc_tree(avl_compare_t cmp, avl_freeitem_t freeitem) {
         return avl_init_tree(SC_ALLOC(avl_tree_t, 1), cmp, freeitem);
 }
 
+avl_tree_t *avl_alloc_tree_mempool(avl_compare_t cmp, avl_freeitem_t freeitem, sc_mempool_t *mempool) {
+        return avl_init_tree_mempool(SC_ALLOC(avl_tree_t, 1), cmp, freeitem, mempool);
+}
+
+static avl_node_t *avl_alloc_node(avl_tree_t *avltree) {
+	return avltree->mempool
+		? (avl_node_t *) sc_mempool_alloc(avltree->mempool)
+		: SC_ALLOC(avl_node_t, 1);
+}
+
+static void avl_release_node(avl_tree_t *avltree, avl_node_t *avlnode) {
+	if(avltree->mempool)
+		sc_mempool_free(avltree->mempool, avlnode);
+	else
+		SC_FREE(avlnode);
+}
+
 void avl_clear_tree(avl_tree_t *avltree) {
 	avltree->top = avltree->head = avltree->tail = NULL;
 }
@@ -206,7 +229,7 @@ void avl_free_nodes(avl_tree_t *avltree) {
 		next = node->next;
 		if(freeitem)
 			freeitem(node->item);
-		SC_FREE(node);
+		avl_release_node(avltree, node);
 	}
 
 	avl_clear_tree(avltree);
@@ -324,11 +347,11 @@ avl_node_t *avl_insert_node(avl_tree_t *avltree, avl_node_t *newnode) {
 avl_node_t *avl_insert(avl_tree_t *avltree, void *item) {
 	avl_node_t *newnode;
 
-	newnode = avl_init_node(SC_ALLOC(avl_node_t, 1), item);
+	newnode = avl_init_node(avl_alloc_node(avltree), item);
 	if(newnode) {
 		if(avl_insert_node(avltree, newnode))
 			return newnode;
-		SC_FREE(newnode);
+		avl_release_node(avltree, newnode);
 		/* errno = EEXIST; */
                 return NULL;
 	}
@@ -403,7 +426,7 @@ void *avl_delete_node(avl_tree_t *avltree, avl_node_t *avlnode) {
 		avl_unlink_node(avltree, avlnode);
 		if(avltree->freeitem)
 			avltree->freeitem(item);
-		SC_FREE(avlnode);
+		avl_release_node(avltree, avlnode);
 	}
 	return item;
 }
@@ -667,4 +690,141 @@ avl_to_array (avl_tree_t * avltree, sc_array_t * array)
   SC_ASSERT (adata.iz == adata.array->elem_count);
 }
 
+/** Link nodes into a balanced subtree and return its top node.
+ * \param [in] nodes    Array of node pointers in ascending order.
+ * \param [in] lo       First index of the subtree.
+ * \param [in] hi       One past the last index of the subtree.
+ * \param [in] parent   Parent node of the subtree, may be NULL.
+ */
+static avl_node_t  *
+avl_link_balanced (avl_node_t ** nodes, size_t lo, size_t hi,
+                   avl_node_t * parent)
+{
+  size_t              mid;
+  avl_node_t         *node;
+
+  if (lo >= hi) {
+    return NULL;
+  }
+  mid = lo + (hi - lo) / 2;
+  node = nodes[mid];
+  node->parent = parent;
+  node->left = avl_link_balanced (nodes, lo, mid, node);
+  node->right = avl_link_balanced (nodes, mid + 1, hi, node);
+  node->count = (unsigned int) (hi - lo);
+
+  return node;
+}
+
+/** Replace the structure of a tree by the nodes of an ascending array. */
+static avl_node_t  *
+avl_link_sorted (avl_tree_t * avltree, sc_array_t * nodes)
+{
+  const size_t        n = nodes->elem_count;
+  size_t              zz;
+  avl_node_t        **pn = (avl_node_t **) nodes->array;
+
+  if (n == 0) {
+    avl_clear_tree (avltree);
+    return NULL;
+  }
+  for (zz = 0; zz < n; ++zz) {
+    pn[zz]->prev = zz > 0 ? pn[zz - 1] : NULL;
+    pn[zz]->next = zz + 1 < n ? pn[zz + 1] : NULL;
+  }
+  avltree->head = pn[0];
+  avltree->tail = pn[n - 1];
+  return avltree->top = avl_link_balanced (pn, 0, n, NULL);
+}
+
+/** Allocate a node for an item and append it to an array of nodes. */
+static void
+avl_push_new_node (avl_tree_t * avltree, sc_array_t * nodes, void *item)
+{
+  avl_node_t         *node;
+
+  node = avl_init_node (avl_alloc_node (avltree), item);
+  *(avl_node_t **) sc_array_push (nodes) = node;
+}
+
+avl_node_t         *
+avl_build_sorted (avl_tree_t * avltree, sc_array_t * items)
+{
+  size_t              zz;
+  sc_array_t          nodes;
+  avl_node_t         *top;
+
+  SC_ASSERT (avltree->top == NULL);
+  SC_ASSERT (items->elem_size == sizeof (void *));
+
+  sc_array_init (&nodes, sizeof (avl_node_t *));
+  sc_array_reserve (&nodes, items->elem_count);
+  for (zz = 0; zz < items->elem_count; ++zz) {
+    SC_ASSERT (zz == 0 ||
+               avltree->cmp (*(void **) sc_array_index (items, zz - 1),
+                             *(void **) sc_array_index (items, zz)) < 0);
+    avl_push_new_node (avltree, &nodes,
+                       *(void **) sc_array_index (items, zz));
+  }
+  top = avl_link_sorted (avltree, &nodes);
+  sc_array_reset (&nodes);
+
+  return top;
+}
+
+size_t
+avl_insert_sorted (avl_tree_t * avltree, sc_array_t * items)
+{
+  const size_t        m = items->elem_count;
+  const size_t        n = avl_count (avltree);
+  size_t              zz, inserted;
+  void               *item;
+  sc_array_t          nodes;
+  avl_node_t         *node, *last;
+
+  SC_ASSERT (items->elem_size == sizeof (void *));
+
+  inserted = 0;
+  if (m * (size_t) SC_LOG2_32 (n + 1) < n) {
+    /* a short run is cheaper to insert one by one */
+    for (zz = 0; zz < m; ++zz) {
+      if (avl_insert (avltree, *(void **) sc_array_index (items, zz))) {
+        ++inserted;
+      }
+    }
+    return inserted;
+  }
+
+  /* merge the run with the nodes in order and relink all of them */
+  sc_array_init (&nodes, sizeof (avl_node_t *));
+  sc_array_reserve (&nodes, n + m);
+  node = avltree->head;
+  last = NULL;
+  for (zz = 0; zz < m;) {
+    item = *(void **) sc_array_index (items, zz);
+    SC_ASSERT (zz == 0 || avltree->cmp (*(void **) sc_array_index
+                                        (items, zz - 1), item) <= 0);
+    if (node != NULL && avltree->cmp (node->item, item) < 0) {
+      *(avl_node_t **) sc_array_push (&nodes) = last = node;
+      node = node->next;
+      continue;
+    }
+    if ((node == NULL || avltree->cmp (item, node->item) != 0) &&
+        (last == NULL || avltree->cmp (last->item, item) != 0)) {
+      avl_push_new_node (avltree, &nodes, item);
+      last = *(avl_node_t **) sc_array_index (&nodes, nodes.elem_count - 1);
+      ++inserted;
+    }
+    ++zz;
+  }
+  for (; node != NULL; node = node->next) {
+    *(avl_node_t **) sc_array_push (&nodes) = node;
+  }
+  SC_ASSERT (nodes.elem_count == n + inserted);
+  avl_link_sorted (avltree, &nodes);
+  sc_array_reset (&nodes);
+
+  return inserted;
+}
+
 #endif /* AVL_COUNT */
@@ -85,6 +85,7 @@ typedef struct avl_tree_t {
 	avl_node_t *top;
 	avl_compare_t cmp;
 	avl_freeitem_t freeitem;
+	sc_mempool_t *mempool;
 } avl_tree_t;
 
 /* Initializes a new tree for elements that will be ordered using
@@ -93,12 +94,23 @@ typedef struct avl_tree_t {
  * O(1) */
 extern avl_tree_t *avl_init_tree(avl_tree_t *avltree, avl_compare_t, avl_freeitem_t);
 
+/* Initializes a new tree like avl_init_tree that allocates its nodes
+ * from a memory pool of element size sizeof(avl_node_t) if not NULL.
+ * The pool belongs to the caller and may be shared between trees.
+ * It must stay alive until the nodes of the tree are freed.
+ * O(1) */
+extern avl_tree_t *avl_init_tree_mempool(avl_tree_t *avltree, avl_compare_t, avl_freeitem_t, sc_mempool_t *mempool);
+
 /* Allocates and initializes a new tree for elements that will be
  * ordered using the supplied strcmp()-like function.
  * Aborts if memory could not be allocated.
  * O(1) */
 extern avl_tree_t *avl_alloc_tree(avl_compare_t, avl_freeitem_t);
 
+/* Allocates and initializes a new tree like avl_init_tree_mempool.
+ * O(1) */
+extern avl_tree_t *avl_alloc_tree_mempool(avl_compare_t, avl_freeitem_t, sc_mempool_t *mempool);
+
 /* Frees the entire tree efficiently. Nodes will be free()d.
  * If the tree's freeitem is not NULL it will be invoked on every item.
  * O(n) */
@@ -205,6 +217,21 @@ extern unsigned int avl_index(const avl_node_t *);
 * O(n) */
 extern void avl_to_array (avl_tree_t *, sc_array_t *);
 
+/* Builds a perfectly balanced tree from an array of void * items that
+ * are strictly ascending wrt. the compare function of the tree.
+ * The tree must be empty.  Returns the top node or NULL if empty.
+ * O(n) */
+extern avl_node_t *avl_build_sorted (avl_tree_t *, sc_array_t *);
+
+/* Inserts an array of void * items that are ascending wrt. the compare
+ * function of the tree.  Items equal to an item in the tree or to their
+ * predecessor in the array are skipped.  A large run is merged with the
+ * tree in one pass that relinks the existing nodes into a balanced tree,
+ * a small run is inserted item by item.  Nodes keep their items.
+ * Returns the number of items inserted.
+ * O(min(m lg n, n + m)) for m items */
+extern size_t avl_insert_sorted (avl_tree_t *, sc_array_t *);
+
 #endif /* AVL_COUNT */
 
 SC_EXTERN_C_END;
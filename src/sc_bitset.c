@@ -0,0 +1,341 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_bitset.h>
+
+/* words per block of the rank directory */
+#define SC_BITSET_BLOCK 8
+
+static inline int
+sc_bitset_popcount (uint64_t w)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll ((unsigned long long) w);
+#else
+  w = w - ((w >> 1) & 0x5555555555555555ULL);
+  w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (int) ((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline int
+sc_bitset_ctz (uint64_t w)
+{
+  SC_ASSERT (w != 0);
+#ifdef __GNUC__
+  return __builtin_ctzll ((unsigned long long) w);
+#else
+  return sc_bitset_popcount ((w & -w) - 1);
+#endif
+}
+
+/* clear the unused bits of the last word */
+static void
+sc_bitset_trim (sc_bitset_t * bs)
+{
+  if (bs->num_bits % 64 != 0) {
+    bs->words[bs->num_words - 1] &=
+      ((uint64_t) 1 << (bs->num_bits % 64)) - 1;
+  }
+}
+
+size_t
+sc_bitset_memory_used (sc_bitset_t * bs)
+{
+  return sizeof (sc_bitset_t) + bs->word_alloc * sizeof (uint64_t) +
+    (bs->rank != NULL ?
+     (bs->num_words / SC_BITSET_BLOCK + 1) * sizeof (size_t) : 0);
+}
+
+sc_bitset_t        *
+sc_bitset_new (size_t num_bits)
+{
+  sc_bitset_t        *bs;
+
+  bs = SC_ALLOC_ZERO (sc_bitset_t, 1);
+  sc_bitset_resize (bs, num_bits);
+
+  return bs;
+}
+
+void
+sc_bitset_destroy (sc_bitset_t * bs)
+{
+  SC_FREE (bs->words);
+  SC_FREE (bs->rank);
+  SC_FREE (bs);
+}
+
+void
+sc_bitset_resize (sc_bitset_t * bs, size_t num_bits)
+{
+  size_t              num_words = (num_bits + 63) / 64;
+
+  if (num_words > bs->word_alloc) {
+    bs->word_alloc = SC_MAX (num_words, 2 * bs->word_alloc);
+    bs->words = SC_REALLOC (bs->words, uint64_t, bs->word_alloc);
+  }
+  if (num_words > bs->num_words) {
+    memset (bs->words + bs->num_words, 0,
+            (num_words - bs->num_words) * sizeof (uint64_t));
+  }
+  bs->num_bits = num_bits;
+  bs->num_words = num_words;
+  sc_bitset_trim (bs);
+
+  /* the directory has a different size now */
+  SC_FREE (bs->rank);
+  bs->rank = NULL;
+  bs->rank_valid = 0;
+}
+
+void
+sc_bitset_fill (sc_bitset_t * bs, int value)
+{
+  if (bs->num_words > 0) {
+    memset (bs->words, value ? 0xff : 0, bs->num_words * sizeof (uint64_t));
+    sc_bitset_trim (bs);
+  }
+  bs->rank_valid = 0;
+}
+
+void
+sc_bitset_and (sc_bitset_t * bs, const sc_bitset_t * other)
+{
+  size_t              iw;
+  uint64_t           *w = bs->words;
+  const uint64_t     *o = other->words;
+
+  SC_ASSERT (bs->num_bits == other->num_bits);
+  for (iw = 0; iw < bs->num_words; ++iw) {
+    w[iw] &= o[iw];
+  }
+  bs->rank_valid = 0;
+}
+
+void
+sc_bitset_or (sc_bitset_t * bs, const sc_bitset_t * other)
+{
+  size_t              iw;
+  uint64_t           *w = bs->words;
+  const uint64_t     *o = other->words;
+
+  SC_ASSERT (bs->num_bits == other->num_bits);
+  for (iw = 0; iw < bs->num_words; ++iw) {
+    w[iw] |= o[iw];
+  }
+  bs->rank_valid = 0;
+}
+
+void
+sc_bitset_xor (sc_bitset_t * bs, const sc_bitset_t * other)
+{
+  size_t              iw;
+  uint64_t           *w = bs->words;
+  const uint64_t     *o = other->words;
+
+  SC_ASSERT (bs->num_bits == other->num_bits);
+  for (iw = 0; iw < bs->num_words; ++iw) {
+    w[iw] ^= o[iw];
+  }
+  bs->rank_valid = 0;
+}
+
+void
+sc_bitset_andnot (sc_bitset_t * bs, const sc_bitset_t * other)
+{
+  size_t              iw;
+  uint64_t           *w = bs->words;
+  const uint64_t     *o = other->words;
+
+  SC_ASSERT (bs->num_bits == other->num_bits);
+  for (iw = 0; iw < bs->num_words; ++iw) {
+    w[iw] &= ~o[iw];
+  }
+  bs->rank_valid = 0;
+}
+
+void
+sc_bitset_not (sc_bitset_t * bs)
+{
+  size_t              iw;
+
+  for (iw = 0; iw < bs->num_words; ++iw) {
+    bs->words[iw] = ~bs->words[iw];
+  }
+  if (bs->num_words > 0) {
+    sc_bitset_trim (bs);
+  }
+  bs->rank_valid = 0;
+}
+
+size_t
+sc_bitset_count (const sc_bitset_t * bs)
+{
+  size_t              iw, count = 0;
+
+  for (iw = 0; iw < bs->num_words; ++iw) {
+    count += (size_t) sc_bitset_popcount (bs->words[iw]);
+  }
+  return count;
+}
+
+void
+sc_bitset_rank_build (sc_bitset_t * bs)
+{
+  size_t              ib, iw, num_blocks, count;
+
+  num_blocks = (bs->num_words + SC_BITSET_BLOCK - 1) / SC_BITSET_BLOCK;
+  if (bs->rank == NULL) {
+    bs->rank = SC_ALLOC (size_t, bs->num_words / SC_BITSET_BLOCK + 1);
+  }
+
+  /* entry ib counts the set bits in the words before block ib */
+  count = 0;
+  for (ib = 0, iw = 0; ib < num_blocks; ++ib) {
+    bs->rank[ib] = count;
+    for (; iw < SC_MIN ((ib + 1) * SC_BITSET_BLOCK, bs->num_words); ++iw) {
+      count += (size_t) sc_bitset_popcount (bs->words[iw]);
+    }
+  }
+  if (bs->num_words % SC_BITSET_BLOCK == 0) {
+    bs->rank[num_blocks] = count;
+  }
+  bs->rank_valid = 1;
+}
+
+size_t
+sc_bitset_rank (const sc_bitset_t * bs, size_t i)
+{
+  size_t              iw, count;
+
+  SC_ASSERT (bs->rank_valid);
+  SC_ASSERT (i <= bs->num_bits);
+
+  iw = i / 64;
+  count = bs->rank[iw / SC_BITSET_BLOCK];
+  for (iw = iw / SC_BITSET_BLOCK * SC_BITSET_BLOCK; iw < i / 64; ++iw) {
+    count += (size_t) sc_bitset_popcount (bs->words[iw]);
+  }
+  if (i % 64 != 0) {
+    count += (size_t) sc_bitset_popcount
+      (bs->words[iw] & (((uint64_t) 1 << (i % 64)) - 1));
+  }
+  return count;
+}
+
+size_t
+sc_bitset_select (const sc_bitset_t * bs, size_t k)
+{
+  size_t              lo, hi, guess, iw, c;
+  uint64_t            w;
+
+  SC_ASSERT (bs->rank_valid);
+  if (bs->num_words == 0) {
+    return bs->num_bits;
+  }
+
+  /* find the last block with fewer than k + 1 set bits before it */
+  lo = 0;
+  hi = (bs->num_words - 1) / SC_BITSET_BLOCK;
+  while (lo < hi) {
+    guess = (lo + hi + 1) / 2;
+    if (bs->rank[guess] <= k) {
+      lo = guess;
+    }
+    else {
+      hi = guess - 1;
+    }
+  }
+  k -= bs->rank[lo];
+
+  /* scan the words of the block */
+  for (iw = lo * SC_BITSET_BLOCK; iw < bs->num_words; ++iw) {
+    w = bs->words[iw];
+    c = (size_t) sc_bitset_popcount (w);
+    if (k < c) {
+      while (k-- > 0) {
+        w &= w - 1;
+      }
+      return 64 * iw + sc_bitset_ctz (w);
+    }
+    k -= c;
+  }
+  return bs->num_bits;
+}
+
+size_t
+sc_bitset_next (const sc_bitset_t * bs, size_t i)
+{
+  size_t              iw;
+  uint64_t            w;
+
+  if (i >= bs->num_bits) {
+    return bs->num_bits;
+  }
+  iw = i / 64;
+  w = bs->words[iw] & (~(uint64_t) 0 << (i % 64));
+  while (w == 0) {
+    if (++iw == bs->num_words) {
+      return bs->num_bits;
+    }
+    w = bs->words[iw];
+  }
+  return 64 * iw + sc_bitset_ctz (w);
+}
+
+size_t
+sc_bitset_pack_size (size_t num_bits)
+{
+  return (num_bits + 7) / 8;
+}
+
+void
+sc_bitset_pack (const sc_bitset_t * bs, void *buffer)
+{
+  size_t              ib, nb;
+  unsigned char      *b = (unsigned char *) buffer;
+
+  nb = sc_bitset_pack_size (bs->num_bits);
+  for (ib = 0; ib < nb; ++ib) {
+    b[ib] = (unsigned char) (bs->words[ib / 8] >> (8 * (ib % 8)));
+  }
+}
+
+void
+sc_bitset_unpack (sc_bitset_t * bs, size_t num_bits, const void *buffer)
+{
+  size_t              ib, nb;
+  const unsigned char *b = (const unsigned char *) buffer;
+
+  sc_bitset_resize (bs, num_bits);
+  sc_bitset_fill (bs, 0);
+  nb = sc_bitset_pack_size (num_bits);
+  for (ib = 0; ib < nb; ++ib) {
+    bs->words[ib / 8] |= (uint64_t) b[ib] << (8 * (ib % 8));
+  }
+  if (bs->num_words > 0) {
+    sc_bitset_trim (bs);
+  }
+}
@@ -0,0 +1,225 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_bitset.h
+ *
+ * A dynamic array of bits stored in 64-bit words.
+ *
+ * The bitset replaces arrays of char or int flags at 1/8 to 1/32 of their
+ * memory.  Whole-set logical operations and counting run one word at a
+ * time in loops simple enough for the compiler to vectorize.  An optional
+ * rank directory answers rank and select queries without scanning the
+ * set, and the bits can be packed into a byte buffer of the same layout
+ * on every architecture, for example as payload of \ref sc_notify_payload.
+ */
+
+#ifndef SC_BITSET_H
+#define SC_BITSET_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The bitset object.  The members may be read but not written. */
+typedef struct sc_bitset
+{
+  /* interface variables */
+  size_t              num_bits;         /**< number of valid bits */
+  uint64_t           *words;            /**< bit i is in words[i / 64] */
+
+  /* implementation variables */
+  size_t              num_words;        /**< ceil (num_bits / 64) */
+  size_t              word_alloc;       /**< allocated words */
+  size_t             *rank;     /**< set bits before each 512-bit block */
+  int                 rank_valid;       /**< rank directory is current */
+}
+sc_bitset_t;
+
+/** Calculate the memory used by a bitset.
+ * \param [in] bs       Valid bitset.
+ * \return              Memory used in bytes.
+ */
+size_t              sc_bitset_memory_used (sc_bitset_t * bs);
+
+/** Create a bitset with all bits cleared.
+ * \param [in] num_bits     Number of bits, may be zero.
+ * \return                  Bitset to be freed by \ref sc_bitset_destroy.
+ */
+sc_bitset_t        *sc_bitset_new (size_t num_bits);
+
+/** Free a bitset and its rank directory. */
+void                sc_bitset_destroy (sc_bitset_t * bs);
+
+/** Change the number of bits; bits added at the end are cleared.
+ * \param [in,out] bs       Valid bitset.
+ * \param [in] num_bits     New number of bits.
+ */
+void                sc_bitset_resize (sc_bitset_t * bs, size_t num_bits);
+
+/** Set all bits to the same value.
+ * \param [in,out] bs       Valid bitset.
+ * \param [in] value        If true, all bits are set, otherwise cleared.
+ */
+void                sc_bitset_fill (sc_bitset_t * bs, int value);
+
+/** Query a bit.
+ * \param [in] bs       Valid bitset.
+ * \param [in] i        Bit index less than bs->num_bits.
+ * \return              True if the bit is set.
+ */
+static inline int
+sc_bitset_get (const sc_bitset_t * bs, size_t i)
+{
+  SC_ASSERT (i < bs->num_bits);
+  return (int) ((bs->words[i / 64] >> (i % 64)) & 1);
+}
+
+/** Set a bit.
+ * \param [in,out] bs   Valid bitset.
+ * \param [in] i        Bit index less than bs->num_bits.
+ */
+static inline void
+sc_bitset_set (sc_bitset_t * bs, size_t i)
+{
+  SC_ASSERT (i < bs->num_bits);
+  bs->words[i / 64] |= (uint64_t) 1 << (i % 64);
+  bs->rank_valid = 0;
+}
+
+/** Clear a bit.
+ * \param [in,out] bs   Valid bitset.
+ * \param [in] i        Bit index less than bs->num_bits.
+ */
+static inline void
+sc_bitset_clear (sc_bitset_t * bs, size_t i)
+{
+  SC_ASSERT (i < bs->num_bits);
+  bs->words[i / 64] &= ~((uint64_t) 1 << (i % 64));
+  bs->rank_valid = 0;
+}
+
+/** Set or clear a bit.
+ * \param [in,out] bs   Valid bitset.
+ * \param [in] i        Bit index less than bs->num_bits.
+ * \param [in] value    If true the bit is set, otherwise cleared.
+ */
+static inline void
+sc_bitset_assign (sc_bitset_t * bs, size_t i, int value)
+{
+  if (value) {
+    sc_bitset_set (bs, i);
+  }
+  else {
+    sc_bitset_clear (bs, i);
+  }
+}
+
+/** Replace \a bs by the bitwise and of \a bs and \a other.
+ * Both sets must have the same number of bits.
+ */
+void                sc_bitset_and (sc_bitset_t * bs,
+                                   const sc_bitset_t * other);
+
+/** Replace \a bs by the bitwise or of \a bs and \a other.
+ * Both sets must have the same number of bits.
+ */
+void                sc_bitset_or (sc_bitset_t * bs,
+                                  const sc_bitset_t * other);
+
+/** Replace \a bs by the bitwise exclusive or of \a bs and \a other.
+ * Both sets must have the same number of bits.
+ */
+void                sc_bitset_xor (sc_bitset_t * bs,
+                                   const sc_bitset_t * other);
+
+/** Clear all bits of \a bs that are set in \a other.
+ * Both sets must have the same number of bits.
+ */
+void                sc_bitset_andnot (sc_bitset_t * bs,
+                                      const sc_bitset_t * other);
+
+/** Invert all bits of a bitset. */
+void                sc_bitset_not (sc_bitset_t * bs);
+
+/** Count the set bits.
+ * \param [in] bs       Valid bitset.
+ * \return              Number of set bits.
+ */
+size_t              sc_bitset_count (const sc_bitset_t * bs);
+
+/** Build the rank directory used by \ref sc_bitset_rank and \ref
+ * sc_bitset_select.  It occupies one size_t per 512 bits.  Any
+ * modification of the set invalidates the directory, which must then be
+ * rebuilt before the next query.
+ * \param [in,out] bs   Valid bitset.
+ */
+void                sc_bitset_rank_build (sc_bitset_t * bs);
+
+/** Count the set bits before a position in O(1).
+ * \param [in] bs       Bitset with a current rank directory.
+ * \param [in] i        Position not greater than bs->num_bits.
+ * \return              Number of set bits with index less than \a i.
+ */
+size_t              sc_bitset_rank (const sc_bitset_t * bs, size_t i);
+
+/** Find the position of a set bit by its rank in O(log n).
+ * \param [in] bs       Bitset with a current rank directory.
+ * \param [in] k        Zero-based rank of the set bit to find.
+ * \return              Index of the set bit with exactly \a k set bits
+ *                      before it, or bs->num_bits if there is none.
+ */
+size_t              sc_bitset_select (const sc_bitset_t * bs, size_t k);
+
+/** Iterate over the set bits.  Zero words are skipped at once.
+ * To visit all set bits, loop with i = sc_bitset_next (bs, 0) while
+ * i < bs->num_bits and continue with sc_bitset_next (bs, i + 1).
+ * \param [in] bs       Valid bitset.
+ * \param [in] i        Position to start the search.
+ * \return              The first set bit at or after \a i, or
+ *                      bs->num_bits if there is none.
+ */
+size_t              sc_bitset_next (const sc_bitset_t * bs, size_t i);
+
+/** Return the number of bytes needed to pack a number of bits. */
+size_t              sc_bitset_pack_size (size_t num_bits);
+
+/** Pack the bits into a byte buffer.
+ * Bit i is stored in byte i / 8 at bit position i % 8 independent of
+ * the byte order of the machine, so the buffer may be sent by MPI as
+ * sc_MPI_BYTE or used as fixed-size payload of \ref sc_notify_payload.
+ * \param [in] bs       Valid bitset.
+ * \param [out] buffer  At least \ref sc_bitset_pack_size bytes.
+ */
+void                sc_bitset_pack (const sc_bitset_t * bs, void *buffer);
+
+/** Unpack bits that were packed by \ref sc_bitset_pack.
+ * \param [in,out] bs   Valid bitset, resized to \a num_bits.
+ * \param [in] num_bits Number of bits in the buffer.
+ * \param [in] buffer   Packed bits.
+ */
+void                sc_bitset_unpack (sc_bitset_t * bs, size_t num_bits,
+                                      const void *buffer);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_BITSET_H */
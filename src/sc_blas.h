@@ -100,6 +100,10 @@ extern const char   sc_cmachchar[];
 #define SC_BLAS_DDOT    SC_F77_FUNC(ddot,DDOT)
 #define SC_BLAS_DGEMV   SC_F77_FUNC(dgemv,DGEMV)
 #define SC_BLAS_DGEMM   SC_F77_FUNC(dgemm,DGEMM)
+#define SC_BLAS_SSCAL   SC_F77_FUNC(sscal,SSCAL)
+#define SC_BLAS_SAXPY   SC_F77_FUNC(saxpy,SAXPY)
+#define SC_BLAS_SGEMV   SC_F77_FUNC(sgemv,SGEMV)
+#define SC_BLAS_SGEMM   SC_F77_FUNC(sgemm,SGEMM)
 
 double              SC_BLAS_DLAMCH (const char *cmach);
 void                SC_BLAS_DSCAL (const sc_bint_t * n, const double *alpha,
@@ -129,6 +133,27 @@ void                SC_BLAS_DGEMM (const char *transa, const char *transb,
                                    const double *beta, double *c,
                                    const sc_bint_t * ldc);
 
+void                SC_BLAS_SSCAL (const sc_bint_t * n, const float *alpha,
+                                   float *X, const sc_bint_t * incx);
+void                SC_BLAS_SAXPY (const sc_bint_t * n, const float *alpha,
+                                   const float *X, const sc_bint_t * incx,
+                                   float *Y, const sc_bint_t * incy);
+
+void                SC_BLAS_SGEMV (const char *transa, const sc_bint_t * m,
+                                   const sc_bint_t * n, const float *alpha,
+                                   const float *a, const sc_bint_t * lda,
+                                   const float *x, const sc_bint_t * incx,
+                                   const float *beta, float *y,
+                                   const sc_bint_t * incy);
+
+void                SC_BLAS_SGEMM (const char *transa, const char *transb,
+                                   const sc_bint_t * m, const sc_bint_t * n,
+                                   const sc_bint_t * k, const float *alpha,
+                                   const float *a, const sc_bint_t * lda,
+                                   const float *b, const sc_bint_t * ldb,
+                                   const float *beta, float *c,
+                                   const sc_bint_t * ldc);
+
 #else /* !SC_WITH_BLAS */
 
 #define SC_BLAS_DLAMCH (double) sc_blas_nonimplemented
@@ -138,6 +163,10 @@ void                SC_BLAS_DGEMM (const char *transa, const char *transb,
 #define SC_BLAS_DDOT   (double) sc_blas_nonimplemented
 #define SC_BLAS_DGEMM  (void)   sc_blas_nonimplemented
 #define SC_BLAS_DGEMV  (void)   sc_blas_nonimplemented
+#define SC_BLAS_SSCAL  (void)   sc_blas_nonimplemented
+#define SC_BLAS_SAXPY  (void)   sc_blas_nonimplemented
+#define SC_BLAS_SGEMM  (void)   sc_blas_nonimplemented
+#define SC_BLAS_SGEMV  (void)   sc_blas_nonimplemented
 
 int                 sc_blas_nonimplemented (SC_NOARGS);
 
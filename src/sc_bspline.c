@@ -508,3 +508,166 @@ sc_bspline_derivative2 (sc_bspline_t * bs, double t, double *result)
 
   memcpy (result, pfrom, sizeof (double) * bs->d);
 }
+
+sc_dmatrix_t       *
+sc_bspline_workspace_batch_new (int n, int d)
+{
+  SC_ASSERT (n >= 0 && d >= 1);
+
+  return sc_dmatrix_new ((n + 1) * d, SC_BSPLINE_BATCH);
+}
+
+/** Find the knot interval of a parameter without modifying the spline.
+ * \param [in] bs       B-spline structure.
+ * \param [in] t        Value that must be within the range of the knots.
+ * \param [in] iguess   Interval of the previous parameter of a sweep.
+ * \return              Largest interval i with knots[i] <= t.
+ */
+static int
+sc_bspline_find_interval_sweep (const sc_bspline_t * bs, double t,
+                                int iguess)
+{
+  int                 ileft, iright, imid;
+  const double       *knotse = bs->knots->e[0];
+
+  SC_ASSERT (t >= knotse[bs->n] && t <= knotse[bs->n + bs->l]);
+  SC_ASSERT (iguess >= bs->n && iguess < bs->n + bs->l);
+
+  ileft = bs->n;
+  iright = bs->n + bs->l - 1;
+  if (knotse[iguess] <= t) {
+    /* ascending parameters mostly stay in or move to the next interval */
+    if (iguess == iright || t < knotse[iguess + 1]) {
+      return iguess;
+    }
+    if (iguess + 1 == iright || t < knotse[iguess + 2]) {
+      return iguess + 1;
+    }
+    ileft = iguess + 2;
+  }
+  else {
+    iright = iguess - 1;
+  }
+
+  /* bisection for the largest interval whose left knot is <= t */
+  while (ileft < iright) {
+    imid = (ileft + iright + 1) / 2;
+    if (knotse[imid] <= t) {
+      ileft = imid;
+    }
+    else {
+      iright = imid - 1;
+    }
+  }
+  return ileft;
+}
+
+void
+sc_bspline_derivative_n_batch (const sc_bspline_t * bs, int order,
+                               size_t num_t, const double *t,
+                               double *result, sc_dmatrix_t * works)
+{
+  const int           d = bs->d;
+  const double       *knotse = bs->knots->e[0];
+  int                 i, k, n, q, nq;
+  int                 iguess;
+  int                 intervals[SC_BSPLINE_BATCH];
+  double              fleft[SC_BSPLINE_BATCH];
+  double              fright[SC_BSPLINE_BATCH];
+  double             *w, *wi, *wn;
+  const double       *tb;
+  size_t              zb;
+  sc_dmatrix_t       *own = NULL;
+
+  SC_ASSERT (order >= 0);
+  SC_ASSERT (num_t == 0 || (t != NULL && result != NULL));
+
+  if (bs->n < order) {
+    memset (result, 0, sizeof (double) * num_t * d);
+    return;
+  }
+  if (works == NULL) {
+    works = own = sc_bspline_workspace_batch_new (bs->n, d);
+  }
+  SC_ASSERT (works->m == (bs->n + 1) * d);
+  SC_ASSERT (works->n == SC_BSPLINE_BATCH);
+
+  /* the workspace holds (n + 1) * d rows of SC_BSPLINE_BATCH values */
+  w = works->e[0];
+  iguess = bs->n;
+  for (zb = 0; zb < num_t; zb += SC_BSPLINE_BATCH) {
+    tb = t + zb;
+    nq = (int) SC_MIN (num_t - zb, (size_t) SC_BSPLINE_BATCH);
+
+    /* locate the knot intervals and gather the control points */
+    for (q = 0; q < nq; ++q) {
+      intervals[q] = iguess = sc_bspline_find_interval_sweep (bs, tb[q],
+                                                              iguess);
+    }
+    for (q = 0; q < nq; ++q) {
+      const double       *pe = bs->points->e[intervals[q] - bs->n];
+
+      for (i = 0; i < (bs->n + 1) * d; ++i) {
+        w[i * SC_BSPLINE_BATCH + q] = pe[i];
+      }
+    }
+
+    /* de Boor's recursion in place, vectorized over the parameters */
+    for (n = bs->n; n > 0; --n) {
+      const int           deriv = bs->n < n + order;
+
+      for (i = 0; i < n; ++i) {
+        for (q = 0; q < nq; ++q) {
+          const double        tleft = knotse[intervals[q] + i - n + 1];
+          const double        tright = knotse[intervals[q] + i + 1];
+          const double        tfactor = 1. / (tright - tleft);
+
+          if (deriv) {
+            fleft[q] = n * tfactor;
+            fright[q] = -n * tfactor;
+          }
+          else {
+            fleft[q] = (tb[q] - tleft) * tfactor;
+            fright[q] = (tright - tb[q]) * tfactor;
+          }
+        }
+        for (k = 0; k < d; ++k) {
+          wi = w + (i * d + k) * SC_BSPLINE_BATCH;
+          wn = wi + d * SC_BSPLINE_BATCH;
+#ifdef SC_ENABLE_OPENMP
+#pragma omp simd
+#endif
+          for (q = 0; q < nq; ++q) {
+            wi[q] = fleft[q] * wn[q] + fright[q] * wi[q];
+          }
+        }
+      }
+    }
+
+    for (q = 0; q < nq; ++q) {
+      for (k = 0; k < d; ++k) {
+        result[(zb + q) * d + k] = w[k * SC_BSPLINE_BATCH + q];
+      }
+    }
+  }
+
+  if (own != NULL) {
+    sc_dmatrix_destroy (own);
+  }
+}
+
+void
+sc_bspline_evaluate_batch (const sc_bspline_t * bs, size_t num_t,
+                           const double *t, double *result,
+                           sc_dmatrix_t * works)
+{
+  sc_bspline_derivative_n_batch (bs, 0, num_t, t, result, works);
+}
+
+void
+sc_bspline_derivative_batch (const sc_bspline_t * bs, size_t num_t,
+                             const double *t, double *result,
+                             sc_dmatrix_t * works)
+{
+  sc_bspline_derivative_n_batch (bs, 1, num_t, t, result, works);
+}
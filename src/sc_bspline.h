@@ -28,6 +28,9 @@
 
 SC_EXTERN_C_BEGIN;
 
+/** Number of parameters evaluated together by the batch functions. */
+#define SC_BSPLINE_BATCH 64
+
 typedef struct
 {
   int                 d; /** Dimensionality of control points */
@@ -163,6 +166,53 @@ void                sc_bspline_derivative_n (sc_bspline_t * bs, int order,
 void                sc_bspline_derivative2 (sc_bspline_t * bs,
                                             double t, double *result);
 
+/** Create workspace for batched B-spline evaluation.
+ * A workspace may be used by one thread at a time only.  Threads that
+ * share a B-spline structure each pass their own workspace.
+ * \param [in] n        Polynomial degree of the spline functions, n >= 0.
+ * \param [in] d        Dimension of the control points in R^d, d >= 1.
+ * \return              Workspace ((n + 1) * d) x SC_BSPLINE_BATCH.
+ */
+sc_dmatrix_t       *sc_bspline_workspace_batch_new (int n, int d);
+
+/** Evaluate a B-spline at many points.
+ * The knot intervals are located in a sweep that is fastest when the
+ * parameters are ascending, but any order is allowed.  The recursion runs
+ * over blocks of SC_BSPLINE_BATCH parameters at a time such that the
+ * innermost loops are over parameters and may be vectorized.
+ * This function does not modify the B-spline structure and is reentrant.
+ * \param [in] bs       B-spline structure.  Its workspace is not used.
+ * \param [in] num_t    Number of parameters.
+ * \param [in] t        Array of \a num_t values within the knot range.
+ * \param [out] result  Array of \a num_t points in R^d one after another.
+ * \param [in,out] works        Workspace from \ref
+ *                      sc_bspline_workspace_batch_new.  If NULL, a
+ *                      temporary workspace is allocated.
+ */
+void                sc_bspline_evaluate_batch (const sc_bspline_t * bs,
+                                               size_t num_t, const double *t,
+                                               double *result,
+                                               sc_dmatrix_t * works);
+
+/** Evaluate a B-spline derivative at many points.
+ * See \ref sc_bspline_evaluate_batch for the parameters.
+ */
+void                sc_bspline_derivative_batch (const sc_bspline_t * bs,
+                                                 size_t num_t,
+                                                 const double *t,
+                                                 double *result,
+                                                 sc_dmatrix_t * works);
+
+/** Evaluate any order B-spline derivative at many points.
+ * See \ref sc_bspline_evaluate_batch for the remaining parameters.
+ * \param [in] order    Order of the derivative >= 0.
+ */
+void                sc_bspline_derivative_n_batch (const sc_bspline_t * bs,
+                                                   int order, size_t num_t,
+                                                   const double *t,
+                                                   double *result,
+                                                   sc_dmatrix_t * works);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_BSPLINE_H */
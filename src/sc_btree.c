@@ -0,0 +1,499 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_btree.h>
+
+/** The approximate number of bytes of elements in one node. */
+#define SC_BTREE_NODE_BYTES 512
+
+/** Round the size of a node to keep consecutive nodes in a pool aligned. */
+#define SC_BTREE_ALIGN(s) (((s) + 15) & ~(size_t) 15)
+
+/** Address of an element in a node of a B-tree. */
+#define SC_BTREE_ELEM(b,n,i) ((n)->elems + (size_t) (i) * (b)->elem_size)
+
+typedef struct sc_btree_node
+{
+  int                 count;    /**< Number of elements in this node. */
+  int                 leaf;     /**< True if the node has no children. */
+  char               *elems;    /**< Sorted elements after the header. */
+  struct sc_btree_node **children;      /**< count + 1 children or NULL. */
+}
+sc_btree_node_t;
+
+struct sc_btree
+{
+  size_t              elem_size;
+  int                 (*compar) (const void *, const void *);
+  int                 min_count;        /**< Minimum degree of the tree. */
+  int                 max_count;        /**< Maximum elements per node. */
+  size_t              elem_count;
+  sc_btree_node_t    *root;
+  char               *scratch;  /**< One element of temporary storage. */
+  sc_mempool_t       *leaves;
+  sc_mempool_t       *inner;
+};
+
+static sc_btree_node_t *
+sc_btree_node_new (sc_btree_t * btree, int leaf)
+{
+  sc_btree_node_t    *node;
+
+  node = (sc_btree_node_t *)
+    sc_mempool_alloc (leaf ? btree->leaves : btree->inner);
+  node->count = 0;
+  node->leaf = leaf;
+  if (leaf) {
+    node->children = NULL;
+    node->elems = (char *) (node + 1);
+  }
+  else {
+    node->children = (sc_btree_node_t **) (node + 1);
+    node->elems = (char *) (node->children + btree->max_count + 1);
+  }
+
+  return node;
+}
+
+static void
+sc_btree_node_destroy (sc_btree_t * btree, sc_btree_node_t * node)
+{
+  sc_mempool_free (node->leaf ? btree->leaves : btree->inner, node);
+}
+
+/** Return the position of the first element not less than elem.
+ * \param [out] equal   True if the element at that position equals elem.
+ */
+static int
+sc_btree_node_find (sc_btree_t * btree, sc_btree_node_t * node,
+                    const void *elem, int *equal)
+{
+  int                 lo = 0, hi = node->count, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (btree->compar (SC_BTREE_ELEM (btree, node, mid), elem) < 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  *equal = lo < node->count &&
+    btree->compar (elem, SC_BTREE_ELEM (btree, node, lo)) == 0;
+
+  return lo;
+}
+
+/** Move the elements of a node from a position on by an offset.
+ * The children to the right of these elements move along.
+ */
+static void
+sc_btree_node_shift (sc_btree_t * btree, sc_btree_node_t * node,
+                     int pos, int offset)
+{
+  memmove (SC_BTREE_ELEM (btree, node, pos + offset),
+           SC_BTREE_ELEM (btree, node, pos),
+           (size_t) (node->count - pos) * btree->elem_size);
+  if (!node->leaf) {
+    memmove (node->children + pos + 1 + offset, node->children + pos + 1,
+             (size_t) (node->count - pos) * sizeof (sc_btree_node_t *));
+  }
+  node->count += offset;
+}
+
+/** Split the full child at a position of a node that is not full. */
+static void
+sc_btree_split_child (sc_btree_t * btree, sc_btree_node_t * node, int pos)
+{
+  const int           t = btree->min_count;
+  sc_btree_node_t    *left = node->children[pos];
+  sc_btree_node_t    *right = sc_btree_node_new (btree, left->leaf);
+
+  SC_ASSERT (left->count == btree->max_count);
+
+  /* the upper half goes to the new right sibling */
+  right->count = t - 1;
+  memcpy (right->elems, SC_BTREE_ELEM (btree, left, t),
+          (size_t) (t - 1) * btree->elem_size);
+  if (!left->leaf) {
+    memcpy (right->children, left->children + t,
+            (size_t) t * sizeof (sc_btree_node_t *));
+  }
+  left->count = t - 1;
+
+  /* the middle element moves up into the parent */
+  sc_btree_node_shift (btree, node, pos, 1);
+  memcpy (SC_BTREE_ELEM (btree, node, pos), SC_BTREE_ELEM (btree, left, t - 1),
+          btree->elem_size);
+  node->children[pos + 1] = right;
+}
+
+/** Merge a child with its right sibling and their separating element. */
+static void
+sc_btree_merge_children (sc_btree_t * btree, sc_btree_node_t * node,
+                         int pos)
+{
+  sc_btree_node_t    *left = node->children[pos];
+  sc_btree_node_t    *right = node->children[pos + 1];
+
+  SC_ASSERT (left->count + right->count < btree->max_count);
+
+  memcpy (SC_BTREE_ELEM (btree, left, left->count),
+          SC_BTREE_ELEM (btree, node, pos), btree->elem_size);
+  memcpy (SC_BTREE_ELEM (btree, left, left->count + 1), right->elems,
+          (size_t) right->count * btree->elem_size);
+  if (!left->leaf) {
+    memcpy (left->children + left->count + 1, right->children,
+            (size_t) (right->count + 1) * sizeof (sc_btree_node_t *));
+  }
+  left->count += right->count + 1;
+  sc_btree_node_destroy (btree, right);
+
+  sc_btree_node_shift (btree, node, pos + 1, -1);
+}
+
+/** Make sure that a child has more than the minimum number of elements.
+ * \return      The position of the child that covers the same range.
+ */
+static int
+sc_btree_fill_child (sc_btree_t * btree, sc_btree_node_t * node, int pos)
+{
+  const int           t = btree->min_count;
+  sc_btree_node_t    *child = node->children[pos];
+  sc_btree_node_t    *sibling;
+
+  if (pos > 0 && (sibling = node->children[pos - 1])->count >= t) {
+    /* rotate the last element of the left sibling through the parent */
+    memmove (SC_BTREE_ELEM (btree, child, 1), child->elems,
+             (size_t) child->count * btree->elem_size);
+    memcpy (child->elems, SC_BTREE_ELEM (btree, node, pos - 1),
+            btree->elem_size);
+    if (!child->leaf) {
+      memmove (child->children + 1, child->children,
+               (size_t) (child->count + 1) * sizeof (sc_btree_node_t *));
+      child->children[0] = sibling->children[sibling->count];
+    }
+    ++child->count;
+    memcpy (SC_BTREE_ELEM (btree, node, pos - 1),
+            SC_BTREE_ELEM (btree, sibling, sibling->count - 1),
+            btree->elem_size);
+    --sibling->count;
+    return pos;
+  }
+  if (pos < node->count && (sibling = node->children[pos + 1])->count >= t) {
+    /* rotate the first element of the right sibling through the parent */
+    memcpy (SC_BTREE_ELEM (btree, child, child->count),
+            SC_BTREE_ELEM (btree, node, pos), btree->elem_size);
+    if (!child->leaf) {
+      child->children[child->count + 1] = sibling->children[0];
+    }
+    ++child->count;
+    memcpy (SC_BTREE_ELEM (btree, node, pos), sibling->elems,
+            btree->elem_size);
+    memmove (sibling->elems, SC_BTREE_ELEM (btree, sibling, 1),
+             (size_t) (sibling->count - 1) * btree->elem_size);
+    if (!sibling->leaf) {
+      memmove (sibling->children, sibling->children + 1,
+               (size_t) sibling->count * sizeof (sc_btree_node_t *));
+    }
+    --sibling->count;
+    return pos;
+  }
+
+  /* both siblings are minimal and we merge with one of them */
+  if (pos == node->count) {
+    --pos;
+  }
+  sc_btree_merge_children (btree, node, pos);
+  return pos;
+}
+
+/** Remove an element from a subtree whose root is not minimal.
+ * The root of the whole tree may have less elements and become empty.
+ */
+static int
+sc_btree_remove_node (sc_btree_t * btree, sc_btree_node_t * node,
+                      const void *elem, void *found)
+{
+  const int           t = btree->min_count;
+  int                 pos, equal;
+  sc_btree_node_t    *child;
+
+  for (;;) {
+    pos = sc_btree_node_find (btree, node, elem, &equal);
+    if (equal && found != NULL) {
+      memcpy (found, SC_BTREE_ELEM (btree, node, pos), btree->elem_size);
+      found = NULL;
+    }
+    if (node->leaf) {
+      if (!equal) {
+        return 0;
+      }
+      sc_btree_node_shift (btree, node, pos + 1, -1);
+      return 1;
+    }
+    if (equal) {
+      if (node->children[pos]->count >= t) {
+        /* replace the element by its predecessor */
+        for (child = node->children[pos]; !child->leaf;
+             child = child->children[child->count]);
+        memcpy (btree->scratch,
+                SC_BTREE_ELEM (btree, child, child->count - 1),
+                btree->elem_size);
+        sc_btree_remove_node (btree, node->children[pos], btree->scratch,
+                              NULL);
+        memcpy (SC_BTREE_ELEM (btree, node, pos), btree->scratch,
+                btree->elem_size);
+        return 1;
+      }
+      if (node->children[pos + 1]->count >= t) {
+        /* replace the element by its successor */
+        for (child = node->children[pos + 1]; !child->leaf;
+             child = child->children[0]);
+        memcpy (btree->scratch, child->elems, btree->elem_size);
+        sc_btree_remove_node (btree, node->children[pos + 1],
+                              btree->scratch, NULL);
+        memcpy (SC_BTREE_ELEM (btree, node, pos), btree->scratch,
+                btree->elem_size);
+        return 1;
+      }
+      /* the element moves down into the merged child */
+      sc_btree_merge_children (btree, node, pos);
+      node = node->children[pos];
+      continue;
+    }
+    if (node->children[pos]->count < t) {
+      pos = sc_btree_fill_child (btree, node, pos);
+    }
+    node = node->children[pos];
+  }
+}
+
+static void
+sc_btree_node_to_array (sc_btree_t * btree, sc_btree_node_t * node,
+                        char **dest)
+{
+  int                 i;
+
+  if (node->leaf) {
+    memcpy (*dest, node->elems, (size_t) node->count * btree->elem_size);
+    *dest += (size_t) node->count * btree->elem_size;
+    return;
+  }
+  for (i = 0; i < node->count; ++i) {
+    sc_btree_node_to_array (btree, node->children[i], dest);
+    memcpy (*dest, SC_BTREE_ELEM (btree, node, i), btree->elem_size);
+    *dest += btree->elem_size;
+  }
+  sc_btree_node_to_array (btree, node->children[node->count], dest);
+}
+
+sc_btree_t         *
+sc_btree_new (size_t elem_size, int (*compar) (const void *, const void *))
+{
+  sc_btree_t         *btree;
+  int                 t;
+
+  SC_ASSERT (elem_size > 0);
+
+  t = (int) SC_MAX (2, (SC_BTREE_NODE_BYTES / elem_size + 1) / 2);
+  btree = SC_ALLOC (sc_btree_t, 1);
+  btree->elem_size = elem_size;
+  btree->compar = compar;
+  btree->min_count = t;
+  btree->max_count = 2 * t - 1;
+  btree->elem_count = 0;
+  btree->root = NULL;
+  btree->scratch = SC_ALLOC (char, elem_size);
+  btree->leaves = sc_mempool_new
+    (SC_BTREE_ALIGN (sizeof (sc_btree_node_t) +
+                     (size_t) btree->max_count * elem_size));
+  btree->inner = sc_mempool_new
+    (SC_BTREE_ALIGN (sizeof (sc_btree_node_t) +
+                     (size_t) btree->max_count * elem_size +
+                     (size_t) (btree->max_count + 1) *
+                     sizeof (sc_btree_node_t *)));
+
+  return btree;
+}
+
+void
+sc_btree_destroy (sc_btree_t * btree)
+{
+  sc_mempool_destroy (btree->leaves);
+  sc_mempool_destroy (btree->inner);
+  SC_FREE (btree->scratch);
+  SC_FREE (btree);
+}
+
+void
+sc_btree_truncate (sc_btree_t * btree)
+{
+  sc_mempool_truncate (btree->leaves);
+  sc_mempool_truncate (btree->inner);
+  btree->root = NULL;
+  btree->elem_count = 0;
+}
+
+size_t
+sc_btree_count (sc_btree_t * btree)
+{
+  return btree->elem_count;
+}
+
+size_t
+sc_btree_memory_used (sc_btree_t * btree)
+{
+  return sizeof (sc_btree_t) + btree->elem_size +
+    sc_mempool_memory_used (btree->leaves) +
+    sc_mempool_memory_used (btree->inner);
+}
+
+int
+sc_btree_insert (sc_btree_t * btree, const void *elem)
+{
+  int                 pos, equal, c;
+  sc_btree_node_t    *node;
+
+  if (btree->root == NULL) {
+    btree->root = sc_btree_node_new (btree, 1);
+  }
+  else if (btree->root->count == btree->max_count) {
+    /* the tree grows at the root */
+    node = sc_btree_node_new (btree, 0);
+    node->children[0] = btree->root;
+    sc_btree_split_child (btree, node, 0);
+    btree->root = node;
+  }
+
+  /* split full nodes on the way down so the parent always has room */
+  node = btree->root;
+  for (;;) {
+    pos = sc_btree_node_find (btree, node, elem, &equal);
+    if (equal) {
+      return 0;
+    }
+    if (node->leaf) {
+      break;
+    }
+    if (node->children[pos]->count == btree->max_count) {
+      sc_btree_split_child (btree, node, pos);
+      c = btree->compar (elem, SC_BTREE_ELEM (btree, node, pos));
+      if (c == 0) {
+        return 0;
+      }
+      if (c > 0) {
+        ++pos;
+      }
+    }
+    node = node->children[pos];
+  }
+
+  memmove (SC_BTREE_ELEM (btree, node, pos + 1),
+           SC_BTREE_ELEM (btree, node, pos),
+           (size_t) (node->count - pos) * btree->elem_size);
+  memcpy (SC_BTREE_ELEM (btree, node, pos), elem, btree->elem_size);
+  ++node->count;
+  ++btree->elem_count;
+
+  return 1;
+}
+
+int
+sc_btree_remove (sc_btree_t * btree, const void *elem, void *found)
+{
+  int                 removed;
+  sc_btree_node_t    *root = btree->root;
+
+  if (root == NULL) {
+    return 0;
+  }
+  removed = sc_btree_remove_node (btree, root, elem, found);
+  if (root->count == 0) {
+    /* the tree shrinks at the root */
+    btree->root = root->leaf ? NULL : root->children[0];
+    sc_btree_node_destroy (btree, root);
+  }
+  if (removed) {
+    --btree->elem_count;
+  }
+
+  return removed;
+}
+
+void               *
+sc_btree_search (sc_btree_t * btree, const void *elem)
+{
+  void               *found;
+
+  return sc_btree_search_closest (btree, elem, &found) || found == NULL ?
+    NULL : found;
+}
+
+int
+sc_btree_search_closest (sc_btree_t * btree, const void *elem, void **found)
+{
+  int                 pos, equal;
+  char               *succ = NULL, *pred = NULL;
+  sc_btree_node_t    *node;
+
+  for (node = btree->root; node != NULL;
+       node = node->leaf ? NULL : node->children[pos]) {
+    pos = sc_btree_node_find (btree, node, elem, &equal);
+    if (equal) {
+      if (found != NULL) {
+        *found = SC_BTREE_ELEM (btree, node, pos);
+      }
+      return 0;
+    }
+
+    /* lower levels hold elements closer to the target */
+    if (pos < node->count) {
+      succ = SC_BTREE_ELEM (btree, node, pos);
+    }
+    if (pos > 0) {
+      pred = SC_BTREE_ELEM (btree, node, pos - 1);
+    }
+  }
+  if (found != NULL) {
+    *found = succ != NULL ? succ : pred;
+  }
+
+  return succ != NULL ? -1 : pred != NULL ? 1 : 0;
+}
+
+void
+sc_btree_to_array (sc_btree_t * btree, sc_array_t * array)
+{
+  char               *dest;
+
+  SC_ASSERT (array->elem_size == btree->elem_size);
+
+  sc_array_resize (array, btree->elem_count);
+  if (btree->root != NULL) {
+    dest = array->array;
+    sc_btree_node_to_array (btree, btree->root, &dest);
+    SC_ASSERT (dest == array->array + btree->elem_count * btree->elem_size);
+  }
+}
@@ -0,0 +1,111 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_BTREE_H
+#define SC_BTREE_H
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** An ordered set of fixed-size elements stored by value in a B-tree.
+ * Every node stores a sorted run of elements of up to a few hundred bytes,
+ * which makes searches and scans cache friendly and adds only one child
+ * pointer per element in the inner nodes.  Compared to \ref avl_tree_t,
+ * which spends five pointers and a count on every item, the memory per
+ * element is close to the element size.  Nodes are taken from two
+ * \ref sc_mempool_t, one for leaves and one for inner nodes.
+ * Pointers to elements become invalid on any modification of the tree.
+ */
+typedef struct sc_btree sc_btree_t;
+
+/** Create a new empty B-tree.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] compar       Comparison function that defines the order.
+ *                          Elements that compare equal are identical.
+ * \return                  A valid and empty tree.
+ */
+sc_btree_t         *sc_btree_new (size_t elem_size,
+                                  int (*compar) (const void *,
+                                                 const void *));
+
+/** Destroy a B-tree and all of its elements.
+ * \param [in,out] btree    The tree is invalid after this call.
+ */
+void                sc_btree_destroy (sc_btree_t * btree);
+
+/** Remove all elements from a B-tree. */
+void                sc_btree_truncate (sc_btree_t * btree);
+
+/** Return the number of elements in a B-tree. */
+size_t              sc_btree_count (sc_btree_t * btree);
+
+/** Calculate the memory used by a B-tree. */
+size_t              sc_btree_memory_used (sc_btree_t * btree);
+
+/** Insert a copy of an element into a B-tree.
+ * \param [in] elem     The element to copy of size elem_size.
+ * \return              True if inserted, false if an equal element
+ *                      is already in the tree, which is not changed.
+ */
+int                 sc_btree_insert (sc_btree_t * btree, const void *elem);
+
+/** Remove an element from a B-tree.
+ * \param [in] elem     An element to compare with.
+ * \param [out] found   If not NULL and the element is found, the removed
+ *                      element is copied here.
+ * \return              True if an equal element was found and removed.
+ */
+int                 sc_btree_remove (sc_btree_t * btree, const void *elem,
+                                     void *found);
+
+/** Search for an element in a B-tree.
+ * \param [in] elem     An element to compare with.
+ * \return              Pointer to the equal element in the tree or NULL.
+ */
+void               *sc_btree_search (sc_btree_t * btree, const void *elem);
+
+/** Search for the element equal or closest to a given one.
+ * If there is no equal element, the smallest greater element is found,
+ * or the greatest element if no element is greater.
+ * \param [in] elem     An element to compare with.
+ * \param [out] found   If not NULL, set to the element found in the tree,
+ *                      or to NULL if the tree is empty.
+ * \return              The comparison of elem with the element found, which
+ *                      is -1 if elem is smaller, 1 if elem is greater and
+ *                      0 if it is equal or the tree is empty.
+ */
+int                 sc_btree_search_closest (sc_btree_t * btree,
+                                             const void *elem,
+                                             void **found);
+
+/** Copy all elements of a B-tree into an array in ascending order.
+ * \param [in,out] array    Array of element size elem_size, resized to
+ *                          the number of elements in the tree.
+ */
+void                sc_btree_to_array (sc_btree_t * btree,
+                                       sc_array_t * array);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_BTREE_H */
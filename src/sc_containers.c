@@ -22,9 +22,85 @@
 */
 
 #include <sc_containers.h>
+#include <sc_uint128.h>
+#include <sc_bitset.h>
+#include <sc_io.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef SC_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* locking routines for the thread-safe containers */
+
+#ifdef SC_ENABLE_PTHREAD
+typedef pthread_mutex_t sc_containers_lock_t;
+#elif defined SC_ENABLE_OPENMP
+typedef omp_lock_t  sc_containers_lock_t;
+#else
+typedef int         sc_containers_lock_t;       /* no threads, no locking */
+#endif
+
+static void
+sc_containers_lock_init (sc_containers_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_init (lock, NULL);
+  SC_CHECK_ABORT (pth == 0, "sc_containers_lock_init");
+#elif defined SC_ENABLE_OPENMP
+  omp_init_lock (lock);
+#else
+  *lock = 0;
+#endif
+}
+
+static void
+sc_containers_lock_destroy (sc_containers_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_destroy (lock);
+  SC_CHECK_ABORT (pth == 0, "sc_containers_lock_destroy");
+#elif defined SC_ENABLE_OPENMP
+  omp_destroy_lock (lock);
+#endif
+}
+
+static void
+sc_containers_lock (sc_containers_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_lock (lock);
+  SC_CHECK_ABORT (pth == 0, "sc_containers_lock");
+#elif defined SC_ENABLE_OPENMP
+  omp_set_lock (lock);
+#endif
+}
+
+static void
+sc_containers_unlock (sc_containers_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_unlock (lock);
+  SC_CHECK_ABORT (pth == 0, "sc_containers_unlock");
+#elif defined SC_ENABLE_OPENMP
+  omp_unset_lock (lock);
+#endif
+}
 
 /* array routines */
 
@@ -32,7 +108,8 @@ size_t
 sc_array_memory_used (sc_array_t * array, int is_dynamic)
 {
   return (is_dynamic ? sizeof (sc_array_t) : 0) +
-    (SC_ARRAY_IS_OWNER (array) ? array->byte_alloc : 0);
+    (SC_ARRAY_IS_OWNER (array) && !SC_ARRAY_IS_INLINE (array) ?
+     array->byte_alloc : 0);
 }
 
 sc_array_t         *
@@ -83,11 +160,23 @@ sc_array_new_data (void *base, size_t elem_size, size_t elem_count)
   return view;
 }
 
+sc_array_t         *
+sc_array_new_domain (size_t elem_size, sc_memory_domain_t domain)
+{
+  sc_array_t         *array;
+
+  array = SC_ALLOC (sc_array_t, 1);
+
+  sc_array_init_domain (array, elem_size, domain);
+
+  return array;
+}
+
 void
 sc_array_destroy (sc_array_t * array)
 {
-  if (SC_ARRAY_IS_OWNER (array)) {
-    SC_FREE (array->array);
+  if (SC_ARRAY_IS_OWNER (array) && !SC_ARRAY_IS_INLINE (array)) {
+    sc_free_domain (sc_package_id, array->domain, array->array);
   }
   SC_FREE (array);
 }
@@ -111,6 +200,17 @@ sc_array_init (sc_array_t * array, size_t elem_size)
   array->elem_count = 0;
   array->byte_alloc = 0;
   array->array = NULL;
+  array->domain = SC_MEMORY_HOST;
+  array->growth = SC_ARRAY_GROWTH_DEFAULT;
+  array->is_inline = 0;
+}
+
+void
+sc_array_init_domain (sc_array_t * array, size_t elem_size,
+                      sc_memory_domain_t domain)
+{
+  sc_array_init (array, elem_size);
+  array->domain = domain;
 }
 
 void
@@ -128,6 +228,9 @@ sc_array_init_count (sc_array_t * array, size_t elem_size, size_t elem_count)
   array->elem_count = elem_count;
   array->byte_alloc = (ssize_t) (elem_size * elem_count);
   array->array = SC_ALLOC (char, (size_t) array->byte_alloc);
+  array->domain = SC_MEMORY_HOST;
+  array->growth = SC_ARRAY_GROWTH_DEFAULT;
+  array->is_inline = 0;
 }
 
 void
@@ -140,6 +243,9 @@ sc_array_init_view (sc_array_t * view, sc_array_t * array, size_t offset,
   view->elem_count = length;
   view->byte_alloc = -(ssize_t) (length * array->elem_size + 1);
   view->array = array->array + offset * array->elem_size;
+  view->domain = array->domain;
+  view->growth = array->growth;
+  view->is_inline = 0;
 }
 
 void
@@ -152,6 +258,28 @@ sc_array_init_data (sc_array_t * view, void *base, size_t elem_size,
   view->elem_count = elem_count;
   view->byte_alloc = -(ssize_t) (elem_count * elem_size + 1);
   view->array = (char *) base;
+  view->domain = SC_MEMORY_HOST;
+  view->growth = SC_ARRAY_GROWTH_DEFAULT;
+  view->is_inline = 0;
+}
+
+void
+sc_array_init_inline (sc_array_inline_t * ai, size_t elem_size)
+{
+  SC_ASSERT (elem_size > 0);
+
+  ai->a.elem_size = elem_size;
+  ai->a.elem_count = 0;
+  ai->a.byte_alloc = (ssize_t) SC_ARRAY_INLINE_BYTES;
+  ai->a.array = ai->buf.bytes;
+  ai->a.domain = SC_MEMORY_HOST;
+  ai->a.growth = SC_ARRAY_GROWTH_DEFAULT;
+  ai->a.is_inline = 1;
+  SC_ASSERT (SC_ARRAY_IS_INLINE (&ai->a));
+
+#ifdef SC_ENABLE_DEBUG
+  memset (ai->a.array, (char) -1, SC_ARRAY_INLINE_BYTES);
+#endif
 }
 
 void
@@ -163,10 +291,11 @@ sc_array_memset (sc_array_t * array, int c)
 void
 sc_array_reset (sc_array_t * array)
 {
-  if (SC_ARRAY_IS_OWNER (array)) {
-    SC_FREE (array->array);
+  if (SC_ARRAY_IS_OWNER (array) && !SC_ARRAY_IS_INLINE (array)) {
+    sc_free_domain (sc_package_id, array->domain, array->array);
   }
   array->array = NULL;
+  array->is_inline = 0;
 
   array->elem_count = 0;
   array->byte_alloc = 0;
@@ -181,7 +310,9 @@ sc_array_truncate (sc_array_t * array)
 
 #if SC_ENABLE_DEBUG
   SC_ASSERT (array->byte_alloc >= 0);
-  memset (array->array, (char) -1, array->byte_alloc);
+  if (sc_memory_domain_is_host (array->domain)) {
+    memset (array->array, (char) -1, array->byte_alloc);
+  }
 #endif
 }
 
@@ -199,16 +330,91 @@ sc_array_rewind (sc_array_t * array, size_t new_count)
   }
 }
 
-void
-sc_array_resize (sc_array_t * array, size_t new_count)
+/** Arrays of at least this size do not double their memory on growth. */
+static const size_t sc_array_large_bytes = (size_t) 1 << 25;
+
+/** Large arrays allocate their memory in multiples of this size. */
+static const size_t sc_array_page_bytes = (size_t) 1 << 21;
+
+/** Return the allocation size to hold a given number of bytes. */
+static size_t
+sc_array_capacity (sc_array_growth_t growth, size_t newoffs)
+{
+  size_t              target;
+
+  if (growth == SC_ARRAY_GROWTH_EXACT) {
+    return newoffs;
+  }
+  if (growth == SC_ARRAY_GROWTH_DOUBLE ||
+      (growth == SC_ARRAY_GROWTH_DEFAULT && newoffs < sc_array_large_bytes)) {
+    target = (size_t) SC_ROUNDUP2_64 (newoffs);
+    SC_ASSERT (target >= newoffs && target <= 2 * newoffs);
+    return target;
+  }
+
+  /* grow large arrays by a quarter, in whole pages */
+  target = newoffs + newoffs / 4;
+  return ((target + sc_array_page_bytes - 1) / sc_array_page_bytes) *
+    sc_array_page_bytes;
+}
+
+/** Change the memory allocation of an array that owns its elements.
+ * \param [in,out] array    The array is not a view.
+ * \param [in] keep         Number of leading bytes to preserve.
+ * \param [in] newsize      New allocation size, positive and >= keep.
+ */
+static void
+sc_array_set_alloc (sc_array_t * array, size_t keep, size_t newsize)
 {
-  size_t              newoffs, roundup, newsize;
-#if !defined SC_ENABLE_USE_REALLOC || defined SC_ENABLE_DEBUG
-  size_t              oldoffs, minoffs;
-#endif
-#ifndef SC_ENABLE_USE_REALLOC
   char               *ptr;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (0 < newsize && keep <= newsize);
+  SC_ASSERT (keep <= (size_t) array->byte_alloc);
+
+  if (array->domain != SC_MEMORY_HOST) {
+    /* device runtimes have no realloc */
+    ptr = (char *) sc_malloc_domain (sc_package_id, array->domain, newsize);
+    sc_memcpy_domain (ptr, array->domain, array->array, array->domain,
+                      keep);
+    sc_free_domain (sc_package_id, array->domain, array->array);
+  }
+  else if (SC_ARRAY_IS_INLINE (array)) {
+    /* move the elements to the heap once and for all */
+    ptr = SC_ALLOC (char, newsize);
+    if (keep > 0) {
+      memcpy (ptr, array->array, keep);
+    }
+  }
+#ifndef SC_ENABLE_USE_REALLOC
+  else if (newsize < sc_array_large_bytes) {
+    ptr = SC_ALLOC (char, newsize);
+    if (keep > 0) {
+      /* avoid calling memcpy on less well supported corner cases */
+      memcpy (ptr, array->array, keep);
+    }
+    SC_FREE (array->array);
+  }
+#endif
+  else {
+    /* for large arrays, the C library may remap pages instead of copying */
+    ptr = SC_REALLOC (array->array, char, newsize);
+  }
+  array->array = ptr;
+  array->byte_alloc = (ssize_t) newsize;
+  array->is_inline = 0;
+
+#ifdef SC_ENABLE_DEBUG
+  if (sc_memory_domain_is_host (array->domain)) {
+    memset (array->array + keep, (char) -1, newsize - keep);
+  }
 #endif
+}
+
+void
+sc_array_resize (sc_array_t * array, size_t new_count)
+{
+  size_t              newoffs, oldoffs;
 #ifdef SC_ENABLE_DEBUG
   size_t              i;
 #endif
@@ -222,29 +428,29 @@ sc_array_resize (sc_array_t * array, size_t new_count)
     return;
   }
 
+  /* Figure out how the array size will change */
+  newoffs = new_count * array->elem_size;
+  oldoffs = array->elem_count * array->elem_size;
+  if (SC_ARRAY_IS_INLINE (array) && newoffs <= (size_t) array->byte_alloc) {
+    /* the elements stay in the inline storage */
+    array->elem_count = new_count;
+    return;
+  }
+
   /* We know that this array is not a view now so we can call reset. */
   if (new_count == 0) {
     sc_array_reset (array);
     return;
   }
-
-  /* Figure out how the array size will change */
-  newoffs = new_count * array->elem_size;
-#if defined SC_ENABLE_DEBUG || !defined SC_ENABLE_USE_REALLOC
-  oldoffs = array->elem_count * array->elem_size;
-  minoffs = SC_MIN (oldoffs, newoffs);
-#endif
   array->elem_count = new_count;
-  roundup = (size_t) SC_ROUNDUP2_64 (newoffs);
-  SC_ASSERT (roundup >= newoffs && roundup <= 2 * newoffs);
 
-  if (newoffs > (size_t) array->byte_alloc ||
-      roundup < (size_t) array->byte_alloc) {
-    /* we will reallocate the array memory, either grow or shrink it */
-    array->byte_alloc = (ssize_t) roundup;
-  }
-  else {
+  /* we keep the allocation unless we outgrow it or use half or less */
+  if (newoffs <= (size_t) array->byte_alloc &&
+      2 * newoffs > (size_t) array->byte_alloc) {
 #ifdef SC_ENABLE_DEBUG
+    if (!sc_memory_domain_is_host (array->domain)) {
+      return;
+    }
     if (newoffs < oldoffs) {
       memset (array->array + newoffs, (char) -1, oldoffs - newoffs);
     }
@@ -252,30 +458,56 @@ sc_array_resize (sc_array_t * array, size_t new_count)
       SC_ASSERT (array->array[i] == (char) -1);
     }
 #endif
-    /* we keep the current allocation */
     return;
   }
 
-  /* byte_alloc is the size to be realloced to, it may be smaller than oldoffs */
-  SC_ASSERT ((size_t) array->byte_alloc >= newoffs);
+  /* we will reallocate the array memory, either grow or shrink it */
+  sc_array_set_alloc (array, SC_MIN (oldoffs, newoffs),
+                      sc_array_capacity (array->growth, newoffs));
+}
 
-  newsize = (size_t) array->byte_alloc;
-#ifdef SC_ENABLE_USE_REALLOC
-  array->array = SC_REALLOC (array->array, char, newsize);
-#else
-  ptr = SC_ALLOC (char, newsize);
-  if (minoffs > 0) {
-    /* avoid calling memcpy on less well supported corner cases */
-    memcpy (ptr, array->array, minoffs);
+void
+sc_array_reserve (sc_array_t * array, size_t elem_count)
+{
+  size_t              newoffs;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  newoffs = elem_count * array->elem_size;
+  if (newoffs > (size_t) array->byte_alloc) {
+    sc_array_set_alloc (array, array->elem_count * array->elem_size,
+                        newoffs);
   }
-  SC_FREE (array->array);
-  array->array = ptr;
-#endif
+}
 
-#ifdef SC_ENABLE_DEBUG
-  SC_ASSERT (minoffs <= newsize);
-  memset (array->array + minoffs, (char) -1, newsize - minoffs);
-#endif
+void
+sc_array_set_growth (sc_array_t * array, sc_array_growth_t growth)
+{
+  SC_ASSERT (array != NULL);
+  SC_ASSERT (SC_ARRAY_GROWTH_DEFAULT <= growth &&
+             growth <= SC_ARRAY_GROWTH_EXACT);
+
+  array->growth = growth;
+}
+
+void
+sc_array_shrink_to_fit (sc_array_t * array)
+{
+  size_t              newoffs;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (SC_ARRAY_IS_INLINE (array)) {
+    /* the inline storage costs nothing extra */
+    return;
+  }
+  newoffs = array->elem_count * array->elem_size;
+  if (newoffs == 0) {
+    sc_array_reset (array);
+  }
+  else if (newoffs < (size_t) array->byte_alloc) {
+    sc_array_set_alloc (array, newoffs, newoffs);
+  }
 }
 
 void
@@ -291,7 +523,8 @@ sc_array_copy (sc_array_t * dest, sc_array_t * src)
     /* avoid calling memcpy on less well supported corner cases */
     return;
   }
-  memcpy (dest->array, src->array, src->elem_count * src->elem_size);
+  sc_memcpy_domain (dest->array, dest->domain, src->array, src->domain,
+                    src->elem_count * src->elem_size);
 }
 
 void
@@ -324,12 +557,154 @@ sc_array_move_part (sc_array_t * dest, size_t dest_offset,
            src->array + src_offset * src->elem_size, count * src->elem_size);
 }
 
+#ifdef SC_ENABLE_OPENMP
+
+/** Below this amount of work, the sc_array functions do not use threads. */
+#define SC_ARRAY_PARALLEL_WORK ((size_t) 1 << 14)
+
+/** Return the number of threads to use for some amount of work.
+ * Inside a parallel region we stay serial to avoid nested parallelism.
+ */
+static int
+sc_array_num_threads (size_t work)
+{
+  int                 num_threads;
+
+  if (work < SC_ARRAY_PARALLEL_WORK || omp_in_parallel ()) {
+    return 1;
+  }
+  num_threads = omp_get_max_threads ();
+  return SC_MAX (num_threads, 1);
+}
+
+/** Return the first index of block number t out of num_blocks. */
+static inline size_t
+sc_array_block_begin (size_t count, int num_blocks, int t)
+{
+  const size_t        q = count / (size_t) num_blocks;
+  const size_t        r = count % (size_t) num_blocks;
+
+  return q * (size_t) t + SC_MIN ((size_t) t, r);
+}
+
+/** Copy memory from src to dest with several threads. */
+static void
+sc_array_copy_parallel (char *dest, const char *src, size_t bytes,
+                        int num_threads)
+{
+  int                 t;
+
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (t = 0; t < num_threads; ++t) {
+    const size_t        b = sc_array_block_begin (bytes, num_threads, t);
+
+    memcpy (dest + b,
+            src + b, sc_array_block_begin (bytes, num_threads, t + 1) - b);
+  }
+}
+
+/** Stable merge of two consecutive sorted ranges from src into dest. */
+static void
+sc_array_merge_runs (char *dest, const char *src, size_t size,
+                     size_t lo, size_t mid, size_t hi,
+                     int (*compar) (const void *, const void *))
+{
+  size_t              i = lo, j = mid;
+  char               *d = dest + lo * size;
+
+  if (lo < mid && mid < hi) {
+    for (;;) {
+      if (compar (src + j * size, src + i * size) < 0) {
+        memcpy (d, src + j * size, size);
+        d += size;
+        if (++j == hi) {
+          break;
+        }
+      }
+      else {
+        memcpy (d, src + i * size, size);
+        d += size;
+        if (++i == mid) {
+          break;
+        }
+      }
+    }
+  }
+  memcpy (d, src + i * size, (mid - i) * size);
+  d += (mid - i) * size;
+  memcpy (d, src + j * size, (hi - j) * size);
+}
+
+/** Sort blocks of the array in parallel and merge them pairwise. */
+static void
+sc_array_sort_blocks (sc_array_t * array, int num_threads,
+                      int (*compar) (const void *, const void *))
+{
+  const size_t        n = array->elem_count;
+  const size_t        size = array->elem_size;
+  int                 t, width;
+  size_t             *bounds;
+  char               *src, *dst, *tmp;
+
+  bounds = SC_ALLOC (size_t, num_threads + 1);
+  for (t = 0; t <= num_threads; ++t) {
+    bounds[t] = sc_array_block_begin (n, num_threads, t);
+  }
+
+  src = array->array;
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (t = 0; t < num_threads; ++t) {
+    qsort (src + bounds[t] * size, bounds[t + 1] - bounds[t], size, compar);
+  }
+
+  dst = SC_ALLOC (char, n * size);
+  for (width = 1; width < num_threads; width *= 2) {
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+    for (t = 0; t < num_threads; t += 2 * width) {
+      sc_array_merge_runs (dst, src, size, bounds[t],
+                           bounds[SC_MIN (t + width, num_threads)],
+                           bounds[SC_MIN (t + 2 * width, num_threads)],
+                           compar);
+    }
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  /* the result may reside in the temporary buffer */
+  if (src != array->array) {
+    sc_array_copy_parallel (array->array, src, n * size, num_threads);
+    SC_FREE (src);
+  }
+  else {
+    SC_FREE (dst);
+  }
+  SC_FREE (bounds);
+}
+
+#endif /* SC_ENABLE_OPENMP */
+
 void
 sc_array_sort (sc_array_t * array, int (*compar) (const void *, const void *))
 {
   qsort (array->array, array->elem_count, array->elem_size, compar);
 }
 
+void
+sc_array_sort_parallel (sc_array_t * array,
+                        int (*compar) (const void *, const void *))
+{
+#ifdef SC_ENABLE_OPENMP
+  const int           num_threads = sc_array_num_threads (array->elem_count);
+
+  if (num_threads > 1) {
+    sc_array_sort_blocks (array, num_threads, compar);
+    return;
+  }
+#endif
+  sc_array_sort (array, compar);
+}
+
 int
 sc_array_is_sorted (sc_array_t * array,
                     int (*compar) (const void *, const void *))
@@ -404,39 +779,538 @@ sc_array_uniq (sc_array_t * array, int (*compar) (const void *, const void *))
   sc_array_resize (array, j);
 }
 
-ssize_t
-sc_array_bsearch (sc_array_t * array, const void *key,
-                  int (*compar) (const void *, const void *))
+/** A slot of the table of \ref sc_array_uniq_hashed. */
+typedef struct sc_array_uniq_slot
 {
-  ssize_t             is = -1;
-  char               *retval;
+  size_t              position; /**< kept index plus one, zero if empty */
+  size_t              hash;     /**< hash value of the kept element */
+}
+sc_array_uniq_slot_t;
 
-  retval = (char *)
-    bsearch (key, array->array, array->elem_count, array->elem_size, compar);
+/** Remove duplicates through an open addressing table of kept indices. */
+static void
+sc_array_uniq_hashed (sc_array_t * array, sc_hash_function_t hash_fn,
+                      sc_equal_function_t equal_fn, void *user,
+                      int keep_order, sc_array_t * map, sc_array_t * counts)
+{
+  const size_t        size = array->elem_size;
+  size_t              incount, count, i, j, k, h, mask, alloc;
+  size_t             *origin = NULL;
+  char               *elem, *kept;
+  sc_array_uniq_slot_t *table, *slot;
 
-  if (retval != NULL) {
-    is = (ssize_t) ((retval - array->array) / array->elem_size);
-    SC_ASSERT (is >= 0 && is < (ssize_t) array->elem_count);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (map == NULL || map->elem_size == sizeof (size_t));
+  SC_ASSERT (counts == NULL || counts->elem_size == sizeof (size_t));
+  SC_ASSERT (counts == NULL || keep_order);
+
+  incount = array->elem_count;
+  if (map != NULL) {
+    sc_array_resize (map, incount);
+  }
+  if (counts != NULL) {
+    sc_array_reset (counts);
+  }
+  if (incount == 0) {
+    return;
   }
 
-  return is;
+  /* a power of two with a load factor of at most one half */
+  for (alloc = 16; alloc < 2 * incount; alloc *= 2);
+  mask = alloc - 1;
+  table = SC_ALLOC_ZERO (sc_array_uniq_slot_t, alloc);
+  if (!keep_order && map != NULL) {
+    /* remember where the elements moved by the swaps came from */
+    origin = SC_ALLOC (size_t, incount);
+    for (i = 0; i < incount; ++i) {
+      origin[i] = i;
+    }
+  }
+
+  /* i is the read position, j the number of kept elements */
+  count = incount;
+  for (i = 0, j = 0; i < count;) {
+    elem = array->array + size * i;
+    h = hash_fn != NULL ? (size_t) hash_fn (elem, user) :
+      (size_t) sc_hash_bytes (elem, size, 0);
+    for (k = (h * 0x9E3779B97F4A7C15ULL) >> 16 & mask;; k = (k + 1) & mask) {
+      slot = table + k;
+      if (slot->position == 0) {
+        break;
+      }
+      kept = array->array + size * (slot->position - 1);
+      if (slot->hash == h && (equal_fn != NULL ? equal_fn (kept, elem, user)
+                              : !memcmp (kept, elem, size))) {
+        break;
+      }
+    }
+
+    if (slot->position != 0) {
+      /* a duplicate of the element kept at slot->position - 1 */
+      if (map != NULL) {
+        *(size_t *) sc_array_index (map, origin != NULL ? origin[i] : i) =
+          slot->position - 1;
+      }
+      if (counts != NULL) {
+        ++*(size_t *) sc_array_index (counts, slot->position - 1);
+      }
+      if (keep_order) {
+        ++i;
+      }
+      else {
+        /* fill the hole with the last element and read it next */
+        if (i < --count) {
+          memcpy (elem, array->array + size * count, size);
+          if (origin != NULL) {
+            origin[i] = origin[count];
+          }
+        }
+      }
+      continue;
+    }
+
+    /* keep the element at position j */
+    if (i > j) {
+      memcpy (array->array + size * j, elem, size);
+    }
+    slot->position = j + 1;
+    slot->hash = h;
+    if (map != NULL) {
+      *(size_t *) sc_array_index (map, origin != NULL ? origin[i] : i) = j;
+    }
+    if (counts != NULL) {
+      *(size_t *) sc_array_push (counts) = 1;
+    }
+    ++i;
+    ++j;
+  }
+  SC_ASSERT (keep_order || i == j);
+
+  SC_FREE (origin);
+  SC_FREE (table);
+  sc_array_resize (array, j);
 }
 
 void
-sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
-                sc_array_type_t type_fn, void *data)
+sc_array_uniq_unsorted (sc_array_t * array, sc_hash_function_t hash_fn,
+                        sc_equal_function_t equal_fn, void *user,
+                        int keep_order, sc_array_t * map)
 {
-  const size_t        count = array->elem_count;
-  size_t              zi, *zp;
-  size_t              guess, low, high, type, step;
+  sc_array_uniq_hashed (array, hash_fn, equal_fn, user, keep_order, map,
+                        NULL);
+}
 
-  SC_ASSERT (offsets->elem_size == sizeof (size_t));
+void
+sc_array_uniq_count (sc_array_t * array, sc_hash_function_t hash_fn,
+                     sc_equal_function_t equal_fn, void *user,
+                     sc_array_t * map, sc_array_t * counts)
+{
+  SC_ASSERT (counts != NULL);
+  sc_array_uniq_hashed (array, hash_fn, equal_fn, user, 1, map, counts);
+}
 
-  sc_array_resize (offsets, num_types + 1);
+/** Swap two array elements; the common sizes are inlined. */
+static inline void
+sc_array_swap_elems (char *a, char *b, size_t size)
+{
+  switch (size) {
+  case 4:
+    {
+      uint32_t            t4;
+
+      memcpy (&t4, a, 4);
+      memcpy (a, b, 4);
+      memcpy (b, &t4, 4);
+    }
+    break;
+  case 8:
+    {
+      uint64_t            t8;
+
+      memcpy (&t8, a, 8);
+      memcpy (a, b, 8);
+      memcpy (b, &t8, 8);
+    }
+    break;
+  case 16:
+    {
+      uint64_t            t16[2];
+
+      memcpy (t16, a, 16);
+      memcpy (a, b, 16);
+      memcpy (b, t16, 16);
+    }
+    break;
+  default:
+    {
+      char                t, *end = a + size;
+
+      for (; a < end; ++a, ++b) {
+        t = *a;
+        *a = *b;
+        *b = t;
+      }
+    }
+  }
+}
 
-  /** The point of this algorithm is to put offsets[i] into its final position
-   * for i = 0,...,num_types, where the final position of offsets[i] is the
-   * unique index k such that type_fn (array, j, data) < i for all j < k
+/** Below this number of elements, introsort switches to insertion sort. */
+#define SC_ARRAY_INTRO_SMALL 16
+
+static void
+sc_array_heapsort (char *base, size_t n, size_t size,
+                   int (*compar) (const void *, const void *))
+{
+  size_t              start, end, root, child;
+
+  if (n < 2) {
+    return;
+  }
+  for (end = n, start = n / 2; end > 1;) {
+    if (start > 0) {
+      /* build the heap */
+      --start;
+    }
+    else {
+      /* move the maximum to the end */
+      --end;
+      sc_array_swap_elems (base, base + end * size, size);
+    }
+    for (root = start; (child = 2 * root + 1) < end; root = child) {
+      if (child + 1 < end &&
+          compar (base + child * size, base + (child + 1) * size) < 0) {
+        ++child;
+      }
+      if (compar (base + root * size, base + child * size) >= 0) {
+        break;
+      }
+      sc_array_swap_elems (base + root * size, base + child * size, size);
+    }
+  }
+}
+
+static void
+sc_array_introsort_rec (char *base, size_t n, size_t size, int depth,
+                        int (*compar) (const void *, const void *))
+{
+  size_t              i, j, mid;
+  char               *pi, *pj, *last;
+
+  while (n > SC_ARRAY_INTRO_SMALL) {
+    if (depth-- == 0) {
+      sc_array_heapsort (base, n, size, compar);
+      return;
+    }
+
+    /* move the median of three to the front as pivot */
+    mid = n / 2;
+    last = base + (n - 1) * size;
+    if (compar (base + mid * size, base) < 0) {
+      sc_array_swap_elems (base + mid * size, base, size);
+    }
+    if (compar (last, base + mid * size) < 0) {
+      sc_array_swap_elems (last, base + mid * size, size);
+      if (compar (base + mid * size, base) < 0) {
+        sc_array_swap_elems (base + mid * size, base, size);
+      }
+    }
+    sc_array_swap_elems (base, base + mid * size, size);
+
+    /* partition around the pivot in front; the last element stops i */
+    i = 0;
+    j = n;
+    for (;;) {
+      do {
+        pi = base + ++i * size;
+      }
+      while (compar (pi, base) < 0);
+      do {
+        pj = base + --j * size;
+      }
+      while (compar (base, pj) < 0);
+      if (i >= j) {
+        break;
+      }
+      sc_array_swap_elems (pi, pj, size);
+    }
+    sc_array_swap_elems (base, base + j * size, size);
+
+    /* recurse into the smaller part, iterate on the larger one */
+    if (j < n - j - 1) {
+      sc_array_introsort_rec (base, j, size, depth, compar);
+      base += (j + 1) * size;
+      n -= j + 1;
+    }
+    else {
+      sc_array_introsort_rec (base + (j + 1) * size, n - j - 1, size,
+                              depth, compar);
+      n = j;
+    }
+  }
+
+  /* insertion sort for small ranges */
+  for (i = 1; i < n; ++i) {
+    for (j = i; j > 0 && compar (base + (j - 1) * size,
+                                 base + j * size) > 0; --j) {
+      sc_array_swap_elems (base + (j - 1) * size, base + j * size, size);
+    }
+  }
+}
+
+void
+sc_array_sort_intro (sc_array_t * array,
+                     int (*compar) (const void *, const void *))
+{
+  int                 depth;
+  size_t              n;
+
+  /* limit the recursion depth to twice the logarithm of the count */
+  for (depth = 0, n = array->elem_count; n > 1; n >>= 1) {
+    depth += 2;
+  }
+  sc_array_introsort_rec (array->array, array->elem_count, array->elem_size,
+                          depth, compar);
+}
+
+/** Return the size in bytes of a key type. */
+static size_t
+sc_array_key_bytes (sc_array_key_t key_type)
+{
+  switch (key_type) {
+  case SC_ARRAY_KEY_INT32:
+  case SC_ARRAY_KEY_UINT32:
+    return 4;
+  case SC_ARRAY_KEY_INT64:
+  case SC_ARRAY_KEY_UINT64:
+    return 8;
+  case SC_ARRAY_KEY_UINT128:
+    return 16;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+/** Read a key and transform it to an unsigned 128 bit number.
+ * The transformation preserves the order of the keys.
+ */
+static inline void
+sc_array_key_get (const char *key, sc_array_key_t key_type,
+                  uint64_t * hi, uint64_t * lo)
+{
+  uint32_t            u32;
+  uint64_t            u64;
+
+  *hi = 0;
+  switch (key_type) {
+  case SC_ARRAY_KEY_INT32:
+    memcpy (&u32, key, 4);
+    *lo = u32 ^ (uint32_t) 0x80000000U;
+    break;
+  case SC_ARRAY_KEY_UINT32:
+    memcpy (&u32, key, 4);
+    *lo = u32;
+    break;
+  case SC_ARRAY_KEY_INT64:
+    memcpy (&u64, key, 8);
+    *lo = u64 ^ ((uint64_t) 1 << 63);
+    break;
+  case SC_ARRAY_KEY_UINT64:
+    memcpy (lo, key, 8);
+    break;
+  case SC_ARRAY_KEY_UINT128:
+    memcpy (hi, key + offsetof (sc_uint128_t, high_bits), 8);
+    memcpy (lo, key + offsetof (sc_uint128_t, low_bits), 8);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+void
+sc_array_key_transform (const void *elem, size_t key_offset,
+                        sc_array_key_t key_type,
+                        uint64_t * high_bits, uint64_t * low_bits)
+{
+  sc_array_key_get ((const char *) elem + key_offset, key_type,
+                    high_bits, low_bits);
+}
+
+static inline int
+sc_array_key_compare (const char *k1, const char *k2,
+                      sc_array_key_t key_type)
+{
+  uint64_t            h1, l1, h2, l2;
+
+  sc_array_key_get (k1, key_type, &h1, &l1);
+  sc_array_key_get (k2, key_type, &h2, &l2);
+  if (h1 != h2) {
+    return h1 < h2 ? -1 : 1;
+  }
+  return l1 < l2 ? -1 : l1 > l2 ? 1 : 0;
+}
+
+/** Return byte number d of a transformed key, counting from the lowest. */
+static inline unsigned
+sc_array_key_digit (uint64_t hi, uint64_t lo, int d)
+{
+  return (unsigned) ((d < 8 ? lo >> (8 * d) : hi >> (8 * (d - 8))) & 0xff);
+}
+
+/** Below this number of elements, we do not use radix sort. */
+#define SC_ARRAY_RADIX_SMALL 64
+
+void
+sc_array_sort_keyed (sc_array_t * array, size_t key_offset,
+                     sc_array_key_t key_type)
+{
+  const size_t        n = array->elem_count;
+  const size_t        size = array->elem_size;
+  const int           nbytes = (int) sc_array_key_bytes (key_type);
+  int                 d;
+  unsigned            digit;
+  size_t              zz, sum, c;
+  size_t             *counts, *offs;
+  uint64_t            hi, lo;
+  char               *src, *dst, *tmp;
+
+  SC_ASSERT (key_offset + nbytes <= size);
+
+  if (n < SC_ARRAY_RADIX_SMALL) {
+    /* stable insertion sort */
+    src = array->array;
+    for (zz = 1; zz < n; ++zz) {
+      for (c = zz; c > 0 &&
+           sc_array_key_compare (src + (c - 1) * size + key_offset,
+                                 src + c * size + key_offset,
+                                 key_type) > 0; --c) {
+        sc_array_swap_elems (src + (c - 1) * size, src + c * size, size);
+      }
+    }
+    return;
+  }
+
+  /* histogram all digits in one sweep */
+  counts = SC_ALLOC_ZERO (size_t, 256 * nbytes);
+  src = array->array;
+  for (zz = 0; zz < n; ++zz) {
+    sc_array_key_get (src + zz * size + key_offset, key_type, &hi, &lo);
+    for (d = 0; d < nbytes; ++d) {
+      ++counts[256 * d + sc_array_key_digit (hi, lo, d)];
+    }
+  }
+
+  /* one stable counting pass per digit that is not the same for all */
+  dst = tmp = SC_ALLOC (char, n * size);
+  for (d = 0; d < nbytes; ++d) {
+    offs = counts + 256 * d;
+    sc_array_key_get (src + key_offset, key_type, &hi, &lo);
+    if (offs[sc_array_key_digit (hi, lo, d)] == n) {
+      continue;
+    }
+    for (sum = 0, digit = 0; digit < 256; ++digit) {
+      c = offs[digit];
+      offs[digit] = sum;
+      sum += c;
+    }
+    for (zz = 0; zz < n; ++zz) {
+      sc_array_key_get (src + zz * size + key_offset, key_type, &hi, &lo);
+      memcpy (dst + offs[sc_array_key_digit (hi, lo, d)]++ * size,
+              src + zz * size, size);
+    }
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  /* the result may reside in the temporary buffer */
+  if (src != array->array) {
+    memcpy (array->array, src, n * size);
+    SC_FREE (src);
+  }
+  else {
+    SC_FREE (dst);
+  }
+  SC_FREE (counts);
+}
+
+int
+sc_array_is_sorted_keyed (sc_array_t * array, size_t key_offset,
+                          sc_array_key_t key_type)
+{
+  const size_t        size = array->elem_size;
+  size_t              zz;
+  const char         *p = array->array + key_offset;
+
+  SC_ASSERT (key_offset + sc_array_key_bytes (key_type) <= size);
+
+  for (zz = 1; zz < array->elem_count; ++zz, p += size) {
+    if (sc_array_key_compare (p, p + size, key_type) > 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void
+sc_array_uniq_keyed (sc_array_t * array, size_t key_offset,
+                     sc_array_key_t key_type)
+{
+  const size_t        size = array->elem_size;
+  size_t              i, j;
+  char               *base = array->array;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (key_offset + sc_array_key_bytes (key_type) <= size);
+
+  if (array->elem_count == 0) {
+    return;
+  }
+
+  /* j is the last element kept so far */
+  for (i = 1, j = 0; i < array->elem_count; ++i) {
+    if (sc_array_key_compare (base + j * size + key_offset,
+                              base + i * size + key_offset, key_type) != 0) {
+      if (++j < i) {
+        memcpy (base + j * size, base + i * size, size);
+      }
+    }
+  }
+  sc_array_resize (array, j + 1);
+}
+
+ssize_t
+sc_array_bsearch (sc_array_t * array, const void *key,
+                  int (*compar) (const void *, const void *))
+{
+  ssize_t             is = -1;
+  char               *retval;
+
+  retval = (char *)
+    bsearch (key, array->array, array->elem_count, array->elem_size, compar);
+
+  if (retval != NULL) {
+    is = (ssize_t) ((retval - array->array) / array->elem_size);
+    SC_ASSERT (is >= 0 && is < (ssize_t) array->elem_count);
+  }
+
+  return is;
+}
+
+void
+sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
+                sc_array_type_t type_fn, void *data)
+{
+  const size_t        count = array->elem_count;
+  size_t              zi, *zp;
+  size_t              guess, low, high, type, step;
+
+  SC_ASSERT (offsets->elem_size == sizeof (size_t));
+
+  sc_array_resize (offsets, num_types + 1);
+
+  /** The point of this algorithm is to put offsets[i] into its final position
+   * for i = 0,...,num_types, where the final position of offsets[i] is the
+   * unique index k such that type_fn (array, j, data) < i for all j < k
    * and type_fn (array, j, data) >= i for all j >= k.
    *
    * The invariants of the loop are:
@@ -516,6 +1390,52 @@ sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
   }
 }
 
+void
+sc_array_split_parallel (sc_array_t * array, sc_array_t * offsets,
+                         size_t num_types, sc_array_type_t type_fn,
+                         void *data)
+{
+#ifdef SC_ENABLE_OPENMP
+  const size_t        count = array->elem_count;
+  const int           num_threads = sc_array_num_threads (num_types);
+  int                 t;
+  size_t             *off;
+
+  if (count > 0 && num_threads > 1) {
+    SC_ASSERT (offsets->elem_size == sizeof (size_t));
+
+    sc_array_resize (offsets, num_types + 1);
+    off = (size_t *) offsets->array;
+    off[0] = 0;
+    off[num_types] = count;
+
+    /* offsets[i] is the first index of type >= i, searched independently */
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (t = 0; t < num_threads; ++t) {
+      size_t              zt, lo, hi, mid;
+
+      for (zt = SC_MAX (sc_array_block_begin (num_types, num_threads, t), 1);
+           zt < sc_array_block_begin (num_types, num_threads, t + 1); ++zt) {
+        lo = 0;
+        hi = count;
+        while (lo < hi) {
+          mid = lo + (hi - lo) / 2;
+          if (type_fn (array, mid, data) < zt) {
+            lo = mid + 1;
+          }
+          else {
+            hi = mid;
+          }
+        }
+        off[zt] = lo;
+      }
+    }
+    return;
+  }
+#endif
+  sc_array_split (array, offsets, num_types, type_fn, data);
+}
+
 int
 sc_array_is_permutation (sc_array_t * newindices)
 {
@@ -573,13 +1493,35 @@ sc_array_permute (sc_array_t * array, sc_array_t * newindices, int keepperm)
     return;
   }
 
-  if (!keepperm) {
-    newind = (size_t *) sc_array_index (newindices, 0);
+#ifdef SC_ENABLE_OPENMP
+  if (keepperm && sc_array_num_threads (count) > 1) {
+    int                 t, num_threads = sc_array_num_threads (count);
+    char               *dest = SC_ALLOC (char, count * esize);
+
+    /* scatter into a copy by blocks and copy back */
+    newind = (size_t *) newindices->array;
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (t = 0; t < num_threads; ++t) {
+      size_t              zt;
+
+      for (zt = sc_array_block_begin (count, num_threads, t);
+           zt < sc_array_block_begin (count, num_threads, t + 1); ++zt) {
+        memcpy (dest + esize * newind[zt], carray + esize * zt, esize);
+      }
+    }
+    sc_array_copy_parallel (carray, dest, count * esize, num_threads);
+    SC_FREE (dest);
+    SC_FREE (temp);
+    return;
   }
-  else {
-    newind = SC_ALLOC (size_t, count);
-    memcpy (newind, sc_array_index (newindices, 0), count * sizeof (size_t));
+#endif
+
+  if (keepperm) {
+    sc_array_permute_multi (&array, 1, newindices, (size_t) -1);
+    SC_FREE (temp);
+    return;
   }
+  newind = (size_t *) sc_array_index (newindices, 0);
 
   zi = 0;
   zj = 0;
@@ -609,11 +1551,196 @@ sc_array_permute (sc_array_t * array, sc_array_t * newindices, int keepperm)
     zj = (++zi);
   }
 
-  if (keepperm) {
-    SC_FREE (newind);
+  SC_FREE (temp);
+}
+
+/** Target bytes per bucket of the cache-blocked permutation. */
+static const size_t sc_array_permute_block = (size_t) 1 << 18;
+
+/** Maximum number of buckets, bounding the streams of the bucket pass. */
+static const size_t sc_array_permute_buckets = 256;
+
+/** Permute arrays out of place into new buffers of exactly their size.
+ * Large arrays are scattered into buckets of neighboring target indices
+ * first, so that the final writes stay local.
+ */
+static void
+sc_array_permute_scatter (sc_array_t ** arrays, int num_arrays,
+                          const size_t * newind, size_t count,
+                          size_t record, char **dest)
+{
+  int                 k;
+  int                 shift;
+  size_t              zi, zb, zc, num_buckets, esize, srecord;
+  size_t             *fill;
+  char               *staging, *rec;
+
+  /* the smallest buckets that stay below the maximum bucket count */
+  shift = 0;
+  while (((size_t) 1 << shift) * record < sc_array_permute_block) {
+    ++shift;
+  }
+  while (((count - 1) >> shift) + 1 > sc_array_permute_buckets) {
+    ++shift;
+  }
+  num_buckets = ((count - 1) >> shift) + 1;
+
+  if (num_buckets == 1) {
+    /* the target fits into cache: scatter directly */
+    for (k = 0; k < num_arrays; ++k) {
+      esize = arrays[k]->elem_size;
+      for (zi = 0; zi < count; ++zi) {
+        memcpy (dest[k] + esize * newind[zi],
+                arrays[k]->array + esize * zi, esize);
+      }
+    }
+    return;
   }
 
-  SC_FREE (temp);
+  /* count the elements per bucket and compute the bucket offsets */
+  fill = SC_ALLOC_ZERO (size_t, num_buckets);
+  for (zi = 0; zi < count; ++zi) {
+    ++fill[newind[zi] >> shift];
+  }
+  for (zi = 0, zb = 0; zb < num_buckets; ++zb) {
+    zc = fill[zb];
+    fill[zb] = zi;
+    zi += zc;
+  }
+
+  /* stream the records of target index and elements into the buckets */
+  srecord = sizeof (size_t) + record;
+  staging = SC_ALLOC (char, count * srecord);
+  for (zi = 0; zi < count; ++zi) {
+    rec = staging + srecord * fill[newind[zi] >> shift]++;
+    memcpy (rec, newind + zi, sizeof (size_t));
+    rec += sizeof (size_t);
+    for (k = 0; k < num_arrays; ++k) {
+      esize = arrays[k]->elem_size;
+      memcpy (rec, arrays[k]->array + esize * zi, esize);
+      rec += esize;
+    }
+  }
+
+  /* the writes of each bucket go to a small range of the target */
+  for (zi = 0; zi < count; ++zi) {
+    size_t              target;
+
+    rec = staging + srecord * zi;
+    memcpy (&target, rec, sizeof (size_t));
+    rec += sizeof (size_t);
+    for (k = 0; k < num_arrays; ++k) {
+      esize = arrays[k]->elem_size;
+      memcpy (dest[k] + esize * target, rec, esize);
+      rec += esize;
+    }
+  }
+  SC_FREE (staging);
+  SC_FREE (fill);
+}
+
+/** Permute arrays in place by following cycles, marking visited indices. */
+static void
+sc_array_permute_cycles (sc_array_t ** arrays, int num_arrays,
+                         const size_t * newind, size_t count, size_t record)
+{
+  int                 k;
+  size_t              zs, zj, esize, offset;
+  char               *carry, *swap;
+  sc_bitset_t        *pending;
+
+  /* one element per array in transit and one to swap it with */
+  carry = SC_ALLOC (char, 2 * record);
+  swap = carry + record;
+  pending = sc_bitset_new (count);
+  sc_bitset_fill (pending, 1);
+
+  for (zs = sc_bitset_next (pending, 0); zs < count;
+       zs = sc_bitset_next (pending, zs + 1)) {
+    for (k = 0, offset = 0; k < num_arrays; offset += esize, ++k) {
+      esize = arrays[k]->elem_size;
+      memcpy (carry + offset, arrays[k]->array + esize * zs, esize);
+    }
+    for (zj = newind[zs]; zj != zs; zj = newind[zj]) {
+      SC_ASSERT (zj < count && sc_bitset_get (pending, zj));
+
+      /* drop the carried elements at their target and pick up the old */
+      for (k = 0, offset = 0; k < num_arrays; offset += esize, ++k) {
+        esize = arrays[k]->elem_size;
+        memcpy (swap + offset, arrays[k]->array + esize * zj, esize);
+        memcpy (arrays[k]->array + esize * zj, carry + offset, esize);
+      }
+      memcpy (carry, swap, record);
+      sc_bitset_clear (pending, zj);
+    }
+    for (k = 0, offset = 0; k < num_arrays; offset += esize, ++k) {
+      esize = arrays[k]->elem_size;
+      memcpy (arrays[k]->array + esize * zs, carry + offset, esize);
+    }
+    sc_bitset_clear (pending, zs);
+  }
+
+  sc_bitset_destroy (pending);
+  SC_FREE (carry);
+}
+
+void
+sc_array_permute_multi (sc_array_t ** arrays, int num_arrays,
+                        sc_array_t * newindices, size_t max_bytes)
+{
+  int                 k;
+  size_t              count, record, bytes, temp_bytes;
+  const size_t       *newind;
+  char              **dest;
+
+  SC_ASSERT (num_arrays >= 0);
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+  SC_ASSERT (sc_array_is_permutation (newindices));
+
+  count = newindices->elem_count;
+  record = 0;
+  for (k = 0; k < num_arrays; ++k) {
+    SC_ASSERT (arrays[k]->elem_count == count);
+    SC_ASSERT (sc_memory_domain_is_host (arrays[k]->domain));
+    record += arrays[k]->elem_size;
+  }
+  if (count == 0 || record == 0) {
+    return;
+  }
+  newind = (const size_t *) newindices->array;
+
+  /* the new buffers plus the staging records of the bucket pass */
+  bytes = count * record;
+  temp_bytes = bytes;
+  if (bytes > sc_array_permute_block) {
+    temp_bytes += count * (sizeof (size_t) + record);
+  }
+  if (temp_bytes > max_bytes) {
+    sc_array_permute_cycles (arrays, num_arrays, newind, count, record);
+    return;
+  }
+
+  dest = SC_ALLOC (char *, num_arrays);
+  for (k = 0; k < num_arrays; ++k) {
+    dest[k] = SC_ALLOC (char, count * arrays[k]->elem_size);
+  }
+  sc_array_permute_scatter (arrays, num_arrays, newind, count, record, dest);
+  for (k = 0; k < num_arrays; ++k) {
+    sc_array_t         *a = arrays[k];
+
+    if (SC_ARRAY_IS_OWNER (a) && !SC_ARRAY_IS_INLINE (a) &&
+        a->domain == SC_MEMORY_HOST) {
+      /* the array takes over the permuted buffer */
+      SC_FREE (a->array);
+      a->array = dest[k];
+      a->byte_alloc = (ssize_t) (count * a->elem_size);
+    }
+    else {
+      memcpy (a->array, dest[k], count * a->elem_size);
+      SC_FREE (dest[k]);
+    }
+  }
+  SC_FREE (dest);
 }
 
 unsigned int
@@ -630,6 +1757,32 @@ sc_array_checksum (sc_array_t * array)
   }
 
   bytes = array->elem_count * array->elem_size;
+#ifdef SC_ENABLE_OPENMP
+  if (sc_array_num_threads (bytes / 64) > 1) {
+    int                 t, num_threads = sc_array_num_threads (bytes / 64);
+    unsigned long      *parts = SC_ALLOC (unsigned long, num_threads);
+
+    /* checksum the blocks independently and combine them in order */
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (t = 0; t < num_threads; ++t) {
+      const size_t        b = sc_array_block_begin (bytes, num_threads, t);
+
+      parts[t] = adler32 (adler32 (0, Z_NULL, 0),
+                          (const Bytef *) array->array + b,
+                          sc_array_block_begin (bytes, num_threads, t + 1)
+                          - b);
+    }
+    for (t = 0; t < num_threads; ++t) {
+      crc = adler32_combine (crc, parts[t],
+                             (z_off_t) (sc_array_block_begin
+                                        (bytes, num_threads, t + 1) -
+                                        sc_array_block_begin
+                                        (bytes, num_threads, t)));
+    }
+    SC_FREE (parts);
+    return crc;
+  }
+#endif
   crc = adler32 (crc, (const Bytef *) array->array, bytes);
 
   return crc;
@@ -640,27 +1793,119 @@ sc_array_checksum (sc_array_t * array)
 #endif
 }
 
-size_t
-sc_array_pqueue_add (sc_array_t * array, void *temp,
-                     int (*compar) (const void *, const void *))
+uint32_t
+sc_array_crc32c (const sc_array_t * array)
 {
-  int                 comp;
-  size_t              parent, child, swaps;
-  const size_t        size = array->elem_size;
-  void               *p, *c;
+  size_t              bytes;
 
-  /* this works on a pre-allocated array that is not a view */
-  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
-  SC_ASSERT (array->elem_count > 0);
+  bytes = array->elem_count * array->elem_size;
+  if (bytes == 0) {
+    return 0;
+  }
+#ifdef SC_ENABLE_OPENMP
+  if (sc_array_num_threads (bytes / 64) > 1) {
+    int                 t, num_threads = sc_array_num_threads (bytes / 64);
+    uint32_t            crc, *parts = SC_ALLOC (uint32_t, num_threads);
+
+    /* checksum the blocks independently and combine them in order */
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (t = 0; t < num_threads; ++t) {
+      const size_t        b = sc_array_block_begin (bytes, num_threads, t);
+
+      parts[t] = sc_io_crc32c (0, array->array + b,
+                               sc_array_block_begin (bytes, num_threads,
+                                                     t + 1) - b);
+    }
+    crc = parts[0];
+    for (t = 1; t < num_threads; ++t) {
+      crc = sc_io_crc32c_combine (crc, parts[t],
+                                  sc_array_block_begin (bytes, num_threads,
+                                                        t + 1) -
+                                  sc_array_block_begin (bytes, num_threads,
+                                                        t));
+    }
+    SC_FREE (parts);
+    return crc;
+  }
+#endif
+  return sc_io_crc32c (0, array->array, bytes);
+}
 
-  /* PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED. */
-  SC_ABORT_NOT_REACHED ();
+#ifdef SC_ENABLE_MPI
 
-  swaps = 0;
-  child = array->elem_count - 1;
-  c = array->array + (size * child);
-  while (child > 0) {
-    parent = (child - 1) / 2;
+/** Combine pairs of checksum and byte count, the earlier ranks first. */
+static void
+sc_array_checksum_op (void *invec, void *inoutvec, int *len,
+                      MPI_Datatype * datatype)
+{
+  int                 i;
+  const uint64_t     *in = (const uint64_t *) invec;
+  uint64_t           *inout = (uint64_t *) inoutvec;
+
+  for (i = 0; i < *len; ++i, in += 2, inout += 2) {
+    inout[0] = sc_io_crc32c_combine ((uint32_t) in[0], (uint32_t) inout[0],
+                                     (size_t) inout[1]);
+    inout[1] += in[1];
+  }
+}
+
+#endif
+
+uint32_t
+sc_array_checksum_global (const sc_array_t * array, sc_MPI_Comm mpicomm)
+{
+  uint32_t            crc;
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+  uint64_t            local[2], global[2];
+  MPI_Datatype        pair;
+  MPI_Op              op;
+#endif
+
+  crc = sc_array_crc32c (array);
+#ifdef SC_ENABLE_MPI
+  local[0] = crc;
+  local[1] = (uint64_t) (array->elem_count * array->elem_size);
+
+  /* the operation is not commutative and thus applied in rank order */
+  mpiret = MPI_Type_contiguous (2, MPI_UINT64_T, &pair);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&pair);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Op_create (sc_array_checksum_op, 0, &op);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Allreduce (local, global, 1, pair, op, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Op_free (&op);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_free (&pair);
+  SC_CHECK_MPI (mpiret);
+  crc = (uint32_t) global[0];
+#endif
+  return crc;
+}
+
+size_t
+sc_array_pqueue_add (sc_array_t * array, void *temp,
+                     int (*compar) (const void *, const void *))
+{
+  int                 comp;
+  size_t              parent, child, swaps;
+  const size_t        size = array->elem_size;
+  void               *p, *c;
+
+  /* this works on a pre-allocated array that is not a view */
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (array->elem_count > 0);
+
+  /* PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED. */
+  SC_ABORT_NOT_REACHED ();
+
+  swaps = 0;
+  child = array->elem_count - 1;
+  c = array->array + (size * child);
+  while (child > 0) {
+    parent = (child - 1) / 2;
     p = array->array + (size * parent);
 
     /* compare child to parent */
@@ -752,268 +1997,1510 @@ sc_array_pqueue_pop (sc_array_t * array, void *result,
   return swaps;
 }
 
-/* memory stamp routines */
+/* structure of arrays routines */
 
-static void
-sc_mstamp_stamp (sc_mstamp_t * mst)
+size_t
+sc_soa_memory_used (sc_soa_t * soa)
 {
-  SC_ASSERT (mst != NULL);
-  SC_ASSERT (mst->elem_size > 0);
-  SC_ASSERT (mst->stamp_size > 0);
+  int                 c;
+  size_t              mem;
+
+  mem = sizeof (sc_soa_t) +
+    soa->alloc_columns * (sizeof (sc_array_t) + sizeof (char *));
+  for (c = 0; c < soa->num_columns; ++c) {
+    mem += sc_array_memory_used (&soa->columns[c], 0);
+    if (soa->names[c] != NULL) {
+      mem += strlen (soa->names[c]) + 1;
+    }
+  }
+  return mem;
+}
 
-  /* make new stamp; the pointer is aligned to any builtin type */
-  mst->cur_snext = 0;
-  *(void **) sc_array_push (&mst->remember) =
-    mst->current = SC_ALLOC (char, mst->stamp_size);
+sc_soa_t           *
+sc_soa_new (void)
+{
+  return SC_ALLOC_ZERO (sc_soa_t, 1);
 }
 
 void
-sc_mstamp_init (sc_mstamp_t * mst, size_t stamp_unit, size_t elem_size)
+sc_soa_destroy (sc_soa_t * soa)
 {
-  SC_ASSERT (mst != NULL);
+  int                 c;
 
-  /* basic initialization */
-  memset (mst, 0, sizeof (sc_mstamp_t));
-  mst->elem_size = elem_size;
-  sc_array_init (&mst->remember, sizeof (void *));
+  for (c = 0; c < soa->num_columns; ++c) {
+    sc_array_reset (&soa->columns[c]);
+    SC_FREE (soa->names[c]);
+  }
+  SC_FREE (soa->columns);
+  SC_FREE (soa->names);
+  SC_FREE (soa);
+}
 
-  /* how many items per stamp we use */
-  if (elem_size > 0) {
-    mst->per_stamp = stamp_unit / elem_size;
-    if (mst->per_stamp == 0) {
-      /* Each item uses more memory than we had specified for one stamp */
-      mst->per_stamp = 1;
+int
+sc_soa_add_column (sc_soa_t * soa, const char *name, size_t elem_size)
+{
+  int                 c;
+
+  SC_ASSERT (elem_size > 0);
+
+  if (soa->num_columns == soa->alloc_columns) {
+    soa->alloc_columns = SC_MAX (4, 2 * soa->alloc_columns);
+    soa->columns = SC_REALLOC (soa->columns, sc_array_t,
+                               soa->alloc_columns);
+    soa->names = SC_REALLOC (soa->names, char *, soa->alloc_columns);
+  }
+  c = soa->num_columns++;
+  sc_array_init_count (&soa->columns[c], elem_size, soa->elem_count);
+  sc_array_memset (&soa->columns[c], 0);
+  soa->names[c] = name != NULL ? SC_STRDUP (name) : NULL;
+
+  return c;
+}
+
+int
+sc_soa_column_index (sc_soa_t * soa, const char *name)
+{
+  int                 c;
+
+  SC_ASSERT (name != NULL);
+  for (c = 0; c < soa->num_columns; ++c) {
+    if (soa->names[c] != NULL && !strcmp (soa->names[c], name)) {
+      return c;
     }
-    mst->stamp_size = mst->per_stamp * elem_size;
-    sc_mstamp_stamp (mst);
   }
+  return -1;
 }
 
 void
-sc_mstamp_reset (sc_mstamp_t * mst)
+sc_soa_column_view (sc_array_t * view, sc_soa_t * soa, int column)
 {
-  size_t              znum, zz;
+  SC_ASSERT (0 <= column && column < soa->num_columns);
+  sc_array_init_view (view, &soa->columns[column], 0, soa->elem_count);
+}
 
-  SC_ASSERT (mst != NULL);
+void
+sc_soa_resize (sc_soa_t * soa, size_t new_count)
+{
+  int                 c;
 
-  /* free all memory stamps we have created */
-  znum = mst->remember.elem_count;
-  for (zz = 0; zz < znum; zz++) {
-    SC_FREE (*(void **) sc_array_index (&mst->remember, zz));
+  for (c = 0; c < soa->num_columns; ++c) {
+    sc_array_resize (&soa->columns[c], new_count);
   }
-  sc_array_reset (&mst->remember);
+  soa->elem_count = new_count;
+}
+
+size_t
+sc_soa_push (sc_soa_t * soa)
+{
+  sc_soa_resize (soa, soa->elem_count + 1);
+  return soa->elem_count - 1;
 }
 
 void
-sc_mstamp_truncate (sc_mstamp_t * mst)
+sc_soa_permute (sc_soa_t * soa, sc_array_t * newindices)
 {
-  /* free all memory in structure; the array mst->remember will be legal */
-  sc_mstamp_reset (mst);
+  int                 c;
+  sc_array_t        **columns;
 
-  /* we will use the container is if freshly initialized */
-  if (mst->elem_size > 0) {
-    sc_mstamp_stamp (mst);
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+  SC_ASSERT (newindices->elem_count == soa->elem_count);
+
+  /* move the records of all columns in one pass */
+  columns = SC_ALLOC (sc_array_t *, soa->num_columns);
+  for (c = 0; c < soa->num_columns; ++c) {
+    columns[c] = &soa->columns[c];
   }
+  sc_array_permute_multi (columns, soa->num_columns, newindices,
+                          (size_t) -1);
+  SC_FREE (columns);
 }
 
-void               *
-sc_mstamp_alloc (sc_mstamp_t * mst)
+void
+sc_soa_sort (sc_soa_t * soa, int column,
+             int (*compar) (const void *, const void *),
+             sc_array_t * newindices)
 {
-  void               *ret;
-
-  SC_ASSERT (mst != NULL);
+  size_t              i, esize, ioffs;
+  char               *rec;
+  sc_array_t         *keys, *perm;
+
+  SC_ASSERT (0 <= column && column < soa->num_columns);
+  SC_ASSERT (newindices == NULL || newindices->elem_size == sizeof (size_t));
+
+  /* sort records of the key at offset zero followed by the old index */
+  esize = soa->columns[column].elem_size;
+  ioffs = (esize + sizeof (size_t) - 1) / sizeof (size_t) * sizeof (size_t);
+  keys = sc_array_new_count (ioffs + sizeof (size_t), soa->elem_count);
+  for (i = 0; i < soa->elem_count; ++i) {
+    rec = (char *) sc_array_index (keys, i);
+    memcpy (rec, sc_soa_index (soa, column, i), esize);
+    memcpy (rec + ioffs, &i, sizeof (size_t));
+  }
+  sc_array_sort (keys, compar);
 
-  if (mst->elem_size == 0) {
-    /* item size zero is legal */
-    return NULL;
+  perm = newindices != NULL ? newindices : sc_array_new (sizeof (size_t));
+  sc_array_resize (perm, soa->elem_count);
+  for (i = 0; i < soa->elem_count; ++i) {
+    rec = (char *) sc_array_index (keys, i);
+    *(size_t *) sc_array_index (perm, *(size_t *) (rec + ioffs)) = i;
   }
+  sc_array_destroy (keys);
 
-  /* we know that at least one item will fit */
-  SC_ASSERT (mst->current != NULL);
-  SC_ASSERT (mst->cur_snext < mst->per_stamp);
-  ret = mst->current + mst->cur_snext * mst->elem_size;
+  sc_soa_permute (soa, perm);
+  if (newindices == NULL) {
+    sc_array_destroy (perm);
+  }
+}
 
-  /* if this was the last item on the current stamp, we need a new one */
-  if (++mst->cur_snext == mst->per_stamp) {
-    sc_mstamp_stamp (mst);
+void
+sc_soa_from_aos (sc_soa_t * soa, sc_array_t * aos, const size_t * offsets)
+{
+  int                 c;
+  size_t              i, esize;
+  const char         *src;
+  char               *dst;
+
+  SC_ASSERT (soa->num_columns == 0 || offsets != NULL);
+
+  sc_soa_resize (soa, aos->elem_count);
+  for (c = 0; c < soa->num_columns; ++c) {
+    /* one pass per column keeps the writes sequential */
+    esize = soa->columns[c].elem_size;
+    SC_ASSERT (offsets[c] + esize <= aos->elem_size);
+    src = aos->array + offsets[c];
+    dst = soa->columns[c].array;
+    for (i = 0; i < aos->elem_count; ++i) {
+      memcpy (dst, src, esize);
+      src += aos->elem_size;
+      dst += esize;
+    }
   }
-  return ret;
 }
 
-size_t
-sc_mstamp_memory_used (sc_mstamp_t * mst)
+void
+sc_soa_to_aos (sc_soa_t * soa, sc_array_t * aos, const size_t * offsets)
 {
-  size_t              s;
+  int                 c;
+  size_t              i, esize;
+  const char         *src;
+  char               *dst;
 
-  SC_ASSERT (mst != NULL);
+  SC_ASSERT (soa->num_columns == 0 || offsets != NULL);
 
-  s = sizeof (sc_mstamp_t);
-  s += mst->remember.elem_count * mst->stamp_size;
-  s += sc_array_memory_used (&mst->remember, 0);
-  return s;
+  if (aos->elem_count != soa->elem_count) {
+    sc_array_resize (aos, soa->elem_count);
+  }
+  for (c = 0; c < soa->num_columns; ++c) {
+    esize = soa->columns[c].elem_size;
+    SC_ASSERT (offsets[c] + esize <= aos->elem_size);
+    src = soa->columns[c].array;
+    dst = aos->array + offsets[c];
+    for (i = 0; i < soa->elem_count; ++i) {
+      memcpy (dst, src, esize);
+      src += esize;
+      dst += aos->elem_size;
+    }
+  }
 }
 
-/* mempool routines */
+/* indexed priority queue routines */
 
-size_t
-sc_mempool_memory_used (sc_mempool_t * mempool)
-{
-  return sizeof (sc_mempool_t) +
-#ifdef SC_MEMPOOL_MSTAMP
-    sc_mstamp_memory_used (&mempool->mstamp) +
-#else
-    obstack_memory_used (&mempool->obstack) +
-#endif
-    sc_array_memory_used (&mempool->freed, 0);
-}
+/** The number of children of a node in the indexed priority queue. */
+#define SC_IPQUEUE_ARITY 4
 
-#ifndef SC_MEMPOOL_MSTAMP
+/** The heap position of a handle that is not in the queue. */
+#define SC_IPQUEUE_NONE ((size_t) -1)
 
-static void        *
-sc_containers_malloc (size_t n)
+struct sc_ipqueue
 {
-  return sc_malloc (sc_package_id, n);
+  sc_array_t          elems;    /**< Element data indexed by handle. */
+  sc_array_t          heap;     /**< Handles of type size_t as a heap. */
+  sc_array_t          pos;      /**< Heap position of type size_t of
+                                     each handle or SC_IPQUEUE_NONE. */
+  int                 (*compar) (const void *, const void *);
+};
+
+static inline int
+sc_ipqueue_less (sc_ipqueue_t * pq, size_t h1, size_t h2)
+{
+  return pq->compar (pq->elems.array + h1 * pq->elems.elem_size,
+                     pq->elems.array + h2 * pq->elems.elem_size) < 0;
 }
 
-static void        *(*obstack_chunk_alloc) (size_t) = sc_containers_malloc;
-
+/** Move a handle up from a heap position until its parent is not larger. */
 static void
-sc_containers_free (void *p)
+sc_ipqueue_sift_up (sc_ipqueue_t * pq, size_t i, size_t h)
 {
-  sc_free (sc_package_id, p);
+  size_t             *heap = (size_t *) pq->heap.array;
+  size_t             *pos = (size_t *) pq->pos.array;
+  size_t              parent;
+
+  /* move the hole up instead of swapping */
+  while (i > 0) {
+    parent = (i - 1) / SC_IPQUEUE_ARITY;
+    if (!sc_ipqueue_less (pq, h, heap[parent])) {
+      break;
+    }
+    heap[i] = heap[parent];
+    pos[heap[i]] = i;
+    i = parent;
+  }
+  heap[i] = h;
+  pos[h] = i;
 }
 
-static void         (*obstack_chunk_free) (void *) = sc_containers_free;
-
-#endif /* !SC_MEMPOOL_MSTAMP */
-
-/** This function is static; we do not like to expose _ext functions in libsc. */
+/** Move a handle down from a heap position until no child is smaller. */
 static void
-sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
-                     int zero_and_persist)
+sc_ipqueue_sift_down (sc_ipqueue_t * pq, size_t i, size_t h)
 {
-  mempool->elem_size = elem_size;
-  mempool->elem_count = 0;
-  mempool->zero_and_persist = zero_and_persist;
-
-#ifdef SC_MEMPOOL_MSTAMP
-  sc_mstamp_init (&mempool->mstamp, 4096, elem_size);
-#else
-  obstack_init (&mempool->obstack);
-#endif
-  sc_array_init (&mempool->freed, sizeof (void *));
+  const size_t        n = pq->heap.elem_count;
+  size_t             *heap = (size_t *) pq->heap.array;
+  size_t             *pos = (size_t *) pq->pos.array;
+  size_t              c, cend, cmin;
+
+  while ((c = SC_IPQUEUE_ARITY * i + 1) < n) {
+    cend = SC_MIN (c + SC_IPQUEUE_ARITY, n);
+    for (cmin = c++; c < cend; ++c) {
+      if (sc_ipqueue_less (pq, heap[c], heap[cmin])) {
+        cmin = c;
+      }
+    }
+    if (!sc_ipqueue_less (pq, heap[cmin], h)) {
+      break;
+    }
+    heap[i] = heap[cmin];
+    pos[heap[i]] = i;
+    i = cmin;
+  }
+  heap[i] = h;
+  pos[h] = i;
 }
 
-void
-sc_mempool_init (sc_mempool_t * mempool, size_t elem_size)
+/** Make room for the data and position of a handle. */
+static void
+sc_ipqueue_grow (sc_ipqueue_t * pq, size_t handle)
 {
-  sc_mempool_init_ext (mempool, elem_size, 0);
+  size_t              zz, old_count = pq->pos.elem_count;
+
+  if (handle >= old_count) {
+    sc_array_resize (&pq->elems, handle + 1);
+    sc_array_resize (&pq->pos, handle + 1);
+    for (zz = old_count; zz <= handle; ++zz) {
+      *(size_t *) sc_array_index (&pq->pos, zz) = SC_IPQUEUE_NONE;
+    }
+  }
 }
 
-/** This function is static; we do not like to expose _ext functions in libsc. */
-static sc_mempool_t *
-sc_mempool_new_ext (size_t elem_size, int zero_and_persist)
+sc_ipqueue_t       *
+sc_ipqueue_new (size_t elem_size, int (*compar) (const void *, const void *))
 {
-  sc_mempool_t       *mempool;
+  sc_ipqueue_t       *pq;
 
   SC_ASSERT (elem_size > 0);
-  SC_ASSERT (elem_size <= (size_t) INT_MAX);    /* obstack limited to int */
-
-  mempool = SC_ALLOC (sc_mempool_t, 1);
 
-  sc_mempool_init_ext (mempool, elem_size, zero_and_persist);
+  pq = SC_ALLOC (sc_ipqueue_t, 1);
+  sc_array_init (&pq->elems, elem_size);
+  sc_array_init (&pq->heap, sizeof (size_t));
+  sc_array_init (&pq->pos, sizeof (size_t));
+  pq->compar = compar;
 
-  return mempool;
+  return pq;
 }
 
-sc_mempool_t       *
-sc_mempool_new (size_t elem_size)
+void
+sc_ipqueue_destroy (sc_ipqueue_t * pq)
 {
-  return sc_mempool_new_ext (elem_size, 0);
+  sc_array_reset (&pq->elems);
+  sc_array_reset (&pq->heap);
+  sc_array_reset (&pq->pos);
+  SC_FREE (pq);
 }
 
-sc_mempool_t       *
-sc_mempool_new_zero_and_persist (size_t elem_size)
+size_t
+sc_ipqueue_count (sc_ipqueue_t * pq)
 {
-  return sc_mempool_new_ext (elem_size, 1);
+  return pq->heap.elem_count;
 }
 
-void
-sc_mempool_reset (sc_mempool_t * mempool)
+size_t
+sc_ipqueue_memory_used (sc_ipqueue_t * pq)
 {
-  sc_array_reset (&mempool->freed);
-#ifdef SC_MEMPOOL_MSTAMP
-  sc_mstamp_reset (&mempool->mstamp);
-#else
-  obstack_free (&mempool->obstack, NULL);
-#endif
+  return sizeof (sc_ipqueue_t) +
+    SC_ARRAY_BYTE_ALLOC (&pq->elems) + SC_ARRAY_BYTE_ALLOC (&pq->heap) +
+    SC_ARRAY_BYTE_ALLOC (&pq->pos);
 }
 
-void
-sc_mempool_destroy (sc_mempool_t * mempool)
+int
+sc_ipqueue_contains (sc_ipqueue_t * pq, size_t handle)
 {
-  sc_mempool_reset (mempool);
-  SC_FREE (mempool);
+  return handle < pq->pos.elem_count &&
+    *(size_t *) sc_array_index (&pq->pos, handle) != SC_IPQUEUE_NONE;
 }
 
-void
-sc_mempool_destroy_null (sc_mempool_t ** pmempool)
+void               *
+sc_ipqueue_elem (sc_ipqueue_t * pq, size_t handle)
 {
-  SC_ASSERT (pmempool != NULL);
-  SC_ASSERT (*pmempool != NULL);
+  SC_ASSERT (sc_ipqueue_contains (pq, handle));
 
-  sc_mempool_destroy (*pmempool);
-  *pmempool = NULL;
+  return sc_array_index (&pq->elems, handle);
 }
 
 void
-sc_mempool_truncate (sc_mempool_t * mempool)
+sc_ipqueue_push (sc_ipqueue_t * pq, size_t handle, const void *elem)
 {
-  sc_array_reset (&mempool->freed);
-#ifdef SC_MEMPOOL_MSTAMP
-  sc_mstamp_truncate (&mempool->mstamp);
-#else
-  obstack_free (&mempool->obstack, NULL);
-  obstack_init (&mempool->obstack);
-#endif
-  mempool->elem_count = 0;
-}
+  SC_ASSERT (!sc_ipqueue_contains (pq, handle));
 
-/* list routines */
+  sc_ipqueue_grow (pq, handle);
+  memcpy (sc_array_index (&pq->elems, handle), elem, pq->elems.elem_size);
+  sc_array_push (&pq->heap);
+  sc_ipqueue_sift_up (pq, pq->heap.elem_count - 1, handle);
+}
 
-size_t
-sc_list_memory_used (sc_list_t * list, int is_dynamic)
+void
+sc_ipqueue_decrease_key (sc_ipqueue_t * pq, size_t handle, const void *elem)
 {
-  return (is_dynamic ? sizeof (sc_list_t) : 0) +
-    (list->allocator_owned ? sc_mempool_memory_used (list->allocator) : 0);
+  SC_ASSERT (sc_ipqueue_contains (pq, handle));
+  SC_ASSERT (pq->compar (elem, sc_array_index (&pq->elems, handle)) <= 0);
+
+  memcpy (sc_array_index (&pq->elems, handle), elem, pq->elems.elem_size);
+  sc_ipqueue_sift_up (pq, *(size_t *) sc_array_index (&pq->pos, handle),
+                      handle);
 }
 
-sc_list_t          *
-sc_list_new (sc_mempool_t * allocator)
+void
+sc_ipqueue_update (sc_ipqueue_t * pq, size_t handle, const void *elem)
 {
-  sc_list_t          *list;
-
-  list = SC_ALLOC (sc_list_t, 1);
+  size_t              i;
 
-  list->elem_count = 0;
-  list->first = NULL;
-  list->last = NULL;
+  SC_ASSERT (sc_ipqueue_contains (pq, handle));
 
-  if (allocator != NULL) {
-    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
-    list->allocator = allocator;
-    list->allocator_owned = 0;
-  }
-  else {
-    list->allocator = sc_mempool_new (sizeof (sc_link_t));
-    list->allocator_owned = 1;
+  memcpy (sc_array_index (&pq->elems, handle), elem, pq->elems.elem_size);
+  i = *(size_t *) sc_array_index (&pq->pos, handle);
+  sc_ipqueue_sift_up (pq, i, handle);
+  if (*(size_t *) sc_array_index (&pq->pos, handle) == i) {
+    sc_ipqueue_sift_down (pq, i, handle);
   }
-
-  return list;
 }
 
 void
-sc_list_destroy (sc_list_t * list)
+sc_ipqueue_remove (sc_ipqueue_t * pq, size_t handle, void *elem)
+{
+  size_t              i, last;
+
+  SC_ASSERT (sc_ipqueue_contains (pq, handle));
+
+  if (elem != NULL) {
+    memcpy (elem, sc_array_index (&pq->elems, handle), pq->elems.elem_size);
+  }
+  i = *(size_t *) sc_array_index (&pq->pos, handle);
+  *(size_t *) sc_array_index (&pq->pos, handle) = SC_IPQUEUE_NONE;
+
+  /* fill the hole with the last handle, which may need to move either way */
+  last = *(size_t *) sc_array_pop (&pq->heap);
+  if (last != handle) {
+    sc_ipqueue_sift_up (pq, i, last);
+    if (*(size_t *) sc_array_index (&pq->pos, last) == i) {
+      sc_ipqueue_sift_down (pq, i, last);
+    }
+  }
+}
+
+size_t
+sc_ipqueue_top (sc_ipqueue_t * pq)
+{
+  SC_ASSERT (pq->heap.elem_count > 0);
+
+  return *(size_t *) sc_array_index (&pq->heap, 0);
+}
+
+size_t
+sc_ipqueue_pop (sc_ipqueue_t * pq, void *elem)
+{
+  size_t              top, last;
+
+  SC_ASSERT (pq->heap.elem_count > 0);
+
+  top = *(size_t *) sc_array_index (&pq->heap, 0);
+  if (elem != NULL) {
+    memcpy (elem, sc_array_index (&pq->elems, top), pq->elems.elem_size);
+  }
+  *(size_t *) sc_array_index (&pq->pos, top) = SC_IPQUEUE_NONE;
+  last = *(size_t *) sc_array_pop (&pq->heap);
+  if (last != top) {
+    sc_ipqueue_sift_down (pq, 0, last);
+  }
+
+  return top;
+}
+
+size_t
+sc_ipqueue_pop_n (sc_ipqueue_t * pq, size_t n, size_t * handles)
+{
+  size_t              zz;
+
+  n = SC_MIN (n, pq->heap.elem_count);
+  for (zz = 0; zz < n; ++zz) {
+    handles[zz] = sc_ipqueue_pop (pq, NULL);
+  }
+
+  return n;
+}
+
+void
+sc_ipqueue_heapify (sc_ipqueue_t * pq, sc_array_t * array)
+{
+  const size_t        n = array->elem_count;
+  size_t              zz, *heap, *pos;
+
+  SC_ASSERT (array->elem_size == pq->elems.elem_size);
+
+  /* the previous contents are dropped without keeping their data */
+  sc_array_truncate (&pq->elems);
+  sc_array_truncate (&pq->heap);
+  sc_array_truncate (&pq->pos);
+  sc_array_resize (&pq->elems, n);
+  if (n > 0) {
+    memcpy (pq->elems.array, array->array, n * array->elem_size);
+  }
+  sc_array_resize (&pq->heap, n);
+  sc_array_resize (&pq->pos, n);
+  heap = (size_t *) pq->heap.array;
+  pos = (size_t *) pq->pos.array;
+  for (zz = 0; zz < n; ++zz) {
+    heap[zz] = pos[zz] = zz;
+  }
+
+  /* sift down all inner nodes from the bottom up */
+  for (zz = n > 1 ? (n - 2) / SC_IPQUEUE_ARITY + 1 : 0; zz > 0; --zz) {
+    sc_ipqueue_sift_down (pq, zz - 1, heap[zz - 1]);
+  }
+}
+
+/* memory stamp routines */
+
+#if defined SC_HAVE_SYS_MMAN_H && defined SC_HAVE_MMAP
+#define SC_MSTAMP_MMAP
+#endif
+
+/** Allocate the memory for one stamp according to the flags. */
+static char        *
+sc_mstamp_new_memory (sc_mstamp_t * mst)
+{
+  char               *mem = NULL;
+
+#ifdef SC_MSTAMP_MMAP
+  if (mst->flags & SC_MSTAMP_HUGE_PAGES) {
+    void               *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    /* explicit huge pages are only available if reserved by the admin */
+    p = mmap (NULL, mst->stamp_size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (p == MAP_FAILED) {
+      p = mmap (NULL, mst->stamp_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      SC_CHECK_ABORT (p != MAP_FAILED, "sc_mstamp mmap");
+#if defined SC_HAVE_MADVISE && defined MADV_HUGEPAGE
+      (void) madvise (p, mst->stamp_size, MADV_HUGEPAGE);
+#endif
+    }
+    mem = (char *) p;
+  }
+#endif
+  if (mem == NULL) {
+    /* the pointer is aligned to any builtin type */
+    mem = SC_ALLOC (char, mst->stamp_size);
+  }
+  if (mst->flags & SC_MSTAMP_FIRST_TOUCH) {
+    memset (mem, 0, mst->stamp_size);
+  }
+  return mem;
+}
+
+static void
+sc_mstamp_free_memory (sc_mstamp_t * mst, char *mem)
+{
+#ifdef SC_MSTAMP_MMAP
+  if (mst->flags & SC_MSTAMP_HUGE_PAGES) {
+    int                 retval;
+
+    retval = munmap (mem, mst->stamp_size);
+    SC_CHECK_ABORT (retval == 0, "sc_mstamp munmap");
+    return;
+  }
+#endif
+  SC_FREE (mem);
+}
+
+static void
+sc_mstamp_stamp (sc_mstamp_t * mst)
+{
+  SC_ASSERT (mst != NULL);
+  SC_ASSERT (mst->elem_size > 0);
+  SC_ASSERT (mst->stamp_size > 0);
+
+  /* make new stamp */
+  mst->cur_snext = 0;
+  *(void **) sc_array_push (&mst->remember) =
+    mst->current = sc_mstamp_new_memory (mst);
+}
+
+void
+sc_mstamp_init_flags (sc_mstamp_t * mst, size_t stamp_unit,
+                      size_t elem_size, int flags)
+{
+  SC_ASSERT (mst != NULL);
+
+  /* basic initialization */
+  memset (mst, 0, sizeof (sc_mstamp_t));
+  mst->elem_size = elem_size;
+  mst->flags = flags;
+  sc_array_init (&mst->remember, sizeof (void *));
+
+#ifdef SC_MSTAMP_MMAP
+  if (flags & SC_MSTAMP_HUGE_PAGES) {
+    /* use whole huge pages for each stamp */
+    stamp_unit = SC_MAX (stamp_unit, elem_size);
+    stamp_unit = ((stamp_unit + SC_MSTAMP_HUGE_PAGE - 1) /
+                  SC_MSTAMP_HUGE_PAGE) * SC_MSTAMP_HUGE_PAGE;
+  }
+#endif
+
+  /* how many items per stamp we use */
+  if (elem_size > 0) {
+    mst->per_stamp = stamp_unit / elem_size;
+    if (mst->per_stamp == 0) {
+      /* Each item uses more memory than we had specified for one stamp */
+      mst->per_stamp = 1;
+    }
+    mst->stamp_size = mst->per_stamp * elem_size;
+#ifdef SC_MSTAMP_MMAP
+    if (flags & SC_MSTAMP_HUGE_PAGES) {
+      /* the mapping covers the complete pages */
+      mst->stamp_size = stamp_unit;
+    }
+#endif
+    sc_mstamp_stamp (mst);
+  }
+}
+
+void
+sc_mstamp_init (sc_mstamp_t * mst, size_t stamp_unit, size_t elem_size)
+{
+  sc_mstamp_init_flags (mst, stamp_unit, elem_size, 0);
+}
+
+void
+sc_mstamp_reset (sc_mstamp_t * mst)
+{
+  size_t              znum, zz;
+
+  SC_ASSERT (mst != NULL);
+
+  /* free all memory stamps we have created */
+  znum = mst->remember.elem_count;
+  for (zz = 0; zz < znum; zz++) {
+    sc_mstamp_free_memory (mst,
+                           *(char **) sc_array_index (&mst->remember, zz));
+  }
+  sc_array_reset (&mst->remember);
+}
+
+void
+sc_mstamp_truncate (sc_mstamp_t * mst)
+{
+  /* free all memory in structure; the array mst->remember will be legal */
+  sc_mstamp_reset (mst);
+
+  /* we will use the container is if freshly initialized */
+  if (mst->elem_size > 0) {
+    sc_mstamp_stamp (mst);
+  }
+}
+
+void               *
+sc_mstamp_alloc (sc_mstamp_t * mst)
+{
+  void               *ret;
+
+  SC_ASSERT (mst != NULL);
+
+  if (mst->elem_size == 0) {
+    /* item size zero is legal */
+    return NULL;
+  }
+
+  /* we know that at least one item will fit */
+  SC_ASSERT (mst->current != NULL);
+  SC_ASSERT (mst->cur_snext < mst->per_stamp);
+  ret = mst->current + mst->cur_snext * mst->elem_size;
+
+  /* if this was the last item on the current stamp, we need a new one */
+  if (++mst->cur_snext == mst->per_stamp) {
+    sc_mstamp_stamp (mst);
+  }
+  return ret;
+}
+
+size_t
+sc_mstamp_memory_used (sc_mstamp_t * mst)
+{
+  size_t              s;
+
+  SC_ASSERT (mst != NULL);
+
+  s = sizeof (sc_mstamp_t);
+  s += mst->remember.elem_count * mst->stamp_size;
+  s += sc_array_memory_used (&mst->remember, 0);
+  return s;
+}
+
+void
+sc_mstamp_memory_stats (sc_mstamp_t * mst, size_t *reserved, size_t *touched)
+{
+  size_t              nstamps;
+
+  SC_ASSERT (mst != NULL);
+
+  nstamps = mst->remember.elem_count;
+  if (reserved != NULL) {
+    *reserved = nstamps * mst->stamp_size;
+  }
+  if (touched != NULL) {
+    if (mst->flags & SC_MSTAMP_FIRST_TOUCH) {
+      *touched = nstamps * mst->stamp_size;
+    }
+    else if (nstamps > 0) {
+      /* all but the current stamp are exhausted */
+      *touched = ((nstamps - 1) * mst->per_stamp + mst->cur_snext) *
+        mst->elem_size;
+    }
+    else {
+      *touched = 0;
+    }
+  }
+}
+
+/* arena routines */
+
+/** The default size of a chunk in an arena. */
+#define SC_ARENA_CHUNK_BYTES ((size_t) 1 << 16)
+
+/** Alignment of all memory returned from an arena. */
+#define SC_ARENA_ALIGN ((size_t) 16)
+
+#if (defined SC_ENABLE_PTHREAD || defined SC_ENABLE_OPENMP) && \
+  defined __GNUC__ && defined __ATOMIC_RELAXED
+#define SC_ARENA_THREAD_LOCAL
+#endif
+
+typedef struct sc_arena_chunk
+{
+  char               *mem;
+  size_t              bytes;
+}
+sc_arena_chunk_t;
+
+typedef struct sc_arena_scope
+{
+  size_t              current;
+  size_t              offset;
+}
+sc_arena_scope_t;
+
+struct sc_arena
+{
+  size_t              chunk_bytes;
+  size_t              current;  /**< Number of chunks in use. */
+  size_t              offset;   /**< Bytes used in the last chunk in use. */
+  sc_array_t          chunks;   /**< All chunks including unused ones. */
+  sc_array_t          scopes;   /**< The state saved by each push. */
+  struct sc_arena    *next;     /**< List of default arenas. */
+};
+
+/** All default arenas of the threads, linked by their next member. */
+static sc_arena_t  *sc_arena_defaults = NULL;
+
+/** Default arenas of a previous generation are no longer valid. */
+static int          sc_arena_generation = 0;
+
+#ifdef SC_ARENA_THREAD_LOCAL
+static __thread sc_arena_t *sc_arena_thread = NULL;
+static __thread int sc_arena_thread_generation = -1;
+#else
+static sc_arena_t  *sc_arena_thread = NULL;
+static int          sc_arena_thread_generation = -1;
+#endif
+
+sc_arena_t         *
+sc_arena_new (size_t chunk_bytes)
+{
+  sc_arena_t         *arena;
+
+  arena = SC_ALLOC (sc_arena_t, 1);
+  arena->chunk_bytes = chunk_bytes > 0 ? chunk_bytes : SC_ARENA_CHUNK_BYTES;
+  arena->current = arena->offset = 0;
+  sc_array_init (&arena->chunks, sizeof (sc_arena_chunk_t));
+  sc_array_init (&arena->scopes, sizeof (sc_arena_scope_t));
+  arena->next = NULL;
+
+  return arena;
+}
+
+void
+sc_arena_reset (sc_arena_t * arena)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < arena->chunks.elem_count; ++zz) {
+    SC_FREE (((sc_arena_chunk_t *) sc_array_index (&arena->chunks, zz))->mem);
+  }
+  sc_array_reset (&arena->chunks);
+  sc_array_reset (&arena->scopes);
+  arena->current = arena->offset = 0;
+}
+
+void
+sc_arena_destroy (sc_arena_t * arena)
+{
+  sc_arena_reset (arena);
+  SC_FREE (arena);
+}
+
+void               *
+sc_arena_alloc (sc_arena_t * arena, size_t bytes)
+{
+  sc_arena_chunk_t   *chunk;
+  void               *ret;
+
+  bytes = (bytes + SC_ARENA_ALIGN - 1) & ~(SC_ARENA_ALIGN - 1);
+  if (arena->current == 0 ||
+      arena->offset + bytes > ((sc_arena_chunk_t *)
+                               sc_array_index (&arena->chunks,
+                                               arena->current - 1))->bytes) {
+    /* move on to the next chunk, reusing a released one if possible */
+    if (arena->current < arena->chunks.elem_count) {
+      chunk = (sc_arena_chunk_t *)
+        sc_array_index (&arena->chunks, arena->current);
+      if (chunk->bytes < bytes) {
+        SC_FREE (chunk->mem);
+        chunk->bytes = SC_MAX (arena->chunk_bytes, bytes);
+        chunk->mem = SC_ALLOC (char, chunk->bytes);
+      }
+    }
+    else {
+      chunk = (sc_arena_chunk_t *) sc_array_push (&arena->chunks);
+      chunk->bytes = SC_MAX (arena->chunk_bytes, bytes);
+      chunk->mem = SC_ALLOC (char, chunk->bytes);
+    }
+    ++arena->current;
+    arena->offset = 0;
+  }
+  chunk = (sc_arena_chunk_t *)
+    sc_array_index (&arena->chunks, arena->current - 1);
+  ret = chunk->mem + arena->offset;
+  arena->offset += bytes;
+
+  return ret;
+}
+
+void               *
+sc_arena_calloc (sc_arena_t * arena, size_t nmemb, size_t size)
+{
+  void               *ret = sc_arena_alloc (arena, nmemb * size);
+
+  memset (ret, 0, nmemb * size);
+  return ret;
+}
+
+void
+sc_arena_push (sc_arena_t * arena)
+{
+  sc_arena_scope_t   *scope;
+
+  scope = (sc_arena_scope_t *) sc_array_push (&arena->scopes);
+  scope->current = arena->current;
+  scope->offset = arena->offset;
+}
+
+void
+sc_arena_pop (sc_arena_t * arena)
+{
+  sc_arena_scope_t   *scope;
+
+  SC_ASSERT (arena->scopes.elem_count > 0);
+
+  scope = (sc_arena_scope_t *) sc_array_pop (&arena->scopes);
+  arena->current = scope->current;
+  arena->offset = scope->offset;
+}
+
+size_t
+sc_arena_memory_used (sc_arena_t * arena)
+{
+  size_t              zz, bytes;
+
+  bytes = sizeof (sc_arena_t) + SC_ARRAY_BYTE_ALLOC (&arena->chunks) +
+    SC_ARRAY_BYTE_ALLOC (&arena->scopes);
+  for (zz = 0; zz < arena->chunks.elem_count; ++zz) {
+    bytes += ((sc_arena_chunk_t *) sc_array_index (&arena->chunks,
+                                                   zz))->bytes;
+  }
+  return bytes;
+}
+
+sc_arena_t         *
+sc_arena_default (void)
+{
+  sc_arena_t         *arena;
+
+  if (sc_arena_thread == NULL ||
+      sc_arena_thread_generation != sc_arena_generation) {
+    arena = sc_arena_new (0);
+
+    /* remember the arena to destroy it in sc_arena_finalize */
+#ifdef SC_ARENA_THREAD_LOCAL
+    arena->next = __atomic_load_n (&sc_arena_defaults, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n (&sc_arena_defaults, &arena->next,
+                                         arena, 1, __ATOMIC_RELEASE,
+                                         __ATOMIC_RELAXED));
+#else
+    arena->next = sc_arena_defaults;
+    sc_arena_defaults = arena;
+#endif
+    sc_arena_thread = arena;
+    sc_arena_thread_generation = sc_arena_generation;
+  }
+
+  return sc_arena_thread;
+}
+
+void
+sc_arena_finalize (void)
+{
+  sc_arena_t         *arena, *next;
+
+  for (arena = sc_arena_defaults; arena != NULL; arena = next) {
+    SC_ASSERT (arena->scopes.elem_count == 0);
+    next = arena->next;
+    sc_arena_destroy (arena);
+  }
+  sc_arena_defaults = NULL;
+  sc_arena_thread = NULL;
+  ++sc_arena_generation;
+}
+
+/* mempool routines */
+
+size_t
+sc_mempool_memory_used (sc_mempool_t * mempool)
+{
+  return sizeof (sc_mempool_t) +
+#ifdef SC_MEMPOOL_MSTAMP
+    sc_mstamp_memory_used (&mempool->mstamp) +
+#else
+    obstack_memory_used (&mempool->obstack) +
+#endif
+    sc_array_memory_used (&mempool->freed, 0);
+}
+
+#ifndef SC_MEMPOOL_MSTAMP
+
+static void        *
+sc_containers_malloc (size_t n)
+{
+  return sc_malloc (sc_package_id, n);
+}
+
+static void        *(*obstack_chunk_alloc) (size_t) = sc_containers_malloc;
+
+static void
+sc_containers_free (void *p)
+{
+  sc_free (sc_package_id, p);
+}
+
+static void         (*obstack_chunk_free) (void *) = sc_containers_free;
+
+#endif /* !SC_MEMPOOL_MSTAMP */
+
+/** This function is static; we do not like to expose _ext functions in libsc. */
+static void
+sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
+                     int zero_and_persist, int mstamp_flags)
+{
+  mempool->elem_size = elem_size;
+  mempool->elem_count = 0;
+  mempool->zero_and_persist = zero_and_persist;
+
+#ifdef SC_MEMPOOL_MSTAMP
+  sc_mstamp_init_flags (&mempool->mstamp, 4096, elem_size, mstamp_flags);
+#else
+  obstack_init (&mempool->obstack);
+#endif
+  sc_array_init (&mempool->freed, sizeof (void *));
+}
+
+void
+sc_mempool_init (sc_mempool_t * mempool, size_t elem_size)
+{
+  sc_mempool_init_ext (mempool, elem_size, 0, 0);
+}
+
+/** This function is static; we do not like to expose _ext functions in libsc. */
+static sc_mempool_t *
+sc_mempool_new_ext (size_t elem_size, int zero_and_persist, int mstamp_flags)
+{
+  sc_mempool_t       *mempool;
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (elem_size <= (size_t) INT_MAX);    /* obstack limited to int */
+
+  mempool = SC_ALLOC (sc_mempool_t, 1);
+
+  sc_mempool_init_ext (mempool, elem_size, zero_and_persist, mstamp_flags);
+
+  return mempool;
+}
+
+sc_mempool_t       *
+sc_mempool_new (size_t elem_size)
+{
+  return sc_mempool_new_ext (elem_size, 0, 0);
+}
+
+sc_mempool_t       *
+sc_mempool_new_zero_and_persist (size_t elem_size)
+{
+  return sc_mempool_new_ext (elem_size, 1, 0);
+}
+
+sc_mempool_t       *
+sc_mempool_new_flags (size_t elem_size, int zero_and_persist,
+                      int mstamp_flags)
+{
+  return sc_mempool_new_ext (elem_size, zero_and_persist, mstamp_flags);
+}
+
+void
+sc_mempool_reset (sc_mempool_t * mempool)
+{
+  sc_array_reset (&mempool->freed);
+#ifdef SC_MEMPOOL_MSTAMP
+  sc_mstamp_reset (&mempool->mstamp);
+#else
+  obstack_free (&mempool->obstack, NULL);
+#endif
+}
+
+void
+sc_mempool_destroy (sc_mempool_t * mempool)
+{
+  sc_mempool_reset (mempool);
+  SC_FREE (mempool);
+}
+
+void
+sc_mempool_destroy_null (sc_mempool_t ** pmempool)
+{
+  SC_ASSERT (pmempool != NULL);
+  SC_ASSERT (*pmempool != NULL);
+
+  sc_mempool_destroy (*pmempool);
+  *pmempool = NULL;
+}
+
+void
+sc_mempool_truncate (sc_mempool_t * mempool)
+{
+  sc_array_reset (&mempool->freed);
+#ifdef SC_MEMPOOL_MSTAMP
+  sc_mstamp_truncate (&mempool->mstamp);
+#else
+  obstack_free (&mempool->obstack, NULL);
+  obstack_init (&mempool->obstack);
+#endif
+  mempool->elem_count = 0;
+}
+
+void
+sc_mempool_alloc_n (sc_mempool_t * mempool, size_t n, void **out)
+{
+  size_t              take, zz;
+  char               *run;
+  sc_array_t         *freed = &mempool->freed;
+
+  mempool->elem_count += n;
+
+  /* recycle from the free list in one copy */
+  take = SC_MIN (n, freed->elem_count);
+  if (take > 0) {
+    memcpy (out, sc_array_index (freed, freed->elem_count - take),
+            take * sizeof (void *));
+    sc_array_resize (freed, freed->elem_count - take);
+  }
+  if (take < n) {
+#ifdef SC_MEMPOOL_MSTAMP
+    sc_mstamp_t        *mst = &mempool->mstamp;
+    size_t              len, iz;
+
+    /* hand out the remaining elements as runs from the current stamp */
+    for (zz = take; zz < n; zz += len) {
+      SC_ASSERT (mst->cur_snext < mst->per_stamp);
+      len = SC_MIN (n - zz, mst->per_stamp - mst->cur_snext);
+      run = mst->current + mst->cur_snext * mst->elem_size;
+      if (mempool->zero_and_persist) {
+        memset (run, 0, len * mst->elem_size);
+      }
+      for (iz = 0; iz < len; ++iz) {
+        out[zz + iz] = run + iz * mst->elem_size;
+      }
+      if ((mst->cur_snext += len) == mst->per_stamp) {
+        sc_mstamp_stamp (mst);
+      }
+    }
+#else
+    const size_t        esize = mempool->elem_size;
+    size_t              len, iz;
+
+    /* obstack sizes are int, so huge requests take several runs */
+    for (zz = take; zz < n; zz += len) {
+      len = SC_MIN (n - zz, (size_t) INT_MAX / SC_MAX (esize, 1));
+      run = (char *) obstack_alloc (&mempool->obstack, (int) (len * esize));
+      if (mempool->zero_and_persist) {
+        memset (run, 0, len * esize);
+      }
+      for (iz = 0; iz < len; ++iz) {
+        out[zz + iz] = run + iz * esize;
+      }
+    }
+#endif
+  }
+
+#ifdef SC_ENABLE_DEBUG
+  if (!mempool->zero_and_persist) {
+    for (zz = 0; zz < n; ++zz) {
+      memset (out[zz], -1, mempool->elem_size);
+    }
+  }
+#endif
+}
+
+void
+sc_mempool_free_n (sc_mempool_t * mempool, size_t n, void **elems)
+{
+  size_t              old_count;
+  sc_array_t         *freed = &mempool->freed;
+
+  SC_ASSERT (mempool->elem_count >= n);
+
+#ifdef SC_ENABLE_DEBUG
+  if (!mempool->zero_and_persist) {
+    size_t              zz;
+
+    for (zz = 0; zz < n; ++zz) {
+      memset (elems[zz], -1, mempool->elem_size);
+    }
+  }
+#endif
+
+  mempool->elem_count -= n;
+
+  /* push all pointers onto the free list in one copy */
+  if (n > 0) {
+    old_count = freed->elem_count;
+    sc_array_resize (freed, old_count + n);
+    memcpy (sc_array_index (freed, old_count), elems, n * sizeof (void *));
+  }
+}
+
+#ifdef SC_MEMPOOL_MSTAMP
+
+/** A stamp of a mempool and its position in the list of stamps. */
+typedef struct sc_mempool_stamp
+{
+  uintptr_t           mem;
+  size_t              index;
+}
+sc_mempool_stamp_t;
+
+static int
+sc_mempool_stamp_compare (const void *v1, const void *v2)
+{
+  const uintptr_t     m1 = ((const sc_mempool_stamp_t *) v1)->mem;
+  const uintptr_t     m2 = ((const sc_mempool_stamp_t *) v2)->mem;
+
+  return m1 < m2 ? -1 : m1 > m2;
+}
+
+/** Count the freed elements in every stamp of a mempool.
+ * \param [out] owner  If not NULL, receives the stamp of every element
+ *                     of the free list.
+ * \return             Allocated array with a count per stamp.
+ */
+static size_t      *
+sc_mempool_occupancy (sc_mempool_t * mempool, size_t *owner)
+{
+  sc_mstamp_t        *mst = &mempool->mstamp;
+  sc_array_t         *freed = &mempool->freed;
+  const size_t        nstamps = mst->remember.elem_count;
+  size_t              zz, lo, hi, mid;
+  size_t             *counts;
+  uintptr_t           p;
+  sc_mempool_stamp_t *stamps;
+
+  counts = SC_ALLOC_ZERO (size_t, nstamps);
+  if (freed->elem_count == 0) {
+    return counts;
+  }
+  SC_ASSERT (nstamps > 0);
+
+  /* sort the stamps by address to look up the elements */
+  stamps = SC_ALLOC (sc_mempool_stamp_t, nstamps);
+  for (zz = 0; zz < nstamps; ++zz) {
+    stamps[zz].mem = (uintptr_t) *(char **) sc_array_index (&mst->remember,
+                                                             zz);
+    stamps[zz].index = zz;
+  }
+  qsort (stamps, nstamps, sizeof (sc_mempool_stamp_t),
+         sc_mempool_stamp_compare);
+  for (zz = 0; zz < freed->elem_count; ++zz) {
+    p = (uintptr_t) *(void **) sc_array_index (freed, zz);
+
+    /* the last stamp that begins at or before the element */
+    lo = 0;
+    hi = nstamps - 1;
+    while (lo < hi) {
+      mid = lo + (hi - lo + 1) / 2;
+      if (stamps[mid].mem <= p) {
+        lo = mid;
+      }
+      else {
+        hi = mid - 1;
+      }
+    }
+    SC_ASSERT (stamps[lo].mem <= p && p < stamps[lo].mem + mst->stamp_size);
+    ++counts[stamps[lo].index];
+    if (owner != NULL) {
+      owner[zz] = stamps[lo].index;
+    }
+  }
+  SC_FREE (stamps);
+
+  return counts;
+}
+
+#endif /* SC_MEMPOOL_MSTAMP */
+
+void
+sc_mempool_get_stats (sc_mempool_t * mempool, sc_mempool_stats_t * stats)
+{
+  const size_t        total =
+    mempool->elem_count + mempool->freed.elem_count;
+#ifdef SC_MEMPOOL_MSTAMP
+  sc_mstamp_t        *mst = &mempool->mstamp;
+  size_t              zz, *counts;
+#else
+  struct _obstack_chunk *chunk;
+#endif
+
+  SC_ASSERT (stats != NULL);
+
+  stats->live = mempool->elem_count;
+  stats->freed = mempool->freed.elem_count;
+  stats->fragmentation = total > 0 ? stats->freed / (double) total : 0.;
+  stats->chunks = stats->free_chunks = stats->reserved = 0;
+#ifdef SC_MEMPOOL_MSTAMP
+  stats->chunks = mst->remember.elem_count;
+  sc_mstamp_memory_stats (mst, &stats->reserved, NULL);
+  counts = sc_mempool_occupancy (mempool, NULL);
+  for (zz = 0; zz + 1 < stats->chunks; ++zz) {
+    stats->free_chunks += counts[zz] == mst->per_stamp;
+  }
+  SC_FREE (counts);
+#else
+  for (chunk = mempool->obstack.chunk; chunk != NULL; chunk = chunk->prev) {
+    ++stats->chunks;
+    stats->reserved += (size_t) (chunk->limit - (char *) chunk);
+  }
+#endif
+}
+
+size_t
+sc_mempool_trim (sc_mempool_t * mempool)
+{
+#ifdef SC_MEMPOOL_MSTAMP
+  sc_mstamp_t        *mst = &mempool->mstamp;
+  sc_array_t         *freed = &mempool->freed;
+  const size_t        nstamps = mst->remember.elem_count;
+  size_t              zz, kept, released = 0;
+  size_t             *counts, *owner;
+  void              **elems;
+  char              **mems;
+
+  if (freed->elem_count == 0) {
+    return 0;
+  }
+
+  /* mark the empty stamps; the current one is last and always kept */
+  owner = SC_ALLOC (size_t, freed->elem_count);
+  counts = sc_mempool_occupancy (mempool, owner);
+  for (zz = 0; zz + 1 < nstamps; ++zz) {
+    counts[zz] = counts[zz] == mst->per_stamp;
+  }
+  counts[nstamps - 1] = counts[nstamps - 1] == mst->cur_snext;
+  if (counts[nstamps - 1]) {
+    mst->cur_snext = 0;
+  }
+
+  /* drop the freed elements of the empty stamps */
+  elems = (void **) freed->array;
+  for (kept = 0, zz = 0; zz < freed->elem_count; ++zz) {
+    if (!counts[owner[zz]]) {
+      elems[kept++] = elems[zz];
+    }
+  }
+  sc_array_resize (freed, kept);
+  sc_array_shrink_to_fit (freed);
+
+  /* release the empty stamps but the current one */
+  mems = (char **) mst->remember.array;
+  for (kept = 0, zz = 0; zz + 1 < nstamps; ++zz) {
+    if (counts[zz]) {
+      sc_mstamp_free_memory (mst, mems[zz]);
+      released += mst->stamp_size;
+    }
+    else {
+      mems[kept++] = mems[zz];
+    }
+  }
+  mems[kept++] = mems[nstamps - 1];
+  sc_array_resize (&mst->remember, kept);
+  sc_array_shrink_to_fit (&mst->remember);
+
+  SC_FREE (counts);
+  SC_FREE (owner);
+  return released;
+#else
+  return 0;
+#endif
+}
+
+/* thread-safe mempool routines */
+
+struct sc_mempool_mt
+{
+  size_t              elem_size;
+  int                 zero_and_persist;
+  int                 num_caches;       /* number of initialized caches */
+  long                elem_count;       /* collected from reset caches */
+  sc_mstamp_t         mstamp;           /* source of fresh elements */
+  sc_array_t          depot;            /* holds the freed elements */
+  sc_containers_lock_t lock;            /* protects all of the above */
+};
+
+static sc_mempool_mt_t *
+sc_mempool_mt_new_ext (size_t elem_size, int zero_and_persist)
+{
+  sc_mempool_mt_t    *mempool;
+
+  SC_ASSERT (elem_size > 0);
+
+  mempool = SC_ALLOC (sc_mempool_mt_t, 1);
+  mempool->elem_size = elem_size;
+  mempool->zero_and_persist = zero_and_persist;
+  mempool->num_caches = 0;
+  mempool->elem_count = 0;
+
+  /* every refill takes a magazine, so we use larger stamps */
+  sc_mstamp_init (&mempool->mstamp,
+                  SC_MAX (4096, SC_MEMPOOL_MAGAZINE * elem_size), elem_size);
+  sc_array_init (&mempool->depot, sizeof (void *));
+  sc_containers_lock_init (&mempool->lock);
+
+  return mempool;
+}
+
+sc_mempool_mt_t    *
+sc_mempool_mt_new (size_t elem_size)
+{
+  return sc_mempool_mt_new_ext (elem_size, 0);
+}
+
+sc_mempool_mt_t    *
+sc_mempool_mt_new_zero_and_persist (size_t elem_size)
+{
+  return sc_mempool_mt_new_ext (elem_size, 1);
+}
+
+void
+sc_mempool_mt_destroy (sc_mempool_mt_t * mempool)
+{
+  SC_ASSERT (mempool->num_caches == 0);
+
+  sc_containers_lock_destroy (&mempool->lock);
+  sc_array_reset (&mempool->depot);
+  sc_mstamp_reset (&mempool->mstamp);
+  SC_FREE (mempool);
+}
+
+size_t
+sc_mempool_mt_elem_count (sc_mempool_mt_t * mempool)
+{
+  long                count;
+
+  sc_containers_lock (&mempool->lock);
+  count = mempool->elem_count;
+  sc_containers_unlock (&mempool->lock);
+
+  SC_ASSERT (count >= 0);
+  return (size_t) count;
+}
+
+size_t
+sc_mempool_mt_memory_used (sc_mempool_mt_t * mempool)
+{
+  size_t              mem;
+
+  sc_containers_lock (&mempool->lock);
+  mem = sizeof (sc_mempool_mt_t) +
+    sc_mstamp_memory_used (&mempool->mstamp) +
+    sc_array_memory_used (&mempool->depot, 0);
+  sc_containers_unlock (&mempool->lock);
+
+  return mem;
+}
+
+void
+sc_mempool_cache_init (sc_mempool_cache_t * cache, sc_mempool_mt_t * mempool)
+{
+  cache->pool = mempool;
+  cache->elem_size = mempool->elem_size;
+  cache->elem_count = 0;
+  cache->zero_and_persist = mempool->zero_and_persist;
+  cache->num_cached = 0;
+
+  sc_containers_lock (&mempool->lock);
+  ++mempool->num_caches;
+  sc_containers_unlock (&mempool->lock);
+}
+
+/** Move elements from the top of the cache into the depot.
+ * The pool must be locked by the caller.
+ */
+static void
+sc_mempool_cache_give (sc_mempool_cache_t * cache, int num)
+{
+  sc_array_t         *depot = &cache->pool->depot;
+  size_t              old_count = depot->elem_count;
+
+  SC_ASSERT (0 <= num && num <= cache->num_cached);
+
+  if (num > 0) {
+    cache->num_cached -= num;
+    sc_array_resize (depot, old_count + num);
+    memcpy (sc_array_index (depot, old_count),
+            cache->cached + cache->num_cached, num * sizeof (void *));
+  }
+}
+
+void
+sc_mempool_cache_reset (sc_mempool_cache_t * cache)
+{
+  sc_mempool_mt_t    *mempool = cache->pool;
+
+  sc_containers_lock (&mempool->lock);
+  sc_mempool_cache_give (cache, cache->num_cached);
+  mempool->elem_count += cache->elem_count;
+  --mempool->num_caches;
+  sc_containers_unlock (&mempool->lock);
+
+  cache->pool = NULL;
+  cache->elem_count = 0;
+}
+
+void
+sc_mempool_cache_refill (sc_mempool_cache_t * cache)
+{
+  int                 num, i;
+  void               *elem;
+  size_t              take;
+  sc_mempool_mt_t    *mempool = cache->pool;
+  sc_array_t         *depot = &mempool->depot;
+
+  SC_ASSERT (cache->num_cached == 0);
+
+  sc_containers_lock (&mempool->lock);
+
+  /* recycle freed elements first */
+  take = SC_MIN (depot->elem_count, (size_t) SC_MEMPOOL_MAGAZINE);
+  if (take > 0) {
+    memcpy (cache->cached, sc_array_index (depot, depot->elem_count - take),
+            take * sizeof (void *));
+    sc_array_resize (depot, depot->elem_count - take);
+  }
+  num = (int) take;
+
+  /* fresh elements complete the magazine */
+  for (i = num; i < SC_MEMPOOL_MAGAZINE; ++i) {
+    elem = sc_mstamp_alloc (&mempool->mstamp);
+    if (mempool->zero_and_persist) {
+      memset (elem, 0, mempool->elem_size);
+    }
+    cache->cached[i] = elem;
+  }
+  cache->num_cached = SC_MEMPOOL_MAGAZINE;
+
+  sc_containers_unlock (&mempool->lock);
+}
+
+void
+sc_mempool_cache_flush (sc_mempool_cache_t * cache)
+{
+  sc_mempool_mt_t    *mempool = cache->pool;
+
+  /* keep half of the elements to avoid thrashing on the boundary */
+  sc_containers_lock (&mempool->lock);
+  sc_mempool_cache_give (cache, SC_MEMPOOL_MAGAZINE);
+  sc_containers_unlock (&mempool->lock);
+}
+
+/* list routines */
+
+size_t
+sc_list_memory_used (sc_list_t * list, int is_dynamic)
+{
+  return (is_dynamic ? sizeof (sc_list_t) : 0) +
+    (list->allocator_owned ? sc_mempool_memory_used (list->allocator) : 0);
+}
+
+sc_list_t          *
+sc_list_new (sc_mempool_t * allocator)
+{
+  sc_list_t          *list;
+
+  list = SC_ALLOC (sc_list_t, 1);
+
+  list->elem_count = 0;
+  list->first = NULL;
+  list->last = NULL;
+
+  if (allocator != NULL) {
+    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
+    list->allocator = allocator;
+    list->allocator_owned = 0;
+  }
+  else {
+    list->allocator = sc_mempool_new (sizeof (sc_link_t));
+    list->allocator_owned = 1;
+  }
+
+  return list;
+}
+
+void
+sc_list_destroy (sc_list_t * list)
 {
 
   if (list->allocator_owned) {
@@ -1166,6 +3653,200 @@ sc_list_pop (sc_list_t * list)
   return data;
 }
 
+/* unrolled list routines */
+
+/** One node of an unrolled list; the items follow the header. */
+typedef struct sc_ulist_node
+{
+  sc_dlink_t          link;
+  size_t              begin, end;       /**< range of used items */
+}
+sc_ulist_node_t;
+
+/* items start at this alignment within a node */
+#define SC_ULIST_ALIGN 16
+#define SC_ULIST_ROUNDUP(n) \
+  (((n) + SC_ULIST_ALIGN - 1) / SC_ULIST_ALIGN * SC_ULIST_ALIGN)
+
+/* default number of bytes of item storage in a node */
+#define SC_ULIST_NODE_BYTES 1024
+
+size_t
+sc_ulist_node_size (size_t elem_size, size_t per_node)
+{
+  SC_ASSERT (elem_size > 0 && per_node > 0);
+  return SC_ULIST_ROUNDUP (SC_ULIST_ROUNDUP (sizeof (sc_ulist_node_t)) +
+                           elem_size * per_node);
+}
+
+size_t
+sc_ulist_memory_used (sc_ulist_t * ulist)
+{
+  return sizeof (sc_ulist_t) + (ulist->allocator_owned ?
+                                sc_mempool_memory_used (ulist->allocator) :
+                                ulist->nodes.elem_count *
+                                ulist->allocator->elem_size);
+}
+
+sc_ulist_t         *
+sc_ulist_new (size_t elem_size, size_t per_node, sc_mempool_t * allocator)
+{
+  size_t              node_size;
+  sc_ulist_t         *ulist;
+
+  SC_ASSERT (elem_size > 0);
+
+  if (per_node == 0) {
+    per_node = SC_MAX (SC_ULIST_NODE_BYTES / elem_size, 4);
+  }
+  node_size = sc_ulist_node_size (elem_size, per_node);
+
+  ulist = SC_ALLOC (sc_ulist_t, 1);
+  ulist->elem_size = elem_size;
+  ulist->elem_count = 0;
+  ulist->per_node = per_node;
+  ulist->data_offset = SC_ULIST_ROUNDUP (sizeof (sc_ulist_node_t));
+  sc_dlist_init (&ulist->nodes);
+  if (allocator != NULL) {
+    SC_ASSERT (allocator->elem_size == node_size);
+    ulist->allocator = allocator;
+    ulist->allocator_owned = 0;
+  }
+  else {
+    ulist->allocator = sc_mempool_new (node_size);
+    ulist->allocator_owned = 1;
+  }
+
+  return ulist;
+}
+
+void
+sc_ulist_destroy (sc_ulist_t * ulist)
+{
+  if (ulist->allocator_owned) {
+    sc_mempool_destroy (ulist->allocator);
+  }
+  else {
+    sc_ulist_reset (ulist);
+  }
+  SC_FREE (ulist);
+}
+
+void
+sc_ulist_reset (sc_ulist_t * ulist)
+{
+  sc_dlink_t         *link;
+
+  while ((link = sc_dlist_pop (&ulist->nodes)) != NULL) {
+    sc_mempool_free (ulist->allocator,
+                     SC_DLIST_ENTRY (link, sc_ulist_node_t, link));
+  }
+  ulist->elem_count = 0;
+}
+
+static inline void *
+sc_ulist_item (sc_ulist_t * ulist, sc_ulist_node_t * node, size_t i)
+{
+  return (char *) node + ulist->data_offset + i * ulist->elem_size;
+}
+
+static inline sc_ulist_node_t *
+sc_ulist_node (sc_dlink_t * link)
+{
+  SC_ASSERT (link != NULL);
+  return SC_DLIST_ENTRY (link, sc_ulist_node_t, link);
+}
+
+void               *
+sc_ulist_push (sc_ulist_t * ulist)
+{
+  sc_dlink_t         *link;
+  sc_ulist_node_t    *node;
+
+  link = sc_dlist_last (&ulist->nodes);
+  if (link == NULL || (node = sc_ulist_node (link))->end == ulist->per_node) {
+    node = (sc_ulist_node_t *) sc_mempool_alloc (ulist->allocator);
+    node->begin = node->end = 0;
+    sc_dlist_append (&ulist->nodes, &node->link);
+  }
+  ++ulist->elem_count;
+  return sc_ulist_item (ulist, node, node->end++);
+}
+
+void               *
+sc_ulist_push_front (sc_ulist_t * ulist)
+{
+  sc_dlink_t         *link;
+  sc_ulist_node_t    *node;
+
+  link = sc_dlist_first (&ulist->nodes);
+  if (link == NULL || (node = sc_ulist_node (link))->begin == 0) {
+    node = (sc_ulist_node_t *) sc_mempool_alloc (ulist->allocator);
+    node->begin = node->end = ulist->per_node;
+    sc_dlist_prepend (&ulist->nodes, &node->link);
+  }
+  ++ulist->elem_count;
+  return sc_ulist_item (ulist, node, --node->begin);
+}
+
+void               *
+sc_ulist_first (sc_ulist_t * ulist)
+{
+  sc_ulist_node_t    *node;
+
+  SC_ASSERT (ulist->elem_count > 0);
+  node = sc_ulist_node (sc_dlist_first (&ulist->nodes));
+  return sc_ulist_item (ulist, node, node->begin);
+}
+
+void               *
+sc_ulist_last (sc_ulist_t * ulist)
+{
+  sc_ulist_node_t    *node;
+
+  SC_ASSERT (ulist->elem_count > 0);
+  node = sc_ulist_node (sc_dlist_last (&ulist->nodes));
+  return sc_ulist_item (ulist, node, node->end - 1);
+}
+
+void
+sc_ulist_pop (sc_ulist_t * ulist, void *elem)
+{
+  sc_ulist_node_t    *node;
+
+  SC_ASSERT (ulist->elem_count > 0);
+  node = sc_ulist_node (sc_dlist_first (&ulist->nodes));
+  SC_ASSERT (node->begin < node->end);
+  if (elem != NULL) {
+    memcpy (elem, sc_ulist_item (ulist, node, node->begin),
+            ulist->elem_size);
+  }
+  if (++node->begin == node->end) {
+    sc_dlist_remove (&ulist->nodes, &node->link);
+    sc_mempool_free (ulist->allocator, node);
+  }
+  --ulist->elem_count;
+}
+
+void
+sc_ulist_pop_back (sc_ulist_t * ulist, void *elem)
+{
+  sc_ulist_node_t    *node;
+
+  SC_ASSERT (ulist->elem_count > 0);
+  node = sc_ulist_node (sc_dlist_last (&ulist->nodes));
+  SC_ASSERT (node->begin < node->end);
+  if (elem != NULL) {
+    memcpy (elem, sc_ulist_item (ulist, node, node->end - 1),
+            ulist->elem_size);
+  }
+  if (--node->end == node->begin) {
+    sc_dlist_remove (&ulist->nodes, &node->link);
+    sc_mempool_free (ulist->allocator, node);
+  }
+  --ulist->elem_count;
+}
+
 /* hash table routines */
 
 unsigned int
@@ -1208,30 +3889,263 @@ sc_hash_function_string (const void *s, const void *u)
   }
 }
 
+/* constants of the wyhash function by Wang Yi, public domain */
+static const uint64_t sc_hash_secret[4] = {
+  0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+  0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+/** Multiply two 64 bit numbers and fold the 128 bit result by xor. */
+static inline       uint64_t
+sc_hash_mum (uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+  __uint128_t         r = (__uint128_t) a * b;
+
+  return (uint64_t) r ^ (uint64_t) (r >> 64);
+#else
+  uint64_t            ha = a >> 32, hb = b >> 32;
+  uint64_t            la = (uint32_t) a, lb = (uint32_t) b;
+  uint64_t            rh, rm0, rm1, rl, t, lo;
+  uint64_t            carry;
+
+  rh = ha * hb;
+  rm0 = ha * lb;
+  rm1 = hb * la;
+  rl = la * lb;
+  t = rl + (rm0 << 32);
+  carry = t < rl;
+  lo = t + (rm1 << 32);
+  carry += lo < t;
+  return lo ^ (rh + (rm0 >> 32) + (rm1 >> 32) + carry);
+#endif
+}
+
+static inline       uint64_t
+sc_hash_read8 (const unsigned char *p)
+{
+  uint64_t            v;
+
+  memcpy (&v, p, sizeof (uint64_t));
+  return v;
+}
+
+static inline       uint64_t
+sc_hash_read4 (const unsigned char *p)
+{
+  uint32_t            v;
+
+  memcpy (&v, p, sizeof (uint32_t));
+  return v;
+}
+
+/** Reduce a 64 bit hash value to the size of an unsigned int. */
+static inline unsigned int
+sc_hash_fold (uint64_t h)
+{
+  return (unsigned int) (h ^ (h >> 32));
+}
+
+uint64_t
+sc_hash_bytes (const void *data, size_t len, uint64_t seed)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  const uint64_t     *s = sc_hash_secret;
+  size_t              i;
+  uint64_t            a, b, see1, see2;
+
+  seed ^= s[0];
+  if (len <= 16) {
+    if (len >= 4) {
+      /* two possibly overlapping reads from each end */
+      a = (sc_hash_read4 (p) << 32) | sc_hash_read4 (p + ((len >> 3) << 2));
+      b = (sc_hash_read4 (p + len - 4) << 32) |
+        sc_hash_read4 (p + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0) {
+      a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) |
+        p[len - 1];
+      b = 0;
+    }
+    else {
+      a = b = 0;
+    }
+  }
+  else {
+    i = len;
+    if (i > 48) {
+      /* three independent lanes for instruction level parallelism */
+      see1 = see2 = seed;
+      do {
+        seed = sc_hash_mum (sc_hash_read8 (p) ^ s[1],
+                            sc_hash_read8 (p + 8) ^ seed);
+        see1 = sc_hash_mum (sc_hash_read8 (p + 16) ^ s[2],
+                            sc_hash_read8 (p + 24) ^ see1);
+        see2 = sc_hash_mum (sc_hash_read8 (p + 32) ^ s[3],
+                            sc_hash_read8 (p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      }
+      while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = sc_hash_mum (sc_hash_read8 (p) ^ s[1],
+                          sc_hash_read8 (p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = sc_hash_read8 (p + i - 16);
+    b = sc_hash_read8 (p + i - 8);
+  }
+  return sc_hash_mum (s[1] ^ (uint64_t) len,
+                      sc_hash_mum (a ^ s[1], b ^ seed));
+}
+
+unsigned int
+sc_hash_function_string_fast (const void *s, const void *u)
+{
+  return sc_hash_fold (sc_hash_bytes (s, strlen ((const char *) s), 0));
+}
+
+unsigned int
+sc_hash_u32 (const void *v, const void *u)
+{
+  uint32_t            h = *(const uint32_t *) v;
+
+  /* finalization of MurmurHash3 by Austin Appleby, public domain */
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return (unsigned int) h;
+}
+
+unsigned int
+sc_hash_u64 (const void *v, const void *u)
+{
+  return sc_hash_fold (sc_hash_mum (*(const uint64_t *) v ^ sc_hash_secret[0],
+                                    sc_hash_secret[1]));
+}
+
+unsigned int
+sc_hash_u128 (const void *v, const void *u)
+{
+  const sc_uint128_t *k = (const sc_uint128_t *) v;
+
+  return sc_hash_fold (sc_hash_mum (k->high_bits ^ sc_hash_secret[0],
+                                    k->low_bits ^ sc_hash_secret[1]));
+}
+
 size_t
 sc_hash_memory_used (sc_hash_t * hash)
 {
   return sizeof (sc_hash_t) +
     sc_array_memory_used (hash->slots, 1) +
-    (hash->allocator_owned ? sc_mempool_memory_used (hash->allocator) : 0);
+    (hash->old_slots != NULL ? sc_array_memory_used (hash->old_slots, 1) : 0)
+    + (hash->allocator_owned ? sc_mempool_memory_used (hash->allocator) : 0);
 }
 
 static const size_t sc_hash_minimal_size = (size_t) ((1 << 8) - 1);
 static const size_t sc_hash_shrink_interval = (size_t) (1 << 8);
+static const size_t sc_hash_migrate_buckets = (size_t) (1 << 4);
+
+/** Allocate a slot array of lists that use the allocator of the hash. */
+static sc_array_t  *
+sc_hash_new_slots (sc_hash_t * hash, size_t new_size)
+{
+  size_t              i;
+  sc_list_t          *new_list;
+  sc_array_t         *new_slots;
+
+  new_slots = sc_array_new (sizeof (sc_list_t));
+  sc_array_resize (new_slots, new_size);
+  for (i = 0; i < new_size; ++i) {
+    new_list = (sc_list_t *) sc_array_index (new_slots, i);
+    sc_list_init (new_list, hash->allocator);
+  }
+  return new_slots;
+}
+
+/** Move the links of one slot list into the current slot array.
+ * The link memory is reused and not returned to the allocator.
+ * \return      The number of objects moved.
+ */
+static size_t
+sc_hash_relink_list (sc_hash_t * hash, sc_list_t * old_list)
+{
+  size_t              j, moved;
+  sc_list_t          *new_list;
+  sc_link_t          *lynk, *temp;
+  sc_array_t         *new_slots = hash->slots;
+
+  moved = 0;
+  lynk = old_list->first;
+  while (lynk != NULL) {
+    temp = lynk->next;
+
+    /* prepend the link to its new slot list */
+    j = hash->hash_fn (lynk->data, hash->user_data) % new_slots->elem_count;
+    new_list = (sc_list_t *) sc_array_index (new_slots, j);
+    lynk->next = new_list->first;
+    new_list->first = lynk;
+    if (new_list->last == NULL) {
+      new_list->last = lynk;
+    }
+    ++new_list->elem_count;
+    ++moved;
+
+    lynk = temp;
+  }
+  SC_ASSERT (moved == old_list->elem_count);
+  sc_list_unlink (old_list);
+
+  return moved;
+}
+
+/** Migrate a bounded number of old slots during an incremental resize.
+ * When the last old slot has been migrated, the old slot array is freed.
+ * \param [in] num_buckets      Maximum number of old slots to migrate.
+ */
+static void
+sc_hash_migrate (sc_hash_t * hash, size_t num_buckets)
+{
+  size_t              end;
+  sc_array_t         *old_slots = hash->old_slots;
+
+  if (old_slots == NULL) {
+    return;
+  }
+
+  ++hash->migrate_steps;
+  end = SC_MIN (hash->migrate_next + num_buckets, old_slots->elem_count);
+  for (; hash->migrate_next < end; ++hash->migrate_next) {
+    hash->migrate_moved += sc_hash_relink_list
+      (hash, (sc_list_t *) sc_array_index (old_slots, hash->migrate_next));
+  }
+  if (hash->migrate_next == old_slots->elem_count) {
+    sc_array_destroy (old_slots);
+    hash->old_slots = NULL;
+    hash->migrate_next = 0;
+  }
+}
 
 static void
 sc_hash_maybe_resize (sc_hash_t * hash)
 {
-  size_t              i, j;
+  size_t              i;
   size_t              new_size, new_count;
-  sc_list_t          *old_list, *new_list;
-  sc_link_t          *lynk, *temp;
-  sc_array_t         *new_slots;
+  sc_list_t          *old_list;
   sc_array_t         *old_slots = hash->slots;
 
   SC_ASSERT (old_slots->elem_count > 0);
 
   ++hash->resize_checks;
+  if (hash->old_slots != NULL) {
+    /* we do not start another resize while one is in progress */
+    return;
+  }
   if (hash->elem_count >= 4 * old_slots->elem_count) {
     new_size = 4 * old_slots->elem_count - 1;
   }
@@ -1247,49 +4161,32 @@ sc_hash_maybe_resize (sc_hash_t * hash)
   ++hash->resize_actions;
 
   /* allocate new slot array */
-  new_slots = sc_array_new (sizeof (sc_list_t));
-  sc_array_resize (new_slots, new_size);
-  for (i = 0; i < new_size; ++i) {
-    new_list = (sc_list_t *) sc_array_index (new_slots, i);
-    sc_list_init (new_list, hash->allocator);
+  hash->slots = sc_hash_new_slots (hash, new_size);
+
+  if (hash->incremental) {
+    /* the old slots are migrated bit by bit in subsequent operations */
+    hash->old_slots = old_slots;
+    hash->migrate_next = 0;
+    return;
   }
 
   /* go through the old slots and move data to the new slots */
   new_count = 0;
   for (i = 0; i < old_slots->elem_count; ++i) {
     old_list = (sc_list_t *) sc_array_index (old_slots, i);
-    lynk = old_list->first;
-    while (lynk != NULL) {
-      /* insert data into new slot list */
-      j = hash->hash_fn (lynk->data, hash->user_data) % new_size;
-      new_list = (sc_list_t *) sc_array_index (new_slots, j);
-      (void) sc_list_prepend (new_list, lynk->data);
-      ++new_count;
-
-      /* remove old list element */
-      temp = lynk->next;
-      sc_mempool_free (old_list->allocator, lynk);
-      lynk = temp;
-      --old_list->elem_count;
-    }
-    SC_ASSERT (old_list->elem_count == 0);
-    old_list->first = old_list->last = NULL;
+    new_count += sc_hash_relink_list (hash, old_list);
   }
   SC_ASSERT (new_count == hash->elem_count);
 
   /* replace old slots by new slots */
   sc_array_destroy (old_slots);
-  hash->slots = new_slots;
 }
 
 sc_hash_t          *
 sc_hash_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
              void *user_data, sc_mempool_t * allocator)
 {
-  size_t              i;
   sc_hash_t          *hash;
-  sc_list_t          *list;
-  sc_array_t         *slots;
 
   hash = SC_ALLOC (sc_hash_t, 1);
 
@@ -1310,16 +4207,41 @@ sc_hash_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
   hash->equal_fn = equal_fn;
   hash->user_data = user_data;
 
-  hash->slots = slots = sc_array_new (sizeof (sc_list_t));
-  sc_array_resize (slots, sc_hash_minimal_size);
-  for (i = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    sc_list_init (list, hash->allocator);
-  }
+  hash->incremental = 0;
+  hash->old_slots = NULL;
+  hash->migrate_next = 0;
+  hash->migrate_steps = 0;
+  hash->migrate_moved = 0;
+
+  hash->slots = sc_hash_new_slots (hash, sc_hash_minimal_size);
 
   return hash;
 }
 
+void
+sc_hash_set_incremental (sc_hash_t * hash, int incremental)
+{
+  hash->incremental = incremental;
+  if (!incremental && hash->old_slots != NULL) {
+    /* complete a resize that is in progress */
+    sc_hash_migrate (hash, hash->old_slots->elem_count);
+    SC_ASSERT (hash->old_slots == NULL);
+  }
+}
+
+/** Free the old slot array of an incremental resize in progress.
+ * Its lists must have been emptied or unlinked before.
+ */
+static void
+sc_hash_drop_old_slots (sc_hash_t * hash)
+{
+  if (hash->old_slots != NULL) {
+    sc_array_destroy (hash->old_slots);
+    hash->old_slots = NULL;
+    hash->migrate_next = 0;
+  }
+}
+
 void
 sc_hash_destroy (sc_hash_t * hash)
 {
@@ -1331,6 +4253,7 @@ sc_hash_destroy (sc_hash_t * hash)
     /* return all list elements to the allocator: requires O(N) */
     sc_hash_truncate (hash);
   }
+  sc_hash_drop_old_slots (hash);
   sc_array_destroy (hash->slots);
 
   SC_FREE (hash);
@@ -1346,15 +4269,36 @@ sc_hash_destroy_null (sc_hash_t ** phash)
   *phash = NULL;
 }
 
+/** Reset or unlink the lists of a slot array.
+ * \param [in] first    Index of the first list to process.
+ * \return              The number of objects in the processed lists.
+ */
+static size_t
+sc_hash_clear_slots (sc_array_t * slots, size_t first, int unlink)
+{
+  size_t              i, count;
+  sc_list_t          *list;
+
+  for (i = first, count = 0; i < slots->elem_count; ++i) {
+    list = (sc_list_t *) sc_array_index (slots, i);
+    count += list->elem_count;
+    if (unlink) {
+      sc_list_unlink (list);
+    }
+    else {
+      sc_list_reset (list);
+    }
+  }
+  return count;
+}
+
 void
 sc_hash_truncate (sc_hash_t * hash)
 {
-  size_t              i;
   size_t              count;
-  sc_list_t          *list;
-  sc_array_t         *slots = hash->slots;
 
   if (hash->elem_count == 0) {
+    sc_hash_drop_old_slots (hash);
     return;
   }
 
@@ -1365,10 +4309,10 @@ sc_hash_truncate (sc_hash_t * hash)
   }
 
   /* return all list elements to the outside memory allocator */
-  for (i = 0, count = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    count += list->elem_count;
-    sc_list_reset (list);
+  count = sc_hash_clear_slots (hash->slots, 0, 0);
+  if (hash->old_slots != NULL) {
+    count += sc_hash_clear_slots (hash->old_slots, hash->migrate_next, 0);
+    sc_hash_drop_old_slots (hash);
   }
   SC_ASSERT (count == hash->elem_count);
 
@@ -1378,14 +4322,12 @@ sc_hash_truncate (sc_hash_t * hash)
 void
 sc_hash_unlink (sc_hash_t * hash)
 {
-  size_t              i, count;
-  sc_list_t          *list;
-  sc_array_t         *slots = hash->slots;
+  size_t              count;
 
-  for (i = 0, count = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    count += list->elem_count;
-    sc_list_unlink (list);
+  count = sc_hash_clear_slots (hash->slots, 0, 1);
+  if (hash->old_slots != NULL) {
+    count += sc_hash_clear_slots (hash->old_slots, hash->migrate_next, 1);
+    sc_hash_drop_old_slots (hash);
   }
   SC_ASSERT (count == hash->elem_count);
 
@@ -1398,51 +4340,108 @@ sc_hash_unlink_destroy (sc_hash_t * hash)
   if (hash->allocator_owned) {
     sc_mempool_destroy (hash->allocator);
   }
+  sc_hash_drop_old_slots (hash);
   sc_array_destroy (hash->slots);
 
   SC_FREE (hash);
 }
 
-int
-sc_hash_lookup (sc_hash_t * hash, void *v, void ***found)
+/** Find the link of an object with a hash value computed by the caller.
+ * During an incremental resize, both the new and the old slots are searched.
+ * \param [out] plist   If not NULL, set to the list containing the object,
+ *                      or to its list in the current slots if not found.
+ * \param [out] pprev   If not NULL, set to the predecessor of the link found
+ *                      or NULL if it is the first link in its list.
+ * \return              The link found or NULL.
+ */
+static sc_link_t   *
+sc_hash_find (sc_hash_t * hash, void *v, unsigned int hv,
+              sc_list_t ** plist, sc_link_t ** pprev)
 {
+  int                 k;
   size_t              hval;
-  sc_list_t          *list;
-  sc_link_t          *lynk;
+  sc_list_t          *list, *new_list;
+  sc_link_t          *lynk, *prev;
+  sc_array_t         *slots;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+  new_list = NULL;
+  for (k = 0; k < 2; ++k) {
+    slots = k == 0 ? hash->slots : hash->old_slots;
+    if (slots == NULL) {
+      break;
+    }
+    hval = hv % slots->elem_count;
+    if (k == 1 && hval < hash->migrate_next) {
+      /* this old slot has been migrated already */
+      break;
+    }
+    list = (sc_list_t *) sc_array_index (slots, hval);
+    if (k == 0) {
+      new_list = list;
+    }
 
-  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-    /* check if an equal object is contained in the hash table */
-    if (hash->equal_fn (lynk->data, v, hash->user_data)) {
-      if (found != NULL) {
-        *found = &lynk->data;
+    prev = NULL;
+    for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+      /* check if an equal object is contained in the hash table */
+      if (hash->equal_fn (lynk->data, v, hash->user_data)) {
+        if (plist != NULL) {
+          *plist = list;
+        }
+        if (pprev != NULL) {
+          *pprev = prev;
+        }
+        return lynk;
       }
-      return 1;
+      prev = lynk;
+    }
+  }
+  if (plist != NULL) {
+    *plist = new_list;
+  }
+  return NULL;
+}
+
+/** Look up an object with a hash value computed by the caller. */
+static int
+sc_hash_lookup_hval (sc_hash_t * hash, void *v, unsigned int hv,
+                     void ***found)
+{
+  sc_link_t          *lynk;
+
+  sc_hash_migrate (hash, sc_hash_migrate_buckets);
+  lynk = sc_hash_find (hash, v, hv, NULL, NULL);
+  if (lynk != NULL) {
+    if (found != NULL) {
+      *found = &lynk->data;
     }
+    return 1;
   }
   return 0;
 }
 
 int
-sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
+sc_hash_lookup (sc_hash_t * hash, void *v, void ***found)
+{
+  return sc_hash_lookup_hval (hash, v, hash->hash_fn (v, hash->user_data),
+                              found);
+}
+
+/** Insert an object with a hash value computed by the caller. */
+static int
+sc_hash_insert_unique_hval (sc_hash_t * hash, void *v, unsigned int hv,
+                            void ***found)
 {
-  size_t              hval;
   sc_list_t          *list;
   sc_link_t          *lynk;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
-
   /* check if an equal object is already contained in the hash table */
-  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-    if (hash->equal_fn (lynk->data, v, hash->user_data)) {
-      if (found != NULL) {
-        *found = &lynk->data;
-      }
-      return 0;
+  sc_hash_migrate (hash, sc_hash_migrate_buckets);
+  lynk = sc_hash_find (hash, v, hv, &list, NULL);
+  if (lynk != NULL) {
+    if (found != NULL) {
+      *found = &lynk->data;
     }
+    return 0;
   }
 
   /* append new object to the list */
@@ -1456,88 +4455,435 @@ sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
   if (hash->elem_count % hash->slots->elem_count == 0) {
     sc_hash_maybe_resize (hash);
     if (found != NULL) {
-      SC_EXECUTE_ASSERT_TRUE (sc_hash_lookup (hash, v, found));
+      lynk = sc_hash_find (hash, v, hv, NULL, NULL);
+      SC_ASSERT (lynk != NULL);
+      *found = &lynk->data;
+    }
+  }
+
+  return 1;
+}
+
+int
+sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
+{
+  return sc_hash_insert_unique_hval (hash, v,
+                                     hash->hash_fn (v, hash->user_data),
+                                     found);
+}
+
+/** Remove an object with a hash value computed by the caller. */
+static int
+sc_hash_remove_hval (sc_hash_t * hash, void *v, unsigned int hv,
+                     void **found)
+{
+  sc_list_t          *list;
+  sc_link_t          *lynk, *prev;
+
+  sc_hash_migrate (hash, sc_hash_migrate_buckets);
+  lynk = sc_hash_find (hash, v, hv, &list, &prev);
+  if (lynk == NULL) {
+    return 0;
+  }
+
+  if (found != NULL) {
+    *found = lynk->data;
+  }
+  (void) sc_list_remove (list, prev);
+  --hash->elem_count;
+
+  /* check for resize at specific intervals and return */
+  if (hash->elem_count % sc_hash_shrink_interval == 0) {
+    sc_hash_maybe_resize (hash);
+  }
+  return 1;
+}
+
+int
+sc_hash_remove (sc_hash_t * hash, void *v, void **found)
+{
+  return sc_hash_remove_hval (hash, v, hash->hash_fn (v, hash->user_data),
+                              found);
+}
+
+void
+sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
+{
+  int                 k;
+  size_t              slot;
+  sc_list_t          *list;
+  sc_link_t          *lynk;
+  sc_array_t         *slots;
+
+  for (k = 0; k < 2; ++k) {
+    slots = k == 0 ? hash->slots : hash->old_slots;
+    if (slots == NULL) {
+      break;
+    }
+    for (slot = k == 0 ? 0 : hash->migrate_next;
+         slot < slots->elem_count; ++slot) {
+      list = (sc_list_t *) sc_array_index (slots, slot);
+      for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+        if (!fn (&lynk->data, hash->user_data)) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+void
+sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
+{
+  size_t              i;
+  double              a, sum, squaresum;
+  double              divide, avg, sqr, std;
+  sc_list_t          *list;
+  sc_array_t         *slots = hash->slots;
+
+  sum = 0.;
+  squaresum = 0.;
+  for (i = 0; i < slots->elem_count; ++i) {
+    list = (sc_list_t *) sc_array_index (slots, i);
+    a = (double) list->elem_count;
+    sum += a;
+    squaresum += a * a;
+  }
+  if (hash->old_slots != NULL) {
+    /* objects in the old slots are not yet counted */
+    for (i = hash->migrate_next; i < hash->old_slots->elem_count; ++i) {
+      list = (sc_list_t *) sc_array_index (hash->old_slots, i);
+      sum += (double) list->elem_count;
+    }
+  }
+  SC_ASSERT ((size_t) sum == hash->elem_count);
+
+  divide = (double) slots->elem_count;
+  avg = sum / divide;
+  sqr = squaresum / divide - avg * avg;
+  std = sqrt (sqr);
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Hash size %lu avg %.3g std %.3g checks %lu %lu\n",
+               (unsigned long) slots->elem_count, avg, std,
+               (unsigned long) hash->resize_checks,
+               (unsigned long) hash->resize_actions);
+  if (hash->incremental) {
+    SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+                 "Hash migration %s steps %lu moved %lu\n",
+                 hash->old_slots != NULL ? "active" : "idle",
+                 (unsigned long) hash->migrate_steps,
+                 (unsigned long) hash->migrate_moved);
+  }
+}
+
+/* flat hash table routines */
+
+static const int    sc_hash_flat_minimal_bits = 4;
+
+size_t
+sc_hash_flat_memory_used (sc_hash_flat_t * hash)
+{
+  return sizeof (sc_hash_flat_t) +
+    hash->slot_count * sizeof (sc_hash_flat_slot_t);
+}
+
+/** Map a hash value to its home slot by Fibonacci hashing.
+ * This spreads poorly mixed hash values over the power-of-two table. */
+static inline size_t
+sc_hash_flat_home (sc_hash_flat_t * hash, unsigned int hval)
+{
+  return (size_t) (((uint64_t) hval * 0x9E3779B97F4A7C15ULL) >>
+                   (64 - hash->slot_bits));
+}
+
+/** Place an object known not to be contained into the slots.
+ * \return      The slot index where the object has been placed.
+ */
+static size_t
+sc_hash_flat_place (sc_hash_flat_t * hash, void *v, unsigned int hval)
+{
+  const size_t        mask = hash->slot_count - 1;
+  size_t              pos, ret;
+  sc_hash_flat_slot_t cur, tmp, *s;
+
+  cur.v = v;
+  cur.hval = hval;
+  cur.dist = 1;
+  ret = hash->slot_count;
+  pos = sc_hash_flat_home (hash, hval);
+  for (;; pos = (pos + 1) & mask, ++cur.dist) {
+    s = hash->slots + pos;
+    if (s->dist == 0) {
+      *s = cur;
+      return ret == hash->slot_count ? pos : ret;
+    }
+    if (s->dist < cur.dist) {
+      /* steal from the rich: the displaced object continues probing */
+      tmp = *s;
+      *s = cur;
+      cur = tmp;
+      if (ret == hash->slot_count) {
+        ret = pos;
+      }
+    }
+  }
+}
+
+static void
+sc_hash_flat_rebuild (sc_hash_flat_t * hash, int new_bits)
+{
+  size_t              zz, old_count;
+  sc_hash_flat_slot_t *old_slots, *s;
+
+  old_count = hash->slot_count;
+  old_slots = hash->slots;
+
+  hash->slot_bits = new_bits;
+  hash->slot_count = (size_t) 1 << new_bits;
+  hash->slots = SC_ALLOC_ZERO (sc_hash_flat_slot_t, hash->slot_count);
+
+  /* the stored hash values save us from calling hash_fn again */
+  for (zz = 0; zz < old_count; ++zz) {
+    s = old_slots + zz;
+    if (s->dist > 0) {
+      (void) sc_hash_flat_place (hash, s->v, s->hval);
+    }
+  }
+  SC_FREE (old_slots);
+}
+
+static void
+sc_hash_flat_maybe_resize (sc_hash_flat_t * hash)
+{
+  ++hash->resize_checks;
+
+  /* keep the load factor between 1/8 and 7/8 */
+  if (8 * hash->elem_count > 7 * hash->slot_count) {
+    ++hash->resize_actions;
+    sc_hash_flat_rebuild (hash, hash->slot_bits + 1);
+  }
+  else if (hash->slot_bits > sc_hash_flat_minimal_bits &&
+           8 * hash->elem_count < hash->slot_count) {
+    ++hash->resize_actions;
+    sc_hash_flat_rebuild (hash, hash->slot_bits - 1);
+  }
+}
+
+sc_hash_flat_t     *
+sc_hash_flat_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+                  void *user_data)
+{
+  sc_hash_flat_t     *hash;
+
+  hash = SC_ALLOC (sc_hash_flat_t, 1);
+
+  hash->elem_count = 0;
+  hash->slot_bits = sc_hash_flat_minimal_bits;
+  hash->slot_count = (size_t) 1 << hash->slot_bits;
+  hash->slots = SC_ALLOC_ZERO (sc_hash_flat_slot_t, hash->slot_count);
+  hash->user_data = user_data;
+  hash->hash_fn = hash_fn;
+  hash->equal_fn = equal_fn;
+  hash->resize_checks = 0;
+  hash->resize_actions = 0;
+
+  return hash;
+}
+
+void
+sc_hash_flat_destroy (sc_hash_flat_t * hash)
+{
+  SC_FREE (hash->slots);
+  SC_FREE (hash);
+}
+
+void
+sc_hash_flat_destroy_null (sc_hash_flat_t ** phash)
+{
+  SC_ASSERT (phash != NULL);
+  SC_ASSERT (*phash != NULL);
+
+  sc_hash_flat_destroy (*phash);
+  *phash = NULL;
+}
+
+void
+sc_hash_flat_truncate (sc_hash_flat_t * hash)
+{
+  if (hash->slot_bits > sc_hash_flat_minimal_bits) {
+    SC_FREE (hash->slots);
+    hash->slot_bits = sc_hash_flat_minimal_bits;
+    hash->slot_count = (size_t) 1 << hash->slot_bits;
+    hash->slots = SC_ALLOC_ZERO (sc_hash_flat_slot_t, hash->slot_count);
+  }
+  else {
+    memset (hash->slots, 0, hash->slot_count * sizeof (sc_hash_flat_slot_t));
+  }
+  hash->elem_count = 0;
+}
+
+/** Find the slot holding an object equal to v.
+ * \return      The slot index or slot_count if not found.
+ */
+static size_t
+sc_hash_flat_find (sc_hash_flat_t * hash, void *v, unsigned int hval)
+{
+  const size_t        mask = hash->slot_count - 1;
+  size_t              pos;
+  unsigned int        dist;
+  sc_hash_flat_slot_t *s;
+
+  pos = sc_hash_flat_home (hash, hval);
+  for (dist = 1;; pos = (pos + 1) & mask, ++dist) {
+    s = hash->slots + pos;
+    if (s->dist < dist) {
+      /* empty slot or an object closer to its home: v is not contained */
+      return hash->slot_count;
+    }
+    if (s->hval == hval && hash->equal_fn (s->v, v, hash->user_data)) {
+      return pos;
+    }
+  }
+}
+
+/** Look up an object with a hash value computed by the caller. */
+static int
+sc_hash_flat_lookup_hval (sc_hash_flat_t * hash, void *v,
+                          unsigned int hval, void ***found)
+{
+  size_t              pos;
+
+  pos = sc_hash_flat_find (hash, v, hval);
+  if (pos == hash->slot_count) {
+    return 0;
+  }
+  if (found != NULL) {
+    *found = &hash->slots[pos].v;
+  }
+  return 1;
+}
+
+int
+sc_hash_flat_lookup (sc_hash_flat_t * hash, void *v, void ***found)
+{
+  return sc_hash_flat_lookup_hval (hash, v,
+                                   hash->hash_fn (v, hash->user_data), found);
+}
+
+/** Insert an object with a hash value computed by the caller. */
+static int
+sc_hash_flat_insert_unique_hval (sc_hash_flat_t * hash, void *v,
+                                 unsigned int hval, void ***found)
+{
+  size_t              pos;
+
+  pos = sc_hash_flat_find (hash, v, hval);
+  if (pos < hash->slot_count) {
+    if (found != NULL) {
+      *found = &hash->slots[pos].v;
     }
+    return 0;
   }
 
+  /* grow before placing the object such that its slot stays put */
+  ++hash->elem_count;
+  if (8 * hash->elem_count > 7 * hash->slot_count) {
+    sc_hash_flat_maybe_resize (hash);
+  }
+  pos = sc_hash_flat_place (hash, v, hval);
+  if (found != NULL) {
+    *found = &hash->slots[pos].v;
+  }
   return 1;
 }
 
 int
-sc_hash_remove (sc_hash_t * hash, void *v, void **found)
+sc_hash_flat_insert_unique (sc_hash_flat_t * hash, void *v, void ***found)
 {
-  size_t              hval;
-  sc_list_t          *list;
-  sc_link_t          *lynk, *prev;
+  return sc_hash_flat_insert_unique_hval (hash, v,
+                                          hash->hash_fn (v, hash->user_data),
+                                          found);
+}
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+int
+sc_hash_flat_remove (sc_hash_flat_t * hash, void *v, void **found)
+{
+  const size_t        mask = hash->slot_count - 1;
+  size_t              pos, next;
 
-  prev = NULL;
-  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-    /* check if an equal object is contained in the hash table */
-    if (hash->equal_fn (lynk->data, v, hash->user_data)) {
-      if (found != NULL) {
-        *found = lynk->data;
-      }
-      (void) sc_list_remove (list, prev);
-      --hash->elem_count;
+  pos = sc_hash_flat_find (hash, v, hash->hash_fn (v, hash->user_data));
+  if (pos == hash->slot_count) {
+    return 0;
+  }
+  if (found != NULL) {
+    *found = hash->slots[pos].v;
+  }
 
-      /* check for resize at specific intervals and return */
-      if (hash->elem_count % sc_hash_shrink_interval == 0) {
-        sc_hash_maybe_resize (hash);
-      }
-      return 1;
-    }
-    prev = lynk;
+  /* shift the following objects back by one; no tombstones needed */
+  for (next = (pos + 1) & mask; hash->slots[next].dist > 1;
+       pos = next, next = (next + 1) & mask) {
+    hash->slots[pos] = hash->slots[next];
+    --hash->slots[pos].dist;
   }
-  return 0;
+  hash->slots[pos].dist = 0;
+  --hash->elem_count;
+
+  /* check for shrinking at specific intervals */
+  if (hash->elem_count % sc_hash_shrink_interval == 0) {
+    sc_hash_flat_maybe_resize (hash);
+  }
+  return 1;
 }
 
 void
-sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
+sc_hash_flat_foreach (sc_hash_flat_t * hash, sc_hash_foreach_t fn)
 {
-  size_t              slot;
-  sc_list_t          *list;
-  sc_link_t          *lynk;
+  size_t              zz;
+  sc_hash_flat_slot_t *s;
 
-  for (slot = 0; slot < hash->slots->elem_count; ++slot) {
-    list = (sc_list_t *) sc_array_index (hash->slots, slot);
-    for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-      if (!fn (&lynk->data, hash->user_data)) {
-        return;
-      }
+  for (zz = 0; zz < hash->slot_count; ++zz) {
+    s = hash->slots + zz;
+    if (s->dist > 0 && !fn (&s->v, hash->user_data)) {
+      return;
     }
   }
 }
 
 void
-sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
+sc_hash_flat_print_statistics (int package_id, int log_priority,
+                               sc_hash_flat_t * hash)
 {
-  size_t              i;
+  size_t              zz, count;
+  unsigned int        maxdist;
   double              a, sum, squaresum;
-  double              divide, avg, sqr, std;
-  sc_list_t          *list;
-  sc_array_t         *slots = hash->slots;
+  double              avg, sqr, std;
+  sc_hash_flat_slot_t *s;
 
+  count = 0;
+  maxdist = 0;
   sum = 0.;
   squaresum = 0.;
-  for (i = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    a = (double) list->elem_count;
-    sum += a;
-    squaresum += a * a;
+  for (zz = 0; zz < hash->slot_count; ++zz) {
+    s = hash->slots + zz;
+    if (s->dist > 0) {
+      ++count;
+      a = (double) s->dist;
+      sum += a;
+      squaresum += a * a;
+      maxdist = SC_MAX (maxdist, s->dist);
+    }
   }
-  SC_ASSERT ((size_t) sum == hash->elem_count);
+  SC_ASSERT (count == hash->elem_count);
 
-  divide = (double) slots->elem_count;
-  avg = sum / divide;
-  sqr = squaresum / divide - avg * avg;
-  std = sqrt (sqr);
+  avg = count > 0 ? sum / (double) count : 0.;
+  sqr = count > 0 ? squaresum / (double) count - avg * avg : 0.;
+  std = sqrt (SC_MAX (sqr, 0.));
   SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
-               "Hash size %lu avg %.3g std %.3g checks %lu %lu\n",
-               (unsigned long) slots->elem_count, avg, std,
-               (unsigned long) hash->resize_checks,
+               "Flat hash size %lu load %.3g probe avg %.3g std %.3g"
+               " max %u checks %lu %lu\n",
+               (unsigned long) hash->slot_count,
+               (double) count / (double) hash->slot_count, avg, std,
+               maxdist, (unsigned long) hash->resize_checks,
                (unsigned long) hash->resize_actions);
 }
 
@@ -1546,8 +4892,9 @@ sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
 size_t
 sc_hash_array_memory_used (sc_hash_array_t * ha)
 {
-  return sizeof (sc_hash_array_t) +
-    sc_array_memory_used (&ha->a, 0) + sc_hash_memory_used (ha->h);
+  return sizeof (sc_hash_array_t) + sc_array_memory_used (&ha->a, 0) +
+    (ha->h != NULL ? sc_hash_memory_used (ha->h) :
+     sc_hash_flat_memory_used (ha->hf));
 }
 
 static unsigned int
@@ -1581,9 +4928,11 @@ sc_hash_array_equal_fn (const void *v1, const void *v2, const void *u)
   return internal_data->equal_fn (p1, p2, internal_data->user_data);
 }
 
-sc_hash_array_t    *
-sc_hash_array_new (size_t elem_size, sc_hash_function_t hash_fn,
-                   sc_equal_function_t equal_fn, void *user_data)
+/** This function is static; we do not like to expose _ext functions in libsc. */
+static sc_hash_array_t *
+sc_hash_array_new_ext (size_t elem_size, sc_hash_function_t hash_fn,
+                       sc_equal_function_t equal_fn, void *user_data,
+                       int flat)
 {
   sc_hash_array_t    *hash_array;
 
@@ -1595,16 +4944,76 @@ sc_hash_array_new (size_t elem_size, sc_hash_function_t hash_fn,
   hash_array->internal_data.equal_fn = equal_fn;
   hash_array->internal_data.user_data = user_data;
   hash_array->internal_data.current_item = NULL;
-  hash_array->h = sc_hash_new (sc_hash_array_hash_fn, sc_hash_array_equal_fn,
-                               &hash_array->internal_data, NULL);
+  hash_array->num_hashed = 0;
+  if (!flat) {
+    hash_array->h = sc_hash_new (sc_hash_array_hash_fn,
+                                 sc_hash_array_equal_fn,
+                                 &hash_array->internal_data, NULL);
+    hash_array->hf = NULL;
+  }
+  else {
+    hash_array->h = NULL;
+    hash_array->hf = sc_hash_flat_new (sc_hash_array_hash_fn,
+                                       sc_hash_array_equal_fn,
+                                       &hash_array->internal_data);
+  }
 
   return hash_array;
 }
 
+sc_hash_array_t    *
+sc_hash_array_new (size_t elem_size, sc_hash_function_t hash_fn,
+                   sc_equal_function_t equal_fn, void *user_data)
+{
+  return sc_hash_array_new_ext (elem_size, hash_fn, equal_fn, user_data, 0);
+}
+
+sc_hash_array_t    *
+sc_hash_array_new_flat (size_t elem_size, sc_hash_function_t hash_fn,
+                        sc_equal_function_t equal_fn, void *user_data)
+{
+  return sc_hash_array_new_ext (elem_size, hash_fn, equal_fn, user_data, 1);
+}
+
+/** Destroy the hash table of a hash array, regardless of its type. */
+static void
+sc_hash_array_destroy_table (sc_hash_array_t * hash_array)
+{
+  if (hash_array->h != NULL) {
+    sc_hash_destroy_null (&hash_array->h);
+  }
+  else {
+    sc_hash_flat_destroy_null (&hash_array->hf);
+  }
+}
+
+/** Enter the array elements not yet in the hash table, as after loading.
+ * The table stores array positions, which are their own keys here. */
+static void
+sc_hash_array_rehash (sc_hash_array_t * hash_array)
+{
+  int                 added;
+  size_t              zz;
+  void              **found_void;
+
+  for (zz = hash_array->num_hashed; zz < hash_array->a.elem_count; ++zz) {
+    if (hash_array->h != NULL) {
+      added = sc_hash_insert_unique (hash_array->h, (void *) zz,
+                                     &found_void);
+    }
+    else {
+      added = sc_hash_flat_insert_unique (hash_array->hf, (void *) zz,
+                                          &found_void);
+    }
+    SC_CHECK_ABORT (added, "Duplicate element in hash array");
+  }
+  hash_array->num_hashed = hash_array->a.elem_count;
+}
+
 void
 sc_hash_array_destroy (sc_hash_array_t * hash_array)
 {
-  sc_hash_destroy (hash_array->h);
+  sc_hash_array_destroy_table (hash_array);
   sc_array_reset (&hash_array->a);
 
   SC_FREE (hash_array);
@@ -1617,6 +5026,7 @@ sc_hash_array_is_valid (sc_hash_array_t * hash_array)
   size_t              zz, position;
   void               *v;
 
+  sc_hash_array_rehash (hash_array);
   for (zz = 0; zz < hash_array->a.elem_count; ++zz) {
     v = sc_array_index (&hash_array->a, zz);
     found = sc_hash_array_lookup (hash_array, v, &position);
@@ -1631,8 +5041,14 @@ sc_hash_array_is_valid (sc_hash_array_t * hash_array)
 void
 sc_hash_array_truncate (sc_hash_array_t * hash_array)
 {
-  sc_hash_truncate (hash_array->h);
+  if (hash_array->h != NULL) {
+    sc_hash_truncate (hash_array->h);
+  }
+  else {
+    sc_hash_flat_truncate (hash_array->hf);
+  }
   sc_array_reset (&hash_array->a);
+  hash_array->num_hashed = 0;
 }
 
 int
@@ -1641,8 +5057,14 @@ sc_hash_array_lookup (sc_hash_array_t * hash_array, void *v, size_t *position)
   int                 found;
   void              **found_void;
 
+  sc_hash_array_rehash (hash_array);
   hash_array->internal_data.current_item = v;
-  found = sc_hash_lookup (hash_array->h, (void *) (-1L), &found_void);
+  if (hash_array->h != NULL) {
+    found = sc_hash_lookup (hash_array->h, (void *) (-1L), &found_void);
+  }
+  else {
+    found = sc_hash_flat_lookup (hash_array->hf, (void *) (-1L), &found_void);
+  }
   hash_array->internal_data.current_item = NULL;
 
   if (found) {
@@ -1663,10 +5085,18 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
   int                 added;
   void              **found_void;
 
-  SC_ASSERT (hash_array->a.elem_count == hash_array->h->elem_count);
-
+  sc_hash_array_rehash (hash_array);
   hash_array->internal_data.current_item = v;
-  added = sc_hash_insert_unique (hash_array->h, (void *) (-1L), &found_void);
+  if (hash_array->h != NULL) {
+    SC_ASSERT (hash_array->a.elem_count == hash_array->h->elem_count);
+    added = sc_hash_insert_unique (hash_array->h, (void *) (-1L),
+                                   &found_void);
+  }
+  else {
+    SC_ASSERT (hash_array->a.elem_count == hash_array->hf->elem_count);
+    added = sc_hash_flat_insert_unique (hash_array->hf, (void *) (-1L),
+                                        &found_void);
+  }
   hash_array->internal_data.current_item = NULL;
 
   if (added) {
@@ -1674,6 +5104,7 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
       *position = hash_array->a.elem_count;
     }
     *found_void = (void *) hash_array->a.elem_count;
+    ++hash_array->num_hashed;
     return sc_array_push (&hash_array->a);
   }
   else {
@@ -1684,49 +5115,468 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
   }
 }
 
+/** Number of keys hashed and prefetched before they are resolved. */
+#define SC_HASH_ARRAY_BATCH 16
+
+/** Compute the hash value of an item and prefetch its hash table slot. */
+static unsigned int
+sc_hash_array_prefetch (sc_hash_array_t * hash_array, void *v)
+{
+  unsigned int        hval;
+
+  hval = hash_array->internal_data.hash_fn
+    (v, hash_array->internal_data.user_data);
+  if (hash_array->h != NULL) {
+    SC_PREFETCH (hash_array->h->slots->array + sizeof (sc_list_t) *
+                 (hval % hash_array->h->slots->elem_count));
+  }
+  else {
+    SC_PREFETCH (hash_array->hf->slots +
+                 sc_hash_flat_home (hash_array->hf, hval));
+  }
+  return hval;
+}
+
+size_t
+sc_hash_array_lookup_batch (sc_hash_array_t * hash_array,
+                            sc_array_t * keys, sc_array_t * positions)
+{
+  int                 found;
+  size_t              zz, zb, bend, num_found;
+  unsigned int        hvals[SC_HASH_ARRAY_BATCH];
+  void               *v, **found_void;
+
+  SC_ASSERT (keys->elem_size == hash_array->a.elem_size);
+  SC_ASSERT (positions->elem_size == sizeof (ssize_t));
+
+  sc_hash_array_rehash (hash_array);
+  sc_array_resize (positions, keys->elem_count);
+  num_found = 0;
+  for (zb = 0; zb < keys->elem_count; zb = bend) {
+    bend = SC_MIN (zb + SC_HASH_ARRAY_BATCH, keys->elem_count);
+
+    /* hash all keys of this batch first to overlap the memory accesses */
+    for (zz = zb; zz < bend; ++zz) {
+      hvals[zz - zb] = sc_hash_array_prefetch
+        (hash_array, sc_array_index (keys, zz));
+    }
+
+    /* then resolve the keys against the prefetched slots */
+    for (zz = zb; zz < bend; ++zz) {
+      v = sc_array_index (keys, zz);
+      hash_array->internal_data.current_item = v;
+      if (hash_array->h != NULL) {
+        found = sc_hash_lookup_hval (hash_array->h, (void *) (-1L),
+                                     hvals[zz - zb], &found_void);
+      }
+      else {
+        found = sc_hash_flat_lookup_hval (hash_array->hf, (void *) (-1L),
+                                          hvals[zz - zb], &found_void);
+      }
+      hash_array->internal_data.current_item = NULL;
+      if (found) {
+        *(ssize_t *) sc_array_index (positions, zz) = (ssize_t) * found_void;
+        ++num_found;
+      }
+      else {
+        *(ssize_t *) sc_array_index (positions, zz) = -1;
+      }
+    }
+  }
+  return num_found;
+}
+
+size_t
+sc_hash_array_insert_unique_batch (sc_hash_array_t * hash_array,
+                                   sc_array_t * keys, sc_array_t * positions)
+{
+  int                 added;
+  size_t              zz, zb, bend, num_added, pos;
+  unsigned int        hvals[SC_HASH_ARRAY_BATCH];
+  void               *v, **found_void;
+
+  SC_ASSERT (keys->elem_size == hash_array->a.elem_size);
+  SC_ASSERT (positions == NULL || positions->elem_size == sizeof (ssize_t));
+
+  sc_hash_array_rehash (hash_array);
+  if (positions != NULL) {
+    sc_array_resize (positions, keys->elem_count);
+  }
+  num_added = 0;
+  for (zb = 0; zb < keys->elem_count; zb = bend) {
+    bend = SC_MIN (zb + SC_HASH_ARRAY_BATCH, keys->elem_count);
+
+    /* hash all keys of this batch first to overlap the memory accesses */
+    for (zz = zb; zz < bend; ++zz) {
+      hvals[zz - zb] = sc_hash_array_prefetch
+        (hash_array, sc_array_index (keys, zz));
+    }
+
+    /* then resolve the keys, possibly growing the table on the way */
+    for (zz = zb; zz < bend; ++zz) {
+      v = sc_array_index (keys, zz);
+      hash_array->internal_data.current_item = v;
+      if (hash_array->h != NULL) {
+        added = sc_hash_insert_unique_hval (hash_array->h, (void *) (-1L),
+                                            hvals[zz - zb], &found_void);
+      }
+      else {
+        added = sc_hash_flat_insert_unique_hval
+          (hash_array->hf, (void *) (-1L), hvals[zz - zb], &found_void);
+      }
+      hash_array->internal_data.current_item = NULL;
+
+      if (added) {
+        /* the key is copied right away since later keys compare to it */
+        pos = hash_array->a.elem_count;
+        *found_void = (void *) pos;
+        memcpy (sc_array_push (&hash_array->a), v, keys->elem_size);
+        ++hash_array->num_hashed;
+        ++num_added;
+      }
+      else {
+        pos = (size_t) (*found_void);
+      }
+      if (positions != NULL) {
+        *(ssize_t *) sc_array_index (positions, zz) = (ssize_t) pos;
+      }
+    }
+  }
+  return num_added;
+}
+
 void
 sc_hash_array_rip (sc_hash_array_t * hash_array, sc_array_t * rip)
 {
-  sc_hash_destroy (hash_array->h);
+  sc_hash_array_destroy_table (hash_array);
   memcpy (rip, &hash_array->a, sizeof (sc_array_t));
 
   SC_FREE (hash_array);
 }
 
+/* concurrent hash table routines */
+
+/** Bytes of a cache line that the shards are padded and aligned to. */
+#define SC_HASH_SHARD_BYTES 64
+
+typedef struct sc_hash_shard
+{
+  sc_hash_t          *h;
+  sc_containers_lock_t lock;
+}
+sc_hash_shard_t;
+
+/** A shard padded to whole cache lines so that no two locks share one. */
+typedef union sc_hash_shard_line
+{
+  sc_hash_shard_t     shard;
+  char                padding[SC_ALIGN_UP (sizeof (sc_hash_shard_t),
+                                           SC_HASH_SHARD_BYTES)];
+}
+sc_hash_shard_line_t;
+
+struct sc_hash_concurrent
+{
+  int                 num_shards;
+  sc_hash_shard_line_t *shards;     /* aligned into shards_alloc */
+  char               *shards_alloc;
+  void               *user_data;
+  sc_hash_function_t  hash_fn;
+};
+
+/** Choose the shard by the upper bits of the mixed hash value.
+ * The shard's own table uses the hash value modulo its size, which
+ * is thus not correlated with the choice of the shard.
+ */
+static sc_hash_shard_t *
+sc_hash_concurrent_shard (sc_hash_concurrent_t * hash, unsigned int hv)
+{
+  uint32_t            mix;
+
+  mix = (uint32_t) (((uint64_t) hv * 0x9E3779B97F4A7C15ULL) >> 32);
+  return &hash->shards[((uint64_t) mix *
+                        (uint64_t) hash->num_shards) >> 32].shard;
+}
+
+sc_hash_concurrent_t *
+sc_hash_concurrent_new (int num_shards, sc_hash_function_t hash_fn,
+                        sc_equal_function_t equal_fn, void *user_data)
+{
+  int                 i;
+  uintptr_t           addr;
+  sc_hash_shard_t    *shard;
+  sc_hash_concurrent_t *hash;
+
+  SC_ASSERT (num_shards > 0);
+
+  hash = SC_ALLOC (sc_hash_concurrent_t, 1);
+  hash->num_shards = num_shards;
+  hash->shards_alloc =
+    SC_ALLOC (char, num_shards * sizeof (sc_hash_shard_line_t) +
+              SC_HASH_SHARD_BYTES - 1);
+  addr = (uintptr_t) hash->shards_alloc + SC_HASH_SHARD_BYTES - 1;
+  addr -= addr % SC_HASH_SHARD_BYTES;
+  hash->shards = (sc_hash_shard_line_t *) addr;
+  hash->user_data = user_data;
+  hash->hash_fn = hash_fn;
+
+  for (i = 0; i < num_shards; ++i) {
+    shard = &hash->shards[i].shard;
+
+    /* every shard owns its allocator, which is then protected by the lock */
+    shard->h = sc_hash_new (hash_fn, equal_fn, user_data, NULL);
+    sc_containers_lock_init (&shard->lock);
+  }
+
+  return hash;
+}
+
+void
+sc_hash_concurrent_destroy (sc_hash_concurrent_t * hash)
+{
+  int                 i;
+  sc_hash_shard_t    *shard;
+
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = &hash->shards[i].shard;
+    sc_hash_destroy (shard->h);
+    sc_containers_lock_destroy (&shard->lock);
+  }
+  SC_FREE (hash->shards_alloc);
+  SC_FREE (hash);
+}
+
+size_t
+sc_hash_concurrent_count (sc_hash_concurrent_t * hash)
+{
+  int                 i;
+  size_t              count;
+  sc_hash_shard_t    *shard;
+
+  count = 0;
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = &hash->shards[i].shard;
+    sc_containers_lock (&shard->lock);
+    count += shard->h->elem_count;
+    sc_containers_unlock (&shard->lock);
+  }
+  return count;
+}
+
+size_t
+sc_hash_concurrent_memory_used (sc_hash_concurrent_t * hash)
+{
+  int                 i;
+  size_t              mem;
+
+  mem = sizeof (sc_hash_concurrent_t) + SC_HASH_SHARD_BYTES - 1 +
+    hash->num_shards * sizeof (sc_hash_shard_line_t);
+  for (i = 0; i < hash->num_shards; ++i) {
+    mem += sc_hash_memory_used (hash->shards[i].shard.h);
+  }
+  return mem;
+}
+
+int
+sc_hash_concurrent_lookup (sc_hash_concurrent_t * hash, void *v,
+                           void **found)
+{
+  int                 added;
+  unsigned int        hv;
+  void              **pfound;
+  sc_hash_shard_t    *shard;
+
+  /* the hash value is computed outside of the lock */
+  hv = hash->hash_fn (v, hash->user_data);
+  shard = sc_hash_concurrent_shard (hash, hv);
+
+  sc_containers_lock (&shard->lock);
+  added = sc_hash_lookup_hval (shard->h, v, hv, &pfound);
+  if (added && found != NULL) {
+    *found = *pfound;
+  }
+  sc_containers_unlock (&shard->lock);
+
+  return added;
+}
+
+int
+sc_hash_concurrent_insert_unique (sc_hash_concurrent_t * hash, void *v,
+                                  void **found)
+{
+  int                 added;
+  unsigned int        hv;
+  void              **pfound;
+  sc_hash_shard_t    *shard;
+
+  hv = hash->hash_fn (v, hash->user_data);
+  shard = sc_hash_concurrent_shard (hash, hv);
+
+  sc_containers_lock (&shard->lock);
+  added = sc_hash_insert_unique_hval (shard->h, v, hv, &pfound);
+  if (found != NULL) {
+    *found = *pfound;
+  }
+  sc_containers_unlock (&shard->lock);
+
+  return added;
+}
+
+int
+sc_hash_concurrent_remove (sc_hash_concurrent_t * hash, void *v,
+                           void **found)
+{
+  int                 removed;
+  unsigned int        hv;
+  sc_hash_shard_t    *shard;
+
+  hv = hash->hash_fn (v, hash->user_data);
+  shard = sc_hash_concurrent_shard (hash, hv);
+
+  sc_containers_lock (&shard->lock);
+  removed = sc_hash_remove_hval (shard->h, v, hv, found);
+  sc_containers_unlock (&shard->lock);
+
+  return removed;
+}
+
+void
+sc_hash_concurrent_foreach (sc_hash_concurrent_t * hash, int thread_id,
+                            int num_threads, sc_hash_foreach_t fn)
+{
+  int                 i, first, last;
+  int                 cont;
+  size_t              slot;
+  sc_list_t          *list;
+  sc_link_t          *lynk;
+  sc_array_t         *slots;
+  sc_hash_t          *h;
+  sc_hash_shard_t    *shard;
+
+  SC_ASSERT (0 <= thread_id && thread_id < num_threads);
+
+  /* each thread processes a contiguous range of shards */
+  first = (int) (((long long) hash->num_shards * thread_id) / num_threads);
+  last =
+    (int) (((long long) hash->num_shards * (thread_id + 1)) / num_threads);
+
+  cont = 1;
+  for (i = first; cont && i < last; ++i) {
+    shard = &hash->shards[i].shard;
+    sc_containers_lock (&shard->lock);
+    h = shard->h;
+
+    /* the shards never resize incrementally */
+    SC_ASSERT (h->old_slots == NULL);
+    slots = h->slots;
+    for (slot = 0; cont && slot < slots->elem_count; ++slot) {
+      list = (sc_list_t *) sc_array_index (slots, slot);
+      for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
+        if (!fn (&lynk->data, h->user_data)) {
+          cont = 0;
+          break;
+        }
+      }
+    }
+    sc_containers_unlock (&shard->lock);
+  }
+}
+
+void
+sc_hash_concurrent_print_statistics (int package_id, int log_priority,
+                                     sc_hash_concurrent_t * hash)
+{
+  int                 i;
+  size_t              count, minc, maxc;
+  sc_hash_shard_t    *shard;
+
+  count = maxc = 0;
+  minc = (size_t) -1;
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = &hash->shards[i].shard;
+    sc_containers_lock (&shard->lock);
+    count += shard->h->elem_count;
+    minc = SC_MIN (minc, shard->h->elem_count);
+    maxc = SC_MAX (maxc, shard->h->elem_count);
+    sc_containers_unlock (&shard->lock);
+  }
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Concurrent hash shards %d count %lu min %lu max %lu\n",
+               hash->num_shards, (unsigned long) count,
+               (unsigned long) minc, (unsigned long) maxc);
+}
+
+/* index of the lowest set bit of a nonzero word */
+static inline int
+sc_recycle_array_ctz (uint64_t w)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll ((unsigned long long) w);
+#else
+  int                 b = 0;
+
+  SC_ASSERT (w != 0);
+  while (!(w & 1)) {
+    w >>= 1;
+    ++b;
+  }
+  return b;
+#endif
+}
+
+static inline uint64_t *
+sc_recycle_array_word (sc_recycle_array_t * rec_array, size_t position)
+{
+  return (uint64_t *) sc_array_index (&rec_array->f, position / 64);
+}
+
 void
 sc_recycle_array_init (sc_recycle_array_t * rec_array, size_t elem_size)
 {
   sc_array_init (&rec_array->a, elem_size);
-  sc_array_init (&rec_array->f, sizeof (size_t));
+  sc_array_init (&rec_array->f, sizeof (uint64_t));
 
   rec_array->elem_count = 0;
+  rec_array->f_word = 0;
 }
 
 void
 sc_recycle_array_reset (sc_recycle_array_t * rec_array)
 {
-  SC_ASSERT (rec_array->a.elem_count ==
-             rec_array->elem_count + rec_array->f.elem_count);
+  SC_ASSERT (rec_array->a.elem_count >= rec_array->elem_count);
+  SC_ASSERT (rec_array->f.elem_count == (rec_array->a.elem_count + 63) / 64);
 
   sc_array_reset (&rec_array->a);
   sc_array_reset (&rec_array->f);
 
   rec_array->elem_count = 0;
+  rec_array->f_word = 0;
 }
 
 void               *
 sc_recycle_array_insert (sc_recycle_array_t * rec_array, size_t *position)
 {
-  size_t              newpos;
+  size_t              newpos, iw;
+  uint64_t           *words;
   void               *newitem;
 
-  if (rec_array->f.elem_count > 0) {
-    newpos = *(size_t *) sc_array_pop (&rec_array->f);
+  if (rec_array->elem_count < rec_array->a.elem_count) {
+    /* there is a free slot, and none in the words before the hint */
+    words = (uint64_t *) rec_array->f.array;
+    for (iw = rec_array->f_word; words[iw] == 0; ++iw) {
+      SC_ASSERT (iw + 1 < rec_array->f.elem_count);
+    }
+    newpos = 64 * iw + sc_recycle_array_ctz (words[iw]);
+    words[iw] &= words[iw] - 1;
+    rec_array->f_word = iw;
     newitem = sc_array_index (&rec_array->a, newpos);
   }
   else {
     newpos = rec_array->a.elem_count;
     newitem = sc_array_push (&rec_array->a);
+    if (newpos % 64 == 0) {
+      *(uint64_t *) sc_array_push (&rec_array->f) = 0;
+    }
   }
 
   if (position != NULL) {
@@ -1740,10 +5590,87 @@ sc_recycle_array_insert (sc_recycle_array_t * rec_array, size_t *position)
 void               *
 sc_recycle_array_remove (sc_recycle_array_t * rec_array, size_t position)
 {
+  uint64_t           *word;
+
   SC_ASSERT (rec_array->elem_count > 0);
+  SC_ASSERT (position < rec_array->a.elem_count);
 
-  *(size_t *) sc_array_push (&rec_array->f) = position;
+  word = sc_recycle_array_word (rec_array, position);
+  SC_ASSERT (!(*word & ((uint64_t) 1 << (position % 64))));
+  *word |= (uint64_t) 1 << (position % 64);
+  rec_array->f_word = SC_MIN (rec_array->f_word, position / 64);
   --rec_array->elem_count;
 
   return sc_array_index (&rec_array->a, position);
 }
+
+size_t
+sc_recycle_array_next (sc_recycle_array_t * rec_array, size_t position)
+{
+  size_t              iw, nw;
+  uint64_t            live;
+  const uint64_t     *words;
+
+  if (position >= rec_array->a.elem_count) {
+    return rec_array->a.elem_count;
+  }
+
+  /* bits past the last slot are clear and would read as valid */
+  words = (const uint64_t *) rec_array->f.array;
+  nw = rec_array->f.elem_count;
+  iw = position / 64;
+  live = ~words[iw] & (~(uint64_t) 0 << (position % 64));
+  while (live == 0 && ++iw < nw) {
+    live = ~words[iw];
+  }
+  if (live == 0) {
+    return rec_array->a.elem_count;
+  }
+  position = 64 * iw + sc_recycle_array_ctz (live);
+  return SC_MIN (position, rec_array->a.elem_count);
+}
+
+void
+sc_recycle_array_compact (sc_recycle_array_t * rec_array,
+                          sc_array_t * newindices)
+{
+  const size_t        elem_size = rec_array->a.elem_size;
+  const size_t        old_count = rec_array->a.elem_count;
+  size_t              pos, dest, hole;
+  char               *base;
+
+  SC_ASSERT (newindices == NULL || newindices->elem_size == sizeof (size_t));
+
+  if (newindices != NULL) {
+    sc_array_resize (newindices, old_count);
+  }
+
+  /* move the valid objects down in ascending order */
+  base = rec_array->a.array;
+  dest = 0;
+  hole = rec_array->elem_count;
+  for (pos = 0; pos < old_count; ++pos) {
+    if (*sc_recycle_array_word (rec_array, pos) &
+        ((uint64_t) 1 << (pos % 64))) {
+      if (newindices != NULL) {
+        *(size_t *) sc_array_index (newindices, pos) = hole;
+      }
+      ++hole;
+      continue;
+    }
+    if (newindices != NULL) {
+      *(size_t *) sc_array_index (newindices, pos) = dest;
+    }
+    if (dest != pos) {
+      memcpy (base + dest * elem_size, base + pos * elem_size, elem_size);
+    }
+    ++dest;
+  }
+  SC_ASSERT (dest == rec_array->elem_count && hole == old_count);
+
+  /* release the storage of the free slots */
+  sc_array_resize (&rec_array->a, rec_array->elem_count);
+  sc_array_resize (&rec_array->f, (rec_array->elem_count + 63) / 64);
+  sc_array_memset (&rec_array->f, 0);
+  rec_array->f_word = 0;
+}
@@ -88,6 +88,20 @@ typedef int         (*sc_equal_function_t) (const void *v1,
  */
 typedef int         (*sc_hash_foreach_t) (void **v, const void *u);
 
+/** Rules to choose the allocation size when an array is resized.
+ * Arrays use \ref SC_ARRAY_GROWTH_DEFAULT unless changed by
+ * \ref sc_array_set_growth.
+ */
+typedef enum sc_array_growth
+{
+  SC_ARRAY_GROWTH_DEFAULT = 0,  /**< Powers of two below 32 MiB,
+                                     then like \ref SC_ARRAY_GROWTH_PAGES. */
+  SC_ARRAY_GROWTH_DOUBLE,       /**< Always the next power of two bytes. */
+  SC_ARRAY_GROWTH_PAGES,        /**< A quarter more in whole 2 MiB pages. */
+  SC_ARRAY_GROWTH_EXACT         /**< Exactly the bytes of the elements. */
+}
+sc_array_growth_t;
+
 /** The sc_array object provides a dynamic array of equal-size elements.
  * Elements are accessed by their 0-based index.  Their address may change.
  * The number of elements (== elem_count) of the array can be changed by 
@@ -109,6 +123,13 @@ typedef struct sc_array
                                            distinguishes an array of size 0
                                            from a view of size 0 */
   char               *array;    /**< linear array to store elements */
+  sc_memory_domain_t  domain;   /**< where the elements live, see
+                                     \ref sc_array_init_domain */
+  sc_array_growth_t   growth;   /**< allocation rule, see
+                                     \ref sc_array_set_growth */
+  int                 is_inline;        /**< true if the elements are in
+                                           the storage of an
+                                           \ref sc_array_inline_t */
 }
 sc_array_t;
 
@@ -143,6 +164,14 @@ sc_array_t         *sc_array_new_count (size_t elem_size, size_t elem_count);
 /** Deprecated: use \ref sc_array_new_count. */
 #define sc_array_new_size(s,c) (sc_array_new_count ((s), (c)))
 
+/** Creates a new array structure with 0 elements in a memory domain.
+ * \param [in] elem_size    Size of one array element in bytes.
+ * \param [in] domain       Where to allocate the elements.
+ * \return                  Return an allocated array of zero length.
+ */
+sc_array_t         *sc_array_new_domain (size_t elem_size,
+                                         sc_memory_domain_t domain);
+
 /** Creates a new view of an existing sc_array_t.
  * \param [in] array    The array must not be resized while view is alive.
  * \param [in] offset   The offset of the viewed section in element units.
@@ -179,6 +208,19 @@ void                sc_array_destroy_null (sc_array_t ** parray);
  */
 void                sc_array_init (sc_array_t * array, size_t elem_size);
 
+/** Initializes an array structure whose elements live in a memory domain.
+ * Resizing, \ref sc_array_copy and \ref sc_array_reset work in every
+ * domain, allocating through \ref sc_malloc_domain.  Views created by
+ * \ref sc_array_init_view inherit the domain.  All functions that access
+ * the elements on the host require \ref sc_memory_domain_is_host.
+ * \param [in,out]  array       Array structure to be initialized.
+ * \param [in] elem_size        Size of one array element in bytes.
+ * \param [in] domain           Where to allocate the elements.
+ */
+void                sc_array_init_domain (sc_array_t * array,
+                                          size_t elem_size,
+                                          sc_memory_domain_t domain);
+
 /** Initializes an already allocated (or static) array structure
  * and allocates a given number of elements.
  * Deprecated: use \ref sc_array_init_count.
@@ -224,6 +266,45 @@ void                sc_array_init_view (sc_array_t * view, sc_array_t * array,
 void                sc_array_init_data (sc_array_t * view, void *base,
                                         size_t elem_size, size_t elem_count);
 
+/** Number of bytes stored inside an \ref sc_array_inline_t. */
+#define SC_ARRAY_INLINE_BYTES 64
+
+/** An sc_array with storage for a few elements inside the structure.
+ * It is initialized by \ref sc_array_init_inline and then used through
+ * its member \b a with all sc_array functions.  Only when the array grows
+ * beyond \ref SC_ARRAY_INLINE_BYTES, it moves its elements to the heap.
+ * The structure must not be copied by assignment or memcpy while its
+ * elements are inline; use \ref sc_array_copy instead.
+ */
+typedef struct sc_array_inline
+{
+  sc_array_t          a;        /**< the array */
+  union
+  {
+    char                bytes[SC_ARRAY_INLINE_BYTES];
+    double              d;
+    void               *p;
+    long long           ll;
+  }
+  buf;                          /**< inline storage, aligned for builtins */
+}
+sc_array_inline_t;
+
+/** test whether the sc_array_t keeps its elements inline */
+#define SC_ARRAY_IS_INLINE(a) ((a)->is_inline)
+
+/** Initialize an array with inline storage.
+ * The array owns its elements and may be grown or shrunk as usual.
+ * Elements of small arrays live inside the structure and need no
+ * allocation.  Calling \ref sc_array_reset is required if the array may
+ * have grown beyond the inline storage, and legal otherwise.
+ * After a reset, the array only uses heap storage.
+ * \param [out] ai          Inline array structure to be initialized.
+ * \param [in] elem_size    Size of one array element in bytes.
+ */
+void                sc_array_init_inline (sc_array_inline_t * ai,
+                                          size_t elem_size);
+
 /** Run memset on the array storage.
  * We pass the character to memset unchanged.  Thus, care must be taken when
  * setting values below -1 or above 127, just as with standard memset (3).
@@ -268,6 +349,12 @@ void                sc_array_rewind (sc_array_t * array, size_t new_count);
  * If the array is a view, new_count must not be greater than the element
  * count of the view when it was created.  The original offset of the view
  * cannot be changed.
+ * The memory is kept while the array uses more than half of it.
+ * Otherwise it is reallocated to the size chosen by the growth rule of
+ * the array, see \ref sc_array_set_growth.  By default, this is the next
+ * power of two bytes, or for arrays of 32 MiB and more, a quarter more in
+ * whole 2 MiB pages.  Large arrays are always grown by realloc, such that
+ * the C library may remap their pages instead of copying them.
  * \param [in,out] array    The element count and address is modified.
  * \param [in] new_count    New element count of the array.
  *                          If it is zero and the array is not a view,
@@ -275,6 +362,35 @@ void                sc_array_rewind (sc_array_t * array, size_t new_count);
  */
 void                sc_array_resize (sc_array_t * array, size_t new_count);
 
+/** Make sure that an array can hold a number of elements without realloc.
+ * The element count is not changed.  If it is less than the capacity,
+ * the memory is allocated exactly.  Growing the array by \ref
+ * sc_array_push or \ref sc_array_push_count keeps it, while a
+ * \ref sc_array_resize to half the capacity or less releases it.
+ * This function is not allowed for views.
+ * \param [in,out] array    The allocation and address may be modified.
+ * \param [in] elem_count   Minimum number of elements to hold.
+ */
+void                sc_array_reserve (sc_array_t * array, size_t elem_count);
+
+/** Choose how an array allocates memory when it is resized.
+ * The rule takes effect on the next reallocation.  Views inherit the
+ * rule of their array but never allocate.
+ * With \ref SC_ARRAY_GROWTH_EXACT, every \ref sc_array_push beyond the
+ * capacity reallocates, so it is best combined with \ref sc_array_reserve.
+ * \param [in,out] array    Valid array.
+ * \param [in] growth       The allocation rule.
+ */
+void                sc_array_set_growth (sc_array_t * array,
+                                         sc_array_growth_t growth);
+
+/** Reallocate the array memory to be exactly the size of its elements.
+ * This function is not allowed for views.
+ * Inline storage of a \ref sc_array_inline_t is not released.
+ * \param [in,out] array    The allocation and address may be modified.
+ */
+void                sc_array_shrink_to_fit (sc_array_t * array);
+
 /** Copy the contents of one array into another.
  * Both arrays must have equal element sizes.
  * The source array may be a view.
@@ -323,6 +439,19 @@ void                sc_array_sort (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Sorts the array like \ref sc_array_sort, using threads if possible.
+ * If configured with OpenMP, large arrays are sorted in blocks by all
+ * threads outside of a parallel region and then merged.  The function
+ * \a compar must be safe to call from several threads at once.
+ * The result is the same as with \ref sc_array_sort, except possibly
+ * for the order of elements that compare equal.
+ * \param [in] array    The array to sort.
+ * \param [in] compar   The comparison function to be used.
+ */
+void                sc_array_sort_parallel (sc_array_t * array,
+                                            int (*compar) (const void *,
+                                                           const void *));
+
 /** Check whether the array is sorted wrt. the comparison function.
  * \param [in] array    The array to check.
  * \param [in] compar   The comparison function to be used.
@@ -350,6 +479,115 @@ void                sc_array_uniq (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Remove duplicate entries from an array in any order.
+ * The elements are entered into a temporary open addressing table, such
+ * that the expected run time is O(N) instead of O(N log N) for sorting.
+ * This function is not allowed for views.
+ * \param [in,out] array  The array size will be reduced as necessary.
+ *                        Of every set of equal elements, the first is kept.
+ * \param [in] hash_fn    Hash of an element.  If NULL, the bytes of the
+ *                        element are hashed by \ref sc_hash_bytes.
+ * \param [in] equal_fn   Equality of two elements.  If NULL, the bytes of
+ *                        the elements are compared.
+ * \param [in] user       Passed as last argument to both functions.
+ * \param [in] keep_order If true, the kept elements remain in the order of
+ *                        their first occurrence.  Otherwise, each duplicate
+ *                        is replaced by the last element, which moves fewer
+ *                        elements when there are few duplicates.
+ * \param [out] map       If not NULL, array of size_t that is resized to the
+ *                        input count.  Entry i is the index on output of
+ *                        the element at index i on input or its duplicate.
+ */
+void                sc_array_uniq_unsorted (sc_array_t * array,
+                                            sc_hash_function_t hash_fn,
+                                            sc_equal_function_t equal_fn,
+                                            void *user, int keep_order,
+                                            sc_array_t * map);
+
+/** Remove duplicate entries from an array in any order and count them.
+ * The arguments are as for \ref sc_array_uniq_unsorted with the order
+ * of first occurrence kept.  With functions that hash and compare only
+ * a key within each element, this counts the elements by key.
+ * \param [out] counts    Array of size_t that is resized to the output
+ *                        count.  Entry k is the number of input elements
+ *                        equal to the element at index k on output.
+ */
+void                sc_array_uniq_count (sc_array_t * array,
+                                         sc_hash_function_t hash_fn,
+                                         sc_equal_function_t equal_fn,
+                                         void *user, sc_array_t * map,
+                                         sc_array_t * counts);
+
+/** Sort an array in place by introsort.
+ * The element swaps are inlined for the element sizes 4, 8 and 16.
+ * Like \ref sc_array_sort, the order of equal elements is unspecified.
+ * Quicksort is used with a fallback to heapsort deep in the recursion,
+ * so the run time is O(N log N) in the worst case.
+ * \param [in,out] array    The array to sort.
+ * \param [in] compar       The comparison function to be used.
+ */
+void                sc_array_sort_intro (sc_array_t * array,
+                                         int (*compar) (const void *,
+                                                        const void *));
+
+/** The types of keys for the sc_array_*_keyed functions. */
+typedef enum sc_array_key
+{
+  SC_ARRAY_KEY_INT32,           /**< int32_t */
+  SC_ARRAY_KEY_UINT32,          /**< uint32_t */
+  SC_ARRAY_KEY_INT64,           /**< int64_t */
+  SC_ARRAY_KEY_UINT64,          /**< uint64_t */
+  SC_ARRAY_KEY_UINT128          /**< sc_uint128_t, see sc_uint128.h */
+}
+sc_array_key_t;
+
+/** Sort an array in ascending order of an integer key in each element.
+ * We use a stable LSD radix sort that skips bytes equal in all keys.
+ * It needs a temporary copy of the array, but no comparison function.
+ * The key need not be aligned within the element.
+ * \param [in,out] array    The array to sort.
+ * \param [in] key_offset   Byte offset of the key in each element.
+ * \param [in] key_type     The type of the key.
+ */
+void                sc_array_sort_keyed (sc_array_t * array,
+                                         size_t key_offset,
+                                         sc_array_key_t key_type);
+
+/** Check whether an array is sorted by an integer key in each element.
+ * \param [in] array        The array to check.
+ * \param [in] key_offset   Byte offset of the key in each element.
+ * \param [in] key_type     The type of the key.
+ * \return                  True if array is sorted, false otherwise.
+ */
+int                 sc_array_is_sorted_keyed (sc_array_t * array,
+                                              size_t key_offset,
+                                              sc_array_key_t key_type);
+
+/** Transform the key of an element into an unsigned 128 bit number.
+ * The transformation preserves the order of the keys of the given type.
+ * \param [in] elem         Pointer to the element.
+ * \param [in] key_offset   Byte offset of the key in the element.
+ * \param [in] key_type     The type of the key.
+ * \param [out] high_bits   The more significant 64 bits of the number.
+ * \param [out] low_bits    The less significant 64 bits of the number.
+ */
+void                sc_array_key_transform (const void *elem,
+                                            size_t key_offset,
+                                            sc_array_key_t key_type,
+                                            uint64_t * high_bits,
+                                            uint64_t * low_bits);
+
+/** Remove the entries of duplicate key from an array sorted by this key.
+ * Of every run of equal keys, the first element is kept.
+ * This function is not allowed for views.
+ * \param [in,out] array    The array size will be reduced as necessary.
+ * \param [in] key_offset   Byte offset of the key in each element.
+ * \param [in] key_type     The type of the key.
+ */
+void                sc_array_uniq_keyed (sc_array_t * array,
+                                         size_t key_offset,
+                                         sc_array_key_t key_type);
+
 /** Performs a binary search on an array. The array must be sorted.
  * \param [in] array   A sorted array to search in.
  * \param [in] key     An element to be searched for.
@@ -389,6 +627,19 @@ void                sc_array_split (sc_array_t * array, sc_array_t * offsets,
                                     size_t num_types, sc_array_type_t type_fn,
                                     void *data);
 
+/** Compute the offsets of groups of types like \ref sc_array_split.
+ * If configured with OpenMP, large \a num_types are split by all threads
+ * outside of a parallel region.  The function \a type_fn must then be
+ * safe to call from several threads at once.  The result is the same as
+ * with \ref sc_array_split.
+ * The parameters are those of \ref sc_array_split.
+ */
+void                sc_array_split_parallel (sc_array_t * array,
+                                             sc_array_t * offsets,
+                                             size_t num_types,
+                                             sc_array_type_t type_fn,
+                                             void *data);
+
 /** Determine whether \a array is an array of size_t's whose entries include
  * every integer 0 <= i < array->elem_count.
  * \param [in] array         An array.
@@ -408,15 +659,70 @@ int                 sc_array_is_permutation (sc_array_t * array);
  *                            algorithm; if false, \a newindices will be the
  *                            identity permutation on output, but the
  *                            algorithm will only use O(1) space.
+ *                            If true and configured with OpenMP, a large
+ *                            array is permuted into a temporary copy by
+ *                            all threads with the same result; no user
+ *                            code runs in them.  If true otherwise, the
+ *                            array is permuted by
+ *                            \ref sc_array_permute_multi.
  */
 void                sc_array_permute (sc_array_t * array,
                                       sc_array_t * newindices, int keepperm);
 
+/** Apply one permutation to several arrays of the same length.
+ * The data in \a arrays[k][i] moves to \a arrays[k][newindices[i]] for
+ * every array, each element being read and written once per pass.
+ * If the temporary memory fits into \a max_bytes, the elements are
+ * scattered out of place: directly for small arrays, and otherwise in two
+ * passes that first sort the elements into buckets of neighboring target
+ * indices like a radix scatter, such that the writes of the second pass
+ * stay within a few cache lines and memory pages.  Arrays that own their
+ * memory then take over the new buffers without copying back.
+ * Otherwise, the cycles of the permutation are followed in place,
+ * marking the visited indices in a bitset of \a elem_count / 8 bytes.
+ * \param [in,out] arrays    Arrays of equal element count and any element
+ *                           size in host accessible memory.
+ * \param [in] num_arrays    Nonnegative number of arrays.
+ * \param [in] newindices    Permutation array (see
+ *                           sc_array_is_permutation).  It is not changed.
+ * \param [in] max_bytes     Bound on the temporary memory of the out of
+ *                           place algorithm.  Use (size_t) -1 for none,
+ *                           0 to always permute in place.
+ */
+void                sc_array_permute_multi (sc_array_t ** arrays,
+                                            int num_arrays,
+                                            sc_array_t * newindices,
+                                            size_t max_bytes);
+
 /** Computes the adler32 checksum of array data (see zlib documentation).
  * This is a faster checksum than crc32, and it works with zeros as data.
+ * If configured with OpenMP, blocks of a large array are summed by
+ * several threads and combined into the same checksum.
  */
 unsigned int        sc_array_checksum (sc_array_t * array);
 
+/** Computes the CRC32C checksum of array data as \ref sc_io_crc32c does.
+ * The SSE 4.2 or ARMv8 CRC instructions are used where available.
+ * If configured with OpenMP, blocks of a large array are checksummed by
+ * several threads and combined into the same checksum.
+ * \param [in] array       Array of any element size, may be a view.
+ * \return                 CRC32C of the elem_count * elem_size bytes.
+ */
+uint32_t            sc_array_crc32c (const sc_array_t * array);
+
+/** Computes the CRC32C checksum of an array distributed over the processes.
+ * The result is that of \ref sc_array_crc32c on the concatenation of the
+ * local arrays in rank order, so it depends on the order of the data.
+ * It is computed from the local checksums and byte counts by one
+ * MPI_Allreduce with an order-preserving operation, without moving data.
+ * This function is collective over \a mpicomm.
+ * \param [in] array       Local part of the array, may be empty.
+ * \param [in] mpicomm     Communicator over which the array is split.
+ * \return                 The global checksum, the same on all processes.
+ */
+uint32_t            sc_array_checksum_global (const sc_array_t * array,
+                                              sc_MPI_Comm mpicomm);
+
 /** Adds an element to a priority queue.
  * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
@@ -449,6 +755,110 @@ size_t              sc_array_pqueue_pop (sc_array_t * array,
                                          int (*compar) (const void *,
                                                         const void *));
 
+/** An indexed priority queue of fixed-size elements.
+ * Each element is identified by a handle, a nonnegative integer chosen by
+ * the caller, such as a vertex number in a graph search.  The queue keeps
+ * the position of every handle in the heap, which allows to change the
+ * priority of a queued element and to remove it in O(log n) time.
+ * The heap has four children per node, which reduces its depth and cache
+ * misses compared to a binary heap.  The heap only moves handles, while
+ * the element data stays in an \ref sc_array_t indexed by handle.
+ * The queue pops the element that is smallest wrt. the comparison.
+ */
+typedef struct sc_ipqueue sc_ipqueue_t;
+
+/** Create a new empty indexed priority queue.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] compar       The comparison function to be used.
+ * \return                  A valid and empty priority queue.
+ */
+sc_ipqueue_t       *sc_ipqueue_new (size_t elem_size,
+                                    int (*compar) (const void *,
+                                                   const void *));
+
+/** Destroy an indexed priority queue and all its element data.
+ * \param [in,out] pq   The queue is invalid after this call.
+ */
+void                sc_ipqueue_destroy (sc_ipqueue_t * pq);
+
+/** Return the number of elements in an indexed priority queue. */
+size_t              sc_ipqueue_count (sc_ipqueue_t * pq);
+
+/** Calculate the memory used by an indexed priority queue. */
+size_t              sc_ipqueue_memory_used (sc_ipqueue_t * pq);
+
+/** Check whether a handle is currently in an indexed priority queue. */
+int                 sc_ipqueue_contains (sc_ipqueue_t * pq, size_t handle);
+
+/** Access the data of an element in an indexed priority queue.
+ * Its priority must not be changed through this pointer; use
+ * \ref sc_ipqueue_update instead.  The pointer is valid until the next
+ * call to \ref sc_ipqueue_push or \ref sc_ipqueue_heapify.
+ * \param [in] handle   A handle contained in the queue.
+ * \return              Pointer to the element data.
+ */
+void               *sc_ipqueue_elem (sc_ipqueue_t * pq, size_t handle);
+
+/** Add an element to an indexed priority queue.
+ * \param [in] handle   A handle not contained in the queue.
+ * \param [in] elem     The element data of size elem_size to copy.
+ */
+void                sc_ipqueue_push (sc_ipqueue_t * pq, size_t handle,
+                                     const void *elem);
+
+/** Change the data of a queued element to a smaller or equal priority.
+ * This is the classic decrease-key operation of Dijkstra's algorithm.
+ * \param [in] handle   A handle contained in the queue.
+ * \param [in] elem     The new element data; must not compare greater
+ *                      than the previous data.
+ */
+void                sc_ipqueue_decrease_key (sc_ipqueue_t * pq,
+                                             size_t handle,
+                                             const void *elem);
+
+/** Change the data of a queued element to an arbitrary priority.
+ * \param [in] handle   A handle contained in the queue.
+ * \param [in] elem     The new element data.
+ */
+void                sc_ipqueue_update (sc_ipqueue_t * pq, size_t handle,
+                                       const void *elem);
+
+/** Remove an element with a given handle from an indexed priority queue.
+ * \param [in] handle   A handle contained in the queue.
+ * \param [out] elem    If not NULL, the element data is copied here.
+ */
+void                sc_ipqueue_remove (sc_ipqueue_t * pq, size_t handle,
+                                       void *elem);
+
+/** Return the handle of the smallest element without removing it.
+ * \param [in] pq       A nonempty queue.
+ */
+size_t              sc_ipqueue_top (sc_ipqueue_t * pq);
+
+/** Remove the smallest element from an indexed priority queue.
+ * \param [in] pq       A nonempty queue.
+ * \param [out] elem    If not NULL, the element data is copied here.
+ * \return              The handle of the removed element.
+ */
+size_t              sc_ipqueue_pop (sc_ipqueue_t * pq, void *elem);
+
+/** Remove up to n of the smallest elements in ascending order.
+ * \param [in] n            The maximum number of elements to pop.
+ * \param [out] handles     Array of at least n entries for the handles.
+ * \return                  The number of elements popped, which is the
+ *                          minimum of n and the count of the queue.
+ */
+size_t              sc_ipqueue_pop_n (sc_ipqueue_t * pq, size_t n,
+                                      size_t * handles);
+
+/** Replace the queue contents by the elements of an array in O(n) time.
+ * The element with index i in \a array receives the handle i.
+ * \param [in,out] pq   The queue, whose previous elements are removed.
+ * \param [in] array    Elements of the size of the queue elements.
+ */
+void                sc_ipqueue_heapify (sc_ipqueue_t * pq,
+                                        sc_array_t * array);
+
 /** Returns a pointer to an array element.
  * \param [in] array Valid array.
  * \param [in] index needs to be in [0]..[elem_count-1].
@@ -595,6 +1005,129 @@ sc_array_push (sc_array_t * array)
   return sc_array_push_count (array, 1);
 }
 
+/** A structure of arrays with named fixed-size columns.
+ * Every column is an \ref sc_array_t of the same number of entries, and
+ * entry i of all columns together forms record i.  Kernels that use only
+ * some fields of a record read only those columns from memory.  All
+ * operations that change the number or order of records act on every
+ * column alike.
+ */
+typedef struct sc_soa
+{
+  /* interface variables */
+  size_t              elem_count;       /**< number of records */
+  int                 num_columns;      /**< number of columns */
+
+  /* implementation variables */
+  int                 alloc_columns;
+  sc_array_t         *columns;  /**< one array per column */
+  char              **names;    /**< column names, entries may be NULL */
+}
+sc_soa_t;
+
+/** Calculate the memory used by a structure of arrays.
+ * \param [in] soa      Valid structure of arrays.
+ * \return              Memory used in bytes.
+ */
+size_t              sc_soa_memory_used (sc_soa_t * soa);
+
+/** Create a structure of arrays without columns and records.
+ * \return              Structure to be freed by \ref sc_soa_destroy.
+ */
+sc_soa_t           *sc_soa_new (void);
+
+/** Free a structure of arrays and all of its columns. */
+void                sc_soa_destroy (sc_soa_t * soa);
+
+/** Add a column.  If there are records, their new entries are zero.
+ * \param [in,out] soa      Valid structure of arrays.
+ * \param [in] name         Name of the column, copied; may be NULL.
+ * \param [in] elem_size    Size of one entry of the column in bytes.
+ * \return                  Index of the new column.
+ */
+int                 sc_soa_add_column (sc_soa_t * soa, const char *name,
+                                       size_t elem_size);
+
+/** Look up a column by name.
+ * \param [in] soa      Valid structure of arrays.
+ * \param [in] name     Name of the column.
+ * \return              Index of the first column of that name, or -1.
+ */
+int                 sc_soa_column_index (sc_soa_t * soa, const char *name);
+
+/** Initialize a view of all entries of one column.
+ * The view may be passed to any function for arrays that does not change
+ * its size, and it is invalidated by a change of the number of records.
+ * \param [out] view    Array initialized as a view.
+ * \param [in] soa      Valid structure of arrays.
+ * \param [in] column   Index of the column.
+ */
+void                sc_soa_column_view (sc_array_t * view, sc_soa_t * soa,
+                                        int column);
+
+/** Return a pointer to one entry of a column. */
+static inline void *
+sc_soa_index (sc_soa_t * soa, int column, size_t i)
+{
+  SC_ASSERT (0 <= column && column < soa->num_columns);
+  SC_ASSERT (i < soa->elem_count);
+
+  return sc_array_index (&soa->columns[column], i);
+}
+
+/** Change the number of records of all columns.
+ * New entries are uninitialized.
+ * \param [in,out] soa      Valid structure of arrays.
+ * \param [in] new_count    New number of records.
+ */
+void                sc_soa_resize (sc_soa_t * soa, size_t new_count);
+
+/** Append an uninitialized record.
+ * \param [in,out] soa      Valid structure of arrays.
+ * \return                  Index of the new record.
+ */
+size_t              sc_soa_push (sc_soa_t * soa);
+
+/** Permute the records of all columns.
+ * \param [in,out] soa      Valid structure of arrays.
+ * \param [in] newindices   Permutation array of size_t as in \ref
+ *                          sc_array_permute.  It is not changed.
+ */
+void                sc_soa_permute (sc_soa_t * soa, sc_array_t * newindices);
+
+/** Sort the records by the entries of one column.
+ * The sort is not stable.
+ * \param [in,out] soa      Valid structure of arrays.
+ * \param [in] column       Index of the column to compare.
+ * \param [in] compar       Comparison function for two column entries.
+ * \param [out] newindices  If not NULL, this array of size_t is resized
+ *                          to the number of records and receives the new
+ *                          position of every old record.
+ */
+void                sc_soa_sort (sc_soa_t * soa, int column,
+                                 int (*compar) (const void *, const void *),
+                                 sc_array_t * newindices);
+
+/** Copy array-of-structs records into the columns.
+ * The structure of arrays is resized to the number of records.
+ * \param [in,out] soa      Valid structure of arrays.
+ * \param [in] aos          Array of records, each holding all columns.
+ * \param [in] offsets      Byte offset of every column in a record,
+ *                          usually obtained by offsetof.
+ */
+void                sc_soa_from_aos (sc_soa_t * soa, sc_array_t * aos,
+                                     const size_t * offsets);
+
+/** Copy the columns into array-of-structs records.
+ * Bytes of a record not covered by a column are left unchanged.
+ * \param [in] soa          Valid structure of arrays.
+ * \param [in,out] aos      Array of records, resized to the number of
+ *                          records unless it is a view of that size.
+ * \param [in] offsets      Byte offset of every column in a record.
+ */
+void                sc_soa_to_aos (sc_soa_t * soa, sc_array_t * aos,
+                                   const size_t * offsets);
+
 /** A data container to create memory items of the same size.
  * Allocations are bundled so it's fast for small memory sizes.
  * The items created will remain valid until the container is destroyed.
@@ -609,9 +1142,27 @@ typedef struct sc_mstamp
   size_t              cur_snext;   /**< Next number within a stamp */
   char               *current;     /**< Memory of current stamp */
   sc_array_t          remember;    /**< Collects all stamps */
+  int                 flags;       /**< Bitwise or of SC_MSTAMP_ flags */
 }
 sc_mstamp_t;
 
+/** Back the stamps by 2 MiB huge pages.
+ * We try explicit huge pages first and fall back to transparent ones.
+ * The stamp size is rounded up to a multiple of \ref SC_MSTAMP_HUGE_PAGE.
+ * Without mmap on the system, this flag is ignored.
+ */
+#define SC_MSTAMP_HUGE_PAGES 1
+
+/** Touch the complete memory of a stamp when it is created.
+ * The operating system usually places a page on the NUMA node of the
+ * thread first touching it, so this binds the stamp to the node of the
+ * thread whose allocation creates the stamp.
+ */
+#define SC_MSTAMP_FIRST_TOUCH 2
+
+/** Size of a huge page as used with \ref SC_MSTAMP_HUGE_PAGES. */
+#define SC_MSTAMP_HUGE_PAGE ((size_t) 1 << 21)
+
 /** Initialize a memory stamp container.
  * We provide allocation of fixed-size memory items
  * without allocating new memory in every request.
@@ -632,6 +1183,18 @@ sc_mstamp_t;
 void                sc_mstamp_init (sc_mstamp_t * mst,
                                     size_t stamp_unit, size_t elem_size);
 
+/** Initialize a memory stamp container with extra options.
+ * Calling it with flags equal to 0 is the same as \ref sc_mstamp_init.
+ * \param [in,out] mst          Legal pointer to a stamp structure.
+ * \param [in] stamp_unit       See \ref sc_mstamp_init.
+ * \param [in] elem_size        See \ref sc_mstamp_init.
+ * \param [in] flags            Bitwise or of \ref SC_MSTAMP_HUGE_PAGES
+ *                              and \ref SC_MSTAMP_FIRST_TOUCH.
+ */
+void                sc_mstamp_init_flags (sc_mstamp_t * mst,
+                                          size_t stamp_unit,
+                                          size_t elem_size, int flags);
+
 /** Free all memory in a stamp structure and all items previously returned.
  * \param [in,out]              Properly initialized stamp container.
  *                              On output, the structure is undefined.
@@ -665,6 +1228,83 @@ void               *sc_mstamp_alloc (sc_mstamp_t * mst);
  */
 size_t              sc_mstamp_memory_used (sc_mstamp_t * mst);
 
+/** Return the reserved and the touched bytes of all stamps.
+ * Memory that is reserved but never touched usually occupies no
+ * physical pages.  Without \ref SC_MSTAMP_FIRST_TOUCH, we count the
+ * bytes of all items handed out so far as touched, which is a bound
+ * from below for the memory resident in physical pages.
+ * \param [in]                  Properly initialized stamp container.
+ * \param [out] reserved        If not NULL, bytes allocated for stamps.
+ * \param [out] touched         If not NULL, bytes touched in stamps.
+ */
+void                sc_mstamp_memory_stats (sc_mstamp_t * mst,
+                                            size_t *reserved,
+                                            size_t *touched);
+
+/** An arena for transient memory of varying sizes released in scopes.
+ * Memory is handed out by advancing a pointer in large chunks.
+ * A scope opened by \ref sc_arena_push is closed by \ref sc_arena_pop,
+ * which releases all memory allocated in that scope at once.
+ * The chunks are kept for reuse, so code that opens a scope, allocates
+ * its temporaries and pops the scope again performs no heap calls once
+ * the arena has grown to the required size.
+ * An arena must only be used by one thread at a time.
+ */
+typedef struct sc_arena sc_arena_t;
+
+/** Allocate memory for an array of a type from an arena. */
+#define SC_ARENA_ALLOC(a,t,n) ((t *) sc_arena_alloc ((a), (n) * sizeof (t)))
+
+/** Allocate memory for an array of a type from an arena and zero it. */
+#define SC_ARENA_ALLOC_ZERO(a,t,n) \
+  ((t *) sc_arena_calloc ((a), (size_t) (n), sizeof (t)))
+
+/** Create a new arena.
+ * \param [in] chunk_bytes  Minimum size of the chunks we allocate.
+ *                          Passing 0 selects a default of 64 KiB.
+ * \return                  A new arena without an open scope.
+ */
+sc_arena_t         *sc_arena_new (size_t chunk_bytes);
+
+/** Destroy an arena and all memory allocated from it. */
+void                sc_arena_destroy (sc_arena_t * arena);
+
+/** Allocate memory from an arena.
+ * The memory is aligned to 16 bytes and valid until the innermost scope
+ * open at the time of allocation is popped or the arena is destroyed.
+ * \param [in] bytes    Number of bytes, may be 0.
+ * \return              Pointer to uninitialized memory.
+ */
+void               *sc_arena_alloc (sc_arena_t * arena, size_t bytes);
+
+/** Allocate zeroed memory for an array from an arena. */
+void               *sc_arena_calloc (sc_arena_t * arena,
+                                     size_t nmemb, size_t size);
+
+/** Open a new scope in an arena. */
+void                sc_arena_push (sc_arena_t * arena);
+
+/** Close the innermost scope and release its memory. */
+void                sc_arena_pop (sc_arena_t * arena);
+
+/** Release all memory of an arena to the heap and close all scopes. */
+void                sc_arena_reset (sc_arena_t * arena);
+
+/** Return the bytes allocated by an arena including unused chunks. */
+size_t              sc_arena_memory_used (sc_arena_t * arena);
+
+/** Return the default arena of the calling thread.
+ * It is created on first use and destroyed by \ref sc_arena_finalize.
+ * In builds with threads, every thread has its own default arena.
+ * Functions using it must pop every scope they push before returning.
+ */
+sc_arena_t         *sc_arena_default (void);
+
+/** Destroy the default arenas of all threads.
+ * This is called by \ref sc_finalize while no other threads are active.
+ */
+void                sc_arena_finalize (void);
+
 /** The sc_mempool object provides a large pool of equal-size elements.
  * The pool grows dynamically for element allocation.
  * Elements are referenced by their address which never changes.
@@ -712,6 +1352,18 @@ sc_mempool_t       *sc_mempool_new (size_t elem_size);
  */
 sc_mempool_t       *sc_mempool_new_zero_and_persist (size_t elem_size);
 
+/** Creates a new mempool structure with options for its memory stamps.
+ * \param [in] elem_size        Size of one element in bytes.
+ * \param [in] zero_and_persist Boolean to select this option.
+ * \param [in] mstamp_flags     Bitwise or of \ref SC_MSTAMP_HUGE_PAGES
+ *                              and \ref SC_MSTAMP_FIRST_TOUCH.
+ *                              Ignored if the mempool uses obstack.
+ * \return Returns an allocated and initialized memory pool.
+ */
+sc_mempool_t       *sc_mempool_new_flags (size_t elem_size,
+                                          int zero_and_persist,
+                                          int mstamp_flags);
+
 /** Same as sc_mempool_new, but for an already allocated sc_mempool_t pointer. */
 void                sc_mempool_init (sc_mempool_t * mempool,
                                      size_t elem_size);
@@ -794,6 +1446,192 @@ sc_mempool_free (sc_mempool_t * mempool, void *elem)
   *(void **) sc_array_push (freed) = elem;
 }
 
+/** Allocate a number of elements at once.
+ * Elements previously returned to the pool are recycled first.
+ * The remaining ones are handed out as contiguous runs of memory.
+ * The elements are equivalent to those from \ref sc_mempool_alloc.
+ * \param [in,out] mempool      Valid memory pool.
+ * \param [in] n                Number of elements to allocate.
+ * \param [out] out             Array of length at least \b n.
+ *                              On output, it holds the element pointers.
+ */
+void                sc_mempool_alloc_n (sc_mempool_t * mempool, size_t n,
+                                        void **out);
+
+/** Return a number of previously allocated elements to the pool.
+ * \param [in,out] mempool      Valid memory pool.
+ * \param [in] n                Number of elements to free.
+ * \param [in] elems            Array of \b n element pointers.
+ */
+void                sc_mempool_free_n (sc_mempool_t * mempool, size_t n,
+                                       void **elems);
+
+/** Statistics of the memory held by a memory pool. */
+typedef struct sc_mempool_stats
+{
+  size_t              live;     /**< number of elements in use */
+  size_t              freed;    /**< number of elements kept for reuse */
+  size_t              chunks;   /**< number of stamps or obstack chunks */
+  size_t              free_chunks;      /**< chunks without any element in
+                                             use that \ref sc_mempool_trim
+                                             would release */
+  size_t              reserved; /**< bytes reserved for elements */
+  double              fragmentation;    /**< the fraction of freed elements
+                                             among all elements handed out */
+}
+sc_mempool_stats_t;
+
+/** Compute statistics of the memory held by a memory pool.
+ * Finding the free chunks takes time proportional to the number of freed
+ * elements times the logarithm of the number of chunks.
+ * \param [in] mempool         Valid memory pool.
+ * \param [out] stats          Filled with the current statistics.
+ */
+void                sc_mempool_get_stats (sc_mempool_t * mempool,
+                                          sc_mempool_stats_t * stats);
+
+/** Return the memory stamps that hold no element in use to the system.
+ * The freed elements in these stamps are removed from the pool, and the
+ * current stamp starts over if all of its elements are freed.  The
+ * elements in use are not moved.  This is useful after a peak in the
+ * number of elements, such as after coarsening an adaptive mesh.
+ * The occupancy of the stamps is computed by this function, such that
+ * \ref sc_mempool_alloc and \ref sc_mempool_free remain unchanged.
+ * If the mempool uses obstack, no memory is released.
+ * \param [in,out] mempool     Valid memory pool.
+ * \return                     Number of bytes released.
+ */
+size_t              sc_mempool_trim (sc_mempool_t * mempool);
+
+/** Number of elements that a thread cache exchanges with the depot at once. */
+#define SC_MEMPOOL_MAGAZINE 32
+
+/** The sc_mempool_mt object provides a memory pool shared between threads.
+ * Threads do not access it directly but through their own \ref
+ * sc_mempool_cache_t, which exchanges elements with a shared depot in
+ * batches of \ref SC_MEMPOOL_MAGAZINE under a lock.  Thus an element
+ * allocated by one thread may be freed by any other thread.
+ * The zero_and_persist option has the same meaning as for \ref sc_mempool_t.
+ * Without --enable-pthread, OpenMP locks are used if configured.
+ */
+typedef struct sc_mempool_mt sc_mempool_mt_t;
+
+/** The per-thread cache of an \ref sc_mempool_mt_t.
+ * A cache must only be used by one thread at a time.
+ */
+typedef struct sc_mempool_cache
+{
+  /* interface variables */
+  sc_mempool_mt_t    *pool;             /**< the shared memory pool */
+  size_t              elem_size;        /**< size of a single element */
+  long                elem_count;       /**< allocations minus frees by
+                                           this cache, may be negative */
+  int                 zero_and_persist; /**< copied from the pool */
+
+  /* implementation variables */
+  int                 num_cached;       /**< number of cached elements */
+  void               *cached[2 * SC_MEMPOOL_MAGAZINE];  /**< free elements */
+}
+sc_mempool_cache_t;
+
+/** Creates a new thread-safe mempool with the zero_and_persist option off.
+ * \param [in] elem_size  Size of one element in bytes.
+ * \return Returns an allocated and initialized memory pool.
+ */
+sc_mempool_mt_t    *sc_mempool_mt_new (size_t elem_size);
+
+/** Creates a new thread-safe mempool with the zero_and_persist option on.
+ * \param [in] elem_size  Size of one element in bytes.
+ * \return Returns an allocated and initialized memory pool.
+ */
+sc_mempool_mt_t    *sc_mempool_mt_new_zero_and_persist (size_t elem_size);
+
+/** Destroy a thread-safe mempool.
+ * All caches must have been reset before.  All elements are invalidated.
+ * \param [in,out] mempool      Its memory is freed.
+ */
+void                sc_mempool_mt_destroy (sc_mempool_mt_t * mempool);
+
+/** Return the number of elements in use.
+ * The result is exact when all caches have been reset.
+ */
+size_t              sc_mempool_mt_elem_count (sc_mempool_mt_t * mempool);
+
+/** Calculate the memory used by a thread-safe mempool without its caches. */
+size_t              sc_mempool_mt_memory_used (sc_mempool_mt_t * mempool);
+
+/** Initialize a thread cache for a thread-safe mempool.
+ * This function may be called concurrently by several threads.
+ * \param [out] cache           Cache structure, usually owned by a thread.
+ * \param [in,out] mempool      The pool must stay alive until the cache
+ *                              is reset.
+ */
+void                sc_mempool_cache_init (sc_mempool_cache_t * cache,
+                                           sc_mempool_mt_t * mempool);
+
+/** Return all cached elements to the pool's depot and unregister the cache.
+ * Elements allocated through the cache stay valid.
+ * This function may be called concurrently by several threads.
+ */
+void                sc_mempool_cache_reset (sc_mempool_cache_t * cache);
+
+/** Fill an empty cache with elements from the depot or fresh memory.
+ * Called by \ref sc_mempool_cache_alloc, there is no need to call it directly.
+ */
+void                sc_mempool_cache_refill (sc_mempool_cache_t * cache);
+
+/** Move a magazine of elements from a full cache to the depot.
+ * Called by \ref sc_mempool_cache_free, there is no need to call it directly.
+ */
+void                sc_mempool_cache_flush (sc_mempool_cache_t * cache);
+
+/** Allocate a single element through a thread cache.
+ * The lock of the pool is only taken when the cache runs empty.
+ * \return Returns a new or recycled element pointer.
+ */
+/*@unused@*/
+static inline void *
+sc_mempool_cache_alloc (sc_mempool_cache_t * cache)
+{
+  void               *ret;
+
+  if (cache->num_cached == 0) {
+    sc_mempool_cache_refill (cache);
+  }
+  SC_ASSERT (cache->num_cached > 0);
+  ret = cache->cached[--cache->num_cached];
+  ++cache->elem_count;
+
+#ifdef SC_ENABLE_DEBUG
+  if (!cache->zero_and_persist) {
+    memset (ret, -1, cache->elem_size);
+  }
+#endif
+
+  return ret;
+}
+
+/** Return an element to the pool through a thread cache.
+ * The element may have been allocated through any cache of the same pool.
+ * \param [in] elem  The element to be returned to the pool.
+ */
+/*@unused@*/
+static inline void
+sc_mempool_cache_free (sc_mempool_cache_t * cache, void *elem)
+{
+#ifdef SC_ENABLE_DEBUG
+  if (!cache->zero_and_persist) {
+    memset (elem, -1, cache->elem_size);
+  }
+#endif
+
+  if (cache->num_cached == 2 * SC_MEMPOOL_MAGAZINE) {
+    sc_mempool_cache_flush (cache);
+  }
+  cache->cached[cache->num_cached++] = elem;
+  --cache->elem_count;
+}
+
 /** The sc_link structure is one link of a linked list.
  */
 typedef struct sc_link
@@ -897,6 +1735,287 @@ void               *sc_list_remove (sc_list_t * list, sc_link_t * pred);
  */
 void               *sc_list_pop (sc_list_t * list);
 
+/** The sc_dlink structure is embedded into user data to put them into
+ * a doubly linked \ref sc_dlist_t.  No memory is allocated by the list:
+ * the user structures may come from an \ref sc_mempool_t or any other
+ * allocator and are linked and unlinked in O(1).
+ */
+typedef struct sc_dlink
+{
+  struct sc_dlink    *prev;
+  struct sc_dlink    *next;
+}
+sc_dlink_t;
+
+/** Recover the user structure from a pointer to its embedded link.
+ * \param [in] link     Pointer to an \ref sc_dlink_t, must not be NULL.
+ * \param [in] type     Type of the user structure.
+ * \param [in] member   Name of the \ref sc_dlink_t member in \a type.
+ */
+#define SC_DLIST_ENTRY(link,type,member) \
+  ((type *) ((char *) (link) - offsetof (type, member)))
+
+/** The sc_dlist object is an intrusive, circular doubly linked list.
+ * It uses its head link as a sentinel and never allocates memory.
+ */
+typedef struct sc_dlist
+{
+  size_t              elem_count;
+  sc_dlink_t          head;     /**< sentinel, not a list element */
+}
+sc_dlist_t;
+
+/** Initialize an empty intrusive list.
+ * The list must not be copied since the sentinel refers to itself.
+ * \param [out] list    List structure to be initialized.
+ */
+static inline void
+sc_dlist_init (sc_dlist_t * list)
+{
+  list->elem_count = 0;
+  list->head.prev = list->head.next = &list->head;
+}
+
+/** Forget all links of the list in O(1); their memory is not touched.
+ * \param [in,out] list Valid list object.
+ */
+static inline void
+sc_dlist_reset (sc_dlist_t * list)
+{
+  sc_dlist_init (list);
+}
+
+/** Return the first link of the list or NULL if it is empty. */
+static inline sc_dlink_t *
+sc_dlist_first (sc_dlist_t * list)
+{
+  return list->head.next == &list->head ? NULL : list->head.next;
+}
+
+/** Return the last link of the list or NULL if it is empty. */
+static inline sc_dlink_t *
+sc_dlist_last (sc_dlist_t * list)
+{
+  return list->head.prev == &list->head ? NULL : list->head.prev;
+}
+
+/** Return the link following \a link or NULL at the end of the list. */
+static inline sc_dlink_t *
+sc_dlist_next (sc_dlist_t * list, sc_dlink_t * link)
+{
+  return link->next == &list->head ? NULL : link->next;
+}
+
+/** Return the link preceding \a link or NULL at the front of the list. */
+static inline sc_dlink_t *
+sc_dlist_prev (sc_dlist_t * list, sc_dlink_t * link)
+{
+  return link->prev == &list->head ? NULL : link->prev;
+}
+
+/** Insert a link after a given list position.
+ * \param [in,out] list     Valid list object.
+ * \param [in,out] pred     A link in the list, or NULL to prepend.
+ * \param [out] link        The link to insert; it must not be in a list.
+ */
+static inline void
+sc_dlist_insert_after (sc_dlist_t * list, sc_dlink_t * pred,
+                       sc_dlink_t * link)
+{
+  if (pred == NULL) {
+    pred = &list->head;
+  }
+  link->prev = pred;
+  link->next = pred->next;
+  pred->next->prev = link;
+  pred->next = link;
+  ++list->elem_count;
+}
+
+/** Insert a link before a given list position.
+ * \param [in,out] list     Valid list object.
+ * \param [in,out] succ     A link in the list, or NULL to append.
+ * \param [out] link        The link to insert; it must not be in a list.
+ */
+static inline void
+sc_dlist_insert_before (sc_dlist_t * list, sc_dlink_t * succ,
+                        sc_dlink_t * link)
+{
+  sc_dlist_insert_after (list, succ == NULL ? list->head.prev : succ->prev,
+                         link);
+}
+
+/** Insert a link at the beginning of the list. */
+static inline void
+sc_dlist_prepend (sc_dlist_t * list, sc_dlink_t * link)
+{
+  sc_dlist_insert_after (list, &list->head, link);
+}
+
+/** Insert a link at the end of the list. */
+static inline void
+sc_dlist_append (sc_dlist_t * list, sc_dlink_t * link)
+{
+  sc_dlist_insert_after (list, list->head.prev, link);
+}
+
+/** Remove an arbitrary link from the list in O(1).
+ * \param [in,out] list     Valid list object that contains \a link.
+ * \param [in,out] link     The link is removed and its pointers cleared.
+ */
+static inline void
+sc_dlist_remove (sc_dlist_t * list, sc_dlink_t * link)
+{
+  SC_ASSERT (list->elem_count > 0);
+  SC_ASSERT (link != &list->head);
+
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->prev = link->next = NULL;
+  --list->elem_count;
+}
+
+/** Remove the first link of the list.
+ * \param [in,out] list     Valid list object.
+ * \return                  The removed link or NULL if the list is empty.
+ */
+static inline sc_dlink_t *
+sc_dlist_pop (sc_dlist_t * list)
+{
+  sc_dlink_t         *link = sc_dlist_first (list);
+
+  if (link != NULL) {
+    sc_dlist_remove (list, link);
+  }
+  return link;
+}
+
+/** Remove the last link of the list.
+ * \param [in,out] list     Valid list object.
+ * \return                  The removed link or NULL if the list is empty.
+ */
+static inline sc_dlink_t *
+sc_dlist_pop_back (sc_dlist_t * list)
+{
+  sc_dlink_t         *link = sc_dlist_last (list);
+
+  if (link != NULL) {
+    sc_dlist_remove (list, link);
+  }
+  return link;
+}
+
+/** Move all links of one list into another in O(1).
+ * \param [in,out] list     Valid list object receiving the links.
+ * \param [in,out] pred     Links are inserted after this link of \a list,
+ *                          or at the front of \a list if it is NULL.
+ * \param [in,out] other    Different list whose links are moved.
+ *                          It is empty on output.
+ */
+static inline void
+sc_dlist_splice (sc_dlist_t * list, sc_dlink_t * pred, sc_dlist_t * other)
+{
+  sc_dlink_t         *first, *last;
+
+  SC_ASSERT (list != other);
+  if (other->elem_count == 0) {
+    return;
+  }
+  if (pred == NULL) {
+    pred = &list->head;
+  }
+  first = other->head.next;
+  last = other->head.prev;
+  first->prev = pred;
+  last->next = pred->next;
+  pred->next->prev = last;
+  pred->next = first;
+  list->elem_count += other->elem_count;
+  sc_dlist_init (other);
+}
+
+/** The sc_ulist object is an unrolled list of fixed-size items.
+ * Each node stores several consecutive items, which makes it a cache
+ * friendly double-ended queue.  The nodes are taken from an \ref
+ * sc_mempool_t and kept in an \ref sc_dlist_t.  Pointers to items stay
+ * valid until the item is popped.
+ */
+typedef struct sc_ulist
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of one item in bytes */
+  size_t              elem_count;       /**< number of items */
+
+  /* implementation variables */
+  size_t              per_node; /**< maximum number of items per node */
+  size_t              data_offset;      /**< offset of items in a node */
+  sc_dlist_t          nodes;    /**< ordered list of nodes */
+  int                 allocator_owned;
+  sc_mempool_t       *allocator;        /**< allocates the nodes */
+}
+sc_ulist_t;
+
+/** Return the node size in bytes for an \ref sc_ulist_t.
+ * A mempool created with this element size can be shared by all
+ * unrolled lists of the same item size and items per node.
+ * \param [in] elem_size    Size of one item in bytes.
+ * \param [in] per_node     Number of items per node, must be positive.
+ * \return                  Element size of a suitable mempool.
+ */
+size_t              sc_ulist_node_size (size_t elem_size, size_t per_node);
+
+/** Calculate the total memory used by an unrolled list.
+ * \param [in] ulist        Valid unrolled list.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_ulist_memory_used (sc_ulist_t * ulist);
+
+/** Create a new, empty unrolled list.
+ * \param [in] elem_size    Size of one item in bytes.
+ * \param [in] per_node     Number of items per node, or 0 for a default.
+ * \param [in] allocator    Mempool with element size \ref
+ *                          sc_ulist_node_size, or NULL to create one.
+ * \return                  New unrolled list.
+ */
+sc_ulist_t         *sc_ulist_new (size_t elem_size, size_t per_node,
+                                  sc_mempool_t * allocator);
+
+/** Destroy an unrolled list.
+ * \note If an allocator was provided in sc_ulist_new, it is not destroyed.
+ */
+void                sc_ulist_destroy (sc_ulist_t * ulist);
+
+/** Remove all items and return the nodes to the allocator. */
+void                sc_ulist_reset (sc_ulist_t * ulist);
+
+/** Add an item at the end of the list.
+ * \return                  Pointer to the uninitialized new item.
+ */
+void               *sc_ulist_push (sc_ulist_t * ulist);
+
+/** Add an item at the front of the list.
+ * \return                  Pointer to the uninitialized new item.
+ */
+void               *sc_ulist_push_front (sc_ulist_t * ulist);
+
+/** Return a pointer to the first item of a non-empty list. */
+void               *sc_ulist_first (sc_ulist_t * ulist);
+
+/** Return a pointer to the last item of a non-empty list. */
+void               *sc_ulist_last (sc_ulist_t * ulist);
+
+/** Remove the first item of a non-empty list.
+ * \param [in,out] ulist    Valid unrolled list.
+ * \param [out] elem        If not NULL, the item is copied here.
+ */
+void                sc_ulist_pop (sc_ulist_t * ulist, void *elem);
+
+/** Remove the last item of a non-empty list.
+ * \param [in,out] ulist    Valid unrolled list.
+ * \param [out] elem        If not NULL, the item is copied here.
+ */
+void                sc_ulist_pop_back (sc_ulist_t * ulist, void *elem);
+
 /** The sc_hash implements a hash table.
  * It uses an array which has linked lists as elements.
  */
@@ -913,6 +2032,13 @@ typedef struct sc_hash
   size_t              resize_checks, resize_actions;
   int                 allocator_owned;
   sc_mempool_t       *allocator;        /**< must allocate sc_link_t */
+
+  /* incremental resize, see \ref sc_hash_set_incremental */
+  int                 incremental;      /**< Boolean: resize step by step */
+  sc_array_t         *old_slots;        /**< not NULL during a migration */
+  size_t              migrate_next;     /**< next old slot to migrate */
+  size_t              migrate_steps;    /**< operations doing migration */
+  size_t              migrate_moved;    /**< objects moved by migration */
 }
 sc_hash_t;
 
@@ -924,6 +2050,50 @@ sc_hash_t;
  */
 unsigned int        sc_hash_function_string (const void *s, const void *u);
 
+/** Compute a 64 bit hash value of a byte sequence of given length.
+ * The data is processed a word at a time in the style of wyhash, and it
+ * may be unaligned.  The result depends on the machine's byte order.
+ * This hash function is NOT cryptographically safe!
+ * \param [in] data     Byte sequence to be hashed.
+ * \param [in] len      Length of the sequence in bytes.
+ * \param [in] seed     Different seeds give independent hash functions.
+ * \return              The computed hash value.
+ */
+uint64_t            sc_hash_bytes (const void *data, size_t len,
+                                   uint64_t seed);
+
+/** Compute a hash value from a null-terminated string using \ref
+ * sc_hash_bytes.  It is faster than \ref sc_hash_function_string
+ * and has better mixing, but yields different values.
+ * \param [in] s        Null-terminated string to be hashed.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_string_fast (const void *s,
+                                                  const void *u);
+
+/** Compute a hash value of a uint32_t key.
+ * All bits of the key influence all bits of the result.
+ * \param [in] v        Pointer to a uint32_t.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_u32 (const void *v, const void *u);
+
+/** Compute a hash value of a uint64_t key.
+ * \param [in] v        Pointer to a uint64_t.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_u64 (const void *v, const void *u);
+
+/** Compute a hash value of an sc_uint128_t key, see sc_uint128.h.
+ * \param [in] v        Pointer to an sc_uint128_t.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_u128 (const void *v, const void *u);
+
 /** Calculate the memory used by a hash table.
  * \param [in] hash        The hash table.
  * \return                 Memory used in bytes.
@@ -941,6 +2111,23 @@ sc_hash_t          *sc_hash_new (sc_hash_function_t hash_fn,
                                  sc_equal_function_t equal_fn,
                                  void *user_data, sc_mempool_t * allocator);
 
+/** Choose between one-shot and incremental resizing of a hash table.
+ * By default, a hash table rebuilds all of its slots in one go whenever
+ * the number of objects leaves the admissible range for the slot count.
+ * This takes time proportional to the size of the table.
+ * In incremental mode, the old slots are kept alongside the new ones and
+ * every subsequent lookup, insert and remove migrates a small, bounded
+ * number of old slots until the resize is complete.
+ * The migration work is recorded in migrate_steps and migrate_moved.
+ * Since a migration moves links, an address returned in the \b found
+ * argument of the hash functions is valid up to the next operation only.
+ * \param [in,out] hash         Valid hash table.
+ * \param [in] incremental      Boolean.  If false and a resize is in
+ *                              progress, it is completed right away.
+ */
+void                sc_hash_set_incremental (sc_hash_t * hash,
+                                             int incremental);
+
 /** Destroy a hash table.
  *
  * If the allocator is owned, this runs in O(1), otherwise in O(N).
@@ -1014,6 +2201,119 @@ void                sc_hash_print_statistics (int package_id,
                                               int log_priority,
                                               sc_hash_t * hash);
 
+/** One slot of the open addressing table \ref sc_hash_flat_t.
+ * The object pointer is stored inline together with its hash value,
+ * such that most unsuccessful comparisons do not touch the object.
+ */
+typedef struct sc_hash_flat_slot
+{
+  void               *v;        /**< the object stored in this slot */
+  unsigned int        hval;     /**< hash value of the object */
+  unsigned int        dist;     /**< 0 if the slot is empty, otherwise
+                                     1 + the distance to the home slot */
+}
+sc_hash_flat_slot_t;
+
+/** The sc_hash_flat implements a hash table with open addressing.
+ * It uses Robin Hood linear probing in a single power-of-two sized array
+ * of slots.  Compared to \ref sc_hash_t, there are no linked lists and no
+ * link allocator, and a lookup usually touches one cache line only.
+ * The object pointers stored are moved around by insertion and removal.
+ * Thus, the address returned in the \b found argument of the functions
+ * below is only valid until the table is modified the next time.
+ */
+typedef struct sc_hash_flat
+{
+  /* interface variables */
+  size_t              elem_count;       /**< total number of objects contained */
+
+  /* implementation variables */
+  size_t              slot_count;       /**< a power of two */
+  int                 slot_bits;        /**< binary log of slot_count */
+  sc_hash_flat_slot_t *slots;           /**< the open addressing slots */
+  void               *user_data;        /**< user data passed to hash function */
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+  size_t              resize_checks, resize_actions;
+}
+sc_hash_flat_t;
+
+/** Calculate the memory used by a flat hash table.
+ * \param [in] hash        The hash table.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_hash_flat_memory_used (sc_hash_flat_t * hash);
+
+/** Create a new flat hash table.
+ * The number of hash slots is chosen dynamically.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ * \param [in] user_data   User data passed through to the hash function.
+ */
+sc_hash_flat_t     *sc_hash_flat_new (sc_hash_function_t hash_fn,
+                                      sc_equal_function_t equal_fn,
+                                      void *user_data);
+
+/** Destroy a flat hash table in O(1).
+ * The objects pointed to by the table entries are not touched.
+ */
+void                sc_hash_flat_destroy (sc_hash_flat_t * hash);
+
+/** Destroy a flat hash table and set its pointer to NULL.
+ * \param [in,out] phash        Address of pointer to hash table.
+ *                              On output, pointer is NULLed.
+ */
+void                sc_hash_flat_destroy_null (sc_hash_flat_t ** phash);
+
+/** Remove all entries from a flat hash table.
+ * The slot array is shrunk to its minimal size.
+ */
+void                sc_hash_flat_truncate (sc_hash_flat_t * hash);
+
+/** Check if an object is contained in the flat hash table.
+ * \param [in]  v      The object to be looked up.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     pointer to the already contained object if the object
+ *                     is found.  You can assign to **found to override.
+ *                     This address is valid until the table is modified.
+ * \return Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_flat_lookup (sc_hash_flat_t * hash, void *v,
+                                         void ***found);
+
+/** Insert an object into a flat hash table if it is not contained already.
+ * \param [in]  v      The object to be inserted.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     pointer to the already contained, or if not present,
+ *                     the new object.  You can assign to **found to override.
+ *                     This address is valid until the table is modified.
+ * \return Returns true if object is added, false if it is already contained.
+ */
+int                 sc_hash_flat_insert_unique (sc_hash_flat_t * hash,
+                                                void *v, void ***found);
+
+/** Remove an object from a flat hash table.
+ * \param [in]  v      The object to be removed.
+ * \param [out] found  If found != NULL, *found is set to the object
+                       that is removed if that exists.
+ * \return Returns true if object is found, false if is not contained.
+ */
+int                 sc_hash_flat_remove (sc_hash_flat_t * hash, void *v,
+                                         void **found);
+
+/** Invoke a callback for every member of the flat hash table.
+ * The functions hash_fn and equal_fn are not called by this function.
+ * The callback must not insert into or remove from the table.
+ */
+void                sc_hash_flat_foreach (sc_hash_flat_t * hash,
+                                          sc_hash_foreach_t fn);
+
+/** Compute and print statistical information about the probe lengths.
+ */
+void                sc_hash_flat_print_statistics (int package_id,
+                                                   int log_priority,
+                                                   sc_hash_flat_t * hash);
+
 typedef struct sc_hash_array_data
 {
   sc_array_t         *pa;
@@ -1026,13 +2326,18 @@ sc_hash_array_data_t;
 
 /** The sc_hash_array implements an array backed up by a hash table.
  * This enables O(1) access for array elements.
+ * The hash table is either a chained \ref sc_hash_t or, if created by
+ * \ref sc_hash_array_new_flat, an open addressing \ref sc_hash_flat_t.
  */
 typedef struct sc_hash_array
 {
   /* implementation variables */
   sc_array_t          a;
   sc_hash_array_data_t internal_data;
-  sc_hash_t          *h;
+  sc_hash_t          *h;        /**< NULL if hf is used */
+  sc_hash_flat_t     *hf;       /**< NULL if h is used */
+  size_t              num_hashed;       /**< leading elements in the table,
+                                           the others are added on use */
 }
 sc_hash_array_t;
 
@@ -1052,6 +2357,18 @@ sc_hash_array_t    *sc_hash_array_new (size_t elem_size,
                                        sc_equal_function_t equal_fn,
                                        void *user_data);
 
+/** Create a new hash array backed by an open addressing hash table.
+ * The interface is identical to the one created by \ref sc_hash_array_new.
+ * This variant uses less memory and fewer pointer indirections per lookup.
+ * \param [in] elem_size   Size of one array element in bytes.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ */
+sc_hash_array_t    *sc_hash_array_new_flat (size_t elem_size,
+                                            sc_hash_function_t hash_fn,
+                                            sc_equal_function_t equal_fn,
+                                            void *user_data);
+
 /** Destroy a hash array.
  */
 void                sc_hash_array_destroy (sc_hash_array_t * hash_array);
@@ -1090,6 +2407,45 @@ int                 sc_hash_array_lookup (sc_hash_array_t * hash_array,
 void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
                                                  void *v, size_t *position);
 
+/** Check for a batch of objects whether they are contained in a hash array.
+ * The keys are hashed in small groups and their hash slots are prefetched
+ * before they are resolved, which hides memory latency on large tables.
+ * The result is identical to calling \ref sc_hash_array_lookup in a loop.
+ *
+ * \param [in] keys        Array of objects with the element size of the
+ *                         hash array.  It is only used for searching.
+ * \param [in,out] positions    Initialized array of element size
+ *                         sizeof (ssize_t), resized to the count of \b keys.
+ *                         On output, entry i is the array position of the
+ *                         object equal to key i, or -1 if it is not found.
+ * \return                 Returns the number of keys found.
+ */
+size_t              sc_hash_array_lookup_batch (sc_hash_array_t * hash_array,
+                                                sc_array_t * keys,
+                                                sc_array_t * positions);
+
+/** Insert a batch of objects into a hash array if not contained already.
+ * Contrary to \ref sc_hash_array_insert_unique, new objects are copied from
+ * \b keys into the array, in the order in which they appear in \b keys.
+ * Duplicates within \b keys are recognized and added only once.
+ * The keys are hashed in small groups and their hash slots are prefetched
+ * before they are resolved, which hides memory latency on large tables.
+ *
+ * \param [in] keys        Array of objects with the element size of the
+ *                         hash array.  New objects are copied from here.
+ * \param [in,out] positions    If not NULL, initialized array of element
+ *                         size sizeof (ssize_t) like in
+ *                         \ref sc_hash_array_lookup_batch, resized to the
+ *                         count of \b keys.  On output, entry i is the array
+ *                         position of the object equal to key i, new or old.
+ * \return                 Returns the number of objects added.
+ */
+size_t              sc_hash_array_insert_unique_batch (sc_hash_array_t *
+                                                       hash_array,
+                                                       sc_array_t * keys,
+                                                       sc_array_t *
+                                                       positions);
+
 /** Extract the array data from a hash array and destroy everything else.
  * \param [in] hash_array   The hash array is destroyed after extraction.
  * \param [in] rip          Array structure that will be overwritten.
@@ -1099,10 +2455,107 @@ void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
 void                sc_hash_array_rip (sc_hash_array_t * hash_array,
                                        sc_array_t * rip);
 
+/** The sc_hash_concurrent object may be accessed from many threads at once.
+ * The objects are distributed by their hash value onto a number of shards.
+ * Each shard is an ordinary \ref sc_hash_t protected by its own lock,
+ * thus threads only contend when they access the same shard.
+ * Without --enable-pthread, OpenMP locks are used if configured, and
+ * without both, the object is a plain sharded hash table for serial use.
+ * The hash and equal functions must be thread-safe.
+ */
+typedef struct sc_hash_concurrent sc_hash_concurrent_t;
+
+/** Create a new concurrent hash table.
+ * \param [in] num_shards   Number of independently locked shards, > 0.
+ *                          Should be a few times the number of threads.
+ * \param [in] hash_fn      Function to compute the hash value.
+ * \param [in] equal_fn     Function to test two objects for equality.
+ * \param [in] user_data    User data passed to the hash and equal functions.
+ * \return                  A valid and empty concurrent hash table.
+ */
+sc_hash_concurrent_t *sc_hash_concurrent_new (int num_shards,
+                                              sc_hash_function_t hash_fn,
+                                              sc_equal_function_t equal_fn,
+                                              void *user_data);
+
+/** Destroy a concurrent hash table.  Must not be called concurrently.
+ * \param [in,out] hash     The table is invalid after this call.
+ */
+void                sc_hash_concurrent_destroy (sc_hash_concurrent_t * hash);
+
+/** Return the number of objects in a concurrent hash table.
+ * The result is only exact if no other thread modifies the table.
+ */
+size_t              sc_hash_concurrent_count (sc_hash_concurrent_t * hash);
+
+/** Calculate the memory used by a concurrent hash table.
+ * Must not be called concurrently with modifying operations.
+ */
+size_t              sc_hash_concurrent_memory_used (sc_hash_concurrent_t *
+                                                    hash);
+
+/** Check if an object is contained in a concurrent hash table.
+ * Unlike \ref sc_hash_lookup, the object itself is returned, since the
+ * address of its storage may change as soon as the shard is unlocked.
+ * \param [in] v        The object to be looked up.
+ * \param [out] found   If found != NULL, *found is set to the object
+ *                      if the object is found.
+ * \return              Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_concurrent_lookup (sc_hash_concurrent_t * hash,
+                                               void *v, void **found);
+
+/** Insert an object into a concurrent hash table if it is not contained.
+ * If two threads insert equal objects at the same time, exactly one of
+ * them succeeds and the other one receives the winning object.
+ * \param [in] v        The object to be inserted.
+ * \param [out] found   If found != NULL, *found is set to the object
+ *                      that is contained in the table after the call,
+ *                      which is either \b v or the previously inserted one.
+ * \return              Returns true if object is added, false if it is
+ *                      already contained.
+ */
+int                 sc_hash_concurrent_insert_unique (sc_hash_concurrent_t *
+                                                      hash, void *v,
+                                                      void **found);
+
+/** Remove an object from a concurrent hash table.
+ * \param [in] v        The object to be removed.
+ * \param [out] found   If found != NULL, *found is set to the object
+ *                      that is removed if that exists.
+ * \return              Returns true if object is found, false if is not.
+ */
+int                 sc_hash_concurrent_remove (sc_hash_concurrent_t * hash,
+                                               void *v, void **found);
+
+/** Invoke a callback for every member of a concurrent hash table.
+ * This function is designed to be called by all threads of a team at the
+ * same time, each thread processing and locking a disjoint set of shards.
+ * For serial use, call it with thread_id 0 and num_threads 1.
+ * The callback must not access the table.
+ * \param [in] thread_id    Number of the calling thread in [0, num_threads).
+ * \param [in] num_threads  Number of threads in the team, > 0.
+ * \param [in] fn           Callback as in \ref sc_hash_foreach.  Returning
+ *                          false ends the iteration of this thread only.
+ */
+void                sc_hash_concurrent_foreach (sc_hash_concurrent_t * hash,
+                                                int thread_id,
+                                                int num_threads,
+                                                sc_hash_foreach_t fn);
+
+/** Compute and print statistical information about all shards. */
+void                sc_hash_concurrent_print_statistics (int package_id,
+                                                         int log_priority,
+                                                         sc_hash_concurrent_t
+                                                         * hash);
+
 /** The sc_recycle_array object provides an array of slots that can be reused.
  *
- * It keeps a list of free slots in the array which will be used for insertion
- * while available.  Otherwise, the array is grown.
+ * It keeps a bitmap of free slots in the array.  The lowest free slot is
+ * used for insertion while available.  Otherwise, the array is grown.
+ * The live entries can be moved to the front by 
+ef
+ * sc_recycle_array_compact.
  */
 typedef struct sc_recycle_array
 {
@@ -1111,7 +2564,8 @@ typedef struct sc_recycle_array
 
   /* implementation variables */
   sc_array_t          a;
-  sc_array_t          f;
+  sc_array_t          f;        /* uint64_t words, bit set for free slot */
+  size_t              f_word;   /* no free slot in the words before */
 }
 sc_recycle_array_t;
 
@@ -1149,6 +2603,36 @@ void               *sc_recycle_array_insert (sc_recycle_array_t * rec_array,
 void               *sc_recycle_array_remove (sc_recycle_array_t * rec_array,
                                              size_t position);
 
+/** Find the next valid object at or after a position.
+ * Free slots are skipped 64 at a time.  To visit all objects, loop with
+ * position = sc_recycle_array_next (rec_array, 0) while it is less than
+ * rec_array->a.elem_count and continue from position + 1.
+ *
+ * \param [in] position   Index into the array to start searching.
+ * 
+eturn                The first valid position not less than
+ *                         position, or rec_array->a.elem_count.
+ */
+size_t              sc_recycle_array_next (sc_recycle_array_t * rec_array,
+                                           size_t position);
+
+/** Move all valid objects to the front of the array, keeping their order.
+ * Afterwards there are no free slots and rec_array->a has elem_count
+ * entries.  Pointers and positions of objects obtained before are stale.
+ *
+ * \param [out] newindices  If not NULL, this array of size_t is resized
+ *                          to the previous number of slots and receives
+ *                          the new position of the object at each old
+ *                          position.  Free slots are assigned positions
+ *                          at or above elem_count.  The result is a
+ *                          permutation that can be passed to
+ *                          
+ef sc_array_permute for user data kept in
+ *                          parallel to the recycle array.
+ */
+void                sc_recycle_array_compact (sc_recycle_array_t * rec_array,
+                                              sc_array_t * newindices);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_CONTAINERS_H */
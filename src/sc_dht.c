@@ -0,0 +1,292 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dht.h>
+#include <sc_notify.h>
+
+struct sc_dht
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  size_t              key_size;
+  sc_hash_function_t  hash_fn;
+  void               *user_data;
+  sc_hash_array_t    *table;    /**< keys owned by this process */
+  sc_notify_t        *notify;
+  sc_notify_plan_t   *plan;     /**< caches the senders of requests */
+};
+
+sc_dht_t           *
+sc_dht_new (sc_MPI_Comm mpicomm, size_t key_size,
+            sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+            void *user_data)
+{
+  int                 mpiret;
+  sc_dht_t           *dht;
+
+  SC_ASSERT (key_size > 0);
+  SC_ASSERT (hash_fn != NULL && equal_fn != NULL);
+
+  dht = SC_ALLOC (sc_dht_t, 1);
+  dht->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &dht->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &dht->mpirank);
+  SC_CHECK_MPI (mpiret);
+  dht->key_size = key_size;
+  dht->hash_fn = hash_fn;
+  dht->user_data = user_data;
+  dht->table = sc_hash_array_new_flat (key_size, hash_fn, equal_fn,
+                                       user_data);
+  dht->notify = sc_notify_new (mpicomm);
+  dht->plan = sc_notify_plan_new (dht->notify);
+
+  return dht;
+}
+
+void
+sc_dht_destroy (sc_dht_t * dht)
+{
+  sc_notify_plan_destroy (dht->plan);
+  sc_notify_destroy (dht->notify);
+  sc_hash_array_destroy (dht->table);
+  SC_FREE (dht);
+}
+
+int
+sc_dht_owner (sc_dht_t * dht, const void *key)
+{
+  uint32_t            h;
+
+  /* scramble the hash, since the local table uses its low bits */
+  h = (uint32_t) dht->hash_fn (key, dht->user_data) * 2654435761u;
+  return (int) (((uint64_t) h * (uint64_t) dht->mpisize) >> 32);
+}
+
+/** Send the results of the requests back to the requesting processes.
+ * \param [in] senders      The ranks that sent requests to this process.
+ * \param [in] soffsets     Offsets of their requests in \a replies.
+ * \param [in] receivers    The ranks that this process sent requests to.
+ * \param [in] roffsets     Offsets of the requests in \a answers.
+ */
+static void
+sc_dht_reply (sc_dht_t * dht, sc_array_t * senders, const int *soffsets,
+              const sc_dht_loc_t * replies, sc_array_t * receivers,
+              const int *roffsets, sc_dht_loc_t * answers)
+{
+  const size_t        lsize = sizeof (sc_dht_loc_t);
+  int                 mpiret;
+  int                 i, peer, num_senders, num_receivers;
+  int                 self = -1;
+  sc_MPI_Request     *reqs;
+
+  num_senders = (int) senders->elem_count;
+  num_receivers = (int) receivers->elem_count;
+  reqs = SC_ALLOC (sc_MPI_Request, num_senders + num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    peer = *(int *) sc_array_index_int (receivers, i);
+    if (peer == dht->mpirank) {
+      reqs[i] = sc_MPI_REQUEST_NULL;
+      self = i;
+      continue;
+    }
+    mpiret = sc_mpi_irecv_large (answers + roffsets[i],
+                                 (roffsets[i + 1] - roffsets[i]) * lsize,
+                                 peer, SC_TAG_DHT, dht->mpicomm, reqs + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (i = 0; i < num_senders; ++i) {
+    peer = *(int *) sc_array_index_int (senders, i);
+    if (peer == dht->mpirank) {
+      SC_ASSERT (self >= 0);
+      SC_ASSERT (roffsets[self + 1] - roffsets[self] ==
+                 soffsets[i + 1] - soffsets[i]);
+      memcpy (answers + roffsets[self], replies + soffsets[i],
+              (soffsets[i + 1] - soffsets[i]) * lsize);
+      reqs[num_receivers + i] = sc_MPI_REQUEST_NULL;
+      continue;
+    }
+    mpiret = sc_mpi_isend_large (replies + soffsets[i],
+                                 (soffsets[i + 1] - soffsets[i]) * lsize,
+                                 peer, SC_TAG_DHT, dht->mpicomm,
+                                 reqs + num_receivers + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Waitall (num_senders + num_receivers, reqs,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (reqs);
+}
+
+/** Send the keys to their owners, resolve them and return the results. */
+static void
+sc_dht_exchange (sc_dht_t * dht, sc_array_t * keys, sc_array_t * locs,
+                 int insert)
+{
+  const size_t        n = keys->elem_count;
+  const int           P = dht->mpisize;
+  int                 q;
+  int                *owners, *counts, *ioff;
+  size_t              zz, m, old_count;
+  ssize_t             pos;
+  char               *first;
+  sc_array_t         *receivers, *senders;
+  sc_array_t         *payload, *requests, *in_offsets, *out_offsets;
+  sc_array_t         *positions;
+  sc_dht_loc_t       *replies, *answers;
+
+  SC_ASSERT (keys->elem_size == dht->key_size);
+  SC_ASSERT (locs == NULL || locs->elem_size == sizeof (sc_dht_loc_t));
+
+  /* group the keys by owner into one message per destination */
+  owners = SC_ALLOC (int, n);
+  counts = SC_ALLOC_ZERO (int, P + 1);
+  for (zz = 0; zz < n; ++zz) {
+    owners[zz] = q = sc_dht_owner (dht, sc_array_index (keys, zz));
+    ++counts[q + 1];
+  }
+  receivers = sc_array_new (sizeof (int));
+  in_offsets = sc_array_new (sizeof (int));
+  *(int *) sc_array_push (in_offsets) = 0;
+  for (q = 0; q < P; ++q) {
+    if (counts[q + 1] > 0) {
+      *(int *) sc_array_push (receivers) = q;
+      *(int *) sc_array_push (in_offsets) = counts[q] + counts[q + 1];
+    }
+    counts[q + 1] += counts[q];
+  }
+  payload = sc_array_new_count (dht->key_size, n);
+  for (zz = 0; zz < n; ++zz) {
+    /* the grouped position of key zz replaces its owner */
+    owners[zz] = counts[owners[zz]]++;
+    memcpy (sc_array_index_int (payload, owners[zz]),
+            sc_array_index (keys, zz), dht->key_size);
+  }
+  SC_FREE (counts);
+
+  /* the plan skips the notification if the pattern repeats */
+  senders = sc_array_new (sizeof (int));
+  requests = sc_array_new (dht->key_size);
+  out_offsets = sc_array_new (sizeof (int));
+  sc_notify_plan_payloadv (dht->plan, receivers, senders, payload,
+                           requests, in_offsets, out_offsets, 1);
+  sc_array_destroy (payload);
+
+  /* resolve the requests in the order of the senders */
+  m = requests->elem_count;
+  replies = SC_ALLOC (sc_dht_loc_t, m);
+  if (insert) {
+    old_count = dht->table->a.elem_count;
+    positions = sc_array_new (sizeof (size_t));
+    sc_hash_array_insert_unique_batch (dht->table, requests, positions);
+    first = SC_ALLOC_ZERO (char, dht->table->a.elem_count - old_count);
+    for (zz = 0; zz < m; ++zz) {
+      replies[zz].owner = dht->mpirank;
+      replies[zz].position =
+        (ssize_t) * (size_t *) sc_array_index (positions, zz);
+      replies[zz].added = 0;
+      if ((size_t) replies[zz].position >= old_count &&
+          !first[replies[zz].position - old_count]) {
+        first[replies[zz].position - old_count] = 1;
+        replies[zz].added = 1;
+      }
+    }
+    SC_FREE (first);
+  }
+  else {
+    positions = sc_array_new (sizeof (ssize_t));
+    sc_hash_array_lookup_batch (dht->table, requests, positions);
+    for (zz = 0; zz < m; ++zz) {
+      pos = *(ssize_t *) sc_array_index (positions, zz);
+      replies[zz].owner = dht->mpirank;
+      replies[zz].added = 0;
+      replies[zz].position = pos;
+    }
+  }
+  sc_array_destroy (positions);
+  sc_array_destroy (requests);
+
+  /* return the results and restore the order of the request */
+  answers = SC_ALLOC (sc_dht_loc_t, n);
+  ioff = (int *) in_offsets->array;
+  sc_dht_reply (dht, senders, (int *) out_offsets->array, replies,
+                receivers, ioff, answers);
+  if (locs != NULL) {
+    sc_array_resize (locs, n);
+    for (zz = 0; zz < n; ++zz) {
+      *(sc_dht_loc_t *) sc_array_index (locs, zz) = answers[owners[zz]];
+    }
+  }
+
+  SC_FREE (answers);
+  SC_FREE (replies);
+  SC_FREE (owners);
+  sc_array_destroy (out_offsets);
+  sc_array_destroy (in_offsets);
+  sc_array_destroy (senders);
+  sc_array_destroy (receivers);
+}
+
+void
+sc_dht_insert_unique (sc_dht_t * dht, sc_array_t * keys, sc_array_t * locs)
+{
+  sc_dht_exchange (dht, keys, locs, 1);
+}
+
+void
+sc_dht_lookup (sc_dht_t * dht, sc_array_t * keys, sc_array_t * locs)
+{
+  SC_ASSERT (locs != NULL);
+  sc_dht_exchange (dht, keys, locs, 0);
+}
+
+const sc_array_t   *
+sc_dht_local_keys (sc_dht_t * dht)
+{
+  return &dht->table->a;
+}
+
+void
+sc_dht_offsets (sc_dht_t * dht, size_t * offsets)
+{
+  int                 mpiret;
+  int                 q;
+  long long           lcount, *counts;
+
+  lcount = (long long) dht->table->a.elem_count;
+  counts = SC_ALLOC (long long, dht->mpisize);
+  mpiret = sc_MPI_Allgather (&lcount, 1, sc_MPI_LONG_LONG_INT,
+                             counts, 1, sc_MPI_LONG_LONG_INT, dht->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  offsets[0] = 0;
+  for (q = 0; q < dht->mpisize; ++q) {
+    offsets[q + 1] = offsets[q] + (size_t) counts[q];
+  }
+  SC_FREE (counts);
+}
+
+void
+sc_dht_get_counts (sc_dht_t * dht, long *hits, long *misses)
+{
+  sc_notify_plan_get_counts (dht->plan, hits, misses);
+}
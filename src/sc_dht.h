@@ -0,0 +1,143 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_dht.h
+ *
+ * A hash table of keys distributed over the processes of a communicator.
+ *
+ * Every key is stored on exactly one owner process determined by its hash
+ * value.  Insertion and lookup are collective and work on a batch of keys
+ * per process: the keys are grouped by owner into one message per
+ * destination, resolved in the owner's \ref sc_hash_array_t, and the
+ * results are returned in the order of the request.  The senders of the
+ * messages are found by a \ref sc_notify_plan_t that is kept in the table,
+ * such that repeated batches with the same communication pattern, as in
+ * the steps of a simulation, skip the notification.
+ *
+ * A typical use is the global deduplication of shared keys, such as the
+ * coordinates of mesh nodes: every process inserts the keys it knows, and
+ * the owner and position returned for a key yield a global number.
+ */
+
+#ifndef SC_DHT_H
+#define SC_DHT_H
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque distributed hash table. */
+typedef struct sc_dht sc_dht_t;
+
+/** The result of inserting or looking up one key. */
+typedef struct sc_dht_loc
+{
+  int                 owner;    /**< Rank that stores the key. */
+  int                 added;    /**< True if this request added the key. */
+  ssize_t             position; /**< Position of the key in the owner's
+                                     table, or -1 if it is not found. */
+}
+sc_dht_loc_t;
+
+/** Create an empty distributed hash table.  This function is collective.
+ * \param [in] mpicomm      Communicator of the owners of the keys.
+ * \param [in] key_size     Size of a key in bytes, identical on all ranks.
+ * \param [in] hash_fn      Hash function of a key.  It must give the same
+ *                          value for equal keys on all processes.
+ * \param [in] equal_fn     Function to test two keys for equality.
+ * \param [in] user_data    Passed to \a hash_fn and \a equal_fn.
+ * \return                  Table to destroy with \ref sc_dht_destroy.
+ */
+sc_dht_t           *sc_dht_new (sc_MPI_Comm mpicomm, size_t key_size,
+                                sc_hash_function_t hash_fn,
+                                sc_equal_function_t equal_fn,
+                                void *user_data);
+
+/** Destroy a distributed hash table.
+ * \param [in,out] dht      The table is invalid after this call.
+ */
+void                sc_dht_destroy (sc_dht_t * dht);
+
+/** Return the rank that owns a key.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [in] key          The key of the size of the table's keys.
+ * \return                  The owner rank of the key.
+ */
+int                 sc_dht_owner (sc_dht_t * dht, const void *key);
+
+/** Insert a batch of keys unless they are contained already.
+ * This function is collective and each process may pass any number of
+ * keys, including duplicates and none.  Concurrent insertions of the same
+ * key are resolved in the order of the requesting ranks, then of the
+ * position of the key in the request.
+ * \param [in,out] dht      Valid distributed hash table.
+ * \param [in] keys         Array of keys of the table's key size.
+ * \param [in,out] locs     If not NULL, array of element size
+ *                          sizeof (\ref sc_dht_loc_t), resized to the count
+ *                          of \a keys.  Entry i is the location of key i.
+ *                          Its field added is true for the first request
+ *                          of a key not contained before.
+ */
+void                sc_dht_insert_unique (sc_dht_t * dht, sc_array_t * keys,
+                                          sc_array_t * locs);
+
+/** Look up a batch of keys.  This function is collective.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [in] keys         Array of keys of the table's key size.
+ * \param [in,out] locs     Array of element size sizeof (\ref sc_dht_loc_t),
+ *                          resized to the count of \a keys.  Entry i is the
+ *                          location of key i, with a position of -1 if the
+ *                          key is not contained.  The field added is false.
+ */
+void                sc_dht_lookup (sc_dht_t * dht, sc_array_t * keys,
+                                   sc_array_t * locs);
+
+/** Return the keys owned by this process.
+ * \param [in] dht          Valid distributed hash table.
+ * \return                  Array of the local keys in the order of their
+ *                          insertion, such that the position of a key
+ *                          is its index.  It must not be modified and
+ *                          is valid until the next insertion.
+ */
+const sc_array_t   *sc_dht_local_keys (sc_dht_t * dht);
+
+/** Compute the offsets of the keys of all owners in a global numbering.
+ * The global number of a key is offsets[owner] + position.
+ * This function is collective.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [out] offsets     Array of mpisize + 1 entries.  The last one is
+ *                          the global number of keys.
+ */
+void                sc_dht_offsets (sc_dht_t * dht, size_t * offsets);
+
+/** Return the number of batches that reused the exchange pattern.
+ * \param [in] dht          Valid distributed hash table.
+ * \param [out] hits        If not NULL, batches that skipped notification.
+ * \param [out] misses      If not NULL, batches that ran the notification.
+ */
+void                sc_dht_get_counts (sc_dht_t * dht,
+                                       long *hits, long *misses);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_DHT_H */
@@ -23,12 +23,31 @@
 
 #include <sc_dmatrix.h>
 #include <sc_lapack.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 int
 sc_darray_is_valid (const double *darray, size_t nelem)
 {
   size_t              zz;
 
+#ifdef SC_ENABLE_OPENMP
+  if (nelem >= SC_DMATRIX_OPENMP_MIN) {
+    long                il, bad = 0;
+
+    /* the static schedule matches the threaded element-wise updates */
+#pragma omp parallel for schedule (static) reduction (+:bad)
+    for (il = 0; il < (long) nelem; ++il) {
+      bad += darray[il] != darray[il];  /* ignore the comparison warning */
+    }
+    return bad == 0;
+  }
+#endif
+
   for (zz = 0; zz < nelem; ++zz) {
     if (darray[zz] != darray[zz]) {     /* ignore the comparison warning */
       return 0;
@@ -44,6 +63,18 @@ sc_darray_is_range (const double *darray, size_t nelem,
 {
   size_t              zz;
 
+#ifdef SC_ENABLE_OPENMP
+  if (nelem >= SC_DMATRIX_OPENMP_MIN) {
+    long                il, bad = 0;
+
+#pragma omp parallel for schedule (static) reduction (+:bad)
+    for (il = 0; il < (long) nelem; ++il) {
+      bad += !(low <= darray[il] && darray[il] <= high);
+    }
+    return bad == 0;
+  }
+#endif
+
   for (zz = 0; zz < nelem; ++zz) {
     if (!(low <= darray[zz] && darray[zz] <= high)) {
       return 0;
@@ -59,7 +90,10 @@ sc_dmatrix_memory_used (sc_dmatrix_t * dm)
   size_t              mem = sizeof (sc_dmatrix_t);
 
   mem += (dm->m + 1) * sizeof (double *);
-  if (!dm->view) {
+  if (dm->storage != NULL) {
+    mem += dm->m * dm->ld * sizeof (double) + SC_DMATRIX_ALIGN;
+  }
+  else if (!dm->view) {
     mem += dm->m * dm->n * sizeof (double);
   }
 
@@ -67,11 +101,13 @@ sc_dmatrix_memory_used (sc_dmatrix_t * dm)
 }
 
 static void
-sc_dmatrix_new_e (sc_dmatrix_t * rdm, sc_bint_t m, sc_bint_t n, double *data)
+sc_dmatrix_new_e (sc_dmatrix_t * rdm, sc_bint_t m, sc_bint_t n,
+                  sc_bint_t ld, double *data)
 {
   sc_bint_t           i;
 
   SC_ASSERT (m >= 0 && n >= 0);
+  SC_ASSERT (ld >= n);
   SC_ASSERT (rdm != NULL);
 
   rdm->e = SC_ALLOC (double *, m + 1);
@@ -79,13 +115,40 @@ sc_dmatrix_new_e (sc_dmatrix_t * rdm, sc_bint_t m, sc_bint_t n, double *data)
 
   if (m > 0) {
     for (i = 1; i < m; ++i)
-      rdm->e[i] = rdm->e[i - 1] + n;
+      rdm->e[i] = rdm->e[i - 1] + ld;
 
     rdm->e[m] = NULL;           /* safeguard */
   }
 
   rdm->m = m;
   rdm->n = n;
+  rdm->ld = ld;
+}
+
+/** Query whether the rows of a matrix follow each other without gaps. */
+#define SC_DMATRIX_CONTIGUOUS(X) ((X)->m <= 1 || (X)->ld == (X)->n)
+
+/** Split the entries of up to three equally sized matrices into runs.
+ * If all matrices are stored contiguously, there is one run over all
+ * entries.  Otherwise, every row is a run of its own.
+ * \param [in] X        Valid matrix.
+ * \param [in] Y        Valid matrix of the same size as X, or NULL.
+ * \param [in] Z        Valid matrix of the same size as X, or NULL.
+ * \param [out] len     Number of entries in each run.
+ * \return              Number of runs.  Run r starts at row e[r].
+ */
+static              sc_bint_t
+sc_dmatrix_runs (const sc_dmatrix_t * X, const sc_dmatrix_t * Y,
+                 const sc_dmatrix_t * Z, sc_bint_t * len)
+{
+  if (SC_DMATRIX_CONTIGUOUS (X) &&
+      (Y == NULL || SC_DMATRIX_CONTIGUOUS (Y)) &&
+      (Z == NULL || SC_DMATRIX_CONTIGUOUS (Z))) {
+    *len = X->m * X->n;
+    return X->m > 0 ? 1 : 0;
+  }
+  *len = X->n;
+  return X->m;
 }
 
 static sc_dmatrix_t *
@@ -117,8 +180,52 @@ sc_dmatrix_new_internal (sc_bint_t m, sc_bint_t n, int init_zero)
 #endif
   }
 
-  sc_dmatrix_new_e (rdm, m, n, data);
+  sc_dmatrix_new_e (rdm, m, n, n, data);
+  rdm->view = 0;
+  rdm->storage = NULL;
+
+  return rdm;
+}
+
+static sc_dmatrix_t *
+sc_dmatrix_new_aligned_internal (sc_bint_t m, sc_bint_t n, int init_zero)
+{
+  sc_dmatrix_t       *rdm, full;
+  char               *storage;
+  double             *data;
+  const sc_bint_t     pad = SC_DMATRIX_ALIGN / (sc_bint_t) sizeof (double);
+  const sc_bint_t     ld = SC_ALIGN_UP (SC_MAX (n, 1), pad);
+  size_t              zz;
+#ifdef SC_ENABLE_DEBUG
+  double              zero = 0.0;       /* no const to avoid warning */
+  const double        anan = 0.0 / zero;
+#endif
+
+  SC_ASSERT (m >= 0 && n >= 0);
+
+  /* over-allocate to place the first row on an aligned address */
+  rdm = SC_ALLOC (sc_dmatrix_t, 1);
+  storage = SC_ALLOC (char, (size_t) (m * ld) * sizeof (double) +
+                      SC_DMATRIX_ALIGN);
+  zz = (size_t) ((uintptr_t) storage % SC_DMATRIX_ALIGN);
+  data = (double *) (storage + (zz > 0 ? SC_DMATRIX_ALIGN - zz : 0));
+
+  sc_dmatrix_new_e (rdm, m, n, ld, data);
   rdm->view = 0;
+  rdm->storage = storage;
+
+  /* the padding is kept zero and only the entries may be undefined;
+     the rows are first touched by the threads that update them later */
+  full = *rdm;
+  full.n = ld;
+  sc_dmatrix_set_zero (&full);
+
+#ifdef SC_ENABLE_DEBUG
+  if (!init_zero) {
+    /* In debug mode initialize the memory to NaN. */
+    sc_dmatrix_set_value (rdm, anan);
+  }
+#endif
 
   return rdm;
 }
@@ -135,6 +242,18 @@ sc_dmatrix_new_zero (sc_bint_t m, sc_bint_t n)
   return sc_dmatrix_new_internal (m, n, 1);
 }
 
+sc_dmatrix_t       *
+sc_dmatrix_new_aligned (sc_bint_t m, sc_bint_t n)
+{
+  return sc_dmatrix_new_aligned_internal (m, n, 0);
+}
+
+sc_dmatrix_t       *
+sc_dmatrix_new_aligned_zero (sc_bint_t m, sc_bint_t n)
+{
+  return sc_dmatrix_new_aligned_internal (m, n, 1);
+}
+
 sc_dmatrix_t       *
 sc_dmatrix_new_data (sc_bint_t m, sc_bint_t n, double *data)
 {
@@ -143,8 +262,9 @@ sc_dmatrix_new_data (sc_bint_t m, sc_bint_t n, double *data)
   SC_ASSERT (m >= 0 && n >= 0);
 
   rdm = SC_ALLOC (sc_dmatrix_t, 1);
-  sc_dmatrix_new_e (rdm, m, n, data);
+  sc_dmatrix_new_e (rdm, m, n, n, data);
   rdm->view = 1;
+  rdm->storage = NULL;
 
   return rdm;
 }
@@ -165,8 +285,16 @@ sc_dmatrix_new_view_offset (sc_bint_t o, sc_bint_t m, sc_bint_t n,
   SC_ASSERT ((o + m) * n <= orig->m * orig->n);
 
   rdm = SC_ALLOC (sc_dmatrix_t, 1);
-  sc_dmatrix_new_e (rdm, m, n, orig->e[0] + o * n);
+  if (SC_DMATRIX_CONTIGUOUS (orig)) {
+    sc_dmatrix_new_e (rdm, m, n, n, orig->e[0] + o * n);
+  }
+  else {
+    /* a padded matrix can only be viewed by a block of whole rows */
+    SC_ASSERT (n == orig->n);
+    sc_dmatrix_new_e (rdm, m, n, orig->ld, orig->e[0] + o * orig->ld);
+  }
   rdm->view = 1;
+  rdm->storage = NULL;
 
   return rdm;
 }
@@ -180,9 +308,9 @@ sc_dmatrix_new_view_column (sc_dmatrix_t * orig, sc_bint_t j)
   SC_ASSERT (0 <= j && j < orig->n);
 
   rdm = SC_ALLOC (sc_dmatrix_t, 1);
-  sc_dmatrix_new_e (rdm, orig->m, orig->n, orig->e[0] + j);
-  rdm->n = 1;
+  sc_dmatrix_new_e (rdm, orig->m, 1, orig->ld, orig->e[0] + j);
   rdm->view = 1;
+  rdm->storage = NULL;
 
   return rdm;
 }
@@ -203,12 +331,13 @@ sc_dmatrix_view_set_column (sc_dmatrix_t * view,
 
   if (m > 0) {
     for (i = 1; i < m; ++i)
-      view->e[i] = view->e[i - 1] + orig->n;
+      view->e[i] = view->e[i - 1] + orig->ld;
 
     view->e[m] = NULL;          /* safeguard */
   }
 
   view->n = 1;
+  view->ld = orig->ld;
 }
 
 void
@@ -221,21 +350,16 @@ sc_dmatrix_view_set_row (sc_dmatrix_t * view,
   SC_ASSERT (0 <= i && i < orig->m);
 
   view->e[0] = orig->e[i];
-  view->n = orig->n;
+  view->n = view->ld = orig->n;
 }
 
 sc_dmatrix_t       *
 sc_dmatrix_clone (const sc_dmatrix_t * X)
 {
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Xdata = X->e[0];
-  double             *Ydata;
   sc_dmatrix_t       *clone;
 
   clone = sc_dmatrix_new (X->m, X->n);
-  Ydata = clone->e[0];
-
-  memcpy (Ydata, Xdata, totalsize * sizeof (double));
+  sc_dmatrix_copy (X, clone);
 
   return clone;
 }
@@ -247,10 +371,11 @@ sc_dmatrix_reshape (sc_dmatrix_t * dmatrix, sc_bint_t m, sc_bint_t n)
 
   SC_ASSERT (dmatrix->e != NULL);
   SC_ASSERT (dmatrix->m * dmatrix->n == m * n);
+  SC_ASSERT (SC_DMATRIX_CONTIGUOUS (dmatrix));
 
   data = dmatrix->e[0];
   SC_FREE (dmatrix->e);
-  sc_dmatrix_new_e (dmatrix, m, n, data);
+  sc_dmatrix_new_e (dmatrix, m, n, n, data);
 }
 
 void
@@ -261,6 +386,7 @@ sc_dmatrix_resize (sc_dmatrix_t * dmatrix, sc_bint_t m, sc_bint_t n)
 
   SC_ASSERT (dmatrix->e != NULL);
   SC_ASSERT (m >= 0 && n >= 0);
+  SC_ASSERT (dmatrix->storage == NULL);
 
   size = dmatrix->m * dmatrix->n;
   newsize = m * n;
@@ -280,7 +406,7 @@ sc_dmatrix_resize (sc_dmatrix_t * dmatrix, sc_bint_t m, sc_bint_t n)
     data = dmatrix->e[0];
   }
   SC_FREE (dmatrix->e);
-  sc_dmatrix_new_e (dmatrix, m, n, data);
+  sc_dmatrix_new_e (dmatrix, m, n, n, data);
 }
 
 void
@@ -295,6 +421,7 @@ sc_dmatrix_resize_in_place (sc_dmatrix_t * dmatrix, sc_bint_t m, sc_bint_t n)
   SC_ASSERT (dmatrix->e != NULL);
   SC_ASSERT (m >= 0 && n >= 0);
   SC_ASSERT (!dmatrix->view);
+  SC_ASSERT (dmatrix->storage == NULL);
 
   size = dmatrix->m * dmatrix->n;
   newsize = m * n;
@@ -320,13 +447,16 @@ sc_dmatrix_resize_in_place (sc_dmatrix_t * dmatrix, sc_bint_t m, sc_bint_t n)
     }
   }
   SC_FREE (dmatrix->e);
-  sc_dmatrix_new_e (dmatrix, m, n, data);
+  sc_dmatrix_new_e (dmatrix, m, n, n, data);
 }
 
 void
 sc_dmatrix_destroy (sc_dmatrix_t * dmatrix)
 {
-  if (!dmatrix->view) {
+  if (dmatrix->storage != NULL) {
+    SC_FREE (dmatrix->storage);
+  }
+  else if (!dmatrix->view) {
     SC_FREE (dmatrix->e[0]);
   }
   SC_FREE (dmatrix->e);
@@ -337,7 +467,27 @@ sc_dmatrix_destroy (sc_dmatrix_t * dmatrix)
 int
 sc_dmatrix_is_valid (const sc_dmatrix_t * A)
 {
-  return sc_darray_is_valid (A->e[0], (size_t) A->m * (size_t) A->n);
+  sc_bint_t           r, len;
+  const sc_bint_t     runs = sc_dmatrix_runs (A, NULL, NULL, &len);
+
+#ifdef SC_ENABLE_OPENMP
+  if (runs > 1 && (long) runs * len >= SC_DMATRIX_OPENMP_MIN) {
+    long                bad = 0;
+
+    /* padded rows are checked by the threads that update them */
+#pragma omp parallel for schedule (static) reduction (+:bad)
+    for (r = 0; r < runs; ++r) {
+      bad += !sc_darray_is_valid (A->e[r], (size_t) len);
+    }
+    return bad == 0;
+  }
+#endif
+  for (r = 0; r < runs; ++r) {
+    if (!sc_darray_is_valid (A->e[r], (size_t) len)) {
+      return 0;
+    }
+  }
+  return 1;
 }
 
 int
@@ -362,6 +512,439 @@ sc_dmatrix_is_symmetric (const sc_dmatrix_t * A, double tolerance)
   return 1;
 }
 
+#if defined __GNUC__ || defined __clang__
+
+/** Number of doubles processed at once by the explicit vector paths. */
+#define SC_DMATRIX_VECTOR 4
+
+/** A vector of doubles that may be accessed at any address aligned to a
+ * double.  On padded rows, all vectors fall on their natural alignment.
+ */
+typedef double      sc_dmatrix_vec_t
+  __attribute__ ((vector_size (SC_DMATRIX_VECTOR * sizeof (double)),
+                  aligned (sizeof (double)), may_alias));
+
+#endif
+
+static void
+sc_dmatrix_run_scale (sc_bint_t len, double alpha, double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = alpha * *y;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] *= alpha;
+  }
+}
+
+static void
+sc_dmatrix_run_shift (sc_bint_t len, double alpha, double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = *y + alpha;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] += alpha;
+  }
+}
+
+static void
+sc_dmatrix_run_scale_shift (sc_bint_t len, double alpha, double beta,
+                            double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = alpha * *y + beta;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] = alpha * Y[i] + beta;
+  }
+}
+
+static void
+sc_dmatrix_run_dotmultiply (sc_bint_t len, const double *X, double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    const sc_dmatrix_vec_t *x = (const sc_dmatrix_vec_t *) (X + i);
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = *y * *x;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] *= X[i];
+  }
+}
+
+static void
+sc_dmatrix_run_dotdivide (sc_bint_t len, const double *X, double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    const sc_dmatrix_vec_t *x = (const sc_dmatrix_vec_t *) (X + i);
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = *y / *x;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] /= X[i];
+  }
+}
+
+static void
+sc_dmatrix_run_dotmultiply_add (sc_bint_t len, const double *A,
+                                const double *X, double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    const sc_dmatrix_vec_t *a = (const sc_dmatrix_vec_t *) (A + i);
+    const sc_dmatrix_vec_t *x = (const sc_dmatrix_vec_t *) (X + i);
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = *y + *a * *x;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] += A[i] * X[i];
+  }
+}
+
+static void
+sc_dmatrix_run_axpy (sc_bint_t len, double alpha, const double *X,
+                     double *Y)
+{
+  sc_bint_t           i = 0;
+
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    const sc_dmatrix_vec_t *x = (const sc_dmatrix_vec_t *) (X + i);
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = *y + alpha * *x;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] += alpha * X[i];
+  }
+}
+
+/** Compute Y := alpha X + beta Y + gamma, not reading Y if beta is zero. */
+static void
+sc_dmatrix_run_axpby (sc_bint_t len, double alpha, const double *X,
+                      double beta, double gamma, double *Y)
+{
+  sc_bint_t           i = 0;
+
+  if (beta == 0.) {
+    for (i = 0; i < len; ++i) {
+      Y[i] = alpha * X[i] + gamma;
+    }
+    return;
+  }
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    const sc_dmatrix_vec_t *x = (const sc_dmatrix_vec_t *) (X + i);
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = alpha * *x + beta * *y + gamma;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] = alpha * X[i] + beta * Y[i] + gamma;
+  }
+}
+
+/** Compute Y := alpha A .* X + beta Y + gamma like \ref sc_dmatrix_run_axpby.
+ */
+static void
+sc_dmatrix_run_dotmultiply_axpby (sc_bint_t len, double alpha,
+                                  const double *A, const double *X,
+                                  double beta, double gamma, double *Y)
+{
+  sc_bint_t           i = 0;
+
+  if (beta == 0.) {
+    for (i = 0; i < len; ++i) {
+      Y[i] = alpha * A[i] * X[i] + gamma;
+    }
+    return;
+  }
+#ifdef SC_DMATRIX_VECTOR
+  for (; i + SC_DMATRIX_VECTOR <= len; i += SC_DMATRIX_VECTOR) {
+    const sc_dmatrix_vec_t *a = (const sc_dmatrix_vec_t *) (A + i);
+    const sc_dmatrix_vec_t *x = (const sc_dmatrix_vec_t *) (X + i);
+    sc_dmatrix_vec_t   *y = (sc_dmatrix_vec_t *) (Y + i);
+    *y = alpha * *a * *x + beta * *y + gamma;
+  }
+#endif
+  for (; i < len; ++i) {
+    Y[i] = alpha * A[i] * X[i] + beta * Y[i] + gamma;
+  }
+}
+
+/** Compute Y := min (max (X, low), high) ^ exponent, using sqrt for .5. */
+static void
+sc_dmatrix_run_clamp_pow (sc_bint_t len, const double *X, double low,
+                          double high, double exponent, double *Y)
+{
+  sc_bint_t           i;
+  double              v;
+
+  for (i = 0; i < len; ++i) {
+    v = X[i] < low ? low : X[i];
+    Y[i] = v > high ? high : v;
+  }
+  if (exponent == .5) {
+    for (i = 0; i < len; ++i) {
+      Y[i] = sqrt (Y[i]);
+    }
+  }
+  else if (exponent != 1.) {
+    for (i = 0; i < len; ++i) {
+      Y[i] = pow (Y[i], exponent);
+    }
+  }
+}
+
+/** The element-wise updates executed by \ref sc_dmatrix_op_run.
+ * Maps of a single matrix read X and write Y, which may be identical. */
+typedef enum sc_dmatrix_op
+{
+  SC_DMATRIX_OP_SET_VALUE,      /**< Y := a */
+  SC_DMATRIX_OP_SCALE,          /**< Y := a Y */
+  SC_DMATRIX_OP_SHIFT,          /**< Y := Y + a */
+  SC_DMATRIX_OP_SCALE_SHIFT,    /**< Y := a Y + b */
+  SC_DMATRIX_OP_ALPHADIVIDE,    /**< Y := a ./ X */
+  SC_DMATRIX_OP_POW,            /**< Y := X ^ a */
+  SC_DMATRIX_OP_FABS,           /**< Y := fabs (X) */
+  SC_DMATRIX_OP_SQRT,           /**< Y := sqrt (X) */
+  SC_DMATRIX_OP_GETSIGN,        /**< Y := (X >= 0 ? 1 : -1) */
+  SC_DMATRIX_OP_GREATEREQUAL,   /**< Y := (X >= a ? 1 : 0) */
+  SC_DMATRIX_OP_LESSEQUAL,      /**< Y := (X <= a ? 1 : 0) */
+  SC_DMATRIX_OP_MAXIMUM,        /**< Y := max (X, Y) */
+  SC_DMATRIX_OP_MINIMUM,        /**< Y := min (X, Y) */
+  SC_DMATRIX_OP_DOTMULTIPLY,    /**< Y := Y .* X */
+  SC_DMATRIX_OP_DOTDIVIDE,      /**< Y := Y ./ X */
+  SC_DMATRIX_OP_DOTMULTIPLY_ADD,        /**< Y := A .* X + Y */
+  SC_DMATRIX_OP_AXPY,           /**< Y := a X + Y */
+  SC_DMATRIX_OP_AXPBY,          /**< Y := a X + b Y + c */
+  SC_DMATRIX_OP_DOTMULTIPLY_AXPBY,      /**< Y := a A .* X + b Y + c */
+  SC_DMATRIX_OP_CLAMP_POW       /**< Y := min (max (X, a), b) ^ c */
+}
+sc_dmatrix_op_t;
+
+/** Execute one element-wise update on a run of entries. */
+static void
+sc_dmatrix_op_run (sc_dmatrix_op_t op, double a, double b, double c,
+                   sc_bint_t len, const double *A, const double *X,
+                   double *Y)
+{
+  sc_bint_t           i;
+
+  switch (op) {
+  case SC_DMATRIX_OP_SET_VALUE:
+    for (i = 0; i < len; ++i)
+      Y[i] = a;
+    break;
+  case SC_DMATRIX_OP_SCALE:
+    sc_dmatrix_run_scale (len, a, Y);
+    break;
+  case SC_DMATRIX_OP_SHIFT:
+    sc_dmatrix_run_shift (len, a, Y);
+    break;
+  case SC_DMATRIX_OP_SCALE_SHIFT:
+    sc_dmatrix_run_scale_shift (len, a, b, Y);
+    break;
+  case SC_DMATRIX_OP_ALPHADIVIDE:
+    for (i = 0; i < len; ++i)
+      Y[i] = a / X[i];
+    break;
+  case SC_DMATRIX_OP_POW:
+    for (i = 0; i < len; ++i)
+      Y[i] = pow (X[i], a);
+    break;
+  case SC_DMATRIX_OP_FABS:
+    for (i = 0; i < len; ++i)
+      Y[i] = fabs (X[i]);
+    break;
+  case SC_DMATRIX_OP_SQRT:
+    for (i = 0; i < len; ++i)
+      Y[i] = sqrt (X[i]);
+    break;
+  case SC_DMATRIX_OP_GETSIGN:
+    for (i = 0; i < len; ++i)
+      Y[i] = (X[i] >= 0. ? 1 : -1);
+    break;
+  case SC_DMATRIX_OP_GREATEREQUAL:
+    for (i = 0; i < len; ++i)
+      Y[i] = (X[i] >= a ? 1 : 0);
+    break;
+  case SC_DMATRIX_OP_LESSEQUAL:
+    for (i = 0; i < len; ++i)
+      Y[i] = (X[i] <= a ? 1 : 0);
+    break;
+  case SC_DMATRIX_OP_MAXIMUM:
+    for (i = 0; i < len; ++i)
+      Y[i] = SC_MAX (X[i], Y[i]);
+    break;
+  case SC_DMATRIX_OP_MINIMUM:
+    for (i = 0; i < len; ++i)
+      Y[i] = SC_MIN (X[i], Y[i]);
+    break;
+  case SC_DMATRIX_OP_DOTMULTIPLY:
+    sc_dmatrix_run_dotmultiply (len, X, Y);
+    break;
+  case SC_DMATRIX_OP_DOTDIVIDE:
+    sc_dmatrix_run_dotdivide (len, X, Y);
+    break;
+  case SC_DMATRIX_OP_DOTMULTIPLY_ADD:
+    sc_dmatrix_run_dotmultiply_add (len, A, X, Y);
+    break;
+  case SC_DMATRIX_OP_AXPY:
+    sc_dmatrix_run_axpy (len, a, X, Y);
+    break;
+  case SC_DMATRIX_OP_AXPBY:
+    sc_dmatrix_run_axpby (len, a, X, b, c, Y);
+    break;
+  case SC_DMATRIX_OP_DOTMULTIPLY_AXPBY:
+    sc_dmatrix_run_dotmultiply_axpby (len, a, A, X, b, c, Y);
+    break;
+  case SC_DMATRIX_OP_CLAMP_POW:
+    sc_dmatrix_run_clamp_pow (len, X, a, b, c, Y);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+/** Number of entries processed by one fused update before the next.
+ * A block of each operand fits into the first level cache together. */
+#define SC_DMATRIX_BLOCK 512
+
+/* Large updates are split over threads block by block.  The static
+ * schedule assigns the same entries to the same thread in every update
+ * of equally shaped matrices, which keeps first-touch pages local. */
+#ifdef SC_ENABLE_OPENMP
+#define SC_DMATRIX_FOR _Pragma \
+  ("omp parallel for schedule (static) if (threaded)")
+#else
+#define SC_DMATRIX_FOR
+#endif
+
+/** Callback to update the entries [offset, offset + len) of run r. */
+typedef void        (*sc_dmatrix_block_t) (void *ctx, sc_bint_t r,
+                                           sc_bint_t offset, sc_bint_t len);
+
+/** Apply a callback to all blocks of equally long runs.
+ * \param [in] runs     Number of runs as from \ref sc_dmatrix_runs.
+ * \param [in] len      Number of entries in each run.
+ * \param [in] block    Called once for every block, possibly threaded.
+ * \param [in] ctx      Passed through to \b block.
+ */
+static void
+sc_dmatrix_blocks (sc_bint_t runs, sc_bint_t len,
+                   sc_dmatrix_block_t block, void *ctx)
+{
+  const long          nb = (len + SC_DMATRIX_BLOCK - 1) / SC_DMATRIX_BLOCK;
+  const long          total = (long) runs * nb;
+#ifdef SC_ENABLE_OPENMP
+  const int           threaded = (long) runs * len >= SC_DMATRIX_OPENMP_MIN;
+#endif
+  long                b;
+
+  SC_DMATRIX_FOR
+  for (b = 0; b < total; ++b) {
+    const sc_bint_t     offset = (sc_bint_t) (b % nb) * SC_DMATRIX_BLOCK;
+
+    block (ctx, (sc_bint_t) (b / nb), offset,
+           SC_MIN (SC_DMATRIX_BLOCK, len - offset));
+  }
+}
+
+#ifdef SC_ENABLE_OPENMP
+
+/** Operands of one update passed through \ref sc_dmatrix_blocks. */
+typedef struct sc_dmatrix_apply
+{
+  sc_dmatrix_op_t     op;
+  double              a, b, c;
+  const sc_dmatrix_t *A, *X;
+  sc_dmatrix_t       *Y;
+}
+sc_dmatrix_apply_t;
+
+static void
+sc_dmatrix_apply_block (void *ctx, sc_bint_t r, sc_bint_t offset,
+                        sc_bint_t len)
+{
+  const sc_dmatrix_apply_t *ap = (const sc_dmatrix_apply_t *) ctx;
+
+  sc_dmatrix_op_run (ap->op, ap->a, ap->b, ap->c, len,
+                     ap->A != NULL ? ap->A->e[r] + offset : NULL,
+                     ap->X != NULL ? ap->X->e[r] + offset : NULL,
+                     ap->Y->e[r] + offset);
+}
+
+#endif /* SC_ENABLE_OPENMP */
+
+/** Execute one element-wise update on equally shaped matrices.
+ * Matrices of at least \ref SC_DMATRIX_OPENMP_MIN entries are updated by
+ * multiple threads if OpenMP is enabled.
+ * \param [in] A        Second operand or NULL.
+ * \param [in] X        First operand or NULL.
+ * \param [in,out] Y    Result, which may be identical to \b X.
+ */
+static void
+sc_dmatrix_apply (sc_dmatrix_op_t op, double a, double b, double c,
+                  const sc_dmatrix_t * A, const sc_dmatrix_t * X,
+                  sc_dmatrix_t * Y)
+{
+  sc_bint_t           r, len;
+  const sc_bint_t     runs = sc_dmatrix_runs (Y, X, A, &len);
+
+  SC_ASSERT (X == NULL || (X->m == Y->m && X->n == Y->n));
+  SC_ASSERT (A == NULL || (A->m == Y->m && A->n == Y->n));
+
+#ifdef SC_ENABLE_OPENMP
+  if ((long) runs * len >= SC_DMATRIX_OPENMP_MIN) {
+    sc_dmatrix_apply_t  ap;
+
+    ap.op = op;
+    ap.a = a;
+    ap.b = b;
+    ap.c = c;
+    ap.A = A;
+    ap.X = X;
+    ap.Y = Y;
+    sc_dmatrix_blocks (runs, len, sc_dmatrix_apply_block, &ap);
+    return;
+  }
+#endif
+
+  /* small updates go without the indirection */
+  for (r = 0; r < runs; ++r) {
+    sc_dmatrix_op_run (op, a, b, c, len, A != NULL ? A->e[r] : NULL,
+                       X != NULL ? X->e[r] : NULL, Y->e[r]);
+  }
+}
+
 void
 sc_dmatrix_set_zero (sc_dmatrix_t * X)
 {
@@ -371,224 +954,113 @@ sc_dmatrix_set_zero (sc_dmatrix_t * X)
 void
 sc_dmatrix_set_value (sc_dmatrix_t * X, double value)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  double             *data = X->e[0];
-
-  for (i = 0; i < totalsize; ++i)
-    data[i] = value;
+  sc_dmatrix_apply (SC_DMATRIX_OP_SET_VALUE, value, 0., 0., NULL, NULL, X);
 }
 
 void
 sc_dmatrix_scale (double alpha, sc_dmatrix_t * X)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  double             *Xdata = X->e[0];
-
-  for (i = 0; i < totalsize; ++i)
-    Xdata[i] *= alpha;
+  sc_dmatrix_apply (SC_DMATRIX_OP_SCALE, alpha, 0., 0., NULL, NULL, X);
 }
 
 void
 sc_dmatrix_shift (double alpha, sc_dmatrix_t * X)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  double             *Xdata = X->e[0];
-
-  for (i = 0; i < totalsize; ++i)
-    Xdata[i] += alpha;
+  sc_dmatrix_apply (SC_DMATRIX_OP_SHIFT, alpha, 0., 0., NULL, NULL, X);
 }
 
 void
 sc_dmatrix_scale_shift (double alpha, double beta, sc_dmatrix_t * X)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  double             *Xdata = X->e[0];
-
-  for (i = 0; i < totalsize; ++i)
-    Xdata[i] = alpha * Xdata[i] + beta;
+  sc_dmatrix_apply (SC_DMATRIX_OP_SCALE_SHIFT, alpha, beta, 0.,
+                    NULL, NULL, X);
 }
 
 void
 sc_dmatrix_alphadivide (double alpha, sc_dmatrix_t * X)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  double             *Xdata = X->e[0];
-
-  for (i = 0; i < totalsize; ++i)
-    Xdata[i] = alpha / Xdata[i];
+  sc_dmatrix_apply (SC_DMATRIX_OP_ALPHADIVIDE, alpha, 0., 0., NULL, X, X);
 }
 
 void
 sc_dmatrix_pow (double alpha, sc_dmatrix_t * X)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  double             *Xdata = X->e[0];
-
-  for (i = 0; i < totalsize; ++i)
-    Xdata[i] = pow (Xdata[i], alpha);
+  sc_dmatrix_apply (SC_DMATRIX_OP_POW, alpha, 0., 0., NULL, X, X);
 }
 
 void
 sc_dmatrix_fabs (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Xdata = X->e[0];
-  double             *Ydata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    Ydata[i] = fabs (Xdata[i]);
+  sc_dmatrix_apply (SC_DMATRIX_OP_FABS, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_sqrt (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Xdata = X->e[0];
-  double             *Ydata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    Ydata[i] = sqrt (Xdata[i]);
+  sc_dmatrix_apply (SC_DMATRIX_OP_SQRT, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_getsign (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *indata = X->e[0];
-  double             *outdata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    outdata[i] = (indata[i] >= 0. ? 1 : -1);
+  sc_dmatrix_apply (SC_DMATRIX_OP_GETSIGN, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_greaterequal (const sc_dmatrix_t * X, double bound,
                          sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *indata = X->e[0];
-  double             *outdata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    outdata[i] = (indata[i] >= bound ? 1 : 0);
+  sc_dmatrix_apply (SC_DMATRIX_OP_GREATEREQUAL, bound, 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_lessequal (const sc_dmatrix_t * X, double bound, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *indata = X->e[0];
-  double             *outdata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    outdata[i] = (indata[i] <= bound ? 1 : 0);
+  sc_dmatrix_apply (SC_DMATRIX_OP_LESSEQUAL, bound, 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_maximum (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *indata = X->e[0];
-  double             *outdata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    outdata[i] = SC_MAX (indata[i], outdata[i]);
+  sc_dmatrix_apply (SC_DMATRIX_OP_MAXIMUM, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_minimum (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *indata = X->e[0];
-  double             *outdata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    outdata[i] = SC_MIN (indata[i], outdata[i]);
+  sc_dmatrix_apply (SC_DMATRIX_OP_MINIMUM, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_dotmultiply (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Xdata = X->e[0];
-  double             *Ydata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    Ydata[i] *= Xdata[i];
+  sc_dmatrix_apply (SC_DMATRIX_OP_DOTMULTIPLY, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_dotdivide (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Xdata = X->e[0];
-  double             *Ydata = Y->e[0];
-
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i)
-    Ydata[i] /= Xdata[i];
+  sc_dmatrix_apply (SC_DMATRIX_OP_DOTDIVIDE, 0., 0., 0., NULL, X, Y);
 }
 
 void
 sc_dmatrix_dotmultiply_add (const sc_dmatrix_t * A, const sc_dmatrix_t * X,
                             sc_dmatrix_t * Y)
 {
-  sc_bint_t           i;
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Adata = A->e[0];
-  const double       *Xdata = X->e[0];
-  double             *Ydata = Y->e[0];
-
-  SC_ASSERT (X->m == A->m && X->n == A->n);
-  SC_ASSERT (X->m == Y->m && X->n == Y->n);
-
-  for (i = 0; i < totalsize; ++i) {
-    Ydata[i] += Adata[i] * Xdata[i];
-  }
+  sc_dmatrix_apply (SC_DMATRIX_OP_DOTMULTIPLY_ADD, 0., 0., 0., A, X, Y);
 }
 
 void
 sc_dmatrix_copy (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  const sc_bint_t     totalsize = X->m * X->n;
-  const double       *Xdata = X->e[0];
-  double             *Ydata = Y->e[0];
+  sc_bint_t           r, len;
+  const sc_bint_t     runs = sc_dmatrix_runs (X, Y, NULL, &len);
 
   SC_ASSERT (X->m == Y->m && X->n == Y->n);
 
-  memmove (Ydata, Xdata, totalsize * sizeof (double));
+  for (r = 0; r < runs; ++r) {
+    memmove (Y->e[r], X->e[r], len * sizeof (double));
+  }
 }
 
 void
@@ -602,8 +1074,8 @@ sc_dmatrix_transpose (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 
   Xrows = X->m;
   Xcols = X->n;
-  Xstride = X->n;
-  Ystride = Y->n;
+  Xstride = X->ld;
+  Ystride = Y->ld;
   Ydata = Y->e[0];
 
   for (i = 0; i < Xrows; i++) {
@@ -616,24 +1088,216 @@ sc_dmatrix_transpose (const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 void
 sc_dmatrix_add (double alpha, const sc_dmatrix_t * X, sc_dmatrix_t * Y)
 {
-  sc_bint_t           totalsize, inc;
+#ifdef SC_WITH_BLAS
+  sc_bint_t           len;
 
   SC_ASSERT (X->m == Y->m && X->n == Y->n);
 
-  totalsize = X->m * X->n;
+  if (sc_dmatrix_runs (X, Y, NULL, &len) == 1) {
+    /* contiguous storage is best left to the BLAS */
+    const sc_bint_t     inc = 1;
+
+    if (len > 0) {
+      SC_BLAS_DAXPY (&len, &alpha, X->e[0], &inc, Y->e[0], &inc);
+    }
+    return;
+  }
+#endif
+  sc_dmatrix_apply (SC_DMATRIX_OP_AXPY, alpha, 0., 0., NULL, X, Y);
+}
+
+void
+sc_dmatrix_axpby (double alpha, const sc_dmatrix_t * X,
+                  double beta, sc_dmatrix_t * Y)
+{
+  sc_dmatrix_apply (SC_DMATRIX_OP_AXPBY, alpha, beta, 0., NULL, X, Y);
+}
 
-  inc = 1;
-  if (totalsize > 0) {
-    SC_BLAS_DAXPY (&totalsize, &alpha, X->e[0], &inc, Y->e[0], &inc);
+void
+sc_dmatrix_dotmultiply_axpby (double alpha, const sc_dmatrix_t * A,
+                              const sc_dmatrix_t * X, double beta,
+                              double gamma, sc_dmatrix_t * Y)
+{
+  if (A != NULL) {
+    sc_dmatrix_apply (SC_DMATRIX_OP_DOTMULTIPLY_AXPBY, alpha, beta, gamma,
+                      A, X, Y);
+  }
+  else {
+    sc_dmatrix_apply (SC_DMATRIX_OP_AXPBY, alpha, beta, gamma, NULL, X, Y);
   }
 }
 
+void
+sc_dmatrix_clamp_pow (const sc_dmatrix_t * X, double low, double high,
+                      double exponent, sc_dmatrix_t * Y)
+{
+  SC_ASSERT (low <= high);
+  sc_dmatrix_apply (SC_DMATRIX_OP_CLAMP_POW, low, high, exponent,
+                    NULL, X, Y);
+}
+
+/** One update recorded in an expression. */
+typedef struct sc_dmatrix_expr_item
+{
+  sc_dmatrix_op_t     op;       /**< The kind of update. */
+  double              a, b, c;  /**< Scalar parameters of the update. */
+  const sc_dmatrix_t *X;        /**< Matrix operand or NULL for Y. */
+}
+sc_dmatrix_expr_item_t;
+
+struct sc_dmatrix_expr
+{
+  sc_array_t          items;    /**< Updates of type sc_dmatrix_expr_item_t. */
+};
+
+/** Context of an expression evaluation passed to the blocks. */
+typedef struct sc_dmatrix_expr_eval
+{
+  const sc_dmatrix_expr_t *expr;
+  sc_dmatrix_t       *Y;
+}
+sc_dmatrix_expr_eval_t;
+
+sc_dmatrix_expr_t  *
+sc_dmatrix_expr_new (void)
+{
+  sc_dmatrix_expr_t  *expr = SC_ALLOC (sc_dmatrix_expr_t, 1);
+
+  sc_array_init (&expr->items, sizeof (sc_dmatrix_expr_item_t));
+  return expr;
+}
+
+void
+sc_dmatrix_expr_destroy (sc_dmatrix_expr_t * expr)
+{
+  sc_array_reset (&expr->items);
+  SC_FREE (expr);
+}
+
+static void
+sc_dmatrix_expr_push (sc_dmatrix_expr_t * expr, sc_dmatrix_op_t op,
+                      double a, double b, double c, const sc_dmatrix_t * X)
+{
+  sc_dmatrix_expr_item_t *item;
+
+  item = (sc_dmatrix_expr_item_t *) sc_array_push (&expr->items);
+  item->op = op;
+  item->a = a;
+  item->b = b;
+  item->c = c;
+  item->X = X;
+}
+
+void
+sc_dmatrix_expr_scale_shift (sc_dmatrix_expr_t * expr,
+                             double alpha, double beta)
+{
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_SCALE_SHIFT, alpha, beta, 0.,
+                        NULL);
+}
+
+void
+sc_dmatrix_expr_add (sc_dmatrix_expr_t * expr, double alpha,
+                     const sc_dmatrix_t * X)
+{
+  SC_ASSERT (X != NULL);
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_AXPY, alpha, 0., 0., X);
+}
+
+void
+sc_dmatrix_expr_dotmultiply (sc_dmatrix_expr_t * expr,
+                             const sc_dmatrix_t * X)
+{
+  SC_ASSERT (X != NULL);
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_DOTMULTIPLY, 0., 0., 0., X);
+}
+
+void
+sc_dmatrix_expr_dotdivide (sc_dmatrix_expr_t * expr, const sc_dmatrix_t * X)
+{
+  SC_ASSERT (X != NULL);
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_DOTDIVIDE, 0., 0., 0., X);
+}
+
+void
+sc_dmatrix_expr_clamp (sc_dmatrix_expr_t * expr, double low, double high)
+{
+  SC_ASSERT (low <= high);
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_CLAMP_POW, low, high, 1., NULL);
+}
+
+void
+sc_dmatrix_expr_pow (sc_dmatrix_expr_t * expr, double exponent)
+{
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_CLAMP_POW, -HUGE_VAL, HUGE_VAL,
+                        exponent, NULL);
+}
+
+void
+sc_dmatrix_expr_fabs (sc_dmatrix_expr_t * expr)
+{
+  sc_dmatrix_expr_push (expr, SC_DMATRIX_OP_FABS, 0., 0., 0., NULL);
+}
+
+static void
+sc_dmatrix_expr_block (void *ctx, sc_bint_t r, sc_bint_t offset,
+                       sc_bint_t len)
+{
+  const sc_dmatrix_expr_eval_t *ev = (const sc_dmatrix_expr_eval_t *) ctx;
+  const size_t        count = ev->expr->items.elem_count;
+  const sc_dmatrix_expr_item_t *item =
+    (const sc_dmatrix_expr_item_t *) ev->expr->items.array;
+  double             *Y = ev->Y->e[r] + offset;
+  size_t              zz;
+
+  for (zz = 0; zz < count; ++zz, ++item) {
+    sc_dmatrix_op_run (item->op, item->a, item->b, item->c, len, NULL,
+                       item->X != NULL ? item->X->e[r] + offset : Y, Y);
+  }
+}
+
+void
+sc_dmatrix_expr_evaluate (const sc_dmatrix_expr_t * expr, sc_dmatrix_t * Y)
+{
+  int                 contiguous = SC_DMATRIX_CONTIGUOUS (Y);
+  sc_bint_t           runs, len;
+  size_t              zz;
+  const sc_dmatrix_expr_item_t *item =
+    (const sc_dmatrix_expr_item_t *) expr->items.array;
+  sc_dmatrix_expr_eval_t ev;
+
+  /* the operands must match the result and decide on the runs together */
+  for (zz = 0; zz < expr->items.elem_count; ++zz, ++item) {
+    if (item->X != NULL) {
+      SC_ASSERT (item->X != Y);
+      SC_ASSERT (item->X->m == Y->m && item->X->n == Y->n);
+      contiguous = contiguous && SC_DMATRIX_CONTIGUOUS (item->X);
+    }
+  }
+  if (contiguous) {
+    len = Y->m * Y->n;
+    runs = Y->m > 0 ? 1 : 0;
+  }
+  else {
+    len = Y->n;
+    runs = Y->m;
+  }
+  if (expr->items.elem_count == 0) {
+    return;
+  }
+
+  ev.expr = expr;
+  ev.Y = Y;
+  sc_dmatrix_blocks (runs, len, sc_dmatrix_expr_block, &ev);
+}
+
 void
 sc_dmatrix_vector (sc_trans_t transa, sc_trans_t transx, sc_trans_t transy,
                    double alpha, const sc_dmatrix_t * A,
                    const sc_dmatrix_t * X, double beta, sc_dmatrix_t * Y)
 {
-  sc_bint_t           inc = 1;
+  const sc_bint_t     incx = (transx == SC_NO_TRANS) ? X->ld : 1;
+  const sc_bint_t     incy = (transy == SC_NO_TRANS) ? Y->ld : 1;
 
 #ifdef SC_ENABLE_DEBUG
   sc_bint_t           dimX = (transx == SC_NO_TRANS) ? X->m : X->n;
@@ -650,7 +1314,7 @@ sc_dmatrix_vector (sc_trans_t transa, sc_trans_t transx, sc_trans_t transy,
 
   if (A->n > 0 && A->m > 0) {
     SC_BLAS_DGEMV (&sc_antitranschar[transa], &A->n, &A->m, &alpha,
-                   A->e[0], &A->n, X->e[0], &inc, &beta, Y->e[0], &inc);
+                   A->e[0], &A->ld, X->e[0], &incx, &beta, Y->e[0], &incy);
   }
   else if (beta != 1.) {
     sc_dmatrix_scale (beta, Y);
@@ -682,8 +1346,8 @@ sc_dmatrix_multiply (sc_trans_t transa, sc_trans_t transb, double alpha,
   if (Crows > 0 && Ccols > 0) {
     if (Acols > 0) {
       SC_BLAS_DGEMM (&sc_transchar[transb], &sc_transchar[transa], &Ccols,
-                     &Crows, &Acols, &alpha, B->e[0], &B->n, A->e[0], &A->n,
-                     &beta, C->e[0], &C->n);
+                     &Crows, &Acols, &alpha, B->e[0], &B->ld, A->e[0],
+                     &A->ld, &beta, C->e[0], &C->ld);
     }
     else if (beta != 1.0) {     /* ignore comparison warning */
       sc_dmatrix_scale (beta, C);
@@ -691,13 +1355,259 @@ sc_dmatrix_multiply (sc_trans_t transa, sc_trans_t transb, double alpha,
   }
 }
 
+/** Force the inlining of the kernels into their specializations. */
+#ifdef __GNUC__
+#define SC_DMATRIX_ALWAYS_INLINE __attribute__ ((always_inline))
+#else
+#define SC_DMATRIX_ALWAYS_INLINE
+#endif
+
+/** Maximum column count of a product computed by the built-in kernels. */
+#define SC_DMATRIX_KERNEL_ROW 64
+
+/** Products with more multiply-adds than this are passed to BLAS, whose
+ * call overhead outweighs its faster inner loops for smaller ones.
+ */
+#define SC_DMATRIX_KERNEL_WORK 256
+
+/** Scale a row of C by beta, where a zero beta overwrites the row. */
+static void
+sc_dmatrix_kernel_beta (sc_bint_t n, double beta, double *Crow)
+{
+  sc_bint_t           j;
+
+  for (j = 0; j < n; ++j) {
+    Crow[j] = beta == 0. ? 0. : beta * Crow[j];
+  }
+}
+
+/** Store a row of a product into C := row + beta * C.
+ * A zero beta overwrites the row, as in BLAS.
+ */
+static inline SC_DMATRIX_ALWAYS_INLINE void
+sc_dmatrix_kernel_store (sc_bint_t n, const double *row, double beta,
+                         double *Crow)
+{
+  sc_bint_t           j;
+
+  if (beta == 0.) {
+    for (j = 0; j < n; ++j) {
+      Crow[j] = row[j];
+    }
+  }
+  else {
+    for (j = 0; j < n; ++j) {
+      Crow[j] = row[j] + beta * Crow[j];
+    }
+  }
+}
+
+/** Multiply small row-major matrices C := alpha * A * B + beta * C.
+ * Each row of the product is summed up in local memory, which does not
+ * alias the arguments.  Called with constant sizes, the loops are
+ * unrolled and vectorized by the compiler.
+ */
+static inline SC_DMATRIX_ALWAYS_INLINE void
+sc_dmatrix_kernel_nn (sc_bint_t m, sc_bint_t n, sc_bint_t k, double alpha,
+                      const double *A, const double *B, double beta,
+                      double *C)
+{
+  sc_bint_t           i, j, l;
+  double              a, row[SC_DMATRIX_KERNEL_ROW];
+
+  SC_ASSERT (n <= SC_DMATRIX_KERNEL_ROW);
+  for (i = 0; i < m; ++i) {
+    for (j = 0; j < n; ++j) {
+      row[j] = 0.;
+    }
+    for (l = 0; l < k; ++l) {
+      a = alpha * A[i * k + l];
+      for (j = 0; j < n; ++j) {
+        row[j] += a * B[l * n + j];
+      }
+    }
+    sc_dmatrix_kernel_store (n, row, beta, C + i * n);
+  }
+}
+
+/** Multiply small row-major matrices with arbitrary transposition.
+ * The entry (i, l) of op (A) is A[i * ars + l * acs], likewise for B.
+ */
+static void
+sc_dmatrix_kernel (sc_bint_t m, sc_bint_t n, sc_bint_t k, double alpha,
+                   const double *A, sc_bint_t ars, sc_bint_t acs,
+                   const double *B, sc_bint_t brs, sc_bint_t bcs,
+                   double beta, double *C)
+{
+  sc_bint_t           i, j, l;
+  double              a, row[SC_DMATRIX_KERNEL_ROW];
+
+  SC_ASSERT (n <= SC_DMATRIX_KERNEL_ROW);
+  for (i = 0; i < m; ++i) {
+    for (j = 0; j < n; ++j) {
+      row[j] = 0.;
+    }
+    for (l = 0; l < k; ++l) {
+      a = alpha * A[i * ars + l * acs];
+      for (j = 0; j < n; ++j) {
+        row[j] += a * B[l * brs + j * bcs];
+      }
+    }
+    sc_dmatrix_kernel_store (n, row, beta, C + i * n);
+  }
+}
+
+static void
+sc_dmatrix_kernel_nn_4 (double alpha, const double *A, const double *B,
+                        double beta, double *C)
+{
+  sc_dmatrix_kernel_nn (4, 4, 4, alpha, A, B, beta, C);
+}
+
+static void
+sc_dmatrix_kernel_nn_8 (double alpha, const double *A, const double *B,
+                        double beta, double *C)
+{
+  sc_dmatrix_kernel_nn (8, 8, 8, alpha, A, B, beta, C);
+}
+
+/** Kernel for the product of square matrices without transposition. */
+typedef void        (*sc_dmatrix_kernel_t) (double alpha, const double *A,
+                                            const double *B, double beta,
+                                            double *C);
+
+/** Select a kernel specialized at compile time, or NULL if none fits. */
+static              sc_dmatrix_kernel_t
+sc_dmatrix_kernel_select (sc_trans_t transa, sc_trans_t transb,
+                          sc_bint_t m, sc_bint_t n, sc_bint_t k)
+{
+  if (transa != SC_NO_TRANS || transb != SC_NO_TRANS || m != n || n != k) {
+    return NULL;
+  }
+  switch (m) {
+  case 4:
+    return sc_dmatrix_kernel_nn_4;
+  case 8:
+    return sc_dmatrix_kernel_nn_8;
+  default:
+    return NULL;
+  }
+}
+
+void
+sc_dmatrix_multiply_strided (sc_trans_t transa, sc_trans_t transb,
+                             sc_bint_t m, sc_bint_t n, sc_bint_t k,
+                             double alpha, const double *A, size_t strideA,
+                             const double *B, size_t strideB, double beta,
+                             double *C, size_t strideC, size_t count)
+{
+  size_t              zz;
+  sc_bint_t           i, ars, acs, brs, bcs;
+  sc_dmatrix_kernel_t kernel;
+
+  SC_ASSERT (transa == SC_NO_TRANS || transa == SC_TRANS);
+  SC_ASSERT (transb == SC_NO_TRANS || transb == SC_TRANS);
+  SC_ASSERT (m >= 0 && n >= 0 && k >= 0);
+  SC_ASSERT (count <= 1 || strideC >= (size_t) (m * n));
+
+  if (count == 0 || m == 0 || n == 0) {
+    return;
+  }
+  if (k == 0) {
+    /* the product is zero */
+    for (zz = 0; zz < count; ++zz) {
+      for (i = 0; i < m; ++i) {
+        sc_dmatrix_kernel_beta (n, beta, C + zz * strideC + i * n);
+      }
+    }
+    return;
+  }
+
+  /* compile-time specialized kernels for common square sizes */
+  if ((kernel = sc_dmatrix_kernel_select (transa, transb, m, n, k)) != NULL) {
+    for (zz = 0; zz < count; ++zz) {
+      kernel (alpha, A + zz * strideA, B + zz * strideB, beta,
+              C + zz * strideC);
+    }
+    return;
+  }
+
+  /* the call overhead of BLAS only pays off for larger matrices */
+#ifdef SC_WITH_BLAS
+  if (n > SC_DMATRIX_KERNEL_ROW ||
+      (double) m * (double) n * (double) k > SC_DMATRIX_KERNEL_WORK) {
+#else
+  if (n > SC_DMATRIX_KERNEL_ROW) {
+#endif
+    sc_bint_t           lda = transa == SC_NO_TRANS ? k : m;
+    sc_bint_t           ldb = transb == SC_NO_TRANS ? n : k;
+
+    for (zz = 0; zz < count; ++zz) {
+      SC_BLAS_DGEMM (&sc_transchar[transb], &sc_transchar[transa], &n, &m,
+                     &k, &alpha, B + zz * strideB, &ldb, A + zz * strideA,
+                     &lda, &beta, C + zz * strideC, &n);
+    }
+    return;
+  }
+
+  /* generic small kernel */
+  ars = transa == SC_NO_TRANS ? k : 1;
+  acs = transa == SC_NO_TRANS ? 1 : m;
+  brs = transb == SC_NO_TRANS ? n : 1;
+  bcs = transb == SC_NO_TRANS ? 1 : k;
+  for (zz = 0; zz < count; ++zz) {
+    sc_dmatrix_kernel (m, n, k, alpha, A + zz * strideA, ars, acs,
+                       B + zz * strideB, brs, bcs, beta, C + zz * strideC);
+  }
+}
+
+void
+sc_dmatrix_multiply_batch (sc_trans_t transa, sc_trans_t transb,
+                           double alpha, const sc_dmatrix_t * const *A,
+                           const sc_dmatrix_t * const *B, double beta,
+                           sc_dmatrix_t * const *C, size_t count)
+{
+  size_t              zz;
+  sc_bint_t           m, n, k;
+  sc_dmatrix_kernel_t kernel;
+
+  if (count == 0) {
+    return;
+  }
+  m = C[0]->m;
+  n = C[0]->n;
+  k = transa == SC_NO_TRANS ? A[0]->n : A[0]->m;
+  kernel = sc_dmatrix_kernel_select (transa, transb, m, n, k);
+
+  for (zz = 0; zz < count; ++zz) {
+    SC_ASSERT (C[zz]->m == m && C[zz]->n == n);
+    SC_ASSERT ((transa == SC_NO_TRANS ? A[zz]->m : A[zz]->n) == m);
+    SC_ASSERT ((transa == SC_NO_TRANS ? A[zz]->n : A[zz]->m) == k);
+    SC_ASSERT ((transb == SC_NO_TRANS ? B[zz]->m : B[zz]->n) == k);
+    SC_ASSERT ((transb == SC_NO_TRANS ? B[zz]->n : B[zz]->m) == n);
+
+    /* the matrices need not be evenly spaced and may be padded */
+    if (!SC_DMATRIX_CONTIGUOUS (A[zz]) || !SC_DMATRIX_CONTIGUOUS (B[zz]) ||
+        !SC_DMATRIX_CONTIGUOUS (C[zz])) {
+      sc_dmatrix_multiply (transa, transb, alpha, A[zz], B[zz], beta, C[zz]);
+    }
+    else if (kernel != NULL) {
+      kernel (alpha, A[zz]->e[0], B[zz]->e[0], beta, C[zz]->e[0]);
+    }
+    else {
+      sc_dmatrix_multiply_strided (transa, transb, m, n, k, alpha,
+                                   A[zz]->e[0], 0, B[zz]->e[0], 0, beta,
+                                   C[zz]->e[0], 0, 1);
+    }
+  }
+}
+
 void
 sc_dmatrix_ldivide (sc_trans_t transa, const sc_dmatrix_t * A,
                     const sc_dmatrix_t * B, sc_dmatrix_t * C)
 {
-  sc_dmatrix_t       *BT;
-  sc_trans_t          invtransa =
-    (transa == SC_NO_TRANS) ? SC_TRANS : SC_NO_TRANS;
+  sc_dmatrix_lu_t    *lu;
+  int                 info;
 
 #ifdef SC_ENABLE_DEBUG
   sc_bint_t           A_nrows = (transa == SC_NO_TRANS) ? A->m : A->n;
@@ -710,15 +1620,16 @@ sc_dmatrix_ldivide (sc_trans_t transa, const sc_dmatrix_t * A,
 
   SC_ASSERT ((C_nrows == A_ncols) && (B_nrows == A_nrows)
              && (B_ncols == C_ncols));
+  SC_ASSERT (A->m == A->n);
 
-  BT = sc_dmatrix_new (B->n, B->m);
-  sc_dmatrix_transpose (B, BT);
-
-  sc_dmatrix_rdivide (invtransa, BT, A, BT);
-
-  sc_dmatrix_transpose (BT, C);
+  /* solve for the columns in place without transposing them */
+  lu = sc_dmatrix_lu_new (A->m);
+  info = sc_dmatrix_lu_factor (lu, A);
+  SC_CHECK_ABORT (info == 0, "Lapack routine DGETRF failed");
 
-  sc_dmatrix_destroy (BT);
+  sc_dmatrix_copy (B, C);
+  sc_dmatrix_lu_ldivide (lu, transa, C);
+  sc_dmatrix_lu_destroy (lu);
 }
 
 void
@@ -733,30 +1644,24 @@ sc_dmatrix_rdivide (sc_trans_t transb, const sc_dmatrix_t * A,
   sc_bint_t           C_nrows = C->m;
   sc_bint_t           C_ncols = C->n;
 #endif
-  sc_bint_t           M = B_ncols, N = B_nrows, Nrhs = A_nrows, info = 0;
+  sc_bint_t           M = B_ncols, N = B_nrows, Nrhs = A_nrows;
+  int                 info;
 
   SC_ASSERT ((C_nrows == A_nrows) && (B_nrows == C_ncols)
              && (B_ncols == A_ncols));
   SC_ASSERT (N > 0 && Nrhs > 0);
 
   if (M == N) {
-    sc_dmatrix_t       *lu = sc_dmatrix_clone (B);
-    sc_bint_t          *ipiv = SC_ALLOC (sc_bint_t, N);
+    sc_dmatrix_lu_t    *lu = sc_dmatrix_lu_new (N);
 
     /* Perform an LU factorization of B. */
-    SC_LAPACK_DGETRF (&N, &N, lu->e[0], &N, ipiv, &info);
-
+    info = sc_dmatrix_lu_factor (lu, B);
     SC_CHECK_ABORT (info == 0, "Lapack routine DGETRF failed");
 
     /* Solve the linear system. */
     sc_dmatrix_copy (A, C);
-    SC_LAPACK_DGETRS (&sc_transchar[transb], &N, &Nrhs, lu->e[0], &N,
-                      ipiv, C->e[0], &N, &info);
-
-    SC_CHECK_ABORT (info == 0, "Lapack routine DGETRS failed");
-
-    SC_FREE (ipiv);
-    sc_dmatrix_destroy (lu);
+    sc_dmatrix_lu_rdivide (lu, transb, C);
+    sc_dmatrix_lu_destroy (lu);
   }
   else {
     SC_CHECK_ABORT (0, "Only square A's work right now\n");
@@ -773,12 +1678,221 @@ sc_dmatrix_solve_transpose_inplace (sc_dmatrix_t * A, sc_dmatrix_t * B)
   SC_ASSERT (A->n == N && B->n == N);
 
   ipiv = SC_ALLOC (sc_bint_t, N);
-  SC_LAPACK_DGESV (&N, &nrhs, A->e[0], &N, ipiv, B->e[0], &N, &info);
+  SC_LAPACK_DGESV (&N, &nrhs, A->e[0], &A->ld, ipiv, B->e[0], &B->ld, &info);
   SC_FREE (ipiv);
 
   SC_CHECK_ABORT (info == 0, "Lapack routine DGESV failed");
 }
 
+/* The factorizations below work on the row-major storage of a matrix,
+ * which LAPACK sees as its transpose.  Right hand sides in the rows of
+ * a matrix are columns to LAPACK, and those in the columns of a matrix
+ * are solved from the right by triangular solves. */
+
+sc_dmatrix_lu_t    *
+sc_dmatrix_lu_new (sc_bint_t n)
+{
+  sc_dmatrix_lu_t    *lu;
+
+  SC_ASSERT (n >= 0);
+
+  lu = SC_ALLOC (sc_dmatrix_lu_t, 1);
+  lu->n = n;
+  lu->factors = sc_dmatrix_new (n, n);
+  lu->ipiv = SC_ALLOC (sc_bint_t, n);
+  lu->factored = 0;
+
+  return lu;
+}
+
+void
+sc_dmatrix_lu_destroy (sc_dmatrix_lu_t * lu)
+{
+  sc_dmatrix_destroy (lu->factors);
+  SC_FREE (lu->ipiv);
+  SC_FREE (lu);
+}
+
+int
+sc_dmatrix_lu_factor (sc_dmatrix_lu_t * lu, const sc_dmatrix_t * A)
+{
+  const sc_bint_t     N = lu->n;
+  sc_bint_t           info = 0;
+
+  SC_ASSERT (A->m == N && A->n == N);
+
+  sc_dmatrix_copy (A, lu->factors);
+  if (N > 0) {
+    SC_LAPACK_DGETRF (&N, &N, lu->factors->e[0], &lu->factors->ld,
+                      lu->ipiv, &info);
+  }
+  lu->factored = (info == 0);
+
+  return (int) info;
+}
+
+/** Exchange two rows of a matrix. */
+static void
+sc_dmatrix_swap_rows (sc_dmatrix_t * C, sc_bint_t i, sc_bint_t j)
+{
+  sc_bint_t           k;
+  double              t, *ci, *cj;
+
+  if (i != j) {
+    ci = C->e[i];
+    cj = C->e[j];
+    for (k = 0; k < C->n; ++k) {
+      t = ci[k];
+      ci[k] = cj[k];
+      cj[k] = t;
+    }
+  }
+}
+
+void
+sc_dmatrix_lu_ldivide (const sc_dmatrix_lu_t * lu, sc_trans_t transa,
+                       sc_dmatrix_t * C)
+{
+  const sc_bint_t     N = lu->n, K = C->n;
+  const double        one = 1.;
+  const sc_dmatrix_t *F = lu->factors;
+  sc_bint_t           i;
+
+  SC_ASSERT (lu->factored);
+  SC_ASSERT (C->m == N);
+  SC_ASSERT (transa == SC_NO_TRANS || transa == SC_TRANS);
+
+  if (N == 0 || K == 0) {
+    return;
+  }
+
+  /* LAPACK sees X = C^T and the factorization A^T = P L U */
+  if (transa == SC_NO_TRANS) {
+    /* solve X P L U = B^T */
+    SC_LAPACK_DTRSM ("R", "U", "N", "N", &K, &N, &one, F->e[0], &F->ld,
+                     C->e[0], &C->ld);
+    SC_LAPACK_DTRSM ("R", "L", "N", "U", &K, &N, &one, F->e[0], &F->ld,
+                     C->e[0], &C->ld);
+    for (i = N - 1; i >= 0; --i) {
+      sc_dmatrix_swap_rows (C, i, lu->ipiv[i] - 1);
+    }
+  }
+  else {
+    /* solve X U^T L^T P^T = B^T */
+    for (i = 0; i < N; ++i) {
+      sc_dmatrix_swap_rows (C, i, lu->ipiv[i] - 1);
+    }
+    SC_LAPACK_DTRSM ("R", "L", "T", "U", &K, &N, &one, F->e[0], &F->ld,
+                     C->e[0], &C->ld);
+    SC_LAPACK_DTRSM ("R", "U", "T", "N", &K, &N, &one, F->e[0], &F->ld,
+                     C->e[0], &C->ld);
+  }
+}
+
+void
+sc_dmatrix_lu_rdivide (const sc_dmatrix_lu_t * lu, sc_trans_t transa,
+                       sc_dmatrix_t * C)
+{
+  const sc_bint_t     N = lu->n, Nrhs = C->m;
+  sc_bint_t           info = 0;
+
+  SC_ASSERT (lu->factored);
+  SC_ASSERT (C->n == N);
+  SC_ASSERT (transa == SC_NO_TRANS || transa == SC_TRANS);
+
+  if (N == 0 || Nrhs == 0) {
+    return;
+  }
+
+  /* the rows of C solve op(A)^T x = b, which uses the factors of A^T */
+  SC_LAPACK_DGETRS (&sc_transchar[transa], &N, &Nrhs, lu->factors->e[0],
+                    &lu->factors->ld, lu->ipiv, C->e[0], &C->ld, &info);
+  SC_CHECK_ABORT (info == 0, "Lapack routine DGETRS failed");
+}
+
+sc_dmatrix_cholesky_t *
+sc_dmatrix_cholesky_new (sc_bint_t n)
+{
+  sc_dmatrix_cholesky_t *chol;
+
+  SC_ASSERT (n >= 0);
+
+  chol = SC_ALLOC (sc_dmatrix_cholesky_t, 1);
+  chol->n = n;
+  chol->factor = sc_dmatrix_new (n, n);
+  chol->factored = 0;
+
+  return chol;
+}
+
+void
+sc_dmatrix_cholesky_destroy (sc_dmatrix_cholesky_t * chol)
+{
+  sc_dmatrix_destroy (chol->factor);
+  SC_FREE (chol);
+}
+
+int
+sc_dmatrix_cholesky_factor (sc_dmatrix_cholesky_t * chol,
+                            const sc_dmatrix_t * A)
+{
+  const sc_bint_t     N = chol->n;
+  sc_bint_t           info = 0;
+
+  SC_ASSERT (A->m == N && A->n == N);
+
+  /* the lower triangle of A is the upper one of its LAPACK transpose */
+  sc_dmatrix_copy (A, chol->factor);
+  if (N > 0) {
+    SC_LAPACK_DPOTRF ("U", &N, chol->factor->e[0], &chol->factor->ld,
+                      &info);
+  }
+  chol->factored = (info == 0);
+
+  return (int) info;
+}
+
+void
+sc_dmatrix_cholesky_ldivide (const sc_dmatrix_cholesky_t * chol,
+                             sc_dmatrix_t * C)
+{
+  const sc_bint_t     N = chol->n, K = C->n;
+  const double        one = 1.;
+  const sc_dmatrix_t *F = chol->factor;
+
+  SC_ASSERT (chol->factored);
+  SC_ASSERT (C->m == N);
+
+  if (N == 0 || K == 0) {
+    return;
+  }
+
+  /* LAPACK sees X = C^T and solves X U^T U = B^T */
+  SC_LAPACK_DTRSM ("R", "U", "N", "N", &K, &N, &one, F->e[0], &F->ld,
+                   C->e[0], &C->ld);
+  SC_LAPACK_DTRSM ("R", "U", "T", "N", &K, &N, &one, F->e[0], &F->ld,
+                   C->e[0], &C->ld);
+}
+
+void
+sc_dmatrix_cholesky_rdivide (const sc_dmatrix_cholesky_t * chol,
+                             sc_dmatrix_t * C)
+{
+  const sc_bint_t     N = chol->n, Nrhs = C->m;
+  sc_bint_t           info = 0;
+
+  SC_ASSERT (chol->factored);
+  SC_ASSERT (C->n == N);
+
+  if (N == 0 || Nrhs == 0) {
+    return;
+  }
+
+  SC_LAPACK_DPOTRS ("U", &N, &Nrhs, chol->factor->e[0], &chol->factor->ld,
+                    C->e[0], &C->ld, &info);
+  SC_CHECK_ABORT (info == 0, "Lapack routine DPOTRS failed");
+}
+
 void
 sc_dmatrix_write (const sc_dmatrix_t * dmatrix, FILE * fp)
 {
@@ -795,6 +1909,102 @@ sc_dmatrix_write (const sc_dmatrix_t * dmatrix, FILE * fp)
   }
 }
 
+/** Magic bytes of a binary matrix record. */
+static const char   sc_dmatrix_magic[4] = { 'S', 'C', 'D', 'M' };
+
+/** Number of rows passed to the sink or source in one vectored call. */
+#define SC_DMATRIX_IO_ROWS 64
+
+int
+sc_dmatrix_write_binary (const sc_dmatrix_t * dmatrix, sc_io_sink_t * sink)
+{
+  sc_bint_t           r, k, runs, len;
+  sc_io_vec_t         vec[SC_DMATRIX_IO_ROWS];
+
+  SC_ASSERT (dmatrix != NULL);
+
+  runs = sc_dmatrix_runs (dmatrix, NULL, NULL, &len);
+  if (runs <= 1) {
+    return sc_io_sink_write_record (sink, sc_dmatrix_magic, sizeof (double),
+                                    (size_t) (dmatrix->m * dmatrix->n),
+                                    (size_t) dmatrix->n,
+                                    runs == 1 ? dmatrix->e[0] : NULL);
+  }
+
+  /* padded rows are passed on from where they are */
+  if (sc_io_sink_write_record (sink, sc_dmatrix_magic, sizeof (double),
+                               (size_t) (dmatrix->m * dmatrix->n),
+                               (size_t) dmatrix->n, NULL)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  for (r = 0; r < runs; r += k) {
+    for (k = 0; k < SC_DMATRIX_IO_ROWS && r + k < runs; ++k) {
+      vec[k].base = dmatrix->e[r + k];
+      vec[k].bytes = (size_t) len * sizeof (double);
+    }
+    if (sc_io_sink_writev (sink, vec, (int) k)) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+/** Read the header of a matrix record and derive the dimensions. */
+static int
+sc_dmatrix_read_header (sc_io_source_t * source, sc_bint_t * m,
+                        sc_bint_t * n)
+{
+  size_t              elem_size, elem_count, cols;
+
+  if (sc_io_source_read_record (source, sc_dmatrix_magic, &elem_size,
+                                &elem_count, &cols) ||
+      elem_size != sizeof (double) ||
+      (cols == 0 && elem_count > 0) ||
+      (cols > 0 && elem_count % cols != 0)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  *n = (sc_bint_t) cols;
+  *m = cols > 0 ? (sc_bint_t) (elem_count / cols) : 0;
+  return SC_IO_ERROR_NONE;
+}
+
+sc_dmatrix_t       *
+sc_dmatrix_read_binary (sc_io_source_t * source)
+{
+  sc_bint_t           m, n;
+  sc_dmatrix_t       *dmatrix;
+
+  if (sc_dmatrix_read_header (source, &m, &n)) {
+    return NULL;
+  }
+
+  /* a new matrix is contiguous, so the entries are read in one piece */
+  dmatrix = sc_dmatrix_new (m, n);
+  SC_ASSERT (SC_DMATRIX_CONTIGUOUS (dmatrix));
+  if (m * n > 0 &&
+      sc_io_source_read (source, dmatrix->e[0],
+                         (size_t) (m * n) * sizeof (double), NULL)) {
+    sc_dmatrix_destroy (dmatrix);
+    return NULL;
+  }
+  return dmatrix;
+}
+
+sc_dmatrix_t       *
+sc_dmatrix_read_binary_view (sc_io_source_t * source)
+{
+  sc_bint_t           m, n;
+  const void         *data = NULL;
+
+  if (sc_dmatrix_read_header (source, &m, &n) ||
+      (m * n > 0 &&
+       sc_io_source_view (source, (size_t) (m * n) * sizeof (double),
+                          &data, NULL))) {
+    return NULL;
+  }
+  return sc_dmatrix_new_data (m, n, (double *) data);
+}
+
 sc_dmatrix_pool_t  *
 sc_dmatrix_pool_new (sc_bint_t m, sc_bint_t n)
 {
@@ -861,6 +2071,346 @@ sc_dmatrix_pool_free (sc_dmatrix_pool_t * dmpool, sc_dmatrix_t * dm)
   *(sc_dmatrix_t **) sc_array_push (&dmpool->freed) = dm;
 }
 
+/* locking routines for the thread-safe matrix pool */
+
+#ifdef SC_ENABLE_PTHREAD
+typedef pthread_mutex_t sc_dmatrix_lock_t;
+#elif defined SC_ENABLE_OPENMP
+typedef omp_lock_t  sc_dmatrix_lock_t;
+#else
+typedef int         sc_dmatrix_lock_t;  /* no threads, no locking */
+#endif
+
+static void
+sc_dmatrix_lock_init (sc_dmatrix_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_init (lock, NULL);
+  SC_CHECK_ABORT (pth == 0, "sc_dmatrix_lock_init");
+#elif defined SC_ENABLE_OPENMP
+  omp_init_lock (lock);
+#else
+  *lock = 0;
+#endif
+}
+
+static void
+sc_dmatrix_lock_destroy (sc_dmatrix_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_destroy (lock);
+  SC_CHECK_ABORT (pth == 0, "sc_dmatrix_lock_destroy");
+#elif defined SC_ENABLE_OPENMP
+  omp_destroy_lock (lock);
+#endif
+}
+
+static void
+sc_dmatrix_lock (sc_dmatrix_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_lock (lock);
+  SC_CHECK_ABORT (pth == 0, "sc_dmatrix_lock");
+#elif defined SC_ENABLE_OPENMP
+  omp_set_lock (lock);
+#endif
+}
+
+static void
+sc_dmatrix_unlock (sc_dmatrix_lock_t * lock)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_unlock (lock);
+  SC_CHECK_ABORT (pth == 0, "sc_dmatrix_unlock");
+#elif defined SC_ENABLE_OPENMP
+  omp_unset_lock (lock);
+#endif
+}
+
+struct sc_dmatrix_pool_mt
+{
+  int                 zero_on_alloc;
+  int                 num_caches;       /* number of initialized caches */
+  long                elem_count;       /* collected from reset caches */
+  char               *slab_storage;     /* slab allocation or NULL */
+  char               *slab;             /* aligned start of the slab */
+  size_t              slab_size;
+  size_t              slab_used;
+  sc_array_t          fresh;            /* blocks allocated beyond slab */
+  sc_array_t          depot[SC_DMATRIX_POOL_CLASSES];   /* freed blocks */
+  sc_dmatrix_lock_t   lock;             /* protects all of the above */
+};
+
+/** Bytes before the entries of a pooled matrix: header and row pointers. */
+static size_t
+sc_dmatrix_pool_head (sc_bint_t m)
+{
+  return SC_ALIGN_UP (sizeof (sc_dmatrix_t) + (m + 1) * sizeof (double *),
+                      SC_DMATRIX_ALIGN);
+}
+
+/** Return the size class of the block that stores a matrix. */
+static int
+sc_dmatrix_pool_class (sc_bint_t m, sc_bint_t n)
+{
+  const size_t        bytes =
+    sc_dmatrix_pool_head (m) + (size_t) m * n * sizeof (double);
+  int                 c = SC_DMATRIX_POOL_MIN_CLASS;
+
+  while (((size_t) 1 << c) < bytes) {
+    ++c;
+  }
+  SC_ASSERT (c < SC_DMATRIX_POOL_MIN_CLASS + SC_DMATRIX_POOL_CLASSES);
+
+  return c - SC_DMATRIX_POOL_MIN_CLASS;
+}
+
+sc_dmatrix_pool_mt_t *
+sc_dmatrix_pool_mt_new (size_t slab_size, int zero_on_alloc)
+{
+  int                 c;
+  size_t              zz;
+  sc_dmatrix_pool_mt_t *pool;
+
+  pool = SC_ALLOC (sc_dmatrix_pool_mt_t, 1);
+  pool->zero_on_alloc = zero_on_alloc;
+  pool->num_caches = 0;
+  pool->elem_count = 0;
+
+  /* the slab is not touched here such that its pages are placed near
+     the threads that carve their first blocks from it */
+  pool->slab_size = slab_size;
+  pool->slab_used = 0;
+  if (slab_size > 0) {
+    pool->slab_storage = SC_ALLOC (char, slab_size + SC_DMATRIX_ALIGN);
+    zz = (size_t) ((uintptr_t) pool->slab_storage % SC_DMATRIX_ALIGN);
+    pool->slab = pool->slab_storage + (zz > 0 ? SC_DMATRIX_ALIGN - zz : 0);
+  }
+  else {
+    pool->slab_storage = pool->slab = NULL;
+  }
+
+  sc_array_init (&pool->fresh, sizeof (char *));
+  for (c = 0; c < SC_DMATRIX_POOL_CLASSES; ++c) {
+    sc_array_init (&pool->depot[c], sizeof (void *));
+  }
+  sc_dmatrix_lock_init (&pool->lock);
+
+  return pool;
+}
+
+void
+sc_dmatrix_pool_mt_destroy (sc_dmatrix_pool_mt_t * pool)
+{
+  int                 c;
+  size_t              zz;
+
+  SC_ASSERT (pool->num_caches == 0);
+  SC_ASSERT (pool->elem_count == 0);
+
+  sc_dmatrix_lock_destroy (&pool->lock);
+  for (c = 0; c < SC_DMATRIX_POOL_CLASSES; ++c) {
+    sc_array_reset (&pool->depot[c]);
+  }
+  for (zz = 0; zz < pool->fresh.elem_count; ++zz) {
+    SC_FREE (*(char **) sc_array_index (&pool->fresh, zz));
+  }
+  sc_array_reset (&pool->fresh);
+  SC_FREE (pool->slab_storage);
+  SC_FREE (pool);
+}
+
+size_t
+sc_dmatrix_pool_mt_elem_count (sc_dmatrix_pool_mt_t * pool)
+{
+  long                count;
+
+  sc_dmatrix_lock (&pool->lock);
+  count = pool->elem_count;
+  sc_dmatrix_unlock (&pool->lock);
+
+  SC_ASSERT (count >= 0);
+  return (size_t) count;
+}
+
+void
+sc_dmatrix_pool_cache_init (sc_dmatrix_pool_cache_t * cache,
+                            sc_dmatrix_pool_mt_t * pool)
+{
+  int                 c;
+
+  cache->pool = pool;
+  cache->elem_count = 0;
+  for (c = 0; c < SC_DMATRIX_POOL_CLASSES; ++c) {
+    cache->num_cached[c] = 0;
+  }
+
+  sc_dmatrix_lock (&pool->lock);
+  ++pool->num_caches;
+  sc_dmatrix_unlock (&pool->lock);
+}
+
+/** Move blocks of one class from the top of the cache into the depot.
+ * The pool must be locked by the caller.
+ */
+static void
+sc_dmatrix_pool_cache_give (sc_dmatrix_pool_cache_t * cache, int c, int num)
+{
+  sc_array_t         *depot = &cache->pool->depot[c];
+  size_t              old_count = depot->elem_count;
+
+  SC_ASSERT (0 <= num && num <= cache->num_cached[c]);
+
+  if (num > 0) {
+    cache->num_cached[c] -= num;
+    sc_array_resize (depot, old_count + num);
+    memcpy (sc_array_index (depot, old_count),
+            cache->cached[c] + cache->num_cached[c], num * sizeof (void *));
+  }
+}
+
+void
+sc_dmatrix_pool_cache_reset (sc_dmatrix_pool_cache_t * cache)
+{
+  int                 c;
+  sc_dmatrix_pool_mt_t *pool = cache->pool;
+
+  sc_dmatrix_lock (&pool->lock);
+  for (c = 0; c < SC_DMATRIX_POOL_CLASSES; ++c) {
+    sc_dmatrix_pool_cache_give (cache, c, cache->num_cached[c]);
+  }
+  pool->elem_count += cache->elem_count;
+  --pool->num_caches;
+  sc_dmatrix_unlock (&pool->lock);
+
+  cache->pool = NULL;
+  cache->elem_count = 0;
+}
+
+/** Fill the empty cache of one class from the depot or fresh memory.
+ * Fresh blocks are created one at a time since they may be large.
+ */
+static void
+sc_dmatrix_pool_cache_refill (sc_dmatrix_pool_cache_t * cache, int c)
+{
+  const size_t        bytes =
+    (size_t) 1 << (c + SC_DMATRIX_POOL_MIN_CLASS);
+  size_t              take, zz;
+  char               *storage;
+  sc_dmatrix_pool_mt_t *pool = cache->pool;
+  sc_array_t         *depot = &pool->depot[c];
+
+  SC_ASSERT (cache->num_cached[c] == 0);
+
+  sc_dmatrix_lock (&pool->lock);
+
+  /* recycle freed blocks first */
+  take = SC_MIN (depot->elem_count, (size_t) SC_DMATRIX_POOL_MAGAZINE);
+  if (take > 0) {
+    memcpy (cache->cached[c],
+            sc_array_index (depot, depot->elem_count - take),
+            take * sizeof (void *));
+    sc_array_resize (depot, depot->elem_count - take);
+    cache->num_cached[c] = (int) take;
+  }
+  else if (pool->slab_used + bytes <= pool->slab_size) {
+    /* blocks are multiples of the alignment and stay aligned */
+    cache->cached[c][0] = pool->slab + pool->slab_used;
+    cache->num_cached[c] = 1;
+    pool->slab_used += bytes;
+  }
+
+  sc_dmatrix_unlock (&pool->lock);
+
+  if (cache->num_cached[c] == 0) {
+    /* allocate outside of the lock and only register the block */
+    storage = SC_ALLOC (char, bytes + SC_DMATRIX_ALIGN);
+    zz = (size_t) ((uintptr_t) storage % SC_DMATRIX_ALIGN);
+    cache->cached[c][0] = storage + (zz > 0 ? SC_DMATRIX_ALIGN - zz : 0);
+    cache->num_cached[c] = 1;
+
+    sc_dmatrix_lock (&pool->lock);
+    *(char **) sc_array_push (&pool->fresh) = storage;
+    sc_dmatrix_unlock (&pool->lock);
+  }
+}
+
+sc_dmatrix_t       *
+sc_dmatrix_pool_cache_alloc (sc_dmatrix_pool_cache_t * cache,
+                             sc_bint_t m, sc_bint_t n)
+{
+  int                 c;
+  sc_bint_t           i;
+  char               *block;
+  sc_dmatrix_t       *dm;
+
+  SC_ASSERT (cache->pool != NULL);
+  SC_ASSERT (m >= 0 && n >= 0);
+
+  c = sc_dmatrix_pool_class (m, n);
+  if (cache->num_cached[c] == 0) {
+    sc_dmatrix_pool_cache_refill (cache, c);
+  }
+  SC_ASSERT (cache->num_cached[c] > 0);
+  block = (char *) cache->cached[c][--cache->num_cached[c]];
+  ++cache->elem_count;
+
+  /* header, row pointers and aligned entries share the block */
+  dm = (sc_dmatrix_t *) block;
+  dm->e = (double **) (dm + 1);
+  dm->e[0] = (double *) (block + sc_dmatrix_pool_head (m));
+  for (i = 1; i < m; ++i) {
+    dm->e[i] = dm->e[i - 1] + n;
+  }
+  if (m > 0) {
+    dm->e[m] = NULL;            /* safeguard */
+  }
+  dm->m = m;
+  dm->n = n;
+  dm->ld = n;
+  dm->view = 1;
+  dm->storage = NULL;
+
+  if (cache->pool->zero_on_alloc) {
+    sc_dmatrix_set_zero (dm);
+  }
+#ifdef SC_ENABLE_DEBUG
+  else {
+    sc_dmatrix_set_value (dm, -1.);
+  }
+#endif
+
+  return dm;
+}
+
+void
+sc_dmatrix_pool_cache_free (sc_dmatrix_pool_cache_t * cache,
+                            sc_dmatrix_t * dm)
+{
+  const int           c = sc_dmatrix_pool_class (dm->m, dm->n);
+
+  SC_ASSERT (cache->pool != NULL);
+  SC_ASSERT (dm->view && dm->storage == NULL);
+  SC_ASSERT (dm->e == (double **) (dm + 1));
+
+  if (cache->num_cached[c] == 2 * SC_DMATRIX_POOL_MAGAZINE) {
+    /* keep half of the blocks to avoid thrashing on the boundary */
+    sc_dmatrix_lock (&cache->pool->lock);
+    sc_dmatrix_pool_cache_give (cache, c, SC_DMATRIX_POOL_MAGAZINE);
+    sc_dmatrix_unlock (&cache->pool->lock);
+  }
+  cache->cached[c][cache->num_cached[c]++] = dm;
+  --cache->elem_count;
+}
+
 sc_darray_work_t   *
 sc_darray_work_new (const int n_threads, const int n_blocks,
                     const int n_entries, const int alignment_bytes)
@@ -31,16 +31,38 @@
 
 #include <sc_blas.h>
 #include <sc_containers.h>
+#include <sc_io.h>
 
 SC_EXTERN_C_BEGIN;
 
-/** This is the matrix object.  It can have its own storage or be a view. */
+/** Byte alignment of the rows of a matrix created by
+ * \ref sc_dmatrix_new_aligned.  This is the size of a typical cache line
+ * and a multiple of the widest SIMD registers in use.
+ */
+#define SC_DMATRIX_ALIGN 64
+
+/** With OpenMP, element-wise updates and checks of at least this many
+ * entries are split over threads.  The static partition of the entries
+ * is the same for all updates of matrices of the same shape, such that
+ * memory first touched by one of them stays local to its thread. */
+#ifndef SC_DMATRIX_OPENMP_MIN
+#define SC_DMATRIX_OPENMP_MIN (1 << 16)
+#endif
+
+/** This is the matrix object.  It can have its own storage or be a view.
+ * The rows are stored \b ld doubles apart, which is usually equal to \b n.
+ * Matrices created by \ref sc_dmatrix_new_aligned pad each row to start on
+ * a \ref SC_DMATRIX_ALIGN byte boundary, and views onto a single column
+ * keep the row stride of the matrix viewed.
+ */
 typedef struct sc_dmatrix
 {
   double            **e;        /**< Array into the rows of the matrix. */
   sc_bint_t           m;        /**< Number of rows in this matrix. */
   sc_bint_t           n;        /**< Number of columns in this matrix. */
+  sc_bint_t           ld;       /**< Leading dimension: row stride >= n. */
   int                 view;     /**< Boolean to indicate this is a view. */
+  void               *storage;  /**< Padded allocation owned or NULL. */
 }
 sc_dmatrix_t;
 
@@ -83,6 +105,27 @@ sc_dmatrix_t       *sc_dmatrix_new (sc_bint_t m, sc_bint_t n);
  */
 sc_dmatrix_t       *sc_dmatrix_new_zero (sc_bint_t m, sc_bint_t n);
 
+/** Create a new uninitialized matrix object with aligned and padded rows.
+ * Every row starts on a \ref SC_DMATRIX_ALIGN byte boundary, and the
+ * leading dimension \b ld is \b n rounded up accordingly.  The padding
+ * entries are zero and are ignored by all sc_dmatrix functions.
+ * Such a matrix cannot be reshaped or resized.
+ * This function aborts on memory allocation errors.
+ * \param [in] m            Number of rows.
+ * \param [in] n            Number of columns.
+ * \return                  A valid padded dmatrix with uninitialized entries.
+ */
+sc_dmatrix_t       *sc_dmatrix_new_aligned (sc_bint_t m, sc_bint_t n);
+
+/** Create a new matrix object with aligned and padded rows set to zero.
+ * See \ref sc_dmatrix_new_aligned for the storage layout.
+ * This function aborts on memory allocation errors.
+ * \param [in] m            Number of rows.
+ * \param [in] n            Number of columns.
+ * \return                  A valid padded dmatrix storing all zeros.
+ */
+sc_dmatrix_t       *sc_dmatrix_new_aligned_zero (sc_bint_t m, sc_bint_t n);
+
 /** Create a new matrix object with the same size and entries as another.
  * This function aborts on memory allocation errors.
  * \param [in] dmatrix      A valid dmatrix or view.
@@ -100,6 +143,7 @@ sc_dmatrix_t       *sc_dmatrix_new_data (sc_bint_t m, sc_bint_t n,
 /** Create a matrix view on an existing sc_dmatrix_t.
  * The original matrix must have greater equal as many elements as the view.
  * The original matrix must not be destroyed or resized while view is in use.
+ * If the original matrix is padded, the view must have as many columns.
  * \note            Currently, creating views of views is not safe.
  */
 sc_dmatrix_t       *sc_dmatrix_new_view (sc_bint_t m, sc_bint_t n,
@@ -109,6 +153,7 @@ sc_dmatrix_t       *sc_dmatrix_new_view (sc_bint_t m, sc_bint_t n,
  * The start of the view is offset by a number of rows.
  * The original matrix must have greater equal as many elements as view end.
  * The original matrix must not be destroyed or resized while view is in use.
+ * If the original matrix is padded, the view must have as many columns.
  * \param [in] o    Number of rows that the view is offset.
  *                  Requires (o + m) * n <= orig->m * orig->n.
  * \param [in] m    Number of rows that the view shall have.
@@ -157,6 +202,7 @@ void                sc_dmatrix_view_set_row (sc_dmatrix_t * view,
                                              sc_bint_t i);
 
 /** Reshape a matrix to different m and n without changing m * n.
+ * The rows of the matrix must be stored contiguously.
  */
 void                sc_dmatrix_reshape (sc_dmatrix_t * dmatrix,
                                         sc_bint_t m, sc_bint_t n);
@@ -165,6 +211,7 @@ void                sc_dmatrix_reshape (sc_dmatrix_t * dmatrix,
  * For views it must be known that the new size is permitted.
  * For non-views the data will be realloced if necessary.
  * The entries are unchanged to the minimum of the old and new sizes.
+ * This is not valid for matrices from \ref sc_dmatrix_new_aligned.
  */
 void                sc_dmatrix_resize (sc_dmatrix_t * dmatrix,
                                        sc_bint_t m, sc_bint_t n);
@@ -172,7 +219,7 @@ void                sc_dmatrix_resize (sc_dmatrix_t * dmatrix,
 /** Change the matrix dimensions, while keeping the subscripts in place, i.e.
  * dmatrix->e[i][j] will have the same value before and after, as long as
  * (i, j) is still a valid subscript.
- * This is not valid for views.
+ * This is not valid for views and matrices from \ref sc_dmatrix_new_aligned.
  * For non-views the data will be realloced if necessary.
  * The entries are unchanged to the minimum of the old and new sizes.
  */
@@ -300,6 +347,95 @@ void                sc_dmatrix_transpose (const sc_dmatrix_t * X,
 void                sc_dmatrix_add (double alpha, const sc_dmatrix_t * X,
                                     sc_dmatrix_t * Y);
 
+/** Perform a scaled matrix addition in one pass, Y := alpha X + beta Y.
+ * With a zero \b beta, the entries of Y are overwritten without reading.
+ */
+void                sc_dmatrix_axpby (double alpha, const sc_dmatrix_t * X,
+                                      double beta, sc_dmatrix_t * Y);
+
+/** Perform a fused element-wise multiply-add with scalars in one pass,
+ * Y := alpha A .* X + beta Y + gamma.
+ * This generalizes \ref sc_dmatrix_dotmultiply_add and, with \b A NULL
+ * taken as all ones, \ref sc_dmatrix_axpby followed by a shift.
+ * \param [in] alpha    Factor of the element-wise product.
+ * \param [in] A        Matrix of the dimensions of Y, or NULL.
+ * \param [in] X        Matrix of the dimensions of Y.
+ * \param [in] beta     Factor of the previous Y.  If zero, Y is not read.
+ * \param [in] gamma    Added to every entry.
+ * \param [in,out] Y    Matrix updated in place.
+ */
+void                sc_dmatrix_dotmultiply_axpby (double alpha,
+                                                  const sc_dmatrix_t * A,
+                                                  const sc_dmatrix_t * X,
+                                                  double beta, double gamma,
+                                                  sc_dmatrix_t * Y);
+
+/** Raise clamped entries to a power in one pass,
+ * Y := min (max (X, low), high) ^ exponent.
+ * An exponent of .5 uses sqrt and an exponent of 1 only clamps.
+ * Clamping to a nonnegative \b low keeps the result free of NaN.
+ * \param [in] X        Matrix taken as a source, may be Y.
+ * \param [in] low      Lower bound of the clamp, may be -HUGE_VAL.
+ * \param [in] high     Upper bound of the clamp, may be HUGE_VAL.
+ * \param [in] exponent Exponent applied after clamping.
+ * \param [out] Y       Matrix of dimensions of \b X.
+ */
+void                sc_dmatrix_clamp_pow (const sc_dmatrix_t * X,
+                                          double low, double high,
+                                          double exponent, sc_dmatrix_t * Y);
+
+/** An expression of element-wise updates evaluated in a single pass.
+ * The operations are recorded in order and applied to a result matrix
+ * block by block, such that every block stays in cache until all
+ * operations are done with it.  Any matrix operands are referenced and
+ * must stay valid and unchanged until the expression is evaluated.
+ * Operands must have the dimensions of the result and must not be it.
+ */
+typedef struct sc_dmatrix_expr sc_dmatrix_expr_t;
+
+/** Create an empty expression, which leaves the result unchanged. */
+sc_dmatrix_expr_t  *sc_dmatrix_expr_new (void);
+
+/** Destroy an expression.  The operand matrices are not touched. */
+void                sc_dmatrix_expr_destroy (sc_dmatrix_expr_t * expr);
+
+/** Append the update Y := alpha .* Y + beta to an expression. */
+void                sc_dmatrix_expr_scale_shift (sc_dmatrix_expr_t * expr,
+                                                 double alpha, double beta);
+
+/** Append the update Y := Y + alpha X to an expression. */
+void                sc_dmatrix_expr_add (sc_dmatrix_expr_t * expr,
+                                         double alpha,
+                                         const sc_dmatrix_t * X);
+
+/** Append the update Y := Y .* X to an expression. */
+void                sc_dmatrix_expr_dotmultiply (sc_dmatrix_expr_t * expr,
+                                                 const sc_dmatrix_t * X);
+
+/** Append the update Y := Y ./ X to an expression. */
+void                sc_dmatrix_expr_dotdivide (sc_dmatrix_expr_t * expr,
+                                               const sc_dmatrix_t * X);
+
+/** Append the update Y := min (max (Y, low), high) to an expression. */
+void                sc_dmatrix_expr_clamp (sc_dmatrix_expr_t * expr,
+                                           double low, double high);
+
+/** Append the update Y := Y ^ exponent to an expression.
+ * An exponent of .5 uses sqrt. */
+void                sc_dmatrix_expr_pow (sc_dmatrix_expr_t * expr,
+                                         double exponent);
+
+/** Append the update Y := fabs (Y) to an expression. */
+void                sc_dmatrix_expr_fabs (sc_dmatrix_expr_t * expr);
+
+/** Apply all updates of an expression to a matrix in one pass.
+ * The expression is unchanged and may be evaluated again.
+ * \param [in] expr     Expression whose operands match \b Y in size.
+ * \param [in,out] Y    Result matrix updated in place.
+ */
+void                sc_dmatrix_expr_evaluate (const sc_dmatrix_expr_t *
+                                              expr, sc_dmatrix_t * Y);
+
 /** Perform matrix-vector multiplication Y = alpha * A * X + beta * Y.
  * The dimensions of A, X, and Y must be compatible.
  * \param [in] transa   Transpose operation for matrix A.
@@ -334,6 +470,67 @@ void                sc_dmatrix_multiply (sc_trans_t transa,
                                          const sc_dmatrix_t * B, double beta,
                                          sc_dmatrix_t * C);
 
+/** Multiply many small matrices of identical shape stored at a stride.
+ * For each i < count, computes \c C_i := alpha * op (A_i) * op (B_i) +
+ * beta * C_i, where all matrices are dense and row-major, C_i is m x n,
+ * op (A_i) is m x k and op (B_i) is k x n.  A_i begins at A + i * strideA,
+ * likewise for B and C.  A stride of 0 for A or B applies the same matrix
+ * in every product.  Square products of size 4 and 8 without
+ * transposition use kernels specialized at compile time.  Other small
+ * products, for which the call overhead of BLAS dominates, use a generic
+ * kernel; larger ones call BLAS dgemm for each matrix.
+ * \param [in] transa   Transpose operation for the matrices A.
+ * \param [in] transb   Transpose operation for the matrices B.
+ * \param [in] m        Row count of C.
+ * \param [in] n        Column count of C.
+ * \param [in] k        Column count of op (A) and row count of op (B).
+ * \param [in] alpha    Factor for the product.
+ * \param [in] A        Entries of the first matrices.
+ * \param [in] strideA  Number of doubles from one matrix A to the next.
+ * \param [in] B        Entries of the second matrices.
+ * \param [in] strideB  Number of doubles from one matrix B to the next.
+ * \param [in] beta     Factor for the original matrices C.  With a zero
+ *                      beta, C is not read, as in BLAS.
+ * \param [in,out] C    Entries of the result matrices, not overlapping.
+ * \param [in] strideC  Number of doubles from one matrix C to the next.
+ * \param [in] count    Number of products.
+ */
+void                sc_dmatrix_multiply_strided (sc_trans_t transa,
+                                                 sc_trans_t transb,
+                                                 sc_bint_t m, sc_bint_t n,
+                                                 sc_bint_t k, double alpha,
+                                                 const double *A,
+                                                 size_t strideA,
+                                                 const double *B,
+                                                 size_t strideB, double beta,
+                                                 double *C, size_t strideC,
+                                                 size_t count);
+
+/** Multiply arrays of matrices of identical shape.
+ * For each i < count, computes \c C[i] := alpha * op (A[i]) * op (B[i]) +
+ * beta * C[i] like \ref sc_dmatrix_multiply, using the kernels of
+ * \ref sc_dmatrix_multiply_strided.  The argument checks are done once
+ * for the batch, except for the shapes in debug mode.
+ * \param [in] transa   Transpose operation for the matrices A.
+ * \param [in] transb   Transpose operation for the matrices B.
+ * \param [in] alpha    Factor for the products.
+ * \param [in] A        Array of count first matrices.
+ * \param [in] B        Array of count second matrices.
+ * \param [in] beta     Factor for the original matrices.
+ * \param [in,out] C    Array of count matrices modified in place.
+ *                      They must not overlap with each other, A or B.
+ * \param [in] count    Number of products.
+ */
+void                sc_dmatrix_multiply_batch (sc_trans_t transa,
+                                               sc_trans_t transb,
+                                               double alpha,
+                                               const sc_dmatrix_t *
+                                               const *A,
+                                               const sc_dmatrix_t *
+                                               const *B, double beta,
+                                               sc_dmatrix_t * const *C,
+                                               size_t count);
+
 /** \brief Left Divide \c A \ \c B.
  * The matrices cannot have 0 rows or columns.
  * Solves  \c A \c C = \c B or \c A' \c C = \c B.
@@ -375,6 +572,108 @@ void                sc_dmatrix_rdivide (sc_trans_t transb,
 void                sc_dmatrix_solve_transpose_inplace
   (sc_dmatrix_t * A, sc_dmatrix_t * B);
 
+/** An LU factorization with partial pivoting of a square matrix.
+ * It is computed once by \ref sc_dmatrix_lu_factor and then applied to any
+ * number of right hand sides without refactoring.
+ */
+typedef struct sc_dmatrix_lu
+{
+  sc_bint_t           n;        /**< Order of the factored matrix. */
+  sc_dmatrix_t       *factors;  /**< LAPACK factors in row-major order. */
+  sc_bint_t          *ipiv;     /**< LAPACK pivot indices, one-based. */
+  int                 factored; /**< True after a successful factorization. */
+}
+sc_dmatrix_lu_t;
+
+/** Create an empty LU factorization for matrices of a given order.
+ * \param [in] n        Order of the square matrices to be factored.
+ * \return              Factorization to be filled by \ref
+ *                      sc_dmatrix_lu_factor.
+ */
+sc_dmatrix_lu_t    *sc_dmatrix_lu_new (sc_bint_t n);
+
+/** Destroy an LU factorization. */
+void                sc_dmatrix_lu_destroy (sc_dmatrix_lu_t * lu);
+
+/** Compute the LU factorization of a square matrix.
+ * The factorization may be recomputed for another matrix of the same order.
+ * \param [in,out] lu   Factorization of matching order, overwritten.
+ * \param [in] A        Square matrix, which is not modified.
+ * \return              0 on success and the LAPACK info otherwise.
+ *                      A positive value indicates a singular matrix,
+ *                      whose factorization must not be applied.
+ */
+int                 sc_dmatrix_lu_factor (sc_dmatrix_lu_t * lu,
+                                          const sc_dmatrix_t * A);
+
+/** Solve with a factored matrix for the columns of another, C := op(A) \ C.
+ * The columns of \b C are the right hand sides, which are all solved
+ * together without a transposed copy of \b C.
+ * \param [in] lu       Successful factorization of A.
+ * \param [in] transa   Whether to solve with A or its transpose.
+ * \param [in,out] C    Matrix with as many rows as A.
+ */
+void                sc_dmatrix_lu_ldivide (const sc_dmatrix_lu_t * lu,
+                                           sc_trans_t transa,
+                                           sc_dmatrix_t * C);
+
+/** Solve with a factored matrix for the rows of another, C := C / op(A).
+ * The rows of \b C are the right hand sides, which are all solved together.
+ * \param [in] lu       Successful factorization of A.
+ * \param [in] transa   Whether to solve with A or its transpose.
+ * \param [in,out] C    Matrix with as many columns as A.
+ */
+void                sc_dmatrix_lu_rdivide (const sc_dmatrix_lu_t * lu,
+                                           sc_trans_t transa,
+                                           sc_dmatrix_t * C);
+
+/** A Cholesky factorization of a symmetric positive definite matrix.
+ * It is used like \ref sc_dmatrix_lu_t with half the factorization work.
+ */
+typedef struct sc_dmatrix_cholesky
+{
+  sc_bint_t           n;        /**< Order of the factored matrix. */
+  sc_dmatrix_t       *factor;   /**< LAPACK factor, lower triangle used. */
+  int                 factored; /**< True after a successful factorization. */
+}
+sc_dmatrix_cholesky_t;
+
+/** Create an empty Cholesky factorization for matrices of a given order.
+ * \param [in] n        Order of the square matrices to be factored.
+ * \return              Factorization to be filled by \ref
+ *                      sc_dmatrix_cholesky_factor.
+ */
+sc_dmatrix_cholesky_t *sc_dmatrix_cholesky_new (sc_bint_t n);
+
+/** Destroy a Cholesky factorization. */
+void                sc_dmatrix_cholesky_destroy (sc_dmatrix_cholesky_t *
+                                                 chol);
+
+/** Compute the Cholesky factorization of a symmetric matrix.
+ * Only the lower triangle of \b A is accessed.
+ * \param [in,out] chol Factorization of matching order, overwritten.
+ * \param [in] A        Symmetric positive definite matrix, not modified.
+ * \return              0 on success and the LAPACK info otherwise.
+ *                      A positive value indicates that \b A is not
+ *                      positive definite and must not be solved with.
+ */
+int                 sc_dmatrix_cholesky_factor (sc_dmatrix_cholesky_t * chol,
+                                                const sc_dmatrix_t * A);
+
+/** Solve with a factored matrix for the columns of another, C := A \ C.
+ * \param [in] chol     Successful factorization of A.
+ * \param [in,out] C    Matrix with as many rows as A.
+ */
+void                sc_dmatrix_cholesky_ldivide (const sc_dmatrix_cholesky_t
+                                                 * chol, sc_dmatrix_t * C);
+
+/** Solve with a factored matrix for the rows of another, C := C / A.
+ * \param [in] chol     Successful factorization of A.
+ * \param [in,out] C    Matrix with as many columns as A.
+ */
+void                sc_dmatrix_cholesky_rdivide (const sc_dmatrix_cholesky_t
+                                                 * chol, sc_dmatrix_t * C);
+
 /** \brief Writes a matrix to an opened stream.
  *
  *   \param dmatrix Pointer to matrix to write
@@ -383,7 +682,37 @@ void                sc_dmatrix_solve_transpose_inplace
 void                sc_dmatrix_write (const sc_dmatrix_t * dmatrix,
                                       FILE * fp);
 
-/** The sc_dmatrix_pool recycles matrices of the same size. */
+/** Write a matrix to a sink in binary form.
+ * The entries are streamed from the matrix memory without a copy in a
+ * record of \ref sc_io_sink_write_record, row by row if they are padded.
+ * \param [in] dmatrix      A valid dmatrix or view.
+ * \param [in,out] sink     The sink object to write to.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_dmatrix_write_binary (const sc_dmatrix_t * dmatrix,
+                                             sc_io_sink_t * sink);
+
+/** Read a matrix written by \ref sc_dmatrix_write_binary.
+ * The entries are read from the source directly into the new matrix.
+ * \param [in,out] source   The source object to read from.
+ * \return                  A new matrix, or NULL on error.
+ */
+sc_dmatrix_t       *sc_dmatrix_read_binary (sc_io_source_t * source);
+
+/** Read a matrix written by \ref sc_dmatrix_write_binary without copying.
+ * The source must support \ref sc_io_source_view, for example an MMAP
+ * source, and the result is a view by \ref sc_dmatrix_new_data on its
+ * read-only contents that must not be modified.  The lifetime of the view
+ * is as documented for \ref sc_io_source_view.
+ * \param [in,out] source   The source object to read from.
+ * \return                  A new matrix view, or NULL on error.
+ */
+sc_dmatrix_t       *sc_dmatrix_read_binary_view (sc_io_source_t * source);
+
+/** The sc_dmatrix_pool recycles matrices of the same size.
+ * It is not thread-safe.  See \ref sc_dmatrix_pool_mt_t for a pool that
+ * serves matrices of any shape to several threads.
+ */
 typedef struct sc_dmatrix_pool
 {
   sc_bint_t           m;        /**< Number of rows of the matrices stored. */
@@ -422,6 +751,106 @@ sc_dmatrix_t       *sc_dmatrix_pool_alloc (sc_dmatrix_pool_t * dmpool);
 void                sc_dmatrix_pool_free (sc_dmatrix_pool_t * dmpool,
                                           sc_dmatrix_t * dm);
 
+/** Smallest size class of an \ref sc_dmatrix_pool_mt_t, log 2 of bytes. */
+#define SC_DMATRIX_POOL_MIN_CLASS 8
+
+/** Number of size classes of an \ref sc_dmatrix_pool_mt_t. */
+#define SC_DMATRIX_POOL_CLASSES 40
+
+/** Number of matrices that a thread cache exchanges with the pool at once. */
+#define SC_DMATRIX_POOL_MAGAZINE 8
+
+/** The sc_dmatrix_pool_mt recycles matrices of any shape between threads.
+ * A matrix is stored in one memory block together with its header and
+ * row pointers.  Blocks come in power-of-two size classes, so a block
+ * freed by a matrix of one shape serves any shape of the same class.
+ * Threads do not access the pool directly but through their own \ref
+ * sc_dmatrix_pool_cache_t, which exchanges blocks with the shared depot
+ * of each class in batches of \ref SC_DMATRIX_POOL_MAGAZINE under a lock.
+ * Fresh blocks may be carved from one contiguous slab for locality.
+ * The entries of every matrix start on a \ref SC_DMATRIX_ALIGN boundary.
+ * Without --enable-pthread, OpenMP locks are used if configured.
+ */
+typedef struct sc_dmatrix_pool_mt sc_dmatrix_pool_mt_t;
+
+/** The per-thread cache of an \ref sc_dmatrix_pool_mt_t.
+ * A cache must only be used by one thread at a time.
+ */
+typedef struct sc_dmatrix_pool_cache
+{
+  sc_dmatrix_pool_mt_t *pool;   /**< The shared pool. */
+  long                elem_count;       /**< Allocations minus frees by
+                                           this cache, may be negative. */
+  int                 num_cached[SC_DMATRIX_POOL_CLASSES]; /**< Counts. */
+  void               *cached[SC_DMATRIX_POOL_CLASSES]
+    [2 * SC_DMATRIX_POOL_MAGAZINE];     /**< Free blocks of each class. */
+}
+sc_dmatrix_pool_cache_t;
+
+/** Create a new thread-safe pool for matrices of any shape.
+ * \param [in] slab_size    If positive, fresh blocks are taken from one
+ *                          contiguous allocation of this many bytes
+ *                          until it is used up.  Zero disables the slab.
+ * \param [in] zero_on_alloc    If true, every matrix is zeroed when it is
+ *                          allocated.  Otherwise its entries are undefined.
+ * \return                  Returns a pool that is ready to use.
+ */
+sc_dmatrix_pool_mt_t *sc_dmatrix_pool_mt_new (size_t slab_size,
+                                              int zero_on_alloc);
+
+/** Destroy a thread-safe matrix pool.
+ * All caches must have been reset and all matrices returned before.
+ * \param [in,out] pool     Its memory and that of all blocks is freed.
+ */
+void                sc_dmatrix_pool_mt_destroy (sc_dmatrix_pool_mt_t *
+                                                pool);
+
+/** Return the number of matrices in use.
+ * The result is exact when all caches have been reset.
+ */
+size_t              sc_dmatrix_pool_mt_elem_count (sc_dmatrix_pool_mt_t *
+                                                   pool);
+
+/** Initialize a thread cache for a thread-safe matrix pool.
+ * This function may be called concurrently by several threads.
+ * \param [out] cache       Cache structure, usually owned by a thread.
+ * \param [in,out] pool     The pool must stay alive until the cache
+ *                          is reset.
+ */
+void                sc_dmatrix_pool_cache_init (sc_dmatrix_pool_cache_t *
+                                                cache,
+                                                sc_dmatrix_pool_mt_t * pool);
+
+/** Return all cached blocks to the pool's depots and unregister the cache.
+ * Matrices allocated through the cache stay valid.
+ * This function may be called concurrently by several threads.
+ */
+void                sc_dmatrix_pool_cache_reset (sc_dmatrix_pool_cache_t *
+                                                 cache);
+
+/** Allocate a matrix of any shape through a thread cache.
+ * The lock of the pool is only taken when the cache has no block of the
+ * matching size class.  The matrix is a view into pool memory: it must
+ * neither be resized nor destroyed, but returned with \ref
+ * sc_dmatrix_pool_cache_free.
+ * \param [in,out] cache    Initialized cache.
+ * \param [in] m            Number of rows.
+ * \param [in] n            Number of columns.
+ * \return                  Matrix with contiguous rows (ld equal to n).
+ */
+sc_dmatrix_t       *sc_dmatrix_pool_cache_alloc (sc_dmatrix_pool_cache_t *
+                                                 cache, sc_bint_t m,
+                                                 sc_bint_t n);
+
+/** Return a matrix to the pool through a thread cache.
+ * The matrix may have been allocated through any cache of the same pool.
+ * \param [in,out] cache    Initialized cache.
+ * \param [in] dm           Matrix from \ref sc_dmatrix_pool_cache_alloc
+ *                          with its original shape.
+ */
+void                sc_dmatrix_pool_cache_free (sc_dmatrix_pool_cache_t *
+                                                cache, sc_dmatrix_t * dm);
+
 /** Multithreaded workspace allocations of multiple blocks. */
 typedef struct sc_darray_work
 {
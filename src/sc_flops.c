@@ -30,6 +30,163 @@
 #include <papi.h>
 #endif
 
+/** Maximum length of an event name including its scale suffix. */
+#define SC_FLOPS_NAME_BYTES 128
+
+static int          sc_flops_configured = 0;
+static int          sc_flops_nevents = 0;
+static char         sc_flops_names[SC_FLOPS_EVENTS][SC_FLOPS_NAME_BYTES];
+
+#ifdef SC_PAPI
+
+static long long    sc_flops_scales[SC_FLOPS_EVENTS];
+static int          sc_flops_eventset = PAPI_NULL;
+static int          sc_flops_fpslot = -1;
+static int          sc_flops_running = 0;
+static long long    sc_flops_usec_real, sc_flops_usec_virt;
+
+/** Add one event to the event set and return true on success. */
+static int
+sc_flops_papi_add (const char *name)
+{
+  char                code_name[SC_FLOPS_NAME_BYTES];
+  int                 code;
+
+  snprintf (code_name, SC_FLOPS_NAME_BYTES, "%s", name);
+  if (PAPI_event_name_to_code (code_name, &code) != PAPI_OK ||
+      PAPI_add_event (sc_flops_eventset, code) != PAPI_OK) {
+    return 0;
+  }
+  return 1;
+}
+
+/** Start the event set on its first use. */
+static void
+sc_flops_papi_start (void)
+{
+  int                 retval;
+
+  if (sc_flops_running) {
+    return;
+  }
+  retval = PAPI_start (sc_flops_eventset);
+  SC_CHECK_ABORT (retval == PAPI_OK, "Papi not happy");
+  sc_flops_usec_real = PAPI_get_real_usec ();
+  sc_flops_usec_virt = PAPI_get_virt_usec ();
+  sc_flops_running = 1;
+}
+
+/** Read the event set; counts are cumulative since its start. */
+static void
+sc_flops_papi_read (float *rtime, float *ptime,
+                    long long *flpops, long long *events)
+{
+  int                 i, retval;
+  long long           values[SC_FLOPS_EVENTS + 1];
+
+  SC_ASSERT (sc_flops_running);
+  retval = PAPI_read (sc_flops_eventset, values);
+  SC_CHECK_ABORT (retval == PAPI_OK, "Papi not happy");
+
+  *rtime = (float) ((PAPI_get_real_usec () - sc_flops_usec_real) * 1.e-6);
+  *ptime = (float) ((PAPI_get_virt_usec () - sc_flops_usec_virt) * 1.e-6);
+  *flpops = sc_flops_fpslot >= 0 ? values[sc_flops_fpslot] : 0;
+  for (i = 0; i < sc_flops_nevents; ++i) {
+    events[i] = values[i] * sc_flops_scales[i];
+  }
+}
+
+#endif /* SC_PAPI */
+
+int
+sc_flops_set_events (const char *events)
+{
+#ifdef SC_PAPI
+  int                 retval;
+  long long           scale;
+  size_t              len;
+  const char         *s, *e;
+  char               *star, name[SC_FLOPS_NAME_BYTES];
+#endif
+
+  SC_CHECK_ABORT (!sc_flops_configured, "Flop events configured already");
+  sc_flops_configured = 1;
+  if (events == NULL || events[0] == '\0') {
+    return 0;
+  }
+
+#ifdef SC_PAPI
+  if (PAPI_is_initialized () == PAPI_NOT_INITED) {
+    retval = PAPI_library_init (PAPI_VER_CURRENT);
+    SC_CHECK_ABORT (retval == PAPI_VER_CURRENT, "Papi not happy");
+  }
+  retval = PAPI_create_eventset (&sc_flops_eventset);
+  SC_CHECK_ABORT (retval == PAPI_OK, "Papi not happy");
+
+  for (s = events; *s != '\0' && sc_flops_nevents < SC_FLOPS_EVENTS;
+       s = *e == ',' ? e + 1 : e) {
+    e = strchr (s, ',');
+    if (e == NULL) {
+      e = s + strlen (s);
+    }
+    len = SC_MIN ((size_t) (e - s), (size_t) SC_FLOPS_NAME_BYTES - 1);
+    if (len == 0) {
+      continue;
+    }
+    memcpy (name, s, len);
+    name[len] = '\0';
+    snprintf (sc_flops_names[sc_flops_nevents], SC_FLOPS_NAME_BYTES,
+              "%s", name);
+
+    /* strip the scale suffix before looking up the event */
+    scale = 1;
+    if ((star = strrchr (name, '*')) != NULL) {
+      *star = '\0';
+      scale = strtoll (star + 1, NULL, 10);
+      if (scale <= 0) {
+        scale = 1;
+      }
+    }
+    if (!sc_flops_papi_add (name)) {
+      SC_GLOBAL_LDEBUGF ("Skipping unsupported flop event %s\n", name);
+      continue;
+    }
+    sc_flops_scales[sc_flops_nevents++] = scale;
+  }
+  if (*s != '\0') {
+    SC_GLOBAL_LDEBUGF ("Ignoring flop events beyond %d\n", SC_FLOPS_EVENTS);
+  }
+
+  /* the flop count goes last so the user events keep their order */
+  if (sc_flops_papi_add ("PAPI_FP_OPS")) {
+    sc_flops_fpslot = sc_flops_nevents;
+  }
+  if (sc_flops_nevents == 0 && sc_flops_fpslot < 0) {
+    retval = PAPI_destroy_eventset (&sc_flops_eventset);
+    SC_CHECK_ABORT (retval == PAPI_OK, "Papi not happy");
+    sc_flops_eventset = PAPI_NULL;
+  }
+#else
+  SC_GLOBAL_LDEBUG ("Flop events require PAPI\n");
+#endif
+
+  return sc_flops_nevents;
+}
+
+int
+sc_flops_num_events (void)
+{
+  return sc_flops_nevents;
+}
+
+const char         *
+sc_flops_event_name (int event)
+{
+  SC_ASSERT (0 <= event && event < sc_flops_nevents);
+
+  return sc_flops_names[event];
+}
+
 void
 sc_flops_papi (float *rtime, float *ptime, long long *flpops, float *mflops)
 {
@@ -50,10 +207,31 @@ sc_flops_start_internal (sc_flopinfo_t * fi, int use_papi)
   float               rtime, ptime, mflops;
   long long           flpops;
 
+  if (use_papi && !sc_flops_configured) {
+    sc_flops_set_events (getenv ("SC_FLOPS_EVENTS"));
+  }
+
   fi->seconds = sc_MPI_Wtime ();
+  fi->num_events = 0;
   if (use_papi) {
-    sc_flops_papi (&rtime, &ptime, &flpops, &mflops);     /* ignore results */
+#ifdef SC_PAPI
+    if (sc_flops_eventset != PAPI_NULL) {
+      sc_flops_papi_start ();
+      fi->num_events = sc_flops_nevents;
+    }
+    else
+#endif
+      sc_flops_papi (&rtime, &ptime, &flpops, &mflops);   /* ignore results */
+  }
+  SC_ASSERT (fi->num_events <= SC_FLOPS_EVENTS);
+  memset (fi->cevents, 0, SC_FLOPS_EVENTS * sizeof (long long));
+  memset (fi->ievents, 0, SC_FLOPS_EVENTS * sizeof (long long));
+#ifdef SC_PAPI
+  if (fi->num_events > 0) {
+    /* count the events from here on */
+    sc_flops_papi_read (&rtime, &ptime, &flpops, fi->cevents);
   }
+#endif
 
   fi->cwtime = 0.;
   fi->crtime = fi->cptime = 0.;
@@ -84,8 +262,25 @@ sc_flops_count (sc_flopinfo_t * fi)
   double              seconds;
   float               rtime = 0., ptime = 0.;
   long long           flpops = 0;
+#ifdef SC_PAPI
+  int                 i;
+  long long           events[SC_FLOPS_EVENTS];
+#endif
 
   seconds = sc_MPI_Wtime ();
+#ifdef SC_PAPI
+  if (fi->use_papi && sc_flops_eventset != PAPI_NULL) {
+    sc_flops_papi_read (&rtime, &ptime, &flpops, events);
+    fi->mflops = rtime > fi->crtime ?
+      (float) ((double) (flpops - fi->cflpops) / 1.e6 /
+               (rtime - fi->crtime)) : 0.;
+    for (i = 0; i < fi->num_events; ++i) {
+      fi->ievents[i] = events[i] - fi->cevents[i];
+      fi->cevents[i] = events[i];
+    }
+  }
+  else
+#endif
   if (fi->use_papi) {
     sc_flops_papi (&rtime, &ptime, &flpops, &fi->mflops);
   }
@@ -132,6 +327,7 @@ sc_flops_shot (sc_flopinfo_t * fi, sc_flopinfo_t * snapshot)
 void
 sc_flops_shotv (sc_flopinfo_t * fi, ...)
 {
+  int                 i;
   sc_flopinfo_t      *snapshot;
   va_list             ap;
 
@@ -151,6 +347,41 @@ sc_flops_shotv (sc_flopinfo_t * fi, ...)
     snapshot->crtime = fi->crtime;
     snapshot->cptime = fi->cptime;
     snapshot->cflpops = fi->cflpops;
+
+    SC_ASSERT (snapshot->num_events == fi->num_events);
+    for (i = 0; i < fi->num_events; ++i) {
+      snapshot->ievents[i] = fi->cevents[i] - snapshot->cevents[i];
+      snapshot->cevents[i] = fi->cevents[i];
+    }
   }
   va_end (ap);
 }
+
+void
+sc_flops_statistics (sc_statistics_t * stats, const char *name,
+                     const sc_flopinfo_t * snapshot)
+{
+  int                 i;
+  char                variable[BUFSIZ];
+
+  if (!sc_statistics_has (stats, name)) {
+    sc_statistics_add_empty (stats, name);
+  }
+  sc_statistics_accumulate (stats, name, snapshot->iwtime);
+
+  for (i = 0; i < snapshot->num_events; ++i) {
+    snprintf (variable, BUFSIZ, "%s:%s", name, sc_flops_names[i]);
+    if (!sc_statistics_has (stats, variable)) {
+      sc_statistics_add_empty_ext (stats, variable, 1);
+    }
+    sc_statistics_accumulate (stats, variable,
+                              (double) snapshot->ievents[i]);
+
+    snprintf (variable, BUFSIZ, "%s:%s/s", name, sc_flops_names[i]);
+    if (!sc_statistics_has (stats, variable)) {
+      sc_statistics_add_empty_ext (stats, variable, 1);
+    }
+    sc_statistics_accumulate (stats, variable, snapshot->iwtime > 0. ?
+                              snapshot->ievents[i] / snapshot->iwtime : 0.);
+  }
+}
@@ -24,10 +24,19 @@
 #ifndef SC_FLOPS_H
 #define SC_FLOPS_H
 
-#include <sc.h>
+#include <sc_statistics.h>
 
 SC_EXTERN_C_BEGIN;
 
+/** Maximum number of extra hardware events counted per sc_flopinfo_t. */
+#define SC_FLOPS_EVENTS 8
+
+/** A suggested event list for memory-bound kernels, see sc_flops_set_events.
+ * Misses in the last level cache are scaled by a typical line size of 64
+ * to approximate the bytes moved from memory. */
+#define SC_FLOPS_EVENTS_MEMORY \
+  "PAPI_L1_DCM,PAPI_L2_DCM,PAPI_L3_TCM*64,PAPI_TLB_DM,PAPI_BR_MSP"
+
 typedef struct sc_flopinfo
 {
   double              seconds;  /* current time from sc_MPI_Wtime */
@@ -47,6 +56,11 @@ typedef struct sc_flopinfo
 
   /* without SC_PAPI only seconds, ?wtime and ?rtime are meaningful */
   int                 use_papi;
+
+  /* hardware events configured by sc_flops_set_events, scaled */
+  int                 num_events;       /* zero without SC_PAPI */
+  long long           cevents[SC_FLOPS_EVENTS]; /* cumulative counts */
+  long long           ievents[SC_FLOPS_EVENTS]; /* interval counts */
 }
 sc_flopinfo_t;
 
@@ -61,6 +75,31 @@ sc_flopinfo_t;
 void                sc_flops_papi (float *rtime, float *ptime,
                                    long long *flpops, float *mflops);
 
+/**
+ * Configure the hardware events counted in addition to the flops.
+ * Must be called before the first sc_flops_start and only once.
+ * If it is not called, sc_flops_start reads the list from the environment
+ * variable SC_FLOPS_EVENTS.  Without SC_PAPI this function does nothing.
+ * Using events replaces the PAPI_flops call by our own event set that
+ * also contains PAPI_FP_OPS if the CPU provides it.
+ *
+ * \param [in] events  Comma separated list of PAPI preset or native event
+ *                     names, at most SC_FLOPS_EVENTS.  A name may carry a
+ *                     suffix "*N" to multiply its counts by N, for example
+ *                     "PAPI_L3_TCM*64" to approximate bytes from memory.
+ *                     Events not supported on this CPU are skipped.
+ * \return             The number of events that are counted.
+ */
+int                 sc_flops_set_events (const char *events);
+
+/** Return the number of hardware events counted by sc_flops_start. */
+int                 sc_flops_num_events (void);
+
+/** Return the name of a configured event including its scale suffix.
+ * \param [in] event   Between 0 and sc_flops_num_events () - 1.
+ */
+const char         *sc_flops_event_name (int event);
+
 /**
  * Prepare sc_flopinfo_t structure and start flop counters.
  * Must only be called once during the program run.
@@ -116,6 +155,21 @@ void                sc_flops_shot (sc_flopinfo_t * fi,
  */
 void                sc_flops_shotv (sc_flopinfo_t * fi, ...);
 
+/**
+ * Accumulate the interval measurements of a snapshot into statistics.
+ * The interval wall time goes into the variable \a name, which is added
+ * if it does not exist.  Each hardware event contributes the variables
+ * "name:event" with the interval count and "name:event/s" with its rate,
+ * which yield per-region bandwidth summaries after sc_statistics_compute.
+ *
+ * \param [in,out] stats   Variables are added as needed.
+ * \param [in] name        Name of the measured region.
+ * \param [in] snapshot    Updated by sc_flops_shot.
+ */
+void                sc_flops_statistics (sc_statistics_t * stats,
+                                         const char *name,
+                                         const sc_flopinfo_t * snapshot);
+
 /**
  * Accumulate sc_flops_snap()/sc_flops_shot() statistics for a function into
  * an (sc_statistics_t *) */
@@ -127,10 +181,10 @@ void                sc_flops_shotv (sc_flopinfo_t * fi, ...);
     sc_flops_snap ((flop), (snap));               \
   } while (0)
 
-#define SC_FUNC_SHOT(stat,flop,snap)                             \
-  do {                                                           \
-    sc_flops_shot ((flop), (snap));                              \
-    sc_statistics_accumulate ((stat), __func__, (snap)->iwtime); \
+#define SC_FUNC_SHOT(stat,flop,snap)                    \
+  do {                                                  \
+    sc_flops_shot ((flop), (snap));                     \
+    sc_flops_statistics ((stat), __func__, (snap));     \
   } while (0)
 
 SC_EXTERN_C_END;
@@ -0,0 +1,559 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_fmatrix.h>
+#include <sc_lapack.h>
+
+static void
+sc_fmatrix_new_e (sc_fmatrix_t * rdm, sc_bint_t m, sc_bint_t n, float *data)
+{
+  sc_bint_t           i;
+
+  SC_ASSERT (m >= 0 && n >= 0);
+  SC_ASSERT (rdm != NULL);
+
+  rdm->e = SC_ALLOC (float *, m + 1);
+  rdm->e[0] = data;
+
+  if (m > 0) {
+    for (i = 1; i < m; ++i)
+      rdm->e[i] = rdm->e[i - 1] + n;
+
+    rdm->e[m] = NULL;           /* safeguard */
+  }
+
+  rdm->m = m;
+  rdm->n = n;
+}
+
+static sc_fmatrix_t *
+sc_fmatrix_new_internal (sc_bint_t m, sc_bint_t n, int init_zero)
+{
+  sc_fmatrix_t       *rdm;
+  float              *data;
+  size_t              size = (size_t) (m * n);
+#ifdef SC_ENABLE_DEBUG
+  float               zero = 0.0f;      /* no const to avoid warning */
+  const float         anan = 0.0f / zero;
+  size_t              zz;
+#endif
+
+  SC_ASSERT (m >= 0 && n >= 0);
+
+  rdm = SC_ALLOC (sc_fmatrix_t, 1);
+
+  if (init_zero) {
+    data = SC_ALLOC_ZERO (float, size);
+  }
+  else {
+    data = SC_ALLOC (float, size);
+#ifdef SC_ENABLE_DEBUG
+    /* In debug mode initialize the memory to NaN. */
+    for (zz = 0; zz < size; ++zz) {
+      data[zz] = anan;
+    }
+#endif
+  }
+
+  sc_fmatrix_new_e (rdm, m, n, data);
+  rdm->view = 0;
+
+  return rdm;
+}
+
+sc_fmatrix_t       *
+sc_fmatrix_new (sc_bint_t m, sc_bint_t n)
+{
+  return sc_fmatrix_new_internal (m, n, 0);
+}
+
+sc_fmatrix_t       *
+sc_fmatrix_new_zero (sc_bint_t m, sc_bint_t n)
+{
+  return sc_fmatrix_new_internal (m, n, 1);
+}
+
+sc_fmatrix_t       *
+sc_fmatrix_new_data (sc_bint_t m, sc_bint_t n, float *data)
+{
+  sc_fmatrix_t       *rdm;
+
+  SC_ASSERT (m >= 0 && n >= 0);
+
+  rdm = SC_ALLOC (sc_fmatrix_t, 1);
+  sc_fmatrix_new_e (rdm, m, n, data);
+  rdm->view = 1;
+
+  return rdm;
+}
+
+sc_fmatrix_t       *
+sc_fmatrix_new_view (sc_bint_t m, sc_bint_t n, sc_fmatrix_t * orig)
+{
+  return sc_fmatrix_new_view_offset (0, m, n, orig);
+}
+
+sc_fmatrix_t       *
+sc_fmatrix_new_view_offset (sc_bint_t o, sc_bint_t m, sc_bint_t n,
+                            sc_fmatrix_t * orig)
+{
+  SC_ASSERT (o >= 0 && m >= 0 && n >= 0);
+  SC_ASSERT ((o + m) * n <= orig->m * orig->n);
+
+  return sc_fmatrix_new_data (m, n, orig->e[0] + o * n);
+}
+
+sc_fmatrix_t       *
+sc_fmatrix_clone (const sc_fmatrix_t * X)
+{
+  sc_fmatrix_t       *clone;
+
+  clone = sc_fmatrix_new (X->m, X->n);
+  sc_fmatrix_copy (X, clone);
+
+  return clone;
+}
+
+void
+sc_fmatrix_reshape (sc_fmatrix_t * fmatrix, sc_bint_t m, sc_bint_t n)
+{
+  float              *data;
+
+  SC_ASSERT (fmatrix->e != NULL);
+  SC_ASSERT (fmatrix->m * fmatrix->n == m * n);
+
+  data = fmatrix->e[0];
+  SC_FREE (fmatrix->e);
+  sc_fmatrix_new_e (fmatrix, m, n, data);
+}
+
+void
+sc_fmatrix_destroy (sc_fmatrix_t * fmatrix)
+{
+  if (!fmatrix->view) {
+    SC_FREE (fmatrix->e[0]);
+  }
+  SC_FREE (fmatrix->e);
+
+  SC_FREE (fmatrix);
+}
+
+int
+sc_fmatrix_is_valid (const sc_fmatrix_t * A)
+{
+  const sc_bint_t     total = A->m * A->n;
+  const float        *data = A->e[0];
+  sc_bint_t           i;
+
+  for (i = 0; i < total; ++i) {
+    if (data[i] != data[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void
+sc_fmatrix_set_zero (sc_fmatrix_t * X)
+{
+  sc_fmatrix_set_value (X, 0.0f);
+}
+
+void
+sc_fmatrix_set_value (sc_fmatrix_t * X, float value)
+{
+  const sc_bint_t     total = X->m * X->n;
+  float              *data = X->e[0];
+  sc_bint_t           i;
+
+  for (i = 0; i < total; ++i) {
+    data[i] = value;
+  }
+}
+
+void
+sc_fmatrix_scale (float alpha, sc_fmatrix_t * X)
+{
+  const sc_bint_t     total = X->m * X->n;
+  float              *data = X->e[0];
+  sc_bint_t           i;
+
+  for (i = 0; i < total; ++i) {
+    data[i] *= alpha;
+  }
+}
+
+void
+sc_fmatrix_shift (float alpha, sc_fmatrix_t * X)
+{
+  const sc_bint_t     total = X->m * X->n;
+  float              *data = X->e[0];
+  sc_bint_t           i;
+
+  for (i = 0; i < total; ++i) {
+    data[i] += alpha;
+  }
+}
+
+void
+sc_fmatrix_add (float alpha, const sc_fmatrix_t * X, sc_fmatrix_t * Y)
+{
+  const sc_bint_t     total = X->m * X->n;
+  const float        *Xdata = X->e[0];
+  float              *Ydata = Y->e[0];
+  sc_bint_t           i;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  for (i = 0; i < total; ++i) {
+    Ydata[i] += alpha * Xdata[i];
+  }
+}
+
+void
+sc_fmatrix_dotmultiply (const sc_fmatrix_t * X, sc_fmatrix_t * Y)
+{
+  const sc_bint_t     total = X->m * X->n;
+  const float        *Xdata = X->e[0];
+  float              *Ydata = Y->e[0];
+  sc_bint_t           i;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  for (i = 0; i < total; ++i) {
+    Ydata[i] *= Xdata[i];
+  }
+}
+
+void
+sc_fmatrix_dotdivide (const sc_fmatrix_t * X, sc_fmatrix_t * Y)
+{
+  const sc_bint_t     total = X->m * X->n;
+  const float        *Xdata = X->e[0];
+  float              *Ydata = Y->e[0];
+  sc_bint_t           i;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  for (i = 0; i < total; ++i) {
+    Ydata[i] /= Xdata[i];
+  }
+}
+
+void
+sc_fmatrix_copy (const sc_fmatrix_t * X, sc_fmatrix_t * Y)
+{
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  if (X != Y && X->m * X->n > 0) {
+    memcpy (Y->e[0], X->e[0], (size_t) (X->m * X->n) * sizeof (float));
+  }
+}
+
+void
+sc_fmatrix_transpose (const sc_fmatrix_t * X, sc_fmatrix_t * Y)
+{
+  sc_bint_t           i, j;
+
+  SC_ASSERT (X->m == Y->n && X->n == Y->m);
+
+  for (i = 0; i < X->m; i++) {
+    for (j = 0; j < X->n; j++) {
+      Y->e[j][i] = X->e[i][j];
+    }
+  }
+}
+
+void
+sc_fmatrix_from_dmatrix (const sc_dmatrix_t * X, sc_fmatrix_t * Y)
+{
+  sc_bint_t           i, j;
+  const double       *Xrow;
+  float              *Yrow;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  /* the rows of X may be padded */
+  for (i = 0; i < X->m; ++i) {
+    Xrow = X->e[i];
+    Yrow = Y->e[i];
+    for (j = 0; j < X->n; ++j) {
+      Yrow[j] = (float) Xrow[j];
+    }
+  }
+}
+
+void
+sc_fmatrix_to_dmatrix (const sc_fmatrix_t * X, sc_dmatrix_t * Y)
+{
+  sc_bint_t           i, j;
+  const float        *Xrow;
+  double             *Yrow;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  for (i = 0; i < X->m; ++i) {
+    Xrow = X->e[i];
+    Yrow = Y->e[i];
+    for (j = 0; j < X->n; ++j) {
+      Yrow[j] = (double) Xrow[j];
+    }
+  }
+}
+
+void
+sc_fmatrix_add_to_dmatrix (double alpha, const sc_fmatrix_t * X,
+                           sc_dmatrix_t * Y)
+{
+  sc_bint_t           i, j;
+  const float        *Xrow;
+  double             *Yrow;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+
+  for (i = 0; i < X->m; ++i) {
+    Xrow = X->e[i];
+    Yrow = Y->e[i];
+    for (j = 0; j < X->n; ++j) {
+      Yrow[j] += alpha * (double) Xrow[j];
+    }
+  }
+}
+
+void
+sc_fmatrix_vector (sc_trans_t transa, sc_trans_t transx, sc_trans_t transy,
+                   float alpha, const sc_fmatrix_t * A,
+                   const sc_fmatrix_t * X, float beta, sc_fmatrix_t * Y)
+{
+  const sc_bint_t     inc = 1;
+
+#ifdef SC_ENABLE_DEBUG
+  sc_bint_t           dimX = (transx == SC_NO_TRANS) ? X->m : X->n;
+  sc_bint_t           dimY = (transy == SC_NO_TRANS) ? Y->m : Y->n;
+  sc_bint_t           dimX1 = (transx == SC_NO_TRANS) ? X->n : X->m;
+  sc_bint_t           dimY1 = (transy == SC_NO_TRANS) ? Y->n : Y->m;
+
+  sc_bint_t           Arows = (transa == SC_NO_TRANS) ? A->m : A->n;
+  sc_bint_t           Acols = (transa == SC_NO_TRANS) ? A->n : A->m;
+#endif
+
+  SC_ASSERT (Acols == dimX && Arows == dimY);
+  SC_ASSERT (dimX1 == 1 && dimY1 == 1);
+
+  if (A->n > 0 && A->m > 0) {
+    SC_BLAS_SGEMV (&sc_antitranschar[transa], &A->n, &A->m, &alpha,
+                   A->e[0], &A->n, X->e[0], &inc, &beta, Y->e[0], &inc);
+  }
+  else if (beta != 1.0f) {
+    sc_fmatrix_scale (beta, Y);
+  }
+}
+
+void
+sc_fmatrix_multiply (sc_trans_t transa, sc_trans_t transb, float alpha,
+                     const sc_fmatrix_t * A, const sc_fmatrix_t * B,
+                     float beta, sc_fmatrix_t * C)
+{
+  sc_bint_t           Acols, Crows, Ccols;
+#ifdef SC_ENABLE_DEBUG
+  sc_bint_t           Arows, Brows, Bcols;
+
+  Arows = (transa == SC_NO_TRANS) ? A->m : A->n;
+  Brows = (transb == SC_NO_TRANS) ? B->m : B->n;
+  Bcols = (transb == SC_NO_TRANS) ? B->n : B->m;
+#endif
+
+  Acols = (transa == SC_NO_TRANS) ? A->n : A->m;
+  Crows = C->m;
+  Ccols = C->n;
+
+  SC_ASSERT (Acols == Brows && Arows == Crows && Bcols == Ccols);
+  SC_ASSERT (transa == SC_NO_TRANS || transa == SC_TRANS);
+  SC_ASSERT (transb == SC_NO_TRANS || transb == SC_TRANS);
+
+  if (Crows > 0 && Ccols > 0) {
+    if (Acols > 0) {
+      SC_BLAS_SGEMM (&sc_transchar[transb], &sc_transchar[transa], &Ccols,
+                     &Crows, &Acols, &alpha, B->e[0], &B->n, A->e[0],
+                     &A->n, &beta, C->e[0], &C->n);
+    }
+    else if (beta != 1.0f) {
+      sc_fmatrix_scale (beta, C);
+    }
+  }
+}
+
+void
+sc_fmatrix_ldivide (sc_trans_t transa, const sc_fmatrix_t * A,
+                    const sc_fmatrix_t * B, sc_fmatrix_t * C)
+{
+  sc_fmatrix_t       *BT;
+  sc_trans_t          invtransa =
+    (transa == SC_NO_TRANS) ? SC_TRANS : SC_NO_TRANS;
+
+  SC_ASSERT (A->m == A->n && B->m == A->m);
+  SC_ASSERT (C->m == B->m && C->n == B->n);
+
+  BT = sc_fmatrix_new (B->n, B->m);
+  sc_fmatrix_transpose (B, BT);
+
+  sc_fmatrix_rdivide (invtransa, BT, A, BT);
+
+  sc_fmatrix_transpose (BT, C);
+
+  sc_fmatrix_destroy (BT);
+}
+
+void
+sc_fmatrix_rdivide (sc_trans_t transb, const sc_fmatrix_t * A,
+                    const sc_fmatrix_t * B, sc_fmatrix_t * C)
+{
+  sc_bint_t           N = B->m, Nrhs = A->m, info = 0;
+  sc_fmatrix_t       *lu;
+  sc_bint_t          *ipiv;
+
+  SC_ASSERT (B->m == B->n);
+  SC_ASSERT (C->m == A->m && C->n == N && A->n == N);
+  SC_ASSERT (N > 0 && Nrhs > 0);
+
+  /* LAPACK sees B transposed and the rows of C as its columns */
+  lu = sc_fmatrix_clone (B);
+  ipiv = SC_ALLOC (sc_bint_t, N);
+  sc_fmatrix_copy (A, C);
+  if (transb == SC_NO_TRANS) {
+    SC_LAPACK_SGESV (&N, &Nrhs, lu->e[0], &N, ipiv, C->e[0], &N, &info);
+    SC_CHECK_ABORT (info == 0, "Lapack routine SGESV failed");
+  }
+  else {
+    SC_LAPACK_SGETRF (&N, &N, lu->e[0], &N, ipiv, &info);
+    SC_CHECK_ABORT (info == 0, "Lapack routine SGETRF failed");
+    SC_LAPACK_SGETRS (&sc_transchar[transb], &N, &Nrhs, lu->e[0], &N,
+                      ipiv, C->e[0], &N, &info);
+    SC_CHECK_ABORT (info == 0, "Lapack routine SGETRS failed");
+  }
+
+  SC_FREE (ipiv);
+  sc_fmatrix_destroy (lu);
+}
+
+/** Return the largest absolute entry of a double matrix. */
+static double
+sc_fmatrix_dmatrix_maxabs (const sc_dmatrix_t * X)
+{
+  sc_bint_t           i, j;
+  double              maxabs = 0.;
+
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      maxabs = SC_MAX (maxabs, fabs (X->e[i][j]));
+    }
+  }
+  return maxabs;
+}
+
+int
+sc_fmatrix_refine_ldivide (const sc_dmatrix_t * A, const sc_dmatrix_t * B,
+                           sc_dmatrix_t * X, int max_iter, double rtol)
+{
+  int                 iter;
+  sc_bint_t           N = A->m, Nrhs = B->n, info = 0;
+  sc_bint_t           i, j, *ipiv;
+  double              bmax;
+  sc_dmatrix_t       *R;
+  sc_fmatrix_t       *lu, *RT;
+
+  SC_ASSERT (A->m == A->n && B->m == N);
+  SC_ASSERT (X->m == B->m && X->n == B->n);
+  SC_ASSERT (max_iter >= 0);
+
+  sc_dmatrix_set_zero (X);
+  if (N == 0 || Nrhs == 0) {
+    return 0;
+  }
+
+  /* factor once in single precision; LAPACK sees A transposed */
+  lu = sc_fmatrix_new (N, N);
+  sc_fmatrix_from_dmatrix (A, lu);
+  ipiv = SC_ALLOC (sc_bint_t, N);
+  SC_LAPACK_SGETRF (&N, &N, lu->e[0], &N, ipiv, &info);
+  if (info != 0) {
+    SC_FREE (ipiv);
+    sc_fmatrix_destroy (lu);
+    return -1;
+  }
+
+  /* the residual is kept in double precision and its columns are
+     solved as the rows of a transposed single precision copy */
+  bmax = sc_fmatrix_dmatrix_maxabs (B);
+  R = sc_dmatrix_clone (B);
+  RT = sc_fmatrix_new (Nrhs, N);
+  for (iter = 0;; ++iter) {
+    if (sc_fmatrix_dmatrix_maxabs (R) <= rtol * bmax) {
+      break;
+    }
+    if (iter == max_iter) {
+      iter = -1;
+      break;
+    }
+    for (i = 0; i < N; ++i) {
+      for (j = 0; j < Nrhs; ++j) {
+        RT->e[j][i] = (float) R->e[i][j];
+      }
+    }
+    SC_LAPACK_SGETRS ("T", &N, &Nrhs, lu->e[0], &N, ipiv, RT->e[0], &N,
+                      &info);
+    SC_CHECK_ABORT (info == 0, "Lapack routine SGETRS failed");
+    for (i = 0; i < N; ++i) {
+      for (j = 0; j < Nrhs; ++j) {
+        X->e[i][j] += (double) RT->e[j][i];
+      }
+    }
+
+    /* R := B - A X */
+    sc_dmatrix_copy (B, R);
+    sc_dmatrix_multiply (SC_NO_TRANS, SC_NO_TRANS, -1., A, X, 1., R);
+  }
+
+  sc_fmatrix_destroy (RT);
+  sc_dmatrix_destroy (R);
+  SC_FREE (ipiv);
+  sc_fmatrix_destroy (lu);
+
+  return iter;
+}
+
+void
+sc_fmatrix_write (const sc_fmatrix_t * fmatrix, FILE * fp)
+{
+  sc_bint_t           i, j, m, n;
+
+  m = fmatrix->m;
+  n = fmatrix->n;
+
+  for (i = 0; i < m; ++i) {
+    for (j = 0; j < n; ++j) {
+      fprintf (fp, " %16.8e", (double) fmatrix->e[i][j]);
+    }
+    fprintf (fp, "\n");
+  }
+}
@@ -0,0 +1,248 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_FMATRIX_H
+#define SC_FMATRIX_H
+
+/** \file sc_fmatrix.h
+ * Routines to create and manipulate small dense matrices of float.
+ * The interface follows \ref sc_dmatrix.h for single precision, which
+ * halves the memory traffic of bandwidth-bound kernels.  Conversions to
+ * and from \ref sc_dmatrix_t support mixed-precision algorithms such as
+ * \ref sc_fmatrix_refine_ldivide.
+ * We use BLAS and LAPACK for more advanced linear algebra computations.
+ */
+
+#include <sc_dmatrix.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** This is the matrix object.  It can have its own storage or be a view.
+ * The rows are stored contiguously, n floats apart.
+ */
+typedef struct sc_fmatrix
+{
+  float             **e;        /**< Array into the rows of the matrix. */
+  sc_bint_t           m;        /**< Number of rows in this matrix. */
+  sc_bint_t           n;        /**< Number of columns in this matrix. */
+  int                 view;     /**< Boolean to indicate this is a view. */
+}
+sc_fmatrix_t;
+
+/** Create a new uninitialized matrix object.
+ * This function aborts on memory allocation errors.
+ * \param [in] m            Number of rows.
+ * \param [in] n            Number of columns.
+ * \return                  A valid fmatrix object with uninitialized entries.
+ */
+sc_fmatrix_t       *sc_fmatrix_new (sc_bint_t m, sc_bint_t n);
+
+/** Create a new matrix object initialized to zero.
+ * \param [in] m            Number of rows.
+ * \param [in] n            Number of columns.
+ * \return                  A valid fmatrix object with zero entries.
+ */
+sc_fmatrix_t       *sc_fmatrix_new_zero (sc_bint_t m, sc_bint_t n);
+
+/** Create a matrix view on an existing data array.
+ * The data array must have been previously allocated and large enough.
+ * The data array must not be deallocated while the view is in use.
+ */
+sc_fmatrix_t       *sc_fmatrix_new_data (sc_bint_t m, sc_bint_t n,
+                                         float *data);
+
+/** Create a matrix view on an existing sc_fmatrix_t.
+ * The original matrix must have greater equal as many elements as the view.
+ * The original matrix must not be destroyed or resized while view is in use.
+ */
+sc_fmatrix_t       *sc_fmatrix_new_view (sc_bint_t m, sc_bint_t n,
+                                         sc_fmatrix_t * orig);
+
+/** Create a matrix view on an existing sc_fmatrix_t.
+ * \param [in] o    Number of rows that the view is offset.
+ *                  Requires (o + m) * n <= orig->m * orig->n.
+ * \param [in] m    Number of rows that the view shall have.
+ * \param [in] n    Number of columns that the view shall have.
+ * \param [in] orig     This valid matrix is viewed.
+ * \return              A newly created mxn view onto \b orig.
+ */
+sc_fmatrix_t       *sc_fmatrix_new_view_offset (sc_bint_t o,
+                                                sc_bint_t m, sc_bint_t n,
+                                                sc_fmatrix_t * orig);
+
+/** Create a new matrix with the same size and entries as another. */
+sc_fmatrix_t       *sc_fmatrix_clone (const sc_fmatrix_t * X);
+
+/** Reshape a matrix to different m and n without changing m * n. */
+void                sc_fmatrix_reshape (sc_fmatrix_t * fmatrix,
+                                        sc_bint_t m, sc_bint_t n);
+
+/** Destroy an fmatrix and all allocated memory. */
+void                sc_fmatrix_destroy (sc_fmatrix_t * fmatrix);
+
+/** Check whether an fmatrix is free of NaN entries.
+ * \return          true if the fmatrix does not contain any NaN entries.
+ */
+int                 sc_fmatrix_is_valid (const sc_fmatrix_t * A);
+
+/** Set a matrix to all zero entries. */
+void                sc_fmatrix_set_zero (sc_fmatrix_t * X);
+
+/** Set all entries of a matrix to one value. */
+void                sc_fmatrix_set_value (sc_fmatrix_t * X, float value);
+
+/** Perform element-wise multiplication with a scalar, X := alpha .* X. */
+void                sc_fmatrix_scale (float alpha, sc_fmatrix_t * X);
+
+/** Perform element-wise addition with a scalar, X := X + alpha. */
+void                sc_fmatrix_shift (float alpha, sc_fmatrix_t * X);
+
+/** Matrix Y = Y + alpha * X. */
+void                sc_fmatrix_add (float alpha, const sc_fmatrix_t * X,
+                                    sc_fmatrix_t * Y);
+
+/** Perform element-wise multiplication, Y := Y .* X. */
+void                sc_fmatrix_dotmultiply (const sc_fmatrix_t * X,
+                                            sc_fmatrix_t * Y);
+
+/** Perform element-wise division, Y := Y ./ X. */
+void                sc_fmatrix_dotdivide (const sc_fmatrix_t * X,
+                                          sc_fmatrix_t * Y);
+
+/** Copy one matrix into another of the same size. */
+void                sc_fmatrix_copy (const sc_fmatrix_t * X,
+                                     sc_fmatrix_t * Y);
+
+/** Copy one matrix transposed into another.
+ * \param [in] X        Matrix taken as a source.
+ * \param [in,out] Y    Matrix of dimensions of \b X transposed.
+ */
+void                sc_fmatrix_transpose (const sc_fmatrix_t * X,
+                                          sc_fmatrix_t * Y);
+
+/** Round a double matrix into a float matrix of the same size.
+ * The source may be padded, as from \ref sc_dmatrix_new_aligned.
+ */
+void                sc_fmatrix_from_dmatrix (const sc_dmatrix_t * X,
+                                             sc_fmatrix_t * Y);
+
+/** Widen a float matrix into a double matrix of the same size. */
+void                sc_fmatrix_to_dmatrix (const sc_fmatrix_t * X,
+                                           sc_dmatrix_t * Y);
+
+/** Add a float matrix to a double matrix in double precision,
+ * Y := Y + alpha * X.  This applies corrections computed in single
+ * precision to a solution kept in double precision.
+ */
+void                sc_fmatrix_add_to_dmatrix (double alpha,
+                                               const sc_fmatrix_t * X,
+                                               sc_dmatrix_t * Y);
+
+/** Perform matrix-vector multiplication Y = alpha * A * X + beta * Y.
+ * \param [in] transa    Transpose operation for matrix A.
+ * \param [in] transx    Transpose operation for matrix X.
+ * \param [in] transy    Transpose operation for matrix Y.
+ * \param [in] A         Matrix.
+ * \param [in] X, Y      Column or row vectors (or one each).
+ */
+void                sc_fmatrix_vector (sc_trans_t transa,
+                                       sc_trans_t transx,
+                                       sc_trans_t transy,
+                                       float alpha, const sc_fmatrix_t * A,
+                                       const sc_fmatrix_t * X, float beta,
+                                       sc_fmatrix_t * Y);
+
+/** Perform matrix-matrix multiplication C = alpha * A * B + beta * C.
+ * \param [in] transa       Transpose operation for matrix A.
+ * \param [in] transb       Transpose operation for matrix B.
+ * \param [in] alpha        Scalar factor to multiply the product.
+ * \param [in] A            Matrix.
+ * \param [in] B            Matrix.
+ * \param [in] beta         Scalar factor for the original C.
+ * \param [in,out] C        Matrix to be updated.
+ */
+void                sc_fmatrix_multiply (sc_trans_t transa,
+                                         sc_trans_t transb, float alpha,
+                                         const sc_fmatrix_t * A,
+                                         const sc_fmatrix_t * B, float beta,
+                                         sc_fmatrix_t * C);
+
+/** \brief Left Divide \c A \ \c B.
+ * The matrices cannot have 0 rows or columns and \c A must be square.
+ * Solves  \c A \c C = \c B or \c A' \c C = \c B.
+ *
+ *   \param transa Use the transpose of \c A
+ *   \param A matrix
+ *   \param B matrix
+ *   \param C matrix
+ */
+void                sc_fmatrix_ldivide (sc_trans_t transa,
+                                        const sc_fmatrix_t * A,
+                                        const sc_fmatrix_t * B,
+                                        sc_fmatrix_t * C);
+
+/** \brief Right Divide \c A / \c B.
+ * The matrices cannot have 0 rows or columns and \c B must be square.
+ * Solves  \c A = \c C \c B or \c A = \c C \c B'.
+ *
+ *   \param transb Use the transpose of \c B
+ *   \param A matrix
+ *   \param B matrix
+ *   \param C matrix
+ */
+void                sc_fmatrix_rdivide (sc_trans_t transb,
+                                        const sc_fmatrix_t * A,
+                                        const sc_fmatrix_t * B,
+                                        sc_fmatrix_t * C);
+
+/** Solve A X = B in double precision by mixed-precision refinement.
+ * The square matrix A is factored once in single precision.  Each step
+ * computes the residual in double precision, solves for a correction
+ * with the single precision factors and adds it to X in double precision.
+ * This converges to double precision accuracy for moderately conditioned
+ * matrices at about the cost of a single precision factorization.
+ * \param [in] A        Square matrix, not modified.
+ * \param [in] B        Right hand sides in its columns.
+ * \param [out] X       Solution of the same size as \b B.
+ * \param [in] max_iter Maximum number of refinement steps.
+ * \param [in] rtol     Stop once the largest residual entry is at most
+ *                      rtol times the largest entry of \b B.
+ * \return              The number of steps taken, or -1 if the factorization
+ *                      failed or the tolerance has not been reached.
+ */
+int                 sc_fmatrix_refine_ldivide (const sc_dmatrix_t * A,
+                                               const sc_dmatrix_t * B,
+                                               sc_dmatrix_t * X,
+                                               int max_iter, double rtol);
+
+/** \brief Writes a matrix to an opened stream.
+ *
+ *   \param fmatrix Pointer to matrix to write
+ *   \param fp      Pointer to file to write to
+ */
+void                sc_fmatrix_write (const sc_fmatrix_t * fmatrix,
+                                      FILE * fp);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_FMATRIX_H */
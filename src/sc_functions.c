@@ -95,51 +95,227 @@ sc_intpowf (double base, int exp)
   return result;
 }
 
+/** Invert a monotone function within a bracket of known values.
+ * \param [in] y_tol    Absolute tolerance of the function value.
+ * \param [in] sign     1. if the function increases, -1. otherwise.
+ * \param [out] y_found If not NULL, the function value at the result.
+ */
+static double
+sc_function1_invert_bracket (sc_function1_t func, void *data,
+                             double x_low, double y_low,
+                             double x_high, double y_high,
+                             double y_target, double y_tol, double sign,
+                             double *y_found)
+{
+  const int           k_max = 100;
+  int                 k, side;
+  double              x, y, g, g_low, g_high;
+
+  /* g is the signed residual that is negative left of the root */
+  g_low = sign * (y_low - y_target);
+  g_high = sign * (y_high - y_target);
+  SC_ASSERT (g_low <= y_tol && -y_tol <= g_high);
+
+  side = 0;
+  for (k = 0;; ++k) {
+    if (g_low >= -y_tol) {
+      x = x_low;
+      y = y_low;
+      break;
+    }
+    if (g_high <= y_tol) {
+      x = x_high;
+      y = y_high;
+      break;
+    }
+    if (k == k_max) {
+      SC_ABORTF ("sc_function1_invert did not converge after %d"
+                 " iterations", k);
+    }
+
+    x = x_low - (x_high - x_low) * g_low / (g_high - g_low);
+    if (x <= x_low || x >= x_high) {
+      /* the bracket cannot be resolved further */
+      x = (x <= x_low) ? x_low : x_high;
+      y = (x <= x_low) ? y_low : y_high;
+      break;
+    }
+
+    y = func (x, data);
+    g = sign * (y - y_target);
+    if (g < -y_tol) {
+      x_low = x;
+      y_low = y;
+      g_low = g;
+      if (side < 0) {
+        /* Illinois: halve the stale end to avoid one-sided stagnation */
+        g_high *= .5;
+      }
+      side = -1;
+    }
+    else if (g > y_tol) {
+      x_high = x;
+      y_high = y;
+      g_high = g;
+      if (side > 0) {
+        g_low *= .5;
+      }
+      side = 1;
+    }
+    else {
+      break;
+    }
+  }
+
+  if (y_found != NULL) {
+    *y_found = y;
+  }
+  return x;
+}
+
 double
 sc_function1_invert (sc_function1_t func, void *data,
                      double x_low, double x_high, double y, double rtol)
 {
-  const int           k_max = 100;
-  int                 k;
-  double              x, sign;
-  double              y_target, y_low, y_high, y_tol;
+  double              y_low, y_high;
 
   SC_ASSERT (x_low < x_high && rtol > 0.);
 
-  y_target = y;
   if (func == NULL)
-    return y_target;
+    return y;
+
+  y_low = func (x_low, data);
+  y_high = func (x_high, data);
+  SC_ASSERT ((y_low <= y && y <= y_high) || (y_high <= y && y <= y_low));
+
+  return sc_function1_invert_bracket
+    (func, data, x_low, y_low, x_high, y_high, y,
+     rtol * fabs (y_high - y_low), (y_low <= y_high) ? 1. : -1., NULL);
+}
+
+void
+sc_function1_invert_batch (sc_function1_t func, void *data,
+                           double x_low, double x_high, size_t n,
+                           const double *y, double *x, double rtol)
+{
+  size_t              i;
+  double              y_low, y_high, y_tol, sign;
+  double              xl, yl, xh, yh, y_prev;
+
+  SC_ASSERT (x_low < x_high && rtol > 0.);
+
+  if (func == NULL) {
+    memcpy (x, y, n * sizeof (double));
+    return;
+  }
+  if (n == 0) {
+    return;
+  }
 
   y_low = func (x_low, data);
   y_high = func (x_high, data);
   y_tol = rtol * fabs (y_high - y_low);
   sign = (y_low <= y_high) ? 1. : -1.;
 
-  SC_ASSERT ((sign > 0. && y_low <= y_target && y_target <= y_high) ||
-             (sign < 0. && y_high <= y_target && y_target <= y_low));
-
-  for (k = 0; k < k_max; ++k) {
-    x = x_low + (x_high - x_low) * (y_target - y_low) / (y_high - y_low);
-    if (x <= x_low) {
-      return x_low;
-    }
-    if (x >= x_high) {
-      return x_high;
+  for (i = 0; i < n; ++i) {
+    xl = x_low;
+    yl = y_low;
+    xh = x_high;
+    yh = y_high;
+    if (i > 0) {
+      /* the previous solution is a sharper end of the bracket */
+      if (sign * (y_prev - y[i]) <= 0.) {
+        xl = x[i - 1];
+        yl = y_prev;
+      }
+      else {
+        xh = x[i - 1];
+        yh = y_prev;
+      }
     }
+    x[i] = sc_function1_invert_bracket (func, data, xl, yl, xh, yh,
+                                        y[i], y_tol, sign, &y_prev);
+  }
+}
 
-    y = func (x, data);
-    if (sign * (y - y_target) < -y_tol) {
-      x_low = x;
-      y_low = y;
+struct sc_function1_inverse
+{
+  sc_function1_t      func;
+  void               *data;
+  int                 num_samples;
+  double              x_low, x_high, dx, sign;
+  double             *ys;       /* sign * function value at samples */
+};
+
+sc_function1_inverse_t *
+sc_function1_inverse_new (sc_function1_t func, void *data,
+                          double x_low, double x_high, int num_samples)
+{
+  int                 i;
+  sc_function1_inverse_t *inv;
+
+  SC_ASSERT (func != NULL);
+  SC_ASSERT (x_low < x_high && num_samples >= 2);
+
+  inv = SC_ALLOC (sc_function1_inverse_t, 1);
+  inv->func = func;
+  inv->data = data;
+  inv->num_samples = num_samples;
+  inv->x_low = x_low;
+  inv->x_high = x_high;
+  inv->dx = (x_high - x_low) / (num_samples - 1);
+  inv->ys = SC_ALLOC (double, num_samples);
+  for (i = 0; i < num_samples; ++i) {
+    inv->ys[i] = func (i == num_samples - 1 ? x_high :
+                       x_low + i * inv->dx, data);
+  }
+
+  /* store increasing values to search them uniformly */
+  inv->sign = (inv->ys[0] <= inv->ys[num_samples - 1]) ? 1. : -1.;
+  for (i = 0; i < num_samples; ++i) {
+    inv->ys[i] *= inv->sign;
+  }
+  return inv;
+}
+
+void
+sc_function1_inverse_destroy (sc_function1_inverse_t * inv)
+{
+  SC_FREE (inv->ys);
+  SC_FREE (inv);
+}
+
+double
+sc_function1_inverse_eval (sc_function1_inverse_t * inv,
+                           double y, double rtol)
+{
+  const int           last = inv->num_samples - 1;
+  int                 lo, hi, mid;
+  double              sy, y_tol;
+
+  SC_ASSERT (rtol > 0.);
+
+  sy = inv->sign * y;
+  y_tol = rtol * (inv->ys[last] - inv->ys[0]);
+  SC_ASSERT (inv->ys[0] - y_tol <= sy && sy <= inv->ys[last] + y_tol);
+
+  /* find the last sample whose value is at most the target */
+  lo = 0;
+  hi = last - 1;
+  while (lo < hi) {
+    mid = (lo + hi + 1) / 2;
+    if (inv->ys[mid] <= sy) {
+      lo = mid;
     }
-    else if (sign * (y - y_target) > y_tol) {
-      x_high = x;
-      y_high = y;
+    else {
+      hi = mid - 1;
     }
-    else
-      return x;
   }
-  SC_ABORTF ("sc_function1_invert did not converge after %d iterations", k);
+
+  return sc_function1_invert_bracket
+    (inv->func, inv->data, inv->x_low + lo * inv->dx, inv->sign * inv->ys[lo],
+     (lo + 1 == last) ? inv->x_high : inv->x_low + (lo + 1) * inv->dx,
+     inv->sign * inv->ys[lo + 1], y, y_tol, inv->sign, NULL);
 }
 
 double
@@ -219,3 +395,155 @@ sc_tensor3 (double x, double y, double z, void *data)
   return meta->f1 (x, y, z, meta->data) *
     meta->f2 (x, y, z, meta->data) * meta->f3 (x, y, z, meta->data);
 }
+
+/** Set an array of values to a constant. */
+static void
+sc_function3_batch_fill (double *out, size_t n, double value)
+{
+  size_t              i;
+
+  for (i = 0; i < n; ++i) {
+    out[i] = value;
+  }
+}
+
+void
+sc_zero3_batch (const double *x, const double *y, const double *z,
+                double *out, size_t n, void *data)
+{
+  sc_function3_batch_fill (out, n, 0.);
+}
+
+void
+sc_one3_batch (const double *x, const double *y, const double *z,
+               double *out, size_t n, void *data)
+{
+  sc_function3_batch_fill (out, n, 1.);
+}
+
+void
+sc_two3_batch (const double *x, const double *y, const double *z,
+               double *out, size_t n, void *data)
+{
+  sc_function3_batch_fill (out, n, 2.);
+}
+
+void
+sc_ten3_batch (const double *x, const double *y, const double *z,
+               double *out, size_t n, void *data)
+{
+  sc_function3_batch_fill (out, n, 10.);
+}
+
+void
+sc_constant3_batch (const double *x, const double *y, const double *z,
+                    double *out, size_t n, void *data)
+{
+  sc_function3_batch_fill (out, n, *(double *) data);
+}
+
+void
+sc_x3_batch (const double *x, const double *y, const double *z,
+             double *out, size_t n, void *data)
+{
+  memcpy (out, x, n * sizeof (double));
+}
+
+void
+sc_y3_batch (const double *x, const double *y, const double *z,
+             double *out, size_t n, void *data)
+{
+  memcpy (out, y, n * sizeof (double));
+}
+
+void
+sc_z3_batch (const double *x, const double *y, const double *z,
+             double *out, size_t n, void *data)
+{
+  memcpy (out, z, n * sizeof (double));
+}
+
+void
+sc_sum3_batch (const double *x, const double *y, const double *z,
+               double *out, size_t n, void *data)
+{
+  sc_function3_batch_meta_t *meta = (sc_function3_batch_meta_t *) data;
+  size_t              b, i, nb;
+  double              work[SC_FUNCTION3_BATCH];
+
+  SC_ASSERT (meta != NULL);
+  meta->f1 (x, y, z, out, n, meta->data);
+  if (meta->f2 == NULL) {
+    for (i = 0; i < n; ++i) {
+      out[i] += meta->parameter2;
+    }
+    return;
+  }
+  for (b = 0; b < n; b += nb) {
+    nb = SC_MIN (n - b, (size_t) SC_FUNCTION3_BATCH);
+    meta->f2 (x + b, y + b, z + b, work, nb, meta->data);
+    for (i = 0; i < nb; ++i) {
+      out[b + i] += work[i];
+    }
+  }
+}
+
+void
+sc_product3_batch (const double *x, const double *y, const double *z,
+                   double *out, size_t n, void *data)
+{
+  sc_function3_batch_meta_t *meta = (sc_function3_batch_meta_t *) data;
+  size_t              b, i, nb;
+  double              work[SC_FUNCTION3_BATCH];
+
+  SC_ASSERT (meta != NULL);
+  meta->f1 (x, y, z, out, n, meta->data);
+  if (meta->f2 == NULL) {
+    for (i = 0; i < n; ++i) {
+      out[i] *= meta->parameter2;
+    }
+    return;
+  }
+  for (b = 0; b < n; b += nb) {
+    nb = SC_MIN (n - b, (size_t) SC_FUNCTION3_BATCH);
+    meta->f2 (x + b, y + b, z + b, work, nb, meta->data);
+    for (i = 0; i < nb; ++i) {
+      out[b + i] *= work[i];
+    }
+  }
+}
+
+void
+sc_tensor3_batch (const double *x, const double *y, const double *z,
+                  double *out, size_t n, void *data)
+{
+  sc_function3_batch_meta_t *meta = (sc_function3_batch_meta_t *) data;
+  size_t              b, i, nb;
+  double              work2[SC_FUNCTION3_BATCH];
+  double              work3[SC_FUNCTION3_BATCH];
+
+  SC_ASSERT (meta != NULL);
+  meta->f1 (x, y, z, out, n, meta->data);
+  for (b = 0; b < n; b += nb) {
+    nb = SC_MIN (n - b, (size_t) SC_FUNCTION3_BATCH);
+    meta->f2 (x + b, y + b, z + b, work2, nb, meta->data);
+    meta->f3 (x + b, y + b, z + b, work3, nb, meta->data);
+    for (i = 0; i < nb; ++i) {
+      out[b + i] *= work2[i] * work3[i];
+    }
+  }
+}
+
+void
+sc_function3_batch_pointwise (const double *x, const double *y,
+                              const double *z, double *out, size_t n,
+                              void *data)
+{
+  sc_function3_meta_t *meta = (sc_function3_meta_t *) data;
+  size_t              i;
+
+  SC_ASSERT (meta != NULL && meta->f1 != NULL);
+  for (i = 0; i < n; ++i) {
+    out[i] = meta->f1 (x[i], y[i], z[i], meta->data);
+  }
+}
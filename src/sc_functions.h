@@ -88,11 +88,66 @@ typedef struct sc_function3_meta
 }
 sc_function3_meta_t;
 
-/* Evaluate the inverse function with regula falsi: x = func^{-1}(y) */
+/** Evaluate the inverse of a monotone function: x = func^{-1}(y).
+ * We use the Illinois variant of regula falsi, which keeps the root
+ * bracketed and converges superlinearly.
+ * \param [in] func     Monotone function, or NULL for the identity.
+ * \param [in] data     Context passed to \a func.
+ * \param [in] x_low, x_high    Bracket of the argument, x_low < x_high.
+ * \param [in] y        Target value between func (x_low) and func (x_high).
+ * \param [in] rtol     Tolerance relative to |func (x_high) - func (x_low)|.
+ * \return              Argument whose value is within tolerance of \a y.
+ */
 double              sc_function1_invert (sc_function1_t func, void *data,
                                          double x_low, double x_high,
                                          double y, double rtol);
 
+/** Evaluate the inverse of a monotone function at many targets.
+ * The end point values are computed once and each solution narrows the
+ * bracket of the next target, which pays off for sorted targets.
+ * The parameters are those of \ref sc_function1_invert.
+ * \param [in] n        Number of targets.
+ * \param [in] y        Array of \a n target values.
+ * \param [out] x       Array of \a n arguments.
+ */
+void                sc_function1_invert_batch (sc_function1_t func,
+                                               void *data, double x_low,
+                                               double x_high, size_t n,
+                                               const double *y, double *x,
+                                               double rtol);
+
+/** Tabulated inverse of a monotone function for repeated inversion. */
+typedef struct sc_function1_inverse sc_function1_inverse_t;
+
+/** Sample a monotone function to accelerate its inversion.
+ * \param [in] func     Monotone function, not NULL.
+ * \param [in] data     Context passed to \a func.  It must remain valid
+ *                      while the table is in use.
+ * \param [in] x_low, x_high    Bracket of the argument, x_low < x_high.
+ * \param [in] num_samples      Number of equidistant samples, >= 2.
+ * \return              Table to be freed by \ref
+ *                      sc_function1_inverse_destroy.
+ */
+sc_function1_inverse_t *sc_function1_inverse_new (sc_function1_t func,
+                                                  void *data, double x_low,
+                                                  double x_high,
+                                                  int num_samples);
+
+/** Free a tabulated inverse. */
+void                sc_function1_inverse_destroy (sc_function1_inverse_t *
+                                                  inv);
+
+/** Evaluate a tabulated inverse.
+ * The table yields a bracket between two samples in which the function
+ * is inverted as in \ref sc_function1_invert.
+ * \param [in] inv      Table created by \ref sc_function1_inverse_new.
+ * \param [in] y        Target value within the range of the function.
+ * \param [in] rtol     Tolerance relative to the range of the function.
+ * \return              Argument whose value is within tolerance of \a y.
+ */
+double              sc_function1_inverse_eval (sc_function1_inverse_t * inv,
+                                               double y, double rtol);
+
 /* Some basic 3D functions */
 double              sc_zero3 (double x, double y, double z, void *data);
 double              sc_one3 (double x, double y, double z, void *data);
@@ -112,6 +167,98 @@ double              sc_sum3 (double x, double y, double z, void *data);
 double              sc_product3 (double x, double y, double z, void *data);
 double              sc_tensor3 (double x, double y, double z, void *data);
 
+/** Number of points that the batch combinators process at a time. */
+#define SC_FUNCTION3_BATCH 256
+
+/** Evaluate a 3D function at many points.
+ * The coordinates are given as separate arrays, such that implementations
+ * may loop over the points without indirect calls and vectorize.
+ * \param [in] x, y, z  Arrays of \a n coordinates each.
+ * \param [out] out     Array of \a n values.  It must not alias the
+ *                      coordinates.
+ * \param [in] n        Number of points.
+ * \param [in] data     Context of the function.
+ */
+typedef void        (*sc_function3_batch_t) (const double *x,
+                                             const double *y,
+                                             const double *z, double *out,
+                                             size_t n, void *data);
+
+/*
+ * this structure is used as data element for the batch meta functions.
+ * for _sum_batch and _product_batch:
+ * f1 needs to be a valid function.
+ * f2 can be a function, then it is used,
+ *    or NULL, in which case parameter2 is used.
+ * for _tensor_batch: f1, f2, f3 need to be valid functions.
+ */
+typedef struct sc_function3_batch_meta
+{
+  sc_function3_batch_t f1;
+  sc_function3_batch_t f2;
+  double              parameter2;
+  sc_function3_batch_t f3;
+  void               *data;
+}
+sc_function3_batch_meta_t;
+
+/* Batch versions of the basic 3D functions */
+void                sc_zero3_batch (const double *x, const double *y,
+                                    const double *z, double *out,
+                                    size_t n, void *data);
+void                sc_one3_batch (const double *x, const double *y,
+                                   const double *z, double *out,
+                                   size_t n, void *data);
+void                sc_two3_batch (const double *x, const double *y,
+                                   const double *z, double *out,
+                                   size_t n, void *data);
+void                sc_ten3_batch (const double *x, const double *y,
+                                   const double *z, double *out,
+                                   size_t n, void *data);
+
+/**
+ * \param data   needs to be *double with the value of the constant.
+ */
+void                sc_constant3_batch (const double *x, const double *y,
+                                        const double *z, double *out,
+                                        size_t n, void *data);
+
+void                sc_x3_batch (const double *x, const double *y,
+                                 const double *z, double *out,
+                                 size_t n, void *data);
+void                sc_y3_batch (const double *x, const double *y,
+                                 const double *z, double *out,
+                                 size_t n, void *data);
+void                sc_z3_batch (const double *x, const double *y,
+                                 const double *z, double *out,
+                                 size_t n, void *data);
+
+/** The batch meta functions take a sc_function3_batch_meta_t as data.
+ * They call each member function once per block of SC_FUNCTION3_BATCH
+ * points and combine the results in loops over the block.
+ */
+void                sc_sum3_batch (const double *x, const double *y,
+                                   const double *z, double *out,
+                                   size_t n, void *data);
+void                sc_product3_batch (const double *x, const double *y,
+                                       const double *z, double *out,
+                                       size_t n, void *data);
+void                sc_tensor3_batch (const double *x, const double *y,
+                                      const double *z, double *out,
+                                      size_t n, void *data);
+
+/** Evaluate a pointwise function in a batch.
+ * This adapter allows to use any sc_function3_t where a batch function is
+ * expected.  It calls the pointwise function once per point.
+ * \param data   needs to be a sc_function3_meta_t whose member f1 is
+ *               called with its member data.
+ */
+void                sc_function3_batch_pointwise (const double *x,
+                                                  const double *y,
+                                                  const double *z,
+                                                  double *out, size_t n,
+                                                  void *data);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_FUNCTIONS_H */
@@ -0,0 +1,533 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_garray.h>
+#if !defined(SC_ENABLE_MPI) && defined(SC_ENABLE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#if defined(SC_ENABLE_MPI) && defined(SC_ENABLE_MPIWINSHARED)
+#define SC_GARRAY_SHARED
+#endif
+
+struct sc_garray
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  size_t              elem_size;
+  size_t             *offsets;  /**< partition of the global indices */
+  char               *base;     /**< block owned by this process */
+  char              **direct;   /**< block of every process if it is
+                                     addressable by memory copies */
+  size_t              cache_entries;
+  size_t             *cache_tags;       /**< global index + 1, 0 if empty */
+  char               *cache_data;
+  long                cache_hits, cache_misses;
+#ifdef SC_ENABLE_MPI
+  MPI_Win             win;      /**< window over all blocks if there
+                                     are other processes */
+#ifdef SC_GARRAY_SHARED
+  MPI_Win             shwin;    /**< node window holding the block */
+#endif
+#endif
+};
+
+typedef enum
+{
+  SC_GARRAY_GET,
+  SC_GARRAY_PUT,
+  SC_GARRAY_ACCUMULATE
+}
+sc_garray_kind_t;
+
+/** One element of a batch: its global index and position in the batch. */
+typedef struct sc_garray_req
+{
+  size_t              gindex;
+  size_t              pos;
+}
+sc_garray_req_t;
+
+#if !defined(SC_ENABLE_MPI) && defined(SC_ENABLE_PTHREAD)
+/* serializes the accumulations of processes emulated by threads */
+static pthread_mutex_t sc_garray_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+sc_garray_t        *
+sc_garray_new (sc_MPI_Comm mpicomm, size_t elem_size, size_t global_count)
+{
+  int                 mpiret;
+  int                 mpisize, q;
+  size_t             *offsets;
+  sc_garray_t        *ga;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  offsets = SC_ALLOC (size_t, mpisize + 1);
+  for (q = 0; q <= mpisize; ++q) {
+    offsets[q] = (global_count / mpisize) * q +
+      SC_MIN ((size_t) q, global_count % mpisize);
+  }
+  ga = sc_garray_new_offsets (mpicomm, elem_size, offsets);
+  SC_FREE (offsets);
+
+  return ga;
+}
+
+sc_garray_t        *
+sc_garray_new_offsets (sc_MPI_Comm mpicomm, size_t elem_size,
+                       const size_t *offsets)
+{
+  int                 mpiret;
+  int                 q;
+  size_t              bytes;
+  sc_garray_t        *ga;
+#ifdef SC_GARRAY_SHARED
+  int                 disp_unit;
+  MPI_Aint            qsize;
+  sc_MPI_Comm         intranode, internode;
+  const int          *locations;
+#endif
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (offsets != NULL && offsets[0] == 0);
+
+  ga = SC_ALLOC_ZERO (sc_garray_t, 1);
+  ga->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &ga->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &ga->mpirank);
+  SC_CHECK_MPI (mpiret);
+  ga->elem_size = elem_size;
+  ga->offsets = SC_ALLOC (size_t, ga->mpisize + 1);
+  memcpy (ga->offsets, offsets, (ga->mpisize + 1) * sizeof (size_t));
+#ifdef SC_ENABLE_DEBUG
+  for (q = 0; q < ga->mpisize; ++q) {
+    SC_ASSERT (offsets[q] <= offsets[q + 1]);
+  }
+#endif
+  bytes = (offsets[ga->mpirank + 1] - offsets[ga->mpirank]) * elem_size;
+  ga->direct = SC_ALLOC_ZERO (char *, ga->mpisize);
+
+#ifdef SC_ENABLE_MPI
+  SC_CHECK_ABORT (elem_size <= (size_t) INT_MAX, "Element size too large");
+#ifdef SC_GARRAY_SHARED
+  /* blocks on the same node are allocated in one shared window */
+  ga->shwin = MPI_WIN_NULL;
+  sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+  locations = sc_mpi_comm_get_node_locations (mpicomm);
+  if (intranode != sc_MPI_COMM_NULL && locations != NULL) {
+    mpiret = MPI_Win_allocate_shared ((MPI_Aint) bytes, (int) elem_size,
+                                      MPI_INFO_NULL, intranode, &ga->base,
+                                      &ga->shwin);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Win_lock_all (MPI_MODE_NOCHECK, ga->shwin);
+    SC_CHECK_MPI (mpiret);
+    for (q = 0; q < ga->mpisize; ++q) {
+      if (locations[2 * q] == locations[2 * ga->mpirank]) {
+        mpiret = MPI_Win_shared_query (ga->shwin, locations[2 * q + 1],
+                                       &qsize, &disp_unit, &ga->direct[q]);
+        SC_CHECK_MPI (mpiret);
+      }
+    }
+  }
+  else
+#endif
+  {
+    mpiret = MPI_Alloc_mem ((MPI_Aint) SC_MAX (bytes, 1), MPI_INFO_NULL,
+                            &ga->base);
+    SC_CHECK_MPI (mpiret);
+    ga->direct[ga->mpirank] = ga->base;
+  }
+  ga->win = MPI_WIN_NULL;
+  if (ga->mpisize > 1) {
+    mpiret = MPI_Win_create (ga->base, (MPI_Aint) bytes, (int) elem_size,
+                             MPI_INFO_NULL, mpicomm, &ga->win);
+    SC_CHECK_MPI (mpiret);
+  }
+#else
+  /* all processes share one address space */
+  ga->base = SC_ALLOC (char, SC_MAX (bytes, 1));
+  mpiret = sc_MPI_Allgather (&ga->base, (int) sizeof (char *), sc_MPI_BYTE,
+                             ga->direct, (int) sizeof (char *), sc_MPI_BYTE,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+#endif
+
+  return ga;
+}
+
+void
+sc_garray_destroy (sc_garray_t * ga)
+{
+  int                 mpiret;
+
+#ifdef SC_ENABLE_MPI
+  if (ga->win != MPI_WIN_NULL) {
+    mpiret = MPI_Win_free (&ga->win);
+    SC_CHECK_MPI (mpiret);
+  }
+#ifdef SC_GARRAY_SHARED
+  if (ga->shwin != MPI_WIN_NULL) {
+    mpiret = MPI_Win_unlock_all (ga->shwin);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Win_free (&ga->shwin);
+    SC_CHECK_MPI (mpiret);
+  }
+  else
+#endif
+  {
+    mpiret = MPI_Free_mem (ga->base);
+    SC_CHECK_MPI (mpiret);
+  }
+#else
+  /* other processes may still read this block */
+  mpiret = sc_MPI_Barrier (ga->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (ga->base);
+#endif
+
+  SC_FREE (ga->cache_tags);
+  SC_FREE (ga->cache_data);
+  SC_FREE (ga->direct);
+  SC_FREE (ga->offsets);
+  SC_FREE (ga);
+}
+
+void               *
+sc_garray_local (sc_garray_t * ga, size_t *local_count)
+{
+  if (local_count != NULL) {
+    *local_count =
+      ga->offsets[ga->mpirank + 1] - ga->offsets[ga->mpirank];
+  }
+  return ga->base;
+}
+
+const size_t       *
+sc_garray_offsets (sc_garray_t * ga)
+{
+  return ga->offsets;
+}
+
+int
+sc_garray_owner (sc_garray_t * ga, size_t gindex)
+{
+  int                 lo, hi, mid;
+
+  SC_ASSERT (gindex < ga->offsets[ga->mpisize]);
+
+  /* the last process whose offset does not exceed the index */
+  lo = 0;
+  hi = ga->mpisize - 1;
+  while (lo < hi) {
+    mid = lo + (hi - lo + 1) / 2;
+    if (ga->offsets[mid] <= gindex) {
+      lo = mid;
+    }
+    else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+static int
+sc_garray_req_compare (const void *v1, const void *v2)
+{
+  const sc_garray_req_t *r1 = (const sc_garray_req_t *) v1;
+  const sc_garray_req_t *r2 = (const sc_garray_req_t *) v2;
+
+  if (r1->gindex != r2->gindex) {
+    return r1->gindex < r2->gindex ? -1 : 1;
+  }
+  return r1->pos < r2->pos ? -1 : r1->pos > r2->pos;
+}
+
+/** Return the length of the run of consecutive indices starting at \a reqs.
+ * The run is limited to \a max elements.
+ */
+static size_t
+sc_garray_run (const sc_garray_req_t * reqs, size_t n, size_t max)
+{
+  size_t              r;
+
+  for (r = 1; r < n && r < max; ++r) {
+    if (reqs[r].gindex != reqs[0].gindex + r) {
+      break;
+    }
+  }
+  return r;
+}
+
+/** Access the requests to a block that is addressable by memory copies. */
+static void
+sc_garray_access_direct (sc_garray_t * ga, sc_garray_kind_t kind, int q,
+                         const sc_garray_req_t * reqs, size_t n,
+                         char *stage, sc_MPI_Datatype type, sc_MPI_Op op)
+{
+  const size_t        es = ga->elem_size;
+  int                 mpiret;
+  size_t              j, r, count = 0;
+  char               *target;
+
+  if (kind == SC_GARRAY_ACCUMULATE) {
+    count = es / sc_mpi_sizeof (type);
+#if !defined(SC_ENABLE_MPI) && defined(SC_ENABLE_PTHREAD)
+    pthread_mutex_lock (&sc_garray_mutex);
+#endif
+  }
+
+  for (j = 0; j < n; j += r) {
+    r = sc_garray_run (reqs + j, n - j, n - j);
+    target = ga->direct[q] + (reqs[j].gindex - ga->offsets[q]) * es;
+    if (kind == SC_GARRAY_GET) {
+      memcpy (stage + j * es, target, r * es);
+    }
+    else if (kind == SC_GARRAY_PUT) {
+      memcpy (target, stage + j * es, r * es);
+    }
+    else {
+      SC_ASSERT (r * count <= (size_t) INT_MAX);
+      mpiret = sc_MPI_Reduce_local (stage + j * es, target, (int) (r * count),
+                                    type, op);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+
+#if !defined(SC_ENABLE_MPI) && defined(SC_ENABLE_PTHREAD)
+  if (kind == SC_GARRAY_ACCUMULATE) {
+    pthread_mutex_unlock (&sc_garray_mutex);
+  }
+#endif
+}
+
+#ifdef SC_ENABLE_MPI
+
+/** Access the requests to a block by one passive target epoch. */
+static void
+sc_garray_access_remote (sc_garray_t * ga, sc_garray_kind_t kind, int q,
+                         const sc_garray_req_t * reqs, size_t n,
+                         char *stage, sc_MPI_Datatype type, sc_MPI_Op op)
+{
+  const size_t        es = ga->elem_size;
+  int                 mpiret;
+  int                 bytes, count;
+  size_t              j, r, tsize, slot;
+  MPI_Aint            disp;
+
+  tsize = kind == SC_GARRAY_ACCUMULATE ? sc_mpi_sizeof (type) : 1;
+  mpiret = MPI_Win_lock (MPI_LOCK_SHARED, q, 0, ga->win);
+  SC_CHECK_MPI (mpiret);
+  for (j = 0; j < n; j += r) {
+    /* one transfer per run, each run fits into an int count of bytes */
+    r = sc_garray_run (reqs + j, n - j, (size_t) INT_MAX / es);
+    disp = (MPI_Aint) (reqs[j].gindex - ga->offsets[q]);
+    bytes = (int) (r * es);
+    if (kind == SC_GARRAY_GET) {
+      mpiret = MPI_Get (stage + j * es, bytes, MPI_BYTE, q, disp, bytes,
+                        MPI_BYTE, ga->win);
+    }
+    else if (kind == SC_GARRAY_PUT) {
+      mpiret = MPI_Put (stage + j * es, bytes, MPI_BYTE, q, disp, bytes,
+                        MPI_BYTE, ga->win);
+    }
+    else {
+      count = bytes / (int) tsize;
+      mpiret = MPI_Accumulate (stage + j * es, count, type, q, disp, count,
+                               type, op, ga->win);
+    }
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Win_unlock (q, ga->win);
+  SC_CHECK_MPI (mpiret);
+
+  /* values read or written by this process are cached */
+  if (kind == SC_GARRAY_GET) {
+    ga->cache_misses += (long) n;
+  }
+  if (ga->cache_entries > 0) {
+    for (j = 0; j < n; ++j) {
+      slot = reqs[j].gindex % ga->cache_entries;
+      if (kind == SC_GARRAY_ACCUMULATE) {
+        if (ga->cache_tags[slot] == reqs[j].gindex + 1) {
+          ga->cache_tags[slot] = 0;
+        }
+      }
+      else {
+        ga->cache_tags[slot] = reqs[j].gindex + 1;
+        memcpy (ga->cache_data + slot * es, stage + j * es, es);
+      }
+    }
+  }
+}
+
+#endif
+
+static void
+sc_garray_access (sc_garray_t * ga, sc_garray_kind_t kind, size_t n,
+                  const size_t *gindices, char *buf,
+                  sc_MPI_Datatype type, sc_MPI_Op op)
+{
+  const size_t        es = ga->elem_size;
+  int                 q;
+  size_t              i, k, kend, m, slot;
+  char               *stage;
+  sc_garray_req_t    *reqs;
+
+  if (n == 0) {
+    return;
+  }
+
+  /* serve reads from the cache and sort the rest by global index */
+  reqs = SC_ALLOC (sc_garray_req_t, n);
+  for (m = 0, i = 0; i < n; ++i) {
+    SC_ASSERT (gindices[i] < ga->offsets[ga->mpisize]);
+    if (kind == SC_GARRAY_GET && ga->cache_entries > 0) {
+      slot = gindices[i] % ga->cache_entries;
+      if (ga->cache_tags[slot] == gindices[i] + 1) {
+        memcpy (buf + i * es, ga->cache_data + slot * es, es);
+        ++ga->cache_hits;
+        continue;
+      }
+    }
+    reqs[m].gindex = gindices[i];
+    reqs[m].pos = i;
+    ++m;
+  }
+  qsort (reqs, m, sizeof (sc_garray_req_t), sc_garray_req_compare);
+
+  /* the elements are staged in the sorted order */
+  stage = SC_ALLOC (char, m * es);
+  if (kind != SC_GARRAY_GET) {
+    for (k = 0; k < m; ++k) {
+      memcpy (stage + k * es, buf + reqs[k].pos * es, es);
+    }
+  }
+
+  /* the requests to one owner are contiguous after sorting */
+  for (k = 0; k < m; k = kend) {
+    q = sc_garray_owner (ga, reqs[k].gindex);
+    for (kend = k + 1; kend < m; ++kend) {
+      if (reqs[kend].gindex >= ga->offsets[q + 1]) {
+        break;
+      }
+    }
+#ifdef SC_ENABLE_MPI
+    /* accumulations are atomic only when done through the window */
+    if (ga->direct[q] == NULL ||
+        (kind == SC_GARRAY_ACCUMULATE && ga->win != MPI_WIN_NULL)) {
+      sc_garray_access_remote (ga, kind, q, reqs + k, kend - k,
+                               stage + k * es, type, op);
+      continue;
+    }
+#endif
+    sc_garray_access_direct (ga, kind, q, reqs + k, kend - k,
+                             stage + k * es, type, op);
+  }
+
+  if (kind == SC_GARRAY_GET) {
+    for (k = 0; k < m; ++k) {
+      memcpy (buf + reqs[k].pos * es, stage + k * es, es);
+    }
+  }
+  SC_FREE (stage);
+  SC_FREE (reqs);
+}
+
+void
+sc_garray_get (sc_garray_t * ga, size_t n, const size_t *gindices,
+               void *out)
+{
+  sc_garray_access (ga, SC_GARRAY_GET, n, gindices, (char *) out,
+                    sc_MPI_BYTE, sc_MPI_REPLACE);
+}
+
+void
+sc_garray_put (sc_garray_t * ga, size_t n, const size_t *gindices,
+               const void *in)
+{
+  sc_garray_access (ga, SC_GARRAY_PUT, n, gindices, (char *) in,
+                    sc_MPI_BYTE, sc_MPI_REPLACE);
+}
+
+void
+sc_garray_accumulate (sc_garray_t * ga, size_t n, const size_t *gindices,
+                      const void *in, sc_MPI_Datatype type, sc_MPI_Op op)
+{
+  SC_ASSERT (ga->elem_size % sc_mpi_sizeof (type) == 0);
+
+  sc_garray_access (ga, SC_GARRAY_ACCUMULATE, n, gindices, (char *) in,
+                    type, op);
+}
+
+void
+sc_garray_sync (sc_garray_t * ga)
+{
+  int                 mpiret;
+
+#ifdef SC_GARRAY_SHARED
+  if (ga->shwin != MPI_WIN_NULL) {
+    mpiret = MPI_Win_sync (ga->shwin);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+  mpiret = sc_MPI_Barrier (ga->mpicomm);
+  SC_CHECK_MPI (mpiret);
+#ifdef SC_GARRAY_SHARED
+  if (ga->shwin != MPI_WIN_NULL) {
+    mpiret = MPI_Win_sync (ga->shwin);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+
+  if (ga->cache_entries > 0) {
+    memset (ga->cache_tags, 0, ga->cache_entries * sizeof (size_t));
+  }
+}
+
+void
+sc_garray_set_cache (sc_garray_t * ga, size_t num_entries)
+{
+  SC_FREE (ga->cache_tags);
+  SC_FREE (ga->cache_data);
+  ga->cache_entries = num_entries;
+  ga->cache_tags = NULL;
+  ga->cache_data = NULL;
+  if (num_entries > 0) {
+    ga->cache_tags = SC_ALLOC_ZERO (size_t, num_entries);
+    ga->cache_data = SC_ALLOC (char, num_entries * ga->elem_size);
+  }
+}
+
+void
+sc_garray_get_cache_counts (sc_garray_t * ga, long *hits, long *misses)
+{
+  if (hits != NULL) {
+    *hits = ga->cache_hits;
+  }
+  if (misses != NULL) {
+    *misses = ga->cache_misses;
+  }
+}
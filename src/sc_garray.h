@@ -0,0 +1,182 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_garray.h
+ *
+ * An array of fixed-size elements distributed over the processes of a
+ * communicator and addressed by global index.
+ *
+ * Every process owns one contiguous block of the global index range,
+ * either from a balanced block partition or from offsets chosen by the
+ * caller.  Any process may read, write or accumulate into elements of any
+ * other process by one-sided access without the cooperation of the owner.
+ * The requests of a call are sorted by index, such that every owner is
+ * accessed in one epoch with one transfer per run of consecutive indices.
+ *
+ * Blocks of processes on the same shared-memory node are accessed by
+ * plain memory copies when the library is configured with MPI-3 shared
+ * windows and node communicators are attached to the communicator (see
+ * \ref sc_mpi_comm_attach_node_comms).  Without MPI all blocks live in the
+ * same address space and are accessed directly.  Remote elements that are
+ * read may be kept in a per-process cache, see \ref sc_garray_set_cache.
+ *
+ * Updates by \ref sc_garray_put and \ref sc_garray_accumulate are
+ * guaranteed to be visible to all processes after the next collective
+ * call to \ref sc_garray_sync.  Between two synchronizations a process
+ * must not write an element that another process reads or writes,
+ * except that concurrent accumulations with the same operation are
+ * allowed.
+ */
+
+#ifndef SC_GARRAY_H
+#define SC_GARRAY_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque distributed global-index array. */
+typedef struct sc_garray sc_garray_t;
+
+/** Create a global array with a balanced block partition.
+ * This function is collective.  The elements are uninitialized.
+ * \param [in] mpicomm      The communicator of the array.
+ * \param [in] elem_size    Size of one element in bytes, positive.
+ * \param [in] global_count Number of elements over all processes.
+ *                          Must be the same on every process.
+ * \return                  The new array.
+ */
+sc_garray_t        *sc_garray_new (sc_MPI_Comm mpicomm, size_t elem_size,
+                                   size_t global_count);
+
+/** Create a global array with the partition given by the caller.
+ * This function is collective.  The elements are uninitialized.
+ * \param [in] mpicomm      The communicator of the array.
+ * \param [in] elem_size    Size of one element in bytes, positive.
+ * \param [in] offsets      Array of size + 1 nondecreasing offsets, the
+ *                          same on every process, such as computed by
+ *                          \ref sc_shmem_prefix.  Process p owns the
+ *                          indices offsets[p] to offsets[p + 1] - 1.
+ *                          The array is copied.
+ * \return                  The new array.
+ */
+sc_garray_t        *sc_garray_new_offsets (sc_MPI_Comm mpicomm,
+                                           size_t elem_size,
+                                           const size_t *offsets);
+
+/** Destroy a global array.  This function is collective.
+ * \param [in] ga           The array is invalid afterwards.
+ */
+void                sc_garray_destroy (sc_garray_t * ga);
+
+/** Return the block of elements owned by this process.
+ * It may be read and written directly subject to the rules for
+ * synchronization given in the file documentation.
+ * \param [in] ga           A valid global array.
+ * \param [out] local_count If not NULL, number of elements in the block.
+ * \return                  Pointer to the first element of the block.
+ */
+void               *sc_garray_local (sc_garray_t * ga, size_t *local_count);
+
+/** Return the partition of a global array.
+ * \param [in] ga           A valid global array.
+ * \return                  Array of size + 1 offsets owned by \a ga.
+ */
+const size_t       *sc_garray_offsets (sc_garray_t * ga);
+
+/** Return the process that owns an element.
+ * \param [in] ga           A valid global array.
+ * \param [in] gindex       Global index less than the global count.
+ * \return                  The owner rank, found by binary search.
+ */
+int                 sc_garray_owner (sc_garray_t * ga, size_t gindex);
+
+/** Read a batch of elements.  This function is not collective.
+ * \param [in] ga           A valid global array.
+ * \param [in] n            Number of elements to read.
+ * \param [in] gindices     Array of \a n global indices in any order.
+ *                          Repeated indices are allowed.
+ * \param [out] out         Array of \a n elements that receives the
+ *                          values in the order of \a gindices.
+ */
+void                sc_garray_get (sc_garray_t * ga, size_t n,
+                                   const size_t *gindices, void *out);
+
+/** Write a batch of elements.  This function is not collective.
+ * \param [in] ga           A valid global array.
+ * \param [in] n            Number of elements to write.
+ * \param [in] gindices     Array of \a n distinct global indices.
+ * \param [in] in           Array of \a n elements to write.
+ */
+void                sc_garray_put (sc_garray_t * ga, size_t n,
+                                   const size_t *gindices, const void *in);
+
+/** Combine a batch of values into elements by a reduction operation.
+ * This function is not collective.  The update of every element is
+ * atomic with respect to other accumulations with the same operation.
+ * \param [in] ga           A valid global array.
+ * \param [in] n            Number of elements to update.
+ * \param [in] gindices     Array of \a n global indices.
+ *                          Repeated indices are allowed.
+ * \param [in] in           Array of \a n elements to combine.
+ * \param [in] type         Predefined datatype of the entries of an
+ *                          element, whose size divides the element size.
+ * \param [in] op           Predefined reduction operation, such as
+ *                          sc_MPI_SUM or sc_MPI_MAX.
+ */
+void                sc_garray_accumulate (sc_garray_t * ga, size_t n,
+                                          const size_t *gindices,
+                                          const void *in,
+                                          sc_MPI_Datatype type,
+                                          sc_MPI_Op op);
+
+/** Make all previous updates visible to all processes.
+ * This function is collective.  It empties the cache of remote elements.
+ * \param [in] ga           A valid global array.
+ */
+void                sc_garray_sync (sc_garray_t * ga);
+
+/** Set the size of the cache of remote elements read by this process.
+ * The cache is direct mapped by global index.  It holds the values read
+ * since the last \ref sc_garray_sync and the values put by this process.
+ * Elements of processes that are accessed directly are never cached.
+ * This function is not collective and empties the cache.
+ * \param [in] ga           A valid global array.
+ * \param [in] num_entries  Number of cached elements, 0 disables the cache,
+ *                          which is the default.
+ */
+void                sc_garray_set_cache (sc_garray_t * ga,
+                                         size_t num_entries);
+
+/** Return the counters of the cache of remote elements.
+ * \param [in] ga           A valid global array.
+ * \param [out] hits        If not NULL, number of reads served by the cache.
+ * \param [out] misses      If not NULL, number of cacheable reads that
+ *                          were transferred from their owner.
+ */
+void                sc_garray_get_cache_counts (sc_garray_t * ga,
+                                                long *hits, long *misses);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_GARRAY_H */
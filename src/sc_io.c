@@ -22,10 +22,1701 @@
 */
 
 #include <sc_io.h>
+#include <sc_shmem.h>
 #include <libb64.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef SC_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SC_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef SC_HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+#if defined SC_HAVE_SYS_MMAN_H && defined SC_HAVE_MMAP && \
+    defined SC_HAVE_FCNTL_H && defined SC_HAVE_UNISTD_H && \
+    defined SC_HAVE_SYS_STAT_H
+#define SC_IO_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined SC_HAVE_SYS_UIO_H && defined SC_HAVE_WRITEV && \
+    defined SC_HAVE_UNISTD_H
+#define SC_IO_WRITEV
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef SC_HAVE_PREADV
+#define SC_IO_PREADV
+#endif
+#endif
+
+/** Maximum number of pieces passed to one vectored system call. */
+#define SC_IO_VEC_BATCH 64
+
+#if defined __GNUC__ && defined __x86_64__
+#define SC_IO_CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined __ARM_FEATURE_CRC32
+#define SC_IO_CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+/** Length of the checksum trailer: four magic bytes and the CRC32C. */
+#define SC_IO_CHECKSUM_BYTES 8
+
+/** Magic bytes that begin a checksum trailer. */
+static const char   sc_io_checksum_magic[4] = { 'C', 'R', 'C', 'C' };
+
+/** Checksum states of a sink or a source. */
+enum
+{
+  SC_IO_CHECKSUM_OFF,   /**< no checksum is kept */
+  SC_IO_CHECKSUM_RUNNING,       /**< data is added to the checksum */
+  SC_IO_CHECKSUM_SEALED /**< trailer written or verified, no data since */
+};
+
+/** Size of the blocks of encoded data staged in a codec. */
+#define SC_IO_CODEC_BLOCK (1 << 16)
+
+/** State of a compressed encoding in a sink or a source. */
+typedef struct sc_io_codec
+{
+  sc_io_encode_t      encode;
+  int                 is_sink;
+  int                 in_frame; /**< a frame is begun and not ended */
+  int                 begun;    /**< an LZ4 frame header is written */
+  char               *buf;      /**< encoded data block */
+  size_t              buf_size;
+  size_t              buf_pos, buf_len;     /**< unread input of a source */
+#ifdef SC_HAVE_ZLIB
+  z_stream            zs;
+#endif
+#ifdef SC_HAVE_ZSTD
+  ZSTD_CStream       *zcs;
+  ZSTD_DStream       *zds;
+#endif
+#ifdef SC_HAVE_LZ4
+  LZ4F_cctx          *lcc;
+  LZ4F_dctx          *ldc;
+#endif
+}
+sc_io_codec_t;
+
+/** Table of the reflected CRC32C polynomial 0x82f63b78 for each byte. */
+static const uint32_t sc_io_crc32c_table[256] = {
+  0x00000000U, 0xf26b8303U, 0xe13b70f7U, 0x1350f3f4U,
+  0xc79a971fU, 0x35f1141cU, 0x26a1e7e8U, 0xd4ca64ebU,
+  0x8ad958cfU, 0x78b2dbccU, 0x6be22838U, 0x9989ab3bU,
+  0x4d43cfd0U, 0xbf284cd3U, 0xac78bf27U, 0x5e133c24U,
+  0x105ec76fU, 0xe235446cU, 0xf165b798U, 0x030e349bU,
+  0xd7c45070U, 0x25afd373U, 0x36ff2087U, 0xc494a384U,
+  0x9a879fa0U, 0x68ec1ca3U, 0x7bbcef57U, 0x89d76c54U,
+  0x5d1d08bfU, 0xaf768bbcU, 0xbc267848U, 0x4e4dfb4bU,
+  0x20bd8edeU, 0xd2d60dddU, 0xc186fe29U, 0x33ed7d2aU,
+  0xe72719c1U, 0x154c9ac2U, 0x061c6936U, 0xf477ea35U,
+  0xaa64d611U, 0x580f5512U, 0x4b5fa6e6U, 0xb93425e5U,
+  0x6dfe410eU, 0x9f95c20dU, 0x8cc531f9U, 0x7eaeb2faU,
+  0x30e349b1U, 0xc288cab2U, 0xd1d83946U, 0x23b3ba45U,
+  0xf779deaeU, 0x05125dadU, 0x1642ae59U, 0xe4292d5aU,
+  0xba3a117eU, 0x4851927dU, 0x5b016189U, 0xa96ae28aU,
+  0x7da08661U, 0x8fcb0562U, 0x9c9bf696U, 0x6ef07595U,
+  0x417b1dbcU, 0xb3109ebfU, 0xa0406d4bU, 0x522bee48U,
+  0x86e18aa3U, 0x748a09a0U, 0x67dafa54U, 0x95b17957U,
+  0xcba24573U, 0x39c9c670U, 0x2a993584U, 0xd8f2b687U,
+  0x0c38d26cU, 0xfe53516fU, 0xed03a29bU, 0x1f682198U,
+  0x5125dad3U, 0xa34e59d0U, 0xb01eaa24U, 0x42752927U,
+  0x96bf4dccU, 0x64d4cecfU, 0x77843d3bU, 0x85efbe38U,
+  0xdbfc821cU, 0x2997011fU, 0x3ac7f2ebU, 0xc8ac71e8U,
+  0x1c661503U, 0xee0d9600U, 0xfd5d65f4U, 0x0f36e6f7U,
+  0x61c69362U, 0x93ad1061U, 0x80fde395U, 0x72966096U,
+  0xa65c047dU, 0x5437877eU, 0x4767748aU, 0xb50cf789U,
+  0xeb1fcbadU, 0x197448aeU, 0x0a24bb5aU, 0xf84f3859U,
+  0x2c855cb2U, 0xdeeedfb1U, 0xcdbe2c45U, 0x3fd5af46U,
+  0x7198540dU, 0x83f3d70eU, 0x90a324faU, 0x62c8a7f9U,
+  0xb602c312U, 0x44694011U, 0x5739b3e5U, 0xa55230e6U,
+  0xfb410cc2U, 0x092a8fc1U, 0x1a7a7c35U, 0xe811ff36U,
+  0x3cdb9bddU, 0xceb018deU, 0xdde0eb2aU, 0x2f8b6829U,
+  0x82f63b78U, 0x709db87bU, 0x63cd4b8fU, 0x91a6c88cU,
+  0x456cac67U, 0xb7072f64U, 0xa457dc90U, 0x563c5f93U,
+  0x082f63b7U, 0xfa44e0b4U, 0xe9141340U, 0x1b7f9043U,
+  0xcfb5f4a8U, 0x3dde77abU, 0x2e8e845fU, 0xdce5075cU,
+  0x92a8fc17U, 0x60c37f14U, 0x73938ce0U, 0x81f80fe3U,
+  0x55326b08U, 0xa759e80bU, 0xb4091bffU, 0x466298fcU,
+  0x1871a4d8U, 0xea1a27dbU, 0xf94ad42fU, 0x0b21572cU,
+  0xdfeb33c7U, 0x2d80b0c4U, 0x3ed04330U, 0xccbbc033U,
+  0xa24bb5a6U, 0x502036a5U, 0x4370c551U, 0xb11b4652U,
+  0x65d122b9U, 0x97baa1baU, 0x84ea524eU, 0x7681d14dU,
+  0x2892ed69U, 0xdaf96e6aU, 0xc9a99d9eU, 0x3bc21e9dU,
+  0xef087a76U, 0x1d63f975U, 0x0e330a81U, 0xfc588982U,
+  0xb21572c9U, 0x407ef1caU, 0x532e023eU, 0xa145813dU,
+  0x758fe5d6U, 0x87e466d5U, 0x94b49521U, 0x66df1622U,
+  0x38cc2a06U, 0xcaa7a905U, 0xd9f75af1U, 0x2b9cd9f2U,
+  0xff56bd19U, 0x0d3d3e1aU, 0x1e6dcdeeU, 0xec064eedU,
+  0xc38d26c4U, 0x31e6a5c7U, 0x22b65633U, 0xd0ddd530U,
+  0x0417b1dbU, 0xf67c32d8U, 0xe52cc12cU, 0x1747422fU,
+  0x49547e0bU, 0xbb3ffd08U, 0xa86f0efcU, 0x5a048dffU,
+  0x8ecee914U, 0x7ca56a17U, 0x6ff599e3U, 0x9d9e1ae0U,
+  0xd3d3e1abU, 0x21b862a8U, 0x32e8915cU, 0xc083125fU,
+  0x144976b4U, 0xe622f5b7U, 0xf5720643U, 0x07198540U,
+  0x590ab964U, 0xab613a67U, 0xb831c993U, 0x4a5a4a90U,
+  0x9e902e7bU, 0x6cfbad78U, 0x7fab5e8cU, 0x8dc0dd8fU,
+  0xe330a81aU, 0x115b2b19U, 0x020bd8edU, 0xf0605beeU,
+  0x24aa3f05U, 0xd6c1bc06U, 0xc5914ff2U, 0x37faccf1U,
+  0x69e9f0d5U, 0x9b8273d6U, 0x88d28022U, 0x7ab90321U,
+  0xae7367caU, 0x5c18e4c9U, 0x4f48173dU, 0xbd23943eU,
+  0xf36e6f75U, 0x0105ec76U, 0x12551f82U, 0xe03e9c81U,
+  0x34f4f86aU, 0xc69f7b69U, 0xd5cf889dU, 0x27a40b9eU,
+  0x79b737baU, 0x8bdcb4b9U, 0x988c474dU, 0x6ae7c44eU,
+  0xbe2da0a5U, 0x4c4623a6U, 0x5f16d052U, 0xad7d5351U
+};
+
+/** Continue a CRC32C one byte at a time in software. */
+static              uint32_t
+sc_io_crc32c_bytes (uint32_t crc, const unsigned char *p, size_t bytes)
+{
+  while (bytes-- > 0) {
+    crc = sc_io_crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#ifdef SC_IO_CRC32C_SSE42
+
+/** Continue a CRC32C with the SSE 4.2 instruction. */
+__attribute__ ((target ("sse4.2")))
+     static uint32_t    sc_io_crc32c_sse42 (uint32_t crc,
+                                            const unsigned char *p,
+                                            size_t bytes)
+{
+  uint64_t            c = crc, word;
+
+  for (; bytes > 0 && ((size_t) p & 7) != 0; --bytes) {
+    c = _mm_crc32_u8 ((uint32_t) c, *p++);
+  }
+  for (; bytes >= 8; bytes -= 8, p += 8) {
+    memcpy (&word, p, 8);
+    c = _mm_crc32_u64 (c, word);
+  }
+  for (; bytes > 0; --bytes) {
+    c = _mm_crc32_u8 ((uint32_t) c, *p++);
+  }
+  return (uint32_t) c;
+}
+
+#endif /* SC_IO_CRC32C_SSE42 */
+
+uint32_t
+sc_io_crc32c (uint32_t crc, const void *data, size_t bytes)
+{
+  const unsigned char *p = (const unsigned char *) data;
+
+  crc = ~crc;
+#if defined SC_IO_CRC32C_SSE42
+  if (__builtin_cpu_supports ("sse4.2")) {
+    return ~sc_io_crc32c_sse42 (crc, p, bytes);
+  }
+#elif defined SC_IO_CRC32C_ARM
+  {
+    uint64_t            word;
+
+    for (; bytes >= 8; bytes -= 8, p += 8) {
+      memcpy (&word, p, 8);
+      crc = __crc32cd (crc, word);
+    }
+    for (; bytes > 0; --bytes) {
+      crc = __crc32cb (crc, *p++);
+    }
+    return ~crc;
+  }
+#endif
+  return ~sc_io_crc32c_bytes (crc, p, bytes);
+}
+
+/** Continue a CRC32C over the first \a bytes bytes of a list of pieces. */
+static              uint32_t
+sc_io_vec_crc32c (uint32_t crc, const sc_io_vec_t * vec, int count,
+                  size_t bytes)
+{
+  int                 i;
+  size_t              piece;
+
+  for (i = 0; i < count && bytes > 0; ++i) {
+    piece = SC_MIN (vec[i].bytes, bytes);
+    crc = sc_io_crc32c (crc, vec[i].base, piece);
+    bytes -= piece;
+  }
+  return crc;
+}
+
+/** Store the checksum trailer of a running checksum. */
+static void
+sc_io_checksum_trailer (uint32_t crc, char *trailer)
+{
+  int                 k;
+
+  memcpy (trailer, sc_io_checksum_magic, 4);
+  for (k = 0; k < 4; ++k) {
+    trailer[4 + k] = (char) ((crc >> (8 * k)) & 0xff);
+  }
+}
+
+/** Multiply two polynomials modulo the reflected CRC32C polynomial. */
+static              uint32_t
+sc_io_crc32c_multmodp (uint32_t a, uint32_t b)
+{
+  uint32_t            m, p;
+
+  p = 0;
+  for (m = 1U << 31; m != 0; m >>= 1) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0) {
+        break;
+      }
+    }
+    b = (b & 1) ? (b >> 1) ^ 0x82f63b78U : b >> 1;
+  }
+  return p;
+}
+
+uint32_t
+sc_io_crc32c_combine (uint32_t crc1, uint32_t crc2, size_t bytes2)
+{
+  uint32_t            p, sq;
+  uint64_t            n;
+
+  /* compute x^(8 * bytes2) by repeated squaring, x^0 is the top bit */
+  p = 1U << 31;
+  sq = 1U << 30;
+  for (n = 8 * (uint64_t) bytes2; n > 0; n >>= 1) {
+    if (n & 1) {
+      p = sc_io_crc32c_multmodp (sq, p);
+    }
+    sq = sc_io_crc32c_multmodp (sq, sq);
+  }
+  return sc_io_crc32c_multmodp (p, crc1) ^ crc2;
+}
+
+int
+sc_io_encode_available (sc_io_encode_t encode)
+{
+  switch (encode) {
+  case SC_IO_ENCODE_NONE:
+    return 1;
+#ifdef SC_HAVE_ZLIB
+  case SC_IO_ENCODE_ZLIB:
+    return 1;
+#endif
+#ifdef SC_HAVE_ZSTD
+  case SC_IO_ENCODE_ZSTD:
+    return 1;
+#endif
+#ifdef SC_HAVE_LZ4
+  case SC_IO_ENCODE_LZ4:
+    return 1;
+#endif
+  default:
+    return 0;
+  }
+}
+
+static void         sc_io_codec_destroy (sc_io_codec_t * codec);
+
+/** Create the codec of a sink or source, or NULL on error. */
+static sc_io_codec_t *
+sc_io_codec_new (sc_io_encode_t encode, int is_sink)
+{
+  int                 retval = 0;
+  sc_io_codec_t      *codec;
+
+  SC_ASSERT (encode != SC_IO_ENCODE_NONE);
+  if (!sc_io_encode_available (encode)) {
+    return NULL;
+  }
+
+  codec = SC_ALLOC_ZERO (sc_io_codec_t, 1);
+  codec->encode = encode;
+  codec->is_sink = is_sink;
+  codec->buf_size = SC_IO_CODEC_BLOCK;
+  switch (encode) {
+#ifdef SC_HAVE_ZLIB
+  case SC_IO_ENCODE_ZLIB:
+    retval = is_sink ?
+      deflateInit (&codec->zs, Z_DEFAULT_COMPRESSION) :
+      inflateInit (&codec->zs);
+    retval = retval != Z_OK;
+    break;
+#endif
+#ifdef SC_HAVE_ZSTD
+  case SC_IO_ENCODE_ZSTD:
+    if (is_sink) {
+      retval = (codec->zcs = ZSTD_createCStream ()) == NULL;
+    }
+    else {
+      retval = (codec->zds = ZSTD_createDStream ()) == NULL;
+    }
+    break;
+#endif
+#ifdef SC_HAVE_LZ4
+  case SC_IO_ENCODE_LZ4:
+    if (is_sink) {
+      retval = LZ4F_isError
+        (LZ4F_createCompressionContext (&codec->lcc, LZ4F_VERSION));
+      /* the output block must hold any compressed input block */
+      codec->buf_size = SC_MAX (LZ4F_compressBound (SC_IO_CODEC_BLOCK, NULL),
+                                LZ4F_HEADER_SIZE_MAX);
+    }
+    else {
+      retval = LZ4F_isError
+        (LZ4F_createDecompressionContext (&codec->ldc, LZ4F_VERSION));
+    }
+    break;
+#endif
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  codec->buf = SC_ALLOC (char, codec->buf_size);
+  if (retval) {
+    sc_io_codec_destroy (codec);
+    return NULL;
+  }
+  return codec;
+}
+
+static void
+sc_io_codec_destroy (sc_io_codec_t * codec)
+{
+  switch (codec->encode) {
+#ifdef SC_HAVE_ZLIB
+  case SC_IO_ENCODE_ZLIB:
+    if (codec->is_sink) {
+      (void) deflateEnd (&codec->zs);
+    }
+    else {
+      (void) inflateEnd (&codec->zs);
+    }
+    break;
+#endif
+#ifdef SC_HAVE_ZSTD
+  case SC_IO_ENCODE_ZSTD:
+    ZSTD_freeCStream (codec->zcs);
+    ZSTD_freeDStream (codec->zds);
+    break;
+#endif
+#ifdef SC_HAVE_LZ4
+  case SC_IO_ENCODE_LZ4:
+    if (codec->lcc != NULL) {
+      (void) LZ4F_freeCompressionContext (codec->lcc);
+    }
+    if (codec->ldc != NULL) {
+      (void) LZ4F_freeDecompressionContext (codec->ldc);
+    }
+    break;
+#endif
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  SC_FREE (codec->buf);
+  SC_FREE (codec);
+}
+
+/** Compress a piece of input into the codec block.
+ * \param [in] in           Input data.
+ * \param [in,out] in_len   Input bytes on entry, consumed bytes on exit.
+ * \param [in,out] out_len  Room in the block on entry, output on exit.
+ * \param [in] finish       End the frame once all input is consumed.
+ * \param [out] done        True if all input is consumed and, if
+ *                          requested, the frame is ended.
+ * \return                  0 on success, nonzero on error.
+ */
+static int
+sc_io_codec_encode (sc_io_codec_t * codec, const char *in, size_t *in_len,
+                    size_t *out_len, int finish, int *done)
+{
+  *done = 0;
+  switch (codec->encode) {
+#ifdef SC_HAVE_ZLIB
+  case SC_IO_ENCODE_ZLIB:
+    {
+      int                 ret;
+      const size_t        total = *in_len;
+      const uInt          avail = (uInt) SC_MIN (total, (size_t) UINT_MAX);
+
+      codec->zs.next_in = (Bytef *) in;
+      codec->zs.avail_in = avail;
+      codec->zs.next_out = (Bytef *) codec->buf;
+      codec->zs.avail_out = (uInt) *out_len;
+      ret = deflate (&codec->zs, finish && avail == total ?
+                     Z_FINISH : Z_NO_FLUSH);
+      if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+        return -1;
+      }
+      *in_len = avail - codec->zs.avail_in;
+      *out_len -= codec->zs.avail_out;
+      if (ret == Z_STREAM_END) {
+        *done = 1;
+        return deflateReset (&codec->zs) != Z_OK;
+      }
+      *done = !finish && *in_len == total;
+    }
+    return 0;
+#endif
+#ifdef SC_HAVE_ZSTD
+  case SC_IO_ENCODE_ZSTD:
+    {
+      size_t              remaining;
+      ZSTD_inBuffer       zin = { in, *in_len, 0 };
+      ZSTD_outBuffer      zout = { codec->buf, *out_len, 0 };
+
+      remaining = ZSTD_compressStream2 (codec->zcs, &zout, &zin,
+                                        finish ? ZSTD_e_end :
+                                        ZSTD_e_continue);
+      if (ZSTD_isError (remaining)) {
+        return -1;
+      }
+      *in_len = zin.pos;
+      *out_len = zout.pos;
+      *done = zin.pos == zin.size && (!finish || remaining == 0);
+    }
+    return 0;
+#endif
+#ifdef SC_HAVE_LZ4
+  case SC_IO_ENCODE_LZ4:
+    {
+      size_t              ret;
+      const size_t        total = *in_len;
+
+      if (!codec->begun) {
+        /* the frame header precedes any input */
+        ret = LZ4F_compressBegin (codec->lcc, codec->buf, *out_len, NULL);
+        *in_len = 0;
+        codec->begun = 1;
+      }
+      else if (total > 0) {
+        *in_len = SC_MIN (total, (size_t) SC_IO_CODEC_BLOCK);
+        ret = LZ4F_compressUpdate (codec->lcc, codec->buf, *out_len,
+                                   in, *in_len, NULL);
+      }
+      else {
+        SC_ASSERT (finish);
+        ret = LZ4F_compressEnd (codec->lcc, codec->buf, *out_len, NULL);
+        codec->begun = 0;
+        *done = 1;
+      }
+      if (LZ4F_isError (ret)) {
+        return -1;
+      }
+      *out_len = ret;
+      *done = *done || (!finish && codec->begun && *in_len == total);
+    }
+    return 0;
+#endif
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  return -1;
+}
+
+/** Decompress a piece of input.
+ * \param [in] in           Encoded input data.
+ * \param [in,out] in_len   Input bytes on entry, consumed bytes on exit.
+ * \param [out] out         Output buffer.
+ * \param [in,out] out_len  Room in the output on entry, output on exit.
+ * \param [out] frame_end   True if a frame has been completed.
+ * \return                  0 on success, nonzero on error.
+ */
+static int
+sc_io_codec_decode (sc_io_codec_t * codec, const char *in, size_t *in_len,
+                    char *out, size_t *out_len, int *frame_end)
+{
+  *frame_end = 0;
+  switch (codec->encode) {
+#ifdef SC_HAVE_ZLIB
+  case SC_IO_ENCODE_ZLIB:
+    {
+      int                 ret;
+
+      codec->zs.next_in = (Bytef *) in;
+      codec->zs.avail_in = (uInt) SC_MIN (*in_len, (size_t) UINT_MAX);
+      codec->zs.next_out = (Bytef *) out;
+      codec->zs.avail_out = (uInt) SC_MIN (*out_len, (size_t) UINT_MAX);
+      *in_len = codec->zs.avail_in;
+      *out_len = codec->zs.avail_out;
+      ret = inflate (&codec->zs, Z_NO_FLUSH);
+      if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+        return -1;
+      }
+      *in_len -= codec->zs.avail_in;
+      *out_len -= codec->zs.avail_out;
+      if (ret == Z_STREAM_END) {
+        *frame_end = 1;
+        return inflateReset (&codec->zs) != Z_OK;
+      }
+    }
+    return 0;
+#endif
+#ifdef SC_HAVE_ZSTD
+  case SC_IO_ENCODE_ZSTD:
+    {
+      size_t              ret;
+      ZSTD_inBuffer       zin = { in, *in_len, 0 };
+      ZSTD_outBuffer      zout = { out, *out_len, 0 };
+
+      ret = ZSTD_decompressStream (codec->zds, &zout, &zin);
+      if (ZSTD_isError (ret)) {
+        return -1;
+      }
+      *in_len = zin.pos;
+      *out_len = zout.pos;
+      *frame_end = ret == 0;
+    }
+    return 0;
+#endif
+#ifdef SC_HAVE_LZ4
+  case SC_IO_ENCODE_LZ4:
+    {
+      size_t              ret;
+
+      ret = LZ4F_decompress (codec->ldc, out, out_len, in, in_len, NULL);
+      if (LZ4F_isError (ret)) {
+        return -1;
+      }
+      *frame_end = ret == 0;
+    }
+    return 0;
+#endif
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  return -1;
+}
+
+/** Staging buffers of a file sink that are written in the background.
+ * The caller fills one buffer at a time and queues it when full.
+ * With --enable-pthread a writer thread empties the queue in order,
+ * otherwise the caller writes each buffer when it is queued.
+ */
+typedef struct sc_io_async
+{
+  FILE               *file;
+  int                 sync;     /**< fsync on completion */
+  int                 num_buffers;
+  size_t              buffer_bytes;
+  char              **buffers;
+  size_t             *lengths;
+  int                 fill;     /**< buffer filled by the caller */
+  int                 head;     /**< first buffer queued for writing */
+  int                 queued;   /**< number of buffers queued */
+  int                 flush;    /**< flush requested and not yet done */
+  int                 error;    /**< a write or flush has failed */
+#ifdef SC_ENABLE_PTHREAD
+  int                 stopping;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+  pthread_t           thread;
+#endif
+}
+sc_io_async_t;
+
+/** Flush the file of an async sink and optionally sync it to disk. */
+static int
+sc_io_async_flush_file (sc_io_async_t * async)
+{
+  if (fflush (async->file)) {
+    return SC_IO_ERROR_FATAL;
+  }
+#ifdef SC_HAVE_FSYNC
+  if (async->sync && fsync (fileno (async->file))) {
+    return SC_IO_ERROR_FATAL;
+  }
+#endif
+  return SC_IO_ERROR_NONE;
+}
+
+/** Write the first queued buffer; called without holding the lock. */
+static int
+sc_io_async_write_head (sc_io_async_t * async)
+{
+  const int           b = async->head;
+
+  return fwrite (async->buffers[b], 1, async->lengths[b], async->file) !=
+    async->lengths[b];
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_io_async_main (void *arg)
+{
+  int                 error;
+  sc_io_async_t      *async = (sc_io_async_t *) arg;
+
+  pthread_mutex_lock (&async->mutex);
+  for (;;) {
+    if (async->queued > 0) {
+      pthread_mutex_unlock (&async->mutex);
+      error = sc_io_async_write_head (async);
+      pthread_mutex_lock (&async->mutex);
+      async->error |= error;
+      async->head = (async->head + 1) % async->num_buffers;
+      --async->queued;
+      pthread_cond_broadcast (&async->cond);
+    }
+    else if (async->flush) {
+      pthread_mutex_unlock (&async->mutex);
+      error = sc_io_async_flush_file (async);
+      pthread_mutex_lock (&async->mutex);
+      async->error |= error;
+      async->flush = 0;
+      pthread_cond_broadcast (&async->cond);
+    }
+    else if (async->stopping) {
+      break;
+    }
+    else {
+      pthread_cond_wait (&async->cond, &async->mutex);
+    }
+  }
+  pthread_mutex_unlock (&async->mutex);
+
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+static sc_io_async_t *
+sc_io_async_new (FILE * file, int num_buffers, size_t buffer_bytes, int sync)
+{
+  int                 b;
+  sc_io_async_t      *async;
+
+  async = SC_ALLOC_ZERO (sc_io_async_t, 1);
+  async->file = file;
+  async->sync = sync;
+  async->num_buffers = num_buffers;
+  async->buffer_bytes = buffer_bytes;
+  async->buffers = SC_ALLOC (char *, num_buffers);
+  async->lengths = SC_ALLOC_ZERO (size_t, num_buffers);
+  for (b = 0; b < num_buffers; ++b) {
+    async->buffers[b] = SC_ALLOC (char, buffer_bytes);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_init (&async->mutex, NULL);
+  pthread_cond_init (&async->cond, NULL);
+  if (pthread_create (&async->thread, NULL, sc_io_async_main, async)) {
+    SC_ABORT ("Failed to create io writer thread");
+  }
+#endif
+  return async;
+}
+
+/** Queue the buffer being filled and wait until the next one is free. */
+static int
+sc_io_async_submit (sc_io_async_t * async)
+{
+  int                 error;
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&async->mutex);
+  ++async->queued;
+  pthread_cond_broadcast (&async->cond);
+  while (async->queued == async->num_buffers) {
+    pthread_cond_wait (&async->cond, &async->mutex);
+  }
+  error = async->error;
+  pthread_mutex_unlock (&async->mutex);
+#else
+  async->error |= sc_io_async_write_head (async);
+  async->head = (async->head + 1) % async->num_buffers;
+  error = async->error;
+#endif
+  async->fill = (async->fill + 1) % async->num_buffers;
+  async->lengths[async->fill] = 0;
+
+  return error ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+static int
+sc_io_async_write (sc_io_async_t * async, const char *data, size_t bytes)
+{
+  size_t              n;
+
+  while (bytes > 0) {
+    n = SC_MIN (bytes, async->buffer_bytes - async->lengths[async->fill]);
+    memcpy (async->buffers[async->fill] + async->lengths[async->fill],
+            data, n);
+    async->lengths[async->fill] += n;
+    data += n;
+    bytes -= n;
+    if (async->lengths[async->fill] == async->buffer_bytes &&
+        sc_io_async_submit (async)) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+/** Write all staged data and flush the file. */
+static int
+sc_io_async_complete (sc_io_async_t * async)
+{
+  if (async->lengths[async->fill] > 0 && sc_io_async_submit (async)) {
+    return SC_IO_ERROR_FATAL;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&async->mutex);
+  async->flush = 1;
+  pthread_cond_broadcast (&async->cond);
+  while (async->queued > 0 || async->flush) {
+    pthread_cond_wait (&async->cond, &async->mutex);
+  }
+  pthread_mutex_unlock (&async->mutex);
+#else
+  async->error |= sc_io_async_flush_file (async);
+#endif
+  /* the writer is idle now */
+  return async->error ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Stop the writer after writing any queued data and free the buffers. */
+static void
+sc_io_async_destroy (sc_io_async_t * async)
+{
+  int                 b;
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&async->mutex);
+  async->stopping = 1;
+  pthread_cond_broadcast (&async->cond);
+  pthread_mutex_unlock (&async->mutex);
+  pthread_join (async->thread, NULL);
+  pthread_cond_destroy (&async->cond);
+  pthread_mutex_destroy (&async->mutex);
+#endif
+  for (b = 0; b < async->num_buffers; ++b) {
+    SC_FREE (async->buffers[b]);
+  }
+  SC_FREE (async->buffers);
+  SC_FREE (async->lengths);
+  SC_FREE (async);
+}
+
+/** Blocks of a file source read ahead of the caller.
+ * The blocks form a ring of which the caller reads the first filled one.
+ * With --enable-pthread a reader thread fills the free blocks in order,
+ * otherwise the caller reads the next block when it has used the last.
+ */
+typedef struct sc_io_readahead
+{
+  FILE               *file;
+  int                 num_buffers;
+  size_t              buffer_bytes;
+  char              **buffers;
+  size_t             *lengths;
+  int                 head;     /**< block read by the caller */
+  size_t              pos;      /**< read position in the head block */
+  int                 filled;   /**< number of filled blocks from head */
+  int                 eof;      /**< the file has no more data */
+  int                 error;    /**< a read has failed */
+#ifdef SC_ENABLE_PTHREAD
+  int                 stopping;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+  pthread_t           thread;
+#endif
+}
+sc_io_readahead_t;
+
+/** Read the block after the filled ones; called without holding the lock.
+ * \return          True if the file ends with this block.
+ */
+static int
+sc_io_readahead_fread (sc_io_readahead_t * ra, int b, int *error)
+{
+  ra->lengths[b] = fread (ra->buffers[b], 1, ra->buffer_bytes, ra->file);
+  if (ra->lengths[b] < ra->buffer_bytes) {
+    *error = ferror (ra->file) != 0;
+    return 1;
+  }
+  *error = 0;
+  return 0;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_io_readahead_main (void *arg)
+{
+  int                 b, eof, error;
+  sc_io_readahead_t  *ra = (sc_io_readahead_t *) arg;
+
+  pthread_mutex_lock (&ra->mutex);
+  for (;;) {
+    if (ra->stopping) {
+      break;
+    }
+    else if (ra->filled < ra->num_buffers && !ra->eof && !ra->error) {
+      /* the caller does not touch the blocks past the filled ones */
+      b = (ra->head + ra->filled) % ra->num_buffers;
+      pthread_mutex_unlock (&ra->mutex);
+      eof = sc_io_readahead_fread (ra, b, &error);
+      pthread_mutex_lock (&ra->mutex);
+      if (ra->lengths[b] > 0) {
+        ++ra->filled;
+      }
+      ra->eof |= eof;
+      ra->error |= error;
+      pthread_cond_broadcast (&ra->cond);
+    }
+    else {
+      pthread_cond_wait (&ra->cond, &ra->mutex);
+    }
+  }
+  pthread_mutex_unlock (&ra->mutex);
+
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+static sc_io_readahead_t *
+sc_io_readahead_new (FILE * file, int num_buffers, size_t buffer_bytes)
+{
+  int                 b;
+  sc_io_readahead_t  *ra;
+
+  ra = SC_ALLOC_ZERO (sc_io_readahead_t, 1);
+  ra->file = file;
+  ra->num_buffers = num_buffers;
+  ra->buffer_bytes = buffer_bytes;
+  ra->buffers = SC_ALLOC (char *, num_buffers);
+  ra->lengths = SC_ALLOC_ZERO (size_t, num_buffers);
+  for (b = 0; b < num_buffers; ++b) {
+    ra->buffers[b] = SC_ALLOC (char, buffer_bytes);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_init (&ra->mutex, NULL);
+  pthread_cond_init (&ra->cond, NULL);
+  if (pthread_create (&ra->thread, NULL, sc_io_readahead_main, ra)) {
+    SC_ABORT ("Failed to create io reader thread");
+  }
+#endif
+  return ra;
+}
+
+/** Wait until the head block is filled.
+ * \return          True if there is a head block, false at the end of the
+ *                  file or after an error.
+ */
+static int
+sc_io_readahead_wait (sc_io_readahead_t * ra)
+{
+  int                 available;
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&ra->mutex);
+  while (ra->filled == 0 && !ra->eof && !ra->error) {
+    pthread_cond_wait (&ra->cond, &ra->mutex);
+  }
+  available = ra->filled > 0;
+  pthread_mutex_unlock (&ra->mutex);
+#else
+  int                 error;
+
+  if (ra->filled == 0 && !ra->eof && !ra->error) {
+    ra->eof = sc_io_readahead_fread (ra, ra->head, &error);
+    ra->error = error;
+    if (ra->lengths[ra->head] > 0) {
+      ra->filled = 1;
+    }
+  }
+  available = ra->filled > 0;
+#endif
+  return available;
+}
+
+/** Return the used head block for reading further ahead. */
+static void
+sc_io_readahead_release (sc_io_readahead_t * ra)
+{
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&ra->mutex);
+#endif
+  ra->head = (ra->head + 1) % ra->num_buffers;
+  --ra->filled;
+  ra->pos = 0;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_cond_broadcast (&ra->cond);
+  pthread_mutex_unlock (&ra->mutex);
+#endif
+}
+
+/** Copy or skip data from the blocks read ahead.
+ * \param [out] data        Destination or NULL to skip the data.
+ * \param [out] bytes_read  Bytes copied or skipped, less than \a bytes
+ *                          only at the end of the file or on error.
+ * \param [out] blocks      Number of blocks taken into use.
+ * \return                  0 on success, nonzero on a read error.
+ */
+static int
+sc_io_readahead_read (sc_io_readahead_t * ra, char *data, size_t bytes,
+                      size_t *bytes_read, int *blocks)
+{
+  size_t              n;
+
+  *bytes_read = 0;
+  *blocks = 0;
+  while (bytes > 0) {
+    if (ra->pos == 0) {
+      if (!sc_io_readahead_wait (ra)) {
+        /* the blocks filled before an error are still served */
+        return ra->error;
+      }
+      ++*blocks;
+    }
+    n = SC_MIN (bytes, ra->lengths[ra->head] - ra->pos);
+    if (data != NULL) {
+      memcpy (data, ra->buffers[ra->head] + ra->pos, n);
+      data += n;
+    }
+    ra->pos += n;
+    bytes -= n;
+    *bytes_read += n;
+    if (ra->pos == ra->lengths[ra->head]) {
+      sc_io_readahead_release (ra);
+    }
+  }
+  return 0;
+}
+
+/** Stop the reader and free the blocks.
+ * The file is positioned after the data read ahead.
+ */
+static void
+sc_io_readahead_destroy (sc_io_readahead_t * ra)
+{
+  int                 b;
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&ra->mutex);
+  ra->stopping = 1;
+  pthread_cond_broadcast (&ra->cond);
+  pthread_mutex_unlock (&ra->mutex);
+  pthread_join (ra->thread, NULL);
+  pthread_cond_destroy (&ra->cond);
+  pthread_mutex_destroy (&ra->mutex);
+#endif
+  for (b = 0; b < ra->num_buffers; ++b) {
+    SC_FREE (ra->buffers[b]);
+  }
+  SC_FREE (ra->buffers);
+  SC_FREE (ra->lengths);
+  SC_FREE (ra);
+}
+
+/* Without MPI there is a single rank and the shared file uses stdio. */
+#if !defined SC_ENABLE_MPIIO && !defined SC_ENABLE_MPI
+#define SC_IO_MPIFILE_STDIO
+#endif
+
+/** Maximum bytes per rank in one collective file operation. */
+#define SC_IO_MPIFILE_CHUNK ((size_t) 1 << 30)
+
+/** A file shared by the ranks of a communicator, written and read in
+ * sections.  Each section holds the data of all ranks in rank order.
+ * For the type AGGREGATE, the communicator is that of a group, and only
+ * its first rank accesses the file. */
+typedef struct sc_io_mpifile
+{
+  int                 aggregate;        /**< boolean: type AGGREGATE */
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+#ifdef SC_ENABLE_MPIIO
+  MPI_File            fh;
+#endif
+  FILE               *file;     /**< stdio file if not using MPI I/O */
+  size_t              stripe_bytes;     /**< alignment of the sections */
+  long long           offset;   /**< file offset of the next section */
+  sc_array_t         *section;  /**< local data of the current section */
+  size_t              section_pos;      /**< read position in the section */
+}
+sc_io_mpifile_t;
+
+static sc_io_mpifile_t *
+sc_io_mpifile_open (sc_MPI_Comm mpicomm, const char *filename,
+                    const sc_io_mpifile_hints_t * hints, int is_sink,
+                    sc_io_mode_t mode)
+{
+  int                 mpiret;
+  sc_io_mpifile_t    *mf;
+
+  mf = SC_ALLOC_ZERO (sc_io_mpifile_t, 1);
+  mf->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &mf->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mf->mpirank);
+  SC_CHECK_MPI (mpiret);
+  mf->stripe_bytes = hints != NULL ? hints->stripe_bytes : 0;
+
+#if defined SC_ENABLE_MPIIO
+  {
+    int                 amode;
+    char                value[BUFSIZ];
+    MPI_Info            info;
+    MPI_Offset          size;
+
+    /* pass the hints to the MPI implementation */
+    mpiret = MPI_Info_create (&info);
+    SC_CHECK_MPI (mpiret);
+    if (hints != NULL && hints->num_aggregators > 0) {
+      snprintf (value, BUFSIZ, "%d", hints->num_aggregators);
+      mpiret = MPI_Info_set (info, "cb_nodes", value);
+      SC_CHECK_MPI (mpiret);
+    }
+    if (hints != NULL && hints->stripe_count > 0) {
+      snprintf (value, BUFSIZ, "%d", hints->stripe_count);
+      mpiret = MPI_Info_set (info, "striping_factor", value);
+      SC_CHECK_MPI (mpiret);
+    }
+    if (hints != NULL && hints->stripe_bytes > 0) {
+      snprintf (value, BUFSIZ, "%llu",
+                (unsigned long long) hints->stripe_bytes);
+      mpiret = MPI_Info_set (info, "striping_unit", value);
+      SC_CHECK_MPI (mpiret);
+    }
+
+    amode = is_sink ? MPI_MODE_WRONLY | MPI_MODE_CREATE : MPI_MODE_RDONLY;
+    mpiret = MPI_File_open (mpicomm, (char *) filename, amode, info,
+                            &mf->fh);
+    MPI_Info_free (&info);
+    if (mpiret == sc_MPI_SUCCESS && is_sink) {
+      if (mode == SC_IO_MODE_WRITE) {
+        mpiret = MPI_File_set_size (mf->fh, 0);
+      }
+      else if ((mpiret = MPI_File_get_size (mf->fh, &size)) ==
+               sc_MPI_SUCCESS) {
+        mf->offset = (long long) size;
+      }
+      if (mpiret != sc_MPI_SUCCESS) {
+        (void) MPI_File_close (&mf->fh);
+      }
+    }
+    if (mpiret != sc_MPI_SUCCESS) {
+      SC_FREE (mf);
+      return NULL;
+    }
+  }
+#elif defined SC_IO_MPIFILE_STDIO
+  mf->file = fopen (filename, !is_sink ? "rb" :
+                    mode == SC_IO_MODE_WRITE ? "wb" : "ab");
+  if (mf->file == NULL || (is_sink && mode == SC_IO_MODE_APPEND &&
+                           (fseek (mf->file, 0, SEEK_END) ||
+                            (mf->offset = ftell (mf->file)) < 0))) {
+    if (mf->file != NULL) {
+      (void) fclose (mf->file);
+    }
+    SC_FREE (mf);
+    return NULL;
+  }
+#else
+  /* MPI without MPI I/O cannot share a file */
+  SC_FREE (mf);
+  return NULL;
+#endif
+
+  mf->section = sc_array_new (sizeof (char));
+  return mf;
+}
+
+/** Open the file of a group of nodes for type AGGREGATE. */
+static sc_io_mpifile_t *
+sc_io_aggregate_open (sc_MPI_Comm mpicomm, const char *filename,
+                      int nodes_per_file, int is_sink, sc_io_mode_t mode)
+{
+  int                 mpiret;
+  int                 rank, node, group, error, any;
+  char                name[BUFSIZ];
+  sc_MPI_Comm         intranode, internode;
+  sc_io_mpifile_t    *mf;
+
+  /* the node number is the rank among the nodes */
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+  node = rank;
+  if (internode != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_rank (internode, &node);
+    SC_CHECK_MPI (mpiret);
+  }
+  group = node / SC_MAX (nodes_per_file, 1);
+
+  mf = SC_ALLOC_ZERO (sc_io_mpifile_t, 1);
+  mf->aggregate = 1;
+  mpiret = sc_MPI_Comm_split (mpicomm, group, rank, &mf->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mf->mpicomm, &mf->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mf->mpicomm, &mf->mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the first rank of the group opens the file */
+  error = 0;
+  if (mf->mpirank == 0) {
+    error = snprintf (name, BUFSIZ, "%s_%04d", filename, group) >= BUFSIZ ||
+      (mf->file = fopen (name, !is_sink ? "rb" :
+                         mode == SC_IO_MODE_WRITE ? "wb" : "ab")) == NULL;
+  }
+  mpiret = sc_MPI_Allreduce (&error, &any, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (any) {
+    if (mf->file != NULL) {
+      (void) fclose (mf->file);
+    }
+    mpiret = sc_MPI_Comm_free (&mf->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    SC_FREE (mf);
+    return NULL;
+  }
+
+  mf->section = sc_array_new (sizeof (char));
+  return mf;
+}
+
+/** Write or read a section of type AGGREGATE within a group.
+ * The first rank gathers or scatters the data by point-to-point messages,
+ * holding the data of at most one other rank at a time.
+ */
+static int
+sc_io_aggregate_section (sc_io_mpifile_t * mf, int is_sink)
+{
+  int                 mpiret;
+  int                 error = 0, any;
+  int                 q;
+  long long           local, *counts;
+  uint64_t           *table;
+  size_t              num_table;
+  sc_array_t         *buffer;
+
+  local = (long long) mf->section->elem_count;
+  counts = NULL;
+  table = NULL;
+  buffer = NULL;
+  num_table = (size_t) mf->mpisize + 1;
+  if (mf->mpirank == 0) {
+    counts = SC_ALLOC (long long, mf->mpisize);
+    table = SC_ALLOC (uint64_t, num_table);
+    buffer = sc_array_new (sizeof (char));
+  }
+
+  if (is_sink) {
+    mpiret = sc_MPI_Gather (&local, 1, sc_MPI_LONG_LONG_INT,
+                            counts, 1, sc_MPI_LONG_LONG_INT, 0, mf->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    if (mf->mpirank == 0) {
+      /* the table precedes the data of the section */
+      table[0] = (uint64_t) mf->mpisize;
+      for (q = 0; q < mf->mpisize; ++q) {
+        table[q + 1] = (uint64_t) counts[q];
+      }
+      error = fwrite (table, sizeof (uint64_t), num_table, mf->file) !=
+        num_table;
+      error |= fwrite (mf->section->array, 1, (size_t) local, mf->file) !=
+        (size_t) local;
+      for (q = 1; q < mf->mpisize; ++q) {
+        sc_array_resize (buffer, (size_t) counts[q]);
+        mpiret = sc_mpi_recv_large (buffer->array, buffer->elem_count, q,
+                                    SC_TAG_IO_AGGREGATE, mf->mpicomm);
+        SC_CHECK_MPI (mpiret);
+        error |= fwrite (buffer->array, 1, buffer->elem_count, mf->file) !=
+          buffer->elem_count;
+      }
+      error |= fflush (mf->file) != 0;
+    }
+    else {
+      mpiret = sc_mpi_send_large (mf->section->array, (size_t) local, 0,
+                                  SC_TAG_IO_AGGREGATE, mf->mpicomm);
+      SC_CHECK_MPI (mpiret);
+    }
+    sc_array_resize (mf->section, 0);
+  }
+  else {
+    if (mf->mpirank == 0) {
+      /* a table of another group size is not read further */
+      if (fread (table, sizeof (uint64_t), 1, mf->file) != 1 ||
+          table[0] != (uint64_t) mf->mpisize ||
+          fread (table + 1, sizeof (uint64_t), num_table - 1, mf->file) !=
+          num_table - 1) {
+        error = 1;
+        memset (table, 0, num_table * sizeof (uint64_t));
+      }
+      for (q = 0; q < mf->mpisize; ++q) {
+        counts[q] = (long long) table[q + 1];
+      }
+    }
+    mpiret = sc_MPI_Scatter (counts, 1, sc_MPI_LONG_LONG_INT,
+                             &local, 1, sc_MPI_LONG_LONG_INT, 0, mf->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    error |= (size_t) local != mf->section->elem_count;
+    sc_array_resize (mf->section, (size_t) local);
+    if (mf->mpirank == 0) {
+      error |= fread (mf->section->array, 1, (size_t) local, mf->file) !=
+        (size_t) local;
+      for (q = 1; q < mf->mpisize; ++q) {
+        sc_array_resize (buffer, (size_t) counts[q]);
+        error |= fread (buffer->array, 1, buffer->elem_count, mf->file) !=
+          buffer->elem_count;
+        mpiret = sc_mpi_send_large (buffer->array, buffer->elem_count, q,
+                                    SC_TAG_IO_AGGREGATE, mf->mpicomm);
+        SC_CHECK_MPI (mpiret);
+      }
+    }
+    else {
+      mpiret = sc_mpi_recv_large (mf->section->array, (size_t) local, 0,
+                                  SC_TAG_IO_AGGREGATE, mf->mpicomm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  mf->section_pos = 0;
+
+  if (mf->mpirank == 0) {
+    sc_array_destroy (buffer);
+    SC_FREE (table);
+    SC_FREE (counts);
+  }
+  mpiret = sc_MPI_Allreduce (&error, &any, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mf->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return any ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+static int
+sc_io_mpifile_close (sc_io_mpifile_t * mf)
+{
+  int                 mpiret;
+  int                 retval = 0;
+
+  if (mf->aggregate) {
+    if (mf->file != NULL) {
+      retval = fclose (mf->file) != 0;
+    }
+    mpiret = sc_MPI_Comm_free (&mf->mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  else {
+#if defined SC_ENABLE_MPIIO
+    retval = MPI_File_close (&mf->fh) != sc_MPI_SUCCESS;
+#elif defined SC_IO_MPIFILE_STDIO
+    retval = fclose (mf->file) != 0;
+#endif
+  }
+  sc_array_destroy (mf->section);
+  SC_FREE (mf);
+
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Access the next section of the file collectively.
+ * The local part of the section is written from or read into the section
+ * array, whose count is the number of local bytes.  The last rank pads the
+ * section to the stripe size.
+ */
+static int
+sc_io_mpifile_section (sc_io_mpifile_t * mf, int is_sink)
+{
+  int                 mpiret;
+  int                 retval = 0;
+  size_t              zz, count, pos, n;
+  long long           local, mine, total, padded, maxcount;
+#ifdef SC_ENABLE_MPIIO
+  int                 icount;
+  sc_MPI_Status       mpistatus;
+#endif
+
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_IO);
+  if (mf->aggregate) {
+    retval = sc_io_aggregate_section (mf, is_sink);
+    sc_mpi_stats_leave ();
+    return retval;
+  }
+
+  /* offset of this rank's part and size of the whole section */
+  local = (long long) mf->section->elem_count;
+  mine = 0;
+  mpiret = sc_MPI_Exscan (&local, &mine, 1, sc_MPI_LONG_LONG_INT,
+                          sc_MPI_SUM, mf->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mf->mpirank == 0) {
+    mine = 0;
+  }
+  mpiret = sc_MPI_Allreduce (&local, &total, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_SUM, mf->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  padded = total;
+  if (mf->stripe_bytes > 0) {
+    padded = (total + (long long) mf->stripe_bytes - 1) /
+      (long long) mf->stripe_bytes * (long long) mf->stripe_bytes;
+  }
+  if (mf->mpirank == mf->mpisize - 1 && padded > total) {
+    count = mf->section->elem_count;
+    sc_array_resize (mf->section, count + (size_t) (padded - total));
+    if (is_sink) {
+      memset (mf->section->array + count, 0, (size_t) (padded - total));
+    }
+  }
+
+  /* every rank takes part in the same number of collective calls */
+  count = mf->section->elem_count;
+  local = (long long) count;
+  mpiret = sc_MPI_Allreduce (&local, &maxcount, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_MAX, mf->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (zz = 0; zz * SC_IO_MPIFILE_CHUNK < (size_t) maxcount; ++zz) {
+    pos = zz * SC_IO_MPIFILE_CHUNK;
+    n = pos < count ? SC_MIN (SC_IO_MPIFILE_CHUNK, count - pos) : 0;
+    pos = SC_MIN (pos, count);
+#if defined SC_ENABLE_MPIIO
+    if (is_sink) {
+      mpiret = MPI_File_write_at_all (mf->fh, (MPI_Offset)
+                                      (mf->offset + mine + (long long) pos),
+                                      mf->section->array + pos, (int) n,
+                                      sc_MPI_BYTE, &mpistatus);
+    }
+    else {
+      mpiret = MPI_File_read_at_all (mf->fh, (MPI_Offset)
+                                     (mf->offset + mine + (long long) pos),
+                                     mf->section->array + pos, (int) n,
+                                     sc_MPI_BYTE, &mpistatus);
+    }
+    if (mpiret != sc_MPI_SUCCESS ||
+        sc_MPI_Get_count (&mpistatus, sc_MPI_BYTE, &icount) !=
+        sc_MPI_SUCCESS || icount != (int) n) {
+      retval = 1;
+    }
+#elif defined SC_IO_MPIFILE_STDIO
+    if (n > 0) {
+      if (fseek (mf->file, (long) (mf->offset + mine + (long long) pos),
+                 SEEK_SET)) {
+        retval = 1;
+      }
+      else if (is_sink) {
+        retval |= fwrite (mf->section->array + pos, 1, n, mf->file) != n;
+      }
+      else {
+        retval |= fread (mf->section->array + pos, 1, n, mf->file) != n;
+      }
+    }
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+  }
+#ifdef SC_IO_MPIFILE_STDIO
+  if (is_sink) {
+    retval |= fflush (mf->file) != 0;
+  }
+#endif
+
+  /* the padding is not part of the local data */
+  mf->offset += padded;
+  if (is_sink) {
+    sc_array_resize (mf->section, 0);
+  }
+  else if (mf->mpirank == mf->mpisize - 1 && padded > total) {
+    sc_array_resize (mf->section, count - (size_t) (padded - total));
+  }
+  mf->section_pos = 0;
+  sc_mpi_stats_leave ();
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Timing counters of a sink or a source. */
+typedef struct sc_io_timer
+{
+  sc_io_timing_t      counts;
+  int                 depth;    /**< number of timed calls in progress */
+}
+sc_io_timer_t;
+
+/** Begin a timed call.  Calls nested in another are not timed again.
+ * \param [in,out] timer    Timer of a sink or source, or NULL.
+ * \return                  Start time to pass to \ref sc_io_timer_end.
+ */
+static double
+sc_io_timer_begin (void *timer)
+{
+  sc_io_timer_t      *t = (sc_io_timer_t *) timer;
+
+  return t != NULL && t->depth++ == 0 ? sc_MPI_Wtime () : 0.;
+}
+
+/** End a timed call and count it as transfer or synchronization. */
+static void
+sc_io_timer_end (void *timer, double start, int is_sync)
+{
+  sc_io_timer_t      *t = (sc_io_timer_t *) timer;
+  double              elapsed;
+
+  if (t == NULL || --t->depth > 0) {
+    return;
+  }
+  elapsed = sc_MPI_Wtime () - start;
+  if (is_sync) {
+    t->counts.sync_time += elapsed;
+    ++t->counts.sync_calls;
+  }
+  else {
+    t->counts.io_time += elapsed;
+    ++t->counts.io_calls;
+  }
+}
+
+/** Count bytes moved and calls made to the underlying medium. */
+static void
+sc_io_timer_medium (void *timer, size_t bytes, int calls)
+{
+  sc_io_timer_t      *t = (sc_io_timer_t *) timer;
+
+  if (t != NULL) {
+    t->counts.bytes += bytes;
+    t->counts.file_calls += calls;
+  }
+}
+
+/** Write data to the underlying sink and count it in bytes_out. */
+static int
+sc_io_sink_write_raw (sc_io_sink_t * sink, const void *data,
+                      size_t bytes_avail)
+{
+  size_t              bytes_out;
+
+  bytes_out = 0;
+
+  if (sink->iotype == SC_IO_TYPE_BUFFER) {
+    size_t              elem_size, new_count;
+
+    SC_ASSERT (sink->buffer != NULL);
+    elem_size = sink->buffer->elem_size;
+    new_count =
+      (sink->buffer_bytes + bytes_avail + elem_size - 1) / elem_size;
+    sc_array_resize (sink->buffer, new_count);
+    /* For a view sufficient size is asserted only in debug mode. */
+    if (new_count * elem_size > SC_ARRAY_BYTE_ALLOC (sink->buffer)) {
+      return SC_IO_ERROR_FATAL;
+    }
+
+    memcpy (sink->buffer->array + sink->buffer_bytes, data, bytes_avail);
+    sink->buffer_bytes += bytes_avail;
+    bytes_out = bytes_avail;
+  }
+  else if (sink->mpifile != NULL) {
+    sc_io_mpifile_t    *mf = (sc_io_mpifile_t *) sink->mpifile;
+    size_t              count = mf->section->elem_count;
+
+    /* the data is written collectively on completion */
+    sc_array_resize (mf->section, count + bytes_avail);
+    memcpy (mf->section->array + count, data, bytes_avail);
+    bytes_out = bytes_avail;
+  }
+  else if (sink->async != NULL) {
+    if (sc_io_async_write ((sc_io_async_t *) sink->async,
+                           (const char *) data, bytes_avail)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    bytes_out = bytes_avail;
+  }
+  else if (sink->iotype == SC_IO_TYPE_FILENAME ||
+           sink->iotype == SC_IO_TYPE_FILEFILE) {
+    SC_ASSERT (sink->file != NULL);
+    bytes_out = fwrite (data, 1, bytes_avail, sink->file);
+    sc_io_timer_medium (sink->timing, 0, 1);
+    if (bytes_out != bytes_avail) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+
+  sc_io_timer_medium (sink->timing, bytes_out, 0);
+  sink->bytes_out += bytes_out;
+
+  return SC_IO_ERROR_NONE;
+}
+
+/** Pass data through the encoder of a sink, optionally ending the frame. */
+static int
+sc_io_sink_encode (sc_io_sink_t * sink, const char *data, size_t bytes_avail,
+                   int finish)
+{
+  sc_io_codec_t      *codec = (sc_io_codec_t *) sink->codec;
+  size_t              in_len, out_len;
+  int                 done;
+
+  do {
+    in_len = bytes_avail;
+    out_len = codec->buf_size;
+    if (sc_io_codec_encode (codec, data, &in_len, &out_len, finish, &done)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    data += in_len;
+    bytes_avail -= in_len;
+    if (out_len > 0 && sc_io_sink_write_raw (sink, codec->buf, out_len)) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+  while (!done);
+
+  return SC_IO_ERROR_NONE;
+}
+
+/** Read data from the underlying source without updating the counters. */
+static int
+sc_io_source_read_raw (sc_io_source_t * source, void *data,
+                       size_t bytes_avail, size_t * bbytes_out)
+{
+  int                 retval;
+
+  retval = 0;
+  *bbytes_out = 0;
+
+  if (source->iotype == SC_IO_TYPE_BUFFER) {
+    SC_ASSERT (source->buffer != NULL);
+    /* the data ends with the array, not with its allocation */
+    *bbytes_out = source->buffer->elem_count * source->buffer->elem_size;
+    SC_ASSERT (*bbytes_out >= source->buffer_bytes);
+    *bbytes_out -= source->buffer_bytes;
+    *bbytes_out = SC_MIN (*bbytes_out, bytes_avail);
+
+    if (data != NULL) {
+      memcpy (data, source->buffer->array + source->buffer_bytes,
+              *bbytes_out);
+    }
+    source->buffer_bytes += *bbytes_out;
+  }
+  else if (source->mpifile != NULL) {
+    sc_io_mpifile_t    *mf = (sc_io_mpifile_t *) source->mpifile;
+
+    *bbytes_out = SC_MIN (mf->section->elem_count - mf->section_pos,
+                          bytes_avail);
+    if (data != NULL) {
+      memcpy (data, mf->section->array + mf->section_pos, *bbytes_out);
+    }
+    mf->section_pos += *bbytes_out;
+  }
+  else if (source->iotype == SC_IO_TYPE_MMAP ||
+           source->iotype == SC_IO_TYPE_BCAST) {
+    SC_ASSERT (source->map_pos <= source->map_bytes);
+    *bbytes_out = SC_MIN (source->map_bytes - source->map_pos, bytes_avail);
+    if (data != NULL) {
+      memcpy (data, source->map + source->map_pos, *bbytes_out);
+    }
+    source->map_pos += *bbytes_out;
+  }
+  else if (source->readahead != NULL) {
+    int                 blocks;
+
+    retval = sc_io_readahead_read ((sc_io_readahead_t *) source->readahead,
+                                   (char *) data, bytes_avail, bbytes_out,
+                                   &blocks);
+    sc_io_timer_medium (source->timing, 0, blocks);
+  }
+  else if (source->iotype == SC_IO_TYPE_FILENAME ||
+           source->iotype == SC_IO_TYPE_FILEFILE) {
+    SC_ASSERT (source->file != NULL);
+    if (data != NULL) {
+      *bbytes_out = fread (data, 1, bytes_avail, source->file);
+      if (*bbytes_out < bytes_avail) {
+        retval = !feof (source->file) || ferror (source->file);
+      }
+    }
+    else {
+      retval = fseek (source->file, (long) bytes_avail, SEEK_CUR);
+      *bbytes_out = bytes_avail;
+    }
+    sc_io_timer_medium (source->timing, 0, 1);
+  }
+
+  sc_io_timer_medium (source->timing, *bbytes_out, 0);
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Refill the encoded input block of a source if it is used up.
+ * \return          0 on success, nonzero on error.  At the end of the data
+ *                  the block is left empty.
+ */
+static int
+sc_io_source_fill (sc_io_source_t * source)
+{
+  sc_io_codec_t      *codec = (sc_io_codec_t *) source->codec;
+  size_t              got;
+
+  if (codec->buf_pos < codec->buf_len) {
+    return SC_IO_ERROR_NONE;
+  }
+  if (sc_io_source_read_raw (source, codec->buf, codec->buf_size, &got)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  codec->buf_pos = 0;
+  codec->buf_len = got;
+  source->bytes_in += got;
+  return SC_IO_ERROR_NONE;
+}
+
+/** Decode data from a source until the output is full or the data ends. */
+static int
+sc_io_source_decode (sc_io_source_t * source, char *data,
+                     size_t bytes_avail, size_t * produced)
+{
+  sc_io_codec_t      *codec = (sc_io_codec_t *) source->codec;
+  size_t              in_len, out_len;
+  int                 frame_end;
+  char                scratch[BUFSIZ];
+
+  *produced = 0;
+  for (;;) {
+    if (sc_io_source_fill (source)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    if (codec->buf_pos == codec->buf_len) {
+      /* the data has ended, which is an error within a frame */
+      return codec->in_frame ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+    }
+
+    /* with the output full, still consume the end of the frame */
+    in_len = codec->buf_len - codec->buf_pos;
+    out_len = bytes_avail - *produced;
+    if (data == NULL) {
+      out_len = SC_MIN (out_len, sizeof (scratch));
+    }
+    if (sc_io_codec_decode (codec, codec->buf + codec->buf_pos, &in_len,
+                            data != NULL ? data + *produced : scratch,
+                            &out_len, &frame_end)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    codec->buf_pos += in_len;
+    *produced += out_len;
+    if (frame_end) {
+      codec->in_frame = 0;
+    }
+    else if (in_len > 0 || out_len > 0) {
+      codec->in_frame = 1;
+    }
+    if (*produced == bytes_avail && (!codec->in_frame || in_len == 0)) {
+      return SC_IO_ERROR_NONE;
+    }
+    if (in_len == 0 && out_len == 0 && !frame_end) {
+      /* no progress with both input and room for output */
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+}
+
 
 sc_io_sink_t       *
 sc_io_sink_new (sc_io_type_t iotype, sc_io_mode_t mode,
@@ -67,11 +1758,54 @@ sc_io_sink_new (sc_io_type_t iotype, sc_io_mode_t mode,
       return NULL;
     }
   }
+  else if (iotype == SC_IO_TYPE_MMAP || iotype == SC_IO_TYPE_BCAST) {
+    va_end (ap);
+    SC_FREE (sink);
+    return NULL;
+  }
+  else if (iotype == SC_IO_TYPE_MPIFILE) {
+    sc_MPI_Comm         mpicomm = va_arg (ap, sc_MPI_Comm);
+    const char         *filename = va_arg (ap, const char *);
+    const sc_io_mpifile_hints_t *hints =
+      va_arg (ap, const sc_io_mpifile_hints_t *);
+
+    sink->mpifile = sc_io_mpifile_open (mpicomm, filename, hints, 1, mode);
+    if (sink->mpifile == NULL) {
+      va_end (ap);
+      SC_FREE (sink);
+      return NULL;
+    }
+  }
+  else if (iotype == SC_IO_TYPE_AGGREGATE) {
+    sc_MPI_Comm         mpicomm = va_arg (ap, sc_MPI_Comm);
+    const char         *filename = va_arg (ap, const char *);
+    int                 nodes_per_file = va_arg (ap, int);
+
+    sink->mpifile = sc_io_aggregate_open (mpicomm, filename,
+                                          nodes_per_file, 1, mode);
+    if (sink->mpifile == NULL) {
+      va_end (ap);
+      SC_FREE (sink);
+      return NULL;
+    }
+  }
   else {
     SC_ABORT_NOT_REACHED ();
   }
   va_end (ap);
 
+  if (encode != SC_IO_ENCODE_NONE &&
+      (sink->codec = sc_io_codec_new (encode, 1)) == NULL) {
+    if (iotype == SC_IO_TYPE_FILENAME) {
+      (void) fclose (sink->file);
+    }
+    else if (sink->mpifile != NULL) {
+      (void) sc_io_mpifile_close ((sc_io_mpifile_t *) sink->mpifile);
+    }
+    SC_FREE (sink);
+    return NULL;
+  }
+
   return sink;
 }
 
@@ -82,102 +1816,574 @@ sc_io_sink_destroy (sc_io_sink_t * sink)
 
   /* The error value SC_IO_ERROR_AGAIN is turned into FATAL */
   retval = sc_io_sink_complete (sink, NULL, NULL);
+  if (sink->async != NULL) {
+    sc_io_async_destroy ((sc_io_async_t *) sink->async);
+  }
+  if (sink->mpifile != NULL) {
+    retval = sc_io_mpifile_close ((sc_io_mpifile_t *) sink->mpifile) ||
+      retval;
+  }
   if (sink->iotype == SC_IO_TYPE_FILENAME) {
     SC_ASSERT (sink->file != NULL);
 
     /* Attempt close even on complete error */
     retval = fclose (sink->file) || retval;
   }
+  if (sink->codec != NULL) {
+    sc_io_codec_destroy ((sc_io_codec_t *) sink->codec);
+  }
+  SC_FREE (sink->timing);
   SC_FREE (sink);
 
   return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
 }
 
+static int
+sc_io_sink_write_untimed (sc_io_sink_t * sink, const void *data,
+                          size_t bytes_avail)
+{
+  int                 retval;
+
+  if (sink->codec == NULL) {
+    retval = sc_io_sink_write_raw (sink, data, bytes_avail);
+  }
+  else if (bytes_avail > 0) {
+    ((sc_io_codec_t *) sink->codec)->in_frame = 1;
+    retval = sc_io_sink_encode (sink, (const char *) data, bytes_avail, 0);
+  }
+  else {
+    retval = SC_IO_ERROR_NONE;
+  }
+  if (retval) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (sink->checksum != SC_IO_CHECKSUM_OFF && bytes_avail > 0) {
+    sink->crc = sc_io_crc32c (sink->crc, data, bytes_avail);
+    sink->checksum = SC_IO_CHECKSUM_RUNNING;
+  }
+
+  sink->bytes_in += bytes_avail;
+
+  return SC_IO_ERROR_NONE;
+}
+
 int
 sc_io_sink_write (sc_io_sink_t * sink, const void *data, size_t bytes_avail)
 {
-  size_t              bytes_out;
+  int                 retval;
+  double              start;
 
-  bytes_out = 0;
+  start = sc_io_timer_begin (sink->timing);
+  retval = sc_io_sink_write_untimed (sink, data, bytes_avail);
+  sc_io_timer_end (sink->timing, start, 0);
 
-  if (sink->iotype == SC_IO_TYPE_BUFFER) {
+  return retval;
+}
+
+#ifdef SC_IO_WRITEV
+
+/** Fill a batch of system vectors with the pieces from \a i on,
+ * skipping the first \a skip bytes of piece \a i.
+ * \return          The number of system vectors.
+ */
+static int
+sc_io_vec_batch (struct iovec *iov, const sc_io_vec_t * vec, int count,
+                 int i, size_t skip)
+{
+  int                 n;
+
+  for (n = 0; n < SC_IO_VEC_BATCH && i + n < count; ++n) {
+    iov[n].iov_base = (char *) vec[i + n].base + (n == 0 ? skip : 0);
+    iov[n].iov_len = vec[i + n].bytes - (n == 0 ? skip : 0);
+  }
+  return n;
+}
+
+/** Advance the piece \a *i and offset \a *skip past \a done bytes. */
+static void
+sc_io_vec_advance (const sc_io_vec_t * vec, int count, int *i,
+                   size_t *skip, size_t done)
+{
+  while (*i < count && done >= vec[*i].bytes - *skip) {
+    done -= vec[*i].bytes - *skip;
+    *skip = 0;
+    ++*i;
+  }
+  if (*i < count) {
+    *skip += done;
+  }
+}
+
+/** Write pieces to the file descriptor of a stream.
+ * The stream is flushed before and repositioned after the write.
+ */
+static int
+sc_io_file_writev (FILE * file, const sc_io_vec_t * vec, int count,
+                   void *timer)
+{
+  int                 i, n;
+  size_t              skip;
+  ssize_t             done;
+  struct iovec        iov[SC_IO_VEC_BATCH];
+
+  sc_io_timer_medium (timer, 0, 1);
+  if (fflush (file)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  i = 0;
+  skip = 0;
+  sc_io_vec_advance (vec, count, &i, &skip, 0);
+  while (i < count) {
+    n = sc_io_vec_batch (iov, vec, count, i, skip);
+    done = writev (fileno (file), iov, n);
+    sc_io_timer_medium (timer, done > 0 ? (size_t) done : 0, 1);
+    if (done < 0 && errno == EINTR) {
+      continue;
+    }
+    if (done <= 0) {
+      return SC_IO_ERROR_FATAL;
+    }
+    sc_io_vec_advance (vec, count, &i, &skip, (size_t) done);
+  }
+
+  /* the stream learns the new offset; this fails harmlessly on pipes */
+  (void) fseek (file, 0, SEEK_CUR);
+  return SC_IO_ERROR_NONE;
+}
+
+#endif /* SC_IO_WRITEV */
+
+/** Add pieces written past the single write function to the checksum. */
+static void
+sc_io_sink_checksum_vec (sc_io_sink_t * sink, const sc_io_vec_t * vec,
+                         int count, size_t bytes)
+{
+  if (sink->checksum != SC_IO_CHECKSUM_OFF && bytes > 0) {
+    sink->crc = sc_io_vec_crc32c (sink->crc, vec, count, bytes);
+    sink->checksum = SC_IO_CHECKSUM_RUNNING;
+  }
+}
+
+static int
+sc_io_sink_writev_untimed (sc_io_sink_t * sink, const sc_io_vec_t * vec,
+                           int count)
+{
+  int                 i;
+  size_t              total;
+
+  SC_ASSERT (count >= 0);
+
+  total = 0;
+  for (i = 0; i < count; ++i) {
+    total += vec[i].bytes;
+  }
+
+  if (sink->codec == NULL && sink->async == NULL &&
+      sink->iotype == SC_IO_TYPE_BUFFER) {
     size_t              elem_size, new_count;
 
+    /* reserve the memory once and copy every piece */
     SC_ASSERT (sink->buffer != NULL);
     elem_size = sink->buffer->elem_size;
-    new_count =
-      (sink->buffer_bytes + bytes_avail + elem_size - 1) / elem_size;
+    new_count = (sink->buffer_bytes + total + elem_size - 1) / elem_size;
     sc_array_resize (sink->buffer, new_count);
-    /* For a view sufficient size is asserted only in debug mode. */
     if (new_count * elem_size > SC_ARRAY_BYTE_ALLOC (sink->buffer)) {
       return SC_IO_ERROR_FATAL;
     }
+    for (i = 0; i < count; ++i) {
+      memcpy (sink->buffer->array + sink->buffer_bytes, vec[i].base,
+              vec[i].bytes);
+      sink->buffer_bytes += vec[i].bytes;
+    }
+    sc_io_timer_medium (sink->timing, total, 0);
+    sc_io_sink_checksum_vec (sink, vec, count, total);
+    sink->bytes_in += total;
+    sink->bytes_out += total;
+    return SC_IO_ERROR_NONE;
+  }
+#ifdef SC_IO_WRITEV
+  if (sink->codec == NULL && sink->async == NULL &&
+      (sink->iotype == SC_IO_TYPE_FILENAME ||
+       sink->iotype == SC_IO_TYPE_FILEFILE)) {
+    SC_ASSERT (sink->file != NULL);
+    if (sc_io_file_writev (sink->file, vec, count, sink->timing)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    sc_io_sink_checksum_vec (sink, vec, count, total);
+    sink->bytes_in += total;
+    sink->bytes_out += total;
+    return SC_IO_ERROR_NONE;
+  }
+#endif
 
-    memcpy (sink->buffer->array + sink->buffer_bytes, data, bytes_avail);
-    sink->buffer_bytes += bytes_avail;
-    bytes_out = bytes_avail;
+  for (i = 0; i < count; ++i) {
+    if (sc_io_sink_write (sink, vec[i].base, vec[i].bytes)) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_sink_writev (sc_io_sink_t * sink, const sc_io_vec_t * vec, int count)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (sink->timing);
+  retval = sc_io_sink_writev_untimed (sink, vec, count);
+  sc_io_timer_end (sink->timing, start, 0);
+
+  return retval;
+}
+
+static int
+sc_io_sink_complete_untimed (sc_io_sink_t * sink,
+                             size_t * bytes_in, size_t * bytes_out)
+{
+  int                 retval;
+  sc_io_codec_t      *codec = (sc_io_codec_t *) sink->codec;
+
+  /* the trailer is written once for the data since the last one */
+  if (sink->checksum == SC_IO_CHECKSUM_RUNNING) {
+    char                trailer[SC_IO_CHECKSUM_BYTES];
+
+    sc_io_checksum_trailer (sink->crc, trailer);
+    sink->checksum = SC_IO_CHECKSUM_OFF;
+    retval = sc_io_sink_write (sink, trailer, SC_IO_CHECKSUM_BYTES);
+    sink->checksum = SC_IO_CHECKSUM_SEALED;
+    sink->crc = 0;
+    if (retval) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+
+  /* end the current compressed frame */
+  if (codec != NULL && codec->in_frame) {
+    if (sc_io_sink_encode (sink, NULL, 0, 1)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    codec->in_frame = 0;
+  }
+
+  retval = 0;
+  if (sink->iotype == SC_IO_TYPE_BUFFER) {
+    SC_ASSERT (sink->buffer != NULL);
+    if (sink->buffer_bytes % sink->buffer->elem_size != 0) {
+      return SC_IO_ERROR_AGAIN;
+    }
+  }
+  else if (sink->mpifile != NULL) {
+    retval = sc_io_mpifile_section ((sc_io_mpifile_t *) sink->mpifile, 1);
+    sc_io_timer_medium (sink->timing, 0, 1);
+  }
+  else if (sink->async != NULL) {
+    retval = sc_io_async_complete ((sc_io_async_t *) sink->async);
+    sc_io_timer_medium (sink->timing, 0, 1);
+  }
+  else if (sink->iotype == SC_IO_TYPE_FILENAME ||
+           sink->iotype == SC_IO_TYPE_FILEFILE) {
+    SC_ASSERT (sink->file != NULL);
+    retval = fflush (sink->file);
+    sc_io_timer_medium (sink->timing, 0, 1);
+  }
+  if (retval) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  if (bytes_in != NULL) {
+    *bytes_in = sink->bytes_in;
+  }
+  if (bytes_out != NULL) {
+    *bytes_out = sink->bytes_out;
+  }
+  sink->bytes_in = sink->bytes_out = 0;
+
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_sink_complete (sc_io_sink_t * sink,
+                     size_t * bytes_in, size_t * bytes_out)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (sink->timing);
+  retval = sc_io_sink_complete_untimed (sink, bytes_in, bytes_out);
+  sc_io_timer_end (sink->timing, start, 1);
+
+  return retval;
+}
+
+int
+sc_io_sink_activate_async (sc_io_sink_t * sink, int num_buffers,
+                           size_t buffer_bytes, int sync)
+{
+  if (sink->iotype != SC_IO_TYPE_FILENAME &&
+      sink->iotype != SC_IO_TYPE_FILEFILE) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (sink->async != NULL || num_buffers < 2 || buffer_bytes == 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* data written so far precedes the staged data */
+  if (fflush (sink->file)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sink->async = sc_io_async_new (sink->file, num_buffers, buffer_bytes,
+                                 sync);
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_sink_activate_checksum (sc_io_sink_t * sink)
+{
+  if (sink->checksum != SC_IO_CHECKSUM_OFF) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sink->checksum = SC_IO_CHECKSUM_RUNNING;
+  sink->crc = 0;
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_sink_activate_timing (sc_io_sink_t * sink)
+{
+  if (sink->timing != NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sink->timing = SC_ALLOC_ZERO (sc_io_timer_t, 1);
+  return SC_IO_ERROR_NONE;
+}
+
+void
+sc_io_sink_timing (sc_io_sink_t * sink, sc_io_timing_t * timing)
+{
+  SC_ASSERT (timing != NULL);
+
+  if (sink->timing != NULL) {
+    *timing = ((sc_io_timer_t *) sink->timing)->counts;
+  }
+  else {
+    memset (timing, 0, sizeof (*timing));
+  }
+}
+
+int
+sc_io_sink_align (sc_io_sink_t * sink, size_t bytes_align)
+{
+  size_t              fill_bytes;
+  char               *fill;
+  int                 retval;
+
+  fill_bytes = (sink->codec != NULL ? sink->bytes_in : sink->bytes_out) %
+    bytes_align;
+  fill_bytes = (bytes_align - fill_bytes) % bytes_align;
+  fill = SC_ALLOC_ZERO (char, fill_bytes);
+  retval = sc_io_sink_write (sink, fill, fill_bytes);
+  SC_FREE (fill);
+
+  return retval;
+}
+
+/** Map a whole file read-only into the memory of a source.
+ * An empty file is valid and leaves the mapping empty.
+ * \return          0 on success, nonzero on error.
+ */
+static int
+sc_io_source_map (sc_io_source_t * source, const char *filename)
+{
+#ifdef SC_IO_MMAP
+  int                 fd;
+  void               *map;
+  struct stat         st;
+
+  fd = open (filename, O_RDONLY);
+  if (fd < 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (fstat (fd, &st) != 0 || st.st_size < 0) {
+    (void) close (fd);
+    return SC_IO_ERROR_FATAL;
   }
-  else if (sink->iotype == SC_IO_TYPE_FILENAME ||
-           sink->iotype == SC_IO_TYPE_FILEFILE) {
-    SC_ASSERT (sink->file != NULL);
-    bytes_out = fwrite (data, 1, bytes_avail, sink->file);
-    if (bytes_out != bytes_avail) {
+  source->map = NULL;
+  source->map_bytes = (size_t) st.st_size;
+  source->map_pos = 0;
+  if (source->map_bytes > 0) {
+    map = mmap (NULL, source->map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      (void) close (fd);
       return SC_IO_ERROR_FATAL;
     }
+    source->map = (const char *) map;
   }
 
-  sink->bytes_in += bytes_avail;
-  sink->bytes_out += bytes_out;
+  /* the mapping remains valid after closing the file */
+  return close (fd) ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+#else
+  return SC_IO_ERROR_FATAL;
+#endif
+}
 
+static int
+sc_io_source_unmap (sc_io_source_t * source)
+{
+#ifdef SC_IO_MMAP
+  if (source->map != NULL &&
+      munmap ((void *) source->map, source->map_bytes) != 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+#endif
+  source->map = NULL;
+  source->map_bytes = source->map_pos = 0;
   return SC_IO_ERROR_NONE;
 }
 
-int
-sc_io_sink_complete (sc_io_sink_t * sink,
-                     size_t * bytes_in, size_t * bytes_out)
+/** Communicator of a BCAST source with node-shared contents. */
+typedef struct sc_io_bcast
 {
-  int                 retval;
+  sc_MPI_Comm         mpicomm;
+}
+sc_io_bcast_t;
 
-  retval = 0;
-  if (sink->iotype == SC_IO_TYPE_BUFFER) {
-    SC_ASSERT (sink->buffer != NULL);
-    if (sink->buffer_bytes % sink->buffer->elem_size != 0) {
-      return SC_IO_ERROR_AGAIN;
-    }
+/** Read a whole file into newly allocated memory. */
+static char        *
+sc_io_bcast_read_file (const char *filename, size_t *bytes)
+{
+  long                length;
+  char               *contents;
+  FILE               *file;
+
+  if ((file = fopen (filename, "rb")) == NULL) {
+    return NULL;
   }
-  else if (sink->iotype == SC_IO_TYPE_FILENAME ||
-           sink->iotype == SC_IO_TYPE_FILEFILE) {
-    SC_ASSERT (sink->file != NULL);
-    retval = fflush (sink->file);
+  if (fseek (file, 0, SEEK_END) != 0 || (length = ftell (file)) < 0 ||
+      fseek (file, 0, SEEK_SET) != 0) {
+    (void) fclose (file);
+    return NULL;
   }
-  if (retval) {
+  contents = SC_ALLOC (char, SC_MAX (length, 1));
+  if (fread (contents, 1, (size_t) length, file) != (size_t) length) {
+    (void) fclose (file);
+    SC_FREE (contents);
+    return NULL;
+  }
+  if (fclose (file)) {
+    SC_FREE (contents);
+    return NULL;
+  }
+  *bytes = (size_t) length;
+  return contents;
+}
+
+/** Broadcast a buffer that may exceed the range of int. */
+static void
+sc_io_bcast_bytes (char *data, size_t bytes, int root, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  size_t              chunk;
+  const size_t        max_chunk = (size_t) 1 << 30;
+
+  while (bytes > 0) {
+    chunk = SC_MIN (bytes, max_chunk);
+    mpiret = sc_MPI_Bcast (data, (int) chunk, sc_MPI_BYTE, root, mpicomm);
+    SC_CHECK_MPI (mpiret);
+    data += chunk;
+    bytes -= chunk;
+  }
+}
+
+/** Read a file on the root rank and broadcast it into the source.
+ * With shared memory, only the writing rank of each node and the root
+ * take part in the broadcast of the contents.
+ */
+static int
+sc_io_source_bcast (sc_io_source_t * source, sc_MPI_Comm mpicomm,
+                    int root, const char *filename, int shmem)
+{
+  int                 mpiret;
+  int                 rank, writer;
+  long                lbytes;
+  size_t              bytes;
+  char               *contents, *data;
+  sc_MPI_Comm         subcomm;
+  sc_io_bcast_t      *bc;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* only the root touches the file system */
+  contents = NULL;
+  lbytes = -1;
+  if (rank == root &&
+      (contents = sc_io_bcast_read_file (filename, &bytes)) != NULL) {
+    lbytes = (long) bytes;
+  }
+  mpiret = sc_MPI_Bcast (&lbytes, 1, sc_MPI_LONG, root, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (lbytes < 0) {
     return SC_IO_ERROR_FATAL;
   }
+  bytes = (size_t) lbytes;
 
-  if (bytes_in != NULL) {
-    *bytes_in = sink->bytes_in;
+  if (!shmem) {
+    /* every rank keeps a private copy */
+    if (rank != root) {
+      contents = SC_ALLOC (char, SC_MAX (bytes, 1));
+    }
+    sc_io_bcast_bytes (contents, bytes, root, mpicomm);
+    source->map = contents;
   }
-  if (bytes_out != NULL) {
-    *bytes_out = sink->bytes_out;
+  else {
+    data = (char *) sc_shmem_malloc (sc_package_id, 1, SC_MAX (bytes, 1),
+                                     mpicomm);
+    writer = sc_shmem_write_start (data, mpicomm);
+
+    /* the root goes first in the communicator of the node writers */
+    mpiret = sc_MPI_Comm_split (mpicomm, writer || rank == root ?
+                                0 : sc_MPI_UNDEFINED,
+                                rank == root ? -1 : rank, &subcomm);
+    SC_CHECK_MPI (mpiret);
+    if (writer || rank == root) {
+      sc_io_bcast_bytes (rank == root ? contents : data, bytes, 0, subcomm);
+      if (writer && rank == root) {
+        memcpy (data, contents, bytes);
+      }
+      mpiret = sc_MPI_Comm_free (&subcomm);
+      SC_CHECK_MPI (mpiret);
+    }
+    sc_shmem_write_end (data, mpicomm);
+    SC_FREE (contents);
+
+    bc = SC_ALLOC (sc_io_bcast_t, 1);
+    bc->mpicomm = mpicomm;
+    source->bcast = bc;
+    source->map = data;
   }
-  sink->bytes_in = sink->bytes_out = 0;
+  source->map_bytes = bytes;
+  source->map_pos = 0;
 
   return SC_IO_ERROR_NONE;
 }
 
-int
-sc_io_sink_align (sc_io_sink_t * sink, size_t bytes_align)
+/** Release the contents of a BCAST source, collectively if shared. */
+static void
+sc_io_source_bcast_free (sc_io_source_t * source)
 {
-  size_t              fill_bytes;
-  char               *fill;
-  int                 retval;
-
-  fill_bytes = (bytes_align - sink->bytes_out % bytes_align) % bytes_align;
-  fill = SC_ALLOC_ZERO (char, fill_bytes);
-  retval = sc_io_sink_write (sink, fill, fill_bytes);
-  SC_FREE (fill);
+  sc_io_bcast_t      *bc = (sc_io_bcast_t *) source->bcast;
 
-  return retval;
+  if (bc != NULL) {
+    sc_shmem_free (sc_package_id, (void *) source->map, bc->mpicomm);
+    SC_FREE (bc);
+    source->bcast = NULL;
+  }
+  else {
+    SC_FREE ((char *) source->map);
+  }
+  source->map = NULL;
+  source->map_bytes = source->map_pos = 0;
 }
 
 sc_io_source_t     *
@@ -213,11 +2419,82 @@ sc_io_source_new (sc_io_type_t iotype, sc_io_encode_t encode, ...)
       return NULL;
     }
   }
+  else if (iotype == SC_IO_TYPE_MMAP) {
+    const char         *filename = va_arg (ap, const char *);
+
+    if (sc_io_source_map (source, filename)) {
+      va_end (ap);
+      SC_FREE (source);
+      return NULL;
+    }
+  }
+  else if (iotype == SC_IO_TYPE_MPIFILE) {
+    sc_MPI_Comm         mpicomm = va_arg (ap, sc_MPI_Comm);
+    const char         *filename = va_arg (ap, const char *);
+    const sc_io_mpifile_hints_t *hints =
+      va_arg (ap, const sc_io_mpifile_hints_t *);
+
+    source->mpifile = sc_io_mpifile_open (mpicomm, filename, hints, 0,
+                                          SC_IO_MODE_WRITE);
+    if (source->mpifile == NULL) {
+      va_end (ap);
+      SC_FREE (source);
+      return NULL;
+    }
+  }
+  else if (iotype == SC_IO_TYPE_AGGREGATE) {
+    sc_MPI_Comm         mpicomm = va_arg (ap, sc_MPI_Comm);
+    const char         *filename = va_arg (ap, const char *);
+    int                 nodes_per_file = va_arg (ap, int);
+
+    source->mpifile = sc_io_aggregate_open (mpicomm, filename,
+                                            nodes_per_file, 0,
+                                            SC_IO_MODE_WRITE);
+    if (source->mpifile == NULL) {
+      va_end (ap);
+      SC_FREE (source);
+      return NULL;
+    }
+  }
+  else if (iotype == SC_IO_TYPE_BCAST) {
+    sc_MPI_Comm         mpicomm = va_arg (ap, sc_MPI_Comm);
+    int                 root = va_arg (ap, int);
+    const char         *filename = va_arg (ap, const char *);
+    int                 shmem = va_arg (ap, int);
+    int                 retval;
+
+    sc_mpi_stats_enter (SC_MPI_CATEGORY_IO);
+    retval = sc_io_source_bcast (source, mpicomm, root, filename, shmem);
+    sc_mpi_stats_leave ();
+    if (retval) {
+      va_end (ap);
+      SC_FREE (source);
+      return NULL;
+    }
+  }
   else {
     SC_ABORT_NOT_REACHED ();
   }
   va_end (ap);
 
+  if (encode != SC_IO_ENCODE_NONE &&
+      (source->codec = sc_io_codec_new (encode, 0)) == NULL) {
+    if (iotype == SC_IO_TYPE_FILENAME) {
+      (void) fclose (source->file);
+    }
+    else if (iotype == SC_IO_TYPE_MMAP) {
+      (void) sc_io_source_unmap (source);
+    }
+    else if (iotype == SC_IO_TYPE_BCAST) {
+      sc_io_source_bcast_free (source);
+    }
+    else if (source->mpifile != NULL) {
+      (void) sc_io_mpifile_close ((sc_io_mpifile_t *) source->mpifile);
+    }
+    SC_FREE (source);
+    return NULL;
+  }
+
   return source;
 }
 
@@ -235,6 +2512,11 @@ sc_io_source_destroy (sc_io_source_t * source)
     sc_array_destroy (source->mirror_buffer);
   }
 
+  /* stop reading ahead before the file is closed */
+  if (source->readahead != NULL) {
+    sc_io_readahead_destroy ((sc_io_readahead_t *) source->readahead);
+  }
+
   /* The error value SC_IO_ERROR_AGAIN is turned into FATAL */
   if (source->iotype == SC_IO_TYPE_FILENAME) {
     SC_ASSERT (source->file != NULL);
@@ -242,80 +2524,442 @@ sc_io_source_destroy (sc_io_source_t * source)
     /* Attempt close even on complete error */
     retval = fclose (source->file) || retval;
   }
+  else if (source->iotype == SC_IO_TYPE_MMAP) {
+    retval = sc_io_source_unmap (source) || retval;
+  }
+  else if (source->iotype == SC_IO_TYPE_BCAST) {
+    sc_io_source_bcast_free (source);
+  }
+  else if (source->mpifile != NULL) {
+    retval = sc_io_mpifile_close ((sc_io_mpifile_t *) source->mpifile) ||
+      retval;
+  }
+  if (source->codec != NULL) {
+    sc_io_codec_destroy ((sc_io_codec_t *) source->codec);
+  }
+  SC_FREE (source->timing);
   SC_FREE (source);
 
-  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+  return retval ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Skip data of a checksummed source by reading it into scratch memory. */
+static int
+sc_io_source_skip_checksum (sc_io_source_t * source, size_t bytes_avail,
+                            size_t * bytes_out)
+{
+  size_t              chunk, bbytes_out, total;
+  char                scratch[BUFSIZ];
+
+  total = 0;
+  while (total < bytes_avail) {
+    chunk = SC_MIN (bytes_avail - total, sizeof (scratch));
+    if (sc_io_source_read (source, scratch, chunk, &bbytes_out)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    total += bbytes_out;
+    if (bbytes_out < chunk) {
+      break;
+    }
+  }
+  if (bytes_out == NULL && total < bytes_avail) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (bytes_out != NULL) {
+    *bytes_out = total;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+static int
+sc_io_source_read_untimed (sc_io_source_t * source, void *data,
+                           size_t bytes_avail, size_t * bytes_out)
+{
+  int                 retval;
+  size_t              bbytes_out;
+
+  if (source->checksum != SC_IO_CHECKSUM_OFF && data == NULL) {
+    return sc_io_source_skip_checksum (source, bytes_avail, bytes_out);
+  }
+  if (source->codec == NULL) {
+    retval = sc_io_source_read_raw (source, data, bytes_avail, &bbytes_out);
+    source->bytes_in += bbytes_out;
+  }
+  else {
+    retval = sc_io_source_decode (source, (char *) data, bytes_avail,
+                                  &bbytes_out);
+  }
+  if (retval == SC_IO_ERROR_NONE && source->mirror != NULL && data != NULL) {
+    retval = sc_io_sink_write (source->mirror, data, bbytes_out);
+  }
+  if (retval) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (bytes_out == NULL && bbytes_out < bytes_avail) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (source->checksum != SC_IO_CHECKSUM_OFF && bbytes_out > 0) {
+    source->crc = sc_io_crc32c (source->crc, data, bbytes_out);
+    source->checksum = SC_IO_CHECKSUM_RUNNING;
+  }
+
+  if (bytes_out != NULL) {
+    *bytes_out = bbytes_out;
+  }
+  source->bytes_out += bbytes_out;
+
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_read (sc_io_source_t * source, void *data,
+                   size_t bytes_avail, size_t * bytes_out)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (source->timing);
+  retval = sc_io_source_read_untimed (source, data, bytes_avail,
+                                    bytes_out);
+  sc_io_timer_end (source->timing, start, 0);
+
+  return retval;
+}
+
+#ifdef SC_IO_PREADV
+
+/** Read pieces from the file descriptor of a stream at its position.
+ * The stream is repositioned after the bytes read.
+ * \return          0 on success, nonzero if the stream is not seekable
+ *                  or on a read error.
+ */
+static int
+sc_io_file_preadv (FILE * file, const sc_io_vec_t * vec, int count,
+                   size_t *bytes_read, void *timer)
+{
+  int                 i, n;
+  long                pos;
+  size_t              skip, total;
+  ssize_t             done;
+  struct iovec        iov[SC_IO_VEC_BATCH];
+
+  if ((pos = ftell (file)) < 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+  i = 0;
+  skip = 0;
+  total = 0;
+  sc_io_vec_advance (vec, count, &i, &skip, 0);
+  while (i < count) {
+    n = sc_io_vec_batch (iov, vec, count, i, skip);
+    done = preadv (fileno (file), iov, n, (off_t) pos + (off_t) total);
+    sc_io_timer_medium (timer, done > 0 ? (size_t) done : 0, 1);
+    if (done < 0 && errno == EINTR) {
+      continue;
+    }
+    if (done < 0) {
+      return SC_IO_ERROR_FATAL;
+    }
+    if (done == 0) {
+      /* end of file */
+      break;
+    }
+    total += (size_t) done;
+    sc_io_vec_advance (vec, count, &i, &skip, (size_t) done);
+  }
+
+  /* discard the stream buffer and continue after the bytes read */
+  if (fseek (file, pos + (long) total, SEEK_SET)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  *bytes_read = total;
+  return SC_IO_ERROR_NONE;
+}
+
+#endif /* SC_IO_PREADV */
+
+static int
+sc_io_source_readv_untimed (sc_io_source_t * source, const sc_io_vec_t * vec,
+                            int count, size_t * bytes_out)
+{
+  int                 i;
+  size_t              total, bbytes_out;
+
+  SC_ASSERT (count >= 0);
+
+  total = 0;
+  for (i = 0; i < count; ++i) {
+    total += vec[i].bytes;
+  }
+
+#ifdef SC_IO_PREADV
+  if (source->codec == NULL && source->mirror == NULL &&
+      source->readahead == NULL &&
+      (source->iotype == SC_IO_TYPE_FILENAME ||
+       source->iotype == SC_IO_TYPE_FILEFILE) &&
+      !sc_io_file_preadv (source->file, vec, count, &bbytes_out,
+                          source->timing)) {
+    source->bytes_in += bbytes_out;
+    source->bytes_out += bbytes_out;
+    if (bytes_out == NULL && bbytes_out < total) {
+      return SC_IO_ERROR_FATAL;
+    }
+    if (source->checksum != SC_IO_CHECKSUM_OFF && bbytes_out > 0) {
+      source->crc = sc_io_vec_crc32c (source->crc, vec, count, bbytes_out);
+      source->checksum = SC_IO_CHECKSUM_RUNNING;
+    }
+    if (bytes_out != NULL) {
+      *bytes_out = bbytes_out;
+    }
+    return SC_IO_ERROR_NONE;
+  }
+#endif
+
+  /* read piece by piece until one is not filled */
+  total = 0;
+  for (i = 0; i < count; ++i) {
+    bbytes_out = 0;
+    if (sc_io_source_read (source, vec[i].base, vec[i].bytes,
+                           bytes_out == NULL ? NULL : &bbytes_out)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    if (bytes_out == NULL) {
+      continue;
+    }
+    total += bbytes_out;
+    if (bbytes_out < vec[i].bytes) {
+      break;
+    }
+  }
+  if (bytes_out != NULL) {
+    *bytes_out = total;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_readv (sc_io_source_t * source, const sc_io_vec_t * vec,
+                    int count, size_t * bytes_out)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (source->timing);
+  retval = sc_io_source_readv_untimed (source, vec, count, bytes_out);
+  sc_io_timer_end (source->timing, start, 0);
+
+  return retval;
+}
+
+static int
+sc_io_source_section_untimed (sc_io_source_t * source, size_t bytes)
+{
+  sc_io_mpifile_t    *mf = (sc_io_mpifile_t *) source->mpifile;
+
+  if (mf == NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+  SC_ASSERT (mf != NULL);
+
+  /* all ranks must take part even if one has unread data */
+  sc_array_resize (mf->section, bytes);
+  sc_io_timer_medium (source->timing, 0, 1);
+  if (sc_io_mpifile_section (mf, 0)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_section (sc_io_source_t * source, size_t bytes)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (source->timing);
+  retval = sc_io_source_section_untimed (source, bytes);
+  sc_io_timer_end (source->timing, start, 1);
+
+  return retval;
+}
+
+static int
+sc_io_source_view_untimed (sc_io_source_t * source, size_t bytes_avail,
+                           const void **data, size_t * bytes_out)
+{
+  int                 retval;
+  size_t              remaining, bbytes_out;
+  const char         *start;
+
+  SC_ASSERT (data != NULL);
+
+  /* the data is accessed in place and skipped by a raw read */
+  if (source->codec != NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (source->iotype == SC_IO_TYPE_MMAP ||
+      source->iotype == SC_IO_TYPE_BCAST) {
+    start = source->map != NULL ? source->map + source->map_pos : NULL;
+    remaining = source->map_bytes - source->map_pos;
+  }
+  else if (source->mpifile != NULL) {
+    sc_io_mpifile_t    *mf = (sc_io_mpifile_t *) source->mpifile;
+
+    start = mf->section->array + mf->section_pos;
+    remaining = mf->section->elem_count - mf->section_pos;
+  }
+  else if (source->iotype == SC_IO_TYPE_BUFFER) {
+    SC_ASSERT (source->buffer != NULL);
+    start = source->buffer->array + source->buffer_bytes;
+    remaining = source->buffer->elem_count * source->buffer->elem_size -
+      source->buffer_bytes;
+  }
+  else {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* a view that cannot be satisfied does not consume any data */
+  if (bytes_out == NULL && remaining < bytes_avail) {
+    return SC_IO_ERROR_FATAL;
+  }
+  *data = start;
+  retval = sc_io_source_read_raw (source, NULL, bytes_avail, &bbytes_out);
+  source->bytes_in += bbytes_out;
+
+  if (retval == SC_IO_ERROR_NONE && source->mirror != NULL) {
+    retval = sc_io_sink_write (source->mirror, *data, bbytes_out);
+  }
+  if (retval) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (source->checksum != SC_IO_CHECKSUM_OFF && bbytes_out > 0) {
+    source->crc = sc_io_crc32c (source->crc, *data, bbytes_out);
+    source->checksum = SC_IO_CHECKSUM_RUNNING;
+  }
+
+  if (bytes_out != NULL) {
+    *bytes_out = bbytes_out;
+  }
+  source->bytes_out += bbytes_out;
+
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_view (sc_io_source_t * source, size_t bytes_avail,
+                   const void **data, size_t * bytes_out)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (source->timing);
+  retval = sc_io_source_view_untimed (source, bytes_avail, data,
+                                    bytes_out);
+  sc_io_timer_end (source->timing, start, 0);
+
+  return retval;
 }
 
 int
-sc_io_source_read (sc_io_source_t * source, void *data,
-                   size_t bytes_avail, size_t * bytes_out)
+sc_io_source_view_array (sc_io_source_t * source, sc_array_t * view,
+                         size_t elem_size, size_t elem_count)
 {
-  int                 retval;
-  size_t              bbytes_out;
-
-  retval = 0;
-  bbytes_out = 0;
+  const void         *data;
 
-  if (source->iotype == SC_IO_TYPE_BUFFER) {
-    SC_ASSERT (source->buffer != NULL);
-    bbytes_out = SC_ARRAY_BYTE_ALLOC (source->buffer);
-    SC_ASSERT (bbytes_out >= source->buffer_bytes);
-    bbytes_out -= source->buffer_bytes;
-    bbytes_out = SC_MIN (bbytes_out, bytes_avail);
+  SC_ASSERT (view != NULL);
+  SC_ASSERT (elem_size > 0);
 
-    if (data != NULL) {
-      memcpy (data, source->buffer->array + source->buffer_bytes, bbytes_out);
-    }
-    source->buffer_bytes += bbytes_out;
+  if (sc_io_source_view (source, elem_size * elem_count, &data, NULL)) {
+    return SC_IO_ERROR_FATAL;
   }
-  else if (source->iotype == SC_IO_TYPE_FILENAME ||
-           source->iotype == SC_IO_TYPE_FILEFILE) {
-    SC_ASSERT (source->file != NULL);
-    if (data != NULL) {
-      bbytes_out = fread (data, 1, bytes_avail, source->file);
-      if (bbytes_out < bytes_avail) {
-        retval = !feof (source->file) || ferror (source->file);
-      }
-      if (retval == SC_IO_ERROR_NONE && source->mirror != NULL) {
-        retval = sc_io_sink_write (source->mirror, data, bbytes_out);
-      }
-    }
-    else {
-      retval = fseek (source->file, (long) bytes_avail, SEEK_CUR);
-      bbytes_out = bytes_avail;
+  sc_array_init_data (view, (void *) data, elem_size, elem_count);
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_advise (sc_io_source_t * source, sc_io_advice_t advice)
+{
+  SC_ASSERT (0 <= advice && advice < SC_IO_ADVICE_LAST);
+
+#if defined SC_IO_MMAP && defined SC_HAVE_MADVISE
+  if (source->iotype == SC_IO_TYPE_MMAP && source->map != NULL) {
+    int                 flag;
+
+    flag = advice == SC_IO_ADVICE_SEQUENTIAL ? MADV_SEQUENTIAL :
+      advice == SC_IO_ADVICE_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+    if (madvise ((void *) source->map, source->map_bytes, flag) != 0) {
+      return SC_IO_ERROR_FATAL;
     }
   }
-  if (retval) {
+#endif
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_activate_readahead (sc_io_source_t * source, int num_buffers,
+                                 size_t buffer_bytes)
+{
+  if (source->iotype != SC_IO_TYPE_FILENAME &&
+      source->iotype != SC_IO_TYPE_FILEFILE) {
     return SC_IO_ERROR_FATAL;
   }
-  if (bytes_out == NULL && bbytes_out < bytes_avail) {
+  if (source->readahead != NULL || num_buffers < 2 || buffer_bytes == 0) {
     return SC_IO_ERROR_FATAL;
   }
 
-  if (bytes_out != NULL) {
-    *bytes_out = bbytes_out;
-  }
-  source->bytes_in += bbytes_out;
-  source->bytes_out += bbytes_out;
-
+#ifdef SC_HAVE_POSIX_FADVISE
+  /* let the kernel read ahead of the blocks as well */
+  (void) posix_fadvise (fileno (source->file), 0, 0,
+                        POSIX_FADV_SEQUENTIAL);
+#endif
+  source->readahead = sc_io_readahead_new (source->file, num_buffers,
+                                           buffer_bytes);
   return SC_IO_ERROR_NONE;
 }
 
-int
-sc_io_source_complete (sc_io_source_t * source,
-                       size_t * bytes_in, size_t * bytes_out)
+static int
+sc_io_source_complete_untimed (sc_io_source_t * source,
+                               size_t * bytes_in, size_t * bytes_out)
 {
   int                 retval = SC_IO_ERROR_NONE;
+  sc_io_codec_t      *codec = (sc_io_codec_t *) source->codec;
+
+  /* the trailer is verified once for the data since the last one */
+  if (source->checksum == SC_IO_CHECKSUM_RUNNING) {
+    char                trailer[SC_IO_CHECKSUM_BYTES];
+    char                expected[SC_IO_CHECKSUM_BYTES];
+
+    sc_io_checksum_trailer (source->crc, expected);
+    source->checksum = SC_IO_CHECKSUM_OFF;
+    retval = sc_io_source_read (source, trailer, SC_IO_CHECKSUM_BYTES,
+                                NULL);
+    if (!retval && codec != NULL && codec->in_frame) {
+      /* the trailer is last in its frame, whose end may follow */
+      retval = sc_io_source_read (source, NULL, 0, NULL);
+    }
+    source->checksum = SC_IO_CHECKSUM_SEALED;
+    source->crc = 0;
+    if (retval || memcmp (trailer, expected, SC_IO_CHECKSUM_BYTES)) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
 
+  if (codec != NULL &&
+      (codec->in_frame || codec->buf_pos < codec->buf_len)) {
+    return SC_IO_ERROR_AGAIN;
+  }
   if (source->iotype == SC_IO_TYPE_BUFFER) {
     SC_ASSERT (source->buffer != NULL);
     if (source->buffer_bytes % source->buffer->elem_size != 0) {
       return SC_IO_ERROR_AGAIN;
     }
   }
-  else if (source->iotype == SC_IO_TYPE_FILENAME ||
-           source->iotype == SC_IO_TYPE_FILEFILE) {
+  else if (source->mpifile != NULL &&
+           ((sc_io_mpifile_t *) source->mpifile)->section_pos <
+           ((sc_io_mpifile_t *) source->mpifile)->section->elem_count) {
+    return SC_IO_ERROR_AGAIN;
+  }
+  if (source->iotype != SC_IO_TYPE_BUFFER) {
     if (source->mirror != NULL) {
       retval = sc_io_sink_complete (source->mirror, NULL, NULL);
     }
@@ -332,6 +2976,102 @@ sc_io_source_complete (sc_io_source_t * source,
   return retval;
 }
 
+int
+sc_io_source_complete (sc_io_source_t * source,
+                       size_t * bytes_in, size_t * bytes_out)
+{
+  int                 retval;
+  double              start;
+
+  start = sc_io_timer_begin (source->timing);
+  retval = sc_io_source_complete_untimed (source, bytes_in, bytes_out);
+  sc_io_timer_end (source->timing, start, 1);
+
+  return retval;
+}
+
+int
+sc_io_source_activate_checksum (sc_io_source_t * source)
+{
+  if (source->checksum != SC_IO_CHECKSUM_OFF) {
+    return SC_IO_ERROR_FATAL;
+  }
+  source->checksum = SC_IO_CHECKSUM_RUNNING;
+  source->crc = 0;
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_io_source_activate_timing (sc_io_source_t * source)
+{
+  if (source->timing != NULL) {
+    return SC_IO_ERROR_FATAL;
+  }
+  source->timing = SC_ALLOC_ZERO (sc_io_timer_t, 1);
+  return SC_IO_ERROR_NONE;
+}
+
+void
+sc_io_source_timing (sc_io_source_t * source, sc_io_timing_t * timing)
+{
+  SC_ASSERT (timing != NULL);
+
+  if (source->timing != NULL) {
+    *timing = ((sc_io_timer_t *) source->timing)->counts;
+  }
+  else {
+    memset (timing, 0, sizeof (*timing));
+  }
+}
+
+/** Add a sample to a statistics variable, registering it if needed. */
+static void
+sc_io_timing_accumulate (sc_statistics_t * stats, const char *prefix,
+                         const char *suffix, const sc_io_timing_t * timing,
+                         double value)
+{
+  char                name[BUFSIZ];
+
+  snprintf (name, BUFSIZ, "%s%s", prefix, suffix);
+  if (!sc_statistics_has (stats, name)) {
+    sc_statistics_add_empty_ext (stats, name, 1);
+  }
+  if (timing != NULL) {
+    sc_statistics_accumulate (stats, name, value);
+  }
+}
+
+void
+sc_io_timing_statistics (sc_statistics_t * stats, const char *prefix,
+                         const sc_io_timing_t * timing)
+{
+  double              total_time, bandwidth;
+
+  SC_ASSERT (stats != NULL);
+  SC_ASSERT (prefix != NULL);
+
+  total_time = bandwidth = 0.;
+  if (timing != NULL) {
+    total_time = timing->io_time + timing->sync_time;
+    bandwidth = total_time > 0. ? timing->bytes / total_time / 1.e6 : 0.;
+  }
+  sc_io_timing_accumulate (stats, prefix, "_io_time", timing,
+                           timing != NULL ? timing->io_time : 0.);
+  sc_io_timing_accumulate (stats, prefix, "_sync_time", timing,
+                           timing != NULL ? timing->sync_time : 0.);
+  sc_io_timing_accumulate (stats, prefix, "_io_calls", timing,
+                           timing != NULL ? (double) timing->io_calls : 0.);
+  sc_io_timing_accumulate (stats, prefix, "_sync_calls", timing,
+                           timing != NULL ?
+                           (double) timing->sync_calls : 0.);
+  sc_io_timing_accumulate (stats, prefix, "_file_calls", timing,
+                           timing != NULL ?
+                           (double) timing->file_calls : 0.);
+  sc_io_timing_accumulate (stats, prefix, "_bytes", timing,
+                           timing != NULL ? (double) timing->bytes : 0.);
+  sc_io_timing_accumulate (stats, prefix, "_bandwidth", timing, bandwidth);
+}
+
 int
 sc_io_source_align (sc_io_source_t * source, size_t bytes_align)
 {
@@ -382,163 +3122,413 @@ sc_io_source_read_mirror (sc_io_source_t * source, void *data,
   return retval;
 }
 
+/** Format version of binary records. */
+#define SC_IO_RECORD_VERSION 1
+
+/** Magic bytes of an array record. */
+static const char   sc_io_array_magic[4] = { 'S', 'C', 'A', 'R' };
+
+/** Byte order tag of this machine: 1 for little, 2 for big endian. */
+static int
+sc_io_record_byte_order (void)
+{
+  const uint32_t      one = 1;
+
+  return *(const unsigned char *) &one == 1 ? 1 : 2;
+}
+
+/** Store a number into a header field in little endian. */
+static void
+sc_io_record_put (char *field, size_t value)
+{
+  int                 k;
+  uint64_t            v = (uint64_t) value;
+
+  for (k = 0; k < 8; ++k) {
+    field[k] = (char) ((v >> (8 * k)) & 0xff);
+  }
+}
+
+/** Load a number from a header field in little endian. */
+static int
+sc_io_record_get (const char *field, size_t *value)
+{
+  int                 k;
+  uint64_t            v = 0;
+
+  for (k = 7; k >= 0; --k) {
+    v = (v << 8) | (uint64_t) (unsigned char) field[k];
+  }
+  if (v > (uint64_t) SIZE_MAX) {
+    return SC_IO_ERROR_FATAL;
+  }
+  *value = (size_t) v;
+  return SC_IO_ERROR_NONE;
+}
+
 int
-sc_vtk_write_binary (FILE * vtkfile, char *numeric_data, size_t byte_length)
+sc_io_sink_write_record (sc_io_sink_t * sink, const char *magic,
+                         size_t elem_size, size_t elem_count, size_t aux,
+                         const void *data)
+{
+  char                header[SC_IO_RECORD_HEADER_BYTES];
+  sc_io_vec_t         vec[2];
+
+  SC_ASSERT (magic != NULL);
+  SC_ASSERT (elem_count == 0 || elem_size <= SIZE_MAX / elem_count);
+
+  memset (header, 0, SC_IO_RECORD_HEADER_BYTES);
+  memcpy (header, magic, 4);
+  header[4] = (char) SC_IO_RECORD_VERSION;
+  header[5] = (char) sc_io_record_byte_order ();
+  sc_io_record_put (header + 8, elem_size);
+  sc_io_record_put (header + 16, elem_count);
+  sc_io_record_put (header + 24, aux);
+
+  /* the header and the data are passed on in one call without copying */
+  vec[0].base = header;
+  vec[0].bytes = SC_IO_RECORD_HEADER_BYTES;
+  if (data == NULL || elem_size * elem_count == 0) {
+    return sc_io_sink_writev (sink, vec, 1);
+  }
+  vec[1].base = (void *) data;
+  vec[1].bytes = elem_size * elem_count;
+  return sc_io_sink_writev (sink, vec, 2);
+}
+
+int
+sc_io_source_read_record (sc_io_source_t * source, const char *magic,
+                          size_t *elem_size, size_t *elem_count, size_t *aux)
+{
+  char                header[SC_IO_RECORD_HEADER_BYTES];
+  size_t              lvalue;
+
+  SC_ASSERT (magic != NULL);
+  SC_ASSERT (elem_size != NULL && elem_count != NULL);
+
+  if (sc_io_source_read (source, header, SC_IO_RECORD_HEADER_BYTES, NULL) ||
+      memcmp (header, magic, 4) ||
+      header[4] != (char) SC_IO_RECORD_VERSION ||
+      header[5] != (char) sc_io_record_byte_order () ||
+      sc_io_record_get (header + 8, elem_size) ||
+      sc_io_record_get (header + 16, elem_count) ||
+      sc_io_record_get (header + 24, &lvalue)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (*elem_count > 0 && *elem_size > SIZE_MAX / *elem_count) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (aux != NULL) {
+    *aux = lvalue;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_array_write (const sc_array_t * array, sc_io_sink_t * sink)
+{
+  SC_ASSERT (array != NULL);
+
+  return sc_io_sink_write_record (sink, sc_io_array_magic, array->elem_size,
+                                  array->elem_count, 0, array->array);
+}
+
+int
+sc_array_read (sc_array_t * array, sc_io_source_t * source)
+{
+  size_t              elem_size, elem_count;
+
+  SC_ASSERT (array != NULL);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (sc_io_source_read_record (source, sc_io_array_magic,
+                                &elem_size, &elem_count, NULL) ||
+      elem_size != array->elem_size) {
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* the elements go straight into the array memory */
+  sc_array_resize (array, elem_count);
+  if (elem_count == 0) {
+    return SC_IO_ERROR_NONE;
+  }
+  return sc_io_source_read (source, array->array, elem_size * elem_count,
+                            NULL);
+}
+
+int
+sc_array_read_view (sc_array_t * view, sc_io_source_t * source)
+{
+  size_t              elem_size, elem_count;
+
+  SC_ASSERT (view != NULL);
+
+  if (sc_io_source_read_record (source, sc_io_array_magic,
+                                &elem_size, &elem_count, NULL) ||
+      elem_size == 0) {
+    return SC_IO_ERROR_FATAL;
+  }
+  if (elem_count == 0) {
+    sc_array_init_data (view, NULL, elem_size, 0);
+    return SC_IO_ERROR_NONE;
+  }
+  return sc_io_source_view_array (source, view, elem_size, elem_count);
+}
+
+int
+sc_hash_array_write (sc_hash_array_t * hash_array, sc_io_sink_t * sink)
+{
+  SC_ASSERT (hash_array != NULL);
+
+  return sc_array_write (&hash_array->a, sink);
+}
+
+int
+sc_hash_array_read (sc_hash_array_t * hash_array, sc_io_source_t * source)
+{
+  SC_ASSERT (hash_array != NULL);
+
+  /* the table is rebuilt from the array on the next use */
+  sc_hash_array_truncate (hash_array);
+  if (sc_array_read (&hash_array->a, source)) {
+    sc_hash_array_truncate (hash_array);
+    return SC_IO_ERROR_FATAL;
+  }
+  SC_ASSERT (hash_array->num_hashed == 0);
+  return SC_IO_ERROR_NONE;
+}
+
+/** Plain bytes encoded at a time when streaming base64 output. */
+#define SC_VTK_CODE_CHUNK 3072
+
+/** Base64 code streamed through a fixed buffer into a file or a sink. */
+typedef struct sc_vtk_base64
+{
+  FILE               *file;
+  sc_io_sink_t       *sink;
+  int                 error;
+  base64_encodestate  state;
+  char                code[4 * SC_VTK_CODE_CHUNK / 3 + 4];
+}
+sc_vtk_base64_t;
+
+static void
+sc_vtk_base64_init (sc_vtk_base64_t * b64, FILE * file, sc_io_sink_t * sink)
+{
+  SC_ASSERT ((file == NULL) != (sink == NULL));
+
+  b64->file = file;
+  b64->sink = sink;
+  b64->error = 0;
+  base64_init_encodestate (&b64->state);
+}
+
+static void
+sc_vtk_base64_flush (sc_vtk_base64_t * b64, size_t code_length)
+{
+  SC_ASSERT (code_length <= sizeof (b64->code));
+
+  if (b64->file != NULL) {
+    (void) fwrite (b64->code, 1, code_length, b64->file);
+  }
+  else if (sc_io_sink_write (b64->sink, b64->code, code_length)) {
+    b64->error = 1;
+  }
+}
+
+static void
+sc_vtk_base64_write (sc_vtk_base64_t * b64, const char *data, size_t length)
+{
+  size_t              chunk;
+
+  while (length > 0) {
+    chunk = SC_MIN (length, SC_VTK_CODE_CHUNK);
+    sc_vtk_base64_flush (b64, base64_encode_block (data, chunk, b64->code,
+                                                   &b64->state));
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+/* finish the current base64 stream and begin a new one */
+static void
+sc_vtk_base64_end (sc_vtk_base64_t * b64)
+{
+  sc_vtk_base64_flush (b64, base64_encode_blockend (b64->code, &b64->state));
+  base64_init_encodestate (&b64->state);
+}
+
+static int
+sc_vtk_write_binary_base64 (sc_vtk_base64_t * b64, const char *numeric_data,
+                            size_t byte_length)
 {
-  size_t              chunks, chunksize, remaining, writenow;
-  size_t              code_length, base_length;
   uint32_t            int_header;
-  char               *base_data;
-  base64_encodestate  encode_state;
 
   /* VTK format used 32bit header info */
   SC_ASSERT (byte_length <= (size_t) UINT32_MAX);
-
-  /* This value may be changed although this is not tested with VTK */
-  chunksize = (size_t) 1 << 15; /* 32768 */
   int_header = (uint32_t) byte_length;
 
-  /* Allocate sufficient memory for base64 encoder */
-  code_length = 2 * SC_MAX (chunksize, sizeof (int_header));
-  code_length = SC_MAX (code_length, 4) + 1;
-  base_data = SC_ALLOC (char, code_length);
-
-  base64_init_encodestate (&encode_state);
-  base_length =
-    base64_encode_block ((char *) &int_header, sizeof (int_header), base_data,
-                         &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  chunks = 0;
-  remaining = byte_length;
-  while (remaining > 0) {
-    writenow = SC_MIN (remaining, chunksize);
-    base_length = base64_encode_block (numeric_data + chunks * chunksize,
-                                       writenow, base_data, &encode_state);
-    SC_ASSERT (base_length < code_length);
-    base_data[base_length] = '\0';
-    (void) fwrite (base_data, 1, base_length, vtkfile);
-    remaining -= writenow;
-    ++chunks;
-  }
-
-  base_length = base64_encode_blockend (base_data, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  SC_FREE (base_data);
-  if (ferror (vtkfile)) {
+  sc_vtk_base64_write (b64, (const char *) &int_header, sizeof (int_header));
+  sc_vtk_base64_write (b64, numeric_data, byte_length);
+  sc_vtk_base64_end (b64);
+
+  return b64->error ? -1 : 0;
+}
+
+int
+sc_vtk_write_binary (FILE * vtkfile, char *numeric_data, size_t byte_length)
+{
+  sc_vtk_base64_t     b64;
+
+  sc_vtk_base64_init (&b64, vtkfile, NULL);
+  if (sc_vtk_write_binary_base64 (&b64, numeric_data, byte_length) ||
+      ferror (vtkfile)) {
     return -1;
   }
   return 0;
 }
 
+int
+sc_vtk_write_binary_sink (sc_io_sink_t * sink, const char *numeric_data,
+                          size_t byte_length)
+{
+  sc_vtk_base64_t     b64;
+
+  sc_vtk_base64_init (&b64, NULL, sink);
+  return sc_vtk_write_binary_base64 (&b64, numeric_data, byte_length);
+}
+
 int
 sc_vtk_write_compressed (FILE * vtkfile, char *numeric_data,
                          size_t byte_length)
 {
 #ifdef SC_HAVE_ZLIB
-  int                 retval, fseek1, fseek2;
-  size_t              iz;
-  size_t              blocksize, lastsize;
-  size_t              theblock, numregularblocks, numfullblocks;
-  size_t              header_entries, header_size;
-  size_t              code_length, base_length;
-  long                header_pos, final_pos;
-  char               *comp_data, *base_data;
+  return sc_vtk_write_compressed_ext (vtkfile, numeric_data, byte_length,
+                                      Z_BEST_COMPRESSION, 0);
+#else
+  SC_ABORT ("Configure did not find a recent enough zlib.  Abort.\n");
+  return -1;
+#endif
+}
+
+#ifdef SC_HAVE_ZLIB
+
+/* Blocks are compressed concurrently in batches of about this many bytes. */
+#define SC_VTK_BATCH_BYTES (1 << 23)
+
+#ifdef SC_ENABLE_OPENMP
+#define SC_VTK_FOR _Pragma \
+  ("omp parallel for schedule (dynamic) reduction (|:failed)")
+#else
+#define SC_VTK_FOR
+#endif
+
+/** Compress consecutive blocks independently of each other.
+ * The compressed block \a ib is placed at \a comp_data + \a ib * \a bound.
+ */
+static void
+sc_vtk_compress_blocks (const char *numeric_data, size_t byte_length,
+                        size_t blocksize, int level, size_t first,
+                        size_t num_blocks, char *comp_data, size_t bound,
+                        uLongf * comp_lengths)
+{
+  int                 failed = 0;
+  size_t              ib;
+
+  SC_VTK_FOR
+  for (ib = 0; ib < num_blocks; ++ib) {
+    const size_t        offset = (first + ib) * blocksize;
+
+    comp_lengths[ib] = (uLongf) bound;
+    failed |= Z_OK !=
+      compress2 ((Bytef *) (comp_data + ib * bound), &comp_lengths[ib],
+                 (const Bytef *) (numeric_data + offset),
+                 (uLong) SC_MIN (blocksize, byte_length - offset), level);
+  }
+  SC_CHECK_ABORT (!failed, "zlib error");
+}
+
+/* prepare the block sizes and the dummy header of compressed data */
+static              uint32_t *
+sc_vtk_compressed_header (size_t byte_length, size_t * blocksize,
+                          size_t * num_blocks, size_t * header_size)
+{
+  size_t              lastsize;
   uint32_t           *compression_header;
-  uLongf              comp_length;
-  base64_encodestate  encode_state;
-
-  /* compute block sizes */
-  blocksize = (size_t) (1 << 15);       /* 32768 */
-  lastsize = byte_length % blocksize;
-  numregularblocks = byte_length / blocksize;
-  numfullblocks = numregularblocks + (lastsize > 0 ? 1 : 0);
-  header_entries = 3 + numfullblocks;
-  header_size = header_entries * sizeof (uint32_t);
-
-  /* allocate compression and base64 arrays */
-  code_length = 2 * SC_MAX (blocksize, header_size) + 4 + 1;
-  comp_data = SC_ALLOC (char, code_length);
-  base_data = SC_ALLOC (char, code_length);
-
-  /* figure out the size of the header and write a dummy */
-  compression_header = SC_ALLOC (uint32_t, header_entries);
-  compression_header[0] = (uint32_t) numfullblocks;
-  compression_header[1] = (uint32_t) blocksize;
+
+  if (*blocksize == 0) {
+    *blocksize = (size_t) (1 << 15);    /* 32768 */
+  }
+  SC_ASSERT (*blocksize <= (size_t) UINT32_MAX);
+  lastsize = byte_length % *blocksize;
+  *num_blocks = byte_length / *blocksize + (lastsize > 0 ? 1 : 0);
+  *header_size = (3 + *num_blocks) * sizeof (uint32_t);
+
+  compression_header = SC_ALLOC_ZERO (uint32_t, 3 + *num_blocks);
+  compression_header[0] = (uint32_t) * num_blocks;
+  compression_header[1] = (uint32_t) * blocksize;
   compression_header[2] = (uint32_t)
-    (lastsize > 0 || byte_length == 0 ? lastsize : blocksize);
-  for (iz = 3; iz < header_entries; ++iz) {
-    compression_header[iz] = 0;
-  }
-  base64_init_encodestate (&encode_state);
-  base_length = base64_encode_block ((char *) compression_header,
-                                     header_size, base_data, &encode_state);
-  base_length +=
-    base64_encode_blockend (base_data + base_length, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
+    (lastsize > 0 || byte_length == 0 ? lastsize : *blocksize);
+  return compression_header;
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+int
+sc_vtk_write_compressed_ext (FILE * vtkfile, char *numeric_data,
+                             size_t byte_length, int level, size_t blocksize)
+{
+#ifdef SC_HAVE_ZLIB
+  int                 fseek1, fseek2;
+  size_t              ib, bound;
+  size_t              first, batchsize, numbatch;
+  size_t              num_blocks, header_size;
+  long                header_pos, final_pos;
+  char               *comp_data;
+  uint32_t           *compression_header;
+  uLongf             *comp_lengths;
+  sc_vtk_base64_t     b64;
+
+  SC_ASSERT (Z_DEFAULT_COMPRESSION <= level && level <= Z_BEST_COMPRESSION);
+
+  /* write a dummy header to be overwritten at the end */
+  compression_header = sc_vtk_compressed_header (byte_length, &blocksize,
+                                                 &num_blocks, &header_size);
+  sc_vtk_base64_init (&b64, vtkfile, NULL);
   header_pos = ftell (vtkfile);
-  (void) fwrite (base_data, 1, base_length, vtkfile);
-
-  /* write the regular data blocks */
-  base64_init_encodestate (&encode_state);
-  for (theblock = 0; theblock < numregularblocks; ++theblock) {
-    comp_length = code_length;
-    retval = compress2 ((Bytef *) comp_data, &comp_length,
-                        (const Bytef *) (numeric_data + theblock * blocksize),
-                        (uLong) blocksize, Z_BEST_COMPRESSION);
-    SC_CHECK_ZLIB (retval);
-    compression_header[3 + theblock] = comp_length;
-    base_length = base64_encode_block (comp_data, comp_length,
-                                       base_data, &encode_state);
-    SC_ASSERT (base_length < code_length);
-    base_data[base_length] = '\0';
-    (void) fwrite (base_data, 1, base_length, vtkfile);
-  }
-
-  /* write odd-sized last block if necessary */
-  if (lastsize > 0) {
-    comp_length = code_length;
-    retval = compress2 ((Bytef *) comp_data, &comp_length,
-                        (const Bytef *) (numeric_data + theblock * blocksize),
-                        (uLong) lastsize, Z_BEST_COMPRESSION);
-    SC_CHECK_ZLIB (retval);
-    compression_header[3 + theblock] = comp_length;
-    base_length = base64_encode_block (comp_data, comp_length,
-                                       base_data, &encode_state);
-    SC_ASSERT (base_length < code_length);
-    base_data[base_length] = '\0';
-    (void) fwrite (base_data, 1, base_length, vtkfile);
-  }
-
-  /* write base64 end block */
-  base_length = base64_encode_blockend (base_data, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
-  (void) fwrite (base_data, 1, base_length, vtkfile);
+  sc_vtk_base64_write (&b64, (const char *) compression_header,
+                       header_size);
+  sc_vtk_base64_end (&b64);
+
+  /* a batch of blocks is compressed at a time, then encoded in order */
+  batchsize = SC_MAX (SC_VTK_BATCH_BYTES / blocksize, 1);
+  batchsize = SC_MIN (batchsize, SC_MAX (num_blocks, 1));
+  bound = (size_t) compressBound ((uLong) blocksize);
+  comp_data = SC_ALLOC (char, batchsize * bound);
+  comp_lengths = SC_ALLOC (uLongf, batchsize);
+  for (first = 0; first < num_blocks; first += numbatch) {
+    numbatch = SC_MIN (batchsize, num_blocks - first);
+    sc_vtk_compress_blocks (numeric_data, byte_length, blocksize, level,
+                            first, numbatch, comp_data, bound, comp_lengths);
+    for (ib = 0; ib < numbatch; ++ib) {
+      compression_header[3 + first + ib] = (uint32_t) comp_lengths[ib];
+      sc_vtk_base64_write (&b64, comp_data + ib * bound, comp_lengths[ib]);
+    }
+  }
+  sc_vtk_base64_end (&b64);
+  SC_FREE (comp_lengths);
+  SC_FREE (comp_data);
 
   /* seek back, write header block, seek forward */
   final_pos = ftell (vtkfile);
-  base64_init_encodestate (&encode_state);
-  base_length = base64_encode_block ((char *) compression_header,
-                                     header_size, base_data, &encode_state);
-  base_length +=
-    base64_encode_blockend (base_data + base_length, &encode_state);
-  SC_ASSERT (base_length < code_length);
-  base_data[base_length] = '\0';
   fseek1 = fseek (vtkfile, header_pos, SEEK_SET);
-  (void) fwrite (base_data, 1, base_length, vtkfile);
+  sc_vtk_base64_write (&b64, (const char *) compression_header,
+                       header_size);
+  sc_vtk_base64_end (&b64);
   fseek2 = fseek (vtkfile, final_pos, SEEK_SET);
 
   /* clean up and return */
   SC_FREE (compression_header);
-  SC_FREE (comp_data);
-  SC_FREE (base_data);
   if (fseek1 != 0 || fseek2 != 0 || ferror (vtkfile)) {
     return -1;
   }
@@ -549,6 +3539,53 @@ sc_vtk_write_compressed (FILE * vtkfile, char *numeric_data,
   return 0;
 }
 
+int
+sc_vtk_write_compressed_sink (sc_io_sink_t * sink, const char *numeric_data,
+                              size_t byte_length, int level,
+                              size_t blocksize)
+{
+#ifdef SC_HAVE_ZLIB
+  size_t              ib, bound;
+  size_t              num_blocks, header_size;
+  char               *comp_data;
+  uint32_t           *compression_header;
+  uLongf             *comp_lengths;
+  sc_vtk_base64_t     b64;
+
+  SC_ASSERT (Z_DEFAULT_COMPRESSION <= level && level <= Z_BEST_COMPRESSION);
+
+  /* the header precedes the data, so all blocks are compressed first */
+  compression_header = sc_vtk_compressed_header (byte_length, &blocksize,
+                                                 &num_blocks, &header_size);
+  bound = (size_t) compressBound ((uLong) blocksize);
+  comp_data = SC_ALLOC (char, SC_MAX (num_blocks, 1) * bound);
+  comp_lengths = SC_ALLOC (uLongf, SC_MAX (num_blocks, 1));
+  sc_vtk_compress_blocks (numeric_data, byte_length, blocksize, level,
+                          0, num_blocks, comp_data, bound, comp_lengths);
+  for (ib = 0; ib < num_blocks; ++ib) {
+    compression_header[3 + ib] = (uint32_t) comp_lengths[ib];
+  }
+
+  /* write header and data as two base64 streams */
+  sc_vtk_base64_init (&b64, NULL, sink);
+  sc_vtk_base64_write (&b64, (const char *) compression_header,
+                       header_size);
+  sc_vtk_base64_end (&b64);
+  for (ib = 0; ib < num_blocks; ++ib) {
+    sc_vtk_base64_write (&b64, comp_data + ib * bound, comp_lengths[ib]);
+  }
+  sc_vtk_base64_end (&b64);
+
+  SC_FREE (comp_lengths);
+  SC_FREE (comp_data);
+  SC_FREE (compression_header);
+  return b64.error ? -1 : 0;
+#else
+  SC_ABORT ("Configure did not find a recent enough zlib.  Abort.\n");
+  return -1;
+#endif
+}
+
 void
 sc_fwrite (const void *ptr, size_t size, size_t nmemb, FILE * file,
            const char *errmsg)
@@ -26,6 +26,7 @@
 
 #include <sc.h>
 #include <sc_containers.h>
+#include <sc_statistics.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -48,9 +49,19 @@ typedef enum
 }
 sc_io_mode_t;
 
+/** Encodings of the data passed through sinks and sources.
+ * The compressed encodings are streaming formats that are only available
+ * if libsc has been configured with the respective library, see
+ * \ref sc_io_encode_available.  A sink writes one compressed frame between
+ * two calls to \ref sc_io_sink_complete, and a source decodes any number
+ * of consecutive frames.
+ */
 typedef enum
 {
   SC_IO_ENCODE_NONE,
+  SC_IO_ENCODE_ZLIB,    /**< zlib stream, requires zlib */
+  SC_IO_ENCODE_ZSTD,    /**< zstd frames, requires libzstd */
+  SC_IO_ENCODE_LZ4,     /**< LZ4 frames, requires liblz4 */
   SC_IO_ENCODE_LAST     /**< Invalid entry to close list */
 }
 sc_io_encode_t;
@@ -60,10 +71,70 @@ typedef enum
   SC_IO_TYPE_BUFFER,
   SC_IO_TYPE_FILENAME,
   SC_IO_TYPE_FILEFILE,
+  SC_IO_TYPE_MMAP,      /**< File mapped into memory, only for sources */
+  SC_IO_TYPE_MPIFILE,   /**< File shared by the ranks of a communicator */
+  SC_IO_TYPE_AGGREGATE, /**< One file per group of nodes, written by
+                             the group's first rank */
+  SC_IO_TYPE_BCAST,     /**< File read by one rank and broadcast to all,
+                             only for sources */
   SC_IO_TYPE_LAST       /**< Invalid entry to close list */
 }
 sc_io_type_t;
 
+/** Hints for opening a file of type MPIFILE.
+ * A value of zero leaves the choice to the MPI implementation.
+ */
+typedef struct sc_io_mpifile_hints
+{
+  int                 num_aggregators;  /**< Ranks that access the file
+                                             in collective buffering. */
+  int                 stripe_count;     /**< Number of file system stripes. */
+  size_t              stripe_bytes;     /**< Size of a file system stripe.
+                                             Each section of the file is
+                                             aligned to it, see
+                                             \ref sc_io_sink_complete. */
+}
+sc_io_mpifile_hints_t;
+
+/** A piece of memory for vectored writes and reads.
+ * \see sc_io_sink_writev and sc_io_source_readv.
+ */
+typedef struct sc_io_vec
+{
+  void               *base;     /**< Start of the memory, not NULL. */
+  size_t              bytes;    /**< Number of bytes. */
+}
+sc_io_vec_t;
+
+/** Access pattern hints for a memory-mapped source.
+ * \see sc_io_source_advise.
+ */
+typedef enum
+{
+  SC_IO_ADVICE_NORMAL,  /**< No particular access pattern. */
+  SC_IO_ADVICE_SEQUENTIAL,      /**< Read ahead aggressively. */
+  SC_IO_ADVICE_RANDOM,  /**< Read only the pages that are accessed. */
+  SC_IO_ADVICE_LAST     /**< Invalid entry to close list */
+}
+sc_io_advice_t;
+
+/** Time spent and calls made by a sink or source.
+ * \see sc_io_sink_activate_timing and sc_io_source_activate_timing.
+ */
+typedef struct sc_io_timing
+{
+  double              io_time;  /**< seconds in write or read calls */
+  double              sync_time;        /**< seconds in complete calls and
+                                             sections of an MPIFILE */
+  long                io_calls; /**< number of write or read calls */
+  long                sync_calls;       /**< number of complete and section
+                                             calls */
+  long                file_calls;       /**< calls to stdio, POSIX and MPI
+                                             I/O made for the data */
+  size_t              bytes;    /**< bytes moved to or from the medium */
+}
+sc_io_timing_t;
+
 typedef struct sc_io_sink
 {
   sc_io_type_t        iotype;
@@ -74,6 +145,12 @@ typedef struct sc_io_sink
   FILE               *file;
   size_t              bytes_in;
   size_t              bytes_out;
+  void               *codec;    /**< state of a compressed encoding */
+  void               *async;    /**< staging buffers of an async sink */
+  void               *mpifile;  /**< file of type MPIFILE or AGGREGATE */
+  int                 checksum; /**< state of an appended checksum */
+  uint32_t            crc;      /**< CRC32C of data since the last trailer */
+  void               *timing;   /**< counters of an activated timing */
 }
 sc_io_sink_t;
 
@@ -88,9 +165,47 @@ typedef struct sc_io_source
   size_t              bytes_out;
   sc_io_sink_t       *mirror;
   sc_array_t         *mirror_buffer;
+  void               *codec;    /**< state of a compressed encoding */
+  const char         *map;      /**< file contents for type MMAP or BCAST */
+  size_t              map_bytes;        /**< length of the mapping */
+  size_t              map_pos;  /**< read position in the mapping */
+  void               *mpifile;  /**< file of type MPIFILE or AGGREGATE */
+  int                 checksum; /**< state of a verified checksum */
+  uint32_t            crc;      /**< CRC32C of data since the last trailer */
+  void               *timing;   /**< counters of an activated timing */
+  void               *bcast;    /**< shared memory of type BCAST or NULL */
+  void               *readahead;        /**< blocks of a file read ahead */
 }
 sc_io_source_t;
 
+/** Query whether an encoding is supported by this build.
+ * \param [in] encode           Type of data encoding.
+ * \return                      True if sinks and sources can be created
+ *                              with this encoding.
+ */
+int                 sc_io_encode_available (sc_io_encode_t encode);
+
+/** Compute the CRC32C (Castagnoli) checksum of data.
+ * The SSE 4.2 or ARMv8 CRC instructions are used where available.
+ * \param [in] crc              Checksum of the preceding data to continue,
+ *                              or 0 to begin a new checksum.
+ * \param [in] data             Data to add to the checksum.
+ * \param [in] bytes            Number of data bytes.
+ * \return                      Checksum of the preceding data and data.
+ */
+uint32_t            sc_io_crc32c (uint32_t crc, const void *data,
+                                  size_t bytes);
+
+/** Combine the CRC32C checksums of two consecutive pieces of data.
+ * \param [in] crc1             Checksum of the first piece.
+ * \param [in] crc2             Checksum of the second piece, begun with 0.
+ * \param [in] bytes2           Length of the second piece in bytes.
+ * \return                      Checksum of both pieces one after another.
+ *                              The cost is logarithmic in \a bytes2.
+ */
+uint32_t            sc_io_crc32c_combine (uint32_t crc1, uint32_t crc2,
+                                          size_t bytes2);
+
 /** Create a generic data sink.
  * \param [in] iotype           Type of the sink.
  *                              Depending on iotype, varargs must follow:
@@ -98,10 +213,31 @@ sc_io_source_t;
  *                              FILENAME: const char * (name of file to open).
  *                              FILEFILE: FILE * (file open for writing).
  *                              These buffers are only borrowed by the sink.
+ *                              MMAP and BCAST are not supported for sinks.
+ *                              MPIFILE: sc_MPI_Comm (communicator),
+ *                              const char * (name of file to open),
+ *                              const sc_io_mpifile_hints_t * (may be NULL).
+ *                              This type is collective over the
+ *                              communicator and requires MPI I/O when
+ *                              configured with MPI.
+ *                              AGGREGATE: sc_MPI_Comm (communicator),
+ *                              const char * (file name prefix),
+ *                              int (number of nodes per file).
+ *                              This type is collective over the
+ *                              communicator.  The ranks are grouped by
+ *                              the nodes of \ref
+ *                              sc_mpi_comm_attach_node_comms, or else
+ *                              each rank counts as a node.  The first
+ *                              rank of each group writes the file
+ *                              prefix_gggg, where gggg is the group.
  * \param [in] mode             Mode to add data to sink.
  *                              For type FILEFILE, data is always appended.
- * \param [in] encode           Type of data encoding.
- * \return                      Newly allocated sink, or NULL on error.
+ * \param [in] encode           Type of data encoding.  With compression,
+ *                              bytes_in counts the raw and bytes_out the
+ *                              encoded bytes.  A BUFFER sink should then
+ *                              have an element size of 1.
+ * \return                      Newly allocated sink, or NULL on error,
+ *                              including an unavailable encoding.
  */
 sc_io_sink_t       *sc_io_sink_new (sc_io_type_t iotype,
                                     sc_io_mode_t mode,
@@ -126,7 +262,31 @@ int                 sc_io_sink_destroy (sc_io_sink_t * sink);
 int                 sc_io_sink_write (sc_io_sink_t * sink,
                                       const void *data, size_t bytes_avail);
 
+/** Write several pieces of memory to a sink one after another.
+ * The result is the same as calling \ref sc_io_sink_write for each piece.
+ * A BUFFER sink is resized once for all pieces.  A FILENAME or FILEFILE
+ * sink without encoding or asynchronous writing uses writev (2) where
+ * available, bypassing the stream buffer.
+ * \param [in,out] sink         The sink object to write to.
+ * \param [in] vec              Array of pieces to write.
+ * \param [in] count            Number of pieces.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_sink_writev (sc_io_sink_t * sink,
+                                       const sc_io_vec_t * vec, int count);
+
 /** Flush all buffered output data to sink.
+ * For the type MPIFILE this function is collective.  The data written by
+ * all ranks since the last complete call forms a section of the file, in
+ * which the ranks' data is concatenated in rank order.  It is written by
+ * one collective operation.  With a stripe size hint, each section starts
+ * at a multiple of the stripe size; if each rank additionally calls
+ * \ref sc_io_sink_align with the stripe size before completing, no two
+ * ranks share a stripe.
+ * For the type AGGREGATE this function is collective, too.  The data of
+ * the ranks of a group is sent to its first rank, which appends a section
+ * to its file: a table of the group size and the byte count of each rank,
+ * followed by the data in rank order.
  * This function may return SC_IO_ERROR_AGAIN if another write is required.
  * Currently this may happen if BUFFER requires an integer multiple of bytes.
  * If successful, the updated value of bytes read and written is returned
@@ -137,6 +297,8 @@ int                 sc_io_sink_write (sc_io_sink_t * sink,
  * The sink actions taken depend on its type.
  * BUFFER, FILEFILE: none.
  * FILENAME: call fclose on sink->file.
+ * With a checksum, its trailer is written before anything else.
+ * With a compressed encoding, the current frame is finished first.
  * \param [in,out] sink         The sink object to write to.
  * \param [in,out] bytes_in     Bytes received since the last new or complete
  *                              call.  May be NULL.
@@ -148,7 +310,67 @@ int                 sc_io_sink_complete (sc_io_sink_t * sink,
                                          size_t * bytes_in,
                                          size_t * bytes_out);
 
+/** Write the data of a file sink asynchronously through staging buffers.
+ * Writes are copied into one buffer at a time; a full buffer is queued and
+ * written by a background thread while the caller continues.  The caller
+ * only waits if all buffers are queued.  \ref sc_io_sink_complete is the
+ * synchronization point: it returns after all data is written and flushed,
+ * and, if requested, synced to disk.  Write errors of the background
+ * thread are reported by the next write or complete call.
+ * Without --enable-pthread, the buffers are written by the caller when
+ * full, which still collects small writes into large ones.
+ * \param [in,out] sink         Sink of type FILENAME or FILEFILE.
+ * \param [in] num_buffers      Number of staging buffers, at least 2.
+ * \param [in] buffer_bytes     Size of each staging buffer.
+ * \param [in] sync             If true, complete also calls fsync (2).
+ * \return                      0 on success, nonzero on error, including
+ *                              a sink of another type or one already
+ *                              writing asynchronously.
+ */
+int                 sc_io_sink_activate_async (sc_io_sink_t * sink,
+                                               int num_buffers,
+                                               size_t buffer_bytes,
+                                               int sync);
+
+/** Append a checksum to the data written to a sink.
+ * From now on, a CRC32C of the data passed to the sink is computed while
+ * it is written.  Each call to \ref sc_io_sink_complete first writes an
+ * eight byte trailer, four magic bytes followed by the CRC32C in little
+ * endian byte order, and then begins a new checksum.  The trailer is
+ * written like other data, so with a compressed encoding it is
+ * compressed, and it counts towards bytes_in and bytes_out.  If no data
+ * has been written since the last trailer, no further trailer is written.
+ * A source reads the data back with \ref sc_io_source_activate_checksum.
+ * \param [in,out] sink         The sink object to checksum.
+ * \return                      0 on success, nonzero if a checksum is
+ *                              already active.
+ */
+int                 sc_io_sink_activate_checksum (sc_io_sink_t * sink);
+
+/** Measure the time spent in the calls of a sink.
+ * From now on, the wall clock time of the write, writev and align calls
+ * and of the complete calls is accumulated, as well as the number of
+ * these calls and of the calls to the underlying file interface, and the
+ * bytes moved to the medium, which are the encoded bytes with
+ * compression.  A call made by another call of the sink is not counted
+ * separately.  Writes done by the thread of an asynchronous sink are
+ * included in the time of its complete calls only.
+ * \param [in,out] sink         The sink object to measure.
+ * \return                      0 on success, nonzero if the timing is
+ *                              already active.
+ */
+int                 sc_io_sink_activate_timing (sc_io_sink_t * sink);
+
+/** Query the counters of a sink.
+ * \param [in] sink             The sink object.
+ * \param [out] timing          The counters accumulated since activating
+ *                              the timing, or all zero if not activated.
+ */
+void                sc_io_sink_timing (sc_io_sink_t * sink,
+                                       sc_io_timing_t * timing);
+
 /** Align sink to a byte boundary by writing zeros.
+ * With a compressed encoding, the raw data written is aligned.
  * \param [in,out] sink         The sink object to align.
  * \param [in] bytes_align      Byte boundary.
  * \return                      0 on success, nonzero on error.
@@ -162,8 +384,31 @@ int                 sc_io_sink_align (sc_io_sink_t * sink,
  *                              BUFFER: sc_array_t * (existing array).
  *                              FILENAME: const char * (name of file to open).
  *                              FILEFILE: FILE * (file open for reading).
- * \param [in] encode           Type of data encoding.
- * \return                      Newly allocated source, or NULL on error.
+ *                              MMAP: const char * (name of file to map).
+ *                              The whole file is mapped read-only; this
+ *                              type is not available without mmap (2).
+ *                              MPIFILE, AGGREGATE: as for
+ *                              \ref sc_io_sink_new.  An AGGREGATE source
+ *                              requires the grouping of the sink.
+ *                              Data is only available after calling
+ *                              \ref sc_io_source_section.
+ *                              BCAST: sc_MPI_Comm (communicator), int
+ *                              (root rank), const char * (name of file,
+ *                              only accessed on the root), int (if true,
+ *                              place the contents in node-shared memory
+ *                              with \ref sc_shmem_malloc).  The root reads
+ *                              the whole file and broadcasts it, so the
+ *                              other ranks do not access the file system.
+ *                              Creating and destroying this source is
+ *                              collective, and it returns NULL on all
+ *                              ranks if the root cannot read the file.
+ * \param [in] encode           Type of data encoding.  With compression,
+ *                              the source must contain only encoded data,
+ *                              which is read ahead in blocks.  Then
+ *                              bytes_in counts the encoded bytes read and
+ *                              bytes_out the decoded bytes passed out.
+ * \return                      Newly allocated source, or NULL on error,
+ *                              including an unavailable encoding.
  */
 sc_io_source_t     *sc_io_source_new (sc_io_type_t iotype,
                                       sc_io_encode_t encode, ...);
@@ -196,25 +441,186 @@ int                 sc_io_source_read (sc_io_source_t * source,
                                        void *data, size_t bytes_avail,
                                        size_t * bytes_out);
 
+/** Read into several pieces of memory one after another.
+ * The result is the same as calling \ref sc_io_source_read for each piece
+ * until one is not filled completely.  A seekable FILENAME or FILEFILE
+ * source without encoding or mirror uses preadv (2) where available.
+ * \param [in,out] source       The source object to read from.
+ * \param [in] vec              Array of pieces to fill.
+ * \param [in] count            Number of pieces.
+ * \param [in,out] bytes_out    If not NULL, total byte count read.
+ *                              Otherwise, requires to fill all pieces.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_source_readv (sc_io_source_t * source,
+                                        const sc_io_vec_t * vec, int count,
+                                        size_t * bytes_out);
+
+/** Collectively read the next section of a source of type MPIFILE
+ * or AGGREGATE.
+ * The sections must match those written by a sink of the same type with
+ * the same stripe size hint or grouping, and each rank must pass the
+ * number of bytes it contributed to the section.  For MPIFILE, the
+ * section is read by one collective operation; for AGGREGATE, the first
+ * rank of each group reads it and sends each rank its part.  The data is
+ * then passed out by subsequent calls to read or view.
+ * Unread data of the previous section is discarded.
+ * \param [in,out] source       The source object to read from.
+ * \param [in] bytes            Number of bytes of this rank's part.
+ * \return                      0 on success, nonzero on error, including
+ *                              a source of another type.
+ */
+int                 sc_io_source_section (sc_io_source_t * source,
+                                          size_t bytes);
+
+/** Read data from a source without copying it.
+ * Works like \ref sc_io_source_read, but instead of copying the data
+ * returns a pointer to it.  This is possible for sources of type MMAP,
+ * BCAST, MPIFILE, AGGREGATE and BUFFER without encoding.  For MMAP and
+ * BCAST, the data points into the read-only file contents and stays valid
+ * until the source is destroyed.  For MPIFILE and AGGREGATE, it stays valid until the next
+ * section is read.  For BUFFER, it
+ * stays valid until the array is modified.
+ * \param [in,out] source       The source object to read from.
+ * \param [in] bytes_avail      Number of bytes requested.
+ * \param [out] data            Pointer to the data on success.
+ * \param [in,out] bytes_out    If not NULL, byte count of the data, which
+ *                              is less than bytes_avail at the end.
+ *                              Otherwise, requires exactly bytes_avail
+ *                              and consumes nothing if they are missing.
+ * \return                      0 on success, nonzero on error, including
+ *                              a source that does not support views.
+ */
+int                 sc_io_source_view (sc_io_source_t * source,
+                                       size_t bytes_avail,
+                                       const void **data,
+                                       size_t * bytes_out);
+
+/** Read an array from a source without copying it.
+ * The view is initialized by \ref sc_array_init_data and must not be
+ * modified or resized.  Its lifetime is as in \ref sc_io_source_view.
+ * \param [in,out] source       The source object to read from.
+ * \param [out] view            Array initialized as a view on success.
+ * \param [in] elem_size        Size of one array element in bytes.
+ * \param [in] elem_count       Number of elements, all of which must be
+ *                              available in the source.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_source_view_array (sc_io_source_t * source,
+                                             sc_array_t * view,
+                                             size_t elem_size,
+                                             size_t elem_count);
+
+/** Advise the operating system of how the source will be accessed.
+ * This is only effective for the type MMAP and a noop otherwise.
+ * \param [in,out] source       The source object to advise on.
+ * \param [in] advice           The expected access pattern.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_source_advise (sc_io_source_t * source,
+                                         sc_io_advice_t advice);
+
+/** Read the file of a source ahead in large blocks in the background.
+ * A background thread keeps up to num_buffers blocks read from the file
+ * ahead of the caller, and the data of \ref sc_io_source_read and the
+ * functions based on it is copied from these blocks.  Readers of many
+ * small records thus wait for the file only if the thread falls behind.
+ * Data skipped by passing NULL is not read again, and a mirror receives
+ * the data read without another copy.  Read errors of the background
+ * thread are reported once the blocks read before are used up.
+ * Without --enable-pthread, the caller reads the next block when it needs
+ * it, which still collects small reads into large ones.
+ * For FILEFILE, the file is positioned after the data read ahead when the
+ * source is destroyed.
+ * \param [in,out] source       Source of type FILENAME or FILEFILE.
+ * \param [in] num_buffers      Number of blocks, at least 2.
+ * \param [in] buffer_bytes     Size of each block.
+ * \return                      0 on success, nonzero on error, including
+ *                              a source of another type or one already
+ *                              reading ahead.
+ */
+int                 sc_io_source_activate_readahead (sc_io_source_t *
+                                                     source,
+                                                     int num_buffers,
+                                                     size_t buffer_bytes);
+
 /** Determine whether all data buffered from source has been returned by read.
  * If it returns SC_IO_ERROR_AGAIN, another sc_io_source_read is required.
  * If the call returns no error, the internal counters source->bytes_in and
  * source->bytes_out are returned to the caller if requested, and reset to 0.
  * The internal state of the source is not changed otherwise.
  * It is legal to continue reading from the source hereafter.
+ * With a checksum, its trailer is read and verified before anything else,
+ * and a mismatch is returned as SC_IO_ERROR_FATAL.
  *
  * \param [in,out] source       The source object to read from.
  * \param [in,out] bytes_in     If not NULL and true is returned,
  *                              the total size of the data sourced.
  * \param [in,out] bytes_out    If not NULL and true is returned,
  *                              total bytes passed out by source_read.
- * \return                      SC_IO_ERROR_AGAIN if buffered data remaining.
+ * \return                      SC_IO_ERROR_AGAIN if buffered data remaining,
+ *                              which includes a partially decoded frame.
  *                              Otherwise return ERROR_NONE and reset counters.
  */
 int                 sc_io_source_complete (sc_io_source_t * source,
                                            size_t * bytes_in,
                                            size_t * bytes_out);
 
+/** Verify the checksums written by \ref sc_io_sink_activate_checksum.
+ * This must be called at the position in the data where the sink was
+ * activated.  From now on, a CRC32C of the data read from the source is
+ * computed, including the data skipped by passing NULL to
+ * \ref sc_io_source_read and the data of \ref sc_io_source_view.  Each
+ * call to \ref sc_io_source_complete first reads the trailer and compares
+ * it with the checksum, returning an error if they differ, and then
+ * begins a new checksum.  The data between two complete calls must thus
+ * match the data of the corresponding calls on the sink.  With a
+ * compressed encoding, complete may return SC_IO_ERROR_AGAIN for encoded
+ * data of the following frames; the trailer has been verified then.
+ * \param [in,out] source       The source object to verify.
+ * \return                      0 on success, nonzero if a checksum is
+ *                              already active.
+ */
+int                 sc_io_source_activate_checksum (sc_io_source_t *
+                                                    source);
+
+/** Measure the time spent in the calls of a source.
+ * This works like \ref sc_io_sink_activate_timing for the read, readv,
+ * view, align, section and complete calls.  For the type MMAP, the
+ * time to page in the data is part of the time of the read calls.
+ * \param [in,out] source       The source object to measure.
+ * \return                      0 on success, nonzero if the timing is
+ *                              already active.
+ */
+int                 sc_io_source_activate_timing (sc_io_source_t *
+                                                  source);
+
+/** Query the counters of a source.
+ * \param [in] source           The source object.
+ * \param [out] timing          The counters accumulated since activating
+ *                              the timing, or all zero if not activated.
+ */
+void                sc_io_source_timing (sc_io_source_t * source,
+                                         sc_io_timing_t * timing);
+
+/** Add the counters of a sink or source to statistics.
+ * The variables prefix_io_time, prefix_sync_time, prefix_io_calls,
+ * prefix_sync_calls, prefix_file_calls, prefix_bytes and
+ * prefix_bandwidth, the latter in MB/s over the time of all calls, are
+ * registered if they do not exist and accumulate one value each.  Since
+ * \ref sc_statistics_compute reduces over all ranks, minimum and maximum
+ * of the times show stragglers and contention.
+ * \param [in,out] stats        Statistics of the ranks writing or reading.
+ * \param [in] prefix           Prefix of the variable names.
+ * \param [in] timing           Counters to add.  If NULL, the variables
+ *                              are registered without a value, so all
+ *                              ranks register the same variables.
+ */
+void                sc_io_timing_statistics (sc_statistics_t * stats,
+                                             const char *prefix,
+                                             const sc_io_timing_t *
+                                             timing);
+
 /** Align source to a byte boundary by skipping.
  * \param [in,out] source       The source object to align.
  * \param [in] bytes_align      Byte boundary.
@@ -239,6 +645,103 @@ int                 sc_io_source_read_mirror (sc_io_source_t * source,
                                               size_t bytes_avail,
                                               size_t * bytes_out);
 
+/** Length of the header of a binary record in bytes. */
+#define SC_IO_RECORD_HEADER_BYTES 32
+
+/** Write a binary record: a header followed by raw element memory.
+ * The header holds four magic bytes identifying the content, a format
+ * version, the byte order of the data and the numbers \a elem_size,
+ * \a elem_count and \a aux, which are stored in little endian.  The data
+ * itself is written in the byte order of this machine and passed to the
+ * sink together with the header by \ref sc_io_sink_writev, so it is not
+ * copied for FILENAME and FILEFILE sinks.
+ * \param [in,out] sink         The sink object to write to.
+ * \param [in] magic            Four bytes identifying the record type.
+ * \param [in] elem_size        Size of one element in bytes.
+ * \param [in] elem_count       Number of elements.
+ * \param [in] aux              Additional number stored in the header.
+ * \param [in] data             Contiguous elem_size * elem_count bytes.
+ *                              If NULL, only the header is written and
+ *                              the caller writes the data afterwards.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_io_sink_write_record (sc_io_sink_t * sink,
+                                             const char *magic,
+                                             size_t elem_size,
+                                             size_t elem_count, size_t aux,
+                                             const void *data);
+
+/** Read the header of a binary record written by
+ * \ref sc_io_sink_write_record.  The data is then read by the caller.
+ * \param [in,out] source       The source object to read from.
+ * \param [in] magic            Four bytes expected to identify the record.
+ * \param [out] elem_size       Size of one element in bytes.
+ * \param [out] elem_count      Number of elements.
+ * \param [out] aux             Additional number, may be NULL.
+ * \return                      0 on success, nonzero on error, including
+ *                              another record type, an unknown format
+ *                              version and data of another byte order.
+ */
+int                 sc_io_source_read_record (sc_io_source_t * source,
+                                              const char *magic,
+                                              size_t *elem_size,
+                                              size_t *elem_count,
+                                              size_t *aux);
+
+/** Write the elements of an array to a sink as a binary record.
+ * \param [in] array            Any array, including views.
+ * \param [in,out] sink         The sink object to write to.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_array_write (const sc_array_t * array,
+                                    sc_io_sink_t * sink);
+
+/** Read an array written by \ref sc_array_write.
+ * The data is read from the source directly into the array memory.
+ * \param [in,out] array        Array that owns its memory.  Its element size
+ *                              must match the record.  It is resized to the
+ *                              stored count and its elements are replaced.
+ * \param [in,out] source       The source object to read from.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_array_read (sc_array_t * array,
+                                   sc_io_source_t * source);
+
+/** Read an array written by \ref sc_array_write without copying it.
+ * The source must support \ref sc_io_source_view, for example an MMAP
+ * source, and the lifetime of the view is as documented there.  The view
+ * is initialized by \ref sc_array_init_data and must not be modified.
+ * Its data is suitably aligned if the record starts at a multiple of
+ * eight bytes and its elements are, which \ref sc_io_sink_align achieves.
+ * \param [out] view            Array initialized as a view on success.
+ * \param [in,out] source       The source object to read from.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_array_read_view (sc_array_t * view,
+                                        sc_io_source_t * source);
+
+/** Write the elements of a hash array to a sink.
+ * The record is that of \ref sc_array_write; the hash table is not stored.
+ * \param [in] hash_array       The hash array to write.
+ * \param [in,out] sink         The sink object to write to.
+ * \return                      0 on success, nonzero on error.
+ */
+int                 sc_hash_array_write (sc_hash_array_t * hash_array,
+                                         sc_io_sink_t * sink);
+
+/** Read the elements of a hash array written by \ref sc_hash_array_write.
+ * The elements replace the previous contents and are read directly into
+ * the array memory.  The hash table is rebuilt lazily by the next lookup
+ * or insertion, so loading alone does not call the hash function.
+ * \param [in,out] hash_array   Hash array with the element size, hash
+ *                              and equal function of the written one.
+ * \param [in,out] source       The source object to read from.
+ * \return                      0 on success, nonzero on error.  On error,
+ *                              the hash array is left empty.
+ */
+int                 sc_hash_array_read (sc_hash_array_t * hash_array,
+                                        sc_io_source_t * source);
+
 /** This function writes numeric binary data in VTK base64 encoding.
  * \param vtkfile        Stream opened for writing.
  * \param numeric_data   A pointer to a numeric data array.
@@ -248,7 +751,19 @@ int                 sc_io_source_read_mirror (sc_io_source_t * source,
 int                 sc_vtk_write_binary (FILE * vtkfile, char *numeric_data,
                                          size_t byte_length);
 
+/** Write numeric binary data in VTK base64 encoding to a sink.
+ * The code is streamed through a small fixed buffer.
+ * \param [in,out] sink  Sink opened for writing.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \return               Returns 0 on success, -1 on sink error.
+ */
+int                 sc_vtk_write_binary_sink (sc_io_sink_t * sink,
+                                              const char *numeric_data,
+                                              size_t byte_length);
+
 /** This function writes numeric binary data in VTK compressed format.
+ * It uses blocks of 32768 bytes and the best compression level.
  * \param vtkfile        Stream opened for writing.
  * \param numeric_data   A pointer to a numeric data array.
  * \param byte_length    The length of the data array in bytes.
@@ -258,6 +773,44 @@ int                 sc_vtk_write_compressed (FILE * vtkfile,
                                              char *numeric_data,
                                              size_t byte_length);
 
+/** Write numeric binary data in VTK compressed format with options.
+ * The data is split into blocks that are compressed independently.
+ * With --enable-openmp, the blocks are compressed by multiple threads.
+ * The output is identical to the sequential compression.
+ * \param vtkfile        Stream opened for writing.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param level          The zlib compression level from -1 to 9.
+ *                       Level 1 is much faster than level 9 and often
+ *                       compresses only slightly worse.
+ * \param blocksize      The uncompressed size of a block in bytes.
+ *                       If 0, the default of 32768 is used.
+ * \return               Returns 0 on success, -1 on file error.
+ */
+int                 sc_vtk_write_compressed_ext (FILE * vtkfile,
+                                                 char *numeric_data,
+                                                 size_t byte_length,
+                                                 int level,
+                                                 size_t blocksize);
+
+/** Write numeric binary data in VTK compressed format to a sink.
+ * Since a sink cannot seek back to the header, all blocks are compressed
+ * before any code is written; the compressed data is held in memory.
+ * The output is the same as that of \ref sc_vtk_write_compressed_ext.
+ * \param [in,out] sink  Sink opened for writing.
+ * \param numeric_data   A pointer to a numeric data array.
+ * \param byte_length    The length of the data array in bytes.
+ * \param level          The zlib compression level from -1 to 9.
+ * \param blocksize      The uncompressed size of a block in bytes.
+ *                       If 0, the default of 32768 is used.
+ * \return               Returns 0 on success, -1 on sink error.
+ */
+int                 sc_vtk_write_compressed_sink (sc_io_sink_t * sink,
+                                                  const char *numeric_data,
+                                                  size_t byte_length,
+                                                  int level,
+                                                  size_t blocksize);
+
 /** Write memory content to a file.
  * \param [in] ptr      Data array to write to disk.
  * \param [in] size     Size of one array member.
@@ -23,9 +23,10 @@
 
 #include <sc_keyvalue.h>
 
-typedef struct sc_keyvalue_entry
+struct sc_keyvalue_entry
 {
   const char         *key;
+  unsigned            hash;     /* hash value of the key string */
   sc_keyvalue_entry_type_t type;
   union
   {
@@ -35,39 +36,154 @@ typedef struct sc_keyvalue_entry
     void               *p;
   }
   value;
-}
-sc_keyvalue_entry_t;
+};
+
+typedef struct sc_keyvalue_entry sc_keyvalue_entry_t;
+
+/** Minimum number of slots of the open addressing table. */
+#define SC_KEYVALUE_MIN_SLOTS 16
 
 struct sc_keyvalue
 {
-  sc_hash_t          *hash;
+  size_t              num_entries;
+  size_t              num_slots;        /* a power of two */
+  sc_keyvalue_entry_t **slots;  /* entries or NULL, linearly probed */
   sc_mempool_t       *value_allocator;
 };
 
 static unsigned
-sc_keyvalue_entry_hash (const void *v, const void *u)
+sc_keyvalue_hash (const char *key)
 {
-  const sc_keyvalue_entry_t *ov = (const sc_keyvalue_entry_t *) v;
-
-  return sc_hash_function_string (ov->key, NULL);
+  return sc_hash_function_string_fast (key, NULL);
 }
 
+/** Check whether an entry has a given key.
+ * The hash comparison rejects almost all other keys, and interned keys
+ * that are passed by the same pointer need no string comparison.
+ */
 static int
-sc_keyvalue_entry_equal (const void *v1, const void *v2, const void *u)
+sc_keyvalue_entry_is (const sc_keyvalue_entry_t * entry,
+                      const char *key, unsigned hash)
 {
+  return entry->hash == hash && (entry->key == key ||
+                                 !strcmp (entry->key, key));
+}
+
+/** Return the slot holding a key or the empty slot that ends its probe. */
+static size_t
+sc_keyvalue_probe (const sc_keyvalue_t * kv, const char *key, unsigned hash)
+{
+  const size_t        mask = kv->num_slots - 1;
+  size_t              pos;
+
+  for (pos = hash & mask; kv->slots[pos] != NULL; pos = (pos + 1) & mask) {
+    if (sc_keyvalue_entry_is (kv->slots[pos], key, hash)) {
+      break;
+    }
+  }
+  return pos;
+}
 
-  const sc_keyvalue_entry_t *ov1 = (const sc_keyvalue_entry_t *) v1;
-  const sc_keyvalue_entry_t *ov2 = (const sc_keyvalue_entry_t *) v2;
+static sc_keyvalue_entry_t *
+sc_keyvalue_find (const sc_keyvalue_t * kv, const char *key)
+{
+  SC_ASSERT (kv != NULL);
+  SC_ASSERT (key != NULL);
 
-  return !strcmp (ov1->key, ov2->key);
+  return kv->slots[sc_keyvalue_probe (kv, key, sc_keyvalue_hash (key))];
+}
+
+static void
+sc_keyvalue_resize (sc_keyvalue_t * kv, size_t num_slots)
+{
+  size_t              i, pos, mask;
+  size_t              old_num_slots = kv->num_slots;
+  sc_keyvalue_entry_t **old_slots = kv->slots;
+
+  kv->num_slots = num_slots;
+  kv->slots = SC_ALLOC_ZERO (sc_keyvalue_entry_t *, num_slots);
+  mask = num_slots - 1;
+  for (i = 0; i < old_num_slots; ++i) {
+    if (old_slots[i] != NULL) {
+      for (pos = old_slots[i]->hash & mask; kv->slots[pos] != NULL;
+           pos = (pos + 1) & mask);
+      kv->slots[pos] = old_slots[i];
+    }
+  }
+  SC_FREE (old_slots);
+}
+
+/** Insert an entry for a key that is not yet present. */
+static void
+sc_keyvalue_insert (sc_keyvalue_t * kv, sc_keyvalue_entry_t * entry)
+{
+  size_t              pos;
+
+  /* keep the load factor at most one half */
+  if (2 * (kv->num_entries + 1) > kv->num_slots) {
+    sc_keyvalue_resize (kv, 2 * kv->num_slots);
+  }
+  pos = sc_keyvalue_probe (kv, entry->key, entry->hash);
+  SC_ASSERT (kv->slots[pos] == NULL);
+  kv->slots[pos] = entry;
+  ++kv->num_entries;
+}
+
+/** Remove the entry in a slot, shifting back the entries probed past it. */
+static void
+sc_keyvalue_remove_slot (sc_keyvalue_t * kv, size_t hole)
+{
+  const size_t        mask = kv->num_slots - 1;
+  size_t              pos, home;
+
+  kv->slots[hole] = NULL;
+  --kv->num_entries;
+  for (pos = (hole + 1) & mask; kv->slots[pos] != NULL;
+       pos = (pos + 1) & mask) {
+    home = kv->slots[pos]->hash & mask;
+
+    /* move the entry unless its home lies cyclically in (hole, pos] */
+    if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+      kv->slots[hole] = kv->slots[pos];
+      kv->slots[pos] = NULL;
+      hole = pos;
+    }
+  }
+}
+
+/** Return the entry of a key, creating it with a type if not present. */
+static sc_keyvalue_entry_t *
+sc_keyvalue_find_or_create (sc_keyvalue_t * kv, const char *key,
+                            sc_keyvalue_entry_type_t type)
+{
+  const unsigned      hash = sc_keyvalue_hash (key);
+  sc_keyvalue_entry_t *value;
+
+  SC_ASSERT (kv != NULL);
+  SC_ASSERT (key != NULL);
+
+  value = kv->slots[sc_keyvalue_probe (kv, key, hash)];
+  if (value != NULL) {
+    /* Key already exists in hash table */
+    SC_ASSERT (value->type == type);
+    return value;
+  }
+
+  /* Key does not exist and must be created */
+  value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
+  value->key = key;
+  value->hash = hash;
+  value->type = type;
+  memset (&value->value, 0, sizeof (value->value));
+  sc_keyvalue_insert (kv, value);
+  return value;
 }
 
 sc_keyvalue_t      *
 sc_keyvalue_newv (va_list ap)
 {
   const char         *s;
-  int                 added;
-  void              **found;
+  size_t              pos;
   sc_keyvalue_t      *kv;
   sc_keyvalue_entry_t *value;
 
@@ -84,6 +200,7 @@ sc_keyvalue_newv (va_list ap)
     SC_ASSERT (s[0] != '\0' && s[1] == ':' && s[2] != '\0');
     value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
     value->key = &s[2];
+    value->hash = sc_keyvalue_hash (value->key);
     switch (s[0]) {
     case 'i':
       value->type = SC_KEYVALUE_ENTRY_INT;
@@ -104,10 +221,15 @@ sc_keyvalue_newv (va_list ap)
     default:
       SC_ABORTF ("invalid argument character %c", s[0]);
     }
-    added = sc_hash_insert_unique (kv->hash, value, &found);
-    if (!added) {
-      sc_mempool_free (kv->value_allocator, *found);
-      *found = value;
+
+    /* a repeated key replaces the earlier entry */
+    pos = sc_keyvalue_probe (kv, value->key, value->hash);
+    if (kv->slots[pos] != NULL) {
+      sc_mempool_free (kv->value_allocator, kv->slots[pos]);
+      kv->slots[pos] = value;
+    }
+    else {
+      sc_keyvalue_insert (kv, value);
     }
   }
 
@@ -135,8 +257,9 @@ sc_keyvalue_new ()
   sc_keyvalue_t      *kv;
 
   kv = SC_ALLOC (sc_keyvalue_t, 1);
-  kv->hash = sc_hash_new (sc_keyvalue_entry_hash, sc_keyvalue_entry_equal,
-                          NULL, NULL);
+  kv->num_entries = 0;
+  kv->num_slots = SC_KEYVALUE_MIN_SLOTS;
+  kv->slots = SC_ALLOC_ZERO (sc_keyvalue_entry_t *, kv->num_slots);
   kv->value_allocator = sc_mempool_new (sizeof (sc_keyvalue_entry_t));
 
   return kv;
@@ -145,7 +268,7 @@ sc_keyvalue_new ()
 void
 sc_keyvalue_destroy (sc_keyvalue_t * kv)
 {
-  sc_hash_destroy (kv->hash);
+  SC_FREE (kv->slots);
   sc_mempool_destroy (kv->value_allocator);
 
   SC_FREE (kv);
@@ -154,54 +277,30 @@ sc_keyvalue_destroy (sc_keyvalue_t * kv)
 sc_keyvalue_entry_type_t
 sc_keyvalue_exists (sc_keyvalue_t * kv, const char *key)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
-    return value->type;
-  }
-  else
-    return SC_KEYVALUE_ENTRY_NONE;
+  value = sc_keyvalue_find (kv, key);
+  return value != NULL ? value->type : SC_KEYVALUE_ENTRY_NONE;
 }
 
 sc_keyvalue_entry_type_t
 sc_keyvalue_unset (sc_keyvalue_t * kv, const char *key)
 {
-  void               *found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
+  size_t              pos;
   sc_keyvalue_entry_t *value;
-
-  int                 remove_test;
   sc_keyvalue_entry_type_t type;
 
   SC_ASSERT (kv != NULL);
   SC_ASSERT (key != NULL);
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-
-  /* Remove this entry */
-  remove_test = sc_hash_remove (kv->hash, pvalue, &found);
-
-  /* Check whether anything was removed */
-  if (!remove_test)
+  /* Check whether anything is to be removed */
+  pos = sc_keyvalue_probe (kv, key, sc_keyvalue_hash (key));
+  if ((value = kv->slots[pos]) == NULL)
     return SC_KEYVALUE_ENTRY_NONE;
 
-  /* Code reaching this point must have found something */
-  SC_ASSERT (remove_test);
-  SC_ASSERT (found != NULL);
-
-  value = (sc_keyvalue_entry_t *) found;
+  /* Remove this entry and destroy it */
   type = value->type;
-
-  /* destroy the original hash entry */
+  sc_keyvalue_remove_slot (kv, pos);
   sc_mempool_free (kv->value_allocator, value);
 
   return type;
@@ -210,17 +309,9 @@ sc_keyvalue_unset (sc_keyvalue_t * kv, const char *key)
 int
 sc_keyvalue_get_int (sc_keyvalue_t * kv, const char *key, int dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_INT);
     return value->value.i;
   }
@@ -231,17 +322,9 @@ sc_keyvalue_get_int (sc_keyvalue_t * kv, const char *key, int dvalue)
 double
 sc_keyvalue_get_double (sc_keyvalue_t * kv, const char *key, double dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_DOUBLE);
     return value->value.g;
   }
@@ -253,17 +336,9 @@ const char         *
 sc_keyvalue_get_string (sc_keyvalue_t * kv, const char *key,
                         const char *dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_STRING);
     return value->value.s;
   }
@@ -274,17 +349,9 @@ sc_keyvalue_get_string (sc_keyvalue_t * kv, const char *key,
 void               *
 sc_keyvalue_get_pointer (sc_keyvalue_t * kv, const char *key, void *dvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_POINTER);
     return value->value.p;
   }
@@ -297,19 +364,11 @@ sc_keyvalue_get_int_check (sc_keyvalue_t * kv, const char *key, int *status)
 {
   int                 result;
   int                 etype;
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
   sc_keyvalue_entry_t *value;
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
   result = (status != NULL) ? *status : INT_MIN;
   etype = 1;
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    value = (sc_keyvalue_entry_t *) (*found);
+  if ((value = sc_keyvalue_find (kv, key)) != NULL) {
     if (value->type == SC_KEYVALUE_ENTRY_INT) {
       etype = 0;
       result = value->value.i;
@@ -328,160 +387,131 @@ sc_keyvalue_get_int_check (sc_keyvalue_t * kv, const char *key, int *status)
 void
 sc_keyvalue_set_int (sc_keyvalue_t * kv, const char *key, int newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
-
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_INT);
-
-    value->value.i = newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_INT;
-    value->value.i = newvalue;
-
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+  sc_keyvalue_find_or_create (kv, key, SC_KEYVALUE_ENTRY_INT)->value.i =
+    newvalue;
 }
 
 void
 sc_keyvalue_set_double (sc_keyvalue_t * kv, const char *key, double newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
-
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
-
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_DOUBLE);
-
-    value->value.g = newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_DOUBLE;
-    value->value.g = newvalue;
-
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+  sc_keyvalue_find_or_create (kv, key, SC_KEYVALUE_ENTRY_DOUBLE)->value.g =
+    newvalue;
 }
 
 void
 sc_keyvalue_set_string (sc_keyvalue_t * kv, const char *key,
                         const char *newvalue)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
+  sc_keyvalue_find_or_create (kv, key, SC_KEYVALUE_ENTRY_STRING)->value.s =
+    newvalue;
+}
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+void
+sc_keyvalue_set_pointer (sc_keyvalue_t * kv, const char *key, void *newvalue)
+{
+  sc_keyvalue_find_or_create (kv, key, SC_KEYVALUE_ENTRY_POINTER)->value.p =
+    newvalue;
+}
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_STRING);
+sc_keyvalue_handle_t *
+sc_keyvalue_lookup_handle (sc_keyvalue_t * kv, const char *key)
+{
+  return sc_keyvalue_find (kv, key);
+}
 
-    value->value.s = newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_STRING;
-    value->value.s = newvalue;
+sc_keyvalue_handle_t *
+sc_keyvalue_create_handle (sc_keyvalue_t * kv, const char *key,
+                           sc_keyvalue_entry_type_t type)
+{
+  SC_ASSERT (type != SC_KEYVALUE_ENTRY_NONE);
 
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+  return sc_keyvalue_find_or_create (kv, key, type);
 }
 
-void
-sc_keyvalue_set_pointer (sc_keyvalue_t * kv, const char *key, void *newvalue)
+const char         *
+sc_keyvalue_handle_key (const sc_keyvalue_handle_t * h)
 {
-  void              **found;
-  sc_keyvalue_entry_t svalue, *pvalue = &svalue;
-  sc_keyvalue_entry_t *value;
+  SC_ASSERT (h != NULL);
+  return h->key;
+}
 
-  SC_ASSERT (kv != NULL);
-  SC_ASSERT (key != NULL);
+sc_keyvalue_entry_type_t
+sc_keyvalue_handle_type (const sc_keyvalue_handle_t * h)
+{
+  SC_ASSERT (h != NULL);
+  return h->type;
+}
 
-  pvalue->key = key;
-  pvalue->type = SC_KEYVALUE_ENTRY_NONE;
-  if (sc_hash_lookup (kv->hash, pvalue, &found)) {
-    /* Key already exists in hash table */
-    value = (sc_keyvalue_entry_t *) (*found);
-    SC_ASSERT (value->type == SC_KEYVALUE_ENTRY_POINTER);
+int
+sc_keyvalue_handle_get_int (const sc_keyvalue_handle_t * h)
+{
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_INT);
+  return h->value.i;
+}
 
-    value->value.p = (void *) newvalue;
-  }
-  else {
-    /* Key does not exist and must be created */
-    value = (sc_keyvalue_entry_t *) sc_mempool_alloc (kv->value_allocator);
-    value->key = key;
-    value->type = SC_KEYVALUE_ENTRY_POINTER;
-    value->value.p = (void *) newvalue;
+double
+sc_keyvalue_handle_get_double (const sc_keyvalue_handle_t * h)
+{
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_DOUBLE);
+  return h->value.g;
+}
 
-    /* Insert value into the hash table */
-    SC_EXECUTE_ASSERT_TRUE (sc_hash_insert_unique (kv->hash, value, &found));
-  }
+const char         *
+sc_keyvalue_handle_get_string (const sc_keyvalue_handle_t * h)
+{
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_STRING);
+  return h->value.s;
 }
 
-typedef struct sc_kv_hash_data
+void               *
+sc_keyvalue_handle_get_pointer (const sc_keyvalue_handle_t * h)
 {
-  sc_keyvalue_foreach_t fn;
-  void               *data;
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_POINTER);
+  return h->value.p;
 }
-sc_kv_hash_data_t;
 
-static int
-sc_kv_hash_fn (void **v, const void *u)
+void
+sc_keyvalue_handle_set_int (sc_keyvalue_handle_t * h, int newvalue)
 {
-  const sc_kv_hash_data_t *hdata = (const sc_kv_hash_data_t *) u;
-  sc_keyvalue_entry_t *hentry = (sc_keyvalue_entry_t *) * v;
-  const char         *key = hentry->key;
-  sc_keyvalue_entry_type_t type = hentry->type;
-  void               *entry = &(hentry->value.p);
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_INT);
+  h->value.i = newvalue;
+}
 
-  return hdata->fn (key, type, entry, hdata->data);
+void
+sc_keyvalue_handle_set_double (sc_keyvalue_handle_t * h, double newvalue)
+{
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_DOUBLE);
+  h->value.g = newvalue;
 }
 
 void
-sc_keyvalue_foreach (sc_keyvalue_t * kv, sc_keyvalue_foreach_t fn,
-                     void *user_data)
+sc_keyvalue_handle_set_string (sc_keyvalue_handle_t * h,
+                               const char *newvalue)
 {
-  sc_kv_hash_data_t   hdata;
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_STRING);
+  h->value.s = newvalue;
+}
 
-  hdata.fn = fn;
-  hdata.data = user_data;
+void
+sc_keyvalue_handle_set_pointer (sc_keyvalue_handle_t * h, void *newvalue)
+{
+  SC_ASSERT (h != NULL && h->type == SC_KEYVALUE_ENTRY_POINTER);
+  h->value.p = newvalue;
+}
 
-  SC_ASSERT (kv->hash->user_data == NULL);
-  kv->hash->user_data = &hdata;
+void
+sc_keyvalue_foreach (sc_keyvalue_t * kv, sc_keyvalue_foreach_t fn,
+                     void *user_data)
+{
+  size_t              i;
+  sc_keyvalue_entry_t *entry;
 
-  sc_hash_foreach (kv->hash, sc_kv_hash_fn);
+  SC_ASSERT (kv != NULL);
 
-  kv->hash->user_data = NULL;
+  for (i = 0; i < kv->num_slots; ++i) {
+    if ((entry = kv->slots[i]) != NULL &&
+        !fn (entry->key, entry->type, &entry->value.p, user_data)) {
+      return;
+    }
+  }
 }
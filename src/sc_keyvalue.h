@@ -44,7 +44,11 @@ typedef enum
 }
 sc_keyvalue_entry_type_t;
 
-/** The key-value container is an opaque structure. */
+/** The key-value container is an opaque structure.
+ * Its entries live in an open addressing table that stores the hash value
+ * of each key.  A key passed by the same pointer as it was inserted with
+ * is matched without comparing strings.
+ */
 typedef struct sc_keyvalue sc_keyvalue_t;
 
 /** Create a new key-value container.
@@ -194,6 +198,62 @@ void                sc_keyvalue_set_string (sc_keyvalue_t * kv,
 void                sc_keyvalue_set_pointer (sc_keyvalue_t * kv,
                                              const char *key, void *newvalue);
 
+/** A handle to one entry of a key-value container.
+ * It stays valid until its key is unset or the container is destroyed,
+ * and gives access to the value without hashing the key again.
+ */
+typedef struct sc_keyvalue_entry sc_keyvalue_handle_t;
+
+/** Look up the handle of a key.
+ * \param [in] kv               Valid key-value container.
+ * \param [in] key              Lookup key.
+ * \return                      The handle or NULL if the key does not exist.
+ */
+sc_keyvalue_handle_t *sc_keyvalue_lookup_handle (sc_keyvalue_t * kv,
+                                                 const char *key);
+
+/** Look up the handle of a key and create the entry if it does not exist.
+ * A new entry has a zero value, NULL for strings and pointers.
+ * \param [in] kv               Valid key-value container.
+ * \param [in] key              Key to look up or insert.  When inserted,
+ *                              the string is referenced, not copied, and
+ *                              must stay alive while the key exists.
+ * \param [in] type             Type of the entry.  An existing entry must
+ *                              have this type.
+ * \return                      The handle of the entry.
+ */
+sc_keyvalue_handle_t *sc_keyvalue_create_handle (sc_keyvalue_t * kv,
+                                                 const char *key,
+                                                 sc_keyvalue_entry_type_t
+                                                 type);
+
+/** Return the key of an entry. */
+const char         *sc_keyvalue_handle_key (const sc_keyvalue_handle_t * h);
+
+/** Return the type of an entry. */
+sc_keyvalue_entry_type_t sc_keyvalue_handle_type (const sc_keyvalue_handle_t
+                                                  * h);
+
+/** Routines to access the value of an entry of matching type. */
+int                 sc_keyvalue_handle_get_int (const sc_keyvalue_handle_t *
+                                                h);
+double              sc_keyvalue_handle_get_double (const sc_keyvalue_handle_t
+                                                   * h);
+const char         *sc_keyvalue_handle_get_string (const sc_keyvalue_handle_t
+                                                   * h);
+void               *sc_keyvalue_handle_get_pointer (const
+                                                    sc_keyvalue_handle_t * h);
+
+/** Routines to modify the value of an entry of matching type. */
+void                sc_keyvalue_handle_set_int (sc_keyvalue_handle_t * h,
+                                                int newvalue);
+void                sc_keyvalue_handle_set_double (sc_keyvalue_handle_t * h,
+                                                   double newvalue);
+void                sc_keyvalue_handle_set_string (sc_keyvalue_handle_t * h,
+                                                   const char *newvalue);
+void                sc_keyvalue_handle_set_pointer (sc_keyvalue_handle_t * h,
+                                                    void *newvalue);
+
 /** Function to call on every key value pair
  * \param [in] key   The key for this pair
  * \param [in] type  The type of entry
@@ -56,6 +56,11 @@ extern const char   sc_jobzchar[];
 #define SC_LAPACK_DGESV   SC_F77_FUNC(dgesv,DGESV)
 #define SC_LAPACK_DGETRF  SC_F77_FUNC(dgetrf,DGETRF)
 #define SC_LAPACK_DGETRS  SC_F77_FUNC(dgetrs,DGETRS)
+#define SC_LAPACK_DPOTRF  SC_F77_FUNC(dpotrf,DPOTRF)
+#define SC_LAPACK_DPOTRS  SC_F77_FUNC(dpotrs,DPOTRS)
+#define SC_LAPACK_SGESV   SC_F77_FUNC(sgesv,SGESV)
+#define SC_LAPACK_SGETRF  SC_F77_FUNC(sgetrf,SGETRF)
+#define SC_LAPACK_SGETRS  SC_F77_FUNC(sgetrs,SGETRS)
 #if defined(__bgq__)            /* && define(__HAVE_ESSL) */
 #define SC_LAPACK_DSTEV   SC_F77_FUNC_NOESSL(dstev,DSTEV)
 #else
@@ -92,6 +97,35 @@ void                SC_LAPACK_DGETRS (const char *trans, const sc_bint_t * n,
                                       const sc_bint_t * ldx,
                                       sc_bint_t * info);
 
+void                SC_LAPACK_DPOTRF (const char *uplo, const sc_bint_t * n,
+                                      double *a, const sc_bint_t * lda,
+                                      sc_bint_t * info);
+
+void                SC_LAPACK_DPOTRS (const char *uplo, const sc_bint_t * n,
+                                      const sc_bint_t * nrhs, const double *a,
+                                      const sc_bint_t * lda, double *b,
+                                      const sc_bint_t * ldb,
+                                      sc_bint_t * info);
+
+void                SC_LAPACK_SGESV (const sc_bint_t * n,
+                                     const sc_bint_t * nrhs,
+                                     float *a, const sc_bint_t * lda,
+                                     sc_bint_t * ipiv,
+                                     float *b, const sc_bint_t * ldb,
+                                     sc_bint_t * info);
+
+void                SC_LAPACK_SGETRF (const sc_bint_t * m,
+                                      const sc_bint_t * n, float *a,
+                                      const sc_bint_t * lda, sc_bint_t * ipiv,
+                                      sc_bint_t * info);
+
+void                SC_LAPACK_SGETRS (const char *trans, const sc_bint_t * n,
+                                      const sc_bint_t * nrhs, const float *a,
+                                      const sc_bint_t * lda,
+                                      const sc_bint_t * ipiv, float *b,
+                                      const sc_bint_t * ldx,
+                                      sc_bint_t * info);
+
 void                SC_LAPACK_DSTEV (const char *jobz,
                                      const sc_bint_t * n,
                                      double *d,
@@ -135,6 +169,11 @@ int                 SC_LAPACK_ILAENV (const sc_bint_t * ispec,
 #define SC_LAPACK_DGESV    (void) sc_lapack_nonimplemented
 #define SC_LAPACK_DGETRF   (void) sc_lapack_nonimplemented
 #define SC_LAPACK_DGETRS   (void) sc_lapack_nonimplemented
+#define SC_LAPACK_DPOTRF   (void) sc_lapack_nonimplemented
+#define SC_LAPACK_DPOTRS   (void) sc_lapack_nonimplemented
+#define SC_LAPACK_SGESV    (void) sc_lapack_nonimplemented
+#define SC_LAPACK_SGETRF   (void) sc_lapack_nonimplemented
+#define SC_LAPACK_SGETRS   (void) sc_lapack_nonimplemented
 #define SC_LAPACK_DSTEV    (void) sc_lapack_nonimplemented
 #define SC_LAPACK_DTRSM    (void) sc_lapack_nonimplemented
 #define SC_LAPACK_DLAIC1   (void) sc_lapack_nonimplemented
@@ -24,6 +24,10 @@
 /* including sc_mpi.h does not work here since sc_mpi.h is included by sc.h */
 #include <sc.h>
 
+#if defined SC_ENABLE_MPI && defined SC_HAVE_MPI_EXT_H
+#include <mpi-ext.h>
+#endif
+
 #ifndef SC_ENABLE_MPI
 
 /* gettimeofday is in either of these two */
@@ -57,6 +61,1094 @@ mpi_dummy_assert_op (sc_MPI_Op op)
   }
 }
 
+#define SC_MPI_TREDUCE_BITWISE                                          \
+  case sc_MPI_BAND:                                                     \
+    for (i = 0; i < n; ++i) b[i] &= a[i];                               \
+    break;                                                              \
+  case sc_MPI_BOR:                                                      \
+    for (i = 0; i < n; ++i) b[i] |= a[i];                               \
+    break;                                                              \
+  case sc_MPI_BXOR:                                                     \
+    for (i = 0; i < n; ++i) b[i] ^= a[i];                               \
+    break;
+
+#define SC_MPI_TREDUCE_DEFINE(name,T,bitwise)                           \
+static void                                                             \
+name (const void *in, void *inout, int n, sc_MPI_Op op)                 \
+{                                                                       \
+  int                 i;                                                \
+  const T            *a = (const T *) in;                               \
+  T                  *b = (T *) inout;                                  \
+                                                                        \
+  switch (op) {                                                         \
+  case sc_MPI_MAX:                                                      \
+    for (i = 0; i < n; ++i) if (a[i] > b[i]) b[i] = a[i];               \
+    break;                                                              \
+  case sc_MPI_MIN:                                                      \
+    for (i = 0; i < n; ++i) if (a[i] < b[i]) b[i] = a[i];               \
+    break;                                                              \
+  case sc_MPI_SUM:                                                      \
+    for (i = 0; i < n; ++i) b[i] += a[i];                               \
+    break;                                                              \
+  case sc_MPI_PROD:                                                     \
+    for (i = 0; i < n; ++i) b[i] *= a[i];                               \
+    break;                                                              \
+  case sc_MPI_LAND:                                                     \
+    for (i = 0; i < n; ++i) b[i] = b[i] && a[i];                        \
+    break;                                                              \
+  case sc_MPI_LOR:                                                      \
+    for (i = 0; i < n; ++i) b[i] = b[i] || a[i];                        \
+    break;                                                              \
+  case sc_MPI_LXOR:                                                     \
+    for (i = 0; i < n; ++i) b[i] = !b[i] != !a[i];                      \
+    break;                                                              \
+  case sc_MPI_REPLACE:                                                  \
+    for (i = 0; i < n; ++i) b[i] = a[i];                                \
+    break;                                                              \
+  bitwise                                                               \
+  default:                                                              \
+    SC_ABORT ("Unsupported reduction for the datatype");                \
+  }                                                                     \
+}
+
+/* *INDENT-OFF* */
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_char, char, SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_schar, signed char,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_uchar, unsigned char,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_short, short, SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_ushort, unsigned short,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_int, int, SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_unsigned, unsigned,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_long, long, SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_ulong, unsigned long,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_llong, long long,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_ullong, unsigned long long,
+                       SC_MPI_TREDUCE_BITWISE)
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_float, float, )
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_double, double, )
+SC_MPI_TREDUCE_DEFINE (sc_mpi_treduce_ldouble, long double, )
+/* *INDENT-ON* */
+
+/** Reduce pairs of value and index; ties go to the smaller index. */
+static void
+sc_mpi_treduce_2int (const void *in, void *inout, int n, sc_MPI_Op op)
+{
+  int                 i;
+  const int          *a = (const int *) in;
+  int                *b = (int *) inout;
+
+  SC_CHECK_ABORT (op == sc_MPI_MINLOC || op == sc_MPI_MAXLOC ||
+                  op == sc_MPI_REPLACE,
+                  "Unsupported reduction for the datatype");
+  for (i = 0; i < n; ++i, a += 2, b += 2) {
+    if (op == sc_MPI_REPLACE ||
+        (op == sc_MPI_MINLOC ? a[0] < b[0] : a[0] > b[0]) ||
+        (a[0] == b[0] && a[1] < b[1])) {
+      b[0] = a[0];
+      b[1] = a[1];
+    }
+  }
+}
+
+/** Combine \a in into \a inout element by element. */
+static void
+sc_mpi_treduce (const void *in, void *inout, int n, sc_MPI_Datatype t,
+                sc_MPI_Op op)
+{
+  mpi_dummy_assert_op (op);
+  if (t == sc_MPI_CHAR)
+    sc_mpi_treduce_char (in, inout, n, op);
+  else if (t == sc_MPI_SIGNED_CHAR)
+    sc_mpi_treduce_schar (in, inout, n, op);
+  else if (t == sc_MPI_UNSIGNED_CHAR || t == sc_MPI_BYTE)
+    sc_mpi_treduce_uchar (in, inout, n, op);
+  else if (t == sc_MPI_SHORT)
+    sc_mpi_treduce_short (in, inout, n, op);
+  else if (t == sc_MPI_UNSIGNED_SHORT)
+    sc_mpi_treduce_ushort (in, inout, n, op);
+  else if (t == sc_MPI_INT)
+    sc_mpi_treduce_int (in, inout, n, op);
+  else if (t == sc_MPI_UNSIGNED)
+    sc_mpi_treduce_unsigned (in, inout, n, op);
+  else if (t == sc_MPI_LONG)
+    sc_mpi_treduce_long (in, inout, n, op);
+  else if (t == sc_MPI_UNSIGNED_LONG)
+    sc_mpi_treduce_ulong (in, inout, n, op);
+  else if (t == sc_MPI_LONG_LONG_INT)
+    sc_mpi_treduce_llong (in, inout, n, op);
+  else if (t == sc_MPI_UNSIGNED_LONG_LONG)
+    sc_mpi_treduce_ullong (in, inout, n, op);
+  else if (t == sc_MPI_FLOAT)
+    sc_mpi_treduce_float (in, inout, n, op);
+  else if (t == sc_MPI_DOUBLE)
+    sc_mpi_treduce_double (in, inout, n, op);
+  else if (t == sc_MPI_LONG_DOUBLE)
+    sc_mpi_treduce_ldouble (in, inout, n, op);
+  else if (t == sc_MPI_2INT)
+    sc_mpi_treduce_2int (in, inout, n, op);
+  else
+    SC_ABORT_NOT_REACHED ();
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+/*
+ * Emulation of several ranks by the threads of sc_mpi_threads_run.
+ * The ranks share one world protected by one mutex and condition variable.
+ * A collective publishes a pointer to the arguments of every member between
+ * two barriers, such that each member copies directly from the buffers of
+ * its peers.  Point-to-point messages are matched under the mutex and then
+ * copied once from the sender's buffer to the receiver's buffer outside of
+ * it.  Only a blocking send copies its data into the message queue.
+ */
+
+#include <pthread.h>
+#include <sc_containers.h>
+
+/** A communicator of emulated ranks. */
+typedef struct sc_mpi_tcomm
+{
+  int                 size;     /**< Number of members */
+  int                *ranks;    /**< World rank of each member */
+  int                *local;    /**< Member of each world rank or -1 */
+  int                 arrived;  /**< Members waiting in the barrier */
+  long                generation;       /**< Number of completed barriers */
+  void              **slots;    /**< Published arguments of each member */
+}
+sc_mpi_tcomm_t;
+
+/** A nonblocking request or a blocking receive of an emulated rank. */
+typedef struct sc_mpi_treq
+{
+  struct sc_mpi_treq *next;     /**< Next posted receive of the rank */
+  int                 done;     /**< True once the data has been copied */
+  int                 context;  /**< Communicator index of a receive */
+  int                 source;   /**< World source rank or ANY_SOURCE */
+  int                 tag;      /**< Tag of a receive or ANY_TAG */
+  void               *buf;      /**< Receive buffer */
+  size_t              bytes;    /**< Capacity of the receive buffer */
+  sc_MPI_Status       status;   /**< Member source, tag and byte count */
+}
+sc_mpi_treq_t;
+
+/** A message that has been sent but not yet received. */
+typedef struct sc_mpi_tmsg
+{
+  struct sc_mpi_tmsg *next;     /**< Next message to the same rank */
+  int                 context;  /**< Communicator index */
+  int                 source;   /**< World source rank */
+  int                 tag;      /**< Message tag */
+  size_t              bytes;    /**< Message size */
+  const void         *data;     /**< Sender's buffer or eager copy */
+  char               *copy;     /**< Eager copy owned by the message */
+  sc_mpi_treq_t      *sreq;     /**< Send request completed on receipt */
+}
+sc_mpi_tmsg_t;
+
+/** The state shared by all ranks of one sc_mpi_threads_run. */
+typedef struct sc_mpi_world
+{
+  int                 size;     /**< Number of ranks */
+  pthread_mutex_t     mutex;    /**< Protects all members below */
+  pthread_cond_t      cond;     /**< Broadcast on every state change */
+  sc_array_t          comms;    /**< Communicators by index */
+  sc_array_t          requests; /**< Requests by handle - 1, NULL if free */
+  sc_array_t          free_requests;    /**< Indices of free handles */
+  sc_mpi_tmsg_t     **msg_head; /**< Unreceived messages per rank */
+  sc_mpi_tmsg_t     **msg_tail; /**< Last unreceived message per rank */
+  sc_mpi_treq_t     **posted_head;      /**< Posted receives per rank */
+  sc_mpi_treq_t     **posted_tail;      /**< Last posted receive per rank */
+}
+sc_mpi_world_t;
+
+/** One emulated rank. */
+typedef struct sc_mpi_trank
+{
+  sc_mpi_world_t     *world;    /**< The world of this rank */
+  int                 rank;     /**< Rank in the world */
+  int                 (*rank_main) (void *user);        /**< Rank program */
+  void               *user;     /**< Argument to the rank program */
+  int                 result;   /**< Return value of the rank program */
+  pthread_t           thread;   /**< The thread running the rank */
+}
+sc_mpi_trank_t;
+
+/** Arguments of a collective published by each member. */
+typedef struct sc_mpi_targs
+{
+  void               *sbuf;
+  int                 scount;
+  int                *scounts;
+  int                *sdispls;
+  sc_MPI_Datatype     stype;
+  int                 color;
+  int                 key;
+  sc_MPI_Comm         newcomm;
+}
+sc_mpi_targs_t;
+
+/** The emulated rank of the calling thread, NULL outside of ranks. */
+static __thread sc_mpi_trank_t *sc_mpi_trank = NULL;
+
+/** Divert a call of the calling thread to its emulation if it has a rank. */
+#define SC_MPI_THREAD_DISPATCH(call) do {                       \
+    if (sc_mpi_trank != NULL) {                                 \
+      return (call);                                            \
+    }} while (0)
+
+static void
+sc_mpi_tlock (sc_mpi_world_t * w)
+{
+  int                 pth = pthread_mutex_lock (&w->mutex);
+
+  SC_CHECK_ABORT (pth == 0, "pthread_mutex_lock");
+}
+
+static void
+sc_mpi_tunlock (sc_mpi_world_t * w)
+{
+  int                 pth = pthread_mutex_unlock (&w->mutex);
+
+  SC_CHECK_ABORT (pth == 0, "pthread_mutex_unlock");
+}
+
+static void
+sc_mpi_twait (sc_mpi_world_t * w)
+{
+  int                 pth = pthread_cond_wait (&w->cond, &w->mutex);
+
+  SC_CHECK_ABORT (pth == 0, "pthread_cond_wait");
+}
+
+static void
+sc_mpi_tsignal (sc_mpi_world_t * w)
+{
+  int                 pth = pthread_cond_broadcast (&w->cond);
+
+  SC_CHECK_ABORT (pth == 0, "pthread_cond_broadcast");
+}
+
+/** Add a communicator to the world; the caller holds the lock.
+ * \return          Its handle.
+ */
+static              sc_MPI_Comm
+sc_mpi_tcomm_new (sc_mpi_world_t * w, int size, const int *ranks)
+{
+  int                 i;
+  sc_mpi_tcomm_t     *c = SC_ALLOC_ZERO (sc_mpi_tcomm_t, 1);
+
+  c->size = size;
+  c->ranks = SC_ALLOC (int, size);
+  c->local = SC_ALLOC (int, w->size);
+  c->slots = SC_ALLOC_ZERO (void *, size);
+  for (i = 0; i < w->size; ++i) {
+    c->local[i] = -1;
+  }
+  for (i = 0; i < size; ++i) {
+    c->ranks[i] = ranks[i];
+    c->local[ranks[i]] = i;
+  }
+  *(sc_mpi_tcomm_t **) sc_array_push (&w->comms) = c;
+  return sc_MPI_COMM_WORLD + (sc_MPI_Comm) (w->comms.elem_count - 1);
+}
+
+/** Return the communicator index of a handle for the calling rank. */
+static int
+sc_mpi_tcomm_index (sc_MPI_Comm comm)
+{
+  SC_CHECK_ABORT (comm != sc_MPI_COMM_NULL, "Invalid communicator");
+  if (comm == sc_MPI_COMM_SELF) {
+    return 1 + sc_mpi_trank->rank;
+  }
+  return (int) (comm - sc_MPI_COMM_WORLD);
+}
+
+/** Look up a communicator and the member number of the calling rank. */
+static sc_mpi_tcomm_t *
+sc_mpi_tcomm_get (sc_MPI_Comm comm, int *context, int *member)
+{
+  int                 index = sc_mpi_tcomm_index (comm);
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+  sc_mpi_tcomm_t     *c;
+
+  sc_mpi_tlock (w);
+  SC_CHECK_ABORT (0 <= index && index < (int) w->comms.elem_count,
+                  "Invalid communicator");
+  c = *(sc_mpi_tcomm_t **) sc_array_index_int (&w->comms, index);
+  sc_mpi_tunlock (w);
+
+  *member = c->local[sc_mpi_trank->rank];
+  SC_CHECK_ABORT (*member >= 0, "Rank is not a member of the communicator");
+  if (context != NULL) {
+    *context = index;
+  }
+  return c;
+}
+
+static void
+sc_mpi_tbarrier (sc_mpi_tcomm_t * c)
+{
+  long                generation;
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+
+  sc_mpi_tlock (w);
+  generation = c->generation;
+  if (++c->arrived == c->size) {
+    c->arrived = 0;
+    ++c->generation;
+    sc_mpi_tsignal (w);
+  }
+  else {
+    while (generation == c->generation) {
+      sc_mpi_twait (w);
+    }
+  }
+  sc_mpi_tunlock (w);
+}
+
+/** Publish the arguments of a collective and wait for all members. */
+static void
+sc_mpi_tpublish (sc_mpi_tcomm_t * c, int member, sc_mpi_targs_t * args)
+{
+  c->slots[member] = args;
+  sc_mpi_tbarrier (c);
+}
+
+/** The arguments published by a member. */
+static sc_mpi_targs_t *
+sc_mpi_tslot (sc_mpi_tcomm_t * c, int member)
+{
+  return (sc_mpi_targs_t *) c->slots[member];
+}
+
+/** Reduce the send buffers of members [first, last) into \a q. */
+static void
+sc_mpi_treduce_range (sc_mpi_tcomm_t * c, int first, int last, size_t offset,
+                      void *q, int n, sc_MPI_Datatype t, sc_MPI_Op op)
+{
+  int                 i;
+  size_t              bytes = (size_t) n * sc_mpi_sizeof (t);
+
+  SC_ASSERT (first < last);
+  memcpy (q, (char *) sc_mpi_tslot (c, first)->sbuf + offset, bytes);
+  for (i = first + 1; i < last; ++i) {
+    sc_mpi_treduce ((char *) sc_mpi_tslot (c, i)->sbuf + offset, q, n, t,
+                    op);
+  }
+}
+
+/* the collectives below publish their arguments, copy, and synchronize */
+
+static int
+sc_mpi_thread_barrier (sc_MPI_Comm comm)
+{
+  int                 member;
+
+  sc_mpi_tbarrier (sc_mpi_tcomm_get (comm, NULL, &member));
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_bcast (void *p, int n, sc_MPI_Datatype t, int root,
+                     sc_MPI_Comm comm)
+{
+  int                 member;
+  sc_mpi_targs_t      args;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, NULL, &member);
+
+  SC_CHECK_ABORT (0 <= root && root < c->size, "Invalid root");
+  args.sbuf = p;
+  sc_mpi_tpublish (c, member, &args);
+  if (member != root) {
+    memcpy (p, sc_mpi_tslot (c, root)->sbuf, (size_t) n * sc_mpi_sizeof (t));
+  }
+  sc_mpi_tbarrier (c);
+  return sc_MPI_SUCCESS;
+}
+
+/** Gather to one or all members by counts or by counts and displacements. */
+static int
+sc_mpi_thread_gather (void *p, int np, sc_MPI_Datatype tp,
+                      void *q, int nq, int *recvc, int *displ,
+                      sc_MPI_Datatype tq, int root, sc_MPI_Comm comm)
+{
+  int                 member, i;
+  size_t              sq = sc_mpi_sizeof (tq);
+  sc_mpi_targs_t      args, *peer;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, NULL, &member);
+
+  SC_CHECK_ABORT (root < c->size, "Invalid root");
+  args.sbuf = p;
+  args.scount = np;
+  args.stype = tp;
+  sc_mpi_tpublish (c, member, &args);
+  if (root < 0 || member == root) {
+    for (i = 0; i < c->size; ++i) {
+      peer = sc_mpi_tslot (c, i);
+      SC_ASSERT (recvc == NULL || (size_t) peer->scount *
+                 sc_mpi_sizeof (peer->stype) <= (size_t) recvc[i] * sq);
+      memcpy ((char *) q + (displ == NULL ? (size_t) i * nq : displ[i]) * sq,
+              peer->sbuf, (size_t) peer->scount * sc_mpi_sizeof (peer->stype));
+    }
+  }
+  sc_mpi_tbarrier (c);
+  return sc_MPI_SUCCESS;
+}
+
+/** Scatter from one member or exchange among all of them. */
+static int
+sc_mpi_thread_scatter (void *p, int np, int *sendc, int *sdispl,
+                       sc_MPI_Datatype tp, void *q, int nq, int *recvc,
+                       int *rdispl, sc_MPI_Datatype tq, int root,
+                       sc_MPI_Comm comm)
+{
+  int                 member, i, first, last;
+  size_t              offset, bytes;
+  sc_mpi_targs_t      args, *peer;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, NULL, &member);
+
+  SC_CHECK_ABORT (root < c->size, "Invalid root");
+  args.sbuf = p;
+  args.scount = np;
+  args.scounts = sendc;
+  args.sdispls = sdispl;
+  args.stype = tp;
+  sc_mpi_tpublish (c, member, &args);
+  first = root < 0 ? 0 : root;
+  last = root < 0 ? c->size : root + 1;
+  for (i = first; i < last; ++i) {
+    peer = sc_mpi_tslot (c, i);
+    offset = (peer->sdispls == NULL ? (size_t) member * peer->scount :
+              (size_t) peer->sdispls[member]) * sc_mpi_sizeof (peer->stype);
+    bytes = (size_t) (peer->scounts == NULL ? peer->scount :
+                      peer->scounts[member]) * sc_mpi_sizeof (peer->stype);
+    SC_ASSERT (bytes <= (size_t) (recvc == NULL ? nq : recvc[i]) *
+               sc_mpi_sizeof (tq));
+    memcpy ((char *) q + (rdispl == NULL ? (size_t) (i - first) * nq :
+                          (size_t) rdispl[i]) * sc_mpi_sizeof (tq),
+            (char *) peer->sbuf + offset, bytes);
+  }
+  sc_mpi_tbarrier (c);
+  return sc_MPI_SUCCESS;
+}
+
+/** Reduce to one or all members, per block, or as an (exclusive) scan. */
+static int
+sc_mpi_thread_reduce (void *p, void *q, int n, sc_MPI_Datatype t,
+                      sc_MPI_Op op, int root, int scan, int block,
+                      sc_MPI_Comm comm)
+{
+  int                 member;
+  sc_mpi_targs_t      args;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, NULL, &member);
+
+  SC_CHECK_ABORT (root < c->size, "Invalid root");
+  args.sbuf = p;
+  sc_mpi_tpublish (c, member, &args);
+  if (scan > 0) {
+    sc_mpi_treduce_range (c, 0, member + 1, 0, q, n, t, op);
+  }
+  else if (scan < 0) {
+    if (member > 0) {
+      sc_mpi_treduce_range (c, 0, member, 0, q, n, t, op);
+    }
+  }
+  else if (block) {
+    sc_mpi_treduce_range (c, 0, c->size,
+                          (size_t) member * n * sc_mpi_sizeof (t),
+                          q, n, t, op);
+  }
+  else if (root < 0 || member == root) {
+    sc_mpi_treduce_range (c, 0, c->size, 0, q, n, t, op);
+  }
+  sc_mpi_tbarrier (c);
+  return sc_MPI_SUCCESS;
+}
+
+/** Duplicate or split a communicator. */
+static int
+sc_mpi_thread_split (sc_MPI_Comm comm, int color, int key,
+                     sc_MPI_Comm * newcomm)
+{
+  int                 member, i, j, num, leader;
+  int                *members, *ranks;
+  sc_mpi_targs_t      args, *peer;
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, NULL, &member);
+
+  args.color = color;
+  args.key = key;
+  args.newcomm = sc_MPI_COMM_NULL;
+  sc_mpi_tpublish (c, member, &args);
+  if (color != sc_MPI_UNDEFINED) {
+    /* sort the members of our color by key and member number */
+    members = SC_ALLOC (int, c->size);
+    for (num = 0, i = 0; i < c->size; ++i) {
+      peer = sc_mpi_tslot (c, i);
+      if (peer->color == color) {
+        for (j = num; j > 0 && sc_mpi_tslot (c, members[j - 1])->key >
+             peer->key; --j) {
+          members[j] = members[j - 1];
+        }
+        members[j] = i;
+        ++num;
+      }
+    }
+
+    /* the lowest member of the color creates the communicator */
+    leader = member;
+    for (i = 0; i < num; ++i) {
+      leader = SC_MIN (leader, members[i]);
+    }
+    if (leader == member) {
+      ranks = SC_ALLOC (int, num);
+      for (i = 0; i < num; ++i) {
+        ranks[i] = c->ranks[members[i]];
+      }
+      sc_mpi_tlock (w);
+      args.newcomm = sc_mpi_tcomm_new (w, num, ranks);
+      sc_mpi_tunlock (w);
+      SC_FREE (ranks);
+    }
+    SC_FREE (members);
+    sc_mpi_tbarrier (c);
+    *newcomm = sc_mpi_tslot (c, leader)->newcomm;
+  }
+  else {
+    sc_mpi_tbarrier (c);
+    *newcomm = sc_MPI_COMM_NULL;
+  }
+  sc_mpi_tbarrier (c);
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_comm_size (sc_MPI_Comm comm, int *size)
+{
+  int                 member;
+
+  *size = sc_mpi_tcomm_get (comm, NULL, &member)->size;
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_comm_rank (sc_MPI_Comm comm, int *rank)
+{
+  (void) sc_mpi_tcomm_get (comm, NULL, rank);
+  return sc_MPI_SUCCESS;
+}
+
+/** Groups are not emulated for more than one rank. */
+static int
+sc_mpi_thread_unsupported (const char *name)
+{
+  SC_ABORTF ("%s is not supported by emulated ranks", name);
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_comm_compare (sc_MPI_Comm comm1, sc_MPI_Comm comm2,
+                            int *result)
+{
+  int                 member, i;
+  sc_mpi_tcomm_t     *c1 = sc_mpi_tcomm_get (comm1, NULL, &member);
+  sc_mpi_tcomm_t     *c2 = sc_mpi_tcomm_get (comm2, NULL, &member);
+
+  if (sc_mpi_tcomm_index (comm1) == sc_mpi_tcomm_index (comm2)) {
+    *result = sc_MPI_IDENT;
+    return sc_MPI_SUCCESS;
+  }
+  *result = sc_MPI_CONGRUENT;
+  if (c1->size != c2->size) {
+    *result = sc_MPI_UNEQUAL;
+    return sc_MPI_SUCCESS;
+  }
+  for (i = 0; i < c1->size; ++i) {
+    if (c2->local[c1->ranks[i]] < 0) {
+      *result = sc_MPI_UNEQUAL;
+      break;
+    }
+    if (c1->ranks[i] != c2->ranks[i]) {
+      *result = sc_MPI_SIMILAR;
+    }
+  }
+  return sc_MPI_SUCCESS;
+}
+
+/** Allocate a request handle; the caller holds the lock. */
+static              sc_MPI_Request
+sc_mpi_treq_new (sc_mpi_world_t * w, sc_mpi_treq_t * r)
+{
+  size_t              index;
+
+  if (w->free_requests.elem_count > 0) {
+    index = *(size_t *) sc_array_pop (&w->free_requests);
+    *(sc_mpi_treq_t **) sc_array_index (&w->requests, index) = r;
+  }
+  else {
+    index = w->requests.elem_count;
+    *(sc_mpi_treq_t **) sc_array_push (&w->requests) = r;
+  }
+  return (sc_MPI_Request) (index + 1);
+}
+
+/** Look up a request handle; the caller holds the lock. */
+static sc_mpi_treq_t *
+sc_mpi_treq_get (sc_mpi_world_t * w, sc_MPI_Request request)
+{
+  sc_mpi_treq_t      *r;
+
+  SC_CHECK_ABORT (request > 0 && (size_t) request <= w->requests.elem_count,
+                  "Invalid request");
+  r = *(sc_mpi_treq_t **) sc_array_index (&w->requests,
+                                          (size_t) request - 1);
+  SC_CHECK_ABORT (r != NULL, "Invalid request");
+  return r;
+}
+
+/** Free a completed request and its handle; the caller holds the lock. */
+static void
+sc_mpi_treq_free (sc_mpi_world_t * w, sc_MPI_Request * request,
+                  sc_MPI_Status * status)
+{
+  sc_mpi_treq_t      *r = sc_mpi_treq_get (w, *request);
+
+  SC_ASSERT (r->done);
+  if (status != sc_MPI_STATUS_IGNORE) {
+    *status = r->status;
+  }
+  *(sc_mpi_treq_t **) sc_array_index (&w->requests, (size_t) *request - 1) =
+    NULL;
+  *(size_t *) sc_array_push (&w->free_requests) = (size_t) *request - 1;
+  SC_FREE (r);
+  *request = sc_MPI_REQUEST_NULL;
+}
+
+/** Return whether a receive matches a message. */
+static int
+sc_mpi_tmatch (int context, int source, int tag, const sc_mpi_tmsg_t * m)
+{
+  return m->context == context &&
+    (source == sc_MPI_ANY_SOURCE || source == m->source) &&
+    (tag == sc_MPI_ANY_TAG || tag == m->tag);
+}
+
+/** Copy a matched message into a receive outside of the lock. */
+static void
+sc_mpi_tdeliver (sc_mpi_world_t * w, sc_mpi_treq_t * r, const void *data,
+                 int source, int tag, size_t bytes, sc_mpi_treq_t * sreq)
+{
+  sc_mpi_tcomm_t     *c;
+
+  SC_CHECK_ABORT (bytes <= r->bytes, "Message truncated");
+  memcpy (r->buf, data, bytes);
+
+  sc_mpi_tlock (w);
+  c = *(sc_mpi_tcomm_t **) sc_array_index_int (&w->comms, r->context);
+  r->status.count = (int) bytes;
+  r->status.cancelled = 0;
+  r->status.MPI_SOURCE = c->local[source];
+  r->status.MPI_TAG = tag;
+  r->status.MPI_ERROR = sc_MPI_SUCCESS;
+  r->done = 1;
+  if (sreq != NULL) {
+    sreq->done = 1;
+  }
+  sc_mpi_tsignal (w);
+  sc_mpi_tunlock (w);
+}
+
+/** Send eagerly if \a request is NULL and by rendezvous otherwise. */
+static int
+sc_mpi_thread_send (void *buf, int count, sc_MPI_Datatype datatype,
+                    int dest, int tag, sc_MPI_Comm comm,
+                    sc_MPI_Request * request)
+{
+  int                 member, context, wdest, source;
+  size_t              bytes = (size_t) count * sc_mpi_sizeof (datatype);
+  char               *copy = NULL;
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, &context, &member);
+  sc_mpi_treq_t      *r, *prev, *sreq = NULL;
+  sc_mpi_tmsg_t      *m;
+
+  SC_CHECK_ABORT (0 <= dest && dest < c->size && tag >= 0,
+                  "Invalid destination or tag");
+  wdest = c->ranks[dest];
+  source = sc_mpi_trank->rank;
+  for (;;) {
+    sc_mpi_tlock (w);
+
+    /* find the first matching posted receive of the destination */
+    for (prev = NULL, r = w->posted_head[wdest]; r != NULL;
+         prev = r, r = r->next) {
+      if (r->context == context &&
+          (r->source == sc_MPI_ANY_SOURCE || r->source == source) &&
+          (r->tag == sc_MPI_ANY_TAG || r->tag == tag)) {
+        break;
+      }
+    }
+    if (r != NULL || request != NULL || copy != NULL) {
+      break;
+    }
+
+    /* a blocking send copies before it queues and then looks again */
+    sc_mpi_tunlock (w);
+    copy = SC_ALLOC (char, bytes);
+    memcpy (copy, buf, bytes);
+  }
+  if (request != NULL) {
+    sreq = SC_ALLOC_ZERO (sc_mpi_treq_t, 1);
+    *request = sc_mpi_treq_new (w, sreq);
+  }
+  if (r != NULL) {
+    if (prev == NULL) {
+      w->posted_head[wdest] = r->next;
+    }
+    else {
+      prev->next = r->next;
+    }
+    if (w->posted_tail[wdest] == r) {
+      w->posted_tail[wdest] = prev;
+    }
+    sc_mpi_tunlock (w);
+    sc_mpi_tdeliver (w, r, buf, source, tag, bytes, sreq);
+    SC_FREE (copy);
+    return sc_MPI_SUCCESS;
+  }
+
+  /* queue the message for a later receive */
+  m = SC_ALLOC_ZERO (sc_mpi_tmsg_t, 1);
+  m->context = context;
+  m->source = source;
+  m->tag = tag;
+  m->bytes = bytes;
+  m->data = copy != NULL ? copy : buf;
+  m->copy = copy;
+  m->sreq = sreq;
+  if (w->msg_tail[wdest] == NULL) {
+    w->msg_head[wdest] = m;
+  }
+  else {
+    w->msg_tail[wdest]->next = m;
+  }
+  w->msg_tail[wdest] = m;
+  sc_mpi_tsignal (w);
+  sc_mpi_tunlock (w);
+  return sc_MPI_SUCCESS;
+}
+
+/** Find and optionally unlink the first message matching a receive;
+ * the caller holds the lock. */
+static sc_mpi_tmsg_t *
+sc_mpi_tfind (sc_mpi_world_t * w, int context, int source, int tag,
+              int unlink)
+{
+  int                 rank = sc_mpi_trank->rank;
+  sc_mpi_tmsg_t      *m, *prev;
+
+  for (prev = NULL, m = w->msg_head[rank]; m != NULL; prev = m, m = m->next) {
+    if (sc_mpi_tmatch (context, source, tag, m)) {
+      if (unlink) {
+        if (prev == NULL) {
+          w->msg_head[rank] = m->next;
+        }
+        else {
+          prev->next = m->next;
+        }
+        if (w->msg_tail[rank] == m) {
+          w->msg_tail[rank] = prev;
+        }
+      }
+      return m;
+    }
+  }
+  return NULL;
+}
+
+/** Receive into \a request if not NULL and blockingly otherwise. */
+static int
+sc_mpi_thread_recv (void *buf, int count, sc_MPI_Datatype datatype,
+                    int source, int tag, sc_MPI_Comm comm,
+                    sc_MPI_Request * request, sc_MPI_Status * status)
+{
+  int                 member, context, rank = sc_mpi_trank->rank;
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, &context, &member);
+  sc_mpi_treq_t      *r, blocking;
+  sc_mpi_tmsg_t      *m;
+
+  SC_CHECK_ABORT (source == sc_MPI_ANY_SOURCE ||
+                  (0 <= source && source < c->size), "Invalid source");
+  r = request != NULL ? SC_ALLOC (sc_mpi_treq_t, 1) : &blocking;
+  memset (r, 0, sizeof (sc_mpi_treq_t));
+  r->context = context;
+  r->source = source == sc_MPI_ANY_SOURCE ? source : c->ranks[source];
+  r->tag = tag;
+  r->buf = buf;
+  r->bytes = (size_t) count * sc_mpi_sizeof (datatype);
+
+  sc_mpi_tlock (w);
+  if (request != NULL) {
+    *request = sc_mpi_treq_new (w, r);
+  }
+  m = sc_mpi_tfind (w, context, r->source, tag, 1);
+  if (m == NULL) {
+    /* post the receive for a later send */
+    if (w->posted_tail[rank] == NULL) {
+      w->posted_head[rank] = r;
+    }
+    else {
+      w->posted_tail[rank]->next = r;
+    }
+    w->posted_tail[rank] = r;
+  }
+  sc_mpi_tunlock (w);
+  if (m != NULL) {
+    sc_mpi_tdeliver (w, r, m->data, m->source, m->tag, m->bytes, m->sreq);
+    SC_FREE (m->copy);
+    SC_FREE (m);
+  }
+  if (request == NULL) {
+    sc_mpi_tlock (w);
+    while (!r->done) {
+      sc_mpi_twait (w);
+    }
+    sc_mpi_tunlock (w);
+    if (status != sc_MPI_STATUS_IGNORE) {
+      *status = r->status;
+    }
+  }
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_probe (int source, int tag, sc_MPI_Comm comm, int *flag,
+                     sc_MPI_Status * status)
+{
+  int                 member, context;
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+  sc_mpi_tcomm_t     *c = sc_mpi_tcomm_get (comm, &context, &member);
+  sc_mpi_tmsg_t      *m;
+
+  SC_CHECK_ABORT (source == sc_MPI_ANY_SOURCE ||
+                  (0 <= source && source < c->size), "Invalid source");
+  if (source != sc_MPI_ANY_SOURCE) {
+    source = c->ranks[source];
+  }
+  sc_mpi_tlock (w);
+  while ((m = sc_mpi_tfind (w, context, source, tag, 0)) == NULL &&
+         flag == NULL) {
+    sc_mpi_twait (w);
+  }
+  if (flag != NULL) {
+    *flag = m != NULL;
+  }
+  if (m != NULL && status != sc_MPI_STATUS_IGNORE) {
+    status->count = (int) m->bytes;
+    status->cancelled = 0;
+    status->MPI_SOURCE = c->local[m->source];
+    status->MPI_TAG = m->tag;
+    status->MPI_ERROR = sc_MPI_SUCCESS;
+  }
+  sc_mpi_tunlock (w);
+  return sc_MPI_SUCCESS;
+}
+
+/** Set the status of a null request as MPI does. */
+static void
+sc_mpi_tstatus_empty (sc_MPI_Status * status)
+{
+  if (status != sc_MPI_STATUS_IGNORE) {
+    status->count = 0;
+    status->cancelled = 0;
+    status->MPI_SOURCE = sc_MPI_ANY_SOURCE;
+    status->MPI_TAG = sc_MPI_ANY_TAG;
+    status->MPI_ERROR = sc_MPI_SUCCESS;
+  }
+}
+
+static int
+sc_mpi_thread_wait (sc_MPI_Request * request, sc_MPI_Status * status)
+{
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+
+  if (*request == sc_MPI_REQUEST_NULL) {
+    sc_mpi_tstatus_empty (status);
+    return sc_MPI_SUCCESS;
+  }
+  sc_mpi_tlock (w);
+  while (!sc_mpi_treq_get (w, *request)->done) {
+    sc_mpi_twait (w);
+  }
+  sc_mpi_treq_free (w, request, status);
+  sc_mpi_tunlock (w);
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_waitall (int count, sc_MPI_Request * array_of_requests,
+                       sc_MPI_Status * array_of_statuses)
+{
+  int                 i;
+
+  for (i = 0; i < count; ++i) {
+    sc_mpi_thread_wait (&array_of_requests[i],
+                        array_of_statuses == sc_MPI_STATUSES_IGNORE ?
+                        sc_MPI_STATUS_IGNORE : &array_of_statuses[i]);
+  }
+  return sc_MPI_SUCCESS;
+}
+
+static int
+sc_mpi_thread_waitsome (int incount, sc_MPI_Request * array_of_requests,
+                        int *outcount, int *array_of_indices,
+                        sc_MPI_Status * array_of_statuses)
+{
+  int                 i, active;
+  sc_mpi_world_t     *w = sc_mpi_trank->world;
+
+  sc_mpi_tlock (w);
+  for (;;) {
+    active = 0;
+    *outcount = 0;
+    for (i = 0; i < incount; ++i) {
+      if (array_of_requests[i] == sc_MPI_REQUEST_NULL) {
+        continue;
+      }
+      ++active;
+      if (sc_mpi_treq_get (w, array_of_requests[i])->done) {
+        sc_mpi_treq_free (w, &array_of_requests[i],
+                          array_of_statuses == sc_MPI_STATUSES_IGNORE ?
+                          sc_MPI_STATUS_IGNORE :
+                          &array_of_statuses[*outcount]);
+        array_of_indices[(*outcount)++] = i;
+      }
+    }
+    if (active == 0) {
+      *outcount = sc_MPI_UNDEFINED;
+      break;
+    }
+    if (*outcount > 0) {
+      break;
+    }
+    sc_mpi_twait (w);
+  }
+  sc_mpi_tunlock (w);
+  return sc_MPI_SUCCESS;
+}
+
+static void        *
+sc_mpi_trank_main (void *arg)
+{
+  sc_mpi_trank = (sc_mpi_trank_t *) arg;
+  sc_mpi_trank->result = sc_mpi_trank->rank_main (sc_mpi_trank->user);
+  sc_mpi_trank = NULL;
+  return NULL;
+}
+
+static int
+sc_mpi_threads_run_world (int num_ranks, int (*rank_main) (void *user),
+                          void *user)
+{
+  int                 i, pth, result = 0;
+  int                *ranks;
+  size_t              zz;
+  sc_mpi_world_t      world, *w = &world;
+  sc_mpi_trank_t     *tranks;
+  sc_mpi_tcomm_t     *c;
+  sc_mpi_tmsg_t      *m;
+
+  SC_CHECK_ABORT (sc_mpi_trank == NULL, "Emulated ranks do not nest");
+
+  /* the world communicator and one self communicator per rank */
+  memset (w, 0, sizeof (sc_mpi_world_t));
+  w->size = num_ranks;
+  pth = pthread_mutex_init (&w->mutex, NULL);
+  SC_CHECK_ABORT (pth == 0, "pthread_mutex_init");
+  pth = pthread_cond_init (&w->cond, NULL);
+  SC_CHECK_ABORT (pth == 0, "pthread_cond_init");
+  sc_array_init (&w->comms, sizeof (sc_mpi_tcomm_t *));
+  sc_array_init (&w->requests, sizeof (sc_mpi_treq_t *));
+  sc_array_init (&w->free_requests, sizeof (size_t));
+  w->msg_head = SC_ALLOC_ZERO (sc_mpi_tmsg_t *, num_ranks);
+  w->msg_tail = SC_ALLOC_ZERO (sc_mpi_tmsg_t *, num_ranks);
+  w->posted_head = SC_ALLOC_ZERO (sc_mpi_treq_t *, num_ranks);
+  w->posted_tail = SC_ALLOC_ZERO (sc_mpi_treq_t *, num_ranks);
+  ranks = SC_ALLOC (int, num_ranks);
+  for (i = 0; i < num_ranks; ++i) {
+    ranks[i] = i;
+  }
+  (void) sc_mpi_tcomm_new (w, num_ranks, ranks);
+  for (i = 0; i < num_ranks; ++i) {
+    (void) sc_mpi_tcomm_new (w, 1, &ranks[i]);
+  }
+  SC_FREE (ranks);
+
+  /* run one thread per rank */
+  tranks = SC_ALLOC_ZERO (sc_mpi_trank_t, num_ranks);
+  for (i = 0; i < num_ranks; ++i) {
+    tranks[i].world = w;
+    tranks[i].rank = i;
+    tranks[i].rank_main = rank_main;
+    tranks[i].user = user;
+    pth = pthread_create (&tranks[i].thread, NULL, sc_mpi_trank_main,
+                          &tranks[i]);
+    SC_CHECK_ABORT (pth == 0, "pthread_create");
+  }
+  for (i = 0; i < num_ranks; ++i) {
+    pth = pthread_join (tranks[i].thread, NULL);
+    SC_CHECK_ABORT (pth == 0, "pthread_join");
+    if (result == 0) {
+      result = tranks[i].result;
+    }
+  }
+  SC_FREE (tranks);
+
+  /* release the world including unreceived messages and open requests */
+  for (i = 0; i < num_ranks; ++i) {
+    while ((m = w->msg_head[i]) != NULL) {
+      w->msg_head[i] = m->next;
+      SC_FREE (m->copy);
+      SC_FREE (m);
+    }
+  }
+  for (zz = 0; zz < w->requests.elem_count; ++zz) {
+    SC_FREE (*(sc_mpi_treq_t **) sc_array_index (&w->requests, zz));
+  }
+  for (zz = 0; zz < w->comms.elem_count; ++zz) {
+    c = *(sc_mpi_tcomm_t **) sc_array_index (&w->comms, zz);
+    SC_FREE (c->ranks);
+    SC_FREE (c->local);
+    SC_FREE (c->slots);
+    SC_FREE (c);
+  }
+  sc_array_reset (&w->comms);
+  sc_array_reset (&w->requests);
+  sc_array_reset (&w->free_requests);
+  SC_FREE (w->msg_head);
+  SC_FREE (w->msg_tail);
+  SC_FREE (w->posted_head);
+  SC_FREE (w->posted_tail);
+  pth = pthread_cond_destroy (&w->cond);
+  SC_CHECK_ABORT (pth == 0, "pthread_cond_destroy");
+  pth = pthread_mutex_destroy (&w->mutex);
+  SC_CHECK_ABORT (pth == 0, "pthread_mutex_destroy");
+  return result;
+}
+
+#else /* !SC_ENABLE_PTHREAD */
+
+#define SC_MPI_THREAD_DISPATCH(call) SC_NOOP ()
+
+#endif /* !SC_ENABLE_PTHREAD */
+
 int
 sc_MPI_Init (int *argc, char ***argv)
 {
@@ -87,6 +1179,8 @@ sc_MPI_Abort (sc_MPI_Comm comm, int exitcode)
 int
 sc_MPI_Comm_dup (sc_MPI_Comm comm, sc_MPI_Comm * newcomm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_split (comm, 0, 0, newcomm));
+
   *newcomm = comm;
 
   return sc_MPI_SUCCESS;
@@ -96,6 +1190,8 @@ int
 sc_MPI_Comm_create (sc_MPI_Comm comm, sc_MPI_Group group,
                     sc_MPI_Comm * newcomm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_unsupported ("MPI_Comm_create"));
+
   *newcomm = sc_MPI_COMM_NULL;
 
   return sc_MPI_SUCCESS;
@@ -105,6 +1201,8 @@ int
 sc_MPI_Comm_split (sc_MPI_Comm comm, int color, int key,
                    sc_MPI_Comm * newcomm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_split (comm, color, key, newcomm));
+
   *newcomm = sc_MPI_COMM_NULL;
 
   return sc_MPI_SUCCESS;
@@ -121,6 +1219,8 @@ sc_MPI_Comm_free (sc_MPI_Comm * comm)
 int
 sc_MPI_Comm_size (sc_MPI_Comm comm, int *size)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_comm_size (comm, size));
+
   *size = 1;
 
   return sc_MPI_SUCCESS;
@@ -129,6 +1229,8 @@ sc_MPI_Comm_size (sc_MPI_Comm comm, int *size)
 int
 sc_MPI_Comm_rank (sc_MPI_Comm comm, int *rank)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_comm_rank (comm, rank));
+
   *rank = 0;
 
   return sc_MPI_SUCCESS;
@@ -137,6 +1239,8 @@ sc_MPI_Comm_rank (sc_MPI_Comm comm, int *rank)
 int
 sc_MPI_Comm_compare (sc_MPI_Comm comm1, sc_MPI_Comm comm2, int *result)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_comm_compare (comm1, comm2, result));
+
   if (comm1 == comm2) {
     *result = sc_MPI_IDENT;
   }
@@ -150,6 +1254,8 @@ sc_MPI_Comm_compare (sc_MPI_Comm comm1, sc_MPI_Comm comm2, int *result)
 int
 sc_MPI_Comm_group (sc_MPI_Comm comm, sc_MPI_Group * group)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_unsupported ("MPI_Comm_group"));
+
   *group = sc_MPI_GROUP_NULL;
 
   return sc_MPI_SUCCESS;
@@ -275,12 +1381,16 @@ sc_MPI_Group_range_excl (sc_MPI_Group group, int n, int ranges[][3],
 int
 sc_MPI_Barrier (sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_barrier (comm));
+
   return sc_MPI_SUCCESS;
 }
 
 int
 sc_MPI_Bcast (void *p, int n, sc_MPI_Datatype t, int rank, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_bcast (p, n, t, rank, comm));
+
   SC_ASSERT (rank == 0);
 
   return sc_MPI_SUCCESS;
@@ -296,6 +1406,39 @@ sc_MPI_Gather (void *p, int np, sc_MPI_Datatype tp,
   size_t              lq;
 #endif
 
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_gather (p, np, tp, q, nq, NULL, NULL,
+                                               tq, rank, comm));
+
+  SC_ASSERT (rank == 0 && np >= 0 && nq >= 0);
+
+/* *INDENT-OFF* horrible indent bug */
+  lp = (size_t) np * sc_mpi_sizeof (tp);
+#ifdef SC_ENABLE_DEBUG
+  lq = (size_t) nq * sc_mpi_sizeof (tq);
+#endif
+/* *INDENT-ON* */
+
+  SC_ASSERT (lp == lq);
+  memcpy (q, p, lp);
+
+  return sc_MPI_SUCCESS;
+}
+
+int
+sc_MPI_Gatherv (void *p, int np, sc_MPI_Datatype tp,
+                void *q, int *recvc, int *displ,
+                sc_MPI_Datatype tq, int rank, sc_MPI_Comm comm)
+{
+  size_t              lp;
+#ifdef SC_ENABLE_DEBUG
+  size_t              lq;
+  int                 nq;
+
+  nq = recvc[0];
+#endif
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_gather (p, np, tp, q, 0, recvc,
+                                               displ, tq, rank, comm));
+
   SC_ASSERT (rank == 0 && np >= 0 && nq >= 0);
 
 /* *INDENT-OFF* horrible indent bug */
@@ -306,34 +1449,50 @@ sc_MPI_Gather (void *p, int np, sc_MPI_Datatype tp,
 /* *INDENT-ON* */
 
   SC_ASSERT (lp == lq);
-  memcpy (q, p, lp);
+  memcpy ((char *) q + displ[0] * sc_mpi_sizeof (tq), p, lp);
 
   return sc_MPI_SUCCESS;
 }
 
 int
-sc_MPI_Gatherv (void *p, int np, sc_MPI_Datatype tp,
-                void *q, int *recvc, int *displ,
-                sc_MPI_Datatype tq, int rank, sc_MPI_Comm comm)
+sc_MPI_Scatter (void *p, int np, sc_MPI_Datatype tp,
+                void *q, int nq, sc_MPI_Datatype tq, int rank,
+                sc_MPI_Comm comm)
+{
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_scatter (p, np, NULL, NULL, tp, q,
+                                                nq, NULL, NULL, tq, rank,
+                                                comm));
+
+  return sc_MPI_Gather (p, np, tp, q, nq, tq, rank, comm);
+}
+
+int
+sc_MPI_Scatterv (void *p, int *sendc, int *displ, sc_MPI_Datatype tp,
+                 void *q, int nq, sc_MPI_Datatype tq, int rank,
+                 sc_MPI_Comm comm)
 {
-  size_t              lp;
-#ifdef SC_ENABLE_DEBUG
   size_t              lq;
-  int                 nq;
+#ifdef SC_ENABLE_DEBUG
+  size_t              lp;
+  int                 np;
 
-  nq = recvc[0];
+  np = sendc[0];
 #endif
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_scatter (p, 0, sendc, displ, tp, q,
+                                                nq, NULL, NULL, tq, rank,
+                                                comm));
+
   SC_ASSERT (rank == 0 && np >= 0 && nq >= 0);
 
 /* *INDENT-OFF* horrible indent bug */
-  lp = (size_t) np * sc_mpi_sizeof (tp);
-#ifdef SC_ENABLE_DEBUG
   lq = (size_t) nq * sc_mpi_sizeof (tq);
+#ifdef SC_ENABLE_DEBUG
+  lp = (size_t) np * sc_mpi_sizeof (tp);
 #endif
 /* *INDENT-ON* */
 
   SC_ASSERT (lp == lq);
-  memcpy ((char *) q + displ[0] * sc_mpi_sizeof (tq), p, lp);
+  memcpy (q, (char *) p + displ[0] * sc_mpi_sizeof (tp), lq);
 
   return sc_MPI_SUCCESS;
 }
@@ -342,6 +1501,9 @@ int
 sc_MPI_Allgather (void *p, int np, sc_MPI_Datatype tp,
                   void *q, int nq, sc_MPI_Datatype tq, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_gather (p, np, tp, q, nq, NULL, NULL,
+                                               tq, -1, comm));
+
   return sc_MPI_Gather (p, np, tp, q, nq, tq, 0, comm);
 }
 
@@ -350,6 +1512,9 @@ sc_MPI_Allgatherv (void *p, int np, sc_MPI_Datatype tp,
                    void *q, int *recvc, int *displ,
                    sc_MPI_Datatype tq, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_gather (p, np, tp, q, 0, recvc,
+                                               displ, tq, -1, comm));
+
   return sc_MPI_Gatherv (p, np, tp, q, recvc, displ, tq, 0, comm);
 }
 
@@ -357,15 +1522,35 @@ int
 sc_MPI_Alltoall (void *p, int np, sc_MPI_Datatype tp,
                  void *q, int nq, sc_MPI_Datatype tq, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_scatter (p, np, NULL, NULL, tp, q,
+                                                nq, NULL, NULL, tq, -1,
+                                                comm));
+
   return sc_MPI_Gather (p, np, tp, q, nq, tq, 0, comm);
 }
 
+int
+sc_MPI_Alltoallv (void *p, int *sendc, int *sdispl, sc_MPI_Datatype tp,
+                  void *q, int *recvc, int *rdispl, sc_MPI_Datatype tq,
+                  sc_MPI_Comm comm)
+{
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_scatter (p, 0, sendc, sdispl, tp, q,
+                                                0, recvc, rdispl, tq, -1,
+                                                comm));
+
+  return sc_MPI_Gatherv ((char *) p + sdispl[0] * sc_mpi_sizeof (tp),
+                         sendc[0], tp, q, recvc, rdispl, tq, 0, comm);
+}
+
 int
 sc_MPI_Reduce (void *p, void *q, int n, sc_MPI_Datatype t,
                sc_MPI_Op op, int rank, sc_MPI_Comm comm)
 {
   size_t              l;
 
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_reduce (p, q, n, t, op, rank, 0, 0,
+                                               comm));
+
   SC_ASSERT (rank == 0 && n >= 0);
   mpi_dummy_assert_op (op);
 
@@ -378,10 +1563,23 @@ sc_MPI_Reduce (void *p, void *q, int n, sc_MPI_Datatype t,
   return sc_MPI_SUCCESS;
 }
 
+int
+sc_MPI_Reduce_local (void *inbuf, void *inoutbuf, int count,
+                     sc_MPI_Datatype datatype, sc_MPI_Op op)
+{
+  SC_ASSERT (count >= 0);
+  sc_mpi_treduce (inbuf, inoutbuf, count, datatype, op);
+
+  return sc_MPI_SUCCESS;
+}
+
 int
 sc_MPI_Reduce_scatter_block (void *p, void *q, int n, sc_MPI_Datatype t,
                              sc_MPI_Op op, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_reduce (p, q, n, t, op, -1, 0, 1,
+                                               comm));
+
   return sc_MPI_Reduce (p, q, n, t, op, 0, comm);
 }
 
@@ -389,6 +1587,9 @@ int
 sc_MPI_Allreduce (void *p, void *q, int n, sc_MPI_Datatype t,
                   sc_MPI_Op op, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_reduce (p, q, n, t, op, -1, 0, 0,
+                                               comm));
+
   return sc_MPI_Reduce (p, q, n, t, op, 0, comm);
 }
 
@@ -396,6 +1597,10 @@ int
 sc_MPI_Scan (void *sendbuf, void *recvbuf, int count,
              sc_MPI_Datatype datatype, sc_MPI_Op op, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_reduce (sendbuf, recvbuf, count,
+                                               datatype, op, -1, 1, 0,
+                                               comm));
+
   return sc_MPI_Reduce (sendbuf, recvbuf, count, datatype, op, 0, comm);
 }
 
@@ -404,6 +1609,10 @@ int
 sc_MPI_Exscan (void *sendbuf, void *recvbf, int count,
                sc_MPI_Datatype datatype, sc_MPI_Op op, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_reduce (sendbuf, recvbf, count,
+                                               datatype, op, -1, -1, 0,
+                                               comm));
+
   return sc_MPI_SUCCESS;
 }
 
@@ -411,6 +1620,9 @@ int
 sc_MPI_Recv (void *buf, int count, sc_MPI_Datatype datatype, int source,
              int tag, sc_MPI_Comm comm, sc_MPI_Status * status)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_recv (buf, count, datatype, source,
+                                             tag, comm, NULL, status));
+
   SC_ABORT ("non-MPI MPI_Recv is not implemented");
   return sc_MPI_SUCCESS;
 }
@@ -419,6 +1631,10 @@ int
 sc_MPI_Irecv (void *buf, int count, sc_MPI_Datatype datatype, int source,
               int tag, sc_MPI_Comm comm, sc_MPI_Request * request)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_recv (buf, count, datatype, source,
+                                             tag, comm, request,
+                                             sc_MPI_STATUS_IGNORE));
+
   SC_ABORT ("non-MPI MPI_Irecv is not implemented");
   return sc_MPI_SUCCESS;
 }
@@ -427,6 +1643,9 @@ int
 sc_MPI_Send (void *buf, int count, sc_MPI_Datatype datatype,
              int dest, int tag, sc_MPI_Comm comm)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_send (buf, count, datatype, dest, tag,
+                                             comm, NULL));
+
   SC_ABORT ("non-MPI MPI_Send is not implemented");
   return sc_MPI_SUCCESS;
 }
@@ -435,6 +1654,9 @@ int
 sc_MPI_Isend (void *buf, int count, sc_MPI_Datatype datatype, int dest,
               int tag, sc_MPI_Comm comm, sc_MPI_Request * request)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_send (buf, count, datatype, dest, tag,
+                                             comm, request));
+
   SC_ABORT ("non-MPI MPI_Isend is not implemented");
   return sc_MPI_SUCCESS;
 }
@@ -442,6 +1664,9 @@ sc_MPI_Isend (void *buf, int count, sc_MPI_Datatype datatype, int dest,
 int
 sc_MPI_Probe (int source, int tag, sc_MPI_Comm comm, sc_MPI_Status * status)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_probe (source, tag, comm, NULL,
+                                              status));
+
   SC_ABORT ("non-MPI MPI_Probe is not implemented");
   return sc_MPI_SUCCESS;
 }
@@ -450,6 +1675,9 @@ int
 sc_MPI_Iprobe (int source, int tag, sc_MPI_Comm comm, int *flag,
                sc_MPI_Status * status)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_probe (source, tag, comm, flag,
+                                              status));
+
   SC_ABORT ("non-MPI MPI_Iprobe is not implemented");
   return sc_MPI_SUCCESS;
 }
@@ -458,13 +1686,23 @@ int
 sc_MPI_Get_count (sc_MPI_Status * status, sc_MPI_Datatype datatype,
                   int *count)
 {
-  SC_ABORT ("non-MPI MPI_Get_count is not implemented");
+  size_t              size = sc_mpi_sizeof (datatype);
+
+  SC_ASSERT (status != NULL && status != sc_MPI_STATUS_IGNORE);
+  if (status->count % size != 0) {
+    *count = sc_MPI_UNDEFINED;
+  }
+  else {
+    *count = (int) (status->count / size);
+  }
   return sc_MPI_SUCCESS;
 }
 
 int
 sc_MPI_Wait (sc_MPI_Request * request, sc_MPI_Status * status)
 {
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_wait (request, status));
+
   SC_CHECK_ABORT (*request == sc_MPI_REQUEST_NULL,
                   "non-MPI MPI_Wait handles NULL request only");
   return sc_MPI_SUCCESS;
@@ -477,6 +1715,11 @@ sc_MPI_Waitsome (int incount, sc_MPI_Request * array_of_requests,
 {
   int                 i;
 
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_waitsome (incount, array_of_requests,
+                                                  outcount,
+                                                  array_of_indices,
+                                                  array_of_statuses));
+
   for (i = 0; i < incount; ++i) {
     SC_CHECK_ABORT (array_of_requests[i] == sc_MPI_REQUEST_NULL,
                     "non-MPI MPI_Waitsome handles NULL requests only");
@@ -492,6 +1735,9 @@ sc_MPI_Waitall (int count, sc_MPI_Request * array_of_requests,
 {
   int                 i;
 
+  SC_MPI_THREAD_DISPATCH (sc_mpi_thread_waitall (count, array_of_requests,
+                                                array_of_statuses));
+
   for (i = 0; i < count; ++i) {
     SC_CHECK_ABORT (array_of_requests[i] == sc_MPI_REQUEST_NULL,
                     "non-MPI MPI_Waitall handles NULL requests only");
@@ -531,7 +1777,7 @@ sc_MPI_Init_thread (int *argc, char ***argv, int required, int *provided)
 size_t
 sc_mpi_sizeof (sc_MPI_Datatype t)
 {
-  if (t == sc_MPI_CHAR)
+  if (t == sc_MPI_CHAR || t == sc_MPI_SIGNED_CHAR || t == sc_MPI_UNSIGNED_CHAR)
     return sizeof (char);
   if (t == sc_MPI_BYTE)
     return 1;
@@ -557,72 +1803,282 @@ sc_mpi_sizeof (sc_MPI_Datatype t)
   SC_ABORT_NOT_REACHED ();
 }
 
+int
+sc_mpi_threads_run (int num_ranks, int (*rank_main) (void *user), void *user)
+{
+  SC_CHECK_ABORT (num_ranks >= 1, "Need at least one rank");
+#if !defined SC_ENABLE_MPI && defined SC_ENABLE_PTHREAD
+  return sc_mpi_threads_run_world (num_ranks, rank_main, user);
+#else
+  SC_CHECK_ABORT (num_ranks == 1, "Emulated ranks require a configuration"
+                  " with --enable-pthread and without --enable-mpi");
+  return rank_main (user);
+#endif
+}
+
+int
+sc_mpi_is_device_aware (void)
+{
+  const char         *env = getenv ("SC_MPI_DEVICE_AWARE");
+
+  if (env != NULL) {
+    return sc_atoi (env) != 0;
+  }
+#if defined SC_ENABLE_MPI && defined SC_ENABLE_CUDA && \
+  defined MPIX_CUDA_AWARE_SUPPORT && MPIX_CUDA_AWARE_SUPPORT
+  return MPIX_Query_cuda_support ();
+#elif defined SC_ENABLE_MPI && defined SC_ENABLE_HIP && \
+  defined MPIX_ROCM_AWARE_SUPPORT && MPIX_ROCM_AWARE_SUPPORT
+  return MPIX_Query_rocm_support ();
+#else
+  return 0;
+#endif
+}
+
+#if defined(SC_ENABLE_MPI) && MPI_VERSION < 4
+
+/** Describe a number of bytes by a count of a possibly derived datatype.
+ * A derived datatype must be freed by the caller.
+ */
+static int
+sc_mpi_large_type (size_t bytes, MPI_Datatype * type, int *count)
+{
+  int                 mpiret;
+  int                 lengths[2];
+  size_t              pieces, rest;
+  MPI_Aint            displs[2];
+  MPI_Datatype        chunk, types[2];
+
+  if (bytes <= (size_t) INT_MAX) {
+    *type = MPI_BYTE;
+    *count = (int) bytes;
+    return MPI_SUCCESS;
+  }
+
+  /* a number of whole chunks followed by the remaining bytes */
+  pieces = bytes / SC_MPI_LARGE_CHUNK;
+  rest = bytes % SC_MPI_LARGE_CHUNK;
+  SC_ASSERT (pieces <= (size_t) INT_MAX);
+  mpiret = MPI_Type_contiguous ((int) SC_MPI_LARGE_CHUNK, MPI_BYTE, &chunk);
+  SC_CHECK_MPI (mpiret);
+  if (rest == 0) {
+    *type = chunk;
+    *count = (int) pieces;
+  }
+  else {
+    lengths[0] = (int) pieces;
+    lengths[1] = (int) rest;
+    displs[0] = 0;
+    displs[1] = (MPI_Aint) (pieces * SC_MPI_LARGE_CHUNK);
+    types[0] = chunk;
+    types[1] = MPI_BYTE;
+    mpiret = MPI_Type_create_struct (2, lengths, displs, types, type);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Type_free (&chunk);
+    SC_CHECK_MPI (mpiret);
+    *count = 1;
+  }
+  return MPI_Type_commit (type);
+}
+
+#endif
+
+int
+sc_mpi_isend_large (const void *buf, size_t bytes, int dest, int tag,
+                    sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  /* these calls bypass the counting sc_MPI_* wrappers */
+  sc_mpi_stats_add (bytes, 0, 0.);
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 4
+  return MPI_Isend_c (buf, (MPI_Count) bytes, MPI_BYTE, dest, tag, comm,
+                      request);
+#elif defined(SC_ENABLE_MPI)
+  int                 mpiret, count;
+  MPI_Datatype        type;
+
+  mpiret = sc_mpi_large_type (bytes, &type, &count);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Isend ((void *) buf, count, type, dest, tag, comm, request);
+  if (type != MPI_BYTE) {
+    /* MPI keeps the type alive until the send completes */
+    MPI_Type_free (&type);
+  }
+  return mpiret;
+#else
+  SC_CHECK_ABORT (bytes <= (size_t) INT_MAX, "Message too large");
+  return sc_MPI_Isend ((void *) buf, (int) bytes, sc_MPI_BYTE, dest, tag,
+                       comm, request);
+#endif
+}
+
+int
+sc_mpi_irecv_large (void *buf, size_t bytes, int source, int tag,
+                    sc_MPI_Comm comm, sc_MPI_Request * request)
+{
+  /* these calls bypass the counting sc_MPI_* wrappers */
+  sc_mpi_stats_add (0, bytes, 0.);
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 4
+  return MPI_Irecv_c (buf, (MPI_Count) bytes, MPI_BYTE, source, tag, comm,
+                      request);
+#elif defined(SC_ENABLE_MPI)
+  int                 mpiret, count;
+  MPI_Datatype        type;
+
+  mpiret = sc_mpi_large_type (bytes, &type, &count);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Irecv (buf, count, type, source, tag, comm, request);
+  if (type != MPI_BYTE) {
+    MPI_Type_free (&type);
+  }
+  return mpiret;
+#else
+  SC_CHECK_ABORT (bytes <= (size_t) INT_MAX, "Message too large");
+  return sc_MPI_Irecv (buf, (int) bytes, sc_MPI_BYTE, source, tag, comm,
+                       request);
+#endif
+}
+
+int
+sc_mpi_send_large (const void *buf, size_t bytes, int dest, int tag,
+                   sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  sc_MPI_Request      request;
+
+  mpiret = sc_mpi_isend_large (buf, bytes, dest, tag, comm, &request);
+  if (mpiret != sc_MPI_SUCCESS) {
+    return mpiret;
+  }
+  return sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+}
+
+int
+sc_mpi_recv_large (void *buf, size_t bytes, int source, int tag,
+                   sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  sc_MPI_Request      request;
+
+  mpiret = sc_mpi_irecv_large (buf, bytes, source, tag, comm, &request);
+  if (mpiret != sc_MPI_SUCCESS) {
+    return mpiret;
+  }
+  return sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+}
+
 #if defined(SC_ENABLE_MPI)
 
-/* these should be initialized in sc_init() */
+/** The node layout cached as an attribute on a communicator.
+ * It is allocated in one block with MPI_Alloc_mem since it may outlive
+ * sc_finalize, followed by the (node, intrarank) pair of every rank.
+ * Both communicators are MPI_COMM_NULL while the layout is pending and
+ * if no node layout is accepted, in which case it is not looked up again.
+ */
+typedef struct sc_mpi_node_info
+{
+  int                 pending;  /**< determine the layout on first use */
+  MPI_Comm            intranode;
+  MPI_Comm            internode;
+  int                 size;     /**< size of the super communicator */
+  int                *locations;        /**< 2 * size entries or NULL */
+}
+sc_mpi_node_info_t;
+
+/* created on the first attachment of node communicators */
 static int          sc_mpi_node_comm_keyval = MPI_KEYVAL_INVALID;
 
 static int
-sc_mpi_node_comms_destroy (MPI_Comm comm, int comm_keyval,
-                           void *attribute_val, void *extra_state)
+sc_mpi_node_info_alloc (int size, int with_locations,
+                        sc_mpi_node_info_t ** pinfo)
 {
   int                 mpiret;
-  MPI_Comm           *node_comms = (MPI_Comm *) attribute_val;
+  size_t              bytes;
+  sc_mpi_node_info_t *info;
 
-  mpiret = MPI_Comm_free (&node_comms[0]);
-  if (mpiret != MPI_SUCCESS) {
-    return mpiret;
+  /* We can't used SC_ALLOC because these might be destroyed after
+   * sc finalizes */
+  bytes = sizeof (sc_mpi_node_info_t);
+  if (with_locations) {
+    bytes += 2 * (size_t) size * sizeof (int);
   }
-  mpiret = MPI_Comm_free (&node_comms[1]);
+  mpiret = MPI_Alloc_mem ((MPI_Aint) bytes, MPI_INFO_NULL, &info);
   if (mpiret != MPI_SUCCESS) {
     return mpiret;
   }
-  mpiret = MPI_Free_mem (node_comms);
-
+  info->pending = 0;
+  info->intranode = MPI_COMM_NULL;
+  info->internode = MPI_COMM_NULL;
+  info->size = size;
+  info->locations = with_locations ? (int *) (info + 1) : NULL;
+  *pinfo = info;
   return MPI_SUCCESS;
 }
 
+static int
+sc_mpi_node_comms_destroy (MPI_Comm comm, int comm_keyval,
+                           void *attribute_val, void *extra_state)
+{
+  int                 mpiret;
+  sc_mpi_node_info_t *info = (sc_mpi_node_info_t *) attribute_val;
+
+  if (info->intranode != MPI_COMM_NULL) {
+    mpiret = MPI_Comm_free (&info->intranode);
+    if (mpiret != MPI_SUCCESS) {
+      return mpiret;
+    }
+  }
+  if (info->internode != MPI_COMM_NULL) {
+    mpiret = MPI_Comm_free (&info->internode);
+    if (mpiret != MPI_SUCCESS) {
+      return mpiret;
+    }
+  }
+  return MPI_Free_mem (info);
+}
+
 static int
 sc_mpi_node_comms_copy (MPI_Comm oldcomm, int comm_keyval,
                         void *extra_state,
                         void *attribute_val_in,
                         void *attribute_val_out, int *flag)
 {
-  MPI_Comm           *node_comms_in = (MPI_Comm *) attribute_val_in;
-  MPI_Comm           *node_comms_out;
+  sc_mpi_node_info_t *info_in = (sc_mpi_node_info_t *) attribute_val_in;
+  sc_mpi_node_info_t *info_out;
   int                 mpiret;
 
-  /* We can't used SC_ALLOC because these might be destroyed after
-   * sc finalizes */
-  mpiret =
-    MPI_Alloc_mem (2 * sizeof (MPI_Comm), MPI_INFO_NULL, &node_comms_out);
+  mpiret = sc_mpi_node_info_alloc (info_in->size,
+                                   info_in->locations != NULL, &info_out);
   if (mpiret != MPI_SUCCESS) {
     return mpiret;
   }
-
-  mpiret = MPI_Comm_dup (node_comms_in[0], &node_comms_out[0]);
-  if (mpiret != MPI_SUCCESS) {
-    return mpiret;
+  info_out->pending = info_in->pending;
+  if (info_in->locations != NULL) {
+    memcpy (info_out->locations, info_in->locations,
+            2 * (size_t) info_in->size * sizeof (int));
   }
-  mpiret = MPI_Comm_dup (node_comms_in[1], &node_comms_out[1]);
-  if (mpiret != MPI_SUCCESS) {
-    return mpiret;
+  if (info_in->intranode != MPI_COMM_NULL) {
+    mpiret = MPI_Comm_dup (info_in->intranode, &info_out->intranode);
+    if (mpiret != MPI_SUCCESS) {
+      return mpiret;
+    }
+  }
+  if (info_in->internode != MPI_COMM_NULL) {
+    mpiret = MPI_Comm_dup (info_in->internode, &info_out->internode);
+    if (mpiret != MPI_SUCCESS) {
+      return mpiret;
+    }
   }
 
-  *((MPI_Comm **) attribute_val_out) = node_comms_out;
+  *((sc_mpi_node_info_t **) attribute_val_out) = info_out;
   *flag = 1;
 
   return MPI_SUCCESS;
 }
 
-#endif /* SC_ENABLE_MPI */
-
-void
-sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
+static void
+sc_mpi_node_keyval_create (void)
 {
-#if defined(SC_ENABLE_MPI)
-  int                 mpiret, rank, size;
-  MPI_Comm           *node_comms, internode, intranode;
+  int                 mpiret;
 
   if (sc_mpi_node_comm_keyval == MPI_KEYVAL_INVALID) {
     /* register the node comm attachment with MPI */
@@ -633,74 +2089,166 @@ sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
     SC_CHECK_MPI (mpiret);
   }
   SC_ASSERT (sc_mpi_node_comm_keyval != MPI_KEYVAL_INVALID);
+}
 
-  mpiret = MPI_Comm_size (comm, &size);
+#if defined(SC_ENABLE_MPICOMMSHARED)
+
+/** Determine the shared memory layout of \a comm.
+ * One MPI_Comm_split_type and one allgather of the node leaders suffice:
+ * the rank of our leader in \a comm is found locally by translating the
+ * intranode rank 0, and the node numbers, intranode ranks and node sizes
+ * of all processes follow from the gathered leaders.  The internode
+ * communicator is created only among its members and ordered by node.
+ */
+static sc_mpi_node_info_t *
+sc_mpi_node_info_shared (MPI_Comm comm, int rank, int size)
+{
+  int                 mpiret;
+  int                 p, q, zero = 0, leader, nodes, count, intrarank;
+  int                 uniform, *leaders, *members;
+  MPI_Comm            intranode, internode;
+  MPI_Group           group, intragroup, intergroup;
+  sc_mpi_node_info_t *info;
+
+  mpiret =
+    MPI_Comm_split_type (comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
+                         &intranode);
   SC_CHECK_MPI (mpiret);
-  mpiret = MPI_Comm_rank (comm, &rank);
+  mpiret = MPI_Comm_rank (intranode, &intrarank);
   SC_CHECK_MPI (mpiret);
 
-  if (processes_per_node < 1) {
-#if !defined(SC_ENABLE_MPICOMMSHARED)
-    SC_ABORT
-      ("Require MPI-3 or greater to automatically determine node communicators");
-#else
-    int                 intrasize, intrarank, maxintrasize, minintrasize;
+  /* the rank of the node leader in comm needs no communication */
+  mpiret = MPI_Comm_group (comm, &group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Comm_group (intranode, &intragroup);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_translate_ranks (intragroup, 1, &zero, group, &leader);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_free (&intragroup);
+  SC_CHECK_MPI (mpiret);
 
-    mpiret =
-      MPI_Comm_split_type (comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
-                           &intranode);
-    SC_CHECK_MPI (mpiret);
+  mpiret = sc_mpi_node_info_alloc (size, 1, &info);
+  SC_CHECK_MPI (mpiret);
+  leaders = SC_ALLOC (int, size);
+  mpiret = MPI_Allgather (&leader, 1, MPI_INT, leaders, 1, MPI_INT, comm);
+  SC_CHECK_MPI (mpiret);
 
-    /* We only accept node comms if they are all the same size */
-    mpiret = MPI_Comm_size (intranode, &intrasize);
-    SC_CHECK_MPI (mpiret);
-    mpiret = MPI_Comm_rank (intranode, &intrarank);
-    SC_CHECK_MPI (mpiret);
+  /* leaders are their own leaders and number the nodes in rank order;
+     the intranode rank counts the earlier processes of the same node */
+  nodes = 0;
+  for (p = 0; p < size; ++p) {
+    if (leaders[p] == p) {
+      info->locations[2 * p] = nodes++;
+      info->locations[2 * p + 1] = 0;
+    }
+    else {
+      SC_ASSERT (0 <= leaders[p] && leaders[p] < p);
+      q = leaders[p];
+      info->locations[2 * p] = info->locations[2 * q];
+      info->locations[2 * p + 1] = ++info->locations[2 * q + 1];
+    }
+  }
+  /* the leaders' slots held the running count so far */
+  uniform = 1;
+  count = -1;
+  for (p = 0; p < size; ++p) {
+    if (leaders[p] == p) {
+      if (count >= 0 && count != info->locations[2 * p + 1]) {
+        uniform = 0;
+      }
+      count = info->locations[2 * p + 1];
+      info->locations[2 * p + 1] = 0;
+    }
+  }
+  SC_FREE (leaders);
 
-    mpiret =
-      MPI_Allreduce (&intrasize, &maxintrasize, 1, MPI_INT, MPI_MAX, comm);
+  /* We only accept node comms if they are all the same size */
+  if (!uniform) {
+    SC_GLOBAL_LDEBUG
+      ("node communicators are not the same size: not attaching\n");
+    mpiret = MPI_Comm_free (&intranode);
     SC_CHECK_MPI (mpiret);
-    mpiret =
-      MPI_Allreduce (&intrasize, &minintrasize, 1, MPI_INT, MPI_MIN, comm);
+    mpiret = MPI_Group_free (&group);
     SC_CHECK_MPI (mpiret);
+    info->locations = NULL;
+    return info;
+  }
+
+  /* the processes of the same intranode rank, one per node, by node */
+  members = SC_ALLOC (int, nodes);
+  for (p = 0; p < size; ++p) {
+    if (info->locations[2 * p + 1] == intrarank) {
+      members[info->locations[2 * p]] = p;
+    }
+  }
+  mpiret = MPI_Group_incl (group, nodes, members, &intergroup);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Comm_create_group (comm, intergroup, intrarank, &internode);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_free (&intergroup);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_free (&group);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (members);
 
-    if (maxintrasize != minintrasize) {
-      SC_GLOBAL_LDEBUG
-        ("node communicators are not the same size: not attaching\n");
+  info->intranode = intranode;
+  info->internode = internode;
+  return info;
+}
 
-      mpiret = MPI_Comm_free (&intranode);
-      SC_CHECK_MPI (mpiret);
+#endif /* SC_ENABLE_MPICOMMSHARED */
 
-      return;
-    }
+#endif /* SC_ENABLE_MPI */
+
+void
+sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm, int processes_per_node)
+{
+#if defined(SC_ENABLE_MPI)
+  int                 mpiret, rank, size;
+  sc_mpi_node_info_t *info;
+
+  sc_mpi_node_keyval_create ();
 
-    mpiret = MPI_Comm_split (comm, intrarank, rank, &internode);
+  mpiret = MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  if (processes_per_node < 1) {
+#if !defined(SC_ENABLE_MPICOMMSHARED)
+    SC_ABORT
+      ("Require MPI-3 or greater to automatically determine node communicators");
+#else
+    /* defer the collective work until the node comms are needed */
+    mpiret = sc_mpi_node_info_alloc (size, 0, &info);
     SC_CHECK_MPI (mpiret);
+    info->pending = 1;
 #endif
   }
   else {
-    int                 node, offset;
+    int                 p, node, offset;
 
     SC_ASSERT (!(size % processes_per_node));
 
     node = rank / processes_per_node;
     offset = rank % processes_per_node;
 
-    mpiret = MPI_Comm_split (comm, node, offset, &intranode);
+    mpiret = sc_mpi_node_info_alloc (size, 1, &info);
     SC_CHECK_MPI (mpiret);
+    for (p = 0; p < size; ++p) {
+      info->locations[2 * p] = p / processes_per_node;
+      info->locations[2 * p + 1] = p % processes_per_node;
+    }
 
-    mpiret = MPI_Comm_split (comm, offset, node, &internode);
+    mpiret = MPI_Comm_split (comm, node, offset, &info->intranode);
     SC_CHECK_MPI (mpiret);
-  }
 
-  /* We can't used SC_ALLOC because these might be destroyed after
-   * sc finalizes */
-  mpiret = MPI_Alloc_mem (2 * sizeof (MPI_Comm), MPI_INFO_NULL, &node_comms);
-  SC_CHECK_MPI (mpiret);
-  node_comms[0] = intranode;
-  node_comms[1] = internode;
+    mpiret = MPI_Comm_split (comm, offset, node, &info->internode);
+    SC_CHECK_MPI (mpiret);
+  }
 
-  mpiret = MPI_Comm_set_attr (comm, sc_mpi_node_comm_keyval, node_comms);
+  /* this replaces and destroys a previous attachment */
+  mpiret = MPI_Comm_set_attr (comm, sc_mpi_node_comm_keyval, info);
   SC_CHECK_MPI (mpiret);
 #endif
 }
@@ -709,38 +2257,87 @@ void
 sc_mpi_comm_detach_node_comms (sc_MPI_Comm comm)
 {
 #if defined(SC_ENABLE_MPI)
-  if (comm != MPI_COMM_NULL) {
-    int                 mpiret;
+  if (comm != MPI_COMM_NULL &&
+      sc_mpi_node_comm_keyval != MPI_KEYVAL_INVALID) {
+    int                 mpiret, flag;
+    void               *info;
+
+    /* the node comms may never have been used on this communicator */
+    mpiret = MPI_Comm_get_attr (comm, sc_mpi_node_comm_keyval, &info, &flag);
+    SC_CHECK_MPI (mpiret);
+    if (flag) {
+      mpiret = MPI_Comm_delete_attr (comm, sc_mpi_node_comm_keyval);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+#endif
+}
+
+#if defined(SC_ENABLE_MPI)
+
+/** Return the cached node layout of \a comm, resolving it if pending. */
+static sc_mpi_node_info_t *
+sc_mpi_comm_node_info (sc_MPI_Comm comm)
+{
+  int                 mpiret, flag;
+  sc_mpi_node_info_t *info;
+
+  if (comm == MPI_COMM_NULL ||
+      sc_mpi_node_comm_keyval == MPI_KEYVAL_INVALID) {
+    return NULL;
+  }
+  mpiret = MPI_Comm_get_attr (comm, sc_mpi_node_comm_keyval, &info, &flag);
+  SC_CHECK_MPI (mpiret);
+  if (!flag) {
+    return NULL;
+  }
+#if defined(SC_ENABLE_MPICOMMSHARED)
+  if (info->pending) {
+    int                 rank;
 
-    mpiret = MPI_Comm_delete_attr (comm, sc_mpi_node_comm_keyval);
+    /* first use on this communicator: determine and cache the layout */
+    mpiret = MPI_Comm_rank (comm, &rank);
+    SC_CHECK_MPI (mpiret);
+    info = sc_mpi_node_info_shared (comm, rank, info->size);
+    mpiret = MPI_Comm_set_attr (comm, sc_mpi_node_comm_keyval, info);
     SC_CHECK_MPI (mpiret);
   }
 #endif
+  SC_ASSERT (!info->pending);
+  return info;
 }
 
+#endif /* SC_ENABLE_MPI */
+
 void
 sc_mpi_comm_get_node_comms (sc_MPI_Comm comm,
                             sc_MPI_Comm * intranode, sc_MPI_Comm * internode)
 {
-#ifdef SC_ENABLE_MPI
-  int                 mpiret, flag;
-  sc_MPI_Comm        *node_comms;
+#if defined(SC_ENABLE_MPI)
+  sc_mpi_node_info_t *info;
 #endif
 
   *intranode = sc_MPI_COMM_NULL;
   *internode = sc_MPI_COMM_NULL;
 #if defined(SC_ENABLE_MPI)
-  if (sc_mpi_node_comm_keyval == MPI_KEYVAL_INVALID) {
-    SC_GLOBAL_LDEBUG
-      ("Asking for node comms before sc_mpi_comm_attach_node_comms is called\n");
-    return;
+  info = sc_mpi_comm_node_info (comm);
+  if (info != NULL) {
+    *intranode = info->intranode;
+    *internode = info->internode;
   }
-  mpiret =
-    MPI_Comm_get_attr (comm, sc_mpi_node_comm_keyval, &node_comms, &flag);
-  SC_CHECK_MPI (mpiret);
-  if (flag && node_comms) {
-    *intranode = (MPI_Comm) node_comms[0];
-    *internode = (MPI_Comm) node_comms[1];
+#endif
+}
+
+const int          *
+sc_mpi_comm_get_node_locations (sc_MPI_Comm comm)
+{
+#if defined(SC_ENABLE_MPI)
+  sc_mpi_node_info_t *info;
+
+  info = sc_mpi_comm_node_info (comm);
+  if (info != NULL && info->intranode != MPI_COMM_NULL) {
+    return info->locations;
   }
 #endif
+  return NULL;
 }
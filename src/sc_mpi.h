@@ -57,6 +57,8 @@ typedef enum
   SC_TAG_AG_RECURSIVE_A,
   SC_TAG_AG_RECURSIVE_B,
   SC_TAG_AG_RECURSIVE_C,
+  SC_TAG_AG_RING,
+  SC_TAG_AG_BRUCK,
   SC_TAG_NOTIFY_CENSUS,
   SC_TAG_NOTIFY_CENSUSV,
   SC_TAG_NOTIFY_NBX,
@@ -67,11 +69,20 @@ typedef enum
   SC_TAG_NOTIFY_PAYLOAD,
   SC_TAG_NOTIFY_SUPER_TRUE,
   SC_TAG_NOTIFY_SUPER_EXTRA,
+  SC_TAG_NOTIFY_PLAN,
+  SC_TAG_NOTIFY_PLANV,
+  SC_TAG_NOTIFY_SEGMENTS,
+  SC_TAG_NOTIFY_REQUEST,
+  SC_TAG_NOTIFY_REQUEST_ODD,
   SC_TAG_NOTIFY_RECURSIVE,
   SC_TAG_NOTIFY_NARY = SC_TAG_NOTIFY_RECURSIVE + 32,
   SC_TAG_REDUCE = SC_TAG_NOTIFY_NARY + 32,
+  SC_TAG_IREDUCE,
+  SC_TAG_NEIGHBOR,
   SC_TAG_PSORT_LO,
   SC_TAG_PSORT_HI,
+  SC_TAG_IO_AGGREGATE,
+  SC_TAG_DHT,
   SC_TAG_LAST
 }
 sc_tag_t;
@@ -172,29 +183,119 @@ sc_tag_t;
 #define sc_MPI_Group_excl          MPI_Group_excl
 #define sc_MPI_Group_range_incl    MPI_Group_range_incl
 #define sc_MPI_Group_range_excl    MPI_Group_range_excl
-#define sc_MPI_Barrier             MPI_Barrier
-#define sc_MPI_Bcast               MPI_Bcast
-#define sc_MPI_Gather              MPI_Gather
-#define sc_MPI_Gatherv             MPI_Gatherv
-#define sc_MPI_Allgather           MPI_Allgather
-#define sc_MPI_Allgatherv          MPI_Allgatherv
-#define sc_MPI_Alltoall            MPI_Alltoall
-#define sc_MPI_Reduce              MPI_Reduce
-#define sc_MPI_Reduce_scatter_block MPI_Reduce_scatter_block
-#define sc_MPI_Allreduce           MPI_Allreduce
-#define sc_MPI_Scan                MPI_Scan
-#define sc_MPI_Exscan              MPI_Exscan
-#define sc_MPI_Recv                MPI_Recv
-#define sc_MPI_Irecv               MPI_Irecv
-#define sc_MPI_Send                MPI_Send
-#define sc_MPI_Isend               MPI_Isend
-#define sc_MPI_Probe               MPI_Probe
+#define sc_MPI_Barrier             sc_mpi_stats_barrier
+#define sc_MPI_Bcast               sc_mpi_stats_bcast
+#define sc_MPI_Gather              sc_mpi_stats_gather
+#define sc_MPI_Gatherv             sc_mpi_stats_gatherv
+#define sc_MPI_Scatter             sc_mpi_stats_scatter
+#define sc_MPI_Scatterv            sc_mpi_stats_scatterv
+#define sc_MPI_Allgather           sc_mpi_stats_allgather
+#define sc_MPI_Allgatherv          sc_mpi_stats_allgatherv
+#define sc_MPI_Alltoall            sc_mpi_stats_alltoall
+#define sc_MPI_Alltoallv           sc_mpi_stats_alltoallv
+#define sc_MPI_Reduce              sc_mpi_stats_reduce
+#define sc_MPI_Reduce_local        MPI_Reduce_local
+#define sc_MPI_Reduce_scatter_block sc_mpi_stats_reduce_scatter_block
+#define sc_MPI_Allreduce           sc_mpi_stats_allreduce
+#define sc_MPI_Scan                sc_mpi_stats_scan
+#define sc_MPI_Exscan              sc_mpi_stats_exscan
+#define sc_MPI_Recv                sc_mpi_stats_recv
+#define sc_MPI_Irecv               sc_mpi_stats_irecv
+#define sc_MPI_Send                sc_mpi_stats_send
+#define sc_MPI_Isend               sc_mpi_stats_isend
+#define sc_MPI_Probe               sc_mpi_stats_probe
 #define sc_MPI_Iprobe              MPI_Iprobe
 #define sc_MPI_Get_count           MPI_Get_count
 #define sc_MPI_Wtime               MPI_Wtime
-#define sc_MPI_Wait                MPI_Wait
-#define sc_MPI_Waitsome            MPI_Waitsome
-#define sc_MPI_Waitall             MPI_Waitall
+#define sc_MPI_Wait                sc_mpi_stats_wait
+#define sc_MPI_Waitsome            sc_mpi_stats_waitsome
+#define sc_MPI_Waitall             sc_mpi_stats_waitall
+
+/* The communication functions above count calls, bytes and time while
+   the statistics of \ref sc_mpi_stats_start are active. */
+
+int                 sc_mpi_stats_barrier (sc_MPI_Comm comm);
+int                 sc_mpi_stats_bcast (void *p, int n, sc_MPI_Datatype t,
+                                        int root, sc_MPI_Comm comm);
+int                 sc_mpi_stats_gather (const void *p, int np,
+                                         sc_MPI_Datatype tp, void *q, int nq,
+                                         sc_MPI_Datatype tq, int root,
+                                         sc_MPI_Comm comm);
+int                 sc_mpi_stats_gatherv (const void *p, int np,
+                                          sc_MPI_Datatype tp, void *q,
+                                          const int *recvc,
+                                          const int *displ,
+                                          sc_MPI_Datatype tq, int root,
+                                          sc_MPI_Comm comm);
+int                 sc_mpi_stats_scatter (const void *p, int np,
+                                          sc_MPI_Datatype tp, void *q,
+                                          int nq, sc_MPI_Datatype tq,
+                                          int root, sc_MPI_Comm comm);
+int                 sc_mpi_stats_scatterv (const void *p, const int *sendc,
+                                           const int *displ,
+                                           sc_MPI_Datatype tp, void *q,
+                                           int nq, sc_MPI_Datatype tq,
+                                           int root, sc_MPI_Comm comm);
+int                 sc_mpi_stats_allgather (const void *p, int np,
+                                            sc_MPI_Datatype tp, void *q,
+                                            int nq, sc_MPI_Datatype tq,
+                                            sc_MPI_Comm comm);
+int                 sc_mpi_stats_allgatherv (const void *p, int np,
+                                             sc_MPI_Datatype tp, void *q,
+                                             const int *recvc,
+                                             const int *displ,
+                                             sc_MPI_Datatype tq,
+                                             sc_MPI_Comm comm);
+int                 sc_mpi_stats_alltoall (const void *p, int np,
+                                           sc_MPI_Datatype tp, void *q,
+                                           int nq, sc_MPI_Datatype tq,
+                                           sc_MPI_Comm comm);
+int                 sc_mpi_stats_alltoallv (const void *p, const int *sendc,
+                                            const int *sdispl,
+                                            sc_MPI_Datatype tp, void *q,
+                                            const int *recvc,
+                                            const int *rdispl,
+                                            sc_MPI_Datatype tq,
+                                            sc_MPI_Comm comm);
+int                 sc_mpi_stats_reduce (const void *p, void *q, int n,
+                                         sc_MPI_Datatype t, sc_MPI_Op op,
+                                         int root, sc_MPI_Comm comm);
+int                 sc_mpi_stats_reduce_scatter_block (const void *p,
+                                                       void *q, int n,
+                                                       sc_MPI_Datatype t,
+                                                       sc_MPI_Op op,
+                                                       sc_MPI_Comm comm);
+int                 sc_mpi_stats_allreduce (const void *p, void *q, int n,
+                                            sc_MPI_Datatype t, sc_MPI_Op op,
+                                            sc_MPI_Comm comm);
+int                 sc_mpi_stats_scan (const void *p, void *q, int n,
+                                       sc_MPI_Datatype t, sc_MPI_Op op,
+                                       sc_MPI_Comm comm);
+int                 sc_mpi_stats_exscan (const void *p, void *q, int n,
+                                         sc_MPI_Datatype t, sc_MPI_Op op,
+                                         sc_MPI_Comm comm);
+int                 sc_mpi_stats_recv (void *p, int n, sc_MPI_Datatype t,
+                                       int src, int tag, sc_MPI_Comm comm,
+                                       sc_MPI_Status * status);
+int                 sc_mpi_stats_irecv (void *p, int n, sc_MPI_Datatype t,
+                                        int src, int tag, sc_MPI_Comm comm,
+                                        sc_MPI_Request * request);
+int                 sc_mpi_stats_send (const void *p, int n,
+                                       sc_MPI_Datatype t, int dest, int tag,
+                                       sc_MPI_Comm comm);
+int                 sc_mpi_stats_isend (const void *p, int n,
+                                        sc_MPI_Datatype t, int dest,
+                                        int tag, sc_MPI_Comm comm,
+                                        sc_MPI_Request * request);
+int                 sc_mpi_stats_probe (int src, int tag, sc_MPI_Comm comm,
+                                        sc_MPI_Status * status);
+int                 sc_mpi_stats_wait (sc_MPI_Request * request,
+                                       sc_MPI_Status * status);
+int                 sc_mpi_stats_waitsome (int n, sc_MPI_Request * requests,
+                                           int *outcount, int *indices,
+                                           sc_MPI_Status * statuses);
+int                 sc_mpi_stats_waitall (int n, sc_MPI_Request * requests,
+                                          sc_MPI_Status * statuses);
 
 #else /* !SC_ENABLE_MPI */
 
@@ -322,6 +423,11 @@ int                 sc_MPI_Gather (void *, int, sc_MPI_Datatype, void *, int,
 int                 sc_MPI_Gatherv (void *, int, sc_MPI_Datatype, void *,
                                     int *, int *, sc_MPI_Datatype, int,
                                     sc_MPI_Comm);
+int                 sc_MPI_Scatter (void *, int, sc_MPI_Datatype, void *,
+                                    int, sc_MPI_Datatype, int, sc_MPI_Comm);
+int                 sc_MPI_Scatterv (void *, int *, int *, sc_MPI_Datatype,
+                                     void *, int, sc_MPI_Datatype, int,
+                                     sc_MPI_Comm);
 int                 sc_MPI_Allgather (void *, int, sc_MPI_Datatype, void *,
                                       int, sc_MPI_Datatype, sc_MPI_Comm);
 int                 sc_MPI_Allgatherv (void *, int, sc_MPI_Datatype, void *,
@@ -329,8 +435,13 @@ int                 sc_MPI_Allgatherv (void *, int, sc_MPI_Datatype, void *,
                                        sc_MPI_Comm);
 int                 sc_MPI_Alltoall (void *, int, sc_MPI_Datatype, void *,
                                      int, sc_MPI_Datatype, sc_MPI_Comm);
+int                 sc_MPI_Alltoallv (void *, int *, int *, sc_MPI_Datatype,
+                                      void *, int *, int *, sc_MPI_Datatype,
+                                      sc_MPI_Comm);
 int                 sc_MPI_Reduce (void *, void *, int, sc_MPI_Datatype,
                                    sc_MPI_Op, int, sc_MPI_Comm);
+int                 sc_MPI_Reduce_local (void *, void *, int,
+                                         sc_MPI_Datatype, sc_MPI_Op);
 int                 sc_MPI_Reduce_scatter_block (void *, void *,
                                                  int, sc_MPI_Datatype,
                                                  sc_MPI_Op, sc_MPI_Comm);
@@ -395,16 +506,84 @@ int                 sc_MPI_Init_thread (int *argc, char ***argv,
  */
 size_t              sc_mpi_sizeof (sc_MPI_Datatype t);
 
+/** Return whether MPI accepts pointers to accelerator memory.
+ * With --enable-cuda or --enable-hip, this queries the CUDA or ROCm
+ * awareness of the MPI library where it provides MPIX_Query_*_support.
+ * The environment variable SC_MPI_DEVICE_AWARE overrides the answer.
+ * \return         True if device buffers may be passed to MPI calls.
+ */
+int                 sc_mpi_is_device_aware (void);
+
+/** Run a program on several ranks emulated by the threads of this process.
+ * Configured with --enable-pthread and without MPI, every thread calls
+ * \a rank_main and sees the sc_MPI_* functions as a rank of its own
+ * sc_MPI_COMM_WORLD of \a num_ranks ranks; sc_MPI_COMM_SELF, duplicates and
+ * splits work as well.  Collectives copy directly between the buffers of
+ * the ranks, and nonblocking sends copy once into the matching receive.
+ * A blocking send buffers its message and returns without waiting.
+ * Groups and sc_MPI_Comm_create are not supported, and communicators are
+ * released only on return.  sc_init, logging and the package registry
+ * remain global to the process and must be set up before this call.
+ * In other configurations, \a num_ranks must be 1 and \a rank_main is
+ * called directly.
+ * \param [in] num_ranks    Number of ranks, at least 1.
+ * \param [in] rank_main    Program run by each rank with \a user.
+ * \param [in] user         Passed to \a rank_main.
+ * \return                  The first nonzero return value of \a rank_main
+ *                          by rank, or 0.
+ */
+int                 sc_mpi_threads_run (int num_ranks,
+                                        int (*rank_main) (void *user),
+                                        void *user);
+
+/** Messages of more bytes are split into pieces of this size */
+#define SC_MPI_LARGE_CHUNK ((size_t) 1 << 30)
+
+/** Send a message of any number of bytes, even beyond INT_MAX.
+ * With MPI-4 the large-count variant of MPI_Isend is used.  Otherwise
+ * a message above INT_MAX bytes is described by a derived datatype of
+ * pieces of \ref SC_MPI_LARGE_CHUNK bytes and a remainder.
+ * The receiver must use \ref sc_mpi_irecv_large or
+ * \ref sc_mpi_recv_large with the same number of bytes.
+ * \return         The return value of the MPI call.
+ */
+int                 sc_mpi_isend_large (const void *buf, size_t bytes,
+                                        int dest, int tag, sc_MPI_Comm comm,
+                                        sc_MPI_Request * request);
+
+/** Receive a message sent by \ref sc_mpi_isend_large or
+ * \ref sc_mpi_send_large of exactly \b bytes bytes.
+ * \return         The return value of the MPI call.
+ */
+int                 sc_mpi_irecv_large (void *buf, size_t bytes,
+                                        int source, int tag,
+                                        sc_MPI_Comm comm,
+                                        sc_MPI_Request * request);
+
+/** Blocking variant of \ref sc_mpi_isend_large. */
+int                 sc_mpi_send_large (const void *buf, size_t bytes,
+                                       int dest, int tag, sc_MPI_Comm comm);
+
+/** Blocking variant of \ref sc_mpi_irecv_large. */
+int                 sc_mpi_recv_large (void *buf, size_t bytes, int source,
+                                       int tag, sc_MPI_Comm comm);
+
 /** Compute ``sc_intranode_comm'' and ``sc_internode_comm''
  * communicators and attach them to the current communicator.  This split
  * takes \a processes_per_node passed by the user at face value: there is no
  * hardware checking to see if this is the true affinity.
+ * The internode rank of a process is the number of its node, the same for
+ * every intranode rank.  A previous attachment is replaced.
  *
  * \param [in/out] comm                 MPI communicator
  * \param [in]     processes_per_node   the size of the intranode
  *                                      communicators. if < 1,
- *                                      sc will try to determine the correct
- *                                      shared memory communicators.
+ *                                      sc will determine the correct
+ *                                      shared memory communicators on first
+ *                                      use with one MPI_Comm_split_type and
+ *                                      one allgather; this call is then
+ *                                      cheap.  If they differ in size, no
+ *                                      node communicators are cached.
  */
 void                sc_mpi_comm_attach_node_comms (sc_MPI_Comm comm,
                                                    int processes_per_node);
@@ -419,6 +598,10 @@ void                sc_mpi_comm_detach_node_comms (sc_MPI_Comm comm);
 
 /** Get the communicators computed in sc_mpi_comm_attach_node_comms() if they
  * exist; return sc_MPI_COMM_NULL otherwise.
+ * If they were attached with automatic detection, which sc_init does for its
+ * communicator, they are determined on this first use and cached on \a comm
+ * and its duplicates, so sc_shmem, sc_notify and others share them.
+ * Such a first call is collective over \a comm.
  *
  * \param[in] comm            Super communicator
  * \param[out] intranode      intranode communicator
@@ -428,6 +611,96 @@ void                sc_mpi_comm_get_node_comms (sc_MPI_Comm comm,
                                                 sc_MPI_Comm * intranode,
                                                 sc_MPI_Comm * internode);
 
+/** Get the node layout cached with the node communicators of \a comm.
+ * Determines pending node communicators like \ref sc_mpi_comm_get_node_comms
+ * and has the same collective semantics.
+ *
+ * \param[in] comm            Super communicator
+ * \return                    NULL if there are no node communicators, else
+ *                            2 * size of \a comm integers owned by the
+ *                            attribute: the node number (the internode rank)
+ *                            and the intranode rank of every process.
+ */
+const int          *sc_mpi_comm_get_node_locations (sc_MPI_Comm comm);
+
+/** The parts of libsc to which the statistics attribute MPI calls. */
+typedef enum sc_mpi_category
+{
+  SC_MPI_CATEGORY_OTHER,        /**< Calls outside of the parts below. */
+  SC_MPI_CATEGORY_NOTIFY,       /**< The sc_notify functions. */
+  SC_MPI_CATEGORY_PSORT,        /**< \ref sc_psort and its variants. */
+  SC_MPI_CATEGORY_ALLGATHER,    /**< The sc_allgather functions. */
+  SC_MPI_CATEGORY_REDUCE,       /**< The sc_reduce functions. */
+  SC_MPI_CATEGORY_SHMEM,        /**< The sc_shmem functions. */
+  SC_MPI_CATEGORY_IO,           /**< The MPI functions of sc_io. */
+  SC_MPI_CATEGORY_LAST          /**< Number of categories. */
+}
+sc_mpi_category_t;
+
+/** Start counting the communication through the sc_MPI_* wrappers.
+ * While active, every call of a point-to-point, wait or collective
+ * sc_MPI_* function records the bytes of its send and receive buffers and
+ * the time spent in it, attributed to the category of the libsc function
+ * that issued it, see \ref sc_mpi_stats_enter.  Received bytes of
+ * nonblocking receives are counted by the size of the posted buffer.
+ * MPI calls made directly, not through the sc_MPI_* names, are not seen.
+ * Without MPI nothing is recorded.  The previous counts are discarded.
+ * If the environment variable SC_MPI_STATS is set, \ref sc_init calls
+ * this function and \ref sc_finalize prints the statistics, which makes
+ * \ref sc_finalize collective.
+ * Counting from several threads at once requires a compiler with GNU
+ * atomic builtins; otherwise the counters and categories are shared.
+ */
+void                sc_mpi_stats_start (void);
+
+/** Stop counting and keep the counts for \ref sc_mpi_stats_get. */
+void                sc_mpi_stats_stop (void);
+
+/** Return true if the communication is counted. */
+int                 sc_mpi_stats_is_active (void);
+
+/** Attribute the MPI calls of the calling thread to a category.
+ * Calls are nested like those of \ref sc_tracer_begin and the outermost
+ * category applies, such that the communication of sc_allgather called
+ * inside sc_psort counts for psort.  This is cheap if not counting.
+ * \param [in] category    The category of the following calls.
+ */
+void                sc_mpi_stats_enter (sc_mpi_category_t category);
+
+/** End the category most recently entered by the calling thread. */
+void                sc_mpi_stats_leave (void);
+
+/** Count one call made outside of the sc_MPI_* wrappers.
+ * It is attributed to the current category of the calling thread.
+ * Nothing is counted if the statistics are not active.
+ * \param [in] sent        Bytes sent by the call.
+ * \param [in] received    Bytes received by the call.
+ * \param [in] seconds     Time spent in the call.
+ */
+void                sc_mpi_stats_add (size_t sent, size_t received,
+                                      double seconds);
+
+/** Return the counts of one category on this process.
+ * \param [in] category    The category.
+ * \param [out] calls      If not NULL, the number of calls.
+ * \param [out] sent       If not NULL, the bytes sent.
+ * \param [out] received   If not NULL, the bytes received.
+ * \param [out] seconds    If not NULL, the time spent in the calls.
+ */
+void                sc_mpi_stats_get (sc_mpi_category_t category,
+                                      long *calls, double *sent,
+                                      double *received, double *seconds);
+
+/** Print the counts of all categories reduced over the processes.
+ * Categories without calls on any process are skipped.  The counting is
+ * paused during this function, which is collective.
+ * \param [in] mpicomm         Communicator for the reduction.
+ * \param [in] package_id      Registered package id or -1.
+ * \param [in] log_priority    Log priority for output according to sc.h.
+ */
+void                sc_mpi_stats_print (sc_MPI_Comm mpicomm,
+                                        int package_id, int log_priority);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_MPI_H */
@@ -0,0 +1,723 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_statistics.h>
+
+#if defined __GNUC__ && defined __ATOMIC_RELAXED
+/** Counters are atomic and the current category is per thread. */
+#define SC_MPI_STATS_ATOMIC
+#endif
+
+/** The counters of one category, updated atomically by all threads. */
+typedef struct sc_mpi_stats_counter
+{
+  long long           calls;
+  long long           sent;
+  long long           received;
+  long long           nanoseconds;
+}
+sc_mpi_stats_counter_t;
+
+static const char  *sc_mpi_stats_names[SC_MPI_CATEGORY_LAST] = {
+  "other", "notify", "psort", "allgather", "reduce", "shmem", "io"
+};
+
+static sc_mpi_stats_counter_t sc_mpi_stats_counters[SC_MPI_CATEGORY_LAST];
+static int          sc_mpi_stats_active = 0;
+#ifdef SC_MPI_STATS_ATOMIC
+static __thread sc_mpi_category_t sc_mpi_stats_category =
+  SC_MPI_CATEGORY_OTHER;
+static __thread int sc_mpi_stats_depth = 0;
+#else
+static sc_mpi_category_t sc_mpi_stats_category = SC_MPI_CATEGORY_OTHER;
+static int          sc_mpi_stats_depth = 0;
+#endif
+
+static void
+sc_mpi_stats_set_active (int active)
+{
+#ifdef SC_MPI_STATS_ATOMIC
+  __atomic_store_n (&sc_mpi_stats_active, active, __ATOMIC_RELEASE);
+#else
+  sc_mpi_stats_active = active;
+#endif
+}
+
+#ifdef SC_ENABLE_MPI
+
+static void
+sc_mpi_stats_counter_add (long long *counter, long long value)
+{
+#ifdef SC_MPI_STATS_ATOMIC
+  __atomic_fetch_add (counter, value, __ATOMIC_RELAXED);
+#else
+  *counter += value;
+#endif
+}
+
+#endif /* SC_ENABLE_MPI */
+
+static long long
+sc_mpi_stats_counter_get (const long long *counter)
+{
+#ifdef SC_MPI_STATS_ATOMIC
+  return __atomic_load_n (counter, __ATOMIC_RELAXED);
+#else
+  return *counter;
+#endif
+}
+
+void
+sc_mpi_stats_start (void)
+{
+  memset (sc_mpi_stats_counters, 0, sizeof (sc_mpi_stats_counters));
+  sc_mpi_stats_set_active (1);
+}
+
+void
+sc_mpi_stats_stop (void)
+{
+  sc_mpi_stats_set_active (0);
+}
+
+int
+sc_mpi_stats_is_active (void)
+{
+#ifdef SC_MPI_STATS_ATOMIC
+  return __atomic_load_n (&sc_mpi_stats_active, __ATOMIC_RELAXED);
+#else
+  return sc_mpi_stats_active;
+#endif
+}
+
+void
+sc_mpi_stats_enter (sc_mpi_category_t category)
+{
+  SC_ASSERT (0 <= category && category < SC_MPI_CATEGORY_LAST);
+  if (sc_mpi_stats_depth++ == 0) {
+    sc_mpi_stats_category = category;
+  }
+}
+
+void
+sc_mpi_stats_leave (void)
+{
+  SC_ASSERT (sc_mpi_stats_depth > 0);
+  if (--sc_mpi_stats_depth == 0) {
+    sc_mpi_stats_category = SC_MPI_CATEGORY_OTHER;
+  }
+}
+
+void
+sc_mpi_stats_add (size_t sent, size_t received, double seconds)
+{
+#ifdef SC_ENABLE_MPI
+  sc_mpi_stats_counter_t *c;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return;
+  }
+  c = &sc_mpi_stats_counters[sc_mpi_stats_category];
+  sc_mpi_stats_counter_add (&c->calls, 1);
+  sc_mpi_stats_counter_add (&c->sent, (long long) sent);
+  sc_mpi_stats_counter_add (&c->received, (long long) received);
+  sc_mpi_stats_counter_add (&c->nanoseconds, (long long) (seconds * 1.e9));
+#endif
+}
+
+void
+sc_mpi_stats_get (sc_mpi_category_t category, long *calls, double *sent,
+                  double *received, double *seconds)
+{
+  sc_mpi_stats_counter_t *c;
+
+  SC_ASSERT (0 <= category && category < SC_MPI_CATEGORY_LAST);
+  c = &sc_mpi_stats_counters[category];
+  if (calls != NULL) {
+    *calls = (long) sc_mpi_stats_counter_get (&c->calls);
+  }
+  if (sent != NULL) {
+    *sent = (double) sc_mpi_stats_counter_get (&c->sent);
+  }
+  if (received != NULL) {
+    *received = (double) sc_mpi_stats_counter_get (&c->received);
+  }
+  if (seconds != NULL) {
+    *seconds = 1.e-9 * (double) sc_mpi_stats_counter_get (&c->nanoseconds);
+  }
+}
+
+void
+sc_mpi_stats_print (sc_MPI_Comm mpicomm, int package_id, int log_priority)
+{
+  /* the statistics keep the variable names by reference */
+  static char         names[SC_MPI_CATEGORY_LAST][4][BUFSIZ];
+  int                 mpiret;
+  int                 active;
+  int                 i;
+  long                calls[SC_MPI_CATEGORY_LAST];
+  long                maxcalls[SC_MPI_CATEGORY_LAST];
+  double              values[4];
+  sc_statistics_t    *stats;
+
+  /* do not count the communication of the report itself */
+  active = sc_mpi_stats_is_active ();
+  sc_mpi_stats_stop ();
+
+  for (i = 0; i < SC_MPI_CATEGORY_LAST; ++i) {
+    sc_mpi_stats_get ((sc_mpi_category_t) i, &calls[i], NULL, NULL, NULL);
+  }
+  mpiret = sc_MPI_Allreduce (calls, maxcalls, SC_MPI_CATEGORY_LAST,
+                             sc_MPI_LONG, sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  stats = sc_statistics_new (mpicomm);
+  for (i = 0; i < SC_MPI_CATEGORY_LAST; ++i) {
+    if (maxcalls[i] == 0) {
+      continue;
+    }
+    snprintf (names[i][0], BUFSIZ, "MPI %s calls", sc_mpi_stats_names[i]);
+    snprintf (names[i][1], BUFSIZ, "MPI %s MB sent", sc_mpi_stats_names[i]);
+    snprintf (names[i][2], BUFSIZ, "MPI %s MB received",
+              sc_mpi_stats_names[i]);
+    snprintf (names[i][3], BUFSIZ, "MPI %s seconds", sc_mpi_stats_names[i]);
+    sc_mpi_stats_get ((sc_mpi_category_t) i, NULL, &values[1], &values[2],
+                      &values[3]);
+    values[0] = (double) calls[i];
+    values[1] /= 1048576.;
+    values[2] /= 1048576.;
+    sc_statistics_add (stats, names[i][0]);
+    sc_statistics_set (stats, names[i][0], values[0]);
+    sc_statistics_add (stats, names[i][1]);
+    sc_statistics_set (stats, names[i][1], values[1]);
+    sc_statistics_add (stats, names[i][2]);
+    sc_statistics_set (stats, names[i][2], values[2]);
+    sc_statistics_add (stats, names[i][3]);
+    sc_statistics_set (stats, names[i][3], values[3]);
+  }
+  sc_statistics_compute (stats);
+  sc_statistics_print (stats, package_id, log_priority, 1, 0);
+  sc_statistics_destroy (stats);
+
+  if (active) {
+    sc_mpi_stats_set_active (1);
+  }
+}
+
+#ifdef SC_ENABLE_MPI
+
+/** Return the bytes of \a n elements of type \a t. */
+static size_t
+sc_mpi_stats_bytes (int n, MPI_Datatype t)
+{
+  int                 mpiret, size;
+
+  if (n <= 0) {
+    return 0;
+  }
+  mpiret = MPI_Type_size (t, &size);
+  SC_CHECK_MPI (mpiret);
+  return (size_t) n * (size_t) size;
+}
+
+/** Return the bytes of the sum of \a P counts of type \a t. */
+static size_t
+sc_mpi_stats_bytesv (int P, const int *counts, MPI_Datatype t)
+{
+  int                 i;
+  size_t              sum = 0;
+
+  for (i = 0; i < P; ++i) {
+    sum += sc_mpi_stats_bytes (counts[i], t);
+  }
+  return sum;
+}
+
+static int
+sc_mpi_stats_size (MPI_Comm comm)
+{
+  int                 mpiret, size;
+
+  mpiret = MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  return size;
+}
+
+static int
+sc_mpi_stats_rank (MPI_Comm comm)
+{
+  int                 mpiret, rank;
+
+  mpiret = MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+  return rank;
+}
+
+/** Count one call that started at \a start. */
+static void
+sc_mpi_stats_record (double start, size_t sent, size_t received)
+{
+  sc_mpi_stats_add (sent, received, MPI_Wtime () - start);
+}
+
+int
+sc_mpi_stats_barrier (MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Barrier (comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Barrier (comm);
+  sc_mpi_stats_record (start, 0, 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_bcast (void *p, int n, MPI_Datatype t, int root, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              bytes;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Bcast (p, n, t, root, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Bcast (p, n, t, root, comm);
+  bytes = sc_mpi_stats_bytes (n, t);
+  if (sc_mpi_stats_rank (comm) == root) {
+    sc_mpi_stats_record (start, bytes, 0);
+  }
+  else {
+    sc_mpi_stats_record (start, 0, bytes);
+  }
+  return mpiret;
+}
+
+int
+sc_mpi_stats_gather (const void *p, int np, MPI_Datatype tp,
+                     void *q, int nq, MPI_Datatype tq, int root,
+                     MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent, received = 0;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Gather ((void *) p, np, tp, q, nq, tq, root, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Gather ((void *) p, np, tp, q, nq, tq, root, comm);
+  sent = p == MPI_IN_PLACE ? 0 : sc_mpi_stats_bytes (np, tp);
+  if (sc_mpi_stats_rank (comm) == root) {
+    received = sc_mpi_stats_size (comm) * sc_mpi_stats_bytes (nq, tq);
+  }
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_gatherv (const void *p, int np, MPI_Datatype tp, void *q,
+                      const int *recvc, const int *displ, MPI_Datatype tq,
+                      int root, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent, received = 0;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Gatherv ((void *) p, np, tp, q, (int *) recvc,
+                        (int *) displ, tq, root, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Gatherv ((void *) p, np, tp, q, (int *) recvc,
+                        (int *) displ, tq, root, comm);
+  sent = p == MPI_IN_PLACE ? 0 : sc_mpi_stats_bytes (np, tp);
+  if (sc_mpi_stats_rank (comm) == root) {
+    received = sc_mpi_stats_bytesv (sc_mpi_stats_size (comm), recvc, tq);
+  }
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_scatter (const void *p, int np, MPI_Datatype tp,
+                      void *q, int nq, MPI_Datatype tq, int root,
+                      MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent = 0, received;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Scatter ((void *) p, np, tp, q, nq, tq, root, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Scatter ((void *) p, np, tp, q, nq, tq, root, comm);
+  if (sc_mpi_stats_rank (comm) == root) {
+    sent = sc_mpi_stats_size (comm) * sc_mpi_stats_bytes (np, tp);
+  }
+  received = q == MPI_IN_PLACE ? 0 : sc_mpi_stats_bytes (nq, tq);
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_scatterv (const void *p, const int *sendc, const int *displ,
+                       MPI_Datatype tp, void *q, int nq, MPI_Datatype tq,
+                       int root, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent = 0, received;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Scatterv ((void *) p, (int *) sendc, (int *) displ, tp,
+                         q, nq, tq, root, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Scatterv ((void *) p, (int *) sendc, (int *) displ, tp,
+                         q, nq, tq, root, comm);
+  if (sc_mpi_stats_rank (comm) == root) {
+    sent = sc_mpi_stats_bytesv (sc_mpi_stats_size (comm), sendc, tp);
+  }
+  received = q == MPI_IN_PLACE ? 0 : sc_mpi_stats_bytes (nq, tq);
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_allgather (const void *p, int np, MPI_Datatype tp,
+                        void *q, int nq, MPI_Datatype tq, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent, received;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Allgather ((void *) p, np, tp, q, nq, tq, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Allgather ((void *) p, np, tp, q, nq, tq, comm);
+  sent = p == MPI_IN_PLACE ? 0 : sc_mpi_stats_bytes (np, tp);
+  received = sc_mpi_stats_size (comm) * sc_mpi_stats_bytes (nq, tq);
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_allgatherv (const void *p, int np, MPI_Datatype tp, void *q,
+                         const int *recvc, const int *displ,
+                         MPI_Datatype tq, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent, received;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Allgatherv ((void *) p, np, tp, q, (int *) recvc,
+                           (int *) displ, tq, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Allgatherv ((void *) p, np, tp, q, (int *) recvc,
+                           (int *) displ, tq, comm);
+  sent = p == MPI_IN_PLACE ? 0 : sc_mpi_stats_bytes (np, tp);
+  received = sc_mpi_stats_bytesv (sc_mpi_stats_size (comm), recvc, tq);
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_alltoall (const void *p, int np, MPI_Datatype tp,
+                       void *q, int nq, MPI_Datatype tq, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent, received;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Alltoall ((void *) p, np, tp, q, nq, tq, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Alltoall ((void *) p, np, tp, q, nq, tq, comm);
+  received = sc_mpi_stats_size (comm) * sc_mpi_stats_bytes (nq, tq);
+  sent = p == MPI_IN_PLACE ? received :
+    sc_mpi_stats_size (comm) * sc_mpi_stats_bytes (np, tp);
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_alltoallv (const void *p, const int *sendc, const int *sdispl,
+                        MPI_Datatype tp, void *q, const int *recvc,
+                        const int *rdispl, MPI_Datatype tq, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              sent, received;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Alltoallv ((void *) p, (int *) sendc, (int *) sdispl, tp,
+                          q, (int *) recvc, (int *) rdispl, tq, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Alltoallv ((void *) p, (int *) sendc, (int *) sdispl, tp,
+                          q, (int *) recvc, (int *) rdispl, tq, comm);
+  received = sc_mpi_stats_bytesv (sc_mpi_stats_size (comm), recvc, tq);
+  sent = p == MPI_IN_PLACE ? received :
+    sc_mpi_stats_bytesv (sc_mpi_stats_size (comm), sendc, tp);
+  sc_mpi_stats_record (start, sent, received);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_reduce (const void *p, void *q, int n, MPI_Datatype t,
+                     MPI_Op op, int root, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              bytes;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Reduce ((void *) p, q, n, t, op, root, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Reduce ((void *) p, q, n, t, op, root, comm);
+  bytes = sc_mpi_stats_bytes (n, t);
+  sc_mpi_stats_record (start, bytes,
+                       sc_mpi_stats_rank (comm) == root ? bytes : 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_reduce_scatter_block (const void *p, void *q, int n,
+                                   MPI_Datatype t, MPI_Op op, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              bytes;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Reduce_scatter_block ((void *) p, q, n, t, op, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Reduce_scatter_block ((void *) p, q, n, t, op, comm);
+  bytes = sc_mpi_stats_bytes (n, t);
+  sc_mpi_stats_record (start, sc_mpi_stats_size (comm) * bytes, bytes);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_allreduce (const void *p, void *q, int n, MPI_Datatype t,
+                        MPI_Op op, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              bytes;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Allreduce ((void *) p, q, n, t, op, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Allreduce ((void *) p, q, n, t, op, comm);
+  bytes = sc_mpi_stats_bytes (n, t);
+  sc_mpi_stats_record (start, bytes, bytes);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_scan (const void *p, void *q, int n, MPI_Datatype t,
+                   MPI_Op op, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              bytes;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Scan ((void *) p, q, n, t, op, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Scan ((void *) p, q, n, t, op, comm);
+  bytes = sc_mpi_stats_bytes (n, t);
+  sc_mpi_stats_record (start, bytes, bytes);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_exscan (const void *p, void *q, int n, MPI_Datatype t,
+                     MPI_Op op, MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+  size_t              bytes;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Exscan ((void *) p, q, n, t, op, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Exscan ((void *) p, q, n, t, op, comm);
+  bytes = sc_mpi_stats_bytes (n, t);
+  sc_mpi_stats_record (start, bytes, bytes);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_recv (void *p, int n, MPI_Datatype t, int src, int tag,
+                   MPI_Comm comm, MPI_Status * status)
+{
+  int                 mpiret, count;
+  double              start;
+  MPI_Status          local;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Recv (p, n, t, src, tag, comm, status);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Recv (p, n, t, src, tag, comm, &local);
+  if (mpiret == MPI_SUCCESS) {
+    /* count what actually arrived, not the size of the buffer */
+    if (MPI_Get_count (&local, t, &count) != MPI_SUCCESS ||
+        count == MPI_UNDEFINED) {
+      count = n;
+    }
+    sc_mpi_stats_record (start, 0, sc_mpi_stats_bytes (count, t));
+  }
+  if (status != MPI_STATUS_IGNORE) {
+    *status = local;
+  }
+  return mpiret;
+}
+
+int
+sc_mpi_stats_irecv (void *p, int n, MPI_Datatype t, int src, int tag,
+                    MPI_Comm comm, MPI_Request * request)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Irecv (p, n, t, src, tag, comm, request);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Irecv (p, n, t, src, tag, comm, request);
+  sc_mpi_stats_record (start, 0, sc_mpi_stats_bytes (n, t));
+  return mpiret;
+}
+
+int
+sc_mpi_stats_send (const void *p, int n, MPI_Datatype t, int dest, int tag,
+                   MPI_Comm comm)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Send ((void *) p, n, t, dest, tag, comm);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Send ((void *) p, n, t, dest, tag, comm);
+  sc_mpi_stats_record (start, sc_mpi_stats_bytes (n, t), 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_isend (const void *p, int n, MPI_Datatype t, int dest,
+                    int tag, MPI_Comm comm, MPI_Request * request)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Isend ((void *) p, n, t, dest, tag, comm, request);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Isend ((void *) p, n, t, dest, tag, comm, request);
+  sc_mpi_stats_record (start, sc_mpi_stats_bytes (n, t), 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_probe (int src, int tag, MPI_Comm comm, MPI_Status * status)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Probe (src, tag, comm, status);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Probe (src, tag, comm, status);
+  sc_mpi_stats_record (start, 0, 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_wait (MPI_Request * request, MPI_Status * status)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Wait (request, status);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Wait (request, status);
+  sc_mpi_stats_record (start, 0, 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_waitsome (int n, MPI_Request * requests, int *outcount,
+                       int *indices, MPI_Status * statuses)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Waitsome (n, requests, outcount, indices, statuses);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Waitsome (n, requests, outcount, indices, statuses);
+  sc_mpi_stats_record (start, 0, 0);
+  return mpiret;
+}
+
+int
+sc_mpi_stats_waitall (int n, MPI_Request * requests, MPI_Status * statuses)
+{
+  int                 mpiret;
+  double              start;
+
+  if (!sc_mpi_stats_is_active ()) {
+    return MPI_Waitall (n, requests, statuses);
+  }
+  start = MPI_Wtime ();
+  mpiret = MPI_Waitall (n, requests, statuses);
+  sc_mpi_stats_record (start, 0, 0);
+  return mpiret;
+}
+
+#endif /* SC_ENABLE_MPI */
@@ -0,0 +1,468 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_neighbor.h>
+
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 4
+#define SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+#endif
+
+struct sc_neighbor_exchange
+{
+  int                 num_receivers;
+  int                 num_senders;
+  int                 active;
+#ifdef SC_ENABLE_MPI
+  sc_MPI_Comm         mpicomm;  /**< graph or duplicate communicator */
+#ifdef SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+  MPI_Request         request;
+#else
+  sc_MPI_Request     *requests; /**< receives first, then sends */
+#endif
+#else
+  /* without MPI the only neighbor is this rank itself */
+  const char         *sendbuf;
+  char               *recvbuf;
+  size_t              bytes;
+#endif
+};
+
+sc_neighbor_exchange_t *
+sc_neighbor_exchange_new (sc_MPI_Comm mpicomm,
+                          sc_array_t * receivers, sc_array_t * senders,
+                          const void *sendbuf, const int *sendcounts,
+                          const int *sdispls, void *recvbuf,
+                          const int *recvcounts, const int *rdispls,
+                          sc_MPI_Datatype datatype)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+#endif
+  sc_neighbor_exchange_t *exc;
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+
+  exc = SC_ALLOC_ZERO (sc_neighbor_exchange_t, 1);
+  exc->num_receivers = (int) receivers->elem_count;
+  exc->num_senders = (int) senders->elem_count;
+
+#ifdef SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+  mpiret = MPI_Dist_graph_create_adjacent
+    (mpicomm, exc->num_senders, (int *) senders->array, MPI_UNWEIGHTED,
+     exc->num_receivers, (int *) receivers->array, MPI_UNWEIGHTED,
+     MPI_INFO_NULL, 0, &exc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Neighbor_alltoallv_init (sendbuf, sendcounts, sdispls,
+                                        datatype, recvbuf, recvcounts,
+                                        rdispls, datatype, exc->mpicomm,
+                                        MPI_INFO_NULL, &exc->request);
+  SC_CHECK_MPI (mpiret);
+#elif defined(SC_ENABLE_MPI)
+  {
+    int                 i;
+    size_t              typesize = sc_mpi_sizeof (datatype);
+
+    /* the duplicate keeps our messages apart from any others */
+    mpiret = sc_MPI_Comm_dup (mpicomm, &exc->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    exc->requests = SC_ALLOC (sc_MPI_Request,
+                              exc->num_senders + exc->num_receivers);
+    for (i = 0; i < exc->num_senders; ++i) {
+      mpiret = MPI_Recv_init ((char *) recvbuf + rdispls[i] * typesize,
+                              recvcounts[i], datatype,
+                              *(int *) sc_array_index_int (senders, i),
+                              SC_TAG_NEIGHBOR, exc->mpicomm,
+                              exc->requests + i);
+      SC_CHECK_MPI (mpiret);
+    }
+    for (i = 0; i < exc->num_receivers; ++i) {
+      mpiret = MPI_Send_init ((char *) sendbuf + sdispls[i] * typesize,
+                              sendcounts[i], datatype,
+                              *(int *) sc_array_index_int (receivers, i),
+                              SC_TAG_NEIGHBOR, exc->mpicomm,
+                              exc->requests + exc->num_senders + i);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+#else
+  SC_CHECK_ABORT (exc->num_receivers == exc->num_senders &&
+                  exc->num_receivers <= 1, "Neighbor exchange mismatch");
+  if (exc->num_receivers == 1) {
+    SC_ASSERT (sendcounts[0] == recvcounts[0]);
+    exc->bytes = sendcounts[0] * sc_mpi_sizeof (datatype);
+    exc->sendbuf = (const char *) sendbuf +
+      sdispls[0] * sc_mpi_sizeof (datatype);
+    exc->recvbuf = (char *) recvbuf + rdispls[0] * sc_mpi_sizeof (datatype);
+  }
+#endif
+
+  return exc;
+}
+
+void
+sc_neighbor_exchange_destroy (sc_neighbor_exchange_t * exc)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+#ifdef SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+  mpiret = MPI_Request_free (&exc->request);
+  SC_CHECK_MPI (mpiret);
+#else
+  int                 i;
+
+  for (i = 0; i < exc->num_senders + exc->num_receivers; ++i) {
+    mpiret = MPI_Request_free (exc->requests + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  SC_FREE (exc->requests);
+#endif
+  mpiret = sc_MPI_Comm_free (&exc->mpicomm);
+  SC_CHECK_MPI (mpiret);
+#endif
+
+  SC_ASSERT (!exc->active);
+  SC_FREE (exc);
+}
+
+void
+sc_neighbor_exchange_start (sc_neighbor_exchange_t * exc)
+{
+  SC_ASSERT (!exc->active);
+  exc->active = 1;
+
+#ifdef SC_ENABLE_MPI
+  {
+    int                 mpiret;
+
+#ifdef SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+    mpiret = MPI_Start (&exc->request);
+#else
+    mpiret = MPI_Startall (exc->num_senders + exc->num_receivers,
+                           exc->requests);
+#endif
+    SC_CHECK_MPI (mpiret);
+  }
+#else
+  memcpy (exc->recvbuf, exc->sendbuf, exc->bytes);
+#endif
+}
+
+int
+sc_neighbor_exchange_test (sc_neighbor_exchange_t * exc)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret, flag;
+
+  SC_ASSERT (exc->active);
+#ifdef SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+  mpiret = MPI_Test (&exc->request, &flag, MPI_STATUS_IGNORE);
+#else
+  mpiret = MPI_Testall (exc->num_senders + exc->num_receivers,
+                        exc->requests, &flag, MPI_STATUSES_IGNORE);
+#endif
+  SC_CHECK_MPI (mpiret);
+  if (flag) {
+    exc->active = 0;
+  }
+  return flag;
+#else
+  SC_ASSERT (exc->active);
+  exc->active = 0;
+  return 1;
+#endif
+}
+
+void
+sc_neighbor_exchange_wait (sc_neighbor_exchange_t * exc)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+
+  SC_ASSERT (exc->active);
+#ifdef SC_NEIGHBOR_PERSISTENT_COLLECTIVE
+  mpiret = MPI_Wait (&exc->request, MPI_STATUS_IGNORE);
+#else
+  mpiret = MPI_Waitall (exc->num_senders + exc->num_receivers,
+                        exc->requests, MPI_STATUSES_IGNORE);
+#endif
+  SC_CHECK_MPI (mpiret);
+#endif
+  exc->active = 0;
+}
+
+/** A graph vertex with its total edge weight, for the seed order. */
+typedef struct sc_neighbor_vertex
+{
+  double              weight;
+  int                 vertex;
+}
+sc_neighbor_vertex_t;
+
+static int
+sc_neighbor_vertex_compare (const void *v1, const void *v2)
+{
+  const sc_neighbor_vertex_t *a = (const sc_neighbor_vertex_t *) v1;
+  const sc_neighbor_vertex_t *b = (const sc_neighbor_vertex_t *) v2;
+
+  /* heaviest first, ties broken by the smaller vertex */
+  if (a->weight != b->weight) {
+    return a->weight > b->weight ? -1 : 1;
+  }
+  return a->vertex - b->vertex;
+}
+
+/** Map the vertices of a symmetric graph greedily onto the nodes.
+ * \param [in] n        Number of vertices and of processes.
+ * \param [in] xadj     Offsets into \a adj and \a wgt, length n + 1.
+ * \param [in] adj      Neighbors of each vertex.
+ * \param [in] wgt      Weight of each edge.
+ * \param [in] node_of  Node index of each process.
+ * \param [in] num_nodes Number of nodes.
+ * \param [out] role_of Vertex assigned to each process.
+ */
+static void
+sc_neighbor_map (int n, const int *xadj, const int *adj, const double *wgt,
+                 const int *node_of, int num_nodes, int *role_of)
+{
+  int                 i, j, m, v, u, best;
+  int                 next_seed, num_front;
+  int                *procs, *pstart, *front;
+  char               *assigned, *infront;
+  double             *gain;
+  sc_neighbor_vertex_t *order;
+
+  /* the processes of each node in ascending order */
+  pstart = SC_ALLOC_ZERO (int, num_nodes + 1);
+  procs = SC_ALLOC (int, n);
+  for (i = 0; i < n; ++i) {
+    SC_ASSERT (0 <= node_of[i] && node_of[i] < num_nodes);
+    ++pstart[node_of[i] + 1];
+  }
+  for (j = 0; j < num_nodes; ++j) {
+    pstart[j + 1] += pstart[j];
+  }
+  for (i = 0; i < n; ++i) {
+    procs[pstart[node_of[i]]++] = i;
+  }
+  for (j = num_nodes; j > 0; --j) {
+    pstart[j] = pstart[j - 1];
+  }
+  pstart[0] = 0;
+
+  /* new nodes are seeded in the order of decreasing vertex weight */
+  order = SC_ALLOC (sc_neighbor_vertex_t, n);
+  for (v = 0; v < n; ++v) {
+    order[v].vertex = v;
+    order[v].weight = 0.;
+    for (i = xadj[v]; i < xadj[v + 1]; ++i) {
+      order[v].weight += wgt[i];
+    }
+  }
+  qsort (order, (size_t) n, sizeof (sc_neighbor_vertex_t),
+         sc_neighbor_vertex_compare);
+
+  assigned = SC_ALLOC_ZERO (char, n);
+  infront = SC_ALLOC_ZERO (char, n);
+  gain = SC_ALLOC_ZERO (double, n);
+  front = SC_ALLOC (int, n);
+  next_seed = 0;
+  for (j = 0; j < num_nodes; ++j) {
+    num_front = 0;
+    for (m = pstart[j]; m < pstart[j + 1]; ++m) {
+      /* pick the unassigned vertex most connected to this node */
+      best = -1;
+      for (i = 0; i < num_front; ++i) {
+        u = front[i];
+        if (!assigned[u] && (best < 0 || gain[u] > gain[best] ||
+                             (gain[u] == gain[best] && u < best))) {
+          best = u;
+        }
+      }
+      if (best < 0) {
+        while (assigned[order[next_seed].vertex]) {
+          ++next_seed;
+        }
+        best = order[next_seed].vertex;
+      }
+      v = best;
+      assigned[v] = 1;
+      role_of[procs[m]] = v;
+      for (i = xadj[v]; i < xadj[v + 1]; ++i) {
+        u = adj[i];
+        if (!assigned[u]) {
+          gain[u] += wgt[i];
+          if (!infront[u]) {
+            infront[u] = 1;
+            front[num_front++] = u;
+          }
+        }
+      }
+    }
+
+    /* the gains only count edges into the current node */
+    for (i = 0; i < num_front; ++i) {
+      gain[front[i]] = 0.;
+      infront[front[i]] = 0;
+    }
+  }
+
+  SC_FREE (front);
+  SC_FREE (gain);
+  SC_FREE (infront);
+  SC_FREE (assigned);
+  SC_FREE (order);
+  SC_FREE (procs);
+  SC_FREE (pstart);
+}
+
+void
+sc_neighbor_reorder (sc_MPI_Comm mpicomm, sc_array_t * receivers,
+                     const double *weights, sc_MPI_Comm * newcomm)
+{
+  int                 mpiret;
+  int                 rank, size, intrasize, node, num_nodes;
+  int                 i, v, u, e, num_receivers, num_edges, myrole;
+  int                *counts = NULL, *displs = NULL, *targets = NULL;
+  int                *node_of = NULL, *role_of = NULL;
+  int                *xadj, *adj;
+  double             *myweights, *edgeweights = NULL, *wgt;
+  sc_MPI_Comm         intranode, internode;
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+  intrasize = 1;
+  if (intranode != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (size == 1 || intrasize == 1) {
+    /* every placement is equally good */
+    mpiret = sc_MPI_Comm_dup (mpicomm, newcomm);
+    SC_CHECK_MPI (mpiret);
+    return;
+  }
+
+  /* the internode communicator is split by node-local rank */
+  mpiret = sc_MPI_Comm_rank (internode, &node);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (internode, &num_nodes);
+  SC_CHECK_MPI (mpiret);
+
+  num_receivers = (int) receivers->elem_count;
+  myweights = SC_ALLOC (double, num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    myweights[i] = weights != NULL ? weights[i] : 1.;
+  }
+  if (rank == 0) {
+    counts = SC_ALLOC (int, size);
+    displs = SC_ALLOC (int, size + 1);
+    node_of = SC_ALLOC (int, size);
+    role_of = SC_ALLOC (int, size);
+  }
+  mpiret = sc_MPI_Gather (&num_receivers, 1, sc_MPI_INT,
+                          counts, 1, sc_MPI_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Gather (&node, 1, sc_MPI_INT,
+                          node_of, 1, sc_MPI_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    displs[0] = 0;
+    for (i = 0; i < size; ++i) {
+      displs[i + 1] = displs[i] + counts[i];
+    }
+    targets = SC_ALLOC (int, displs[size]);
+    edgeweights = SC_ALLOC (double, displs[size]);
+  }
+  mpiret = sc_MPI_Gatherv (receivers->array, num_receivers, sc_MPI_INT,
+                           targets, counts, displs, sc_MPI_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Gatherv (myweights, num_receivers, sc_MPI_DOUBLE,
+                           edgeweights, counts, displs, sc_MPI_DOUBLE, 0,
+                           mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (myweights);
+
+  if (rank == 0) {
+    /* symmetrize the graph without self edges */
+    xadj = SC_ALLOC_ZERO (int, size + 1);
+    for (v = 0; v < size; ++v) {
+      for (e = displs[v]; e < displs[v + 1]; ++e) {
+        u = targets[e];
+        SC_ASSERT (0 <= u && u < size);
+        if (u != v) {
+          ++xadj[v + 1];
+          ++xadj[u + 1];
+        }
+      }
+    }
+    for (v = 0; v < size; ++v) {
+      xadj[v + 1] += xadj[v];
+    }
+    num_edges = xadj[size];
+    adj = SC_ALLOC (int, num_edges);
+    wgt = SC_ALLOC (double, num_edges);
+    for (v = 0; v < size; ++v) {
+      for (e = displs[v]; e < displs[v + 1]; ++e) {
+        u = targets[e];
+        if (u != v) {
+          adj[xadj[v]] = u;
+          wgt[xadj[v]++] = edgeweights[e];
+          adj[xadj[u]] = v;
+          wgt[xadj[u]++] = edgeweights[e];
+        }
+      }
+    }
+    for (v = size; v > 0; --v) {
+      xadj[v] = xadj[v - 1];
+    }
+    xadj[0] = 0;
+
+    sc_neighbor_map (size, xadj, adj, wgt, node_of, num_nodes, role_of);
+
+    SC_FREE (wgt);
+    SC_FREE (adj);
+    SC_FREE (xadj);
+    SC_FREE (edgeweights);
+    SC_FREE (targets);
+    SC_FREE (displs);
+    SC_FREE (counts);
+  }
+
+  mpiret = sc_MPI_Scatter (role_of, 1, sc_MPI_INT, &myrole, 1, sc_MPI_INT,
+                           0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    SC_FREE (role_of);
+    SC_FREE (node_of);
+  }
+
+  /* the process that plays role q becomes rank q */
+  mpiret = sc_MPI_Comm_split (mpicomm, 0, myrole, newcomm);
+  SC_CHECK_MPI (mpiret);
+}
@@ -0,0 +1,130 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_NEIGHBOR_H
+#define SC_NEIGHBOR_H
+
+/** \file sc_neighbor.h
+ * Persistent sparse data exchange with a fixed set of neighbors.
+ *
+ * Once \ref sc_notify or one of its variants has found the senders that
+ * match a list of receivers, the same pattern is often used to exchange
+ * data in many steps until the next repartition.  An exchange object is
+ * set up once with the buffers, counts and displacements, and every step
+ * only calls \ref sc_neighbor_exchange_start and
+ * \ref sc_neighbor_exchange_wait.
+ *
+ * With MPI 4, the exchange is a persistent MPI_Neighbor_alltoallv on a
+ * distributed graph communicator, which lets MPI optimize the fixed
+ * pattern.  Older MPI versions use persistent point-to-point requests on
+ * a duplicate of the communicator.
+ *
+ * Before the data is distributed, \ref sc_neighbor_reorder may be used to
+ * renumber the ranks such that heavily communicating ranks share a node.
+ */
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque object for a persistent neighbor exchange */
+typedef struct sc_neighbor_exchange sc_neighbor_exchange_t;
+
+/** Set up a persistent exchange.  This function is collective.
+ * All counts and displacements are in elements of \a datatype.
+ * The buffers are bound to the exchange and must remain alive until it is
+ * destroyed; their contents may change between the steps.
+ * \param [in] mpicomm      Communicator of the ranks in the arrays.
+ * \param [in] receivers    Sorted array of int: the ranks we send to.
+ * \param [in] senders      Sorted array of int: the ranks we receive from,
+ *                          usually the output of \ref sc_notify.
+ * \param [in] sendbuf      Data to send.
+ * \param [in] sendcounts   Elements sent to each receiver.
+ * \param [in] sdispls      Offset of the data of each receiver.
+ * \param [in] recvbuf      Memory for the data to receive.
+ * \param [in] recvcounts   Elements received from each sender.
+ * \param [in] rdispls      Offset of the data of each sender.
+ * \param [in] datatype     Type of the elements.
+ * \return                  The exchange, to destroy with
+ *                          \ref sc_neighbor_exchange_destroy.
+ */
+sc_neighbor_exchange_t *sc_neighbor_exchange_new (sc_MPI_Comm mpicomm,
+                                                  sc_array_t * receivers,
+                                                  sc_array_t * senders,
+                                                  const void *sendbuf,
+                                                  const int *sendcounts,
+                                                  const int *sdispls,
+                                                  void *recvbuf,
+                                                  const int *recvcounts,
+                                                  const int *rdispls,
+                                                  sc_MPI_Datatype datatype);
+
+/** Free the communicator and requests of an exchange.
+ * \param [in] exchange     It must not be in progress.
+ */
+void                sc_neighbor_exchange_destroy (sc_neighbor_exchange_t *
+                                                  exchange);
+
+/** Start one step of the exchange.
+ * The send buffer must not be modified until the step is complete.
+ */
+void                sc_neighbor_exchange_start (sc_neighbor_exchange_t *
+                                                exchange);
+
+/** Check without blocking whether the current step has completed.
+ * \return                  True if the receive buffer is complete.
+ */
+int                 sc_neighbor_exchange_test (sc_neighbor_exchange_t *
+                                               exchange);
+
+/** Wait for the current step to complete. */
+void                sc_neighbor_exchange_wait (sc_neighbor_exchange_t *
+                                               exchange);
+
+/** Renumber the ranks to keep most of the communication within nodes.
+ * This function is collective.  The graph of all receiver lists is
+ * gathered to the first rank, symmetrized, and mapped greedily onto the
+ * nodes: each node is seeded with the heaviest unassigned vertex and grown
+ * by the vertex with the largest edge weight into it.  The nodes are taken
+ * from \ref sc_mpi_comm_attach_node_comms; without them, or with only one
+ * rank per node, the communicator is duplicated unchanged.
+ * The graph vertices are the ranks of \a mpicomm understood as roles, such
+ * as the parts of a partition: the process that receives rank q in
+ * \a newcomm should take over the role and the data of former rank q.
+ * \param [in] mpicomm      Communicator with node communicators attached.
+ * \param [in] receivers    Array of int: the ranks that role sends to,
+ *                          for example the input to \ref sc_notify.
+ * \param [in] weights      One weight per receiver, such as a message
+ *                          size, or NULL for unit weights.
+ * \param [out] newcomm     The reordered communicator, to be freed with
+ *                          sc_MPI_Comm_free.  Node communicators are not
+ *                          attached to it.
+ */
+void                sc_neighbor_reorder (sc_MPI_Comm mpicomm,
+                                         sc_array_t * receivers,
+                                         const double *weights,
+                                         sc_MPI_Comm * newcomm);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_NEIGHBOR_H */
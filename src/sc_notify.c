@@ -25,9 +25,12 @@
 #include <sc_notify.h>
 #include <sc_ranges.h>
 #include <sc_flops.h>
+#include <sc_tracer.h>
 
 #define SC_NOTIFY_FUNC_SNAP(notify,snap)                   \
 do {                                                       \
+  sc_tracer_begin (__func__);                              \
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_NOTIFY);             \
   if (notify->stats) {                                     \
     SC_FUNC_SNAP (notify->stats, &(notify->flop), (snap)); \
   }                                                        \
@@ -38,12 +41,15 @@ do {                                                       \
   if (notify->stats) {                                     \
     SC_FUNC_SHOT (notify->stats, &(notify->flop), (snap)); \
   }                                                        \
+  sc_mpi_stats_leave ();                                   \
+  sc_tracer_end (__func__);                                \
 } while (0)
 
 /*== INTERFACE == */
 
 sc_notify_type_t    sc_notify_type_default = SC_NOTIFY_NARY;
 size_t              sc_notify_eager_threshold_default = 1024;
+int                 sc_notify_auto_trials_default = 2;
 
 typedef struct sc_notify_nary_s
 {
@@ -70,6 +76,25 @@ typedef struct sc_notify_superset_s
 }
 sc_notify_superset_t;
 
+typedef struct sc_notify_hier_s
+{
+  sc_MPI_Comm         intranode;        /* ranks sharing this node */
+  int                 intrarank, intrasize;
+  int                *locations;        /* node and intranode rank by rank */
+  sc_notify_t        *leaders;  /* notify between leaders, on leaders */
+}
+sc_notify_hier_t;
+
+typedef struct sc_notify_auto_s
+{
+  int                 trials;   /* timed calls per candidate */
+  int                 calls[SC_NOTIFY_NUM_REGIMES];     /* timed so far */
+  sc_notify_type_t    choice[SC_NOTIFY_NUM_REGIMES];    /* AUTO if tuning */
+  double              seconds[SC_NOTIFY_NUM_REGIMES][SC_NOTIFY_NUM_TYPES];
+  double              start;    /* begin of the call being timed */
+}
+sc_notify_auto_t;
+
 struct sc_notify_s
 {
   sc_MPI_Comm         mpicomm;
@@ -77,11 +102,14 @@ struct sc_notify_s
   size_t              eager_threshold;
   sc_statistics_t    *stats;
   sc_flopinfo_t       flop;
+  sc_notify_auto_t    autotune;
+  int                 requests; /* number of sc_notify_begin calls */
   union
   {
     sc_notify_nary_t    nary;
     sc_notify_ranges_t  ranges;
     sc_notify_superset_t superset;
+    sc_notify_hier_t    hier;
   }
   data;
 };
@@ -96,8 +124,36 @@ const char         *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES] = {
   SC_NOTIFY_STR_NBX,
   SC_NOTIFY_STR_RANGES,
   SC_NOTIFY_STR_SUPERSET,
+  SC_NOTIFY_STR_HIER,
+};
+
+const char         *sc_notify_regime_strings[SC_NOTIFY_NUM_REGIMES] = {
+  "none",
+  "small",
+  "eager",
+  "variable",
+};
+
+/** The algorithms tried by SC_NOTIFY_AUTO.  They need no configuration. */
+static const sc_notify_type_t sc_notify_auto_candidates[] = {
+  SC_NOTIFY_ALLGATHER,
+  SC_NOTIFY_BINARY,
+  SC_NOTIFY_NARY,
+  SC_NOTIFY_PEX,
+#if defined(SC_ENABLE_MPI) && (MPI_VERSION > 2 || (MPI_VERSION == 2 && MPI_SUBVERSION >= 2))
+  SC_NOTIFY_PCX,
+#endif
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 2
+  SC_NOTIFY_RSX,
+#endif
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  SC_NOTIFY_NBX,
+#endif
 };
 
+#define SC_NOTIFY_AUTO_NUM_CANDIDATES \
+  ((int) (sizeof (sc_notify_auto_candidates) / sizeof (sc_notify_type_t)))
+
 sc_notify_t        *
 sc_notify_new (sc_MPI_Comm comm)
 {
@@ -107,13 +163,17 @@ sc_notify_new (sc_MPI_Comm comm)
   notify->mpicomm = comm;
   notify->type = SC_NOTIFY_DEFAULT;
   notify->eager_threshold = sc_notify_eager_threshold_default;
-  SC_ASSERT (sc_notify_type_default >= 0
-             && sc_notify_type_default < SC_NOTIFY_NUM_TYPES);
+  SC_ASSERT (sc_notify_type_default == SC_NOTIFY_AUTO ||
+             (sc_notify_type_default >= 0
+              && sc_notify_type_default < SC_NOTIFY_NUM_TYPES));
   sc_notify_set_type (notify, sc_notify_type_default);
   sc_flops_start_nopapi (&(notify->flop));
   return notify;
 }
 
+static void         sc_notify_hier_init (sc_notify_t * notify);
+static void         sc_notify_hier_reset (sc_notify_t * notify);
+
 void
 sc_notify_destroy (sc_notify_t * notify)
 {
@@ -131,6 +191,10 @@ sc_notify_destroy (sc_notify_t * notify)
   case SC_NOTIFY_NBX:
   case SC_NOTIFY_RANGES:
   case SC_NOTIFY_SUPERSET:
+  case SC_NOTIFY_AUTO:
+    break;
+  case SC_NOTIFY_HIER:
+    sc_notify_hier_reset (notify);
     break;
   default:
     SC_ABORT_NOT_REACHED ();
@@ -152,6 +216,7 @@ sc_notify_get_type (sc_notify_t * notify)
 
 static void         sc_notify_nary_init (sc_notify_t * notify);
 static void         sc_notify_ranges_init (sc_notify_t * notify);
+static void         sc_notify_auto_init (sc_notify_t * notify);
 
 int
 sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
@@ -162,8 +227,12 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
   if (in_type == SC_NOTIFY_DEFAULT) {
     in_type = sc_notify_type_default;
   }
-  SC_ASSERT (in_type >= 0 && in_type < SC_NOTIFY_NUM_TYPES);
+  SC_ASSERT (in_type == SC_NOTIFY_AUTO ||
+             (in_type >= 0 && in_type < SC_NOTIFY_NUM_TYPES));
   if (current_type != in_type) {
+    if (current_type == SC_NOTIFY_HIER) {
+      sc_notify_hier_reset (notify);
+    }
     notify->type = in_type;
     /* initialize_data */
     switch (in_type) {
@@ -181,6 +250,14 @@ sc_notify_set_type (sc_notify_t * notify, sc_notify_type_t in_type)
     case SC_NOTIFY_NARY:
       sc_notify_nary_init (notify);
       break;
+    case SC_NOTIFY_AUTO:
+      /* the nary candidate uses the type data */
+      sc_notify_nary_init (notify);
+      sc_notify_auto_init (notify);
+      break;
+    case SC_NOTIFY_HIER:
+      sc_notify_hier_init (notify);
+      break;
     default:
       SC_ABORT_NOT_REACHED ();
     }
@@ -197,7 +274,7 @@ sc_notify_get_eager_threshold (sc_notify_t * notify)
 }
 
 void
-sc_notify_set_eagher_threshold (sc_notify_t * notify, size_t thresh)
+sc_notify_set_eager_threshold (sc_notify_t * notify, size_t thresh)
 {
   notify->eager_threshold = thresh;
 }
@@ -254,8 +331,10 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
   int                *isenders, num_senders = -1;
   sc_MPI_Comm         comm;
   sc_flopinfo_t       snap;
+  sc_arena_t         *arena = sc_arena_default ();
 
   SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  sc_arena_push (arena);
 
   comm = sc_notify_get_comm (notify);
   mpiret = sc_MPI_Comm_size (comm, &size);
@@ -269,7 +348,7 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
     isenders = (int *) senders->array;
   }
   else {
-    isenders = SC_ALLOC (int, (size_t) size);
+    isenders = SC_ARENA_ALLOC (arena, int, (size_t) size);
   }
 
   mpiret = (*notify_fn) ((int *) receivers->array,
@@ -286,14 +365,15 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
     int                *ireceivers = (int *) receivers->array;
     int                 msg_size = (int) in_payload->elem_size;
 
-    sendreq = SC_ALLOC (sc_MPI_Request, (num_receivers + num_senders));
+    sendreq = SC_ARENA_ALLOC (arena, sc_MPI_Request,
+                              (num_receivers + num_senders));
     recvreq = &sendreq[num_receivers];
     if (out_payload) {
       sc_array_resize (out_payload, (size_t) num_senders);
       rpayload = (char *) out_payload->array;
     }
     else {
-      rpayload = SC_ALLOC (char, num_senders * msg_size);
+      rpayload = SC_ARENA_ALLOC (arena, char, num_senders * msg_size);
     }
 
     for (j = 0; j < num_receivers; j++) {
@@ -317,10 +397,8 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
       sc_array_reset (in_payload);
       sc_array_resize (in_payload, num_senders);
       memcpy ((char *) in_payload->array, rpayload, num_senders * msg_size);
-      SC_FREE (rpayload);
       out_payload = in_payload;
     }
-    SC_FREE (sendreq);
   }
   if (senders) {
     sc_array_resize (senders, (size_t) num_senders);
@@ -329,7 +407,6 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
     sc_array_reset (receivers);
     sc_array_resize (receivers, (size_t) num_senders);
     memcpy (receivers->array, isenders, num_senders * sizeof (int));
-    SC_FREE (isenders);
     senders = receivers;
   }
   if (sorted && !sc_array_is_sorted (senders, sc_int_compare)) {
@@ -363,6 +440,7 @@ sc_notify_payload_wrapper (sc_array_t * receivers, sc_array_t * senders,
       sc_array_destroy (sorter);
     }
   }
+  sc_arena_pop (arena);
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
@@ -643,6 +721,82 @@ sc_notify_payloadv_wrapper (sc_array_t * receivers, sc_array_t * senders,
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
+/** Send small variable size messages inside the notification itself.
+ * Every message is padded to the largest message on any process, which
+ * takes one allreduce to find.  If the padded message and its length fit
+ * into the eager threshold, the messages travel with the notify algorithm
+ * as a fixed size payload, such that no separate exchange is needed.
+ * \return         True if the messages have been exchanged this way.
+ */
+static int
+sc_notify_payloadv_eager (sc_array_t * receivers, sc_array_t * senders,
+                          sc_array_t * in_payload, sc_array_t * out_payload,
+                          sc_array_t * in_offsets, sc_array_t * out_offsets,
+                          int sorted, sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 i, count, num_receivers, num_senders;
+  int                 max_count, global_max;
+  int                *ioffsets, *roffsets, *rec;
+  size_t              elem_size = in_payload->elem_size;
+  size_t              record_size;
+  sc_array_t         *records, *recv_records;
+  sc_array_t         *recv_payload, *recv_offsets;
+
+  /* agree on the size of the padded messages */
+  num_receivers = (int) receivers->elem_count;
+  ioffsets = (int *) in_offsets->array;
+  max_count = 0;
+  for (i = 0; i < num_receivers; ++i) {
+    max_count = SC_MAX (max_count, ioffsets[i + 1] - ioffsets[i]);
+  }
+  mpiret = sc_MPI_Allreduce (&max_count, &global_max, 1, sc_MPI_INT,
+                             sc_MPI_MAX, sc_notify_get_comm (notify));
+  SC_CHECK_MPI (mpiret);
+  record_size = sizeof (int) + (size_t) global_max * elem_size;
+  if (record_size > notify->eager_threshold) {
+    return 0;
+  }
+
+  /* each record is the number of elements followed by the padded data */
+  records = sc_array_new_count (record_size, (size_t) num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    rec = (int *) sc_array_index_int (records, i);
+    count = ioffsets[i + 1] - ioffsets[i];
+    rec[0] = count;
+    if (count > 0) {
+      memcpy (rec + 1, sc_array_index_int (in_payload, ioffsets[i]),
+              (size_t) count * elem_size);
+    }
+  }
+  recv_records = sc_array_new (record_size);
+  sc_notify_payload (receivers, senders, records, recv_records, sorted,
+                     notify);
+  sc_array_destroy (records);
+
+  /* unpack the records into the output arrays */
+  num_senders = (int) recv_records->elem_count;
+  recv_offsets = out_offsets != NULL ? out_offsets : in_offsets;
+  recv_payload = out_payload != NULL ? out_payload : in_payload;
+  sc_array_resize (recv_offsets, (size_t) num_senders + 1);
+  roffsets = (int *) recv_offsets->array;
+  roffsets[0] = 0;
+  for (i = 0; i < num_senders; ++i) {
+    rec = (int *) sc_array_index_int (recv_records, i);
+    roffsets[i + 1] = roffsets[i] + rec[0];
+  }
+  sc_array_resize (recv_payload, (size_t) roffsets[num_senders]);
+  for (i = 0; i < num_senders; ++i) {
+    rec = (int *) sc_array_index_int (recv_records, i);
+    if (rec[0] > 0) {
+      memcpy (sc_array_index_int (recv_payload, roffsets[i]), rec + 1,
+              (size_t) rec[0] * elem_size);
+    }
+  }
+  sc_array_destroy (recv_records);
+  return 1;
+}
+
 static void
 sc_notify_payloadv_census (sc_array_t * receivers, sc_array_t * senders,
                            sc_array_t * in_payload, sc_array_t * out_payload,
@@ -829,7 +983,7 @@ sc_notify_init_input (sc_array_t * input, int *receivers, int num_receivers,
       (payload->elem_size >
        sizeof (int)) ? (payload->elem_size - sizeof (int)) : 0;
 
-    npay = lowbound / sizeof (int) + 1;
+    npay = (lowbound + sizeof (int) - 1) / sizeof (int) + 1;
   }
   else {
     npay = 0;
@@ -885,7 +1039,7 @@ sc_notify_reset_output (sc_array_t * output, int *senders, int *num_senders,
       (payload->elem_size >
        sizeof (int)) ? (payload->elem_size - sizeof (int)) : 0;
 
-    npay = lowbound / sizeof (int) + 1;
+    npay = (lowbound + sizeof (int) - 1) / sizeof (int) + 1;
   }
   else {
     npay = 0;
@@ -1124,7 +1278,7 @@ sc_notify_nary_get_widths (sc_notify_t * notify, int *ntop, int *nint,
   sc_notify_type_t    type;
 
   type = sc_notify_get_type (notify);
-  SC_ASSERT (type == SC_NOTIFY_NARY);
+  SC_ASSERT (type == SC_NOTIFY_NARY || type == SC_NOTIFY_AUTO);
 #endif
   if (ntop)
     *ntop = notify->data.nary.ntop;
@@ -1141,7 +1295,7 @@ sc_notify_nary_set_widths (sc_notify_t * notify, int ntop, int nint, int nbot)
   sc_notify_type_t    type;
 
   type = sc_notify_get_type (notify);
-  SC_ASSERT (type == SC_NOTIFY_NARY);
+  SC_ASSERT (type == SC_NOTIFY_NARY || type == SC_NOTIFY_AUTO);
 #endif
   notify->data.nary.ntop = ntop;
   notify->data.nary.nint = nint;
@@ -1167,6 +1321,250 @@ sc_notify_nary_init (sc_notify_t * notify)
                              sc_notify_nary_nbot_default);
 }
 
+/*== SC_NOTIFY_AUTO ==*/
+
+static void
+sc_notify_auto_init (sc_notify_t * notify)
+{
+  int                 mpiret, mpisize;
+  int                 r;
+  sc_notify_auto_t   *at = &notify->autotune;
+
+  mpiret = sc_MPI_Comm_size (sc_notify_get_comm (notify), &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  memset (at, 0, sizeof (*at));
+  at->trials = SC_MAX (sc_notify_auto_trials_default, 1);
+  for (r = 0; r < SC_NOTIFY_NUM_REGIMES; ++r) {
+    /* there is nothing to tune on one process */
+    at->choice[r] = mpisize == 1 ? SC_NOTIFY_NARY : SC_NOTIFY_AUTO;
+  }
+}
+
+/** Return the index of a candidate by name or -1 if it is not one. */
+static int
+sc_notify_auto_candidate (const char *name)
+{
+  int                 i;
+
+  for (i = 0; i < SC_NOTIFY_AUTO_NUM_CANDIDATES; ++i) {
+    if (!strcmp (name,
+                 sc_notify_type_strings[sc_notify_auto_candidates[i]])) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int
+sc_notify_auto_is_candidate (sc_notify_type_t type)
+{
+  int                 i;
+
+  for (i = 0; i < SC_NOTIFY_AUTO_NUM_CANDIDATES; ++i) {
+    if (type == sc_notify_auto_candidates[i]) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/** Select the type for a call in a regime and start timing it.
+ * The notify type is set to the selected one until sc_notify_auto_end.
+ */
+static              sc_notify_type_t
+sc_notify_auto_begin (sc_notify_t * notify, sc_notify_regime_t regime)
+{
+  sc_notify_auto_t   *at = &notify->autotune;
+  sc_notify_type_t    type;
+
+  SC_ASSERT (notify->type == SC_NOTIFY_AUTO);
+  SC_ASSERT (0 <= regime && regime < SC_NOTIFY_NUM_REGIMES);
+
+  if ((type = at->choice[regime]) == SC_NOTIFY_AUTO) {
+    type = sc_notify_auto_candidates[at->calls[regime] / at->trials];
+    at->start = sc_MPI_Wtime ();
+  }
+  notify->type = type;
+  return type;
+}
+
+/** Finish timing a call and decide once all candidates are measured. */
+static void
+sc_notify_auto_end (sc_notify_t * notify, sc_notify_regime_t regime,
+                    sc_notify_type_t type)
+{
+  int                 mpiret;
+  int                 i, best;
+  double              elapsed, global;
+  char                variable[BUFSIZ];
+  sc_notify_auto_t   *at = &notify->autotune;
+  sc_notify_type_t    candidate;
+
+  SC_ASSERT (notify->type == type);
+  notify->type = SC_NOTIFY_AUTO;
+  if (at->choice[regime] != SC_NOTIFY_AUTO) {
+    return;
+  }
+
+  /* the slowest process determines the time of a collective call */
+  elapsed = sc_MPI_Wtime () - at->start;
+  mpiret = sc_MPI_Allreduce (&elapsed, &global, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, sc_notify_get_comm (notify));
+  SC_CHECK_MPI (mpiret);
+  at->seconds[regime][type] += global;
+  if (++at->calls[regime] < SC_NOTIFY_AUTO_NUM_CANDIDATES * at->trials) {
+    return;
+  }
+
+  /* all processes see the same times and agree on the fastest */
+  best = 0;
+  for (i = 1; i < SC_NOTIFY_AUTO_NUM_CANDIDATES; ++i) {
+    if (at->seconds[regime][sc_notify_auto_candidates[i]] <
+        at->seconds[regime][sc_notify_auto_candidates[best]]) {
+      best = i;
+    }
+  }
+  at->choice[regime] = sc_notify_auto_candidates[best];
+  SC_GLOBAL_INFOF ("Notify auto chooses %s for regime %s\n",
+                   sc_notify_type_strings[at->choice[regime]],
+                   sc_notify_regime_strings[regime]);
+
+  if (notify->stats != NULL) {
+    for (i = 0; i < SC_NOTIFY_AUTO_NUM_CANDIDATES; ++i) {
+      candidate = sc_notify_auto_candidates[i];
+      snprintf (variable, BUFSIZ, "sc_notify_auto:%s:%s",
+                sc_notify_regime_strings[regime],
+                sc_notify_type_strings[candidate]);
+      if (!sc_statistics_has (notify->stats, variable)) {
+        sc_statistics_add_empty_ext (notify->stats, variable, 1);
+      }
+      sc_statistics_accumulate (notify->stats, variable,
+                                at->seconds[regime][candidate] / at->trials);
+    }
+    snprintf (variable, BUFSIZ, "sc_notify_auto:%s",
+              sc_notify_regime_strings[regime]);
+    if (!sc_statistics_has (notify->stats, variable)) {
+      sc_statistics_add_empty_ext (notify->stats, variable, 1);
+    }
+    sc_statistics_accumulate (notify->stats, variable,
+                              (double) at->choice[regime]);
+  }
+}
+
+sc_notify_type_t
+sc_notify_auto_get_type (sc_notify_t * notify, sc_notify_regime_t regime)
+{
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_AUTO);
+  SC_ASSERT (0 <= regime && regime < SC_NOTIFY_NUM_REGIMES);
+
+  return notify->autotune.choice[regime];
+}
+
+int
+sc_notify_auto_save (sc_notify_t * notify, const char *filename)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank;
+  int                 r, result = 0;
+  FILE               *file;
+  sc_notify_auto_t   *at = &notify->autotune;
+  sc_MPI_Comm         comm = sc_notify_get_comm (notify);
+
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_AUTO);
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  if (mpirank == 0) {
+    if ((file = fopen (filename, "w")) == NULL) {
+      result = -1;
+    }
+    else {
+      fprintf (file, "sc_notify_auto %d\n", mpisize);
+      for (r = 0; r < SC_NOTIFY_NUM_REGIMES; ++r) {
+        if (at->choice[r] != SC_NOTIFY_AUTO) {
+          fprintf (file, "%s %s\n", sc_notify_regime_strings[r],
+                   sc_notify_type_strings[at->choice[r]]);
+        }
+      }
+      if (ferror (file)) {
+        result = -1;
+      }
+      if (fclose (file)) {
+        result = -1;
+      }
+    }
+  }
+  mpiret = sc_MPI_Bcast (&result, 1, sc_MPI_INT, 0, comm);
+  SC_CHECK_MPI (mpiret);
+
+  return result;
+}
+
+int
+sc_notify_auto_load (sc_notify_t * notify, const char *filename)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank, filesize;
+  int                 r, c;
+  int                 table[SC_NOTIFY_NUM_REGIMES + 1];
+  char                rname[BUFSIZ], tname[BUFSIZ];
+  FILE               *file;
+  sc_notify_auto_t   *at = &notify->autotune;
+  sc_MPI_Comm         comm = sc_notify_get_comm (notify);
+
+  SC_ASSERT (sc_notify_get_type (notify) == SC_NOTIFY_AUTO);
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the first entry is the result, followed by a type for each regime */
+  if (mpirank == 0) {
+    table[0] = -1;
+    for (r = 0; r < SC_NOTIFY_NUM_REGIMES; ++r) {
+      table[1 + r] = (int) SC_NOTIFY_AUTO;
+    }
+    if ((file = fopen (filename, "r")) != NULL) {
+      if (fscanf (file, "sc_notify_auto %d", &filesize) == 1 &&
+          filesize == mpisize) {
+        table[0] = 0;
+        while (fscanf (file, "%1023s %1023s", rname, tname) == 2) {
+          for (r = 0; r < SC_NOTIFY_NUM_REGIMES; ++r) {
+            if (!strcmp (rname, sc_notify_regime_strings[r])) {
+              break;
+            }
+          }
+          if (r == SC_NOTIFY_NUM_REGIMES ||
+              (c = sc_notify_auto_candidate (tname)) < 0) {
+            table[0] = -1;
+            break;
+          }
+          table[0] += table[1 + r] == (int) SC_NOTIFY_AUTO;
+          table[1 + r] = (int) sc_notify_auto_candidates[c];
+        }
+      }
+      fclose (file);
+    }
+  }
+  mpiret = sc_MPI_Bcast (table, SC_NOTIFY_NUM_REGIMES + 1, sc_MPI_INT, 0,
+                         comm);
+  SC_CHECK_MPI (mpiret);
+
+  if (table[0] >= 0) {
+    for (r = 0; r < SC_NOTIFY_NUM_REGIMES; ++r) {
+      if (table[1 + r] != (int) SC_NOTIFY_AUTO) {
+        at->choice[r] = (sc_notify_type_t) table[1 + r];
+      }
+    }
+  }
+  return table[0];
+}
+
 /** Internally used function to execute the sc_notify recursion.
  * The internal data format of the input and output arrays is as follows:
  * forall(torank): (torank, howmanyfroms, listoffromranks).
@@ -1487,6 +1885,10 @@ sc_notify_payload_nary (sc_array_t * receivers, sc_array_t * senders,
         *(int *) sc_array_push (senders) = 0;
       }
     }
+    if (in_payload != NULL && out_payload != NULL) {
+      /* the only message goes to ourselves */
+      sc_array_copy (out_payload, in_payload);
+    }
 
     /* we return if there is only one process */
     SC_NOTIFY_FUNC_SHOT (notify, &snap);
@@ -1519,7 +1921,7 @@ sc_notify_payload_nary (sc_array_t * receivers, sc_array_t * senders,
       (in_payload->elem_size >
        sizeof (int)) ? (in_payload->elem_size - sizeof (int)) : 0;
 
-    nary->npay = lowbound / sizeof (int) + 1;
+    nary->npay = (lowbound + sizeof (int) - 1) / sizeof (int) + 1;
   }
   else {
     nary->npay = 0;
@@ -1585,7 +1987,7 @@ sc_notify_payload_pex (sc_array_t * receivers, sc_array_t * senders,
       (in_payload->elem_size >
        sizeof (int)) ? (in_payload->elem_size - sizeof (int)) : 0;
 
-    npay = lowbound / sizeof (int) + 1;
+    npay = (lowbound + sizeof (int) - 1) / sizeof (int) + 1;
   }
   stride = 1 + npay;
 
@@ -2063,7 +2465,7 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
     MPI_Status          status;
 
     mpiret =
-      MPI_Iprobe (MPI_ANY_SOURCE, SC_TAG_NOTIFY_NBX, comm, &flag, &status);
+      MPI_Iprobe (MPI_ANY_SOURCE, SC_TAG_NOTIFY_NBXV, comm, &flag, &status);
     SC_CHECK_MPI (mpiret);
     if (flag) {
       int                *r;
@@ -2082,8 +2484,8 @@ sc_notify_payloadv_nbx (sc_array_t * receivers, sc_array_t * senders,
       *off = (int) recv_buf->elem_count;
 
       mpiret =
-        MPI_Recv (rc, msg_size * count, MPI_BYTE, j, SC_TAG_NOTIFY_NBX, comm,
-                  MPI_STATUS_IGNORE);
+        MPI_Recv (rc, msg_size * count, MPI_BYTE, j, SC_TAG_NOTIFY_NBXV,
+                  comm, MPI_STATUS_IGNORE);
       SC_CHECK_MPI (mpiret);
     }
     if (!barr) {
@@ -2190,8 +2592,10 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
   char               *my_payload = NULL;
   int                 last_proc;
   sc_flopinfo_t       snap;
+  sc_arena_t         *arena = sc_arena_default ();
 
   SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  sc_arena_push (arena);
   max_ranges = notify->data.ranges.num_ranges;
   package_id = notify->data.ranges.package_id;
   comm = sc_notify_get_comm (notify);
@@ -2200,10 +2604,10 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
   mpiret = sc_MPI_Comm_size (comm, &size);
   SC_CHECK_MPI (mpiret);
 
-  my_ranges = SC_ALLOC (int, 2 * max_ranges);
-  receiver_ranks_ranges = SC_ALLOC (int, size);
-  sender_ranks_ranges = SC_ALLOC (int, size);
-  procs = SC_ALLOC_ZERO (int, size);
+  my_ranges = SC_ARENA_ALLOC (arena, int, 2 * max_ranges);
+  receiver_ranks_ranges = SC_ARENA_ALLOC (arena, int, size);
+  sender_ranks_ranges = SC_ARENA_ALLOC (arena, int, size);
+  procs = SC_ARENA_ALLOC_ZERO (arena, int, size);
   num_procs = (int) receivers->elem_count;
   ireceivers = (int *) receivers->array;
   first_peer = size;
@@ -2213,7 +2617,7 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
     if (peer == rank) {
       my_pos = i;
       if (in_payload) {
-        my_payload = SC_ALLOC (char, in_payload->elem_size);
+        my_payload = SC_ARENA_ALLOC (arena, char, in_payload->elem_size);
         memcpy (my_payload, sc_array_index_int (in_payload, i),
                 in_payload->elem_size);
       }
@@ -2235,14 +2639,13 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
                         comm, num_procs, procs, rank, max_ranges, my_ranges);
 #endif
   SC_FREE (all_ranges);
-  SC_FREE (my_ranges);
   msg_size = sizeof (int);
   if (in_payload) {
     msg_size += in_payload->elem_size;
   }
   sendbuf = sc_array_new_count (msg_size, (size_t) num_receivers_ranges);
-  sendreqs =
-    SC_ALLOC (sc_MPI_Request, (num_receivers_ranges + num_senders_ranges));
+  sendreqs = SC_ARENA_ALLOC (arena, sc_MPI_Request,
+                             (num_receivers_ranges + num_senders_ranges));
   recvreqs = &sendreqs[num_receivers_ranges];
   for (i = 0; i < num_receivers_ranges; i++) {
     int                *send = (int *) sc_array_index_int (sendbuf, i);
@@ -2264,7 +2667,6 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
                            proc, SC_TAG_NOTIFY_RANGES, comm, &sendreqs[i]);
     SC_CHECK_MPI (mpiret);
   }
-  SC_FREE (procs);
   if (!senders) {
     sc_array_reset (receivers);
     senders = receivers;
@@ -2341,14 +2743,9 @@ sc_notify_payload_ranges (sc_array_t * receivers, sc_array_t * senders,
     }
     num_senders++;
   }
-  if (my_payload) {
-    SC_FREE (my_payload);
-  }
-  SC_FREE (sendreqs);
   sc_array_destroy (recvbuf);
   sc_array_destroy (sendbuf);
-  SC_FREE (sender_ranks_ranges);
-  SC_FREE (receiver_ranks_ranges);
+  sc_arena_pop (arena);
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
@@ -2541,6 +2938,272 @@ sc_notify_payload_superset (sc_array_t * receivers, sc_array_t * senders,
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
 }
 
+/*== SC_NOTIFY_HIER ==*/
+
+static void
+sc_notify_hier_init (sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 p, mpisize;
+  const int          *locations;
+  sc_MPI_Comm         comm, intranode, internode;
+  sc_notify_hier_t   *hier = &notify->data.hier;
+
+  comm = sc_notify_get_comm (notify);
+  memset (hier, 0, sizeof (*hier));
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  locations = sc_mpi_comm_get_node_locations (comm);
+  if (intranode == sc_MPI_COMM_NULL) {
+    /* every process is a node of its own */
+    SC_GLOBAL_LDEBUG ("No node communicators attached for hier notify\n");
+    intranode = sc_MPI_COMM_SELF;
+    internode = comm;
+    locations = NULL;
+  }
+  hier->intranode = intranode;
+  mpiret = sc_MPI_Comm_size (intranode, &hier->intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &hier->intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the nodes are numbered by their internode rank; the layout is cached
+     with the node comms, so no communication is needed here */
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  hier->locations = SC_ALLOC (int, 2 * mpisize);
+  if (locations != NULL) {
+    memcpy (hier->locations, locations, 2 * (size_t) mpisize * sizeof (int));
+  }
+  else {
+    SC_ASSERT (hier->intrasize == 1);
+    for (p = 0; p < mpisize; ++p) {
+      hier->locations[2 * p] = p;
+      hier->locations[2 * p + 1] = 0;
+    }
+  }
+
+  if (hier->intrarank == 0) {
+    hier->leaders = sc_notify_new (internode);
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+    sc_notify_set_type (hier->leaders, SC_NOTIFY_NBX);
+#else
+    sc_notify_set_type (hier->leaders, SC_NOTIFY_NARY);
+#endif
+  }
+}
+
+static void
+sc_notify_hier_reset (sc_notify_t * notify)
+{
+  sc_notify_hier_t   *hier = &notify->data.hier;
+
+  if (hier->leaders != NULL) {
+    sc_notify_destroy (hier->leaders);
+  }
+  SC_FREE (hier->locations);
+  memset (hier, 0, sizeof (*hier));
+}
+
+/** Order records by destination and then by source rank. */
+static int
+sc_notify_hier_compare (const void *a, const void *b)
+{
+  const int          *ra = (const int *) a;
+  const int          *rb = (const int *) b;
+
+  if (ra[0] != rb[0]) {
+    return ra[0] < rb[0] ? -1 : 1;
+  }
+  return ra[1] == rb[1] ? 0 : ra[1] < rb[1] ? -1 : 1;
+}
+
+/** Hierarchical notify through the leader of each node.
+ * Every message is a record of destination rank, source rank and payload.
+ * The records are gathered on the node leaders, exchanged between leaders
+ * with one record list per destination node, and scattered to the ranks
+ * of the node.  Thus only leaders communicate between nodes.
+ */
+static void
+sc_notify_payload_hier (sc_array_t * receivers, sc_array_t * senders,
+                        sc_array_t * in_payload, sc_array_t * out_payload,
+                        int sorted, sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 i, j, node, rank, numnodes;
+  int                 rints, count, total, num_senders;
+  int                 num_receivers, num_local, num_remote;
+  int                *ireceivers, *rec, *records, *gathered;
+  int                *counts, *displs, *nodecounts;
+  size_t              elem_size;
+  sc_array_t         *lreceivers, *lsenders, *lin, *lout, *lin_offsets,
+    *lout_offsets;
+  sc_MPI_Comm         comm;
+  sc_notify_hier_t   *hier = &notify->data.hier;
+  sc_flopinfo_t       snap;
+
+  SC_ASSERT (hier->locations != NULL);
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  comm = sc_notify_get_comm (notify);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* pack a record for every receiver */
+  elem_size = in_payload != NULL ? in_payload->elem_size : 0;
+  rints = 2 + (int) ((elem_size + sizeof (int) - 1) / sizeof (int));
+  num_receivers = (int) receivers->elem_count;
+  ireceivers = (int *) receivers->array;
+  records = SC_ALLOC_ZERO (int, rints * num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    rec = records + rints * i;
+    rec[0] = ireceivers[i];
+    rec[1] = rank;
+    if (elem_size > 0) {
+      memcpy (rec + 2, sc_array_index_int (in_payload, i), elem_size);
+    }
+  }
+
+  /* gather all records of the node on its leader */
+  count = rints * num_receivers;
+  counts = displs = gathered = NULL;
+  if (hier->intrarank == 0) {
+    counts = SC_ALLOC (int, 2 * hier->intrasize);
+    displs = counts + hier->intrasize;
+  }
+  mpiret = sc_MPI_Gather (&count, 1, sc_MPI_INT, counts, 1, sc_MPI_INT, 0,
+                          hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  total = 0;
+  if (hier->intrarank == 0) {
+    for (j = 0; j < hier->intrasize; ++j) {
+      displs[j] = total;
+      total += counts[j];
+    }
+    gathered = SC_ALLOC (int, total);
+  }
+  mpiret = sc_MPI_Gatherv (records, count, sc_MPI_INT, gathered, counts,
+                           displs, sc_MPI_INT, 0, hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (records);
+  records = NULL;
+
+  if (hier->intrarank == 0) {
+    /* sort the records by destination node with a counting sort */
+    mpiret = sc_MPI_Comm_size (sc_notify_get_comm (hier->leaders),
+                               &numnodes);
+    SC_CHECK_MPI (mpiret);
+    node = hier->locations[2 * rank];
+    nodecounts = SC_ALLOC_ZERO (int, numnodes + 1);
+    for (i = 0; i < total; i += rints) {
+      ++nodecounts[hier->locations[2 * gathered[i]] + 1];
+    }
+    for (j = 0; j < numnodes; ++j) {
+      nodecounts[j + 1] += nodecounts[j];
+    }
+    num_local = nodecounts[node + 1] - nodecounts[node];
+    records = SC_ALLOC (int, total);
+    for (i = 0; i < total; i += rints) {
+      j = nodecounts[hier->locations[2 * gathered[i]]]++;
+      memcpy (records + rints * j, gathered + i, rints * sizeof (int));
+    }
+    SC_FREE (gathered);
+
+    /* records for this node stay, the others go to the remote leaders */
+    lreceivers = sc_array_new (sizeof (int));
+    lin_offsets = sc_array_new (sizeof (int));
+    *(int *) sc_array_push (lin_offsets) = 0;
+    lin = sc_array_new ((size_t) rints * sizeof (int));
+    num_remote = 0;
+    for (j = 0; j < numnodes; ++j) {
+      /* nodecounts[j] is now the end of the bucket of node j */
+      count = nodecounts[j] - (j == 0 ? 0 : nodecounts[j - 1]);
+      if (j == node || count == 0) {
+        continue;
+      }
+      *(int *) sc_array_push (lreceivers) = j;
+      sc_array_resize (lin, (size_t) (num_remote + count));
+      memcpy (sc_array_index_int (lin, num_remote),
+              records + rints * (nodecounts[j] - count),
+              (size_t) count * rints * sizeof (int));
+      num_remote += count;
+      *(int *) sc_array_push (lin_offsets) = num_remote;
+    }
+    lsenders = sc_array_new (sizeof (int));
+    lout = sc_array_new ((size_t) rints * sizeof (int));
+    lout_offsets = sc_array_new (sizeof (int));
+    sc_notify_payloadv (lreceivers, lsenders, lin, lout, lin_offsets,
+                        lout_offsets, 0, hier->leaders);
+
+    /* collect the records for this node and order them for scattering */
+    total = (int) lout->elem_count + num_local;
+    gathered = SC_ALLOC (int, rints * SC_MAX (total, 1));
+    if (num_local > 0) {
+      memcpy (gathered, records + rints * (nodecounts[node] - num_local),
+              (size_t) num_local * rints * sizeof (int));
+    }
+    if (lout->elem_count > 0) {
+      memcpy (gathered + rints * num_local, lout->array,
+              lout->elem_count * rints * sizeof (int));
+    }
+    qsort (gathered, (size_t) total, rints * sizeof (int),
+           sc_notify_hier_compare);
+    memset (counts, 0, hier->intrasize * sizeof (int));
+    for (i = 0; i < total; ++i) {
+      counts[hier->locations[2 * gathered[rints * i] + 1]] += rints;
+    }
+    for (j = 0, count = 0; j < hier->intrasize; ++j) {
+      displs[j] = count;
+      count += counts[j];
+    }
+
+    SC_FREE (records);
+    SC_FREE (nodecounts);
+    sc_array_destroy (lreceivers);
+    sc_array_destroy (lsenders);
+    sc_array_destroy (lin);
+    sc_array_destroy (lout);
+    sc_array_destroy (lin_offsets);
+    sc_array_destroy (lout_offsets);
+  }
+
+  /* scatter the records to their destination ranks */
+  mpiret = sc_MPI_Scatter (counts, 1, sc_MPI_INT, &count, 1, sc_MPI_INT, 0,
+                           hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  records = SC_ALLOC (int, SC_MAX (count, 1));
+  mpiret = sc_MPI_Scatterv (gathered, counts, displs, sc_MPI_INT,
+                            records, count, sc_MPI_INT, 0, hier->intranode);
+  SC_CHECK_MPI (mpiret);
+  if (hier->intrarank == 0) {
+    SC_FREE (gathered);
+    SC_FREE (counts);
+  }
+
+  /* the records arrive sorted by source rank */
+  num_senders = count / rints;
+  if (senders == NULL) {
+    senders = receivers;
+  }
+  sc_array_resize (senders, (size_t) num_senders);
+  if (in_payload != NULL) {
+    if (out_payload == NULL) {
+      out_payload = in_payload;
+    }
+    sc_array_resize (out_payload, (size_t) num_senders);
+  }
+  for (i = 0; i < num_senders; ++i) {
+    rec = records + rints * i;
+    SC_ASSERT (rec[0] == rank);
+    *(int *) sc_array_index_int (senders, i) = rec[1];
+    if (elem_size > 0) {
+      memcpy (sc_array_index_int (out_payload, i), rec + 2, elem_size);
+    }
+  }
+  SC_FREE (records);
+
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
 /*== SC_NOTIFY_BINARY ==*/
 
 /** Internally used function to execute the sc_notify recursion.
@@ -2736,6 +3399,7 @@ sc_notify (int *receivers, int num_receivers,
   SC_ASSERT (num_receivers >= 0);
   SC_ASSERT (senders != NULL && num_senders != NULL);
   SC_ASSERT (pow2length / 2 < mpisize && mpisize <= pow2length);
+  sc_tracer_begin (__func__);
 
   /* convert input variables into internal format */
   sc_notify_init_input (&array, receivers, num_receivers, NULL,
@@ -2747,25 +3411,85 @@ sc_notify (int *receivers, int num_receivers,
   /* convert internal format to output variables */
   sc_notify_reset_output (&array, senders, num_senders, NULL,
                           mpisize, mpirank);
+  sc_tracer_end (__func__);
 
   return sc_MPI_SUCCESS;
 }
 
 /*== SC_NOTIFY_PAYLOAD ==*/
 
-void
-sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
-                   sc_array_t * in_payload, sc_array_t * out_payload,
-                   int sorted, sc_notify_t * notify)
+/** Return true if a payload lives in memory the host cannot access.
+ * All notify algorithms pack the payload into their messages on the
+ * host, so such payloads are staged through pinned host memory even
+ * when MPI is device-aware.
+ */
+static int
+sc_notify_payload_is_device (sc_array_t * payload)
 {
-  int                 num_receivers;
-  sc_notify_type_t    type = sc_notify_get_type (notify);
-  sc_array_t         *first_in_payload = NULL;
-  sc_array_t         *first_out_payload = NULL;
+  return payload != NULL && !sc_memory_domain_is_host (payload->domain);
+}
+
+/** Copy a payload into a pinned staging array or initialize it empty. */
+static sc_array_t  *
+sc_notify_stage_in (sc_array_t * stage, sc_array_t * payload)
+{
+  if (payload == NULL) {
+    return NULL;
+  }
+  sc_array_init_domain (stage, payload->elem_size, SC_MEMORY_PINNED);
+  sc_array_copy (stage, payload);
+  return stage;
+}
+
+/** Copy a staged result back to its domain and release the stage. */
+static void
+sc_notify_stage_out (sc_array_t * payload, sc_array_t * stage, int result)
+{
+  if (payload != NULL) {
+    if (result) {
+      sc_array_copy (payload, stage);
+    }
+    sc_array_reset (stage);
+  }
+}
+
+void
+sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
+                   sc_array_t * in_payload, sc_array_t * out_payload,
+                   int sorted, sc_notify_t * notify)
+{
+  int                 num_receivers;
+  sc_notify_type_t    type = sc_notify_get_type (notify);
+  sc_array_t         *first_in_payload = NULL;
+  sc_array_t         *first_out_payload = NULL;
   sc_array_t         *receivers_copy = NULL;
+  int                 autotune = 0;
+  sc_notify_regime_t  regime = SC_NOTIFY_REGIME_NONE;
   sc_flopinfo_t       snap;
 
+  if (sc_notify_payload_is_device (in_payload) ||
+      sc_notify_payload_is_device (out_payload)) {
+    sc_array_t          in_stage, out_stage;
+
+    sc_notify_payload (receivers, senders,
+                       sc_notify_stage_in (&in_stage, in_payload),
+                       sc_notify_stage_in (&out_stage, out_payload),
+                       sorted, notify);
+    sc_notify_stage_out (in_payload, &in_stage, out_payload == NULL);
+    sc_notify_stage_out (out_payload, &out_stage, 1);
+    return;
+  }
+
   SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  if (type == SC_NOTIFY_AUTO) {
+    if (in_payload != NULL &&
+        in_payload->elem_size <= notify->eager_threshold) {
+      regime = in_payload->elem_size <= SC_NOTIFY_AUTO_SMALL ?
+        SC_NOTIFY_REGIME_SMALL : SC_NOTIFY_REGIME_EAGER;
+    }
+    type = sc_notify_auto_begin (notify, regime);
+    autotune = 1;
+  }
   SC_GLOBAL_LDEBUGF ("Into sc_notify_payload, type %s\n",
                      sc_notify_type_strings[type]);
 
@@ -2847,6 +3571,10 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
     sc_notify_payload_superset (receivers, senders, first_in_payload,
                                 first_out_payload, sorted, notify);
     break;
+  case SC_NOTIFY_HIER:
+    sc_notify_payload_hier (receivers, senders, first_in_payload,
+                            first_out_payload, sorted, notify);
+    break;
   default:
     SC_ABORT_NOT_REACHED ();
   }
@@ -2864,9 +3592,11 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
     sc_MPI_Request     *sendreq;
     sc_MPI_Comm         comm = sc_notify_get_comm (notify);
     char               *recv_payload = NULL;
+    sc_arena_t         *arena = sc_arena_default ();
 
+    sc_arena_push (arena);
     num_receivers = (int) arecv->elem_count;
-    sendreq = SC_ALLOC (sc_MPI_Request, num_receivers);
+    sendreq = SC_ARENA_ALLOC (arena, sc_MPI_Request, num_receivers);
     for (i = 0; i < num_receivers; i++) {
       mpiret =
         sc_MPI_Isend (&cpayload[i * msg_size], msg_size, sc_MPI_BYTE,
@@ -2878,7 +3608,7 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
       recv_payload = (char *) out_payload->array;
     }
     else {
-      recv_payload = SC_ALLOC (char, msg_size * num_senders);
+      recv_payload = SC_ARENA_ALLOC (arena, char, msg_size * num_senders);
     }
     for (i = 0; i < num_senders; i++) {
       mpiret =
@@ -2893,13 +3623,15 @@ sc_notify_payload (sc_array_t * receivers, sc_array_t * senders,
       sc_array_resize (in_payload, num_senders);
       memcpy (in_payload->array, recv_payload,
               (size_t) msg_size * num_senders);
-      SC_FREE (recv_payload);
     }
-    SC_FREE (sendreq);
+    sc_arena_pop (arena);
   }
   if (receivers_copy) {
     sc_array_destroy (receivers_copy);
   }
+  if (autotune) {
+    sc_notify_auto_end (notify, regime, type);
+  }
 
   SC_GLOBAL_LDEBUG ("Done sc_notify_payload\n");
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
@@ -2915,12 +3647,23 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   size_t              num_receivers;
 #endif
   sc_notify_type_t    type = sc_notify_get_type (notify);
+  int                 autotune = 0;
   sc_flopinfo_t       snap;
 
-  SC_NOTIFY_FUNC_SNAP (notify, &snap);
-  SC_GLOBAL_LDEBUGF ("Into sc_notify_payloadv, type %s\n",
-                     sc_notify_type_strings[type]);
+  if (sc_notify_payload_is_device (in_payload) ||
+      sc_notify_payload_is_device (out_payload)) {
+    sc_array_t          in_stage, out_stage;
 
+    sc_notify_payloadv (receivers, senders,
+                        sc_notify_stage_in (&in_stage, in_payload),
+                        sc_notify_stage_in (&out_stage, out_payload),
+                        in_offsets, out_offsets, sorted, notify);
+    sc_notify_stage_out (in_payload, &in_stage, out_payload == NULL);
+    sc_notify_stage_out (out_payload, &out_stage, 1);
+    return;
+  }
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
   if (in_payload == NULL) {
     SC_ASSERT (out_payload == NULL && in_offsets == NULL
                && out_offsets == NULL);
@@ -2928,6 +3671,12 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
     SC_NOTIFY_FUNC_SHOT (notify, &snap);
     return;
   }
+  if (type == SC_NOTIFY_AUTO) {
+    type = sc_notify_auto_begin (notify, SC_NOTIFY_REGIME_VARIABLE);
+    autotune = 1;
+  }
+  SC_GLOBAL_LDEBUGF ("Into sc_notify_payloadv, type %s\n",
+                     sc_notify_type_strings[type]);
 
   SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
   SC_ASSERT (senders == NULL || senders->elem_size == sizeof (int));
@@ -2964,9 +3713,19 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   }
 
   switch (type) {
+  case SC_NOTIFY_NARY:
+  case SC_NOTIFY_HIER:
+    /* these carry small messages along the notification */
+    if (sc_notify_payloadv_eager (receivers, senders, in_payload,
+                                  out_payload, in_offsets, out_offsets,
+                                  sorted, notify)) {
+      break;
+    }
+    sc_notify_payloadv_wrapper (receivers, senders, in_payload, out_payload,
+                                in_offsets, out_offsets, sorted, notify);
+    break;
   case SC_NOTIFY_ALLGATHER:
   case SC_NOTIFY_BINARY:
-  case SC_NOTIFY_NARY:
   case SC_NOTIFY_PEX:
   case SC_NOTIFY_RANGES:
   case SC_NOTIFY_SUPERSET:
@@ -2990,6 +3749,9 @@ sc_notify_payloadv (sc_array_t * receivers, sc_array_t * senders,
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  if (autotune) {
+    sc_notify_auto_end (notify, SC_NOTIFY_REGIME_VARIABLE, type);
+  }
 
   SC_GLOBAL_LDEBUG ("Done sc_notify_payload\n");
   SC_NOTIFY_FUNC_SHOT (notify, &snap);
@@ -3007,3 +3769,701 @@ sc_notify_ext (sc_array_t * receivers, sc_array_t * senders,
   sc_notify_payload (receivers, senders, in_payload, out_payload, 1, notifyc);
   sc_notify_destroy (notifyc);
 }
+
+void
+sc_notify_payloadv_segments (sc_array_t * receivers, sc_array_t * senders,
+                             const sc_notify_segment_t * segments,
+                             const int *seg_offsets,
+                             sc_notify_recv_buffer_t recv_buffer,
+                             sc_notify_recv_done_t recv_done, void *user,
+                             int sorted, sc_notify_t * notify)
+{
+  int                 mpiret;
+  int                 rank, i, k, self = -1;
+  int                 num_receivers, num_senders, num_reqs;
+  int                 remaining, outcount;
+  int                *ireceivers, *isenders, *indices;
+  size_t              bytes, *sizes;
+  char               *dest;
+  void              **buffers;
+  sc_array_t         *send_sizes, *recv_sizes;
+  sc_MPI_Comm         comm;
+  sc_MPI_Request     *reqs;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders != NULL && senders->elem_size == sizeof (int));
+  SC_ASSERT (seg_offsets != NULL && recv_buffer != NULL);
+
+  comm = sc_notify_get_comm (notify);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* exchange the message sizes to find the senders */
+  num_receivers = (int) receivers->elem_count;
+  ireceivers = (int *) receivers->array;
+  send_sizes = sc_array_new_count (sizeof (size_t), (size_t) num_receivers);
+  for (i = 0; i < num_receivers; ++i) {
+    bytes = 0;
+    for (k = seg_offsets[i]; k < seg_offsets[i + 1]; ++k) {
+      bytes += segments[k].bytes;
+    }
+    *(size_t *) sc_array_index_int (send_sizes, i) = bytes;
+    if (ireceivers[i] == rank) {
+      self = i;
+    }
+  }
+  recv_sizes = sc_array_new (sizeof (size_t));
+  sc_notify_payload (receivers, senders, send_sizes, recv_sizes, sorted,
+                     notify);
+  num_senders = (int) senders->elem_count;
+  isenders = (int *) senders->array;
+  sizes = (size_t *) recv_sizes->array;
+
+  /* post the receives into the memory provided by the caller */
+  num_reqs = num_senders + num_receivers;
+  reqs = SC_ALLOC (sc_MPI_Request, num_reqs);
+  buffers = SC_ALLOC (void *, num_senders);
+  for (i = 0; i < num_senders; ++i) {
+    buffers[i] = recv_buffer (isenders[i], sizes[i], user);
+    reqs[i] = sc_MPI_REQUEST_NULL;
+    if (isenders[i] == rank) {
+      /* the message to ourselves is copied once */
+      SC_ASSERT (self >= 0);
+      dest = (char *) buffers[i];
+      for (k = seg_offsets[self]; k < seg_offsets[self + 1]; ++k) {
+        if (segments[k].bytes > 0) {
+          memcpy (dest, segments[k].data, segments[k].bytes);
+          dest += segments[k].bytes;
+        }
+      }
+      if (recv_done != NULL) {
+        recv_done (rank, buffers[i], sizes[i], user);
+      }
+      continue;
+    }
+    mpiret = sc_mpi_irecv_large (buffers[i], sizes[i], isenders[i],
+                                 SC_TAG_NOTIFY_SEGMENTS, comm, reqs + i);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* send the segments without packing them */
+  for (i = 0; i < num_receivers; ++i) {
+    reqs[num_senders + i] = sc_MPI_REQUEST_NULL;
+    if (i == self) {
+      continue;
+    }
+#ifdef SC_ENABLE_MPI
+    k = seg_offsets[i + 1] - seg_offsets[i];
+    if (k == 1) {
+      mpiret = sc_mpi_isend_large (segments[seg_offsets[i]].data,
+                                   segments[seg_offsets[i]].bytes,
+                                   ireceivers[i], SC_TAG_NOTIFY_SEGMENTS,
+                                   comm, reqs + num_senders + i);
+      SC_CHECK_MPI (mpiret);
+    }
+    else {
+      int                 j, *lengths;
+      MPI_Aint           *displs;
+      MPI_Datatype        segtype;
+
+      lengths = SC_ALLOC (int, SC_MAX (k, 1));
+      displs = SC_ALLOC (MPI_Aint, SC_MAX (k, 1));
+      for (j = 0; j < k; ++j) {
+        SC_ASSERT (segments[seg_offsets[i] + j].bytes <= (size_t) INT_MAX);
+        lengths[j] = (int) segments[seg_offsets[i] + j].bytes;
+        mpiret = MPI_Get_address ((void *) segments[seg_offsets[i] + j].data,
+                                  displs + j);
+        SC_CHECK_MPI (mpiret);
+      }
+      mpiret = MPI_Type_create_hindexed (k, lengths, displs, MPI_BYTE,
+                                         &segtype);
+      SC_CHECK_MPI (mpiret);
+      mpiret = MPI_Type_commit (&segtype);
+      SC_CHECK_MPI (mpiret);
+      mpiret = MPI_Isend (MPI_BOTTOM, 1, segtype, ireceivers[i],
+                          SC_TAG_NOTIFY_SEGMENTS, comm,
+                          reqs + num_senders + i);
+      SC_CHECK_MPI (mpiret);
+
+      /* the type is kept alive by MPI until the send completes */
+      mpiret = MPI_Type_free (&segtype);
+      SC_CHECK_MPI (mpiret);
+      SC_FREE (lengths);
+      SC_FREE (displs);
+    }
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+  }
+
+  /* report every message as soon as it has arrived */
+  for (remaining = 0, i = 0; i < num_reqs; ++i) {
+    remaining += reqs[i] != sc_MPI_REQUEST_NULL;
+  }
+  indices = SC_ALLOC (int, SC_MAX (num_reqs, 1));
+  for (; remaining > 0; remaining -= outcount) {
+    mpiret = sc_MPI_Waitsome (num_reqs, reqs, &outcount, indices,
+                              sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    SC_ASSERT (outcount != sc_MPI_UNDEFINED && outcount > 0);
+    for (k = 0; k < outcount; ++k) {
+      i = indices[k];
+      if (i < num_senders && recv_done != NULL) {
+        recv_done (isenders[i], buffers[i], sizes[i], user);
+      }
+    }
+  }
+
+  SC_FREE (indices);
+  SC_FREE (reqs);
+  SC_FREE (buffers);
+  sc_array_destroy (send_sizes);
+  sc_array_destroy (recv_sizes);
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
+/*== SC_NOTIFY_REQUEST ==*/
+
+struct sc_notify_request_s
+{
+  sc_notify_t        *notify;
+  sc_array_t         *senders;
+  sc_array_t         *in_payload;
+  sc_array_t         *out_payload;
+  int                 sorted;
+  int                 done;
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  sc_notify_type_t    type;     /* SC_NOTIFY_NBX or SC_NOTIFY_PCX */
+  int                 tag;
+  int                 msg_size;
+  int                 num_receivers;
+  MPI_Request        *sendreqs;
+  int                 sent;     /* all sends have completed */
+  MPI_Request         collreq;  /* barrier (nbx) or census (pcx) */
+  int                 coll_started, coll_done;
+  int                *census;   /* send buffer of the census */
+  int                 num_senders;      /* known after the census (pcx) */
+  sc_array_t         *records;  /* sender rank followed by payload */
+#endif
+};
+
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+
+/** Receive the messages that have arrived so far, up to \a limit in total
+ * if it is not negative. */
+static void
+sc_notify_request_recv (sc_notify_request_t * req, int limit, MPI_Comm comm)
+{
+  int                 mpiret;
+  int                 flag;
+  int                *r;
+  MPI_Status          status;
+
+  while (limit < 0 || (int) req->records->elem_count < limit) {
+    mpiret = MPI_Iprobe (MPI_ANY_SOURCE, req->tag, comm, &flag, &status);
+    SC_CHECK_MPI (mpiret);
+    if (!flag) {
+      break;
+    }
+    r = (int *) sc_array_push (req->records);
+    r[0] = status.MPI_SOURCE;
+    mpiret = MPI_Recv (r + 1, req->msg_size, MPI_BYTE, status.MPI_SOURCE,
+                       req->tag, comm, MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+#endif
+
+sc_notify_request_t *
+sc_notify_begin (sc_array_t * receivers, sc_array_t * senders,
+                 sc_array_t * in_payload, sc_array_t * out_payload,
+                 int sorted, sc_notify_t * notify)
+{
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  sc_notify_type_t    type = sc_notify_get_type (notify);
+#endif
+  sc_notify_request_t *req;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders == NULL || senders->elem_size == sizeof (int));
+  SC_ASSERT (in_payload == NULL ||
+             in_payload->elem_count == receivers->elem_count);
+
+  req = SC_ALLOC_ZERO (sc_notify_request_t, 1);
+  req->notify = notify;
+  req->senders = senders != NULL ? senders : receivers;
+  req->in_payload = in_payload;
+  req->out_payload = out_payload != NULL ? out_payload : in_payload;
+  req->sorted = sorted;
+
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  if (type == SC_NOTIFY_NBX || type == SC_NOTIFY_PCX) {
+    int                 mpiret;
+    int                 i, size;
+    int                *ireceivers = (int *) receivers->array;
+    char               *cpayload, *buf;
+    MPI_Comm            comm = sc_notify_get_comm (notify);
+
+    /* a rank may begin the next request while others still receive
+       messages of this one, so consecutive requests alternate tags */
+    req->type = type;
+    req->tag = notify->requests++ % 2 == 0 ?
+      SC_TAG_NOTIFY_REQUEST : SC_TAG_NOTIFY_REQUEST_ODD;
+    req->msg_size = in_payload != NULL ? (int) in_payload->elem_size : 0;
+    req->num_receivers = (int) receivers->elem_count;
+    req->num_senders = -1;
+    req->collreq = MPI_REQUEST_NULL;
+    req->records = sc_array_new (sizeof (int) + (size_t) req->msg_size);
+
+    /* nbx detects completion by synchronous sends and a barrier,
+       pcx by counting the senders in a reduce_scatter */
+    cpayload = in_payload != NULL ? (char *) in_payload->array : NULL;
+    req->sendreqs = SC_ALLOC (MPI_Request, SC_MAX (req->num_receivers, 1));
+    for (i = 0; i < req->num_receivers; ++i) {
+      buf = cpayload != NULL ? cpayload + i * req->msg_size : NULL;
+      if (type == SC_NOTIFY_NBX) {
+        mpiret = MPI_Issend (buf, req->msg_size, MPI_BYTE, ireceivers[i],
+                             req->tag, comm, req->sendreqs + i);
+      }
+      else {
+        mpiret = MPI_Isend (buf, req->msg_size, MPI_BYTE, ireceivers[i],
+                            req->tag, comm, req->sendreqs + i);
+      }
+      SC_CHECK_MPI (mpiret);
+    }
+    if (type == SC_NOTIFY_PCX) {
+      mpiret = MPI_Comm_size (comm, &size);
+      SC_CHECK_MPI (mpiret);
+      req->census = SC_ALLOC_ZERO (int, size);
+      for (i = 0; i < req->num_receivers; ++i) {
+        req->census[ireceivers[i]] = 1;
+      }
+      mpiret = MPI_Ireduce_scatter_block (req->census, &req->num_senders,
+                                          1, MPI_INT, MPI_SUM, comm,
+                                          &req->collreq);
+      SC_CHECK_MPI (mpiret);
+      req->coll_started = 1;
+    }
+    SC_NOTIFY_FUNC_SHOT (notify, &snap);
+    return req;
+  }
+#endif
+
+  /* the other types complete right away */
+  sc_notify_payload (receivers, senders, in_payload, out_payload, sorted,
+                     notify);
+  req->done = 1;
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+  return req;
+}
+
+int
+sc_notify_test (sc_notify_request_t * req)
+{
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  int                 mpiret;
+  MPI_Comm            comm;
+
+  if (req->done) {
+    return 1;
+  }
+  comm = sc_notify_get_comm (req->notify);
+  sc_notify_request_recv (req, req->coll_done ? req->num_senders : -1,
+                          comm);
+  if (!req->sent) {
+    mpiret = MPI_Testall (req->num_receivers, req->sendreqs, &req->sent,
+                          MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (req->type == SC_NOTIFY_NBX) {
+    /* the barrier starts when our messages have been received */
+    if (req->sent && !req->coll_started) {
+      mpiret = MPI_Ibarrier (comm, &req->collreq);
+      SC_CHECK_MPI (mpiret);
+      req->coll_started = 1;
+    }
+    if (req->coll_started) {
+      mpiret = MPI_Test (&req->collreq, &req->coll_done, MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+    req->done = req->coll_done;
+  }
+  else {
+    if (!req->coll_done) {
+      mpiret = MPI_Test (&req->collreq, &req->coll_done, MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+    if (req->coll_done) {
+      /* the census tells how many messages to expect */
+      sc_notify_request_recv (req, req->num_senders, comm);
+      req->done = req->sent &&
+        (int) req->records->elem_count == req->num_senders;
+    }
+  }
+#endif
+  return req->done;
+}
+
+void
+sc_notify_end (sc_notify_request_t * req)
+{
+  sc_notify_t        *notify = req->notify;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+  while (!sc_notify_test (req)) {
+  }
+
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  if (req->records != NULL) {
+    int                 i, num_senders;
+    int                *r;
+
+    /* move the received records into the output arrays */
+    num_senders = (int) req->records->elem_count;
+    if (req->sorted) {
+      sc_array_sort (req->records, sc_int_compare);
+    }
+    sc_array_resize (req->senders, (size_t) num_senders);
+    if (req->out_payload != NULL) {
+      sc_array_resize (req->out_payload, (size_t) num_senders);
+    }
+    for (i = 0; i < num_senders; ++i) {
+      r = (int *) sc_array_index_int (req->records, i);
+      *(int *) sc_array_index_int (req->senders, i) = r[0];
+      if (req->out_payload != NULL) {
+        memcpy (sc_array_index_int (req->out_payload, i), r + 1,
+                (size_t) req->msg_size);
+      }
+    }
+    sc_array_destroy (req->records);
+    SC_FREE (req->sendreqs);
+    SC_FREE (req->census);
+  }
+#endif
+
+  SC_FREE (req);
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
+/*== SC_NOTIFY_PLAN ==*/
+
+struct sc_notify_plan_s
+{
+  sc_notify_t        *notify;
+  int                 valid;    /* false before the first exchange */
+  int                 variable; /* made by sc_notify_plan_payloadv */
+  int                 sorted;   /* senders are sorted by rank */
+  size_t              elem_size;        /* payload element size or 0 */
+  sc_array_t         *receivers;        /* receivers of the last miss */
+  sc_array_t         *senders;  /* senders found for these receivers */
+  sc_array_t         *send_offsets;     /* variable: offsets by receiver */
+  sc_array_t         *recv_offsets;     /* variable: offsets by sender */
+  long                hits, misses;
+};
+
+sc_notify_plan_t   *
+sc_notify_plan_new (sc_notify_t * notify)
+{
+  sc_notify_plan_t   *plan;
+
+  SC_ASSERT (notify != NULL);
+
+  plan = SC_ALLOC_ZERO (sc_notify_plan_t, 1);
+  plan->notify = notify;
+  plan->receivers = sc_array_new (sizeof (int));
+  plan->senders = sc_array_new (sizeof (int));
+  plan->send_offsets = sc_array_new (sizeof (int));
+  plan->recv_offsets = sc_array_new (sizeof (int));
+
+  return plan;
+}
+
+void
+sc_notify_plan_destroy (sc_notify_plan_t * plan)
+{
+  sc_array_destroy (plan->receivers);
+  sc_array_destroy (plan->senders);
+  sc_array_destroy (plan->send_offsets);
+  sc_array_destroy (plan->recv_offsets);
+  SC_FREE (plan);
+}
+
+void
+sc_notify_plan_get_counts (sc_notify_plan_t * plan, long *hits, long *misses)
+{
+  if (hits != NULL) {
+    *hits = plan->hits;
+  }
+  if (misses != NULL) {
+    *misses = plan->misses;
+  }
+}
+
+/** Compare the input of a call with the plan on this rank.
+ * \return  2 if the plan matches, 1 if only the message sizes differ,
+ *          and 0 if the notify algorithm must run again.
+ */
+static int
+sc_notify_plan_match (sc_notify_plan_t * plan, sc_array_t * receivers,
+                      size_t elem_size, sc_array_t * in_offsets,
+                      int variable, int sorted)
+{
+  size_t              count = receivers->elem_count;
+
+  if (!plan->valid || plan->variable != variable ||
+      plan->elem_size != elem_size || (sorted && !plan->sorted) ||
+      plan->receivers->elem_count != count ||
+      (count > 0 && memcmp (plan->receivers->array, receivers->array,
+                            count * sizeof (int)))) {
+    return 0;
+  }
+  if (in_offsets != NULL &&
+      memcmp (plan->send_offsets->array, in_offsets->array,
+              (count + 1) * sizeof (int))) {
+    return 1;
+  }
+  return 2;
+}
+
+/** Agree on the validity of the plan over all ranks and count the outcome.
+ * \return  The minimum over all ranks of \a local.
+ */
+static int
+sc_notify_plan_validate (sc_notify_plan_t * plan, int local)
+{
+  int                 mpiret;
+  int                 global;
+  sc_statistics_t    *stats;
+
+  mpiret = sc_MPI_Allreduce (&local, &global, 1, sc_MPI_INT, sc_MPI_MIN,
+                             sc_notify_get_comm (plan->notify));
+  SC_CHECK_MPI (mpiret);
+
+  if (global > 0) {
+    ++plan->hits;
+  }
+  else {
+    ++plan->misses;
+  }
+  if ((stats = sc_notify_get_stats (plan->notify)) != NULL) {
+    if (!sc_statistics_has (stats, "sc_notify_plan_hit")) {
+      sc_statistics_add_empty (stats, "sc_notify_plan_hit");
+    }
+    sc_statistics_accumulate (stats, "sc_notify_plan_hit",
+                              global > 0 ? 1. : 0.);
+  }
+  return global;
+}
+
+/** Send messages to the receivers and receive those from the senders.
+ * Without offsets, every message holds exactly one element.
+ * A message to this rank is copied locally.
+ */
+static void
+sc_notify_plan_exchange (sc_notify_plan_t * plan, int tag, size_t elem_size,
+                         sc_array_t * receivers, const int *soffsets,
+                         char *sendbuf, sc_array_t * senders,
+                         const int *roffsets, char *recvbuf)
+{
+  int                 mpiret;
+  int                 rank, i, self = -1;
+  int                 first, count, sfirst = 0, scount = 0;
+  int                 num_receivers = (int) receivers->elem_count;
+  int                 num_senders = (int) senders->elem_count;
+  int                *ireceivers = (int *) receivers->array;
+  int                *isenders = (int *) senders->array;
+  sc_MPI_Comm         comm = sc_notify_get_comm (plan->notify);
+  sc_MPI_Request     *reqs;
+
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  reqs = SC_ALLOC (sc_MPI_Request, num_receivers + num_senders);
+  for (i = 0; i < num_receivers; ++i) {
+    first = soffsets != NULL ? soffsets[i] : i;
+    count = soffsets != NULL ? soffsets[i + 1] - first : 1;
+    if (ireceivers[i] == rank) {
+      self = i;
+      sfirst = first;
+      scount = count;
+      reqs[i] = sc_MPI_REQUEST_NULL;
+      continue;
+    }
+    mpiret = sc_mpi_isend_large (sendbuf + first * elem_size,
+                                 (size_t) count * elem_size,
+                                 ireceivers[i], tag, comm, reqs + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (i = 0; i < num_senders; ++i) {
+    first = roffsets != NULL ? roffsets[i] : i;
+    count = roffsets != NULL ? roffsets[i + 1] - first : 1;
+    if (isenders[i] == rank) {
+      SC_ASSERT (self >= 0 && scount == count);
+      if (count > 0) {
+        memcpy (recvbuf + first * elem_size, sendbuf + sfirst * elem_size,
+                count * elem_size);
+      }
+      reqs[num_receivers + i] = sc_MPI_REQUEST_NULL;
+      continue;
+    }
+    mpiret = sc_mpi_irecv_large (recvbuf + first * elem_size,
+                                 (size_t) count * elem_size, isenders[i],
+                                 tag, comm, reqs + num_receivers + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Waitall (num_receivers + num_senders, reqs,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (reqs);
+}
+
+void
+sc_notify_plan_payload (sc_notify_plan_t * plan, sc_array_t * receivers,
+                        sc_array_t * senders, sc_array_t * in_payload,
+                        sc_array_t * out_payload, int sorted)
+{
+  int                 local;
+  size_t              elem_size;
+  sc_array_t         *recv_payload;
+  sc_notify_t        *notify = plan->notify;
+  sc_flopinfo_t       snap;
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders == NULL || senders->elem_size == sizeof (int));
+  SC_ASSERT (in_payload == NULL ||
+             in_payload->elem_count == receivers->elem_count);
+
+  elem_size = in_payload != NULL ? in_payload->elem_size : 0;
+  local = sc_notify_plan_match (plan, receivers, elem_size, NULL, 0, sorted);
+  if (!sc_notify_plan_validate (plan, local)) {
+    /* run the notify algorithm and remember its result */
+    sc_array_copy (plan->receivers, receivers);
+    if (out_payload != NULL) {
+      /* some algorithms expect an empty output array */
+      sc_array_reset (out_payload);
+    }
+    sc_notify_payload (receivers, senders, in_payload, out_payload,
+                       sorted, notify);
+    sc_array_copy (plan->senders, senders != NULL ? senders : receivers);
+    plan->valid = 1;
+    plan->variable = 0;
+    plan->sorted = sorted;
+    plan->elem_size = elem_size;
+  }
+  else {
+    if (in_payload != NULL) {
+      recv_payload = out_payload != NULL ? out_payload :
+        sc_array_new (elem_size);
+      sc_array_resize (recv_payload, plan->senders->elem_count);
+      sc_notify_plan_exchange (plan, SC_TAG_NOTIFY_PLAN, elem_size,
+                               plan->receivers, NULL, in_payload->array,
+                               plan->senders, NULL, recv_payload->array);
+      if (out_payload == NULL) {
+        sc_array_copy (in_payload, recv_payload);
+        sc_array_destroy (recv_payload);
+      }
+    }
+    sc_array_copy (senders != NULL ? senders : receivers, plan->senders);
+  }
+
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
+
+void
+sc_notify_plan_payloadv (sc_notify_plan_t * plan, sc_array_t * receivers,
+                         sc_array_t * senders, sc_array_t * in_payload,
+                         sc_array_t * out_payload, sc_array_t * in_offsets,
+                         sc_array_t * out_offsets, int sorted)
+{
+  int                 global;
+  int                 i, num_receivers, num_senders;
+  int                *ioffsets, *roffsets, *icounts;
+  size_t              elem_size;
+  sc_array_t         *counts, *recv_payload;
+  sc_notify_t        *notify = plan->notify;
+  sc_flopinfo_t       snap;
+
+  if (in_payload == NULL) {
+    SC_ASSERT (out_payload == NULL && in_offsets == NULL
+               && out_offsets == NULL);
+    sc_notify_plan_payload (plan, receivers, senders, NULL, NULL, sorted);
+    return;
+  }
+
+  SC_NOTIFY_FUNC_SNAP (notify, &snap);
+
+  SC_ASSERT (receivers != NULL && receivers->elem_size == sizeof (int));
+  SC_ASSERT (senders == NULL || senders->elem_size == sizeof (int));
+  SC_ASSERT (in_offsets != NULL && in_offsets->elem_size == sizeof (int)
+             && in_offsets->elem_count == receivers->elem_count + 1);
+
+  elem_size = in_payload->elem_size;
+  global = sc_notify_plan_validate
+    (plan, sc_notify_plan_match (plan, receivers, elem_size, in_offsets,
+                                 1, sorted));
+  if (!global) {
+    /* run the notify algorithm and remember its result */
+    sc_array_copy (plan->receivers, receivers);
+    sc_array_copy (plan->send_offsets, in_offsets);
+    sc_notify_payloadv (receivers, senders, in_payload, out_payload,
+                        in_offsets, out_offsets, sorted, notify);
+    sc_array_copy (plan->senders, senders != NULL ? senders : receivers);
+    sc_array_copy (plan->recv_offsets,
+                   out_offsets != NULL ? out_offsets : in_offsets);
+    plan->valid = 1;
+    plan->variable = 1;
+    plan->sorted = sorted;
+    plan->elem_size = elem_size;
+  }
+  else {
+    num_receivers = (int) plan->receivers->elem_count;
+    num_senders = (int) plan->senders->elem_count;
+    ioffsets = (int *) in_offsets->array;
+    if (global == 1) {
+      /* the senders are still valid but some message sizes changed */
+      counts = sc_array_new_count (sizeof (int),
+                                   (size_t) (num_receivers + num_senders));
+      icounts = (int *) counts->array;
+      for (i = 0; i < num_receivers; ++i) {
+        icounts[i] = ioffsets[i + 1] - ioffsets[i];
+      }
+      sc_notify_plan_exchange (plan, SC_TAG_NOTIFY_PLANV, sizeof (int),
+                               plan->receivers, NULL, (char *) icounts,
+                               plan->senders, NULL,
+                               (char *) (icounts + num_receivers));
+      sc_array_resize (plan->recv_offsets, (size_t) num_senders + 1);
+      roffsets = (int *) plan->recv_offsets->array;
+      roffsets[0] = 0;
+      for (i = 0; i < num_senders; ++i) {
+        roffsets[i + 1] = roffsets[i] + icounts[num_receivers + i];
+      }
+      sc_array_destroy (counts);
+      sc_array_copy (plan->send_offsets, in_offsets);
+    }
+    roffsets = (int *) plan->recv_offsets->array;
+
+    recv_payload = out_payload != NULL ? out_payload :
+      sc_array_new (elem_size);
+    sc_array_resize (recv_payload, (size_t) roffsets[num_senders]);
+    sc_notify_plan_exchange (plan, SC_TAG_NOTIFY_PLAN, elem_size,
+                             plan->receivers, ioffsets, in_payload->array,
+                             plan->senders, roffsets, recv_payload->array);
+    if (out_payload == NULL) {
+      sc_array_copy (in_payload, recv_payload);
+      sc_array_destroy (recv_payload);
+    }
+    sc_array_copy (out_offsets != NULL ? out_offsets : in_offsets,
+                   plan->recv_offsets);
+    sc_array_copy (senders != NULL ? senders : receivers, plan->senders);
+  }
+
+  SC_NOTIFY_FUNC_SHOT (notify, &snap);
+}
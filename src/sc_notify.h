@@ -32,6 +32,12 @@ SC_EXTERN_C_BEGIN;
 /** Opaque object used for controlling notification (AKA dynamic sparse data exchange) operations */
 typedef struct sc_notify_s sc_notify_t;
 
+/** Opaque object caching the result of notification for reuse */
+typedef struct sc_notify_plan_s sc_notify_plan_t;
+
+/** Opaque object for a notification in progress */
+typedef struct sc_notify_request_s sc_notify_request_t;
+
 /** Type of callback function for the superset variant */
 typedef void        (*sc_compute_superset_t) (sc_array_t *, sc_array_t *,
                                               sc_array_t *, sc_notify_t *,
@@ -40,6 +46,8 @@ typedef void        (*sc_compute_superset_t) (sc_array_t *, sc_array_t *,
 /** Existing implementations */
 typedef enum
 {
+  SC_NOTIFY_AUTO = -2,     /**< time the candidates on the first calls
+                                and choose the fastest, see below */
   SC_NOTIFY_DEFAULT = -1,  /**< choose whatever type is stored in sc_notify_type_default */
   SC_NOTIFY_ALLGATHER = 0, /**< choose allgather algorithm */
   SC_NOTIFY_BINARY,        /**< choose simple binary recursion */
@@ -51,6 +59,10 @@ typedef enum
   SC_NOTIFY_RANGES,        /**< use sc_ranges */
   SC_NOTIFY_SUPERSET,      /**< use a computable superset of communicators, computed by
                                 a callback function */
+  SC_NOTIFY_HIER,          /**< gather on node leaders, which exchange messages
+                                between nodes and scatter them to their ranks;
+                                requires node communicators to be attached,
+                                see \ref sc_mpi_comm_attach_node_comms */
   SC_NOTIFY_NUM_TYPES
 }
 sc_notify_type_t;
@@ -64,12 +76,32 @@ sc_notify_type_t;
 #define SC_NOTIFY_STR_NBX "nbx"
 #define SC_NOTIFY_STR_RANGES "ranges"
 #define SC_NOTIFY_STR_SUPERSET "superset"
+#define SC_NOTIFY_STR_HIER "hier"
+#define SC_NOTIFY_STR_AUTO "auto"
+
+/** Message size regimes tuned separately by SC_NOTIFY_AUTO */
+typedef enum
+{
+  SC_NOTIFY_REGIME_NONE = 0,  /**< no payload or above eager threshold */
+  SC_NOTIFY_REGIME_SMALL,     /**< payload of at most
+                                   SC_NOTIFY_AUTO_SMALL bytes */
+  SC_NOTIFY_REGIME_EAGER,     /**< larger payload up to eager threshold */
+  SC_NOTIFY_REGIME_VARIABLE,  /**< variable size payload */
+  SC_NOTIFY_NUM_REGIMES
+}
+sc_notify_regime_t;
+
+/** Largest payload in bytes of the regime SC_NOTIFY_REGIME_SMALL */
+#define SC_NOTIFY_AUTO_SMALL 64
+
+/** Names for each message size regime */
+extern const char  *sc_notify_regime_strings[SC_NOTIFY_NUM_REGIMES];
 
 /** Names for each notify method */
 extern const char  *sc_notify_type_strings[SC_NOTIFY_NUM_TYPES];
 
 /** The default type used when constructing a notify controller.  Initialized
- * to SC_NOTIFY_NARY */
+ * to SC_NOTIFY_NARY.  May be set to SC_NOTIFY_AUTO. */
 extern sc_notify_type_t sc_notify_type_default;
 
 /** The default threshold for payload sizes (in bytes) that are communicated
@@ -102,6 +134,9 @@ size_t              sc_notify_get_eager_threshold (sc_notify_t * notify);
 
 /** Get the payload size above which payloads are no longer transferred with
  * notification packets in sc_notify_payload().
+ * For the nary and hier types, sc_notify_payloadv() also carries the
+ * messages with the notification if the largest message on any process,
+ * plus an int for its length, fits into this threshold.
  *
  * \param[in,out] notify      The notify controller.
  * \param[in]     thresh      The size in bytes of the maximum eager payload
@@ -159,6 +194,60 @@ int                 sc_notify_set_type (sc_notify_t * notify,
 
 /* TODO: sc_notify_supports_type() */
 
+/** Default number of timed calls per candidate algorithm and message size
+ * regime of a notify controller of type SC_NOTIFY_AUTO; initialized to 2 */
+extern int          sc_notify_auto_trials_default;
+
+/** For a notify of type SC_NOTIFY_AUTO, get the algorithm chosen for a
+ * message size regime.
+ *
+ * A controller of type SC_NOTIFY_AUTO tunes itself lazily: the first calls
+ * in each regime cycle through the algorithms that work without further
+ * configuration, each for sc_notify_auto_trials_default calls.  The call
+ * times are maximized over the communicator.  Afterwards the fastest one
+ * is used.  If statistics are set by sc_notify_set_stats, the decision adds
+ * the variables "sc_notify_auto:regime:type" with the average time of each
+ * candidate and "sc_notify_auto:regime" with the chosen type.
+ *
+ * \param[in] notify  The notify controller.
+ * \param[in] regime  Message size regime.
+ * \return            The chosen type or SC_NOTIFY_AUTO while tuning.
+ */
+sc_notify_type_t    sc_notify_auto_get_type (sc_notify_t * notify,
+                                             sc_notify_regime_t regime);
+
+/** Query whether SC_NOTIFY_AUTO considers a type.
+ * Only the candidate types may appear in a file for sc_notify_auto_load.
+ * Which types are candidates depends on the MPI version.
+ * \param[in] type    Any notify type.
+ * eturn            True if  type is a candidate of the tuning.
+ */
+int                 sc_notify_auto_is_candidate (sc_notify_type_t type);
+
+/** For a notify of type SC_NOTIFY_AUTO, write the decided regimes to a file.
+ * This function is collective and only the first rank writes.
+ *
+ * \param[in] notify   The notify controller.
+ * \param[in] filename Name of the file to write.
+ * \return             0 on success and -1 if the file could not be written.
+ */
+int                 sc_notify_auto_save (sc_notify_t * notify,
+                                         const char *filename);
+
+/** For a notify of type SC_NOTIFY_AUTO, read decisions for the regimes
+ * from a file written by sc_notify_auto_save.  This skips the tuning
+ * for these regimes.  The file is ignored if it was written for a
+ * different communicator size or with an unsupported type.
+ * This function is collective and only the first rank reads.
+ *
+ * \param[in,out] notify   The notify controller.
+ * \param[in] filename     Name of the file to read.
+ * \return                 The number of regimes read or -1 if the file
+ *                         could not be used.
+ */
+int                 sc_notify_auto_load (sc_notify_t * notify,
+                                         const char *filename);
+
 /** Default number of children at root node of nary tree; initialized to 2 */
 extern int          sc_notify_nary_ntop_default;
 
@@ -349,6 +438,162 @@ void                sc_notify_payloadv (sc_array_t * receivers,
                                         sc_array_t * in_offsets,
                                         int sorted, sc_notify_t * notify);
 
+/** One contiguous piece of memory sent by \ref sc_notify_payloadv_segments.
+ */
+typedef struct sc_notify_segment
+{
+  const void         *data;     /**< start of the piece, not copied */
+  size_t              bytes;    /**< length of the piece in bytes */
+}
+sc_notify_segment_t;
+
+/** Provide the destination memory for a message of known size.
+ * \param[in] sender   Rank of the sending process.
+ * \param[in] bytes    Size of the message; may be zero.
+ * \param[in] user     User context passed through.
+ * \return             Memory of at least \b bytes bytes that remains
+ *                     valid until the message is completed.
+ */
+typedef void       *(*sc_notify_recv_buffer_t) (int sender, size_t bytes,
+                                                void *user);
+
+/** Announce that a message has arrived in its destination memory.
+ * \param[in] sender   Rank of the sending process.
+ * \param[in] buffer   Memory returned by the \ref sc_notify_recv_buffer_t.
+ * \param[in] bytes    Size of the message.
+ * \param[in] user     User context passed through.
+ */
+typedef void        (*sc_notify_recv_done_t) (int sender, void *buffer,
+                                              size_t bytes, void *user);
+
+/** Collective call to notify a set of receiver ranks of current rank
+ * and send each receiver a variable size message straight from user memory.
+ * The message to a receiver is the concatenation of a list of segments.
+ * Messages are not copied into internal buffers: the sizes are exchanged by
+ * \ref sc_notify_payload, then the segments are sent directly using
+ * a derived datatype, and every message is received into memory returned
+ * by \b recv_buffer.  Messages to the own rank are copied once.
+ * This function aborts on MPI error.
+ * \param [in] receivers        Sorted and uniqued array of type int.
+ * \param [in,out] senders      Array of type int that must not be a view.
+ *                              On output, it contains the sending ranks,
+ *                              in the order that \b recv_buffer was called.
+ * \param [in] segments         Segments for all receivers in order.
+ * \param [in] seg_offsets      Array of \b receivers->elem_count + 1 ints.
+ *                              The message to receiver i is made of the
+ *                              segments seg_offsets[i] to
+ *                              seg_offsets[i + 1] - 1.
+ * \param [in] recv_buffer      Called once per sender before receiving.
+ * \param [in] recv_done        If not NULL, called once per sender as
+ *                              soon as its message has arrived.
+ * \param [in] user             Passed to the callbacks.
+ * \param [in] sorted           Whether \b senders are required to be
+ *                              sorted by MPI rank.
+ * \param [in] notify           Notify controller to determine the senders.
+ */
+void                sc_notify_payloadv_segments (sc_array_t * receivers,
+                                                 sc_array_t * senders,
+                                                 const sc_notify_segment_t *
+                                                 segments,
+                                                 const int *seg_offsets,
+                                                 sc_notify_recv_buffer_t
+                                                 recv_buffer,
+                                                 sc_notify_recv_done_t
+                                                 recv_done, void *user,
+                                                 int sorted,
+                                                 sc_notify_t * notify);
+
+/** Start a collective notification that completes in the background.
+ * The parameters are as for \ref sc_notify_payload and all arrays must
+ * remain alive and untouched until \ref sc_notify_end returns.
+ * The results are valid only after \ref sc_notify_end.
+ * The types SC_NOTIFY_NBX and, with MPI-3, SC_NOTIFY_PCX progress with
+ * non-blocking communication.  Every other type runs its algorithm in this
+ * call, such that the request is already complete.
+ * At most one request may be in progress on a communicator at a time,
+ * and consecutive requests on a communicator use the same controller.
+ * \return             Request to pass to \ref sc_notify_test and
+ *                     \ref sc_notify_end.
+ */
+sc_notify_request_t *sc_notify_begin (sc_array_t * receivers,
+                                      sc_array_t * senders,
+                                      sc_array_t * in_payload,
+                                      sc_array_t * out_payload,
+                                      int sorted, sc_notify_t * notify);
+
+/** Progress a notification without blocking.
+ * \param[in,out] request  Request returned by \ref sc_notify_begin.
+ * \return                 True if the notification has completed.
+ *                         Then \ref sc_notify_end will not block.
+ */
+int                 sc_notify_test (sc_notify_request_t * request);
+
+/** Wait for a notification to complete and place its results.
+ * \param[in] request  Request returned by \ref sc_notify_begin;
+ *                     it is destroyed.
+ */
+void                sc_notify_end (sc_notify_request_t * request);
+
+/** Create a plan that caches the senders found by a notify controller.
+ * A plan is meant for repeated notification with a pattern of receivers
+ * that changes rarely.  Each call to \ref sc_notify_plan_payload or
+ * \ref sc_notify_plan_payloadv compares the receivers, and the message
+ * sizes where applicable, with those of the previous call.  One allreduce
+ * of a single integer establishes whether the plan is valid on all ranks.
+ * If so, the cached senders are used and only the payload is exchanged
+ * point-to-point.  Otherwise the notify controller runs its algorithm and
+ * the plan is updated.  If the controller has statistics set, the variable
+ * "sc_notify_plan_hit" accumulates 1 for a hit and 0 for a miss, such
+ * that its average is the hit rate.
+ *
+ * \param[in] notify    The notify controller to use on a plan miss.
+ *                      It must remain alive while the plan is used.
+ * \return              Plan to destroy with \ref sc_notify_plan_destroy.
+ */
+sc_notify_plan_t   *sc_notify_plan_new (sc_notify_t * notify);
+
+/** Destroy a plan created with \ref sc_notify_plan_new.
+ *
+ * \param[in,out] plan  This plan is destroyed.
+ */
+void                sc_notify_plan_destroy (sc_notify_plan_t * plan);
+
+/** Return the number of plan hits and misses so far.
+ *
+ * \param[in] plan      The plan.
+ * \param[out] hits     If not NULL, number of calls that used the cache.
+ * \param[out] misses   If not NULL, number of calls that ran the notify.
+ */
+void                sc_notify_plan_get_counts (sc_notify_plan_t * plan,
+                                               long *hits, long *misses);
+
+/** Collective call equivalent to \ref sc_notify_payload with the plan's
+ * notify controller that reuses the cached senders when it is valid.
+ * The parameters are as for \ref sc_notify_payload.
+ * The plan also becomes invalid when the payload element size changes.
+ */
+void                sc_notify_plan_payload (sc_notify_plan_t * plan,
+                                            sc_array_t * receivers,
+                                            sc_array_t * senders,
+                                            sc_array_t * in_payload,
+                                            sc_array_t * out_payload,
+                                            int sorted);
+
+/** Collective call equivalent to \ref sc_notify_payloadv with the plan's
+ * notify controller that reuses the cached senders when it is valid.
+ * The parameters are as for \ref sc_notify_payloadv.
+ * If only the message sizes change, the plan exchanges the new sizes
+ * point-to-point and counts as a hit.
+ */
+void                sc_notify_plan_payloadv (sc_notify_plan_t * plan,
+                                             sc_array_t * receivers,
+                                             sc_array_t * senders,
+                                             sc_array_t * in_payload,
+                                             sc_array_t * out_payload,
+                                             sc_array_t * in_offsets,
+                                             sc_array_t * out_offsets,
+                                             int sorted);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_NOTIFY_H */
@@ -25,6 +25,7 @@
 #include <sc_options.h>
 #include <iniparser.h>
 
+#include <ctype.h>
 #include <errno.h>
 
 typedef enum
@@ -76,16 +77,11 @@ static const int    sc_options_space_type = 20;
 static const int    sc_options_space_help = 32;
 
 static int
-sc_iniparser_getint (dictionary * d, const char *key, int notfound,
-                     int *iserror)
+sc_options_string_getint (const char *str, int *iserror)
 {
-  char               *str;
   long                l;
 
-  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
-  if (str == sc_iniparser_invalid_key) {
-    return notfound;
-  }
+  errno = 0;
   l = strtol (str, NULL, 0);
   if (iserror != NULL) {
     *iserror = (errno == ERANGE);
@@ -106,16 +102,11 @@ sc_iniparser_getint (dictionary * d, const char *key, int notfound,
 }
 
 static              size_t
-sc_iniparser_getsizet (dictionary * d, const char *key, size_t notfound,
-                       int *iserror)
+sc_options_string_getsizet (const char *str, int *iserror)
 {
-  char               *str;
   long long           ll;
 
-  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
-  if (str == sc_iniparser_invalid_key) {
-    return notfound;
-  }
+  errno = 0;
 #ifndef SC_HAVE_STRTOLL
   ll = (long long) strtol (str, NULL, 0);
 #else
@@ -134,16 +125,11 @@ sc_iniparser_getsizet (dictionary * d, const char *key, size_t notfound,
 }
 
 static double
-sc_iniparser_getdouble (dictionary * d, const char *key, double notfound,
-                        int *iserror)
+sc_options_string_getdouble (const char *str, int *iserror)
 {
-  char               *str;
   double              dbl;
 
-  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
-  if (str == sc_iniparser_invalid_key) {
-    return notfound;
-  }
+  errno = 0;
   dbl = strtod (str, NULL);
   if (iserror != NULL) {
     *iserror = (errno == ERANGE);
@@ -151,6 +137,134 @@ sc_iniparser_getdouble (dictionary * d, const char *key, double notfound,
   return dbl;
 }
 
+/** Interpret a string as boolean the same way as iniparser_getboolean. */
+static int
+sc_options_string_getboolean (const char *str, int notfound)
+{
+  switch (str[0]) {
+  case 'y':
+  case 'Y':
+  case '1':
+  case 't':
+  case 'T':
+    return 1;
+  case 'n':
+  case 'N':
+  case '0':
+  case 'f':
+  case 'F':
+    return 0;
+  default:
+    return notfound;
+  }
+}
+
+static int
+sc_iniparser_getint (dictionary * d, const char *key, int notfound,
+                     int *iserror)
+{
+  char               *str;
+
+  str = iniparser_getstring (d, key, sc_iniparser_invalid_key);
+  if (str == sc_iniparser_invalid_key) {
+    return notfound;
+  }
+  return sc_options_string_getint (str, iserror);
+}
+
+/** Hash all key-value entries of an ini dictionary.
+ * Section entries without a value are skipped.
+ * Keys and values are borrowed from the dictionary.
+ */
+static sc_keyvalue_t *
+sc_options_index_dict (dictionary * dict)
+{
+  int                 i;
+  sc_keyvalue_t      *index;
+
+  index = sc_keyvalue_new ();
+  for (i = 0; i < dict->size; ++i) {
+    if (dict->key[i] != NULL && dict->val[i] != NULL) {
+      sc_keyvalue_set_pointer (index, dict->key[i], dict->val[i]);
+    }
+  }
+  return index;
+}
+
+/** Hash the entries of a buffer of alternating keys and values.
+ * \param [in] buffer  Concatenation of null-terminated strings.
+ * \param [in] bytes   Length of the buffer, including the last null.
+ * \return             Index borrowing its keys and values from \a buffer.
+ */
+static sc_keyvalue_t *
+sc_options_index_buffer (const char *buffer, size_t bytes)
+{
+  const char         *pos, *end, *key;
+  sc_keyvalue_t      *index;
+
+  index = sc_keyvalue_new ();
+  pos = buffer;
+  end = buffer + bytes;
+  while (pos < end) {
+    key = pos;
+    pos += strlen (pos) + 1;
+    SC_ASSERT (pos < end);
+    sc_keyvalue_set_pointer (index, key, (void *) pos);
+    pos += strlen (pos) + 1;
+  }
+  SC_ASSERT (pos == end);
+  return index;
+}
+
+/** Serialize the key-value entries of an ini dictionary.
+ * \return             Newly allocated buffer to free with SC_FREE.
+ */
+static char        *
+sc_options_serialize_dict (dictionary * dict, size_t *bytes)
+{
+  int                 i;
+  size_t              total, kl, vl;
+  char               *buffer, *pos;
+
+  total = 0;
+  for (i = 0; i < dict->size; ++i) {
+    if (dict->key[i] != NULL && dict->val[i] != NULL) {
+      total += strlen (dict->key[i]) + strlen (dict->val[i]) + 2;
+    }
+  }
+  buffer = pos = SC_ALLOC (char, SC_MAX (total, 1));
+  for (i = 0; i < dict->size; ++i) {
+    if (dict->key[i] != NULL && dict->val[i] != NULL) {
+      kl = strlen (dict->key[i]) + 1;
+      vl = strlen (dict->val[i]) + 1;
+      memcpy (pos, dict->key[i], kl);
+      memcpy (pos + kl, dict->val[i], vl);
+      pos += kl + vl;
+    }
+  }
+  SC_ASSERT ((size_t) (pos - buffer) == total);
+  *bytes = total;
+  return buffer;
+}
+
+/** Look up a key in an index case-insensitively like iniparser does.
+ * \return             The value or NULL if the key does not exist.
+ */
+static const char  *
+sc_options_index_get (sc_keyvalue_t * index, const char *key)
+{
+  size_t              z;
+  char                lkey[BUFSIZ];
+  sc_keyvalue_handle_t *h;
+
+  for (z = 0; z + 1 < BUFSIZ && key[z] != '\0'; ++z) {
+    lkey[z] = (char) tolower ((int) key[z]);
+  }
+  lkey[z] = '\0';
+  h = sc_keyvalue_lookup_handle (index, lkey);
+  return h == NULL ? NULL : (const char *) sc_keyvalue_handle_get_pointer (h);
+}
+
 static void
 sc_options_free_args (sc_options_t * opt)
 {
@@ -763,31 +877,28 @@ sc_options_print_summary (int package_id, int log_priority,
   }
 }
 
-int
-sc_options_load (int package_id, int err_priority,
-                 sc_options_t * opt, const char *inifile)
+/** Update the options from an index of ini entries.
+ * \param [in] index   Maps lowercase "section:key" to value strings.
+ * \param [in] inifile Name of the file, only used for error messages.
+ */
+static int
+sc_options_load_index (int package_id, int err_priority,
+                       sc_options_t * opt, sc_keyvalue_t * index,
+                       const char *inifile)
 {
   int                 found_short, found_long;
   size_t              iz;
   sc_array_t         *items = opt->option_items;
   size_t              count = items->elem_count;
   sc_option_item_t   *item;
-  dictionary         *dict;
   int                 iserror;
   int                 bvalue;
   int                *ivalue;
   double             *dvalue;
   size_t             *zvalue;
-  const char         *s, *key;
+  const char         *s, *key, *sval, *lval;
   char                skey[BUFSIZ], lkey[BUFSIZ];
 
-  dict = iniparser_load (inifile);
-  if (dict == NULL) {
-    SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
-                "Could not load or parse inifile\n");
-    return -1;
-  }
-
   for (iz = 0; iz < count; ++iz) {
     item = (sc_option_item_t *) sc_array_index (items, iz);
     if (item->opt_type == SC_OPTION_INIFILE ||
@@ -797,10 +908,10 @@ sc_options_load (int package_id, int err_priority,
 
     key = NULL;
     skey[0] = lkey[0] = '\0';
-    found_short = found_long = 0;
+    sval = lval = NULL;
     if (item->opt_char != '\0') {
       snprintf (skey, BUFSIZ, "Options:-%c", item->opt_char);
-      found_short = iniparser_find_entry (dict, skey);
+      sval = sc_options_index_get (index, skey);
     }
     if (item->opt_name != NULL) {
       /* if the name contains a section prefix, don't add "Options:" */
@@ -811,19 +922,22 @@ sc_options_load (int package_id, int err_priority,
       else {
         snprintf (lkey, BUFSIZ, "Options:%s", item->opt_name);
       }
-      found_long = iniparser_find_entry (dict, lkey);
+      lval = sc_options_index_get (index, lkey);
     }
+    found_short = (sval != NULL);
+    found_long = (lval != NULL);
     if (found_short && found_long) {
       SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                    "Duplicates %s %s in file: %s\n", skey, lkey, inifile);
-      iniparser_freedict (dict);
       return -1;
     }
     else if (found_long) {
       key = lkey;
+      s = lval;
     }
     else if (found_short) {
       key = skey;
+      s = sval;
     }
     else {
       continue;
@@ -832,64 +946,56 @@ sc_options_load (int package_id, int err_priority,
     ++item->called;
     switch (item->opt_type) {
     case SC_OPTION_SWITCH:
-      bvalue = iniparser_getboolean (dict, key, -1);
+      bvalue = sc_options_string_getboolean (s, -1);
       if (bvalue == -1) {
-        bvalue = sc_iniparser_getint (dict, key, 0, &iserror);
+        bvalue = sc_options_string_getint (s, &iserror);
         if (bvalue <= 0 || iserror) {
           SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                        "Invalid switch %s in file: %s\n", key, inifile);
-          iniparser_freedict (dict);
           return -1;
         }
       }
       *(int *) item->opt_var = bvalue;
       break;
     case SC_OPTION_BOOL:
-      bvalue = iniparser_getboolean (dict, key, -1);
+      bvalue = sc_options_string_getboolean (s, -1);
       if (bvalue == -1) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid boolean %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
         return -1;
       }
       *(int *) item->opt_var = bvalue;
       break;
     case SC_OPTION_INT:
       ivalue = (int *) item->opt_var;
-      *ivalue = sc_iniparser_getint (dict, key, *ivalue, &iserror);
+      *ivalue = sc_options_string_getint (s, &iserror);
       if (iserror) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid int %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
         return -1;
       }
       break;
     case SC_OPTION_SIZE_T:
       zvalue = (size_t *) item->opt_var;
-      *zvalue = sc_iniparser_getsizet (dict, key, *zvalue, &iserror);
+      *zvalue = sc_options_string_getsizet (s, &iserror);
       if (iserror) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid size_t %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
         return -1;
       }
       break;
     case SC_OPTION_DOUBLE:
       dvalue = (double *) item->opt_var;
-      *dvalue = sc_iniparser_getdouble (dict, key, *dvalue, &iserror);
+      *dvalue = sc_options_string_getdouble (s, &iserror);
       if (iserror) {
         SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
                      "Invalid double %s in file: %s\n", key, inifile);
-        iniparser_freedict (dict);
         return -1;
       }
       break;
     case SC_OPTION_STRING:
-      s = iniparser_getstring (dict, key, NULL);
-      if (s != NULL) {
-        SC_FREE (item->string_value);   /* deals with NULL */
-        *(const char **) item->opt_var = item->string_value = SC_STRDUP (s);
-      }
+      SC_FREE (item->string_value);     /* deals with NULL */
+      *(const char **) item->opt_var = item->string_value = SC_STRDUP (s);
       break;
 #if 0
     case SC_OPTION_CALLBACK:
@@ -916,33 +1022,115 @@ sc_options_load (int package_id, int err_priority,
 #endif
     case SC_OPTION_KEYVALUE:
       SC_ASSERT (item->string_value != NULL);
-      s = iniparser_getstring (dict, key, NULL);
-      if (s != NULL) {
-        /* lookup the key and see if the result is valid */
-        iserror = *(ivalue = (int *) item->opt_var);
-        *ivalue = sc_keyvalue_get_int_check ((sc_keyvalue_t *)
-                                             item->user_data, s, &iserror);
-        if (iserror) {
-          /* key not found or of the wrong type; this cannot be ignored */
-          SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
-                       "Invalid key %s for option %s in file: %s\n",
-                       s, key, inifile);
-          iniparser_freedict (dict);
-          return -1;
-        }
-        SC_FREE (item->string_value);
-        item->string_value = SC_STRDUP (s);
+      /* lookup the key and see if the result is valid */
+      iserror = *(ivalue = (int *) item->opt_var);
+      *ivalue = sc_keyvalue_get_int_check ((sc_keyvalue_t *)
+                                           item->user_data, s, &iserror);
+      if (iserror) {
+        /* key not found or of the wrong type; this cannot be ignored */
+        SC_GEN_LOGF (package_id, SC_LC_GLOBAL, err_priority,
+                     "Invalid key %s for option %s in file: %s\n",
+                     s, key, inifile);
+        return -1;
       }
+      SC_FREE (item->string_value);
+      item->string_value = SC_STRDUP (s);
       break;
     default:
       SC_ABORT_NOT_REACHED ();
     }
   }
 
-  iniparser_freedict (dict);
   return 0;
 }
 
+int
+sc_options_load (int package_id, int err_priority,
+                 sc_options_t * opt, const char *inifile)
+{
+  int                 retval;
+  dictionary         *dict;
+  sc_keyvalue_t      *index;
+
+  dict = iniparser_load (inifile);
+  if (dict == NULL) {
+    SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
+                "Could not load or parse inifile\n");
+    return -1;
+  }
+
+  index = sc_options_index_dict (dict);
+  retval = sc_options_load_index (package_id, err_priority,
+                                  opt, index, inifile);
+  sc_keyvalue_destroy (index);
+  iniparser_freedict (dict);
+
+  return retval;
+}
+
+int
+sc_options_load_bcast (int package_id, int err_priority,
+                       sc_options_t * opt, const char *inifile,
+                       sc_MPI_Comm mpicomm, int root)
+{
+  int                 mpiret;
+  int                 rank;
+  int                 retval;
+  long                lbytes;
+  size_t              bytes;
+  char               *buffer;
+  dictionary         *dict;
+  sc_keyvalue_t      *index;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* only the root touches the file system */
+  buffer = NULL;
+  lbytes = -1;
+  if (rank == root) {
+    dict = iniparser_load (inifile);
+    if (dict != NULL) {
+      buffer = sc_options_serialize_dict (dict, &bytes);
+      iniparser_freedict (dict);
+
+      /* the contents are broadcast with a single int count */
+      if (bytes <= (size_t) INT_MAX) {
+        lbytes = (long) bytes;
+      }
+      else {
+        SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
+                    "Inifile contents too large to broadcast\n");
+        SC_FREE (buffer);
+      }
+    }
+  }
+  mpiret = sc_MPI_Bcast (&lbytes, 1, sc_MPI_LONG, root, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (lbytes < 0) {
+    SC_GEN_LOG (package_id, SC_LC_GLOBAL, err_priority,
+                "Could not load or parse inifile\n");
+    return -1;
+  }
+
+  /* every rank indexes the same compact table of entries */
+  bytes = (size_t) lbytes;
+  if (rank != root) {
+    buffer = SC_ALLOC (char, SC_MAX (bytes, 1));
+  }
+  if (bytes > 0) {
+    mpiret = sc_MPI_Bcast (buffer, (int) bytes, sc_MPI_CHAR, root, mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  index = sc_options_index_buffer (buffer, bytes);
+  retval = sc_options_load_index (package_id, err_priority,
+                                  opt, index, inifile);
+  sc_keyvalue_destroy (index);
+  SC_FREE (buffer);
+
+  return retval;
+}
+
 int
 sc_options_save (int package_id, int err_priority,
                  sc_options_t * opt, const char *inifile)
@@ -295,6 +295,27 @@ void                sc_options_print_summary (int package_id,
 int                 sc_options_load (int package_id, int err_priority,
                                      sc_options_t * opt, const char *inifile);
 
+/** Load a file in .ini format on one rank and update the options on all.
+ * Only the \a root rank reads the file.  It broadcasts the entries as one
+ * compact buffer, and each rank updates its options as sc_options_load
+ * would.  This avoids many ranks reading the same file concurrently.
+ * This function is collective over \a mpicomm.
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] err_priority     Error log priority according to sc.h.
+ * \param [in] opt              The option structure.
+ * \param [in] inifile          Filename of the ini file to load.
+ *                              Only accessed on the root rank.
+ * \param [in] mpicomm          Communicator of all ranks loading the file.
+ * \param [in] root             The rank that reads the file.
+ * \return                      Returns 0 on success, -1 on failure.
+ *                              Failure to read the file is reported on
+ *                              all ranks.
+ */
+int                 sc_options_load_bcast (int package_id, int err_priority,
+                                           sc_options_t * opt,
+                                           const char *inifile,
+                                           sc_MPI_Comm mpicomm, int root);
+
 /** Save all options and arguments to a file in .ini format.
  * This function must only be called after successful option parsing.
  * This function should only be called on rank 0.
@@ -0,0 +1,116 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_partition.h>
+
+/** The weight prefix where rank q begins. */
+static double
+sc_partition_cut (double total, int q, int mpisize)
+{
+  return total * q / mpisize;
+}
+
+/** Find the first position k in [lo, n] with prefix[k] >= cut. */
+static size_t
+sc_partition_lower_bound (const double *prefix, size_t lo, size_t n,
+                          double cut)
+{
+  size_t              hi = n, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (prefix[mid] < cut) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+double
+sc_partition_weights (sc_MPI_Comm mpicomm, size_t num_local,
+                      const double *weights, size_t *send_counts)
+{
+  int                 mpiret;
+  int                 mpisize, mpirank, q;
+  size_t              zz, first, next;
+  double              local, offset, total;
+  double             *prefix;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* local sum of the weights */
+  if (weights == NULL) {
+    local = (double) num_local;
+  }
+  else {
+    local = 0.;
+    for (zz = 0; zz < num_local; ++zz) {
+      SC_ASSERT (weights[zz] >= 0.);
+      local += weights[zz];
+    }
+  }
+
+  /* the last rank knows the total and shares the identical value */
+  offset = 0.;
+  mpiret = sc_MPI_Exscan (&local, &offset, 1, sc_MPI_DOUBLE, sc_MPI_SUM,
+                          mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    offset = 0.;
+  }
+  total = offset + local;
+  mpiret = sc_MPI_Bcast (&total, 1, sc_MPI_DOUBLE, mpisize - 1, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* exclusive prefix of every local element */
+  prefix = SC_ALLOC (double, num_local + 1);
+  prefix[0] = offset;
+  for (zz = 0; zz < num_local; ++zz) {
+    prefix[zz + 1] = prefix[zz] + (weights == NULL ? 1. : weights[zz]);
+  }
+
+  /* element k goes to the last rank whose cut is at most prefix[k] */
+  first = 0;
+  for (q = 0; q < mpisize; ++q) {
+    if (q + 1 == mpisize) {
+      next = num_local;
+    }
+    else {
+      next = sc_partition_lower_bound
+        (prefix, first, num_local,
+         sc_partition_cut (total, q + 1, mpisize));
+    }
+    send_counts[q] = next - first;
+    first = next;
+  }
+  SC_ASSERT (first == num_local);
+  SC_FREE (prefix);
+
+  return total;
+}
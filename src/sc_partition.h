@@ -0,0 +1,61 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_PARTITION_H
+#define SC_PARTITION_H
+
+/** \file sc_partition.h
+ * Partition a distributed sequence of weighted elements.
+ *
+ * The elements keep their global order.  Rank q of P receives the
+ * elements whose global exclusive weight prefix lies in
+ * [W * q / P, W * (q + 1) / P), where W is the global sum of weights.
+ * The result are the numbers of local elements to send to each rank,
+ * ready for an all-to-all exchange of the element data.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Compute the send counts to repartition elements by weight.
+ * This function is collective and uses one MPI_Exscan and one broadcast.
+ * The local cut positions are found by one binary search per destination
+ * that narrows from the previous result.
+ * \param [in] mpicomm      Communicator of the partition.
+ * \param [in] num_local    Number of local elements.
+ * \param [in] weights      Non-negative weight of each local element,
+ *                          or NULL to weight all elements equally.
+ * \param [out] send_counts Array of mpisize entries: the number of
+ *                          consecutive local elements to send to each
+ *                          rank.  The counts sum to \a num_local.
+ * \return                  The global sum of weights.
+ */
+double              sc_partition_weights (sc_MPI_Comm mpicomm,
+                                          size_t num_local,
+                                          const double *weights,
+                                          size_t *send_counts);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PARTITION_H */
@@ -57,7 +57,7 @@ sc_polynom_is_valid (const sc_polynom_t * p)
   }
 #ifdef SC_ENABLE_DEBUG
   for (i = p->degree + 1; i < (int) p->c->elem_count; ++i) {
-    if (*sc_polynom_coefficient_const (p, i) != -1.) {
+    if (((const double *) p->c->array)[i] != -1.) {
       return 0;
     }
   }
@@ -269,18 +269,22 @@ void
 sc_polynom_set_degree (sc_polynom_t * p, int degree)
 {
   int                 i;
+  double             *c;
 
   SC_ASSERT (sc_polynom_is_valid (p));
   SC_ASSERT (degree >= 0);
 
+  /* the accessors would refuse indices beyond the current degree */
 #ifdef SC_ENABLE_DEBUG
+  c = (double *) p->c->array;
   for (i = degree; i < p->degree; ++i) {
-    *sc_polynom_coefficient (p, i + 1) = -1.;
+    c[i + 1] = -1.;
   }
 #endif
   sc_array_resize (p->c, (size_t) degree + 1);
+  c = (double *) p->c->array;
   for (i = p->degree; i < degree; ++i) {
-    *sc_polynom_coefficient (p, i + 1) = 0.;
+    c[i + 1] = 0.;
   }
   p->degree = degree;
 
@@ -381,11 +385,71 @@ sc_polynom_AXPY (double A, const sc_polynom_t * X, sc_polynom_t * Y)
 void
 sc_polynom_multiply (sc_polynom_t * p, const sc_polynom_t * q)
 {
+  int                 degree, pdegree;
+  int                 i, j, k;
+  double              sum, *pc;
+  const double       *qc;
   sc_polynom_t       *prod;
 
-  prod = sc_polynom_new_from_product (p, q);
-  sc_polynom_set_polynom (p, prod);
-  sc_polynom_destroy (prod);
+  SC_ASSERT (sc_polynom_is_valid (p));
+  SC_ASSERT (sc_polynom_is_valid (q));
+
+  if (p == q) {
+    prod = sc_polynom_new_from_product (p, q);
+    sc_polynom_set_polynom (p, prod);
+    sc_polynom_destroy (prod);
+    return;
+  }
+
+  /* coefficient i of the product needs coefficients j <= i of p only,
+     so we compute it in place from the highest degree down */
+  pdegree = p->degree;
+  sc_polynom_set_degree (p, degree = pdegree + q->degree);
+  pc = (double *) p->c->array;
+  qc = (const double *) q->c->array;
+  for (i = degree; i >= 0; --i) {
+    sum = 0.;
+    k = SC_MIN (i, pdegree);
+    for (j = SC_MAX (0, i - q->degree); j <= k; ++j) {
+      sum += pc[j] * qc[i - j];
+    }
+    pc[i] = sum;
+  }
+
+  SC_ASSERT (sc_polynom_is_valid (p));
+}
+
+void
+sc_polynom_set_sum (sc_polynom_t * p,
+                    const sc_polynom_t * q, const sc_polynom_t * r)
+{
+  const sc_polynom_t *swap;
+
+  if (p == r) {
+    swap = q;
+    q = r;
+    r = swap;
+  }
+  if (p != q) {
+    sc_polynom_set_polynom (p, q);
+  }
+  sc_polynom_AXPY (1., r, p);
+}
+
+void
+sc_polynom_set_product (sc_polynom_t * p,
+                        const sc_polynom_t * q, const sc_polynom_t * r)
+{
+  if (p == q) {
+    sc_polynom_multiply (p, r);
+  }
+  else if (p == r) {
+    sc_polynom_multiply (p, q);
+  }
+  else {
+    sc_polynom_set_polynom (p, q);
+    sc_polynom_multiply (p, r);
+  }
 }
 
 double
@@ -405,6 +469,88 @@ sc_polynom_eval (const sc_polynom_t * p, double x)
   return v;
 }
 
+/** Number of arguments per block in batched evaluation. */
+#define SC_POLYNOM_BATCH 256
+
+void
+sc_polynom_eval_batch (const sc_polynom_t * p, size_t num_x,
+                       const double *x, double *values)
+{
+  int                 i, deg;
+  size_t              zb, zz, nz;
+  double              ci, xb[SC_POLYNOM_BATCH], *vb;
+  const double       *c;
+
+  deg = sc_polynom_degree (p);
+  c = (const double *) p->c->array;
+
+  /* blocks keep the partial values in cache over all coefficients;
+     the arguments are copied since the values may overwrite them */
+  for (zb = 0; zb < num_x; zb += nz) {
+    nz = SC_MIN (num_x - zb, (size_t) SC_POLYNOM_BATCH);
+    memcpy (xb, x + zb, nz * sizeof (double));
+    vb = values + zb;
+    for (zz = 0; zz < nz; ++zz) {
+      vb[zz] = c[deg];
+    }
+    for (i = deg - 1; i >= 0; --i) {
+      ci = c[i];
+#ifdef SC_ENABLE_OPENMP
+#pragma omp simd
+#endif
+      for (zz = 0; zz < nz; ++zz) {
+        vb[zz] = xb[zz] * vb[zz] + ci;
+      }
+    }
+  }
+}
+
+void
+sc_polynom_eval_soa (int degree, size_t num_p,
+                     const double *coefficients,
+                     const double *x, double *values)
+{
+  int                 i;
+  size_t              zb, zz, nz;
+  double              xb[SC_POLYNOM_BATCH], *vb;
+  const double       *ci;
+
+  SC_ASSERT (degree >= 0);
+
+  for (zb = 0; zb < num_p; zb += nz) {
+    nz = SC_MIN (num_p - zb, (size_t) SC_POLYNOM_BATCH);
+    memcpy (xb, x + zb, nz * sizeof (double));
+    vb = values + zb;
+    memcpy (vb, coefficients + (size_t) degree * num_p + zb,
+            nz * sizeof (double));
+    for (i = degree - 1; i >= 0; --i) {
+      ci = coefficients + (size_t) i * num_p + zb;
+#ifdef SC_ENABLE_OPENMP
+#pragma omp simd
+#endif
+      for (zz = 0; zz < nz; ++zz) {
+        vb[zz] = xb[zz] * vb[zz] + ci[zz];
+      }
+    }
+  }
+}
+
+void
+sc_polynom_lagrange_table (int degree, const double *points,
+                           size_t num_x, const double *x, double *table)
+{
+  int                 i;
+  sc_polynom_t       *p;
+
+  SC_ASSERT (degree >= 0);
+
+  for (i = 0; i <= degree; ++i) {
+    p = sc_polynom_new_lagrange (degree, i, points);
+    sc_polynom_eval_batch (p, num_x, x, table + (size_t) i * num_x);
+    sc_polynom_destroy (p);
+  }
+}
+
 int
 sc_polynom_roots (const sc_polynom_t * p, double *roots)
 {
@@ -152,12 +152,33 @@ void                sc_polynom_AXPY (double A, const sc_polynom_t * X,
                                      sc_polynom_t * Y);
 
 /** Modify a polynom by multiplying another.
+ * The product is computed in the storage of p unless q is the same as p.
  * \param[in,out] p     The polynom p will be set to p * q.
  * \param[in] q         The polynom that is multiplied with p; not changed.
  */
 void                sc_polynom_multiply (sc_polynom_t * p,
                                          const sc_polynom_t * q);
 
+/** Set a polynom to the sum of two others, reusing its storage.
+ * \param[in,out] p     The polynom p will be set to q + r.
+ *                      It may be the same as q or r or both.
+ * \param[in] q         First summand.
+ * \param[in] r         Second summand.
+ */
+void                sc_polynom_set_sum (sc_polynom_t * p,
+                                        const sc_polynom_t * q,
+                                        const sc_polynom_t * r);
+
+/** Set a polynom to the product of two others, reusing its storage.
+ * \param[in,out] p     The polynom p will be set to q * r.
+ *                      It may be the same as q or r or both.
+ * \param[in] q         First factor.
+ * \param[in] r         Second factor.
+ */
+void                sc_polynom_set_product (sc_polynom_t * p,
+                                            const sc_polynom_t * q,
+                                            const sc_polynom_t * r);
+
 /***************** investigate properties of polynomials ****************/
 
 /** Evaluate a polynomial using Horner's scheme.
@@ -167,6 +188,47 @@ void                sc_polynom_multiply (sc_polynom_t * p,
  */
 double              sc_polynom_eval (const sc_polynom_t * p, double x);
 
+/** Evaluate a polynomial at many arguments.
+ * Horner's scheme runs over blocks of arguments with the arguments in
+ * the innermost loop, such that it may be vectorized.
+ * \param [in] p        Valid polynomial.
+ * \param [in] num_x    Number of arguments.
+ * \param [in] x        Array of \a num_x arguments.
+ * \param [out] values  Array of \a num_x values of p.  It may be \a x.
+ */
+void                sc_polynom_eval_batch (const sc_polynom_t * p,
+                                           size_t num_x, const double *x,
+                                           double *values);
+
+/** Evaluate many polynomials of equal degree given by raw coefficients.
+ * The coefficients are stored in structure-of-arrays layout: coefficient
+ * i of polynomial j is \a coefficients [i * \a num_p + j].
+ * \param [in] degree           Common degree of the polynomials, >= 0.
+ * \param [in] num_p            Number of polynomials.
+ * \param [in] coefficients     Array of (\a degree + 1) * \a num_p values.
+ * \param [in] x        Array of \a num_p arguments, one per polynomial.
+ * \param [out] values  Array of \a num_p values.  It may be \a x.
+ */
+void                sc_polynom_eval_soa (int degree, size_t num_p,
+                                         const double *coefficients,
+                                         const double *x, double *values);
+
+/** Tabulate all Lagrange basis polynomials at many arguments.
+ * The monomial coefficients of the basis are computed once by \ref
+ * sc_polynom_new_lagrange and evaluated by \ref sc_polynom_eval_batch.
+ * \param [in] degree   Must be non-negative.
+ * \param [in] points   A set of \a degree + 1 distinct values.
+ * \param [in] num_x    Number of arguments.
+ * \param [in] x        Array of \a num_x arguments.
+ * \param [out] table   Array of (\a degree + 1) * \a num_x values.
+ *                      The value of basis polynomial i at argument k
+ *                      is stored at \a table [i * \a num_x + k].
+ */
+void                sc_polynom_lagrange_table (int degree,
+                                               const double *points,
+                                               size_t num_x, const double *x,
+                                               double *table);
+
 /** Compute the roots of a polynomial up to quadratic degree.
  *
  * We use fuzzy criteria with threshold SC_1000_EPS, thus this function
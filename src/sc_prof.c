@@ -0,0 +1,428 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_prof.h>
+#include <sc_statistics.h>
+#include <sc_tracer.h>
+
+#if (defined SC_ENABLE_PTHREAD || defined SC_ENABLE_OPENMP) && \
+  defined __GNUC__ && defined __ATOMIC_RELAXED
+#define SC_PROF_THREAD_LOCAL
+#endif
+
+/** One node of the call tree of a thread. */
+typedef struct sc_prof_node
+{
+  const char         *name;
+  int                 parent;
+  int                 child;    /**< First nested region or -1. */
+  int                 sibling;  /**< Next region of the parent or -1. */
+  long                calls;
+  double              start;
+  double              inclusive;
+  double              children; /**< Inclusive time of nested regions. */
+  long long           start_flops;
+  long long           flops;
+}
+sc_prof_node_t;
+
+/** The call tree of one thread.  Node 0 is the root outside any region. */
+typedef struct sc_prof_thread
+{
+  sc_array_t          nodes;
+  int                 current;
+  struct sc_prof_thread *next;  /**< List of all threads. */
+}
+sc_prof_thread_t;
+
+/** The accumulated data of one path over the threads. */
+typedef struct sc_prof_path
+{
+  char               *path;
+  long                calls;
+  double              inclusive;
+  double              exclusive;
+  long long           flops;
+}
+sc_prof_path_t;
+
+/** All call trees of the threads, linked by their next member. */
+static sc_prof_thread_t *sc_prof_threads = NULL;
+
+/** Call trees of a previous generation are no longer valid. */
+static int          sc_prof_generation = 0;
+
+static int          sc_prof_papi = 0;
+
+#ifdef SC_PROF_THREAD_LOCAL
+static __thread sc_prof_thread_t *sc_prof_thread = NULL;
+static __thread int sc_prof_thread_generation = -1;
+#else
+static sc_prof_thread_t *sc_prof_thread = NULL;
+static int          sc_prof_thread_generation = -1;
+#endif
+
+/** Append a node to a call tree and return its index. */
+static int
+sc_prof_node_new (sc_prof_thread_t * pt, const char *name, int parent)
+{
+  int                 index = (int) pt->nodes.elem_count;
+  sc_prof_node_t     *node = (sc_prof_node_t *) sc_array_push (&pt->nodes);
+
+  memset (node, 0, sizeof (sc_prof_node_t));
+  node->name = name;
+  node->parent = parent;
+  node->child = node->sibling = -1;
+  return index;
+}
+
+/** Return the call tree of the calling thread and create it if needed. */
+static sc_prof_thread_t *
+sc_prof_thread_get (void)
+{
+  sc_prof_thread_t   *pt;
+
+  if (sc_prof_thread == NULL ||
+      sc_prof_thread_generation != sc_prof_generation) {
+    pt = SC_ALLOC (sc_prof_thread_t, 1);
+    sc_array_init (&pt->nodes, sizeof (sc_prof_node_t));
+    pt->current = sc_prof_node_new (pt, NULL, -1);
+
+    /* remember the call tree to report and destroy it */
+#ifdef SC_PROF_THREAD_LOCAL
+    pt->next = __atomic_load_n (&sc_prof_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n (&sc_prof_threads, &pt->next,
+                                         pt, 1, __ATOMIC_RELEASE,
+                                         __ATOMIC_RELAXED));
+#else
+    pt->next = sc_prof_threads;
+    sc_prof_threads = pt;
+#endif
+    sc_prof_thread = pt;
+    sc_prof_thread_generation = sc_prof_generation;
+  }
+  return sc_prof_thread;
+}
+
+/** Read the floating point operations if enabled. */
+static long long
+sc_prof_flops (void)
+{
+  float               rtime, ptime, mflops;
+  long long           flpops = 0;
+
+  if (sc_prof_papi) {
+    sc_flops_papi (&rtime, &ptime, &flpops, &mflops);
+  }
+  return flpops;
+}
+
+void
+sc_prof_begin (const char *name)
+{
+  int                 index;
+  sc_prof_thread_t   *pt = sc_prof_thread_get ();
+  sc_prof_node_t     *node;
+
+  SC_ASSERT (name != NULL);
+
+  /* find the region among the children of the current one */
+  node = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, pt->current);
+  for (index = node->child; index >= 0; index = node->sibling) {
+    node = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, index);
+    if (node->name == name || !strcmp (node->name, name)) {
+      break;
+    }
+  }
+  if (index < 0) {
+    index = sc_prof_node_new (pt, name, pt->current);
+    node = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, pt->current);
+    ((sc_prof_node_t *) sc_array_index_int (&pt->nodes, index))->sibling =
+      node->child;
+    node->child = index;
+    node = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, index);
+  }
+
+  pt->current = index;
+  sc_tracer_begin (name);
+  node->start_flops = sc_prof_flops ();
+  node->start = sc_MPI_Wtime ();
+}
+
+void
+sc_prof_end (void)
+{
+  double              elapsed;
+  sc_prof_thread_t   *pt = sc_prof_thread_get ();
+  sc_prof_node_t     *node, *parent;
+
+  SC_ASSERT (pt->current > 0);
+
+  node = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, pt->current);
+  elapsed = sc_MPI_Wtime () - node->start;
+  ++node->calls;
+  node->inclusive += elapsed;
+  node->flops += sc_prof_flops () - node->start_flops;
+
+  parent = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, node->parent);
+  parent->children += elapsed;
+  pt->current = node->parent;
+  sc_tracer_end (node->name);
+}
+
+void
+sc_prof_set_papi (int use_papi)
+{
+  sc_prof_papi = use_papi;
+}
+
+/** Append the paths of a subtree to an array of sc_prof_path_t. */
+static void
+sc_prof_collect_node (sc_prof_thread_t * pt, int index,
+                      const char *prefix, sc_array_t * paths)
+{
+  size_t              len;
+  sc_prof_node_t     *node;
+  sc_prof_path_t     *p;
+
+  for (; index >= 0; index = node->sibling) {
+    node = (sc_prof_node_t *) sc_array_index_int (&pt->nodes, index);
+    len = strlen (prefix) + strlen (node->name) + 2;
+
+    p = (sc_prof_path_t *) sc_array_push (paths);
+    p->path = SC_ALLOC (char, len);
+    snprintf (p->path, len, "%s%s%s", prefix, *prefix ? "/" : "",
+              node->name);
+    p->calls = node->calls;
+    p->inclusive = node->inclusive;
+    p->exclusive = node->inclusive - node->children;
+    p->flops = node->flops;
+
+    sc_prof_collect_node (pt, node->child, p->path, paths);
+  }
+}
+
+static int
+sc_prof_path_compare (const void *v1, const void *v2)
+{
+  return strcmp (((const sc_prof_path_t *) v1)->path,
+                 ((const sc_prof_path_t *) v2)->path);
+}
+
+/** Collect the paths of all threads, sorted and merged. */
+static void
+sc_prof_collect (sc_array_t * paths)
+{
+  size_t              zz, iz;
+  sc_prof_thread_t   *pt;
+  sc_prof_path_t     *p, *q;
+
+  sc_array_init (paths, sizeof (sc_prof_path_t));
+  for (pt = sc_prof_threads; pt != NULL; pt = pt->next) {
+    SC_ASSERT (pt->current == 0);
+    sc_prof_collect_node
+      (pt, ((sc_prof_node_t *) sc_array_index (&pt->nodes, 0))->child,
+       "", paths);
+  }
+  sc_array_sort (paths, sc_prof_path_compare);
+
+  /* merge the entries of the same path from different threads */
+  for (zz = iz = 0; zz < paths->elem_count; ++zz) {
+    p = (sc_prof_path_t *) sc_array_index (paths, zz);
+    if (iz > 0) {
+      q = (sc_prof_path_t *) sc_array_index (paths, iz - 1);
+      if (!strcmp (p->path, q->path)) {
+        q->calls += p->calls;
+        q->inclusive += p->inclusive;
+        q->exclusive += p->exclusive;
+        q->flops += p->flops;
+        SC_FREE (p->path);
+        continue;
+      }
+    }
+    *(sc_prof_path_t *) sc_array_index (paths, iz++) = *p;
+  }
+  sc_array_resize (paths, iz);
+}
+
+/** Free the strings of the collected paths and the array. */
+static void
+sc_prof_collect_reset (sc_array_t * paths)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < paths->elem_count; ++zz) {
+    SC_FREE (((sc_prof_path_t *) sc_array_index (paths, zz))->path);
+  }
+  sc_array_reset (paths);
+}
+
+int
+sc_prof_lookup (const char *path, long *calls,
+                double *inclusive, double *exclusive)
+{
+  ssize_t             found;
+  sc_array_t          paths;
+  sc_prof_path_t      key, *p = NULL;
+
+  sc_prof_collect (&paths);
+  key.path = (char *) path;
+  found = sc_array_bsearch (&paths, &key, sc_prof_path_compare);
+  if (found >= 0) {
+    p = (sc_prof_path_t *) sc_array_index_ssize_t (&paths, found);
+  }
+  if (calls != NULL)
+    *calls = p != NULL ? p->calls : 0;
+  if (inclusive != NULL)
+    *inclusive = p != NULL ? p->inclusive : 0.;
+  if (exclusive != NULL)
+    *exclusive = p != NULL ? p->exclusive : 0.;
+  sc_prof_collect_reset (&paths);
+  return p != NULL;
+}
+
+static int
+sc_prof_string_compare (const void *v1, const void *v2)
+{
+  return strcmp (*(char *const *) v1, *(char *const *) v2);
+}
+
+void
+sc_prof_print (sc_MPI_Comm mpicomm, int package_id, int log_priority)
+{
+  int                 mpiret;
+  int                 i, num_procs, len, total;
+  int                *lens, *offsets;
+  size_t              zz, iz, nnames;
+  ssize_t             found;
+  char               *local, *all, *s;
+  char              **names;
+  const char         *suffix[4] = { "calls", "inclusive", "exclusive",
+    "mflops"
+  };
+  sc_array_t          paths, unique;
+  sc_prof_path_t      key, *p;
+  sc_statistics_t    *stats;
+
+  /* concatenate the local paths separated by newlines */
+  sc_prof_collect (&paths);
+  for (len = 0, zz = 0; zz < paths.elem_count; ++zz) {
+    p = (sc_prof_path_t *) sc_array_index (&paths, zz);
+    len += (int) strlen (p->path) + 1;
+  }
+  local = SC_ALLOC (char, len + 1);
+  for (s = local, zz = 0; zz < paths.elem_count; ++zz) {
+    p = (sc_prof_path_t *) sc_array_index (&paths, zz);
+    s += sprintf (s, "%s\n", p->path);
+  }
+
+  /* gather the paths of all ranks */
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  lens = SC_ALLOC (int, 2 * num_procs);
+  offsets = lens + num_procs;
+  mpiret = sc_MPI_Allgather (&len, 1, sc_MPI_INT, lens, 1, sc_MPI_INT,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (total = 0, i = 0; i < num_procs; ++i) {
+    offsets[i] = total;
+    total += lens[i];
+  }
+  all = SC_ALLOC (char, total + 1);
+  mpiret = sc_MPI_Allgatherv (local, len, sc_MPI_CHAR, all, lens, offsets,
+                              sc_MPI_CHAR, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (lens);
+  SC_FREE (local);
+
+  /* find the union of the paths in a deterministic order */
+  sc_array_init (&unique, sizeof (char *));
+  for (s = all; s < all + total; s += strlen (s) + 1) {
+    *(char **) sc_array_push (&unique) = s;
+    *strchr (s, '\n') = '\0';
+  }
+  sc_array_sort (&unique, sc_prof_string_compare);
+  sc_array_uniq (&unique, sc_prof_string_compare);
+
+  /* the statistics keep the names by pointer */
+  nnames = 4 * unique.elem_count;
+  names = SC_ALLOC (char *, nnames);
+  stats = sc_statistics_new (mpicomm);
+  for (zz = 0; zz < unique.elem_count; ++zz) {
+    key.path = *(char **) sc_array_index (&unique, zz);
+    found = sc_array_bsearch (&paths, &key, sc_prof_path_compare);
+    p = found >= 0 ?
+      (sc_prof_path_t *) sc_array_index_ssize_t (&paths, found) : NULL;
+    for (iz = 0; iz < 4; ++iz) {
+      len = (int) strlen (key.path) + strlen (suffix[iz]) + 2;
+      names[4 * zz + iz] = SC_ALLOC (char, len);
+      snprintf (names[4 * zz + iz], len, "%s %s", key.path, suffix[iz]);
+      if (iz == 3 && !sc_prof_papi) {
+        continue;
+      }
+      sc_statistics_add_empty (stats, names[4 * zz + iz]);
+      if (p == NULL) {
+        continue;
+      }
+      sc_statistics_accumulate
+        (stats, names[4 * zz + iz],
+         iz == 0 ? (double) p->calls : iz == 1 ? p->inclusive :
+         iz == 2 ? p->exclusive :
+         p->inclusive > 0. ? (double) p->flops / 1.e6 / p->inclusive : 0.);
+    }
+  }
+  sc_statistics_compute (stats);
+  sc_statistics_print (stats, package_id, log_priority, 1, 0);
+  sc_statistics_destroy (stats);
+
+  for (zz = 0; zz < nnames; ++zz) {
+    SC_FREE (names[zz]);
+  }
+  SC_FREE (names);
+  sc_array_reset (&unique);
+  SC_FREE (all);
+  sc_prof_collect_reset (&paths);
+}
+
+void
+sc_prof_reset (void)
+{
+  sc_prof_thread_t   *pt, *next;
+
+  for (pt = sc_prof_threads; pt != NULL; pt = next) {
+    SC_ASSERT (pt->current == 0);
+    next = pt->next;
+    sc_array_reset (&pt->nodes);
+    SC_FREE (pt);
+  }
+  sc_prof_threads = NULL;
+  sc_prof_thread = NULL;
+  ++sc_prof_generation;
+}
+
+void
+sc_prof_finalize (void)
+{
+  sc_prof_reset ();
+  sc_prof_papi = 0;
+}
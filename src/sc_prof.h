@@ -0,0 +1,98 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_PROF_H
+#define SC_PROF_H
+
+/** \file sc_prof.h
+ * Named and nestable regions that are timed per thread.
+ *
+ * Every thread records a call tree of the regions it enters.  For each
+ * path of nested regions, the number of calls, the inclusive time, the
+ * exclusive time without nested regions and optionally the floating
+ * point operations from \ref sc_flops_papi are accumulated.
+ * The summary is reduced over all ranks with \ref sc_statistics_t.
+ *
+ * The macros \ref SC_PROF_BEGIN and \ref SC_PROF_END expand to nothing
+ * unless SC_PROF is defined before including this header.
+ */
+
+#include <sc_flops.h>
+
+SC_EXTERN_C_BEGIN;
+
+#ifdef SC_PROF
+#define SC_PROF_BEGIN(name) sc_prof_begin (name)
+#define SC_PROF_END() sc_prof_end ()
+#else
+#define SC_PROF_BEGIN(name) SC_NOOP ()
+#define SC_PROF_END() SC_NOOP ()
+#endif
+
+/** Enter a region nested in the region currently open by this thread.
+ * \param [in] name     Name of the region.  It is stored by pointer,
+ *                      so it must stay alive until \ref sc_prof_reset.
+ *                      A string literal is the common choice.
+ */
+void                sc_prof_begin (const char *name);
+
+/** Leave the region most recently entered by this thread. */
+void                sc_prof_end (void);
+
+/** Choose whether regions count floating point operations by PAPI.
+ * This is off by default and must be set while no region is open.
+ */
+void                sc_prof_set_papi (int use_papi);
+
+/** Look up the accumulated data of a path of regions over all threads.
+ * \param [in] path         Region names separated by '/', for example
+ *                          "solve/assemble".
+ * \param [out] calls       If not NULL, the number of calls.
+ * \param [out] inclusive   If not NULL, the time in seconds.
+ * \param [out] exclusive   If not NULL, the time without nested regions.
+ * \return                  True if the path has been recorded.
+ */
+int                 sc_prof_lookup (const char *path, long *calls,
+                                    double *inclusive, double *exclusive);
+
+/** Print the calls, times and flops of all paths reduced over ranks.
+ * Paths recorded on some ranks only are reduced over those ranks.
+ * This function is collective and must not run while regions are open.
+ * \param [in] mpicomm          Communicator for the reduction.
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] log_priority     Log priority for output according to sc.h.
+ */
+void                sc_prof_print (sc_MPI_Comm mpicomm,
+                                   int package_id, int log_priority);
+
+/** Discard the recorded regions of all threads.
+ * This function must not be called while other threads use regions.
+ */
+void                sc_prof_reset (void);
+
+/** Free all memory of the profiler.  It is called by \ref sc_finalize. */
+void                sc_prof_finalize (void);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PROF_H */
@@ -0,0 +1,287 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sc_progress.h>
+#include <sc_notify.h>
+#include <sc_reduce.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+struct sc_progress_item
+{
+  sc_progress_poll_t  poll;
+  void               *data;
+  sc_progress_done_t  done;
+  void               *user;
+  int                 complete;
+  sc_progress_item_t *next;     /**< in the list of pending items */
+};
+
+/** The items not yet complete in order of registration. */
+static sc_progress_item_t *sc_progress_pending = NULL;
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Protects the list and the item states; held while polling. */
+static pthread_mutex_t sc_progress_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Signals new items to the thread and completions to waiters. */
+static pthread_cond_t sc_progress_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t    sc_progress_thread;
+static int          sc_progress_running = 0;
+static int          sc_progress_stopping = 0;
+
+#define SC_PROGRESS_LOCK() pthread_mutex_lock (&sc_progress_mutex)
+#define SC_PROGRESS_UNLOCK() pthread_mutex_unlock (&sc_progress_mutex)
+
+#else
+
+#define SC_PROGRESS_LOCK() do { } while (0)
+#define SC_PROGRESS_UNLOCK() do { } while (0)
+
+#endif /* SC_ENABLE_PTHREAD */
+
+/** Poll an item once and retire it on completion.
+ * Must be called with the lock held.
+ */
+static void
+sc_progress_poll_item (sc_progress_item_t * item)
+{
+  sc_progress_item_t **pitem;
+
+  if (item->complete || !item->poll (item->data)) {
+    return;
+  }
+  if (item->done != NULL) {
+    item->done (item->data, item->user);
+  }
+  item->complete = 1;
+
+  for (pitem = &sc_progress_pending; *pitem != item;
+       pitem = &(*pitem)->next) {
+    SC_ASSERT (*pitem != NULL);
+  }
+  *pitem = item->next;
+  item->next = NULL;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_progress_main (void *arg)
+{
+  struct timespec     pause;
+  sc_progress_item_t *item, *next;
+
+  pause.tv_sec = 0;
+  pause.tv_nsec = SC_PROGRESS_SLEEP_US * 1000L;
+
+  SC_PROGRESS_LOCK ();
+  while (!sc_progress_stopping) {
+    if (sc_progress_pending == NULL) {
+      pthread_cond_wait (&sc_progress_cond, &sc_progress_mutex);
+      continue;
+    }
+    for (item = sc_progress_pending; item != NULL; item = next) {
+      next = item->next;
+      sc_progress_poll_item (item);
+    }
+    pthread_cond_broadcast (&sc_progress_cond);
+
+    /* let other threads register and wait */
+    SC_PROGRESS_UNLOCK ();
+    nanosleep (&pause, NULL);
+    SC_PROGRESS_LOCK ();
+  }
+  SC_PROGRESS_UNLOCK ();
+
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+int
+sc_progress_start (int cpu)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+#ifdef SC_ENABLE_MPI
+  int                 mpiret, provided;
+
+  mpiret = MPI_Query_thread (&provided);
+  SC_CHECK_MPI (mpiret);
+  if (provided < MPI_THREAD_MULTIPLE) {
+    SC_GLOBAL_LDEBUG ("No progress thread without MPI_THREAD_MULTIPLE\n");
+    return -1;
+  }
+#endif
+  if (sc_progress_running) {
+    return 0;
+  }
+
+  sc_progress_stopping = 0;
+  pth = pthread_create (&sc_progress_thread, NULL, sc_progress_main, NULL);
+  SC_CHECK_ABORT (pth == 0, "Failed to create progress thread");
+  sc_progress_running = 1;
+
+#ifdef __linux__
+  if (cpu >= 0) {
+    cpu_set_t           cpuset;
+
+    CPU_ZERO (&cpuset);
+    CPU_SET (cpu, &cpuset);
+    if (pthread_setaffinity_np (sc_progress_thread, sizeof (cpuset),
+                                &cpuset)) {
+      SC_LDEBUGF ("Could not pin the progress thread to CPU %d\n", cpu);
+    }
+  }
+#endif
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+void
+sc_progress_stop (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  if (!sc_progress_running) {
+    return;
+  }
+  SC_PROGRESS_LOCK ();
+  sc_progress_stopping = 1;
+  pthread_cond_broadcast (&sc_progress_cond);
+  SC_PROGRESS_UNLOCK ();
+  pthread_join (sc_progress_thread, NULL);
+  sc_progress_running = 0;
+
+  /* waiters now poll by themselves */
+  SC_PROGRESS_LOCK ();
+  pthread_cond_broadcast (&sc_progress_cond);
+  SC_PROGRESS_UNLOCK ();
+#endif
+}
+
+int
+sc_progress_is_threaded (void)
+{
+#ifdef SC_ENABLE_PTHREAD
+  return sc_progress_running;
+#else
+  return 0;
+#endif
+}
+
+sc_progress_item_t *
+sc_progress_add (sc_progress_poll_t poll, void *data,
+                 sc_progress_done_t done, void *user)
+{
+  sc_progress_item_t *item, **pitem;
+
+  SC_ASSERT (poll != NULL);
+
+  item = SC_ALLOC_ZERO (sc_progress_item_t, 1);
+  item->poll = poll;
+  item->data = data;
+  item->done = done;
+  item->user = user;
+
+  SC_PROGRESS_LOCK ();
+  for (pitem = &sc_progress_pending; *pitem != NULL;
+       pitem = &(*pitem)->next);
+  *pitem = item;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_cond_broadcast (&sc_progress_cond);
+#endif
+  SC_PROGRESS_UNLOCK ();
+
+  return item;
+}
+
+int
+sc_progress_test (sc_progress_item_t * item)
+{
+  int                 complete;
+
+  SC_PROGRESS_LOCK ();
+  if (!sc_progress_is_threaded ()) {
+    sc_progress_poll_item (item);
+  }
+  complete = item->complete;
+  SC_PROGRESS_UNLOCK ();
+
+  return complete;
+}
+
+void
+sc_progress_wait (sc_progress_item_t * item)
+{
+  SC_PROGRESS_LOCK ();
+  while (!item->complete) {
+#ifdef SC_ENABLE_PTHREAD
+    if (sc_progress_running) {
+      pthread_cond_wait (&sc_progress_cond, &sc_progress_mutex);
+      continue;
+    }
+#endif
+    sc_progress_poll_item (item);
+  }
+  SC_PROGRESS_UNLOCK ();
+
+  SC_FREE (item);
+}
+
+void
+sc_progress_poll (void)
+{
+  sc_progress_item_t *item, *next;
+
+  SC_PROGRESS_LOCK ();
+  if (!sc_progress_is_threaded ()) {
+    for (item = sc_progress_pending; item != NULL; item = next) {
+      next = item->next;
+      sc_progress_poll_item (item);
+    }
+  }
+  SC_PROGRESS_UNLOCK ();
+}
+
+int
+sc_progress_poll_notify (void *request)
+{
+  return sc_notify_test ((sc_notify_request_t *) request);
+}
+
+int
+sc_progress_poll_reduce (void *request)
+{
+  return sc_reduce_test ((sc_reduce_request_t *) request);
+}
@@ -0,0 +1,121 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_PROGRESS_H
+#define SC_PROGRESS_H
+
+/** \file sc_progress.h
+ * Drive non-blocking communication in the background.
+ *
+ * Outstanding requests, such as those of \ref sc_notify_begin and
+ * \ref sc_iallreduce_custom, only advance while their test function is
+ * called.  They can be registered here as items with a poll function.
+ * If the progress thread runs, it polls all registered items and calls
+ * their completion callbacks.  Otherwise, the items are polled by
+ * \ref sc_progress_test, \ref sc_progress_wait and \ref sc_progress_poll
+ * in the calling thread, which keeps the same code correct in both cases.
+ *
+ * The thread requires configuring with --enable-pthread and, with MPI,
+ * initializing MPI with sc_MPI_THREAD_MULTIPLE.
+ * If the environment variable SC_PROGRESS_THREAD is set, \ref sc_init
+ * starts the thread pinned to the CPU given by its value, or unpinned if
+ * the value is negative, and \ref sc_finalize stops it.
+ */
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Microseconds the progress thread sleeps between two polling rounds. */
+#ifndef SC_PROGRESS_SLEEP_US
+#define SC_PROGRESS_SLEEP_US 20
+#endif
+
+/** Poll an outstanding operation.
+ * \param [in,out] data The operation registered with \ref sc_progress_add.
+ * \return              True if the operation has completed.
+ */
+typedef int         (*sc_progress_poll_t) (void *data);
+
+/** Callback run once an operation has completed.
+ * With the progress thread it runs on that thread.
+ */
+typedef void        (*sc_progress_done_t) (void *data, void *user);
+
+/** Opaque handle of a registered operation */
+typedef struct sc_progress_item sc_progress_item_t;
+
+/** Start the progress thread.
+ * \param [in] cpu      Pin the thread to this CPU if non-negative.
+ *                      Pinning is ignored where it is not supported.
+ * \return              0 if the thread runs, or -1 if threads or
+ *                      sc_MPI_THREAD_MULTIPLE are not available.  Then
+ *                      the items are progressed by the calling threads.
+ */
+int                 sc_progress_start (int cpu);
+
+/** Stop the progress thread after it has finished its current round.
+ * Items still registered remain valid and are polled by the callers.
+ */
+void                sc_progress_stop (void);
+
+/** Return true if the progress thread is running. */
+int                 sc_progress_is_threaded (void);
+
+/** Register an outstanding operation.
+ * \param [in] poll     Poll function called until it returns true.
+ *                      It is never called concurrently for one item.
+ * \param [in] data     Passed to \a poll and \a done.
+ * \param [in] done     Called once after completion; may be NULL.
+ * \param [in] user     Passed to \a done.
+ * \return              Item to be passed to \ref sc_progress_wait.
+ */
+sc_progress_item_t *sc_progress_add (sc_progress_poll_t poll, void *data,
+                                     sc_progress_done_t done, void *user);
+
+/** Check without blocking whether an item has completed.
+ * Without the progress thread, the item is polled once.
+ * \return              True if the item and its callback have completed.
+ */
+int                 sc_progress_test (sc_progress_item_t * item);
+
+/** Wait until an item has completed and destroy it.
+ * The operation itself, for example a request of \ref sc_notify_begin,
+ * must still be finished by its own end function afterwards.
+ */
+void                sc_progress_wait (sc_progress_item_t * item);
+
+/** Poll every registered item once from the calling thread.
+ * With the progress thread running, this function does nothing.
+ */
+void                sc_progress_poll (void);
+
+/** Poll function for a request of \ref sc_notify_begin. */
+int                 sc_progress_poll_notify (void *request);
+
+/** Poll function for a request of \ref sc_iallreduce_custom. */
+int                 sc_progress_poll_reduce (void *request);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PROGRESS_H */
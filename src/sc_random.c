@@ -162,6 +162,165 @@ sc_rand_poisson (sc_rand_state_t * state, double mean)
   return (int) x;
 }
 
+/* multipliers and key increments of the Philox4x32 generator */
+#define SC_RAND_PHILOX_M0 0xd2511f53U
+#define SC_RAND_PHILOX_M1 0xcd9e8d57U
+#define SC_RAND_PHILOX_W0 0x9e3779b9U
+#define SC_RAND_PHILOX_W1 0xbb67ae85U
+#define SC_RAND_PHILOX_ROUNDS 10
+
+/** Compute the Philox4x32-10 bijection of a counter under a key. */
+static void
+sc_rand_philox (const uint32_t key[2], const uint32_t ctr[4],
+                uint32_t out[4])
+{
+  int                 r;
+  uint32_t            k0 = key[0], k1 = key[1];
+  uint32_t            c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint64_t            p0, p1;
+
+  for (r = 0; r < SC_RAND_PHILOX_ROUNDS; ++r) {
+    p0 = (uint64_t) SC_RAND_PHILOX_M0 * c0;
+    p1 = (uint64_t) SC_RAND_PHILOX_M1 * c2;
+    c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+    c1 = (uint32_t) p1;
+    c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+    c3 = (uint32_t) p0;
+    k0 += SC_RAND_PHILOX_W0;
+    k1 += SC_RAND_PHILOX_W1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+/** Compute the two 64-bit words for positions 2 * block and one after. */
+static void
+sc_rand_stream_block (const sc_rand_stream_t * s, uint64_t block,
+                      uint64_t words[2])
+{
+  uint32_t            ctr[4], out[4];
+
+  ctr[0] = (uint32_t) block;
+  ctr[1] = (uint32_t) (block >> 32);
+  ctr[2] = (uint32_t) s->stream_id;
+  ctr[3] = (uint32_t) (s->stream_id >> 32);
+  sc_rand_philox (s->key, ctr, out);
+  words[0] = ((uint64_t) out[0] << 32) | out[1];
+  words[1] = ((uint64_t) out[2] << 32) | out[3];
+}
+
+/** Convert the upper 53 bits of a word into a number in [0, 1). */
+static double
+sc_rand_word_to_double (uint64_t word)
+{
+  return (word >> 11) * (1. / 9007199254740992.);
+}
+
+void
+sc_rand_stream_init (sc_rand_stream_t * s, uint64_t seed, uint64_t stream_id)
+{
+  SC_ASSERT (s != NULL);
+
+  s->key[0] = (uint32_t) seed;
+  s->key[1] = (uint32_t) (seed >> 32);
+  s->stream_id = stream_id;
+  s->position = 0;
+}
+
+void
+sc_rand_stream_skip (sc_rand_stream_t * s, uint64_t n)
+{
+  SC_ASSERT (s != NULL);
+
+  s->position += n;
+}
+
+double
+sc_rand_stream_uniform (sc_rand_stream_t * s)
+{
+  uint64_t            words[2];
+
+  SC_ASSERT (s != NULL);
+
+  sc_rand_stream_block (s, s->position / 2, words);
+  return sc_rand_word_to_double (words[s->position++ % 2]);
+}
+
+/** Transform the words of one block and copy the requested part.
+ * \param [in] kind     0 for uniform, 1 for normal distribution.
+ * \return              Number of values stored, 1 or 2.
+ */
+static size_t
+sc_rand_stream_block_values (sc_rand_stream_t * s, int kind,
+                             double *out, size_t n)
+{
+  const int           first = (int) (s->position % 2);
+  int                 h;
+  size_t              i;
+  uint64_t            words[2];
+  double              v[2], r, theta;
+
+  sc_rand_stream_block (s, s->position / 2, words);
+  v[0] = sc_rand_word_to_double (words[0]);
+  v[1] = sc_rand_word_to_double (words[1]);
+  if (kind == 1) {
+    /* Box Muller transform, taking the logarithm of a number in (0, 1] */
+    r = sqrt (-2. * log (1. - v[0]));
+    theta = 2. * M_PI * v[1];
+    v[0] = r * cos (theta);
+    v[1] = r * sin (theta);
+  }
+  for (i = 0, h = first; h < 2 && i < n; ++h) {
+    out[i++] = v[h];
+  }
+  s->position += i;
+  return i;
+}
+
+void
+sc_rand_stream_uniform_batch (sc_rand_stream_t * s, double *out, size_t n)
+{
+  size_t              i;
+
+  SC_ASSERT (s != NULL);
+
+  for (i = 0; i < n;) {
+    i += sc_rand_stream_block_values (s, 0, out + i, n - i);
+  }
+}
+
+void
+sc_rand_stream_normal_batch (sc_rand_stream_t * s, double *out, size_t n)
+{
+  size_t              i;
+
+  SC_ASSERT (s != NULL);
+
+  for (i = 0; i < n;) {
+    i += sc_rand_stream_block_values (s, 1, out + i, n - i);
+  }
+}
+
+void
+sc_rand_stream_poisson_batch (sc_rand_stream_t * s, double mean,
+                              int *out, size_t n)
+{
+  size_t              i;
+  uint64_t            words[2];
+  sc_rand_state_t     state;
+
+  SC_ASSERT (s != NULL);
+
+  for (i = 0; i < n; ++i) {
+    /* the rejection method draws a varying count from a private state */
+    sc_rand_stream_block (s, s->position / 2, words);
+    state = words[s->position++ % 2];
+    out[i] = sc_rand_poisson (&state, mean);
+  }
+}
+
 static int
 draw_poisson_cumulative (sc_rand_state_t * state, double *cumud, int ncumu)
 {
@@ -67,4 +67,73 @@ int                 sc_rand_small (sc_rand_state_t * state, double d);
  */
 int                 sc_rand_poisson (sc_rand_state_t * state, double mean);
 
+/** A counter-based stream of random numbers.
+ * The numbers are computed by the Philox4x32-10 generator from a key, a
+ * stream id and a position.  The value at any position is independent of
+ * how the numbers before it were drawn, so a global array filled in
+ * pieces by any number of threads or processes is reproducible when each
+ * piece skips ahead to its global offset.
+ * The members should be treated as opaque.
+ */
+typedef struct sc_rand_stream
+{
+  uint32_t            key[2];   /**< Derived from the seed. */
+  uint64_t            stream_id;        /**< Selects the stream. */
+  uint64_t            position; /**< Number of values drawn so far. */
+}
+sc_rand_stream_t;
+
+/** Initialize a random stream at position zero.
+ * \param [out] s       The stream to initialize.
+ * \param [in] seed     Streams with different seeds are independent.
+ * \param [in] stream_id        Streams with the same seed and different
+ *                              ids are independent.
+ */
+void                sc_rand_stream_init (sc_rand_stream_t * s,
+                                         uint64_t seed, uint64_t stream_id);
+
+/** Advance the position of a stream in constant time.
+ * Every value drawn by the functions below consumes one position.
+ * \param [in,out] s    The stream is advanced.
+ * \param [in] n        Number of positions to skip.
+ */
+void                sc_rand_stream_skip (sc_rand_stream_t * s, uint64_t n);
+
+/** Draw one number uniformly distributed in [0, 1) from a stream.
+ * \param [in,out] s    The stream is advanced by one position.
+ * \return              Number in [0, 1) with 53 random bits.
+ */
+double              sc_rand_stream_uniform (sc_rand_stream_t * s);
+
+/** Fill an array with numbers uniformly distributed in [0, 1).
+ * The result equals \a n calls to \ref sc_rand_stream_uniform.
+ * \param [in,out] s    The stream is advanced by \a n positions.
+ * \param [out] out     Array of \a n numbers.
+ * \param [in] n        Number of values to draw.
+ */
+void                sc_rand_stream_uniform_batch (sc_rand_stream_t * s,
+                                                  double *out, size_t n);
+
+/** Fill an array with samples of the standard normal distribution.
+ * The samples at positions 2k and 2k + 1 are computed by the Box Muller
+ * transform from the uniform numbers at the same positions.
+ * \param [in,out] s    The stream is advanced by \a n positions.
+ * \param [out] out     Array of \a n samples.
+ * \param [in] n        Number of values to draw.
+ */
+void                sc_rand_stream_normal_batch (sc_rand_stream_t * s,
+                                                 double *out, size_t n);
+
+/** Fill an array with samples of the Poisson distribution.
+ * Each sample is drawn by \ref sc_rand_poisson from a state derived
+ * from its position in the stream.
+ * \param [in,out] s    The stream is advanced by \a n positions.
+ * \param [in] mean     Mean value of Poisson distribution.
+ * \param [out] out     Array of \a n non-negative integers.
+ * \param [in] n        Number of values to draw.
+ */
+void                sc_rand_stream_poisson_batch (sc_rand_stream_t * s,
+                                                  double mean, int *out,
+                                                  size_t n);
+
 #endif /* !SC_RANDOM_H */
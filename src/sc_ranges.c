@@ -226,6 +226,99 @@ sc_ranges_adaptive (int package_id, sc_MPI_Comm mpicomm,
   return nwin;
 }
 
+int
+sc_ranges_compute_weighted (int package_id, int num_procs,
+                            const size_t *bytes, int rank, double latency,
+                            double range_cost, int num_ranges, int *ranges)
+{
+  int                 i, j, nwin, nmerged;
+  int                 first_peer, last_peer, empties;
+  int                *procs;
+
+  SC_ASSERT (rank >= 0 && rank < num_procs);
+  SC_ASSERT (num_ranges >= 1);
+
+  /* peers are the processors we send a nonempty message */
+  procs = SC_ALLOC (int, num_procs);
+  first_peer = num_procs;
+  last_peer = -1;
+  for (j = 0; j < num_procs; ++j) {
+    procs[j] = (j != rank && bytes[j] > 0);
+    if (procs[j]) {
+      first_peer = SC_MIN (first_peer, j);
+      last_peer = j;
+    }
+  }
+  nwin = sc_ranges_compute (package_id, num_procs, procs, rank,
+                            first_peer, last_peer, num_ranges, ranges);
+  SC_FREE (procs);
+
+  /* close the gaps that are cheaper than an additional range */
+  nmerged = SC_MIN (nwin, 1);
+  for (i = 1; i < nwin; ++i) {
+    empties = ranges[2 * i] - ranges[2 * nmerged - 1] - 1;
+    if (ranges[2 * nmerged - 1] < rank && rank < ranges[2 * i]) {
+      --empties;
+    }
+    if (latency * empties <= range_cost) {
+      ranges[2 * nmerged - 1] = ranges[2 * i + 1];
+    }
+    else {
+      ranges[2 * nmerged] = ranges[2 * i];
+      ranges[2 * nmerged + 1] = ranges[2 * i + 1];
+      ++nmerged;
+    }
+  }
+  for (i = nmerged; i < nwin; ++i) {
+    ranges[2 * i] = -1;
+    ranges[2 * i + 1] = -2;
+  }
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, SC_LP_DEBUG,
+               "weighted ranges %d of %d\n", nmerged, nwin);
+
+  return nmerged;
+}
+
+int
+sc_ranges_weighted (int package_id, sc_MPI_Comm mpicomm,
+                    const size_t *bytes, double latency, double byte_cost,
+                    int num_ranges, int *ranges, int *max_ranges,
+                    int **global_ranges)
+{
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 nwin, maxwin, twomaxwin;
+  double              range_cost;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* each range is exchanged with every processor */
+  range_cost = byte_cost * 2. * sizeof (int) * num_procs;
+  nwin = sc_ranges_compute_weighted (package_id, num_procs, bytes, rank,
+                                     latency, range_cost, num_ranges,
+                                     ranges);
+
+  mpiret = sc_MPI_Allreduce (&nwin, &maxwin, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  *max_ranges = maxwin;
+  twomaxwin = 2 * maxwin;
+  SC_ASSERT (nwin <= maxwin && maxwin <= num_ranges);
+
+  if (global_ranges != NULL) {
+    *global_ranges = SC_ALLOC (int, twomaxwin * num_procs);
+    mpiret = sc_MPI_Allgather (ranges, twomaxwin, sc_MPI_INT,
+                               *global_ranges, twomaxwin, sc_MPI_INT,
+                               mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  return nwin;
+}
+
 void
 sc_ranges_decode (int num_procs, int rank,
                   int max_ranges, const int *global_ranges,
@@ -329,3 +422,41 @@ sc_ranges_statistics (int package_id, int log_priority,
                "Ranges %d nonpeer %g +- %g min/max %g %g\n",
                num_ranges, si.average, si.standev, si.min, si.max);
 }
+
+void
+sc_ranges_statistics_weighted (int package_id, int log_priority,
+                               sc_MPI_Comm mpicomm, int num_procs,
+                               const size_t *bytes, int rank,
+                               double latency, double byte_cost,
+                               int num_ranges, const int *ranges)
+{
+  int                 i, j;
+  int                 nwin, empties, messages;
+  double              volume, total;
+  sc_statinfo_t       si[3];
+
+  nwin = empties = messages = 0;
+  volume = 0.;
+  for (i = 0; i < num_ranges && ranges[2 * i] >= 0; ++i) {
+    ++nwin;
+    for (j = ranges[2 * i]; j <= ranges[2 * i + 1]; ++j) {
+      if (j != rank) {
+        ++messages;
+        empties += (bytes[j] == 0);
+        volume += (double) bytes[j];
+      }
+    }
+  }
+  total = latency * messages + byte_cost * volume;
+
+  sc_stats_set1 (si, (double) nwin, "ranges");
+  sc_stats_set1 (si + 1, (double) empties, "empty messages");
+  sc_stats_set1 (si + 2, total > 0. ? latency * empties / total : 0.,
+                 "wasted cost");
+  sc_stats_compute (mpicomm, 3, si);
+  SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+               "Weighted ranges %g max %g empty %g +- %g max %g"
+               " wasted %g max %g\n", si[0].average, si[0].max,
+               si[1].average, si[1].standev, si[1].max,
+               si[2].average, si[2].max);
+}
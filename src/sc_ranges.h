@@ -77,6 +77,59 @@ int                 sc_ranges_adaptive (int package_id, sc_MPI_Comm mpicomm,
                                         int num_ranges, int *ranges,
                                         int **global_ranges);
 
+/** Compute ranges of processors from message sizes with a cost model.
+ * Sending to every processor of a range may include empty messages to
+ * processors in the gaps between the peers.  Each empty message is
+ * assumed to cost \a latency and each range to cost \a range_cost.
+ * Starting from the ranges of \ref sc_ranges_compute, every gap whose
+ * empty messages cost no more than a range is closed, so the number of
+ * ranges is chosen per processor and may be less than \a num_ranges.
+ *
+ * \param [in] package_id   Registered package id or -1.
+ * \param [in] num_procs    Number of processors processed.
+ * \param [in] bytes        Array [num_procs] of message sizes.
+ *                          Nonzero entries need to be talked to.
+ * \param [in] rank         The id of the calling process.
+ *                          Will be excluded from the ranges.
+ * \param [in] latency      Cost of one empty message, such as seconds.
+ * \param [in] range_cost   Cost of one additional range in the same unit.
+ * \param [in] num_ranges   The maximum number of ranges to fill.
+ * \param [in,out] ranges   Array [2 * num_ranges] as in
+ *                          sc_ranges_compute ().
+ * \return                  Returns the number of filled ranges.
+ */
+int                 sc_ranges_compute_weighted (int package_id,
+                                                int num_procs,
+                                                const size_t *bytes,
+                                                int rank, double latency,
+                                                double range_cost,
+                                                int num_ranges, int *ranges);
+
+/** Compute cost-optimal ranges on all processors.
+ * Every process calls \ref sc_ranges_compute_weighted with the cost of a
+ * range being the volume it adds to the exchange of all ranges,
+ * 2 * sizeof (int) * num_procs bytes times \a byte_cost.
+ *
+ * \param [in] package_id   Registered package id or -1.
+ * \param [in] mpicomm      MPI Communicator for Allreduce and Allgather.
+ * \param [in] bytes        Same as in sc_ranges_compute_weighted ().
+ * \param [in] latency      Cost of one empty message.
+ * \param [in] byte_cost    Cost of sending one byte.
+ * \param [in] num_ranges   The maximum number of ranges to fill.
+ * \param [in,out] ranges   Array [2 * num_ranges] for the local ranges.
+ * \param [out] max_ranges  Global maximum number of filled ranges.
+ * \param [out] global_ranges
+ *     If not NULL, will be allocated and filled with everybody's ranges.
+ *     Size will be 2 * max_ranges * num_procs.  Must be freed with
+ *     SC_FREE ().  This array can be passed to sc_ranges_decode ().
+ * \return                  Returns the number of locally filled ranges.
+ */
+int                 sc_ranges_weighted (int package_id, sc_MPI_Comm mpicomm,
+                                        const size_t *bytes, double latency,
+                                        double byte_cost, int num_ranges,
+                                        int *ranges, int *max_ranges,
+                                        int **global_ranges);
+
 /** Determine an array of receivers and an array of senders from ranges.
  * This function is intended for compatibility and debugging only.
  * In particular, sc_ranges_adaptive may include non-receiving processors.
@@ -110,6 +163,26 @@ void                sc_ranges_statistics (int package_id, int log_priority,
                                           const int *procs, int rank,
                                           int num_ranges, int *ranges);
 
+/** Compute global statistics on the cost of weighted ranges.
+ * Logs the number of ranges, the number of empty messages they cause,
+ * and the fraction of the modeled message cost wasted on them.
+ *
+ * \param [in] package_id       Registered package id or -1.
+ * \param [in] log_priority     Priority to use for logging.
+ * \param [in] bytes            Same as in sc_ranges_compute_weighted ().
+ * \param [in] latency          Cost of one message.
+ * \param [in] byte_cost        Cost of sending one byte.
+ */
+void                sc_ranges_statistics_weighted (int package_id,
+                                                   int log_priority,
+                                                   sc_MPI_Comm mpicomm,
+                                                   int num_procs,
+                                                   const size_t *bytes,
+                                                   int rank, double latency,
+                                                   double byte_cost,
+                                                   int num_ranges,
+                                                   const int *ranges);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_RANGES_H */
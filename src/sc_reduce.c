@@ -24,6 +24,15 @@
 #include <sc_reduce.h>
 #include <sc_search.h>
 
+/* The combine loops below are written without branches so that the
+ * compiler vectorizes them; very long ones are also split over threads. */
+#ifdef SC_ENABLE_OPENMP
+#define SC_REDUCE_FOR _Pragma \
+  ("omp parallel for simd if (sendcount >= SC_REDUCE_OPENMP_MIN)")
+#else
+#define SC_REDUCE_FOR
+#endif
+
 static void
 sc_reduce_alltoall (sc_MPI_Comm mpicomm,
                     void *data, int count, sc_MPI_Datatype datatype,
@@ -76,13 +85,13 @@ sc_reduce_alltoall (sc_MPI_Comm mpicomm,
       else {
         if (peer < groupsize) {
           mpiret =
-            sc_MPI_Irecv (alldata + i * datasize, datasize, sc_MPI_BYTE, peer,
-                          SC_TAG_REDUCE, mpicomm, rrequest + i);
+            sc_mpi_irecv_large (alldata + i * datasize, datasize, peer,
+                                SC_TAG_REDUCE, mpicomm, rrequest + i);
           SC_CHECK_MPI (mpiret);
           if (doall) {
-            mpiret = sc_MPI_Isend (data, datasize, sc_MPI_BYTE,
-                                   peer, SC_TAG_REDUCE, mpicomm,
-                                   srequest + i);
+            mpiret = sc_mpi_isend_large (data, datasize, peer,
+                                         SC_TAG_REDUCE, mpicomm,
+                                         srequest + i);
             SC_CHECK_MPI (mpiret);
           }
           else {
@@ -116,8 +125,6 @@ sc_reduce_alltoall (sc_MPI_Comm mpicomm,
         }
       }
     }
-    memcpy (data, alldata, datasize);
-    SC_FREE (alldata);          /* alldata is not used in send buffers */
 
     /* wait for sends only after computation is done */
     if (doall) {
@@ -125,10 +132,14 @@ sc_reduce_alltoall (sc_MPI_Comm mpicomm,
       SC_CHECK_MPI (mpiret);
     }
     SC_FREE (request);
+
+    /* data is the send buffer and may only be overwritten now */
+    memcpy (data, alldata, datasize);
+    SC_FREE (alldata);
   }
   else {
-    mpiret = sc_MPI_Send (data, datasize, sc_MPI_BYTE,
-                          target, SC_TAG_REDUCE, mpicomm);
+    mpiret = sc_mpi_send_large (data, datasize, target, SC_TAG_REDUCE,
+                                mpicomm);
     SC_CHECK_MPI (mpiret);
   }
 }
@@ -145,7 +156,6 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
   int                 myrank, peer, higher;
   char               *peerdata;
   size_t              datasize;
-  sc_MPI_Status       rstatus;
 
   orig_target = target;
   doall = 0;
@@ -183,8 +193,8 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
         /* temporary data to compare against peer */
         peerdata = SC_ALLOC (char, datasize);
 
-        mpiret = sc_MPI_Recv (peerdata, datasize, sc_MPI_BYTE,
-                              peer, SC_TAG_REDUCE, mpicomm, &rstatus);
+        mpiret = sc_mpi_recv_large (peerdata, datasize, peer, SC_TAG_REDUCE,
+                                    mpicomm);
         SC_CHECK_MPI (mpiret);
 
         /* execute reduction operation here */
@@ -199,20 +209,20 @@ sc_reduce_recursive (sc_MPI_Comm mpicomm,
 
       if (doall && peer < groupsize) {
         /* if allreduce send back result of reduction */
-        mpiret = sc_MPI_Send (data, datasize, sc_MPI_BYTE,
-                              peer, SC_TAG_REDUCE, mpicomm);
+        mpiret = sc_mpi_send_large (data, datasize, peer, SC_TAG_REDUCE,
+                                    mpicomm);
         SC_CHECK_MPI (mpiret);
       }
     }
     else {
       if (peer < groupsize) {
-        mpiret = sc_MPI_Send (data, datasize, sc_MPI_BYTE,
-                              peer, SC_TAG_REDUCE, mpicomm);
+        mpiret = sc_mpi_send_large (data, datasize, peer, SC_TAG_REDUCE,
+                                    mpicomm);
         SC_CHECK_MPI (mpiret);
         if (doall) {
           /* if allreduce receive back result of reduction */
-          mpiret = sc_MPI_Recv (data, datasize, sc_MPI_BYTE,
-                                peer, SC_TAG_REDUCE, mpicomm, &rstatus);
+          mpiret = sc_mpi_recv_large (data, datasize, peer, SC_TAG_REDUCE,
+                                      mpicomm);
           SC_CHECK_MPI (mpiret);
         }
       }
@@ -229,79 +239,79 @@ sc_reduce_max (void *sendbuf, void *recvbuf,
   if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
     const char         *s = (char *) sendbuf;
     char               *r = (char *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_SHORT) {
     const short        *s = (short *) sendbuf;
     short              *r = (short *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
     const unsigned short *s = (unsigned short *) sendbuf;
     unsigned short     *r = (unsigned short *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_INT) {
     const int          *s = (int *) sendbuf;
     int                *r = (int *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED) {
     const unsigned     *s = (unsigned *) sendbuf;
     unsigned           *r = (unsigned *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG) {
     const long         *s = (long *) sendbuf;
     long               *r = (long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_LONG) {
     const unsigned long *s = (unsigned long *) sendbuf;
     unsigned long      *r = (unsigned long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_LONG_INT) {
     const long long    *s = (long long *) sendbuf;
     long long          *r = (long long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_FLOAT) {
     const float        *s = (float *) sendbuf;
     float              *r = (float *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_DOUBLE) {
     const double       *s = (double *) sendbuf;
     double             *r = (double *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_DOUBLE) {
     const long double  *s = (long double *) sendbuf;
     long double        *r = (long double *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] > r[i])
-        r[i] = s[i];
+      r[i] = s[i] > r[i] ? s[i] : r[i];
   }
   else {
     SC_ABORT ("Unsupported MPI datatype in sc_reduce_max");
@@ -317,79 +327,79 @@ sc_reduce_min (void *sendbuf, void *recvbuf,
   if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
     const char         *s = (char *) sendbuf;
     char               *r = (char *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_SHORT) {
     const short        *s = (short *) sendbuf;
     short              *r = (short *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
     const unsigned short *s = (unsigned short *) sendbuf;
     unsigned short     *r = (unsigned short *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_INT) {
     const int          *s = (int *) sendbuf;
     int                *r = (int *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED) {
     const unsigned     *s = (unsigned *) sendbuf;
     unsigned           *r = (unsigned *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG) {
     const long         *s = (long *) sendbuf;
     long               *r = (long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_LONG) {
     const unsigned long *s = (unsigned long *) sendbuf;
     unsigned long      *r = (unsigned long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_LONG_INT) {
     const long long    *s = (long long *) sendbuf;
     long long          *r = (long long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_FLOAT) {
     const float        *s = (float *) sendbuf;
     float              *r = (float *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_DOUBLE) {
     const double       *s = (double *) sendbuf;
     double             *r = (double *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else if (sendtype == sc_MPI_LONG_DOUBLE) {
     const long double  *s = (long double *) sendbuf;
     long double        *r = (long double *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
-      if (s[i] < r[i])
-        r[i] = s[i];
+      r[i] = s[i] < r[i] ? s[i] : r[i];
   }
   else {
     SC_ABORT ("Unsupported MPI datatype in sc_reduce_min");
@@ -405,66 +415,77 @@ sc_reduce_sum (void *sendbuf, void *recvbuf,
   if (sendtype == sc_MPI_CHAR || sendtype == sc_MPI_BYTE) {
     const char         *s = (char *) sendbuf;
     char               *r = (char *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_SHORT) {
     const short        *s = (short *) sendbuf;
     short              *r = (short *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_SHORT) {
     const unsigned short *s = (unsigned short *) sendbuf;
     unsigned short     *r = (unsigned short *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_INT) {
     const int          *s = (int *) sendbuf;
     int                *r = (int *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED) {
     const unsigned     *s = (unsigned *) sendbuf;
     unsigned           *r = (unsigned *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_LONG) {
     const long         *s = (long *) sendbuf;
     long               *r = (long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_UNSIGNED_LONG) {
     const unsigned long *s = (unsigned long *) sendbuf;
     unsigned long      *r = (unsigned long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_LONG_LONG_INT) {
     const long long    *s = (long long *) sendbuf;
     long long          *r = (long long *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_FLOAT) {
     const float        *s = (float *) sendbuf;
     float              *r = (float *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_DOUBLE) {
     const double       *s = (double *) sendbuf;
     double             *r = (double *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
   else if (sendtype == sc_MPI_LONG_DOUBLE) {
     const long double  *s = (long double *) sendbuf;
     long double        *r = (long double *) recvbuf;
+    SC_REDUCE_FOR
     for (i = 0; i < sendcount; ++i)
       r[i] += s[i];
   }
@@ -473,6 +494,32 @@ sc_reduce_sum (void *sendbuf, void *recvbuf,
   }
 }
 
+/** Add two arrays of double-double numbers stored as (high, low) pairs.
+ * The rounding error of each high sum is recovered by Knuth's TwoSum and
+ * carried along in the low part, which must not be optimized away.
+ */
+static void
+sc_reduce_sum_compensated (void *sendbuf, void *recvbuf,
+                           int sendcount, sc_MPI_Datatype sendtype)
+{
+  int                 i;
+  const double       *s = (double *) sendbuf;
+  double             *r = (double *) recvbuf;
+  volatile double     sum, bp, err;
+
+  SC_ASSERT (sendtype == sc_MPI_DOUBLE);
+  SC_ASSERT (sendcount % 2 == 0);
+
+  for (i = 0; i < sendcount; i += 2) {
+    sum = s[i] + r[i];
+    bp = sum - s[i];
+    err = (s[i] - (sum - bp)) + (r[i] - bp);
+    err += s[i + 1] + r[i + 1];
+    r[i] = sum + err;
+    r[i + 1] = err - (r[i] - sum);
+  }
+}
+
 static int
 sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
                            sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
@@ -499,8 +546,10 @@ sc_reduce_custom_dispatch (void *sendbuf, void *recvbuf, int sendcount,
   SC_ASSERT (-1 <= target && target < mpisize);
 
   maxlevel = SC_LOG2_32 (mpisize - 1) + 1;
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_REDUCE);
   sc_reduce_recursive (mpicomm, recvbuf, sendcount, sendtype, mpisize,
                        target, maxlevel, maxlevel, mpirank, reduce_fn);
+  sc_mpi_stats_leave ();
 
   return sc_MPI_SUCCESS;
 }
@@ -565,3 +614,298 @@ sc_reduce (void *sendbuf, void *recvbuf, int sendcount,
   return sc_reduce_dispatch (sendbuf, recvbuf, sendcount,
                              sendtype, operation, target, mpicomm);
 }
+
+static int
+sc_reduce_sum_reproducible_dispatch (const double *sendbuf, double *recvbuf,
+                                     int count, int target,
+                                     sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 i;
+  double             *pairs, *result;
+
+  SC_ASSERT (count >= 0);
+
+  pairs = SC_ALLOC (double, 4 * count);
+  result = pairs + 2 * count;
+  for (i = 0; i < count; ++i) {
+    pairs[2 * i] = sendbuf[i];
+    pairs[2 * i + 1] = 0.;
+  }
+  mpiret = sc_reduce_custom_dispatch (pairs, result, 2 * count,
+                                      sc_MPI_DOUBLE,
+                                      sc_reduce_sum_compensated,
+                                      target, mpicomm);
+  for (i = 0; i < count; ++i) {
+    recvbuf[i] = result[2 * i] + result[2 * i + 1];
+  }
+  SC_FREE (pairs);
+
+  return mpiret;
+}
+
+int
+sc_allreduce_sum_reproducible (const double *sendbuf, double *recvbuf,
+                               int count, sc_MPI_Comm mpicomm)
+{
+  return sc_reduce_sum_reproducible_dispatch (sendbuf, recvbuf, count,
+                                              -1, mpicomm);
+}
+
+int
+sc_reduce_sum_reproducible (const double *sendbuf, double *recvbuf,
+                            int count, int target, sc_MPI_Comm mpicomm)
+{
+  SC_CHECK_ABORT (target >= 0,
+                  "sc_reduce_sum_reproducible requires non-negative target");
+
+  return sc_reduce_sum_reproducible_dispatch (sendbuf, recvbuf, count,
+                                              target, mpicomm);
+}
+
+struct sc_reduce_request
+{
+  sc_MPI_Comm         mpicomm;
+  sc_MPI_Datatype     datatype;
+  sc_reduce_t         reduce_fn;
+  int                 mpisize, mpirank, maxlevel;
+  int                 count, segcount, nseg;
+  size_t              typesize;
+  char               *data, *peerdata;
+
+  /* the rank receives the result at mylevel and sends up there before */
+  int                 mylevel, level, phase, posted, combined;
+  char               *segdone;
+  sc_MPI_Request     *recvreqs;
+  sc_MPI_Request     *sendreqs;
+  int                 num_sends;
+};
+
+enum
+{
+  SC_IREDUCE_UP,
+  SC_IREDUCE_DOWN,
+  SC_IREDUCE_FINISH,
+  SC_IREDUCE_DONE
+};
+
+#ifdef SC_ENABLE_MPI
+
+/** Post one non-blocking message per segment of the data. */
+static void
+sc_ireduce_segments (sc_reduce_request_t * req, char *buffer, int peer,
+                     int send, sc_MPI_Request * requests)
+{
+  int                 mpiret;
+  int                 j, first, num;
+
+  for (j = 0; j < req->nseg; ++j) {
+    first = j * req->segcount;
+    num = SC_MIN (req->segcount, req->count - first);
+    if (send) {
+      mpiret = sc_mpi_isend_large (buffer + first * req->typesize,
+                                   num * req->typesize, peer, SC_TAG_IREDUCE,
+                                   req->mpicomm, requests + j);
+    }
+    else {
+      mpiret = sc_mpi_irecv_large (buffer + first * req->typesize,
+                                   num * req->typesize, peer, SC_TAG_IREDUCE,
+                                   req->mpicomm, requests + j);
+    }
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+#endif /* SC_ENABLE_MPI */
+
+sc_reduce_request_t *
+sc_iallreduce_custom (void *sendbuf, void *recvbuf, int sendcount,
+                      sc_MPI_Datatype sendtype, sc_reduce_t reduce_fn,
+                      int segcount, sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  sc_reduce_request_t *req;
+
+  SC_ASSERT (sendcount >= 0);
+  SC_ASSERT (reduce_fn != NULL);
+
+  req = SC_ALLOC_ZERO (sc_reduce_request_t, 1);
+  req->mpicomm = mpicomm;
+  req->datatype = sendtype;
+  req->reduce_fn = reduce_fn;
+  req->count = sendcount;
+  req->segcount = (segcount <= 0 || segcount > sendcount) ?
+    SC_MAX (sendcount, 1) : segcount;
+  req->nseg = (sendcount + req->segcount - 1) / req->segcount;
+  req->typesize = sc_mpi_sizeof (sendtype);
+  req->data = (char *) recvbuf;
+  memcpy (recvbuf, sendbuf, sendcount * req->typesize);
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &req->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &req->mpirank);
+  SC_CHECK_MPI (mpiret);
+  req->maxlevel = SC_LOG2_32 (req->mpisize - 1) + 1;
+
+  /* the lowest set bit of a nonzero rank determines its parent's level */
+  req->mylevel = 0;
+  if (req->mpirank > 0) {
+    req->mylevel = req->maxlevel -
+      SC_LOG2_32 (req->mpirank & -req->mpirank);
+  }
+  req->level = req->maxlevel;
+  req->phase = SC_IREDUCE_UP;
+  if (req->mpisize == 1 || req->count == 0) {
+    req->phase = SC_IREDUCE_DONE;
+    return req;
+  }
+
+  req->peerdata = SC_ALLOC (char, sendcount * req->typesize);
+  req->segdone = SC_ALLOC (char, req->nseg);
+  req->recvreqs = SC_ALLOC (sc_MPI_Request, req->nseg);
+  req->sendreqs = SC_ALLOC (sc_MPI_Request, (req->maxlevel + 1) * req->nseg);
+
+  sc_reduce_test (req);
+  return req;
+}
+
+/** Advance the messages of a nonblocking reduction.
+ * \return             True if the reduction is complete.
+ */
+static int
+sc_reduce_progress (sc_reduce_request_t * req)
+{
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+  int                 j, flag, stride, peer, first;
+  int                 l;
+
+  for (;;) {
+    switch (req->phase) {
+    case SC_IREDUCE_UP:
+      if (req->level == req->mylevel) {
+        if (req->mylevel > 0) {
+          /* hand the partial result to the parent */
+          stride = 1 << (req->maxlevel - req->level);
+          sc_ireduce_segments (req, req->data, req->mpirank - stride, 1,
+                               req->sendreqs);
+          req->num_sends = req->nseg;
+        }
+        req->phase = SC_IREDUCE_DOWN;
+        break;
+      }
+      stride = 1 << (req->maxlevel - req->level);
+      peer = req->mpirank + stride;
+      if (peer >= req->mpisize) {
+        --req->level;
+        break;
+      }
+      if (!req->posted) {
+        sc_ireduce_segments (req, req->peerdata, peer, 0, req->recvreqs);
+        memset (req->segdone, 0, req->nseg);
+        req->posted = 1;
+        req->combined = 0;
+      }
+
+      /* combine every segment that has arrived */
+      for (j = 0; j < req->nseg; ++j) {
+        if (req->segdone[j]) {
+          continue;
+        }
+        mpiret = MPI_Test (req->recvreqs + j, &flag, MPI_STATUS_IGNORE);
+        SC_CHECK_MPI (mpiret);
+        if (flag) {
+          first = j * req->segcount;
+          req->reduce_fn (req->peerdata + first * req->typesize,
+                          req->data + first * req->typesize,
+                          SC_MIN (req->segcount, req->count - first),
+                          req->datatype);
+          req->segdone[j] = 1;
+          ++req->combined;
+        }
+      }
+      if (req->combined < req->nseg) {
+        return 0;
+      }
+      req->posted = 0;
+      --req->level;
+      break;
+    case SC_IREDUCE_DOWN:
+      if (req->mylevel > 0) {
+        /* the send buffer is about to receive the result */
+        if (!req->posted) {
+          mpiret = MPI_Testall (req->num_sends, req->sendreqs, &flag,
+                                MPI_STATUSES_IGNORE);
+          SC_CHECK_MPI (mpiret);
+          if (!flag) {
+            return 0;
+          }
+          stride = 1 << (req->maxlevel - req->mylevel);
+          sc_ireduce_segments (req, req->data, req->mpirank - stride, 0,
+                               req->recvreqs);
+          req->num_sends = 0;
+          req->posted = 1;
+        }
+        mpiret = MPI_Testall (req->nseg, req->recvreqs, &flag,
+                              MPI_STATUSES_IGNORE);
+        SC_CHECK_MPI (mpiret);
+        if (!flag) {
+          return 0;
+        }
+      }
+
+      /* pass the result on to the children */
+      for (l = req->mylevel + 1; l <= req->maxlevel; ++l) {
+        peer = req->mpirank + (1 << (req->maxlevel - l));
+        if (peer < req->mpisize) {
+          sc_ireduce_segments (req, req->data, peer, 1,
+                               req->sendreqs + req->num_sends);
+          req->num_sends += req->nseg;
+        }
+      }
+      req->phase = SC_IREDUCE_FINISH;
+      break;
+    case SC_IREDUCE_FINISH:
+      mpiret = MPI_Testall (req->num_sends, req->sendreqs, &flag,
+                            MPI_STATUSES_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      if (!flag) {
+        return 0;
+      }
+      req->phase = SC_IREDUCE_DONE;
+      break;
+    case SC_IREDUCE_DONE:
+      return 1;
+    default:
+      SC_ABORT_NOT_REACHED ();
+    }
+  }
+#else
+  SC_ASSERT (req->phase == SC_IREDUCE_DONE);
+  return 1;
+#endif
+}
+
+int
+sc_reduce_test (sc_reduce_request_t * req)
+{
+  int                 done;
+
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_REDUCE);
+  done = sc_reduce_progress (req);
+  sc_mpi_stats_leave ();
+  return done;
+}
+
+void
+sc_reduce_end (sc_reduce_request_t * req)
+{
+  while (!sc_reduce_test (req)) {
+    /* a blocking wait would not progress the other messages */
+  }
+  SC_FREE (req->peerdata);
+  SC_FREE (req->segdone);
+  SC_FREE (req->recvreqs);
+  SC_FREE (req->sendreqs);
+  SC_FREE (req);
+}
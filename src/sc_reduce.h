@@ -31,8 +31,16 @@
 #define SC_REDUCE_ALLTOALL_LEVEL        3
 #endif
 
+/* with OpenMP, combine loops of at least this many elements are threaded */
+#ifndef SC_REDUCE_OPENMP_MIN
+#define SC_REDUCE_OPENMP_MIN            (1 << 18)
+#endif
+
 SC_EXTERN_C_BEGIN;
 
+/** Opaque object for a non-blocking reduction in progress */
+typedef struct sc_reduce_request sc_reduce_request_t;
+
 typedef void        (*sc_reduce_t) (void *sendbuf, void *recvbuf,
                                     int sendcount, sc_MPI_Datatype sendtype);
 
@@ -52,7 +60,47 @@ int                 sc_reduce_custom (void *sendbuf, void *recvbuf,
                                       sc_reduce_t reduce_fn,
                                       int target, sc_MPI_Comm mpicomm);
 
+/** Start a custom allreduce operation that completes in the background.
+ * The data is combined over the same binary tree as \ref
+ * sc_allreduce_custom, such that both produce bitwise identical results.
+ * Progress is made only inside \ref sc_reduce_test and \ref sc_reduce_end.
+ * At most one request may be in progress on a communicator at a time.
+ * \param [in] sendbuf  Local input; may be reused after this call returns.
+ * \param [out] recvbuf Result; must remain untouched until the request
+ *                      has completed.
+ * \param [in] segcount If positive and less than \a sendcount, the data is
+ *                      communicated in segments of this many elements and
+ *                      each segment is combined as soon as it arrives.
+ *                      Messages beyond INT_MAX bytes are supported.
+ * \return              Request to pass to \ref sc_reduce_test and
+ *                      \ref sc_reduce_end.
+ */
+sc_reduce_request_t *sc_iallreduce_custom (void *sendbuf, void *recvbuf,
+                                           int sendcount,
+                                           sc_MPI_Datatype sendtype,
+                                           sc_reduce_t reduce_fn,
+                                           int segcount,
+                                           sc_MPI_Comm mpicomm);
+
+/** Progress a non-blocking reduction without blocking.
+ * \param [in,out] request  Request returned by \ref sc_iallreduce_custom.
+ * \return                  True if the reduction has completed.
+ *                          Then \ref sc_reduce_end will not block.
+ */
+int                 sc_reduce_test (sc_reduce_request_t * request);
+
+/** Wait for a non-blocking reduction to complete.
+ * \param [in] request  Request returned by \ref sc_iallreduce_custom;
+ *                      it is destroyed.
+ */
+void                sc_reduce_end (sc_reduce_request_t * request);
+
 /** Drop-in MPI_Allreduce replacement.
+ * Supports sc_MPI_MAX, sc_MPI_MIN and sc_MPI_SUM on the basic types.
+ * The partial results are always combined in the same binary tree order,
+ * independent of the arrival of messages, so for a fixed communicator
+ * size the result is bitwise reproducible from run to run.
+ * To keep one copy of the result per node, see \ref sc_shmem_allreduce.
  */
 int                 sc_allreduce (void *sendbuf, void *recvbuf, int sendcount,
                                   sc_MPI_Datatype sendtype,
@@ -65,6 +113,28 @@ int                 sc_reduce (void *sendbuf, void *recvbuf, int sendcount,
                                sc_MPI_Datatype sendtype, sc_MPI_Op operation,
                                int target, sc_MPI_Comm mpicomm);
 
+/** Allreduce sum of doubles with compensated (double-double) summation.
+ * Each partial sum carries its rounding error along the reduction tree,
+ * which makes the result accurate to nearly twice the working precision
+ * and, like \ref sc_allreduce, bitwise reproducible for a fixed
+ * communicator size.  The compensation is lost under -ffast-math.
+ * \param [in] sendbuf  Array of \a count local values.
+ * \param [out] recvbuf Array of \a count rounded global sums.
+ */
+int                 sc_allreduce_sum_reproducible (const double *sendbuf,
+                                                   double *recvbuf,
+                                                   int count,
+                                                   sc_MPI_Comm mpicomm);
+
+/** Reduce sum of doubles with compensated summation.
+ * \see sc_allreduce_sum_reproducible.
+ * \param [in] target   The MPI rank that obtains the result.
+ */
+int                 sc_reduce_sum_reproducible (const double *sendbuf,
+                                                double *recvbuf, int count,
+                                                int target,
+                                                sc_MPI_Comm mpicomm);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_REDUCE_H */
@@ -23,6 +23,9 @@
 
 #include <sc_private.h>
 #include <sc_refcount.h>
+#if !defined SC_REFCOUNT_ATOMIC && defined SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
 
 void
 sc_refcount_init_invalid (sc_refcount_t * rc)
@@ -108,3 +111,84 @@ sc_refcount_is_last (const sc_refcount_t * rc)
 
   return rc->refcount == 1;
 }
+
+void
+sc_refcount_atomic_init (sc_refcount_atomic_t * rc, int package_id)
+{
+  SC_ASSERT (rc != NULL);
+  SC_ASSERT (package_id == -1 || sc_package_is_registered (package_id));
+
+  rc->package_id = package_id;
+  rc->refcount = 1;
+
+#ifdef SC_ENABLE_DEBUG
+  sc_package_rc_count_add (rc->package_id, 1);
+#endif
+}
+
+sc_refcount_atomic_t *
+sc_refcount_atomic_new (int package_id)
+{
+  sc_refcount_atomic_t *rc;
+
+  rc = SC_ALLOC (sc_refcount_atomic_t, 1);
+  sc_refcount_atomic_init (rc, package_id);
+
+  return rc;
+}
+
+void
+sc_refcount_atomic_destroy (sc_refcount_atomic_t * rc)
+{
+  SC_ASSERT (rc != NULL);
+  SC_ASSERT (!sc_refcount_atomic_is_active (rc));
+
+  SC_FREE (rc);
+}
+
+void
+sc_refcount_atomic_check (int count)
+{
+  SC_CHECK_ABORTF (count > 0, "Atomic reference count %d not positive",
+                   count);
+}
+
+void
+sc_refcount_atomic_released (const sc_refcount_atomic_t * rc)
+{
+  SC_ASSERT (rc != NULL);
+
+  sc_package_rc_count_add (rc->package_id, -1);
+}
+
+#ifndef SC_REFCOUNT_ATOMIC
+
+#ifdef SC_ENABLE_PTHREAD
+static pthread_mutex_t sc_refcount_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+int
+sc_refcount_atomic_add (sc_refcount_atomic_t * rc, int toadd)
+{
+  int                 count;
+
+  SC_ASSERT (rc != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_refcount_mutex);
+#endif
+#ifdef SC_ENABLE_OPENMP
+#pragma omp critical (sc_refcount)
+#endif
+  {
+    count = rc->refcount;
+    rc->refcount += toadd;
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_refcount_mutex);
+#endif
+
+  return count;
+}
+
+#endif /* !SC_REFCOUNT_ATOMIC */
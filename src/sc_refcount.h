@@ -27,6 +27,10 @@
  * The functions in this file can be used for multiple purposes.
  * The current setup is not so much targeted at garbage collection but rather
  * intended for debugging and verification.
+ *
+ * The plain \ref sc_refcount_t is meant for single-threaded use.
+ * Objects shared between threads use \ref sc_refcount_atomic_t, whose
+ * counting functions are inline and atomic.
  */
 
 #ifndef SC_REFCOUNT_H
@@ -115,6 +119,150 @@ int                 sc_refcount_is_active (const sc_refcount_t * rc);
  */
 int                 sc_refcount_is_last (const sc_refcount_t * rc);
 
+#if defined __GNUC__ && defined __ATOMIC_RELAXED
+/** The atomic reference counter uses compiler builtins. */
+#define SC_REFCOUNT_ATOMIC
+#endif
+
+/** A reference counter that may be updated by multiple threads.
+ * Its members should never be accessed directly.
+ */
+typedef struct sc_refcount_atomic
+{
+  /** The sc package that uses this reference counter. */
+  int                 package_id;
+
+  /** The reference count is always positive for a valid counter. */
+  int                 refcount;
+}
+sc_refcount_atomic_t;
+
+/** Initialize an atomic reference counter to 1.
+ * This call must happen before the counter is shared between threads.
+ * \param [out] rc          This reference counter is initialized to one.
+ * \param [in] package_id   Either -1 or a package registered to libsc.
+ */
+void                sc_refcount_atomic_init (sc_refcount_atomic_t * rc,
+                                             int package_id);
+
+/** Create a new atomic reference counter with count initialized to 1.
+ * \param [in] package_id   Either -1 or a package registered to libsc.
+ * \return                  A reference counter with count one.
+ */
+sc_refcount_atomic_t *sc_refcount_atomic_new (int package_id);
+
+/** Destroy an atomic reference counter that has reached count zero.
+ * \param [in,out] rc       This reference counter must have count zero.
+ */
+void                sc_refcount_atomic_destroy (sc_refcount_atomic_t * rc);
+
+/** Verify the count seen by an atomic update; aborts if it is invalid.
+ * Called by the inline functions in debug mode only.
+ * \param [in] count        The count before the update, must be positive.
+ */
+void                sc_refcount_atomic_check (int count);
+
+/** Account for an atomic counter that has reached zero.
+ * Called by \ref sc_refcount_atomic_unref in debug mode only.
+ * \param [in] rc           This reference counter has reached zero.
+ */
+void                sc_refcount_atomic_released (const sc_refcount_atomic_t
+                                                 * rc);
+
+#ifndef SC_REFCOUNT_ATOMIC
+/** Add to an atomic reference counter under a lock.
+ * This fallback is used when the compiler has no atomic builtins.
+ * \param [in,out] rc       This reference counter is modified.
+ * \param [in] toadd        Usually 1 or -1; 0 reads the count.
+ * \return                  The count before the addition.
+ */
+int                 sc_refcount_atomic_add (sc_refcount_atomic_t * rc,
+                                            int toadd);
+#endif
+
+/** Increase an atomic reference counter.
+ * The caller must already hold a reference, thus no ordering is needed.
+ * \param [in,out] rc       This reference counter must be greater zero.
+ */
+static inline void
+sc_refcount_atomic_ref (sc_refcount_atomic_t * rc)
+{
+  int                 count;
+
+#ifdef SC_REFCOUNT_ATOMIC
+  count = __atomic_fetch_add (&rc->refcount, 1, __ATOMIC_RELAXED);
+#else
+  count = sc_refcount_atomic_add (rc, 1);
+#endif
+#ifdef SC_ENABLE_DEBUG
+  sc_refcount_atomic_check (count);
+#else
+  (void) count;
+#endif
+}
+
+/** Decrease an atomic reference counter and notify when it reaches zero.
+ * Decrements have release semantics and the thread that reaches zero
+ * acquires them, so it sees all writes made to the object by threads
+ * that released their references before.
+ * \param [in,out] rc       This reference counter must be greater zero.
+ * \return          True if the count has reached zero, false otherwise.
+ */
+static inline int
+sc_refcount_atomic_unref (sc_refcount_atomic_t * rc)
+{
+  int                 count;
+
+#ifdef SC_REFCOUNT_ATOMIC
+  count = __atomic_fetch_sub (&rc->refcount, 1, __ATOMIC_RELEASE);
+#else
+  count = sc_refcount_atomic_add (rc, -1);
+#endif
+#ifdef SC_ENABLE_DEBUG
+  sc_refcount_atomic_check (count);
+#endif
+  if (count == 1) {
+#ifdef SC_REFCOUNT_ATOMIC
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+#endif
+#ifdef SC_ENABLE_DEBUG
+    sc_refcount_atomic_released (rc);
+#endif
+    return 1;
+  }
+  return 0;
+}
+
+/** Check whether an atomic reference counter has a positive value.
+ * \param [in] rc   A reference counter.
+ * \return          True if the count is greater zero, false otherwise.
+ */
+static inline int
+sc_refcount_atomic_is_active (const sc_refcount_atomic_t * rc)
+{
+#ifdef SC_REFCOUNT_ATOMIC
+  return __atomic_load_n (&rc->refcount, __ATOMIC_ACQUIRE) > 0;
+#else
+  return sc_refcount_atomic_add ((sc_refcount_atomic_t *) rc, 0) > 0;
+#endif
+}
+
+/** Check whether an atomic reference counter has value one.
+ * If so, the caller holds the only reference and no other thread can
+ * obtain a new one from it.
+ * \param [in] rc   A reference counter.
+ * \return          True if the count is exactly one.
+ */
+static inline int
+sc_refcount_atomic_is_last (const sc_refcount_atomic_t * rc)
+{
+#ifdef SC_REFCOUNT_ATOMIC
+  return __atomic_load_n (&rc->refcount, __ATOMIC_ACQUIRE) == 1;
+#else
+  return sc_refcount_atomic_add ((sc_refcount_atomic_t *) rc, 0) == 1;
+#endif
+}
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_REFCOUNT_H */
@@ -0,0 +1,280 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_ringbuf.h>
+
+#if defined __GNUC__ && defined __ATOMIC_RELAXED
+#define SC_RINGBUF_LOAD(p,o) __atomic_load_n ((p), __ATOMIC_ ## o)
+#define SC_RINGBUF_STORE(p,v,o) __atomic_store_n ((p), (v), __ATOMIC_ ## o)
+#define SC_RINGBUF_CAS(p,e,v) \
+  __atomic_compare_exchange_n ((p), (e), (v), 1, __ATOMIC_RELAXED, \
+                               __ATOMIC_RELAXED)
+#else
+/* without atomic builtins the queue is restricted to one thread */
+#define SC_RINGBUF_LOAD(p,o) (*(p))
+#define SC_RINGBUF_STORE(p,v,o) (*(p) = (v))
+#define SC_RINGBUF_CAS(p,e,v) \
+  (*(p) == *(e) ? (*(p) = (v), 1) : (*(e) = *(p), 0))
+#endif
+
+/* distance between the positions of the two ends */
+#define SC_RINGBUF_LINE 128
+
+struct sc_ringbuf
+{
+  /* constant after creation */
+  size_t              elem_size;
+  size_t              mask;     /**< capacity minus one */
+  sc_ringbuf_mode_t   mode;
+  char               *data;
+  size_t             *seq;      /**< per-slot sequence in MPMC mode */
+  char                pad0[SC_RINGBUF_LINE];
+
+  /* written by producers */
+  size_t              head;     /**< total number of elements pushed */
+  size_t              tail_cache;       /**< SPSC producer's view of tail */
+  char                pad1[SC_RINGBUF_LINE - 2 * sizeof (size_t)];
+
+  /* written by consumers */
+  size_t              tail;     /**< total number of elements popped */
+  size_t              head_cache;       /**< SPSC consumer's view of head */
+  char                pad2[SC_RINGBUF_LINE - 2 * sizeof (size_t)];
+};
+
+sc_ringbuf_t       *
+sc_ringbuf_new (size_t elem_size, size_t capacity, sc_ringbuf_mode_t mode)
+{
+  size_t              cap, zz;
+  sc_ringbuf_t       *rb;
+
+  SC_ASSERT (mode == SC_RINGBUF_SPSC || mode == SC_RINGBUF_MPMC);
+
+  for (cap = 1; cap < capacity; cap *= 2);
+
+  rb = SC_ALLOC_ZERO (sc_ringbuf_t, 1);
+  rb->elem_size = elem_size;
+  rb->mask = cap - 1;
+  rb->mode = mode;
+  rb->data = SC_ALLOC (char, SC_MAX (cap * elem_size, 1));
+  if (mode == SC_RINGBUF_MPMC) {
+    rb->seq = SC_ALLOC (size_t, cap);
+    for (zz = 0; zz < cap; ++zz) {
+      rb->seq[zz] = zz;
+    }
+  }
+
+  return rb;
+}
+
+void
+sc_ringbuf_destroy (sc_ringbuf_t * rb)
+{
+  SC_FREE (rb->seq);
+  SC_FREE (rb->data);
+  SC_FREE (rb);
+}
+
+size_t
+sc_ringbuf_capacity (sc_ringbuf_t * rb)
+{
+  return rb->mask + 1;
+}
+
+size_t
+sc_ringbuf_size (sc_ringbuf_t * rb)
+{
+  size_t              head, tail;
+
+  tail = SC_RINGBUF_LOAD (&rb->tail, ACQUIRE);
+  head = SC_RINGBUF_LOAD (&rb->head, ACQUIRE);
+
+  /* a concurrent pop may have passed the head we read */
+  return head - tail <= rb->mask + 1 ? head - tail : 0;
+}
+
+/* copy n elements into the ring starting at position pos */
+static void
+sc_ringbuf_copy_in (sc_ringbuf_t * rb, size_t pos, size_t n,
+                    const char *elems)
+{
+  size_t              start, first;
+
+  start = pos & rb->mask;
+  first = SC_MIN (n, rb->mask + 1 - start);
+  memcpy (rb->data + start * rb->elem_size, elems, first * rb->elem_size);
+  memcpy (rb->data, elems + first * rb->elem_size,
+          (n - first) * rb->elem_size);
+}
+
+/* copy n elements out of the ring starting at position pos */
+static void
+sc_ringbuf_copy_out (sc_ringbuf_t * rb, size_t pos, size_t n, char *elems)
+{
+  size_t              start, first;
+
+  start = pos & rb->mask;
+  first = SC_MIN (n, rb->mask + 1 - start);
+  memcpy (elems, rb->data + start * rb->elem_size, first * rb->elem_size);
+  memcpy (elems + first * rb->elem_size, rb->data,
+          (n - first) * rb->elem_size);
+}
+
+/* claim one slot for a producer, or return 0 if the queue is full */
+static int
+sc_ringbuf_mpmc_push (sc_ringbuf_t * rb, const void *elem)
+{
+  size_t              pos, seq;
+  ptrdiff_t           dif;
+
+  pos = SC_RINGBUF_LOAD (&rb->head, RELAXED);
+  for (;;) {
+    seq = SC_RINGBUF_LOAD (&rb->seq[pos & rb->mask], ACQUIRE);
+    dif = (ptrdiff_t) (seq - pos);
+    if (dif == 0) {
+      if (SC_RINGBUF_CAS (&rb->head, &pos, pos + 1)) {
+        break;
+      }
+    }
+    else if (dif < 0) {
+      /* the slot still holds an element from the previous round */
+      return 0;
+    }
+    else {
+      pos = SC_RINGBUF_LOAD (&rb->head, RELAXED);
+    }
+  }
+  sc_ringbuf_copy_in (rb, pos, 1, (const char *) elem);
+  SC_RINGBUF_STORE (&rb->seq[pos & rb->mask], pos + 1, RELEASE);
+  return 1;
+}
+
+/* claim one slot for a consumer, or return 0 if the queue is empty */
+static int
+sc_ringbuf_mpmc_pop (sc_ringbuf_t * rb, void *elem)
+{
+  size_t              pos, seq;
+  ptrdiff_t           dif;
+
+  pos = SC_RINGBUF_LOAD (&rb->tail, RELAXED);
+  for (;;) {
+    seq = SC_RINGBUF_LOAD (&rb->seq[pos & rb->mask], ACQUIRE);
+    dif = (ptrdiff_t) (seq - (pos + 1));
+    if (dif == 0) {
+      if (SC_RINGBUF_CAS (&rb->tail, &pos, pos + 1)) {
+        break;
+      }
+    }
+    else if (dif < 0) {
+      /* the slot has not been filled in this round */
+      return 0;
+    }
+    else {
+      pos = SC_RINGBUF_LOAD (&rb->tail, RELAXED);
+    }
+  }
+  if (elem != NULL) {
+    sc_ringbuf_copy_out (rb, pos, 1, (char *) elem);
+  }
+  SC_RINGBUF_STORE (&rb->seq[pos & rb->mask], pos + rb->mask + 1, RELEASE);
+  return 1;
+}
+
+size_t
+sc_ringbuf_push_n (sc_ringbuf_t * rb, size_t n, const void *elems)
+{
+  size_t              head, avail, i;
+
+  if (rb->mode == SC_RINGBUF_MPMC) {
+    for (i = 0; i < n; ++i) {
+      if (!sc_ringbuf_mpmc_push
+          (rb, (const char *) elems + i * rb->elem_size)) {
+        break;
+      }
+    }
+    return i;
+  }
+
+  /* only this thread writes the head */
+  head = rb->head;
+  avail = rb->mask + 1 - (head - rb->tail_cache);
+  if (avail < n) {
+    rb->tail_cache = SC_RINGBUF_LOAD (&rb->tail, ACQUIRE);
+    avail = rb->mask + 1 - (head - rb->tail_cache);
+  }
+  n = SC_MIN (n, avail);
+  if (n > 0) {
+    sc_ringbuf_copy_in (rb, head, n, (const char *) elems);
+    SC_RINGBUF_STORE (&rb->head, head + n, RELEASE);
+  }
+  return n;
+}
+
+size_t
+sc_ringbuf_pop_n (sc_ringbuf_t * rb, size_t n, void *elems)
+{
+  size_t              tail, avail, i;
+
+  if (rb->mode == SC_RINGBUF_MPMC) {
+    for (i = 0; i < n; ++i) {
+      if (!sc_ringbuf_mpmc_pop (rb, elems == NULL ? NULL :
+                                (char *) elems + i * rb->elem_size)) {
+        break;
+      }
+    }
+    return i;
+  }
+
+  /* only this thread writes the tail */
+  tail = rb->tail;
+  avail = rb->head_cache - tail;
+  if (avail < n) {
+    rb->head_cache = SC_RINGBUF_LOAD (&rb->head, ACQUIRE);
+    avail = rb->head_cache - tail;
+  }
+  n = SC_MIN (n, avail);
+  if (n > 0) {
+    if (elems != NULL) {
+      sc_ringbuf_copy_out (rb, tail, n, (char *) elems);
+    }
+    SC_RINGBUF_STORE (&rb->tail, tail + n, RELEASE);
+  }
+  return n;
+}
+
+int
+sc_ringbuf_push (sc_ringbuf_t * rb, const void *elem)
+{
+  if (rb->mode == SC_RINGBUF_MPMC) {
+    return sc_ringbuf_mpmc_push (rb, elem);
+  }
+  return (int) sc_ringbuf_push_n (rb, 1, elem);
+}
+
+int
+sc_ringbuf_pop (sc_ringbuf_t * rb, void *elem)
+{
+  if (rb->mode == SC_RINGBUF_MPMC) {
+    return sc_ringbuf_mpmc_pop (rb, elem);
+  }
+  return (int) sc_ringbuf_pop_n (rb, 1, elem);
+}
@@ -0,0 +1,118 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_ringbuf.h
+ *
+ * A bounded queue of fixed-size elements for passing work between threads.
+ *
+ * The queue lives in one array whose capacity is a power of two.  It does
+ * not take locks.  The producer and consumer positions sit on different
+ * cache lines so that threads on the two ends do not slow each other down.
+ * The single-producer single-consumer mode copies whole batches with one
+ * synchronization.  The multiple-producer multiple-consumer mode tags
+ * every slot with a sequence number and claims slots by compare and swap.
+ *
+ * Push and pop never block.  They report a full or empty queue, so callers
+ * can choose to spin, yield or wait on a condition variable.
+ * The queue is thread safe if the compiler provides the GNU atomic
+ * builtins.  Otherwise, it must only be used by one thread.
+ */
+
+#ifndef SC_RINGBUF_H
+#define SC_RINGBUF_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Who may access the two ends of the queue. */
+typedef enum sc_ringbuf_mode
+{
+  SC_RINGBUF_SPSC,      /**< one producer and one consumer thread */
+  SC_RINGBUF_MPMC       /**< any number of producers and consumers */
+}
+sc_ringbuf_mode_t;
+
+/** Opaque ring buffer queue. */
+typedef struct sc_ringbuf sc_ringbuf_t;
+
+/** Create an empty ring buffer.
+ * \param [in] elem_size    Size of one element in bytes, may be zero.
+ * \param [in] capacity     Minimum number of elements that fit into the
+ *                          queue, rounded up to a power of two.
+ * \param [in] mode         Selects the synchronization protocol.
+ * \return                  Queue to be freed by \ref sc_ringbuf_destroy.
+ */
+sc_ringbuf_t       *sc_ringbuf_new (size_t elem_size, size_t capacity,
+                                    sc_ringbuf_mode_t mode);
+
+/** Free a ring buffer.  No other thread may access it any longer. */
+void                sc_ringbuf_destroy (sc_ringbuf_t * rb);
+
+/** Return the number of elements that fit into the queue. */
+size_t              sc_ringbuf_capacity (sc_ringbuf_t * rb);
+
+/** Return the number of elements in the queue.
+ * The value may be outdated by the time it is returned when other threads
+ * access the queue.
+ */
+size_t              sc_ringbuf_size (sc_ringbuf_t * rb);
+
+/** Append an element to the queue if there is space.
+ * \param [in,out] rb   The queue.
+ * \param [in] elem     Element of elem_size bytes copied into the queue.
+ * \return              True if the element was added, false if full.
+ */
+int                 sc_ringbuf_push (sc_ringbuf_t * rb, const void *elem);
+
+/** Remove the oldest element from the queue if there is one.
+ * \param [in,out] rb   The queue.
+ * \param [out] elem    If not NULL, receives the element.
+ * \return              True if an element was removed, false if empty.
+ */
+int                 sc_ringbuf_pop (sc_ringbuf_t * rb, void *elem);
+
+/** Append as many elements as fit, up to a given number.
+ * In the SPSC mode the elements are copied in at most two pieces and made
+ * visible to the consumer at once.  In the MPMC mode each element is
+ * claimed individually, so elements of concurrent producers interleave.
+ * \param [in,out] rb   The queue.
+ * \param [in] n        Number of elements offered.
+ * \param [in] elems    Array of \a n contiguous elements.
+ * \return              Number of leading elements that were added.
+ */
+size_t              sc_ringbuf_push_n (sc_ringbuf_t * rb, size_t n,
+                                       const void *elems);
+
+/** Remove as many elements as are available, up to a given number.
+ * \param [in,out] rb   The queue.
+ * \param [in] n        Maximum number of elements to remove.
+ * \param [out] elems   Array receiving up to \a n elements in order.
+ * \return              Number of elements that were removed.
+ */
+size_t              sc_ringbuf_pop_n (sc_ringbuf_t * rb, size_t n,
+                                      void *elems);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_RINGBUF_H */
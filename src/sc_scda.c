@@ -0,0 +1,745 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_scda.h>
+
+#define SC_SCDA_HEADER_BYTES 64
+#define SC_SCDA_TRAILER_BYTES 32
+#define SC_SCDA_VERSION 1
+
+/** Maximum bytes in one read call. */
+#define SC_SCDA_READ_BYTES ((size_t) 1 << 30)
+
+/* Without MPI there is a single rank and the file is read with stdio. */
+#if !defined SC_ENABLE_MPIIO && !defined SC_ENABLE_MPI
+#define SC_SCDA_STDIO
+#endif
+
+/** A section as loaded from the index. */
+typedef struct sc_scda_section
+{
+  char                name[SC_SCDA_NAME_BYTES];
+  size_t              elem_size;
+  sc_io_encode_t      encode;
+  size_t              num_chunks;
+  size_t              first_chunk;      /**< position in the chunk array */
+  size_t              elem_count;
+}
+sc_scda_section_t;
+
+/** A chunk as loaded from the index. */
+typedef struct sc_scda_chunk
+{
+  long long           offset;   /**< file offset of the stored bytes */
+  size_t              bytes;    /**< number of stored bytes */
+  size_t              first;    /**< global number of the first element */
+  size_t              count;    /**< number of elements */
+}
+sc_scda_chunk_t;
+
+struct sc_scda
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  int                 writing;
+
+  /* members used for writing */
+  sc_io_sink_t       *sink;
+  size_t              stripe_bytes;
+  long long           offset;   /**< file offset of the next section */
+  size_t              num_written;      /**< number of sections written */
+  sc_array_t         *index;    /**< index bytes, only on the first rank */
+
+  /* members used for reading */
+#if defined SC_ENABLE_MPIIO
+  MPI_File            fh;
+#elif defined SC_SCDA_STDIO
+  FILE               *file;
+#endif
+  sc_array_t         *sections;
+  sc_array_t         *chunks;
+};
+
+static void
+sc_scda_put (char *buf, uint64_t value)
+{
+  int                 i;
+
+  for (i = 0; i < 8; ++i) {
+    buf[i] = (char) (value >> (8 * i));
+  }
+}
+
+static              uint64_t
+sc_scda_get (const char *buf)
+{
+  int                 i;
+  uint64_t            value = 0;
+
+  for (i = 7; i >= 0; --i) {
+    value = (value << 8) | (unsigned char) buf[i];
+  }
+  return value;
+}
+
+/** Combine error flags of all ranks. */
+static int
+sc_scda_agree (sc_scda_t * scda, int error)
+{
+  int                 mpiret;
+  int                 any;
+
+  mpiret = sc_MPI_Allreduce (&error, &any, 1, sc_MPI_INT, sc_MPI_MAX,
+                             scda->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return any;
+}
+
+/** Track the file offset on the first rank after completing a section. */
+static void
+sc_scda_advance (sc_scda_t * scda, size_t bytes)
+{
+  if (scda->stripe_bytes > 0) {
+    bytes = (bytes + scda->stripe_bytes - 1) / scda->stripe_bytes *
+      scda->stripe_bytes;
+  }
+  scda->offset += (long long) bytes;
+}
+
+sc_scda_t          *
+sc_scda_open_write (sc_MPI_Comm mpicomm, const char *filename,
+                    const char *user_string,
+                    const sc_io_mpifile_hints_t * hints)
+{
+  int                 mpiret;
+  int                 error;
+  char                header[SC_SCDA_HEADER_BYTES];
+  sc_io_sink_t       *sink;
+  sc_scda_t          *scda;
+
+  sink = sc_io_sink_new (SC_IO_TYPE_MPIFILE, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, mpicomm, filename, hints);
+  if (sink == NULL) {
+    return NULL;
+  }
+
+  scda = SC_ALLOC_ZERO (sc_scda_t, 1);
+  scda->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &scda->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &scda->mpirank);
+  SC_CHECK_MPI (mpiret);
+  scda->writing = 1;
+  scda->sink = sink;
+  scda->stripe_bytes = hints != NULL ? hints->stripe_bytes : 0;
+
+  /* the first rank writes the header and keeps the index */
+  error = 0;
+  if (scda->mpirank == 0) {
+    memset (header, 0, SC_SCDA_HEADER_BYTES);
+    memcpy (header, "scdafile", 8);
+    sc_scda_put (header + 8, SC_SCDA_VERSION);
+    if (user_string != NULL) {
+      strncpy (header + 16, user_string, SC_SCDA_USER_BYTES - 1);
+    }
+    error = sc_io_sink_write (sink, header, SC_SCDA_HEADER_BYTES);
+    scda->index = sc_array_new (sizeof (char));
+  }
+  error = sc_io_sink_complete (sink, NULL, NULL) || error;
+  sc_scda_advance (scda, SC_SCDA_HEADER_BYTES);
+  if (sc_scda_agree (scda, error)) {
+    (void) sc_io_sink_destroy (sink);
+    if (scda->index != NULL) {
+      sc_array_destroy (scda->index);
+    }
+    SC_FREE (scda);
+    return NULL;
+  }
+  return scda;
+}
+
+int
+sc_scda_write (sc_scda_t * scda, const char *name,
+               sc_array_t * local, sc_io_encode_t encode)
+{
+  int                 mpiret;
+  int                 error;
+  int                 q;
+  char               *header;
+  const char         *data;
+  size_t              bytes, total, pos;
+  long long           check[5], checkmax[5];
+  long long           counts[2], *all;
+  sc_array_t         *encoded;
+  sc_io_sink_t       *esink;
+
+  SC_ASSERT (scda != NULL && scda->writing);
+  SC_ASSERT (name != NULL && local != NULL);
+
+  /* encode the local chunk */
+  error = strlen (name) >= SC_SCDA_NAME_BYTES ||
+    encode < SC_IO_ENCODE_NONE || encode >= SC_IO_ENCODE_LAST ||
+    !sc_io_encode_available (encode);
+  data = local->array;
+  bytes = local->elem_count * local->elem_size;
+  encoded = NULL;
+  if (!error && encode != SC_IO_ENCODE_NONE) {
+    encoded = sc_array_new (sizeof (char));
+    esink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE, encode,
+                            encoded);
+    if (esink == NULL) {
+      error = 1;
+    }
+    else {
+      error = sc_io_sink_write (esink, data, bytes);
+      error = sc_io_sink_destroy (esink) || error;
+    }
+    data = encoded->array;
+    bytes = encoded->elem_count;
+  }
+
+  /* all ranks must agree on the element size and encoding */
+  check[0] = error;
+  check[1] = (long long) local->elem_size;
+  check[2] = -(long long) local->elem_size;
+  check[3] = (long long) encode;
+  check[4] = -(long long) encode;
+  mpiret = sc_MPI_Allreduce (check, checkmax, 5, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_MAX, scda->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (checkmax[0] || checkmax[1] != -checkmax[2] ||
+      checkmax[3] != -checkmax[4]) {
+    if (encoded != NULL) {
+      sc_array_destroy (encoded);
+    }
+    return SC_IO_ERROR_FATAL;
+  }
+
+  /* the first rank collects the chunk sizes for the index */
+  counts[0] = (long long) bytes;
+  counts[1] = (long long) local->elem_count;
+  all = NULL;
+  if (scda->mpirank == 0) {
+    all = SC_ALLOC (long long, 2 * scda->mpisize);
+  }
+  mpiret = sc_MPI_Gather (counts, 2, sc_MPI_LONG_LONG_INT,
+                          all, 2, sc_MPI_LONG_LONG_INT, 0, scda->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* the section header precedes the chunks */
+  if (scda->mpirank == 0) {
+    pos = scda->index->elem_count;
+    sc_array_resize (scda->index, pos + SC_SCDA_HEADER_BYTES + 8 +
+                     16 * (size_t) scda->mpisize);
+    header = scda->index->array + pos;
+    memset (header, 0, SC_SCDA_HEADER_BYTES);
+    memcpy (header, "scdasect", 8);
+    strncpy (header + 8, name, SC_SCDA_NAME_BYTES - 1);
+    sc_scda_put (header + 40, local->elem_size);
+    sc_scda_put (header + 48, (uint64_t) encode);
+    sc_scda_put (header + 56, (uint64_t) scda->mpisize);
+    sc_scda_put (header + SC_SCDA_HEADER_BYTES, (uint64_t) scda->offset);
+    pos += SC_SCDA_HEADER_BYTES + 8;
+    total = SC_SCDA_HEADER_BYTES;
+    for (q = 0; q < scda->mpisize; ++q) {
+      sc_scda_put (scda->index->array + pos, (uint64_t) all[2 * q]);
+      sc_scda_put (scda->index->array + pos + 8, (uint64_t) all[2 * q + 1]);
+      pos += 16;
+      total += (size_t) all[2 * q];
+    }
+    SC_FREE (all);
+    error = sc_io_sink_write (scda->sink, header, SC_SCDA_HEADER_BYTES);
+    sc_scda_advance (scda, total);
+    ++scda->num_written;
+  }
+
+  /* write the section with one collective operation */
+  error = sc_io_sink_write (scda->sink, data, bytes) || error;
+  error = sc_io_sink_complete (scda->sink, NULL, NULL) || error;
+  if (encoded != NULL) {
+    sc_array_destroy (encoded);
+  }
+  return sc_scda_agree (scda, error) ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+/** Read bytes at a file offset independently of other ranks. */
+static int
+sc_scda_read_at (sc_scda_t * scda, long long offset, void *data,
+                 size_t bytes)
+{
+  size_t              pos, n;
+#if defined SC_ENABLE_MPIIO
+  int                 mpiret, icount;
+  sc_MPI_Status       mpistatus;
+
+  for (pos = 0; pos < bytes; pos += n) {
+    n = SC_MIN (SC_SCDA_READ_BYTES, bytes - pos);
+    mpiret = MPI_File_read_at (scda->fh, (MPI_Offset) (offset +
+                                                       (long long) pos),
+                               (char *) data + pos, (int) n, sc_MPI_BYTE,
+                               &mpistatus);
+    if (mpiret != sc_MPI_SUCCESS ||
+        sc_MPI_Get_count (&mpistatus, sc_MPI_BYTE, &icount) !=
+        sc_MPI_SUCCESS || icount != (int) n) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+#elif defined SC_SCDA_STDIO
+  if (fseek (scda->file, (long) offset, SEEK_SET)) {
+    return SC_IO_ERROR_FATAL;
+  }
+  for (pos = 0; pos < bytes; pos += n) {
+    n = SC_MIN (SC_SCDA_READ_BYTES, bytes - pos);
+    if (fread ((char *) data + pos, 1, n, scda->file) != n) {
+      return SC_IO_ERROR_FATAL;
+    }
+  }
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+  return SC_IO_ERROR_NONE;
+}
+
+/** Read the header, trailer and index on the first rank.
+ * \return          The index bytes, or NULL on error.
+ */
+static sc_array_t  *
+sc_scda_read_index (sc_scda_t * scda, char *header,
+                    long long *num_sections)
+{
+  char                trailer[SC_SCDA_TRAILER_BYTES];
+  long long           size, index_offset;
+  sc_array_t         *index;
+
+  /* query the file size */
+#if defined SC_ENABLE_MPIIO
+  {
+    MPI_Offset          msize;
+
+    if (MPI_File_get_size (scda->fh, &msize) != sc_MPI_SUCCESS) {
+      return NULL;
+    }
+    size = (long long) msize;
+  }
+#elif defined SC_SCDA_STDIO
+  if (fseek (scda->file, 0, SEEK_END) || (size = ftell (scda->file)) < 0) {
+    return NULL;
+  }
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+
+  /* check the header and the trailer */
+  if (size < SC_SCDA_HEADER_BYTES + SC_SCDA_TRAILER_BYTES ||
+      sc_scda_read_at (scda, 0, header, SC_SCDA_HEADER_BYTES) ||
+      memcmp (header, "scdafile", 8) ||
+      sc_scda_get (header + 8) != SC_SCDA_VERSION ||
+      sc_scda_read_at (scda, size - SC_SCDA_TRAILER_BYTES, trailer,
+                       SC_SCDA_TRAILER_BYTES) ||
+      memcmp (trailer, "scdaindx", 8)) {
+    return NULL;
+  }
+  index_offset = (long long) sc_scda_get (trailer + 8);
+  *num_sections = (long long) sc_scda_get (trailer + 16);
+  if (index_offset < SC_SCDA_HEADER_BYTES ||
+      (long long) sc_scda_get (trailer + 24) >
+      size - SC_SCDA_TRAILER_BYTES - index_offset) {
+    return NULL;
+  }
+
+  index = sc_array_new_count (sizeof (char),
+                              (size_t) sc_scda_get (trailer + 24));
+  if (sc_scda_read_at (scda, index_offset, index->array,
+                       index->elem_count)) {
+    sc_array_destroy (index);
+    return NULL;
+  }
+  return index;
+}
+
+/** Parse the index into the section and chunk arrays.
+ * \return          0 on success, nonzero if the index is invalid.
+ */
+static int
+sc_scda_parse_index (sc_scda_t * scda, const sc_array_t * index,
+                     size_t num_sections)
+{
+  size_t              zz, c, pos, first;
+  long long           offset;
+  const char         *entry;
+  sc_scda_section_t  *section;
+  sc_scda_chunk_t    *chunk;
+
+  pos = 0;
+  for (zz = 0; zz < num_sections; ++zz) {
+    entry = index->array + pos;
+    if (index->elem_count - pos < SC_SCDA_HEADER_BYTES + 8 ||
+        memcmp (entry, "scdasect", 8)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    section = (sc_scda_section_t *) sc_array_push (scda->sections);
+    memcpy (section->name, entry + 8, SC_SCDA_NAME_BYTES);
+    section->name[SC_SCDA_NAME_BYTES - 1] = '\0';
+    section->elem_size = (size_t) sc_scda_get (entry + 40);
+    section->encode = (sc_io_encode_t) sc_scda_get (entry + 48);
+    section->num_chunks = (size_t) sc_scda_get (entry + 56);
+    section->first_chunk = scda->chunks->elem_count;
+    offset = (long long) sc_scda_get (entry + SC_SCDA_HEADER_BYTES) +
+      SC_SCDA_HEADER_BYTES;
+    pos += SC_SCDA_HEADER_BYTES + 8;
+    if (section->elem_size == 0 || section->encode < SC_IO_ENCODE_NONE ||
+        section->encode >= SC_IO_ENCODE_LAST ||
+        (index->elem_count - pos) / 16 < section->num_chunks) {
+      return SC_IO_ERROR_FATAL;
+    }
+
+    /* chunk offsets and element numbers are prefix sums */
+    first = 0;
+    for (c = 0; c < section->num_chunks; ++c) {
+      chunk = (sc_scda_chunk_t *) sc_array_push (scda->chunks);
+      chunk->offset = offset;
+      chunk->bytes = (size_t) sc_scda_get (index->array + pos);
+      chunk->count = (size_t) sc_scda_get (index->array + pos + 8);
+      chunk->first = first;
+      if (section->encode == SC_IO_ENCODE_NONE &&
+          chunk->bytes != chunk->count * section->elem_size) {
+        return SC_IO_ERROR_FATAL;
+      }
+      offset += (long long) chunk->bytes;
+      first += chunk->count;
+      pos += 16;
+    }
+    section->elem_count = first;
+  }
+  return pos == index->elem_count ? SC_IO_ERROR_NONE : SC_IO_ERROR_FATAL;
+}
+
+sc_scda_t          *
+sc_scda_open_read (sc_MPI_Comm mpicomm, const char *filename,
+                   char *user_string)
+{
+  int                 mpiret;
+  int                 error;
+  char                header[SC_SCDA_HEADER_BYTES];
+  long long           meta[3];
+  sc_array_t         *index;
+  sc_scda_t          *scda;
+
+  scda = SC_ALLOC_ZERO (sc_scda_t, 1);
+  scda->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &scda->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &scda->mpirank);
+  SC_CHECK_MPI (mpiret);
+
+#if defined SC_ENABLE_MPIIO
+  mpiret = MPI_File_open (mpicomm, (char *) filename, MPI_MODE_RDONLY,
+                          MPI_INFO_NULL, &scda->fh);
+  if (mpiret != sc_MPI_SUCCESS) {
+    SC_FREE (scda);
+    return NULL;
+  }
+#elif defined SC_SCDA_STDIO
+  if ((scda->file = fopen (filename, "rb")) == NULL) {
+    SC_FREE (scda);
+    return NULL;
+  }
+#else
+  /* MPI without MPI I/O cannot read shared files */
+  SC_FREE (scda);
+  return NULL;
+#endif
+  scda->sections = sc_array_new (sizeof (sc_scda_section_t));
+  scda->chunks = sc_array_new (sizeof (sc_scda_chunk_t));
+
+  /* the first rank reads the index and shares it */
+  index = NULL;
+  meta[0] = meta[1] = meta[2] = 0;
+  if (scda->mpirank == 0) {
+    index = sc_scda_read_index (scda, header, &meta[2]);
+    meta[0] = index == NULL;
+    meta[1] = index == NULL ? 0 : (long long) index->elem_count;
+  }
+  mpiret = sc_MPI_Bcast (meta, 3, sc_MPI_LONG_LONG_INT, 0, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (meta[0]) {
+    (void) sc_scda_close (scda);
+    return NULL;
+  }
+  if (scda->mpirank != 0) {
+    index = sc_array_new_count (sizeof (char), (size_t) meta[1]);
+  }
+  mpiret = sc_MPI_Bcast (header, SC_SCDA_HEADER_BYTES, sc_MPI_BYTE, 0,
+                         mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Bcast (index->array, (int) meta[1], sc_MPI_BYTE, 0,
+                         mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* every rank parses the same index */
+  error = sc_scda_parse_index (scda, index, (size_t) meta[2]);
+  sc_array_destroy (index);
+  if (error) {
+    (void) sc_scda_close (scda);
+    return NULL;
+  }
+  if (user_string != NULL) {
+    memcpy (user_string, header + 16, SC_SCDA_USER_BYTES);
+    user_string[SC_SCDA_USER_BYTES - 1] = '\0';
+  }
+  return scda;
+}
+
+size_t
+sc_scda_num_sections (sc_scda_t * scda)
+{
+  SC_ASSERT (scda != NULL && !scda->writing);
+
+  return scda->sections->elem_count;
+}
+
+int
+sc_scda_find (sc_scda_t * scda, const char *name)
+{
+  size_t              zz;
+  sc_scda_section_t  *section;
+
+  SC_ASSERT (scda != NULL && !scda->writing);
+
+  for (zz = 0; zz < scda->sections->elem_count; ++zz) {
+    section = (sc_scda_section_t *) sc_array_index (scda->sections, zz);
+    if (!strcmp (section->name, name)) {
+      return (int) zz;
+    }
+  }
+  return -1;
+}
+
+void
+sc_scda_info (sc_scda_t * scda, int section, sc_scda_info_t * info)
+{
+  sc_scda_section_t  *sec;
+
+  SC_ASSERT (scda != NULL && !scda->writing);
+  SC_ASSERT (info != NULL);
+
+  sec = (sc_scda_section_t *) sc_array_index_int (scda->sections, section);
+  info->name = sec->name;
+  info->elem_size = sec->elem_size;
+  info->encode = sec->encode;
+  info->num_chunks = sec->num_chunks;
+  info->elem_count = sec->elem_count;
+}
+
+static sc_scda_chunk_t *
+sc_scda_chunk (sc_scda_t * scda, const sc_scda_section_t * sec, size_t c)
+{
+  SC_ASSERT (c < sec->num_chunks);
+
+  return (sc_scda_chunk_t *) sc_array_index (scda->chunks,
+                                             sec->first_chunk + c);
+}
+
+size_t
+sc_scda_chunk_count (sc_scda_t * scda, int section, size_t chunk)
+{
+  sc_scda_section_t  *sec;
+
+  SC_ASSERT (scda != NULL && !scda->writing);
+
+  sec = (sc_scda_section_t *) sc_array_index_int (scda->sections, section);
+  return sc_scda_chunk (scda, sec, chunk)->count;
+}
+
+/** Read the elements [lo, lo + n) of one chunk into memory. */
+static int
+sc_scda_read_elements (sc_scda_t * scda, const sc_scda_section_t * sec,
+                       const sc_scda_chunk_t * chunk, size_t lo, size_t n,
+                       char *dest)
+{
+  int                 error;
+  size_t              bytes, bytes_out;
+  char               *plain;
+  sc_array_t         *stored;
+  sc_io_source_t     *source;
+
+  SC_ASSERT (lo + n <= chunk->count);
+  if (n == 0) {
+    return SC_IO_ERROR_NONE;
+  }
+  if (sec->encode == SC_IO_ENCODE_NONE) {
+    return sc_scda_read_at (scda, chunk->offset +
+                            (long long) (lo * sec->elem_size), dest,
+                            n * sec->elem_size);
+  }
+
+  /* an encoded chunk is read and decoded as a whole */
+  stored = sc_array_new_count (sizeof (char), chunk->bytes);
+  error = sc_scda_read_at (scda, chunk->offset, stored->array,
+                           chunk->bytes);
+  bytes = chunk->count * sec->elem_size;
+  plain = n == chunk->count ? dest : SC_ALLOC (char, bytes);
+  if (!error) {
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, sec->encode, stored);
+    if (source == NULL) {
+      error = SC_IO_ERROR_FATAL;
+    }
+    else {
+      bytes_out = 0;
+      error = sc_io_source_read (source, plain, bytes, &bytes_out) ||
+        bytes_out != bytes;
+      error = sc_io_source_destroy (source) || error;
+    }
+  }
+  if (plain != dest) {
+    if (!error) {
+      memcpy (dest, plain + lo * sec->elem_size, n * sec->elem_size);
+    }
+    SC_FREE (plain);
+  }
+  sc_array_destroy (stored);
+  return error ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
+
+int
+sc_scda_read_chunk (sc_scda_t * scda, int section, size_t chunk,
+                    sc_array_t * data)
+{
+  sc_scda_section_t  *sec;
+  sc_scda_chunk_t    *ch;
+
+  SC_ASSERT (scda != NULL && !scda->writing);
+
+  sec = (sc_scda_section_t *) sc_array_index_int (scda->sections, section);
+  ch = sc_scda_chunk (scda, sec, chunk);
+  if (data->elem_size != sec->elem_size) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sc_array_resize (data, ch->count);
+  return sc_scda_read_elements (scda, sec, ch, 0, ch->count, data->array);
+}
+
+int
+sc_scda_read_range (sc_scda_t * scda, int section, size_t first,
+                    size_t count, sc_array_t * data)
+{
+  size_t              lo, hi, mid, pos, n;
+  sc_scda_section_t  *sec;
+  sc_scda_chunk_t    *ch;
+
+  SC_ASSERT (scda != NULL && !scda->writing);
+
+  sec = (sc_scda_section_t *) sc_array_index_int (scda->sections, section);
+  if (data->elem_size != sec->elem_size || first > sec->elem_count ||
+      count > sec->elem_count - first) {
+    return SC_IO_ERROR_FATAL;
+  }
+  sc_array_resize (data, count);
+  if (count == 0) {
+    return SC_IO_ERROR_NONE;
+  }
+
+  /* find the last chunk that begins at or before the first element */
+  lo = 0;
+  hi = sec->num_chunks;
+  while (hi - lo > 1) {
+    mid = lo + (hi - lo) / 2;
+    if (sc_scda_chunk (scda, sec, mid)->first <= first) {
+      lo = mid;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  /* read the overlap with every chunk until the range is complete */
+  for (pos = 0; pos < count; ++lo) {
+    ch = sc_scda_chunk (scda, sec, lo);
+    SC_ASSERT (first + pos >= ch->first);
+    n = SC_MIN (ch->first + ch->count - (first + pos), count - pos);
+    if (sc_scda_read_elements (scda, sec, ch, first + pos - ch->first, n,
+                               data->array + pos * sec->elem_size)) {
+      return SC_IO_ERROR_FATAL;
+    }
+    pos += n;
+  }
+  return SC_IO_ERROR_NONE;
+}
+
+int
+sc_scda_close (sc_scda_t * scda)
+{
+  int                 error = 0;
+  char                trailer[SC_SCDA_TRAILER_BYTES];
+  size_t              end, pad;
+  long long           index_offset;
+  char               *zeros;
+
+  SC_ASSERT (scda != NULL);
+
+  if (scda->writing) {
+    /* the first rank appends the index and the trailer */
+    if (scda->mpirank == 0 && scda->index != NULL) {
+      index_offset = scda->offset;
+      error = sc_io_sink_write (scda->sink, scda->index->array,
+                                scda->index->elem_count);
+
+      /* the trailer must end the file even if sections are padded */
+      end = scda->index->elem_count + SC_SCDA_TRAILER_BYTES;
+      pad = 0;
+      if (scda->stripe_bytes > 0) {
+        pad = (size_t) ((index_offset + (long long) end) %
+                        (long long) scda->stripe_bytes);
+        pad = (scda->stripe_bytes - pad) % scda->stripe_bytes;
+      }
+      zeros = SC_ALLOC_ZERO (char, pad);
+      error = sc_io_sink_write (scda->sink, zeros, pad) || error;
+      SC_FREE (zeros);
+
+      memcpy (trailer, "scdaindx", 8);
+      sc_scda_put (trailer + 8, (uint64_t) index_offset);
+      sc_scda_put (trailer + 16, (uint64_t) scda->num_written);
+      sc_scda_put (trailer + 24, (uint64_t) scda->index->elem_count);
+      error = sc_io_sink_write (scda->sink, trailer,
+                                SC_SCDA_TRAILER_BYTES) || error;
+    }
+    error = sc_io_sink_destroy (scda->sink) || error;
+    if (scda->index != NULL) {
+      sc_array_destroy (scda->index);
+    }
+    error = sc_scda_agree (scda, error);
+  }
+  else {
+#if defined SC_ENABLE_MPIIO
+    error = MPI_File_close (&scda->fh) != sc_MPI_SUCCESS;
+#elif defined SC_SCDA_STDIO
+    error = fclose (scda->file) != 0;
+#endif
+    sc_array_destroy (scda->sections);
+    sc_array_destroy (scda->chunks);
+  }
+  SC_FREE (scda);
+
+  return error ? SC_IO_ERROR_FATAL : SC_IO_ERROR_NONE;
+}
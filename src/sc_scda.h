@@ -0,0 +1,181 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#ifndef SC_SCDA_H
+#define SC_SCDA_H
+
+/** \file sc_scda.h
+ * A self-describing container file of named array sections.
+ *
+ * A section holds one array distributed over the ranks of the writing
+ * communicator: each rank contributes one chunk, and the chunks are stored
+ * in rank order, optionally compressed with an \ref sc_io_encode_t.
+ * The file is written through an MPIFILE \ref sc_io_sink_t.
+ * On closing, an index of all sections and chunks is appended to the file.
+ *
+ * A reader loads the index once and then finds the file position of any
+ * section or chunk directly.  Reading is independent per rank and may use
+ * a different number of ranks than writing, since any range of elements
+ * can be read, touching only the chunks that overlap it.
+ *
+ * All integers in the file are stored as 64-bit little-endian numbers.
+ * The file begins with a 64-byte header holding the magic "scdafile",
+ * the format version and a user string.  Each section begins with a
+ * 64-byte header holding the magic "scdasect", the section name, the
+ * element size, the encoding and the number of chunks.  The index holds,
+ * per section, a copy of its header, its file offset and the stored byte
+ * and element count of each chunk.  The file ends with a 32-byte trailer
+ * holding the magic "scdaindx", the index offset, the number of sections
+ * and the byte size of the index.
+ */
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Maximum length of a section name including the terminating nul. */
+#define SC_SCDA_NAME_BYTES 32
+
+/** Maximum length of the user string including the terminating nul. */
+#define SC_SCDA_USER_BYTES 48
+
+/** An opaque container file open for writing or reading. */
+typedef struct sc_scda sc_scda_t;
+
+/** Properties of a section as stored in the index. */
+typedef struct sc_scda_info
+{
+  const char         *name;     /**< Name of the section. */
+  size_t              elem_size;        /**< Byte size of one element. */
+  sc_io_encode_t      encode;   /**< Encoding of the chunks. */
+  size_t              num_chunks;       /**< Number of ranks that wrote. */
+  size_t              elem_count;       /**< Global number of elements. */
+}
+sc_scda_info_t;
+
+/** Create a container file for writing.
+ * This function is collective.
+ * \param [in] mpicomm      Communicator of the writing ranks.
+ * \param [in] filename     Name of the file, which is truncated.
+ * \param [in] user_string  Nul-terminated string of at most
+ *                          \ref SC_SCDA_USER_BYTES - 1 characters
+ *                          stored in the file header, or NULL.
+ * \param [in] hints        Hints for the MPI file, or NULL.
+ * \return                  The open file, or NULL on error, which
+ *                          includes an MPI build without MPI I/O.
+ */
+sc_scda_t          *sc_scda_open_write (sc_MPI_Comm mpicomm,
+                                        const char *filename,
+                                        const char *user_string,
+                                        const sc_io_mpifile_hints_t *
+                                        hints);
+
+/** Append a section to a container file.
+ * This function is collective and writes the section with one collective
+ * operation.  The chunks of all ranks must have the same element size.
+ * \param [in,out] scda     File opened by \ref sc_scda_open_write.
+ * \param [in] name         Nul-terminated name of at most
+ *                          \ref SC_SCDA_NAME_BYTES - 1 characters.
+ * \param [in] local        The chunk of this rank.
+ * \param [in] encode       Encoding of the chunks, the same on all ranks.
+ * \return                  0 on success, nonzero on error on any rank,
+ *                          including an encoding that is not available.
+ */
+int                 sc_scda_write (sc_scda_t * scda, const char *name,
+                                   sc_array_t * local,
+                                   sc_io_encode_t encode);
+
+/** Open a container file for reading.
+ * This function is collective.  The first rank reads the index and
+ * broadcasts it.
+ * \param [in] mpicomm      Communicator of the reading ranks, which need
+ *                          not match the one that wrote the file.
+ * \param [in] filename     Name of the file.
+ * \param [out] user_string If not NULL, array of \ref SC_SCDA_USER_BYTES
+ *                          filled with the user string of the header.
+ * \return                  The open file, or NULL on error.
+ */
+sc_scda_t          *sc_scda_open_read (sc_MPI_Comm mpicomm,
+                                       const char *filename,
+                                       char *user_string);
+
+/** Return the number of sections in a file opened for reading. */
+size_t              sc_scda_num_sections (sc_scda_t * scda);
+
+/** Find a section by its name.
+ * \return                  The first section of that name, or -1.
+ */
+int                 sc_scda_find (sc_scda_t * scda, const char *name);
+
+/** Query the properties of a section.
+ * \param [in] scda         File opened for reading.
+ * \param [in] section      Section number less than the number of sections.
+ * \param [out] info        Properties of the section.  The name stays
+ *                          valid until the file is closed.
+ */
+void                sc_scda_info (sc_scda_t * scda, int section,
+                                  sc_scda_info_t * info);
+
+/** Return the element count of one chunk of a section. */
+size_t              sc_scda_chunk_count (sc_scda_t * scda, int section,
+                                         size_t chunk);
+
+/** Read the chunk written by one rank.
+ * This function is not collective.
+ * \param [in] scda         File opened for reading.
+ * \param [in] section      Section number less than the number of sections.
+ * \param [in] chunk        Chunk number less than the number of chunks.
+ * \param [in,out] data     Array of the section's element size, resized
+ *                          to the elements of the chunk.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_scda_read_chunk (sc_scda_t * scda, int section,
+                                        size_t chunk, sc_array_t * data);
+
+/** Read a range of elements of a section.
+ * This function is not collective.  Only the chunks overlapping the range
+ * are read; without encoding, only the requested bytes are read.
+ * \param [in] scda         File opened for reading.
+ * \param [in] section      Section number less than the number of sections.
+ * \param [in] first        Global number of the first element to read.
+ * \param [in] count        Number of elements to read.  The range must lie
+ *                          within the section.
+ * \param [in,out] data     Array of the section's element size, resized
+ *                          to \a count elements.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_scda_read_range (sc_scda_t * scda, int section,
+                                        size_t first, size_t count,
+                                        sc_array_t * data);
+
+/** Close a container file.
+ * This function is collective.  When writing, it appends the index.
+ * \param [in] scda         The file is closed and its memory freed.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_scda_close (sc_scda_t * scda);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_SCDA_H */
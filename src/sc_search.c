@@ -22,6 +22,9 @@
 */
 
 #include <sc_search.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 int
 sc_search_bias (int maxlevel, int level, int interval, int target)
@@ -141,3 +144,185 @@ sc_bsearch_range (const void *key, const void *base, size_t nmemb,
   SC_ASSERT (compar (ckey, cbase + (guess + 1) * size) < 0);
   return guess;
 }
+
+ssize_t
+sc_search_lower_bound64_branchless (int64_t target, const int64_t * array,
+                                    size_t nmemb)
+{
+  size_t              n, half, pos;
+  const int64_t      *base;
+
+  if (nmemb == 0) {
+    return -1;
+  }
+
+  /* the answer is in base[0 .. n] and base[0] < target unless base == array */
+  base = array;
+  for (n = nmemb; n > 1; n -= half) {
+    half = n / 2;
+    SC_PREFETCH (base + half / 2);
+    SC_PREFETCH (base + half + half / 2);
+    base = (base[half] < target) ? base + half : base;
+  }
+  pos = (size_t) (base - array) + (*base < target);
+
+  SC_ASSERT (pos == nmemb || array[pos] >= target);
+  SC_ASSERT (pos == 0 || array[pos - 1] < target);
+  return pos == nmemb ? -1 : (ssize_t) pos;
+}
+
+/** The number of targets searched in lockstep. */
+#define SC_SEARCH_LOCKSTEP 8
+
+void
+sc_search_lower_bound64_many (const int64_t * targets, size_t ntargets,
+                              const int64_t * array, size_t nmemb,
+                              ssize_t * positions)
+{
+  int                 j, m;
+  size_t              zz, n, half, pos;
+  size_t              base[SC_SEARCH_LOCKSTEP];
+#ifdef __AVX2__
+  __m256i             vt[SC_SEARCH_LOCKSTEP / 4], vb[SC_SEARCH_LOCKSTEP / 4];
+  __m256i             vh, vv;
+#endif
+
+  if (nmemb == 0) {
+    for (zz = 0; zz < ntargets; ++zz) {
+      positions[zz] = -1;
+    }
+    return;
+  }
+
+  for (zz = 0; zz < ntargets; zz += SC_SEARCH_LOCKSTEP) {
+    m = (int) SC_MIN (ntargets - zz, SC_SEARCH_LOCKSTEP);
+#ifdef __AVX2__
+    if (m == SC_SEARCH_LOCKSTEP) {
+      /* all searches take the same steps, only their bases differ */
+      for (j = 0; j < SC_SEARCH_LOCKSTEP / 4; ++j) {
+        vt[j] = _mm256_loadu_si256 ((const __m256i *) (targets + zz + 4 * j));
+        vb[j] = _mm256_setzero_si256 ();
+      }
+      for (n = nmemb; n > 1; n -= half) {
+        half = n / 2;
+        vh = _mm256_set1_epi64x ((long long) half);
+        for (j = 0; j < SC_SEARCH_LOCKSTEP / 4; ++j) {
+          vv = _mm256_i64gather_epi64 ((const long long *) array,
+                                       _mm256_add_epi64 (vb[j], vh), 8);
+          vb[j] = _mm256_add_epi64
+            (vb[j], _mm256_and_si256 (_mm256_cmpgt_epi64 (vt[j], vv), vh));
+        }
+      }
+      for (j = 0; j < SC_SEARCH_LOCKSTEP / 4; ++j) {
+        _mm256_storeu_si256 ((__m256i *) (base + 4 * j), vb[j]);
+      }
+    }
+    else
+#endif
+    {
+      for (j = 0; j < m; ++j) {
+        base[j] = 0;
+      }
+      for (n = nmemb; n > 1; n -= half) {
+        half = n / 2;
+        for (j = 0; j < m; ++j) {
+          base[j] += (array[base[j] + half] < targets[zz + j]) ? half : 0;
+        }
+      }
+    }
+    for (j = 0; j < m; ++j) {
+      pos = base[j] + (array[base[j]] < targets[zz + j]);
+      positions[zz + j] = pos == nmemb ? -1 : (ssize_t) pos;
+    }
+  }
+}
+
+void
+sc_search_lower_bound64_batch (const int64_t * targets, size_t ntargets,
+                               const int64_t * array, size_t nmemb,
+                               ssize_t * positions)
+{
+  size_t              zz, lo, hi, mid, step;
+  int64_t             target;
+
+  lo = 0;
+  for (zz = 0; zz < ntargets; ++zz) {
+    target = targets[zz];
+    SC_ASSERT (zz == 0 || targets[zz - 1] <= target);
+
+    /* all elements before lo are less than target */
+    if (lo < nmemb && array[lo] < target) {
+      /* gallop until array[hi] >= target or hi == nmemb */
+      for (step = 1, hi = lo + 1; hi < nmemb && array[hi] < target;
+           step *= 2) {
+        lo = hi + 1;
+        hi = SC_MIN (lo + step, nmemb);
+      }
+      SC_ASSERT (lo <= hi);
+
+      /* bisect before hi for the first element >= target */
+      while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (array[mid] < target) {
+          lo = mid + 1;
+        }
+        else {
+          hi = mid;
+        }
+      }
+    }
+    SC_ASSERT (lo == nmemb || array[lo] >= target);
+    SC_ASSERT (lo == 0 || array[lo - 1] < target);
+    positions[zz] = lo == nmemb ? -1 : (ssize_t) lo;
+  }
+}
+
+/** Fill the subtree of node k by an in-order traversal.
+ * \return          The next position to read in the sorted array.
+ */
+static              size_t
+sc_search_eytzinger64_fill (const int64_t * array, size_t i, size_t k,
+                            size_t nmemb, int64_t * eytz, size_t * perm)
+{
+  if (k <= nmemb) {
+    i = sc_search_eytzinger64_fill (array, i, 2 * k, nmemb, eytz, perm);
+    eytz[k] = array[i];
+    if (perm != NULL) {
+      perm[k] = i;
+    }
+    i = sc_search_eytzinger64_fill (array, i + 1, 2 * k + 1, nmemb,
+                                    eytz, perm);
+  }
+  return i;
+}
+
+void
+sc_search_eytzinger64_build (const int64_t * array, size_t nmemb,
+                             int64_t * eytz, size_t * perm)
+{
+  size_t              i;
+
+  eytz[0] = 0;
+  if (perm != NULL) {
+    perm[0] = nmemb;
+  }
+  i = sc_search_eytzinger64_fill (array, 0, 1, nmemb, eytz, perm);
+  SC_ASSERT (i == nmemb);
+}
+
+size_t
+sc_search_eytzinger64 (int64_t target, const int64_t * eytz, size_t nmemb)
+{
+  size_t              k;
+
+  /* descend to a leaf; the prefetch covers the descendants four levels down */
+  for (k = 1; k <= nmemb; k = 2 * k + (eytz[k] < target)) {
+    SC_PREFETCH (eytz + 16 * k);
+  }
+
+  /* undo the right turns below the last left turn, then that left turn */
+  while (k & 1) {
+    k >>= 1;
+  }
+  return k >> 1;
+}
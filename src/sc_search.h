@@ -67,6 +67,86 @@ size_t              sc_bsearch_range (const void *key, const void *base,
                                       int (*compar) (const void *,
                                                      const void *));
 
+/** Find lowest position k in a sorted array such that array[k] >= target.
+ * The result is the same as of \ref sc_search_lower_bound64.
+ * The search takes floor (log2 (nmemb)) + 1 steps without branches that
+ * depend on the data, and prefetches the candidates of the next steps.
+ * It is faster when the search pattern is unpredictable.
+ * \param [in]  target  The target lower bound to binary search for.
+ * \param [in]  array   The 64bit integer array to binary search in.
+ * \param [in]  nmemb   The number of int64_t's in the array.
+ * \return  Returns the matching position
+ *          or -1 if array[size-1] < target or if size == 0.
+ */
+ssize_t             sc_search_lower_bound64_branchless (int64_t target,
+                                                        const int64_t *
+                                                        array, size_t nmemb);
+
+/** Find the lower bounds of many targets in one sorted array.
+ * The targets need not be sorted.  Groups of targets are searched in
+ * lockstep, with AVX2 gather instructions if the compiler enables them,
+ * so that the memory latencies of the searches overlap.
+ * \param [in]  targets     Array of \a ntargets targets.
+ * \param [in]  ntargets    The number of targets.
+ * \param [in]  array       The 64bit integer array to binary search in.
+ * \param [in]  nmemb       The number of int64_t's in the array.
+ * \param [out] positions   Array of \a ntargets positions, each one as
+ *                          returned by \ref sc_search_lower_bound64.
+ */
+void                sc_search_lower_bound64_many (const int64_t * targets,
+                                                  size_t ntargets,
+                                                  const int64_t * array,
+                                                  size_t nmemb,
+                                                  ssize_t * positions);
+
+/** Find the lower bounds of ascending targets in one sorted array.
+ * Each search gallops forward from the result of the previous target,
+ * doubling the step until passing the target, and bisects the last step.
+ * This takes O (T log (N / T)) comparisons for T targets in N elements,
+ * which is less than both T binary searches and a linear merge.
+ * \param [in]  targets     Array of \a ntargets targets sorted ascending.
+ * \param [in]  ntargets    The number of targets.
+ * \param [in]  array       The 64bit integer array to search in.
+ * \param [in]  nmemb       The number of int64_t's in the array.
+ * \param [out] positions   Array of \a ntargets positions, each one as
+ *                          returned by \ref sc_search_lower_bound64.
+ */
+void                sc_search_lower_bound64_batch (const int64_t * targets,
+                                                   size_t ntargets,
+                                                   const int64_t * array,
+                                                   size_t nmemb,
+                                                   ssize_t * positions);
+
+/** Copy a sorted array into the Eytzinger layout for faster searching.
+ * The layout stores a complete binary search tree in breadth first order.
+ * The first levels of the tree share few cache lines, which makes \ref
+ * sc_search_eytzinger64 faster than binary search on large static arrays.
+ * \param [in]  array   The sorted 64bit integer array.
+ * \param [in]  nmemb   The number of int64_t's in the array.
+ * \param [out] eytz    Array of nmemb + 1 entries.  The tree is stored in
+ *                      the entries 1 through nmemb, and entry 0 is unused.
+ * \param [out] perm    If not NULL, array of nmemb + 1 entries.  Entries
+ *                      1 through nmemb are set to the sorted position of
+ *                      the respective entry of \a eytz, and entry 0
+ *                      is set to nmemb.
+ */
+void                sc_search_eytzinger64_build (const int64_t * array,
+                                                 size_t nmemb,
+                                                 int64_t * eytz,
+                                                 size_t * perm);
+
+/** Find the smallest entry >= target in an array in Eytzinger layout.
+ * \param [in]  target  The target lower bound to search for.
+ * \param [in]  eytz    An array created by \ref sc_search_eytzinger64_build.
+ * \param [in]  nmemb   The number of int64_t's in the original array.
+ * \return  Returns the index 1 <= k <= nmemb into \a eytz of the lower
+ *          bound, or 0 if all entries are less than target.  The position
+ *          in the sorted array is perm[k], see the build function.
+ */
+size_t              sc_search_eytzinger64 (int64_t target,
+                                           const int64_t * eytz,
+                                           size_t nmemb);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_SEARCH_H */
@@ -0,0 +1,179 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_segarray.h>
+
+/* default chunk size in bytes if the shift is not given */
+#define SC_SEGARRAY_CHUNK_BYTES 65536
+
+size_t
+sc_segarray_memory_used (sc_segarray_t * sa, int is_dynamic)
+{
+  return (is_dynamic ? sizeof (sc_segarray_t) : 0) +
+    sa->chunk_alloc * sizeof (char *) +
+    (sa->num_chunks << sa->chunk_shift) * sa->elem_size;
+}
+
+void
+sc_segarray_init (sc_segarray_t * sa, size_t elem_size, int chunk_shift)
+{
+  SC_ASSERT (elem_size > 0);
+
+  if (chunk_shift < 0) {
+    for (chunk_shift = 0;
+         ((size_t) 2 << chunk_shift) * elem_size <= SC_SEGARRAY_CHUNK_BYTES;
+         ++chunk_shift) {
+    }
+  }
+  SC_ASSERT (chunk_shift < (int) (8 * sizeof (size_t)) - 1);
+
+  sa->elem_size = elem_size;
+  sa->elem_count = 0;
+  sa->chunk_shift = chunk_shift;
+  sa->chunk_mask = ((size_t) 1 << chunk_shift) - 1;
+  sa->num_chunks = 0;
+  sa->chunk_alloc = 0;
+  sa->chunks = NULL;
+}
+
+sc_segarray_t      *
+sc_segarray_new (size_t elem_size, int chunk_shift)
+{
+  sc_segarray_t      *sa;
+
+  sa = SC_ALLOC (sc_segarray_t, 1);
+  sc_segarray_init (sa, elem_size, chunk_shift);
+
+  return sa;
+}
+
+void
+sc_segarray_reset (sc_segarray_t * sa)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < sa->num_chunks; ++zz) {
+    SC_FREE (sa->chunks[zz]);
+  }
+  SC_FREE (sa->chunks);
+
+  sa->elem_count = 0;
+  sa->num_chunks = 0;
+  sa->chunk_alloc = 0;
+  sa->chunks = NULL;
+}
+
+void
+sc_segarray_destroy (sc_segarray_t * sa)
+{
+  sc_segarray_reset (sa);
+  SC_FREE (sa);
+}
+
+void
+sc_segarray_resize (sc_segarray_t * sa, size_t new_count)
+{
+  const size_t        chunk_bytes = (sa->chunk_mask + 1) * sa->elem_size;
+  size_t              needed;
+
+  needed = (new_count + sa->chunk_mask) >> sa->chunk_shift;
+  if (needed > sa->chunk_alloc) {
+    /* only the small table of chunk pointers is ever reallocated */
+    sa->chunk_alloc = SC_MAX (needed, 2 * sa->chunk_alloc);
+    sa->chunks = SC_REALLOC (sa->chunks, char *, sa->chunk_alloc);
+  }
+  while (sa->num_chunks < needed) {
+    sa->chunks[sa->num_chunks++] = SC_ALLOC (char, chunk_bytes);
+  }
+  while (sa->num_chunks > needed) {
+    SC_FREE (sa->chunks[--sa->num_chunks]);
+  }
+  sa->elem_count = new_count;
+}
+
+void               *
+sc_segarray_chunk (sc_segarray_t * sa, size_t chunk, size_t *count)
+{
+  const size_t        first = chunk << sa->chunk_shift;
+
+  SC_ASSERT (first < sa->elem_count);
+
+  *count = SC_MIN (sa->chunk_mask + 1, sa->elem_count - first);
+  return (void *) sa->chunks[chunk];
+}
+
+void
+sc_segarray_append (sc_segarray_t * sa, const void *data, size_t n)
+{
+  const char         *src = (const char *) data;
+  size_t              iz, offset, len;
+
+  iz = sa->elem_count;
+  sc_segarray_resize (sa, iz + n);
+  while (n > 0) {
+    offset = iz & sa->chunk_mask;
+    len = SC_MIN (n, sa->chunk_mask + 1 - offset);
+    memcpy (sa->chunks[iz >> sa->chunk_shift] + offset * sa->elem_size,
+            src, len * sa->elem_size);
+    src += len * sa->elem_size;
+    iz += len;
+    n -= len;
+  }
+}
+
+void
+sc_segarray_flatten (sc_segarray_t * sa, sc_array_t * array, int release)
+{
+  const size_t        chunk_bytes = (sa->chunk_mask + 1) * sa->elem_size;
+  size_t              zz, num_full, rest;
+  char               *dest;
+
+  SC_ASSERT (array->elem_size == sa->elem_size);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  sc_array_resize (array, sa->elem_count);
+  dest = array->array;
+  num_full = sa->elem_count >> sa->chunk_shift;
+  rest = sa->elem_count & sa->chunk_mask;
+  for (zz = 0; zz < num_full; ++zz) {
+    memcpy (dest + zz * chunk_bytes, sa->chunks[zz], chunk_bytes);
+    if (release) {
+      SC_FREE (sa->chunks[zz]);
+    }
+  }
+  if (rest > 0) {
+    memcpy (dest + num_full * chunk_bytes, sa->chunks[num_full],
+            rest * sa->elem_size);
+  }
+  if (release) {
+    /* the full chunks are already gone */
+    for (zz = num_full; zz < sa->num_chunks; ++zz) {
+      SC_FREE (sa->chunks[zz]);
+    }
+    SC_FREE (sa->chunks);
+    sa->elem_count = 0;
+    sa->num_chunks = 0;
+    sa->chunk_alloc = 0;
+    sa->chunks = NULL;
+  }
+}
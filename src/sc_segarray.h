@@ -0,0 +1,186 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_segarray.h
+ *
+ * A growable array stored in fixed-size chunks.
+ *
+ * Growing an \ref sc_array_t moves its data on reallocation, which copies
+ * every element and invalidates all pointers into the array.  The segmented
+ * array allocates a new chunk of \f$2^{\mathrm{shift}}\f$ elements whenever
+ * the last one is full and never moves an element once it is stored.  An
+ * element is found by one shift and one mask of its index.  Truncating the
+ * array frees the chunks no longer needed, and the data can be copied into
+ * a contiguous \ref sc_array_t once that is required, releasing the chunks
+ * on the way to keep the peak memory low.
+ */
+
+#ifndef SC_SEGARRAY_H
+#define SC_SEGARRAY_H
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The segmented array object.  The members may be read but not written. */
+typedef struct sc_segarray
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of one element in bytes */
+  size_t              elem_count;       /**< number of valid elements */
+  int                 chunk_shift;      /**< log2 of elements per chunk */
+
+  /* implementation variables */
+  size_t              chunk_mask;       /**< elements per chunk minus one */
+  size_t              num_chunks;       /**< number of allocated chunks */
+  size_t              chunk_alloc;      /**< allocated chunk pointers */
+  char              **chunks;   /**< element i is in chunks[i >> shift] */
+}
+sc_segarray_t;
+
+/** Calculate the memory used by a segmented array.
+ * \param [in] sa           Valid segmented array.
+ * \param [in] is_dynamic   True if created with \ref sc_segarray_new,
+ *                          false if initialized with \ref sc_segarray_init.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_segarray_memory_used (sc_segarray_t * sa,
+                                             int is_dynamic);
+
+/** Initialize an empty segmented array.
+ * \param [out] sa          Segmented array to initialize.
+ * \param [in] elem_size    Size of one element in bytes, positive.
+ * \param [in] chunk_shift  Each chunk holds 2^chunk_shift elements.
+ *                          If negative, chunks of about 64 KiB are used.
+ */
+void                sc_segarray_init (sc_segarray_t * sa, size_t elem_size,
+                                      int chunk_shift);
+
+/** Create an empty segmented array.
+ * \param [in] elem_size    Size of one element in bytes, positive.
+ * \param [in] chunk_shift  See \ref sc_segarray_init.
+ * \return                  Array to be freed by \ref sc_segarray_destroy.
+ */
+sc_segarray_t      *sc_segarray_new (size_t elem_size, int chunk_shift);
+
+/** Free all chunks of an array initialized by \ref sc_segarray_init.
+ * The array is empty afterwards and may be used again.
+ */
+void                sc_segarray_reset (sc_segarray_t * sa);
+
+/** Free a segmented array created by \ref sc_segarray_new. */
+void                sc_segarray_destroy (sc_segarray_t * sa);
+
+/** Change the number of elements.
+ * Growing allocates chunks as needed; the new elements are uninitialized.
+ * Shrinking frees every chunk that no longer holds a valid element.
+ * Addresses of elements that stay valid do not change.
+ * \param [in,out] sa       Valid segmented array.
+ * \param [in] new_count    New number of elements.
+ */
+void                sc_segarray_resize (sc_segarray_t * sa,
+                                        size_t new_count);
+
+/** Return a pointer to an element.
+ * The pointer stays valid until the element is truncated away.
+ * \param [in] sa           Valid segmented array.
+ * \param [in] iz           Index smaller than elem_count.
+ * \return                  Pointer to the element.
+ */
+static inline void *
+sc_segarray_index (sc_segarray_t * sa, size_t iz)
+{
+  SC_ASSERT (iz < sa->elem_count);
+
+  return (void *) (sa->chunks[iz >> sa->chunk_shift] +
+                   (iz & sa->chunk_mask) * sa->elem_size);
+}
+
+/** Append an uninitialized element.
+ * \param [in,out] sa       Valid segmented array.
+ * \return                  Pointer to the new element.
+ */
+static inline void *
+sc_segarray_push (sc_segarray_t * sa)
+{
+  size_t              iz = sa->elem_count;
+
+  if ((iz >> sa->chunk_shift) == sa->num_chunks) {
+    sc_segarray_resize (sa, iz + 1);
+  }
+  else {
+    sa->elem_count = iz + 1;
+  }
+  return sc_segarray_index (sa, iz);
+}
+
+/** Remove the last element.
+ * The chunk holding it is not freed, so the returned pointer remains
+ * valid until the next push or resize.
+ * \param [in,out] sa       Valid segmented array, not empty.
+ * \return                  Pointer to the removed element.
+ */
+static inline void *
+sc_segarray_pop (sc_segarray_t * sa)
+{
+  size_t              iz;
+
+  SC_ASSERT (sa->elem_count > 0);
+
+  iz = --sa->elem_count;
+  return (void *) (sa->chunks[iz >> sa->chunk_shift] +
+                   (iz & sa->chunk_mask) * sa->elem_size);
+}
+
+/** Access the valid elements of one chunk for chunk-wise loops.
+ * \param [in] sa           Valid segmented array.
+ * \param [in] chunk        Chunk number, smaller than
+ *                          ceil (elem_count / 2^chunk_shift).
+ * \param [out] count       Number of valid elements in this chunk.
+ * \return                  Pointer to the first element of the chunk.
+ */
+void               *sc_segarray_chunk (sc_segarray_t * sa, size_t chunk,
+                                       size_t *count);
+
+/** Append elements copied from a contiguous buffer.
+ * \param [in,out] sa       Valid segmented array.
+ * \param [in] data         Array of \b n elements of size elem_size.
+ * \param [in] n            Number of elements to append.
+ */
+void                sc_segarray_append (sc_segarray_t * sa,
+                                        const void *data, size_t n);
+
+/** Copy all elements into a contiguous array.
+ * \param [in,out] sa       Valid segmented array.  If \b release is true,
+ *                          each chunk is freed as soon as it is copied
+ *                          and the array is empty on return.
+ * \param [out] array       Array of the same element size, resized to
+ *                          elem_count.  Must not be a view.
+ * \param [in] release      Free the chunks while copying.
+ */
+void                sc_segarray_flatten (sc_segarray_t * sa,
+                                         sc_array_t * array, int release);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_SEGARRAY_H */
@@ -22,6 +22,10 @@
 */
 
 #include <sc_shmem.h>
+#include <sc_allgather.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 #if defined(__bgq__)
 /** for sc_allgather_final_*_bgq routines to work on BG/Q, you must
@@ -43,122 +47,61 @@ const char         *sc_shmem_type_to_string[SC_SHMEM_NUM_TYPES] = {
 #endif
 };
 
+/* Scan the columns [cbegin, cend) of a (size + 1) x count array down its
+ * rows.  The inner loop runs over contiguous memory and vectorizes. */
+#define SC_SCAN_ON_ARRAY(T) do {                                \
+  T                  *array = (T *) recvchar;                   \
+  T                  *row;                                      \
+                                                                \
+  SC_ASSERT (sizeof (*array) == (size_t) typesize);             \
+  for (p = 1; p <= size; p++) {                                 \
+    row = array + (size_t) count * p;                           \
+    for (c = cbegin; c < cend; c++) {                           \
+      row[c] += row[c - count];                                 \
+    }                                                           \
+  }                                                             \
+} while (0)
+
 static void
-sc_scan_on_array (void *recvchar, int size, int count, int typesize,
-                  sc_MPI_Datatype type, sc_MPI_Op op)
+sc_scan_on_array_range (void *recvchar, int size, int count,
+                        int cbegin, int cend, int typesize,
+                        sc_MPI_Datatype type, sc_MPI_Op op)
 {
   int                 p, c;
 
   if (op == sc_MPI_SUM) {
     if (type == sc_MPI_CHAR || type == sc_MPI_BYTE) {
-      char               *array = (char *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (char);
     }
     else if (type == sc_MPI_SHORT) {
-      short              *array = (short *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (short);
     }
     else if (type == sc_MPI_UNSIGNED_SHORT) {
-      unsigned short     *array = (unsigned short *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (unsigned short);
     }
     else if (type == sc_MPI_INT) {
-      int                *array = (int *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (int);
     }
     else if (type == sc_MPI_UNSIGNED) {
-      unsigned           *array = (unsigned *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (unsigned);
     }
     else if (type == sc_MPI_LONG) {
-      long               *array = (long *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (long);
     }
     else if (type == sc_MPI_UNSIGNED_LONG) {
-      unsigned long      *array = (unsigned long *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (unsigned long);
     }
     else if (type == sc_MPI_LONG_LONG_INT) {
-      long long          *array = (long long *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (long long);
     }
     else if (type == sc_MPI_FLOAT) {
-      float              *array = (float *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (float);
     }
     else if (type == sc_MPI_DOUBLE) {
-      double             *array = (double *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (double);
     }
     else if (type == sc_MPI_LONG_DOUBLE) {
-      long double        *array = (long double *) recvchar;
-
-      SC_ASSERT (sizeof (*array) == typesize);
-      for (p = 1; p <= size; p++) {
-        for (c = 0; c < count; c++) {
-          array[count * p + c] += array[count * (p - 1) + c];
-        }
-      }
+      SC_SCAN_ON_ARRAY (long double);
     }
     else {
       SC_ABORT ("MPI_Datatype not supported\n");
@@ -169,8 +112,34 @@ sc_scan_on_array (void *recvchar, int size, int count, int typesize,
   }
 }
 
+/* The columns are independent, so threads each scan a slice of them. */
+static void
+sc_scan_on_array (void *recvchar, int size, int count,
+                  int cbegin, int cend, int typesize,
+                  sc_MPI_Datatype type, sc_MPI_Op op)
+{
+#ifdef SC_ENABLE_OPENMP
+  if (cend - cbegin >= SC_SHMEM_SCAN_SPLIT) {
+#pragma omp parallel
+    {
+      const long          width = cend - cbegin;
+      const int           nt = omp_get_num_threads ();
+      const int           t = omp_get_thread_num ();
+
+      sc_scan_on_array_range (recvchar, size, count,
+                              cbegin + (int) (width * t / nt),
+                              cbegin + (int) (width * (t + 1) / nt),
+                              typesize, type, op);
+    }
+    return;
+  }
+#endif
+  sc_scan_on_array_range (recvchar, size, count, cbegin, cend,
+                          typesize, type, op);
+}
+
 #if !defined(SC_SHMEM_DEFAULT)
-#define SC_SHMEM_DEFAULT SC_SHMEM_BASIC
+#define SC_SHMEM_DEFAULT SC_SHMEM_AUTO
 #endif
 sc_shmem_type_t     sc_shmem_default_type = SC_SHMEM_DEFAULT;
 
@@ -223,9 +192,40 @@ sc_shmem_get_type (sc_MPI_Comm comm)
 #endif
 }
 
+/** Choose the fastest type for the MPI library and node layout. */
+static              sc_shmem_type_t
+sc_shmem_type_auto (sc_MPI_Comm comm)
+{
+#if defined(SC_ENABLE_MPI)
+  int                 mpiret, intrasize;
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL, internode =
+    sc_MPI_COMM_NULL;
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    return SC_SHMEM_BASIC;
+  }
+
+  /* a single process per node has nothing to share */
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  if (intrasize > 1) {
+#if defined(SC_ENABLE_MPIWINSHARED)
+    return SC_SHMEM_WINDOW;
+#elif defined(__bgq__)
+    return SC_SHMEM_BGQ;
+#endif
+  }
+#endif
+  return SC_SHMEM_BASIC;
+}
+
 void
 sc_shmem_set_type (sc_MPI_Comm comm, sc_shmem_type_t type)
 {
+  if (type == SC_SHMEM_AUTO) {
+    type = sc_shmem_type_auto (comm);
+  }
   SC_ASSERT (0 <= type && type < SC_SHMEM_NUM_TYPES);
 
 #if defined(SC_ENABLE_MPI)
@@ -249,8 +249,9 @@ sc_shmem_get_type_default (sc_MPI_Comm comm)
 {
   sc_shmem_type_t     type = sc_shmem_get_type (comm);
   if (type == SC_SHMEM_NOT_SET) {
-    type = sc_shmem_default_type;
-    sc_shmem_set_type (comm, type);
+    /* the default may be SC_SHMEM_AUTO, which is resolved when set */
+    sc_shmem_set_type (comm, sc_shmem_default_type);
+    type = sc_shmem_get_type (comm);
   }
   return type;
 }
@@ -305,6 +306,30 @@ sc_shmem_allgather_basic (void *sendbuf, int sendcount,
   SC_CHECK_MPI (mpiret);
 }
 
+static void
+sc_shmem_allgatherv_basic (void *sendbuf, int sendcount,
+                           sc_MPI_Datatype sendtype, void *recvbuf,
+                           int *recvcounts, int *displs,
+                           sc_MPI_Datatype recvtype, sc_MPI_Comm comm,
+                           sc_MPI_Comm intranode, sc_MPI_Comm internode)
+{
+  int                 mpiret = sc_allgatherv (sendbuf, sendcount, sendtype,
+                                              recvbuf, recvcounts, displs,
+                                              recvtype, comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+static void
+sc_shmem_allreduce_basic (void *sendbuf, void *recvbuf, int count,
+                          sc_MPI_Datatype type, sc_MPI_Op op,
+                          sc_MPI_Comm comm, sc_MPI_Comm intranode,
+                          sc_MPI_Comm internode)
+{
+  int                 mpiret = sc_MPI_Allreduce (sendbuf, recvbuf, count,
+                                                 type, op, comm);
+  SC_CHECK_MPI (mpiret);
+}
+
 static void
 sc_shmem_prefix_basic (void *sendbuf, void *recvbuf, int count,
                        sc_MPI_Datatype type, sc_MPI_Op op,
@@ -320,7 +345,7 @@ sc_shmem_prefix_basic (void *sendbuf, void *recvbuf, int count,
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_size (comm, &size);
   SC_CHECK_MPI (mpiret);
-  sc_scan_on_array (recvbuf, size, count, typesize, type, op);
+  sc_scan_on_array (recvbuf, size, count, 0, count, typesize, type, op);
 }
 
 /* PRESCAN implementation */
@@ -351,6 +376,43 @@ sc_shmem_prefix_prescan (void *sendbuf, void *recvbuf, int count,
 
 #if defined(__bgq__) || defined(SC_ENABLE_MPIWINSHARED)
 
+#if defined(SC_ENABLE_MPIWINSHARED)
+
+static MPI_Win      sc_shmem_get_win (void *array, sc_MPI_Comm comm,
+                                      sc_MPI_Comm intranode,
+                                      sc_MPI_Comm internode);
+
+/** Every process of the node scans its slice of the columns in place. */
+static void
+sc_shmem_scan_window (void *recvbuf, int size, int count, int typesize,
+                      sc_MPI_Datatype type, sc_MPI_Op op, sc_MPI_Comm comm,
+                      sc_MPI_Comm intranode, sc_MPI_Comm internode)
+{
+  int                 mpiret, intrarank, intrasize;
+  MPI_Win             win;
+
+  win = sc_shmem_get_win (recvbuf, comm, intranode, internode);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Win_sync (win);
+  SC_CHECK_MPI (mpiret);
+  sc_scan_on_array (recvbuf, size, count,
+                    (int) ((long) count * intrarank / intrasize),
+                    (int) ((long) count * (intrarank + 1) / intrasize),
+                    typesize, type, op);
+  mpiret = MPI_Win_sync (win);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Barrier (intranode);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_sync (win);
+  SC_CHECK_MPI (mpiret);
+}
+
+#endif /* SC_ENABLE_MPIWINSHARED */
+
 static void
 sc_shmem_memcpy_common (void *destarray, void *srcarray, size_t bytes,
                         sc_MPI_Comm comm, sc_MPI_Comm intranode,
@@ -400,6 +462,124 @@ sc_shmem_allgather_common (void *sendbuf, int sendcount,
   sc_shmem_write_end (recvbuf, comm);
 }
 
+static void
+sc_shmem_allgatherv_common (void *sendbuf, int sendcount,
+                            sc_MPI_Datatype sendtype, void *recvbuf,
+                            int *recvcounts, int *displs,
+                            sc_MPI_Datatype recvtype, sc_MPI_Comm comm,
+                            sc_MPI_Comm intranode, sc_MPI_Comm internode)
+{
+  size_t              typesize;
+  int                 mpiret, size, intrarank, intrasize, numnodes;
+  int                 p, node, i, offset;
+  int                *members, *counts, *nodecounts, *nodedispls;
+  const int          *locations;
+  char               *nodedata = NULL, *alldata = NULL;
+
+  locations = sc_mpi_comm_get_node_locations (comm);
+  if (locations == NULL) {
+    sc_shmem_allgatherv_basic (sendbuf, sendcount, sendtype, recvbuf,
+                               recvcounts, displs, recvtype, comm,
+                               intranode, internode);
+    return;
+  }
+  typesize = sc_mpi_sizeof (recvtype);
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (internode, &numnodes);
+  SC_CHECK_MPI (mpiret);
+
+  /* the rank of every node member and the counts packed by node */
+  members = SC_ALLOC (int, size + 2 * intrasize + 2 * numnodes + 1);
+  counts = members + size;
+  nodecounts = counts + 2 * intrasize;
+  nodedispls = nodecounts + numnodes;
+  for (p = 0; p < size; ++p) {
+    members[locations[2 * p] * intrasize + locations[2 * p + 1]] = p;
+  }
+  nodedispls[0] = 0;
+  for (node = 0; node < numnodes; ++node) {
+    nodecounts[node] = 0;
+    for (i = 0; i < intrasize; ++i) {
+      nodecounts[node] += recvcounts[members[node * intrasize + i]];
+    }
+    nodedispls[node + 1] = nodedispls[node] + nodecounts[node];
+  }
+
+  /* node root gathers from node */
+  mpiret = sc_MPI_Comm_rank (internode, &node);
+  SC_CHECK_MPI (mpiret);
+  for (offset = 0, i = 0; i < intrasize; ++i) {
+    counts[i] = recvcounts[members[node * intrasize + i]];
+    counts[intrasize + i] = offset;
+    offset += counts[i];
+  }
+  if (!intrarank) {
+    nodedata = SC_ALLOC (char, (size_t) nodecounts[node] * typesize);
+  }
+  mpiret = sc_MPI_Gatherv (sendbuf, sendcount, sendtype, nodedata, counts,
+                           counts + intrasize, recvtype, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+
+  /* node root allgathers between nodes and unpacks by rank */
+  if (sc_shmem_write_start (recvbuf, comm)) {
+    alldata = SC_ALLOC (char, (size_t) nodedispls[numnodes] * typesize);
+    mpiret = sc_allgatherv (nodedata, nodecounts[node], recvtype, alldata,
+                            nodecounts, nodedispls, recvtype, internode);
+    SC_CHECK_MPI (mpiret);
+    for (node = 0; node < numnodes; ++node) {
+      for (offset = nodedispls[node], i = 0; i < intrasize; ++i) {
+        p = members[node * intrasize + i];
+        memcpy ((char *) recvbuf + (size_t) displs[p] * typesize,
+                alldata + (size_t) offset * typesize,
+                (size_t) recvcounts[p] * typesize);
+        offset += recvcounts[p];
+      }
+    }
+    SC_FREE (alldata);
+    SC_FREE (nodedata);
+  }
+  sc_shmem_write_end (recvbuf, comm);
+  SC_FREE (members);
+}
+
+static void
+sc_shmem_allreduce_common (void *sendbuf, void *recvbuf, int count,
+                           sc_MPI_Datatype type, sc_MPI_Op op,
+                           sc_MPI_Comm comm, sc_MPI_Comm intranode,
+                           sc_MPI_Comm internode)
+{
+  size_t              typesize;
+  int                 mpiret, intrarank;
+  char               *nodereducechar = NULL;
+
+  typesize = sc_mpi_sizeof (type);
+
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+
+  /* node root reduces over node */
+  if (!intrarank) {
+    nodereducechar = SC_ALLOC (char, count * typesize);
+  }
+  mpiret = sc_MPI_Reduce (sendbuf, nodereducechar, count, type, op, 0,
+                          intranode);
+  SC_CHECK_MPI (mpiret);
+
+  /* node root allreduces between nodes, straight into the shared array */
+  if (sc_shmem_write_start (recvbuf, comm)) {
+    mpiret = sc_MPI_Allreduce (nodereducechar, recvbuf, count, type, op,
+                               internode);
+    SC_CHECK_MPI (mpiret);
+    SC_FREE (nodereducechar);
+  }
+  sc_shmem_write_end (recvbuf, comm);
+}
+
 static void
 sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
                         sc_MPI_Datatype type, sc_MPI_Op op,
@@ -409,6 +589,7 @@ sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
   size_t              typesize;
   int                 mpiret, intrarank, intrasize, size;
   char               *noderecvchar = NULL;
+  int                 cooperative = 0;
 
   typesize = sc_mpi_sizeof (type);
 
@@ -428,6 +609,12 @@ sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
                    intranode);
   SC_CHECK_MPI (mpiret);
 
+#if defined(SC_ENABLE_MPIWINSHARED)
+  /* long rows are scanned by all processes of the node together */
+  cooperative = count >= SC_SHMEM_SCAN_SPLIT && intrasize > 1 &&
+    sc_shmem_get_type (comm) == SC_SHMEM_WINDOW;
+#endif
+
   /* node root allgathers between nodes */
   if (sc_shmem_write_start (recvbuf, comm)) {
     memset (recvbuf, 0, count * typesize);
@@ -437,9 +624,18 @@ sc_shmem_prefix_common (void *sendbuf, void *recvbuf, int count,
                         count * intrasize, type, internode);
     SC_CHECK_MPI (mpiret);
     SC_FREE (noderecvchar);
-    sc_scan_on_array (recvbuf, size, count, typesize, type, op);
+    if (!cooperative) {
+      sc_scan_on_array (recvbuf, size, count, 0, count, typesize, type, op);
+    }
   }
   sc_shmem_write_end (recvbuf, comm);
+
+#if defined(SC_ENABLE_MPIWINSHARED)
+  if (cooperative) {
+    sc_shmem_scan_window (recvbuf, size, count, typesize, type, op, comm,
+                          intranode, internode);
+  }
+#endif
 }
 
 static void
@@ -559,17 +755,193 @@ sc_shmem_free_bgq (int package, void *array, sc_MPI_Comm comm,
 #if defined(SC_ENABLE_MPIWINSHARED)
 /* MPI_Win implementation */
 
-static              MPI_Win
-sc_shmem_get_win (void *array, sc_MPI_Comm comm, sc_MPI_Comm intranode,
-                  sc_MPI_Comm internode)
+/* Shared arrays are carved out of a few large windows per node.  Every
+ * process of the node runs the same deterministic first-fit allocator on
+ * its private copy of the pool, so that no communication is needed unless
+ * a window is created or freed.  Each window is locked shared by all
+ * processes except between write_start and write_end. */
+
+typedef struct sc_shmem_block
 {
-  int                 mpiret, intrarank, intrasize;
+  size_t              offset, bytes;
+}
+sc_shmem_block_t;
+
+typedef struct sc_shmem_chunk
+{
+  MPI_Win             win;
+  char               *base;
+  size_t              size;
+  int                 dedicated;        /**< holds exactly one large array */
+  size_t              num_blocks, alloc_blocks;
+  sc_shmem_block_t   *blocks;           /**< allocations sorted by offset */
+}
+sc_shmem_chunk_t;
+
+typedef struct sc_shmem_pool
+{
+  int                 num_chunks;
+  sc_shmem_chunk_t  **chunks;
+}
+sc_shmem_pool_t;
+
+static int          sc_shmem_pool_keyval = MPI_KEYVAL_INVALID;
+
+static int
+sc_shmem_chunk_destroy (sc_shmem_chunk_t * chunk)
+{
+  int                 mpiret;
+
+  mpiret = MPI_Win_unlock (0, chunk->win);
+  if (mpiret != MPI_SUCCESS) {
+    return mpiret;
+  }
+  mpiret = MPI_Win_free (&chunk->win);
+  free (chunk->blocks);
+  free (chunk);
+
+  return mpiret;
+}
+
+/* The pool is attached to the node communicator and its windows are freed
+ * with it, which may happen after sc_finalize; hence we use plain malloc. */
+static int
+sc_shmem_pool_destroy (MPI_Comm comm, int comm_keyval,
+                       void *attribute_val, void *extra_state)
+{
+  int                 mpiret, i;
+  sc_shmem_pool_t    *pool = (sc_shmem_pool_t *) attribute_val;
+
+  for (i = 0; i < pool->num_chunks; ++i) {
+    mpiret = sc_shmem_chunk_destroy (pool->chunks[i]);
+    if (mpiret != MPI_SUCCESS) {
+      return mpiret;
+    }
+  }
+  free (pool->chunks);
+  free (pool);
+
+  return MPI_SUCCESS;
+}
+
+static sc_shmem_pool_t *
+sc_shmem_pool_get (sc_MPI_Comm intranode)
+{
+  int                 mpiret, flg;
+  sc_shmem_pool_t    *pool;
+
+  if (sc_shmem_pool_keyval == MPI_KEYVAL_INVALID) {
+    mpiret = MPI_Comm_create_keyval (MPI_COMM_NULL_COPY_FN,
+                                     sc_shmem_pool_destroy,
+                                     &sc_shmem_pool_keyval, NULL);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Comm_get_attr (intranode, sc_shmem_pool_keyval, &pool, &flg);
+  SC_CHECK_MPI (mpiret);
+  if (!flg) {
+    pool = (sc_shmem_pool_t *) calloc (1, sizeof (sc_shmem_pool_t));
+    SC_CHECK_ABORT (pool != NULL, "Shared window pool allocation");
+    mpiret = MPI_Comm_set_attr (intranode, sc_shmem_pool_keyval, pool);
+    SC_CHECK_MPI (mpiret);
+  }
+  return pool;
+}
+
+static sc_shmem_chunk_t *
+sc_shmem_chunk_new (sc_shmem_pool_t * pool, size_t size, int dedicated,
+                    sc_MPI_Comm intranode)
+{
+  int                 mpiret, disp_unit, intrarank;
+  MPI_Aint            winsize;
+  sc_shmem_chunk_t   *chunk;
 
   mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
   SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+
+  chunk = (sc_shmem_chunk_t *) calloc (1, sizeof (sc_shmem_chunk_t));
+  SC_CHECK_ABORT (chunk != NULL, "Shared window pool allocation");
+  chunk->size = size;
+  chunk->dedicated = dedicated;
+
+  winsize = intrarank ? 0 : (MPI_Aint) size;
+  mpiret = MPI_Win_allocate_shared (winsize, 1, MPI_INFO_NULL, intranode,
+                                    &chunk->base, &chunk->win);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_shared_query (chunk->win, 0, &winsize, &disp_unit,
+                                 &chunk->base);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_lock (MPI_LOCK_SHARED, 0, MPI_MODE_NOCHECK, chunk->win);
   SC_CHECK_MPI (mpiret);
-  return ((MPI_Win *) array)[-intrasize + intrarank];
+
+  pool->chunks = (sc_shmem_chunk_t **)
+    realloc (pool->chunks, (pool->num_chunks + 1) * sizeof (*pool->chunks));
+  SC_CHECK_ABORT (pool->chunks != NULL, "Shared window pool allocation");
+  pool->chunks[pool->num_chunks++] = chunk;
+
+  return chunk;
+}
+
+/** Find the first gap that fits and record the block there.
+ * \return    The offset of the block, or -1 if the chunk is too full.
+ */
+static ssize_t
+sc_shmem_chunk_alloc (sc_shmem_chunk_t * chunk, size_t bytes)
+{
+  size_t              i, start;
+
+  start = 0;
+  for (i = 0; i <= chunk->num_blocks; ++i) {
+    if ((i < chunk->num_blocks ? chunk->blocks[i].offset : chunk->size)
+        >= start + bytes) {
+      break;
+    }
+    start = chunk->blocks[i].offset + chunk->blocks[i].bytes;
+  }
+  if (i > chunk->num_blocks) {
+    return -1;
+  }
+
+  if (chunk->num_blocks == chunk->alloc_blocks) {
+    chunk->alloc_blocks = SC_MAX (8, 2 * chunk->alloc_blocks);
+    chunk->blocks = (sc_shmem_block_t *)
+      realloc (chunk->blocks, chunk->alloc_blocks * sizeof (*chunk->blocks));
+    SC_CHECK_ABORT (chunk->blocks != NULL, "Shared window pool allocation");
+  }
+  memmove (chunk->blocks + i + 1, chunk->blocks + i,
+           (chunk->num_blocks - i) * sizeof (*chunk->blocks));
+  chunk->blocks[i].offset = start;
+  chunk->blocks[i].bytes = bytes;
+  ++chunk->num_blocks;
+
+  return (ssize_t) start;
+}
+
+static sc_shmem_chunk_t *
+sc_shmem_chunk_find (sc_shmem_pool_t * pool, void *array, int *index)
+{
+  int                 i;
+  sc_shmem_chunk_t   *chunk;
+
+  for (i = 0; i < pool->num_chunks; ++i) {
+    chunk = pool->chunks[i];
+    if (chunk->base <= (char *) array &&
+        (char *) array < chunk->base + chunk->size) {
+      if (index != NULL) {
+        *index = i;
+      }
+      return chunk;
+    }
+  }
+  SC_ABORT ("Array not allocated by sc_shmem_malloc");
+  return NULL;
+}
+
+static              MPI_Win
+sc_shmem_get_win (void *array, sc_MPI_Comm comm, sc_MPI_Comm intranode,
+                  sc_MPI_Comm internode)
+{
+  return sc_shmem_chunk_find (sc_shmem_pool_get (intranode), array,
+                              NULL)->win;
 }
 
 static void        *
@@ -577,53 +949,71 @@ sc_shmem_malloc_window (int package, size_t elem_size, size_t elem_count,
                         sc_MPI_Comm comm, sc_MPI_Comm intranode,
                         sc_MPI_Comm internode)
 {
-  char               *array = NULL;
-  int                 mpiret, disp_unit, intrarank, intrasize;
-  MPI_Win             win;
-  MPI_Aint            winsize = 0;
+  int                 i;
+  size_t              bytes;
+  ssize_t             offset;
+  sc_shmem_pool_t    *pool;
+  sc_shmem_chunk_t   *chunk;
+
+  bytes = SC_MAX (elem_size * elem_count, 1);
+  bytes = (bytes + SC_SHMEM_POOL_ALIGN - 1) & ~(SC_SHMEM_POOL_ALIGN - 1);
+  pool = sc_shmem_pool_get (intranode);
+
+  /* large arrays get a window of their own */
+  if (bytes > SC_SHMEM_POOL_CHUNK / 2) {
+    chunk = sc_shmem_chunk_new (pool, bytes, 1, intranode);
+    offset = sc_shmem_chunk_alloc (chunk, bytes);
+    SC_ASSERT (offset == 0);
+    return chunk->base;
+  }
 
-  disp_unit = SC_MAX (elem_size, sizeof (MPI_Win));
-  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
-  SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
-  SC_CHECK_MPI (mpiret);
-  if (!intrarank) {
-    winsize = elem_size * elem_count + intrasize * sizeof (MPI_Win);
-    if (winsize % disp_unit) {
-      winsize = ((winsize / disp_unit) + 1) * disp_unit;
+  for (i = 0; i < pool->num_chunks; ++i) {
+    chunk = pool->chunks[i];
+    if (!chunk->dedicated &&
+        (offset = sc_shmem_chunk_alloc (chunk, bytes)) >= 0) {
+      return chunk->base + offset;
     }
   }
-  mpiret = MPI_Win_allocate_shared (winsize, disp_unit, MPI_INFO_NULL,
-                                    intranode, &array, &win);
-  SC_CHECK_MPI (mpiret);
-  mpiret = MPI_Win_shared_query (win, 0, &winsize, &disp_unit, &array);
-  SC_CHECK_MPI (mpiret);
-  /* store the windows at the front of the array */
-  mpiret = sc_MPI_Gather (&win, sizeof (MPI_Win), sc_MPI_BYTE,
-                          array, sizeof (MPI_Win), sc_MPI_BYTE, 0, intranode);
-  SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Barrier (intranode);
-  SC_CHECK_MPI (mpiret);
-
-  mpiret = MPI_Win_lock (MPI_LOCK_SHARED, 0, MPI_MODE_NOCHECK, win);
-  SC_CHECK_MPI (mpiret);
-
-  return ((MPI_Win *) array) + intrasize;
+  chunk = sc_shmem_chunk_new (pool, SC_SHMEM_POOL_CHUNK, 0, intranode);
+  offset = sc_shmem_chunk_alloc (chunk, bytes);
+  SC_ASSERT (offset == 0);
+  return chunk->base;
 }
 
 static void
 sc_shmem_free_window (int package, void *array, sc_MPI_Comm comm,
                       sc_MPI_Comm intranode, sc_MPI_Comm internode)
 {
-  int                 mpiret;
-  MPI_Win             win;
-
-  win = sc_shmem_get_win (array, comm, intranode, internode);
-
-  mpiret = MPI_Win_unlock (0, win);
-  SC_CHECK_MPI (mpiret);
-  mpiret = MPI_Win_free (&win);
-  SC_CHECK_MPI (mpiret);
+  int                 mpiret, index;
+  size_t              i, offset;
+  sc_shmem_pool_t    *pool;
+  sc_shmem_chunk_t   *chunk;
+
+  pool = sc_shmem_pool_get (intranode);
+  chunk = sc_shmem_chunk_find (pool, array, &index);
+  offset = (char *) array - chunk->base;
+  for (i = 0; i < chunk->num_blocks; ++i) {
+    if (chunk->blocks[i].offset == offset) {
+      break;
+    }
+  }
+  SC_CHECK_ABORT (i < chunk->num_blocks,
+                  "Array not allocated by sc_shmem_malloc");
+  memmove (chunk->blocks + i, chunk->blocks + i + 1,
+           (chunk->num_blocks - i - 1) * sizeof (*chunk->blocks));
+  --chunk->num_blocks;
+
+  /* regular chunks stay around to be reused by the next allocation */
+  if (chunk->dedicated) {
+    mpiret = sc_shmem_chunk_destroy (chunk);
+    SC_CHECK_MPI (mpiret);
+    pool->chunks[index] = pool->chunks[--pool->num_chunks];
+  }
+  else {
+    /* nobody may still read the memory once it is handed out again */
+    mpiret = sc_MPI_Barrier (intranode);
+    SC_CHECK_MPI (mpiret);
+  }
 }
 
 static int
@@ -719,6 +1109,7 @@ sc_shmem_free (int package, void *array, sc_MPI_Comm comm)
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
   case SC_SHMEM_PRESCAN:
@@ -739,6 +1130,7 @@ sc_shmem_free (int package, void *array, sc_MPI_Comm comm)
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_stats_leave ();
 }
 
 int
@@ -785,6 +1177,7 @@ sc_shmem_write_end (void *array, sc_MPI_Comm comm)
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
   case SC_SHMEM_PRESCAN:
@@ -805,6 +1198,7 @@ sc_shmem_write_end (void *array, sc_MPI_Comm comm)
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_stats_leave ();
 }
 
 void
@@ -820,6 +1214,7 @@ sc_shmem_memcpy (void *destarray, void *srcarray, size_t bytes,
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
   case SC_SHMEM_PRESCAN:
@@ -842,6 +1237,7 @@ sc_shmem_memcpy (void *destarray, void *srcarray, size_t bytes,
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_stats_leave ();
 }
 
 void
@@ -858,6 +1254,7 @@ sc_shmem_allgather (void *sendbuf, int sendcount,
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
   case SC_SHMEM_PRESCAN:
@@ -882,6 +1279,89 @@ sc_shmem_allgather (void *sendbuf, int sendcount,
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_stats_leave ();
+}
+
+void
+sc_shmem_allgatherv (void *sendbuf, int sendcount,
+                     sc_MPI_Datatype sendtype, void *recvbuf,
+                     int *recvcounts, int *displs,
+                     sc_MPI_Datatype recvtype, sc_MPI_Comm comm)
+{
+  sc_shmem_type_t     type;
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL, internode =
+    sc_MPI_COMM_NULL;
+
+  type = sc_shmem_get_type_default (comm);
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    type = SC_SHMEM_BASIC;
+  }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
+  switch (type) {
+  case SC_SHMEM_BASIC:
+  case SC_SHMEM_PRESCAN:
+    sc_shmem_allgatherv_basic (sendbuf, sendcount, sendtype, recvbuf,
+                               recvcounts, displs, recvtype, comm,
+                               intranode, internode);
+    break;
+#if defined(__bgq__) || defined(SC_ENABLE_MPIWINSHARED)
+#if defined(__bgq__)
+  case SC_SHMEM_BGQ:
+  case SC_SHMEM_BGQ_PRESCAN:
+#endif
+#if defined(SC_ENABLE_MPIWINSHARED)
+  case SC_SHMEM_WINDOW:
+  case SC_SHMEM_WINDOW_PRESCAN:
+#endif
+    sc_shmem_allgatherv_common (sendbuf, sendcount, sendtype, recvbuf,
+                                recvcounts, displs, recvtype, comm,
+                                intranode, internode);
+    break;
+#endif
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  sc_mpi_stats_leave ();
+}
+
+void
+sc_shmem_allreduce (void *sendbuf, void *recvbuf, int count,
+                    sc_MPI_Datatype dtype, sc_MPI_Op op, sc_MPI_Comm comm)
+{
+  sc_shmem_type_t     type;
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL, internode =
+    sc_MPI_COMM_NULL;
+
+  type = sc_shmem_get_type_default (comm);
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    type = SC_SHMEM_BASIC;
+  }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
+  switch (type) {
+  case SC_SHMEM_BASIC:
+  case SC_SHMEM_PRESCAN:
+    sc_shmem_allreduce_basic (sendbuf, recvbuf, count, dtype, op, comm,
+                              intranode, internode);
+    break;
+#if defined(__bgq__) || defined(SC_ENABLE_MPIWINSHARED)
+#if defined(__bgq__)
+  case SC_SHMEM_BGQ:
+  case SC_SHMEM_BGQ_PRESCAN:
+#endif
+#if defined(SC_ENABLE_MPIWINSHARED)
+  case SC_SHMEM_WINDOW:
+  case SC_SHMEM_WINDOW_PRESCAN:
+#endif
+    sc_shmem_allreduce_common (sendbuf, recvbuf, count, dtype, op, comm,
+                               intranode, internode);
+    break;
+#endif
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  sc_mpi_stats_leave ();
 }
 
 void
@@ -897,6 +1377,7 @@ sc_shmem_prefix (void *sendbuf, void *recvbuf, int count,
   if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
     type = SC_SHMEM_BASIC;
   }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_SHMEM);
   switch (type) {
   case SC_SHMEM_BASIC:
     sc_shmem_prefix_basic (sendbuf, recvbuf, count, dtype, op, comm,
@@ -931,4 +1412,5 @@ sc_shmem_prefix (void *sendbuf, void *recvbuf, int count,
   default:
     SC_ABORT_NOT_REACHED ();
   }
+  sc_mpi_stats_leave ();
 }
@@ -27,6 +27,23 @@
 #include <sc.h>
 #include <sc_mpi.h>
 
+/** Size of the shared windows that the WINDOW types suballocate from. */
+#ifndef SC_SHMEM_POOL_CHUNK
+#define SC_SHMEM_POOL_CHUNK ((size_t) 1 << 20)
+#endif
+
+/** Alignment of arrays within a shared window; a power of two. */
+#ifndef SC_SHMEM_POOL_ALIGN
+#define SC_SHMEM_POOL_ALIGN ((size_t) 64)
+#endif
+
+/** Prefix scans over at least this many items per process are split
+ * between threads and, for SC_SHMEM_WINDOW, between the processes of a
+ * node that then write their slices of the shared array concurrently. */
+#ifndef SC_SHMEM_SCAN_SPLIT
+#define SC_SHMEM_SCAN_SPLIT 4096
+#endif
+
 SC_EXTERN_C_BEGIN;
 
 /** \file sc_shmem.h */
@@ -49,7 +66,9 @@ typedef enum
                                 for shared-heap environments */
 #endif
   SC_SHMEM_NUM_TYPES,
-  SC_SHMEM_NOT_SET
+  SC_SHMEM_NOT_SET,
+  SC_SHMEM_AUTO            /**< resolved by sc_shmem_set_type to the fastest
+                                type for this MPI and node layout */
 }
 sc_shmem_type_t;
 
@@ -61,9 +80,11 @@ extern sc_shmem_type_t sc_shmem_default_type;
  * every process in the communicator */
 
 /** Set the type of shared memory arrays to use on this mpi communicator.
+ * The default type is SC_SHMEM_AUTO unless SC_SHMEM_DEFAULT is defined.
  *
  * \param[in,out] comm        the mpi communicator
- * \param[in]     type        the type of shmem array behavior.
+ * \param[in]     type        the type of shmem array behavior,
+ *                            or SC_SHMEM_AUTO to choose the fastest.
  */
 void                sc_shmem_set_type (sc_MPI_Comm comm,
                                        sc_shmem_type_t type);
@@ -77,6 +98,10 @@ void                sc_shmem_set_type (sc_MPI_Comm comm,
 sc_shmem_type_t     sc_shmem_get_type (sc_MPI_Comm comm);
 
 /** Allocate a shmem array: an array that is redundant on every process.
+ * The WINDOW types place small arrays into a pool of shared windows of
+ * SC_SHMEM_POOL_CHUNK bytes kept per node, such that most allocations do
+ * not create a window.  The pool lives until the node communicators of
+ * \a comm are freed.
  *
  * \param[in] package         package requesting memory
  * \param[in] elem_size       the size of each element in the array
@@ -145,6 +170,42 @@ void                sc_shmem_allgather (void *sendbuf, int sendcount,
                                         sc_MPI_Datatype recvtype,
                                         sc_MPI_Comm comm);
 
+/** Fill a shmem array with an allgather of varying counts.
+ * The node roots gather the contributions of their node, exchange them
+ * between nodes by \ref sc_allgatherv, and write the result once per node.
+ * Without node communicators, \ref sc_allgatherv fills every copy.
+ *
+ * \param[in] sendbuf         the source from this process
+ * \param[in] sendcount       the number of items from this process
+ * \param[in] sendtype        the type of items to allgather
+ * \param[in,out] recvbuf     the destination shmem array
+ * \param[in] recvcounts      the number of items from every process
+ * \param[in] displs          the offset of the items of every process
+ * \param[in] recvtype        the type of items to allgather
+ * \param[in] comm            the mpi communicator
+ */
+void                sc_shmem_allgatherv (void *sendbuf, int sendcount,
+                                         sc_MPI_Datatype sendtype,
+                                         void *recvbuf, int *recvcounts,
+                                         int *displs,
+                                         sc_MPI_Datatype recvtype,
+                                         sc_MPI_Comm comm);
+
+/** Fill a shmem array with an allreduce.
+ * The processes of a node first reduce to the node root, then only the
+ * node roots communicate between nodes and write the result once per node.
+ * Every process reads it from the shared array without a private copy.
+ * \param[in] sendbuf         the source from this process
+ * \param[in,out] recvbuf     the destination shmem array of \a count items
+ * \param[in] count           the number of items to allreduce
+ * \param[in] type            the type of items to allreduce
+ * \param[in] op              the operation (e.g., sc_MPI_SUM)
+ * \param[in] comm            the mpi communicator
+ */
+void                sc_shmem_allreduce (void *sendbuf, void *recvbuf,
+                                        int count, sc_MPI_Datatype type,
+                                        sc_MPI_Op op, sc_MPI_Comm comm);
+
 /** Fill a shmem array with an allgather of the prefix op over all processes.
  *
  * The return array will be
@@ -26,6 +26,7 @@
 #endif
 #include <sc_containers.h>
 #include <sc_sort.h>
+#include <sc_tracer.h>
 
 typedef struct sc_psort_peer
 {
@@ -137,8 +138,10 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     sc_array_t          r, *pr = &r;
     sc_array_t          s, *ps = &s;
     int                *wait_indices, *wait_indices2;
+    char               *temp;
     sc_MPI_Status      *recv_statuses, *recv_statuses2;
     sc_psort_peer_t    *peer;
+    sc_arena_t         *arena = sc_arena_default ();
 
     for (k = 1; k < n;) {
       k = k << 1;
@@ -154,6 +157,9 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     sc_array_init (pr, sizeof (sc_MPI_Request));
     sc_array_init (ps, sizeof (sc_MPI_Request));
 
+    /* all temporary buffers are released at once after the exchange */
+    sc_arena_push (arena);
+
     /* loop 1: initiate communication */
     lo_owner = hi_owner = rank;
     offset = max_length = 0;
@@ -173,7 +179,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
       if (lo_owner == rank && hi_owner != rank) {
         char               *lo_data;
         sc_MPI_Request     *rreq, *sreq;
-        const int           bytes = (int) (max_length * size);
+        const size_t        bytes = max_length * size;
 
         /* receive high part, send low part */
         peer = (sc_psort_peer_t *) sc_array_push (pa);
@@ -185,24 +191,22 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         peer->sent = 0;
         peer->prank = hi_owner;
         peer->length = max_length;
-        peer->buffer = SC_ALLOC (char, bytes);
+        peer->buffer = SC_ARENA_ALLOC (arena, char, bytes);
         peer->my_start = lo_data;
-        mpiret = sc_MPI_Irecv (peer->buffer, bytes, sc_MPI_BYTE,
-                               peer->prank, SC_TAG_PSORT_HI, pst->mpicomm,
-                               rreq);
+        mpiret = sc_mpi_irecv_large (peer->buffer, bytes, peer->prank,
+                                     SC_TAG_PSORT_HI, pst->mpicomm, rreq);
         SC_CHECK_MPI (mpiret);
 
         SC_ASSERT (lo_data >= pst->my_base);
         SC_ASSERT (lo_data + bytes <= pst->my_base + pst->my_count * size);
-        mpiret = sc_MPI_Isend (lo_data, bytes, sc_MPI_BYTE,
-                               peer->prank, SC_TAG_PSORT_LO, pst->mpicomm,
-                               sreq);
+        mpiret = sc_mpi_isend_large (lo_data, bytes, peer->prank,
+                                     SC_TAG_PSORT_LO, pst->mpicomm, sreq);
         SC_CHECK_MPI (mpiret);
       }
       else if (lo_owner != rank && hi_owner == rank) {
         char               *hi_data;
         sc_MPI_Request     *rreq, *sreq;
-        const int           bytes = (int) (max_length * size);
+        const size_t        bytes = max_length * size;
 
         /* receive low part, send high part */
         peer = (sc_psort_peer_t *) sc_array_push (pa);
@@ -214,24 +218,23 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
         peer->sent = 0;
         peer->prank = lo_owner;
         peer->length = max_length;
-        peer->buffer = SC_ALLOC (char, bytes);
+        peer->buffer = SC_ARENA_ALLOC (arena, char, bytes);
         peer->my_start = hi_data;
 
-        mpiret = sc_MPI_Irecv (peer->buffer, bytes, sc_MPI_BYTE,
-                               peer->prank, SC_TAG_PSORT_LO, pst->mpicomm,
-                               rreq);
+        mpiret = sc_mpi_irecv_large (peer->buffer, bytes, peer->prank,
+                                     SC_TAG_PSORT_LO, pst->mpicomm, rreq);
         SC_CHECK_MPI (mpiret);
 
         SC_ASSERT (hi_data >= pst->my_base);
         SC_ASSERT (hi_data + bytes <= pst->my_base + pst->my_count * size);
-        mpiret = sc_MPI_Isend (hi_data, bytes, sc_MPI_BYTE,
-                               peer->prank, SC_TAG_PSORT_HI, pst->mpicomm,
-                               sreq);
+        mpiret = sc_mpi_isend_large (hi_data, bytes, peer->prank,
+                                     SC_TAG_PSORT_HI, pst->mpicomm, sreq);
         SC_CHECK_MPI (mpiret);
       }
     }
 
-    /* loop 2: local computation */
+    /* loop 2: local computation with one scratch element for swapping */
+    temp = SC_ARENA_ALLOC (arena, char, size);
     lo_owner = hi_owner = rank;
     offset = max_length = 0;
     for (offset = 0; offset < lo_end - lo; offset += max_length) {
@@ -250,7 +253,6 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
       if (lo_owner == rank && hi_owner == rank) {
         size_t              zz;
         char               *lo_data, *hi_data;
-        char               *temp = SC_ALLOC (char, size);
 
         /* local comparisons only */
         lo_data = pst->my_base + (lo + offset - pst->my_lo) * size;
@@ -264,7 +266,6 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
           lo_data += size;
           hi_data += size;
         }
-        SC_FREE (temp);
       }
     }
 
@@ -272,10 +273,10 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     outcount = 0;
     outcount2 = 0;
     num_peers = (int) pa->elem_count;
-    wait_indices = SC_ALLOC (int, num_peers);
-    wait_indices2 = SC_ALLOC (int, num_peers);
-    recv_statuses = SC_ALLOC (sc_MPI_Status, num_peers);
-    recv_statuses2 = SC_ALLOC (sc_MPI_Status, num_peers);
+    wait_indices = SC_ARENA_ALLOC (arena, int, num_peers);
+    wait_indices2 = SC_ARENA_ALLOC (arena, int, num_peers);
+    recv_statuses = SC_ARENA_ALLOC (arena, sc_MPI_Status, num_peers);
+    recv_statuses2 = SC_ARENA_ALLOC (arena, sc_MPI_Status, num_peers);
     for (remaining = num_peers, remaining2 = num_peers;
          remaining > 0 || remaining2 > 0;
          remaining -= outcount, remaining2 -= outcount2) {
@@ -331,7 +332,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
             }
 
             /* close down this peer */
-            SC_FREE (peer->buffer);
+            peer->buffer = NULL;
           }
           peer->received = 1;
         }
@@ -380,7 +381,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
             }
 
             /* close down this peer */
-            SC_FREE (peer->buffer);
+            peer->buffer = NULL;
           }
           peer->sent = 1;
         }
@@ -388,10 +389,6 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     }
     SC_ASSERT (remaining == 0);
     SC_ASSERT (remaining2 == 0);
-    SC_FREE (recv_statuses);
-    SC_FREE (wait_indices);
-    SC_FREE (recv_statuses2);
-    SC_FREE (wait_indices2);
 
     /* clean up */
     if (num_peers > 0) {
@@ -402,6 +399,7 @@ sc_merge_bitonic (sc_psort_t * pst, size_t lo, size_t hi, int dir)
     sc_array_reset (pa);
     sc_array_reset (pr);
     sc_array_reset (ps);
+    sc_arena_pop (arena);
 
     /* recursive merge */
     sc_merge_bitonic (pst, lo, lo + n2, dir);
@@ -449,6 +447,8 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t * nmemb, size_t size,
 #ifndef SC_HAVE_QSORT_R
   SC_ASSERT (sc_compare == NULL);
 #endif
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_PSORT);
 
   /* get basic MPI information */
   mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
@@ -487,4 +487,634 @@ sc_psort (sc_MPI_Comm mpicomm, void *base, size_t * nmemb, size_t size,
   sc_compare = NULL;
 #endif
   SC_FREE (gmemb);
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
+}
+
+/** Average number of splitter samples per process in sc_psort_sample. */
+#define SC_PSORT_SAMPLES 32
+
+/** Stably merge consecutive sorted runs of records pairwise.
+ * Records compare by their leading data item; ties prefer the lower run.
+ * \param [in] src      Records, overwritten as a temporary buffer.
+ * \param [in] dst      Temporary buffer of the same size as \a src.
+ * \param [in] bounds   Array of num_runs + 1 record offsets of the runs.
+ * \return              Either \a src or \a dst, whichever has the result.
+ */
+static char        *
+sc_psort_merge_runs (char *src, char *dst, size_t rsize,
+                     const size_t * bounds, int num_runs,
+                     int (*compar) (const void *, const void *))
+{
+  int                 t, width;
+  size_t              i, j, mid, hi;
+  char               *d, *tmp;
+
+  for (width = 1; width < num_runs; width *= 2) {
+    for (t = 0; t < num_runs; t += 2 * width) {
+      i = bounds[t];
+      j = mid = bounds[SC_MIN (t + width, num_runs)];
+      hi = bounds[SC_MIN (t + 2 * width, num_runs)];
+      d = dst + i * rsize;
+      while (i < mid && j < hi) {
+        if (compar (src + j * rsize, src + i * rsize) < 0) {
+          memcpy (d, src + j++ * rsize, rsize);
+        }
+        else {
+          memcpy (d, src + i++ * rsize, rsize);
+        }
+        d += rsize;
+      }
+      memcpy (d, src + i * rsize, (mid - i) * rsize);
+      d += (mid - i) * rsize;
+      memcpy (d, src + j * rsize, (hi - j) * rsize);
+    }
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  return src;
+}
+
+/** Return the number of splitter samples taken on one process. */
+static              size_t
+sc_psort_num_samples (size_t count, size_t total, int num_procs)
+{
+  size_t              s;
+
+  if (count == 0) {
+    return 0;
+  }
+  s = (SC_PSORT_SAMPLES * (size_t) num_procs * count + total - 1) / total;
+  return SC_MIN (s, count);
+}
+
+/** Count the sorted local items that are less than a sample.
+ * Items and sample compare by value, and if equal by global position.
+ */
+static              size_t
+sc_psort_count_below (const char *my_base, size_t my_count, size_t size,
+                      size_t my_lo, const char *sample,
+                      int (*compar) (const void *, const void *))
+{
+  int                 cmp;
+  size_t              lo, hi, mid, g;
+
+  memcpy (&g, sample + size, sizeof (size_t));
+  lo = 0;
+  hi = my_count;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    cmp = compar (my_base + mid * size, sample);
+    if (cmp < 0 || (cmp == 0 && my_lo + mid < g)) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/** Move locally sorted items into a globally sorted target partition.
+ * \param [in] my_base     Local items sorted wrt. \a compar.
+ * \param [in] gmemb       Global offsets of the input partition.
+ * \param [in] toff        Global offsets of the output partition.
+ * \param [out] out        Room for the local items of the output partition.
+ */
+static void
+sc_psort_exchange (sc_MPI_Comm mpicomm, int num_procs, int rank,
+                   const char *my_base, const size_t * gmemb, size_t size,
+                   int (*compar) (const void *, const void *),
+                   const size_t * toff, char *out)
+{
+  const size_t        rsize = size + sizeof (size_t);
+  const size_t        total = gmemb[num_procs];
+  const size_t        my_lo = gmemb[rank];
+  const size_t        my_count = gmemb[rank + 1] - my_lo;
+  int                 mpiret;
+  int                 q;
+  int                *sendc, *senddispl, *recvc, *recvdispl;
+  size_t              zz, s, lo, hi, g, nsamples, bucket_count;
+  size_t             *bounds, *boff;
+  long long           lbucket, *lbuckets;
+  char               *samples, *allsamples, *temp, *sorted, *bucket;
+
+  /* pick regular samples tagged with their global position */
+  nsamples = sc_psort_num_samples (my_count, total, num_procs);
+  samples = SC_ALLOC (char, nsamples * rsize);
+  for (zz = 0; zz < nsamples; ++zz) {
+    s = (2 * zz + 1) * my_count / (2 * nsamples);
+    g = my_lo + s;
+    memcpy (samples + zz * rsize, my_base + s * size, size);
+    memcpy (samples + zz * rsize + size, &g, sizeof (size_t));
+  }
+
+  /* the sample counts are known everywhere from the input partition */
+  sendc = SC_ALLOC (int, 4 * num_procs);
+  senddispl = sendc + num_procs;
+  recvc = senddispl + num_procs;
+  recvdispl = recvc + num_procs;
+  bounds = SC_ALLOC (size_t, num_procs + 1);
+  bounds[0] = 0;
+  for (q = 0; q < num_procs; ++q) {
+    s = sc_psort_num_samples (gmemb[q + 1] - gmemb[q], total, num_procs);
+    bounds[q + 1] = bounds[q] + s;
+    recvc[q] = (int) (s * rsize);
+    recvdispl[q] = (int) (bounds[q] * rsize);
+  }
+  allsamples = SC_ALLOC (char, bounds[num_procs] * rsize);
+  temp = SC_ALLOC (char, bounds[num_procs] * rsize);
+  mpiret = sc_MPI_Allgatherv (samples, (int) (nsamples * rsize),
+                              sc_MPI_BYTE, allsamples, recvc, recvdispl,
+                              sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (samples);
+
+  /* the samples are ordered by value, then by position, on all processes */
+  sorted = sc_psort_merge_runs (allsamples, temp, rsize, bounds, num_procs,
+                                compar);
+
+  /* count the local items below each splitter */
+  nsamples = bounds[num_procs];
+  for (q = 0, lo = 0; q < num_procs; ++q, lo = hi) {
+    hi = my_count;
+    if (q < num_procs - 1 && nsamples > 0) {
+      hi = sc_psort_count_below (my_base, my_count, size, my_lo,
+                                 sorted + (q + 1) * nsamples / num_procs *
+                                 rsize, compar);
+    }
+    SC_ASSERT (lo <= hi);
+    senddispl[q] = (int) (lo * size);
+    sendc[q] = (int) ((hi - lo) * size);
+  }
+  SC_FREE (allsamples);
+  SC_FREE (temp);
+
+  /* exchange the buckets of items between the splitters */
+  mpiret = sc_MPI_Alltoall (sendc, 1, sc_MPI_INT, recvc, 1, sc_MPI_INT,
+                            mpicomm);
+  SC_CHECK_MPI (mpiret);
+  bounds[0] = 0;
+  for (q = 0; q < num_procs; ++q) {
+    recvdispl[q] = (int) (bounds[q] * size);
+    bounds[q + 1] = bounds[q] + (size_t) recvc[q] / size;
+  }
+  bucket_count = bounds[num_procs];
+  bucket = SC_ALLOC (char, bucket_count * size);
+  temp = SC_ALLOC (char, bucket_count * size);
+  mpiret = sc_MPI_Alltoallv ((void *) my_base, sendc, senddispl,
+                             sc_MPI_BYTE, bucket, recvc, recvdispl,
+                             sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sorted = sc_psort_merge_runs (bucket, temp, size, bounds, num_procs,
+                                compar);
+  if (sorted != bucket) {
+    SC_FREE (bucket);
+    bucket = sorted;
+  }
+  else {
+    SC_FREE (temp);
+  }
+
+  /* global offsets of the buckets */
+  lbucket = (long long) bucket_count;
+  lbuckets = SC_ALLOC (long long, num_procs);
+  mpiret = sc_MPI_Allgather (&lbucket, 1, sc_MPI_LONG_LONG_INT,
+                             lbuckets, 1, sc_MPI_LONG_LONG_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  boff = SC_ALLOC (size_t, num_procs + 1);
+  boff[0] = 0;
+  for (q = 0; q < num_procs; ++q) {
+    boff[q + 1] = boff[q] + (size_t) lbuckets[q];
+  }
+  SC_ASSERT (boff[num_procs] == total && toff[num_procs] == total);
+  SC_FREE (lbuckets);
+
+  /* move the sorted buckets into the output partition */
+  for (q = 0; q < num_procs; ++q) {
+    lo = SC_MAX (boff[rank], toff[q]);
+    hi = SC_MIN (boff[rank + 1], toff[q + 1]);
+    sendc[q] = lo < hi ? (int) ((hi - lo) * size) : 0;
+    senddispl[q] = lo < hi ? (int) ((lo - boff[rank]) * size) : 0;
+    lo = SC_MAX (boff[q], toff[rank]);
+    hi = SC_MIN (boff[q + 1], toff[rank + 1]);
+    recvc[q] = lo < hi ? (int) ((hi - lo) * size) : 0;
+    recvdispl[q] = lo < hi ? (int) ((lo - toff[rank]) * size) : 0;
+  }
+  mpiret = sc_MPI_Alltoallv (bucket, sendc, senddispl, sc_MPI_BYTE,
+                             out, recvc, recvdispl, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  SC_FREE (bucket);
+  SC_FREE (boff);
+  SC_FREE (bounds);
+  SC_FREE (sendc);
+}
+
+/** Compute global offsets of an input or output partition.
+ * \param [in] nmemb    If not NULL, the counts of the partition.
+ * \param [in] weights  If \a nmemb is NULL and this is not NULL,
+ *                      nonnegative weights of the processes.
+ *                      If both are NULL, we compute a balanced partition.
+ * \return              Allocated array of num_procs + 1 offsets.
+ */
+static size_t      *
+sc_psort_offsets (int num_procs, const size_t * nmemb,
+                  const double *weights, size_t total)
+{
+  int                 q;
+  double              wsum, wpart;
+  size_t             *off = SC_ALLOC (size_t, num_procs + 1);
+
+  off[0] = 0;
+  if (nmemb != NULL) {
+    for (q = 0; q < num_procs; ++q) {
+      off[q + 1] = off[q] + nmemb[q];
+    }
+  }
+  else if (weights != NULL) {
+    for (wsum = 0., q = 0; q < num_procs; ++q) {
+      SC_ASSERT (weights[q] >= 0.);
+      wsum += weights[q];
+    }
+    SC_CHECK_ABORT (wsum > 0., "Sort needs a positive sum of weights");
+    for (wpart = 0., q = 0; q < num_procs - 1; ++q) {
+      wpart += weights[q];
+      off[q + 1] = (size_t) ((double) total * (wpart / wsum));
+      off[q + 1] = SC_MIN (SC_MAX (off[q + 1], off[q]), total);
+    }
+    off[num_procs] = total;
+  }
+  else {
+    for (q = 0; q < num_procs; ++q) {
+      off[q + 1] = total / num_procs * (q + 1) +
+        SC_MIN ((size_t) q + 1, total % num_procs);
+    }
+  }
+  return off;
+}
+
+void
+sc_psort_sample (sc_MPI_Comm mpicomm, void *base, size_t * nmemb,
+                 size_t size, int (*compar) (const void *, const void *),
+                 sc_array_t * rebalanced)
+{
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 q;
+  size_t             *gmemb, *toff;
+  char               *my_base = (char *) base;
+  char               *out;
+
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_PSORT);
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (rebalanced == NULL || rebalanced->elem_size == size);
+
+  /* global offsets of the input and output partitions */
+  gmemb = sc_psort_offsets (num_procs, nmemb, NULL, 0);
+  toff = sc_psort_offsets (num_procs, rebalanced == NULL ? nmemb : NULL,
+                           NULL, gmemb[num_procs]);
+  SC_GLOBAL_LDEBUGF ("Total values to sample sort %lld\n",
+                     (long long) gmemb[num_procs]);
+
+  /* sort locally and exchange */
+  qsort (my_base, nmemb[rank], size, compar);
+  if (rebalanced == NULL) {
+    out = my_base;
+  }
+  else {
+    sc_array_resize (rebalanced, toff[rank + 1] - toff[rank]);
+    out = rebalanced->array;
+    for (q = 0; q < num_procs; ++q) {
+      nmemb[q] = toff[q + 1] - toff[q];
+    }
+  }
+  sc_psort_exchange (mpicomm, num_procs, rank, my_base, gmemb, size,
+                     compar, toff, out);
+
+  SC_FREE (toff);
+  SC_FREE (gmemb);
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
+}
+
+/** Item size from which \ref sc_psort_ext sorts keys and indices only. */
+#define SC_PSORT_INDIRECT_MIN 64
+
+/** Prefix of the items sorted by \ref sc_psort_ext. */
+typedef struct sc_psort_record
+{
+  sc_uint128_t        key;      /**< Key transformed to be unsigned. */
+  size_t              g;        /**< Global position of the input item. */
+}
+sc_psort_record_t;
+
+/** Compare records by key, then by input position. */
+static int
+sc_psort_record_compare (const void *v1, const void *v2)
+{
+  sc_psort_record_t   r1, r2;
+
+  memcpy (&r1, v1, sizeof (sc_psort_record_t));
+  memcpy (&r2, v2, sizeof (sc_psort_record_t));
+  if (r1.key.high_bits != r2.key.high_bits) {
+    return r1.key.high_bits < r2.key.high_bits ? -1 : 1;
+  }
+  if (r1.key.low_bits != r2.key.low_bits) {
+    return r1.key.low_bits < r2.key.low_bits ? -1 : 1;
+  }
+  return r1.g < r2.g ? -1 : r1.g > r2.g ? 1 : 0;
+}
+
+/** Fetch the items of parallel arrays for the sorted records.
+ * Every process asks the holders of its output items for them by local
+ * index, and the holders reply with one exchange of packed item rows.
+ * \param [in] gmemb       Global offsets of the input partition.
+ * \param [in] out         Local records of the output partition.
+ * \param [in] my_new      Number of local records in the output.
+ * \param [in,out] arrays  Parallel arrays of the local input items,
+ *                         resized to and filled with the output items.
+ */
+static void
+sc_psort_move (sc_MPI_Comm mpicomm, int num_procs, int rank,
+               const size_t * gmemb, const sc_psort_record_t * out,
+               size_t my_new, sc_array_t ** arrays, int num_arrays)
+{
+  int                 mpiret;
+  int                 a, q;
+  int                *sendc, *senddispl, *recvc, *recvdispl;
+  size_t              zz, k, rowsize, nask;
+  size_t             *aoff, *reqc, *owner, *order, *ask, *idx;
+  char               *rows, *got;
+
+  /* the items of one position are packed into a row of all arrays */
+  aoff = SC_ALLOC (size_t, num_arrays + 1);
+  aoff[0] = 0;
+  for (a = 0; a < num_arrays; ++a) {
+    aoff[a + 1] = aoff[a] + arrays[a]->elem_size;
+  }
+  rowsize = aoff[num_arrays];
+
+  /* group the output positions by the process holding their input */
+  reqc = SC_ALLOC (size_t, num_procs + 1);
+  memset (reqc, 0, (num_procs + 1) * sizeof (size_t));
+  owner = SC_ALLOC (size_t, my_new);
+  for (zz = 0, q = rank; zz < my_new; ++zz) {
+    q = (int) sc_bsearch_cumulative (gmemb, (size_t) num_procs,
+                                     out[zz].g, (size_t) q);
+    owner[zz] = (size_t) q;
+    ++reqc[q + 1];
+  }
+  for (q = 0; q < num_procs; ++q) {
+    reqc[q + 1] += reqc[q];
+  }
+  order = SC_ALLOC (size_t, my_new);
+  ask = SC_ALLOC (size_t, my_new);
+  for (zz = 0; zz < my_new; ++zz) {
+    k = reqc[owner[zz]]++;
+    order[k] = zz;
+    ask[k] = out[zz].g - gmemb[owner[zz]];
+  }
+  SC_FREE (owner);
+
+  /* send the requested local indices to their holders */
+  sendc = SC_ALLOC (int, 4 * num_procs);
+  senddispl = sendc + num_procs;
+  recvc = senddispl + num_procs;
+  recvdispl = recvc + num_procs;
+  for (q = 0, k = 0; q < num_procs; ++q) {
+    senddispl[q] = (int) (k * sizeof (size_t));
+    sendc[q] = (int) ((reqc[q] - k) * sizeof (size_t));
+    k = reqc[q];
+  }
+  mpiret = sc_MPI_Alltoall (sendc, 1, sc_MPI_INT, recvc, 1, sc_MPI_INT,
+                            mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (q = 0, nask = 0; q < num_procs; ++q) {
+    recvdispl[q] = (int) (nask * sizeof (size_t));
+    nask += (size_t) recvc[q] / sizeof (size_t);
+  }
+  idx = SC_ALLOC (size_t, nask);
+  mpiret = sc_MPI_Alltoallv (ask, sendc, senddispl, sc_MPI_BYTE,
+                             idx, recvc, recvdispl, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (ask);
+
+  /* pack the requested rows and reply in one exchange */
+  rows = SC_ALLOC (char, nask * rowsize);
+  for (k = 0; k < nask; ++k) {
+    for (a = 0; a < num_arrays; ++a) {
+      memcpy (rows + k * rowsize + aoff[a],
+              sc_array_index (arrays[a], idx[k]), arrays[a]->elem_size);
+    }
+  }
+  SC_FREE (idx);
+  for (q = 0; q < num_procs; ++q) {
+    recvc[q] = (int) ((size_t) recvc[q] / sizeof (size_t) * rowsize);
+    recvdispl[q] = (int) ((size_t) recvdispl[q] / sizeof (size_t) *
+                          rowsize);
+    sendc[q] = (int) ((size_t) sendc[q] / sizeof (size_t) * rowsize);
+    senddispl[q] = (int) ((size_t) senddispl[q] / sizeof (size_t) *
+                          rowsize);
+  }
+  got = SC_ALLOC (char, my_new * rowsize);
+  mpiret = sc_MPI_Alltoallv (rows, recvc, recvdispl, sc_MPI_BYTE,
+                             got, sendc, senddispl, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_FREE (rows);
+
+  /* unpack the rows into the output positions */
+  for (a = 0; a < num_arrays; ++a) {
+    sc_array_resize (arrays[a], my_new);
+    for (k = 0; k < my_new; ++k) {
+      memcpy (sc_array_index (arrays[a], order[k]),
+              got + k * rowsize + aoff[a], arrays[a]->elem_size);
+    }
+  }
+
+  SC_FREE (got);
+  SC_FREE (sendc);
+  SC_FREE (order);
+  SC_FREE (reqc);
+  SC_FREE (aoff);
+}
+
+void
+sc_psort_ext (sc_MPI_Comm mpicomm, sc_array_t * array, size_t * nmemb,
+              sc_psort_key_t key_fn, void *user,
+              size_t key_offset, sc_array_key_t key_type,
+              const double *weights)
+{
+  const size_t        size = array->elem_size;
+  const size_t        rsize = sizeof (sc_psort_record_t) + size;
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 q;
+  size_t              zz, my_count, my_new;
+  size_t             *gmemb, *toff;
+  char               *records, *out;
+  sc_psort_record_t   rec;
+  sc_array_t          view;
+
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_PSORT);
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (array->elem_count == nmemb[rank]);
+
+  /* large items only move once after the keys are sorted */
+  if (size >= SC_PSORT_INDIRECT_MIN) {
+    sc_psort_arrays (mpicomm, array, NULL, 0, nmemb, key_fn, user,
+                     key_offset, key_type, weights, NULL);
+    sc_mpi_stats_leave ();
+    sc_tracer_end (__func__);
+    return;
+  }
+
+  gmemb = sc_psort_offsets (num_procs, nmemb, NULL, 0);
+  toff = sc_psort_offsets (num_procs, NULL, weights, gmemb[num_procs]);
+  SC_GLOBAL_LDEBUGF ("Total values to sort by key %lld\n",
+                     (long long) gmemb[num_procs]);
+
+  /* prefix each item with its key and input position */
+  my_count = array->elem_count;
+  records = SC_ALLOC (char, my_count * rsize);
+  for (zz = 0; zz < my_count; ++zz) {
+    const void         *item = sc_array_index (array, zz);
+
+    if (key_fn != NULL) {
+      key_fn (item, &rec.key, user);
+    }
+    else {
+      sc_array_key_transform (item, key_offset, key_type,
+                              &rec.key.high_bits, &rec.key.low_bits);
+    }
+    rec.g = gmemb[rank] + zz;
+    memcpy (records + zz * rsize, &rec, sizeof (sc_psort_record_t));
+    memcpy (records + zz * rsize + sizeof (sc_psort_record_t), item, size);
+  }
+
+  /* the radix sort is stable, so ties stay in order of position */
+  sc_array_init_data (&view, records, rsize, my_count);
+  sc_array_sort_keyed (&view, offsetof (sc_psort_record_t, key),
+                       SC_ARRAY_KEY_UINT128);
+
+  my_new = toff[rank + 1] - toff[rank];
+  out = SC_ALLOC (char, my_new * rsize);
+  sc_psort_exchange (mpicomm, num_procs, rank, records, gmemb, rsize,
+                     sc_psort_record_compare, toff, out);
+  SC_FREE (records);
+
+  /* strip the prefix */
+  sc_array_resize (array, my_new);
+  for (zz = 0; zz < my_new; ++zz) {
+    memcpy (sc_array_index (array, zz),
+            out + zz * rsize + sizeof (sc_psort_record_t), size);
+  }
+  for (q = 0; q < num_procs; ++q) {
+    nmemb[q] = toff[q + 1] - toff[q];
+  }
+
+  SC_FREE (out);
+  SC_FREE (toff);
+  SC_FREE (gmemb);
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
+}
+
+void
+sc_psort_arrays (sc_MPI_Comm mpicomm, sc_array_t * keys,
+                 sc_array_t ** arrays, int num_arrays, size_t * nmemb,
+                 sc_psort_key_t key_fn, void *user,
+                 size_t key_offset, sc_array_key_t key_type,
+                 const double *weights, sc_array_t * origin)
+{
+  int                 mpiret;
+  int                 num_procs, rank;
+  int                 a, q;
+  size_t              zz, my_count, my_new;
+  size_t             *gmemb, *toff;
+  sc_psort_record_t  *records, *out;
+  sc_array_t        **all;
+  sc_array_t          view;
+
+  sc_tracer_begin (__func__);
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_PSORT);
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  SC_ASSERT (SC_ARRAY_IS_OWNER (keys));
+  SC_ASSERT (keys->elem_count == nmemb[rank]);
+  SC_ASSERT (num_arrays >= 0);
+  SC_ASSERT (num_arrays == 0 || arrays != NULL);
+  SC_ASSERT (origin == NULL || origin->elem_size == sizeof (size_t));
+
+  gmemb = sc_psort_offsets (num_procs, nmemb, NULL, 0);
+  toff = sc_psort_offsets (num_procs, NULL, weights, gmemb[num_procs]);
+  SC_GLOBAL_LDEBUGF ("Total values to sort by key and index %lld\n",
+                     (long long) gmemb[num_procs]);
+
+  /* sort only the keys and input positions */
+  my_count = keys->elem_count;
+  records = SC_ALLOC (sc_psort_record_t, my_count);
+  for (zz = 0; zz < my_count; ++zz) {
+    const void         *item = sc_array_index (keys, zz);
+
+    if (key_fn != NULL) {
+      key_fn (item, &records[zz].key, user);
+    }
+    else {
+      sc_array_key_transform (item, key_offset, key_type,
+                              &records[zz].key.high_bits,
+                              &records[zz].key.low_bits);
+    }
+    records[zz].g = gmemb[rank] + zz;
+  }
+  sc_array_init_data (&view, records, sizeof (sc_psort_record_t),
+                      my_count);
+  sc_array_sort_keyed (&view, offsetof (sc_psort_record_t, key),
+                       SC_ARRAY_KEY_UINT128);
+  my_new = toff[rank + 1] - toff[rank];
+  out = SC_ALLOC (sc_psort_record_t, my_new);
+  sc_psort_exchange (mpicomm, num_procs, rank, (const char *) records,
+                     gmemb, sizeof (sc_psort_record_t),
+                     sc_psort_record_compare, toff, (char *) out);
+  SC_FREE (records);
+
+  /* move the keys and all parallel arrays once */
+  all = SC_ALLOC (sc_array_t *, num_arrays + 1);
+  all[0] = keys;
+  for (a = 0; a < num_arrays; ++a) {
+    SC_ASSERT (SC_ARRAY_IS_OWNER (arrays[a]));
+    SC_ASSERT (arrays[a]->elem_count == my_count);
+    all[a + 1] = arrays[a];
+  }
+  sc_psort_move (mpicomm, num_procs, rank, gmemb, out, my_new,
+                 all, num_arrays + 1);
+  SC_FREE (all);
+
+  if (origin != NULL) {
+    sc_array_resize (origin, my_new);
+    for (zz = 0; zz < my_new; ++zz) {
+      *(size_t *) sc_array_index (origin, zz) = out[zz].g;
+    }
+  }
+  for (q = 0; q < num_procs; ++q) {
+    nmemb[q] = toff[q + 1] - toff[q];
+  }
+
+  SC_FREE (out);
+  SC_FREE (toff);
+  SC_FREE (gmemb);
+  sc_mpi_stats_leave ();
+  sc_tracer_end (__func__);
 }
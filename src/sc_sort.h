@@ -24,7 +24,8 @@
 #ifndef SC_SORT_H
 #define SC_SORT_H
 
-#include <sc.h>
+#include <sc_containers.h>
+#include <sc_uint128.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -52,6 +53,127 @@ void                sc_psort (sc_MPI_Comm mpicomm, void *base,
                               size_t * nmemb, size_t size,
                               int (*compar) (const void *, const void *));
 
+/** Sort a distributed set of fixed-size data items by sample sort.
+ * Each process sorts locally with qsort and contributes regular samples.
+ * The samples are gathered to choose splitters identically everywhere.
+ * One all-to-all exchange moves the items between the splitters, and a
+ * second one moves them into the output partition.  Compared to \ref
+ * sc_psort, the number of communication rounds does not grow with the
+ * number of processes, at the cost of buffers proportional to the data.
+ *
+ * This function is thread-safe if called on different communicators.
+ * Items that compare equal end up in an unspecified order.
+ *
+ * \param [in] mpicomm          Communicator to use.
+ * \param [in,out] base         Pointer to the process-local data items.
+ *                              If \a rebalanced is NULL, contains the sorted
+ *                              items of the unchanged partition on output.
+ *                              Otherwise, its order is changed and
+ *                              the sorted items are returned in \a
+ *                              rebalanced.
+ * \param [in,out] nmemb        Array of mpisize counts of data items as in
+ *                              \ref sc_psort, identical on all processes.
+ *                              If \a rebalanced is not NULL, overwritten with
+ *                              the counts of the output partition.
+ * \param [in] size             Size in bytes of one data item.
+ * \param [in] compar           Comparison function to use; see \ref sc_psort.
+ * \param [in,out] rebalanced   If NULL, the partition is not changed.
+ *                              Otherwise, an array of element size \a size
+ *                              that is resized and filled with the local
+ *                              items of a partition with counts differing
+ *                              by at most one over the processes.
+ */
+void                sc_psort_sample (sc_MPI_Comm mpicomm, void *base,
+                                     size_t * nmemb, size_t size,
+                                     int (*compar) (const void *,
+                                                    const void *),
+                                     sc_array_t * rebalanced);
+
+/** Extract the sort key of a data item for \ref sc_psort_ext.
+ * \param [in] item     The data item.
+ * \param [out] key     The items are sorted by ascending key.
+ * \param [in] user     The user pointer passed to \ref sc_psort_ext.
+ */
+typedef void        (*sc_psort_key_t) (const void *item, sc_uint128_t * key,
+                                       void *user);
+
+/** Stably sort a distributed array by integer keys into a new partition.
+ * The algorithm is the sample sort of \ref sc_psort_sample, but items are
+ * compared by their keys and then by their position in the input, so the
+ * result is stable and does not depend on a comparison function.
+ * The local sort is a radix sort; see \ref sc_array_sort_keyed.
+ *
+ * This function is thread-safe if called on different communicators.
+ *
+ * \param [in] mpicomm      Communicator to use.
+ * \param [in,out] array    On input, the process-local items.
+ *                          On output, resized to and filled with the local
+ *                          items of the output partition in sorted order.
+ *                          Must not be a view.
+ * \param [in,out] nmemb    Array of mpisize counts of data items as in
+ *                          \ref sc_psort, identical on all processes.
+ *                          Overwritten with the counts of the output.
+ * \param [in] key_fn       If not NULL, called to extract keys.
+ * \param [in] user         Passed through to \a key_fn.
+ * \param [in] key_offset   If \a key_fn is NULL, the byte offset of the key
+ *                          in each item.
+ * \param [in] key_type     If \a key_fn is NULL, the type of the key.
+ * \param [in] weights      If NULL, the output partition is balanced.
+ *                          Otherwise, mpisize nonnegative weights identical
+ *                          on all processes, with a positive sum.  The
+ *                          output counts are proportional to the weights.
+ */
+void                sc_psort_ext (sc_MPI_Comm mpicomm, sc_array_t * array,
+                                  size_t * nmemb,
+                                  sc_psort_key_t key_fn, void *user,
+                                  size_t key_offset, sc_array_key_t key_type,
+                                  const double *weights);
+
+/** Stably sort parallel distributed arrays by the keys of one of them.
+ * Only the keys and the input positions go through the sample sort of
+ * \ref sc_psort_ext.  Afterwards, every process fetches the items of its
+ * output positions in one exchange, which moves the keys and all parallel
+ * arrays together.  This pays off for large items or many arrays.
+ * \ref sc_psort_ext switches to this algorithm for large items.
+ *
+ * This function is thread-safe if called on different communicators.
+ *
+ * \param [in] mpicomm      Communicator to use.
+ * \param [in,out] keys     On input, the process-local items holding the
+ *                          keys.  On output, resized to and filled with the
+ *                          local items of the output partition in sorted
+ *                          order.  Must not be a view.
+ * \param [in,out] arrays   Array of \a num_arrays arrays of the same local
+ *                          count as \a keys and arbitrary element sizes.
+ *                          They are permuted and repartitioned like \a
+ *                          keys.  None may be a view.
+ * \param [in] num_arrays   Number of parallel arrays, may be 0.
+ * \param [in,out] nmemb    Array of mpisize counts of data items as in
+ *                          \ref sc_psort, identical on all processes.
+ *                          Overwritten with the counts of the output.
+ * \param [in] key_fn       If not NULL, called to extract keys.
+ * \param [in] user         Passed through to \a key_fn.
+ * \param [in] key_offset   If \a key_fn is NULL, the byte offset of the key
+ *                          in each item of \a keys.
+ * \param [in] key_type     If \a key_fn is NULL, the type of the key.
+ * \param [in] weights      Weights of the output partition as in
+ *                          \ref sc_psort_ext, may be NULL.
+ * \param [in,out] origin   If not NULL, an array of element size
+ *                          sizeof (size_t) that is resized to the local
+ *                          output count and filled with the global input
+ *                          position of each output item.  Passing only
+ *                          small \a keys and this array yields a sorted
+ *                          permutation without moving any payload.
+ */
+void                sc_psort_arrays (sc_MPI_Comm mpicomm, sc_array_t * keys,
+                                     sc_array_t ** arrays, int num_arrays,
+                                     size_t * nmemb,
+                                     sc_psort_key_t key_fn, void *user,
+                                     size_t key_offset,
+                                     sc_array_key_t key_type,
+                                     const double *weights,
+                                     sc_array_t * origin);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_SORT_H */
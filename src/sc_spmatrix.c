@@ -0,0 +1,530 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_spmatrix.h>
+#include <sc_neighbor.h>
+#include <sc_notify.h>
+#include <sc_search.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/** A triplet sorted by the position of its block. */
+typedef struct sc_spmatrix_coo
+{
+  uint64_t            key;      /**< block row * nb + block column */
+  size_t              index;    /**< position of the triplet */
+}
+sc_spmatrix_coo_t;
+
+sc_spmatrix_t      *
+sc_spmatrix_new_coo (sc_bint_t m, sc_bint_t n, sc_bint_t bs, size_t count,
+                     const sc_bint_t * rows, const sc_bint_t * cols,
+                     const double *vals)
+{
+  const sc_bint_t     bs2 = bs * bs;
+  size_t              zz, z;
+  uint64_t            key;
+  sc_bint_t           r, b;
+  sc_array_t          coo;
+  sc_spmatrix_coo_t  *item;
+  sc_spmatrix_t      *A;
+
+  SC_ASSERT (bs > 0 && m >= 0 && n >= 0);
+  SC_ASSERT (m % bs == 0 && n % bs == 0);
+
+  A = SC_ALLOC (sc_spmatrix_t, 1);
+  A->m = m;
+  A->n = n;
+  A->bs = bs;
+  A->mb = m / bs;
+  A->nb = n / bs;
+
+  /* the stable radix sort keeps duplicates in the order given */
+  sc_array_init_count (&coo, sizeof (sc_spmatrix_coo_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    SC_ASSERT (0 <= rows[zz] && rows[zz] < m);
+    SC_ASSERT (0 <= cols[zz] && cols[zz] < n);
+    item = (sc_spmatrix_coo_t *) sc_array_index (&coo, zz);
+    item->key = (uint64_t) (rows[zz] / bs) * (uint64_t) A->nb +
+      (uint64_t) (cols[zz] / bs);
+    item->index = zz;
+  }
+  sc_array_sort_keyed (&coo, 0, SC_ARRAY_KEY_UINT64);
+  item = (sc_spmatrix_coo_t *) coo.array;
+
+  /* count the blocks of each block row */
+  A->rowptr = SC_ALLOC_ZERO (sc_bint_t, A->mb + 1);
+  A->nnzb = 0;
+  for (zz = 0; zz < count; ++zz) {
+    if (zz == 0 || item[zz].key != item[zz - 1].key) {
+      ++A->rowptr[item[zz].key / (uint64_t) A->nb + 1];
+      ++A->nnzb;
+    }
+  }
+  for (r = 0; r < A->mb; ++r) {
+    A->rowptr[r + 1] += A->rowptr[r];
+  }
+
+  /* the blocks are in row-major order already */
+  A->colidx = SC_ALLOC (sc_bint_t, A->nnzb);
+  A->values = SC_ALLOC_ZERO (double, (size_t) A->nnzb * bs2);
+  b = -1;
+  for (zz = 0; zz < count; ++zz) {
+    key = item[zz].key;
+    if (zz == 0 || key != item[zz - 1].key) {
+      A->colidx[++b] = (sc_bint_t) (key % (uint64_t) A->nb);
+    }
+    z = item[zz].index;
+    A->values[(size_t) b * bs2 + (rows[z] % bs) * bs + cols[z] % bs] +=
+      vals[z];
+  }
+  SC_ASSERT (b + 1 == A->nnzb);
+  sc_array_reset (&coo);
+
+  return A;
+}
+
+void
+sc_spmatrix_destroy (sc_spmatrix_t * A)
+{
+  SC_FREE (A->rowptr);
+  SC_FREE (A->colidx);
+  SC_FREE (A->values);
+  SC_FREE (A);
+}
+
+size_t
+sc_spmatrix_memory_used (const sc_spmatrix_t * A)
+{
+  return sizeof (sc_spmatrix_t) +
+    (A->mb + 1 + A->nnzb) * sizeof (sc_bint_t) +
+    (size_t) A->nnzb * A->bs * A->bs * sizeof (double);
+}
+
+void
+sc_spmatrix_to_dmatrix (const sc_spmatrix_t * A, sc_dmatrix_t * D)
+{
+  const sc_bint_t     bs = A->bs;
+  sc_bint_t           r, k, i, j;
+  const double       *block;
+
+  SC_ASSERT (D->m == A->m && D->n == A->n);
+
+  sc_dmatrix_set_zero (D);
+  for (r = 0; r < A->mb; ++r) {
+    for (k = A->rowptr[r]; k < A->rowptr[r + 1]; ++k) {
+      block = A->values + (size_t) k * bs * bs;
+      for (i = 0; i < bs; ++i) {
+        for (j = 0; j < bs; ++j) {
+          D->e[r * bs + i][A->colidx[k] * bs + j] = block[i * bs + j];
+        }
+      }
+    }
+  }
+}
+
+#ifdef SC_ENABLE_OPENMP
+
+/** Return the first block row of a thread's share of the blocks.
+ * The shares of consecutive threads are adjacent and hold about the
+ * same number of blocks, which balances rows of varying length.
+ */
+static              sc_bint_t
+sc_spmatrix_row_begin (const sc_spmatrix_t * A, int t, int num_threads)
+{
+  const sc_bint_t     target =
+    (sc_bint_t) ((long) A->nnzb * t / num_threads);
+  sc_bint_t           lo = 0, hi = A->mb, mid;
+
+  if (t >= num_threads) {
+    return A->mb;
+  }
+
+  /* lowest block row with rowptr[r] >= target */
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (A->rowptr[mid] < target) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+#endif /* SC_ENABLE_OPENMP */
+
+/** Compute the product with a vector for a range of block rows. */
+static void
+sc_spmatrix_vector_rows (double alpha, const sc_spmatrix_t * A,
+                         const double *x, double beta, double *y,
+                         sc_bint_t r0, sc_bint_t r1)
+{
+  const sc_bint_t     bs = A->bs;
+  const sc_bint_t    *rowptr = A->rowptr;
+  const sc_bint_t    *colidx = A->colidx;
+  const double       *values = A->values;
+  const double       *block, *xb;
+  sc_bint_t           r, k, i, j;
+  double              sum, *yb;
+
+  if (bs == 1) {
+    for (r = r0; r < r1; ++r) {
+      sum = 0.;
+#ifdef SC_ENABLE_OPENMP
+#pragma omp simd reduction (+:sum)
+#endif
+      for (k = rowptr[r]; k < rowptr[r + 1]; ++k) {
+        sum += values[k] * x[colidx[k]];
+      }
+      y[r] = (beta == 0.) ? alpha * sum : alpha * sum + beta * y[r];
+    }
+    return;
+  }
+
+  for (r = r0; r < r1; ++r) {
+    yb = y + r * bs;
+    for (i = 0; i < bs; ++i) {
+      yb[i] = (beta == 0.) ? 0. : beta * yb[i];
+    }
+    for (k = rowptr[r]; k < rowptr[r + 1]; ++k) {
+      block = values + (size_t) k * bs * bs;
+      xb = x + colidx[k] * bs;
+      for (i = 0; i < bs; ++i) {
+        sum = 0.;
+        for (j = 0; j < bs; ++j) {
+          sum += block[i * bs + j] * xb[j];
+        }
+        yb[i] += alpha * sum;
+      }
+    }
+  }
+}
+
+void
+sc_spmatrix_vector (double alpha, const sc_spmatrix_t * A,
+                    const double *x, double beta, double *y)
+{
+#ifdef SC_ENABLE_OPENMP
+  if ((long) A->nnzb * A->bs * A->bs >= SC_SPMATRIX_OPENMP_MIN &&
+      !omp_in_parallel ()) {
+#pragma omp parallel
+    {
+      const int           t = omp_get_thread_num ();
+      const int           num_threads = omp_get_num_threads ();
+
+      sc_spmatrix_vector_rows (alpha, A, x, beta, y,
+                               sc_spmatrix_row_begin (A, t, num_threads),
+                               sc_spmatrix_row_begin (A, t + 1,
+                                                      num_threads));
+    }
+    return;
+  }
+#endif
+  sc_spmatrix_vector_rows (alpha, A, x, beta, y, 0, A->mb);
+}
+
+/** Compute the product with a dense matrix for a range of block rows. */
+static void
+sc_spmatrix_multiply_rows (double alpha, const sc_spmatrix_t * A,
+                           const sc_dmatrix_t * X, double beta,
+                           sc_dmatrix_t * Y, sc_bint_t r0, sc_bint_t r1)
+{
+  const sc_bint_t     bs = A->bs;
+  const sc_bint_t     ncols = Y->n;
+  const double       *block, *xrow;
+  sc_bint_t           r, k, i, j, l;
+  double              a, *yrow;
+
+  for (r = r0; r < r1; ++r) {
+    for (i = 0; i < bs; ++i) {
+      yrow = Y->e[r * bs + i];
+      for (l = 0; l < ncols; ++l) {
+        yrow[l] = (beta == 0.) ? 0. : beta * yrow[l];
+      }
+      for (k = A->rowptr[r]; k < A->rowptr[r + 1]; ++k) {
+        block = A->values + (size_t) k * bs * bs + i * bs;
+        for (j = 0; j < bs; ++j) {
+          a = alpha * block[j];
+          xrow = X->e[A->colidx[k] * bs + j];
+          for (l = 0; l < ncols; ++l) {
+            yrow[l] += a * xrow[l];
+          }
+        }
+      }
+    }
+  }
+}
+
+void
+sc_spmatrix_multiply (double alpha, const sc_spmatrix_t * A,
+                      const sc_dmatrix_t * X, double beta, sc_dmatrix_t * Y)
+{
+  SC_ASSERT (X->m == A->n && Y->m == A->m && X->n == Y->n);
+
+#ifdef SC_ENABLE_OPENMP
+  if ((long) A->nnzb * A->bs * A->bs * Y->n >= SC_SPMATRIX_OPENMP_MIN &&
+      !omp_in_parallel ()) {
+#pragma omp parallel
+    {
+      const int           t = omp_get_thread_num ();
+      const int           num_threads = omp_get_num_threads ();
+
+      sc_spmatrix_multiply_rows (alpha, A, X, beta, Y,
+                                 sc_spmatrix_row_begin (A, t, num_threads),
+                                 sc_spmatrix_row_begin (A, t + 1,
+                                                        num_threads));
+    }
+    return;
+  }
+#endif
+  sc_spmatrix_multiply_rows (alpha, A, X, beta, Y, 0, A->mb);
+}
+
+struct sc_spmatrix_dist
+{
+  sc_bint_t           bs;
+  sc_spmatrix_t      *owned;    /* columns owned by this process */
+  sc_spmatrix_t      *ghost;    /* ghost columns in ascending order */
+  sc_bint_t           num_ghosts;       /* block columns of ghost */
+  sc_bint_t           num_mirrors;      /* blocks sent to other ranks */
+  sc_bint_t          *mirrors;  /* owned block column of each block sent */
+  double             *sendbuf;  /* mirror values */
+  double             *recvbuf;  /* ghost values */
+  sc_array_t          receivers;        /* ranks that need our values */
+  sc_array_t          senders;  /* ranks that own our ghosts */
+  int                *counts;   /* send and receive counts, displacements */
+  sc_neighbor_exchange_t *exchange;
+};
+
+sc_spmatrix_dist_t *
+sc_spmatrix_dist_new_coo (sc_MPI_Comm mpicomm, sc_bint_t bs,
+                          const int64_t * row_offsets,
+                          const int64_t * col_offsets, size_t count,
+                          const int64_t * rows, const int64_t * cols,
+                          const double *vals)
+{
+  int                 mpiret, mpisize, mpirank;
+  int                 p, q, num_receivers, num_senders;
+  int                *sendcounts, *sdispls, *recvcounts, *rdispls;
+  int64_t             rbeg, cbeg, cend, g;
+  int64_t            *col_blocks;
+  size_t              zz, num_owned, num_ghost;
+  ssize_t             pos;
+  sc_bint_t           i, m_local, n_local;
+  sc_bint_t          *orows, *ocols, *grows, *gcols;
+  double             *ovals, *gvals;
+  sc_array_t          ghosts, owners, requested;
+  sc_array_t          request_offsets, requested_offsets;
+  sc_notify_t        *notify;
+  sc_spmatrix_dist_t *A;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  SC_ASSERT (bs > 0);
+  rbeg = row_offsets[mpirank];
+  cbeg = col_offsets[mpirank];
+  cend = col_offsets[mpirank + 1];
+  SC_ASSERT (rbeg % bs == 0 && cbeg % bs == 0 && cend % bs == 0);
+  m_local = (sc_bint_t) (row_offsets[mpirank + 1] - rbeg);
+  n_local = (sc_bint_t) (cend - cbeg);
+
+  /* the ghost block columns in ascending order */
+  sc_array_init (&ghosts, sizeof (int64_t));
+  for (zz = 0; zz < count; ++zz) {
+    SC_ASSERT (rbeg <= rows[zz] && rows[zz] < row_offsets[mpirank + 1]);
+    if (cols[zz] < cbeg || cols[zz] >= cend) {
+      *(int64_t *) sc_array_push (&ghosts) = cols[zz] / bs;
+    }
+  }
+  sc_array_sort_keyed (&ghosts, 0, SC_ARRAY_KEY_INT64);
+  sc_array_uniq_keyed (&ghosts, 0, SC_ARRAY_KEY_INT64);
+
+  /* split the triplets into owned and ghost columns */
+  num_ghost = 0;
+  for (zz = 0; zz < count; ++zz) {
+    num_ghost += (cols[zz] < cbeg || cols[zz] >= cend);
+  }
+  num_owned = count - num_ghost;
+  orows = SC_ALLOC (sc_bint_t, num_owned);
+  ocols = SC_ALLOC (sc_bint_t, num_owned);
+  ovals = SC_ALLOC (double, num_owned);
+  grows = SC_ALLOC (sc_bint_t, num_ghost);
+  gcols = SC_ALLOC (sc_bint_t, num_ghost);
+  gvals = SC_ALLOC (double, num_ghost);
+  num_owned = num_ghost = 0;
+  for (zz = 0; zz < count; ++zz) {
+    if (cols[zz] < cbeg || cols[zz] >= cend) {
+      pos = sc_search_lower_bound64 (cols[zz] / bs,
+                                     (const int64_t *) ghosts.array,
+                                     ghosts.elem_count, 0);
+      SC_ASSERT (pos >= 0);
+      grows[num_ghost] = (sc_bint_t) (rows[zz] - rbeg);
+      gcols[num_ghost] = (sc_bint_t) (pos * bs + cols[zz] % bs);
+      gvals[num_ghost++] = vals[zz];
+    }
+    else {
+      orows[num_owned] = (sc_bint_t) (rows[zz] - rbeg);
+      ocols[num_owned] = (sc_bint_t) (cols[zz] - cbeg);
+      ovals[num_owned++] = vals[zz];
+    }
+  }
+
+  A = SC_ALLOC (sc_spmatrix_dist_t, 1);
+  A->bs = bs;
+  A->num_ghosts = (sc_bint_t) ghosts.elem_count;
+  A->owned = sc_spmatrix_new_coo (m_local, n_local, bs, num_owned,
+                                  orows, ocols, ovals);
+  A->ghost = sc_spmatrix_new_coo (m_local, A->num_ghosts * bs, bs,
+                                  num_ghost, grows, gcols, gvals);
+  SC_FREE (orows);
+  SC_FREE (ocols);
+  SC_FREE (ovals);
+  SC_FREE (grows);
+  SC_FREE (gcols);
+  SC_FREE (gvals);
+
+  /* group the ghosts by their owners, which are ascending as well */
+  col_blocks = SC_ALLOC (int64_t, mpisize + 1);
+  for (p = 0; p <= mpisize; ++p) {
+    SC_ASSERT (col_offsets[p] % bs == 0);
+    col_blocks[p] = col_offsets[p] / bs;
+  }
+  sc_array_init (&owners, sizeof (int));
+  sc_array_init (&request_offsets, sizeof (int));
+  *(int *) sc_array_push (&request_offsets) = 0;
+  for (zz = 0; zz < ghosts.elem_count; ++zz) {
+    g = *(int64_t *) sc_array_index (&ghosts, zz);
+    pos = sc_search_lower_bound64 (g + 1, col_blocks, mpisize + 1, 0);
+    SC_ASSERT (pos > 0);
+    p = (int) pos - 1;
+    SC_ASSERT (p != mpirank);
+    if (owners.elem_count == 0 ||
+        *(int *) sc_array_index (&owners, owners.elem_count - 1) != p) {
+      *(int *) sc_array_push (&owners) = p;
+      *(int *) sc_array_push (&request_offsets) = (int) zz;
+    }
+    *(int *) sc_array_index (&request_offsets,
+                             request_offsets.elem_count - 1) = (int) zz + 1;
+  }
+  SC_FREE (col_blocks);
+
+  /* tell the owners which of their block columns we need */
+  sc_array_init (&A->senders, sizeof (int));
+  sc_array_init (&requested, sizeof (int64_t));
+  sc_array_init (&requested_offsets, sizeof (int));
+  notify = sc_notify_new (mpicomm);
+  sc_notify_payloadv (&owners, &A->senders, &ghosts, &requested,
+                      &request_offsets, &requested_offsets, 1, notify);
+  sc_notify_destroy (notify);
+
+  /* the owners become the ranks we receive from and vice versa */
+  A->receivers = A->senders;
+  A->senders = owners;
+  num_receivers = (int) A->receivers.elem_count;
+  num_senders = (int) A->senders.elem_count;
+  A->num_mirrors = (sc_bint_t) requested.elem_count;
+  A->mirrors = SC_ALLOC (sc_bint_t, A->num_mirrors);
+  for (i = 0; i < A->num_mirrors; ++i) {
+    g = *(int64_t *) sc_array_index (&requested, (size_t) i);
+    SC_ASSERT (cbeg / bs <= g && g < cend / bs);
+    A->mirrors[i] = (sc_bint_t) (g - cbeg / bs);
+  }
+
+  A->counts = SC_ALLOC (int, 2 * (num_receivers + num_senders));
+  sendcounts = A->counts;
+  sdispls = sendcounts + num_receivers;
+  recvcounts = sdispls + num_receivers;
+  rdispls = recvcounts + num_senders;
+  for (q = 0; q < num_receivers; ++q) {
+    sdispls[q] = bs * *(int *) sc_array_index_int (&requested_offsets, q);
+    sendcounts[q] =
+      bs * *(int *) sc_array_index_int (&requested_offsets, q + 1) -
+      sdispls[q];
+  }
+  for (q = 0; q < num_senders; ++q) {
+    rdispls[q] = bs * *(int *) sc_array_index_int (&request_offsets, q);
+    recvcounts[q] =
+      bs * *(int *) sc_array_index_int (&request_offsets, q + 1) -
+      rdispls[q];
+  }
+  A->sendbuf = SC_ALLOC (double, (size_t) A->num_mirrors * bs);
+  A->recvbuf = SC_ALLOC (double, (size_t) A->num_ghosts * bs);
+  A->exchange =
+    sc_neighbor_exchange_new (mpicomm, &A->receivers, &A->senders,
+                              A->sendbuf, sendcounts, sdispls,
+                              A->recvbuf, recvcounts, rdispls,
+                              sc_MPI_DOUBLE);
+
+  sc_array_reset (&ghosts);
+  sc_array_reset (&requested);
+  sc_array_reset (&request_offsets);
+  sc_array_reset (&requested_offsets);
+
+  return A;
+}
+
+void
+sc_spmatrix_dist_destroy (sc_spmatrix_dist_t * A)
+{
+  sc_neighbor_exchange_destroy (A->exchange);
+  sc_spmatrix_destroy (A->owned);
+  sc_spmatrix_destroy (A->ghost);
+  sc_array_reset (&A->receivers);
+  sc_array_reset (&A->senders);
+  SC_FREE (A->counts);
+  SC_FREE (A->mirrors);
+  SC_FREE (A->sendbuf);
+  SC_FREE (A->recvbuf);
+  SC_FREE (A);
+}
+
+sc_bint_t
+sc_spmatrix_dist_num_ghosts (const sc_spmatrix_dist_t * A)
+{
+  return A->num_ghosts * A->bs;
+}
+
+void
+sc_spmatrix_dist_vector (double alpha, sc_spmatrix_dist_t * A,
+                         const double *x, double beta, double *y)
+{
+  const sc_bint_t     bs = A->bs;
+  sc_bint_t           i, j;
+
+  /* pack the values others need and overlap their exchange */
+  for (i = 0; i < A->num_mirrors; ++i) {
+    for (j = 0; j < bs; ++j) {
+      A->sendbuf[i * bs + j] = x[A->mirrors[i] * bs + j];
+    }
+  }
+  sc_neighbor_exchange_start (A->exchange);
+  sc_spmatrix_vector (alpha, A->owned, x, beta, y);
+  sc_neighbor_exchange_wait (A->exchange);
+  sc_spmatrix_vector (alpha, A->ghost, A->recvbuf, 1., y);
+}
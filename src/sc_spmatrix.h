@@ -0,0 +1,185 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_SPMATRIX_H
+#define SC_SPMATRIX_H
+
+/** \file sc_spmatrix.h
+ * Sparse matrices of double in compressed sparse row format.
+ *
+ * A matrix consists of dense square blocks of size \b bs, stored by block
+ * rows (BSR).  With a block size of one, this is the usual CSR format.
+ * Matrices are assembled from coordinate triplets, which may come in any
+ * order and whose duplicates are summed.  The products with vectors and
+ * dense matrices split the rows over threads with OpenMP.
+ *
+ * A distributed matrix \ref sc_spmatrix_dist_t owns a contiguous range of
+ * rows on each process.  Its columns are split into those owned by the
+ * process and the ghost columns owned by others.  The ranks to exchange
+ * ghost values with are found once by \ref sc_notify_payloadv, and every
+ * product exchanges them by an \ref sc_neighbor_exchange_t while the
+ * owned columns are multiplied.
+ */
+
+#include <sc_dmatrix.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** With OpenMP, products with at least this many matrix entries are
+ * split over threads.  Each thread takes a range of rows with about the
+ * same number of entries. */
+#ifndef SC_SPMATRIX_OPENMP_MIN
+#define SC_SPMATRIX_OPENMP_MIN (1 << 15)
+#endif
+
+/** This is the sparse matrix in block compressed row format. */
+typedef struct sc_spmatrix
+{
+  sc_bint_t           m;        /**< Number of rows. */
+  sc_bint_t           n;        /**< Number of columns. */
+  sc_bint_t           bs;       /**< Block size, dividing m and n. */
+  sc_bint_t           mb;       /**< Number of block rows. */
+  sc_bint_t           nb;       /**< Number of block columns. */
+  sc_bint_t           nnzb;     /**< Number of nonzero blocks. */
+  sc_bint_t          *rowptr;   /**< Block row r has the blocks
+                                     rowptr[r] <= k < rowptr[r + 1]. */
+  sc_bint_t          *colidx;   /**< Block column of each block,
+                                     ascending within a block row. */
+  double             *values;   /**< The entries of the blocks, each
+                                     block bs * bs in row-major order. */
+}
+sc_spmatrix_t;
+
+/** Assemble a matrix from coordinate triplets.
+ * Entries of the same position are summed.  The order of summation is
+ * that of the triplets, so the result is reproducible.
+ * \param [in] m        Number of rows, a multiple of \b bs.
+ * \param [in] n        Number of columns, a multiple of \b bs.
+ * \param [in] bs       Block size, 1 for a CSR matrix.
+ * \param [in] count    Number of triplets.
+ * \param [in] rows     Row index of each triplet, 0 <= rows[z] < m.
+ * \param [in] cols     Column index of each triplet, 0 <= cols[z] < n.
+ * \param [in] vals     Value of each triplet.
+ * \return              Matrix with the blocks that hold any triplet.
+ *                      Their remaining entries are zero.
+ */
+sc_spmatrix_t      *sc_spmatrix_new_coo (sc_bint_t m, sc_bint_t n,
+                                         sc_bint_t bs, size_t count,
+                                         const sc_bint_t * rows,
+                                         const sc_bint_t * cols,
+                                         const double *vals);
+
+/** Destroy a sparse matrix and all allocated memory. */
+void                sc_spmatrix_destroy (sc_spmatrix_t * A);
+
+/** Return the memory used by a sparse matrix in bytes. */
+size_t              sc_spmatrix_memory_used (const sc_spmatrix_t * A);
+
+/** Expand a sparse matrix into a dense one.
+ * \param [in] A        Sparse matrix.
+ * \param [out] D       Matrix of the same size.
+ */
+void                sc_spmatrix_to_dmatrix (const sc_spmatrix_t * A,
+                                            sc_dmatrix_t * D);
+
+/** Multiply a sparse matrix with a vector, y := alpha * A x + beta * y.
+ * If beta is zero, y is not read.
+ * \param [in] alpha    Factor of the product.
+ * \param [in] A        Sparse matrix.
+ * \param [in] x        Array of A->n entries.
+ * \param [in] beta     Factor of the original y.
+ * \param [in,out] y    Array of A->m entries, not overlapping x.
+ */
+void                sc_spmatrix_vector (double alpha, const sc_spmatrix_t * A,
+                                        const double *x, double beta,
+                                        double *y);
+
+/** Multiply a sparse matrix with a dense one, Y := alpha * A X + beta * Y.
+ * Each row of the result combines whole rows of \b X, which keeps the
+ * innermost loop contiguous.  If beta is zero, Y is not read.
+ * \param [in] alpha    Factor of the product.
+ * \param [in] A        Sparse matrix.
+ * \param [in] X        Dense matrix with A->n rows, possibly padded.
+ * \param [in] beta     Factor of the original Y.
+ * \param [in,out] Y    Dense matrix with A->m rows and as many columns
+ *                      as \b X, possibly padded.
+ */
+void                sc_spmatrix_multiply (double alpha,
+                                          const sc_spmatrix_t * A,
+                                          const sc_dmatrix_t * X,
+                                          double beta, sc_dmatrix_t * Y);
+
+/** A sparse matrix whose rows are distributed over the processes. */
+typedef struct sc_spmatrix_dist sc_spmatrix_dist_t;
+
+/** Assemble a distributed matrix from coordinate triplets.
+ * This function is collective.  Each process passes triplets of its own
+ * rows only, with global row and column indices.
+ * \param [in] mpicomm      Communicator of the distribution.
+ * \param [in] bs           Block size, 1 for a CSR matrix.
+ * \param [in] row_offsets  Array of mpisize + 1 global row indices,
+ *                          multiples of \b bs: process p owns the rows
+ *                          row_offsets[p] <= i < row_offsets[p + 1].
+ * \param [in] col_offsets  Likewise for the entries of the vectors that
+ *                          the matrix is multiplied with.
+ * \param [in] count        Number of local triplets.
+ * \param [in] rows         Global row index of each triplet, owned.
+ * \param [in] cols         Global column index of each triplet.
+ * \param [in] vals         Value of each triplet.
+ * \return                  Matrix to destroy with
+ *                          \ref sc_spmatrix_dist_destroy.
+ */
+sc_spmatrix_dist_t *sc_spmatrix_dist_new_coo (sc_MPI_Comm mpicomm,
+                                              sc_bint_t bs,
+                                              const int64_t * row_offsets,
+                                              const int64_t * col_offsets,
+                                              size_t count,
+                                              const int64_t * rows,
+                                              const int64_t * cols,
+                                              const double *vals);
+
+/** Destroy a distributed matrix.  This function is not collective. */
+void                sc_spmatrix_dist_destroy (sc_spmatrix_dist_t * A);
+
+/** Return the number of ghost columns of the local rows. */
+sc_bint_t           sc_spmatrix_dist_num_ghosts (const sc_spmatrix_dist_t *
+                                                 A);
+
+/** Multiply a distributed matrix with a distributed vector,
+ * y := alpha * A x + beta * y.  This function is collective.
+ * The ghost values of x are exchanged while the owned columns are
+ * multiplied.  If beta is zero, y is not read.
+ * \param [in] alpha    Factor of the product.
+ * \param [in] A        Distributed sparse matrix.
+ * \param [in] x        The owned entries of x by the column offsets.
+ * \param [in] beta     Factor of the original y.
+ * \param [in,out] y    The owned entries of y by the row offsets.
+ */
+void                sc_spmatrix_dist_vector (double alpha,
+                                             sc_spmatrix_dist_t * A,
+                                             const double *x, double beta,
+                                             double *y);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_SPMATRIX_H */
@@ -22,6 +22,64 @@
 */
 
 #include <sc_statistics.h>
+#include <sc_reduce.h>
+
+/** Number of doubles reduced per variable. */
+#define SC_STATS_FLAT 7
+
+/** Number of doubles in front of the bins of a packed distribution. */
+#define SC_STATS_DIST_HEAD 5
+
+#if defined SC_ENABLE_MPI && defined MPI_VERSION && MPI_VERSION >= 3
+#define SC_STATS_IALLREDUCE
+#endif
+
+/** Kinds of value distributions that may be attached to a variable. */
+typedef enum sc_stats_dist_type
+{
+  SC_STATS_DIST_LINEAR,         /**< Histogram of bins of equal width. */
+  SC_STATS_DIST_LOG,            /**< Histogram of bins of equal ratio. */
+  SC_STATS_DIST_SKETCH          /**< Quantiles of bounded relative error. */
+}
+sc_stats_dist_type_t;
+
+/** Mergeable distribution of the values of one random variable.
+ * The histograms have an underflow and an overflow bin in addition to
+ * the regular bins between \a lo and \a hi.  The sketch maps positive
+ * values to logarithmically spaced buckets of width \a lo, which is the
+ * ratio (1 + alpha) / (1 - alpha) for a relative accuracy alpha.
+ * If its values span more buckets than available, the lowest ones are
+ * collapsed, which keeps the upper quantiles accurate.  The sketch counts
+ * values that are not positive in its underflow bin.
+ */
+typedef struct sc_stats_dist
+{
+  sc_stats_dist_type_t type;    /**< Kind of the distribution. */
+  int                 num_bins; /**< Number of regular bins. */
+  double              lo, hi;   /**< Range of the regular histogram bins. */
+  int                 offset;   /**< Sketch key of the first regular bin. */
+  int                 kmin, kmax;       /**< Range of nonempty sketch keys. */
+  double             *counts;   /**< Underflow, regular and overflow bins. */
+}
+sc_stats_dist_t;
+
+struct sc_stats_request
+{
+  int                 nvars;
+  sc_statinfo_t      *stats;
+  double             *flat;
+#ifdef SC_ENABLE_MPI
+  sc_MPI_Op           op;
+  sc_MPI_Datatype     ctype;
+#ifdef SC_STATS_IALLREDUCE
+  MPI_Request         request;
+#endif
+#endif
+  sc_stats_dist_t   **dists;    /* NULL or distribution by variable */
+  size_t              dsize;    /* size of the packed distributions */
+  double             *dflat;    /* packed distributions, in and out */
+  sc_reduce_request_t *dreq;    /* NULL if there are no distributions */
+};
 
 #ifdef SC_ENABLE_MPI
 
@@ -34,9 +92,13 @@ sc_stats_mpifunc (void *invec, void *inoutvec, int *len,
   double             *inout = (double *) inoutvec;
 
   for (i = 0; i < *len; ++i) {
-    /* sum count, values and their squares */
-    inout[0] += in[0];
-    if (in[0]) {                /* ignore statistics when no count */
+    if (!inout[0]) {
+      /* take all of the input, including its minimum and maximum */
+      memcpy (inout, in, SC_STATS_FLAT * sizeof (double));
+    }
+    else if (in[0]) {           /* ignore statistics when no count */
+      /* sum count, values and their squares */
+      inout[0] += in[0];
       inout[1] += in[1];
       inout[2] += in[2];
 
@@ -60,13 +122,268 @@ sc_stats_mpifunc (void *invec, void *inoutvec, int *len,
     }
 
     /* advance to next data set */
-    in += 7;
-    inout += 7;
+    in += SC_STATS_FLAT;
+    inout += SC_STATS_FLAT;
   }
 }
 
 #endif /* SC_ENABLE_MPI */
 
+static sc_stats_dist_t *
+sc_stats_dist_new (sc_stats_dist_type_t type, int num_bins,
+                   double lo, double hi)
+{
+  sc_stats_dist_t    *dist;
+
+  dist = SC_ALLOC (sc_stats_dist_t, 1);
+  dist->type = type;
+  dist->num_bins = num_bins;
+  dist->lo = lo;
+  dist->hi = hi;
+  dist->offset = 0;
+  dist->kmin = 1;
+  dist->kmax = 0;
+  dist->counts = SC_ALLOC_ZERO (double, num_bins + 2);
+
+  return dist;
+}
+
+static void
+sc_stats_dist_destroy (sc_stats_dist_t * dist)
+{
+  SC_FREE (dist->counts);
+  SC_FREE (dist);
+}
+
+static void
+sc_stats_dist_clear (sc_stats_dist_t * dist)
+{
+  dist->offset = 0;
+  dist->kmin = 1;
+  dist->kmax = 0;
+  memset (dist->counts, 0, (dist->num_bins + 2) * sizeof (double));
+}
+
+/** Return the sketch key of a positive value. */
+static int
+sc_stats_sketch_key (double gamma, double value)
+{
+  return (int) ceil (log (value) / log (gamma));
+}
+
+/** Find the lowest and highest key of the nonempty sketch buckets.
+ * \return           False if all buckets are empty.
+ */
+static int
+sc_stats_sketch_range (const double *buckets, int num_bins, int offset,
+                       int *lo, int *hi)
+{
+  int                 j;
+
+  for (j = 0; j < num_bins && buckets[j] == 0.; ++j);
+  if (j == num_bins) {
+    return 0;
+  }
+  *lo = offset + j;
+  for (j = num_bins - 1; buckets[j] == 0.; --j);
+  *hi = offset + j;
+  return 1;
+}
+
+/** Choose the first key of the sketch buckets to hold the keys lo to hi.
+ * If they do not fit, the highest keys are kept.
+ */
+static int
+sc_stats_sketch_offset (int offset, int num_bins, int lo, int hi)
+{
+  if (hi - lo >= num_bins || hi >= offset + num_bins) {
+    return hi - num_bins + 1;
+  }
+  return SC_MIN (offset, lo);
+}
+
+/** Move the sketch buckets to begin at a new key.
+ * Keys below the new first key are collapsed into the first bucket.
+ * When moving to a lower key, the buckets moved out must be empty.
+ */
+static void
+sc_stats_sketch_shift (double *buckets, int num_bins,
+                       int offset, int new_offset)
+{
+  int                 j, shift;
+  double              folded;
+
+  if (new_offset > offset) {
+    shift = new_offset - offset;
+    for (folded = 0., j = 0; j < num_bins && j <= shift; ++j) {
+      folded += buckets[j];
+    }
+    for (j = 0; j < num_bins; ++j) {
+      buckets[j] = j + shift < num_bins ? buckets[j + shift] : 0.;
+    }
+    buckets[0] = folded;
+  }
+  else if (new_offset < offset) {
+    shift = offset - new_offset;
+    for (j = num_bins - 1; j >= 0; --j) {
+      SC_ASSERT (j < num_bins - shift || buckets[j] == 0.);
+      buckets[j] = j >= shift ? buckets[j - shift] : 0.;
+    }
+  }
+}
+
+static void
+sc_stats_dist_add (sc_stats_dist_t * dist, double value)
+{
+  const int           nb = dist->num_bins;
+  int                 b, k, lo, hi;
+
+  switch (dist->type) {
+  case SC_STATS_DIST_LINEAR:
+    if (value < dist->lo) {
+      b = 0;
+    }
+    else if (value >= dist->hi) {
+      b = nb + 1;
+    }
+    else {
+      b = 1 + (int) ((value - dist->lo) / (dist->hi - dist->lo) * nb);
+      b = SC_MIN (b, nb);
+    }
+    break;
+  case SC_STATS_DIST_LOG:
+    if (value < dist->lo) {
+      b = 0;
+    }
+    else if (value >= dist->hi) {
+      b = nb + 1;
+    }
+    else {
+      b = 1 + (int) (log (value / dist->lo) / log (dist->hi / dist->lo) *
+                     nb);
+      b = SC_MIN (b, nb);
+    }
+    break;
+  case SC_STATS_DIST_SKETCH:
+    if (!(value > 0.)) {
+      b = 0;
+      break;
+    }
+    k = sc_stats_sketch_key (dist->lo, value);
+    if (dist->kmin > dist->kmax) {
+      /* the first value is centered to leave room on either side */
+      dist->offset = k - nb / 2;
+      dist->kmin = dist->kmax = k;
+    }
+    else if (k < dist->offset || k >= dist->offset + nb) {
+      lo = SC_MIN (dist->kmin, k);
+      hi = SC_MAX (dist->kmax, k);
+      k = sc_stats_sketch_offset (dist->offset, nb, lo, hi);
+      sc_stats_sketch_shift (dist->counts + 1, nb, dist->offset, k);
+      dist->offset = k;
+      dist->kmin = SC_MAX (lo, k);
+      dist->kmax = hi;
+      k = sc_stats_sketch_key (dist->lo, value);
+    }
+    else {
+      dist->kmin = SC_MIN (dist->kmin, k);
+      dist->kmax = SC_MAX (dist->kmax, k);
+    }
+    b = 1 + SC_MAX (k, dist->offset) - dist->offset;
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  dist->counts[b] += 1.;
+}
+
+/** Pack a distribution for the reduction.
+ * \param [in] zero      If true, pack empty bins.
+ * \return               The position behind the packed distribution.
+ */
+static double      *
+sc_stats_dist_pack (const sc_stats_dist_t * dist, int zero, double *flat)
+{
+  flat[0] = (double) dist->type;
+  flat[1] = (double) dist->num_bins;
+  flat[2] = dist->lo;
+  flat[3] = dist->hi;
+  flat[4] = (double) dist->offset;
+  flat += SC_STATS_DIST_HEAD;
+  if (zero) {
+    memset (flat, 0, (dist->num_bins + 2) * sizeof (double));
+  }
+  else {
+    memcpy (flat, dist->counts, (dist->num_bins + 2) * sizeof (double));
+  }
+  return flat + dist->num_bins + 2;
+}
+
+static void
+sc_stats_dist_unpack (sc_stats_dist_t * dist, const double *flat)
+{
+  SC_ASSERT ((int) flat[0] == (int) dist->type);
+  SC_ASSERT ((int) flat[1] == dist->num_bins);
+
+  dist->offset = (int) flat[4];
+  flat += SC_STATS_DIST_HEAD;
+  memcpy (dist->counts, flat, (dist->num_bins + 2) * sizeof (double));
+  if (!sc_stats_sketch_range (dist->counts + 1, dist->num_bins,
+                              dist->offset, &dist->kmin, &dist->kmax)) {
+    dist->kmin = 1;
+    dist->kmax = 0;
+  }
+}
+
+/** Combine packed distributions in the format of \ref sc_reduce_t. */
+static void
+sc_stats_dist_reduce (void *sendbuf, void *recvbuf, int sendcount,
+                      sc_MPI_Datatype sendtype)
+{
+  int                 j, nb, off, ioff, lo, hi, olo, ohi;
+  const double       *in = (const double *) sendbuf;
+  const double       *end = in + sendcount;
+  const double       *ic;
+  double             *inout = (double *) recvbuf;
+  double             *oc;
+
+  SC_ASSERT (sendtype == sc_MPI_DOUBLE);
+  while (in < end) {
+    nb = (int) in[1];
+    SC_ASSERT (in[0] == inout[0] && nb == (int) inout[1]);
+    ic = in + SC_STATS_DIST_HEAD;
+    oc = inout + SC_STATS_DIST_HEAD;
+    if ((int) in[0] != SC_STATS_DIST_SKETCH) {
+      for (j = 0; j < nb + 2; ++j) {
+        oc[j] += ic[j];
+      }
+    }
+    else {
+      oc[0] += ic[0];
+      ioff = (int) in[4];
+      if (sc_stats_sketch_range (ic + 1, nb, ioff, &lo, &hi)) {
+        /* align the buckets to hold the union of both key ranges */
+        off = (int) inout[4];
+        if (sc_stats_sketch_range (oc + 1, nb, off, &olo, &ohi)) {
+          lo = SC_MIN (lo, olo);
+          hi = SC_MAX (hi, ohi);
+          off = sc_stats_sketch_offset (off, nb, lo, hi);
+          sc_stats_sketch_shift (oc + 1, nb, (int) inout[4], off);
+        }
+        else {
+          off = ioff;
+        }
+        for (j = 0; j < nb; ++j) {
+          oc[1 + SC_MAX (ioff + j, off) - off] += ic[1 + j];
+        }
+        inout[4] = (double) off;
+      }
+    }
+    in += SC_STATS_DIST_HEAD + nb + 2;
+    inout += SC_STATS_DIST_HEAD + nb + 2;
+  }
+}
+
 const int           sc_stats_group_all = -2;
 const int           sc_stats_prio_all = -3;
 
@@ -185,68 +502,248 @@ sc_stats_accumulate (sc_statinfo_t * stats, double value)
 }
 
 void
-sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+sc_stats_accumulate_n (sc_statinfo_t * stats, size_t n, const double *values)
+{
+  size_t              z;
+  double              v, sum, sumsq, vmin, vmax;
+
+  SC_ASSERT (stats->dirty);
+  if (n == 0) {
+    return;
+  }
+  SC_ASSERT (values != NULL);
+
+  /* reduce into locals that the compiler can keep in vector registers */
+  sum = sumsq = 0.;
+  vmin = vmax = values[0];
+  for (z = 0; z < n; ++z) {
+    v = values[z];
+    sum += v;
+    sumsq += v * v;
+    vmin = v < vmin ? v : vmin;
+    vmax = v > vmax ? v : vmax;
+  }
+
+  if (stats->count) {
+    stats->count += (long) n;
+    stats->sum_values += sum;
+    stats->sum_squares += sumsq;
+    stats->min = SC_MIN (stats->min, vmin);
+    stats->max = SC_MAX (stats->max, vmax);
+  }
+  else {
+    stats->count = (long) n;
+    stats->sum_values = sum;
+    stats->sum_squares = sumsq;
+    stats->min = vmin;
+    stats->max = vmax;
+  }
+}
+
+/** Estimate a quantile from the global distribution of a variable. */
+static double
+sc_stats_dist_quantile (const sc_statinfo_t * stats,
+                        const sc_stats_dist_t * dist, double q)
+{
+  int                 b, nb;
+  double              total, rank, cum, frac, v;
+
+  SC_ASSERT (dist != NULL);
+  SC_ASSERT (0. <= q && q <= 1.);
+
+  nb = dist->num_bins;
+  for (total = 0., b = 0; b < nb + 2; ++b) {
+    total += dist->counts[b];
+  }
+  if (!stats->count || total <= 0.) {
+    return 0.;
+  }
+
+  /* find the bin of the value of this rank in sorted order */
+  rank = q * (total - 1.);
+  for (cum = 0., b = 0; b < nb + 1; ++b) {
+    if (rank < cum + dist->counts[b]) {
+      break;
+    }
+    cum += dist->counts[b];
+  }
+  frac = dist->counts[b] > 0. ? (rank - cum + .5) / dist->counts[b] : .5;
+
+  /* interpolate within the bin */
+  if (b == 0) {
+    v = dist->type == SC_STATS_DIST_SKETCH ? 0. : stats->min;
+  }
+  else if (b == nb + 1) {
+    v = stats->max;
+  }
+  else if (dist->type == SC_STATS_DIST_LINEAR) {
+    v = dist->lo + (dist->hi - dist->lo) * (b - 1 + frac) / nb;
+  }
+  else if (dist->type == SC_STATS_DIST_LOG) {
+    v = dist->lo * pow (dist->hi / dist->lo, (b - 1 + frac) / nb);
+  }
+  else {
+    /* this estimate is within the relative accuracy of the bucket */
+    v = 2. * pow (dist->lo, dist->offset + b - 1) / (dist->lo + 1.);
+  }
+  return SC_MIN (SC_MAX (v, stats->min), stats->max);
+}
+
+/** Start the reduction of the variables and their distributions.
+ * \param [in] dists    NULL or one distribution or NULL per variable.
+ */
+static sc_stats_request_t *
+sc_stats_compute_begin_dist (sc_MPI_Comm mpicomm, int nvars,
+                             sc_statinfo_t * stats, sc_stats_dist_t ** dists)
 {
   int                 i;
   int                 mpiret;
   int                 rank;
-  double              cnt, avg;
-  double             *flat;
+  size_t              dsize;
   double             *flatin;
   double             *flatout;
-#ifdef SC_ENABLE_MPI
-  sc_MPI_Op           op;
-  sc_MPI_Datatype     ctype;
-#endif
+  double             *dflat;
+  sc_stats_request_t *req;
 
   mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
   SC_CHECK_MPI (mpiret);
 
-  flat = SC_ALLOC (double, 2 * 7 * nvars);
-  flatin = flat;
-  flatout = flat + 7 * nvars;
-
-  for (i = 0; i < nvars; ++i) {
-    if (!stats[i].dirty) {
-      memset (flatin + 7 * i, 0, 7 * sizeof (*flatin));
+  req = SC_ALLOC (sc_stats_request_t, 1);
+  req->nvars = nvars;
+  req->stats = stats;
+  req->dists = dists;
+  req->flat = SC_ALLOC (double, 2 * SC_STATS_FLAT * nvars);
+  flatin = req->flat;
+  flatout = req->flat + SC_STATS_FLAT * nvars;
+
+  for (i = 0; i < nvars; ++i, flatin += SC_STATS_FLAT) {
+    if (!stats[i].dirty || !stats[i].count) {
+      memset (flatin, 0, SC_STATS_FLAT * sizeof (*flatin));
       continue;
     }
-    flatin[7 * i + 0] = (double) stats[i].count;
-    flatin[7 * i + 1] = stats[i].sum_values;
-    flatin[7 * i + 2] = stats[i].sum_squares;
-    flatin[7 * i + 3] = stats[i].min;
-    flatin[7 * i + 4] = stats[i].max;
-    flatin[7 * i + 5] = (double) rank;  /* rank that attains minimum */
-    flatin[7 * i + 6] = (double) rank;  /* rank that attains maximum */
+    flatin[0] = (double) stats[i].count;
+    flatin[1] = stats[i].sum_values;
+    flatin[2] = stats[i].sum_squares;
+    flatin[3] = stats[i].min;
+    flatin[4] = stats[i].max;
+    flatin[5] = (double) rank;  /* rank that attains minimum */
+    flatin[6] = (double) rank;  /* rank that attains maximum */
   }
+  flatin = req->flat;
 
 #ifndef SC_ENABLE_MPI
-  memcpy (flatout, flatin, 7 * nvars * sizeof (*flatout));
+  memcpy (flatout, flatin, SC_STATS_FLAT * nvars * sizeof (*flatout));
 #else
-  mpiret = MPI_Type_contiguous (7, MPI_DOUBLE, &ctype);
+  mpiret = MPI_Type_contiguous (SC_STATS_FLAT, MPI_DOUBLE, &req->ctype);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = MPI_Type_commit (&req->ctype);
   SC_CHECK_MPI (mpiret);
 
-  mpiret = MPI_Type_commit (&ctype);
+  mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1,
+                          &req->op);
   SC_CHECK_MPI (mpiret);
 
-  mpiret = MPI_Op_create ((MPI_User_function *) sc_stats_mpifunc, 1, &op);
+#ifdef SC_STATS_IALLREDUCE
+  mpiret = MPI_Iallreduce (flatin, flatout, nvars, req->ctype, req->op,
+                           mpicomm, &req->request);
+#else
+  mpiret = MPI_Allreduce (flatin, flatout, nvars, req->ctype, req->op,
+                          mpicomm);
+#endif
   SC_CHECK_MPI (mpiret);
+#endif /* SC_ENABLE_MPI */
+
+  /* all distributions are combined in one custom reduction */
+  for (dsize = 0, i = 0; dists != NULL && i < nvars; ++i) {
+    if (dists[i] != NULL) {
+      dsize += SC_STATS_DIST_HEAD + dists[i]->num_bins + 2;
+    }
+  }
+  req->dsize = dsize;
+  req->dflat = NULL;
+  req->dreq = NULL;
+  if (dsize > 0) {
+    req->dflat = dflat = SC_ALLOC (double, 2 * dsize);
+    for (i = 0; i < nvars; ++i) {
+      if (dists[i] != NULL) {
+        dflat = sc_stats_dist_pack (dists[i], !stats[i].dirty ||
+                                    !stats[i].count, dflat);
+      }
+    }
+    req->dreq = sc_iallreduce_custom (req->dflat, req->dflat + dsize,
+                                      (int) dsize, sc_MPI_DOUBLE,
+                                      sc_stats_dist_reduce, 0, mpicomm);
+  }
+
+  return req;
+}
+
+void
+sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+{
+  sc_stats_compute_end (sc_stats_compute_begin (mpicomm, nvars, stats));
+}
+
+sc_stats_request_t *
+sc_stats_compute_begin (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
+{
+  return sc_stats_compute_begin_dist (mpicomm, nvars, stats, NULL);
+}
+
+void
+sc_stats_compute_end (sc_stats_request_t * req)
+{
+  int                 i;
+  int                 nvars;
+#ifdef SC_ENABLE_MPI
+  int                 mpiret;
+#endif
+  double              cnt, avg;
+  double             *flatout;
+  const double       *dflat;
+  sc_statinfo_t      *stats;
+  sc_stats_dist_t   **dists;
+
+  SC_ASSERT (req != NULL);
+  nvars = req->nvars;
+  stats = req->stats;
+  dists = req->dists;
+  flatout = req->flat + SC_STATS_FLAT * nvars;
 
-  mpiret = MPI_Allreduce (flatin, flatout, nvars, ctype, op, mpicomm);
+#ifdef SC_ENABLE_MPI
+#ifdef SC_STATS_IALLREDUCE
+  mpiret = MPI_Wait (&req->request, MPI_STATUS_IGNORE);
   SC_CHECK_MPI (mpiret);
+#endif
 
-  mpiret = MPI_Op_free (&op);
+  mpiret = MPI_Op_free (&req->op);
   SC_CHECK_MPI (mpiret);
 
-  mpiret = MPI_Type_free (&ctype);
+  mpiret = MPI_Type_free (&req->ctype);
   SC_CHECK_MPI (mpiret);
 #endif /* SC_ENABLE_MPI */
 
-  for (i = 0; i < nvars; ++i) {
+  /* the global distributions follow the local ones */
+  if (req->dreq != NULL) {
+    sc_reduce_end (req->dreq);
+    dflat = req->dflat + req->dsize;
+    for (i = 0; i < nvars; ++i) {
+      if (dists[i] != NULL) {
+        if (stats[i].dirty) {
+          sc_stats_dist_unpack (dists[i], dflat);
+        }
+        dflat += SC_STATS_DIST_HEAD + dists[i]->num_bins + 2;
+      }
+    }
+    SC_FREE (req->dflat);
+  }
+
+  for (i = 0; i < nvars; ++i, flatout += SC_STATS_FLAT) {
     if (!stats[i].dirty) {
       continue;
     }
-    cnt = flatout[7 * i + 0];
+    cnt = flatout[0];
     stats[i].count = (long) cnt;
     if (!cnt) {
       /* initialize output variables */
@@ -255,12 +752,12 @@ sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
     }
     else {
       stats[i].dirty = 0;
-      stats[i].sum_values = flatout[7 * i + 1];
-      stats[i].sum_squares = flatout[7 * i + 2];
-      stats[i].min = flatout[7 * i + 3];
-      stats[i].max = flatout[7 * i + 4];
-      stats[i].min_at_rank = (int) flatout[7 * i + 5];
-      stats[i].max_at_rank = (int) flatout[7 * i + 6];
+      stats[i].sum_values = flatout[1];
+      stats[i].sum_squares = flatout[2];
+      stats[i].min = flatout[3];
+      stats[i].max = flatout[4];
+      stats[i].min_at_rank = (int) flatout[5];
+      stats[i].max_at_rank = (int) flatout[6];
       stats[i].average = avg = stats[i].sum_values / cnt;
       stats[i].variance = stats[i].sum_squares / cnt - avg * avg;
       stats[i].variance = SC_MAX (stats[i].variance, 0.);
@@ -270,7 +767,8 @@ sc_stats_compute (sc_MPI_Comm mpicomm, int nvars, sc_statinfo_t * stats)
     stats[i].standev_mean = sqrt (stats[i].variance_mean);
   }
 
-  SC_FREE (flat);
+  SC_FREE (req->flat);
+  SC_FREE (req);
 }
 
 void
@@ -314,10 +812,15 @@ sc_stats_print (int package_id, int log_priority,
                       sc_stats_group_all, sc_stats_prio_all, full, summary);
 }
 
-void
-sc_stats_print_ext (int package_id, int log_priority,
-                    int nvars, sc_statinfo_t * stats,
-                    int stats_group, int stats_prio, int full, int summary)
+/** Print statistics as in \ref sc_stats_print_ext.
+ * \param [in] dists    NULL or one distribution or NULL per variable.
+ *                      In full mode we print their quantiles.
+ */
+static void
+sc_stats_print_dist (int package_id, int log_priority,
+                     int nvars, sc_statinfo_t * stats,
+                     sc_stats_dist_t ** dists,
+                     int stats_group, int stats_prio, int full, int summary)
 {
   int                 i, count;
   sc_statinfo_t      *si;
@@ -366,6 +869,13 @@ sc_stats_print_ext (int package_id, int log_priority,
       SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
                    "   Maximum attained at rank %7d: %g\n",
                    si->max_at_rank, si->max);
+      if (dists != NULL && dists[i] != NULL) {
+        SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+                     "   Percentiles 50 / 95 / 99:         %g %g %g\n",
+                     sc_stats_dist_quantile (si, dists[i], .5),
+                     sc_stats_dist_quantile (si, dists[i], .95),
+                     sc_stats_dist_quantile (si, dists[i], .99));
+      }
     }
   }
   else {
@@ -431,6 +941,15 @@ sc_stats_print_ext (int package_id, int log_priority,
   }
 }
 
+void
+sc_stats_print_ext (int package_id, int log_priority,
+                    int nvars, sc_statinfo_t * stats,
+                    int stats_group, int stats_prio, int full, int summary)
+{
+  sc_stats_print_dist (package_id, log_priority, nvars, stats, NULL,
+                       stats_group, stats_prio, full, summary);
+}
+
 sc_statistics_t    *
 sc_statistics_new (sc_MPI_Comm mpicomm)
 {
@@ -440,6 +959,7 @@ sc_statistics_new (sc_MPI_Comm mpicomm)
   stats->mpicomm = mpicomm;
   stats->kv = sc_keyvalue_new ();
   stats->sarray = sc_array_new (sizeof (sc_statinfo_t));
+  stats->darray = sc_array_new (sizeof (sc_stats_dist_t *));
 
   return stats;
 }
@@ -447,8 +967,19 @@ sc_statistics_new (sc_MPI_Comm mpicomm)
 void
 sc_statistics_destroy (sc_statistics_t * stats)
 {
+  size_t              zz;
+  sc_stats_dist_t    *dist;
+
   sc_keyvalue_destroy (stats->kv);
+  for (zz = 0; zz < stats->sarray->elem_count; ++zz) {
+    sc_stats_reset ((sc_statinfo_t *) sc_array_index (stats->sarray, zz), 1);
+    dist = *(sc_stats_dist_t **) sc_array_index (stats->darray, zz);
+    if (dist != NULL) {
+      sc_stats_dist_destroy (dist);
+    }
+  }
   sc_array_destroy (stats->sarray);
+  sc_array_destroy (stats->darray);
 
   SC_FREE (stats);
 }
@@ -466,6 +997,7 @@ sc_statistics_add (sc_statistics_t * stats, const char *name)
   i = (int) stats->sarray->elem_count;
   si = (sc_statinfo_t *) sc_array_push (stats->sarray);
   sc_stats_set1 (si, 0, name);
+  *(sc_stats_dist_t **) sc_array_push (stats->darray) = NULL;
 
   sc_keyvalue_set_int (stats->kv, name, i);
 }
@@ -475,6 +1007,7 @@ sc_statistics_set (sc_statistics_t * stats, const char *name, double value)
 {
   int                 i;
   sc_statinfo_t      *si;
+  sc_stats_dist_t    *dist;
 
   i = sc_keyvalue_get_int (stats->kv, name, -1);
 
@@ -482,12 +1015,24 @@ sc_statistics_set (sc_statistics_t * stats, const char *name, double value)
   SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
 
   si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
-
   sc_stats_set1 (si, value, name);
+
+  dist = *(sc_stats_dist_t **) sc_array_index_int (stats->darray, i);
+  if (dist != NULL) {
+    sc_stats_dist_clear (dist);
+    sc_stats_dist_add (dist, value);
+  }
 }
 
 void
 sc_statistics_add_empty (sc_statistics_t * stats, const char *name)
+{
+  sc_statistics_add_empty_ext (stats, name, 0);
+}
+
+void
+sc_statistics_add_empty_ext (sc_statistics_t * stats, const char *name,
+                             int copy_name)
 {
   int                 i;
   sc_statinfo_t      *si;
@@ -498,9 +1043,12 @@ sc_statistics_add_empty (sc_statistics_t * stats, const char *name)
 
   i = (int) stats->sarray->elem_count;
   si = (sc_statinfo_t *) sc_array_push (stats->sarray);
-  sc_stats_init (si, name);
+  sc_stats_init_ext (si, name, copy_name,
+                     sc_stats_group_all, sc_stats_prio_all);
+  *(sc_stats_dist_t **) sc_array_push (stats->darray) = NULL;
 
-  sc_keyvalue_set_int (stats->kv, name, i);
+  /* the key must live as long as the variable */
+  sc_keyvalue_set_int (stats->kv, si->variable, i);
 }
 
 int
@@ -514,30 +1062,154 @@ sc_statistics_accumulate (sc_statistics_t * stats, const char *name,
                           double value)
 {
   int                 i;
-  sc_statinfo_t      *si;
 
   i = sc_keyvalue_get_int (stats->kv, name, -1);
 
   /* always check for wrong usage and output adequate error message */
   SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
 
+  sc_statistics_accumulate_h (stats, i, value);
+}
+
+int
+sc_statistics_get_handle (sc_statistics_t * stats, const char *name)
+{
+  int                 i;
+
+  i = sc_keyvalue_get_int (stats->kv, name, -1);
+
+  /* always check for wrong usage and output adequate error message */
+  SC_CHECK_ABORTF (i >= 0, "Statistics variable \"%s\" does not exist", name);
+
+  return i;
+}
+
+void
+sc_statistics_accumulate_h (sc_statistics_t * stats, int handle,
+                            double value)
+{
+  sc_stats_dist_t    *dist;
+
+  SC_ASSERT (0 <= handle && (size_t) handle < stats->sarray->elem_count);
+
+  sc_stats_accumulate ((sc_statinfo_t *)
+                       sc_array_index_int (stats->sarray, handle), value);
+  dist = *(sc_stats_dist_t **) sc_array_index_int (stats->darray, handle);
+  if (dist != NULL) {
+    sc_stats_dist_add (dist, value);
+  }
+}
+
+void
+sc_statistics_accumulate_n (sc_statistics_t * stats, int handle,
+                            size_t n, const double *values)
+{
+  size_t              z;
+  sc_stats_dist_t    *dist;
+
+  SC_ASSERT (0 <= handle && (size_t) handle < stats->sarray->elem_count);
+
+  sc_stats_accumulate_n ((sc_statinfo_t *)
+                         sc_array_index_int (stats->sarray, handle),
+                         n, values);
+  dist = *(sc_stats_dist_t **) sc_array_index_int (stats->darray, handle);
+  if (dist != NULL) {
+    for (z = 0; z < n; ++z) {
+      sc_stats_dist_add (dist, values[z]);
+    }
+  }
+}
+
+/** Replace the distribution of a variable that has no values yet. */
+static void
+sc_statistics_set_dist (sc_statistics_t * stats, const char *name,
+                        sc_stats_dist_t * dist)
+{
+  int                 i;
+  sc_statinfo_t      *si;
+  sc_stats_dist_t   **pdist;
+
+  i = sc_statistics_get_handle (stats, name);
   si = (sc_statinfo_t *) sc_array_index_int (stats->sarray, i);
+  SC_ASSERT (si->dirty && si->count == 0);
+
+  pdist = (sc_stats_dist_t **) sc_array_index_int (stats->darray, i);
+  if (*pdist != NULL) {
+    sc_stats_dist_destroy (*pdist);
+  }
+  *pdist = dist;
+}
+
+void
+sc_statistics_set_histogram (sc_statistics_t * stats, const char *name,
+                             int log_bins, int num_bins, double lo, double hi)
+{
+  SC_ASSERT (num_bins > 0 && lo < hi);
+  SC_ASSERT (!log_bins || lo > 0.);
+
+  sc_statistics_set_dist (stats, name,
+                          sc_stats_dist_new (log_bins ? SC_STATS_DIST_LOG :
+                                             SC_STATS_DIST_LINEAR, num_bins,
+                                             lo, hi));
+}
 
-  sc_stats_accumulate (si, value);
+void
+sc_statistics_set_sketch (sc_statistics_t * stats, const char *name,
+                          double alpha, int num_bins)
+{
+  SC_ASSERT (num_bins > 0 && 0. < alpha && alpha < 1.);
+
+  sc_statistics_set_dist (stats, name,
+                          sc_stats_dist_new (SC_STATS_DIST_SKETCH, num_bins,
+                                             (1. + alpha) / (1. - alpha),
+                                             alpha));
+}
+
+double
+sc_statistics_quantile (sc_statistics_t * stats, const char *name, double q)
+{
+  int                 i;
+  sc_stats_dist_t    *dist;
+
+  i = sc_statistics_get_handle (stats, name);
+  dist = *(sc_stats_dist_t **) sc_array_index_int (stats->darray, i);
+  SC_CHECK_ABORTF (dist != NULL,
+                   "Statistics variable \"%s\" has no distribution", name);
+
+  return sc_stats_dist_quantile ((sc_statinfo_t *)
+                                 sc_array_index_int (stats->sarray, i),
+                                 dist, q);
 }
 
 void
 sc_statistics_compute (sc_statistics_t * stats)
 {
-  sc_stats_compute (stats->mpicomm, (int) stats->sarray->elem_count,
-                    (sc_statinfo_t *) stats->sarray->array);
+  sc_stats_compute_end (sc_statistics_compute_begin (stats));
+}
+
+sc_stats_request_t *
+sc_statistics_compute_begin (sc_statistics_t * stats)
+{
+  return sc_stats_compute_begin_dist (stats->mpicomm,
+                                      (int) stats->sarray->elem_count,
+                                      (sc_statinfo_t *) stats->sarray->array,
+                                      (sc_stats_dist_t **)
+                                      stats->darray->array);
+}
+
+void
+sc_statistics_compute_end (sc_stats_request_t * request)
+{
+  sc_stats_compute_end (request);
 }
 
 void
 sc_statistics_print (sc_statistics_t * stats,
                      int package_id, int log_priority, int full, int summary)
 {
-  sc_stats_print (package_id, log_priority,
-                  (int) stats->sarray->elem_count,
-                  (sc_statinfo_t *) stats->sarray->array, full, summary);
+  sc_stats_print_dist (package_id, log_priority,
+                       (int) stats->sarray->elem_count,
+                       (sc_statinfo_t *) stats->sarray->array,
+                       (sc_stats_dist_t **) stats->darray->array,
+                       sc_stats_group_all, sc_stats_prio_all, full, summary);
 }
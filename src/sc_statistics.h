@@ -51,12 +51,16 @@ typedef struct sc_statinfo
 }
 sc_statinfo_t;
 
+/** Opaque handle for a statistics reduction in progress. */
+typedef struct sc_stats_request sc_stats_request_t;
+
 /* sc_statistics_t allows dynamically adding random variables */
 typedef struct sc_stats
 {
   sc_MPI_Comm         mpicomm;
   sc_keyvalue_t      *kv;
   sc_array_t         *sarray;
+  sc_array_t         *darray;   /* owned distribution or NULL by variable */
 }
 sc_statistics_t;
 
@@ -140,6 +144,16 @@ void                sc_stats_set_group_prio (sc_statinfo_t * stats,
  */
 void                sc_stats_accumulate (sc_statinfo_t * stats, double value);
 
+/** Add a batch of instances of the random variable.
+ * The result is the same as calling \ref sc_stats_accumulate on each value
+ * up to the rounding of the sums, which are reduced locally first.
+ * \param [out] stats          Must be dirty.  We bump count and values.
+ * \param [in] n               Number of values, may be 0.
+ * \param [in] values          Array of \a n values.
+ */
+void                sc_stats_accumulate_n (sc_statinfo_t * stats,
+                                           size_t n, const double *values);
+
 /**
  * Compute global average and standard deviation.
  * Only updates dirty variables. Then removes the dirty flag.
@@ -164,6 +178,29 @@ void                sc_stats_accumulate (sc_statinfo_t * stats, double value);
 void                sc_stats_compute (sc_MPI_Comm mpicomm, int nvars,
                                       sc_statinfo_t * stats);
 
+/**
+ * Start computing global statistics as in sc_stats_compute.
+ * All variables are packed into one reduction with a user-defined operator.
+ * With MPI version 3 or later the reduction is non-blocking and may overlap
+ * with computation; otherwise it completes in this function.
+ * The stats array must neither be accessed nor freed until the matching
+ * call to sc_stats_compute_end.  This function is collective.
+ * \param [in] mpicomm         MPI communicator to use.
+ * \param [in] nvars           Number of stats items in input array.
+ * \param [in,out] stats       Array of stats items to work on.
+ * \return                     Handle to pass to sc_stats_compute_end.
+ */
+sc_stats_request_t *sc_stats_compute_begin (sc_MPI_Comm mpicomm, int nvars,
+                                            sc_statinfo_t * stats);
+
+/**
+ * Complete a reduction started by sc_stats_compute_begin.
+ * On output, the stats are set as documented for sc_stats_compute.
+ * \param [in] request         Handle returned by sc_stats_compute_begin,
+ *                             freed by this function.
+ */
+void                sc_stats_compute_end (sc_stats_request_t * request);
+
 /**
  * Version of sc_statistics_statistics that assumes count=1.
  * On input, the field sum_values needs to be set to the value
@@ -237,6 +274,15 @@ void                sc_statistics_add (sc_statistics_t * stats,
 void                sc_statistics_add_empty (sc_statistics_t * stats,
                                              const char *name);
 
+/** Register a statistics variable by name and set its count to 0.
+ * This variable must not exist already.
+ * \param [in] copy_name   If true, the name is copied and may be released
+ *                          by the caller; the copy is freed on destroy.
+ */
+void                sc_statistics_add_empty_ext (sc_statistics_t * stats,
+                                                 const char *name,
+                                                 int copy_name);
+
 /** Returns true if the stats include a variable with the given name */
 int                 sc_statistics_has (sc_statistics_t * stats,
                                        const char *name);
@@ -253,11 +299,114 @@ void                sc_statistics_set (sc_statistics_t * stats,
 void                sc_statistics_accumulate (sc_statistics_t * stats,
                                               const char *name, double value);
 
+/** Look up a statistics variable once for repeated accumulation.
+ * The handle is the index of the variable in \a stats->sarray and remains
+ * valid until \a stats is destroyed.  Using it avoids hashing \a name
+ * on every call in inner loops.
+ * \param [in] stats       Valid statistics object.
+ * \param [in] name        The variable must have been added before.
+ * \return                 Non-negative handle of the variable.
+ */
+int                 sc_statistics_get_handle (sc_statistics_t * stats,
+                                              const char *name);
+
+/** Add an instance of a statistics variable given by handle.
+ * \param [in,out] stats   Valid statistics object.
+ * \param [in] handle      Obtained from \ref sc_statistics_get_handle.
+ * \param [in] value       Value to accumulate.
+ */
+void                sc_statistics_accumulate_h (sc_statistics_t * stats,
+                                                int handle, double value);
+
+/** Add a batch of instances of a statistics variable given by handle,
+ * see \ref sc_stats_accumulate_n.
+ * \param [in,out] stats   Valid statistics object.
+ * \param [in] handle      Obtained from \ref sc_statistics_get_handle.
+ * \param [in] n           Number of values, may be 0.
+ * \param [in] values      Array of \a n values.
+ */
+void                sc_statistics_accumulate_n (sc_statistics_t * stats,
+                                                int handle, size_t n,
+                                                const double *values);
+
+/** Attach a histogram to a statistics variable to estimate its quantiles.
+ * An existing distribution of the variable is replaced.
+ * The histogram must be attached with the same parameters on all
+ * processes before any value is accumulated.
+ * The distribution is filled by \ref sc_statistics_set and the
+ * sc_statistics_accumulate functions, not by \ref sc_stats_accumulate.
+ * \param [in,out] stats      Valid statistics object.
+ * \param [in] name           The variable must be added with
+ *                            sc_statistics_add_empty and must not have
+ *                            accumulated any values yet.
+ * \param [in] log_bins       If true, the bins are of equal ratio between
+ *                            \a lo and \a hi, and \a lo must be positive.
+ *                            Otherwise, they are of equal width.
+ * \param [in] num_bins       Positive number of bins between the bounds.
+ * \param [in] lo, hi         Range of the bins with \a lo < \a hi.
+ *                            Values outside go into an underflow or
+ *                            overflow bin, which map to the global minimum
+ *                            and maximum when computing quantiles.
+ */
+void                sc_statistics_set_histogram (sc_statistics_t * stats,
+                                                 const char *name,
+                                                 int log_bins, int num_bins,
+                                                 double lo, double hi);
+
+/** Attach a compact quantile sketch to a statistics variable.
+ * The sketch needs no range of values in advance, and its quantiles of
+ * positive values are accurate to the relative error \a alpha as long as
+ * all values fit into \a num_bins buckets of geometric width.  For example,
+ * alpha = .01 and 1024 buckets cover a ratio of about 10^8 of max to min.
+ * If the values span more buckets, the lowest ones are collapsed, which
+ * keeps the upper quantiles accurate.  Values that are not positive are
+ * counted in one extra bucket.
+ * An existing distribution of the variable is replaced.
+ * The sketch must be attached with the same parameters on all processes
+ * before any value is accumulated.
+ * \param [in,out] stats      Valid statistics object.
+ * \param [in] name           The variable must be added with
+ *                            sc_statistics_add_empty and must not have
+ *                            accumulated any values yet.
+ * \param [in] alpha          Relative accuracy between 0 and 1.
+ * \param [in] num_bins       Positive number of buckets.
+ */
+void                sc_statistics_set_sketch (sc_statistics_t * stats,
+                                              const char *name,
+                                              double alpha, int num_bins);
+
+/** Estimate a quantile of a statistics variable with a distribution.
+ * The global quantile is available after \ref sc_statistics_compute.
+ * \param [in] stats          Valid statistics object.
+ * \param [in] name           Variable with a distribution.
+ * \param [in] q              Quantile between 0 and 1, such as .95.
+ * \return                    Estimate between the minimum and maximum,
+ *                            or 0 if the variable has no values.
+ */
+double              sc_statistics_quantile (sc_statistics_t * stats,
+                                            const char *name, double q);
+
 /** Compute statistics for all variables, see sc_stats_compute.
+ * The distributions of all variables are combined by one reduction with
+ * \ref sc_iallreduce_custom.
  */
 void                sc_statistics_compute (sc_statistics_t * stats);
 
+/** Start computing statistics for all variables, see
+ * sc_stats_compute_begin.  No variables may be added in the meantime.
+ * If any variable has a distribution, no other \ref sc_iallreduce_custom
+ * may be in progress on the communicator of \a stats until the end.
+ */
+sc_stats_request_t *sc_statistics_compute_begin (sc_statistics_t * stats);
+
+/** Complete sc_statistics_compute_begin, see sc_stats_compute_end.
+ */
+void                sc_statistics_compute_end (sc_stats_request_t *
+                                               request);
+
 /** Print all statistics variables, see sc_stats_print.
+ * In full mode, also print the 50, 95 and 99 percent quantiles of the
+ * variables with a distribution.
  */
 void                sc_statistics_print (sc_statistics_t * stats,
                                          int package_id, int log_priority,
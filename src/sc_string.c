@@ -22,6 +22,7 @@
 */
 
 #include <sc_string.h>
+#include <sc_io.h>
 
 void
 sc_string_init (sc_string_t * scs)
@@ -100,3 +101,335 @@ sc_string_get_content (sc_string_t * scs, int *length)
   }
   return scs->buffer;
 }
+
+/** One piece of memory of a string builder. */
+typedef struct sc_string_chunk
+{
+  struct sc_string_chunk *next;
+  size_t              size;     /**< capacity of data */
+  size_t              used;     /**< bytes written to data */
+  char               *data;     /**< stored behind this struct */
+}
+sc_string_chunk_t;
+
+struct sc_string_builder
+{
+  size_t              chunk_size;
+  size_t              length;   /**< sum of used bytes of all chunks */
+  sc_string_chunk_t  *first, *last;
+};
+
+/** Two decimal digits for each number from 0 to 99. */
+static const char   sc_string_digits[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536"
+  "37383940414243444546474849505152535455565758596061626364656667686970717273"
+  "7475767778798081828384858687888990919293949596979899";
+
+static sc_string_chunk_t *
+sc_string_chunk_new (size_t size)
+{
+  sc_string_chunk_t  *chunk;
+
+  chunk = (sc_string_chunk_t *)
+    SC_ALLOC (char, sizeof (sc_string_chunk_t) + size);
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  chunk->data = (char *) (chunk + 1);
+  return chunk;
+}
+
+/** Free a list of chunks starting at a given one. */
+static void
+sc_string_chunk_free (sc_string_chunk_t * chunk)
+{
+  sc_string_chunk_t  *next;
+
+  for (; chunk != NULL; chunk = next) {
+    next = chunk->next;
+    SC_FREE (chunk);
+  }
+}
+
+/** Return room for at least \a bytes contiguous bytes at the end. */
+static char        *
+sc_string_builder_reserve (sc_string_builder_t * sb, size_t bytes)
+{
+  sc_string_chunk_t  *chunk = sb->last;
+
+  if (chunk->size - chunk->used < bytes) {
+    chunk = sc_string_chunk_new (SC_MAX (sb->chunk_size, bytes));
+    sb->last->next = chunk;
+    sb->last = chunk;
+  }
+  return chunk->data + chunk->used;
+}
+
+/** Account for bytes written into reserved room. */
+static void
+sc_string_builder_commit (sc_string_builder_t * sb, size_t bytes)
+{
+  SC_ASSERT (sb->last->used + bytes <= sb->last->size);
+
+  sb->last->used += bytes;
+  sb->length += bytes;
+}
+
+sc_string_builder_t *
+sc_string_builder_new (size_t chunk_size)
+{
+  sc_string_builder_t *sb;
+
+  sb = SC_ALLOC (sc_string_builder_t, 1);
+  sb->chunk_size = chunk_size > 0 ? chunk_size : SC_STRING_BUILDER_CHUNK;
+  sb->length = 0;
+  sb->first = sb->last = sc_string_chunk_new (sb->chunk_size);
+  return sb;
+}
+
+void
+sc_string_builder_destroy (sc_string_builder_t * sb)
+{
+  SC_ASSERT (sb != NULL);
+
+  sc_string_chunk_free (sb->first);
+  SC_FREE (sb);
+}
+
+void
+sc_string_builder_reset (sc_string_builder_t * sb)
+{
+  SC_ASSERT (sb != NULL);
+
+  sc_string_chunk_free (sb->first->next);
+  sb->first->next = NULL;
+  sb->first->used = 0;
+  sb->last = sb->first;
+  sb->length = 0;
+}
+
+size_t
+sc_string_builder_length (const sc_string_builder_t * sb)
+{
+  SC_ASSERT (sb != NULL);
+
+  return sb->length;
+}
+
+void
+sc_string_builder_putc (sc_string_builder_t * sb, int c)
+{
+  *sc_string_builder_reserve (sb, 1) = (char) (unsigned char) c;
+  sc_string_builder_commit (sb, 1);
+}
+
+void
+sc_string_builder_puts (sc_string_builder_t * sb, const char *s)
+{
+  sc_string_builder_putn (sb, s, strlen (s));
+}
+
+void
+sc_string_builder_putn (sc_string_builder_t * sb, const void *data,
+                        size_t bytes)
+{
+  size_t              room;
+  const char         *src = (const char *) data;
+  sc_string_chunk_t  *chunk = sb->last;
+
+  /* fill up the current chunk before starting the next one */
+  room = SC_MIN (chunk->size - chunk->used, bytes);
+  memcpy (chunk->data + chunk->used, src, room);
+  sc_string_builder_commit (sb, room);
+  if (bytes > room) {
+    memcpy (sc_string_builder_reserve (sb, bytes - room), src + room,
+            bytes - room);
+    sc_string_builder_commit (sb, bytes - room);
+  }
+}
+
+/** Write the decimal digits of a number right-aligned before \a end.
+ * \return              Pointer to the first digit.
+ */
+static char        *
+sc_string_format_uint (char *end, unsigned long long value)
+{
+  unsigned            two;
+
+  while (value >= 100) {
+    two = (unsigned) (value % 100) * 2;
+    value /= 100;
+    *--end = sc_string_digits[two + 1];
+    *--end = sc_string_digits[two];
+  }
+  if (value >= 10) {
+    two = (unsigned) value * 2;
+    *--end = sc_string_digits[two + 1];
+    *--end = sc_string_digits[two];
+  }
+  else {
+    *--end = (char) ('0' + value);
+  }
+  return end;
+}
+
+void
+sc_string_builder_put_uint (sc_string_builder_t * sb,
+                            unsigned long long value)
+{
+  char                buf[24], *begin;
+
+  begin = sc_string_format_uint (buf + sizeof (buf), value);
+  sc_string_builder_putn (sb, begin, (size_t) (buf + sizeof (buf) - begin));
+}
+
+void
+sc_string_builder_put_int (sc_string_builder_t * sb, long long value)
+{
+  char                buf[24], *begin;
+
+  /* negate in unsigned arithmetic to cover the smallest value */
+  begin = sc_string_format_uint (buf + sizeof (buf), value < 0 ?
+                                 0ULL - (unsigned long long) value :
+                                 (unsigned long long) value);
+  if (value < 0) {
+    *--begin = '-';
+  }
+  sc_string_builder_putn (sb, begin, (size_t) (buf + sizeof (buf) - begin));
+}
+
+void
+sc_string_builder_put_double (sc_string_builder_t * sb, double value,
+                              int decimals)
+{
+  int                 i, negative;
+  double              scaled, floored, residual;
+  unsigned long long  digits;
+  char                buf[48], *begin, *end;
+  static const double pow10[18] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+    1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+  };
+
+  SC_ASSERT (0 <= decimals && decimals <= 17);
+
+  /* the scaled value must be representable below 2^53 */
+  negative = value < 0.;
+  value = negative ? -value : value;
+  scaled = value * pow10[decimals];
+  if (!(scaled < 9007199254740992.)) {
+    /* large and non-finite values take the slow path */
+    sc_string_builder_putf (sb, "%.*g", 17, negative ? -value : value);
+    return;
+  }
+
+  /* round to nearest like printf, deciding ties by the exact product */
+  floored = floor (scaled);
+  digits = (unsigned long long) floored;
+  if (scaled - floored > .5) {
+    ++digits;
+  }
+  else if (scaled - floored == .5) {
+    residual = fma (value, pow10[decimals], -scaled);
+    if (residual > 0. || (residual == 0. && (digits & 1))) {
+      ++digits;
+    }
+  }
+
+  /* write the fraction first, padded with zeros, then the integer part */
+  end = buf + sizeof (buf);
+  begin = end;
+  if (decimals > 0) {
+    for (i = 0; i < decimals; ++i) {
+      *--begin = (char) ('0' + digits % 10);
+      digits /= 10;
+    }
+    *--begin = '.';
+  }
+  begin = sc_string_format_uint (begin, digits);
+  if (negative) {
+    *--begin = '-';
+  }
+  sc_string_builder_putn (sb, begin, (size_t) (end - begin));
+}
+
+void
+sc_string_builder_putf (sc_string_builder_t * sb, const char *fmt, ...)
+{
+  va_list             ap;
+
+  va_start (ap, fmt);
+  sc_string_builder_putv (sb, fmt, ap);
+  va_end (ap);
+}
+
+void
+sc_string_builder_putv (sc_string_builder_t * sb, const char *fmt,
+                        va_list ap)
+{
+  int                 result;
+  size_t              room;
+  va_list             aq;
+  sc_string_chunk_t  *chunk = sb->last;
+
+  /* try to print into the rest of the current chunk */
+  room = chunk->size - chunk->used;
+  va_copy (aq, ap);
+  result = vsnprintf (chunk->data + chunk->used, room, fmt, aq);
+  va_end (aq);
+  SC_CHECK_ABORT (result >= 0, "String builder format error");
+  if ((size_t) result < room) {
+    sc_string_builder_commit (sb, (size_t) result);
+    return;
+  }
+
+  /* print again into a chunk of sufficient size */
+  result = vsnprintf (sc_string_builder_reserve (sb, (size_t) result + 1),
+                      (size_t) result + 1, fmt, ap);
+  sc_string_builder_commit (sb, (size_t) result);
+}
+
+const char         *
+sc_string_builder_get_content (sc_string_builder_t * sb, size_t *length)
+{
+  sc_string_chunk_t  *chunk, *merged;
+
+  SC_ASSERT (sb != NULL);
+
+  if (sb->first->next != NULL || sb->first->used == sb->first->size) {
+    /* copy everything into one chunk with room for the terminator */
+    merged = sc_string_chunk_new (SC_MAX (sb->chunk_size, sb->length + 1));
+    for (chunk = sb->first; chunk != NULL; chunk = chunk->next) {
+      memcpy (merged->data + merged->used, chunk->data, chunk->used);
+      merged->used += chunk->used;
+    }
+    SC_ASSERT (merged->used == sb->length);
+    sc_string_chunk_free (sb->first);
+    sb->first = sb->last = merged;
+  }
+
+  /* the terminator is not counted as content */
+  sb->first->data[sb->first->used] = '\0';
+  if (length != NULL) {
+    *length = sb->length;
+  }
+  return sb->first->data;
+}
+
+int
+sc_string_builder_drain (sc_string_builder_t * sb, struct sc_io_sink *sink)
+{
+  int                 retval = 0;
+  sc_string_chunk_t  *chunk;
+
+  SC_ASSERT (sb != NULL);
+  SC_ASSERT (sink != NULL);
+
+  for (chunk = sb->first; chunk != NULL && !retval; chunk = chunk->next) {
+    if (chunk->used > 0) {
+      retval = sc_io_sink_write (sink, chunk->data, chunk->used);
+    }
+  }
+  sc_string_builder_reset (sb);
+  return retval;
+}
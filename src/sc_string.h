@@ -104,4 +104,127 @@ int                 sc_string_putv (sc_string_t * scs, const char *fmt,
  */
 const char         *sc_string_get_content (sc_string_t * scs, int *length);
 
+/** Default byte size of the chunks of a string builder. */
+#define SC_STRING_BUILDER_CHUNK 65536
+
+/** A growable string assembled in a list of memory chunks.
+ * Unlike \ref sc_string_t, its length is only limited by memory.
+ * Appending never moves data that has been written before; a new chunk
+ * is started when the current one is full.  Integers and fixed-point
+ * doubles are formatted without going through printf.
+ * The content can be flattened into one string or drained into a sink.
+ */
+typedef struct sc_string_builder sc_string_builder_t;
+
+/* declared in sc_io.h, which need not be included here */
+struct sc_io_sink;
+
+/** Create an empty string builder.
+ * \param [in] chunk_size      Minimum byte size of each chunk.
+ *                              If 0, \ref SC_STRING_BUILDER_CHUNK is used.
+ * \return                     A valid and empty string builder.
+ */
+sc_string_builder_t *sc_string_builder_new (size_t chunk_size);
+
+/** Destroy a string builder and all of its chunks.
+ * \param [in,out] sb          Valid string builder.
+ */
+void                sc_string_builder_destroy (sc_string_builder_t * sb);
+
+/** Make the string empty, keeping the first chunk for reuse.
+ * \param [in,out] sb          Valid string builder.
+ */
+void                sc_string_builder_reset (sc_string_builder_t * sb);
+
+/** Return the number of bytes in a string builder.
+ * \param [in] sb              Valid string builder.
+ * \return                     Length of the content without trailing '\0'.
+ */
+size_t              sc_string_builder_length (const sc_string_builder_t *
+                                              sb);
+
+/** Append a single character.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] c               Converted to an unsigned char and appended.
+ */
+void                sc_string_builder_putc (sc_string_builder_t * sb, int c);
+
+/** Append a null-terminated string.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] s               This string is appended.
+ */
+void                sc_string_builder_puts (sc_string_builder_t * sb,
+                                            const char *s);
+
+/** Append a number of bytes, which may include '\0'.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] data            Bytes to append.
+ * \param [in] bytes           Number of bytes to append.
+ */
+void                sc_string_builder_putn (sc_string_builder_t * sb,
+                                            const void *data, size_t bytes);
+
+/** Append a signed integer in decimal notation as printf "%lld" would.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] value           The integer to append.
+ */
+void                sc_string_builder_put_int (sc_string_builder_t * sb,
+                                               long long value);
+
+/** Append an unsigned integer in decimal notation as printf "%llu" would.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] value           The integer to append.
+ */
+void                sc_string_builder_put_uint (sc_string_builder_t * sb,
+                                                unsigned long long value);
+
+/** Append a double in fixed-point notation like printf "%.*f".
+ * The value is scaled and rounded to the given number of decimals in
+ * integer arithmetic, resolving ties by the exact product as printf does.
+ * Values too large to be scaled below 2^53 and non-finite values are
+ * passed to printf "%.17g" instead.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] value           The number to append.
+ * \param [in] decimals        Digits after the decimal point, 0 to 17.
+ *                              The decimal point is omitted for 0.
+ */
+void                sc_string_builder_put_double (sc_string_builder_t * sb,
+                                                  double value,
+                                                  int decimals);
+
+/** Append using a format string and arguments.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] fmt             Format string as used with printf and friends.
+ */
+void                sc_string_builder_putf (sc_string_builder_t * sb,
+                                            const char *fmt, ...)
+  __attribute__ ((format (printf, 2, 3)));
+
+/** Append using a format string and a vararg pointer.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in] fmt             Format string as used with printf and friends.
+ * \param [in,out] ap          Argument list pointer as defined in stdarg.h.
+ */
+void                sc_string_builder_putv (sc_string_builder_t * sb,
+                                            const char *fmt, va_list ap);
+
+/** Access the content as one contiguous null-terminated string.
+ * If the content spans several chunks, they are merged into one first.
+ * \param [in,out] sb          Valid string builder.
+ * \param [out] length         If not NULL, the length without '\0'.
+ * \return                     Pointer to the content, valid until the
+ *                              builder is modified or destroyed.
+ */
+const char         *sc_string_builder_get_content (sc_string_builder_t * sb,
+                                                   size_t *length);
+
+/** Write the content to a sink chunk by chunk and make the builder empty.
+ * \param [in,out] sb          Valid string builder.
+ * \param [in,out] sink        Valid sink, see \ref sc_io_sink_write.
+ * \return                     0 on success, nonzero on error.  The builder
+ *                              is empty afterwards in either case.
+ */
+int                 sc_string_builder_drain (sc_string_builder_t * sb,
+                                             struct sc_io_sink *sink);
+
 #endif /* !SC_STRING_H */
@@ -0,0 +1,536 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sc_taskpool.h>
+#include <sc_ringbuf.h>
+
+#if defined SC_ENABLE_PTHREAD && defined __GNUC__ && defined __ATOMIC_RELAXED
+/** Worker threads need the atomic builtins for the deques. */
+#define SC_TASKPOOL_THREADED
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/** Number of unsuccessful searches for work before a worker sleeps. */
+#define SC_TASKPOOL_SPIN 64
+
+/** Distance between the two ends of a deque to keep them apart. */
+#define SC_TASKPOOL_LINE 128
+
+/** Capacity of the queue for tasks spawned outside of the workers. */
+#define SC_TASKPOOL_INJECT 1024
+
+/** Shared description of a parallel loop. */
+typedef struct sc_taskpool_loop
+{
+  sc_task_range_t     body;
+  void               *user;
+  size_t              grain;
+  sc_taskgroup_t     *group;
+}
+sc_taskpool_loop_t;
+
+/** A queued task: either a function call or a subrange of a loop. */
+typedef struct sc_taskpool_entry
+{
+  sc_task_t           task;
+  void               *data;
+  sc_taskpool_loop_t *loop;     /**< if not NULL, run this loop instead */
+  size_t              begin, end;
+  sc_taskgroup_t     *group;
+}
+sc_taskpool_entry_t;
+
+#ifdef SC_TASKPOOL_THREADED
+
+/** Chase-Lev deque of fixed capacity.  The owner pushes and takes at the
+ * bottom, thieves steal at the top. */
+typedef struct sc_taskpool_deque
+{
+  long                top;
+  char                pad0[SC_TASKPOOL_LINE - sizeof (long)];
+  long                bottom;
+  char                pad1[SC_TASKPOOL_LINE - sizeof (long)];
+  sc_taskpool_entry_t buffer[SC_TASKPOOL_DEQUE];
+}
+sc_taskpool_deque_t;
+
+typedef struct sc_taskpool_worker
+{
+  sc_taskpool_t      *pool;
+  int                 index;
+  pthread_t           thread;
+  sc_taskpool_deque_t deque;
+}
+sc_taskpool_worker_t;
+
+#endif /* SC_TASKPOOL_THREADED */
+
+struct sc_taskpool
+{
+  int                 num_threads;
+#ifdef SC_TASKPOOL_THREADED
+  sc_taskpool_worker_t *workers;
+  sc_ringbuf_t       *inject;   /**< tasks from threads outside the pool */
+  pthread_mutex_t     mutex;    /**< protects sleeping workers */
+  pthread_cond_t      cond;
+  long                epoch;    /**< incremented for every new task */
+  int                 sleeping;
+  int                 stop;
+#endif
+};
+
+/** The pool started by \ref sc_taskpool_start. */
+static sc_taskpool_t *sc_taskpool_default_pool = NULL;
+
+static void         sc_taskpool_loop_run (sc_taskpool_loop_t * loop,
+                                          size_t begin, size_t end);
+
+#ifdef SC_TASKPOOL_THREADED
+
+/** The worker running on this thread, NULL outside of all pools. */
+static __thread sc_taskpool_worker_t *sc_taskpool_self = NULL;
+
+/* thieves may read a slot while it is rewritten; their compare and swap
+ * on top then fails and the torn copy is discarded */
+static inline void
+sc_taskpool_entry_store (sc_taskpool_entry_t * dst,
+                         const sc_taskpool_entry_t * src)
+{
+  __atomic_store_n (&dst->task, src->task, __ATOMIC_RELAXED);
+  __atomic_store_n (&dst->data, src->data, __ATOMIC_RELAXED);
+  __atomic_store_n (&dst->loop, src->loop, __ATOMIC_RELAXED);
+  __atomic_store_n (&dst->begin, src->begin, __ATOMIC_RELAXED);
+  __atomic_store_n (&dst->end, src->end, __ATOMIC_RELAXED);
+  __atomic_store_n (&dst->group, src->group, __ATOMIC_RELAXED);
+}
+
+static inline void
+sc_taskpool_entry_load (sc_taskpool_entry_t * dst,
+                        sc_taskpool_entry_t * src)
+{
+  dst->task = __atomic_load_n (&src->task, __ATOMIC_RELAXED);
+  dst->data = __atomic_load_n (&src->data, __ATOMIC_RELAXED);
+  dst->loop = __atomic_load_n (&src->loop, __ATOMIC_RELAXED);
+  dst->begin = __atomic_load_n (&src->begin, __ATOMIC_RELAXED);
+  dst->end = __atomic_load_n (&src->end, __ATOMIC_RELAXED);
+  dst->group = __atomic_load_n (&src->group, __ATOMIC_RELAXED);
+}
+
+/* owner only; returns false if the deque is full */
+static int
+sc_taskpool_deque_push (sc_taskpool_deque_t * d,
+                        const sc_taskpool_entry_t * e)
+{
+  long                b, t;
+
+  b = __atomic_load_n (&d->bottom, __ATOMIC_RELAXED);
+  t = __atomic_load_n (&d->top, __ATOMIC_ACQUIRE);
+  if (b - t >= SC_TASKPOOL_DEQUE) {
+    return 0;
+  }
+  sc_taskpool_entry_store (&d->buffer[b % SC_TASKPOOL_DEQUE], e);
+  __atomic_store_n (&d->bottom, b + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/* owner only; takes the newest entry */
+static int
+sc_taskpool_deque_take (sc_taskpool_deque_t * d, sc_taskpool_entry_t * e)
+{
+  int                 found = 0;
+  long                b, t;
+
+  b = __atomic_load_n (&d->bottom, __ATOMIC_RELAXED) - 1;
+  __atomic_store_n (&d->bottom, b, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  t = __atomic_load_n (&d->top, __ATOMIC_RELAXED);
+  if (t <= b) {
+    sc_taskpool_entry_load (e, &d->buffer[b % SC_TASKPOOL_DEQUE]);
+    found = 1;
+    if (t == b) {
+      /* the last entry may be stolen concurrently */
+      found = __atomic_compare_exchange_n (&d->top, &t, t + 1, 0,
+                                           __ATOMIC_SEQ_CST,
+                                           __ATOMIC_RELAXED);
+      __atomic_store_n (&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+  }
+  else {
+    __atomic_store_n (&d->bottom, b + 1, __ATOMIC_RELAXED);
+  }
+  return found;
+}
+
+/* any thread; takes the oldest entry */
+static int
+sc_taskpool_deque_steal (sc_taskpool_deque_t * d, sc_taskpool_entry_t * e)
+{
+  long                b, t;
+
+  t = __atomic_load_n (&d->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  b = __atomic_load_n (&d->bottom, __ATOMIC_ACQUIRE);
+  if (t < b) {
+    sc_taskpool_entry_load (e, &d->buffer[t % SC_TASKPOOL_DEQUE]);
+    return __atomic_compare_exchange_n (&d->top, &t, t + 1, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+  }
+  return 0;
+}
+
+/* look for a task: own deque first, then outside tasks, then steal */
+static int
+sc_taskpool_find (sc_taskpool_t * pool, sc_taskpool_worker_t * self,
+                  sc_taskpool_entry_t * e)
+{
+  int                 k, start, n = pool->num_threads;
+  sc_taskpool_worker_t *w;
+
+  if (self != NULL && sc_taskpool_deque_take (&self->deque, e)) {
+    return 1;
+  }
+  if (sc_ringbuf_pop (pool->inject, e)) {
+    return 1;
+  }
+  start = self != NULL ? self->index + 1 : 0;
+  for (k = 0; k < n; ++k) {
+    w = &pool->workers[(start + k) % n];
+    if (w != self && sc_taskpool_deque_steal (&w->deque, e)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* wake up sleeping workers after a task was queued */
+static void
+sc_taskpool_notify (sc_taskpool_t * pool)
+{
+  __atomic_fetch_add (&pool->epoch, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&pool->sleeping, __ATOMIC_SEQ_CST) > 0) {
+    pthread_mutex_lock (&pool->mutex);
+    pthread_cond_signal (&pool->cond);
+    pthread_mutex_unlock (&pool->mutex);
+  }
+}
+
+/* return the worker of this thread if it belongs to the pool */
+static sc_taskpool_worker_t *
+sc_taskpool_worker (sc_taskpool_t * pool)
+{
+  sc_taskpool_worker_t *self = sc_taskpool_self;
+
+  return self != NULL && self->pool == pool ? self : NULL;
+}
+
+#endif /* SC_TASKPOOL_THREADED */
+
+static void
+sc_taskpool_execute (sc_taskpool_entry_t * e)
+{
+  if (e->loop != NULL) {
+    sc_taskpool_loop_run (e->loop, e->begin, e->end);
+  }
+  else {
+    e->task (e->data);
+  }
+#ifdef SC_TASKPOOL_THREADED
+  __atomic_fetch_sub (&e->group->pending, 1, __ATOMIC_RELEASE);
+#endif
+}
+
+#ifdef SC_TASKPOOL_THREADED
+
+static void        *
+sc_taskpool_main (void *arg)
+{
+  int                 idle = 0;
+  long                epoch;
+  sc_taskpool_worker_t *self = (sc_taskpool_worker_t *) arg;
+  sc_taskpool_t      *pool = self->pool;
+  sc_taskpool_entry_t e;
+
+  sc_taskpool_self = self;
+  for (;;) {
+    epoch = __atomic_load_n (&pool->epoch, __ATOMIC_SEQ_CST);
+    if (sc_taskpool_find (pool, self, &e)) {
+      sc_taskpool_execute (&e);
+      idle = 0;
+      continue;
+    }
+    if (__atomic_load_n (&pool->stop, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    if (++idle < SC_TASKPOOL_SPIN) {
+      sched_yield ();
+      continue;
+    }
+
+    /* sleep until a task is queued after our last search */
+    pthread_mutex_lock (&pool->mutex);
+    __atomic_fetch_add (&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n (&pool->epoch, __ATOMIC_SEQ_CST) == epoch &&
+           !pool->stop) {
+      pthread_cond_wait (&pool->cond, &pool->mutex);
+    }
+    __atomic_fetch_sub (&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock (&pool->mutex);
+    idle = 0;
+  }
+  sc_taskpool_self = NULL;
+
+  return NULL;
+}
+
+#endif /* SC_TASKPOOL_THREADED */
+
+sc_taskpool_t      *
+sc_taskpool_new (int num_threads, int first_cpu)
+{
+  sc_taskpool_t      *pool;
+
+  pool = SC_ALLOC_ZERO (sc_taskpool_t, 1);
+#ifdef SC_TASKPOOL_THREADED
+  if (num_threads > 0) {
+    int                 i, pth;
+    sc_taskpool_worker_t *w;
+
+    pool->num_threads = num_threads;
+    pool->inject = sc_ringbuf_new (sizeof (sc_taskpool_entry_t),
+                                   SC_TASKPOOL_INJECT, SC_RINGBUF_MPMC);
+    pthread_mutex_init (&pool->mutex, NULL);
+    pthread_cond_init (&pool->cond, NULL);
+    pool->workers = SC_ALLOC_ZERO (sc_taskpool_worker_t, num_threads);
+    for (i = 0; i < num_threads; ++i) {
+      w = &pool->workers[i];
+      w->pool = pool;
+      w->index = i;
+      pth = pthread_create (&w->thread, NULL, sc_taskpool_main, w);
+      SC_CHECK_ABORT (pth == 0, "Failed to create task pool thread");
+#ifdef __linux__
+      if (first_cpu >= 0) {
+        cpu_set_t           cpuset;
+
+        CPU_ZERO (&cpuset);
+        CPU_SET (first_cpu + i, &cpuset);
+        if (pthread_setaffinity_np (w->thread, sizeof (cpuset), &cpuset)) {
+          SC_LDEBUGF ("Could not pin task pool thread %d to CPU %d\n",
+                      i, first_cpu + i);
+        }
+      }
+#endif
+    }
+  }
+#endif
+
+  return pool;
+}
+
+void
+sc_taskpool_destroy (sc_taskpool_t * pool)
+{
+#ifdef SC_TASKPOOL_THREADED
+  if (pool->num_threads > 0) {
+    int                 i;
+
+    pthread_mutex_lock (&pool->mutex);
+    __atomic_store_n (&pool->stop, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast (&pool->cond);
+    pthread_mutex_unlock (&pool->mutex);
+    for (i = 0; i < pool->num_threads; ++i) {
+      pthread_join (pool->workers[i].thread, NULL);
+    }
+    SC_ASSERT (sc_ringbuf_size (pool->inject) == 0);
+    sc_ringbuf_destroy (pool->inject);
+    pthread_mutex_destroy (&pool->mutex);
+    pthread_cond_destroy (&pool->cond);
+    SC_FREE (pool->workers);
+  }
+#endif
+  SC_FREE (pool);
+}
+
+int
+sc_taskpool_num_threads (sc_taskpool_t * pool)
+{
+  if (pool == NULL) {
+    pool = sc_taskpool_default_pool;
+  }
+  return pool != NULL ? pool->num_threads : 0;
+}
+
+int
+sc_taskpool_start (int num_threads, int first_cpu)
+{
+#ifdef SC_TASKPOOL_THREADED
+  if (num_threads <= 0) {
+    return -1;
+  }
+  if (sc_taskpool_default_pool == NULL) {
+    sc_taskpool_default_pool = sc_taskpool_new (num_threads, first_cpu);
+  }
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+void
+sc_taskpool_stop (void)
+{
+  if (sc_taskpool_default_pool != NULL) {
+    sc_taskpool_destroy (sc_taskpool_default_pool);
+    sc_taskpool_default_pool = NULL;
+  }
+}
+
+sc_taskpool_t      *
+sc_taskpool_default (void)
+{
+  return sc_taskpool_default_pool;
+}
+
+void
+sc_taskgroup_init (sc_taskgroup_t * group, sc_taskpool_t * pool)
+{
+  group->pool = pool != NULL ? pool : sc_taskpool_default_pool;
+  group->pending = 0;
+}
+
+/* queue a task or run it right away */
+static void
+sc_taskpool_submit (sc_taskgroup_t * group, sc_taskpool_entry_t * e)
+{
+#ifdef SC_TASKPOOL_THREADED
+  sc_taskpool_t      *pool = group->pool;
+  sc_taskpool_worker_t *self;
+
+  /* the task is counted even if it runs here, which decrements it */
+  __atomic_fetch_add (&group->pending, 1, __ATOMIC_RELAXED);
+  if (pool != NULL && pool->num_threads > 0) {
+    self = sc_taskpool_worker (pool);
+    if (self != NULL ? sc_taskpool_deque_push (&self->deque, e) :
+        sc_ringbuf_push (pool->inject, e)) {
+      sc_taskpool_notify (pool);
+    }
+    else {
+      /* the queue is full and the task runs here */
+      sc_taskpool_execute (e);
+    }
+    return;
+  }
+#endif
+  sc_taskpool_execute (e);
+}
+
+void
+sc_taskgroup_spawn (sc_taskgroup_t * group, sc_task_t task, void *data)
+{
+  sc_taskpool_entry_t e;
+
+  SC_ASSERT (task != NULL);
+
+  e.task = task;
+  e.data = data;
+  e.loop = NULL;
+  e.begin = e.end = 0;
+  e.group = group;
+  sc_taskpool_submit (group, &e);
+}
+
+void
+sc_taskgroup_wait (sc_taskgroup_t * group)
+{
+#ifdef SC_TASKPOOL_THREADED
+  sc_taskpool_t      *pool = group->pool;
+  sc_taskpool_worker_t *self;
+  sc_taskpool_entry_t e;
+
+  if (pool == NULL || pool->num_threads == 0) {
+    SC_ASSERT (group->pending == 0);
+    return;
+  }
+
+  /* work on any task of the pool while our group is busy */
+  self = sc_taskpool_worker (pool);
+  while (__atomic_load_n (&group->pending, __ATOMIC_ACQUIRE) > 0) {
+    if (sc_taskpool_find (pool, self, &e)) {
+      sc_taskpool_execute (&e);
+    }
+    else {
+      sched_yield ();
+    }
+  }
+#else
+  SC_ASSERT (group->pending == 0);
+#endif
+}
+
+/* split off the upper halves as tasks and run the lowest piece */
+static void
+sc_taskpool_loop_run (sc_taskpool_loop_t * loop, size_t begin, size_t end)
+{
+  sc_taskpool_entry_t e;
+
+  while (end - begin > loop->grain) {
+    e.task = NULL;
+    e.data = NULL;
+    e.loop = loop;
+    e.begin = begin + (end - begin) / 2;
+    e.end = end;
+    e.group = loop->group;
+    sc_taskpool_submit (loop->group, &e);
+    end = e.begin;
+  }
+  loop->body (begin, end, loop->user);
+}
+
+void
+sc_taskpool_parallel_for (sc_taskpool_t * pool, size_t begin, size_t end,
+                          size_t grain, sc_task_range_t body, void *user)
+{
+  sc_taskgroup_t      group;
+  sc_taskpool_loop_t  loop;
+
+  SC_ASSERT (body != NULL);
+  if (end <= begin) {
+    return;
+  }
+
+  sc_taskgroup_init (&group, pool);
+  if (sc_taskpool_num_threads (group.pool) == 0) {
+    /* without threads the whole range is one piece */
+    body (begin, end, user);
+    return;
+  }
+  loop.body = body;
+  loop.user = user;
+  loop.grain = SC_MAX (grain, 1);
+  loop.group = &group;
+  sc_taskpool_loop_run (&loop, begin, end);
+  sc_taskgroup_wait (&group);
+}
@@ -0,0 +1,159 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_taskpool.h
+ *
+ * A work-stealing task pool shared by all parallel code of a process.
+ *
+ * Each worker thread owns a Chase-Lev deque.  It pushes and takes tasks
+ * at the bottom, while idle workers steal the oldest tasks from the top.
+ * Threads outside the pool hand their tasks to a shared \ref sc_ringbuf_t.
+ * A thread waiting for a \ref sc_taskgroup_t runs pending tasks instead of
+ * blocking, so tasks may spawn and wait for nested task groups and loops.
+ *
+ * If the environment variable SC_TASKPOOL_THREADS is set, \ref sc_init
+ * starts the default pool with that many worker threads, and \ref
+ * sc_finalize stops it.  If SC_TASKPOOL_CPU is set to a non-negative
+ * number, worker i is pinned to CPU SC_TASKPOOL_CPU + i where supported.
+ * Without a pool, or if libsc is configured without --enable-pthread,
+ * all tasks run in the calling thread.  The same code is correct in
+ * every case.
+ */
+
+#ifndef SC_TASKPOOL_H
+#define SC_TASKPOOL_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Maximum number of tasks queued in the deque of one worker.
+ * If a deque is full, further tasks run immediately in the spawning thread.
+ */
+#ifndef SC_TASKPOOL_DEQUE
+#define SC_TASKPOOL_DEQUE 4096
+#endif
+
+/** Opaque task pool. */
+typedef struct sc_taskpool sc_taskpool_t;
+
+/** A task executes a function on its data. */
+typedef void        (*sc_task_t) (void *data);
+
+/** The body of a parallel loop runs on a half-open index range. */
+typedef void        (*sc_task_range_t) (size_t begin, size_t end,
+                                        void *user);
+
+/** A task group counts its unfinished tasks.
+ * It is usually placed on the stack of the spawning function.  Its members
+ * must not be accessed directly.
+ */
+typedef struct sc_taskgroup
+{
+  sc_taskpool_t      *pool;     /**< pool running the tasks, may be NULL */
+  long                pending;  /**< number of unfinished tasks */
+}
+sc_taskgroup_t;
+
+/** Create a task pool with its own worker threads.
+ * \param [in] num_threads  Number of worker threads.  The threads that
+ *                          wait for task groups work as well.  If zero,
+ *                          or without pthread support, no threads are
+ *                          started and all tasks run when spawned.
+ * \param [in] first_cpu    If non-negative, worker i is pinned to
+ *                          CPU first_cpu + i where this is supported.
+ * \return                  The pool, to be freed by
+ *                          \ref sc_taskpool_destroy.
+ */
+sc_taskpool_t      *sc_taskpool_new (int num_threads, int first_cpu);
+
+/** Stop the worker threads and free the pool.
+ * All task groups of the pool must have been waited for.
+ */
+void                sc_taskpool_destroy (sc_taskpool_t * pool);
+
+/** Return the number of worker threads of a pool.
+ * \param [in] pool     A pool, or NULL for the default pool.
+ * \return              The number of worker threads, 0 for none.
+ */
+int                 sc_taskpool_num_threads (sc_taskpool_t * pool);
+
+/** Start the default task pool.
+ * This is called by \ref sc_init if SC_TASKPOOL_THREADS is set.
+ * \param [in] num_threads  Number of worker threads, see
+ *                          \ref sc_taskpool_new.
+ * \param [in] first_cpu    First CPU to pin to, or negative.
+ * \return                  0 if the default pool runs threads, or -1
+ *                          if threads are not available.
+ */
+int                 sc_taskpool_start (int num_threads, int first_cpu);
+
+/** Stop and free the default task pool if it runs. */
+void                sc_taskpool_stop (void);
+
+/** Return the default task pool or NULL if it is not running. */
+sc_taskpool_t      *sc_taskpool_default (void);
+
+/** Initialize an empty task group.
+ * \param [out] group   The task group.
+ * \param [in] pool     Pool to run the tasks, or NULL for the default
+ *                      pool.  If there is no pool, tasks run when spawned.
+ */
+void                sc_taskgroup_init (sc_taskgroup_t * group,
+                                       sc_taskpool_t * pool);
+
+/** Add a task to a group.  It may run at once or later on any thread.
+ * \param [in,out] group    Initialized task group.
+ * \param [in] task         Function to call.
+ * \param [in] data         Passed to \a task; must stay valid until
+ *                          \ref sc_taskgroup_wait returns.
+ */
+void                sc_taskgroup_spawn (sc_taskgroup_t * group,
+                                        sc_task_t task, void *data);
+
+/** Run tasks until all tasks of the group have finished.
+ * Afterwards the group may be used for new tasks.
+ * \param [in,out] group    Initialized task group.
+ */
+void                sc_taskgroup_wait (sc_taskgroup_t * group);
+
+/** Run a loop body over an index range in parallel and wait for it.
+ * The range is split in halves recursively down to \a grain indices.
+ * \param [in] pool     Pool to run the loop, or NULL for the default pool.
+ * \param [in] begin    First index of the range.
+ * \param [in] end      One past the last index of the range.
+ * \param [in] grain    Minimum number of indices per call of \a body,
+ *                      0 is treated as 1.
+ * \param [in] body     Function called on disjoint subranges that cover
+ *                      [begin, end), possibly concurrently.
+ * \param [in] user     Passed to \a body.
+ */
+void                sc_taskpool_parallel_for (sc_taskpool_t * pool,
+                                              size_t begin, size_t end,
+                                              size_t grain,
+                                              sc_task_range_t body,
+                                              void *user);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_TASKPOOL_H */
@@ -0,0 +1,252 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_tracer.h>
+
+#if (defined SC_ENABLE_PTHREAD || defined SC_ENABLE_OPENMP) && \
+  defined __GNUC__ && defined __ATOMIC_RELAXED
+#define SC_TRACER_THREAD_LOCAL
+#endif
+
+typedef struct sc_tracer_event
+{
+  const char         *name;
+  double              time;
+  char                phase;    /**< 'B' for begin and 'E' for end. */
+}
+sc_tracer_event_t;
+
+/** The event buffer of one thread. */
+typedef struct sc_tracer_thread
+{
+  int                 tid;
+  size_t              count;
+  size_t              open;     /**< Recorded begins without end. */
+  size_t              skip;     /**< Dropped begins without end. */
+  long                dropped;
+  sc_tracer_event_t  *events;
+  struct sc_tracer_thread *next;        /**< List of all threads. */
+}
+sc_tracer_thread_t;
+
+static int          sc_tracer_active = 0;
+static size_t       sc_tracer_max_events = 0;
+static double       sc_tracer_start_time = 0.;
+static int          sc_tracer_num_threads = 0;
+
+/** All event buffers of the threads, linked by their next member. */
+static sc_tracer_thread_t *sc_tracer_threads = NULL;
+
+/** Event buffers of a previous generation are no longer valid. */
+static int          sc_tracer_generation = 0;
+
+#ifdef SC_TRACER_THREAD_LOCAL
+static __thread sc_tracer_thread_t *sc_tracer_thread = NULL;
+static __thread int sc_tracer_thread_generation = -1;
+#else
+static sc_tracer_thread_t *sc_tracer_thread = NULL;
+static int          sc_tracer_thread_generation = -1;
+#endif
+
+/** Return the event buffer of the calling thread and create it if needed. */
+static sc_tracer_thread_t *
+sc_tracer_thread_get (void)
+{
+  sc_tracer_thread_t *tt;
+
+  if (sc_tracer_thread == NULL ||
+      sc_tracer_thread_generation != sc_tracer_generation) {
+    tt = SC_ALLOC (sc_tracer_thread_t, 1);
+    tt->count = tt->open = tt->skip = 0;
+    tt->dropped = 0;
+    tt->events = SC_ALLOC (sc_tracer_event_t, sc_tracer_max_events);
+
+    /* remember the buffer to write and free it */
+#ifdef SC_TRACER_THREAD_LOCAL
+    tt->tid = __atomic_fetch_add (&sc_tracer_num_threads, 1,
+                                  __ATOMIC_RELAXED);
+    tt->next = __atomic_load_n (&sc_tracer_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n (&sc_tracer_threads, &tt->next,
+                                         tt, 1, __ATOMIC_RELEASE,
+                                         __ATOMIC_RELAXED));
+#else
+    tt->tid = sc_tracer_num_threads++;
+    tt->next = sc_tracer_threads;
+    sc_tracer_threads = tt;
+#endif
+    sc_tracer_thread = tt;
+    sc_tracer_thread_generation = sc_tracer_generation;
+  }
+  return sc_tracer_thread;
+}
+
+void
+sc_tracer_start (size_t max_events)
+{
+  sc_tracer_stop ();
+
+  /* each region needs two events */
+  sc_tracer_max_events = SC_MAX (2, max_events > 0 ? max_events :
+                                 SC_TRACER_EVENTS);
+  sc_tracer_start_time = sc_MPI_Wtime ();
+  sc_tracer_active = 1;
+
+  /* allocate the buffer of the calling thread up front */
+  (void) sc_tracer_thread_get ();
+}
+
+void
+sc_tracer_stop (void)
+{
+  sc_tracer_thread_t *tt, *next;
+
+  for (tt = sc_tracer_threads; tt != NULL; tt = next) {
+    next = tt->next;
+    SC_FREE (tt->events);
+    SC_FREE (tt);
+  }
+  sc_tracer_threads = NULL;
+  sc_tracer_thread = NULL;
+  sc_tracer_num_threads = 0;
+  sc_tracer_active = 0;
+  ++sc_tracer_generation;
+}
+
+int
+sc_tracer_is_active (void)
+{
+  return sc_tracer_active;
+}
+
+void
+sc_tracer_begin (const char *name)
+{
+  sc_tracer_thread_t *tt;
+  sc_tracer_event_t  *ev;
+
+  if (!sc_tracer_active) {
+    return;
+  }
+  tt = sc_tracer_thread_get ();
+
+  /* keep room for the end events of all open regions */
+  if (tt->skip > 0 || tt->count + tt->open + 2 > sc_tracer_max_events) {
+    ++tt->skip;
+    ++tt->dropped;
+    return;
+  }
+  ev = tt->events + tt->count++;
+  ev->name = name;
+  ev->phase = 'B';
+  ev->time = sc_MPI_Wtime ();
+  ++tt->open;
+}
+
+void
+sc_tracer_end (const char *name)
+{
+  double              time;
+  sc_tracer_thread_t *tt;
+  sc_tracer_event_t  *ev;
+
+  if (!sc_tracer_active) {
+    return;
+  }
+  time = sc_MPI_Wtime ();
+  tt = sc_tracer_thread_get ();
+  if (tt->skip > 0) {
+    --tt->skip;
+    return;
+  }
+  SC_ASSERT (tt->open > 0 && tt->count < sc_tracer_max_events);
+  ev = tt->events + tt->count++;
+  ev->name = name;
+  ev->phase = 'E';
+  ev->time = time;
+  --tt->open;
+}
+
+long
+sc_tracer_dropped (void)
+{
+  long                dropped = 0;
+  sc_tracer_thread_t *tt;
+
+  for (tt = sc_tracer_threads; tt != NULL; tt = tt->next) {
+    dropped += tt->dropped;
+  }
+  return dropped;
+}
+
+/** Copy a name into a JSON string without the enclosing quotes. */
+static void
+sc_tracer_escape (char *out, size_t size, const char *name)
+{
+  size_t              len = 0;
+
+  SC_ASSERT (size >= 1);
+  for (; *name != '\0' && len + 3 < size; ++name) {
+    if (*name == '"' || *name == '\\') {
+      out[len++] = '\\';
+    }
+    out[len++] = (unsigned char) *name < 0x20 ? ' ' : *name;
+  }
+  out[len] = '\0';
+}
+
+int
+sc_tracer_write (sc_io_sink_t * sink, int rank)
+{
+  int                 retval;
+  int                 len;
+  size_t              zz;
+  char                line[BUFSIZ];
+  char                name[BUFSIZ / 2];
+  const char         *sep = "";
+  sc_tracer_thread_t *tt;
+  sc_tracer_event_t  *ev;
+
+  len = snprintf (line, BUFSIZ, "{\"traceEvents\":[\n");
+  retval = sc_io_sink_write (sink, line, (size_t) len);
+  for (tt = sc_tracer_threads; !retval && tt != NULL; tt = tt->next) {
+    for (zz = 0; !retval && zz < tt->count; ++zz) {
+      ev = tt->events + zz;
+      sc_tracer_escape (name, BUFSIZ / 2, ev->name);
+      len = snprintf (line, BUFSIZ,
+                      "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                      "\"pid\":%d,\"tid\":%d}", sep, name, ev->phase,
+                      1.e6 * (ev->time - sc_tracer_start_time),
+                      rank, tt->tid);
+      retval = sc_io_sink_write (sink, line, (size_t) len);
+      sep = ",\n";
+    }
+  }
+  if (!retval) {
+    len = snprintf (line, BUFSIZ,
+                    "\n],\"displayTimeUnit\":\"ms\","
+                    "\"otherData\":{\"dropped\":%ld}}\n",
+                    sc_tracer_dropped ());
+    retval = sc_io_sink_write (sink, line, (size_t) len);
+  }
+  return retval;
+}
@@ -0,0 +1,90 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef SC_TRACER_H
+#define SC_TRACER_H
+
+/** \file sc_tracer.h
+ * Record timestamped begin and end events for a timeline view.
+ *
+ * Every thread appends to its own event buffer of bounded size that is
+ * allocated once.  If a buffer is full, further regions are dropped as a
+ * whole and counted.  The events are written as Chrome trace JSON, which
+ * can be loaded by chrome://tracing or Perfetto, with the MPI rank as
+ * process and the thread as thread id.
+ *
+ * The collectives \ref sc_allgather, \ref sc_psort, the sc_notify
+ * functions and the regions of \ref sc_prof_begin are recorded
+ * automatically while the tracer is active.
+ * If the environment variable SC_TRACER_FILE is set, \ref sc_init starts
+ * the tracer and \ref sc_finalize writes the file
+ * $SC_TRACER_FILE.<rank>.json.  The environment variable
+ * SC_TRACER_EVENTS optionally sets the maximum events per thread.
+ */
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Default maximum number of events per thread. */
+#define SC_TRACER_EVENTS (1 << 16)
+
+/** Start recording events.
+ * This function must be called while no other thread records events.
+ * \param [in] max_events   Maximum number of events per thread.
+ *                          If 0, \ref SC_TRACER_EVENTS is used.
+ */
+void                sc_tracer_start (size_t max_events);
+
+/** Stop recording and discard all events. */
+void                sc_tracer_stop (void);
+
+/** Return true if the tracer is recording. */
+int                 sc_tracer_is_active (void);
+
+/** Record the begin of a region in the calling thread.
+ * Without an active tracer, this function returns immediately.
+ * \param [in] name     Name of the region.  It is stored by pointer,
+ *                      so it must stay alive until \ref sc_tracer_stop.
+ */
+void                sc_tracer_begin (const char *name);
+
+/** Record the end of the region most recently begun by this thread.
+ * \param [in] name     Name of the region, must match the begin.
+ */
+void                sc_tracer_end (const char *name);
+
+/** Return the number of events dropped because a buffer was full. */
+long                sc_tracer_dropped (void);
+
+/** Write all recorded events as Chrome trace JSON.
+ * This function must be called while no other thread records events.
+ * \param [in,out] sink     The sink to write to.
+ * \param [in] rank         Process id used in the output.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_tracer_write (sc_io_sink_t * sink, int rank);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_TRACER_H */
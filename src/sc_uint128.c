@@ -29,231 +29,152 @@
 
 #include <sc_uint128.h>
 
-void
-sc_uint128_init (sc_uint128_t * input, uint64_t high, uint64_t low)
-{
-  SC_ASSERT (input != NULL);
-  input->high_bits = high;
-  input->low_bits = low;
-}
+/* The arithmetic and bit operations are inline in the header. */
 
-int
-sc_uint128_chk_bit (const sc_uint128_t * input, int exponent)
+/** Spread the lower 32 bits of x to the even bits. */
+static inline       uint64_t
+sc_uint128_part1by1 (uint64_t x)
 {
-  SC_ASSERT (input != NULL);
-  SC_ASSERT (exponent >= 0);
-
-  if (exponent < 64) {
-    /* returns 0 or 1 according to the C99 standard */
-    return (input->low_bits & ((uint64_t) 1) << exponent) != 0;
-  }
-  else {
-    SC_ASSERT (exponent < 128);
-    return (input->high_bits & ((uint64_t) 1) << (exponent - 64)) != 0;
-  }
+  x &= 0x00000000ffffffffULL;
+  x = (x | x << 16) & 0x0000ffff0000ffffULL;
+  x = (x | x << 8) & 0x00ff00ff00ff00ffULL;
+  x = (x | x << 4) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & 0x5555555555555555ULL;
+  return x;
 }
 
-void
-sc_uint128_set_bit (sc_uint128_t * input, int exponent)
+/** Gather the even bits of x into the lower 32 bits. */
+static inline       uint64_t
+sc_uint128_compact1by1 (uint64_t x)
 {
-  SC_ASSERT (input != NULL);
-  SC_ASSERT (exponent >= 0);
-
-  if (exponent < 64) {
-    input->low_bits |= ((uint64_t) 1) << exponent;
-  }
-  else {
-    SC_ASSERT (exponent < 128);
-    input->high_bits |= ((uint64_t) 1) << (exponent - 64);
-  }
+  x &= 0x5555555555555555ULL;
+  x = (x | x >> 1) & 0x3333333333333333ULL;
+  x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | x >> 4) & 0x00ff00ff00ff00ffULL;
+  x = (x | x >> 8) & 0x0000ffff0000ffffULL;
+  x = (x | x >> 16) & 0x00000000ffffffffULL;
+  return x;
 }
 
-void
-sc_uint128_copy (const sc_uint128_t * input, sc_uint128_t * output)
+/** Spread the lower 21 bits of x to every third bit. */
+static inline       uint64_t
+sc_uint128_part1by2 (uint64_t x)
 {
-  SC_ASSERT (input != NULL && output != NULL);
-  output->high_bits = input->high_bits;
-  output->low_bits = input->low_bits;
+  x &= 0x00000000001fffffULL;
+  x = (x | x << 32) & 0x001f00000000ffffULL;
+  x = (x | x << 16) & 0x001f0000ff0000ffULL;
+  x = (x | x << 8) & 0x100f00f00f00f00fULL;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+  x = (x | x << 2) & 0x1249249249249249ULL;
+  return x;
 }
 
-int
-sc_uint128_is_equal (const sc_uint128_t * a, const sc_uint128_t * b)
+/** Gather every third bit of x into the lower 21 bits. */
+static inline       uint64_t
+sc_uint128_compact1by2 (uint64_t x)
 {
-  SC_ASSERT (a != NULL && b != NULL);
-  return a->high_bits == b->high_bits && a->low_bits == b->low_bits;
-}
-
-int
-sc_uint128_compare (const void *va, const void *vb)
-{
-  SC_ASSERT (va != NULL && vb != NULL);
-  const sc_uint128_t *a = (sc_uint128_t *) va;
-  const sc_uint128_t *b = (sc_uint128_t *) vb;
-
-  if (a->high_bits < b->high_bits) {
-    return -1;
-  }
-  else if (a->high_bits > b->high_bits) {
-    return 1;
-  }
-  else if (a->low_bits < b->low_bits) {
-    return -1;
-  }
-  else if (a->low_bits > b->low_bits) {
-    return 1;
-  }
-  return 0;
+  x &= 0x1249249249249249ULL;
+  x = (x | x >> 2) & 0x10c30c30c30c30c3ULL;
+  x = (x | x >> 4) & 0x100f00f00f00f00fULL;
+  x = (x | x >> 8) & 0x001f0000ff0000ffULL;
+  x = (x | x >> 16) & 0x001f00000000ffffULL;
+  x = (x | x >> 32) & 0x00000000001fffffULL;
+  return x;
 }
 
 void
-sc_uint128_add (const sc_uint128_t * a, const sc_uint128_t * b,
-                sc_uint128_t * result)
-{
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  SC_ASSERT (result != a && result != b);
-  result->high_bits = a->high_bits + b->high_bits;
-  result->low_bits = a->low_bits + b->low_bits;
-  if (result->low_bits < a->low_bits) {
-    ++result->high_bits;
-  }
-}
-
- /* we assume result >= 0 and calculate a - b */
-void
-sc_uint128_sub (const sc_uint128_t * a, const sc_uint128_t * b,
-                sc_uint128_t * result)
-{
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  SC_ASSERT (result != a && result != b);
-  result->high_bits = a->high_bits - b->high_bits;
-  result->low_bits = a->low_bits - b->low_bits;
-  if (a->low_bits < result->low_bits) {
-    --result->high_bits;
-  }
-}
-
-void
-sc_uint128_bitwise_neg (const sc_uint128_t * a, sc_uint128_t * result)
-{
-  SC_ASSERT (a != NULL && result != NULL);
-  result->high_bits = ~a->high_bits;
-  result->low_bits = ~a->low_bits;
-}
-
-void
-sc_uint128_bitwise_or (const sc_uint128_t * a, const sc_uint128_t * b,
-                       sc_uint128_t * result)
-{
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  result->high_bits = a->high_bits | b->high_bits;
-  result->low_bits = a->low_bits | b->low_bits;
-}
-
-void
-sc_uint128_bitwise_and (const sc_uint128_t * a, const sc_uint128_t * b,
-                        sc_uint128_t * result)
-{
-  SC_ASSERT (a != NULL && b != NULL && result != NULL);
-  result->high_bits = a->high_bits & b->high_bits;
-  result->low_bits = a->low_bits & b->low_bits;
-}
-
-void
-sc_uint128_shift_right (const sc_uint128_t * input, int shift_count,
-                        sc_uint128_t * result)
-{
-  SC_ASSERT (input != NULL && result != NULL);
-  SC_ASSERT (shift_count >= 0);
-  if (shift_count >= 128) {
-    result->high_bits = 0;
-    result->low_bits = 0;
-    return;
-  }
-
-  result->high_bits = input->high_bits;
-  result->low_bits = input->low_bits;
-  if (shift_count == 0)
-    return;
-
-  if (shift_count >= 64) {
-    result->low_bits = input->high_bits;
-    result->high_bits = 0;
-    result->low_bits >>= (shift_count - 64);
+sc_uint128_morton_encode (int dim, int bits, size_t n,
+                          const uint64_t * coords, sc_uint128_t * keys)
+{
+  int                 b, d;
+  size_t              zz;
+  uint64_t            c0, c1;
+  const uint64_t     *c;
+
+  SC_ASSERT (dim >= 1 && bits >= 0 && bits <= 64 && dim * bits <= 128);
+
+  if (dim == 2) {
+    for (zz = 0; zz < n; ++zz) {
+      c = coords + 2 * zz;
+      keys[zz].low_bits = sc_uint128_part1by1 (c[0]) |
+        sc_uint128_part1by1 (c[1]) << 1;
+      keys[zz].high_bits = sc_uint128_part1by1 (c[0] >> 32) |
+        sc_uint128_part1by1 (c[1] >> 32) << 1;
+    }
+  }
+  else if (dim == 3) {
+    /* two chunks of 63 bits each hold 21 bits per coordinate */
+    for (zz = 0; zz < n; ++zz) {
+      c = coords + 3 * zz;
+      c0 = sc_uint128_part1by2 (c[0]) | sc_uint128_part1by2 (c[1]) << 1 |
+        sc_uint128_part1by2 (c[2]) << 2;
+      c1 = sc_uint128_part1by2 (c[0] >> 21) |
+        sc_uint128_part1by2 (c[1] >> 21) << 1 |
+        sc_uint128_part1by2 (c[2] >> 21) << 2;
+      keys[zz].low_bits = c0 | c1 << 63;
+      keys[zz].high_bits = c1 >> 1;
+    }
   }
   else {
-    result->low_bits =
-      (result->high_bits << (64 - shift_count)) |
-      (input->low_bits >> shift_count);
-    result->high_bits >>= shift_count;
+    for (zz = 0; zz < n; ++zz) {
+      c = coords + (size_t) dim *zz;
+      sc_uint128_init (keys + zz, 0, 0);
+      for (b = 0; b < bits; ++b) {
+        for (d = 0; d < dim; ++d) {
+          if ((c[d] >> b) & 1) {
+            sc_uint128_set_bit (keys + zz, b * dim + d);
+          }
+        }
+      }
+    }
   }
 }
 
 void
-sc_uint128_shift_left (const sc_uint128_t * input, int shift_count,
-                       sc_uint128_t * result)
-{
-  SC_ASSERT (input != NULL && result != NULL);
-  SC_ASSERT (shift_count >= 0);
-  if (shift_count >= 128) {
-    result->high_bits = 0;
-    result->low_bits = 0;
-    return;
-  }
-
-  result->high_bits = input->high_bits;
-  result->low_bits = input->low_bits;
-  if (shift_count == 0)
-    return;
-
-  if (shift_count >= 64) {
-    result->high_bits = input->low_bits;
-    result->low_bits = 0;
-    result->high_bits <<= (shift_count - 64);
+sc_uint128_morton_decode (int dim, int bits, size_t n,
+                          const sc_uint128_t * keys, uint64_t * coords)
+{
+  int                 b, d;
+  size_t              zz;
+  uint64_t            c0, c1, mask;
+  uint64_t           *c;
+
+  SC_ASSERT (dim >= 1 && bits >= 0 && bits <= 64 && dim * bits <= 128);
+
+  mask = bits >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << bits) - 1;
+  if (dim == 2) {
+    for (zz = 0; zz < n; ++zz) {
+      c = coords + 2 * zz;
+      for (d = 0; d < 2; ++d) {
+        c[d] = (sc_uint128_compact1by1 (keys[zz].low_bits >> d) |
+                sc_uint128_compact1by1 (keys[zz].high_bits >> d) << 32)
+          & mask;
+      }
+    }
+  }
+  else if (dim == 3) {
+    for (zz = 0; zz < n; ++zz) {
+      c = coords + 3 * zz;
+      c0 = keys[zz].low_bits & ~((uint64_t) 1 << 63);
+      c1 = keys[zz].low_bits >> 63 | keys[zz].high_bits << 1;
+      for (d = 0; d < 3; ++d) {
+        c[d] = (sc_uint128_compact1by2 (c0 >> d) |
+                sc_uint128_compact1by2 (c1 >> d) << 21) & mask;
+      }
+    }
   }
   else {
-    result->high_bits =
-      (result->high_bits << shift_count) | (input->
-                                            low_bits >> (64 - shift_count));
-    result->low_bits <<= shift_count;
-  }
-}
-
-void
-sc_uint128_add_inplace (sc_uint128_t * a, const sc_uint128_t * b)
-{
-  SC_ASSERT (a != NULL && b != NULL);
-  uint64_t            temp = a->low_bits;
-  a->high_bits += b->high_bits;
-  a->low_bits += b->low_bits;
-  if (a->low_bits < temp) {
-    ++a->high_bits;
-  }
-}
-
-void
-sc_uint128_sub_inplace (sc_uint128_t * a, const sc_uint128_t * b)
-{
-  SC_ASSERT (a != NULL && b != NULL);
-  uint64_t            temp = a->low_bits;
-  a->high_bits -= b->high_bits;
-  a->low_bits -= b->low_bits;
-  if (temp < a->low_bits) {
-    --a->high_bits;
+    for (zz = 0; zz < n; ++zz) {
+      c = coords + (size_t) dim *zz;
+      for (d = 0; d < dim; ++d) {
+        c[d] = 0;
+      }
+      for (b = 0; b < bits; ++b) {
+        for (d = 0; d < dim; ++d) {
+          c[d] |= (uint64_t) sc_uint128_chk_bit (keys + zz, b * dim + d) << b;
+        }
+      }
+    }
   }
 }
-
-void
-sc_uint128_bitwise_or_inplace (sc_uint128_t * a, const sc_uint128_t * b)
-{
-  SC_ASSERT (a != NULL && b != NULL);
-  a->low_bits |= b->low_bits;
-  a->high_bits |= b->high_bits;
-}
-
-void
-sc_uint128_bitwise_and_inplace (sc_uint128_t * a, const sc_uint128_t * b)
-{
-  SC_ASSERT (a != NULL && b != NULL);
-  a->high_bits &= b->high_bits;
-  a->low_bits &= b->low_bits;
-}
@@ -48,14 +48,85 @@ typedef struct sc_uint128
 }
 sc_uint128_t;
 
+#ifdef __SIZEOF_INT128__
+
+/** The compiler supports unsigned 128 bit integers. */
+#define SC_UINT128_NATIVE
+
+/** The compiler's native unsigned 128 bit integer type. */
+typedef __uint128_t sc_uint128_native_t;
+
+/** Convert a sc_uint128_t to the native integer type.
+ * \param [in]  a A pointer to a sc_uint128_t.
+ * \return        The same number as a native integer.
+ */
+static inline       sc_uint128_native_t
+sc_uint128_to_native (const sc_uint128_t * a)
+{
+  return ((sc_uint128_native_t) a->high_bits << 64) | a->low_bits;
+}
+
+/** Convert a native integer to a sc_uint128_t.
+ * \param [in]  x       The number as a native integer.
+ * \param [out] result  A pointer to a sc_uint128_t.
+ */
+static inline void
+sc_uint128_from_native (sc_uint128_native_t x, sc_uint128_t * result)
+{
+  result->high_bits = (uint64_t) (x >> 64);
+  result->low_bits = (uint64_t) x;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
 /** Compare the sc_uint128_t \a a and the sc_uint128_t \a b.
+ * The comparison is branchless, which suits it as a callback for sorting.
+ * To sort arrays of keys without callbacks, use \ref sc_array_sort_keyed
+ * with the key type SC_ARRAY_KEY_UINT128.
  * \param [in]  a A pointer to a sc_uint128_t.
  * \param [in]  b A pointer to a sc_uint128_t.
  * \return        Returns -1 if a < b,
  *                         1 if a > b and
  *                         0 if a == b.
  */
-int                 sc_uint128_compare (const void *a, const void *b);
+static inline int
+sc_uint128_compare (const void *va, const void *vb)
+{
+  const sc_uint128_t *a = (const sc_uint128_t *) va;
+  const sc_uint128_t *b = (const sc_uint128_t *) vb;
+#ifdef SC_UINT128_NATIVE
+  const sc_uint128_native_t x = sc_uint128_to_native (a);
+  const sc_uint128_native_t y = sc_uint128_to_native (b);
+
+  SC_ASSERT (va != NULL && vb != NULL);
+  return (x > y) - (x < y);
+#else
+  const int           hc = (a->high_bits > b->high_bits) -
+    (a->high_bits < b->high_bits);
+  const int           lc = (a->low_bits > b->low_bits) -
+    (a->low_bits < b->low_bits);
+
+  SC_ASSERT (va != NULL && vb != NULL);
+  return hc != 0 ? hc : lc;
+#endif
+}
+
+/** Checks if the sc_uint128_t \a a is less than the sc_uint128_t \a b.
+ * \param [in]  a A pointer to a sc_uint128_t.
+ * \param [in]  b A pointer to a sc_uint128_t.
+ * \return        Returns true if \a a < \a b, false otherwise.
+ */
+static inline int
+sc_uint128_is_less (const sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+#ifdef SC_UINT128_NATIVE
+  return sc_uint128_to_native (a) < sc_uint128_to_native (b);
+#else
+  return (a->high_bits < b->high_bits) |
+    ((a->high_bits == b->high_bits) & (a->low_bits < b->low_bits));
+#endif
+}
 
 /** Checks if the sc_uint128_t \a a and the sc_uint128_t \a b are equal.
  * \param [in]  a A pointer to a sc_uint128_t.
@@ -63,8 +134,12 @@ int                 sc_uint128_compare (const void *a, const void *b);
  * \return        Returns a true value if \a a and \a b are equal,
  *                false otherwise.
  */
-int                 sc_uint128_is_equal (const sc_uint128_t * a,
-                                         const sc_uint128_t * b);
+static inline int
+sc_uint128_is_equal (const sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+  return ((a->high_bits ^ b->high_bits) | (a->low_bits ^ b->low_bits)) == 0;
+}
 
 /** Initializes an unsigned 128 bit integer to a given value.
  * \param [in,out] a        A pointer to the sc_uint128_t that will be
@@ -72,8 +147,13 @@ int                 sc_uint128_is_equal (const sc_uint128_t * a,
  * \param [in]     high     The given high bits to initialize \a a.
  * \param [in]     low      The given low bits to initialize \a a.
  */
-void                sc_uint128_init (sc_uint128_t * a,
-                                     uint64_t high, uint64_t low);
+static inline void
+sc_uint128_init (sc_uint128_t * a, uint64_t high, uint64_t low)
+{
+  SC_ASSERT (a != NULL);
+  a->high_bits = high;
+  a->low_bits = low;
+}
 
 /** Returns the bit_number-th bit of \a input.
  * This function checks a bit of an existing, initialized value.
@@ -83,8 +163,14 @@ void                sc_uint128_init (sc_uint128_t * a,
  *                            Require 0 <= \a bit_number < 128.
  * \return                    True if the checked bit is set, false if not.
  */
-int                 sc_uint128_chk_bit (const sc_uint128_t * input,
-                                        int exponent);
+static inline int
+sc_uint128_chk_bit (const sc_uint128_t * input, int exponent)
+{
+  SC_ASSERT (input != NULL);
+  SC_ASSERT (0 <= exponent && exponent < 128);
+  return (int) (((exponent < 64 ? input->low_bits : input->high_bits)
+                 >> (exponent & 63)) & 1);
+}
 
 /** Sets the exponent-th bit of \a a to one and keep all other bits.
  * This function modifies an existing, initialized value.
@@ -93,7 +179,18 @@ int                 sc_uint128_chk_bit (const sc_uint128_t * input,
  *                          that is set to one by logical or.
  *                          0 <= \a exponent < 128.
  */
-void                sc_uint128_set_bit (sc_uint128_t * a, int exponent);
+static inline void
+sc_uint128_set_bit (sc_uint128_t * a, int exponent)
+{
+  SC_ASSERT (a != NULL);
+  SC_ASSERT (0 <= exponent && exponent < 128);
+  if (exponent < 64) {
+    a->low_bits |= ((uint64_t) 1) << exponent;
+  }
+  else {
+    a->high_bits |= ((uint64_t) 1) << (exponent - 64);
+  }
+}
 
 /** Copies an initialized sc_uint128_t to a sc_uint128_t.
  * \param [in]     input    A pointer to the sc_uint128 that is copied.
@@ -102,8 +199,12 @@ void                sc_uint128_set_bit (sc_uint128_t * a, int exponent);
  *                          be set to the high and low bits of
  *                          \a input, respectively.
  */
-void                sc_uint128_copy (const sc_uint128_t * input,
-                                     sc_uint128_t * output);
+static inline void
+sc_uint128_copy (const sc_uint128_t * input, sc_uint128_t * output)
+{
+  SC_ASSERT (input != NULL && output != NULL);
+  *output = *input;
+}
 
 /** Adds the uint128_t \a b to the uint128_t \a a.
  * \a result == \a a or \a result == \a b is not allowed.
@@ -113,9 +214,21 @@ void                sc_uint128_copy (const sc_uint128_t * input,
  * \param[out]  result  A pointer to a sc_uint128_t.
  *                      The sum \a a + \a b will be saved in \a result.
  */
-void                sc_uint128_add (const sc_uint128_t * a,
-                                    const sc_uint128_t * b,
-                                    sc_uint128_t * result);
+static inline void
+sc_uint128_add (const sc_uint128_t * a, const sc_uint128_t * b,
+                sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  SC_ASSERT (result != a && result != b);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (sc_uint128_to_native (a) +
+                          sc_uint128_to_native (b), result);
+#else
+  result->low_bits = a->low_bits + b->low_bits;
+  result->high_bits = a->high_bits + b->high_bits +
+    (result->low_bits < a->low_bits);
+#endif
+}
 
 /** Subtracts the uint128_t \a b from the uint128_t \a a.
  * This function assumes that the result is >= 0.
@@ -126,9 +239,21 @@ void                sc_uint128_add (const sc_uint128_t * a,
  * \param[out]  result  A pointer to a sc_uint128_t.
  *                      The difference \a a - \a b will be saved in \a result.
  */
-void                sc_uint128_sub (const sc_uint128_t * a,
-                                    const sc_uint128_t * b,
-                                    sc_uint128_t * result);
+static inline void
+sc_uint128_sub (const sc_uint128_t * a, const sc_uint128_t * b,
+                sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  SC_ASSERT (result != a && result != b);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (sc_uint128_to_native (a) -
+                          sc_uint128_to_native (b), result);
+#else
+  result->low_bits = a->low_bits - b->low_bits;
+  result->high_bits = a->high_bits - b->high_bits -
+    (a->low_bits < b->low_bits);
+#endif
+}
 
 /** Calculates the bitwise negation of the uint128_t \a a.
  * \a a == \a result is allowed.
@@ -137,8 +262,13 @@ void                sc_uint128_sub (const sc_uint128_t * a,
  *                      The bitwise negation of \a a will be saved in
  *                      \a result.
  */
-void                sc_uint128_bitwise_neg (const sc_uint128_t * a,
-                                            sc_uint128_t * result);
+static inline void
+sc_uint128_bitwise_neg (const sc_uint128_t * a, sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && result != NULL);
+  result->high_bits = ~a->high_bits;
+  result->low_bits = ~a->low_bits;
+}
 
 /** Calculates the bitwise or of the uint128_t \a a and \a b.
  * \a a == \a result is allowed. Furthermore, \a a == \a result
@@ -149,9 +279,14 @@ void                sc_uint128_bitwise_neg (const sc_uint128_t * a,
  *                      The bitwise or of \a a and \a b will be
  *                      saved in \a result.
  */
-void                sc_uint128_bitwise_or (const sc_uint128_t * a,
-                                           const sc_uint128_t * b,
-                                           sc_uint128_t * result);
+static inline void
+sc_uint128_bitwise_or (const sc_uint128_t * a, const sc_uint128_t * b,
+                       sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  result->high_bits = a->high_bits | b->high_bits;
+  result->low_bits = a->low_bits | b->low_bits;
+}
 
 /** Calculates the bitwise and of the uint128_t \a a and the uint128_t \a b.
  * \a a == \a result is allowed. Furthermore, \a a == \a result
@@ -162,9 +297,14 @@ void                sc_uint128_bitwise_or (const sc_uint128_t * a,
  *                      The bitwise and of \a a and \a b will be saved.
  *                      in \a result.
  */
-void                sc_uint128_bitwise_and (const sc_uint128_t * a,
-                                            const sc_uint128_t * b,
-                                            sc_uint128_t * result);
+static inline void
+sc_uint128_bitwise_and (const sc_uint128_t * a, const sc_uint128_t * b,
+                        sc_uint128_t * result)
+{
+  SC_ASSERT (a != NULL && b != NULL && result != NULL);
+  result->high_bits = a->high_bits & b->high_bits;
+  result->low_bits = a->low_bits & b->low_bits;
+}
 
 /** Calculates the bit right shift of uint128_t \a input by shift_count bits.
  * We shift in zeros from the left. If \a shift_count >= 128, \a result is 0.
@@ -176,9 +316,34 @@ void                sc_uint128_bitwise_and (const sc_uint128_t * a,
  *                              The right shifted number will be saved
  *                              in \a result.
  */
-void                sc_uint128_shift_right (const sc_uint128_t * input,
-                                            int shift_count,
-                                            sc_uint128_t * result);
+static inline void
+sc_uint128_shift_right (const sc_uint128_t * input, int shift_count,
+                        sc_uint128_t * result)
+{
+  SC_ASSERT (input != NULL && result != NULL);
+  SC_ASSERT (shift_count >= 0);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (shift_count >= 128 ? 0 :
+                          sc_uint128_to_native (input) >> shift_count,
+                          result);
+#else
+  if (shift_count >= 128) {
+    result->high_bits = result->low_bits = 0;
+  }
+  else if (shift_count >= 64) {
+    result->low_bits = input->high_bits >> (shift_count - 64);
+    result->high_bits = 0;
+  }
+  else if (shift_count > 0) {
+    result->low_bits = (input->high_bits << (64 - shift_count)) |
+      (input->low_bits >> shift_count);
+    result->high_bits = input->high_bits >> shift_count;
+  }
+  else {
+    *result = *input;
+  }
+#endif
+}
 
 /** Calculates the bit left shift of uint128_t \a input by shift_count bits.
  * We shift in zeros from the right. If \a shift_count >= 128, \a result is 0.
@@ -190,9 +355,34 @@ void                sc_uint128_shift_right (const sc_uint128_t * input,
  *                              The left shifted number will be saved
  *                              in \a result.
  */
-void                sc_uint128_shift_left (const sc_uint128_t * input,
-                                           int shift_count,
-                                           sc_uint128_t * result);
+static inline void
+sc_uint128_shift_left (const sc_uint128_t * input, int shift_count,
+                       sc_uint128_t * result)
+{
+  SC_ASSERT (input != NULL && result != NULL);
+  SC_ASSERT (shift_count >= 0);
+#ifdef SC_UINT128_NATIVE
+  sc_uint128_from_native (shift_count >= 128 ? 0 :
+                          sc_uint128_to_native (input) << shift_count,
+                          result);
+#else
+  if (shift_count >= 128) {
+    result->high_bits = result->low_bits = 0;
+  }
+  else if (shift_count >= 64) {
+    result->high_bits = input->low_bits << (shift_count - 64);
+    result->low_bits = 0;
+  }
+  else if (shift_count > 0) {
+    result->high_bits = (input->high_bits << shift_count) |
+      (input->low_bits >> (64 - shift_count));
+    result->low_bits = input->low_bits << shift_count;
+  }
+  else {
+    *result = *input;
+  }
+#endif
+}
 
 /** Adds the uint128 \a b to the uint128_t \a a.
  * The result is saved in \a a. \a a == \a b is allowed.
@@ -200,8 +390,15 @@ void                sc_uint128_shift_left (const sc_uint128_t * input,
  *                      will be overwritten by \a a + \a b.
  * \param [in]      b   A pointer to a sc_uint128_t.
  */
-void                sc_uint128_add_inplace (sc_uint128_t * a,
-                                            const sc_uint128_t * b);
+static inline void
+sc_uint128_add_inplace (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  const uint64_t      low = a->low_bits;
+
+  SC_ASSERT (a != NULL && b != NULL);
+  a->low_bits += b->low_bits;
+  a->high_bits += b->high_bits + (a->low_bits < low);
+}
 
 /** Subtracts the uint128_t \a b from the uint128_t \a a.
  * The result is saved in \a a. \a a == \a b is allowed.
@@ -210,8 +407,15 @@ void                sc_uint128_add_inplace (sc_uint128_t * a,
  *                      \a a will be overwritten by \a a - \a b.
  * \param [in]      b   A pointer to a sc_uint128_t.
  */
-void                sc_uint128_sub_inplace (sc_uint128_t * a,
-                                            const sc_uint128_t * b);
+static inline void
+sc_uint128_sub_inplace (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  const uint64_t      low = a->low_bits;
+
+  SC_ASSERT (a != NULL && b != NULL);
+  a->low_bits -= b->low_bits;
+  a->high_bits -= b->high_bits + (low < a->low_bits);
+}
 
 /** Calculates the bitwise or of the uint128_t \a a and the uint128_t \a b.
  * \a a == \a b is allowed.
@@ -219,8 +423,13 @@ void                sc_uint128_sub_inplace (sc_uint128_t * a,
  *                      The bitwise or will be saved in \a a.
  * \param [in]      b   A pointer to a sc_uint128_t.
  */
-void                sc_uint128_bitwise_or_inplace (sc_uint128_t * a,
-                                                   const sc_uint128_t * b);
+static inline void
+sc_uint128_bitwise_or_inplace (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+  a->high_bits |= b->high_bits;
+  a->low_bits |= b->low_bits;
+}
 
 /** Calculates the bitwise and of the uint128_t \a a and the uint128_t \a b.
  * \a a == \a b is allowed.
@@ -228,7 +437,42 @@ void                sc_uint128_bitwise_or_inplace (sc_uint128_t * a,
  *                      The bitwise and will be saved in \a a.
  * \param [in]      b   A pointer to a sc_uint128_t.
  */
-void                sc_uint128_bitwise_and_inplace (sc_uint128_t * a,
-                                                    const sc_uint128_t * b);
+static inline void
+sc_uint128_bitwise_and_inplace (sc_uint128_t * a, const sc_uint128_t * b)
+{
+  SC_ASSERT (a != NULL && b != NULL);
+  a->high_bits &= b->high_bits;
+  a->low_bits &= b->low_bits;
+}
+
+/** Interleave the bits of coordinates into Morton keys.
+ * Bit b of coordinate d becomes bit b * dim + d of the key.
+ * Dimensions 2 and 3 use bit spreading by masks instead of a bit loop.
+ * \param [in]  dim     The number of coordinates per key, at least 1.
+ * \param [in]  bits    The number of bits per coordinate, at least 0
+ *                      and no more than 64 and 128 / \a dim.  Each
+ *                      coordinate must be less than 2**\a bits.
+ * \param [in]  n       The number of keys.
+ * \param [in]  coords  Array of n * dim coordinates, key by key.
+ * \param [out] keys    Array of n keys.
+ */
+void                sc_uint128_morton_encode (int dim, int bits, size_t n,
+                                              const uint64_t * coords,
+                                              sc_uint128_t * keys);
+
+/** Extract the coordinates from Morton keys.
+ * This is the inverse of \ref sc_uint128_morton_encode.
+ * \param [in]  dim     The number of coordinates per key, at least 1.
+ * \param [in]  bits    The number of bits per coordinate, at least 0
+ *                      and no more than 64 and 128 / \a dim.  Key bits
+ *                      beyond the \a dim * \a bits lowest ones are
+ *                      ignored.
+ * \param [in]  n       The number of keys.
+ * \param [in]  keys    Array of n keys.
+ * \param [out] coords  Array of n * dim coordinates, key by key.
+ */
+void                sc_uint128_morton_decode (int dim, int bits, size_t n,
+                                              const sc_uint128_t * keys,
+                                              uint64_t * coords);
 
 #endif /* !SC_UINT128_H */
@@ -75,3 +75,259 @@ sc_unique_counter_release (sc_unique_counter_t * uc, int *counter)
 
   sc_mempool_free (uc->mempool, counter);
 }
+
+#if defined __GNUC__ && defined __ATOMIC_RELAXED
+/** The thread-safe factory uses compiler builtins. */
+#define SC_UNIQUE_COUNTER_ATOMIC
+#endif
+
+/** Number of 64-bit words in one page of the released bitmap. */
+#define SC_UNIQUE_COUNTER_WORDS (SC_UNIQUE_COUNTER_PAGE / 64)
+
+/** Number of pages to cover all non-negative int offsets. */
+#define SC_UNIQUE_COUNTER_PAGES \
+  ((int) (((uint64_t) INT_MAX + 1) / SC_UNIQUE_COUNTER_PAGE))
+
+struct sc_unique_counter_mt
+{
+  int                 start_value;
+  int                 next;     /* offset of the next fresh batch */
+  int                 num_free; /* number of bits set in the pages */
+  int                 num_pages;        /* number of pages allocated */
+  int                 scan_page;        /* where the last claim succeeded */
+  uint64_t           *pages[SC_UNIQUE_COUNTER_PAGES];
+};
+
+static int
+sc_unique_counter_fetch_add (int *p, int toadd)
+{
+#ifdef SC_UNIQUE_COUNTER_ATOMIC
+  return __atomic_fetch_add (p, toadd, __ATOMIC_ACQ_REL);
+#else
+  const int           old = *p;
+  *p += toadd;
+  return old;
+#endif
+}
+
+static int
+sc_unique_counter_load (const int *p)
+{
+#ifdef SC_UNIQUE_COUNTER_ATOMIC
+  return __atomic_load_n (p, __ATOMIC_ACQUIRE);
+#else
+  return *p;
+#endif
+}
+
+/** Return the page for an offset, possibly installing a new one.
+ * \param [in] create   If false and the page is missing, return NULL.
+ */
+static uint64_t    *
+sc_unique_counter_page (sc_unique_counter_mt_t * uc, int p, int create)
+{
+  uint64_t           *page;
+#ifdef SC_UNIQUE_COUNTER_ATOMIC
+  uint64_t           *expected = NULL;
+
+  page = __atomic_load_n (&uc->pages[p], __ATOMIC_ACQUIRE);
+  if (page == NULL && create) {
+    page = SC_ALLOC_ZERO (uint64_t, SC_UNIQUE_COUNTER_WORDS);
+    if (__atomic_compare_exchange_n (&uc->pages[p], &expected, page, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      sc_unique_counter_fetch_add (&uc->num_pages, 1);
+    }
+    else {
+      /* another thread installed the page first */
+      SC_FREE (page);
+      page = expected;
+    }
+  }
+#else
+  page = uc->pages[p];
+  if (page == NULL && create) {
+    page = uc->pages[p] = SC_ALLOC_ZERO (uint64_t, SC_UNIQUE_COUNTER_WORDS);
+    ++uc->num_pages;
+  }
+#endif
+  return page;
+}
+
+/** Mark a value as released in the shared bitmap. */
+static void
+sc_unique_counter_free_value (sc_unique_counter_mt_t * uc, int value)
+{
+  const int           offset = value - uc->start_value;
+  const int           bit = offset % SC_UNIQUE_COUNTER_PAGE;
+  const uint64_t      mask = (uint64_t) 1 << (bit % 64);
+  uint64_t           *word, old;
+
+  SC_ASSERT (0 <= offset && offset < sc_unique_counter_load (&uc->next));
+
+  word = sc_unique_counter_page (uc, offset / SC_UNIQUE_COUNTER_PAGE, 1) +
+    bit / 64;
+#ifdef SC_UNIQUE_COUNTER_ATOMIC
+  old = __atomic_fetch_or (word, mask, __ATOMIC_RELEASE);
+#else
+  old = *word;
+  *word |= mask;
+#endif
+  SC_CHECK_ABORTF (!(old & mask), "Unique value %d released twice", value);
+  sc_unique_counter_fetch_add (&uc->num_free, 1);
+}
+
+/** Take all released values of one bitmap word into a thread cache.
+ * \return              True if at least one value was claimed.
+ */
+static int
+sc_unique_counter_claim (sc_unique_counter_cache_t * cache)
+{
+  sc_unique_counter_mt_t *uc = cache->uc;
+  int                 i, p, w, b, num_pages, first;
+  uint64_t           *page, bits;
+
+  if (sc_unique_counter_load (&uc->num_free) <= 0) {
+    return 0;
+  }
+  num_pages = (sc_unique_counter_load (&uc->next) +
+               SC_UNIQUE_COUNTER_PAGE - 1) / SC_UNIQUE_COUNTER_PAGE;
+  first = sc_unique_counter_load (&uc->scan_page);
+  for (i = 0; i < num_pages; ++i) {
+    p = (first + i) % num_pages;
+    if ((page = sc_unique_counter_page (uc, p, 0)) == NULL) {
+      continue;
+    }
+    for (w = 0; w < SC_UNIQUE_COUNTER_WORDS; ++w) {
+#ifdef SC_UNIQUE_COUNTER_ATOMIC
+      if (__atomic_load_n (&page[w], __ATOMIC_RELAXED) == 0) {
+        continue;
+      }
+      bits = __atomic_exchange_n (&page[w], 0, __ATOMIC_ACQUIRE);
+#else
+      bits = page[w];
+      page[w] = 0;
+#endif
+      if (bits == 0) {
+        continue;
+      }
+
+      /* a word holds at most as many values as the cache has room for */
+      SC_ASSERT (cache->num_recycled == 0);
+      for (b = 0; b < 64; ++b) {
+        if (bits & ((uint64_t) 1 << b)) {
+          cache->recycled[cache->num_recycled++] = uc->start_value +
+            p * SC_UNIQUE_COUNTER_PAGE + w * 64 + b;
+        }
+      }
+      sc_unique_counter_fetch_add (&uc->num_free, -cache->num_recycled);
+#ifdef SC_UNIQUE_COUNTER_ATOMIC
+      __atomic_store_n (&uc->scan_page, p, __ATOMIC_RELAXED);
+#else
+      uc->scan_page = p;
+#endif
+      return 1;
+    }
+  }
+  return 0;
+}
+
+sc_unique_counter_mt_t *
+sc_unique_counter_mt_new (int start_value)
+{
+  sc_unique_counter_mt_t *uc;
+
+  uc = SC_ALLOC_ZERO (sc_unique_counter_mt_t, 1);
+  uc->start_value = start_value;
+
+  return uc;
+}
+
+void
+sc_unique_counter_mt_destroy (sc_unique_counter_mt_t * uc)
+{
+  int                 p;
+
+  /* every value handed out has come back to the bitmap */
+  SC_ASSERT (uc->num_free == uc->next);
+
+  for (p = 0; p < SC_UNIQUE_COUNTER_PAGES; ++p) {
+    SC_FREE (uc->pages[p]);
+  }
+  SC_FREE (uc);
+}
+
+size_t
+sc_unique_counter_mt_memory_used (sc_unique_counter_mt_t * uc)
+{
+  return sizeof (sc_unique_counter_mt_t) +
+    (size_t) sc_unique_counter_load (&uc->num_pages) *
+    SC_UNIQUE_COUNTER_WORDS * sizeof (uint64_t);
+}
+
+void
+sc_unique_counter_cache_init (sc_unique_counter_cache_t * cache,
+                              sc_unique_counter_mt_t * uc)
+{
+  SC_ASSERT (cache != NULL && uc != NULL);
+
+  cache->uc = uc;
+  cache->next = cache->end = 0;
+  cache->num_recycled = 0;
+}
+
+void
+sc_unique_counter_cache_reset (sc_unique_counter_cache_t * cache)
+{
+  while (cache->num_recycled > 0) {
+    sc_unique_counter_free_value (cache->uc,
+                                  cache->recycled[--cache->num_recycled]);
+  }
+  while (cache->next < cache->end) {
+    sc_unique_counter_free_value (cache->uc, cache->next++);
+  }
+  cache->uc = NULL;
+}
+
+int
+sc_unique_counter_cache_add (sc_unique_counter_cache_t * cache)
+{
+  sc_unique_counter_mt_t *uc = cache->uc;
+  int                 offset;
+
+  SC_ASSERT (uc != NULL);
+
+  if (cache->num_recycled > 0 || sc_unique_counter_claim (cache)) {
+    return cache->recycled[--cache->num_recycled];
+  }
+  if (cache->next == cache->end) {
+    offset = sc_unique_counter_fetch_add (&uc->next,
+                                          SC_UNIQUE_COUNTER_BATCH);
+    SC_CHECK_ABORT (offset >= 0 && (int64_t) uc->start_value + offset +
+                    SC_UNIQUE_COUNTER_BATCH <= INT_MAX,
+                    "Unique counter overflow");
+    cache->next = uc->start_value + offset;
+    cache->end = cache->next + SC_UNIQUE_COUNTER_BATCH;
+  }
+  return cache->next++;
+}
+
+void
+sc_unique_counter_cache_release (sc_unique_counter_cache_t * cache,
+                                 int value)
+{
+  int                 i;
+
+  SC_ASSERT (cache->uc != NULL);
+  SC_ASSERT (value >= cache->uc->start_value);
+
+  if (cache->num_recycled == 2 * SC_UNIQUE_COUNTER_BATCH) {
+    /* share the older half with the other threads */
+    for (i = 0; i < SC_UNIQUE_COUNTER_BATCH; ++i) {
+      sc_unique_counter_free_value (cache->uc, cache->recycled[i]);
+    }
+    memmove (cache->recycled, cache->recycled + SC_UNIQUE_COUNTER_BATCH,
+             SC_UNIQUE_COUNTER_BATCH * sizeof (int));
+    cache->num_recycled = SC_UNIQUE_COUNTER_BATCH;
+  }
+  cache->recycled[cache->num_recycled++] = value;
+}
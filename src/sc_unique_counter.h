@@ -73,4 +73,87 @@ int                *sc_unique_counter_add (sc_unique_counter_t * uc);
 void                sc_unique_counter_release (sc_unique_counter_t * uc,
                                                int *counter);
 
+/** Number of fresh values a thread cache takes from the shared counter. */
+#define SC_UNIQUE_COUNTER_BATCH 64
+
+/** A factory of unique integers for use by many threads.
+ * Fresh values are handed to the thread caches in batches by an atomic
+ * increment of a shared counter.  Released values are kept in a bitmap
+ * of pages that are installed and updated with atomic operations, thus
+ * the factory is lock-free.  Each page covers \ref
+ * SC_UNIQUE_COUNTER_PAGE values.  Without compiler atomics it is only
+ * safe to use from one thread.
+ */
+typedef struct sc_unique_counter_mt sc_unique_counter_mt_t;
+
+/** Number of values covered by one page of the released bitmap. */
+#define SC_UNIQUE_COUNTER_PAGE (1 << 18)
+
+/** The per-thread cache of an \ref sc_unique_counter_mt_t.
+ * A cache must only be used by one thread at a time.
+ */
+typedef struct sc_unique_counter_cache
+{
+  sc_unique_counter_mt_t *uc;   /**< The shared factory. */
+  int                 next;     /**< Next fresh value of this thread. */
+  int                 end;      /**< End of the fresh values. */
+  int                 num_recycled;     /**< Number of values below. */
+  int                 recycled[2 * SC_UNIQUE_COUNTER_BATCH]; /**< Values
+                                           released by this thread. */
+}
+sc_unique_counter_cache_t;
+
+/** Create a thread-safe factory for unique integers.
+ * \param [in] start_value      Smallest value to be handed out.
+ * \return                      Factory that is ready to use.
+ */
+sc_unique_counter_mt_t *sc_unique_counter_mt_new (int start_value);
+
+/** Destroy a thread-safe factory.
+ * All values must have been released and all caches reset before.
+ * \param [in,out] uc           This memory will be released.
+ */
+void                sc_unique_counter_mt_destroy (sc_unique_counter_mt_t *
+                                                  uc);
+
+/** Return the size in bytes allocated by a thread-safe factory.
+ * \param [in] uc               Its total memory used will be counted.
+ */
+size_t              sc_unique_counter_mt_memory_used (sc_unique_counter_mt_t
+                                                      * uc);
+
+/** Initialize a thread cache for a factory.
+ * \param [out] cache           Cache to be used by one thread.
+ * \param [in,out] uc           The factory must stay alive until the
+ *                              cache is reset.
+ */
+void                sc_unique_counter_cache_init (sc_unique_counter_cache_t
+                                                  * cache,
+                                                  sc_unique_counter_mt_t *
+                                                  uc);
+
+/** Return the values held by a thread cache to its factory.
+ * This function may be called concurrently by several threads.
+ * \param [in,out] cache        The cache is empty afterwards.
+ */
+void                sc_unique_counter_cache_reset (sc_unique_counter_cache_t
+                                                   * cache);
+
+/** Return a unique integer through a thread cache.
+ * Values released by this thread are reused first, then values released
+ * by any thread, and finally fresh values of the thread's batch.
+ * \param [in,out] cache        Initialized cache.
+ * \return                      A value not currently handed out.
+ */
+int                 sc_unique_counter_cache_add (sc_unique_counter_cache_t *
+                                                 cache);
+
+/** Release a unique integer through a thread cache.
+ * \param [in,out] cache        Initialized cache.
+ * \param [in] value            A value obtained from any cache of the
+ *                              same factory and not since released.
+ */
+void                sc_unique_counter_cache_release (sc_unique_counter_cache_t
+                                                     * cache, int value);
+
 #endif /* !SC_UNIQUE_COUNTER */
@@ -49,11 +49,34 @@
 #ifdef SC_HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef SC_ENABLE_V4L2
+#include <sys/mman.h>
+#endif
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
 
 #ifndef SC_BUFSIZE
 #define SC_BUFSIZE BUFSIZ
 #endif
 
+/** State of a memory mapped buffer for streaming output. */
+typedef enum
+{
+  SC_V4L2_BUFFER_FREE,          /**< available to be acquired */
+  SC_V4L2_BUFFER_ACQUIRED,      /**< being rendered into by the caller */
+  SC_V4L2_BUFFER_QUEUED         /**< owned by the driver */
+}
+sc_v4l2_buffer_state_t;
+
+typedef struct sc_v4l2_buffer
+{
+  char               *start;
+  size_t              length;
+  sc_v4l2_buffer_state_t state;
+}
+sc_v4l2_buffer_t;
+
 struct sc_v4l2_device
 {
   int                 fd;
@@ -61,6 +84,9 @@ struct sc_v4l2_device
   int                 support_readwrite;
   int                 support_streaming;
   int                 support_io_mc;
+  int                 stream_on;
+  unsigned            num_buffers;
+  sc_v4l2_buffer_t   *buffers;
 #ifdef SC_ENABLE_V4L2
   struct v4l2_capability capability;
   struct v4l2_output  output;
@@ -214,11 +240,22 @@ int
 sc_v4l2_device_format (sc_v4l2_device_t * vd,
                        unsigned int *width, unsigned int *height,
                        unsigned int *bytesperline, unsigned int *sizeimage)
+{
+  return sc_v4l2_device_format_ext (vd, SC_V4L2_PIXEL_RGB565, width, height,
+                                    bytesperline, sizeimage);
+}
+
+int
+sc_v4l2_device_format_ext (sc_v4l2_device_t * vd, sc_v4l2_pixel_t pixel,
+                           unsigned int *width, unsigned int *height,
+                           unsigned int *bytesperline,
+                           unsigned int *sizeimage)
 {
 #ifdef SC_ENABLE_V4L2
   int                 retval;
   int                 output_index;
   __u32               pixelformat;
+  __u32               colorspace;
 #endif
 
   SC_ASSERT (vd != NULL);
@@ -229,6 +266,8 @@ sc_v4l2_device_format (sc_v4l2_device_t * vd,
   SC_ASSERT (height != NULL);
   SC_ASSERT (bytesperline != NULL);
   SC_ASSERT (sizeimage != NULL);
+  SC_ASSERT (0 <= pixel && pixel < SC_V4L2_PIXEL_LAST);
+  SC_ASSERT (pixel != SC_V4L2_PIXEL_YUYV || *width % 2 == 0);
 
 #ifdef SC_ENABLE_V4L2
   /* select video output */
@@ -266,13 +305,20 @@ sc_v4l2_device_format (sc_v4l2_device_t * vd,
   pixelformat = V4L2_PIX_FMT_ABGR555;
   pixelformat = V4L2_PIX_FMT_RGBA555;
 #else
-  pixelformat = V4L2_PIX_FMT_RGB565;
+  if (pixel == SC_V4L2_PIXEL_YUYV) {
+    pixelformat = V4L2_PIX_FMT_YUYV;
+    colorspace = V4L2_COLORSPACE_SMPTE170M;
+  }
+  else {
+    pixelformat = V4L2_PIX_FMT_RGB565;
+    colorspace = V4L2_COLORSPACE_SRGB;
+  }
 #endif
   vd->pix->pixelformat = pixelformat;
   vd->pix->field = V4L2_FIELD_NONE;
   vd->pix->bytesperline = 2 * vd->pix->width;
   vd->pix->sizeimage = vd->pix->bytesperline * vd->pix->height;
-  vd->pix->colorspace = V4L2_COLORSPACE_SRGB;
+  vd->pix->colorspace = colorspace;
   vd->pix->ycbcr_enc = V4L2_YCBCR_ENC_DEFAULT;
   vd->pix->quantization = V4L2_QUANTIZATION_DEFAULT;
   vd->pix->xfer_func = V4L2_XFER_FUNC_DEFAULT;
@@ -282,7 +328,7 @@ sc_v4l2_device_format (sc_v4l2_device_t * vd,
     return retval;
   }
   if (vd->pix->pixelformat != pixelformat ||
-      vd->pix->colorspace != V4L2_COLORSPACE_SRGB ||
+      vd->pix->colorspace != colorspace ||
       vd->pix->field != V4L2_FIELD_NONE) {
     errno = EINVAL;
     return -1;
@@ -366,6 +412,236 @@ sc_v4l2_device_write (sc_v4l2_device_t * vd, const char *wbuf)
   return 0;
 }
 
+#ifdef SC_ENABLE_V4L2
+
+/** Request a number of mmap buffers from the driver, 0 to release them. */
+static int
+reqbufs (sc_v4l2_device_t * vd, unsigned *count)
+{
+  int                 retval;
+  struct v4l2_requestbuffers req;
+
+  memset (&req, 0, sizeof (req));
+  req.count = *count;
+  req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  req.memory = V4L2_MEMORY_MMAP;
+  if ((retval = ioctl (vd->fd, VIDIOC_REQBUFS, &req)) != 0) {
+    return retval;
+  }
+  *count = req.count;
+  return 0;
+}
+
+/** Unmap the first \a count buffers and release all of them. */
+static int
+unmap_buffers (sc_v4l2_device_t * vd, unsigned count)
+{
+  int                 retval = 0;
+  unsigned            i, zero = 0;
+
+  for (i = 0; i < count; ++i) {
+    if (munmap (vd->buffers[i].start, vd->buffers[i].length) != 0) {
+      retval = -1;
+    }
+  }
+  SC_FREE (vd->buffers);
+  vd->buffers = NULL;
+  vd->num_buffers = 0;
+  return reqbufs (vd, &zero) || retval ? -1 : 0;
+}
+
+#endif /* SC_ENABLE_V4L2 */
+
+int
+sc_v4l2_device_stream_start (sc_v4l2_device_t * vd, unsigned *num_buffers)
+{
+#ifdef SC_ENABLE_V4L2
+  int                 retval;
+  unsigned            i;
+  void               *start;
+  struct v4l2_buffer  buf;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (vd->support_output);
+  SC_ASSERT (num_buffers != NULL && *num_buffers >= 1);
+  SC_ASSERT (vd->buffers == NULL);
+
+#ifdef SC_ENABLE_V4L2
+  SC_ASSERT (vd->pix != NULL);
+  if (!vd->support_streaming) {
+    errno = EINVAL;
+    return -1;
+  }
+  if ((retval = reqbufs (vd, num_buffers)) != 0) {
+    return retval;
+  }
+  if (*num_buffers == 0) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  /* map each buffer into our address space */
+  vd->buffers = SC_ALLOC_ZERO (sc_v4l2_buffer_t, *num_buffers);
+  for (i = 0; i < *num_buffers; ++i) {
+    memset (&buf, 0, sizeof (buf));
+    buf.index = i;
+    buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    buf.memory = V4L2_MEMORY_MMAP;
+    start = MAP_FAILED;
+    if (ioctl (vd->fd, VIDIOC_QUERYBUF, &buf) == 0) {
+      start = mmap (NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    vd->fd, buf.m.offset);
+    }
+    if (start == MAP_FAILED || buf.length < vd->pix->sizeimage) {
+      if (start != MAP_FAILED) {
+        (void) munmap (start, buf.length);
+      }
+      (void) unmap_buffers (vd, i);
+      errno = EINVAL;
+      return -1;
+    }
+    vd->buffers[i].start = (char *) start;
+    vd->buffers[i].length = buf.length;
+    vd->buffers[i].state = SC_V4L2_BUFFER_FREE;
+  }
+  vd->num_buffers = *num_buffers;
+  vd->stream_on = 0;
+#endif
+  return 0;
+}
+
+int
+sc_v4l2_device_stream_acquire (sc_v4l2_device_t * vd, unsigned usec,
+                               char **buffer)
+{
+#ifdef SC_ENABLE_V4L2
+  int                 retval;
+  unsigned            i;
+  struct v4l2_buffer  buf;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (buffer != NULL);
+
+  *buffer = NULL;
+#ifdef SC_ENABLE_V4L2
+  SC_ASSERT (vd->buffers != NULL);
+
+  /* prefer a buffer that has never been queued or was reclaimed */
+  for (i = 0; i < vd->num_buffers; ++i) {
+    if (vd->buffers[i].state == SC_V4L2_BUFFER_FREE) {
+      vd->buffers[i].state = SC_V4L2_BUFFER_ACQUIRED;
+      *buffer = vd->buffers[i].start;
+      return 1;
+    }
+  }
+  if (!vd->stream_on) {
+    /* all buffers are held by the caller */
+    errno = EBUSY;
+    return -1;
+  }
+
+  /* wait for the device to finish with a buffer and reclaim it */
+  if ((retval = sc_v4l2_device_select (vd, usec)) <= 0) {
+    return retval;
+  }
+  memset (&buf, 0, sizeof (buf));
+  buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  buf.memory = V4L2_MEMORY_MMAP;
+  if (ioctl (vd->fd, VIDIOC_DQBUF, &buf) != 0) {
+    return errno == EAGAIN ? 0 : -1;
+  }
+  if (buf.index >= vd->num_buffers ||
+      vd->buffers[buf.index].state != SC_V4L2_BUFFER_QUEUED) {
+    errno = EINVAL;
+    return -1;
+  }
+  vd->buffers[buf.index].state = SC_V4L2_BUFFER_ACQUIRED;
+  *buffer = vd->buffers[buf.index].start;
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+int
+sc_v4l2_device_stream_queue (sc_v4l2_device_t * vd, char *buffer)
+{
+#ifdef SC_ENABLE_V4L2
+  int                 retval;
+  int                 type;
+  unsigned            i;
+  struct v4l2_buffer  buf;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (buffer != NULL);
+
+#ifdef SC_ENABLE_V4L2
+  SC_ASSERT (vd->buffers != NULL);
+  for (i = 0; i < vd->num_buffers; ++i) {
+    if (vd->buffers[i].start == buffer) {
+      break;
+    }
+  }
+  if (i == vd->num_buffers ||
+      vd->buffers[i].state != SC_V4L2_BUFFER_ACQUIRED) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  memset (&buf, 0, sizeof (buf));
+  buf.index = i;
+  buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  buf.memory = V4L2_MEMORY_MMAP;
+  buf.bytesused = vd->pix->sizeimage;
+  buf.field = V4L2_FIELD_NONE;
+  if ((retval = ioctl (vd->fd, VIDIOC_QBUF, &buf)) != 0) {
+    return retval;
+  }
+  vd->buffers[i].state = SC_V4L2_BUFFER_QUEUED;
+
+  /* the device starts consuming once the first buffer is queued */
+  if (!vd->stream_on) {
+    type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    if ((retval = ioctl (vd->fd, VIDIOC_STREAMON, &type)) != 0) {
+      return retval;
+    }
+    vd->stream_on = 1;
+  }
+#endif
+  return 0;
+}
+
+int
+sc_v4l2_device_stream_stop (sc_v4l2_device_t * vd)
+{
+  int                 retval = 0;
+#ifdef SC_ENABLE_V4L2
+  int                 type;
+#endif
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+
+#ifdef SC_ENABLE_V4L2
+  SC_ASSERT (vd->buffers != NULL);
+
+  /* turning streaming off dequeues all buffers */
+  if (vd->stream_on) {
+    type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    retval = ioctl (vd->fd, VIDIOC_STREAMOFF, &type);
+    vd->stream_on = 0;
+  }
+  retval = unmap_buffers (vd, vd->num_buffers) || retval ? -1 : 0;
+#endif
+  return retval;
+}
+
 int
 sc_v4l2_device_close (sc_v4l2_device_t * vd)
 {
@@ -377,6 +653,9 @@ sc_v4l2_device_close (sc_v4l2_device_t * vd)
   SC_ASSERT (vd->fd >= 0);
 
 #ifdef SC_ENABLE_V4L2
+  if (vd->buffers != NULL) {
+    (void) sc_v4l2_device_stream_stop (vd);
+  }
   if ((retval = close (vd->fd)) != 0) {
     SC_FREE (vd);
     return retval;
@@ -386,3 +665,347 @@ sc_v4l2_device_close (sc_v4l2_device_t * vd)
   SC_FREE (vd);
   return 0;
 }
+
+void
+sc_v4l2_colormap_init (sc_v4l2_colormap_t * cmap, int num_points,
+                       const unsigned char (*points)[3])
+{
+  int                 i, k, c;
+  double              s, w;
+  static const unsigned char coolwarm[3][3] = {
+    {0x3B, 0x4C, 0xC0}, {0xDD, 0xDD, 0xDD}, {0xB4, 0x04, 0x26}
+  };
+
+  SC_ASSERT (cmap != NULL);
+  if (points == NULL) {
+    points = coolwarm;
+    num_points = 3;
+  }
+  SC_ASSERT (num_points >= 2);
+
+  for (i = 0; i < 256; ++i) {
+    /* position of entry i between the given colors */
+    s = i * (num_points - 1) / 255.;
+    k = SC_MIN ((int) s, num_points - 2);
+    w = s - k;
+    for (c = 0; c < 3; ++c) {
+      cmap->rgb[i][c] = (unsigned char)
+        ((1. - w) * points[k][c] + w * points[k + 1][c] + .5);
+    }
+  }
+}
+
+/** Map a value to a colormap index; scale is 255 / (vmax - vmin). */
+static inline int
+sc_v4l2_color_index (float value, float vmin, float scale)
+{
+  float               s = (value - vmin) * scale;
+
+  /* the comparisons are false for NaN */
+  return s > 0.f ? (s < 255.f ? (int) (s + .5f) : 255) : 0;
+}
+
+void
+sc_v4l2_convert_field (sc_v4l2_pixel_t pixel, unsigned width,
+                       unsigned height, const float *field, size_t stride,
+                       float vmin, float vmax,
+                       const sc_v4l2_colormap_t * cmap, char *image,
+                       unsigned bytesperline, int num_threads)
+{
+  int                 i, j;
+  int                 r, g, b;
+  float               scale;
+  uint16_t            rgb565[256];
+  unsigned char       ty[256], tu[256], tv[256];
+
+  SC_ASSERT (0 <= pixel && pixel < SC_V4L2_PIXEL_LAST);
+  SC_ASSERT (pixel != SC_V4L2_PIXEL_YUYV || width % 2 == 0);
+  SC_ASSERT (field != NULL || width * height == 0);
+  SC_ASSERT (stride >= width);
+  SC_ASSERT (cmap != NULL);
+  SC_ASSERT (image != NULL || width * height == 0);
+  SC_ASSERT (bytesperline >= 2 * width);
+  SC_ASSERT (num_threads >= 1);
+
+  /* precompute the packed pixel of each colormap entry */
+  for (i = 0; i < 256; ++i) {
+    r = cmap->rgb[i][0];
+    g = cmap->rgb[i][1];
+    b = cmap->rgb[i][2];
+    rgb565[i] = (uint16_t) (((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+    ty[i] = (unsigned char) (16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+    tu[i] = (unsigned char)
+      (128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+    tv[i] = (unsigned char)
+      (128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+  }
+  scale = vmax > vmin ? 255.f / (vmax - vmin) : 0.f;
+
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static) \
+  private(i)
+#endif
+  for (j = 0; j < (int) height; ++j) {
+    const float        *row = field + (size_t) j * stride;
+    char               *out = image + (size_t) j * bytesperline;
+
+    if (pixel == SC_V4L2_PIXEL_RGB565) {
+      uint16_t           *upix = (uint16_t *) out;
+
+      for (i = 0; i < (int) width; ++i) {
+        upix[i] = rgb565[sc_v4l2_color_index (row[i], vmin, scale)];
+      }
+    }
+    else {
+      unsigned char      *ypix = (unsigned char *) out;
+      int                 k0, k1;
+
+      /* two pixels share the average of their chroma */
+      for (i = 0; i < (int) width; i += 2) {
+        k0 = sc_v4l2_color_index (row[i], vmin, scale);
+        k1 = sc_v4l2_color_index (row[i + 1], vmin, scale);
+        ypix[2 * i] = ty[k0];
+        ypix[2 * i + 1] = (unsigned char) ((tu[k0] + tu[k1] + 1) >> 1);
+        ypix[2 * i + 2] = ty[k1];
+        ypix[2 * i + 3] = (unsigned char) ((tv[k0] + tv[k1] + 1) >> 1);
+      }
+    }
+  }
+}
+
+struct sc_v4l2_producer
+{
+  sc_v4l2_device_t   *vd;
+  size_t              sizeimage;
+  double              period;   /**< minimum seconds between frames */
+  double              last;     /**< time of the last frame written */
+  char               *buffers[3];
+  int                 back;     /**< rendered into by the caller */
+  int                 latest;   /**< most recently published */
+  int                 front;    /**< being written to the device */
+  int                 fresh;    /**< latest has not been written yet */
+  int                 error;
+  unsigned long       num_written;
+  unsigned long       num_dropped;
+#ifdef SC_ENABLE_PTHREAD
+  int                 stopping;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+  pthread_t           thread;
+#endif
+};
+
+/** Pass one image to the device, through its stream if started.
+ * \return              -1 on error, 0 if not ready, 1 if written.
+ */
+static int
+sc_v4l2_producer_output (sc_v4l2_producer_t * producer, const char *image,
+                         unsigned usec)
+{
+  int                 retval;
+  char               *buffer;
+  sc_v4l2_device_t   *vd = producer->vd;
+
+  if (vd->buffers != NULL) {
+    if ((retval = sc_v4l2_device_stream_acquire (vd, usec, &buffer)) <= 0) {
+      return retval;
+    }
+    memcpy (buffer, image, producer->sizeimage);
+    return sc_v4l2_device_stream_queue (vd, buffer) ? -1 : 1;
+  }
+  if ((retval = sc_v4l2_device_select (vd, usec)) <= 0) {
+    return retval;
+  }
+  return sc_v4l2_device_write (vd, image) ? -1 : 1;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+static void        *
+sc_v4l2_producer_main (void *arg)
+{
+  int                 retval, tmp, stopping;
+  double              wait;
+  struct timespec     ts;
+  sc_v4l2_producer_t *producer = (sc_v4l2_producer_t *) arg;
+
+  pthread_mutex_lock (&producer->mutex);
+  for (;;) {
+    while (!producer->fresh && !producer->stopping) {
+      pthread_cond_wait (&producer->cond, &producer->mutex);
+    }
+    if (producer->stopping) {
+      break;
+    }
+
+    /* pace frames to the requested rate */
+    wait = producer->last + producer->period - sc_MPI_Wtime ();
+    if (wait > 0.) {
+      clock_gettime (CLOCK_REALTIME, &ts);
+      ts.tv_sec += (time_t) wait;
+      ts.tv_nsec += (long) ((wait - (time_t) wait) * 1e9);
+      if (ts.tv_nsec >= 1000000000L) {
+        ++ts.tv_sec;
+        ts.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait (&producer->cond, &producer->mutex, &ts);
+      continue;
+    }
+
+    /* take the latest frame and write it without holding the lock */
+    tmp = producer->front;
+    producer->front = producer->latest;
+    producer->latest = tmp;
+    producer->fresh = 0;
+    pthread_mutex_unlock (&producer->mutex);
+    stopping = 0;
+    do {
+      retval = sc_v4l2_producer_output (producer,
+                                        producer->buffers[producer->front],
+                                        10 * 1000);
+      if (retval == 0) {
+        /* the device is not ready; give up only when stopping */
+        pthread_mutex_lock (&producer->mutex);
+        stopping = producer->stopping;
+        pthread_mutex_unlock (&producer->mutex);
+      }
+    } while (retval == 0 && !stopping);
+    pthread_mutex_lock (&producer->mutex);
+    if (retval < 0) {
+      producer->error = 1;
+    }
+    else if (retval > 0) {
+      ++producer->num_written;
+      producer->last = sc_MPI_Wtime ();
+    }
+  }
+  pthread_mutex_unlock (&producer->mutex);
+
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+sc_v4l2_producer_t *
+sc_v4l2_producer_new (sc_v4l2_device_t * vd, double fps)
+{
+  int                 b;
+  sc_v4l2_producer_t *producer;
+
+  SC_ASSERT (vd != NULL);
+  SC_ASSERT (vd->fd >= 0);
+  SC_ASSERT (fps >= 0.);
+
+  producer = SC_ALLOC_ZERO (sc_v4l2_producer_t, 1);
+  producer->vd = vd;
+#ifdef SC_ENABLE_V4L2
+  SC_ASSERT (vd->pix != NULL);
+  producer->sizeimage = vd->pix->sizeimage;
+#endif
+  producer->period = fps > 0. ? 1. / fps : 0.;
+  producer->last = -1e100;
+  for (b = 0; b < 3; ++b) {
+    producer->buffers[b] = SC_ALLOC_ZERO (char, producer->sizeimage);
+  }
+  producer->back = 0;
+  producer->latest = 1;
+  producer->front = 2;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_init (&producer->mutex, NULL);
+  pthread_cond_init (&producer->cond, NULL);
+  if (pthread_create (&producer->thread, NULL, sc_v4l2_producer_main,
+                      producer)) {
+    SC_ABORT ("Failed to create v4l2 producer thread");
+  }
+#endif
+  return producer;
+}
+
+char               *
+sc_v4l2_producer_acquire (sc_v4l2_producer_t * producer)
+{
+  SC_ASSERT (producer != NULL);
+
+  /* only the caller swaps the back buffer */
+  return producer->buffers[producer->back];
+}
+
+void
+sc_v4l2_producer_publish (sc_v4l2_producer_t * producer, char *buffer)
+{
+  int                 tmp;
+#ifndef SC_ENABLE_PTHREAD
+  int                 retval;
+#endif
+
+  SC_ASSERT (producer != NULL);
+  SC_ASSERT (buffer == producer->buffers[producer->back]);
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&producer->mutex);
+  tmp = producer->back;
+  producer->back = producer->latest;
+  producer->latest = tmp;
+  if (producer->fresh) {
+    ++producer->num_dropped;
+  }
+  producer->fresh = 1;
+  pthread_cond_signal (&producer->cond);
+  pthread_mutex_unlock (&producer->mutex);
+#else
+  /* write now if the rate and the device allow, otherwise drop */
+  tmp = producer->back;
+  producer->back = producer->latest;
+  producer->latest = tmp;
+  if (sc_MPI_Wtime () < producer->last + producer->period ||
+      (retval = sc_v4l2_producer_output (producer,
+                                         producer->buffers[tmp], 0)) == 0) {
+    ++producer->num_dropped;
+  }
+  else if (retval < 0) {
+    producer->error = 1;
+  }
+  else {
+    ++producer->num_written;
+    producer->last = sc_MPI_Wtime ();
+  }
+#endif
+}
+
+int
+sc_v4l2_producer_destroy (sc_v4l2_producer_t * producer,
+                          unsigned long *num_written,
+                          unsigned long *num_dropped)
+{
+  int                 b, error;
+
+  SC_ASSERT (producer != NULL);
+
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&producer->mutex);
+  producer->stopping = 1;
+  pthread_cond_signal (&producer->cond);
+  pthread_mutex_unlock (&producer->mutex);
+  if (pthread_join (producer->thread, NULL)) {
+    SC_ABORT ("Failed to join v4l2 producer thread");
+  }
+  pthread_cond_destroy (&producer->cond);
+  pthread_mutex_destroy (&producer->mutex);
+#endif
+  if (producer->fresh) {
+    ++producer->num_dropped;
+  }
+
+  if (num_written != NULL) {
+    *num_written = producer->num_written;
+  }
+  if (num_dropped != NULL) {
+    *num_dropped = producer->num_dropped;
+  }
+  error = producer->error;
+  for (b = 0; b < 3; ++b) {
+    SC_FREE (producer->buffers[b]);
+  }
+  SC_FREE (producer);
+  return error ? -1 : 0;
+}
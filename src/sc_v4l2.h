@@ -35,6 +35,64 @@ SC_EXTERN_C_BEGIN;
 
 typedef struct sc_v4l2_device sc_v4l2_device_t;
 
+/** Pixel formats for output supported by this interface. */
+typedef enum
+{
+  SC_V4L2_PIXEL_RGB565,         /**< sRGB packed into 2 bytes */
+  SC_V4L2_PIXEL_YUYV,           /**< 4:2:2 BT.601 luma and chroma,
+                                     2 bytes per pixel, even width */
+  SC_V4L2_PIXEL_LAST            /**< Invalid entry to close list */
+}
+sc_v4l2_pixel_t;
+
+/** A table of 256 colors to map normalized scalar values to. */
+typedef struct sc_v4l2_colormap
+{
+  unsigned char       rgb[256][3];      /**< red, green, blue per entry */
+}
+sc_v4l2_colormap_t;
+
+/** Populate a colormap by interpolating evenly spaced colors.
+ * \param [out] cmap           The table is filled on output.
+ * \param [in] num_points      Number of colors, at least 2 unless \a
+ *                              points is NULL.
+ * \param [in] points          Red, green and blue of each color from the
+ *                              low to the high end of the map.  If NULL,
+ *                              a blue-white-red diverging map is used.
+ */
+void                sc_v4l2_colormap_init (sc_v4l2_colormap_t * cmap,
+                                           int num_points,
+                                           const unsigned char
+                                           (*points)[3]);
+
+/** Convert a scalar field into an image through a colormap.
+ * Values are scaled linearly from [\a vmin, \a vmax] to the colormap and
+ * clamped; NaN maps to the low end.  The conversion goes through a
+ * table of packed pixels precomputed from the colormap, and rows are
+ * distributed to several threads if OpenMP is enabled.
+ * \param [in] pixel           Pixel format of the image.
+ * \param [in] width           Image width, even for YUYV.
+ * \param [in] height          Image height.
+ * \param [in] field           Values of row j start at field + j * stride.
+ * \param [in] stride          Number of floats between rows of \a field.
+ * \param [in] vmin            Value mapped to the first colormap entry.
+ * \param [in] vmax            Value mapped to the last colormap entry.
+ * \param [in] cmap            Valid colormap.
+ * \param [out] image          Pixels of row j start at image +
+ *                              j * \a bytesperline.
+ * \param [in] bytesperline    At least twice the width.
+ * \param [in] num_threads     Maximum number of threads, 1 for serial.
+ */
+void                sc_v4l2_convert_field (sc_v4l2_pixel_t pixel,
+                                           unsigned width, unsigned height,
+                                           const float *field,
+                                           size_t stride,
+                                           float vmin, float vmax,
+                                           const sc_v4l2_colormap_t * cmap,
+                                           char *image,
+                                           unsigned bytesperline,
+                                           int num_threads);
+
 /** Open a video device by special file name.
  * The device is queried but its state is not modified.
  * \param [in] devname      Special file name such as `/dev/video8`.
@@ -113,6 +171,121 @@ int                 sc_v4l2_device_format (sc_v4l2_device_t * vd,
                                            unsigned int *bytesperline,
                                            unsigned int *sizeimage);
 
+/** Set output configuration of device with a choice of pixel format.
+ * This works like \ref sc_v4l2_device_format, which uses RGB 565.
+ * With YUYV, we demand the SMPTE 170M color space and an even width.
+ * \param [in,out] vd   Device must support the desired output format.
+ * \param [in] pixel    Desired pixel format.
+ * \param [in,out] width    Desired width on input, actual width on output.
+ * \param [in,out] height   Desired height on input, actual height on output.
+ * \param [out] bytesperline    Bytes per line on output, including padding.
+ * \param [out] sizeimage       Bytes per image, including padding.
+ * \return          0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_format_ext (sc_v4l2_device_t * vd,
+                                               sc_v4l2_pixel_t pixel,
+                                               unsigned int *width,
+                                               unsigned int *height,
+                                               unsigned int *bytesperline,
+                                               unsigned int *sizeimage);
+
+/** Map a ring of device buffers for streaming output.
+ * This is an alternative to \ref sc_v4l2_device_write that avoids copying
+ * each image: the application renders directly into a device buffer
+ * obtained by \ref sc_v4l2_device_stream_acquire and hands it back by
+ * \ref sc_v4l2_device_stream_queue.  With several buffers, rendering the
+ * next image overlaps with the device consuming the previous ones.
+ * Call after \ref sc_v4l2_device_format and do not mix with write.
+ * \param [in,out] vd          Device must support streaming output.
+ * \param [in,out] num_buffers Desired number of buffers on input, at least
+ *                              1.  The number granted by the driver on
+ *                              output.
+ * \return                     0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_stream_start (sc_v4l2_device_t * vd,
+                                                 unsigned *num_buffers);
+
+/** Obtain a buffer to render the next image into.
+ * If no buffer is available, wait up to \a usec microseconds for the
+ * device to return one that it has finished with.
+ * \param [in,out] vd          Device with streaming started.
+ * \param [in] usec            Number of microseconds to wait at most.
+ * \param [out] buffer         On success, memory of \a sizeimage bytes as
+ *                              returned by \ref sc_v4l2_device_format.
+ *                              NULL on timeout or error.
+ * \return                     -1 on error, 0 on timeout, 1 on success.
+ */
+int                 sc_v4l2_device_stream_acquire (sc_v4l2_device_t * vd,
+                                                   unsigned usec,
+                                                   char **buffer);
+
+/** Hand a rendered buffer to the device for output.
+ * The first call turns on streaming on the device.
+ * \param [in,out] vd          Device with streaming started.
+ * \param [in] buffer          Obtained by \ref sc_v4l2_device_stream_acquire
+ *                              and not used by the caller afterwards.
+ * \return                     0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_stream_queue (sc_v4l2_device_t * vd,
+                                                 char *buffer);
+
+/** Turn off streaming and release all buffers.
+ * This is done by \ref sc_v4l2_device_close if necessary.
+ * \param [in,out] vd          Device with streaming started.
+ * \return                     0 on success, -1 otherwise and setting errno.
+ */
+int                 sc_v4l2_device_stream_stop (sc_v4l2_device_t * vd);
+
+/** A thread that passes the latest published frame to a device.
+ * The simulation renders into a buffer obtained by
+ * \ref sc_v4l2_producer_acquire and publishes it without waiting for the
+ * device.  The thread writes the most recent frame at most at the given
+ * rate; frames published in between are dropped.  Without pthreads,
+ * publishing writes the frame if the device is ready and drops it
+ * otherwise.
+ */
+typedef struct sc_v4l2_producer sc_v4l2_producer_t;
+
+/** Create a producer for a device with its format set.
+ * If streaming has been started on the device, frames are copied into
+ * its buffers; otherwise they are written by write (2).
+ * \param [in,out] vd  Device with format and possibly streaming set.
+ *                      It must not be used otherwise while the producer
+ *                      exists.
+ * \param [in] fps     Maximum frames per second, or 0 for no limit.
+ * \return             Valid producer.
+ */
+sc_v4l2_producer_t *sc_v4l2_producer_new (sc_v4l2_device_t * vd,
+                                          double fps);
+
+/** Obtain the buffer to render the next frame into.
+ * The buffer has \a sizeimage bytes and belongs to the caller until
+ * it is passed to \ref sc_v4l2_producer_publish.  This does not block.
+ * \param [in,out] producer    Valid producer.
+ * \return                     Buffer for the next frame.
+ */
+char               *sc_v4l2_producer_acquire (sc_v4l2_producer_t * producer);
+
+/** Publish a rendered frame, replacing any frame not yet written.
+ * \param [in,out] producer    Valid producer.
+ * \param [in] buffer          Obtained by the last call to
+ *                              \ref sc_v4l2_producer_acquire.
+ */
+void                sc_v4l2_producer_publish (sc_v4l2_producer_t * producer,
+                                              char *buffer);
+
+/** Stop the producer thread and free its buffers.
+ * A frame published but not written yet is dropped.
+ * \param [in,out] producer    Valid producer, destroyed.
+ * \param [out] num_written    If not NULL, the number of frames written.
+ * \param [out] num_dropped    If not NULL, the number of frames dropped.
+ * \return                     0 on success, -1 if writing to the device
+ *                              failed at some point.
+ */
+int                 sc_v4l2_producer_destroy (sc_v4l2_producer_t * producer,
+                                              unsigned long *num_written,
+                                              unsigned long *num_dropped);
+
 SC_EXTERN_C_END;
 
 #endif /* SC_V4L2_H */
@@ -0,0 +1,409 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_vtu.h>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/** The parts of a piece in the order they are written. */
+enum
+{
+  SC_VTU_PART_NONE,
+  SC_VTU_PART_POINTS,
+  SC_VTU_PART_CELLS,
+  SC_VTU_PART_POINTDATA,
+  SC_VTU_PART_CELLDATA
+};
+
+/** A data array as declared in the index file. */
+typedef struct sc_vtu_decl
+{
+  int                 cell_data;
+  sc_vtu_type_t       type;
+  int                 num_components;
+  char               *name;
+}
+sc_vtu_decl_t;
+
+struct sc_vtu
+{
+  sc_MPI_Comm         mpicomm;
+  int                 mpisize, mpirank;
+  sc_vtu_format_t     format;
+  size_t              num_points, num_cells;
+  char                prefix[BUFSIZ];
+  sc_io_sink_t       *sink;
+  int                 part;     /**< the part written last */
+  int                 error;
+  sc_array_t         *appended; /**< raw blocks for the appended format */
+  sc_array_t         *decls;    /**< data arrays, only on the first rank */
+};
+
+static const char  *sc_vtu_type_names[SC_VTU_TYPE_LAST] = {
+  "Int8", "UInt8", "Int32", "UInt32", "Int64", "UInt64", "Float32",
+  "Float64"
+};
+
+static const size_t sc_vtu_type_sizes[SC_VTU_TYPE_LAST] = {
+  1, 1, 4, 4, 8, 8, 4, 8
+};
+
+static int
+sc_vtu_agree (sc_MPI_Comm mpicomm, int error)
+{
+  int                 mpiret;
+  int                 any;
+
+  mpiret = sc_MPI_Allreduce (&error, &any, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return any;
+}
+
+/** Write formatted text to a sink and remember any error. */
+static void
+sc_vtu_printf (sc_io_sink_t * sink, int *error, const char *fmt, ...)
+{
+  int                 n;
+  char                buf[BUFSIZ];
+  va_list             ap;
+
+  va_start (ap, fmt);
+  n = vsnprintf (buf, BUFSIZ, fmt, ap);
+  va_end (ap);
+  if (n < 0 || n >= BUFSIZ) {
+    *error = 1;
+    return;
+  }
+  if (sc_io_sink_write (sink, buf, (size_t) n)) {
+    *error = 1;
+  }
+}
+
+/** Write the opening tag of the file element. */
+static void
+sc_vtu_file_tag (sc_io_sink_t * sink, int *error, const char *type,
+                 sc_vtu_format_t format)
+{
+  const int           one = 1;
+
+  sc_vtu_printf (sink, error, "<?xml version=\"1.0\"?>\n"
+                 "<VTKFile type=\"%s\" version=\"0.1\" "
+                 "byte_order=\"%s\"%s>\n", type,
+                 *(const char *) &one ? "LittleEndian" : "BigEndian",
+                 format == SC_VTU_FORMAT_COMPRESSED ?
+                 " compressor=\"vtkZLibDataCompressor\"" : "");
+}
+
+sc_vtu_t           *
+sc_vtu_open (sc_MPI_Comm mpicomm, const char *prefix,
+             sc_vtu_format_t format, size_t num_points, size_t num_cells)
+{
+  int                 mpiret;
+  int                 error;
+  char                filename[BUFSIZ];
+  sc_vtu_t           *vtu;
+
+  SC_ASSERT (0 <= format && format < SC_VTU_FORMAT_LAST);
+
+  vtu = SC_ALLOC_ZERO (sc_vtu_t, 1);
+  vtu->mpicomm = mpicomm;
+  mpiret = sc_MPI_Comm_size (mpicomm, &vtu->mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &vtu->mpirank);
+  SC_CHECK_MPI (mpiret);
+  vtu->format = format;
+  vtu->num_points = num_points;
+  vtu->num_cells = num_cells;
+
+  /* open the file of the local piece */
+  error = snprintf (vtu->prefix, BUFSIZ, "%s", prefix) >= BUFSIZ ||
+    snprintf (filename, BUFSIZ, "%s_%04d.vtu", prefix, vtu->mpirank) >=
+    BUFSIZ;
+#ifndef SC_HAVE_ZLIB
+  error = error || format == SC_VTU_FORMAT_COMPRESSED;
+#endif
+  if (!error) {
+    vtu->sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                                SC_IO_ENCODE_NONE, filename);
+    error = vtu->sink == NULL;
+  }
+  if (sc_vtu_agree (mpicomm, error)) {
+    if (vtu->sink != NULL) {
+      (void) sc_io_sink_destroy (vtu->sink);
+    }
+    SC_FREE (vtu);
+    return NULL;
+  }
+
+  sc_vtu_file_tag (vtu->sink, &vtu->error, "UnstructuredGrid", format);
+  sc_vtu_printf (vtu->sink, &vtu->error, "  <UnstructuredGrid>\n"
+                 "    <Piece NumberOfPoints=\"%llu\" "
+                 "NumberOfCells=\"%llu\">\n",
+                 (unsigned long long) num_points,
+                 (unsigned long long) num_cells);
+  if (format == SC_VTU_FORMAT_APPENDED) {
+    vtu->appended = sc_array_new (sizeof (char));
+  }
+  if (vtu->mpirank == 0) {
+    vtu->decls = sc_array_new (sizeof (sc_vtu_decl_t));
+  }
+  return vtu;
+}
+
+/** Close the current part and open the next one.
+ * \return          0 on success, nonzero if the parts are out of order.
+ */
+static int
+sc_vtu_enter (sc_vtu_t * vtu, int part)
+{
+  static const char  *tags[] = { NULL, "Points", "Cells", "PointData",
+    "CellData"
+  };
+
+  /* points and cells are written once, then the data arrays */
+  if (part <= SC_VTU_PART_CELLS ? vtu->part != part - 1 :
+      vtu->part < SC_VTU_PART_CELLS || part < vtu->part) {
+    return -1;
+  }
+  if (part == vtu->part) {
+    return 0;
+  }
+  if (vtu->part >= SC_VTU_PART_POINTDATA) {
+    sc_vtu_printf (vtu->sink, &vtu->error, "      </%s>\n",
+                   tags[vtu->part]);
+  }
+  vtu->part = part;
+  sc_vtu_printf (vtu->sink, &vtu->error, "      <%s>\n", tags[part]);
+  return 0;
+}
+
+/** Write one data array element and its data. */
+static void
+sc_vtu_array (sc_vtu_t * vtu, const char *name, sc_vtu_type_t type,
+              int num_components, const void *data, size_t num_tuples)
+{
+  size_t              bytes, pos;
+  uint32_t            header;
+
+  bytes = num_tuples * (size_t) num_components * sc_vtu_type_sizes[type];
+  if (bytes > (size_t) UINT32_MAX) {
+    /* the VTK format uses a 32-bit header */
+    vtu->error = 1;
+    return;
+  }
+  sc_vtu_printf (vtu->sink, &vtu->error, "        <DataArray type=\"%s\" "
+                 "Name=\"%s\" NumberOfComponents=\"%d\" ",
+                 sc_vtu_type_names[type], name, num_components);
+
+  if (vtu->format == SC_VTU_FORMAT_APPENDED) {
+    /* the data follows the XML and is referenced by its offset */
+    pos = vtu->appended->elem_count;
+    sc_vtu_printf (vtu->sink, &vtu->error,
+                   "format=\"appended\" offset=\"%llu\"/>\n",
+                   (unsigned long long) pos);
+    header = (uint32_t) bytes;
+    sc_array_resize (vtu->appended, pos + sizeof (header) + bytes);
+    memcpy (vtu->appended->array + pos, &header, sizeof (header));
+    if (bytes > 0) {
+      memcpy (vtu->appended->array + pos + sizeof (header), data, bytes);
+    }
+    return;
+  }
+
+  sc_vtu_printf (vtu->sink, &vtu->error, "format=\"binary\">\n"
+                 "          ");
+  if (vtu->format == SC_VTU_FORMAT_BINARY) {
+    vtu->error |= sc_vtk_write_binary_sink (vtu->sink, (const char *) data,
+                                            bytes) != 0;
+  }
+  else {
+#ifdef SC_HAVE_ZLIB
+    vtu->error |= sc_vtk_write_compressed_sink (vtu->sink,
+                                                (const char *) data, bytes,
+                                                Z_DEFAULT_COMPRESSION,
+                                                0) != 0;
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+  }
+  sc_vtu_printf (vtu->sink, &vtu->error, "\n        </DataArray>\n");
+}
+
+int
+sc_vtu_write_points (sc_vtu_t * vtu, const double *xyz)
+{
+  SC_ASSERT (vtu != NULL);
+
+  if (sc_vtu_enter (vtu, SC_VTU_PART_POINTS)) {
+    return -1;
+  }
+  sc_vtu_array (vtu, "Position", SC_VTU_FLOAT64, 3, xyz, vtu->num_points);
+  sc_vtu_printf (vtu->sink, &vtu->error, "      </Points>\n");
+  return vtu->error ? -1 : 0;
+}
+
+int
+sc_vtu_write_cells (sc_vtu_t * vtu, const int64_t * connectivity,
+                    const int64_t * offsets, const uint8_t * types)
+{
+  size_t              num_connect;
+
+  SC_ASSERT (vtu != NULL);
+
+  if (sc_vtu_enter (vtu, SC_VTU_PART_CELLS)) {
+    return -1;
+  }
+  num_connect = vtu->num_cells > 0 ?
+    (size_t) offsets[vtu->num_cells - 1] : 0;
+  sc_vtu_array (vtu, "connectivity", SC_VTU_INT64, 1, connectivity,
+                num_connect);
+  sc_vtu_array (vtu, "offsets", SC_VTU_INT64, 1, offsets, vtu->num_cells);
+  sc_vtu_array (vtu, "types", SC_VTU_UINT8, 1, types, vtu->num_cells);
+  sc_vtu_printf (vtu->sink, &vtu->error, "      </Cells>\n");
+  return vtu->error ? -1 : 0;
+}
+
+int
+sc_vtu_write_data (sc_vtu_t * vtu, int cell_data, const char *name,
+                   sc_vtu_type_t type, int num_components, const void *data)
+{
+  sc_vtu_decl_t      *decl;
+
+  SC_ASSERT (vtu != NULL && name != NULL);
+  SC_ASSERT (0 <= type && type < SC_VTU_TYPE_LAST);
+  SC_ASSERT (num_components > 0);
+
+  if (sc_vtu_enter (vtu, cell_data ? SC_VTU_PART_CELLDATA :
+                    SC_VTU_PART_POINTDATA)) {
+    return -1;
+  }
+  sc_vtu_array (vtu, name, type, num_components, data,
+                cell_data ? vtu->num_cells : vtu->num_points);
+
+  /* the first rank declares the array in the index file */
+  if (vtu->decls != NULL) {
+    decl = (sc_vtu_decl_t *) sc_array_push (vtu->decls);
+    decl->cell_data = cell_data;
+    decl->type = type;
+    decl->num_components = num_components;
+    decl->name = SC_STRDUP (name);
+  }
+  return vtu->error ? -1 : 0;
+}
+
+/** Write the index file on the first rank. */
+static int
+sc_vtu_write_pvtu (sc_vtu_t * vtu)
+{
+  int                 error = 0;
+  int                 q, cell_data;
+  char                filename[BUFSIZ];
+  const char         *base;
+  size_t              zz;
+  sc_vtu_decl_t      *decl;
+  sc_io_sink_t       *sink;
+
+  if (snprintf (filename, BUFSIZ, "%s.pvtu", vtu->prefix) >= BUFSIZ ||
+      (sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                              SC_IO_ENCODE_NONE, filename)) == NULL) {
+    return -1;
+  }
+
+  sc_vtu_file_tag (sink, &error, "PUnstructuredGrid", vtu->format);
+  sc_vtu_printf (sink, &error, "  <PUnstructuredGrid GhostLevel=\"0\">\n");
+  for (cell_data = 0; cell_data < 2; ++cell_data) {
+    sc_vtu_printf (sink, &error, "    <%s>\n",
+                   cell_data ? "PCellData" : "PPointData");
+    for (zz = 0; zz < vtu->decls->elem_count; ++zz) {
+      decl = (sc_vtu_decl_t *) sc_array_index (vtu->decls, zz);
+      if (decl->cell_data == cell_data) {
+        sc_vtu_printf (sink, &error, "      <PDataArray type=\"%s\" "
+                       "Name=\"%s\" NumberOfComponents=\"%d\"/>\n",
+                       sc_vtu_type_names[decl->type], decl->name,
+                       decl->num_components);
+      }
+    }
+    sc_vtu_printf (sink, &error, "    </%s>\n",
+                   cell_data ? "PCellData" : "PPointData");
+  }
+  sc_vtu_printf (sink, &error, "    <PPoints>\n"
+                 "      <PDataArray type=\"Float64\" Name=\"Position\" "
+                 "NumberOfComponents=\"3\"/>\n    </PPoints>\n");
+
+  /* the pieces are found relative to the index file */
+  base = strrchr (vtu->prefix, '/');
+  base = base != NULL ? base + 1 : vtu->prefix;
+  for (q = 0; q < vtu->mpisize; ++q) {
+    sc_vtu_printf (sink, &error, "    <Piece Source=\"%s_%04d.vtu\"/>\n",
+                   base, q);
+  }
+  sc_vtu_printf (sink, &error, "  </PUnstructuredGrid>\n</VTKFile>\n");
+
+  return sc_io_sink_destroy (sink) || error ? -1 : 0;
+}
+
+int
+sc_vtu_close (sc_vtu_t * vtu)
+{
+  int                 error;
+  size_t              zz;
+
+  SC_ASSERT (vtu != NULL);
+
+  /* a piece requires points and cells */
+  if (vtu->part < SC_VTU_PART_CELLS) {
+    vtu->error = 1;
+  }
+  if (vtu->part >= SC_VTU_PART_POINTDATA) {
+    sc_vtu_printf (vtu->sink, &vtu->error, "      </%s>\n",
+                   vtu->part == SC_VTU_PART_POINTDATA ?
+                   "PointData" : "CellData");
+  }
+  sc_vtu_printf (vtu->sink, &vtu->error, "    </Piece>\n"
+                 "  </UnstructuredGrid>\n");
+  if (vtu->appended != NULL) {
+    sc_vtu_printf (vtu->sink, &vtu->error,
+                   "  <AppendedData encoding=\"raw\">\n_");
+    vtu->error |= sc_io_sink_write (vtu->sink, vtu->appended->array,
+                                    vtu->appended->elem_count) != 0;
+    sc_vtu_printf (vtu->sink, &vtu->error, "\n  </AppendedData>\n");
+    sc_array_destroy (vtu->appended);
+  }
+  sc_vtu_printf (vtu->sink, &vtu->error, "</VTKFile>\n");
+  error = sc_io_sink_destroy (vtu->sink) || vtu->error;
+
+  if (vtu->decls != NULL) {
+    error = sc_vtu_write_pvtu (vtu) || error;
+    for (zz = 0; zz < vtu->decls->elem_count; ++zz) {
+      SC_FREE (((sc_vtu_decl_t *) sc_array_index (vtu->decls, zz))->name);
+    }
+    sc_array_destroy (vtu->decls);
+  }
+  error = sc_vtu_agree (vtu->mpicomm, error);
+  SC_FREE (vtu);
+
+  return error ? -1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#ifndef SC_VTU_H
+#define SC_VTU_H
+
+/** \file sc_vtu.h
+ * Write a partitioned unstructured grid in the VTK XML format.
+ *
+ * Each rank writes its piece to the file prefix_rrrr.vtu through an
+ * \ref sc_io_sink_t, and the first rank writes the index prefix.pvtu that
+ * lists all pieces and the data arrays.  The arrays are written in one of
+ * the formats of \ref sc_vtu_format_t.
+ *
+ * A piece is written by the calls \ref sc_vtu_write_points, then
+ * \ref sc_vtu_write_cells, then any number of \ref sc_vtu_write_data for
+ * point data followed by any number for cell data, and finally
+ * \ref sc_vtu_close.  All ranks must write the same data arrays.
+ */
+
+#include <sc_io.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The encoding of the data arrays. */
+typedef enum sc_vtu_format
+{
+  SC_VTU_FORMAT_BINARY, /**< Inline base64 code. */
+  SC_VTU_FORMAT_COMPRESSED,     /**< Inline base64 code of zlib blocks;
+                                     requires zlib. */
+  SC_VTU_FORMAT_APPENDED,       /**< Raw bytes appended to the file, which
+                                     avoids the size and time overhead of
+                                     base64.  The arrays are held in memory
+                                     until the piece is closed. */
+  SC_VTU_FORMAT_LAST    /**< Invalid entry to close list */
+}
+sc_vtu_format_t;
+
+/** The numeric type of a data array. */
+typedef enum sc_vtu_type
+{
+  SC_VTU_INT8,
+  SC_VTU_UINT8,
+  SC_VTU_INT32,
+  SC_VTU_UINT32,
+  SC_VTU_INT64,
+  SC_VTU_UINT64,
+  SC_VTU_FLOAT32,
+  SC_VTU_FLOAT64,
+  SC_VTU_TYPE_LAST      /**< Invalid entry to close list */
+}
+sc_vtu_type_t;
+
+/** An opaque piece of a partitioned unstructured grid file. */
+typedef struct sc_vtu sc_vtu_t;
+
+/** Begin writing the pieces of a partitioned file.
+ * This function is collective.
+ * \param [in] mpicomm      Each rank of this communicator writes a piece.
+ * \param [in] prefix       Path of the files without suffix.
+ * \param [in] format       Encoding of the data arrays.
+ * \param [in] num_points   Number of points of the local piece.
+ * \param [in] num_cells    Number of cells of the local piece.
+ * \return                  The piece to write, or NULL if any rank failed
+ *                          to open its file or the format is unavailable.
+ */
+sc_vtu_t           *sc_vtu_open (sc_MPI_Comm mpicomm, const char *prefix,
+                                 sc_vtu_format_t format,
+                                 size_t num_points, size_t num_cells);
+
+/** Write the coordinates of the points.
+ * \param [in,out] vtu      Piece that has no points or cells yet.
+ * \param [in] xyz          Array of 3 * num_points coordinates.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_vtu_write_points (sc_vtu_t * vtu, const double *xyz);
+
+/** Write the cells.
+ * \param [in,out] vtu      Piece that has points but no cells yet.
+ * \param [in] connectivity Point numbers of all cells, one after another.
+ * \param [in] offsets      Array of num_cells end positions of each cell
+ *                          in \a connectivity.
+ * \param [in] types        Array of num_cells VTK cell types.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_vtu_write_cells (sc_vtu_t * vtu,
+                                        const int64_t * connectivity,
+                                        const int64_t * offsets,
+                                        const uint8_t * types);
+
+/** Write an array of point or cell data.
+ * Point data must be written before cell data.
+ * \param [in,out] vtu      Piece that has points and cells.
+ * \param [in] cell_data    False for point data, true for cell data.
+ * \param [in] name         Name of the array.
+ * \param [in] type         Numeric type of the array.
+ * \param [in] num_components   Number of values per point or cell.
+ * \param [in] data         Array of num_components values per point
+ *                          or cell.
+ * \return                  0 on success, nonzero on error.
+ */
+int                 sc_vtu_write_data (sc_vtu_t * vtu, int cell_data,
+                                       const char *name, sc_vtu_type_t type,
+                                       int num_components, const void *data);
+
+/** Finish the pieces and write the index file.
+ * This function is collective.
+ * \param [in] vtu          The piece is closed and its memory freed.
+ * \return                  0 on success, nonzero on error on any rank.
+ */
+int                 sc_vtu_close (sc_vtu_t * vtu);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_VTU_H */
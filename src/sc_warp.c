@@ -21,6 +21,7 @@
   02110-1301, USA.
 */
 
+#include <sc_containers.h>
 #include <sc_warp.h>
 
 sc_warp_interval_t *
@@ -220,3 +221,353 @@ sc_warp_print (int package_id, int log_priority, sc_warp_interval_t * root)
     sc_warp_print (package_id, log_priority, root->right);
   }
 }
+
+/** One node of the flat warp tree. */
+typedef struct sc_warp_node
+{
+  int                 level;    /**< level of root is 0 */
+  int                 left;     /**< index of left child or -1 for a leaf;
+                                     the right child follows it */
+  double              r_low, r_high;    /**< interval coordinates */
+}
+sc_warp_node_t;
+
+/** Pending work of the non-recursive tree update. */
+typedef struct sc_warp_frame
+{
+  int                 node;
+  int                 start, end;
+  int                 rem_levels;
+}
+sc_warp_frame_t;
+
+struct sc_warp_tree
+{
+  sc_array_t         *nodes;    /**< root is node 0 */
+  sc_array_t         *leaves;   /**< node index of each leaf, sorted */
+  sc_array_t         *bounds;   /**< leaf boundaries, one more than leaves */
+  sc_array_t         *stack;    /**< work space for traversals */
+};
+
+static inline sc_warp_node_t *
+sc_warp_tree_node (sc_warp_tree_t * tree, int n)
+{
+  return (sc_warp_node_t *) sc_array_index_int (tree->nodes, n);
+}
+
+/* rebuild the cached leaf list and boundaries in left-to-right order */
+static void
+sc_warp_tree_leaves (sc_warp_tree_t * tree)
+{
+  int                 n;
+  sc_warp_node_t     *node;
+  sc_warp_frame_t    *f;
+
+  sc_array_truncate (tree->leaves);
+  sc_array_truncate (tree->bounds);
+
+  /* only the node member of the frames is used here */
+  f = (sc_warp_frame_t *) sc_array_push (tree->stack);
+  f->node = 0;
+  while (tree->stack->elem_count > 0) {
+    n = ((sc_warp_frame_t *) sc_array_pop (tree->stack))->node;
+    node = sc_warp_tree_node (tree, n);
+    if (node->left >= 0) {
+      /* right child is pushed first to be processed last */
+      f = (sc_warp_frame_t *) sc_array_push_count (tree->stack, 2);
+      f[0].node = node->left + 1;
+      f[1].node = node->left;
+    }
+    else {
+      *(int *) sc_array_push (tree->leaves) = n;
+      *(double *) sc_array_push (tree->bounds) = node->r_low;
+    }
+  }
+  *(double *) sc_array_push (tree->bounds) =
+    sc_warp_tree_node (tree, 0)->r_high;
+}
+
+sc_warp_tree_t *
+sc_warp_tree_new (double r_low, double r_high)
+{
+  sc_warp_tree_t     *tree;
+  sc_warp_node_t     *root;
+
+  SC_ASSERT (r_low <= r_high);
+
+  tree = SC_ALLOC (sc_warp_tree_t, 1);
+  tree->nodes = sc_array_new (sizeof (sc_warp_node_t));
+  tree->leaves = sc_array_new (sizeof (int));
+  tree->bounds = sc_array_new (sizeof (double));
+  tree->stack = sc_array_new (sizeof (sc_warp_frame_t));
+
+  root = (sc_warp_node_t *) sc_array_push (tree->nodes);
+  root->level = 0;
+  root->left = -1;
+  root->r_low = r_low;
+  root->r_high = r_high;
+  sc_warp_tree_leaves (tree);
+
+  return tree;
+}
+
+void
+sc_warp_tree_destroy (sc_warp_tree_t * tree)
+{
+  sc_array_destroy (tree->nodes);
+  sc_array_destroy (tree->leaves);
+  sc_array_destroy (tree->bounds);
+  sc_array_destroy (tree->stack);
+  SC_FREE (tree);
+}
+
+/* process one node of the update sweep, the counterpart of
+ * sc_warp_update_interval; pushes the work for the children */
+static void
+sc_warp_tree_update_node (sc_warp_tree_t * tree, sc_warp_frame_t * f,
+                          const double *r_points, double r_tol)
+{
+  int                 start, end, n;
+  int                 i_low, i_high, i_guess, i_best;
+  int                 i_left_end, i_right_start;
+  double              r, r_best, r_dist, r_sign, r_mid;
+  sc_warp_node_t     *iv, *left, *right;
+  sc_warp_frame_t    *g;
+
+  n = f->node;
+  start = f->start;
+  end = f->end;
+  iv = sc_warp_tree_node (tree, n);
+
+  SC_ASSERT (0 <= start && start < end);
+  SC_ASSERT (r_points[start] >= iv->r_low);
+  SC_ASSERT (r_points[end - 1] <= iv->r_high);
+
+  while (start < end && r_points[start] <= iv->r_low)
+    ++start;
+  while (start < end && r_points[end - 1] >= iv->r_high)
+    --end;
+  if (start >= end || f->rem_levels == 0) {
+    return;
+  }
+
+  if (iv->left >= 0) {
+    /* find highest point with r < r_mid, which need not exist */
+    r_mid = sc_warp_tree_node (tree, iv->left)->r_high;
+    i_low = start;
+    i_high = end - 1;
+    while (i_low < i_high) {
+      i_guess = (i_low + i_high + 1) / 2;
+      r = r_points[i_guess];
+      if (r < r_mid) {
+        i_low = i_guess;
+      }
+      else {
+        i_high = i_guess - 1;
+      }
+    }
+    SC_ASSERT (i_low == i_high);
+    if (r_points[i_low] >= r_mid) {
+      /* left interval is empty */
+      i_left_end = start;
+    }
+    else {
+      i_left_end = i_low + 1;
+    }
+    while (i_high < end && r_points[i_high] <= r_mid) {
+      ++i_high;
+    }
+    i_right_start = i_high;
+  }
+  else {
+    /* find closest point to mid-interval */
+    r_sign = iv->r_high - iv->r_low;
+    r_best = r_mid = .5 * (iv->r_low + iv->r_high);
+    i_low = start;
+    i_high = end - 1;
+    i_guess = i_best = -1;
+    while (i_low <= i_high) {
+      i_guess = (i_low + i_high + 1) / 2;
+      r = r_points[i_guess];
+      r_dist = r - r_mid;
+      if (fabs (r_dist) < fabs (r_sign)) {
+        r_sign = r_dist;
+        r_best = r;
+        i_best = i_guess;
+      }
+      if (r_dist < 0.) {
+        i_low = i_guess + 1;
+      }
+      else if (r_dist > 0.) {
+        i_high = i_guess - 1;
+      }
+      else
+        break;
+    }
+    SC_ASSERT (i_best >= start && i_best < end);
+
+    /* both children are allocated next to each other */
+    r_dist = r_tol * (iv->r_high - iv->r_low);
+    if (fabs (r_sign) < r_dist) {
+      i_left_end = i_best;
+      i_right_start = i_best + 1;
+    }
+    else {
+      r_best = r_mid;
+      i_left_end = i_right_start = (r_sign < 0 ? i_best + 1 : i_best);
+    }
+    iv->left = (int) tree->nodes->elem_count;
+    left = (sc_warp_node_t *) sc_array_push_count (tree->nodes, 2);
+    right = left + 1;
+    iv = sc_warp_tree_node (tree, n);
+    left->level = right->level = iv->level + 1;
+    left->left = right->left = -1;
+    left->r_low = iv->r_low;
+    left->r_high = right->r_low = r_best;
+    right->r_high = iv->r_high;
+  }
+
+  /* the left child is pushed last to be processed first */
+  if (i_right_start < end) {
+    g = (sc_warp_frame_t *) sc_array_push (tree->stack);
+    g->node = iv->left + 1;
+    g->start = i_right_start;
+    g->end = end;
+    g->rem_levels = f->rem_levels - 1;
+  }
+  if (start < i_left_end) {
+    g = (sc_warp_frame_t *) sc_array_push (tree->stack);
+    g->node = iv->left;
+    g->start = start;
+    g->end = i_left_end;
+    g->rem_levels = f->rem_levels - 1;
+  }
+}
+
+void
+sc_warp_tree_update (sc_warp_tree_t * tree, int num_points,
+                     const double *r_points, double r_tol, int max_level)
+{
+  sc_warp_frame_t     f;
+
+  if (num_points <= 0)
+    return;
+
+  SC_ASSERT (r_points != NULL);
+  SC_ASSERT (0 <= r_tol && r_tol <= 1.);
+
+  SC_ASSERT (tree->stack->elem_count == 0);
+  f.node = 0;
+  f.start = 0;
+  f.end = num_points;
+  f.rem_levels = max_level;
+  *(sc_warp_frame_t *) sc_array_push (tree->stack) = f;
+  while (tree->stack->elem_count > 0) {
+    f = *(sc_warp_frame_t *) sc_array_pop (tree->stack);
+    sc_warp_tree_update_node (tree, &f, r_points, r_tol);
+  }
+  sc_warp_tree_leaves (tree);
+}
+
+int
+sc_warp_tree_num_leaves (sc_warp_tree_t * tree)
+{
+  return (int) tree->leaves->elem_count;
+}
+
+void
+sc_warp_tree_leaf (sc_warp_tree_t * tree, int leaf,
+                   int *level, double *r_low, double *r_high)
+{
+  sc_warp_node_t     *node;
+
+  SC_ASSERT (0 <= leaf && leaf < sc_warp_tree_num_leaves (tree));
+
+  node = sc_warp_tree_node
+    (tree, *(int *) sc_array_index_int (tree->leaves, leaf));
+  if (level != NULL)
+    *level = node->level;
+  if (r_low != NULL)
+    *r_low = node->r_low;
+  if (r_high != NULL)
+    *r_high = node->r_high;
+}
+
+/* return the largest i in [lo, hi] with bounds[i] <= r, given
+ * bounds[lo] <= r, or lo if there is none */
+static inline int
+sc_warp_tree_search (const double *bounds, int lo, int hi, double r)
+{
+  int                 guess;
+
+  while (lo < hi) {
+    guess = (lo + hi + 1) / 2;
+    if (bounds[guess] <= r) {
+      lo = guess;
+    }
+    else {
+      hi = guess - 1;
+    }
+  }
+  return lo;
+}
+
+void
+sc_warp_tree_locate (sc_warp_tree_t * tree, size_t num_points,
+                     const double *r_points, int *leaves)
+{
+  int                 last, prev, step, hi;
+  size_t              iz;
+  double              r;
+  const double       *bounds;
+
+  SC_ASSERT (num_points == 0 || (r_points != NULL && leaves != NULL));
+
+  bounds = (const double *) tree->bounds->array;
+  last = sc_warp_tree_num_leaves (tree) - 1;
+  prev = 0;
+  for (iz = 0; iz < num_points; ++iz) {
+    r = r_points[iz];
+    if (r < bounds[prev]) {
+      /* search to the left of the previous result */
+      prev = r <= bounds[0] ? 0 : sc_warp_tree_search (bounds, 0, prev, r);
+    }
+    else {
+      /* gallop to the right of the previous result */
+      for (step = 1, hi = prev + 1; hi <= last && bounds[hi] <= r;
+           step *= 2, hi = prev + step) {
+        prev = hi;
+      }
+      prev = sc_warp_tree_search (bounds, prev, SC_MIN (hi, last + 1) - 1,
+                                  r);
+    }
+    leaves[iz] = prev;
+  }
+}
+
+void
+sc_warp_tree_write (sc_warp_tree_t * tree, FILE * nout)
+{
+  int                 i, level;
+  double              r_low, r_high;
+
+  for (i = 0; i < sc_warp_tree_num_leaves (tree); ++i) {
+    sc_warp_tree_leaf (tree, i, &level, &r_low, &r_high);
+    fprintf (nout, "Warp interval level %d [%g %g] length %g\n",
+             level, r_low, r_high, r_high - r_low);
+  }
+}
+
+void
+sc_warp_tree_print (int package_id, int log_priority, sc_warp_tree_t * tree)
+{
+  int                 i, level;
+  double              r_low, r_high;
+
+  for (i = 0; i < sc_warp_tree_num_leaves (tree); ++i) {
+    sc_warp_tree_leaf (tree, i, &level, &r_low, &r_high);
+    SC_GEN_LOGF (package_id, SC_LC_GLOBAL, log_priority,
+                 "Warp interval level %d [%g %g] length %g\n",
+                 level, r_low, r_high, r_high - r_low);
+  }
+}
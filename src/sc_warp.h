@@ -52,6 +52,75 @@ void                sc_warp_print (int package_id, int log_priority,
                                    sc_warp_interval_t * root);
 void                sc_warp_write (sc_warp_interval_t * root, FILE * nout);
 
+/** Opaque warp tree stored in one contiguous array of nodes.
+ * It refines the same way as the pointer-linked \ref sc_warp_interval_t
+ * tree, but nodes refer to their children by array index, the two
+ * children of a node are adjacent in memory, and the sorted leaf
+ * boundaries are cached for fast batch lookups.
+ */
+typedef struct sc_warp_tree sc_warp_tree_t;
+
+/** Create a flat warp tree consisting of a single interval.
+ * \param [in] r_low            Left end of the root interval.
+ * \param [in] r_high           Right end, must not be less than \a r_low.
+ * \return                      Tree to be freed by \ref sc_warp_tree_destroy.
+ */
+sc_warp_tree_t     *sc_warp_tree_new (double r_low, double r_high);
+
+/** Free all memory of a flat warp tree. */
+void                sc_warp_tree_destroy (sc_warp_tree_t * tree);
+
+/** Refine the tree as necessary to accommodate a sorted set of points.
+ * The refinement is identical to \ref sc_warp_update.  The whole point
+ * set is processed in one sweep over the tree without recursion.
+ * \param [in,out] tree         The tree to refine.
+ * \param [in] num_points       Number of new points to integrate.
+ * \param [in] r_points         The new points need to be sorted.
+ * \param [in] r_tol            Relative tolerance for matching a point.
+ * \param [in] max_level        Maximum number of levels added.
+ */
+void                sc_warp_tree_update (sc_warp_tree_t * tree,
+                                         int num_points,
+                                         const double *r_points,
+                                         double r_tol, int max_level);
+
+/** Return the number of leaf intervals of the tree. */
+int                 sc_warp_tree_num_leaves (sc_warp_tree_t * tree);
+
+/** Query one leaf interval in left-to-right order.
+ * \param [in] tree             The tree to query.
+ * \param [in] leaf             Leaf number in [0, number of leaves).
+ * \param [out] level           If not NULL, the level of the leaf.
+ * \param [out] r_low           If not NULL, the left end of the leaf.
+ * \param [out] r_high          If not NULL, the right end of the leaf.
+ */
+void                sc_warp_tree_leaf (sc_warp_tree_t * tree, int leaf,
+                                       int *level, double *r_low,
+                                       double *r_high);
+
+/** Map many coordinates to the leaf intervals containing them.
+ * Leaf i contains the coordinates in [r_low, r_high) of that leaf, while
+ * the last leaf also contains its right end.  Coordinates outside of the
+ * root interval are clamped to the first or last leaf.  The points need
+ * not be sorted, but sorted or clustered input is located fastest, since
+ * each search starts from the result for the previous point.
+ * \param [in] tree             The tree to query.
+ * \param [in] num_points       Number of coordinates.
+ * \param [in] r_points         Array of \a num_points coordinates.
+ * \param [out] leaves          Array of \a num_points leaf numbers.
+ */
+void                sc_warp_tree_locate (sc_warp_tree_t * tree,
+                                         size_t num_points,
+                                         const double *r_points,
+                                         int *leaves);
+
+/** Print the leaf intervals of a flat tree to a log category. */
+void                sc_warp_tree_print (int package_id, int log_priority,
+                                        sc_warp_tree_t * tree);
+
+/** Write the leaf intervals of a flat tree to a stream. */
+void                sc_warp_tree_write (sc_warp_tree_t * tree, FILE * nout);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_WARP_H */
@@ -23,6 +23,114 @@
 
 #include <sc_allgather.h>
 
+/* layout where rank p contributes p % 4 ints, stored in reverse rank order
+   with a gap of one int after each block */
+static void
+test_allgatherv_layout (int mpisize, int *counts, int *displs,
+                        size_t *sizes, size_t *offsets)
+{
+  int                 p, offset;
+
+  for (offset = 0, p = mpisize - 1; p >= 0; --p) {
+    counts[p] = p % 4;
+    displs[p] = offset;
+    sizes[p] = counts[p] * sizeof (int);
+    offsets[p] = displs[p] * sizeof (int);
+    offset += counts[p] + 1;
+  }
+}
+
+/* fill our own block or all blocks with their expected values */
+static void
+test_allgatherv_fill (int *vdata, int *counts, int *displs,
+                      int mpisize, int mpirank)
+{
+  int                 p, j;
+
+  for (p = 0; p < mpisize; ++p) {
+    for (j = 0; j < counts[p]; ++j) {
+      vdata[displs[p] + j] = (p == mpirank || mpirank < 0) ?
+        100 * p + j : -1;
+    }
+  }
+}
+
+static void
+test_allgatherv_check (int *vdata, int *counts, int *displs, int mpisize)
+{
+  int                 p, j;
+
+  for (p = 0; p < mpisize; ++p) {
+    for (j = 0; j < counts[p]; ++j) {
+      SC_CHECK_ABORT (vdata[displs[p] + j] == 100 * p + j,
+                      "allgatherv mismatch");
+    }
+  }
+}
+
+static void
+test_allgatherv (sc_MPI_Comm mpicomm, int mpisize, int mpirank)
+{
+  int                 mpiret;
+  int                 p, count;
+  int                *counts, *displs, *vdata, *vsend, *vrecv;
+  size_t             *sizes, *offsets;
+
+  counts = SC_ALLOC (int, 2 * mpisize + 1);
+  displs = counts + mpisize;
+  sizes = SC_ALLOC (size_t, 2 * mpisize);
+  offsets = sizes + mpisize;
+  test_allgatherv_layout (mpisize, counts, displs, sizes, offsets);
+  vdata = SC_ALLOC (int, displs[0] + counts[0] + 1);
+  vsend = SC_ALLOC (int, 3);
+
+  if (mpisize <= 64) {
+    SC_GLOBAL_INFO ("Testing sc_allgatherv_alltoall\n");
+    test_allgatherv_fill (vdata, counts, displs, mpisize, mpirank);
+    sc_allgatherv_alltoall (mpicomm, (char *) vdata, sizes, offsets,
+                            mpisize, mpirank);
+    test_allgatherv_check (vdata, counts, displs, mpisize);
+  }
+
+  SC_GLOBAL_INFO ("Testing sc_allgatherv_bruck\n");
+  test_allgatherv_fill (vdata, counts, displs, mpisize, mpirank);
+  sc_allgatherv_bruck (mpicomm, (char *) vdata, sizes, offsets,
+                       mpisize, mpirank);
+  test_allgatherv_check (vdata, counts, displs, mpisize);
+
+  SC_GLOBAL_INFO ("Testing sc_allgatherv_ring\n");
+  test_allgatherv_fill (vdata, counts, displs, mpisize, mpirank);
+  sc_allgatherv_ring (mpicomm, (char *) vdata, sizes, offsets,
+                      mpisize, mpirank);
+  test_allgatherv_check (vdata, counts, displs, mpisize);
+
+  SC_GLOBAL_INFO ("Testing sc_allgatherv and sc_allgatherv_alloc\n");
+  test_allgatherv_fill (vdata, counts, displs, mpisize, -1);
+  memcpy (vsend, vdata + displs[mpirank], counts[mpirank] * sizeof (int));
+  test_allgatherv_fill (vdata, counts, displs, mpisize, mpisize);
+  mpiret = sc_allgatherv (vsend, counts[mpirank], sc_MPI_INT, vdata, counts,
+                          displs, sc_MPI_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  test_allgatherv_check (vdata, counts, displs, mpisize);
+
+  /* the allocating variant packs the blocks in rank order */
+  vrecv = (int *) sc_allgatherv_alloc (vsend, counts[mpirank], sc_MPI_INT,
+                                       counts, displs, mpicomm);
+  for (count = 0, p = 0; p < mpisize; ++p) {
+    SC_CHECK_ABORT (counts[p] == p % 4 && displs[p] == count,
+                    "allgatherv counts mismatch");
+    count += counts[p];
+  }
+  SC_CHECK_ABORT (displs[mpisize] == count, "allgatherv total mismatch");
+  test_allgatherv_check (vrecv, counts, displs, mpisize);
+
+  SC_FREE (vrecv);
+  SC_FREE (vsend);
+  SC_FREE (vdata);
+  SC_FREE (sizes);
+  SC_FREE (counts);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -30,10 +138,13 @@ main (int argc, char **argv)
   int                 mpiret;
   int                 mpisize;
   int                 mpirank;
-  int                 i;
+  int                 i, j;
   int                *idata;
+  int                *bdata;
   double              elapsed_alltoall = 0.;
   double              elapsed_recursive;
+  double              elapsed_ring;
+  double              elapsed_bruck;
   double              dsend;
   double             *ddata1;
   double             *ddata2;
@@ -80,8 +191,43 @@ main (int argc, char **argv)
     SC_ASSERT (idata[i] == i);
   }
 
+  SC_GLOBAL_INFO ("Testing sc_allgather_bruck\n");
+
+  for (i = 0; i < mpisize; ++i) {
+    idata[i] = (i == mpirank) ? mpirank : -1;
+  }
+  elapsed_bruck = -sc_MPI_Wtime ();
+  sc_allgather_bruck (mpicomm, (char *) idata, sizeof (int),
+                      mpisize, mpirank, mpirank);
+  elapsed_bruck += sc_MPI_Wtime ();
+  for (i = 0; i < mpisize; ++i) {
+    SC_ASSERT (idata[i] == i);
+  }
+
   SC_FREE (idata);
 
+  SC_GLOBAL_INFO ("Testing sc_allgather_ring\n");
+
+  /* blocks of 5 ints split into segments that straddle the ints */
+  bdata = SC_ALLOC (int, 5 * mpisize);
+  for (i = 0; i < mpisize; ++i) {
+    for (j = 0; j < 5; ++j) {
+      bdata[5 * i + j] = (i == mpirank) ? 10 * mpirank + j : -1;
+    }
+  }
+  elapsed_ring = -sc_MPI_Wtime ();
+  sc_allgather_ring (mpicomm, (char *) bdata, 5 * sizeof (int),
+                     mpisize, mpirank, mpirank, 3);
+  elapsed_ring += sc_MPI_Wtime ();
+  for (i = 0; i < mpisize; ++i) {
+    for (j = 0; j < 5; ++j) {
+      SC_ASSERT (bdata[5 * i + j] == 10 * i + j);
+    }
+  }
+  SC_FREE (bdata);
+
+  test_allgatherv (mpicomm, mpisize, mpirank);
+
   ddata1 = SC_ALLOC (double, mpisize);
   ddata2 = SC_ALLOC (double, mpisize);
 
@@ -121,6 +267,8 @@ main (int argc, char **argv)
                          SC_AG_ALLTOALL_MAX, mpisize);
   SC_GLOBAL_STATISTICSF ("   alltoall %g\n", elapsed_alltoall);
   SC_GLOBAL_STATISTICSF ("   recursive %g\n", elapsed_recursive);
+  SC_GLOBAL_STATISTICSF ("   bruck %g\n", elapsed_bruck);
+  SC_GLOBAL_STATISTICSF ("   ring %g\n", elapsed_ring);
   SC_GLOBAL_STATISTICSF ("   allgather %g\n", elapsed_allgather);
   SC_GLOBAL_STATISTICSF ("   replacement %g\n", elapsed_replacement);
 
@@ -0,0 +1,201 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_amr.h>
+
+#define TEST_AMR_ELEMENTS 1000
+
+typedef struct test_amr
+{
+  long                num_elements;
+  double             *errors;
+}
+test_amr_t;
+
+/* families of four elements coarsen into one */
+static long
+test_amr_count_coarsen (sc_amr_control_t * amr, void *user_data)
+{
+  test_amr_t         *t = (test_amr_t *) user_data;
+  long                i, count = 0;
+
+  for (i = 0; i < t->num_elements; ++i) {
+    count += (t->errors[i] < amr->coarsen_threshold);
+  }
+  return count - count / 4;
+}
+
+/* each element refines into four */
+static long
+test_amr_count_refine (sc_amr_control_t * amr, void *user_data)
+{
+  test_amr_t         *t = (test_amr_t *) user_data;
+  long                i, count = 0;
+
+  for (i = 0; i < t->num_elements; ++i) {
+    count += (t->errors[i] > amr->refine_threshold);
+  }
+  return 3 * count;
+}
+
+static int
+test_amr_check (sc_amr_control_t * amr, long low, long high,
+                const char *what)
+{
+  if (amr->num_total_estimated < low || amr->num_total_estimated > high) {
+    SC_GLOBAL_LERRORF ("%s estimated %ld outside of %ld %ld\n", what,
+                       amr->num_total_estimated, low, high);
+    return 1;
+  }
+  return 0;
+}
+
+static int
+test_amr_accum (sc_MPI_Comm mpicomm, test_amr_t * t)
+{
+  const double        accuracy = .01;
+  const double        quantiles[3] = { .1, .5, .9 };
+  int                 failed = 0;
+  int                 mpiret;
+  int                 j;
+  long                i, local[2], global[2];
+  double              q;
+  sc_amr_control_t    amr, ref;
+  sc_amr_accum_t     *acc;
+
+  /* statistics must match those of the full error array */
+  acc = sc_amr_accum_new (accuracy, 1e-8, 1e2);
+  for (i = 0; i < t->num_elements; ++i) {
+    sc_amr_accum_add (acc, t->errors[i]);
+  }
+  sc_amr_accum_finalize (acc, mpicomm, &amr);
+  sc_amr_error_stats (mpicomm, t->num_elements, t->errors, &ref);
+  if (amr.num_total_elements != ref.num_total_elements ||
+      amr.estats.min != ref.estats.min || amr.estats.max != ref.estats.max ||
+      fabs (amr.estats.average - ref.estats.average) >
+      1e-12 * ref.estats.average) {
+    SC_GLOBAL_LERROR ("Accumulated statistics mismatch\n");
+    failed = 1;
+  }
+
+  /* the quantiles are within the relative accuracy */
+  for (j = 0; j < 3; ++j) {
+    q = sc_amr_accum_quantile (acc, quantiles[j]);
+    local[0] = local[1] = 0;
+    for (i = 0; i < t->num_elements; ++i) {
+      local[0] += (t->errors[i] <= q * (1. + accuracy));
+      local[1] += (t->errors[i] < q * (1. - accuracy));
+    }
+    mpiret = sc_MPI_Allreduce (local, global, 2, sc_MPI_LONG, sc_MPI_SUM,
+                               mpicomm);
+    SC_CHECK_MPI (mpiret);
+    if (global[0] < quantiles[j] * (amr.num_total_elements - 1) ||
+        global[1] > quantiles[j] * (amr.num_total_elements - 1) + 1) {
+      SC_GLOBAL_LERRORF ("Quantile %g estimate %g is off\n",
+                         quantiles[j], q);
+      failed = 1;
+    }
+  }
+  sc_amr_accum_destroy (acc);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 failed = 0, anyfailed;
+  int                 mpiret;
+  int                 rank, size;
+  long                i, total, target;
+  unsigned            seed;
+  test_amr_t          t;
+  sc_amr_control_t    amr;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* errors spread over several orders of magnitude */
+  t.num_elements = TEST_AMR_ELEMENTS + 17 * rank;
+  t.errors = SC_ALLOC (double, t.num_elements);
+  seed = 12345u + (unsigned) rank;
+  for (i = 0; i < t.num_elements; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    t.errors[i] = exp (-10. * ((seed >> 8) & 0xffff) / 65536.);
+  }
+
+  /* coarsen down to sixty percent */
+  sc_amr_error_stats (mpicomm, t.num_elements, t.errors, &amr);
+  total = amr.num_total_elements;
+  target = (long) (.6 * total);
+  sc_amr_coarsen_search_histogram (-1, &amr, target, amr.estats.max, .95,
+                                   16, 3, test_amr_count_coarsen, &t);
+  failed |= test_amr_check (&amr, target, (long) (target / .95),
+                            "Histogram coarsen");
+  sc_amr_coarsen_search (-1, &amr, target, amr.estats.max, .95, 40,
+                         test_amr_count_coarsen, &t);
+  failed |= test_amr_check (&amr, target, (long) (target / .95),
+                            "Binary coarsen");
+
+  /* refine up to one and a half times */
+  sc_amr_error_stats (mpicomm, t.num_elements, t.errors, &amr);
+  target = (long) (1.5 * total);
+  sc_amr_refine_search_histogram (-1, &amr, target, amr.estats.min, .95,
+                                  16, 3, test_amr_count_refine, &t);
+  failed |= test_amr_check (&amr, (long) (target * .95), target,
+                            "Histogram refine");
+
+  /* an unreachable target keeps the extreme threshold */
+  sc_amr_error_stats (mpicomm, t.num_elements, t.errors, &amr);
+  target = 10 * total;
+  sc_amr_refine_search_histogram (-1, &amr, target, amr.estats.min, .95,
+                                  16, 3, test_amr_count_refine, &t);
+  if (amr.refine_threshold != amr.estats.min) {
+    SC_GLOBAL_LERROR ("Refinement should stop at the lower bound\n");
+    failed = 1;
+  }
+
+  failed |= test_amr_accum (mpicomm, &t);
+
+  SC_FREE (t.errors);
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_io.h>
+
+/* checksums of split data combine into that of the whole */
+static int
+test_combine (void)
+{
+  int                 failed = 0;
+  size_t              zz, split;
+  unsigned char       data[1000];
+  uint32_t            whole;
+  const char          check[] = "123456789";
+  sc_array_t          view;
+
+  /* the standard check value of CRC32C */
+  sc_array_init_data (&view, (void *) check, 1, 9);
+  failed |= sc_array_crc32c (&view) != 0xe3069283U;
+
+  for (zz = 0; zz < 1000; ++zz) {
+    data[zz] = (unsigned char) (zz * 131 % 251);
+  }
+  whole = sc_io_crc32c (0, data, 1000);
+  for (split = 0; split <= 1000; split += 97) {
+    failed |= whole != sc_io_crc32c_combine
+      (sc_io_crc32c (0, data, split),
+       sc_io_crc32c (0, data + split, 1000 - split), 1000 - split);
+  }
+  sc_array_init_data (&view, data, 8, 125);
+  failed |= sc_array_crc32c (&view) != whole;
+  if (failed) {
+    SC_LERROR ("Checksum combination mismatch\n");
+  }
+  return failed;
+}
+
+/* the global checksum is that of the gathered array */
+static int
+test_global (sc_MPI_Comm mpicomm, int big)
+{
+  int                 mpiret, rank, size, p, failed = 0;
+  int                *counts, *displs, total;
+  uint32_t            global, all, expect;
+  size_t              zz, count;
+  sc_array_t         *local, *gathered;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* some ranks contribute nothing */
+  count = rank % 3 == 1 ? 0 : (size_t) (big ? 300000 : 17 * rank + 5);
+  local = sc_array_new_count (sizeof (int), count);
+  for (zz = 0; zz < count; ++zz) {
+    *(int *) sc_array_index (local, zz) = (int) (rank * 1000003 + zz);
+  }
+  global = sc_array_checksum_global (local, mpicomm);
+
+  counts = SC_ALLOC (int, size);
+  displs = SC_ALLOC (int, size);
+  p = (int) count;
+  mpiret = sc_MPI_Allgather (&p, 1, sc_MPI_INT, counts, 1, sc_MPI_INT,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  total = 0;
+  for (p = 0; p < size; ++p) {
+    displs[p] = total;
+    total += counts[p];
+  }
+  gathered = sc_array_new_count (sizeof (int), (size_t) total);
+  mpiret = sc_MPI_Allgatherv (local->array, (int) count, sc_MPI_INT,
+                              gathered->array, counts, displs, sc_MPI_INT,
+                              mpicomm);
+  SC_CHECK_MPI (mpiret);
+  expect = sc_array_crc32c (gathered);
+  failed |= global != expect;
+
+  /* the same result on all ranks */
+  mpiret = sc_MPI_Allreduce (&global, &all, 1, sc_MPI_UNSIGNED,
+                             sc_MPI_BXOR, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  failed |= (size % 2 == 0 ? 0U : global) != all;
+  if (failed) {
+    SC_LERRORF ("Global checksum mismatch %x %x\n", global, expect);
+  }
+
+  sc_array_destroy (gathered);
+  sc_array_destroy (local);
+  SC_FREE (displs);
+  SC_FREE (counts);
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0, anyfailed;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  failed |= test_combine ();
+  failed |= test_global (mpicomm, 0);
+  failed |= test_global (mpicomm, 1);
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
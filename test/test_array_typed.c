@@ -0,0 +1,143 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_array_typed.h>
+
+typedef struct test_pair
+{
+  int                 key;
+  int                 id;
+}
+test_pair_t;
+
+#define test_pair_less(a,b) \
+  ((a).key < (b).key || ((a).key == (b).key && (a).id < (b).id))
+
+SC_ARRAY_DECLARE_LESS (pair, test_pair_t, test_pair_less)
+
+static int
+test_int64_compare (const void *v1, const void *v2)
+{
+  const int64_t       i1 = *(const int64_t *) v1;
+  const int64_t       i2 = *(const int64_t *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2;
+}
+
+/** Sort by the typed and the untyped functions and search all keys. */
+static int
+test_int64 (size_t n, int pattern)
+{
+  int                 num_failed = 0;
+  int64_t             key, *data;
+  size_t              zz;
+  ssize_t             pos;
+  sc_array_t         *a, *b;
+
+  a = sc_array_int64_new ();
+  for (zz = 0; zz < n; ++zz) {
+    switch (pattern) {
+    case 0:
+      key = (int64_t) (rand () % 1000) - 500;
+      break;
+    case 1:
+      key = (int64_t) zz;
+      break;
+    case 2:
+      key = (int64_t) (n - zz);
+      break;
+    default:
+      key = 7;
+    }
+    sc_array_int64_push_value (a, 2 * key);
+  }
+  b = sc_array_new_count (sizeof (int64_t), n);
+  sc_array_copy (b, a);
+  sc_array_int64_sort (a);
+  sc_array_sort (b, test_int64_compare);
+  num_failed += a->elem_count != n ||
+    memcmp (a->array, b->array, n * sizeof (int64_t)) != 0;
+
+  /* the typed search finds the first of equal elements */
+  data = sc_array_int64_data (a);
+  for (zz = 0; zz < n; ++zz) {
+    num_failed += sc_array_int64_index (a, zz) !=
+      (int64_t *) sc_array_index (a, zz);
+    pos = sc_array_int64_bsearch (a, &data[zz]);
+    num_failed += pos < 0 || data[pos] != data[zz] ||
+      (pos > 0 && data[pos - 1] == data[zz]);
+    key = data[zz] + 1;
+    num_failed += sc_array_int64_bsearch (a, &key) != -1;
+  }
+  sc_array_destroy (b);
+  sc_array_destroy (a);
+
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 i, pattern;
+  size_t              zz;
+  ssize_t             pos;
+  sc_array_t          array, *a = &array;
+  test_pair_t        *p, key;
+
+  sc_init (sc_MPI_COMM_NULL, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (pattern = 0; pattern < 4; ++pattern) {
+    num_failed += test_int64 (0, pattern);
+    num_failed += test_int64 (13, pattern);
+    num_failed += test_int64 (5000, pattern);
+  }
+
+  /* a custom order on a structure */
+  sc_array_pair_init (a);
+  p = sc_array_pair_push_count (a, 100);
+  for (i = 0; i < 100; ++i) {
+    p[i].key = (i * 37) % 10;
+    p[i].id = 99 - i;
+  }
+  sc_array_pair_push (a)->key = -1;
+  sc_array_pair_index (a, 100)->id = 0;
+  sc_array_pair_sort (a);
+  p = sc_array_pair_data (a);
+  for (zz = 1; zz < a->elem_count; ++zz) {
+    num_failed += !test_pair_less (p[zz - 1], p[zz]);
+  }
+  key.key = 4;
+  key.id = 97;
+  pos = sc_array_pair_bsearch (a, &key);
+  num_failed += pos < 0 || p[pos].key != 4 || p[pos].id != 97;
+  key.id = 98;
+  num_failed += sc_array_pair_bsearch (a, &key) != -1;
+  sc_array_reset (a);
+
+  SC_CHECK_ABORT (num_failed == 0, "Typed arrays");
+
+  sc_finalize ();
+
+  return 0;
+}
@@ -22,6 +22,10 @@
 */
 
 #include <sc_containers.h>
+#include <sc_uint128.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 static              ssize_t
 sc_array_bsearch_range (sc_array_t * array, size_t begin, size_t end,
@@ -144,6 +148,502 @@ test_mstamp (void)
   }
 }
 
+static void
+test_inline (void)
+{
+  int                 i;
+  sc_array_inline_t   ai;
+  sc_array_t         *a = &ai.a, *v;
+
+  sc_array_init_inline (&ai, sizeof (int));
+  SC_CHECK_ABORT (SC_ARRAY_IS_INLINE (a), "Inline init");
+  SC_CHECK_ABORT (sc_array_memory_used (a, 0) == 0, "Inline memory");
+
+  /* the first elements stay inside the structure */
+  for (i = 0; i < (int) (SC_ARRAY_INLINE_BYTES / sizeof (int)); ++i) {
+    *(int *) sc_array_push (a) = i;
+  }
+  SC_CHECK_ABORT (SC_ARRAY_IS_INLINE (a), "Inline push");
+  v = sc_array_new_view (a, 2, 3);
+  SC_CHECK_ABORT (*(int *) sc_array_index (v, 0) == 2, "Inline view");
+  sc_array_destroy (v);
+  sc_array_resize (a, 0);
+  SC_CHECK_ABORT (SC_ARRAY_IS_INLINE (a), "Inline resize to zero");
+
+  /* growing further moves the elements to the heap */
+  for (i = 0; i < 100; ++i) {
+    *(int *) sc_array_push (a) = i;
+  }
+  SC_CHECK_ABORT (!SC_ARRAY_IS_INLINE (a), "Inline spill");
+  for (i = 0; i < 100; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (a, i) == i, "Inline data");
+  }
+  sc_array_reset (a);
+
+  sc_array_init_inline (&ai, sizeof (int));
+  *(int *) sc_array_push (a) = 5;
+  sc_array_reset (a);
+
+  /* data that happens to follow its array structure is not inline */
+  v = (sc_array_t *) SC_ALLOC (char, sizeof (sc_array_t) + 4 * sizeof (int));
+  sc_array_init_data (v, v + 1, sizeof (int), 4);
+  SC_CHECK_ABORT (!SC_ARRAY_IS_INLINE (v), "Inline adjacent data");
+  SC_FREE (v);
+}
+
+static void
+test_reserve (void)
+{
+  int                 i;
+  char               *base;
+  sc_array_t         *a;
+
+  a = sc_array_new (sizeof (int));
+  sc_array_reserve (a, 1000);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == 1000 * sizeof (int),
+                  "Reserve exact");
+  base = a->array;
+  for (i = 0; i < 1000; ++i) {
+    *(int *) sc_array_push (a) = i;
+  }
+  SC_CHECK_ABORT (a->array == base, "Reserve keeps memory");
+  sc_array_resize (a, 999);
+  SC_CHECK_ABORT (a->array == base, "Resize keeps memory");
+
+  /* push one more than reserved and shrink back */
+  sc_array_resize (a, 1000);
+  *(int *) sc_array_index_int (a, 999) = 999;
+  *(int *) sc_array_push (a) = 1000;
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) >= 1001 * sizeof (int),
+                  "Reserve grow");
+  sc_array_shrink_to_fit (a);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == 1001 * sizeof (int),
+                  "Shrink to fit");
+  for (i = 0; i <= 1000; ++i) {
+    SC_CHECK_ABORT (*(int *) sc_array_index_int (a, i) == i, "Reserve data");
+  }
+  sc_array_truncate (a);
+  sc_array_shrink_to_fit (a);
+  SC_CHECK_ABORT (a->byte_alloc == 0 && a->array == NULL, "Shrink empty");
+  sc_array_destroy (a);
+
+  /* large arrays overshoot by a quarter plus a page at most */
+  a = sc_array_new (1);
+  sc_array_resize (a, ((size_t) 1 << 25) + 1);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) <
+                  ((size_t) 5 << 23) + ((size_t) 1 << 21) + 1, "Large grow");
+  sc_array_resize (a, ((size_t) 1 << 25) + 7);
+  sc_array_destroy (a);
+
+  /* the growth rule is chosen per array */
+  a = sc_array_new (sizeof (int));
+  sc_array_set_growth (a, SC_ARRAY_GROWTH_EXACT);
+  sc_array_resize (a, 3);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == 3 * sizeof (int),
+                  "Growth exact");
+  sc_array_set_growth (a, SC_ARRAY_GROWTH_PAGES);
+  sc_array_resize (a, 7);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == ((size_t) 1 << 21),
+                  "Growth pages");
+  sc_array_destroy (a);
+
+  a = sc_array_new (1);
+  sc_array_set_growth (a, SC_ARRAY_GROWTH_DOUBLE);
+  sc_array_resize (a, ((size_t) 1 << 25) + 1);
+  SC_CHECK_ABORT (SC_ARRAY_BYTE_ALLOC (a) == ((size_t) 1 << 26),
+                  "Growth double");
+  sc_array_destroy (a);
+}
+
+typedef struct test_keyed
+{
+  int                 pad;
+  int32_t             k32;
+  int64_t             k64;
+  sc_uint128_t        k128;
+  int                 pos;
+}
+test_keyed_t;
+
+static int
+test_keyed_compare64 (const void *v1, const void *v2)
+{
+  const test_keyed_t *t1 = (const test_keyed_t *) v1;
+  const test_keyed_t *t2 = (const test_keyed_t *) v2;
+
+  return t1->k64 < t2->k64 ? -1 : t1->k64 > t2->k64 ? 1 : 0;
+}
+
+static int
+test_keyed_compare_int (const void *v1, const void *v2)
+{
+  const int           i1 = *(const int *) v1;
+  const int           i2 = *(const int *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2 ? 1 : 0;
+}
+
+static void
+test_keyed (size_t n)
+{
+  size_t              zz;
+  test_keyed_t       *t, *u;
+  sc_array_t         *a, *b;
+
+  a = sc_array_new_count (sizeof (test_keyed_t), n);
+  for (zz = 0; zz < n; ++zz) {
+    t = (test_keyed_t *) sc_array_index (a, zz);
+    t->pad = 0;
+    t->k32 = (int32_t) (rand () % 97) - 48;
+    t->k64 = ((int64_t) (rand () % 1000) - 500) << 40;
+    t->k128.high_bits = (uint64_t) (rand () % 5);
+    t->k128.low_bits = (uint64_t) rand () << 33;
+    t->pos = (int) zz;
+  }
+  b = sc_array_new (sizeof (test_keyed_t));
+  sc_array_copy (b, a);
+
+  /* signed 32 bit keys, checking stability */
+  sc_array_sort_keyed (a, offsetof (test_keyed_t, k32), SC_ARRAY_KEY_INT32);
+  SC_CHECK_ABORT (sc_array_is_sorted_keyed (a, offsetof (test_keyed_t, k32),
+                                            SC_ARRAY_KEY_INT32), "Sort 32");
+  for (zz = 1; zz < n; ++zz) {
+    t = (test_keyed_t *) sc_array_index (a, zz - 1);
+    u = (test_keyed_t *) sc_array_index (a, zz);
+    SC_CHECK_ABORT (t->k32 < u->k32 || (t->k32 == u->k32 && t->pos < u->pos),
+                    "Sort stable");
+  }
+  sc_array_uniq_keyed (a, offsetof (test_keyed_t, k32), SC_ARRAY_KEY_INT32);
+  SC_CHECK_ABORT (n == 0 || a->elem_count <= 97, "Uniq count");
+  for (zz = 1; zz < a->elem_count; ++zz) {
+    t = (test_keyed_t *) sc_array_index (a, zz - 1);
+    u = (test_keyed_t *) sc_array_index (a, zz);
+    SC_CHECK_ABORT (t->k32 < u->k32, "Uniq order");
+  }
+
+  /* signed 64 bit keys agree with the comparison sort */
+  sc_array_copy (a, b);
+  sc_array_sort_keyed (a, offsetof (test_keyed_t, k64), SC_ARRAY_KEY_INT64);
+  sc_array_sort_intro (b, test_keyed_compare64);
+  SC_CHECK_ABORT (sc_array_is_sorted (b, test_keyed_compare64), "Intro");
+  for (zz = 0; zz < n; ++zz) {
+    t = (test_keyed_t *) sc_array_index (a, zz);
+    u = (test_keyed_t *) sc_array_index (b, zz);
+    SC_CHECK_ABORT (t->k64 == u->k64, "Sort 64");
+  }
+
+  /* 128 bit keys */
+  sc_array_sort_keyed (a, offsetof (test_keyed_t, k128),
+                       SC_ARRAY_KEY_UINT128);
+  for (zz = 1; zz < n; ++zz) {
+    t = (test_keyed_t *) sc_array_index (a, zz - 1);
+    u = (test_keyed_t *) sc_array_index (a, zz);
+    SC_CHECK_ABORT (sc_uint128_compare (&t->k128, &u->k128) <= 0,
+                    "Sort 128");
+  }
+  sc_array_destroy (a);
+  sc_array_destroy (b);
+
+  /* introsort on plain integers, including many duplicates */
+  a = sc_array_new_count (sizeof (int), n);
+  for (zz = 0; zz < n; ++zz) {
+    *(int *) sc_array_index (a, zz) = rand () % 13;
+  }
+  sc_array_sort_intro (a, test_keyed_compare_int);
+  SC_CHECK_ABORT (sc_array_is_sorted (a, test_keyed_compare_int),
+                  "Intro int");
+  sc_array_destroy (a);
+}
+
+static              size_t
+test_parallel_type (sc_array_t * array, size_t index, void *data)
+{
+  return (size_t) *(int *) sc_array_index (array, index) / 4;
+}
+
+/** Run the thread parallel sc_array functions and compare to one thread. */
+static void
+test_parallel (size_t n)
+{
+  const int           M = 1 << 16;
+#ifdef SC_ENABLE_OPENMP
+  int                 num_threads;
+#endif
+  size_t              zz, zt, *pz, *pt;
+  unsigned int        crc1 = 0, crc2 = 0;
+  sc_array_t         *a, *b, *perm, *offs1, *offs2;
+
+#ifdef SC_ENABLE_OPENMP
+  num_threads = omp_get_max_threads ();
+#endif
+  a = sc_array_new_count (sizeof (int), n);
+  perm = sc_array_new_count (sizeof (size_t), n);
+  for (zz = 0; zz < n; ++zz) {
+    *(int *) sc_array_index (a, zz) = rand () % M;
+    *(size_t *) sc_array_index (perm, zz) = zz;
+  }
+  for (zz = n; zz > 1; --zz) {
+    /* shuffle the permutation */
+    pz = (size_t *) sc_array_index (perm, zz - 1);
+    pt = (size_t *) sc_array_index (perm, (size_t) rand () % zz);
+    zt = *pz;
+    *pz = *pt;
+    *pt = zt;
+  }
+  b = sc_array_new (sizeof (int));
+  sc_array_copy (b, a);
+
+  /* permute with kept permutation against the in-place algorithm */
+  sc_array_permute (a, perm, 1);
+#ifdef SC_HAVE_ZLIB
+  crc1 = sc_array_checksum (a);
+#endif
+#ifdef SC_ENABLE_OPENMP
+  omp_set_num_threads (1);
+#endif
+  sc_array_permute (b, perm, 0);
+  SC_CHECK_ABORT (sc_array_is_equal (a, b), "Parallel permute");
+#ifdef SC_HAVE_ZLIB
+  crc2 = sc_array_checksum (b);
+#endif
+  SC_CHECK_ABORT (crc1 == crc2, "Parallel checksum");
+
+  /* sort and split */
+  sc_array_sort (b, sc_int_compare);
+  offs2 = sc_array_new (sizeof (size_t));
+  sc_array_split (b, offs2, M / 4, test_parallel_type, NULL);
+#ifdef SC_ENABLE_OPENMP
+  omp_set_num_threads (num_threads);
+#endif
+  sc_array_sort_parallel (a, sc_int_compare);
+  SC_CHECK_ABORT (sc_array_is_equal (a, b), "Parallel sort");
+  offs1 = sc_array_new (sizeof (size_t));
+  sc_array_split_parallel (a, offs1, M / 4, test_parallel_type, NULL);
+  SC_CHECK_ABORT (sc_array_is_equal (offs1, offs2), "Parallel split");
+
+  sc_array_destroy (offs1);
+  sc_array_destroy (offs2);
+  sc_array_destroy (perm);
+  sc_array_destroy (a);
+  sc_array_destroy (b);
+}
+
+/** Permute three arrays of different element sizes in one call. */
+static void
+test_permute_multi (size_t n, size_t max_bytes)
+{
+  int                 k;
+  size_t              zz, zt, *pz, *pt;
+  char                view_data[100];
+  sc_array_t         *perm, *arrays[3];
+
+  perm = sc_array_new_count (sizeof (size_t), n);
+  for (zz = 0; zz < n; ++zz) {
+    *(size_t *) sc_array_index (perm, zz) = zz;
+  }
+  for (zz = n; zz > 1; --zz) {
+    pz = (size_t *) sc_array_index (perm, zz - 1);
+    pt = (size_t *) sc_array_index (perm, (size_t) rand () % zz);
+    zt = *pz;
+    *pz = *pt;
+    *pt = zt;
+  }
+
+  /* the third array is a view if it is small enough */
+  arrays[0] = sc_array_new_count (1, n);
+  arrays[1] = sc_array_new_count (sizeof (size_t), n);
+  arrays[2] = n <= sizeof (view_data) / 4 ?
+    sc_array_new_data (view_data, 4, n) : sc_array_new_count (24, n);
+  for (zz = 0; zz < n; ++zz) {
+    *(char *) sc_array_index (arrays[0], zz) = (char) zz;
+    *(size_t *) sc_array_index (arrays[1], zz) = zz;
+    memset (sc_array_index (arrays[2], zz), (int) (zz % 251),
+            arrays[2]->elem_size);
+  }
+
+  sc_array_permute_multi (arrays, 3, perm, max_bytes);
+  for (zz = 0; zz < n; ++zz) {
+    zt = *(size_t *) sc_array_index (perm, zz);
+    SC_CHECK_ABORT (*(char *) sc_array_index (arrays[0], zt) == (char) zz,
+                    "Multi permute char");
+    SC_CHECK_ABORT (*(size_t *) sc_array_index (arrays[1], zt) == zz,
+                    "Multi permute size_t");
+    SC_CHECK_ABORT (((unsigned char *) sc_array_index (arrays[2], zt))
+                    [arrays[2]->elem_size - 1] == zz % 251,
+                    "Multi permute record");
+  }
+
+  for (k = 0; k < 3; ++k) {
+    sc_array_destroy (arrays[k]);
+  }
+  sc_array_destroy (perm);
+}
+
+/** Hash the first int of a pair for counting by key. */
+static unsigned int
+test_uniq_hash (const void *v, const void *u)
+{
+  return (unsigned int) *(const int *) v * 2654435761u;
+}
+
+static int
+test_uniq_equal (const void *v1, const void *v2, const void *u)
+{
+  return *(const int *) v1 == *(const int *) v2;
+}
+
+/** Remove duplicates from an unsorted array with and without order. */
+static void
+test_uniq_unsorted (size_t n, int range)
+{
+  int                 keep_order, *pi;
+  size_t              zz, zk, total;
+  sc_array_t         *input, *a, *b, *map, *counts;
+
+  input = sc_array_new_count (2 * sizeof (int), n);
+  for (zz = 0; zz < n; ++zz) {
+    pi = (int *) sc_array_index (input, zz);
+    pi[0] = rand () % range;
+    pi[1] = (int) zz;
+  }
+
+  /* deduplicate the keys against sorting */
+  b = sc_array_new_count (sizeof (int), n);
+  for (zz = 0; zz < n; ++zz) {
+    *(int *) sc_array_index (b, zz) = *(int *) sc_array_index (input, zz);
+  }
+  a = sc_array_new (sizeof (int));
+  sc_array_copy (a, b);
+  sc_array_sort (b, sc_int_compare);
+  sc_array_uniq (b, sc_int_compare);
+  map = sc_array_new (sizeof (size_t));
+  for (keep_order = 0; keep_order < 2; ++keep_order) {
+    sc_array_resize (a, n);
+    for (zz = 0; zz < n; ++zz) {
+      *(int *) sc_array_index (a, zz) = *(int *) sc_array_index (input, zz);
+    }
+    sc_array_uniq_unsorted (a, NULL, NULL, NULL, keep_order, map);
+    SC_CHECK_ABORT (map->elem_count == n, "Uniq unsorted map");
+    for (zz = 0; zz < n; ++zz) {
+      zk = *(size_t *) sc_array_index (map, zz);
+      SC_CHECK_ABORT (zk < a->elem_count &&
+                      *(int *) sc_array_index (a, zk) ==
+                      *(int *) sc_array_index (input, zz),
+                      "Uniq unsorted map entry");
+    }
+    sc_array_sort (a, sc_int_compare);
+    SC_CHECK_ABORT (sc_array_is_equal (a, b), "Uniq unsorted");
+  }
+
+  /* first occurrence order means new keys appear as increasing indices */
+  sc_array_resize (a, n);
+  for (zz = 0; zz < n; ++zz) {
+    *(int *) sc_array_index (a, zz) = *(int *) sc_array_index (input, zz);
+  }
+  sc_array_uniq_unsorted (a, NULL, NULL, NULL, 1, map);
+  for (zz = 0, zk = 0; zz < n; ++zz) {
+    size_t              zm = *(size_t *) sc_array_index (map, zz);
+
+    SC_CHECK_ABORT (zm <= zk, "Uniq unsorted first occurrence");
+    if (zm == zk) {
+      ++zk;
+    }
+  }
+  SC_CHECK_ABORT (zk == a->elem_count, "Uniq unsorted kept count");
+
+  /* count the pairs by their first int */
+  counts = sc_array_new (sizeof (size_t));
+  sc_array_uniq_count (input, test_uniq_hash, test_uniq_equal, NULL,
+                       NULL, counts);
+  SC_CHECK_ABORT (input->elem_count == b->elem_count &&
+                  counts->elem_count == b->elem_count, "Uniq count size");
+  for (zz = 0, total = 0; zz < counts->elem_count; ++zz) {
+    pi = (int *) sc_array_index (input, zz);
+    SC_CHECK_ABORT (*(int *) sc_array_index (a, zz) == pi[0],
+                    "Uniq count order");
+    total += *(size_t *) sc_array_index (counts, zz);
+  }
+  SC_CHECK_ABORT (total == n, "Uniq count total");
+
+  sc_array_destroy (input);
+  sc_array_destroy (a);
+  sc_array_destroy (b);
+  sc_array_destroy (map);
+  sc_array_destroy (counts);
+}
+
+/** Churn a recycle array, iterate over it and compact it. */
+static void
+test_recycle (void)
+{
+  const size_t        N = 300;
+  int                 live[300];
+  size_t              zz, pos, count;
+  sc_array_t         *newindices, *shadow;
+  sc_recycle_array_t  rec;
+
+  sc_recycle_array_init (&rec, sizeof (size_t));
+  for (zz = 0; zz < N; ++zz) {
+    *(size_t *) sc_recycle_array_insert (&rec, &pos) = zz;
+    SC_CHECK_ABORT (pos == zz, "Recycle append");
+    live[zz] = 1;
+  }
+
+  /* free a pattern with long holes and refill the lowest slots */
+  for (zz = 0; zz < N; ++zz) {
+    if (zz % 7 == 0 || (zz >= 64 && zz < 200)) {
+      sc_recycle_array_remove (&rec, zz);
+      live[zz] = 0;
+    }
+  }
+  for (zz = 0; zz < 3; ++zz) {
+    *(size_t *) sc_recycle_array_insert (&rec, &pos) = pos;
+    SC_CHECK_ABORT (pos == 7 * zz && !live[pos], "Recycle lowest free");
+    live[pos] = 1;
+  }
+
+  /* the iterator visits exactly the valid slots */
+  count = 0;
+  for (pos = sc_recycle_array_next (&rec, 0); pos < rec.a.elem_count;
+       pos = sc_recycle_array_next (&rec, pos + 1)) {
+    SC_CHECK_ABORT (live[pos], "Recycle next valid");
+    SC_CHECK_ABORT (*(size_t *) sc_array_index (&rec.a, pos) == pos,
+                    "Recycle next data");
+    ++count;
+  }
+  SC_CHECK_ABORT (count == rec.elem_count, "Recycle next count");
+
+  /* compaction keeps the order and permutes parallel data alike */
+  shadow = sc_array_new_count (sizeof (size_t), N);
+  for (zz = 0; zz < N; ++zz) {
+    *(size_t *) sc_array_index (shadow, zz) = zz;
+  }
+  newindices = sc_array_new (sizeof (size_t));
+  sc_recycle_array_compact (&rec, newindices);
+  SC_CHECK_ABORT (rec.a.elem_count == count && rec.elem_count == count,
+                  "Recycle compact count");
+  SC_CHECK_ABORT (sc_array_is_permutation (newindices),
+                  "Recycle compact permutation");
+  sc_array_permute (shadow, newindices, 1);
+  for (pos = 0; pos < count; ++pos) {
+    zz = *(size_t *) sc_array_index (&rec.a, pos);
+    SC_CHECK_ABORT (live[zz], "Recycle compact data");
+    SC_CHECK_ABORT (*(size_t *) sc_array_index (shadow, pos) == zz,
+                    "Recycle compact shadow");
+    SC_CHECK_ABORT (pos == 0 || zz > *(size_t *)
+                    sc_array_index (&rec.a, pos - 1), "Recycle order");
+  }
+  SC_CHECK_ABORT (sc_recycle_array_next (&rec, 0) == 0, "Recycle dense");
+
+  /* the compacted array grows again at the end */
+  sc_recycle_array_insert (&rec, &pos);
+  SC_CHECK_ABORT (pos == count, "Recycle grow after compact");
+
+  sc_array_destroy (newindices);
+  sc_array_destroy (shadow);
+  sc_recycle_array_reset (&rec);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -272,6 +772,23 @@ main (int argc, char **argv)
   SC_FREE (data);
 
   test_mstamp ();
+  test_inline ();
+  test_reserve ();
+  test_keyed (0);
+  test_keyed (50);
+  test_keyed (10000);
+  test_parallel (100);
+  test_parallel (100000);
+  test_permute_multi (0, (size_t) -1);
+  test_permute_multi (20, (size_t) -1);
+  test_permute_multi (20, 0);
+  test_permute_multi (100000, (size_t) -1);
+  test_permute_multi (100000, 0);
+  test_uniq_unsorted (0, 10);
+  test_uniq_unsorted (1000, 10);
+  test_uniq_unsorted (1000, 100000);
+  test_uniq_unsorted (100000, 5000);
+  test_recycle ();
 
   sc_finalize ();
 
@@ -0,0 +1,176 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_avl.h>
+
+static int
+test_compare_int (const void *v1, const void *v2)
+{
+  const int           i1 = *(const int *) v1;
+  const int           i2 = *(const int *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2 ? 1 : 0;
+}
+
+/** Verify links and counts of a subtree and return its depth. */
+static int
+test_check_node (avl_node_t * node, avl_node_t * parent)
+{
+  int                 dl, dr;
+
+  if (node == NULL) {
+    return 0;
+  }
+  SC_CHECK_ABORT (node->parent == parent, "Parent link");
+  dl = test_check_node (node->left, node);
+  dr = test_check_node (node->right, node);
+  SC_CHECK_ABORT (node->count == 1 + (node->left ? node->left->count : 0) +
+                  (node->right ? node->right->count : 0), "Node count");
+
+  return 1 + SC_MAX (dl, dr);
+}
+
+/** Verify a tree against the expected sorted values. */
+static void
+test_check_tree (avl_tree_t * tree, const int *values, size_t n)
+{
+  int                 depth;
+  size_t              zz;
+  sc_array_t         *array;
+  avl_node_t         *node;
+
+  depth = test_check_node (tree->top, NULL);
+  SC_CHECK_ABORT (avl_count (tree) == n, "Tree count");
+  SC_CHECK_ABORT (depth <= 2 * SC_LOG2_32 (n + 1) + 2, "Tree depth");
+
+  array = sc_array_new (sizeof (void *));
+  avl_to_array (tree, array);
+  for (node = tree->head, zz = 0; zz < n; node = node->next, ++zz) {
+    SC_CHECK_ABORT (**(int **) sc_array_index (array, zz) == values[zz],
+                    "Tree order");
+    SC_CHECK_ABORT (node->item == *(void **) sc_array_index (array, zz),
+                    "Node list");
+    SC_CHECK_ABORT (avl_at (tree, (unsigned int) zz) == node, "Rank");
+    SC_CHECK_ABORT (avl_index (node) == zz, "Index");
+  }
+  SC_CHECK_ABORT (node == NULL, "List end");
+  sc_array_destroy (array);
+}
+
+static void
+test_avl (sc_mempool_t * mempool, size_t n)
+{
+  int                *values, *expect, *extra;
+  size_t              zz, ne, num_extra;
+  sc_array_t         *items;
+  avl_tree_t         *tree;
+
+  values = SC_ALLOC (int, n);
+  extra = SC_ALLOC (int, n);
+  expect = SC_ALLOC (int, 2 * n);
+  items = sc_array_new (sizeof (void *));
+  tree = avl_alloc_tree_mempool (test_compare_int, NULL, mempool);
+
+  /* build from the even numbers */
+  for (zz = 0; zz < n; ++zz) {
+    values[zz] = 2 * (int) zz;
+    *(void **) sc_array_push (items) = &values[zz];
+  }
+  avl_build_sorted (tree, items);
+  test_check_tree (tree, values, n);
+
+  /* a short run of odd numbers with duplicates is inserted one by one */
+  sc_array_truncate (items);
+  num_extra = SC_MIN (n, 4);
+  for (zz = 0; zz < num_extra; ++zz) {
+    extra[zz] = (int) (2 * zz + 1);
+    *(void **) sc_array_push (items) = &extra[zz];
+    *(void **) sc_array_push (items) = &extra[zz];
+  }
+  if (n > num_extra) {
+    *(void **) sc_array_push (items) = &values[n - 1];
+  }
+  SC_CHECK_ABORT (avl_insert_sorted (tree, items) == num_extra, "Short");
+  for (ne = zz = 0; zz < n; ++zz) {
+    expect[ne++] = values[zz];
+    if (zz < num_extra) {
+      expect[ne++] = extra[zz];
+    }
+  }
+  test_check_tree (tree, expect, ne);
+
+  /* a long run of all odd numbers is merged in one pass */
+  sc_array_truncate (items);
+  for (zz = 0; zz < n; ++zz) {
+    extra[zz] = (int) (2 * zz + 1);
+    *(void **) sc_array_push (items) = &extra[zz];
+  }
+  SC_CHECK_ABORT (avl_insert_sorted (tree, items) == n - num_extra, "Long");
+  for (zz = 0; zz < 2 * n; ++zz) {
+    expect[zz] = (int) zz;
+  }
+  test_check_tree (tree, expect, 2 * n);
+
+  /* the merged tree supports the usual deletion */
+  for (zz = 0; zz < n; ++zz) {
+    avl_delete (tree, &extra[zz]);
+  }
+  test_check_tree (tree, values, n);
+
+  avl_free_tree (tree);
+  if (mempool != NULL) {
+    SC_CHECK_ABORT (mempool->elem_count == 0, "Pool count");
+  }
+  sc_array_destroy (items);
+  SC_FREE (expect);
+  SC_FREE (extra);
+  SC_FREE (values);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              n;
+  sc_mempool_t       *mempool;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  mempool = sc_mempool_new (sizeof (avl_node_t));
+  for (n = 0; n <= 20; ++n) {
+    test_avl (NULL, n);
+    test_avl (mempool, n);
+  }
+  test_avl (mempool, 1000);
+  sc_mempool_destroy (mempool);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
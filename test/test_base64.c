@@ -0,0 +1,151 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc.h>
+#include <libb64.h>
+
+#define TEST_BASE64_MAX 5000
+
+static const char   test_base64_alphabet[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* straightforward reference encoder with padding */
+static              size_t
+test_base64_reference (const unsigned char *in, size_t length, char *out)
+{
+  size_t              iz, jz;
+  unsigned long       v;
+
+  for (iz = 0, jz = 0; iz < length; iz += 3, jz += 4) {
+    v = (unsigned long) in[iz] << 16;
+    v |= iz + 1 < length ? (unsigned long) in[iz + 1] << 8 : 0;
+    v |= iz + 2 < length ? (unsigned long) in[iz + 2] : 0;
+    out[jz] = test_base64_alphabet[v >> 18];
+    out[jz + 1] = test_base64_alphabet[(v >> 12) & 0x3f];
+    out[jz + 2] = iz + 1 < length ? test_base64_alphabet[(v >> 6) & 0x3f] :
+      '=';
+    out[jz + 3] = iz + 2 < length ? test_base64_alphabet[v & 0x3f] : '=';
+  }
+  return jz;
+}
+
+/* encode in random pieces and decode in random pieces with line breaks */
+static int
+test_base64 (const unsigned char *data, size_t length)
+{
+  int                 retval = 0;
+  size_t              pos, piece, code_length, ref_length;
+  size_t              broken_length, plain_length;
+  char               *code, *ref, *broken, *plain;
+  base64_encodestate  es;
+  base64_decodestate  ds;
+
+  code = SC_ALLOC (char, 2 * length + 5);
+  ref = SC_ALLOC (char, 2 * length + 5);
+  broken = SC_ALLOC (char, 4 * length + 10);
+  plain = SC_ALLOC (char, 4 * length + 10);
+
+  base64_init_encodestate (&es);
+  for (pos = 0, code_length = 0; pos < length; pos += piece) {
+    piece = (size_t) rand () % 200;
+    piece = SC_MIN (piece, length - pos);
+    code_length += base64_encode_block ((const char *) data + pos, piece,
+                                        code + code_length, &es);
+  }
+  code_length += base64_encode_blockend (code + code_length, &es);
+  ref_length = test_base64_reference (data, length, ref);
+  if (code_length != ref_length || memcmp (code, ref, code_length)) {
+    SC_LERRORF ("Encoding mismatch for length %ld\n", (long) length);
+    retval = 1;
+  }
+
+  /* line breaks at random places are skipped by the decoder */
+  for (pos = 0, broken_length = 0; pos < code_length; ++pos) {
+    if (rand () % 61 == 0) {
+      broken[broken_length++] = '\n';
+    }
+    broken[broken_length++] = code[pos];
+  }
+  base64_init_decodestate (&ds);
+  for (pos = 0, plain_length = 0; pos < broken_length; pos += piece) {
+    piece = (size_t) rand () % 300;
+    piece = SC_MIN (piece, broken_length - pos);
+    plain_length += base64_decode_block (broken + pos, piece,
+                                         plain + plain_length, &ds);
+  }
+  if (plain_length != length || memcmp (plain, data, length)) {
+    SC_LERRORF ("Decoding mismatch for length %ld\n", (long) length);
+    retval = 1;
+  }
+
+  /* decoding the whole code at once */
+  base64_init_decodestate (&ds);
+  plain_length = base64_decode_block (code, code_length, plain, &ds);
+  if (plain_length != length || memcmp (plain, data, length)) {
+    SC_LERRORF ("Decoding mismatch for length %ld\n", (long) length);
+    retval = 1;
+  }
+
+  SC_FREE (code);
+  SC_FREE (ref);
+  SC_FREE (broken);
+  SC_FREE (plain);
+  return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  size_t              zz, length;
+  unsigned char      *data;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  srand (17);
+  data = SC_ALLOC (unsigned char, TEST_BASE64_MAX);
+  for (zz = 0; zz < TEST_BASE64_MAX; ++zz) {
+    data[zz] = (unsigned char) rand ();
+  }
+
+  /* all short lengths and some long ones */
+  for (length = 0; length < 100; ++length) {
+    failed |= test_base64 (data, length);
+  }
+  for (length = 100; length <= TEST_BASE64_MAX; length += 1 + length / 3) {
+    failed |= test_base64 (data + length % 7,
+                           SC_MIN (length, TEST_BASE64_MAX - 7));
+  }
+  SC_FREE (data);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
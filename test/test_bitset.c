@@ -0,0 +1,182 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_bitset.h>
+
+/* compare a bitset with a reference array of flags */
+static int
+test_bitset_check (sc_bitset_t * bs, const char *ref, size_t n)
+{
+  int                 num_failed = 0;
+  size_t              i, k, count;
+  char               *buffer;
+  sc_bitset_t        *copy;
+
+  if (bs->num_bits != n) {
+    return 1;
+  }
+  count = 0;
+  sc_bitset_rank_build (bs);
+  for (i = 0; i < n; ++i) {
+    num_failed += sc_bitset_get (bs, i) != ref[i];
+    num_failed += sc_bitset_rank (bs, i) != count;
+    if (ref[i]) {
+      num_failed += sc_bitset_select (bs, count) != i;
+      ++count;
+    }
+  }
+  num_failed += sc_bitset_rank (bs, n) != count;
+  num_failed += sc_bitset_count (bs) != count;
+  num_failed += sc_bitset_select (bs, count) != n;
+
+  /* iterate over the set bits */
+  k = 0;
+  for (i = sc_bitset_next (bs, 0); i < n; i = sc_bitset_next (bs, i + 1)) {
+    num_failed += !ref[i];
+    ++k;
+  }
+  num_failed += k != count;
+
+  /* round trip through a packed buffer */
+  buffer = SC_ALLOC (char, sc_bitset_pack_size (n) + 1);
+  sc_bitset_pack (bs, buffer);
+  copy = sc_bitset_new (3);
+  sc_bitset_unpack (copy, n, buffer);
+  for (i = 0; i < n; ++i) {
+    num_failed += sc_bitset_get (copy, i) != ref[i];
+  }
+  if (n > 0) {
+    num_failed += (((unsigned char *) buffer)[0] & 1) != ref[0];
+  }
+  sc_bitset_destroy (copy);
+  SC_FREE (buffer);
+
+  return num_failed;
+}
+
+static int
+test_bitset (size_t n)
+{
+  int                 num_failed = 0;
+  size_t              i;
+  char               *ref, *ref2;
+  sc_bitset_t        *bs, *other;
+
+  ref = SC_ALLOC_ZERO (char, n + 1);
+  ref2 = SC_ALLOC_ZERO (char, n + 1);
+  bs = sc_bitset_new (n);
+  other = sc_bitset_new (n);
+  num_failed += test_bitset_check (bs, ref, n);
+
+  for (i = 0; i < n; ++i) {
+    if (rand () % 3 == 0 || (i >= 700 && i < 1300)) {
+      sc_bitset_set (bs, i);
+      ref[i] = 1;
+    }
+    if (rand () % 2) {
+      sc_bitset_assign (other, i, 1);
+      ref2[i] = 1;
+    }
+  }
+  num_failed += test_bitset_check (bs, ref, n);
+
+  sc_bitset_xor (bs, other);
+  for (i = 0; i < n; ++i) {
+    ref[i] ^= ref2[i];
+  }
+  num_failed += test_bitset_check (bs, ref, n);
+  sc_bitset_or (bs, other);
+  for (i = 0; i < n; ++i) {
+    ref[i] |= ref2[i];
+  }
+  num_failed += test_bitset_check (bs, ref, n);
+  sc_bitset_not (other);
+  sc_bitset_and (bs, other);
+  for (i = 0; i < n; ++i) {
+    ref2[i] = !ref2[i];
+    ref[i] &= ref2[i];
+  }
+  num_failed += test_bitset_check (bs, ref, n);
+  sc_bitset_fill (bs, 1);
+  sc_bitset_andnot (bs, other);
+  for (i = 0; i < n; ++i) {
+    ref[i] = !ref2[i];
+  }
+  num_failed += test_bitset_check (bs, ref, n);
+
+  /* growing appends cleared bits and shrinking forgets the tail */
+  sc_bitset_resize (bs, n + 77);
+  ref = SC_REALLOC (ref, char, n + 78);
+  memset (ref + n, 0, 78);
+  num_failed += test_bitset_check (bs, ref, n + 77);
+  sc_bitset_resize (bs, n / 2);
+  sc_bitset_resize (bs, n);
+  memset (ref + n / 2, 0, n - n / 2);
+  num_failed += test_bitset_check (bs, ref, n);
+  for (i = 0; i < n; ++i) {
+    sc_bitset_clear (bs, i);
+  }
+  num_failed += sc_bitset_count (bs) != 0;
+
+  SC_GLOBAL_INFOF ("Bitset of %llu bits uses %llu bytes\n",
+                   (unsigned long long) n,
+                   (unsigned long long) sc_bitset_memory_used (bs));
+  sc_bitset_destroy (bs);
+  sc_bitset_destroy (other);
+  SC_FREE (ref);
+  SC_FREE (ref2);
+
+  if (num_failed) {
+    SC_LERRORF ("Bitset of %llu bits failed %d checks\n",
+                (unsigned long long) n, num_failed);
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  srand (11);
+  num_failed += test_bitset (0);
+  num_failed += test_bitset (1);
+  num_failed += test_bitset (64);
+  num_failed += test_bitset (512);
+  num_failed += test_bitset (3001);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
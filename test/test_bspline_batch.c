@@ -0,0 +1,144 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_bspline.h>
+#include <sc_random.h>
+
+#define TEST_BSPLINE_NUM_T 300
+
+static int
+test_bspline_batch_compare (sc_bspline_t * bs, int order, size_t num_t,
+                            const double *t, sc_dmatrix_t * works)
+{
+  int                 num_failed = 0;
+  int                 k;
+  size_t              zz;
+  double             *result, *single;
+
+  result = SC_ALLOC (double, num_t * bs->d);
+  single = SC_ALLOC (double, bs->d);
+  sc_bspline_derivative_n_batch (bs, order, num_t, t, result, works);
+  for (zz = 0; zz < num_t; ++zz) {
+    sc_bspline_derivative_n (bs, order, t[zz], single);
+    for (k = 0; k < bs->d; ++k) {
+      if (fabs (result[zz * bs->d + k] - single[k]) >
+          1.e-10 * (1. + fabs (single[k]))) {
+        SC_LERRORF ("Degree %d order %d at %g: %g instead of %g\n",
+                    bs->n, order, t[zz], result[zz * bs->d + k],
+                    single[k]);
+        ++num_failed;
+      }
+    }
+  }
+  SC_FREE (single);
+  SC_FREE (result);
+  return num_failed;
+}
+
+static int
+test_bspline_batch (int n, int d, int np, int length,
+                    sc_rand_state_t * state)
+{
+  int                 num_failed = 0;
+  int                 i, k, order;
+  size_t              zz;
+  double              t0, t1, *t;
+  sc_dmatrix_t       *points, *knots, *works;
+  sc_bspline_t       *bs;
+
+  points = sc_dmatrix_new (np, d);
+  for (i = 0; i < np; ++i) {
+    for (k = 0; k < d; ++k) {
+      points->e[i][k] = i + sc_rand (state);
+    }
+  }
+  knots = length ? sc_bspline_knots_new_length (n, points) :
+    sc_bspline_knots_new (n, points);
+  bs = sc_bspline_new (n, points, knots, NULL);
+  t0 = knots->e[0][n];
+  t1 = knots->e[0][n + bs->l];
+
+  /* parameters in random order including the end points */
+  t = SC_ALLOC (double, TEST_BSPLINE_NUM_T);
+  for (zz = 0; zz < TEST_BSPLINE_NUM_T; ++zz) {
+    t[zz] = t0 + sc_rand (state) * (t1 - t0);
+  }
+  t[7] = t0;
+  t[13] = t1;
+  t[19] = knots->e[0][n + bs->l / 2];
+  works = sc_bspline_workspace_batch_new (n, d);
+  for (order = 0; order <= n + 1; ++order) {
+    num_failed += test_bspline_batch_compare (bs, order, TEST_BSPLINE_NUM_T,
+                                              t, works);
+  }
+
+  /* ascending parameters as in a sweep */
+  for (zz = 0; zz < TEST_BSPLINE_NUM_T; ++zz) {
+    t[zz] = t0 + zz * (t1 - t0) / (TEST_BSPLINE_NUM_T - 1);
+  }
+  t[TEST_BSPLINE_NUM_T - 1] = t1;
+  num_failed += test_bspline_batch_compare (bs, 0, TEST_BSPLINE_NUM_T,
+                                            t, NULL);
+  num_failed += test_bspline_batch_compare (bs, 1, 5, t + 100, works);
+  num_failed += test_bspline_batch_compare (bs, 0, 0, t, works);
+
+  sc_dmatrix_destroy (works);
+  SC_FREE (t);
+  sc_bspline_destroy (bs);
+  sc_dmatrix_destroy (knots);
+  sc_dmatrix_destroy (points);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 n, d, np;
+  sc_rand_state_t     state = 11;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (n = 0; n <= 4; ++n) {
+    for (d = 1; d <= 3; ++d) {
+      for (np = n + 1; np <= n + 90; np += 29) {
+        num_failed += test_bspline_batch (n, d, np, 0, &state);
+        if (n >= 1) {
+          num_failed += test_bspline_batch (n, d, np, 1, &state);
+        }
+      }
+    }
+  }
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
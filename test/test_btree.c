@@ -0,0 +1,174 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_btree.h>
+
+/** An element that is large enough for the minimum node size. */
+typedef struct test_btree_big
+{
+  int                 key;
+  char                payload[252];
+}
+test_btree_big_t;
+
+static int
+test_compare_key (const void *v1, const void *v2)
+{
+  const int           i1 = *(const int *) v1;
+  const int           i2 = *(const int *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2 ? 1 : 0;
+}
+
+/** Verify the contents of a tree against a table of present keys. */
+static void
+test_check (sc_btree_t * btree, size_t elem_size, const char *present,
+            int range)
+{
+  int                 i, key, c, expected;
+  size_t              zz, count;
+  void               *found;
+  sc_array_t         *array;
+
+  for (count = 0, i = 0; i < range; ++i) {
+    count += present[i];
+  }
+  SC_CHECK_ABORT (sc_btree_count (btree) == count, "Count");
+
+  array = sc_array_new (elem_size);
+  sc_btree_to_array (btree, array);
+  SC_CHECK_ABORT (array->elem_count == count, "Array count");
+  for (zz = 0, i = 0; i < range; ++i) {
+    if (present[i]) {
+      SC_CHECK_ABORT (*(int *) sc_array_index (array, zz) == i, "Order");
+      ++zz;
+    }
+  }
+  sc_array_destroy (array);
+
+  for (key = -1; key <= range; ++key) {
+    c = sc_btree_search_closest (btree, &key, &found);
+    if (key >= 0 && key < range && present[key]) {
+      SC_CHECK_ABORT (c == 0 && *(int *) found == key, "Closest equal");
+      SC_CHECK_ABORT (sc_btree_search (btree, &key) == found, "Search");
+      continue;
+    }
+    SC_CHECK_ABORT (sc_btree_search (btree, &key) == NULL, "Search none");
+
+    /* the smallest greater key or else the greatest key */
+    for (expected = SC_MAX (key + 1, 0);
+         expected < range && !present[expected]; ++expected);
+    if (expected >= range) {
+      for (expected = range - 1; expected >= 0 && !present[expected];
+           --expected);
+    }
+    if (expected < 0) {
+      SC_CHECK_ABORT (c == 0 && found == NULL, "Closest empty");
+    }
+    else {
+      SC_CHECK_ABORT (c == (key < expected ? -1 : 1) &&
+                      *(int *) found == expected, "Closest");
+    }
+  }
+}
+
+static void
+test_btree (size_t elem_size, int range, int num_ops)
+{
+  int                 op, key;
+  char               *present;
+  test_btree_big_t    elem, found;
+  sc_btree_t         *btree;
+
+  present = SC_ALLOC_ZERO (char, range);
+  btree = sc_btree_new (elem_size, test_compare_key);
+  memset (&elem, 0, sizeof (elem));
+
+  /* random insertions that grow the tree, then random deletions */
+  for (op = 0; op < num_ops; ++op) {
+    elem.key = key = rand () % range;
+    if (op < num_ops / 2 ? rand () % 4 != 0 : rand () % 4 == 0) {
+      SC_CHECK_ABORT (sc_btree_insert (btree, &elem) == !present[key],
+                      "Insert");
+      present[key] = 1;
+    }
+    else {
+      found.key = -1;
+      SC_CHECK_ABORT (sc_btree_remove (btree, &elem, &found) ==
+                      present[key], "Remove");
+      SC_CHECK_ABORT (found.key == (present[key] ? key : -1), "Removed");
+      present[key] = 0;
+    }
+    if (op % (num_ops / 8) == 0) {
+      test_check (btree, elem_size, present, range);
+    }
+  }
+  test_check (btree, elem_size, present, range);
+
+  /* remove the remaining elements in order */
+  for (key = 0; key < range; ++key) {
+    elem.key = key;
+    SC_CHECK_ABORT (sc_btree_remove (btree, &elem, NULL) == present[key],
+                    "Remove all");
+    present[key] = 0;
+  }
+  test_check (btree, elem_size, present, range);
+
+  /* ascending insertion as for a bulk load */
+  for (key = 0; key < range; key += 2) {
+    elem.key = key;
+    sc_btree_insert (btree, &elem);
+    present[key] = 1;
+  }
+  test_check (btree, elem_size, present, range);
+  SC_GLOBAL_INFOF ("B-tree of %llu elements of size %llu uses %llu bytes\n",
+                   (unsigned long long) sc_btree_count (btree),
+                   (unsigned long long) elem_size,
+                   (unsigned long long) sc_btree_memory_used (btree));
+  sc_btree_truncate (btree);
+  SC_CHECK_ABORT (sc_btree_count (btree) == 0, "Truncate");
+
+  sc_btree_destroy (btree);
+  SC_FREE (present);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_btree (sizeof (int), 3000, 20000);
+  test_btree (sizeof (test_btree_big_t), 500, 4000);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,241 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_allgather.h>
+#include <sc_notify.h>
+
+/* Device memory is emulated by host memory that the library must not
+ * touch directly, so every access goes through the copy function. */
+static int          test_copies = 0;
+
+static void        *
+test_malloc (sc_memory_domain_t domain, size_t size, void *user)
+{
+  return malloc (size);
+}
+
+static void
+test_free (sc_memory_domain_t domain, void *ptr, void *user)
+{
+  free (ptr);
+}
+
+static void
+test_copy (void *dest, const void *src, size_t n, void *user)
+{
+  ++test_copies;
+  memcpy (dest, src, n);
+}
+
+/** Return a new array with the elements of another in a domain. */
+static sc_array_t  *
+test_array_domain (sc_array_t * src, sc_memory_domain_t domain)
+{
+  sc_array_t         *dest = sc_array_new_domain (src->elem_size, domain);
+
+  sc_array_copy (dest, src);
+  return dest;
+}
+
+/** Return true if two arrays in any domain differ. */
+static int
+test_array_differs (sc_array_t * host, sc_array_t * other)
+{
+  int                 differs;
+  sc_array_t         *back = test_array_domain (other, SC_MEMORY_HOST);
+
+  differs = host->elem_count != back->elem_count ||
+    (host->elem_count > 0 && memcmp (host->array, back->array,
+                                     host->elem_count * host->elem_size));
+  sc_array_destroy (back);
+  return differs;
+}
+
+static int
+test_allgather (sc_MPI_Comm mpicomm, int rank, int size, int count)
+{
+  int                 mpiret;
+  int                 i, num_failed = 0;
+  int                 copies = test_copies;
+  sc_array_t         *mine, *all, *dmine, *dall;
+
+  mine = sc_array_new_count (sizeof (int), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_index_int (mine, i) = rank * count + 7 * i;
+  }
+  all = sc_array_new_count (sizeof (int), (size_t) (size * count));
+  mpiret = sc_MPI_Allgather (mine->array, count, sc_MPI_INT,
+                             all->array, count, sc_MPI_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  dmine = test_array_domain (mine, SC_MEMORY_DEVICE);
+  dall = sc_array_new_domain (sizeof (int), SC_MEMORY_DEVICE);
+  sc_array_resize (dall, (size_t) (size * count));
+  sc_allgather_domain (dmine->array, count, sc_MPI_INT, dall->array,
+                       count, sc_MPI_INT, SC_MEMORY_DEVICE, mpicomm);
+  num_failed += test_array_differs (all, dall);
+  num_failed += size > 1 && count > 0 && test_copies == copies;
+
+  sc_array_destroy (mine);
+  sc_array_destroy (all);
+  sc_array_destroy (dmine);
+  sc_array_destroy (dall);
+  return num_failed;
+}
+
+/** Separate consecutive notify calls, which may share message tags. */
+static void
+test_barrier (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/** Compare notify with device payloads to the same call on the host. */
+static int
+test_notify (sc_MPI_Comm mpicomm, int rank, int size, int variable)
+{
+  int                 i, r, num_failed = 0;
+  sc_array_t         *receivers, *senders, *dsenders;
+  sc_array_t         *payload, *result, *dpayload, *dresult;
+  sc_array_t         *in_offsets, *out_offsets, *dout_offsets;
+  sc_notify_t        *notify;
+
+  notify = sc_notify_new (mpicomm);
+  receivers = sc_array_new (sizeof (int));
+  payload = sc_array_new (3 * sizeof (int));
+  in_offsets = sc_array_new (sizeof (int));
+  *(int *) sc_array_push (in_offsets) = 0;
+  for (r = 0; r < size; ++r) {
+    if ((r * 5 + rank) % 3 == 0) {
+      *(int *) sc_array_push (receivers) = r;
+
+      /* the variable payload has one or two entries per receiver */
+      for (i = 0; i < (variable ? 1 + r % 2 : 1); ++i) {
+        int                *p = (int *) sc_array_push (payload);
+
+        p[0] = rank;
+        p[1] = r;
+        p[2] = rank * size + r;
+      }
+      *(int *) sc_array_push (in_offsets) = (int) payload->elem_count;
+    }
+  }
+  dpayload = test_array_domain (payload, SC_MEMORY_DEVICE);
+
+  senders = sc_array_new (sizeof (int));
+  dsenders = sc_array_new (sizeof (int));
+  result = sc_array_new (3 * sizeof (int));
+  dresult = sc_array_new_domain (3 * sizeof (int), SC_MEMORY_DEVICE);
+  out_offsets = sc_array_new (sizeof (int));
+  dout_offsets = sc_array_new (sizeof (int));
+  if (variable) {
+    sc_notify_payloadv (receivers, senders, payload, result,
+                        in_offsets, out_offsets, 1, notify);
+    test_barrier (mpicomm);
+    sc_notify_payloadv (receivers, dsenders, dpayload, dresult,
+                        in_offsets, dout_offsets, 1, notify);
+    num_failed += test_array_differs (out_offsets, dout_offsets);
+  }
+  else {
+    sc_notify_payload (receivers, senders, payload, result, 1, notify);
+    test_barrier (mpicomm);
+    sc_notify_payload (receivers, dsenders, dpayload, dresult, 1, notify);
+  }
+  num_failed += test_array_differs (senders, dsenders);
+  num_failed += test_array_differs (result, dresult);
+  num_failed += dresult->domain != SC_MEMORY_DEVICE;
+
+  /* without output array the result replaces the device payload */
+  if (!variable) {
+    test_barrier (mpicomm);
+    sc_notify_payload (receivers, dsenders, dpayload, NULL, 1, notify);
+    num_failed += test_array_differs (result, dpayload);
+    num_failed += dpayload->domain != SC_MEMORY_DEVICE;
+    for (i = 0; i < (int) result->elem_count; ++i) {
+      int                *p = (int *) sc_array_index_int (result, i);
+
+      num_failed += p[1] != rank || p[2] != p[0] * size + rank;
+    }
+  }
+
+  sc_array_destroy (receivers);
+  sc_array_destroy (senders);
+  sc_array_destroy (dsenders);
+  sc_array_destroy (payload);
+  sc_array_destroy (dpayload);
+  sc_array_destroy (result);
+  sc_array_destroy (dresult);
+  sc_array_destroy (in_offsets);
+  sc_array_destroy (out_offsets);
+  sc_array_destroy (dout_offsets);
+  sc_notify_destroy (notify);
+  test_barrier (mpicomm);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 num_failed = 0;
+  sc_MPI_Comm         mpicomm;
+  sc_memory_backend_t backend;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  memset (&backend, 0, sizeof (backend));
+  backend.malloc_fn = test_malloc;
+  backend.free_fn = test_free;
+  backend.copy_fn = test_copy;
+  sc_memory_set_backend (&backend);
+
+  if (!sc_mpi_is_device_aware ()) {
+    num_failed += test_allgather (mpicomm, rank, size, 0);
+    num_failed += test_allgather (mpicomm, rank, size, 1);
+    num_failed += test_allgather (mpicomm, rank, size, 5000);
+  }
+  num_failed += test_notify (mpicomm, rank, size, 0);
+  num_failed += test_notify (mpicomm, rank, size, 1);
+
+  sc_memory_set_backend (NULL);
+  if (num_failed) {
+    SC_LERRORF ("Device payload tests failed: %d\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dht.h>
+
+typedef struct test_node
+{
+  int32_t             x, y;
+}
+test_node_t;
+
+static unsigned
+test_node_hash (const void *v, const void *u)
+{
+  const test_node_t  *n = (const test_node_t *) v;
+  uint32_t            a = (uint32_t) n->x, b = (uint32_t) n->y, c = 0;
+
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+  return (unsigned) c;
+}
+
+static int
+test_node_equal (const void *v1, const void *v2, const void *u)
+{
+  const test_node_t  *n1 = (const test_node_t *) v1;
+  const test_node_t  *n2 = (const test_node_t *) v2;
+
+  return n1->x == n2->x && n1->y == n2->y;
+}
+
+/** Fill the corners of the cells of a rank, including duplicates.
+ * If \a absent is true, use nodes below the mesh instead. */
+static void
+test_dht_nodes (sc_array_t * keys, int rank, int absent)
+{
+  int                 i, row, a, b;
+  test_node_t        *n;
+
+  sc_array_reset (keys);
+  for (i = 0; i < 4; ++i) {
+    for (row = 0; row < 2; ++row) {
+      for (a = 0; a < 2; ++a) {
+        for (b = 0; b < 2; ++b) {
+          n = (test_node_t *) sc_array_push (keys);
+          n->x = 4 * rank + i + a;
+          n->y = absent ? -1 - b : row + b;
+        }
+      }
+    }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 num_failed = 0;
+  long                hits, misses;
+  long long           added, gadded;
+  size_t              zz, *offsets;
+  sc_dht_loc_t       *l1, *l2;
+  sc_array_t         *keys, *locs, *again;
+  sc_dht_t           *dht;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* neighboring ranks share the nodes of one column */
+  dht = sc_dht_new (sc_MPI_COMM_WORLD, sizeof (test_node_t),
+                    test_node_hash, test_node_equal, NULL);
+  keys = sc_array_new (sizeof (test_node_t));
+  locs = sc_array_new (sizeof (sc_dht_loc_t));
+  again = sc_array_new (sizeof (sc_dht_loc_t));
+  test_dht_nodes (keys, rank, 0);
+  sc_dht_insert_unique (dht, keys, locs);
+
+  /* every node is added exactly once */
+  added = 0;
+  for (zz = 0; zz < locs->elem_count; ++zz) {
+    l1 = (sc_dht_loc_t *) sc_array_index (locs, zz);
+    added += l1->added;
+    num_failed += l1->owner != sc_dht_owner (dht, sc_array_index (keys, zz))
+      || l1->position < 0;
+  }
+  mpiret = sc_MPI_Allreduce (&added, &gadded, 1, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_SUM, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  offsets = SC_ALLOC (size_t, size + 1);
+  sc_dht_offsets (dht, offsets);
+  if (gadded != 3 * (4 * size + 1) || offsets[size] != (size_t) gadded ||
+      offsets[rank + 1] - offsets[rank] !=
+      sc_dht_local_keys (dht)->elem_count) {
+    SC_GLOBAL_LERRORF ("DHT added %lld keys of %lld\n", gadded,
+                       (long long) offsets[size]);
+    ++num_failed;
+  }
+
+  /* the same batch again finds everything in place and reuses the plan */
+  sc_dht_insert_unique (dht, keys, again);
+  for (zz = 0; zz < locs->elem_count; ++zz) {
+    l1 = (sc_dht_loc_t *) sc_array_index (locs, zz);
+    l2 = (sc_dht_loc_t *) sc_array_index (again, zz);
+    num_failed += l2->added || l1->owner != l2->owner ||
+      l1->position != l2->position;
+  }
+  sc_dht_lookup (dht, keys, again);
+  for (zz = 0; zz < locs->elem_count; ++zz) {
+    l1 = (sc_dht_loc_t *) sc_array_index (locs, zz);
+    l2 = (sc_dht_loc_t *) sc_array_index (again, zz);
+    num_failed += l2->added || l1->owner != l2->owner ||
+      l1->position != l2->position;
+    if (l1->owner == rank) {
+      num_failed += !test_node_equal
+        (sc_array_index (keys, zz),
+         sc_array_index ((sc_array_t *) sc_dht_local_keys (dht),
+                         (size_t) l1->position), NULL);
+    }
+  }
+  sc_dht_get_counts (dht, &hits, &misses);
+  if (hits != 2 || misses != 1) {
+    SC_GLOBAL_LERRORF ("DHT plan hits %ld misses %ld\n", hits, misses);
+    ++num_failed;
+  }
+
+  /* keys that were never inserted */
+  test_dht_nodes (keys, rank, 1);
+  sc_dht_lookup (dht, keys, again);
+  for (zz = 0; zz < again->elem_count; ++zz) {
+    l2 = (sc_dht_loc_t *) sc_array_index (again, zz);
+    num_failed += l2->position != -1 ||
+      l2->owner != sc_dht_owner (dht, sc_array_index (keys, zz));
+  }
+
+  /* an empty batch on some ranks */
+  if (rank % 2) {
+    sc_array_reset (keys);
+  }
+  sc_dht_insert_unique (dht, keys, NULL);
+  sc_dht_offsets (dht, offsets);
+  if (offsets[size] != (size_t) gadded + 10 * (size_t) ((size + 1) / 2)) {
+    SC_GLOBAL_LERRORF ("DHT count %lld after new keys\n",
+                       (long long) offsets[size]);
+    ++num_failed;
+  }
+
+  SC_FREE (offsets);
+  sc_array_destroy (again);
+  sc_array_destroy (locs);
+  sc_array_destroy (keys);
+  sc_dht_destroy (dht);
+
+  SC_CHECK_ABORT (num_failed == 0, "Distributed hash table");
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,242 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+typedef struct test_item
+{
+  int                 value;
+  sc_dlink_t          link;
+}
+test_item_t;
+
+/* compare the list contents in both directions to an expected sequence */
+static int
+test_dlist_check (sc_dlist_t * list, const int *expect, size_t n)
+{
+  size_t              i;
+  sc_dlink_t         *link;
+
+  if (list->elem_count != n) {
+    return 1;
+  }
+  for (i = 0, link = sc_dlist_first (list); i < n;
+       ++i, link = sc_dlist_next (list, link)) {
+    if (link == NULL ||
+        SC_DLIST_ENTRY (link, test_item_t, link)->value != expect[i]) {
+      return 1;
+    }
+  }
+  if (link != NULL) {
+    return 1;
+  }
+  for (i = n, link = sc_dlist_last (list); i > 0;
+       --i, link = sc_dlist_prev (list, link)) {
+    if (link == NULL ||
+        SC_DLIST_ENTRY (link, test_item_t, link)->value != expect[i - 1]) {
+      return 1;
+    }
+  }
+  return link != NULL;
+}
+
+static int
+test_dlist (void)
+{
+  int                 i, num_failed = 0;
+  int                 expect[20];
+  test_item_t        *items[20], *item;
+  sc_dlink_t         *link;
+  sc_dlist_t          list, other;
+  sc_mempool_t       *pool;
+
+  pool = sc_mempool_new (sizeof (test_item_t));
+  sc_dlist_init (&list);
+  sc_dlist_init (&other);
+  num_failed += test_dlist_check (&list, NULL, 0);
+  num_failed += sc_dlist_pop (&list) != NULL;
+
+  for (i = 0; i < 20; ++i) {
+    items[i] = (test_item_t *) sc_mempool_alloc (pool);
+    items[i]->value = i;
+    sc_dlist_append (i < 10 ? &list : &other, &items[i]->link);
+  }
+
+  /* remove every odd element of the first list in O(1) each */
+  for (i = 1; i < 10; i += 2) {
+    sc_dlist_remove (&list, &items[i]->link);
+  }
+  for (i = 0; i < 5; ++i) {
+    expect[i] = 2 * i;
+  }
+  num_failed += test_dlist_check (&list, expect, 5);
+
+  /* put them back in front and behind their neighbors */
+  sc_dlist_insert_after (&list, &items[0]->link, &items[1]->link);
+  sc_dlist_insert_before (&list, &items[4]->link, &items[3]->link);
+  sc_dlist_insert_before (&list, NULL, &items[9]->link);
+  sc_dlist_prepend (&list, &items[5]->link);
+  sc_dlist_insert_after (&list, NULL, &items[7]->link);
+  expect[0] = 7;
+  expect[1] = 5;
+  expect[2] = 0;
+  expect[3] = 1;
+  expect[4] = 2;
+  expect[5] = 3;
+  expect[6] = 4;
+  expect[7] = 6;
+  expect[8] = 8;
+  expect[9] = 9;
+  num_failed += test_dlist_check (&list, expect, 10);
+
+  /* splice the second list after the third element */
+  sc_dlist_splice (&list, &items[0]->link, &other);
+  expect[0] = 7;
+  expect[1] = 5;
+  expect[2] = 0;
+  for (i = 0; i < 10; ++i) {
+    expect[3 + i] = 10 + i;
+  }
+  expect[13] = 1;
+  expect[14] = 2;
+  expect[15] = 3;
+  expect[16] = 4;
+  expect[17] = 6;
+  expect[18] = 8;
+  expect[19] = 9;
+  num_failed += test_dlist_check (&list, expect, 20);
+  num_failed += test_dlist_check (&other, NULL, 0);
+
+  /* drain from both ends and return the items to the pool */
+  for (i = 0; i < 10; ++i) {
+    link = sc_dlist_pop (&list);
+    item = SC_DLIST_ENTRY (link, test_item_t, link);
+    num_failed += item->value != expect[i];
+    sc_mempool_free (pool, item);
+    link = sc_dlist_pop_back (&list);
+    item = SC_DLIST_ENTRY (link, test_item_t, link);
+    num_failed += item->value != expect[19 - i];
+    sc_mempool_free (pool, item);
+  }
+  num_failed += test_dlist_check (&list, NULL, 0);
+  num_failed += pool->elem_count != 0;
+  sc_mempool_destroy (pool);
+
+  if (num_failed) {
+    SC_LERRORF ("Intrusive list failed %d checks\n", num_failed);
+  }
+  return num_failed;
+}
+
+/* run random deque operations against a reference array */
+static int
+test_ulist (size_t per_node, sc_mempool_t * pool)
+{
+  int                 i, j, value, num_failed = 0;
+  int                *ref, num_ref, offset;
+  sc_ulist_t         *ulist;
+
+  ref = SC_ALLOC (int, 4000);
+  offset = 2000;
+  num_ref = 0;
+  ulist = sc_ulist_new (sizeof (int), per_node, pool);
+  for (i = 0; i < 3000; ++i) {
+    j = rand () % 5;
+    if (num_ref > 0 && j == 0) {
+      sc_ulist_pop (ulist, &value);
+      num_failed += value != ref[offset];
+      ++offset;
+      --num_ref;
+    }
+    else if (num_ref > 0 && j == 1) {
+      sc_ulist_pop_back (ulist, &value);
+      --num_ref;
+      num_failed += value != ref[offset + num_ref];
+    }
+    else if (j == 2 && offset > 0) {
+      *(int *) sc_ulist_push_front (ulist) = ref[--offset] = i;
+      ++num_ref;
+    }
+    else if (offset + num_ref < 4000) {
+      *(int *) sc_ulist_push (ulist) = ref[offset + num_ref++] = i;
+    }
+    if ((int) ulist->elem_count != num_ref) {
+      ++num_failed;
+    }
+    else if (num_ref > 0) {
+      num_failed += *(int *) sc_ulist_first (ulist) != ref[offset];
+      num_failed += *(int *) sc_ulist_last (ulist) !=
+        ref[offset + num_ref - 1];
+    }
+  }
+  while (ulist->elem_count > 0) {
+    sc_ulist_pop (ulist, NULL);
+  }
+  num_failed += ulist->nodes.elem_count != 0;
+  for (i = 0; i < 100; ++i) {
+    *(int *) sc_ulist_push (ulist) = i;
+  }
+  sc_ulist_destroy (ulist);
+  SC_FREE (ref);
+
+  if (num_failed) {
+    SC_LERRORF ("Unrolled list with %d per node failed %d checks\n",
+                (int) per_node, num_failed);
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+  sc_mempool_t       *pool;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  srand (13);
+  num_failed += test_dlist ();
+  num_failed += test_ulist (0, NULL);
+  num_failed += test_ulist (1, NULL);
+  num_failed += test_ulist (7, NULL);
+
+  /* two lists may share one node allocator */
+  pool = sc_mempool_new (sc_ulist_node_size (sizeof (int), 5));
+  num_failed += test_ulist (5, pool);
+  num_failed += test_ulist (5, pool);
+  num_failed += pool->elem_count != 0;
+  sc_mempool_destroy (pool);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
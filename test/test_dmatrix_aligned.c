@@ -0,0 +1,360 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_dmatrix.h>
+
+/** Fill a matrix with reproducible values bounded away from zero. */
+static void
+test_dmatrix_aligned_fill (sc_dmatrix_t * X, int seed)
+{
+  sc_bint_t           i, j;
+
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      X->e[i][j] = (double) (((i * 7 + j * 3 + seed) % 13) - 6) + .25;
+    }
+  }
+}
+
+/** Count the entries that differ between two equally sized matrices. */
+static int
+test_dmatrix_aligned_compare (const sc_dmatrix_t * X, const sc_dmatrix_t * Y)
+{
+  int                 num_failed = 0;
+  sc_bint_t           i, j;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      num_failed += fabs (X->e[i][j] - Y->e[i][j]) > 1e-12;
+    }
+  }
+  return num_failed;
+}
+
+/** Check alignment of the rows and that the padding is still zero. */
+static int
+test_dmatrix_aligned_layout (const sc_dmatrix_t * X)
+{
+  int                 num_failed = 0;
+  sc_bint_t           i, j;
+
+  num_failed += X->ld < X->n;
+  num_failed += X->ld % (SC_DMATRIX_ALIGN / sizeof (double)) != 0;
+  for (i = 0; i < X->m; ++i) {
+    num_failed += (uintptr_t) X->e[i] % SC_DMATRIX_ALIGN != 0;
+    for (j = X->n; j < X->ld; ++j) {
+      num_failed += X->e[i][j] != 0.;
+    }
+  }
+  return num_failed;
+}
+
+static int
+test_dmatrix_aligned_elementwise (sc_bint_t m, sc_bint_t n)
+{
+  int                 num_failed = 0;
+  sc_dmatrix_t       *A, *X, *Y, *pA, *pX, *pY;
+
+  A = sc_dmatrix_new (m, n);
+  X = sc_dmatrix_new (m, n);
+  Y = sc_dmatrix_new (m, n);
+  pA = sc_dmatrix_new_aligned (m, n);
+  pX = sc_dmatrix_new_aligned (m, n);
+  pY = sc_dmatrix_new_aligned_zero (m, n);
+  num_failed += test_dmatrix_aligned_layout (pY);
+  num_failed += !sc_dmatrix_is_valid (pY);
+
+  test_dmatrix_aligned_fill (A, 1);
+  test_dmatrix_aligned_fill (X, 2);
+  test_dmatrix_aligned_fill (Y, 3);
+  sc_dmatrix_copy (A, pA);
+  sc_dmatrix_copy (X, pX);
+  sc_dmatrix_copy (Y, pY);
+  num_failed += test_dmatrix_aligned_compare (A, pA);
+  num_failed += !sc_dmatrix_is_valid (pA);
+
+  /* the same operations on both layouts must agree */
+  sc_dmatrix_scale (1.5, Y);
+  sc_dmatrix_scale (1.5, pY);
+  sc_dmatrix_shift (-.5, Y);
+  sc_dmatrix_shift (-.5, pY);
+  sc_dmatrix_scale_shift (.75, 2., Y);
+  sc_dmatrix_scale_shift (.75, 2., pY);
+  num_failed += test_dmatrix_aligned_compare (Y, pY);
+
+  sc_dmatrix_dotmultiply (X, Y);
+  sc_dmatrix_dotmultiply (pX, pY);
+  sc_dmatrix_dotdivide (A, Y);
+  sc_dmatrix_dotdivide (pA, pY);
+  sc_dmatrix_dotmultiply_add (A, X, Y);
+  sc_dmatrix_dotmultiply_add (pA, pX, pY);
+  num_failed += test_dmatrix_aligned_compare (Y, pY);
+
+  /* mix contiguous and padded operands */
+  sc_dmatrix_add (-2., X, Y);
+  sc_dmatrix_add (-2., X, pY);
+  sc_dmatrix_dotmultiply (pA, Y);
+  sc_dmatrix_dotmultiply (A, pY);
+  sc_dmatrix_fabs (pY, pY);
+  sc_dmatrix_fabs (Y, Y);
+  sc_dmatrix_minimum (pX, pY);
+  sc_dmatrix_minimum (X, Y);
+  num_failed += test_dmatrix_aligned_compare (Y, pY);
+
+  sc_dmatrix_set_value (pX, 3.);
+  sc_dmatrix_set_value (X, 3.);
+  num_failed += test_dmatrix_aligned_compare (X, pX);
+
+  num_failed += test_dmatrix_aligned_layout (pA);
+  num_failed += test_dmatrix_aligned_layout (pX);
+  num_failed += test_dmatrix_aligned_layout (pY);
+
+  /* checks find entries anywhere in the matrix */
+  num_failed += !sc_darray_is_range (A->e[0], (size_t) (m * n), -6., 7.);
+  if (m > 0 && n > 0) {
+    A->e[m - 1][n - 1] = 8.;
+    num_failed += sc_darray_is_range (A->e[0], (size_t) (m * n), -6., 7.);
+    pY->e[m - 1][n - 1] = sqrt (-1.);
+    num_failed += sc_dmatrix_is_valid (pY);
+  }
+
+  sc_dmatrix_destroy (A);
+  sc_dmatrix_destroy (X);
+  sc_dmatrix_destroy (Y);
+  sc_dmatrix_destroy (pA);
+  sc_dmatrix_destroy (pX);
+  sc_dmatrix_destroy (pY);
+  return num_failed;
+}
+
+static int
+test_dmatrix_aligned_views (void)
+{
+  int                 num_failed = 0;
+  sc_bint_t           i, j;
+  sc_dmatrix_t       *X, *pX, *cX, *V, *pV, *C;
+
+  X = sc_dmatrix_new (6, 5);
+  pX = sc_dmatrix_new_aligned (6, 5);
+  test_dmatrix_aligned_fill (X, 4);
+  sc_dmatrix_copy (X, pX);
+
+  /* a block of whole rows of a padded matrix */
+  V = sc_dmatrix_new_view_offset (2, 3, 5, X);
+  pV = sc_dmatrix_new_view_offset (2, 3, 5, pX);
+  num_failed += pV->e[0] != pX->e[2] || pV->e[2] != pX->e[4];
+  sc_dmatrix_scale (-1., V);
+  sc_dmatrix_scale (-1., pV);
+  num_failed += test_dmatrix_aligned_compare (X, pX);
+  sc_dmatrix_destroy (V);
+  sc_dmatrix_destroy (pV);
+
+  /* column views keep the row stride of the original */
+  C = sc_dmatrix_new_view_column (X, 3);
+  sc_dmatrix_set_value (C, 9.);
+  sc_dmatrix_view_set_column (C, pX, 3);
+  sc_dmatrix_set_value (C, 9.);
+  num_failed += C->ld != pX->ld;
+  sc_dmatrix_destroy (C);
+  for (i = 0; i < X->m; ++i) {
+    num_failed += X->e[i][3] != 9.;
+    for (j = 0; j < X->n; ++j) {
+      num_failed += j != 3 && X->e[i][j] == 9.;
+    }
+  }
+  num_failed += test_dmatrix_aligned_compare (X, pX);
+
+  /* copies of padded matrices are contiguous */
+  cX = sc_dmatrix_clone (pX);
+  num_failed += cX->ld != cX->n;
+  num_failed += test_dmatrix_aligned_compare (X, cX);
+  sc_dmatrix_destroy (cX);
+
+  /* transposition between layouts */
+  C = sc_dmatrix_new_aligned (5, 6);
+  cX = sc_dmatrix_new_aligned (6, 5);
+  sc_dmatrix_transpose (pX, C);
+  sc_dmatrix_transpose (C, cX);
+  num_failed += test_dmatrix_aligned_compare (X, cX);
+  num_failed += test_dmatrix_aligned_layout (C);
+  num_failed += test_dmatrix_aligned_layout (cX);
+  sc_dmatrix_destroy (C);
+  sc_dmatrix_destroy (cX);
+
+  num_failed += sc_dmatrix_memory_used (pX) <=
+    sc_dmatrix_memory_used (X);
+
+  sc_dmatrix_destroy (X);
+  sc_dmatrix_destroy (pX);
+  return num_failed;
+}
+
+#ifdef SC_WITH_BLAS
+
+static int
+test_dmatrix_aligned_blas (sc_trans_t transa, sc_trans_t transb,
+                           sc_bint_t m, sc_bint_t n, sc_bint_t k)
+{
+  int                 num_failed = 0;
+  sc_dmatrix_t       *A, *B, *C, *pA, *pB, *pC;
+  sc_dmatrix_t       *x, *y, *px, *py;
+
+  A = transa == SC_NO_TRANS ? sc_dmatrix_new (m, k) : sc_dmatrix_new (k, m);
+  B = transb == SC_NO_TRANS ? sc_dmatrix_new (k, n) : sc_dmatrix_new (n, k);
+  C = sc_dmatrix_new (m, n);
+  pA = sc_dmatrix_new_aligned (A->m, A->n);
+  pB = sc_dmatrix_new_aligned (B->m, B->n);
+  pC = sc_dmatrix_new_aligned (m, n);
+  test_dmatrix_aligned_fill (A, 5);
+  test_dmatrix_aligned_fill (B, 6);
+  test_dmatrix_aligned_fill (C, 7);
+  sc_dmatrix_copy (A, pA);
+  sc_dmatrix_copy (B, pB);
+  sc_dmatrix_copy (C, pC);
+
+  sc_dmatrix_multiply (transa, transb, .5, A, B, 2., C);
+  sc_dmatrix_multiply (transa, transb, .5, pA, pB, 2., pC);
+  num_failed += test_dmatrix_aligned_compare (C, pC);
+  num_failed += test_dmatrix_aligned_layout (pC);
+
+  sc_dmatrix_multiply_batch (transa, transb, 1.,
+                             (const sc_dmatrix_t * const *) &pA,
+                             (const sc_dmatrix_t * const *) &pB, -1., &pC,
+                             1);
+  sc_dmatrix_multiply (transa, transb, 1., A, B, -1., C);
+  num_failed += test_dmatrix_aligned_compare (C, pC);
+
+  /* matrix times column vector with padded rows */
+  x = sc_dmatrix_new (k, 1);
+  y = sc_dmatrix_new (m, 1);
+  px = sc_dmatrix_new_aligned (k, 1);
+  py = sc_dmatrix_new_aligned_zero (m, 1);
+  test_dmatrix_aligned_fill (x, 8);
+  sc_dmatrix_copy (x, px);
+  sc_dmatrix_set_zero (y);
+  sc_dmatrix_vector (transa, SC_NO_TRANS, SC_NO_TRANS, 1., A, x, 0., y);
+  sc_dmatrix_vector (transa, SC_NO_TRANS, SC_NO_TRANS, 1., pA, px, 0., py);
+  num_failed += test_dmatrix_aligned_compare (y, py);
+  num_failed += test_dmatrix_aligned_layout (py);
+
+  sc_dmatrix_destroy (x);
+  sc_dmatrix_destroy (y);
+  sc_dmatrix_destroy (px);
+  sc_dmatrix_destroy (py);
+  sc_dmatrix_destroy (A);
+  sc_dmatrix_destroy (B);
+  sc_dmatrix_destroy (C);
+  sc_dmatrix_destroy (pA);
+  sc_dmatrix_destroy (pB);
+  sc_dmatrix_destroy (pC);
+  return num_failed;
+}
+
+#endif /* SC_WITH_BLAS */
+
+#ifdef SC_WITH_LAPACK
+
+static int
+test_dmatrix_aligned_solve (sc_bint_t n, sc_bint_t nrhs)
+{
+  int                 num_failed = 0;
+  sc_bint_t           i;
+  sc_dmatrix_t       *A, *B, *X, *pA, *pB, *pX;
+
+  A = sc_dmatrix_new (n, n);
+  B = sc_dmatrix_new (nrhs, n);
+  X = sc_dmatrix_new (nrhs, n);
+  pA = sc_dmatrix_new_aligned (n, n);
+  pB = sc_dmatrix_new_aligned (nrhs, n);
+  pX = sc_dmatrix_new_aligned (nrhs, n);
+  test_dmatrix_aligned_fill (A, 9);
+  for (i = 0; i < n; ++i) {
+    A->e[i][i] += 4. * n;
+  }
+  test_dmatrix_aligned_fill (B, 10);
+  sc_dmatrix_copy (A, pA);
+  sc_dmatrix_copy (B, pB);
+
+  sc_dmatrix_rdivide (SC_NO_TRANS, B, A, X);
+  sc_dmatrix_rdivide (SC_NO_TRANS, pB, pA, pX);
+  num_failed += test_dmatrix_aligned_compare (X, pX);
+
+  sc_dmatrix_solve_transpose_inplace (A, B);
+  sc_dmatrix_solve_transpose_inplace (pA, pB);
+  num_failed += test_dmatrix_aligned_compare (B, pB);
+  num_failed += test_dmatrix_aligned_layout (pB);
+
+  sc_dmatrix_destroy (A);
+  sc_dmatrix_destroy (B);
+  sc_dmatrix_destroy (X);
+  sc_dmatrix_destroy (pA);
+  sc_dmatrix_destroy (pB);
+  sc_dmatrix_destroy (pX);
+  return num_failed;
+}
+
+#endif /* SC_WITH_LAPACK */
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 s;
+  const sc_bint_t     sizes[][2] = {
+    {1, 1}, {3, 4}, {4, 3}, {5, 8}, {7, 9}, {2, 17}, {0, 5}, {6, 0},
+    {260, 270}, {1, 70000}
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (s = 0; s < (int) (sizeof (sizes) / sizeof (sizes[0])); ++s) {
+    num_failed += test_dmatrix_aligned_elementwise (sizes[s][0],
+                                                    sizes[s][1]);
+  }
+  num_failed += test_dmatrix_aligned_views ();
+#ifdef SC_WITH_BLAS
+  num_failed += test_dmatrix_aligned_blas (SC_NO_TRANS, SC_NO_TRANS, 5, 7, 3);
+  num_failed += test_dmatrix_aligned_blas (SC_TRANS, SC_NO_TRANS, 9, 2, 6);
+  num_failed += test_dmatrix_aligned_blas (SC_NO_TRANS, SC_TRANS, 4, 11, 9);
+  num_failed += test_dmatrix_aligned_blas (SC_TRANS, SC_TRANS, 8, 8, 8);
+#endif
+#ifdef SC_WITH_LAPACK
+  num_failed += test_dmatrix_aligned_solve (5, 3);
+  num_failed += test_dmatrix_aligned_solve (9, 1);
+#endif
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_dmatrix.h>
+
+#define TEST_DMATRIX_BATCH_COUNT 5
+
+/** Reference product of row-major matrices. */
+static void
+test_dmatrix_batch_reference (sc_trans_t transa, sc_trans_t transb,
+                              sc_bint_t m, sc_bint_t n, sc_bint_t k,
+                              double alpha, const double *A,
+                              const double *B, double beta, double *C)
+{
+  sc_bint_t           i, j, l;
+  double              sum, a, b;
+
+  for (i = 0; i < m; ++i) {
+    for (j = 0; j < n; ++j) {
+      sum = 0.;
+      for (l = 0; l < k; ++l) {
+        a = transa == SC_NO_TRANS ? A[i * k + l] : A[l * m + i];
+        b = transb == SC_NO_TRANS ? B[l * n + j] : B[j * k + l];
+        sum += a * b;
+      }
+      C[i * n + j] = alpha * sum + (beta == 0. ? 0. : beta * C[i * n + j]);
+    }
+  }
+}
+
+static int
+test_dmatrix_batch_shape (sc_trans_t transa, sc_trans_t transb,
+                          sc_bint_t m, sc_bint_t n, sc_bint_t k,
+                          double beta, int shared_a)
+{
+  int                 num_failed = 0;
+  int                 i;
+  size_t              zz, sa, sb, sc;
+  double             *A, *B, *C, *D;
+  const double        alpha = .75;
+  sc_dmatrix_t       *mA[TEST_DMATRIX_BATCH_COUNT];
+  sc_dmatrix_t       *mB[TEST_DMATRIX_BATCH_COUNT];
+  sc_dmatrix_t       *mC[TEST_DMATRIX_BATCH_COUNT];
+
+  /* strides with a gap between the matrices */
+  sa = shared_a ? 0 : (size_t) (m * k + 3);
+  sb = (size_t) (k * n + 1);
+  sc = (size_t) (m * n + 2);
+  A = SC_ALLOC (double, (m * k + 3) * TEST_DMATRIX_BATCH_COUNT);
+  B = SC_ALLOC (double, sb * TEST_DMATRIX_BATCH_COUNT);
+  C = SC_ALLOC (double, sc * TEST_DMATRIX_BATCH_COUNT);
+  D = SC_ALLOC (double, sc * TEST_DMATRIX_BATCH_COUNT);
+  for (zz = 0; zz < (size_t) ((m * k + 3) * TEST_DMATRIX_BATCH_COUNT);
+       ++zz) {
+    A[zz] = (double) ((zz * 7) % 11) - 5.;
+  }
+  for (zz = 0; zz < sb * TEST_DMATRIX_BATCH_COUNT; ++zz) {
+    B[zz] = (double) ((zz * 5) % 13) - 6.;
+  }
+  for (zz = 0; zz < sc * TEST_DMATRIX_BATCH_COUNT; ++zz) {
+    /* with a zero beta, C must not be read */
+    C[zz] = D[zz] = beta == 0. ? sqrt (-1.) : (double) (zz % 3);
+  }
+
+  for (i = 0; i < TEST_DMATRIX_BATCH_COUNT; ++i) {
+    test_dmatrix_batch_reference (transa, transb, m, n, k, alpha,
+                                  A + i * sa, B + i * sb, beta, D + i * sc);
+  }
+
+  /* strided storage */
+  sc_dmatrix_multiply_strided (transa, transb, m, n, k, alpha, A, sa,
+                               B, sb, beta, C, sc, TEST_DMATRIX_BATCH_COUNT);
+  for (i = 0; i < TEST_DMATRIX_BATCH_COUNT; ++i) {
+    for (zz = 0; zz < (size_t) (m * n); ++zz) {
+      num_failed += fabs (C[i * sc + zz] - D[i * sc + zz]) > 1e-12;
+    }
+  }
+
+  /* arrays of matrices, which are views into the same storage */
+  for (i = 0; i < TEST_DMATRIX_BATCH_COUNT; ++i) {
+    mA[i] = transa == SC_NO_TRANS ?
+      sc_dmatrix_new_data (m, k, A + i * sa) :
+      sc_dmatrix_new_data (k, m, A + i * sa);
+    mB[i] = transb == SC_NO_TRANS ?
+      sc_dmatrix_new_data (k, n, B + i * sb) :
+      sc_dmatrix_new_data (n, k, B + i * sb);
+    mC[i] = sc_dmatrix_new_data (m, n, C + i * sc);
+    if (beta != 0.) {
+      memcpy (C + i * sc, D + i * sc, m * n * sizeof (double));
+    }
+    test_dmatrix_batch_reference (transa, transb, m, n, k, alpha,
+                                  A + i * sa, B + i * sb, beta, D + i * sc);
+  }
+  sc_dmatrix_multiply_batch (transa, transb, alpha,
+                             (const sc_dmatrix_t * const *) mA,
+                             (const sc_dmatrix_t * const *) mB, beta, mC,
+                             TEST_DMATRIX_BATCH_COUNT);
+  for (i = 0; i < TEST_DMATRIX_BATCH_COUNT; ++i) {
+    for (zz = 0; zz < (size_t) (m * n); ++zz) {
+      num_failed += fabs (C[i * sc + zz] - D[i * sc + zz]) > 1e-12;
+    }
+    sc_dmatrix_destroy (mA[i]);
+    sc_dmatrix_destroy (mB[i]);
+    sc_dmatrix_destroy (mC[i]);
+  }
+
+  SC_FREE (A);
+  SC_FREE (B);
+  SC_FREE (C);
+  SC_FREE (D);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 ta, tb, s;
+  const sc_bint_t     sizes[][3] = {
+    {4, 4, 4}, {8, 8, 8}, {16, 16, 16}, {32, 32, 32},
+    {5, 7, 3}, {1, 9, 2}, {8, 8, 0}, {0, 4, 4}, {64, 64, 64}
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (s = 0; s < (int) (sizeof (sizes) / sizeof (sizes[0])); ++s) {
+    for (ta = 0; ta < 2; ++ta) {
+      for (tb = 0; tb < 2; ++tb) {
+        num_failed += test_dmatrix_batch_shape
+          ((sc_trans_t) ta, (sc_trans_t) tb, sizes[s][0], sizes[s][1],
+           sizes[s][2], 0., 0);
+        num_failed += test_dmatrix_batch_shape
+          ((sc_trans_t) ta, (sc_trans_t) tb, sizes[s][0], sizes[s][1],
+           sizes[s][2], 1.5, s % 2);
+      }
+    }
+  }
+#ifdef SC_WITH_BLAS
+  /* the larger products are passed to BLAS */
+  num_failed += test_dmatrix_batch_shape (SC_TRANS, SC_NO_TRANS,
+                                          70, 3, 5, 0., 0);
+  num_failed += test_dmatrix_batch_shape (SC_NO_TRANS, SC_TRANS,
+                                          3, 5, 80, .5, 1);
+#endif
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
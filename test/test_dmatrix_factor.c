@@ -0,0 +1,252 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_dmatrix.h>
+#include <sc_random.h>
+
+#define TEST_DMATRIX_FACTOR_TOL 1.e-10
+
+/** Fill a matrix with reproducible random entries that require pivoting. */
+static void
+test_dmatrix_factor_fill (sc_dmatrix_t * X, int seed)
+{
+  sc_bint_t           i, j;
+  sc_rand_state_t     state = (sc_rand_state_t) seed;
+
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      X->e[i][j] = sc_rand (&state) - .5;
+    }
+  }
+}
+
+/** Create a symmetric positive definite matrix. */
+static sc_dmatrix_t *
+test_dmatrix_factor_spd (sc_bint_t n)
+{
+  sc_dmatrix_t       *G = sc_dmatrix_new (n, n);
+  sc_dmatrix_t       *S = sc_dmatrix_new (n, n);
+  sc_bint_t           i;
+
+  test_dmatrix_factor_fill (G, 5);
+  sc_dmatrix_multiply (SC_NO_TRANS, SC_TRANS, 1., G, G, 0., S);
+  for (i = 0; i < n; ++i) {
+    S->e[i][i] += n;
+  }
+  sc_dmatrix_destroy (G);
+  return S;
+}
+
+/** Count the entries of two matrices that differ by more than tolerance. */
+static int
+test_dmatrix_factor_compare (const char *what, const sc_dmatrix_t * X,
+                             const sc_dmatrix_t * Y)
+{
+  sc_bint_t           i, j;
+  int                 num_failed = 0;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      if (fabs (X->e[i][j] - Y->e[i][j]) > TEST_DMATRIX_FACTOR_TOL) {
+        ++num_failed;
+      }
+    }
+  }
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("%s: %d entries differ\n", what, num_failed);
+  }
+  return num_failed;
+}
+
+/** Solve with one LU factorization for several right hand sides. */
+static int
+test_dmatrix_factor_lu (sc_bint_t n, sc_bint_t k, int aligned)
+{
+  int                 num_failed = 0;
+  int                 t, r;
+  sc_trans_t          trans;
+  sc_dmatrix_t       *A, *B, *Bt, *C, *Ct, *R, *Rt, *D;
+  sc_dmatrix_lu_t    *lu;
+
+  A = sc_dmatrix_new (n, n);
+  test_dmatrix_factor_fill (A, 0);
+  lu = sc_dmatrix_lu_new (n);
+  if (sc_dmatrix_lu_factor (lu, A) != 0) {
+    SC_GLOBAL_LERROR ("LU factorization failed\n");
+    ++num_failed;
+  }
+
+  B = sc_dmatrix_new (n, k);
+  Bt = sc_dmatrix_new (k, n);
+  R = sc_dmatrix_new (n, k);
+  Rt = sc_dmatrix_new (k, n);
+  D = sc_dmatrix_new (n, k);
+  C = aligned ? sc_dmatrix_new_aligned (n, k) : sc_dmatrix_new (n, k);
+  Ct = aligned ? sc_dmatrix_new_aligned (k, n) : sc_dmatrix_new (k, n);
+
+  for (t = 0; t < 2; ++t) {
+    trans = (sc_trans_t) t;
+    for (r = 0; r < 3; ++r) {
+      /* the factorization is reused for each new right hand side */
+      test_dmatrix_factor_fill (B, 10 * r + 1);
+      sc_dmatrix_copy (B, C);
+      sc_dmatrix_lu_ldivide (lu, trans, C);
+      sc_dmatrix_multiply (trans, SC_NO_TRANS, 1., A, C, 0., R);
+      num_failed += test_dmatrix_factor_compare ("LU ldivide", R, B);
+
+      test_dmatrix_factor_fill (Bt, 10 * r + 2);
+      sc_dmatrix_copy (Bt, Ct);
+      sc_dmatrix_lu_rdivide (lu, trans, Ct);
+      sc_dmatrix_multiply (SC_NO_TRANS, trans, 1., Ct, A, 0., Rt);
+      num_failed += test_dmatrix_factor_compare ("LU rdivide", Rt, Bt);
+    }
+
+    /* the convenience functions agree with the cached factorization */
+    sc_dmatrix_ldivide (trans, A, B, D);
+    sc_dmatrix_copy (B, C);
+    sc_dmatrix_lu_ldivide (lu, trans, C);
+    num_failed += test_dmatrix_factor_compare ("ldivide", D, C);
+  }
+
+  sc_dmatrix_destroy (A);
+  sc_dmatrix_destroy (B);
+  sc_dmatrix_destroy (Bt);
+  sc_dmatrix_destroy (C);
+  sc_dmatrix_destroy (Ct);
+  sc_dmatrix_destroy (R);
+  sc_dmatrix_destroy (Rt);
+  sc_dmatrix_destroy (D);
+  sc_dmatrix_lu_destroy (lu);
+  return num_failed;
+}
+
+/** Solve with one Cholesky factorization for several right hand sides. */
+static int
+test_dmatrix_factor_cholesky (sc_bint_t n, sc_bint_t k, int aligned)
+{
+  int                 num_failed = 0;
+  int                 r;
+  sc_dmatrix_t       *A, *B, *Bt, *C, *Ct, *R, *Rt;
+  sc_dmatrix_cholesky_t *chol;
+
+  A = test_dmatrix_factor_spd (n);
+  chol = sc_dmatrix_cholesky_new (n);
+  if (sc_dmatrix_cholesky_factor (chol, A) != 0) {
+    SC_GLOBAL_LERROR ("Cholesky factorization failed\n");
+    ++num_failed;
+  }
+
+  B = sc_dmatrix_new (n, k);
+  Bt = sc_dmatrix_new (k, n);
+  R = sc_dmatrix_new (n, k);
+  Rt = sc_dmatrix_new (k, n);
+  C = aligned ? sc_dmatrix_new_aligned (n, k) : sc_dmatrix_new (n, k);
+  Ct = aligned ? sc_dmatrix_new_aligned (k, n) : sc_dmatrix_new (k, n);
+
+  for (r = 0; r < 3; ++r) {
+    test_dmatrix_factor_fill (B, 10 * r + 3);
+    sc_dmatrix_copy (B, C);
+    sc_dmatrix_cholesky_ldivide (chol, C);
+    sc_dmatrix_multiply (SC_NO_TRANS, SC_NO_TRANS, 1., A, C, 0., R);
+    num_failed += test_dmatrix_factor_compare ("Cholesky ldivide", R, B);
+
+    test_dmatrix_factor_fill (Bt, 10 * r + 4);
+    sc_dmatrix_copy (Bt, Ct);
+    sc_dmatrix_cholesky_rdivide (chol, Ct);
+    sc_dmatrix_multiply (SC_NO_TRANS, SC_NO_TRANS, 1., Ct, A, 0., Rt);
+    num_failed += test_dmatrix_factor_compare ("Cholesky rdivide", Rt, Bt);
+  }
+
+  sc_dmatrix_destroy (A);
+  sc_dmatrix_destroy (B);
+  sc_dmatrix_destroy (Bt);
+  sc_dmatrix_destroy (C);
+  sc_dmatrix_destroy (Ct);
+  sc_dmatrix_destroy (R);
+  sc_dmatrix_destroy (Rt);
+  sc_dmatrix_cholesky_destroy (chol);
+  return num_failed;
+}
+
+/** Failed factorizations are reported by their LAPACK info. */
+static int
+test_dmatrix_factor_failure (void)
+{
+  int                 num_failed = 0;
+  sc_dmatrix_t       *A;
+  sc_dmatrix_lu_t    *lu;
+  sc_dmatrix_cholesky_t *chol;
+
+  A = sc_dmatrix_new_zero (3, 3);
+  A->e[0][0] = A->e[1][1] = 1.;
+  lu = sc_dmatrix_lu_new (3);
+  if (sc_dmatrix_lu_factor (lu, A) <= 0 || lu->factored) {
+    SC_GLOBAL_LERROR ("Singular LU factorization not detected\n");
+    ++num_failed;
+  }
+  sc_dmatrix_lu_destroy (lu);
+
+  A->e[2][2] = -1.;
+  chol = sc_dmatrix_cholesky_new (3);
+  if (sc_dmatrix_cholesky_factor (chol, A) <= 0 || chol->factored) {
+    SC_GLOBAL_LERROR ("Indefinite Cholesky factorization not detected\n");
+    ++num_failed;
+  }
+  sc_dmatrix_cholesky_destroy (chol);
+
+  sc_dmatrix_destroy (A);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#if defined SC_WITH_BLAS && defined SC_WITH_LAPACK
+  num_failed += test_dmatrix_factor_lu (1, 1, 0);
+  num_failed += test_dmatrix_factor_lu (7, 3, 0);
+  num_failed += test_dmatrix_factor_lu (20, 9, 1);
+  num_failed += test_dmatrix_factor_cholesky (1, 2, 0);
+  num_failed += test_dmatrix_factor_cholesky (12, 5, 0);
+  num_failed += test_dmatrix_factor_cholesky (19, 11, 1);
+  num_failed += test_dmatrix_factor_failure ();
+#endif
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_dmatrix.h>
+
+/** Fill a matrix with reproducible values bounded away from zero. */
+static void
+test_dmatrix_fused_fill (sc_dmatrix_t * X, int seed)
+{
+  sc_bint_t           i, j;
+
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      X->e[i][j] = (double) (((i * 7 + j * 3 + seed) % 13) - 6) + .25;
+    }
+  }
+}
+
+/** Count the entries that differ between two equally sized matrices. */
+static int
+test_dmatrix_fused_compare (const sc_dmatrix_t * X, const sc_dmatrix_t * Y)
+{
+  int                 num_failed = 0;
+  sc_bint_t           i, j;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      num_failed += fabs (X->e[i][j] - Y->e[i][j]) >
+        1e-12 * (1. + fabs (X->e[i][j]));
+    }
+  }
+  return num_failed;
+}
+
+static sc_dmatrix_t *
+test_dmatrix_fused_new (sc_bint_t m, sc_bint_t n, int padded, int seed)
+{
+  sc_dmatrix_t       *X;
+
+  X = padded ? sc_dmatrix_new_aligned (m, n) : sc_dmatrix_new (m, n);
+  test_dmatrix_fused_fill (X, seed);
+  return X;
+}
+
+static int
+test_dmatrix_fused_shape (sc_bint_t m, sc_bint_t n, int padded)
+{
+  int                 num_failed = 0;
+  int                 k;
+  sc_dmatrix_t       *A, *X, *Y, *R, *T;
+  sc_dmatrix_expr_t  *expr;
+
+  A = test_dmatrix_fused_new (m, n, padded, 1);
+  X = test_dmatrix_fused_new (m, n, !padded, 2);
+  Y = test_dmatrix_fused_new (m, n, padded, 3);
+  R = test_dmatrix_fused_new (m, n, 0, 3);
+  T = sc_dmatrix_new (m, n);
+
+  /* axpby against scale and add */
+  sc_dmatrix_axpby (.5, X, -1.5, Y);
+  sc_dmatrix_scale (-1.5, R);
+  sc_dmatrix_add (.5, X, R);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  /* a zero beta must not read NaN entries of the result */
+  sc_dmatrix_set_value (Y, sqrt (-1.));
+  sc_dmatrix_axpby (2., X, 0., Y);
+  sc_dmatrix_copy (X, R);
+  sc_dmatrix_scale (2., R);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  /* generalized multiply-add */
+  sc_dmatrix_dotmultiply_axpby (.25, A, X, 3., -1., Y);
+  sc_dmatrix_copy (A, T);
+  sc_dmatrix_dotmultiply (X, T);
+  sc_dmatrix_scale (.25, T);
+  sc_dmatrix_scale_shift (3., -1., R);
+  sc_dmatrix_add (1., T, R);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  sc_dmatrix_dotmultiply_axpby (-2., NULL, X, .5, 4., Y);
+  sc_dmatrix_scale_shift (.5, 4., R);
+  sc_dmatrix_add (-2., X, R);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  /* clamped powers, also in place */
+  sc_dmatrix_clamp_pow (X, 0., 3., .5, Y);
+  sc_dmatrix_set_zero (T);
+  sc_dmatrix_copy (X, R);
+  sc_dmatrix_maximum (T, R);
+  sc_dmatrix_set_value (T, 3.);
+  sc_dmatrix_minimum (T, R);
+  sc_dmatrix_sqrt (R, R);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+  num_failed += !sc_dmatrix_is_valid (Y);
+
+  sc_dmatrix_clamp_pow (Y, .5, 1.5, 3., Y);
+  sc_dmatrix_set_value (T, .5);
+  sc_dmatrix_maximum (T, R);
+  sc_dmatrix_set_value (T, 1.5);
+  sc_dmatrix_minimum (T, R);
+  sc_dmatrix_pow (3., R);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  /* an expression evaluated twice against the individual operations */
+  expr = sc_dmatrix_expr_new ();
+  sc_dmatrix_expr_scale_shift (expr, 2., -.5);
+  sc_dmatrix_expr_add (expr, -1., X);
+  sc_dmatrix_expr_dotmultiply (expr, A);
+  sc_dmatrix_expr_fabs (expr);
+  sc_dmatrix_expr_clamp (expr, .125, 40.);
+  sc_dmatrix_expr_dotdivide (expr, A);
+  sc_dmatrix_expr_pow (expr, .5);
+  sc_dmatrix_expr_pow (expr, 3.);
+  sc_dmatrix_expr_evaluate (expr, Y);
+  sc_dmatrix_expr_evaluate (expr, Y);
+  sc_dmatrix_expr_destroy (expr);
+  for (k = 0; k < 2; ++k) {
+    sc_dmatrix_scale_shift (2., -.5, R);
+    sc_dmatrix_add (-1., X, R);
+    sc_dmatrix_dotmultiply (A, R);
+    sc_dmatrix_fabs (R, R);
+    sc_dmatrix_set_value (T, .125);
+    sc_dmatrix_maximum (T, R);
+    sc_dmatrix_set_value (T, 40.);
+    sc_dmatrix_minimum (T, R);
+    sc_dmatrix_dotdivide (A, R);
+    sc_dmatrix_sqrt (R, R);
+    sc_dmatrix_pow (3., R);
+  }
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  /* an empty expression leaves the result alone */
+  expr = sc_dmatrix_expr_new ();
+  sc_dmatrix_expr_evaluate (expr, Y);
+  sc_dmatrix_expr_destroy (expr);
+  num_failed += test_dmatrix_fused_compare (R, Y);
+
+  sc_dmatrix_destroy (A);
+  sc_dmatrix_destroy (X);
+  sc_dmatrix_destroy (Y);
+  sc_dmatrix_destroy (R);
+  sc_dmatrix_destroy (T);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 s, padded;
+  const sc_bint_t     sizes[][2] = {
+    {1, 1}, {3, 5}, {7, 9}, {2, 1030}, {0, 4}, {5, 0}, {300, 301}
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (s = 0; s < (int) (sizeof (sizes) / sizeof (sizes[0])); ++s) {
+    for (padded = 0; padded < 2; ++padded) {
+      num_failed += test_dmatrix_fused_shape (sizes[s][0], sizes[s][1],
+                                              padded);
+    }
+  }
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
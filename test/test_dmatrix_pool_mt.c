@@ -0,0 +1,185 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_dmatrix.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_NUM_THREADS 4
+#define TEST_NUM_MATRICES 500
+
+typedef struct test_pool_thread
+{
+  int                 thread_id;
+  sc_dmatrix_pool_mt_t *pool;
+  int                 zero_on_alloc;
+  sc_dmatrix_t      **matrices;  /* shared between all threads */
+}
+test_pool_thread_t;
+
+/** Vary the shapes such that several size classes are in use. */
+static void
+test_pool_shape (int i, sc_bint_t * m, sc_bint_t * n)
+{
+  if (i % 50 == 7) {
+    *m = 60;
+    *n = 70;
+  }
+  else {
+    *m = i % 7;
+    *n = 1 + (3 * i) % 11;
+  }
+}
+
+static void        *
+test_pool_allocate (void *arg)
+{
+  test_pool_thread_t *tt = (test_pool_thread_t *) arg;
+  int                 i;
+  sc_bint_t           m, n, j, k;
+  sc_dmatrix_t       *dm;
+  sc_dmatrix_pool_cache_t cache;
+
+  sc_dmatrix_pool_cache_init (&cache, tt->pool);
+  for (i = 0; i < TEST_NUM_MATRICES; ++i) {
+    test_pool_shape (i, &m, &n);
+    dm = sc_dmatrix_pool_cache_alloc (&cache, m, n);
+    SC_CHECK_ABORT (dm->m == m && dm->n == n && dm->ld == n,
+                    "Pool shape");
+    SC_CHECK_ABORT ((uintptr_t) dm->e[0] % SC_DMATRIX_ALIGN == 0,
+                    "Pool alignment");
+    for (j = 0; j < m; ++j) {
+      for (k = 0; k < n; ++k) {
+        SC_CHECK_ABORT (!tt->zero_on_alloc || dm->e[j][k] == 0.,
+                        "Pool zero");
+        dm->e[j][k] = tt->thread_id * TEST_NUM_MATRICES + i + j - k;
+      }
+    }
+    tt->matrices[tt->thread_id * TEST_NUM_MATRICES + i] = dm;
+  }
+  SC_CHECK_ABORT (cache.elem_count == TEST_NUM_MATRICES, "Pool cache count");
+  sc_dmatrix_pool_cache_reset (&cache);
+  return NULL;
+}
+
+static void        *
+test_pool_release (void *arg)
+{
+  test_pool_thread_t *tt = (test_pool_thread_t *) arg;
+  int                 i, t;
+  sc_bint_t           j, k;
+  sc_dmatrix_t       *dm;
+  sc_dmatrix_pool_cache_t cache;
+
+  /* free the matrices allocated by the next thread */
+  t = (tt->thread_id + 1) % TEST_NUM_THREADS;
+  sc_dmatrix_pool_cache_init (&cache, tt->pool);
+  for (i = 0; i < TEST_NUM_MATRICES; ++i) {
+    dm = tt->matrices[t * TEST_NUM_MATRICES + i];
+    for (j = 0; j < dm->m; ++j) {
+      for (k = 0; k < dm->n; ++k) {
+        SC_CHECK_ABORT (dm->e[j][k] == t * TEST_NUM_MATRICES + i + j - k,
+                        "Pool content");
+      }
+    }
+    sc_dmatrix_pool_cache_free (&cache, dm);
+  }
+  sc_dmatrix_pool_cache_reset (&cache);
+  return NULL;
+}
+
+static void
+test_pool_run (test_pool_thread_t * tt, void *(*fn) (void *))
+{
+  int                 t;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t           threads[TEST_NUM_THREADS];
+
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    pth = pthread_create (&threads[t], NULL, fn, tt + t);
+    SC_CHECK_ABORT (pth == 0, "Pool thread create");
+  }
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Pool thread join");
+  }
+#else
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    (void) fn (tt + t);
+  }
+#endif
+}
+
+static void
+test_pool (size_t slab_size, int zero_on_alloc)
+{
+  int                 t, round;
+  test_pool_thread_t  tt[TEST_NUM_THREADS];
+  sc_dmatrix_t      **matrices;
+  sc_dmatrix_pool_mt_t *pool;
+
+  pool = sc_dmatrix_pool_mt_new (slab_size, zero_on_alloc);
+  matrices = SC_ALLOC (sc_dmatrix_t *, TEST_NUM_THREADS * TEST_NUM_MATRICES);
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    tt[t].thread_id = t;
+    tt[t].pool = pool;
+    tt[t].zero_on_alloc = zero_on_alloc;
+    tt[t].matrices = matrices;
+  }
+  for (round = 0; round < 3; ++round) {
+    test_pool_run (tt, test_pool_allocate);
+    SC_CHECK_ABORT (sc_dmatrix_pool_mt_elem_count (pool) ==
+                    TEST_NUM_THREADS * TEST_NUM_MATRICES, "Pool count");
+    test_pool_run (tt, test_pool_release);
+    SC_CHECK_ABORT (sc_dmatrix_pool_mt_elem_count (pool) == 0,
+                    "Pool count after free");
+  }
+
+  SC_FREE (matrices);
+  sc_dmatrix_pool_mt_destroy (pool);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_pool (0, 0);
+  test_pool (0, 1);
+  test_pool (1 << 16, 0);
+  test_pool (1 << 22, 1);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
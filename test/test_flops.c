@@ -0,0 +1,130 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_flops.h>
+
+static int
+test_statistics_copy (sc_MPI_Comm mpicomm)
+{
+  int                 failed = 0;
+  char                name[BUFSIZ];
+  sc_statistics_t    *stats;
+
+  stats = sc_statistics_new (mpicomm);
+
+  /* the copied name must survive changes to the caller's buffer */
+  snprintf (name, BUFSIZ, "%s", "copied");
+  sc_statistics_add_empty_ext (stats, name, 1);
+  snprintf (name, BUFSIZ, "%s", "changed");
+  if (!sc_statistics_has (stats, "copied") ||
+      sc_statistics_has (stats, "changed")) {
+    SC_GLOBAL_LERROR ("Copied statistics name not found\n");
+    ++failed;
+  }
+  sc_statistics_accumulate (stats, "copied", 2.);
+  sc_statistics_accumulate (stats, "copied", 4.);
+  sc_statistics_compute (stats);
+  if (((sc_statinfo_t *) sc_array_index (stats->sarray, 0))->average != 3.) {
+    SC_GLOBAL_LERROR ("Copied statistics average mismatch\n");
+    ++failed;
+  }
+
+  sc_statistics_destroy (stats);
+  return failed;
+}
+
+static int
+test_flops_events (sc_MPI_Comm mpicomm)
+{
+  int                 i, events, failed = 0;
+  double              sum = 0.;
+  sc_flopinfo_t       fi, snapshot;
+  sc_statistics_t    *stats;
+
+  events = sc_flops_set_events (SC_FLOPS_EVENTS_MEMORY);
+  if (events != sc_flops_num_events () || events > SC_FLOPS_EVENTS) {
+    SC_GLOBAL_LERROR ("Flop event count mismatch\n");
+    ++failed;
+  }
+#ifndef SC_PAPI
+  if (events != 0) {
+    SC_GLOBAL_LERROR ("Flop events without PAPI\n");
+    ++failed;
+  }
+#endif
+  for (i = 0; i < events; ++i) {
+    SC_GLOBAL_INFOF ("Counting flop event %s\n", sc_flops_event_name (i));
+  }
+
+  stats = sc_statistics_new (mpicomm);
+  sc_flops_start (&fi);
+  if (fi.num_events != events) {
+    SC_GLOBAL_LERROR ("Flop info event count mismatch\n");
+    ++failed;
+  }
+  sc_flops_snap (&fi, &snapshot);
+  for (i = 0; i < 1000000; ++i) {
+    sum += 1. / (i + 1.);
+  }
+  sc_flops_shot (&fi, &snapshot);
+  sc_flops_statistics (stats, "harmonic", &snapshot);
+  sc_flops_statistics (stats, "harmonic", &snapshot);
+
+  /* the wall time plus a count and a rate per event */
+  if ((int) stats->sarray->elem_count != 1 + 2 * events ||
+      !sc_statistics_has (stats, "harmonic") || snapshot.iwtime < 0.) {
+    SC_GLOBAL_LERROR ("Flop statistics variables mismatch\n");
+    ++failed;
+  }
+  sc_statistics_compute (stats);
+  sc_statistics_print (stats, sc_package_id, SC_LP_STATISTICS, 1, 0);
+  sc_statistics_destroy (stats);
+
+  SC_GLOBAL_INFOF ("Harmonic sum %g\n", sum);
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  failed += test_statistics_copy (mpicomm);
+  failed += test_flops_events (mpicomm);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
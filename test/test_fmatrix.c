@@ -0,0 +1,246 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_fmatrix.h>
+#include <sc_random.h>
+
+/** Fill a double matrix with reproducible random entries. */
+static void
+test_fmatrix_fill (sc_dmatrix_t * X, int seed)
+{
+  sc_bint_t           i, j;
+  sc_rand_state_t     state = (sc_rand_state_t) seed;
+
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      X->e[i][j] = sc_rand (&state) - .5;
+    }
+  }
+}
+
+/** Count the entries of a float matrix that differ from a double one. */
+static int
+test_fmatrix_compare (const char *what, const sc_fmatrix_t * X,
+                      const sc_dmatrix_t * Y, double tol)
+{
+  sc_bint_t           i, j;
+  int                 num_failed = 0;
+
+  SC_ASSERT (X->m == Y->m && X->n == Y->n);
+  for (i = 0; i < X->m; ++i) {
+    for (j = 0; j < X->n; ++j) {
+      if (fabs ((double) X->e[i][j] - Y->e[i][j]) > tol) {
+        ++num_failed;
+      }
+    }
+  }
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("%s: %d entries differ\n", what, num_failed);
+  }
+  return num_failed;
+}
+
+/** Check element-wise operations and conversions against sc_dmatrix. */
+static int
+test_fmatrix_elementwise (sc_bint_t m, sc_bint_t n)
+{
+  int                 num_failed = 0;
+  sc_dmatrix_t       *dx, *dy, *dz;
+  sc_fmatrix_t       *fx, *fy, *fv;
+
+  dx = sc_dmatrix_new_aligned (m, n);
+  dy = sc_dmatrix_new (m, n);
+  dz = sc_dmatrix_new (m, n);
+  test_fmatrix_fill (dx, 1);
+  test_fmatrix_fill (dy, 2);
+  sc_dmatrix_shift (2., dx);
+
+  fx = sc_fmatrix_new (m, n);
+  fy = sc_fmatrix_new_zero (m, n);
+  sc_fmatrix_from_dmatrix (dx, fx);
+  num_failed += test_fmatrix_compare ("convert", fx, dx, 1.e-6);
+  sc_fmatrix_to_dmatrix (fx, dz);
+  num_failed += test_fmatrix_compare ("widen", fx, dz, 0.);
+
+  sc_fmatrix_from_dmatrix (dy, fy);
+  sc_fmatrix_add (-1.5f, fx, fy);
+  sc_fmatrix_dotmultiply (fx, fy);
+  sc_fmatrix_scale (.25f, fy);
+  sc_fmatrix_shift (3.f, fy);
+  sc_fmatrix_dotdivide (fx, fy);
+  sc_dmatrix_add (-1.5, dx, dy);
+  sc_dmatrix_dotmultiply (dx, dy);
+  sc_dmatrix_scale (.25, dy);
+  sc_dmatrix_shift (3., dy);
+  sc_dmatrix_dotdivide (dx, dy);
+  num_failed += test_fmatrix_compare ("element-wise", fy, dy, 1.e-5);
+
+  /* the correction is added in double precision */
+  sc_dmatrix_copy (dy, dz);
+  sc_fmatrix_add_to_dmatrix (2., fx, dz);
+  sc_dmatrix_add (2., dx, dy);
+  sc_dmatrix_add (-1., dy, dz);
+  if (!sc_darray_is_range (dz->e[0], (size_t) (m * n), -1.e-5, 1.e-5)) {
+    SC_GLOBAL_LERROR ("add to dmatrix\n");
+    ++num_failed;
+  }
+
+  if (m > 1) {
+    fv = sc_fmatrix_new_view_offset (1, m - 1, n, fx);
+    if (fv->e[0][0] != fx->e[1][0] || !sc_fmatrix_is_valid (fv)) {
+      SC_GLOBAL_LERROR ("view offset\n");
+      ++num_failed;
+    }
+    sc_fmatrix_destroy (fv);
+  }
+
+  sc_dmatrix_destroy (dx);
+  sc_dmatrix_destroy (dy);
+  sc_dmatrix_destroy (dz);
+  sc_fmatrix_destroy (fx);
+  sc_fmatrix_destroy (fy);
+  return num_failed;
+}
+
+#if defined SC_WITH_BLAS && defined SC_WITH_LAPACK
+
+/** Check products and solves against sc_dmatrix. */
+static int
+test_fmatrix_linalg (sc_bint_t n, sc_bint_t k)
+{
+  int                 num_failed = 0;
+  int                 t, iter;
+  sc_trans_t          trans;
+  sc_dmatrix_t       *dA, *dB, *dC, *dx, *dy, *dX;
+  sc_fmatrix_t       *fA, *fB, *fC, *fx, *fy;
+
+  dA = sc_dmatrix_new (n, n);
+  dB = sc_dmatrix_new (n, k);
+  dC = sc_dmatrix_new (n, k);
+  dx = sc_dmatrix_new (n, 1);
+  dy = sc_dmatrix_new (n, 1);
+  test_fmatrix_fill (dA, 3);
+  test_fmatrix_fill (dB, 4);
+  test_fmatrix_fill (dx, 5);
+
+  fA = sc_fmatrix_new (n, n);
+  fB = sc_fmatrix_new (n, k);
+  fC = sc_fmatrix_new (n, k);
+  fx = sc_fmatrix_new (n, 1);
+  fy = sc_fmatrix_new_zero (n, 1);
+  sc_fmatrix_from_dmatrix (dA, fA);
+  sc_fmatrix_from_dmatrix (dB, fB);
+  sc_fmatrix_from_dmatrix (dx, fx);
+
+  for (t = 0; t < 2; ++t) {
+    trans = (sc_trans_t) t;
+
+    sc_fmatrix_multiply (trans, SC_NO_TRANS, 2.f, fA, fB, 0.f, fC);
+    sc_dmatrix_multiply (trans, SC_NO_TRANS, 2., dA, dB, 0., dC);
+    num_failed += test_fmatrix_compare ("multiply", fC, dC, 1.e-4);
+
+    sc_fmatrix_vector (trans, SC_NO_TRANS, SC_NO_TRANS, 1.f, fA, fx, 0.f,
+                       fy);
+    sc_dmatrix_vector (trans, SC_NO_TRANS, SC_NO_TRANS, 1., dA, dx, 0.,
+                       dy);
+    num_failed += test_fmatrix_compare ("vector", fy, dy, 1.e-4);
+
+    /* the single precision solve is accurate to single precision */
+    sc_fmatrix_ldivide (trans, fA, fB, fC);
+    sc_dmatrix_ldivide (trans, dA, dB, dC);
+    num_failed += test_fmatrix_compare ("ldivide", fC, dC, 1.e-2);
+  }
+
+  /* right division with the transposed right hand sides */
+  sc_fmatrix_destroy (fC);
+  fC = sc_fmatrix_new (k, n);
+  sc_fmatrix_transpose (fB, fC);
+  sc_fmatrix_rdivide (SC_TRANS, fC, fA, fC);
+  sc_dmatrix_ldivide (SC_NO_TRANS, dA, dB, dC);
+  sc_fmatrix_destroy (fB);
+  fB = sc_fmatrix_new (n, k);
+  sc_fmatrix_transpose (fC, fB);
+  num_failed += test_fmatrix_compare ("rdivide", fB, dC, 1.e-2);
+
+  /* refinement reaches double precision */
+  dX = sc_dmatrix_new (n, k);
+  iter = sc_fmatrix_refine_ldivide (dA, dB, dX, 20, 1.e-13);
+  if (iter <= 0) {
+    SC_GLOBAL_LERRORF ("refinement failed with %d\n", iter);
+    ++num_failed;
+  }
+  else {
+    sc_dmatrix_multiply (SC_NO_TRANS, SC_NO_TRANS, 1., dA, dX, -1., dB);
+    if (!sc_darray_is_range (dB->e[0], (size_t) (n * k), -1.e-12, 1.e-12)) {
+      SC_GLOBAL_LERROR ("refinement residual\n");
+      ++num_failed;
+    }
+    SC_GLOBAL_INFOF ("Refinement of order %d took %d steps\n",
+                     (int) n, iter);
+  }
+
+  sc_dmatrix_destroy (dA);
+  sc_dmatrix_destroy (dB);
+  sc_dmatrix_destroy (dC);
+  sc_dmatrix_destroy (dx);
+  sc_dmatrix_destroy (dy);
+  sc_dmatrix_destroy (dX);
+  sc_fmatrix_destroy (fA);
+  sc_fmatrix_destroy (fB);
+  sc_fmatrix_destroy (fC);
+  sc_fmatrix_destroy (fx);
+  sc_fmatrix_destroy (fy);
+  return num_failed;
+}
+
+#endif
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_fmatrix_elementwise (1, 1);
+  num_failed += test_fmatrix_elementwise (7, 13);
+  num_failed += test_fmatrix_elementwise (40, 3);
+#if defined SC_WITH_BLAS && defined SC_WITH_LAPACK
+  num_failed += test_fmatrix_linalg (1, 1);
+  num_failed += test_fmatrix_linalg (10, 3);
+  num_failed += test_fmatrix_linalg (50, 7);
+#endif
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_functions.h>
+
+#define TEST_INVERT_N 200
+
+typedef struct test_invert
+{
+  int                 kind;
+  long                num_evals;
+}
+test_invert_t;
+
+static double
+test_invert_func (double x, void *data)
+{
+  test_invert_t      *ti = (test_invert_t *) data;
+
+  ++ti->num_evals;
+  switch (ti->kind) {
+  case 0:
+    return x * x * x;
+  case 1:
+    return exp (3. * x);
+  case 2:
+    return -tanh (4. * x);
+  default:
+    /* flat near the root, which stalls plain regula falsi */
+    return sc_intpowf (x, 9);
+  }
+}
+
+static int
+test_invert_check (test_invert_t * ti, double x_low, double x_high,
+                   double y, double x, double rtol)
+{
+  double              range;
+
+  range = fabs (test_invert_func (x_high, ti) - test_invert_func (x_low, ti));
+  return !(x_low <= x && x <= x_high &&
+           fabs (test_invert_func (x, ti) - y) <= rtol * range);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 kind;
+  size_t              i;
+  long                evals_single, evals_batch, evals_table;
+  const double        rtol = 1.e-10;
+  const double        x_low = -1., x_high = 1.5;
+  double              y_low, y_high, y[TEST_INVERT_N], x[TEST_INVERT_N];
+  test_invert_t       ti;
+  sc_function1_inverse_t *inv;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (kind = 0; kind < 4; ++kind) {
+    ti.kind = kind;
+    y_low = test_invert_func (x_low, &ti);
+    y_high = test_invert_func (x_high, &ti);
+    for (i = 0; i < TEST_INVERT_N; ++i) {
+      y[i] = y_low + (y_high - y_low) * i / (TEST_INVERT_N - 1.);
+    }
+
+    /* one target at a time */
+    ti.num_evals = 0;
+    for (i = 0; i < TEST_INVERT_N; ++i) {
+      x[i] = sc_function1_invert (test_invert_func, &ti, x_low, x_high,
+                                  y[i], rtol);
+    }
+    evals_single = ti.num_evals;
+    for (i = 0; i < TEST_INVERT_N; ++i) {
+      num_failed += test_invert_check (&ti, x_low, x_high, y[i], x[i], rtol);
+    }
+
+    /* sorted targets with warm starts */
+    ti.num_evals = 0;
+    sc_function1_invert_batch (test_invert_func, &ti, x_low, x_high,
+                               TEST_INVERT_N, y, x, rtol);
+    evals_batch = ti.num_evals;
+    for (i = 0; i < TEST_INVERT_N; ++i) {
+      num_failed += test_invert_check (&ti, x_low, x_high, y[i], x[i], rtol);
+    }
+
+    /* repeated inversion through a table */
+    inv = sc_function1_inverse_new (test_invert_func, &ti, x_low, x_high,
+                                    65);
+    ti.num_evals = 0;
+    for (i = 0; i < TEST_INVERT_N; ++i) {
+      x[TEST_INVERT_N - 1 - i] =
+        sc_function1_inverse_eval (inv, y[TEST_INVERT_N - 1 - i], rtol);
+    }
+    evals_table = ti.num_evals;
+    for (i = 0; i < TEST_INVERT_N; ++i) {
+      num_failed += test_invert_check (&ti, x_low, x_high, y[i], x[i], rtol);
+    }
+    sc_function1_inverse_destroy (inv);
+
+    SC_GLOBAL_INFOF ("Function %d evaluations single %ld batch %ld"
+                     " table %ld\n", kind, evals_single, evals_batch,
+                     evals_table);
+  }
+
+  /* the identity needs no function */
+  num_failed += sc_function1_invert (NULL, NULL, 0., 1., .25, rtol) != .25;
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_functions.h>
+
+#define TEST_FUNCTION3_N 1000
+
+static int
+test_function3_compare (sc_function3_t f, void *fdata,
+                        sc_function3_batch_t fb, void *fbdata,
+                        const double *x, const double *y, const double *z,
+                        size_t n)
+{
+  int                 num_failed = 0;
+  size_t              i;
+  double             *out;
+
+  out = SC_ALLOC (double, n + 1);
+  out[n] = -7.;
+  fb (x, y, z, out, n, fbdata);
+  for (i = 0; i < n; ++i) {
+    num_failed += fabs (out[i] - f (x[i], y[i], z[i], fdata)) > 1.e-14;
+  }
+  num_failed += out[n] != -7.;
+  SC_FREE (out);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  size_t              i, n;
+  double              c = 1.25;
+  double             *x, *y, *z;
+  sc_function3_meta_t inner, outer, shift, adapt;
+  sc_function3_batch_meta_t binner, bouter, bshift;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  x = SC_ALLOC (double, TEST_FUNCTION3_N);
+  y = SC_ALLOC (double, TEST_FUNCTION3_N);
+  z = SC_ALLOC (double, TEST_FUNCTION3_N);
+  for (i = 0; i < TEST_FUNCTION3_N; ++i) {
+    x[i] = sin (1. + i);
+    y[i] = cos (2. + i);
+    z[i] = sin (3. * i);
+  }
+
+  /* the combinators apply all member functions to the same data */
+  inner.f1 = sc_x3;
+  inner.f2 = sc_y3;
+  inner.f3 = sc_z3;
+  inner.data = NULL;
+  outer.f1 = sc_sum3;
+  outer.f2 = sc_product3;
+  outer.f3 = sc_tensor3;
+  outer.data = &inner;
+  shift.f1 = sc_tensor3;
+  shift.f2 = NULL;
+  shift.parameter2 = .5;
+  shift.data = &outer;
+  binner.f1 = sc_x3_batch;
+  binner.f2 = sc_y3_batch;
+  binner.f3 = sc_z3_batch;
+  binner.data = NULL;
+  bouter.f1 = sc_sum3_batch;
+  bouter.f2 = sc_product3_batch;
+  bouter.f3 = sc_tensor3_batch;
+  bouter.data = &binner;
+  bshift.f1 = sc_tensor3_batch;
+  bshift.f2 = NULL;
+  bshift.parameter2 = .5;
+  bshift.data = &bouter;
+  adapt.f1 = sc_sum3;
+  adapt.data = &shift;
+
+  /* batch sizes below, at, and above the block size */
+  for (n = 0; n <= TEST_FUNCTION3_N; n += 127) {
+    num_failed += test_function3_compare (sc_zero3, NULL, sc_zero3_batch,
+                                          NULL, x, y, z, n);
+    num_failed += test_function3_compare (sc_one3, NULL, sc_one3_batch,
+                                          NULL, x, y, z, n);
+    num_failed += test_function3_compare (sc_two3, NULL, sc_two3_batch,
+                                          NULL, x, y, z, n);
+    num_failed += test_function3_compare (sc_ten3, NULL, sc_ten3_batch,
+                                          NULL, x, y, z, n);
+    num_failed += test_function3_compare (sc_constant3, &c,
+                                          sc_constant3_batch, &c,
+                                          x, y, z, n);
+    num_failed += test_function3_compare (sc_sum3, &inner, sc_sum3_batch,
+                                          &binner, x, y, z, n);
+    num_failed += test_function3_compare (sc_product3, &inner,
+                                          sc_product3_batch, &binner,
+                                          x, y, z, n);
+    num_failed += test_function3_compare (sc_tensor3, &inner,
+                                          sc_tensor3_batch, &binner,
+                                          x, y, z, n);
+    num_failed += test_function3_compare (sc_tensor3, &outer,
+                                          sc_tensor3_batch, &bouter,
+                                          x, y, z, n);
+    num_failed += test_function3_compare (sc_sum3, &shift, sc_sum3_batch,
+                                          &bshift, x, y, z, n);
+    num_failed += test_function3_compare (sc_product3, &shift,
+                                          sc_product3_batch, &bshift,
+                                          x, y, z, n);
+    num_failed += test_function3_compare (sc_sum3, &shift,
+                                          sc_function3_batch_pointwise,
+                                          &adapt, x, y, z, n);
+  }
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  SC_FREE (x);
+  SC_FREE (y);
+  SC_FREE (z);
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
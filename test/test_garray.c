@@ -0,0 +1,196 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_garray.h>
+
+typedef struct test_elem
+{
+  long long           a, b;
+}
+test_elem_t;
+
+static int
+test_garray_check (sc_garray_t * ga, size_t n, long long add_a,
+                   long long add_b, int negate)
+{
+  int                 num_failed = 0;
+  size_t              g;
+  size_t             *gindices;
+  long long           a, b;
+  test_elem_t        *out;
+
+  /* read everything in reverse order, the first element twice */
+  gindices = SC_ALLOC (size_t, n + 1);
+  out = SC_ALLOC (test_elem_t, n + 1);
+  for (g = 0; g < n; ++g) {
+    gindices[g] = n - 1 - g;
+  }
+  gindices[n] = n - 1;
+  sc_garray_get (ga, n + 1, gindices, out);
+  for (g = 0; g <= n; ++g) {
+    a = (long long) gindices[g];
+    b = negate ? a : -a;
+    a = negate ? -a : 3 * a + add_a;
+    num_failed += out[g].a != a || out[g].b != b + add_b;
+  }
+  SC_FREE (out);
+  SC_FREE (gindices);
+
+  return num_failed;
+}
+
+static int
+test_garray_run (sc_MPI_Comm comm, const size_t *offsets, int check_cache)
+{
+  int                 mpiret;
+  int                 rank, size, q;
+  int                 num_failed = 0;
+  long                hits, misses, remote;
+  size_t              g, n, local_count, first;
+  size_t             *gindices;
+  test_elem_t        *local, *in;
+  sc_garray_t        *ga;
+
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  if (offsets == NULL) {
+    ga = sc_garray_new (comm, sizeof (test_elem_t), 10 * size + 3);
+  }
+  else {
+    ga = sc_garray_new_offsets (comm, sizeof (test_elem_t), offsets);
+  }
+  n = sc_garray_offsets (ga)[size];
+  first = sc_garray_offsets (ga)[rank];
+  for (g = 0; g < n; ++g) {
+    q = sc_garray_owner (ga, g);
+    num_failed += g < sc_garray_offsets (ga)[q] ||
+      g >= sc_garray_offsets (ga)[q + 1];
+  }
+
+  /* every process initializes its own block */
+  local = (test_elem_t *) sc_garray_local (ga, &local_count);
+  for (g = 0; g < local_count; ++g) {
+    local[g].a = 3 * (long long) (first + g);
+    local[g].b = -(long long) (first + g);
+  }
+  sc_garray_sync (ga);
+  num_failed += test_garray_check (ga, n, 0, 0, 0);
+
+  /* the second read of remote elements is served by the cache */
+  sc_garray_set_cache (ga, 2 * n);
+  num_failed += test_garray_check (ga, n, 0, 0, 0);
+  num_failed += test_garray_check (ga, n, 0, 0, 0);
+  for (remote = 0, g = 0; g <= n; ++g) {
+    remote += sc_garray_owner (ga, g < n ? g : n - 1) != rank;
+  }
+  sc_garray_get_cache_counts (ga, &hits, &misses);
+  if (check_cache && (hits != remote || misses != 2 * remote)) {
+    SC_LERRORF ("Cache hits %ld misses %ld\n", hits, misses);
+    ++num_failed;
+  }
+
+  /* all processes add to all elements once all reads are done */
+  sc_garray_sync (ga);
+  gindices = SC_ALLOC (size_t, n);
+  in = SC_ALLOC (test_elem_t, n);
+  for (g = 0; g < n; ++g) {
+    gindices[g] = g;
+    in[g].a = rank + 1;
+    in[g].b = 1;
+  }
+  sc_garray_accumulate (ga, n, gindices, in, sc_MPI_LONG_LONG_INT,
+                        sc_MPI_SUM);
+  sc_garray_sync (ga);
+  num_failed += test_garray_check (ga, n, (long long) size * (size + 1) / 2,
+                                   size, 0);
+
+  /* the processes overwrite disjoint strided elements */
+  sc_garray_sync (ga);
+  for (n = 0, g = (size_t) rank; g < sc_garray_offsets (ga)[size];
+       g += size, ++n) {
+    gindices[n] = g;
+    in[n].a = -(long long) g;
+    in[n].b = (long long) g;
+  }
+  sc_garray_put (ga, n, gindices, in);
+  sc_garray_sync (ga);
+  n = sc_garray_offsets (ga)[size];
+  num_failed += test_garray_check (ga, n, 0, 0, 1);
+
+  SC_FREE (in);
+  SC_FREE (gindices);
+  sc_garray_destroy (ga);
+
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size, q;
+  int                 num_failed = 0, check_cache = 0;
+  size_t             *offsets;
+  sc_MPI_Comm         split;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* the world communicator may access blocks on the node directly */
+  num_failed += test_garray_run (sc_MPI_COMM_WORLD, NULL, 0);
+
+  /* a split communicator has no node communicators attached */
+  mpiret = sc_MPI_Comm_split (sc_MPI_COMM_WORLD, 0, rank, &split);
+  SC_CHECK_MPI (mpiret);
+#ifdef SC_ENABLE_MPI
+  check_cache = 1;
+#endif
+  num_failed += test_garray_run (split, NULL, check_cache);
+
+  /* a partition with empty blocks */
+  offsets = SC_ALLOC (size_t, size + 1);
+  offsets[0] = 0;
+  for (q = 0; q < size; ++q) {
+    offsets[q + 1] = offsets[q] + (q % 2 ? 0 : 5 + q);
+  }
+  num_failed += test_garray_run (split, offsets, check_cache);
+  SC_FREE (offsets);
+  mpiret = sc_MPI_Comm_free (&split);
+  SC_CHECK_MPI (mpiret);
+
+  SC_CHECK_ABORT (num_failed == 0, "Global array");
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,465 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_uint128.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_NUM_THREADS 4
+
+static unsigned int
+test_hash_int (const void *v, const void *u)
+{
+  /* deliberately poor hash to exercise collisions */
+  return (unsigned int) (*(const int *) v % 1000);
+}
+
+static int
+test_equal_int (const void *v1, const void *v2, const void *u)
+{
+  return *(const int *) v1 == *(const int *) v2;
+}
+
+static int
+test_count_fn (void **v, const void *u)
+{
+  ++*(size_t *) u;
+  return 1;
+}
+
+static void
+test_flat (int N)
+{
+  int                 i;
+  int                *data;
+  void              **found;
+  void               *removed;
+  size_t              count;
+  sc_hash_flat_t     *hash;
+
+  data = SC_ALLOC (int, N);
+  for (i = 0; i < N; ++i) {
+    data[i] = i;
+  }
+  hash = sc_hash_flat_new (test_hash_int, test_equal_int, &count);
+
+  for (i = 0; i < N; ++i) {
+    SC_CHECK_ABORT (sc_hash_flat_insert_unique (hash, data + i, &found),
+                    "Flat insert");
+    SC_CHECK_ABORT (*found == data + i, "Flat insert found");
+  }
+  SC_CHECK_ABORT (hash->elem_count == (size_t) N, "Flat count");
+  for (i = 0; i < N; ++i) {
+    SC_CHECK_ABORT (!sc_hash_flat_insert_unique (hash, data + i, &found),
+                    "Flat insert duplicate");
+    SC_CHECK_ABORT (*found == data + i, "Flat duplicate found");
+  }
+  sc_hash_flat_print_statistics (sc_package_id, SC_LP_INFO, hash);
+  SC_GLOBAL_INFOF ("Flat hash memory %llu\n",
+                   (unsigned long long) sc_hash_flat_memory_used (hash));
+
+  /* remove every other entry and verify the rest */
+  for (i = 0; i < N; i += 2) {
+    SC_CHECK_ABORT (sc_hash_flat_remove (hash, data + i, &removed),
+                    "Flat remove");
+    SC_CHECK_ABORT (removed == data + i, "Flat removed");
+    SC_CHECK_ABORT (!sc_hash_flat_remove (hash, data + i, NULL),
+                    "Flat remove twice");
+  }
+  for (i = 0; i < N; ++i) {
+    SC_CHECK_ABORT (sc_hash_flat_lookup (hash, data + i, &found) == (i % 2),
+                    "Flat lookup");
+    SC_CHECK_ABORT (!(i % 2) || *found == data + i, "Flat lookup found");
+  }
+  count = 0;
+  sc_hash_flat_foreach (hash, test_count_fn);
+  SC_CHECK_ABORT (count == hash->elem_count, "Flat foreach");
+
+  sc_hash_flat_truncate (hash);
+  SC_CHECK_ABORT (hash->elem_count == 0, "Flat truncate");
+  SC_CHECK_ABORT (!sc_hash_flat_lookup (hash, data + 1, NULL),
+                  "Flat lookup after truncate");
+
+  sc_hash_flat_destroy (hash);
+  SC_FREE (data);
+}
+
+static void
+test_incremental (int N)
+{
+  int                 i;
+  int                *data;
+  void              **found;
+  size_t              count;
+  sc_hash_t          *hash;
+
+  data = SC_ALLOC (int, N);
+  for (i = 0; i < N; ++i) {
+    data[i] = i;
+  }
+  hash = sc_hash_new (test_hash_int, test_equal_int, &count, NULL);
+  sc_hash_set_incremental (hash, 1);
+
+  for (i = 0; i < N; ++i) {
+    SC_CHECK_ABORT (sc_hash_insert_unique (hash, data + i, &found),
+                    "Incremental insert");
+    SC_CHECK_ABORT (*found == data + i, "Incremental insert found");
+
+    /* all objects must be found while a migration may be in progress */
+    SC_CHECK_ABORT (sc_hash_lookup (hash, data + i / 2, &found) &&
+                    *found == data + i / 2, "Incremental lookup");
+  }
+  SC_CHECK_ABORT (hash->resize_actions > 0, "Incremental resize");
+  SC_CHECK_ABORT (hash->migrate_moved > 0, "Incremental migration");
+  count = 0;
+  sc_hash_foreach (hash, test_count_fn);
+  SC_CHECK_ABORT (count == (size_t) N, "Incremental foreach");
+  sc_hash_print_statistics (sc_package_id, SC_LP_INFO, hash);
+
+  for (i = 0; i < N; ++i) {
+    SC_CHECK_ABORT (sc_hash_remove (hash, data + i, NULL),
+                    "Incremental remove");
+    SC_CHECK_ABORT (!sc_hash_lookup (hash, data + i, NULL),
+                    "Incremental remove lookup");
+  }
+  SC_CHECK_ABORT (hash->elem_count == 0, "Incremental count");
+
+  /* leave the table in the middle of a migration before destroying it */
+  for (i = 0; i < N; ++i) {
+    (void) sc_hash_insert_unique (hash, data + i, NULL);
+  }
+  sc_hash_destroy (hash);
+  SC_FREE (data);
+}
+
+typedef struct test_concurrent
+{
+  int                 thread_id;
+  int                 N;
+  int                *data;
+  size_t              added;
+  sc_hash_concurrent_t *hash;
+}
+test_concurrent_t;
+
+static int
+test_concurrent_count_fn (void **v, const void *u)
+{
+  SC_CHECK_ABORT (**(int **) v >= 0, "Concurrent foreach object");
+  return 1;
+}
+
+static void        *
+test_concurrent_worker (void *arg)
+{
+  test_concurrent_t  *tc = (test_concurrent_t *) arg;
+  int                 i;
+  void               *found;
+
+  /* all threads insert all objects and race for them */
+  tc->added = 0;
+  for (i = 0; i < tc->N; ++i) {
+    if (sc_hash_concurrent_insert_unique (tc->hash, tc->data + i, &found)) {
+      ++tc->added;
+    }
+    SC_CHECK_ABORT (*(int *) found == i, "Concurrent insert found");
+  }
+  return NULL;
+}
+
+static void        *
+test_concurrent_remover (void *arg)
+{
+  test_concurrent_t  *tc = (test_concurrent_t *) arg;
+  int                 i;
+  void               *found;
+
+  /* every thread removes a disjoint set of objects */
+  for (i = tc->thread_id; i < tc->N; i += TEST_NUM_THREADS) {
+    SC_CHECK_ABORT (sc_hash_concurrent_lookup (tc->hash, tc->data + i,
+                                               &found) &&
+                    found == tc->data + i, "Concurrent lookup");
+    SC_CHECK_ABORT (sc_hash_concurrent_remove (tc->hash, tc->data + i,
+                                               &found) &&
+                    found == tc->data + i, "Concurrent remove");
+  }
+  return NULL;
+}
+
+static void
+test_concurrent_run (test_concurrent_t * tc, void *(*fn) (void *))
+{
+  int                 t;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t           threads[TEST_NUM_THREADS];
+
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    pth = pthread_create (&threads[t], NULL, fn, tc + t);
+    SC_CHECK_ABORT (pth == 0, "Concurrent thread create");
+  }
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Concurrent thread join");
+  }
+#else
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    (void) fn (tc + t);
+  }
+#endif
+}
+
+static void        *
+test_concurrent_iterator (void *arg)
+{
+  test_concurrent_t  *tc = (test_concurrent_t *) arg;
+
+  sc_hash_concurrent_foreach (tc->hash, tc->thread_id, TEST_NUM_THREADS,
+                              test_concurrent_count_fn);
+  return NULL;
+}
+
+static void
+test_concurrent (int num_shards, int N)
+{
+  int                 i, t;
+  int                *data;
+  size_t              added;
+  sc_hash_concurrent_t *hash;
+  test_concurrent_t   tc[TEST_NUM_THREADS];
+
+  data = SC_ALLOC (int, N);
+  for (i = 0; i < N; ++i) {
+    data[i] = i;
+  }
+  hash = sc_hash_concurrent_new (num_shards, test_hash_int, test_equal_int,
+                                 NULL);
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    tc[t].thread_id = t;
+    tc[t].N = N;
+    tc[t].data = data;
+    tc[t].hash = hash;
+  }
+
+  test_concurrent_run (tc, test_concurrent_worker);
+  added = 0;
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    added += tc[t].added;
+  }
+  SC_CHECK_ABORT (added == (size_t) N, "Concurrent insert count");
+  SC_CHECK_ABORT (sc_hash_concurrent_count (hash) == (size_t) N,
+                  "Concurrent count");
+  sc_hash_concurrent_print_statistics (sc_package_id, SC_LP_INFO, hash);
+  SC_GLOBAL_INFOF ("Concurrent hash memory %llu\n", (unsigned long long)
+                   sc_hash_concurrent_memory_used (hash));
+
+  test_concurrent_run (tc, test_concurrent_iterator);
+  test_concurrent_run (tc, test_concurrent_remover);
+  SC_CHECK_ABORT (sc_hash_concurrent_count (hash) == 0,
+                  "Concurrent remove count");
+
+  sc_hash_concurrent_destroy (hash);
+  SC_FREE (data);
+}
+
+static int
+test_equal_u64 (const void *v1, const void *v2, const void *u)
+{
+  return *(const uint64_t *) v1 == *(const uint64_t *) v2;
+}
+
+static void
+test_hash_functions (void)
+{
+  int                 i;
+  size_t              len;
+  char                buffer[129];
+  uint32_t            k32;
+  uint64_t            h, *keys;
+  sc_uint128_t        k128;
+  unsigned int        hv;
+  sc_hash_t          *hash;
+
+  for (len = 0; len < sizeof (buffer); ++len) {
+    buffer[len] = (char) ('a' + len % 26);
+  }
+
+  /* every prefix length hashes differently and independent of alignment */
+  for (len = 0; len + 1 < sizeof (buffer); ++len) {
+    h = sc_hash_bytes (buffer, len, 0);
+    SC_CHECK_ABORT (h != sc_hash_bytes (buffer, len + 1, 0),
+                    "Hash bytes length");
+    SC_CHECK_ABORT (h != sc_hash_bytes (buffer, len, 1), "Hash bytes seed");
+    memmove (buffer + 1, buffer, len);
+    SC_CHECK_ABORT (h == sc_hash_bytes (buffer + 1, len, 0),
+                    "Hash bytes alignment");
+    memmove (buffer, buffer + 1, len);
+  }
+  buffer[sizeof (buffer) - 1] = '\0';
+  SC_CHECK_ABORT (sc_hash_function_string_fast (buffer, NULL) ==
+                  sc_hash_function_string_fast (buffer, NULL),
+                  "Hash string fast");
+
+  /* consecutive keys spread over the low bits used for the slots */
+  k32 = 1;
+  hv = sc_hash_u32 (&k32, NULL);
+  k32 = 2;
+  SC_CHECK_ABORT ((hv & 0xff) != (sc_hash_u32 (&k32, NULL) & 0xff),
+                  "Hash u32");
+  sc_uint128_init (&k128, 1, 0);
+  hv = sc_hash_u128 (&k128, NULL);
+  sc_uint128_init (&k128, 0, 1);
+  SC_CHECK_ABORT (hv != sc_hash_u128 (&k128, NULL), "Hash u128");
+
+  keys = SC_ALLOC (uint64_t, 10000);
+  hash = sc_hash_new (sc_hash_u64, test_equal_u64, NULL, NULL);
+  for (i = 0; i < 10000; ++i) {
+    keys[i] = (uint64_t) i << 32;
+    SC_CHECK_ABORT (sc_hash_insert_unique (hash, keys + i, NULL),
+                    "Hash u64 insert");
+  }
+  sc_hash_print_statistics (sc_package_id, SC_LP_INFO, hash);
+  sc_hash_destroy (hash);
+  SC_FREE (keys);
+}
+
+static void
+test_hash_array (int flat, int N)
+{
+  int                 i, j, *pi;
+  size_t              position;
+  sc_hash_array_t    *ha;
+  sc_array_t          rip;
+
+  ha = flat ?
+    sc_hash_array_new_flat (sizeof (int), test_hash_int, test_equal_int,
+                            NULL) :
+    sc_hash_array_new (sizeof (int), test_hash_int, test_equal_int, NULL);
+
+  /* every value is inserted twice */
+  for (j = 0; j < 2; ++j) {
+    for (i = 0; i < N; ++i) {
+      pi = (int *) sc_hash_array_insert_unique (ha, &i, &position);
+      SC_CHECK_ABORT ((pi != NULL) == (j == 0), "Hash array insert");
+      SC_CHECK_ABORT (position == (size_t) i, "Hash array position");
+      if (pi != NULL) {
+        *pi = i;
+      }
+    }
+  }
+  SC_CHECK_ABORT (ha->a.elem_count == (size_t) N, "Hash array count");
+  SC_CHECK_ABORT (sc_hash_array_is_valid (ha), "Hash array valid");
+  i = N;
+  SC_CHECK_ABORT (!sc_hash_array_lookup (ha, &i, NULL), "Hash array lookup");
+  SC_GLOBAL_INFOF ("Hash array flat %d memory %llu\n", flat,
+                   (unsigned long long) sc_hash_array_memory_used (ha));
+
+  sc_hash_array_truncate (ha);
+  SC_CHECK_ABORT (ha->a.elem_count == 0, "Hash array truncate");
+  i = 3;
+  SC_CHECK_ABORT (sc_hash_array_insert_unique (ha, &i, &position) != NULL &&
+                  position == 0, "Hash array reinsert");
+
+  sc_hash_array_rip (ha, &rip);
+  SC_CHECK_ABORT (rip.elem_count == 1, "Hash array rip");
+  sc_array_reset (&rip);
+}
+
+static void
+test_hash_array_batch (int flat, int N)
+{
+  int                 i;
+  size_t              added;
+  ssize_t             zz;
+  sc_hash_array_t    *ha;
+  sc_array_t         *keys, *pos, *spos;
+
+  ha = flat ?
+    sc_hash_array_new_flat (sizeof (int), test_hash_int, test_equal_int,
+                            NULL) :
+    sc_hash_array_new (sizeof (int), test_hash_int, test_equal_int, NULL);
+
+  /* keys 0, 1, ..., N / 2 - 1, each one appearing twice */
+  keys = sc_array_new_count (sizeof (int), (size_t) N);
+  for (i = 0; i < N; ++i) {
+    *(int *) sc_array_index_int (keys, i) = i / 2;
+  }
+  pos = sc_array_new (sizeof (ssize_t));
+  added = sc_hash_array_insert_unique_batch (ha, keys, pos);
+  SC_CHECK_ABORT (added == (size_t) (N / 2), "Batch insert count");
+  SC_CHECK_ABORT (sc_hash_array_is_valid (ha), "Batch insert valid");
+  for (i = 0; i < N; ++i) {
+    zz = *(ssize_t *) sc_array_index_int (pos, i);
+    SC_CHECK_ABORT (zz == (ssize_t) (i / 2), "Batch insert position");
+    SC_CHECK_ABORT (*(int *) sc_array_index_ssize_t (&ha->a, zz) == i / 2,
+                    "Batch insert copy");
+  }
+
+  /* look up keys of which half are contained */
+  for (i = 0; i < N; ++i) {
+    *(int *) sc_array_index_int (keys, i) = i;
+  }
+  spos = sc_array_new (sizeof (ssize_t));
+  SC_CHECK_ABORT (sc_hash_array_lookup_batch (ha, keys, spos) ==
+                  (size_t) (N / 2), "Batch lookup count");
+  for (i = 0; i < N; ++i) {
+    SC_CHECK_ABORT (*(ssize_t *) sc_array_index_int (spos, i) ==
+                    (i < N / 2 ? (ssize_t) i : -1), "Batch lookup position");
+  }
+
+  sc_array_destroy (spos);
+  sc_array_destroy (pos);
+  sc_array_destroy (keys);
+  sc_hash_array_destroy (ha);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_hash_functions ();
+  test_flat (3);
+  test_flat (5000);
+  test_incremental (20000);
+  test_concurrent (1, 1000);
+  test_concurrent (61, 20000);
+  test_hash_array (0, 4321);
+  test_hash_array (1, 4321);
+  test_hash_array_batch (0, 6790);
+  test_hash_array_batch (1, 6790);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -28,6 +28,9 @@
 */
 
 #include <sc.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 #define SC_TEST_TOOLONG 123456789012345678901234567890123456789
 #define SC_TEST_LONG    1234567890123456789
@@ -75,6 +78,155 @@ test_helpers (const char *str, const char *label, int tint, int tlong)
   return nft;
 }
 
+/** Allocate and free memory from many threads and check the balance. */
+static int
+test_memory_count (int n)
+{
+  int                 i, status;
+  int               **p;
+
+  status = sc_memory_status (sc_package_id);
+  p = SC_ALLOC (int *, n);
+
+  /* the memory may be freed by a different thread than allocated it */
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+  for (i = 0; i < n; ++i) {
+    p[i] = SC_ALLOC (int, 1 + i % 7);
+  }
+  if (sc_memory_status (sc_package_id) != status + n + 1) {
+    SC_GLOBAL_LERROR ("Memory count after parallel allocation\n");
+    return 1;
+  }
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel for schedule(static, 3)
+#endif
+  for (i = 0; i < n; ++i) {
+    SC_FREE (p[i]);
+  }
+  SC_FREE (p);
+
+  if (sc_memory_status (sc_package_id) != status) {
+    SC_GLOBAL_LERROR ("Memory count after parallel free\n");
+    return 1;
+  }
+  return 0;
+}
+
+static void        *
+test_backend_malloc (size_t size, void *user)
+{
+  ++*(int *) user;
+  return malloc (size);
+}
+
+static void        *
+test_backend_realloc (void *ptr, size_t size, void *user)
+{
+  return realloc (ptr, size);
+}
+
+static void
+test_backend_free (void *ptr, void *user)
+{
+  --*(int *) user;
+  free (ptr);
+}
+
+/** Route the allocations of a package through a counting backend. */
+static int
+test_allocator (void)
+{
+  int                 package, live = 0;
+  int                *p, *q;
+  sc_allocator_t      allocator;
+
+  package = sc_package_register (NULL, SC_LP_DEFAULT, "test_allocator",
+                                 "Allocator backend test");
+  allocator.malloc_fn = test_backend_malloc;
+  allocator.calloc_fn = NULL;
+  allocator.realloc_fn = test_backend_realloc;
+  allocator.free_fn = test_backend_free;
+  allocator.user = &live;
+  sc_package_set_allocator (package, &allocator);
+
+  p = (int *) sc_malloc (package, 10 * sizeof (int));
+  q = (int *) sc_calloc (package, 10, sizeof (int));
+  q = (int *) sc_realloc (package, q, 1000 * sizeof (int));
+  if (live != 2 || q[9] != 0 || sc_memory_status (package) != 2) {
+    SC_GLOBAL_LERROR ("Allocator backend not used\n");
+    return 1;
+  }
+  sc_free (package, p);
+  sc_free (package, q);
+  if (live != 0 || sc_memory_status (package) != 0) {
+    SC_GLOBAL_LERROR ("Allocator backend free not used\n");
+    return 1;
+  }
+
+  sc_package_set_allocator (package, NULL);
+  sc_package_unregister (package);
+  return 0;
+}
+
+/** Check the byte accounting with and without an allocator backend. */
+static int
+test_memory_profile (sc_MPI_Comm mpicomm, int backend)
+{
+  int                 package, live = 0;
+  size_t              current, peak;
+  char               *p, *q;
+  sc_allocator_t      allocator;
+
+  package = sc_package_register (NULL, SC_LP_DEFAULT, "test_profile",
+                                 "Memory profile test");
+  if (backend) {
+    allocator.malloc_fn = test_backend_malloc;
+    allocator.calloc_fn = NULL;
+    allocator.realloc_fn = test_backend_realloc;
+    allocator.free_fn = test_backend_free;
+    allocator.user = &live;
+    sc_package_set_allocator (package, &allocator);
+  }
+  sc_memory_bytes (package, &current, &peak);
+  if (current != 0 || peak != 0) {
+    SC_GLOBAL_LERROR ("Memory profile not empty\n");
+    return 1;
+  }
+  sc_package_set_memory_profile (package, 1);
+
+  p = (char *) sc_malloc_site (package, 1000, __FILE__, __LINE__);
+  q = (char *) sc_calloc_site (package, 10, 20, __FILE__, __LINE__);
+  memset (p, 1, 1000);
+  q = (char *) sc_realloc (package, q, 3000);
+  sc_memory_bytes (package, &current, &peak);
+  if (current != 4000 || peak != 4000 || q[199] != 0) {
+    SC_GLOBAL_LERROR ("Memory profile after allocation\n");
+    return 1;
+  }
+  q = (char *) sc_realloc (package, q, 100);
+  sc_free (package, p);
+  sc_memory_bytes (package, &current, &peak);
+  if (current != 100 || peak != 4000) {
+    SC_GLOBAL_LERROR ("Memory profile after free\n");
+    return 1;
+  }
+  sc_package_print_memory_summary (mpicomm, SC_LP_INFO);
+  sc_free (package, q);
+  sc_memory_bytes (package, &current, &peak);
+  if (current != 0 || sc_memory_status (package) != 0 ||
+      (backend && live != 0)) {
+    SC_GLOBAL_LERROR ("Memory profile not balanced\n");
+    return 1;
+  }
+
+  sc_package_set_memory_profile (package, 0);
+  sc_package_set_allocator (package, NULL);
+  sc_package_unregister (package);
+  return 0;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -95,6 +247,12 @@ main (int argc, char **argv)
   num_failed_tests += TH (SC_TEST_LONG, "long", 0, 1);
   num_failed_tests += TH (SC_TEST_INT, "int", 1, 1);
 
+  /* test the memory counters */
+  num_failed_tests += test_memory_count (1000);
+  num_failed_tests += test_allocator ();
+  num_failed_tests += test_memory_profile (mpicomm, 0);
+  num_failed_tests += test_memory_profile (mpicomm, 1);
+
   /* clean up and exit */
   sc_finalize ();
 
@@ -0,0 +1,182 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_AGGREGATE_PREFIX "sc_test_io_aggregate"
+
+static size_t
+test_io_aggregate_bytes (int rank, int section)
+{
+  return (size_t) ((rank * 37 + section * 11) % 101);
+}
+
+static void
+test_io_aggregate_fill (char *data, size_t bytes, int rank, int section)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < bytes; ++zz) {
+    data[zz] = (char) (zz * 3 + rank * 5 + section * 7);
+  }
+}
+
+/** Write and read sections with a given grouping of the ranks. */
+static int
+test_io_aggregate_run (sc_MPI_Comm mpicomm, int nodes_per_file,
+                       int num_sections)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, sec;
+  char               *data, *back;
+  const void         *view;
+  size_t              bytes, bytes_out;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sink = sc_io_sink_new (SC_IO_TYPE_AGGREGATE, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, mpicomm,
+                         TEST_IO_AGGREGATE_PREFIX, nodes_per_file);
+  SC_CHECK_ABORT (sink != NULL, "Open aggregate sink");
+  for (sec = 0; sec < num_sections; ++sec) {
+    bytes = test_io_aggregate_bytes (rank, sec);
+    data = SC_ALLOC (char, bytes + 1);
+    test_io_aggregate_fill (data, bytes, rank, sec);
+    num_failed += sc_io_sink_write (sink, data, bytes) != 0;
+    num_failed += sc_io_sink_complete (sink, NULL, NULL) != 0;
+    SC_FREE (data);
+  }
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  source = sc_io_source_new (SC_IO_TYPE_AGGREGATE, SC_IO_ENCODE_NONE,
+                             mpicomm, TEST_IO_AGGREGATE_PREFIX,
+                             nodes_per_file);
+  SC_CHECK_ABORT (source != NULL, "Open aggregate source");
+  for (sec = 0; sec < num_sections; ++sec) {
+    bytes = test_io_aggregate_bytes (rank, sec);
+    data = SC_ALLOC (char, bytes + 1);
+    test_io_aggregate_fill (data, bytes, rank, sec);
+    num_failed += sc_io_source_section (source, bytes) != 0;
+    if (sec % 2 == 0) {
+      num_failed += sc_io_source_view (source, bytes, &view, NULL) != 0;
+      num_failed += memcmp (view, data, bytes) != 0;
+    }
+    else {
+      back = SC_ALLOC (char, bytes + 1);
+      bytes_out = 0;
+      num_failed += sc_io_source_read (source, back, bytes, &bytes_out);
+      num_failed += bytes_out != bytes;
+      num_failed += memcmp (back, data, bytes) != 0;
+      SC_FREE (back);
+    }
+    num_failed += sc_io_source_complete (source, NULL, NULL) != 0;
+    SC_FREE (data);
+  }
+
+  /* a byte count that does not match the table is an error */
+  num_failed += sc_io_source_section (source, 1) == 0;
+  num_failed += sc_io_source_destroy (source) != 0;
+  return num_failed;
+}
+
+/** Remove the files written by the first ranks of the groups. */
+static int
+test_io_aggregate_remove (sc_MPI_Comm mpicomm, int ranks_per_file)
+{
+  int                 mpiret, rank, size, group;
+  char                filename[BUFSIZ];
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* exactly one file per group must exist */
+  if (rank == 0) {
+    for (group = 0; group * ranks_per_file < size; ++group) {
+      snprintf (filename, BUFSIZ, "%s_%04d", TEST_IO_AGGREGATE_PREFIX,
+                group);
+      if (remove (filename)) {
+        return 1;
+      }
+    }
+    snprintf (filename, BUFSIZ, "%s_%04d", TEST_IO_AGGREGATE_PREFIX, group);
+    if (!remove (filename)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0, num_failed_all;
+  int                 mpiret, size;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* a split communicator has no node communicators attached */
+  mpiret = sc_MPI_Comm_split (sc_MPI_COMM_WORLD, 0, 0, &mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* one file per rank and one file per three ranks */
+  num_failed += test_io_aggregate_run (mpicomm, 1, 3);
+  num_failed += test_io_aggregate_remove (mpicomm, 1);
+  num_failed += test_io_aggregate_run (mpicomm, 3, 4);
+  num_failed += test_io_aggregate_remove (mpicomm, 3);
+
+  /* emulate nodes of two ranks each with node communicators */
+  if (size % 2 == 0) {
+    sc_mpi_comm_attach_node_comms (mpicomm, 2);
+    num_failed += test_io_aggregate_run (mpicomm, 2, 2);
+    num_failed += test_io_aggregate_remove (mpicomm, 4);
+    sc_mpi_comm_detach_node_comms (mpicomm);
+  }
+  mpiret = sc_MPI_Comm_free (&mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = sc_MPI_Allreduce (&num_failed, &num_failed_all, 1, sc_MPI_INT,
+                             sc_MPI_SUM, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (num_failed_all) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed_all);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_all ? EXIT_FAILURE : EXIT_SUCCESS;
+}
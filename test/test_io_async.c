@@ -0,0 +1,245 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_ASYNC_BYTES 1000000
+
+/* compare the contents of an open file with the data */
+static int
+test_io_async_compare (FILE * file, const char *data, size_t bytes)
+{
+  int                 retval;
+  char               *readback;
+
+  readback = SC_ALLOC (char, bytes + 1);
+  rewind (file);
+  retval = fread (readback, 1, bytes + 1, file) != bytes ||
+    memcmp (readback, data, bytes) != 0;
+  SC_FREE (readback);
+  return retval;
+}
+
+/* write in uneven pieces to an async file sink and check the result */
+static int
+test_io_async (const char *data, int num_buffers, size_t buffer_bytes,
+               int sync)
+{
+  int                 retval;
+  int                 failed = 0;
+  size_t              pos, piece, bytes_in, bytes_out;
+  FILE               *file;
+  sc_io_sink_t       *sink;
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "Temporary file");
+  sink = sc_io_sink_new (SC_IO_TYPE_FILEFILE, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, file);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+
+  /* data written before activation comes first */
+  retval = sc_io_sink_write (sink, data, 10);
+  retval = retval || sc_io_sink_activate_async (sink, num_buffers,
+                                                buffer_bytes, sync);
+  retval = retval || !sc_io_sink_activate_async (sink, num_buffers,
+                                                 buffer_bytes, sync);
+  SC_CHECK_ABORT (retval == 0, "Sink activate");
+
+  for (pos = 10; pos < TEST_IO_ASYNC_BYTES / 2; pos += piece) {
+    piece = SC_MIN (1 + pos % 10007, TEST_IO_ASYNC_BYTES / 2 - pos);
+    retval = sc_io_sink_write (sink, data + pos, piece);
+    SC_CHECK_ABORT (retval == 0, "Sink write");
+  }
+
+  /* the first half is in the file after completion */
+  retval = sc_io_sink_complete (sink, &bytes_in, &bytes_out);
+  if (retval || bytes_in != pos || bytes_out != pos ||
+      test_io_async_compare (file, data, pos)) {
+    SC_LERRORF ("Async sink with %d buffers of %ld bytes\n",
+                num_buffers, (long) buffer_bytes);
+    failed = 1;
+  }
+
+  /* the sink continues after completion */
+  fseek (file, 0, SEEK_END);
+  for (; pos < TEST_IO_ASYNC_BYTES; pos += piece) {
+    piece = SC_MIN (1 + pos % 30011, TEST_IO_ASYNC_BYTES - pos);
+    retval = sc_io_sink_write (sink, data + pos, piece);
+    SC_CHECK_ABORT (retval == 0, "Sink write");
+  }
+  retval = sc_io_sink_destroy (sink);
+  if (retval || test_io_async_compare (file, data, TEST_IO_ASYNC_BYTES)) {
+    SC_LERRORF ("Async sink destroy with %d buffers\n", num_buffers);
+    failed = 1;
+  }
+  fclose (file);
+  return failed;
+}
+
+/* an async sink with compression */
+static int
+test_io_async_encode (const char *data)
+{
+  int                 retval;
+  int                 failed = 0;
+  const char         *filename = "sc_test_io_async.tmp";
+  char               *readback;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_ZLIB, filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_io_sink_activate_async (sink, 3, 1000, 1);
+  retval = retval || sc_io_sink_write (sink, data, TEST_IO_ASYNC_BYTES);
+  retval = retval || sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+
+  readback = SC_ALLOC (char, TEST_IO_ASYNC_BYTES);
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_ZLIB,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  retval = sc_io_source_read (source, readback, TEST_IO_ASYNC_BYTES, NULL);
+  retval = retval || sc_io_source_destroy (source);
+  if (retval || memcmp (readback, data, TEST_IO_ASYNC_BYTES)) {
+    SC_LERROR ("Async sink with compression\n");
+    failed = 1;
+  }
+  SC_FREE (readback);
+  (void) remove (filename);
+  return failed;
+}
+
+/* read in uneven pieces from a file source reading ahead */
+static int
+test_io_readahead (const char *data, int num_buffers, size_t buffer_bytes,
+                   int skip)
+{
+  int                 retval;
+  int                 failed = 0;
+  size_t              pos, piece, got;
+  char               *readback;
+  FILE               *file;
+  sc_io_source_t     *source;
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "Temporary file");
+  SC_CHECK_ABORT (fwrite (data, 1, TEST_IO_ASYNC_BYTES, file) ==
+                  TEST_IO_ASYNC_BYTES, "File write");
+  rewind (file);
+  source = sc_io_source_new (SC_IO_TYPE_FILEFILE, SC_IO_ENCODE_NONE, file);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+
+  /* data read before activation comes first */
+  readback = SC_ALLOC_ZERO (char, TEST_IO_ASYNC_BYTES);
+  retval = !skip && sc_io_source_activate_mirror (source);
+  retval = retval || sc_io_source_read (source, readback, 10, NULL);
+  retval = retval || sc_io_source_activate_readahead (source, num_buffers,
+                                                      buffer_bytes);
+  retval = retval || !sc_io_source_activate_readahead (source, num_buffers,
+                                                       buffer_bytes);
+  SC_CHECK_ABORT (retval == 0, "Source activate");
+
+  for (pos = 10; pos < TEST_IO_ASYNC_BYTES; pos += piece) {
+    piece = SC_MIN (1 + pos % 10007, TEST_IO_ASYNC_BYTES - pos);
+    retval = sc_io_source_read (source, skip && pos % 2 ? NULL :
+                                readback + pos, piece, NULL);
+    SC_CHECK_ABORT (retval == 0, "Source read");
+    if (skip && pos % 2) {
+      memcpy (readback + pos, data + pos, piece);
+    }
+  }
+
+  /* the end of the file is reported by a short read */
+  retval = sc_io_source_read (source, readback, 10, &got);
+  if (retval || got != 0 || memcmp (readback, data, TEST_IO_ASYNC_BYTES)) {
+    SC_LERRORF ("Read ahead with %d buffers of %ld bytes\n",
+                num_buffers, (long) buffer_bytes);
+    failed = 1;
+  }
+
+  /* the mirror holds all data read */
+  if (!skip) {
+    memset (readback, 0, TEST_IO_ASYNC_BYTES);
+    retval = sc_io_source_read_mirror (source, readback,
+                                       TEST_IO_ASYNC_BYTES, NULL);
+    if (retval || memcmp (readback, data, TEST_IO_ASYNC_BYTES)) {
+      SC_LERROR ("Read ahead mirror\n");
+      failed = 1;
+    }
+  }
+  failed |= sc_io_source_destroy (source);
+  SC_FREE (readback);
+  fclose (file);
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  size_t              zz;
+  char               *data;
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  data = SC_ALLOC (char, TEST_IO_ASYNC_BYTES);
+  for (zz = 0; zz < TEST_IO_ASYNC_BYTES; ++zz) {
+    data[zz] = (char) ((zz % 251) ^ (zz / 1000));
+  }
+
+  if (sc_is_root ()) {
+    failed |= test_io_async (data, 2, 61, 0);
+    failed |= test_io_async (data, 2, 4096, 0);
+    failed |= test_io_async (data, 4, 100000, 1);
+    failed |= test_io_async (data, 3, 2 * TEST_IO_ASYNC_BYTES, 0);
+    if (sc_io_encode_available (SC_IO_ENCODE_ZLIB)) {
+      failed |= test_io_async_encode (data);
+    }
+    failed |= test_io_readahead (data, 2, 61, 0);
+    failed |= test_io_readahead (data, 3, 4096, 1);
+    failed |= test_io_readahead (data, 4, 2 * TEST_IO_ASYNC_BYTES, 0);
+
+    /* buffer sinks are not asynchronous */
+    buffer = sc_array_new (sizeof (char));
+    sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, buffer);
+    failed |= !sc_io_sink_activate_async (sink, 2, 100, 0);
+    failed |= sc_io_sink_destroy (sink);
+    sc_array_destroy (buffer);
+  }
+  SC_FREE (data);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_io.h>
+#include <sc_shmem.h>
+
+#define TEST_IO_BCAST_COUNT 10000
+
+static int
+test_io_bcast_write (const char *filename, int count)
+{
+  int                 i;
+  FILE               *file;
+
+  file = fopen (filename, "wb");
+  if (file == NULL) {
+    return -1;
+  }
+  for (i = 0; i < count; ++i) {
+    if (fwrite (&i, sizeof (int), 1, file) != 1) {
+      (void) fclose (file);
+      return -1;
+    }
+  }
+  return fclose (file);
+}
+
+static int
+test_io_bcast_read (sc_MPI_Comm mpicomm, int root, const char *filename,
+                    int shmem)
+{
+  int                 i, failed = 0;
+  int                 value;
+  const void         *view;
+  size_t              bytes_out;
+  sc_io_source_t     *source;
+
+  source = sc_io_source_new (SC_IO_TYPE_BCAST, SC_IO_ENCODE_NONE,
+                             mpicomm, root, filename, shmem);
+  if (source == NULL) {
+    SC_LERROR ("Broadcast source not created\n");
+    return 1;
+  }
+
+  /* the first half is copied out, the second half viewed in place */
+  for (i = 0; i < TEST_IO_BCAST_COUNT / 2; ++i) {
+    if (sc_io_source_read (source, &value, sizeof (int), NULL) ||
+        value != i) {
+      ++failed;
+      break;
+    }
+  }
+  if (sc_io_source_view (source, (TEST_IO_BCAST_COUNT / 2) * sizeof (int),
+                         &view, NULL)) {
+    ++failed;
+  }
+  else {
+    for (i = 0; i < TEST_IO_BCAST_COUNT / 2; ++i) {
+      if (((const int *) view)[i] != TEST_IO_BCAST_COUNT / 2 + i) {
+        ++failed;
+        break;
+      }
+    }
+  }
+  if (sc_io_source_read (source, &value, sizeof (int), &bytes_out) ||
+      bytes_out != 0) {
+    ++failed;
+  }
+  if (failed) {
+    SC_LERRORF ("Broadcast source mismatch root %d shmem %d\n",
+                root, shmem);
+  }
+  if (sc_io_source_destroy (source)) {
+    SC_LERROR ("Broadcast source destroy\n");
+    ++failed;
+  }
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpirank, mpisize;
+  int                 itype, shmem;
+  int                 num_failed = 0;
+  const char         *filename = "sc_test_io_bcast.tmp";
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* the sink side is not supported */
+  SC_CHECK_ABORT (sc_io_sink_new (SC_IO_TYPE_BCAST, SC_IO_MODE_WRITE,
+                                  SC_IO_ENCODE_NONE) == NULL,
+                  "Broadcast sink must not be created");
+
+  /* the last rank is usually not the writer of its node */
+  if (mpirank == mpisize - 1) {
+    SC_CHECK_ABORT (test_io_bcast_write (filename,
+                                         TEST_IO_BCAST_COUNT) == 0,
+                    "Could not write file");
+  }
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  num_failed += test_io_bcast_read (mpicomm, mpisize - 1, filename, 0);
+  for (itype = 0; itype < (int) SC_SHMEM_NUM_TYPES; ++itype) {
+    sc_shmem_set_type (mpicomm, (sc_shmem_type_t) itype);
+    num_failed += test_io_bcast_read (mpicomm, mpisize - 1, filename, 1);
+  }
+  sc_shmem_set_type (mpicomm, SC_SHMEM_AUTO);
+
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == mpisize - 1) {
+    (void) remove (filename);
+  }
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* a missing file yields no source on every rank */
+  for (shmem = 0; shmem <= 1; ++shmem) {
+    if (sc_io_source_new (SC_IO_TYPE_BCAST, SC_IO_ENCODE_NONE,
+                          mpicomm, 0, filename, shmem) != NULL) {
+      SC_LERROR ("Broadcast source of missing file created\n");
+      ++num_failed;
+    }
+  }
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_CHECKSUM_BYTES 3000
+#define TEST_IO_CHECKSUM_FILE "sc_test_io_checksum.bin"
+
+/** Reference CRC32C computed bit by bit. */
+static              uint32_t
+test_io_crc32c_bits (const char *data, size_t bytes)
+{
+  int                 k;
+  uint32_t            crc = 0xffffffffU;
+
+  while (bytes-- > 0) {
+    crc ^= (unsigned char) *data++;
+    for (k = 0; k < 8; ++k) {
+      crc = (crc >> 1) ^ (0x82f63b78U & (0U - (crc & 1U)));
+    }
+  }
+  return ~crc;
+}
+
+static int
+test_io_crc32c (const char *data)
+{
+  int                 num_failed = 0;
+  size_t              start, len, split;
+  uint32_t            crc;
+
+  num_failed += sc_io_crc32c (0, "123456789", 9) != 0xe3069283U;
+  num_failed += sc_io_crc32c (0, NULL, 0) != 0;
+
+  /* all alignments and the continuation of checksums */
+  for (start = 0; start < 9; ++start) {
+    for (len = 0; len < 70; len += 3) {
+      crc = test_io_crc32c_bits (data + start, len);
+      num_failed += sc_io_crc32c (0, data + start, len) != crc;
+      split = len / 3;
+      num_failed += sc_io_crc32c (sc_io_crc32c (0, data + start, split),
+                                  data + start + split, len - split) != crc;
+    }
+  }
+  return num_failed;
+}
+
+/** Write the data in two checksummed sections with several calls. */
+static int
+test_io_checksum_write (sc_io_sink_t * sink, const char *data)
+{
+  int                 num_failed = 0;
+  sc_io_vec_t         vec[3];
+
+  num_failed += sc_io_sink_activate_checksum (sink) != 0;
+  num_failed += sc_io_sink_activate_checksum (sink) == 0;
+  num_failed += sc_io_sink_write (sink, data, 1000) != 0;
+  num_failed += sc_io_sink_complete (sink, NULL, NULL) != 0;
+
+  /* nothing written since the trailer */
+  num_failed += sc_io_sink_complete (sink, NULL, NULL) != 0;
+
+  vec[0].base = (void *) (data + 1000);
+  vec[0].bytes = 500;
+  vec[1].base = (void *) (data + 1500);
+  vec[1].bytes = 0;
+  vec[2].base = (void *) (data + 1500);
+  vec[2].bytes = 1499;
+  num_failed += sc_io_sink_writev (sink, vec, 3) != 0;
+  num_failed += sc_io_sink_align (sink, 16) != 0;
+  num_failed += sc_io_sink_write (sink, data + 2999, 1) != 0;
+  return num_failed;
+}
+
+/** Complete a source within its data.  With a compressed encoding, the
+ * source reports the encoded data of the next frame as remaining.
+ */
+static int
+test_io_checksum_complete (sc_io_source_t * source)
+{
+  int                 retval;
+
+  retval = sc_io_source_complete (source, NULL, NULL);
+  if (retval == SC_IO_ERROR_AGAIN && source->codec != NULL) {
+    retval = SC_IO_ERROR_NONE;
+  }
+  return retval;
+}
+
+/** Read the data written by test_io_checksum_write. */
+static int
+test_io_checksum_read (sc_io_source_t * source, const char *data,
+                       int corrupt)
+{
+  int                 num_failed = 0;
+  char               *back;
+  size_t              bytes_out;
+  sc_io_vec_t         vec[2];
+
+  back = SC_ALLOC_ZERO (char, TEST_IO_CHECKSUM_BYTES);
+  num_failed += sc_io_source_activate_checksum (source) != 0;
+  num_failed += sc_io_source_read (source, back, 1000, NULL) != 0;
+  num_failed += (test_io_checksum_complete (source) != 0) != corrupt;
+  if (!corrupt) {
+    num_failed += test_io_checksum_complete (source) != 0;
+
+    /* skip part of the data, which still counts for the checksum */
+    num_failed += sc_io_source_read (source, NULL, 500, NULL) != 0;
+    vec[0].base = back + 1500;
+    vec[0].bytes = 700;
+    vec[1].base = back + 2200;
+    vec[1].bytes = 799;
+    num_failed += sc_io_source_readv (source, vec, 2, &bytes_out) != 0;
+    num_failed += bytes_out != 1499;
+    num_failed += sc_io_source_align (source, 16) != 0;
+    num_failed += sc_io_source_read (source, back + 2999, 1, NULL) != 0;
+    num_failed += memcmp (back, data, 1000) != 0;
+    num_failed += memcmp (back + 1500, data + 1500, 1500) != 0;
+    num_failed += sc_io_source_complete (source, NULL, NULL) != 0;
+  }
+  SC_FREE (back);
+  return num_failed;
+}
+
+static int
+test_io_checksum_buffer (const char *data, sc_io_encode_t encode)
+{
+  int                 num_failed = 0;
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  buffer = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE, encode,
+                         buffer);
+  SC_CHECK_ABORT (sink != NULL, "Open sink");
+  num_failed += test_io_checksum_write (sink, data);
+  num_failed += sc_io_sink_destroy (sink) != 0;
+  if (encode == SC_IO_ENCODE_NONE) {
+    /* two trailers and the alignment */
+    num_failed += buffer->elem_count != 1000 + 8 + 1999 + 1 + 1 + 8;
+  }
+
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, encode, buffer);
+  SC_CHECK_ABORT (source != NULL, "Open source");
+  num_failed += test_io_checksum_read (source, data, 0);
+  num_failed += sc_io_source_destroy (source) != 0;
+
+  /* a changed byte is detected */
+  if (encode == SC_IO_ENCODE_NONE) {
+    buffer->array[500] ^= 0x10;
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, encode, buffer);
+    SC_CHECK_ABORT (source != NULL, "Open source");
+    num_failed += test_io_checksum_read (source, data, 1);
+    num_failed += sc_io_source_destroy (source) != 0;
+  }
+  sc_array_destroy (buffer);
+  return num_failed;
+}
+
+static int
+test_io_checksum_file (const char *data, sc_io_type_t iotype)
+{
+  int                 num_failed = 0;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, TEST_IO_CHECKSUM_FILE);
+  SC_CHECK_ABORT (sink != NULL, "Open sink");
+  num_failed += test_io_checksum_write (sink, data);
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  source = sc_io_source_new (iotype, SC_IO_ENCODE_NONE,
+                             TEST_IO_CHECKSUM_FILE);
+  SC_CHECK_ABORT (source != NULL, "Open source");
+  num_failed += test_io_checksum_read (source, data, 0);
+  num_failed += sc_io_source_destroy (source) != 0;
+  num_failed += remove (TEST_IO_CHECKSUM_FILE) != 0;
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 i;
+  char               *data;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  if (sc_is_root ()) {
+    data = SC_ALLOC (char, TEST_IO_CHECKSUM_BYTES);
+    for (i = 0; i < TEST_IO_CHECKSUM_BYTES; ++i) {
+      data[i] = (char) (i * 31 + i / 7);
+    }
+
+    num_failed += test_io_crc32c (data);
+    num_failed += test_io_checksum_buffer (data, SC_IO_ENCODE_NONE);
+    if (sc_io_encode_available (SC_IO_ENCODE_ZLIB)) {
+      num_failed += test_io_checksum_buffer (data, SC_IO_ENCODE_ZLIB);
+    }
+    num_failed += test_io_checksum_file (data, SC_IO_TYPE_FILENAME);
+    num_failed += test_io_checksum_file (data, SC_IO_TYPE_MMAP);
+    SC_FREE (data);
+
+    if (num_failed) {
+      SC_LERRORF ("Test failed %d times\n", num_failed);
+    }
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
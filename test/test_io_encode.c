@@ -0,0 +1,187 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_io.h>
+
+#define TEST_IO_ENCODE_BYTES 300000
+
+static const char  *test_io_encode_names[SC_IO_ENCODE_LAST] =
+  { "none", "zlib", "zstd", "lz4" };
+
+/* read the data back in uneven pieces, skipping some of it */
+static int
+test_io_decode (sc_io_source_t * source, const char *data, size_t frame)
+{
+  int                 retval;
+  size_t              pos, piece, got, bytes_in, bytes_out;
+  char               *readback;
+
+  readback = SC_ALLOC (char, 2 * frame);
+  for (pos = 0; pos < 2 * frame; pos += got) {
+    piece = SC_MIN (1 + pos % 7919, 2 * frame - pos);
+    if (pos % 3 == 1) {
+      retval = sc_io_source_read (source, NULL, piece, NULL);
+      memcpy (readback + pos, data + pos, piece);
+      got = piece;
+    }
+    else {
+      retval = sc_io_source_read (source, readback + pos, piece, &got);
+    }
+    if (retval || got == 0) {
+      SC_LERRORF ("Source read failed at %ld\n", (long) pos);
+      SC_FREE (readback);
+      return 1;
+    }
+  }
+  retval = memcmp (readback, data, 2 * frame) != 0;
+  SC_FREE (readback);
+  if (retval) {
+    SC_LERROR ("Decoded data mismatch\n");
+    return 1;
+  }
+
+  /* the data has been consumed exactly */
+  retval = sc_io_source_read (source, &piece, 1, &got);
+  if (retval || got != 0) {
+    SC_LERROR ("Source not at its end\n");
+    return 1;
+  }
+  retval = sc_io_source_complete (source, &bytes_in, &bytes_out);
+  if (retval || bytes_out != 2 * frame) {
+    SC_LERROR ("Source complete\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int
+test_io_encode (sc_io_encode_t encode, const char *data, size_t frame)
+{
+  int                 retval, failed = 0;
+  int                 i;
+  size_t              pos, piece, bytes_in, bytes_out[2];
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+  FILE               *file;
+
+  /* two frames into a buffer, one into a file */
+  buffer = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE, encode,
+                         buffer);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  for (i = 0; i < 2; ++i) {
+    for (pos = 0; pos < frame; pos += piece) {
+      piece = SC_MIN (1000 + pos % 4099, frame - pos);
+      retval = sc_io_sink_write (sink, data + i * frame + pos, piece);
+      SC_CHECK_ABORT (retval == 0, "Sink write");
+    }
+    retval = sc_io_sink_complete (sink, &bytes_in, bytes_out + i);
+    SC_CHECK_ABORT (retval == 0, "Sink complete");
+    if (bytes_in != frame || buffer->elem_count !=
+        bytes_out[0] + (i ? bytes_out[1] : 0)) {
+      SC_LERROR ("Sink byte counts\n");
+      failed = 1;
+    }
+  }
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  SC_INFOF ("Encoding %s compresses %ld bytes to %ld\n",
+            test_io_encode_names[encode], (long) (2 * frame),
+            (long) buffer->elem_count);
+  if (encode != SC_IO_ENCODE_NONE && buffer->elem_count >= frame) {
+    SC_LERROR ("Data has not been compressed\n");
+    failed = 1;
+  }
+
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, encode, buffer);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  failed |= test_io_decode (source, data, frame);
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  sc_array_destroy (buffer);
+
+  /* the same through a temporary file */
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "Open temporary file");
+  sink = sc_io_sink_new (SC_IO_TYPE_FILEFILE, SC_IO_MODE_WRITE, encode,
+                         file);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  for (i = 0; i < 2; ++i) {
+    retval = sc_io_sink_write (sink, data + i * frame, frame);
+    SC_CHECK_ABORT (retval == 0, "Sink write");
+    retval = sc_io_sink_complete (sink, NULL, NULL);
+    SC_CHECK_ABORT (retval == 0, "Sink complete");
+  }
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+  rewind (file);
+  source = sc_io_source_new (SC_IO_TYPE_FILEFILE, encode, file);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  failed |= test_io_decode (source, data, frame);
+  retval = sc_io_source_destroy (source);
+  SC_CHECK_ABORT (retval == 0, "Source destroy");
+  fclose (file);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  int                 encode;
+  size_t              zz;
+  char               *data;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* compressible data of two frames */
+  data = SC_ALLOC (char, 2 * TEST_IO_ENCODE_BYTES);
+  for (zz = 0; zz < 2 * TEST_IO_ENCODE_BYTES; ++zz) {
+    data[zz] = (char) ((zz % 61) ^ (zz / 4096));
+  }
+
+  if (sc_is_root ()) {
+    for (encode = 0; encode < SC_IO_ENCODE_LAST; ++encode) {
+      if (!sc_io_encode_available ((sc_io_encode_t) encode)) {
+        SC_INFOF ("Encoding %s is not available\n",
+                  test_io_encode_names[encode]);
+        continue;
+      }
+      failed |= test_io_encode ((sc_io_encode_t) encode, data,
+                                TEST_IO_ENCODE_BYTES);
+    }
+  }
+  SC_FREE (data);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_MMAP_COUNT 100000
+
+/* write the data into a file with the given encoding */
+static void
+test_io_mmap_write (const char *filename, sc_io_encode_t encode,
+                    const int *data, size_t count)
+{
+  int                 retval;
+  sc_io_sink_t       *sink;
+
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE, encode,
+                         filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  retval = sc_io_sink_write (sink, data, count * sizeof (int));
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+}
+
+/* view, read and skip through the data in turns */
+static int
+test_io_mmap_views (sc_io_source_t * source, const int *data, size_t count)
+{
+  int                 retval;
+  int                 value;
+  size_t              pos, bytes_in, bytes_out;
+  const void         *view;
+  sc_array_t          array;
+
+  retval = sc_io_source_advise (source, SC_IO_ADVICE_SEQUENTIAL);
+  SC_CHECK_ABORT (retval == 0, "Source advise");
+  for (pos = 0; pos + 100 <= count; pos += 100) {
+    switch (pos / 100 % 3) {
+    case 0:
+      retval = sc_io_source_view_array (source, &array, sizeof (int), 100);
+      retval = retval || array.elem_count != 100 ||
+        memcmp (array.array, data + pos, 100 * sizeof (int));
+      break;
+    case 1:
+      retval = sc_io_source_view (source, sizeof (int), &view, NULL);
+      retval = retval || memcmp (view, data + pos, sizeof (int));
+      retval = retval || sc_io_source_read (source, &value, sizeof (int),
+                                            NULL) || value != data[pos + 1];
+      retval = retval || sc_io_source_read (source, NULL,
+                                            98 * sizeof (int), NULL);
+      break;
+    default:
+      retval = sc_io_source_view (source, 100 * sizeof (int), &view,
+                                  &bytes_out);
+      retval = retval || bytes_out != 100 * sizeof (int) ||
+        memcmp (view, data + pos, bytes_out);
+    }
+    if (retval) {
+      SC_LERRORF ("View mismatch at %ld\n", (long) pos);
+      return 1;
+    }
+  }
+
+  /* a view beyond the end is shortened or an error */
+  if (sc_io_source_view (source, 200 * sizeof (int), &view, NULL) == 0) {
+    SC_LERROR ("View beyond end\n");
+    return 1;
+  }
+  retval = sc_io_source_view (source, 200 * sizeof (int), &view, &bytes_out);
+  if (retval || bytes_out != (count - pos) * sizeof (int) ||
+      memcmp (view, data + pos, bytes_out)) {
+    SC_LERROR ("View at end\n");
+    return 1;
+  }
+  retval = sc_io_source_complete (source, &bytes_in, &bytes_out);
+  if (retval || bytes_in != count * sizeof (int) ||
+      bytes_out != count * sizeof (int)) {
+    SC_LERROR ("Source complete\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int
+test_io_mmap (const int *data, size_t count)
+{
+  int                 failed = 0;
+  int                 value;
+  size_t              got;
+  const char         *filename = "sc_test_io_mmap.tmp";
+  const void         *view;
+  sc_array_t         *buffer;
+  sc_io_source_t     *source;
+
+  /* mapped sources are not sinks */
+  SC_CHECK_ABORT (sc_io_sink_new (SC_IO_TYPE_MMAP, SC_IO_MODE_WRITE,
+                                  SC_IO_ENCODE_NONE, filename) == NULL,
+                  "Sink of type mmap");
+
+  test_io_mmap_write (filename, SC_IO_ENCODE_NONE, data, count);
+  source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE, filename);
+  if (source == NULL) {
+    SC_INFO ("Memory-mapped sources are not available\n");
+    (void) remove (filename);
+    return 0;
+  }
+  failed |= test_io_mmap_views (source, data, count);
+  failed |= sc_io_source_destroy (source) != 0;
+
+  /* random access to a mapping with a mirror */
+  source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  failed |= sc_io_source_advise (source, SC_IO_ADVICE_RANDOM) != 0;
+  failed |= sc_io_source_activate_mirror (source) != 0;
+  failed |= sc_io_source_read (source, NULL, 7 * sizeof (int), NULL) != 0;
+  failed |= sc_io_source_view (source, sizeof (int), &view, NULL) != 0;
+  failed |= memcmp (view, data + 7, sizeof (int)) != 0;
+  failed |= sc_io_source_read_mirror (source, &value, sizeof (int), &got);
+  failed |= got != sizeof (int) || value != data[7];
+  failed |= sc_io_source_destroy (source) != 0;
+
+  /* an empty file maps to an empty source */
+  test_io_mmap_write (filename, SC_IO_ENCODE_NONE, data, 0);
+  source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (source != NULL, "Source create empty");
+  failed |= sc_io_source_view (source, 1, &view, &got) != 0 || got != 0;
+  failed |= sc_io_source_destroy (source) != 0;
+
+  /* a mapping may be decoded but not viewed */
+  if (sc_io_encode_available (SC_IO_ENCODE_ZLIB)) {
+    test_io_mmap_write (filename, SC_IO_ENCODE_ZLIB, data, count);
+    source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_ZLIB,
+                               filename);
+    SC_CHECK_ABORT (source != NULL, "Source create zlib");
+    failed |= sc_io_source_view (source, 1, &view, &got) == 0;
+    failed |= sc_io_source_read (source, NULL, 5 * sizeof (int), NULL);
+    failed |= sc_io_source_read (source, &value, sizeof (int), NULL);
+    failed |= value != data[5];
+    failed |= sc_io_source_read (source, NULL,
+                                 (count - 6) * sizeof (int), NULL);
+    failed |= sc_io_source_destroy (source) != 0;
+  }
+  (void) remove (filename);
+
+  /* arrays are viewed in place */
+  buffer = sc_array_new_count (sizeof (int), count);
+  memcpy (buffer->array, data, count * sizeof (int));
+  source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (source != NULL, "Source create buffer");
+  failed |= test_io_mmap_views (source, data, count);
+  failed |= sc_io_source_destroy (source) != 0;
+  sc_array_destroy (buffer);
+
+  if (failed) {
+    SC_LERROR ("Memory-mapped source failed\n");
+  }
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  int                *data;
+  size_t              zz;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  data = SC_ALLOC (int, TEST_IO_MMAP_COUNT + 37);
+  for (zz = 0; zz < TEST_IO_MMAP_COUNT + 37; ++zz) {
+    data[zz] = (int) (zz * 7919 % 100003);
+  }
+  if (sc_is_root ()) {
+    failed = test_io_mmap (data, TEST_IO_MMAP_COUNT + 37);
+  }
+  SC_FREE (data);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_MPIFILE_STRIPE 4096
+#define TEST_IO_MPIFILE_ROUNDUP(b,s) (((b) + (s) - 1) / (s) * (s))
+
+/** Fill a buffer with bytes depending on rank, section and position. */
+static void
+test_io_mpifile_fill (char *data, size_t bytes, int rank, int section)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < bytes; ++zz) {
+    data[zz] = (char) (zz * 7 + rank * 13 + section * 31);
+  }
+}
+
+static size_t
+test_io_mpifile_bytes (int rank, int section)
+{
+  return (size_t) (rank * 1000 + section * 77 + (rank % 2) * 5);
+}
+
+/** Write sections with all ranks and read them back. */
+static int
+test_io_mpifile_sections (sc_MPI_Comm mpicomm, const char *filename,
+                          const sc_io_mpifile_hints_t * hints,
+                          int num_sections)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, sec;
+  int                 is_aligned = hints != NULL && hints->stripe_bytes > 0;
+  size_t              bytes, bytes_out, local;
+  char               *data, *back;
+  const void         *view;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sink = sc_io_sink_new (SC_IO_TYPE_MPIFILE, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, mpicomm, filename, hints);
+  SC_CHECK_ABORT (sink != NULL, "Open MPI file sink");
+  for (sec = 0; sec < num_sections; ++sec) {
+    bytes = test_io_mpifile_bytes (rank, sec);
+    data = SC_ALLOC (char, bytes + 1);
+    test_io_mpifile_fill (data, bytes, rank, sec);
+    num_failed += sc_io_sink_write (sink, data, bytes) != 0;
+    if (is_aligned) {
+      num_failed += sc_io_sink_align (sink, hints->stripe_bytes) != 0;
+    }
+    num_failed += sc_io_sink_complete (sink, NULL, NULL) != 0;
+    SC_FREE (data);
+  }
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  source = sc_io_source_new (SC_IO_TYPE_MPIFILE, SC_IO_ENCODE_NONE,
+                             mpicomm, filename, hints);
+  SC_CHECK_ABORT (source != NULL, "Open MPI file source");
+  for (sec = 0; sec < num_sections; ++sec) {
+    bytes = test_io_mpifile_bytes (rank, sec);
+    local = bytes;
+    if (is_aligned) {
+      local = TEST_IO_MPIFILE_ROUNDUP (bytes, hints->stripe_bytes);
+    }
+    num_failed += sc_io_source_section (source, local) != 0;
+
+    /* nothing may be read before the section is consumed */
+    num_failed += sc_io_source_complete (source, NULL, NULL) !=
+      (local > 0 ? SC_IO_ERROR_AGAIN : SC_IO_ERROR_NONE);
+
+    data = SC_ALLOC (char, bytes + 1);
+    back = SC_ALLOC (char, bytes + 1);
+    test_io_mpifile_fill (data, bytes, rank, sec);
+    if (sec % 2 == 0) {
+      bytes_out = 0;
+      num_failed += sc_io_source_read (source, back, bytes, &bytes_out);
+      num_failed += bytes_out != bytes;
+      num_failed += memcmp (data, back, bytes) != 0;
+    }
+    else {
+      num_failed += sc_io_source_view (source, bytes, &view, NULL) != 0;
+      num_failed += memcmp (data, view, bytes) != 0;
+    }
+    if (local > bytes) {
+      num_failed += sc_io_source_read (source, NULL, local - bytes, NULL);
+    }
+    num_failed += sc_io_source_complete (source, NULL, NULL) != 0;
+    SC_FREE (back);
+    SC_FREE (data);
+  }
+  num_failed += sc_io_source_destroy (source) != 0;
+
+  return num_failed;
+}
+
+/** Verify the file layout on one rank by reading it as a plain file. */
+static int
+test_io_mpifile_layout (const char *filename, int size,
+                        size_t stripe_bytes, int num_sections)
+{
+  int                 num_failed = 0;
+  int                 rank, sec;
+  long                offset;
+  size_t              bytes, total;
+  char               *data, *back;
+  FILE               *file;
+
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORT (file != NULL, "Open layout file");
+  offset = 0;
+  for (sec = 0; sec < num_sections; ++sec) {
+    total = 0;
+    for (rank = 0; rank < size; ++rank) {
+      bytes = test_io_mpifile_bytes (rank, sec);
+      data = SC_ALLOC (char, bytes + 1);
+      back = SC_ALLOC (char, bytes + 1);
+      test_io_mpifile_fill (data, bytes, rank, sec);
+      num_failed += fseek (file, offset + (long) total, SEEK_SET) != 0;
+      num_failed += fread (back, 1, bytes, file) != bytes;
+      num_failed += memcmp (data, back, bytes) != 0;
+      SC_FREE (back);
+      SC_FREE (data);
+      if (stripe_bytes > 0) {
+        bytes = TEST_IO_MPIFILE_ROUNDUP (bytes, stripe_bytes);
+      }
+      total += bytes;
+    }
+    if (stripe_bytes > 0) {
+      num_failed += offset % (long) stripe_bytes != 0;
+      total = TEST_IO_MPIFILE_ROUNDUP (total, stripe_bytes);
+    }
+    offset += (long) total;
+  }
+  num_failed += fseek (file, 0, SEEK_END) != 0;
+  num_failed += ftell (file) != offset;
+  num_failed += fclose (file) != 0;
+
+  return num_failed;
+}
+
+/** Append a section to an existing file and check its size. */
+static int
+test_io_mpifile_append (sc_MPI_Comm mpicomm, const char *filename)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, size;
+  long                before, after;
+  char                data[16];
+  FILE               *file;
+  sc_io_sink_t       *sink;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  before = 0;
+  if (rank == 0) {
+    file = fopen (filename, "rb");
+    SC_CHECK_ABORT (file != NULL, "Open append file");
+    num_failed += fseek (file, 0, SEEK_END) != 0;
+    before = ftell (file);
+    num_failed += fclose (file) != 0;
+  }
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sink = sc_io_sink_new (SC_IO_TYPE_MPIFILE, SC_IO_MODE_APPEND,
+                         SC_IO_ENCODE_NONE, mpicomm, filename, NULL);
+  SC_CHECK_ABORT (sink != NULL, "Open MPI file sink for append");
+  test_io_mpifile_fill (data, sizeof (data), rank, 99);
+  num_failed += sc_io_sink_write (sink, data, sizeof (data)) != 0;
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  if (rank == 0) {
+    file = fopen (filename, "rb");
+    SC_CHECK_ABORT (file != NULL, "Reopen append file");
+    num_failed += fseek (file, 0, SEEK_END) != 0;
+    after = ftell (file);
+    num_failed += after != before + (long) (size * sizeof (data));
+    num_failed += fseek (file, before, SEEK_SET) != 0;
+    num_failed += fread (data, 1, sizeof (data), file) != sizeof (data);
+    num_failed += data[1] != (char) (7 + 99 * 31);
+    num_failed += fclose (file) != 0;
+  }
+
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0, num_failed_all;
+  int                 mpiret, rank, size;
+  const char         *filename = "sc_test_io_mpifile.bin";
+  sc_io_mpifile_hints_t hints;
+  sc_io_sink_t       *sink;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* check whether shared files are available in this configuration */
+  sink = sc_io_sink_new (SC_IO_TYPE_MPIFILE, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, sc_MPI_COMM_WORLD, filename,
+                         NULL);
+  if (sink == NULL) {
+    SC_GLOBAL_PRODUCTION ("MPI file type not available\n");
+  }
+  else {
+    num_failed += sc_io_sink_destroy (sink) != 0;
+
+    /* contiguous sections */
+    num_failed += test_io_mpifile_sections (sc_MPI_COMM_WORLD, filename,
+                                            NULL, 3);
+    mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      num_failed += test_io_mpifile_layout (filename, size, 0, 3);
+    }
+    num_failed += test_io_mpifile_append (sc_MPI_COMM_WORLD, filename);
+
+    /* sections aligned to the stripe size */
+    memset (&hints, 0, sizeof (hints));
+    hints.stripe_bytes = TEST_IO_MPIFILE_STRIPE;
+    num_failed += test_io_mpifile_sections (sc_MPI_COMM_WORLD, filename,
+                                            &hints, 2);
+    mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      num_failed += test_io_mpifile_layout (filename, size,
+                                            TEST_IO_MPIFILE_STRIPE, 2);
+      num_failed += remove (filename) != 0;
+    }
+  }
+
+  mpiret = sc_MPI_Allreduce (&num_failed, &num_failed_all, 1, sc_MPI_INT,
+                             sc_MPI_SUM, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (num_failed_all) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed_all);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_all ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_io.h>
+#include <sc_dmatrix.h>
+
+#define TEST_IO_RECORD_COUNT 10000
+
+static unsigned int
+test_io_record_hash (const void *v, const void *u)
+{
+  return (unsigned int) *(const int *) v;
+}
+
+static int
+test_io_record_equal (const void *v1, const void *v2, const void *u)
+{
+  return *(const int *) v1 == *(const int *) v2;
+}
+
+/* write all containers into one file in turn */
+static void
+test_io_record_write (const char *filename, sc_array_t * array,
+                      sc_hash_array_t * hash_array, sc_dmatrix_t * plain,
+                      sc_dmatrix_t * padded)
+{
+  int                 retval;
+  sc_array_t          empty;
+  sc_io_sink_t       *sink;
+
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  sc_array_init (&empty, sizeof (int));
+  retval = sc_array_write (array, sink);
+  retval = retval || sc_array_write (&empty, sink);
+  retval = retval || sc_hash_array_write (hash_array, sink);
+  retval = retval || sc_dmatrix_write_binary (plain, sink);
+  retval = retval || sc_dmatrix_write_binary (padded, sink);
+  SC_CHECK_ABORT (retval == 0, "Sink write");
+  retval = sc_io_sink_destroy (sink);
+  SC_CHECK_ABORT (retval == 0, "Sink destroy");
+}
+
+/* compare a matrix with a reference entry by entry */
+static int
+test_io_record_matrix (const sc_dmatrix_t * A, const sc_dmatrix_t * B)
+{
+  sc_bint_t           i, j;
+
+  if (A == NULL || A->m != B->m || A->n != B->n) {
+    return 1;
+  }
+  for (i = 0; i < A->m; ++i) {
+    for (j = 0; j < A->n; ++j) {
+      if (A->e[i][j] != B->e[i][j]) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* read the containers back by copying and, if possible, by viewing */
+static int
+test_io_record_read (sc_io_source_t * source, int view, sc_array_t * array,
+                     sc_hash_array_t * hash_array, sc_dmatrix_t * plain,
+                     sc_dmatrix_t * padded)
+{
+  int                 failed = 0;
+  int                 key;
+  size_t              zz, position;
+  sc_array_t         *copy, empty, *wrong;
+  sc_hash_array_t    *loaded;
+  sc_dmatrix_t       *M;
+
+  copy = sc_array_new (sizeof (int));
+  if (view) {
+    failed |= sc_array_read_view (copy, source) != 0;
+  }
+  else {
+    failed |= sc_array_read (copy, source) != 0;
+  }
+  failed |= copy->elem_count != array->elem_count ||
+    memcmp (copy->array, array->array, array->elem_count * sizeof (int));
+  if (view) {
+    failed |= SC_ARRAY_IS_OWNER (copy);
+    failed |= sc_array_read_view (&empty, source) != 0;
+  }
+  else {
+    sc_array_init (&empty, sizeof (int));
+    failed |= sc_array_read (&empty, source) != 0;
+  }
+  failed |= empty.elem_count != 0;
+  sc_array_reset (&empty);
+  sc_array_destroy (copy);
+
+  /* the hash table is usable after loading */
+  loaded = sc_hash_array_new_flat (sizeof (int), test_io_record_hash,
+                                   test_io_record_equal, NULL);
+  failed |= sc_hash_array_read (loaded, source) != 0;
+  failed |= loaded->a.elem_count != hash_array->a.elem_count;
+  failed |= loaded->num_hashed != 0;
+  for (zz = 0; zz < hash_array->a.elem_count; ++zz) {
+    key = *(int *) sc_array_index (&hash_array->a, zz);
+    failed |= !sc_hash_array_lookup (loaded, &key, &position);
+    failed |= position != zz;
+  }
+  key = -1;
+  failed |= sc_hash_array_insert_unique (loaded, &key, &position) == NULL;
+  failed |= position != hash_array->a.elem_count;
+  failed |= !sc_hash_array_is_valid (loaded);
+  sc_hash_array_destroy (loaded);
+
+  M = view ? sc_dmatrix_read_binary_view (source) :
+    sc_dmatrix_read_binary (source);
+  failed |= test_io_record_matrix (M, plain);
+  if (M != NULL) {
+    sc_dmatrix_destroy (M);
+  }
+  M = view ? sc_dmatrix_read_binary_view (source) :
+    sc_dmatrix_read_binary (source);
+  failed |= test_io_record_matrix (M, padded);
+  if (M != NULL) {
+    sc_dmatrix_destroy (M);
+  }
+
+  /* the end of the source is no record */
+  wrong = sc_array_new (sizeof (int));
+  failed |= sc_array_read (wrong, source) == 0;
+  sc_array_destroy (wrong);
+  return failed;
+}
+
+static int
+test_io_record (void)
+{
+  int                 failed = 0, retval;
+  int                 key;
+  size_t              zz;
+  const char         *filename = "sc_test_io_record.tmp";
+  sc_array_t         *array, *wrong;
+  sc_hash_array_t    *hash_array;
+  sc_dmatrix_t       *plain, *padded;
+  sc_io_source_t     *source;
+  sc_bint_t           i, j;
+
+  array = sc_array_new_count (sizeof (int), TEST_IO_RECORD_COUNT);
+  hash_array = sc_hash_array_new (sizeof (int), test_io_record_hash,
+                                  test_io_record_equal, NULL);
+  for (zz = 0; zz < TEST_IO_RECORD_COUNT; ++zz) {
+    key = (int) (zz * 7919 % 100003);
+    *(int *) sc_array_index (array, zz) = key;
+    *(int *) sc_hash_array_insert_unique (hash_array, &key, NULL) = key;
+  }
+  plain = sc_dmatrix_new (13, 7);
+  padded = sc_dmatrix_new_aligned (11, 5);
+  for (i = 0; i < 13; ++i) {
+    for (j = 0; j < 7; ++j) {
+      plain->e[i][j] = i * 7 + j + .5;
+    }
+  }
+  for (i = 0; i < 11; ++i) {
+    for (j = 0; j < 5; ++j) {
+      padded->e[i][j] = -(i * 5 + j) - .25;
+    }
+  }
+
+  /* copying reads from a stream */
+  test_io_record_write (filename, array, hash_array, plain, padded);
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  failed |= test_io_record_read (source, 0, array, hash_array,
+                                 plain, padded);
+  failed |= sc_io_source_destroy (source) != 0;
+
+  /* views into a mapped file */
+  source = sc_io_source_new (SC_IO_TYPE_MMAP, SC_IO_ENCODE_NONE, filename);
+  if (source == NULL) {
+    SC_INFO ("Memory-mapped sources are not available\n");
+  }
+  else {
+    failed |= test_io_record_read (source, 1, array, hash_array,
+                                   plain, padded);
+    failed |= sc_io_source_destroy (source) != 0;
+  }
+
+  /* a record of another element size is refused */
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Source create");
+  wrong = sc_array_new (sizeof (double));
+  retval = sc_array_read (wrong, source);
+  failed |= retval == 0;
+  sc_array_destroy (wrong);
+  (void) sc_io_source_read (source, NULL, SIZE_MAX, &zz);
+  failed |= sc_io_source_destroy (source) != 0;
+  (void) remove (filename);
+
+  sc_dmatrix_destroy (plain);
+  sc_dmatrix_destroy (padded);
+  sc_hash_array_destroy (hash_array);
+  sc_array_destroy (array);
+
+  if (failed) {
+    SC_LERROR ("Binary records failed\n");
+  }
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  if (sc_is_root ()) {
+    failed = test_io_record ();
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
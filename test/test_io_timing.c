@@ -0,0 +1,208 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_TIMING_WRITES 10
+#define TEST_IO_TIMING_BYTES 1000
+
+/** Find a statistics variable by name. */
+static sc_statinfo_t *
+test_io_timing_find (sc_statistics_t * stats, const char *name)
+{
+  size_t              zz;
+  sc_statinfo_t      *si;
+
+  for (zz = 0; zz < stats->sarray->elem_count; ++zz) {
+    si = (sc_statinfo_t *) sc_array_index (stats->sarray, zz);
+    if (!strcmp (si->variable, name)) {
+      return si;
+    }
+  }
+  return NULL;
+}
+
+static int
+test_io_timing_file (sc_MPI_Comm mpicomm, const char *filename,
+                     const char *data)
+{
+  int                 num_failed = 0;
+  int                 mpiret, mpirank;
+  int                 i;
+  char               *back;
+  sc_io_vec_t         vec[2];
+  sc_io_timing_t      timing;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+  sc_statistics_t    *stats;
+  sc_statinfo_t      *si;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  stats = sc_statistics_new (mpicomm);
+
+  /* time the writes */
+  sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, filename);
+  SC_CHECK_ABORT (sink != NULL, "Open sink");
+  sc_io_sink_timing (sink, &timing);
+  num_failed += timing.io_calls != 0 || timing.bytes != 0;
+  num_failed += sc_io_sink_activate_timing (sink) != 0;
+  num_failed += sc_io_sink_activate_timing (sink) == 0;
+  for (i = 0; i < TEST_IO_TIMING_WRITES; ++i) {
+    num_failed += sc_io_sink_write (sink, data + i * TEST_IO_TIMING_BYTES,
+                                    TEST_IO_TIMING_BYTES) != 0;
+  }
+  vec[0].base = (void *) data;
+  vec[0].bytes = 10;
+  vec[1].base = (void *) (data + 10);
+  vec[1].bytes = 20;
+  num_failed += sc_io_sink_writev (sink, vec, 2) != 0;
+  num_failed += sc_io_sink_complete (sink, NULL, NULL) != 0;
+  sc_io_sink_timing (sink, &timing);
+  num_failed += timing.io_calls != TEST_IO_TIMING_WRITES + 1;
+  num_failed += timing.sync_calls != 1;
+  num_failed += timing.bytes != TEST_IO_TIMING_WRITES *
+    TEST_IO_TIMING_BYTES + 30;
+  num_failed += timing.file_calls < TEST_IO_TIMING_WRITES + 2;
+  num_failed += timing.io_time < 0. || timing.sync_time < 0.;
+
+  /* only the first rank contributes values */
+  sc_io_timing_statistics (stats, "write", mpirank == 0 ? &timing : NULL);
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  /* time the reads */
+  source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                             filename);
+  SC_CHECK_ABORT (source != NULL, "Open source");
+  num_failed += sc_io_source_activate_timing (source) != 0;
+  back = SC_ALLOC (char, TEST_IO_TIMING_WRITES * TEST_IO_TIMING_BYTES);
+  for (i = 0; i < TEST_IO_TIMING_WRITES; ++i) {
+    num_failed += sc_io_source_read (source, back + i * TEST_IO_TIMING_BYTES,
+                                     TEST_IO_TIMING_BYTES, NULL) != 0;
+  }
+  num_failed += memcmp (back, data, TEST_IO_TIMING_WRITES *
+                        TEST_IO_TIMING_BYTES) != 0;
+  num_failed += sc_io_source_read (source, NULL, 30, NULL) != 0;
+  num_failed += sc_io_source_complete (source, NULL, NULL) != 0;
+  sc_io_source_timing (source, &timing);
+  num_failed += timing.io_calls != TEST_IO_TIMING_WRITES + 1;
+  num_failed += timing.sync_calls != 1;
+  num_failed += timing.bytes != TEST_IO_TIMING_WRITES *
+    TEST_IO_TIMING_BYTES + 30;
+  num_failed += timing.file_calls != TEST_IO_TIMING_WRITES + 1;
+  sc_io_timing_statistics (stats, "read", &timing);
+  num_failed += sc_io_source_destroy (source) != 0;
+  SC_FREE (back);
+  num_failed += remove (filename) != 0;
+
+  /* reduce over all ranks */
+  num_failed += !sc_statistics_has (stats, "write_bandwidth");
+  num_failed += !sc_statistics_has (stats, "read_file_calls");
+  sc_statistics_compute (stats);
+  si = test_io_timing_find (stats, "write_bytes");
+  num_failed += si == NULL || si->count != 1 ||
+    si->sum_values != TEST_IO_TIMING_WRITES * TEST_IO_TIMING_BYTES + 30;
+  si = test_io_timing_find (stats, "read_io_calls");
+  num_failed += si == NULL || si->min != TEST_IO_TIMING_WRITES + 1;
+  sc_statistics_print (stats, sc_package_id, SC_LP_STATISTICS, 1, 1);
+  sc_statistics_destroy (stats);
+
+  return num_failed;
+}
+
+/** A call made by another call of the sink is not counted twice. */
+static int
+test_io_timing_nested (const char *data)
+{
+  int                 num_failed = 0;
+  sc_array_t         *buffer;
+  sc_io_vec_t         vec[3];
+  sc_io_timing_t      timing;
+  sc_io_sink_t       *sink;
+
+  buffer = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_ZLIB, buffer);
+  SC_CHECK_ABORT (sink != NULL, "Open sink");
+  num_failed += sc_io_sink_activate_timing (sink) != 0;
+  vec[0].base = (void *) data;
+  vec[0].bytes = 100;
+  vec[1].base = (void *) (data + 100);
+  vec[1].bytes = 200;
+  vec[2].base = (void *) (data + 300);
+  vec[2].bytes = 300;
+  num_failed += sc_io_sink_writev (sink, vec, 3) != 0;
+  num_failed += sc_io_sink_align (sink, 64) != 0;
+  num_failed += sc_io_sink_complete (sink, NULL, NULL) != 0;
+  sc_io_sink_timing (sink, &timing);
+  num_failed += timing.io_calls != 2;
+  num_failed += timing.sync_calls != 1;
+  num_failed += timing.bytes != buffer->elem_count;
+  num_failed += sc_io_sink_destroy (sink) != 0;
+  sc_array_destroy (buffer);
+
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0, num_failed_all;
+  int                 mpiret, mpirank;
+  int                 i;
+  char               *data;
+  char                filename[BUFSIZ];
+  sc_MPI_Comm         mpicomm = sc_MPI_COMM_WORLD;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  data = SC_ALLOC (char, TEST_IO_TIMING_WRITES * TEST_IO_TIMING_BYTES);
+  for (i = 0; i < TEST_IO_TIMING_WRITES * TEST_IO_TIMING_BYTES; ++i) {
+    data[i] = (char) (i * 7 + mpirank);
+  }
+  snprintf (filename, BUFSIZ, "sc_test_io_timing_%d.bin", mpirank);
+  num_failed += test_io_timing_file (mpicomm, filename, data);
+  if (sc_io_encode_available (SC_IO_ENCODE_ZLIB)) {
+    num_failed += test_io_timing_nested (data);
+  }
+  SC_FREE (data);
+
+  mpiret = sc_MPI_Allreduce (&num_failed, &num_failed_all, 1, sc_MPI_INT,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (num_failed_all) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed_all);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_all ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+
+#define TEST_IO_VEC_PIECES 200
+#define TEST_IO_VEC_FILE "sc_test_io_vec.bin"
+
+/** Pieces of varying length, including empty ones, over a data array. */
+static size_t
+test_io_vec_pieces (char *data, sc_io_vec_t * vec)
+{
+  int                 i;
+  size_t              total = 0;
+
+  for (i = 0; i < TEST_IO_VEC_PIECES; ++i) {
+    vec[i].base = data + total;
+    vec[i].bytes = (size_t) ((i * 7) % 9);
+    total += vec[i].bytes;
+  }
+  return total;
+}
+
+/** Compare vectored writes with single writes for a sink type. */
+static int
+test_io_vec_sink (int use_file, const char *data, sc_io_vec_t * vec,
+                  size_t total)
+{
+  int                 num_failed = 0;
+  int                 i;
+  size_t              bytes_out;
+  char               *back;
+  sc_array_t         *buffer, *single;
+  sc_io_sink_t       *sink;
+  sc_io_source_t     *source;
+
+  buffer = sc_array_new (sizeof (char));
+  single = sc_array_new (sizeof (char));
+
+  /* the reference writes each piece separately */
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, single);
+  num_failed += sink == NULL;
+  num_failed += sc_io_sink_write (sink, "head", 4) != 0;
+  for (i = 0; i < TEST_IO_VEC_PIECES; ++i) {
+    num_failed += sc_io_sink_write (sink, vec[i].base, vec[i].bytes) != 0;
+  }
+  num_failed += sc_io_sink_write (sink, "tail", 4) != 0;
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  /* mix single and vectored writes */
+  if (use_file) {
+    sink = sc_io_sink_new (SC_IO_TYPE_FILENAME, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, TEST_IO_VEC_FILE);
+  }
+  else {
+    sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                           SC_IO_ENCODE_NONE, buffer);
+  }
+  SC_CHECK_ABORT (sink != NULL, "Open sink");
+  num_failed += sc_io_sink_write (sink, "head", 4) != 0;
+  num_failed += sc_io_sink_writev (sink, vec, TEST_IO_VEC_PIECES) != 0;
+  num_failed += sc_io_sink_writev (sink, vec, 0) != 0;
+  num_failed += sc_io_sink_write (sink, "tail", 4) != 0;
+  num_failed += sink->bytes_in != total + 8;
+  num_failed += sink->bytes_out != total + 8;
+  num_failed += sc_io_sink_destroy (sink) != 0;
+
+  /* read back with a vectored read in the middle */
+  if (use_file) {
+    source = sc_io_source_new (SC_IO_TYPE_FILENAME, SC_IO_ENCODE_NONE,
+                               TEST_IO_VEC_FILE);
+  }
+  else {
+    num_failed += buffer->elem_count != single->elem_count;
+    num_failed += memcmp (buffer->array, single->array,
+                          single->elem_count) != 0;
+    source = sc_io_source_new (SC_IO_TYPE_BUFFER, SC_IO_ENCODE_NONE,
+                               buffer);
+  }
+  SC_CHECK_ABORT (source != NULL, "Open source");
+  back = SC_ALLOC_ZERO (char, total + 8);
+  num_failed += sc_io_source_read (source, back, 4, NULL) != 0;
+  for (i = 0; i < TEST_IO_VEC_PIECES; ++i) {
+    vec[i].base = back + 4 + ((char *) vec[i].base - data);
+  }
+  num_failed += sc_io_source_readv (source, vec, TEST_IO_VEC_PIECES,
+                                    NULL) != 0;
+  num_failed += sc_io_source_read (source, back + 4 + total, 4, NULL) != 0;
+  num_failed += memcmp (back, single->array, total + 8) != 0;
+
+  /* at the end a vectored read is partial */
+  num_failed += sc_io_source_readv (source, vec, TEST_IO_VEC_PIECES,
+                                    NULL) == 0;
+  bytes_out = 1;
+  num_failed += sc_io_source_readv (source, vec, TEST_IO_VEC_PIECES,
+                                    &bytes_out) != 0;
+  num_failed += bytes_out != 0;
+  num_failed += sc_io_source_destroy (source) != 0;
+
+  /* restore the pieces */
+  for (i = 0; i < TEST_IO_VEC_PIECES; ++i) {
+    vec[i].base = (char *) data + ((char *) vec[i].base - back - 4);
+  }
+  SC_FREE (back);
+  sc_array_destroy (single);
+  sc_array_destroy (buffer);
+  if (use_file) {
+    num_failed += remove (TEST_IO_VEC_FILE) != 0;
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  size_t              zz, total;
+  char               *data;
+  sc_io_vec_t         vec[TEST_IO_VEC_PIECES];
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  if (sc_is_root ()) {
+    data = SC_ALLOC (char, 8 * TEST_IO_VEC_PIECES);
+    for (zz = 0; zz < 8 * TEST_IO_VEC_PIECES; ++zz) {
+      data[zz] = (char) (zz * 13 + 1);
+    }
+    total = test_io_vec_pieces (data, vec);
+
+    num_failed += test_io_vec_sink (0, data, vec, total);
+    num_failed += test_io_vec_sink (1, data, vec, total);
+    SC_FREE (data);
+
+    if (num_failed) {
+      SC_LERRORF ("Test failed %d times\n", num_failed);
+    }
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
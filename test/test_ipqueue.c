@@ -0,0 +1,153 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_containers.h>
+
+static int
+test_compare_double (const void *v1, const void *v2)
+{
+  const double        d1 = *(const double *) v1;
+  const double        d2 = *(const double *) v2;
+
+  return d1 < d2 ? -1 : d1 > d2 ? 1 : 0;
+}
+
+/** Pop all elements and verify that they come out in ascending order. */
+static void
+test_drain (sc_ipqueue_t * pq, const double *prio, size_t n)
+{
+  size_t              zz, handle;
+  double              value, last = -1.;
+
+  SC_CHECK_ABORT (sc_ipqueue_count (pq) == n, "Queue count");
+  for (zz = 0; zz < n; ++zz) {
+    handle = sc_ipqueue_top (pq);
+    SC_CHECK_ABORT (sc_ipqueue_pop (pq, &value) == handle, "Pop handle");
+    SC_CHECK_ABORT (!sc_ipqueue_contains (pq, handle), "Popped handle");
+    SC_CHECK_ABORT (value == prio[handle], "Pop value");
+    SC_CHECK_ABORT (value >= last, "Pop order");
+    last = value;
+  }
+  SC_CHECK_ABORT (sc_ipqueue_count (pq) == 0, "Queue empty");
+}
+
+static void
+test_ipqueue (size_t n)
+{
+  size_t              zz, iz, m, *handles;
+  double             *prio, value;
+  sc_array_t         *array;
+  sc_ipqueue_t       *pq;
+
+  prio = SC_ALLOC (double, n);
+  handles = SC_ALLOC (size_t, n);
+  pq = sc_ipqueue_new (sizeof (double), test_compare_double);
+
+  /* push in random order with sparse handles */
+  for (zz = 0; zz < n; ++zz) {
+    prio[zz] = rand () / (RAND_MAX + 1.);
+    if (zz % 3 != 1) {
+      sc_ipqueue_push (pq, zz, &prio[zz]);
+    }
+  }
+  for (zz = 1; zz < n; zz += 3) {
+    SC_CHECK_ABORT (!sc_ipqueue_contains (pq, zz), "Absent handle");
+  }
+
+  /* decrease, update and remove a selection of elements */
+  m = 0;
+  for (zz = 0; zz < n; ++zz) {
+    if (zz % 3 == 1) {
+      continue;
+    }
+    SC_CHECK_ABORT (*(double *) sc_ipqueue_elem (pq, zz) == prio[zz],
+                    "Element data");
+    switch (zz % 4) {
+    case 0:
+      prio[zz] *= .5;
+      sc_ipqueue_decrease_key (pq, zz, &prio[zz]);
+      break;
+    case 1:
+      prio[zz] = rand () / (RAND_MAX + 1.);
+      sc_ipqueue_update (pq, zz, &prio[zz]);
+      break;
+    case 2:
+      if (zz % 5 == 0) {
+        sc_ipqueue_remove (pq, zz, &value);
+        SC_CHECK_ABORT (value == prio[zz], "Remove value");
+        ++m;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  test_drain (pq, prio, n - (n + 1) / 3 - m);
+
+  /* rebuild in bulk and pop in batches */
+  array = sc_array_new_data (prio, sizeof (double), n);
+  sc_ipqueue_heapify (pq, array);
+  for (zz = 0; zz < n; zz += m) {
+    m = sc_ipqueue_pop_n (pq, 7, handles + zz);
+    SC_CHECK_ABORT (m == SC_MIN (7, n - zz), "Pop n count");
+  }
+  for (iz = 1; iz < n; ++iz) {
+    SC_CHECK_ABORT (prio[handles[iz - 1]] <= prio[handles[iz]],
+                    "Pop n order");
+  }
+  sc_ipqueue_heapify (pq, array);
+  test_drain (pq, prio, n);
+  sc_array_destroy (array);
+
+  SC_GLOBAL_INFOF ("Indexed priority queue of %llu elements uses %llu"
+                   " bytes\n", (unsigned long long) n,
+                   (unsigned long long) sc_ipqueue_memory_used (pq));
+  sc_ipqueue_destroy (pq);
+  SC_FREE (handles);
+  SC_FREE (prio);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              n;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (n = 0; n <= 9; ++n) {
+    test_ipqueue (n);
+  }
+  test_ipqueue (1000);
+  test_ipqueue (12345);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -23,6 +23,93 @@
 
 #include <sc_keyvalue.h>
 
+#define TEST_KEYVALUE_MANY 1000
+
+static int
+test_keyvalue_count (const char *key, const sc_keyvalue_entry_type_t type,
+                     void *entry, const void *u)
+{
+  ++*(int *) u;
+  return 1;
+}
+
+static int
+test_keyvalue_many (void)
+{
+  int                 i, num_failed = 0;
+  char                keys[TEST_KEYVALUE_MANY][16];
+  sc_keyvalue_t      *kv;
+  sc_keyvalue_handle_t *h, *h0;
+
+  kv = sc_keyvalue_new ();
+
+  /* this handle must stay valid while the table grows */
+  h0 = sc_keyvalue_create_handle (kv, "handle", SC_KEYVALUE_ENTRY_DOUBLE);
+  sc_keyvalue_handle_set_double (h0, 2.5);
+
+  for (i = 0; i < TEST_KEYVALUE_MANY; ++i) {
+    snprintf (keys[i], 16, "key%d", i);
+    sc_keyvalue_set_int (kv, keys[i], i);
+  }
+  for (i = 0; i < TEST_KEYVALUE_MANY; ++i) {
+    if (sc_keyvalue_get_int (kv, keys[i], -1) != i) {
+      SC_VERBOSE ("Test failure on many get\n");
+      ++num_failed;
+    }
+  }
+  if (sc_keyvalue_lookup_handle (kv, "handle") != h0 ||
+      sc_keyvalue_handle_get_double (h0) != 2.5 ||
+      sc_keyvalue_get_double (kv, "handle", 0.) != 2.5) {
+    SC_VERBOSE ("Test failure on handle after growth\n");
+    ++num_failed;
+  }
+
+  /* remove every other key to exercise deletion inside probe chains */
+  for (i = 0; i < TEST_KEYVALUE_MANY; i += 2) {
+    if (sc_keyvalue_unset (kv, keys[i]) != SC_KEYVALUE_ENTRY_INT) {
+      SC_VERBOSE ("Test failure on many unset\n");
+      ++num_failed;
+    }
+  }
+  for (i = 0; i < TEST_KEYVALUE_MANY; ++i) {
+    if (sc_keyvalue_exists (kv, keys[i]) !=
+        (i % 2 ? SC_KEYVALUE_ENTRY_INT : SC_KEYVALUE_ENTRY_NONE) ||
+        sc_keyvalue_get_int (kv, keys[i], -1) != (i % 2 ? i : -1)) {
+      SC_VERBOSE ("Test failure on many after unset\n");
+      ++num_failed;
+    }
+  }
+
+  /* handles alias the entries seen through the string interface */
+  h = sc_keyvalue_lookup_handle (kv, keys[1]);
+  if (h == NULL || strcmp (sc_keyvalue_handle_key (h), keys[1]) ||
+      sc_keyvalue_handle_type (h) != SC_KEYVALUE_ENTRY_INT) {
+    SC_VERBOSE ("Test failure on handle lookup\n");
+    ++num_failed;
+  }
+  else {
+    sc_keyvalue_handle_set_int (h, -17);
+    if (sc_keyvalue_get_int (kv, keys[1], 0) != -17) {
+      SC_VERBOSE ("Test failure on handle set\n");
+      ++num_failed;
+    }
+  }
+  if (sc_keyvalue_lookup_handle (kv, keys[0]) != NULL) {
+    SC_VERBOSE ("Test failure on handle of removed key\n");
+    ++num_failed;
+  }
+
+  i = 0;
+  sc_keyvalue_foreach (kv, test_keyvalue_count, &i);
+  if (i != TEST_KEYVALUE_MANY / 2 + 1) {
+    SC_VERBOSE ("Test failure on foreach count\n");
+    ++num_failed;
+  }
+
+  sc_keyvalue_destroy (kv);
+  return num_failed;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -212,6 +299,9 @@ main (int argc, char **argv)
 
   sc_keyvalue_destroy (args2);
 
+  /* Stress the table with many keys, removals, and handles */
+  num_failed_tests += test_keyvalue_many ();
+
   /* Shutdown procedures */
   sc_finalize ();
 
@@ -0,0 +1,178 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+#define TEST_LOG_MESSAGES 10000
+
+/** Log from all threads and check every line arrived exactly once. */
+static int
+test_log_mode (sc_MPI_Comm mpicomm, int async, int per_node)
+{
+  int                 mpiret;
+  int                 rank, size, num_threads = 1;
+  int                 r, t, i;
+  int                 num_bad = 0;
+  long                num_good = 0, num_total;
+  char                line[BUFSIZ];
+  char               *seen;
+  FILE               *stream;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+#ifdef SC_ENABLE_OPENMP
+  num_threads = omp_get_max_threads ();
+#endif
+
+  stream = tmpfile ();
+  SC_CHECK_ABORT (stream != NULL, "Open temporary log file");
+  sc_set_log_defaults (stream, NULL, SC_LP_DEFAULT);
+  if (async) {
+    sc_set_log_async (1, per_node);
+  }
+
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel private (t, i)
+#endif
+  {
+#ifdef SC_ENABLE_OPENMP
+    t = omp_get_thread_num ();
+#else
+    t = 0;
+#endif
+    for (i = 0; i < TEST_LOG_MESSAGES; ++i) {
+      SC_GEN_LOGF (sc_package_id, SC_LC_NORMAL, SC_LP_ESSENTIAL,
+                   "msg %d %d %d\n", rank, t, i);
+    }
+  }
+
+  sc_log_collect ();
+  if (async) {
+    sc_set_log_async (0, 0);
+  }
+  sc_set_log_defaults (NULL, NULL, SC_LP_DEFAULT);
+
+  /* every line must be complete and unique */
+  seen = SC_ALLOC_ZERO (char, num_threads * TEST_LOG_MESSAGES);
+  rewind (stream);
+  while (fgets (line, BUFSIZ, stream) != NULL) {
+    if (sscanf (line, "[%*[^]]] msg %d %d %d", &r, &t, &i) != 3 ||
+        t < 0 || t >= num_threads || i < 0 || i >= TEST_LOG_MESSAGES) {
+      ++num_bad;
+      continue;
+    }
+    if (r == rank) {
+      if (seen[t * TEST_LOG_MESSAGES + i]++) {
+        ++num_bad;
+      }
+    }
+    ++num_good;
+  }
+  fclose (stream);
+  SC_FREE (seen);
+
+  mpiret = sc_MPI_Allreduce (&num_good, &num_total, 1, sc_MPI_LONG,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (num_bad > 0 ||
+      num_total != (long) size * num_threads * TEST_LOG_MESSAGES) {
+    SC_GLOBAL_LERRORF ("Log mode %d %d: %d bad, %ld of %ld lines\n",
+                       async, per_node, num_bad, num_total,
+                       (long) size * num_threads * TEST_LOG_MESSAGES);
+    return 1;
+  }
+  return 0;
+}
+
+static int          test_evaluated = 0;
+
+static int
+test_evaluate (void)
+{
+  return ++test_evaluated;
+}
+
+/** Check that filtered log calls do not evaluate their arguments. */
+static int
+test_log_filter (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 rank, package;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  package = sc_package_register (NULL, SC_LP_ERROR, "test_filter",
+                                 "Log filter test");
+
+  SC_GEN_LOGF (package, SC_LC_NORMAL, SC_LP_ESSENTIAL,
+               "Filtered %d\n", test_evaluate ());
+  if (test_evaluated != 0) {
+    SC_LERROR ("Filtered log arguments evaluated\n");
+    return 1;
+  }
+
+  sc_package_set_verbosity (package, SC_LP_ESSENTIAL);
+  SC_GEN_LOGF (package, SC_LC_NORMAL, SC_LP_ESSENTIAL,
+               "Passed %d\n", test_evaluate ());
+  SC_GEN_LOGF (package, SC_LC_GLOBAL, SC_LP_ESSENTIAL,
+               "Passed on root %d\n", test_evaluate ());
+  if (test_evaluated != (rank == 0 ? 2 : 1)) {
+    SC_LERROR ("Log arguments not evaluated as expected\n");
+    return 1;
+  }
+
+  sc_package_unregister (package);
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed_tests = 0;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed_tests += test_log_mode (mpicomm, 0, 0);
+  num_failed_tests += test_log_mode (mpicomm, 1, 0);
+  num_failed_tests += test_log_mode (mpicomm, 1, 1);
+  num_failed_tests += test_log_filter (mpicomm);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
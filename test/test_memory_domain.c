@@ -0,0 +1,197 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+typedef struct test_backend
+{
+  int                 num_malloc;
+  int                 num_free;
+  int                 num_copy;
+}
+test_backend_t;
+
+static void        *
+test_malloc (sc_memory_domain_t domain, size_t size, void *user)
+{
+  ++((test_backend_t *) user)->num_malloc;
+  return malloc (size);
+}
+
+static void
+test_free (sc_memory_domain_t domain, void *ptr, void *user)
+{
+  ++((test_backend_t *) user)->num_free;
+  free (ptr);
+}
+
+static void
+test_copy (void *dest, const void *src, size_t n, void *user)
+{
+  ++((test_backend_t *) user)->num_copy;
+  memcpy (dest, src, n);
+}
+
+/** Allocate many blocks per domain and free them in a different order. */
+static int
+test_accounting (void)
+{
+  const int           num = 300;
+  int                 num_failed = 0;
+  int                 d, i, status;
+  size_t              current, peak, total;
+  void              **ptrs;
+
+  status = sc_memory_status (sc_package_id);
+  ptrs = SC_ALLOC (void *, num);
+  for (d = SC_MEMORY_PINNED; d < SC_MEMORY_NUM_DOMAINS; ++d) {
+    total = 0;
+    for (i = 0; i < num; ++i) {
+      ptrs[i] = sc_malloc_domain (sc_package_id, (sc_memory_domain_t) d,
+                                  (size_t) (i + 1));
+      total += (size_t) (i + 1);
+    }
+    num_failed += sc_memory_status (sc_package_id) != status + num + 1;
+    sc_memory_domain_bytes (sc_package_id, (sc_memory_domain_t) d,
+                            &current, &peak);
+    num_failed += current != total || peak < total;
+
+    for (i = 0; i < num; ++i) {
+      int                 j = (i * 7) % num;
+
+      sc_free_domain (sc_package_id, (sc_memory_domain_t) d, ptrs[j]);
+    }
+    sc_memory_domain_bytes (sc_package_id, (sc_memory_domain_t) d,
+                            &current, &peak);
+    num_failed += current != 0 || peak < total;
+    num_failed += sc_memory_status (sc_package_id) != status + 1;
+  }
+  SC_FREE (ptrs);
+  num_failed += sc_malloc_domain (sc_package_id, SC_MEMORY_DEVICE, 0)
+    != NULL;
+  sc_free_domain (sc_package_id, SC_MEMORY_DEVICE, NULL);
+  return num_failed;
+}
+
+/** Fill an array in any domain, grow and shrink it and read it back. */
+static int
+test_array (sc_memory_domain_t domain)
+{
+  const size_t        n = 1000;
+  int                 num_failed = 0;
+  size_t              i, current;
+  int                *host;
+  sc_array_t         *a, *back, view;
+
+  host = SC_ALLOC (int, n);
+  for (i = 0; i < n; ++i) {
+    host[i] = (int) (3 * i + 1);
+  }
+
+  a = sc_array_new_domain (sizeof (int), domain);
+  sc_array_resize (a, n / 2);
+  sc_memcpy_domain (a->array, domain, host, SC_MEMORY_HOST,
+                    n / 2 * sizeof (int));
+  sc_array_resize (a, n);
+  sc_memcpy_domain (sc_array_index (a, n / 2), domain, host + n / 2,
+                    SC_MEMORY_HOST, (n - n / 2) * sizeof (int));
+  sc_memory_domain_bytes (sc_package_id, domain, &current, NULL);
+  num_failed += domain != SC_MEMORY_HOST &&
+    current != (size_t) a->byte_alloc;
+
+  /* copy back to the host through a view and sc_array_copy */
+  sc_array_init_view (&view, a, 10, n - 20);
+  num_failed += view.domain != domain;
+  back = sc_array_new (sizeof (int));
+  sc_array_copy (back, &view);
+  for (i = 0; i < n - 20; ++i) {
+    num_failed += *(int *) sc_array_index (back, i) != host[i + 10];
+  }
+
+  /* shrinking preserves the leading elements */
+  sc_array_resize (a, 10);
+  sc_array_shrink_to_fit (a);
+  sc_array_copy (back, a);
+  for (i = 0; i < 10; ++i) {
+    num_failed += *(int *) sc_array_index (back, i) != host[i];
+  }
+
+  sc_array_destroy (a);
+  sc_array_destroy (back);
+  SC_FREE (host);
+  sc_memory_domain_bytes (sc_package_id, domain, &current, NULL);
+  num_failed += domain != SC_MEMORY_HOST && current != 0;
+  return num_failed;
+}
+
+/** A custom backend is called for every device operation. */
+static int
+test_backend (void)
+{
+  int                 num_failed = 0;
+  test_backend_t      counts;
+  sc_memory_backend_t backend;
+
+  memset (&counts, 0, sizeof (counts));
+  backend.malloc_fn = test_malloc;
+  backend.free_fn = test_free;
+  backend.copy_fn = test_copy;
+  backend.device_on_host = 0;
+  backend.user = &counts;
+  sc_memory_set_backend (&backend);
+
+  num_failed += sc_memory_domain_is_host (SC_MEMORY_DEVICE);
+  num_failed += !sc_memory_domain_is_host (SC_MEMORY_PINNED);
+  num_failed += test_array (SC_MEMORY_DEVICE);
+  num_failed += counts.num_malloc == 0 || counts.num_copy == 0;
+  num_failed += counts.num_malloc != counts.num_free;
+
+  sc_memory_set_backend (NULL);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 d, num_failed = 0;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_accounting ();
+  for (d = SC_MEMORY_HOST; d < SC_MEMORY_NUM_DOMAINS; ++d) {
+    num_failed += test_array ((sc_memory_domain_t) d);
+  }
+  num_failed += test_backend ();
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Memory domain tests failed: %d\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,353 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define TEST_NUM_THREADS 4
+#define TEST_NUM_ELEMS 1000
+
+typedef struct test_mempool_thread
+{
+  int                 thread_id;
+  sc_mempool_mt_t    *pool;
+  int               **elems;    /* shared between all threads */
+}
+test_mempool_thread_t;
+
+static void        *
+test_mempool_allocate (void *arg)
+{
+  test_mempool_thread_t *tt = (test_mempool_thread_t *) arg;
+  int                 i, *p;
+  sc_mempool_cache_t  cache;
+
+  sc_mempool_cache_init (&cache, tt->pool);
+  for (i = 0; i < TEST_NUM_ELEMS; ++i) {
+    p = (int *) sc_mempool_cache_alloc (&cache);
+    SC_CHECK_ABORT (p[0] == 0 && p[1] == 0, "Mempool zero");
+    p[0] = tt->thread_id;
+    p[1] = i;
+    tt->elems[tt->thread_id * TEST_NUM_ELEMS + i] = p;
+  }
+  SC_CHECK_ABORT (cache.elem_count == TEST_NUM_ELEMS, "Mempool cache count");
+  sc_mempool_cache_reset (&cache);
+  return NULL;
+}
+
+static void        *
+test_mempool_release (void *arg)
+{
+  test_mempool_thread_t *tt = (test_mempool_thread_t *) arg;
+  int                 i, t, *p;
+  sc_mempool_cache_t  cache;
+
+  /* free the elements allocated by the next thread */
+  t = (tt->thread_id + 1) % TEST_NUM_THREADS;
+  sc_mempool_cache_init (&cache, tt->pool);
+  for (i = 0; i < TEST_NUM_ELEMS; ++i) {
+    p = tt->elems[t * TEST_NUM_ELEMS + i];
+    SC_CHECK_ABORT (p[0] == t && p[1] == i, "Mempool content");
+    p[0] = p[1] = 0;
+    sc_mempool_cache_free (&cache, p);
+  }
+  sc_mempool_cache_reset (&cache);
+  return NULL;
+}
+
+static void
+test_mempool_run (test_mempool_thread_t * tt, void *(*fn) (void *))
+{
+  int                 t;
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+  pthread_t           threads[TEST_NUM_THREADS];
+
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    pth = pthread_create (&threads[t], NULL, fn, tt + t);
+    SC_CHECK_ABORT (pth == 0, "Mempool thread create");
+  }
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    pth = pthread_join (threads[t], NULL);
+    SC_CHECK_ABORT (pth == 0, "Mempool thread join");
+  }
+#else
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    (void) fn (tt + t);
+  }
+#endif
+}
+
+static void
+test_mstamp (int flags, size_t num_items)
+{
+  size_t              zz, reserved, touched;
+  char               *item;
+  sc_mstamp_t         mst;
+  sc_mempool_t       *pool;
+
+  sc_mstamp_init_flags (&mst, 8192, 24, flags);
+  for (zz = 0; zz < num_items; ++zz) {
+    item = (char *) sc_mstamp_alloc (&mst);
+    memset (item, 1, 24);
+  }
+  sc_mstamp_memory_stats (&mst, &reserved, &touched);
+  SC_GLOBAL_INFOF ("Mstamp flags %d reserved %llu touched %llu\n", flags,
+                   (unsigned long long) reserved,
+                   (unsigned long long) touched);
+  SC_CHECK_ABORT (touched <= reserved && touched >= num_items * 24,
+                  "Mstamp memory stats");
+  SC_CHECK_ABORT ((flags & SC_MSTAMP_FIRST_TOUCH) ||
+                  touched == num_items * 24, "Mstamp touched");
+  sc_mstamp_truncate (&mst);
+  sc_mstamp_memory_stats (&mst, NULL, &touched);
+  SC_CHECK_ABORT ((flags & SC_MSTAMP_FIRST_TOUCH) || touched == 0,
+                  "Mstamp truncate");
+  sc_mstamp_reset (&mst);
+
+  pool = sc_mempool_new_flags (24, 1, flags);
+  for (zz = 0; zz < num_items; ++zz) {
+    item = (char *) sc_mempool_alloc (pool);
+    SC_CHECK_ABORT (item[0] == 0 && item[23] == 0, "Mempool flags zero");
+  }
+  SC_CHECK_ABORT (pool->elem_count == num_items, "Mempool flags count");
+  sc_mempool_destroy (pool);
+}
+
+static void
+test_mempool_n (int zero_and_persist)
+{
+  size_t              zz, n;
+  void               *elems[300];
+  sc_mempool_t       *pool;
+
+  /* a stamp holds 64 elements of this size */
+  pool = zero_and_persist ? sc_mempool_new_zero_and_persist (64) :
+    sc_mempool_new (64);
+
+  /* mix single and batch allocations across stamp boundaries */
+  for (n = 1; n <= 300; n = 2 * n + 7) {
+    sc_mempool_alloc_n (pool, n, elems);
+    for (zz = 0; zz < n; ++zz) {
+      SC_CHECK_ABORT (!zero_and_persist || *(int *) elems[zz] == 0,
+                      "Mempool n zero");
+      *(int *) elems[zz] = 0;
+    }
+    SC_CHECK_ABORT (pool->elem_count == n, "Mempool n count");
+    (void) sc_mempool_alloc (pool);
+    sc_mempool_free_n (pool, n / 2, elems);
+    sc_mempool_free_n (pool, n - n / 2, elems + n / 2);
+    sc_mempool_truncate (pool);
+  }
+
+  /* recycled elements are found again */
+  sc_mempool_alloc_n (pool, 100, elems);
+  for (zz = 0; zz < 100; ++zz) {
+    *(int *) elems[zz] = (int) zz;
+  }
+  sc_mempool_free_n (pool, 50, elems + 50);
+  sc_mempool_alloc_n (pool, 60, elems + 50);
+  for (zz = 50; zz < 100; ++zz) {
+    SC_CHECK_ABORT (!zero_and_persist || *(int *) elems[zz] >= 50,
+                    "Mempool n recycle");
+  }
+  for (zz = 100; zz < 110; ++zz) {
+    SC_CHECK_ABORT (!zero_and_persist || *(int *) elems[zz] == 0,
+                    "Mempool n fresh");
+  }
+  SC_CHECK_ABORT (pool->elem_count == 110, "Mempool n total");
+  sc_mempool_free_n (pool, 110, elems);
+  SC_CHECK_ABORT (pool->elem_count == 0, "Mempool n empty");
+  sc_mempool_destroy (pool);
+}
+
+/** Release the stamps emptied after a peak of allocations. */
+static void
+test_mempool_trim (int zero_and_persist)
+{
+  size_t              zz, kept;
+  int                *elems[640];
+  sc_mempool_t       *pool;
+  sc_mempool_stats_t  stats;
+
+  /* a stamp holds 64 elements of this size */
+  pool = zero_and_persist ? sc_mempool_new_zero_and_persist (64) :
+    sc_mempool_new (64);
+  for (zz = 0; zz < 640; ++zz) {
+    elems[zz] = (int *) sc_mempool_alloc (pool);
+    *elems[zz] = (int) zz;
+  }
+
+  /* keep some elements in the first and the sixth stamp */
+  for (kept = 0, zz = 0; zz < 640; ++zz) {
+    if ((zz < 64 && zz % 7 == 0) || zz == 5 * 64 + 3) {
+      ++kept;
+    }
+    else {
+      sc_mempool_free (pool, elems[zz]);
+    }
+  }
+  sc_mempool_get_stats (pool, &stats);
+  SC_GLOBAL_INFOF ("Mempool chunks %llu free %llu fragmentation %g\n",
+                   (unsigned long long) stats.chunks,
+                   (unsigned long long) stats.free_chunks,
+                   stats.fragmentation);
+  SC_CHECK_ABORT (stats.live == kept && stats.freed == 640 - kept &&
+                  stats.chunks == 11 && stats.free_chunks == 8 &&
+                  stats.reserved == 11 * 4096 &&
+                  stats.fragmentation == (640 - kept) / 640.,
+                  "Mempool stats");
+
+  /* the empty stamps are released and the kept elements stay */
+  SC_CHECK_ABORT (sc_mempool_trim (pool) == 8 * 4096, "Mempool trim");
+  sc_mempool_get_stats (pool, &stats);
+  SC_CHECK_ABORT (stats.live == kept && stats.freed == 128 - kept &&
+                  stats.chunks == 3 && stats.free_chunks == 0,
+                  "Mempool stats after trim");
+  for (zz = 0; zz < 640; ++zz) {
+    if ((zz < 64 && zz % 7 == 0) || zz == 5 * 64 + 3) {
+      SC_CHECK_ABORT (*elems[zz] == (int) zz, "Mempool trim kept");
+      sc_mempool_free (pool, elems[zz]);
+    }
+  }
+  SC_CHECK_ABORT (sc_mempool_trim (pool) == 2 * 4096, "Mempool trim all");
+
+  /* the current stamp starts over */
+  sc_mempool_get_stats (pool, &stats);
+  SC_CHECK_ABORT (stats.chunks == 1 && stats.freed == 0 && stats.live == 0,
+                  "Mempool stats empty");
+  for (zz = 0; zz < 100; ++zz) {
+    elems[zz] = (int *) sc_mempool_alloc (pool);
+    SC_CHECK_ABORT (!zero_and_persist || *elems[zz] == 0,
+                    "Mempool trim zero");
+  }
+  sc_mempool_destroy (pool);
+}
+
+/** Run time steps with scoped temporaries and check they reuse memory. */
+static void
+test_arena (sc_arena_t * arena)
+{
+  int                 step, status = 0;
+  size_t              zz, bytes = 0;
+  char               *first = NULL, *p, *q;
+  double             *d;
+
+  for (step = 0; step < 4; ++step) {
+    if (step == 2) {
+      /* after warming up there are no more heap calls */
+      status = sc_memory_status (sc_package_id);
+      bytes = sc_arena_memory_used (arena);
+    }
+    sc_arena_push (arena);
+    p = SC_ARENA_ALLOC (arena, char, 3);
+    SC_CHECK_ABORT (first == NULL || p == first, "Arena reuse");
+    first = p;
+    for (zz = 1; zz < 200; ++zz) {
+      q = SC_ARENA_ALLOC (arena, char, 37 * zz);
+      SC_CHECK_ABORT (((size_t) q & 15) == 0, "Arena alignment");
+      memset (q, (int) zz, 37 * zz);
+    }
+
+    /* a nested scope releases only its own memory */
+    sc_arena_push (arena);
+    d = SC_ARENA_ALLOC_ZERO (arena, double, 100000);
+    SC_CHECK_ABORT (d[0] == 0. && d[99999] == 0., "Arena zero");
+    sc_arena_pop (arena);
+    SC_CHECK_ABORT (q[37 * 199 - 1] == (char) 199, "Arena outer scope");
+    sc_arena_pop (arena);
+    if (step >= 2) {
+      SC_CHECK_ABORT (sc_memory_status (sc_package_id) == status &&
+                      sc_arena_memory_used (arena) == bytes,
+                      "Arena steady state");
+    }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 t, round;
+  int               **elems;
+  sc_mempool_mt_t    *pool;
+  test_mempool_thread_t tt[TEST_NUM_THREADS];
+  sc_arena_t         *arena;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* elements are zeroed when new and persist when recycled */
+  pool = sc_mempool_mt_new_zero_and_persist (2 * sizeof (int));
+  elems = SC_ALLOC (int *, TEST_NUM_THREADS * TEST_NUM_ELEMS);
+  for (t = 0; t < TEST_NUM_THREADS; ++t) {
+    tt[t].thread_id = t;
+    tt[t].pool = pool;
+    tt[t].elems = elems;
+  }
+  for (round = 0; round < 3; ++round) {
+    test_mempool_run (tt, test_mempool_allocate);
+    SC_CHECK_ABORT (sc_mempool_mt_elem_count (pool) ==
+                    TEST_NUM_THREADS * TEST_NUM_ELEMS, "Mempool count");
+    test_mempool_run (tt, test_mempool_release);
+    SC_CHECK_ABORT (sc_mempool_mt_elem_count (pool) == 0,
+                    "Mempool count after free");
+  }
+  SC_GLOBAL_INFOF ("Mempool memory used %llu\n", (unsigned long long)
+                   sc_mempool_mt_memory_used (pool));
+  SC_FREE (elems);
+  sc_mempool_mt_destroy (pool);
+
+  test_mempool_n (0);
+  test_mempool_n (1);
+  test_mempool_trim (0);
+  test_mempool_trim (1);
+  test_mstamp (0, 100000);
+  test_mstamp (SC_MSTAMP_FIRST_TOUCH, 100000);
+  test_mstamp (SC_MSTAMP_HUGE_PAGES, 100000);
+  test_mstamp (SC_MSTAMP_HUGE_PAGES | SC_MSTAMP_FIRST_TOUCH, 3);
+
+  arena = sc_arena_new (1000);
+  test_arena (arena);
+  sc_arena_reset (arena);
+  test_arena (arena);
+  sc_arena_destroy (arena);
+  test_arena (sc_arena_default ());
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel
+  {
+    test_arena (sc_arena_default ());
+  }
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+
+#include <sc.h>
+
+#ifdef SC_ENABLE_MPI
+
+/** Pass a message of \a bytes bytes around a ring and check it. */
+static int
+test_large_ring (sc_MPI_Comm mpicomm, int rank, int size, size_t bytes)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  size_t              zz;
+  char               *sendbuf, *recvbuf;
+  sc_MPI_Request      request[2];
+
+  sendbuf = SC_ALLOC (char, bytes);
+  recvbuf = SC_ALLOC (char, bytes);
+  for (zz = 0; zz < bytes; zz += 4093) {
+    sendbuf[zz] = (char) (rank + zz);
+  }
+  mpiret = sc_mpi_irecv_large (recvbuf, bytes, (rank + size - 1) % size,
+                               SC_TAG_FIRST, mpicomm, request);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_mpi_isend_large (sendbuf, bytes, (rank + 1) % size,
+                               SC_TAG_FIRST, mpicomm, request + 1);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Waitall (2, request, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  for (zz = 0; zz < bytes; zz += 4093) {
+    if (recvbuf[zz] != (char) ((rank + size - 1) % size + zz)) {
+      ++failed;
+      break;
+    }
+  }
+  SC_FREE (sendbuf);
+  SC_FREE (recvbuf);
+  return failed;
+}
+
+#endif
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 failed = 0;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+#ifdef SC_ENABLE_MPI
+  failed += test_large_ring (mpicomm, rank, size, 100000);
+
+  /* a message beyond INT_MAX bytes needs several GiB of memory */
+  if (getenv ("SC_TEST_LARGE") != NULL) {
+    failed += test_large_ring (mpicomm, rank, size,
+                               (size_t) INT_MAX + SC_MPI_LARGE_CHUNK / 2);
+  }
+#endif
+  if (failed) {
+    SC_LERROR ("Large message mismatch\n");
+  }
+
+  mpiret = sc_MPI_Allreduce (&failed, &rank, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  failed = rank;
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc.h>
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 num_failed = 0;
+  int                 in[4], out[4];
+  long                calls, expect_calls;
+  double              sent, received, seconds, expect_bytes;
+  double              send[10], recv[10];
+  sc_MPI_Request      requests[2];
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+
+  sc_mpi_stats_start ();
+  SC_CHECK_ABORT (sc_mpi_stats_is_active (), "Statistics not active");
+
+  /* the outer category applies to the nested calls */
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_ALLGATHER);
+  in[0] = in[1] = in[2] = in[3] = rank;
+  mpiret = sc_MPI_Allreduce (in, out, 4, sc_MPI_INT, sc_MPI_SUM,
+                             sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (out[3] != size * (size - 1) / 2) {
+    ++num_failed;
+  }
+  sc_mpi_stats_enter (SC_MPI_CATEGORY_REDUCE);
+  if (size > 1) {
+    memset (send, 0, sizeof (send));
+    mpiret = sc_MPI_Irecv (recv, 10, sc_MPI_DOUBLE, (rank + size - 1) % size,
+                           0, sc_MPI_COMM_WORLD, &requests[0]);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Isend (send, 10, sc_MPI_DOUBLE, (rank + 1) % size,
+                           0, sc_MPI_COMM_WORLD, &requests[1]);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Waitall (2, requests, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  sc_mpi_stats_leave ();
+  sc_mpi_stats_leave ();
+
+  /* nothing is counted after stopping */
+  sc_mpi_stats_stop ();
+  mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+
+  sc_mpi_stats_get (SC_MPI_CATEGORY_ALLGATHER, &calls, &sent, &received,
+                    &seconds);
+#ifdef SC_ENABLE_MPI
+  expect_calls = 1 + (size > 1 ? 3 : 0);
+  expect_bytes = 4 * sizeof (int) + (size > 1 ? 10 * sizeof (double) : 0);
+#else
+  expect_calls = 0;
+  expect_bytes = 0.;
+#endif
+  if (calls != expect_calls || sent != expect_bytes ||
+      received != expect_bytes || seconds < 0.) {
+    SC_LERRORF ("Counted %ld calls %g sent %g received\n",
+                calls, sent, received);
+    ++num_failed;
+  }
+  sc_mpi_stats_get (SC_MPI_CATEGORY_REDUCE, &calls, NULL, NULL, NULL);
+  num_failed += calls != 0;
+  sc_mpi_stats_get (SC_MPI_CATEGORY_OTHER, &calls, NULL, NULL, NULL);
+  num_failed += calls != 0;
+
+  sc_mpi_stats_print (sc_MPI_COMM_WORLD, -1, SC_LP_ESSENTIAL);
+  SC_CHECK_ABORT (num_failed == 0, "MPI statistics");
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,331 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc.h>
+#include <sc_mpi.h>
+#include <sc_notify.h>
+#include <sc_sort.h>
+
+#define TEST_MPI_THREADS_TAG 7
+
+/* the serial sc_MPI_* layer has no point-to-point messages */
+#if defined SC_ENABLE_MPI || defined SC_ENABLE_PTHREAD
+#define TEST_MPI_THREADS_P2P
+#endif
+
+static int
+test_compare_int (const void *a, const void *b)
+{
+  const int           i = *(const int *) a, j = *(const int *) b;
+
+  return i < j ? -1 : i > j;
+}
+
+/* collectives, checked against values every rank can compute */
+static int
+test_collectives (sc_MPI_Comm comm, int rank, int size)
+{
+  int                 mpiret, failed = 0, i, sum;
+  int                 value, bcast, scan, exscan, pair[2], minloc[2];
+  int                *gathered, *sendc, *sdispl, *recvc, *rdispl;
+  int                *sendbuf, *recvbuf, *block;
+  double              dvalue, dmax;
+
+  /* gather the ranks to everyone */
+  gathered = SC_ALLOC (int, size);
+  value = 10 * rank;
+  mpiret = sc_MPI_Allgather (&value, 1, sc_MPI_INT, gathered, 1, sc_MPI_INT,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < size; ++i) {
+    failed |= gathered[i] != 10 * i;
+  }
+
+  /* broadcast from the last rank */
+  bcast = rank == size - 1 ? 4711 : -1;
+  mpiret = sc_MPI_Bcast (&bcast, 1, sc_MPI_INT, size - 1, comm);
+  SC_CHECK_MPI (mpiret);
+  failed |= bcast != 4711;
+
+  /* reductions and scans */
+  dvalue = rank + .5;
+  mpiret = sc_MPI_Allreduce (&dvalue, &dmax, 1, sc_MPI_DOUBLE, sc_MPI_MAX,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  failed |= dmax != size - .5;
+  pair[0] = rank % 2;
+  pair[1] = rank;
+  mpiret = sc_MPI_Allreduce (pair, minloc, 1, sc_MPI_2INT, sc_MPI_MINLOC,
+                             comm);
+  SC_CHECK_MPI (mpiret);
+  failed |= minloc[0] != 0 || minloc[1] != 0;
+  value = rank + 1;
+  mpiret = sc_MPI_Scan (&value, &scan, 1, sc_MPI_INT, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  failed |= scan != (rank + 1) * (rank + 2) / 2;
+  exscan = 0;
+  mpiret = sc_MPI_Exscan (&value, &exscan, 1, sc_MPI_INT, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  failed |= rank > 0 && exscan != rank * (rank + 1) / 2;
+
+  /* every rank sends i + 1 copies of its rank to rank i */
+  sendc = SC_ALLOC (int, size);
+  sdispl = SC_ALLOC (int, size);
+  recvc = SC_ALLOC (int, size);
+  rdispl = SC_ALLOC (int, size);
+  for (sum = 0, i = 0; i < size; ++i) {
+    sendc[i] = i + 1;
+    sdispl[i] = sum;
+    sum += sendc[i];
+  }
+  sendbuf = SC_ALLOC (int, sum);
+  for (i = 0; i < sum; ++i) {
+    sendbuf[i] = rank;
+  }
+  for (i = 0; i < size; ++i) {
+    recvc[i] = rank + 1;
+    rdispl[i] = i * (rank + 1);
+  }
+  recvbuf = SC_ALLOC (int, size * (rank + 1));
+  mpiret = sc_MPI_Alltoallv (sendbuf, sendc, sdispl, sc_MPI_INT,
+                             recvbuf, recvc, rdispl, sc_MPI_INT, comm);
+  SC_CHECK_MPI (mpiret);
+  for (i = 0; i < size * (rank + 1); ++i) {
+    failed |= recvbuf[i] != i / (rank + 1);
+  }
+
+  /* reduce one block per rank */
+  block = SC_ALLOC (int, size);
+  for (i = 0; i < size; ++i) {
+    block[i] = rank * i;
+  }
+  mpiret = sc_MPI_Reduce_scatter_block (block, &value, 1, sc_MPI_INT,
+                                        sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  failed |= value != rank * (size - 1) * size / 2;
+
+  SC_FREE (gathered);
+  SC_FREE (sendc);
+  SC_FREE (sdispl);
+  SC_FREE (recvc);
+  SC_FREE (rdispl);
+  SC_FREE (sendbuf);
+  SC_FREE (recvbuf);
+  SC_FREE (block);
+  return failed;
+}
+
+/* nonblocking ring exchange and a blocking message to ourselves */
+static int
+test_point_to_point (sc_MPI_Comm comm, int rank, int size)
+{
+#ifdef TEST_MPI_THREADS_P2P
+  int                 mpiret, failed = 0, count, flag;
+  int                 out[3], in[3], self, back;
+  sc_MPI_Request      requests[2];
+  sc_MPI_Status       statuses[2], status;
+
+  out[0] = rank;
+  out[1] = rank * rank;
+  out[2] = -rank;
+  mpiret = sc_MPI_Irecv (in, 3, sc_MPI_INT, sc_MPI_ANY_SOURCE,
+                         TEST_MPI_THREADS_TAG, comm, &requests[0]);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Isend (out, 3, sc_MPI_INT, (rank + 1) % size,
+                         TEST_MPI_THREADS_TAG, comm, &requests[1]);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Waitall (2, requests, statuses);
+  SC_CHECK_MPI (mpiret);
+  back = (rank + size - 1) % size;
+  failed |= in[0] != back || in[1] != back * back || in[2] != -back;
+  failed |= statuses[0].MPI_SOURCE != back;
+  failed |= statuses[0].MPI_TAG != TEST_MPI_THREADS_TAG;
+  failed |= requests[0] != sc_MPI_REQUEST_NULL;
+
+  self = 100 + rank;
+  mpiret = sc_MPI_Send (&self, 1, sc_MPI_INT, rank, 0, comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Iprobe (rank, sc_MPI_ANY_TAG, comm, &flag, &status);
+  SC_CHECK_MPI (mpiret);
+  failed |= !flag;
+  mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, 0, comm, &status);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Get_count (&status, sc_MPI_INT, &count);
+  SC_CHECK_MPI (mpiret);
+  failed |= count != 1 || status.MPI_SOURCE != rank;
+  mpiret = sc_MPI_Recv (&back, 1, sc_MPI_INT, status.MPI_SOURCE,
+                        status.MPI_TAG, comm, sc_MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  failed |= back != self;
+  return failed;
+#else
+  return 0;
+#endif
+}
+
+/* libsc algorithms built on the sc_MPI_* layer */
+static int
+test_algorithms (sc_MPI_Comm comm, int rank, int size)
+{
+  int                 mpiret, failed = 0, i, q, num_receivers;
+  int                 num_senders, expected, next;
+  int                *receivers, *senders, *data;
+  size_t             *nmemb;
+  sc_MPI_Request      request;
+
+  /* notify the next two ranks */
+  receivers = SC_ALLOC (int, size);
+  senders = SC_ALLOC (int, size);
+  for (num_receivers = 0, q = 0; q < size; ++q) {
+    if (q != rank && ((q - rank + size) % size == 1 ||
+                      (q - rank + size) % size == 2)) {
+      receivers[num_receivers++] = q;
+    }
+  }
+  mpiret = sc_notify (receivers, num_receivers, senders, &num_senders, comm);
+  SC_CHECK_MPI (mpiret);
+  for (expected = 0, q = 0; q < size; ++q) {
+    if (q != rank && ((rank - q + size) % size == 1 ||
+                      (rank - q + size) % size == 2)) {
+      failed |= expected >= num_senders || senders[expected] != q;
+      ++expected;
+    }
+  }
+  failed |= expected != num_senders;
+  SC_FREE (receivers);
+  SC_FREE (senders);
+
+  /* sort distributed data of uneven length */
+  nmemb = SC_ALLOC (size_t, size);
+  for (q = 0; q < size; ++q) {
+    nmemb[q] = 3 + q;
+  }
+  data = SC_ALLOC (int, nmemb[rank]);
+  for (i = 0; i < (int) nmemb[rank]; ++i) {
+    data[i] = (rank * 7919 + i * 104729) % 1009;
+  }
+  sc_psort (comm, data, nmemb, sizeof (int), test_compare_int);
+  for (i = 1; i < (int) nmemb[rank]; ++i) {
+    failed |= data[i - 1] > data[i];
+  }
+  if (size > 1) {
+    /* the first item of the next rank is not smaller than our last */
+    mpiret = sc_MPI_Isend (data, 1, sc_MPI_INT, (rank + size - 1) % size,
+                           TEST_MPI_THREADS_TAG, comm, &request);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Recv (&next, 1, sc_MPI_INT, (rank + 1) % size,
+                          TEST_MPI_THREADS_TAG, comm, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    failed |= rank < size - 1 && next < data[nmemb[rank] - 1];
+  }
+  SC_FREE (data);
+  SC_FREE (nmemb);
+  return failed;
+}
+
+/* the program run by every rank */
+static int
+test_rank_main (void *user)
+{
+  int                 mpiret, failed = 0, anyfailed;
+  int                 rank, size, subrank, subsize, result;
+  sc_MPI_Comm         dupcomm, splitcomm;
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+  failed |= size != *(int *) user && *(int *) user > 0;
+
+  mpiret = sc_MPI_Comm_dup (sc_MPI_COMM_WORLD, &dupcomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_compare (sc_MPI_COMM_WORLD, dupcomm, &result);
+  SC_CHECK_MPI (mpiret);
+#ifdef TEST_MPI_THREADS_P2P
+  failed |= result != sc_MPI_CONGRUENT;
+#else
+  /* the serial layer duplicates by returning the same communicator */
+  failed |= result != sc_MPI_IDENT;
+#endif
+  failed |= test_collectives (dupcomm, rank, size);
+  failed |= test_point_to_point (dupcomm, rank, size);
+  failed |= test_algorithms (dupcomm, rank, size);
+
+  /* split into even and odd ranks in reverse order */
+  mpiret = sc_MPI_Comm_split (dupcomm, rank % 2, -rank, &splitcomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (splitcomm, &subsize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (splitcomm, &subrank);
+  SC_CHECK_MPI (mpiret);
+  failed |= subsize != (size + 1 - rank % 2) / 2;
+  failed |= subrank != subsize - 1 - rank / 2;
+  failed |= test_collectives (splitcomm, subrank, subsize);
+  failed |= test_point_to_point (splitcomm, subrank, subsize);
+  mpiret = sc_MPI_Comm_free (&splitcomm);
+  SC_CHECK_MPI (mpiret);
+
+  failed |= test_point_to_point (sc_MPI_COMM_SELF, 0, 1);
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT, sc_MPI_MAX,
+                             dupcomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_free (&dupcomm);
+  SC_CHECK_MPI (mpiret);
+  if (failed) {
+    SC_LERRORF ("Rank %d of %d failed\n", rank, size);
+  }
+  return anyfailed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, failed = 0;
+  int                 num_ranks;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#if !defined SC_ENABLE_MPI && defined SC_ENABLE_PTHREAD
+  /* run the same program on several emulated rank counts */
+  for (num_ranks = 1; num_ranks <= 8; num_ranks += num_ranks < 3 ? 1 : 2) {
+    SC_GLOBAL_PRODUCTIONF ("Running %d emulated ranks\n", num_ranks);
+    failed |= sc_mpi_threads_run (num_ranks, test_rank_main, &num_ranks);
+  }
+#else
+  /* run the program once on the ranks of this job */
+  num_ranks = 0;
+  failed |= sc_mpi_threads_run (1, test_rank_main, &num_ranks);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? 1 : 0;
+}
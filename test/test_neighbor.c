@@ -0,0 +1,131 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_neighbor.h>
+#include <sc_notify.h>
+
+/* the number of values sent to a rank depends on the receiving rank */
+#define TEST_NEIGHBOR_COUNT(r) (1 + (r) % 3)
+
+int
+main (int argc, char **argv)
+{
+  int                 failed = 0, anyfailed;
+  int                 mpiret;
+  int                 rank, size;
+  int                 i, j, k, step, peer;
+  int                 num_receivers, num_senders;
+  int                *sendcounts, *sdispls, *recvcounts, *rdispls;
+  int                *sendbuf, *recvbuf;
+  sc_array_t         *receivers, *senders;
+  sc_neighbor_exchange_t *exchange;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* send to the next and the third next rank, including possibly self */
+  receivers = sc_array_new (sizeof (int));
+  for (i = 1; i <= 3; i += 2) {
+    *(int *) sc_array_push (receivers) = (rank + i) % size;
+  }
+  sc_array_sort (receivers, sc_int_compare);
+  sc_array_uniq (receivers, sc_int_compare);
+  senders = sc_array_new (sizeof (int));
+  sc_notify_ext (receivers, senders, NULL, NULL, mpicomm);
+  num_receivers = (int) receivers->elem_count;
+  num_senders = (int) senders->elem_count;
+
+  sendcounts = SC_ALLOC (int, 2 * (num_receivers + num_senders));
+  sdispls = sendcounts + num_receivers;
+  recvcounts = sdispls + num_receivers;
+  rdispls = recvcounts + num_senders;
+  for (k = i = 0; i < num_receivers; ++i) {
+    peer = *(int *) sc_array_index_int (receivers, i);
+    sendcounts[i] = TEST_NEIGHBOR_COUNT (peer);
+    sdispls[i] = k;
+    k += sendcounts[i];
+  }
+  sendbuf = SC_ALLOC (int, k);
+  for (k = i = 0; i < num_senders; ++i) {
+    recvcounts[i] = TEST_NEIGHBOR_COUNT (rank);
+    rdispls[i] = k;
+    k += recvcounts[i];
+  }
+  recvbuf = SC_ALLOC (int, k);
+
+  exchange = sc_neighbor_exchange_new (mpicomm, receivers, senders,
+                                       sendbuf, sendcounts, sdispls,
+                                       recvbuf, recvcounts, rdispls,
+                                       sc_MPI_INT);
+  for (step = 0; step < 3; ++step) {
+    for (i = 0; i < num_receivers; ++i) {
+      for (j = 0; j < sendcounts[i]; ++j) {
+        sendbuf[sdispls[i] + j] = 1000 * step + 10 * rank + j;
+      }
+    }
+    sc_neighbor_exchange_start (exchange);
+    if (step == 1) {
+      while (!sc_neighbor_exchange_test (exchange)) {
+      }
+    }
+    else {
+      sc_neighbor_exchange_wait (exchange);
+    }
+    for (i = 0; i < num_senders; ++i) {
+      peer = *(int *) sc_array_index_int (senders, i);
+      for (j = 0; j < recvcounts[i]; ++j) {
+        if (recvbuf[rdispls[i] + j] != 1000 * step + 10 * peer + j) {
+          SC_LERRORF ("Mismatch from %d in step %d\n", peer, step);
+          failed = 1;
+        }
+      }
+    }
+  }
+  sc_neighbor_exchange_destroy (exchange);
+
+  SC_FREE (sendbuf);
+  SC_FREE (recvbuf);
+  SC_FREE (sendcounts);
+  sc_array_destroy (receivers);
+  sc_array_destroy (senders);
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
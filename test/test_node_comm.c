@@ -36,14 +36,17 @@
 int
 test_shmem (int count, sc_MPI_Comm comm, sc_shmem_type_t type)
 {
-  int                 i, p, size, mpiret, check;
+  int                 i, p, size, rank, mpiret, check, total;
+  int                *counts, *displs;
   long int           *myval, *recv_self, *recv_shmem, *scan_self, *scan_shmem,
-                     *copy_shmem;
+                     *copy_shmem, *reduce_self, *reduce_shmem, *recvv_shmem;
 
   sc_shmem_set_type (comm, type);
 
   mpiret = sc_MPI_Comm_size (comm, &size);
   SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
 
   myval = SC_ALLOC (long int, count);
   for (i = 0; i < count; i++) {
@@ -52,6 +55,7 @@ test_shmem (int count, sc_MPI_Comm comm, sc_shmem_type_t type)
 
   recv_self = SC_ALLOC (long int, count * size);
   scan_self = SC_ALLOC (long int, count * (size + 1));
+  reduce_self = SC_ALLOC (long int, count);
   mpiret = sc_MPI_Allgather (myval, count, sc_MPI_LONG,
                              recv_self, count, sc_MPI_LONG, comm);
   SC_CHECK_MPI (mpiret);
@@ -86,6 +90,40 @@ test_shmem (int count, sc_MPI_Comm comm, sc_shmem_type_t type)
   SC_SHMEM_FREE (copy_shmem, comm);
   SC_SHMEM_FREE (recv_shmem, comm);
 
+  /* odd processes contribute all of their values, even ones half */
+  counts = SC_ALLOC (int, 2 * size);
+  displs = counts + size;
+  for (total = 0, p = 0; p < size; p++) {
+    counts[p] = p % 2 ? count : count / 2;
+    displs[p] = total;
+    total += counts[p];
+  }
+  recvv_shmem = SC_SHMEM_ALLOC (long int, (size_t) total + 1, comm);
+  sc_shmem_allgatherv (myval, counts[rank], sc_MPI_LONG, recvv_shmem,
+                       counts, displs, sc_MPI_LONG, comm);
+  for (p = 0; p < size; p++) {
+    if (memcmp (recvv_shmem + displs[p], recv_self + count * p,
+                counts[p] * sizeof (long int))) {
+      SC_GLOBAL_LERROR ("sc_shmem_allgatherv mismatch\n");
+      return 1;
+    }
+  }
+  SC_SHMEM_FREE (recvv_shmem, comm);
+  SC_FREE (counts);
+
+  reduce_shmem = SC_SHMEM_ALLOC (long int, (size_t) count, comm);
+  mpiret = sc_MPI_Allreduce (myval, reduce_self, count, sc_MPI_LONG,
+                             sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  sc_shmem_allreduce (myval, reduce_shmem, count, sc_MPI_LONG, sc_MPI_MAX,
+                      comm);
+  check = memcmp (reduce_self, reduce_shmem, count * sizeof (long int));
+  if (check) {
+    SC_GLOBAL_LERROR ("sc_shmem_allreduce mismatch\n");
+    return 3;
+  }
+  SC_SHMEM_FREE (reduce_shmem, comm);
+
   scan_shmem = SC_SHMEM_ALLOC (long int, (size_t) count * (size + 1), comm);
   sc_shmem_prefix (myval, scan_shmem, count, sc_MPI_LONG, sc_MPI_SUM, comm);
   check =
@@ -96,12 +134,98 @@ test_shmem (int count, sc_MPI_Comm comm, sc_shmem_type_t type)
   }
   SC_SHMEM_FREE (scan_shmem, comm);
 
+  SC_FREE (reduce_self);
   SC_FREE (scan_self);
   SC_FREE (recv_self);
   SC_FREE (myval);
   return 0;
 }
 
+/* allocate on a communicator whose type has never been set */
+static int
+test_shmem_default (sc_MPI_Comm comm)
+{
+  int                 mpiret;
+  int                 i, failed = 0;
+  long               *array;
+  sc_MPI_Comm         dup;
+
+  /* a duplicate does not inherit a type if none was set on comm */
+  mpiret = sc_MPI_Comm_dup (comm, &dup);
+  SC_CHECK_MPI (mpiret);
+
+  array = SC_SHMEM_ALLOC (long, 100, dup);
+  if (sc_shmem_write_start (array, dup)) {
+    for (i = 0; i < 100; ++i) {
+      array[i] = i;
+    }
+  }
+  sc_shmem_write_end (array, dup);
+  for (i = 0; i < 100; ++i) {
+    if (array[i] != i) {
+      ++failed;
+    }
+  }
+  if (failed) {
+    SC_LERROR ("sc_shmem default type mismatch\n");
+  }
+  SC_SHMEM_FREE (array, dup);
+
+  mpiret = sc_MPI_Comm_free (&dup);
+  SC_CHECK_MPI (mpiret);
+  return failed ? 1 : 0;
+}
+
+/* allocate and free shared arrays of various sizes in interleaved order */
+static int
+test_shmem_pool (sc_MPI_Comm comm)
+{
+  int                 i, j, k;
+  int                *arrays[8];
+  size_t              counts[8];
+  sc_shmem_type_t     type;
+
+  sc_shmem_set_type (comm, SC_SHMEM_AUTO);
+  type = sc_shmem_get_type (comm);
+  if (type < 0 || type >= SC_SHMEM_NUM_TYPES) {
+    SC_GLOBAL_LERROR ("sc_shmem auto type not resolved\n");
+    return 1;
+  }
+  SC_GLOBAL_PRODUCTIONF ("sc_shmem auto type: %s\n",
+                         sc_shmem_type_to_string[type]);
+
+  for (k = 0; k < 3; ++k) {
+    for (i = 0; i < 8; ++i) {
+      /* one array larger than a pool chunk */
+      counts[i] = i == 5 ? SC_SHMEM_POOL_CHUNK : (size_t) (1 + 1000 * i);
+      arrays[i] = SC_SHMEM_ALLOC (int, counts[i], comm);
+      if (sc_shmem_write_start (arrays[i], comm)) {
+        for (j = 0; j < (int) counts[i]; ++j) {
+          arrays[i][j] = 8 * k + i;
+        }
+      }
+      sc_shmem_write_end (arrays[i], comm);
+      if (i % 3 == 1) {
+        SC_SHMEM_FREE (arrays[i - 1], comm);
+        arrays[i - 1] = NULL;
+      }
+    }
+    for (i = 0; i < 8; ++i) {
+      if (arrays[i] == NULL) {
+        continue;
+      }
+      for (j = 0; j < (int) counts[i]; ++j) {
+        if (arrays[i][j] != 8 * k + i) {
+          SC_LERRORF ("sc_shmem pool mismatch in array %d\n", i);
+          return 1;
+        }
+      }
+      SC_SHMEM_FREE (arrays[i], comm);
+    }
+  }
+  return 0;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -119,14 +243,22 @@ main (int argc, char **argv)
 
   sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
 
+  /* this must run before any type is set on the world communicator */
+  retval += test_shmem_default (sc_MPI_COMM_WORLD);
+
   srandom (rank);
   for (itype = 0; itype < (int) SC_SHMEM_NUM_TYPES; itype++) {
 
     SC_GLOBAL_PRODUCTIONF ("sc_shmem type: %s\n",
                            sc_shmem_type_to_string[itype]);
-    for (count = 1; count <= 3; count++) {
+    /* the last count is long enough for a cooperative scan */
+    for (count = 1; count <= 4; count++) {
       int                 retvalin = retval;
 
+      if (count == 4) {
+        count = SC_SHMEM_SCAN_SPLIT;
+      }
+
       SC_GLOBAL_PRODUCTIONF ("  count = %d\n", count);
       retval +=
         test_shmem (count, sc_MPI_COMM_WORLD, (sc_shmem_type_t) itype);
@@ -139,6 +271,8 @@ main (int argc, char **argv)
     }
   }
 
+  retval += test_shmem_pool (sc_MPI_COMM_WORLD);
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
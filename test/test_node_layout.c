@@ -0,0 +1,153 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc.h>
+#include <sc_mpi.h>
+
+#if defined(SC_ENABLE_MPI)
+
+/* check the cached layout against the node communicators */
+static int
+test_layout (sc_MPI_Comm comm, int expect_ppn)
+{
+  int                 mpiret, p, rank, size, failed = 0;
+  int                 intrarank, intrasize, node, sameranks;
+  const int          *locations, *again;
+  sc_MPI_Comm         intranode, internode, intra2, inter2;
+
+  mpiret = sc_MPI_Comm_size (comm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the first query computes, the second one returns the cached comms */
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  sc_mpi_comm_get_node_comms (comm, &intra2, &inter2);
+  if (intranode != intra2 || internode != inter2) {
+    SC_LERROR ("Node comms are not cached\n");
+    return 1;
+  }
+  locations = sc_mpi_comm_get_node_locations (comm);
+  again = sc_mpi_comm_get_node_locations (comm);
+  if (locations != again) {
+    SC_LERROR ("Node locations are not cached\n");
+    return 1;
+  }
+  if (intranode == sc_MPI_COMM_NULL) {
+    SC_GLOBAL_PRODUCTION ("No node communicators\n");
+    return locations != NULL || expect_ppn > 0;
+  }
+  SC_CHECK_ABORT (locations != NULL, "Node locations missing");
+
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (internode, &node);
+  SC_CHECK_MPI (mpiret);
+  SC_GLOBAL_PRODUCTIONF ("Node communicator size %d\n", intrasize);
+  if (expect_ppn > 0 && intrasize != expect_ppn) {
+    SC_LERROR ("Node size mismatch\n");
+    failed = 1;
+  }
+
+  /* our own entry and the node membership agree with the comms */
+  if (locations[2 * rank] != node || locations[2 * rank + 1] != intrarank) {
+    SC_LERROR ("Own location mismatch\n");
+    failed = 1;
+  }
+  sameranks = 0;
+  for (p = 0; p < size; ++p) {
+    if (locations[2 * p] == node) {
+      if (locations[2 * p + 1] < 0 || locations[2 * p + 1] >= intrasize) {
+        SC_LERROR ("Intranode rank out of range\n");
+        failed = 1;
+      }
+      ++sameranks;
+    }
+  }
+  if (sameranks != intrasize) {
+    SC_LERROR ("Node membership mismatch\n");
+    failed = 1;
+  }
+  return failed;
+}
+
+#endif /* SC_ENABLE_MPI */
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, size;
+  int                 failed = 0, anyfailed;
+  sc_MPI_Comm         mpicomm, dupcomm, intranode, internode;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+#if defined(SC_ENABLE_MPI)
+  mpiret = sc_MPI_Comm_dup (mpicomm, &dupcomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* the pending layout of sc_init is inherited and determined on use */
+  failed |= test_layout (dupcomm, 0);
+
+  /* an explicit attachment replaces the cached one */
+  sc_mpi_comm_attach_node_comms (dupcomm, size % 2 == 0 ? 2 : 1);
+  failed |= test_layout (dupcomm, size % 2 == 0 ? 2 : 1);
+
+  /* detaching leaves no node comms and no layout */
+  sc_mpi_comm_detach_node_comms (dupcomm);
+  sc_mpi_comm_get_node_comms (dupcomm, &intranode, &internode);
+  failed |= intranode != sc_MPI_COMM_NULL;
+  failed |= sc_mpi_comm_get_node_locations (dupcomm) != NULL;
+
+  /* an automatic attachment is pending until the next query */
+  sc_mpi_comm_attach_node_comms (dupcomm, 0);
+  failed |= test_layout (dupcomm, 0);
+
+  mpiret = sc_MPI_Comm_free (&dupcomm);
+  SC_CHECK_MPI (mpiret);
+#else
+  dupcomm = mpicomm;
+  sc_mpi_comm_get_node_comms (dupcomm, &intranode, &internode);
+  failed |= intranode != sc_MPI_COMM_NULL;
+  failed |= sc_mpi_comm_get_node_locations (dupcomm) != NULL;
+#endif
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? 1 : 0;
+}
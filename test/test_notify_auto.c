@@ -0,0 +1,178 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_notify.h>
+
+#define TEST_AUTO_FILE "sc_test_notify_auto.txt"
+
+/** Notify the receivers and compare the senders with sc_notify_allgather. */
+static int
+test_auto_call (sc_notify_t * notify, int rank, int size, int step,
+                int payload)
+{
+  int                 mpiret;
+  int                 i, failed = 0;
+  int                 num_receivers, num_senders;
+  int                 receivers[3], *senders;
+  sc_array_t         *arecv, *asend, *in_payload, *out_payload;
+
+  /* a small pattern that differs between the steps */
+  num_receivers = 0;
+  for (i = 0; i < 3; ++i) {
+    if ((rank + step + i) % 2 == 0) {
+      receivers[num_receivers++] = (rank + i * (step + 1)) % size;
+    }
+  }
+  qsort (receivers, num_receivers, sizeof (int), sc_int_compare);
+  for (i = 1; i < num_receivers; ++i) {
+    if (receivers[i] == receivers[i - 1]) {
+      memmove (receivers + i, receivers + i + 1,
+               (num_receivers - i - 1) * sizeof (int));
+      --num_receivers;
+      --i;
+    }
+  }
+  senders = SC_ALLOC (int, size);
+  mpiret = sc_notify_allgather (receivers, num_receivers, senders,
+                                &num_senders, sc_notify_get_comm (notify));
+  SC_CHECK_MPI (mpiret);
+
+  arecv = sc_array_new_count (sizeof (int), (size_t) num_receivers);
+  memcpy (arecv->array, receivers, num_receivers * sizeof (int));
+  asend = sc_array_new (sizeof (int));
+  in_payload = out_payload = NULL;
+  if (payload) {
+    in_payload = sc_array_new_count (sizeof (int), (size_t) num_receivers);
+    for (i = 0; i < num_receivers; ++i) {
+      *(int *) sc_array_index_int (in_payload, i) = rank;
+    }
+    out_payload = sc_array_new (sizeof (int));
+  }
+  sc_notify_payload (arecv, asend, in_payload, out_payload, 1, notify);
+
+  if ((int) asend->elem_count != num_senders) {
+    ++failed;
+  }
+  else {
+    for (i = 0; i < num_senders; ++i) {
+      if (*(int *) sc_array_index_int (asend, i) != senders[i] ||
+          (payload && *(int *) sc_array_index_int (out_payload, i)
+           != senders[i])) {
+        ++failed;
+      }
+    }
+  }
+  if (failed) {
+    SC_LERRORF ("Auto notify mismatch in step %d\n", step);
+  }
+
+  if (payload) {
+    sc_array_destroy (in_payload);
+    sc_array_destroy (out_payload);
+  }
+  sc_array_destroy (arecv);
+  sc_array_destroy (asend);
+  SC_FREE (senders);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 step, failed = 0;
+  sc_MPI_Comm         mpicomm;
+  sc_notify_t        *notify;
+  sc_statistics_t    *stats;
+  sc_notify_type_t    none, small;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* tune two regimes until a decision is made */
+  stats = sc_statistics_new (mpicomm);
+  notify = sc_notify_new (mpicomm);
+  sc_notify_set_type (notify, SC_NOTIFY_AUTO);
+  sc_notify_set_stats (notify, stats);
+  for (step = 0; step < 32; ++step) {
+    failed += test_auto_call (notify, rank, size, step, 0);
+    failed += test_auto_call (notify, rank, size, step, 1);
+  }
+  none = sc_notify_auto_get_type (notify, SC_NOTIFY_REGIME_NONE);
+  small = sc_notify_auto_get_type (notify, SC_NOTIFY_REGIME_SMALL);
+  if (none == SC_NOTIFY_AUTO || small == SC_NOTIFY_AUTO) {
+    SC_GLOBAL_LERROR ("Auto notify did not decide\n");
+    ++failed;
+  }
+  if (size > 1 && !sc_statistics_has (stats, "sc_notify_auto:small")) {
+    SC_GLOBAL_LERROR ("Auto notify statistics missing\n");
+    ++failed;
+  }
+  sc_statistics_compute (stats);
+  sc_statistics_print (stats, sc_package_id, SC_LP_STATISTICS, 1, 0);
+  if (sc_notify_auto_save (notify, TEST_AUTO_FILE)) {
+    SC_GLOBAL_LERROR ("Auto notify save failed\n");
+    ++failed;
+  }
+  sc_notify_destroy (notify);
+  sc_statistics_destroy (stats);
+
+  /* a new controller takes the decisions from the file */
+  notify = sc_notify_new (mpicomm);
+  sc_notify_set_type (notify, SC_NOTIFY_AUTO);
+  if (sc_notify_auto_load (notify, TEST_AUTO_FILE) !=
+      (size > 1 ? 2 : SC_NOTIFY_NUM_REGIMES) ||
+      sc_notify_auto_get_type (notify, SC_NOTIFY_REGIME_NONE) != none ||
+      sc_notify_auto_get_type (notify, SC_NOTIFY_REGIME_SMALL) != small) {
+    SC_GLOBAL_LERROR ("Auto notify load mismatch\n");
+    ++failed;
+  }
+  failed += test_auto_call (notify, rank, size, 0, 1);
+  sc_notify_destroy (notify);
+  if (rank == 0) {
+    remove (TEST_AUTO_FILE);
+  }
+
+  mpiret = sc_MPI_Allreduce (&failed, &rank, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  failed = rank;
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
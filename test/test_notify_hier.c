@@ -0,0 +1,224 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_notify.h>
+
+/** Payload of a size that is not a multiple of sizeof (int). */
+#define TEST_HIER_BYTES 5
+
+/** Fill sorted receivers and their payload for a fixed pattern. */
+static void
+test_hier_receivers (sc_array_t * receivers, sc_array_t * payload,
+                     int rank, int size)
+{
+  int                 k, r;
+  int                 flags[4];
+  char               *p;
+
+  sc_array_reset (receivers);
+  sc_array_reset (payload);
+  for (k = 0; k < 4; ++k) {
+    flags[k] = (rank + k * k + k) % size;
+  }
+  for (r = 0; r < size; ++r) {
+    for (k = 0; k < 4; ++k) {
+      if (flags[k] == r) {
+        *(int *) sc_array_push (receivers) = r;
+        p = (char *) sc_array_push (payload);
+        memset (p, 0, TEST_HIER_BYTES);
+        p[0] = (char) rank;
+        p[TEST_HIER_BYTES - 1] = (char) r;
+        break;
+      }
+    }
+  }
+}
+
+/** Compare the hierarchical notify with the nary notify. */
+static int
+test_hier_payload (sc_notify_t * hier, sc_notify_t * ref, int rank,
+                   int size)
+{
+  int                 failed = 0;
+  sc_array_t         *receivers, *senders[2], *in_payload, *out_payload[2];
+  sc_notify_t        *notify[2];
+  int                 i;
+
+  notify[0] = hier;
+  notify[1] = ref;
+  receivers = sc_array_new (sizeof (int));
+  in_payload = sc_array_new (TEST_HIER_BYTES);
+  test_hier_receivers (receivers, in_payload, rank, size);
+  for (i = 0; i < 2; ++i) {
+    senders[i] = sc_array_new (sizeof (int));
+    out_payload[i] = sc_array_new (TEST_HIER_BYTES);
+    sc_notify_payload (receivers, senders[i], in_payload, out_payload[i], 1,
+                       notify[i]);
+  }
+  if (!sc_array_is_equal (senders[0], senders[1]) ||
+      !sc_array_is_equal (out_payload[0], out_payload[1])) {
+    SC_LERROR ("Hier payload mismatch\n");
+    ++failed;
+  }
+
+  /* without payload, the senders replace the receivers */
+  test_hier_receivers (receivers, in_payload, rank, size);
+  sc_notify_payload (receivers, NULL, NULL, NULL, 1, hier);
+  if (!sc_array_is_equal (receivers, senders[1])) {
+    SC_LERROR ("Hier notify mismatch\n");
+    ++failed;
+  }
+
+  for (i = 0; i < 2; ++i) {
+    sc_array_destroy (senders[i]);
+    sc_array_destroy (out_payload[i]);
+  }
+  sc_array_destroy (receivers);
+  sc_array_destroy (in_payload);
+
+  return failed;
+}
+
+#ifdef SC_ENABLE_MPI
+/** Compare variable size messages with the nary notify. */
+static int
+test_hier_payloadv (sc_notify_t * hier, sc_notify_t * ref, int rank,
+                    int size)
+{
+  int                 failed = 0;
+  int                 i, j;
+  size_t              zz;
+  sc_array_t         *receivers, *senders[2], *in_payload, *out_payload[2];
+  sc_array_t         *in_offsets, *out_offsets[2], *dummy;
+  sc_notify_t        *notify[2];
+
+  notify[0] = hier;
+  notify[1] = ref;
+  receivers = sc_array_new (sizeof (int));
+  dummy = sc_array_new (TEST_HIER_BYTES);
+  test_hier_receivers (receivers, dummy, rank, size);
+  in_payload = sc_array_new (sizeof (int));
+  in_offsets = sc_array_new_count (sizeof (int), receivers->elem_count + 1);
+  *(int *) sc_array_index (in_offsets, 0) = 0;
+  for (zz = 0; zz < receivers->elem_count; ++zz) {
+    j = *(int *) sc_array_index (receivers, zz);
+    for (i = 0; i <= (rank + j) % 3; ++i) {
+      *(int *) sc_array_push (in_payload) = 100 * rank + i;
+    }
+    *(int *) sc_array_index (in_offsets, zz + 1) =
+      (int) in_payload->elem_count;
+  }
+  for (i = 0; i < 2; ++i) {
+    senders[i] = sc_array_new (sizeof (int));
+    out_payload[i] = sc_array_new (sizeof (int));
+    out_offsets[i] = sc_array_new (sizeof (int));
+    sc_notify_payloadv (receivers, senders[i], in_payload, out_payload[i],
+                        in_offsets, out_offsets[i], 1, notify[i]);
+  }
+  if (!sc_array_is_equal (senders[0], senders[1]) ||
+      !sc_array_is_equal (out_payload[0], out_payload[1]) ||
+      !sc_array_is_equal (out_offsets[0], out_offsets[1])) {
+    SC_LERROR ("Hier payloadv mismatch\n");
+    ++failed;
+  }
+
+  for (i = 0; i < 2; ++i) {
+    sc_array_destroy (senders[i]);
+    sc_array_destroy (out_payload[i]);
+    sc_array_destroy (out_offsets[i]);
+  }
+  sc_array_destroy (receivers);
+  sc_array_destroy (dummy);
+  sc_array_destroy (in_payload);
+  sc_array_destroy (in_offsets);
+
+  return failed;
+}
+#endif
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 failed = 0;
+  sc_MPI_Comm         mpicomm;
+  sc_notify_t        *hier, *ref;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* a copy of the world with two processes per node if possible */
+  mpiret = sc_MPI_Comm_dup (sc_MPI_COMM_WORLD, &mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+#ifdef SC_ENABLE_MPI
+  sc_mpi_comm_detach_node_comms (mpicomm);
+  sc_mpi_comm_attach_node_comms (mpicomm, size % 2 == 0 ? 2 : 1);
+#endif
+
+  ref = sc_notify_new (mpicomm);
+  sc_notify_set_type (ref, SC_NOTIFY_NARY);
+#ifdef SC_ENABLE_MPI
+  /* the reference sends all payloads separately */
+  sc_notify_set_eager_threshold (ref, 0);
+#endif
+  hier = sc_notify_new (mpicomm);
+  sc_notify_set_type (hier, SC_NOTIFY_HIER);
+
+  failed += test_hier_payload (hier, ref, rank, size);
+#ifdef SC_ENABLE_MPI
+  /* the variable size notification requires point-to-point messages */
+  failed += test_hier_payloadv (hier, ref, rank, size);
+#endif
+
+  /* switching the type releases the node data */
+  sc_notify_set_type (hier, SC_NOTIFY_PEX);
+  failed += test_hier_payload (hier, ref, rank, size);
+
+  sc_notify_destroy (hier);
+  sc_notify_destroy (ref);
+#ifdef SC_ENABLE_MPI
+  sc_mpi_comm_detach_node_comms (mpicomm);
+#endif
+  mpiret = sc_MPI_Comm_free (&mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  mpiret = sc_MPI_Allreduce (&failed, &rank, 1, sc_MPI_INT, sc_MPI_MAX,
+                             sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  failed = rank;
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_notify.h>
+
+/** Fill receivers with this rank and its successor shifted by \a shift. */
+static void
+test_plan_receivers (sc_array_t * receivers, int rank, int size, int shift)
+{
+  int                 next = (rank + shift) % size;
+
+  sc_array_reset (receivers);
+  *(int *) sc_array_push (receivers) = SC_MIN (rank, next);
+  if (next != rank) {
+    *(int *) sc_array_push (receivers) = SC_MAX (rank, next);
+  }
+}
+
+/** Check that the senders are this rank and its predecessor. */
+static int
+test_plan_senders (sc_array_t * senders, int rank, int size, int shift)
+{
+  int                 prev = (rank - shift % size + size) % size;
+
+  if (prev == rank) {
+    return senders->elem_count != 1 || *(int *) sc_array_index (senders, 0)
+      != rank;
+  }
+  return senders->elem_count != 2 ||
+    *(int *) sc_array_index (senders, 0) != SC_MIN (rank, prev) ||
+    *(int *) sc_array_index (senders, 1) != SC_MAX (rank, prev);
+}
+
+static int
+test_plan_payload (sc_notify_t * notify, int rank, int size)
+{
+  int                 failed = 0;
+  int                 step, shift;
+  long                hits, misses;
+  size_t              zz;
+  sc_array_t         *receivers, *senders, *in_payload, *out_payload;
+  sc_notify_plan_t   *plan;
+
+  plan = sc_notify_plan_new (notify);
+  receivers = sc_array_new (sizeof (int));
+  senders = sc_array_new (sizeof (int));
+  in_payload = sc_array_new (sizeof (int));
+  out_payload = sc_array_new (sizeof (int));
+
+  /* the pattern changes once during the steps */
+  for (step = 0; step < 6; ++step) {
+    shift = step < 3 ? 1 : 2;
+    test_plan_receivers (receivers, rank, size, shift);
+    sc_array_resize (in_payload, receivers->elem_count);
+    for (zz = 0; zz < receivers->elem_count; ++zz) {
+      *(int *) sc_array_index (in_payload, zz) = 100 * step + rank;
+    }
+    sc_notify_plan_payload (plan, receivers, senders, in_payload,
+                            out_payload, 1);
+    failed += test_plan_senders (senders, rank, size, shift);
+    for (zz = 0; zz < senders->elem_count; ++zz) {
+      if (*(int *) sc_array_index (out_payload, zz) != 100 * step +
+          *(int *) sc_array_index (senders, zz)) {
+        SC_LERRORF ("Plan payload mismatch in step %d\n", step);
+        ++failed;
+      }
+    }
+  }
+  sc_notify_plan_get_counts (plan, &hits, &misses);
+  /* on one process both patterns coincide */
+  if (hits != 6 - misses || misses != (size > 1 ? 2 : 1)) {
+    SC_GLOBAL_LERRORF ("Plan hits %ld misses %ld\n", hits, misses);
+    ++failed;
+  }
+
+  sc_array_destroy (receivers);
+  sc_array_destroy (senders);
+  sc_array_destroy (in_payload);
+  sc_array_destroy (out_payload);
+  sc_notify_plan_destroy (plan);
+
+  return failed;
+}
+
+#ifdef SC_ENABLE_MPI
+static int
+test_plan_payloadv (sc_notify_t * notify, int rank, int size)
+{
+  int                 failed = 0;
+  int                 i, j, step, count, sender;
+  int                *offsets;
+  long                hits, misses;
+  size_t              zz;
+  sc_array_t         *receivers, *in_payload, *in_offsets;
+  sc_notify_plan_t   *plan;
+
+  plan = sc_notify_plan_new (notify);
+  receivers = sc_array_new (sizeof (int));
+  in_payload = sc_array_new (sizeof (int));
+  in_offsets = sc_array_new (sizeof (int));
+
+  /* the message sizes change with every other step */
+  for (step = 0; step < 4; ++step) {
+    test_plan_receivers (receivers, rank, size, 1);
+    count = rank % 3 + step / 2 + 1;
+    sc_array_resize (in_offsets, receivers->elem_count + 1);
+    offsets = (int *) in_offsets->array;
+    offsets[0] = 0;
+    sc_array_reset (in_payload);
+    for (zz = 0; zz < receivers->elem_count; ++zz) {
+      offsets[zz + 1] = offsets[zz] + count;
+      for (j = 0; j < count; ++j) {
+        *(int *) sc_array_push (in_payload) = 1000 * rank + j;
+      }
+    }
+
+    /* the received data replaces the input arrays */
+    sc_notify_plan_payloadv (plan, receivers, NULL, in_payload, NULL,
+                             in_offsets, NULL, 1);
+    failed += test_plan_senders (receivers, rank, size, 1);
+    offsets = (int *) in_offsets->array;
+    for (i = 0; i < (int) receivers->elem_count; ++i) {
+      sender = *(int *) sc_array_index_int (receivers, i);
+      count = sender % 3 + step / 2 + 1;
+      if (offsets[i + 1] - offsets[i] != count) {
+        SC_LERRORF ("Plan size mismatch in step %d\n", step);
+        ++failed;
+        continue;
+      }
+      for (j = 0; j < count; ++j) {
+        if (*(int *) sc_array_index_int (in_payload, offsets[i] + j)
+            != 1000 * sender + j) {
+          SC_LERRORF ("Plan payloadv mismatch in step %d\n", step);
+          ++failed;
+        }
+      }
+    }
+  }
+  sc_notify_plan_get_counts (plan, &hits, &misses);
+  if (hits != 3 || misses != 1) {
+    SC_GLOBAL_LERRORF ("Plan v hits %ld misses %ld\n", hits, misses);
+    ++failed;
+  }
+
+  sc_array_destroy (receivers);
+  sc_array_destroy (in_payload);
+  sc_array_destroy (in_offsets);
+  sc_notify_plan_destroy (plan);
+
+  return failed;
+}
+#endif
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 failed = 0;
+  sc_MPI_Comm         mpicomm;
+  sc_notify_t        *notify;
+  sc_statistics_t    *stats;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  stats = sc_statistics_new (mpicomm);
+  notify = sc_notify_new (mpicomm);
+  sc_notify_set_stats (notify, stats);
+
+  failed += test_plan_payload (notify, rank, size);
+#ifdef SC_ENABLE_MPI
+  /* the variable size notification requires point-to-point messages */
+  failed += test_plan_payloadv (notify, rank, size);
+#endif
+  if (!sc_statistics_has (stats, "sc_notify_plan_hit")) {
+    SC_GLOBAL_LERROR ("Plan statistics missing\n");
+    ++failed;
+  }
+  sc_statistics_compute (stats);
+  sc_statistics_print (stats, sc_package_id, SC_LP_STATISTICS, 1, 0);
+
+  sc_notify_destroy (notify);
+  sc_statistics_destroy (stats);
+
+  mpiret = sc_MPI_Allreduce (&failed, &rank, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  failed = rank;
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+
+#include <sc_notify.h>
+
+/** Fill sorted receivers and their payload for a fixed pattern. */
+static void
+test_request_receivers (sc_array_t * receivers, sc_array_t * payload,
+                        int rank, int size)
+{
+  int                 r;
+
+  sc_array_reset (receivers);
+  sc_array_reset (payload);
+  for (r = 0; r < size; ++r) {
+    if ((r + 2 * rank) % 3 == 0 || r == (rank + 1) % size) {
+      *(int *) sc_array_push (receivers) = r;
+      *(double *) sc_array_push (payload) = 1000. * rank + r;
+    }
+  }
+}
+
+/** Compare the non-blocking notify of a type with the nary notify. */
+static int
+test_request_type (sc_notify_t * notify, sc_notify_type_t type, int rank,
+                   int size)
+{
+  int                 failed = 0;
+  int                 i, polls;
+  sc_array_t         *receivers, *senders[2], *in_payload, *out_payload[2];
+  sc_notify_t        *notifies[2];
+  sc_notify_request_t *request;
+
+  notifies[0] = notify;
+  notifies[1] = sc_notify_new (sc_notify_get_comm (notify));
+  sc_notify_set_type (notifies[0], type);
+  sc_notify_set_type (notifies[1], SC_NOTIFY_NARY);
+  for (i = 0; i < 2; ++i) {
+    senders[i] = sc_array_new (sizeof (int));
+    out_payload[i] = sc_array_new (sizeof (double));
+  }
+  receivers = sc_array_new (sizeof (int));
+  in_payload = sc_array_new (sizeof (double));
+  test_request_receivers (receivers, in_payload, rank, size);
+
+  /* poll a few times as if doing local work in between */
+  request = sc_notify_begin (receivers, senders[0], in_payload,
+                             out_payload[0], 1, notifies[0]);
+  for (polls = 0; polls < 10 && !sc_notify_test (request); ++polls) {
+  }
+  sc_notify_end (request);
+  sc_notify_payload (receivers, senders[1], in_payload, out_payload[1], 1,
+                     notifies[1]);
+  if (!sc_array_is_equal (senders[0], senders[1]) ||
+      !sc_array_is_equal (out_payload[0], out_payload[1])) {
+    SC_LERRORF ("Request mismatch for type %s\n",
+                sc_notify_type_strings[type]);
+    ++failed;
+  }
+
+  /* without payload the senders replace the receivers */
+  request = sc_notify_begin (receivers, NULL, NULL, NULL, 1, notifies[0]);
+  sc_notify_end (request);
+  if (!sc_array_is_equal (receivers, senders[1])) {
+    SC_LERRORF ("Request notify mismatch for type %s\n",
+                sc_notify_type_strings[type]);
+    ++failed;
+  }
+
+  sc_notify_destroy (notifies[1]);
+  for (i = 0; i < 2; ++i) {
+    sc_array_destroy (senders[i]);
+    sc_array_destroy (out_payload[i]);
+  }
+  sc_array_destroy (receivers);
+  sc_array_destroy (in_payload);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 failed = 0;
+  sc_MPI_Comm         mpicomm;
+  sc_notify_t        *notify;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* consecutive requests on a communicator share their controller */
+  notify = sc_notify_new (mpicomm);
+  failed += test_request_type (notify, SC_NOTIFY_PEX, rank, size);
+#if defined(SC_ENABLE_MPI) && MPI_VERSION >= 3
+  failed += test_request_type (notify, SC_NOTIFY_NBX, rank, size);
+  failed += test_request_type (notify, SC_NOTIFY_PCX, rank, size);
+  failed += test_request_type (notify, SC_NOTIFY_NBX, rank, size);
+#endif
+  sc_notify_destroy (notify);
+
+  mpiret = sc_MPI_Allreduce (&failed, &rank, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  failed = rank;
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
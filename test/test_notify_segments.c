@@ -0,0 +1,176 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+
+#include <sc_notify.h>
+
+/** Destination memory of all messages received by one rank. */
+typedef struct test_segments
+{
+  sc_array_t         *buffers;  /* one pointer per sender */
+  int                 done;     /* number of completed messages */
+}
+test_segments_t;
+
+/** Number of ints sent from \a sender to \a receiver. */
+static int
+test_segments_length (int sender, int receiver)
+{
+  return (sender + 2 * receiver) % 5;
+}
+
+static void        *
+test_segments_buffer (int sender, size_t bytes, void *user)
+{
+  test_segments_t    *ts = (test_segments_t *) user;
+  void               *buffer = SC_ALLOC (char, SC_MAX (bytes, 1));
+
+  *(void **) sc_array_push (ts->buffers) = buffer;
+  return buffer;
+}
+
+static void
+test_segments_done (int sender, void *buffer, size_t bytes, void *user)
+{
+  ++((test_segments_t *) user)->done;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 failed = 0;
+  int                 i, j, r, s, len;
+  int                *data, *ireceivers, *seg_offsets;
+  size_t              zz;
+  sc_MPI_Comm         mpicomm;
+  sc_array_t         *receivers, *senders, *segments;
+  sc_notify_segment_t *seg;
+  sc_notify_t        *notify;
+  test_segments_t     ts;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* send to this rank and the next two */
+  receivers = sc_array_new (sizeof (int));
+  for (r = 0; r < size; ++r) {
+    if (r == rank || r == (rank + 1) % size || r == (rank + 2) % size) {
+      *(int *) sc_array_push (receivers) = r;
+    }
+  }
+  ireceivers = (int *) receivers->array;
+
+  /* each message is its first int, an empty piece and the rest */
+  data = SC_ALLOC (int, 5 * receivers->elem_count);
+  segments = sc_array_new (sizeof (sc_notify_segment_t));
+  seg_offsets = SC_ALLOC (int, receivers->elem_count + 1);
+  seg_offsets[0] = 0;
+  for (zz = 0; zz < receivers->elem_count; ++zz) {
+    len = test_segments_length (rank, ireceivers[zz]);
+    for (j = 0; j < len; ++j) {
+      data[5 * zz + j] = 1000 * rank + 10 * ireceivers[zz] + j;
+    }
+    seg = (sc_notify_segment_t *) sc_array_push_count (segments, 3);
+    seg[0].data = data + 5 * zz;
+    seg[0].bytes = len > 0 ? sizeof (int) : 0;
+    seg[1].data = NULL;
+    seg[1].bytes = 0;
+    seg[2].data = data + 5 * zz + 1;
+    seg[2].bytes = len > 1 ? (len - 1) * sizeof (int) : 0;
+    seg_offsets[zz + 1] = (int) segments->elem_count;
+  }
+
+  notify = sc_notify_new (mpicomm);
+  senders = sc_array_new (sizeof (int));
+  ts.buffers = sc_array_new (sizeof (void *));
+  ts.done = 0;
+  sc_notify_payloadv_segments (receivers, senders,
+                               (sc_notify_segment_t *) segments->array,
+                               seg_offsets, test_segments_buffer,
+                               test_segments_done, &ts, 1, notify);
+
+  /* check the senders and the received messages */
+  if (ts.done != (int) senders->elem_count ||
+      ts.buffers->elem_count != senders->elem_count) {
+    SC_LERROR ("Segments callback count mismatch\n");
+    ++failed;
+  }
+  for (zz = 0; zz < senders->elem_count; ++zz) {
+    s = *(int *) sc_array_index (senders, zz);
+    if (zz > 0 && s <= *(int *) sc_array_index (senders, zz - 1)) {
+      SC_LERROR ("Segments senders not sorted\n");
+      ++failed;
+    }
+    if (s != rank && s != (rank - 1 + size) % size &&
+        s != (rank - 2 + 2 * size) % size) {
+      SC_LERROR ("Segments unexpected sender\n");
+      ++failed;
+    }
+    len = test_segments_length (s, rank);
+    for (i = 0; i < len; ++i) {
+      if ((*(int **) sc_array_index (ts.buffers, zz))[i] !=
+          1000 * s + 10 * rank + i) {
+        SC_LERROR ("Segments payload mismatch\n");
+        ++failed;
+      }
+    }
+  }
+  if (senders->elem_count != receivers->elem_count) {
+    SC_LERROR ("Segments number of senders mismatch\n");
+    ++failed;
+  }
+
+  for (zz = 0; zz < ts.buffers->elem_count; ++zz) {
+    SC_FREE (*(void **) sc_array_index (ts.buffers, zz));
+  }
+  sc_array_destroy (ts.buffers);
+  sc_array_destroy (senders);
+  sc_array_destroy (segments);
+  sc_array_destroy (receivers);
+  SC_FREE (seg_offsets);
+  SC_FREE (data);
+  sc_notify_destroy (notify);
+
+  mpiret = sc_MPI_Allreduce (&failed, &rank, 1, sc_MPI_INT, sc_MPI_MAX,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  failed = rank;
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_options.h>
+
+static int
+test_options_write (const char *filename, int nextra)
+{
+  int                 i;
+  FILE               *file;
+
+  file = fopen (filename, "w");
+  if (file == NULL) {
+    return -1;
+  }
+  fprintf (file, "[Options]\n-i = 42\nDouble = 2.5\nstring = hello\n");
+  fprintf (file, "switch = 1\nsize = 123456789\n");
+
+  /* many unrelated entries to fill the index */
+  for (i = 0; i < nextra; ++i) {
+    fprintf (file, "unused%d = %d\n", i, i);
+  }
+  fprintf (file, "[Prefix]\nbool = false\n");
+  return fclose (file);
+}
+
+static int
+test_options_check (int use_bcast, const char *filename, int expect_fail)
+{
+  int                 failed = 0;
+  int                 retval;
+  int                 ivalue, bvalue, svalue;
+  size_t              zvalue;
+  double              dvalue;
+  const char         *string;
+  sc_options_t       *opt;
+
+  ivalue = 0;
+  bvalue = 1;
+  svalue = 0;
+  zvalue = 0;
+  dvalue = 0.;
+  string = NULL;
+
+  opt = sc_options_new ("test_options_bcast");
+  sc_options_add_int (opt, 'i', "integer", &ivalue, 0, "Integer");
+  sc_options_add_double (opt, '\0', "double", &dvalue, 0., "Double");
+  sc_options_add_string (opt, '\0', "string", &string, NULL, "String");
+  sc_options_add_switch (opt, '\0', "switch", &svalue, "Switch");
+  sc_options_add_size_t (opt, '\0', "size", &zvalue, 0, "Size");
+  sc_options_add_bool (opt, '\0', "Prefix:bool", &bvalue, 1, "Bool");
+
+  if (use_bcast) {
+    retval = sc_options_load_bcast (sc_package_id, SC_LP_INFO, opt,
+                                    filename, sc_MPI_COMM_WORLD, 0);
+  }
+  else {
+    retval = sc_options_load (sc_package_id, SC_LP_INFO, opt, filename);
+  }
+
+  if (expect_fail) {
+    if (retval != -1) {
+      SC_LERROR ("Loading a missing file succeeded\n");
+      ++failed;
+    }
+  }
+  else if (retval != 0 || ivalue != 42 || dvalue != 2.5 ||
+           string == NULL || strcmp (string, "hello") ||
+           svalue != 1 || zvalue != 123456789 || bvalue != 0) {
+    SC_LERRORF ("Loaded options mismatch with bcast %d\n", use_bcast);
+    ++failed;
+  }
+  sc_options_destroy (opt);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 mpirank;
+  int                 num_failed = 0;
+  const char         *filename = "sc_test_options_bcast.ini";
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* only the root rank writes and reads the file */
+  if (mpirank == 0) {
+    SC_CHECK_ABORT (test_options_write (filename, 1000) == 0,
+                    "Could not write ini file");
+    num_failed += test_options_check (0, filename, 0);
+  }
+  num_failed += test_options_check (1, filename, 0);
+  mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    (void) remove (filename);
+  }
+
+  /* a missing file fails on all ranks alike */
+  num_failed += test_options_check (1, filename, 1);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_partition.h>
+
+/* the weight of an element by its global index */
+#define TEST_PARTITION_WEIGHT(g) ((double) (1 + (g) % 3 + ((g) % 7 == 0) * 5))
+
+static int
+test_partition (sc_MPI_Comm mpicomm, int rank, int size, int uniform)
+{
+  int                 failed = 0;
+  int                 mpiret;
+  int                 q;
+  long                num_local, offset, num_global, g, k;
+  size_t             *send_counts, *expected;
+  double             *weights, total, prefix, check;
+
+  /* uneven local counts, some ranks empty */
+  num_local = rank % 3 == 1 ? 0 : 50 + 13 * rank;
+  offset = 0;
+  mpiret = sc_MPI_Exscan (&num_local, &offset, 1, sc_MPI_LONG, sc_MPI_SUM,
+                          mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank == 0) {
+    offset = 0;
+  }
+  mpiret = sc_MPI_Allreduce (&num_local, &num_global, 1, sc_MPI_LONG,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  weights = SC_ALLOC (double, num_local);
+  for (k = 0; k < num_local; ++k) {
+    weights[k] = uniform ? 1. : TEST_PARTITION_WEIGHT (offset + k);
+  }
+  send_counts = SC_ALLOC (size_t, size);
+  total = sc_partition_weights (mpicomm, (size_t) num_local,
+                                uniform ? NULL : weights, send_counts);
+
+  /* compute the expected destinations from the global sequence */
+  expected = SC_ALLOC_ZERO (size_t, size);
+  check = prefix = 0.;
+  for (g = 0; g < num_global; ++g) {
+    check += uniform ? 1. : TEST_PARTITION_WEIGHT (g);
+  }
+  for (g = 0; g < num_global; ++g) {
+    for (q = size - 1; q > 0 && total * q / size > prefix; --q) {
+    }
+    if (offset <= g && g < offset + num_local) {
+      ++expected[q];
+    }
+    prefix += uniform ? 1. : TEST_PARTITION_WEIGHT (g);
+  }
+  if (total != check) {
+    SC_LERRORF ("Total weight %g expected %g\n", total, check);
+    failed = 1;
+  }
+  for (q = 0; q < size; ++q) {
+    if (send_counts[q] != expected[q]) {
+      SC_LERRORF ("Send count to %d is %ld expected %ld\n", q,
+                  (long) send_counts[q], (long) expected[q]);
+      failed = 1;
+    }
+  }
+
+  SC_FREE (expected);
+  SC_FREE (send_counts);
+  SC_FREE (weights);
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 failed = 0, anyfailed;
+  int                 mpiret;
+  int                 rank, size;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  failed |= test_partition (mpicomm, rank, size, 0);
+  failed |= test_partition (mpicomm, rank, size, 1);
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_polynom.h>
+#include <sc_random.h>
+
+#define TEST_POLYNOM_NUM_X 1000
+
+static int
+test_polynom_close (double a, double b)
+{
+  return fabs (a - b) <= 1.e-12 * (1. + fabs (b));
+}
+
+static sc_polynom_t *
+test_polynom_random (int degree, sc_rand_state_t * state)
+{
+  int                 i;
+  double              c[16];
+
+  SC_ASSERT (degree < 16);
+  for (i = 0; i <= degree; ++i) {
+    c[i] = sc_rand (state) - .5;
+  }
+  return sc_polynom_new_from_coefficients (degree, c);
+}
+
+static int
+test_polynom_equal (const sc_polynom_t * p, const sc_polynom_t * q)
+{
+  int                 i;
+
+  if (sc_polynom_degree (p) != sc_polynom_degree (q)) {
+    return 0;
+  }
+  for (i = 0; i <= sc_polynom_degree (p); ++i) {
+    if (!test_polynom_close (*sc_polynom_coefficient_const (p, i),
+                             *sc_polynom_coefficient_const (q, i))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int
+test_polynom_batch_eval (int degree, sc_rand_state_t * state)
+{
+  int                 num_failed = 0;
+  int                 i;
+  size_t              zz;
+  const size_t        num_p = 333;
+  double             *x, *v, *c;
+  sc_polynom_t       *p;
+
+  x = SC_ALLOC (double, TEST_POLYNOM_NUM_X);
+  v = SC_ALLOC (double, TEST_POLYNOM_NUM_X);
+  for (zz = 0; zz < TEST_POLYNOM_NUM_X; ++zz) {
+    x[zz] = 4. * sc_rand (state) - 2.;
+  }
+
+  /* many arguments of one polynomial, also overwriting the arguments */
+  p = test_polynom_random (degree, state);
+  sc_polynom_eval_batch (p, TEST_POLYNOM_NUM_X, x, v);
+  for (zz = 0; zz < TEST_POLYNOM_NUM_X; ++zz) {
+    num_failed += !test_polynom_close (v[zz], sc_polynom_eval (p, x[zz]));
+  }
+  memcpy (v, x, TEST_POLYNOM_NUM_X * sizeof (double));
+  sc_polynom_eval_batch (p, TEST_POLYNOM_NUM_X, v, v);
+  for (zz = 0; zz < TEST_POLYNOM_NUM_X; ++zz) {
+    num_failed += !test_polynom_close (v[zz], sc_polynom_eval (p, x[zz]));
+  }
+  sc_polynom_destroy (p);
+
+  /* many polynomials in structure-of-arrays layout */
+  c = SC_ALLOC (double, (degree + 1) * num_p);
+  for (zz = 0; zz < (degree + 1) * num_p; ++zz) {
+    c[zz] = sc_rand (state) - .5;
+  }
+  sc_polynom_eval_soa (degree, num_p, c, x, v);
+  p = sc_polynom_new ();
+  for (zz = 0; zz < num_p; ++zz) {
+    sc_polynom_set_degree (p, degree);
+    for (i = 0; i <= degree; ++i) {
+      *sc_polynom_coefficient (p, i) = c[i * num_p + zz];
+    }
+    num_failed += !test_polynom_close (v[zz], sc_polynom_eval (p, x[zz]));
+  }
+  sc_polynom_destroy (p);
+
+  SC_FREE (c);
+  SC_FREE (v);
+  SC_FREE (x);
+  return num_failed;
+}
+
+static int
+test_polynom_in_place (int dq, int dr, sc_rand_state_t * state)
+{
+  int                 num_failed = 0;
+  sc_polynom_t       *q, *r, *p, *ref;
+
+  q = test_polynom_random (dq, state);
+  r = test_polynom_random (dr, state);
+  p = sc_polynom_new ();
+
+  /* sums into distinct and aliased storage */
+  ref = sc_polynom_new_from_sum (q, r);
+  sc_polynom_set_sum (p, q, r);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_set_polynom (p, q);
+  sc_polynom_set_sum (p, p, r);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_set_polynom (p, r);
+  sc_polynom_set_sum (p, q, p);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_destroy (ref);
+  ref = sc_polynom_new_from_sum (q, q);
+  sc_polynom_set_polynom (p, q);
+  sc_polynom_set_sum (p, p, p);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_destroy (ref);
+
+  /* products into distinct and aliased storage */
+  ref = sc_polynom_new_from_product (q, r);
+  sc_polynom_set_product (p, q, r);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_set_polynom (p, q);
+  sc_polynom_set_product (p, p, r);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_set_polynom (p, r);
+  sc_polynom_set_product (p, q, p);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_destroy (ref);
+  ref = sc_polynom_new_from_product (q, q);
+  sc_polynom_set_polynom (p, q);
+  sc_polynom_multiply (p, p);
+  num_failed += !test_polynom_equal (p, ref);
+  sc_polynom_destroy (ref);
+
+  sc_polynom_destroy (p);
+  sc_polynom_destroy (r);
+  sc_polynom_destroy (q);
+  return num_failed;
+}
+
+static int
+test_polynom_lagrange (int degree, sc_rand_state_t * state)
+{
+  int                 num_failed = 0;
+  int                 i, j;
+  size_t              zz;
+  double              points[16], x[TEST_POLYNOM_NUM_X], sum;
+  double             *table;
+
+  for (i = 0; i <= degree; ++i) {
+    points[i] = -1. + 2. * (i + .3 * sc_rand (state)) / (degree + 1.);
+  }
+  for (zz = 0; zz < TEST_POLYNOM_NUM_X; ++zz) {
+    x[zz] = 2. * sc_rand (state) - 1.;
+  }
+  table = SC_ALLOC (double, (degree + 1) * TEST_POLYNOM_NUM_X);
+
+  /* the basis interpolates the unit vectors */
+  sc_polynom_lagrange_table (degree, points, degree + 1, points, table);
+  for (i = 0; i <= degree; ++i) {
+    for (j = 0; j <= degree; ++j) {
+      num_failed += fabs (table[i * (degree + 1) + j] - (i == j)) > 1.e-9;
+    }
+  }
+
+  /* the basis is a partition of unity */
+  sc_polynom_lagrange_table (degree, points, TEST_POLYNOM_NUM_X, x, table);
+  for (zz = 0; zz < TEST_POLYNOM_NUM_X; ++zz) {
+    sum = 0.;
+    for (i = 0; i <= degree; ++i) {
+      sum += table[i * TEST_POLYNOM_NUM_X + zz];
+    }
+    num_failed += fabs (sum - 1.) > 1.e-9;
+  }
+
+  SC_FREE (table);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 degree, dr;
+  sc_rand_state_t     state = 5;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (degree = 0; degree <= 7; ++degree) {
+    num_failed += test_polynom_batch_eval (degree, &state);
+    num_failed += test_polynom_lagrange (degree, &state);
+    for (dr = 0; dr <= 4; ++dr) {
+      num_failed += test_polynom_in_place (degree, dr, &state);
+    }
+  }
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#define SC_PROF
+#include <sc_prof.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+static double
+test_work (int n)
+{
+  int                 i;
+  double              sum = 0.;
+
+  for (i = 0; i < n; ++i) {
+    sum += 1. / (1. + i);
+  }
+  return sum;
+}
+
+static double
+test_recursion (int level)
+{
+  double              sum;
+
+  SC_PROF_BEGIN ("recursion");
+  sum = test_work (1000);
+  if (level > 0) {
+    sum += test_recursion (level - 1);
+  }
+  SC_PROF_END ();
+  return sum;
+}
+
+/** Check the calls and the relation of inclusive and exclusive times. */
+static int
+test_path (const char *path, long expected, double *inclusive)
+{
+  long                calls;
+  double              exclusive;
+
+  if (!sc_prof_lookup (path, &calls, inclusive, &exclusive) ||
+      calls != expected || exclusive < -1e-9 ||
+      exclusive > *inclusive + 1e-9) {
+    SC_GLOBAL_LERRORF ("Region %s: %ld calls, expected %ld\n",
+                       path, calls, expected);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 i, j, num_threads = 1;
+  int                 num_failed_tests = 0;
+  double              sum = 0., outer, inner, other;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+#ifdef SC_ENABLE_OPENMP
+  num_threads = omp_get_max_threads ();
+#endif
+
+  /* every thread records its own call tree */
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel private (i, j) reduction (+:sum)
+#endif
+  {
+    for (i = 0; i < 3; ++i) {
+      SC_PROF_BEGIN ("outer");
+      for (j = 0; j < 2; ++j) {
+        SC_PROF_BEGIN ("inner");
+        sum += test_work (10000);
+        SC_PROF_END ();
+      }
+      SC_PROF_BEGIN ("other");
+      sum += test_work (5000);
+      SC_PROF_END ();
+      SC_PROF_END ();
+    }
+    sum += test_recursion (2);
+  }
+  SC_GLOBAL_INFOF ("Sum of work %g\n", sum);
+
+  num_failed_tests += test_path ("outer", 3 * num_threads, &outer);
+  num_failed_tests += test_path ("outer/inner", 6 * num_threads, &inner);
+  num_failed_tests += test_path ("outer/other", 3 * num_threads, &other);
+  num_failed_tests += test_path ("recursion/recursion/recursion",
+                                 num_threads, &other);
+  if (inner > outer + 1e-9) {
+    SC_GLOBAL_LERROR ("Nested region exceeds its parent\n");
+    ++num_failed_tests;
+  }
+  if (sc_prof_lookup ("inner", NULL, NULL, NULL)) {
+    SC_GLOBAL_LERROR ("Nested region recorded at top level\n");
+    ++num_failed_tests;
+  }
+
+  sc_prof_print (mpicomm, sc_package_id, SC_LP_INFO);
+  sc_prof_reset ();
+  if (sc_prof_lookup ("outer", NULL, NULL, NULL)) {
+    SC_GLOBAL_LERROR ("Region left after reset\n");
+    ++num_failed_tests;
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
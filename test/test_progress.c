@@ -0,0 +1,134 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_progress.h>
+#include <sc_reduce.h>
+
+static void
+test_progress_isum (void *sendbuf, void *recvbuf, int sendcount,
+                    sc_MPI_Datatype sendtype)
+{
+  int                 i;
+  const int          *s = (int *) sendbuf;
+  int                *r = (int *) recvbuf;
+
+  SC_ASSERT (sendtype == sc_MPI_INT);
+  for (i = 0; i < sendcount; ++i) {
+    r[i] += s[i];
+  }
+}
+
+static void
+test_progress_done (void *data, void *user)
+{
+  ++*(int *) user;
+}
+
+/* run a few reductions at once, each on its own communicator */
+static int
+test_progress_reduce (sc_MPI_Comm mpicomm, int rank, int size)
+{
+  int                 failed = 0;
+  int                 mpiret;
+  int                 i, j, done = 0;
+  int                 send[3][5], recv[3][5];
+  sc_MPI_Comm         comms[3];
+  sc_reduce_request_t *requests[3];
+  sc_progress_item_t *items[3];
+
+  for (i = 0; i < 3; ++i) {
+    mpiret = sc_MPI_Comm_dup (mpicomm, comms + i);
+    SC_CHECK_MPI (mpiret);
+    for (j = 0; j < 5; ++j) {
+      send[i][j] = rank * (i + 1) + j;
+    }
+    requests[i] = sc_iallreduce_custom (send[i], recv[i], 5, sc_MPI_INT,
+                                        test_progress_isum, 2, comms[i]);
+    items[i] = sc_progress_add (sc_progress_poll_reduce, requests[i],
+                                test_progress_done, &done);
+  }
+
+  /* the items advance while we would compute something else */
+  sc_progress_poll ();
+  for (i = 0; i < 3; ++i) {
+    sc_progress_wait (items[i]);
+    sc_reduce_end (requests[i]);
+    for (j = 0; j < 5; ++j) {
+      if (recv[i][j] != (i + 1) * (size - 1) * size / 2 + size * j) {
+        SC_LERRORF ("Reduction %d mismatch at %d\n", i, j);
+        failed = 1;
+      }
+    }
+    mpiret = sc_MPI_Comm_free (comms + i);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (done != 3) {
+    SC_LERROR ("Completion callbacks missing\n");
+    failed = 1;
+  }
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 failed = 0, anyfailed;
+  int                 mpiret, provided;
+  int                 rank, size;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init_thread (&argc, &argv, sc_MPI_THREAD_MULTIPLE,
+                               &provided);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* polled by the calling thread */
+  sc_progress_stop ();
+  failed |= test_progress_reduce (mpicomm, rank, size);
+
+  /* polled by the progress thread if it is available */
+  if (!sc_progress_start (-1)) {
+    SC_GLOBAL_INFO ("Testing with the progress thread\n");
+    SC_CHECK_ABORT (sc_progress_is_threaded (), "Progress thread");
+    failed |= test_progress_reduce (mpicomm, rank, size);
+    sc_progress_stop ();
+  }
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
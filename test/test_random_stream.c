@@ -0,0 +1,187 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_random.h>
+
+#define TEST_RANDOM_N 100000
+
+/* known answers of Philox4x32-10 for the counter (0, 0, 0, 0) */
+static int
+test_random_known (void)
+{
+  int                 num_failed = 0;
+  sc_rand_stream_t    s;
+  double              u[2];
+
+  sc_rand_stream_init (&s, 0, 0);
+  sc_rand_stream_uniform_batch (&s, u, 2);
+  num_failed += u[0] != (double) ((0x6627e8d5e169c58dULL >> 11)) /
+    9007199254740992.;
+  num_failed += u[1] != (double) ((0xbc57ac4c9b00dbd8ULL >> 11)) /
+    9007199254740992.;
+  return num_failed;
+}
+
+static int
+test_random_partition (void)
+{
+  int                 num_failed = 0;
+  size_t              i, piece;
+  double             *all, *part, *norm;
+  int                *pois, *pois2;
+  sc_rand_stream_t    s, t;
+
+  all = SC_ALLOC (double, 1000);
+  part = SC_ALLOC (double, 1000);
+  norm = SC_ALLOC (double, 1000);
+  pois = SC_ALLOC (int, 1000);
+  pois2 = SC_ALLOC (int, 1000);
+
+  /* one call equals single draws and pieces of any size */
+  sc_rand_stream_init (&s, 12345, 7);
+  sc_rand_stream_uniform_batch (&s, all, 1000);
+  num_failed += s.position != 1000;
+  sc_rand_stream_init (&s, 12345, 7);
+  for (i = 0; i < 1000; ++i) {
+    num_failed += sc_rand_stream_uniform (&s) != all[i];
+  }
+  for (piece = 1; piece <= 7; piece += 2) {
+    sc_rand_stream_init (&s, 12345, 7);
+    for (i = 0; i < 1000; i += piece) {
+      sc_rand_stream_uniform_batch (&s, part + i, SC_MIN (piece, 1000 - i));
+    }
+    num_failed += memcmp (all, part, 1000 * sizeof (double)) != 0;
+  }
+
+  /* skipping ahead reproduces the tail, also for odd offsets */
+  sc_rand_stream_init (&t, 12345, 7);
+  sc_rand_stream_skip (&t, 333);
+  sc_rand_stream_uniform_batch (&t, part, 667);
+  num_failed += memcmp (all + 333, part, 667 * sizeof (double)) != 0;
+
+  /* other streams and seeds differ */
+  sc_rand_stream_init (&t, 12345, 8);
+  sc_rand_stream_uniform_batch (&t, part, 1000);
+  num_failed += memcmp (all, part, 1000 * sizeof (double)) == 0;
+  sc_rand_stream_init (&t, 12346, 7);
+  sc_rand_stream_uniform_batch (&t, part, 1000);
+  num_failed += memcmp (all, part, 1000 * sizeof (double)) == 0;
+
+  /* normal and Poisson samples are reproducible in pieces */
+  sc_rand_stream_init (&s, 99, 1);
+  sc_rand_stream_normal_batch (&s, norm, 1000);
+  sc_rand_stream_init (&s, 99, 1);
+  sc_rand_stream_normal_batch (&s, part, 501);
+  sc_rand_stream_normal_batch (&s, part + 501, 499);
+  num_failed += memcmp (norm, part, 1000 * sizeof (double)) != 0;
+  sc_rand_stream_init (&s, 99, 2);
+  sc_rand_stream_poisson_batch (&s, 30., pois, 1000);
+  sc_rand_stream_init (&s, 99, 2);
+  sc_rand_stream_skip (&s, 5);
+  sc_rand_stream_poisson_batch (&s, 30., pois2, 995);
+  num_failed += memcmp (pois + 5, pois2, 995 * sizeof (int)) != 0;
+
+  SC_FREE (all);
+  SC_FREE (part);
+  SC_FREE (norm);
+  SC_FREE (pois);
+  SC_FREE (pois2);
+  return num_failed;
+}
+
+static int
+test_random_moments (void)
+{
+  int                 num_failed = 0;
+  int                 k, *pois;
+  size_t              i;
+  double             *v, sum, sumsq, mean, var;
+  const double        pmean[2] = { 3., 40. };
+  sc_rand_stream_t    s;
+
+  v = SC_ALLOC (double, TEST_RANDOM_N);
+  pois = SC_ALLOC (int, TEST_RANDOM_N);
+  sc_rand_stream_init (&s, 2024, 0);
+
+  sc_rand_stream_uniform_batch (&s, v, TEST_RANDOM_N);
+  sum = sumsq = 0.;
+  for (i = 0; i < TEST_RANDOM_N; ++i) {
+    num_failed += !(0. <= v[i] && v[i] < 1.);
+    sum += v[i];
+    sumsq += v[i] * v[i];
+  }
+  mean = sum / TEST_RANDOM_N;
+  var = sumsq / TEST_RANDOM_N - mean * mean;
+  num_failed += fabs (mean - .5) > .01 || fabs (var - 1. / 12.) > .01;
+
+  sc_rand_stream_normal_batch (&s, v, TEST_RANDOM_N);
+  sum = sumsq = 0.;
+  for (i = 0; i < TEST_RANDOM_N; ++i) {
+    sum += v[i];
+    sumsq += v[i] * v[i];
+  }
+  mean = sum / TEST_RANDOM_N;
+  var = sumsq / TEST_RANDOM_N - mean * mean;
+  num_failed += fabs (mean) > .02 || fabs (var - 1.) > .02;
+
+  for (k = 0; k < 2; ++k) {
+    sc_rand_stream_poisson_batch (&s, pmean[k], pois, TEST_RANDOM_N);
+    sum = sumsq = 0.;
+    for (i = 0; i < TEST_RANDOM_N; ++i) {
+      sum += pois[i];
+      sumsq += (double) pois[i] * pois[i];
+    }
+    mean = sum / TEST_RANDOM_N;
+    var = sumsq / TEST_RANDOM_N - mean * mean;
+    num_failed += fabs (mean / pmean[k] - 1.) > .02 ||
+      fabs (var / pmean[k] - 1.) > .05;
+  }
+
+  SC_FREE (v);
+  SC_FREE (pois);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_random_known ();
+  num_failed += test_random_partition ();
+  num_failed += test_random_moments ();
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
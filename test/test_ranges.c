@@ -0,0 +1,187 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_ranges.h>
+
+/* the message size from one rank to another */
+#define TEST_RANGES_BYTES(from,to) \
+  ((((from) * 7 + (to) * 3) % 5 == 0) ? (size_t) (100 + (to)) : 0)
+
+static int
+test_ranges_local (void)
+{
+  /* peers 1 2 | gap of 1 | 4 | gap of 3 | 8 | gap of 6 | 15 */
+  const int           peers[5] = { 1, 2, 4, 8, 15 };
+  const int           num_procs = 20;
+  int                 i, nwin, ranges[2 * 4];
+  size_t              bytes[20];
+
+  memset (bytes, 0, sizeof (bytes));
+  for (i = 0; i < 5; ++i) {
+    bytes[peers[i]] = 10;
+  }
+
+  /* a range costs as much as two empty messages: close the short gap */
+  nwin = sc_ranges_compute_weighted (-1, num_procs, bytes, 0, 1., 2.,
+                                     4, ranges);
+  if (nwin != 3 || ranges[0] != 1 || ranges[1] != 4 ||
+      ranges[2] != 8 || ranges[3] != 8 ||
+      ranges[4] != 15 || ranges[5] != 15 || ranges[6] != -1) {
+    SC_LERROR ("Wrong ranges for cheap windows\n");
+    return 1;
+  }
+
+  /* the gap 3..5 contains the rank itself and costs two messages */
+  bytes[4] = 0;
+  bytes[6] = 10;
+  nwin = sc_ranges_compute_weighted (-1, num_procs, bytes, 5, 1., 2.,
+                                     4, ranges);
+  if (nwin != 2 || ranges[0] != 1 || ranges[1] != 8 ||
+      ranges[2] != 15 || ranges[3] != 15) {
+    SC_LERROR ("Wrong ranges around own rank\n");
+    return 1;
+  }
+
+  /* expensive ranges merge everything into one */
+  nwin = sc_ranges_compute_weighted (-1, num_procs, bytes, 5, 1., 100.,
+                                     4, ranges);
+  if (nwin != 1 || ranges[0] != 1 || ranges[1] != 15 || ranges[2] != -1) {
+    SC_LERROR ("Wrong single range\n");
+    return 1;
+  }
+
+  /* no peers give no ranges */
+  memset (bytes, 0, sizeof (bytes));
+  nwin = sc_ranges_compute_weighted (-1, num_procs, bytes, 5, 1., 0.,
+                                     4, ranges);
+  if (nwin != 0 || ranges[0] != -1) {
+    SC_LERROR ("Wrong empty ranges\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int
+test_ranges_global (sc_MPI_Comm mpicomm, int rank, int size)
+{
+  int                 failed = 0;
+  int                 i, j, nwin, maxwin, num_ranges = 3;
+  int                 nr, ns, counts[2], sums[2];
+  int                *ranges, *global_ranges;
+  int                *receivers, *senders;
+  size_t             *bytes;
+  int                 mpiret;
+
+  bytes = SC_ALLOC (size_t, size);
+  for (j = 0; j < size; ++j) {
+    bytes[j] = TEST_RANGES_BYTES (rank, j);
+  }
+  ranges = SC_ALLOC (int, 2 * num_ranges);
+  nwin = sc_ranges_weighted (-1, mpicomm, bytes, 1e-6, 1e-9, num_ranges,
+                             ranges, &maxwin, &global_ranges);
+  SC_ASSERT (nwin <= maxwin && maxwin <= num_ranges);
+  sc_ranges_statistics_weighted (-1, SC_LP_STATISTICS, mpicomm, size,
+                                 bytes, rank, 1e-6, 1e-9, num_ranges,
+                                 ranges);
+
+  receivers = SC_ALLOC (int, size);
+  senders = SC_ALLOC (int, size);
+  sc_ranges_decode (size, rank, maxwin, global_ranges,
+                    &nr, receivers, &ns, senders);
+
+  /* every real receiver and sender must be covered */
+  for (j = 0, i = 0; j < size; ++j) {
+    if (j != rank && bytes[j] > 0) {
+      while (i < nr && receivers[i] < j) {
+        ++i;
+      }
+      if (i == nr || receivers[i] != j) {
+        SC_LERRORF ("Receiver %d missing\n", j);
+        failed = 1;
+      }
+    }
+  }
+  for (j = 0, i = 0; j < size; ++j) {
+    if (j != rank && TEST_RANGES_BYTES (j, rank) > 0) {
+      while (i < ns && senders[i] < j) {
+        ++i;
+      }
+      if (i == ns || senders[i] != j) {
+        SC_LERRORF ("Sender %d missing\n", j);
+        failed = 1;
+      }
+    }
+  }
+
+  /* the decoded messages match up */
+  counts[0] = nr;
+  counts[1] = ns;
+  mpiret = sc_MPI_Allreduce (counts, sums, 2, sc_MPI_INT, sc_MPI_SUM,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (sums[0] != sums[1]) {
+    SC_LERROR ("Receivers and senders do not match\n");
+    failed = 1;
+  }
+
+  SC_FREE (receivers);
+  SC_FREE (senders);
+  SC_FREE (global_ranges);
+  SC_FREE (ranges);
+  SC_FREE (bytes);
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 failed = 0, anyfailed;
+  int                 mpiret;
+  int                 rank, size;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  failed |= test_ranges_local ();
+  failed |= test_ranges_global (mpicomm, rank, size);
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -23,6 +23,20 @@
 
 #include <sc_reduce.h>
 
+static void
+test_reduce_dsum (void *sendbuf, void *recvbuf, int sendcount,
+                  sc_MPI_Datatype sendtype)
+{
+  int                 i;
+  const double       *s = (double *) sendbuf;
+  double             *r = (double *) recvbuf;
+
+  SC_ASSERT (sendtype == sc_MPI_DOUBLE);
+  for (i = 0; i < sendcount; ++i) {
+    r[i] += s[i];
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -35,6 +49,9 @@ main (int argc, char **argv)
   long                lvalue, lresult;
   float               fvalue[3], fresult[3], fexpect[3];
   double              dvalue, dresult;
+  double              dvalues[2], dresults[2], dexpect;
+  double              dvector[7], dblocking[7], dnonblocking[7];
+  sc_reduce_request_t *request;
   sc_MPI_Comm         mpicomm;
 
   mpiret = sc_MPI_Init (&argc, &argv);
@@ -101,6 +118,42 @@ main (int argc, char **argv)
     }
   }
 
+  /* test compensated sum that cancels a large value exactly */
+  dvalues[0] = mpirank == 0 ? 1e16 : mpirank == mpisize - 1 ? -1e16 : 1.;
+  dvalues[1] = (double) mpirank;
+  dexpect = (double) (mpisize - 2);
+  sc_allreduce_sum_reproducible (dvalues, dresults, 2, mpicomm);
+  SC_CHECK_ABORT (mpisize == 1 || dresults[0] == dexpect,       /* ok */
+                  "Compensated allreduce mismatch");
+  SC_CHECK_ABORT (dresults[1] == ((double) (mpisize - 1)) * mpisize / 2.,       /* ok */
+                  "Compensated allreduce mismatch");
+  for (i = 0; i < mpisize; ++i) {
+    sc_reduce_sum_reproducible (dvalues, dresults, 1, i, mpicomm);
+    if (i == mpirank) {
+      SC_CHECK_ABORT (mpisize == 1 || dresults[0] == dexpect,   /* ok */
+                      "Compensated reduce mismatch");
+    }
+  }
+
+  /* test non-blocking custom allreduce against the blocking one */
+  for (j = 0; j < 7; ++j) {
+    dvector[j] = 1. / (mpirank + j + 3.);
+  }
+  sc_allreduce_custom (dvector, dblocking, 7, sc_MPI_DOUBLE,
+                       test_reduce_dsum, mpicomm);
+  for (i = 0; i <= 7; i += 3) {
+    request = sc_iallreduce_custom (dvector, dnonblocking, 7, sc_MPI_DOUBLE,
+                                    test_reduce_dsum, i, mpicomm);
+    while (!sc_reduce_test (request)) {
+      /* here would be overlapping local work */
+    }
+    sc_reduce_end (request);
+    for (j = 0; j < 7; ++j) {
+      SC_CHECK_ABORT (dnonblocking[j] == dblocking[j],  /* ok */
+                      "Non-blocking allreduce mismatch");
+    }
+  }
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
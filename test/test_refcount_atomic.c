@@ -0,0 +1,113 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_refcount.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+#define TEST_REFCOUNT_THREADS 8
+#define TEST_REFCOUNT_ITER 20000
+
+/** An object shared by threads that frees itself with the last reference. */
+typedef struct test_shared
+{
+  sc_refcount_atomic_t rc;
+  int                 written[TEST_REFCOUNT_THREADS];
+}
+test_shared_t;
+
+/** Drop a reference and verify the writes when it was the last one. */
+static int
+test_shared_unref (test_shared_t * shared, int *num_released)
+{
+  int                 t, num_failed = 0;
+
+  if (sc_refcount_atomic_unref (&shared->rc)) {
+    for (t = 0; t < TEST_REFCOUNT_THREADS; ++t) {
+      num_failed += shared->written[t] != t + 1;
+    }
+    SC_FREE (shared);
+    ++*num_released;
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 t, num_released = 0;
+  test_shared_t      *shared;
+  sc_refcount_atomic_t *rc;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* the counter behaves like the plain one in a single thread */
+  rc = sc_refcount_atomic_new (-1);
+  num_failed += !sc_refcount_atomic_is_active (rc);
+  num_failed += !sc_refcount_atomic_is_last (rc);
+  sc_refcount_atomic_ref (rc);
+  num_failed += sc_refcount_atomic_is_last (rc);
+  num_failed += sc_refcount_atomic_unref (rc);
+  num_failed += !sc_refcount_atomic_unref (rc);
+  num_failed += sc_refcount_atomic_is_active (rc);
+  sc_refcount_atomic_destroy (rc);
+
+  /* every thread holds one reference and takes and drops many more */
+  shared = SC_ALLOC_ZERO (test_shared_t, 1);
+  sc_refcount_atomic_init (&shared->rc, -1);
+  for (t = 1; t < TEST_REFCOUNT_THREADS; ++t) {
+    sc_refcount_atomic_ref (&shared->rc);
+  }
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel for num_threads (TEST_REFCOUNT_THREADS) \
+  reduction (+:num_failed, num_released)
+#endif
+  for (t = 0; t < TEST_REFCOUNT_THREADS; ++t) {
+    int                 i;
+
+    for (i = 0; i < TEST_REFCOUNT_ITER; ++i) {
+      sc_refcount_atomic_ref (&shared->rc);
+    }
+    for (i = 0; i < TEST_REFCOUNT_ITER; ++i) {
+      num_failed += test_shared_unref (shared, &num_released);
+    }
+    shared->written[t] = t + 1;
+    num_failed += test_shared_unref (shared, &num_released);
+  }
+  num_failed += num_released != 1;
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
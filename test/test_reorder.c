@@ -0,0 +1,116 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_neighbor.h>
+
+int
+main (int argc, char **argv)
+{
+  int                 failed = 0, anyfailed;
+  int                 mpiret;
+  int                 rank, size, newrank, ppn, half;
+  int                 i, partner;
+  int                *allranks;
+  double              weights[2];
+  sc_array_t         *receivers, view;
+  sc_MPI_Comm         mpicomm, newcomm;
+  sc_MPI_Comm         intranode, internode;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* emulate two processes per node where possible */
+  mpiret = sc_MPI_Comm_dup (mpicomm, &mpicomm);
+  SC_CHECK_MPI (mpiret);
+  ppn = size % 2 == 0 ? 2 : 1;
+  sc_mpi_comm_attach_node_comms (mpicomm, ppn);
+
+  /* talk heavily to the rank half way around and lightly to the next */
+  half = size / 2;
+  receivers = sc_array_new (sizeof (int));
+  *(int *) sc_array_push (receivers) = (rank + half) % size;
+  weights[0] = 100.;
+  *(int *) sc_array_push (receivers) = (rank + 1) % size;
+  weights[1] = 1.;
+  sc_neighbor_reorder (mpicomm, receivers, weights, &newcomm);
+  sc_array_destroy (receivers);
+
+  mpiret = sc_MPI_Comm_rank (newcomm, &newrank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the new ranks must be a permutation */
+  allranks = SC_ALLOC (int, size);
+  mpiret = sc_MPI_Allgather (&newrank, 1, sc_MPI_INT,
+                             allranks, 1, sc_MPI_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  sc_array_init_data (&view, allranks, sizeof (int), (size_t) size);
+  sc_array_sort (&view, sc_int_compare);
+  for (i = 0; i < size; ++i) {
+    if (allranks[i] != i) {
+      SC_LERROR ("New ranks are not a permutation\n");
+      failed = 1;
+      break;
+    }
+  }
+
+  /* both roles of a heavy pair must end up on the same node */
+  sc_mpi_comm_get_node_comms (mpicomm, &intranode, &internode);
+  if (ppn == 2) {
+    SC_CHECK_ABORT (intranode != sc_MPI_COMM_NULL, "Node comms missing");
+    mpiret = sc_MPI_Allgather (&newrank, 1, sc_MPI_INT,
+                               allranks, 1, sc_MPI_INT, intranode);
+    SC_CHECK_MPI (mpiret);
+    partner = allranks[0] == newrank ? allranks[1] : allranks[0];
+    if (partner != (newrank + half) % size) {
+      SC_LERRORF ("Role %d shares a node with role %d\n", newrank, partner);
+      failed = 1;
+    }
+  }
+  SC_FREE (allranks);
+
+  mpiret = sc_MPI_Comm_free (&newcomm);
+  SC_CHECK_MPI (mpiret);
+  sc_mpi_comm_detach_node_comms (mpicomm);
+  mpiret = sc_MPI_Comm_free (&mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  mpiret = sc_MPI_Allreduce (&failed, &anyfailed, 1, sc_MPI_INT,
+                             sc_MPI_MAX, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return anyfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_ringbuf.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+#define TEST_RB_ITEMS 100000
+#define TEST_RB_THREADS 4
+
+/* fill and drain a queue from one thread, checking order and limits */
+static int
+test_ringbuf_serial (sc_ringbuf_mode_t mode)
+{
+  int                 num_failed = 0;
+  int                 i, round, v[10], w[10];
+  size_t              n;
+  sc_ringbuf_t       *rb;
+
+  rb = sc_ringbuf_new (sizeof (int), 5, mode);
+  num_failed += sc_ringbuf_capacity (rb) != 8;
+  num_failed += sc_ringbuf_pop (rb, &i);
+  for (round = 0; round < 5; ++round) {
+    for (i = 0; i < 10; ++i) {
+      v[i] = 10 * round + i;
+    }
+    num_failed += sc_ringbuf_push (rb, &v[0]) != 1;
+    n = sc_ringbuf_push_n (rb, 10, v + 1);
+    num_failed += n != 7;
+    num_failed += sc_ringbuf_size (rb) != 8;
+    num_failed += sc_ringbuf_push (rb, &v[9]) != 0;
+    num_failed += sc_ringbuf_pop (rb, &w[0]) != 1;
+    n = sc_ringbuf_pop_n (rb, 3, w + 1);
+    num_failed += n != 3;
+    n = sc_ringbuf_pop_n (rb, 10, w + 4);
+    num_failed += n != 4;
+    for (i = 0; i < 8; ++i) {
+      num_failed += w[i] != v[i];
+    }
+    num_failed += sc_ringbuf_size (rb) != 0;
+
+    /* leave some elements to move the start of the next round */
+    n = sc_ringbuf_push_n (rb, 3, v);
+    num_failed += n != 3;
+    n = sc_ringbuf_pop_n (rb, 3, NULL);
+    num_failed += n != 3;
+  }
+  sc_ringbuf_destroy (rb);
+
+  if (num_failed) {
+    SC_LERRORF ("Serial ring buffer mode %d failed %d checks\n",
+                (int) mode, num_failed);
+  }
+  return num_failed;
+}
+
+/* every thread pushes its own items and pops whatever is available,
+ * which also works if fewer threads are started than requested */
+static int
+test_ringbuf_threads (sc_ringbuf_mode_t mode)
+{
+  int                 num_failed = 0;
+  size_t              i;
+  volatile size_t     consumed = 0;
+  char               *seen;
+  sc_ringbuf_t       *rb;
+
+  rb = sc_ringbuf_new (sizeof (size_t), 64, mode);
+  seen = SC_ALLOC_ZERO (char, TEST_RB_ITEMS);
+
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel reduction (+:num_failed) \
+  num_threads (mode == SC_RINGBUF_SPSC ? 2 : TEST_RB_THREADS)
+#endif
+  {
+    int                 t = 0, nt = 1;
+    size_t              next, batch[16], n, k, last = 0;
+    int                 produce, consume;
+
+#ifdef SC_ENABLE_OPENMP
+    t = omp_get_thread_num ();
+    nt = omp_get_num_threads ();
+#endif
+    /* with one thread per end the SPSC roles are split */
+    produce = mode == SC_RINGBUF_MPMC || nt == 1 || t == 0;
+    consume = mode == SC_RINGBUF_MPMC || nt == 1 || t == 1;
+    next = produce ? (size_t) t : TEST_RB_ITEMS;
+    while ((produce && next < TEST_RB_ITEMS) ||
+           (consume && consumed < TEST_RB_ITEMS)) {
+      if (produce && next < TEST_RB_ITEMS) {
+        for (k = 0; k < 16 && next < TEST_RB_ITEMS;
+             ++k, next += (mode == SC_RINGBUF_MPMC ? nt : 1)) {
+          batch[k] = next;
+        }
+        n = sc_ringbuf_push_n (rb, k, batch);
+        next -= (k - n) * (mode == SC_RINGBUF_MPMC ? nt : 1);
+      }
+      if (consume) {
+        n = sc_ringbuf_pop_n (rb, 16, batch);
+        for (k = 0; k < n; ++k) {
+          if (batch[k] >= TEST_RB_ITEMS || seen[batch[k]]++) {
+            ++num_failed;
+          }
+          /* a single producer's items arrive in order */
+          if (mode == SC_RINGBUF_SPSC && batch[k] != last++) {
+            ++num_failed;
+          }
+        }
+#ifdef SC_ENABLE_OPENMP
+#pragma omp atomic
+#endif
+        consumed += n;
+      }
+    }
+  }
+  for (i = 0; i < TEST_RB_ITEMS; ++i) {
+    num_failed += seen[i] != 1;
+  }
+  num_failed += sc_ringbuf_size (rb) != 0;
+  SC_FREE (seen);
+  sc_ringbuf_destroy (rb);
+
+  if (num_failed) {
+    SC_LERRORF ("Threaded ring buffer mode %d failed %d checks\n",
+                (int) mode, num_failed);
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_ringbuf_serial (SC_RINGBUF_SPSC);
+  num_failed += test_ringbuf_serial (SC_RINGBUF_MPMC);
+  num_failed += test_ringbuf_threads (SC_RINGBUF_SPSC);
+  num_failed += test_ringbuf_threads (SC_RINGBUF_MPMC);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
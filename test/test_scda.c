@@ -0,0 +1,253 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_scda.h>
+
+static size_t
+test_scda_count (int rank)
+{
+  return (size_t) ((rank % 3) * 50 + rank);
+}
+
+/** Write the sections "ids", "zids" and "empty" with global numbers. */
+static int
+test_scda_write (sc_MPI_Comm mpicomm, const char *filename,
+                 const sc_io_mpifile_hints_t * hints, sc_io_encode_t encode)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, size, q;
+  size_t              zz, first;
+  sc_array_t         *local, *empty;
+  sc_scda_t          *scda;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  first = 0;
+  for (q = 0; q < rank; ++q) {
+    first += test_scda_count (q);
+  }
+  local = sc_array_new_count (sizeof (int64_t), test_scda_count (rank));
+  for (zz = 0; zz < local->elem_count; ++zz) {
+    *(int64_t *) sc_array_index (local, zz) = (int64_t) (first + zz);
+  }
+  empty = sc_array_new (sizeof (double));
+
+  scda = sc_scda_open_write (mpicomm, filename, "scda test file", hints);
+  SC_CHECK_ABORT (scda != NULL, "Open scda for writing");
+  num_failed += sc_scda_write (scda, "ids", local, SC_IO_ENCODE_NONE) != 0;
+  num_failed += sc_scda_write (scda, "zids", local, encode) != 0;
+  num_failed += sc_scda_write (scda, "empty", empty, encode) != 0;
+
+  /* a name that is too long is rejected on all ranks */
+  num_failed += sc_scda_write (scda, "a name that is much too long for "
+                               "the section header", local,
+                               SC_IO_ENCODE_NONE) == 0;
+  num_failed += sc_scda_close (scda) != 0;
+
+  sc_array_destroy (empty);
+  sc_array_destroy (local);
+  return num_failed;
+}
+
+/** Read the sections with a uniform partition of the elements. */
+static int
+test_scda_read (sc_MPI_Comm mpicomm, const char *filename, int write_size)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, size, s, q;
+  char                user_string[SC_SCDA_USER_BYTES];
+  size_t              zz, total, first, count;
+  sc_array_t         *data;
+  sc_scda_info_t      info;
+  sc_scda_t          *scda;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  total = 0;
+  for (q = 0; q < write_size; ++q) {
+    total += test_scda_count (q);
+  }
+
+  scda = sc_scda_open_read (mpicomm, filename, user_string);
+  SC_CHECK_ABORT (scda != NULL, "Open scda for reading");
+  num_failed += strcmp (user_string, "scda test file") != 0;
+  num_failed += sc_scda_num_sections (scda) != 3;
+  num_failed += sc_scda_find (scda, "missing") != -1;
+  num_failed += sc_scda_find (scda, "empty") != 2;
+
+  data = sc_array_new (sizeof (int64_t));
+  for (s = 0; s < 2; ++s) {
+    num_failed += sc_scda_find (scda, s == 0 ? "ids" : "zids") != s;
+    sc_scda_info (scda, s, &info);
+    num_failed += info.elem_size != sizeof (int64_t);
+    num_failed += info.num_chunks != (size_t) write_size;
+    num_failed += info.elem_count != total;
+
+    /* a range that differs from the written chunks */
+    first = total * rank / size;
+    count = total * (rank + 1) / size - first;
+    num_failed += sc_scda_read_range (scda, s, first, count, data) != 0;
+    num_failed += data->elem_count != count;
+    for (zz = 0; zz < data->elem_count; ++zz) {
+      num_failed += *(int64_t *) sc_array_index (data, zz) !=
+        (int64_t) (first + zz);
+    }
+
+    /* the chunk of a writing rank */
+    q = rank % write_size;
+    num_failed += sc_scda_read_chunk (scda, s, (size_t) q, data) != 0;
+    num_failed += data->elem_count != test_scda_count (q);
+    num_failed += sc_scda_chunk_count (scda, s, (size_t) q) !=
+      test_scda_count (q);
+    first = 0;
+    while (q > 0) {
+      first += test_scda_count (--q);
+    }
+    for (zz = 0; zz < data->elem_count; ++zz) {
+      num_failed += *(int64_t *) sc_array_index (data, zz) !=
+        (int64_t) (first + zz);
+    }
+
+    /* invalid requests */
+    num_failed += sc_scda_read_range (scda, s, total, 1, data) == 0;
+    num_failed += sc_scda_read_range (scda, s, total, 0, data) != 0;
+  }
+  sc_array_destroy (data);
+
+  data = sc_array_new (sizeof (double));
+  sc_scda_info (scda, 2, &info);
+  num_failed += info.elem_count != 0;
+  num_failed += sc_scda_read_range (scda, 2, 0, 0, data) != 0;
+  num_failed += sc_scda_read_chunk (scda, 2, 0, data) != 0;
+  num_failed += data->elem_count != 0;
+  sc_array_destroy (data);
+
+  num_failed += sc_scda_close (scda) != 0;
+  return num_failed;
+}
+
+/** Write and read a file with all ranks and read it with half of them. */
+static int
+test_scda_file (sc_MPI_Comm mpicomm, const char *filename,
+                const sc_io_mpifile_hints_t * hints, sc_io_encode_t encode)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, size;
+  sc_MPI_Comm         subcomm;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  num_failed += test_scda_write (mpicomm, filename, hints, encode);
+  num_failed += test_scda_read (mpicomm, filename, size);
+
+  mpiret = sc_MPI_Comm_split (mpicomm, rank < (size + 1) / 2, rank,
+                              &subcomm);
+  SC_CHECK_MPI (mpiret);
+  if (rank < (size + 1) / 2) {
+    num_failed += test_scda_read (subcomm, filename, size);
+  }
+  mpiret = sc_MPI_Comm_free (&subcomm);
+  SC_CHECK_MPI (mpiret);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0, num_failed_all;
+  int                 mpiret, rank;
+  const char         *filename = "sc_test_scda.scd";
+  sc_io_encode_t      encode;
+  sc_io_mpifile_hints_t hints;
+  sc_scda_t          *scda;
+  FILE               *file;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  scda = sc_scda_open_write (sc_MPI_COMM_WORLD, filename, NULL, NULL);
+  if (scda == NULL) {
+    SC_GLOBAL_PRODUCTION ("Container files not available\n");
+  }
+  else {
+    num_failed += sc_scda_close (scda) != 0;
+    encode = sc_io_encode_available (SC_IO_ENCODE_ZLIB) ?
+      SC_IO_ENCODE_ZLIB : SC_IO_ENCODE_NONE;
+
+    num_failed += test_scda_file (sc_MPI_COMM_WORLD, filename, NULL,
+                                  encode);
+    memset (&hints, 0, sizeof (hints));
+    hints.stripe_bytes = 4096;
+    num_failed += test_scda_file (sc_MPI_COMM_WORLD, filename, &hints,
+                                  encode);
+
+    /* a file that is not a container is rejected */
+    mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      file = fopen (filename, "wb");
+      SC_CHECK_ABORT (file != NULL, "Open plain file");
+      fprintf (file, "This is not a container file, although it is long "
+               "enough to hold a header and a trailer of one.\n");
+      num_failed += fclose (file) != 0;
+    }
+    mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    scda = sc_scda_open_read (sc_MPI_COMM_WORLD, filename, NULL);
+    num_failed += scda != NULL;
+    if (scda != NULL) {
+      (void) sc_scda_close (scda);
+    }
+    mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+    SC_CHECK_MPI (mpiret);
+    if (rank == 0) {
+      num_failed += remove (filename) != 0;
+    }
+  }
+
+  mpiret = sc_MPI_Allreduce (&num_failed, &num_failed_all, 1, sc_MPI_INT,
+                             sc_MPI_SUM, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (num_failed_all) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed_all);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_all ? EXIT_FAILURE : EXIT_SUCCESS;
+}
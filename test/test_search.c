@@ -23,6 +23,57 @@
 
 #include <sc_search.h>
 
+/** Compare the search kernels with sc_search_lower_bound64. */
+static void
+test_lower_bound (size_t nmemb)
+{
+  const size_t        ntargets = 2 * nmemb + 13;
+  size_t              zz, k;
+  int64_t            *array, *targets, *eytz;
+  size_t             *perm;
+  ssize_t             pos, *positions;
+
+  array = SC_ALLOC (int64_t, nmemb);
+  for (zz = 0; zz < nmemb; ++zz) {
+    /* sorted with duplicates and gaps */
+    array[zz] = (zz == 0 ? -5 : array[zz - 1]) + rand () % 3;
+  }
+  targets = SC_ALLOC (int64_t, ntargets);
+  for (zz = 0; zz < ntargets; ++zz) {
+    targets[zz] = -7 + rand () % (int) (nmemb + 10);
+  }
+  positions = SC_ALLOC (ssize_t, ntargets);
+  eytz = SC_ALLOC (int64_t, nmemb + 1);
+  perm = SC_ALLOC (size_t, nmemb + 1);
+  sc_search_eytzinger64_build (array, nmemb, eytz, perm);
+  sc_search_lower_bound64_many (targets, ntargets, array, nmemb, positions);
+
+  for (zz = 0; zz < ntargets; ++zz) {
+    pos = sc_search_lower_bound64 (targets[zz], array, nmemb, nmemb / 2);
+    SC_CHECK_ABORT (pos == sc_search_lower_bound64_branchless
+                    (targets[zz], array, nmemb), "Branchless search");
+    SC_CHECK_ABORT (pos == positions[zz], "Lockstep search");
+    k = sc_search_eytzinger64 (targets[zz], eytz, nmemb);
+    SC_CHECK_ABORT (pos == (perm[k] == nmemb ? -1 : (ssize_t) perm[k]),
+                    "Eytzinger search");
+    SC_CHECK_ABORT (k == 0 || eytz[k] == array[perm[k]], "Eytzinger value");
+  }
+
+  /* ascending targets for the galloping search */
+  qsort (targets, ntargets, sizeof (int64_t), sc_int64_compare);
+  sc_search_lower_bound64_batch (targets, ntargets, array, nmemb, positions);
+  for (zz = 0; zz < ntargets; ++zz) {
+    SC_CHECK_ABORT (positions[zz] == sc_search_lower_bound64
+                    (targets[zz], array, nmemb, 0), "Batch search");
+  }
+
+  SC_FREE (perm);
+  SC_FREE (eytz);
+  SC_FREE (positions);
+  SC_FREE (targets);
+  SC_FREE (array);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -30,6 +81,7 @@ main (int argc, char **argv)
   int                 mpirank, mpisize;
   int                 maxlevel, level, target;
   int                 i, position;
+  size_t              zz;
   sc_MPI_Comm         mpicomm;
 
   mpiret = sc_MPI_Init (&argc, &argv);
@@ -40,6 +92,7 @@ main (int argc, char **argv)
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
   SC_CHECK_MPI (mpiret);
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
 
   if (mpirank == 0) {
     maxlevel = 3;
@@ -56,6 +109,14 @@ main (int argc, char **argv)
     }
   }
 
+  for (zz = 0; zz < 40; ++zz) {
+    test_lower_bound (zz);
+  }
+  test_lower_bound (1000);
+  test_lower_bound (4097);
+
+  sc_finalize ();
+
   mpiret = sc_MPI_Finalize ();
   SC_CHECK_MPI (mpiret);
 
@@ -0,0 +1,142 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_segarray.h>
+
+/* fill, truncate and flatten a segmented array of int */
+static int
+test_segarray (int chunk_shift, size_t n)
+{
+  int                 num_failed = 0;
+  int                 i, *ip;
+  int               **addr;
+  size_t              zz, c, count, seen;
+  sc_array_t         *flat;
+  sc_segarray_t       sa;
+
+  sc_segarray_init (&sa, sizeof (int), chunk_shift);
+  addr = SC_ALLOC (int *, n);
+
+  /* element addresses never change while the array grows */
+  for (zz = 0; zz < n; ++zz) {
+    ip = (int *) sc_segarray_push (&sa);
+    *ip = (int) zz;
+    addr[zz] = ip;
+  }
+  num_failed += sa.elem_count != n;
+  for (zz = 0; zz < n; ++zz) {
+    num_failed += sc_segarray_index (&sa, zz) != (void *) addr[zz];
+    num_failed += *addr[zz] != (int) zz;
+  }
+
+  /* visit the elements chunk by chunk */
+  seen = 0;
+  for (c = 0; seen < sa.elem_count; ++c) {
+    ip = (int *) sc_segarray_chunk (&sa, c, &count);
+    for (zz = 0; zz < count; ++zz) {
+      num_failed += ip[zz] != (int) (seen + zz);
+    }
+    seen += count;
+  }
+  num_failed += seen != n;
+
+  /* pop keeps the chunk, truncation frees whole chunks */
+  if (n > 0) {
+    ip = (int *) sc_segarray_pop (&sa);
+    num_failed += *ip != (int) n - 1;
+  }
+  sc_segarray_resize (&sa, n / 3);
+  num_failed += sa.num_chunks !=
+    (n / 3 + sa.chunk_mask) >> sa.chunk_shift;
+  for (zz = 0; zz < n / 3; ++zz) {
+    num_failed += sc_segarray_index (&sa, zz) != (void *) addr[zz];
+  }
+
+  /* append a contiguous block across chunk boundaries */
+  {
+    int                *block = SC_ALLOC (int, n - n / 3);
+
+    for (zz = 0; zz < n - n / 3; ++zz) {
+      block[zz] = (int) (n / 3 + zz);
+    }
+    sc_segarray_append (&sa, block, n - n / 3);
+    SC_FREE (block);
+  }
+  num_failed += sa.elem_count != n;
+
+  /* copy and keep, then copy and release */
+  flat = sc_array_new (sizeof (int));
+  sc_segarray_flatten (&sa, flat, 0);
+  num_failed += flat->elem_count != n;
+  for (zz = 0; zz < flat->elem_count; ++zz) {
+    i = *(int *) sc_array_index (flat, zz);
+    num_failed += i != (int) zz;
+    num_failed += *(int *) sc_segarray_index (&sa, zz) != i;
+  }
+  sc_array_reset (flat);
+  sc_segarray_flatten (&sa, flat, 1);
+  num_failed += sa.elem_count != 0 || sa.num_chunks != 0;
+  num_failed += flat->elem_count != n;
+  for (zz = 0; zz < flat->elem_count; ++zz) {
+    num_failed += *(int *) sc_array_index (flat, zz) != (int) zz;
+  }
+  sc_array_destroy (flat);
+
+  SC_FREE (addr);
+  sc_segarray_reset (&sa);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+  sc_segarray_t      *sa;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_segarray (0, 5);
+  num_failed += test_segarray (3, 0);
+  num_failed += test_segarray (3, 64);
+  num_failed += test_segarray (4, 1001);
+  num_failed += test_segarray (-1, 100000);
+
+  /* the default chunk holds 64 KiB */
+  sa = sc_segarray_new (24, -1);
+  num_failed += (sa->chunk_mask + 1) * 24 > 65536;
+  num_failed += (sa->chunk_mask + 1) * 48 <= 65536;
+  sc_segarray_destroy (sa);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
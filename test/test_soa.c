@@ -0,0 +1,140 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+typedef struct test_quad
+{
+  int                 x, y;
+  int8_t              level;
+  double              weight;
+}
+test_quad_t;
+
+static int
+test_soa_int8_compare (const void *v1, const void *v2)
+{
+  return (int) *(const int8_t *) v1 - (int) *(const int8_t *) v2;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+  int                 cx, cy, cl, cw;
+  size_t              i, n = 1000;
+  size_t              offsets[4];
+  sc_array_t         *aos, *back, *newindices, view;
+  sc_soa_t           *soa;
+  test_quad_t        *q, *r;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  soa = sc_soa_new ();
+  cx = sc_soa_add_column (soa, "x", sizeof (int));
+  cy = sc_soa_add_column (soa, "y", sizeof (int));
+  cl = sc_soa_add_column (soa, "level", sizeof (int8_t));
+  num_failed += sc_soa_column_index (soa, "level") != cl;
+  num_failed += sc_soa_column_index (soa, "weight") != -1;
+  offsets[cx] = offsetof (test_quad_t, x);
+  offsets[cy] = offsetof (test_quad_t, y);
+  offsets[cl] = offsetof (test_quad_t, level);
+
+  /* fill records one by one */
+  for (i = 0; i < n; ++i) {
+    num_failed += sc_soa_push (soa) != i;
+    *(int *) sc_soa_index (soa, cx, i) = (int) i;
+    *(int *) sc_soa_index (soa, cy, i) = (int) (3 * i);
+    *(int8_t *) sc_soa_index (soa, cl, i) = (int8_t) ((i * 7) % 19);
+  }
+
+  /* a column added later is zero and matches its name */
+  cw = sc_soa_add_column (soa, "weight", sizeof (double));
+  offsets[cw] = offsetof (test_quad_t, weight);
+  num_failed += sc_soa_column_index (soa, "weight") != cw;
+  for (i = 0; i < n; ++i) {
+    num_failed += *(double *) sc_soa_index (soa, cw, i) != 0.;
+    *(double *) sc_soa_index (soa, cw, i) = .5 * i;
+  }
+
+  /* per-column views work with the array functions */
+  sc_soa_column_view (&view, soa, cl);
+  num_failed += view.elem_count != n || view.elem_size != sizeof (int8_t);
+  sc_array_sort (&view, test_soa_int8_compare);
+  num_failed += !sc_array_is_sorted (&view, test_soa_int8_compare);
+  for (i = 0; i < n; ++i) {
+    *(int8_t *) sc_soa_index (soa, cl, i) = (int8_t) ((i * 7) % 19);
+  }
+
+  /* sorting by the level keeps the records together */
+  newindices = sc_array_new (sizeof (size_t));
+  sc_soa_sort (soa, cl, test_soa_int8_compare, newindices);
+  num_failed += !sc_array_is_permutation (newindices);
+  sc_soa_column_view (&view, soa, cl);
+  num_failed += !sc_array_is_sorted (&view, test_soa_int8_compare);
+  for (i = 0; i < n; ++i) {
+    int                 x = *(int *) sc_soa_index (soa, cx, i);
+
+    num_failed += *(size_t *) sc_array_index (newindices, x) != i;
+    num_failed += *(int *) sc_soa_index (soa, cy, i) != 3 * x;
+    num_failed += *(int8_t *) sc_soa_index (soa, cl, i) != (x * 7) % 19;
+    num_failed += *(double *) sc_soa_index (soa, cw, i) != .5 * x;
+  }
+
+  /* round trip through records */
+  aos = sc_array_new (sizeof (test_quad_t));
+  sc_soa_to_aos (soa, aos, offsets);
+  num_failed += aos->elem_count != n;
+  sc_soa_resize (soa, 10);
+  sc_soa_from_aos (soa, aos, offsets);
+  num_failed += soa->elem_count != n;
+  back = sc_array_new_count (sizeof (test_quad_t), n);
+  sc_array_memset (back, 0);
+  sc_soa_to_aos (soa, back, offsets);
+  for (i = 0; i < n; ++i) {
+    q = (test_quad_t *) sc_array_index (aos, i);
+    r = (test_quad_t *) sc_array_index (back, i);
+    num_failed += q->x != r->x || q->y != r->y || q->level != r->level ||
+      q->weight != r->weight;
+  }
+  SC_GLOBAL_INFOF ("Structure of arrays uses %llu bytes\n",
+                   (unsigned long long) sc_soa_memory_used (soa));
+
+  sc_array_destroy (aos);
+  sc_array_destroy (back);
+  sc_array_destroy (newindices);
+  sc_soa_destroy (soa);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
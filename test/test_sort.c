@@ -24,6 +24,261 @@
 #include <sc_allgather.h>
 #include <sc_sort.h>
 
+typedef struct test_item
+{
+  int32_t             key;
+  int                 origin;   /* global input position */
+}
+test_item_t;
+
+typedef struct test_big
+{
+  int32_t             key;
+  int                 origin;
+  char                pad[88];  /* large enough to be sorted by index */
+}
+test_big_t;
+
+static void
+test_key_negate (const void *item, sc_uint128_t * key, void *user)
+{
+  key->high_bits = 0;
+  key->low_bits = (uint64_t) (1000 - ((const test_item_t *) item)->key);
+}
+
+/** Sort items by key with a weighted output and by callback balanced. */
+static void
+test_psort_ext (sc_MPI_Comm mpicomm, size_t lcount)
+{
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i, *recvc, *displ;
+  size_t              zz, offset, gtotal;
+  size_t             *nmemb;
+  double             *weights;
+  long long           lc, *counts;
+  test_item_t        *gitems, *t, *u;
+  sc_array_t         *a;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  lc = (long long) lcount;
+  counts = SC_ALLOC (long long, num_procs);
+  mpiret = sc_MPI_Allgather (&lc, 1, sc_MPI_LONG_LONG_INT,
+                             counts, 1, sc_MPI_LONG_LONG_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  nmemb = SC_ALLOC (size_t, num_procs);
+  weights = SC_ALLOC (double, num_procs);
+  for (offset = 0, gtotal = 0, i = 0; i < num_procs; ++i) {
+    nmemb[i] = (size_t) counts[i];
+    weights[i] = i + 1.;
+    if (i < rank) {
+      offset += nmemb[i];
+    }
+    gtotal += nmemb[i];
+  }
+  SC_FREE (counts);
+
+  /* many duplicate keys to check stability */
+  a = sc_array_new_count (sizeof (test_item_t), lcount);
+  for (zz = 0; zz < lcount; ++zz) {
+    t = (test_item_t *) sc_array_index (a, zz);
+    t->key = (int32_t) (rand () % 10) - 5;
+    t->origin = (int) (offset + zz);
+  }
+  sc_psort_ext (mpicomm, a, nmemb, NULL, NULL, offsetof (test_item_t, key),
+                SC_ARRAY_KEY_INT32, weights);
+  SC_CHECK_ABORT (a->elem_count == nmemb[rank], "Sort ext count");
+
+  recvc = SC_ALLOC (int, num_procs);
+  displ = SC_ALLOC (int, num_procs + 1);
+  displ[0] = 0;
+  for (i = 0; i < num_procs; ++i) {
+    recvc[i] = (int) (nmemb[i] * sizeof (test_item_t));
+    displ[i + 1] = displ[i] + recvc[i];
+  }
+  SC_CHECK_ABORT ((size_t) displ[num_procs] ==
+                  gtotal * sizeof (test_item_t), "Sort ext total");
+  SC_CHECK_ABORT (nmemb[num_procs - 1] + 1 >= nmemb[0],
+                  "Sort ext weights");
+  gitems = SC_ALLOC (test_item_t, gtotal);
+  mpiret = sc_MPI_Allgatherv (a->array, recvc[rank], sc_MPI_BYTE,
+                              gitems, recvc, displ, sc_MPI_BYTE, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (zz = 1; zz < gtotal; ++zz) {
+    t = gitems + zz - 1;
+    u = gitems + zz;
+    SC_CHECK_ABORT (t->key < u->key ||
+                    (t->key == u->key && t->origin < u->origin),
+                    "Sort ext stable");
+  }
+
+  /* sort descending by callback into a balanced partition */
+  sc_psort_ext (mpicomm, a, nmemb, test_key_negate, NULL, 0,
+                SC_ARRAY_KEY_INT32, NULL);
+  for (i = 0; i < num_procs; ++i) {
+    SC_CHECK_ABORT (nmemb[i] == gtotal / num_procs +
+                    (i < (int) (gtotal % num_procs)), "Sort ext balance");
+  }
+  for (zz = 1; zz < a->elem_count; ++zz) {
+    t = (test_item_t *) sc_array_index (a, zz - 1);
+    u = (test_item_t *) sc_array_index (a, zz);
+    SC_CHECK_ABORT (t->key > u->key ||
+                    (t->key == u->key && t->origin < u->origin),
+                    "Sort ext callback");
+  }
+
+  SC_FREE (gitems);
+  SC_FREE (displ);
+  SC_FREE (recvc);
+  SC_FREE (weights);
+  SC_FREE (nmemb);
+  sc_array_destroy (a);
+}
+
+/** Check that consecutive keys and input positions are stably sorted. */
+static void
+test_check_stable (sc_MPI_Comm mpicomm, const long long *pairs,
+                   size_t count, const char *msg)
+{
+  int                 mpiret;
+  int                 num_procs, i, *recvc, *displ;
+  int                 lc;
+  size_t              zz;
+  long long          *all;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  recvc = SC_ALLOC (int, num_procs);
+  displ = SC_ALLOC (int, num_procs + 1);
+  lc = (int) (2 * count);
+  mpiret = sc_MPI_Allgather (&lc, 1, sc_MPI_INT, recvc, 1, sc_MPI_INT,
+                             mpicomm);
+  SC_CHECK_MPI (mpiret);
+  displ[0] = 0;
+  for (i = 0; i < num_procs; ++i) {
+    displ[i + 1] = displ[i] + recvc[i];
+  }
+  all = SC_ALLOC (long long, displ[num_procs]);
+  mpiret = sc_MPI_Allgatherv ((void *) pairs, lc, sc_MPI_LONG_LONG_INT,
+                              all, recvc, displ, sc_MPI_LONG_LONG_INT,
+                              mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (zz = 2; zz < (size_t) displ[num_procs]; zz += 2) {
+    SC_CHECK_ABORT (all[zz - 2] < all[zz] ||
+                    (all[zz - 2] == all[zz] && all[zz - 1] < all[zz + 1]),
+                    msg);
+  }
+  SC_FREE (all);
+  SC_FREE (displ);
+  SC_FREE (recvc);
+}
+
+/** Sort large items and parallel arrays by moving keys and indices. */
+static void
+test_psort_arrays (sc_MPI_Comm mpicomm, size_t lcount)
+{
+  int                 mpiret;
+  int                 rank, num_procs;
+  int                 i;
+  size_t              zz, offset, g;
+  size_t             *nmemb;
+  long long           lc, *counts, *pairs;
+  int32_t            *key;
+  double             *d;
+  test_big_t         *t;
+  sc_array_t         *a, *keys, *big, *dbl, *origin;
+  sc_array_t         *arrays[2];
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  lc = (long long) lcount;
+  counts = SC_ALLOC (long long, num_procs);
+  mpiret = sc_MPI_Allgather (&lc, 1, sc_MPI_LONG_LONG_INT,
+                             counts, 1, sc_MPI_LONG_LONG_INT, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  nmemb = SC_ALLOC (size_t, num_procs);
+  for (offset = 0, i = 0; i < num_procs; ++i) {
+    nmemb[i] = (size_t) counts[i];
+    if (i < rank) {
+      offset += nmemb[i];
+    }
+  }
+
+  /* keys, large payloads and doubles in parallel arrays */
+  keys = sc_array_new_count (sizeof (int32_t), lcount);
+  big = sc_array_new_count (sizeof (test_big_t), lcount);
+  dbl = sc_array_new_count (sizeof (double), lcount);
+  origin = sc_array_new (sizeof (size_t));
+  for (zz = 0; zz < lcount; ++zz) {
+    key = (int32_t *) sc_array_index (keys, zz);
+    *key = (int32_t) (rand () % 10) - 5;
+    t = (test_big_t *) sc_array_index (big, zz);
+    t->key = *key;
+    t->origin = (int) (offset + zz);
+    memset (t->pad, (int) ((offset + zz) & 0x7f), sizeof (t->pad));
+    *(double *) sc_array_index (dbl, zz) = (double) (offset + zz);
+  }
+  a = sc_array_new (sizeof (test_big_t));
+  sc_array_copy (a, big);
+
+  arrays[0] = big;
+  arrays[1] = dbl;
+  sc_psort_arrays (mpicomm, keys, arrays, 2, nmemb, NULL, NULL, 0,
+                   SC_ARRAY_KEY_INT32, NULL, origin);
+  SC_CHECK_ABORT (keys->elem_count == nmemb[rank] &&
+                  big->elem_count == nmemb[rank] &&
+                  dbl->elem_count == nmemb[rank] &&
+                  origin->elem_count == nmemb[rank], "Sort arrays count");
+  pairs = SC_ALLOC (long long, 2 * keys->elem_count);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = (int32_t *) sc_array_index (keys, zz);
+    t = (test_big_t *) sc_array_index (big, zz);
+    d = (double *) sc_array_index (dbl, zz);
+    g = *(size_t *) sc_array_index (origin, zz);
+    SC_CHECK_ABORT (t->key == *key && (size_t) t->origin == g &&
+                    *d == (double) g &&
+                    t->pad[sizeof (t->pad) - 1] == (char) (g & 0x7f),
+                    "Sort arrays payload");
+    pairs[2 * zz] = *key;
+    pairs[2 * zz + 1] = (long long) g;
+  }
+  test_check_stable (mpicomm, pairs, keys->elem_count,
+                     "Sort arrays stable");
+  SC_FREE (pairs);
+
+  /* large items in one array take the same path */
+  for (i = 0; i < num_procs; ++i) {
+    nmemb[i] = (size_t) counts[i];
+  }
+  sc_psort_ext (mpicomm, a, nmemb, NULL, NULL, offsetof (test_big_t, key),
+                SC_ARRAY_KEY_INT32, NULL);
+  pairs = SC_ALLOC (long long, 2 * a->elem_count);
+  for (zz = 0; zz < a->elem_count; ++zz) {
+    t = (test_big_t *) sc_array_index (a, zz);
+    SC_CHECK_ABORT (t->pad[0] == (char) (t->origin & 0x7f),
+                    "Sort ext payload");
+    pairs[2 * zz] = t->key;
+    pairs[2 * zz + 1] = t->origin;
+  }
+  test_check_stable (mpicomm, pairs, a->elem_count, "Sort ext large");
+  SC_FREE (pairs);
+
+  SC_FREE (counts);
+  SC_FREE (nmemb);
+  sc_array_destroy (a);
+  sc_array_destroy (origin);
+  sc_array_destroy (dbl);
+  sc_array_destroy (big);
+  sc_array_destroy (keys);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -37,7 +292,7 @@ main (int argc, char **argv)
   size_t              zz;
   size_t              lcount, gtotal;
   size_t             *nmemb;
-  double             *ldata, *gdata;
+  double             *ldata, *gdata, *odata;
   sc_MPI_Comm         mpicomm;
   char                buffer[BUFSIZ];
 
@@ -102,6 +357,10 @@ main (int argc, char **argv)
     sleep (1);
   }
 
+  /* keep the unsorted data for the sample sort below */
+  odata = SC_ALLOC (double, lcount);
+  memcpy (odata, ldata, lcount * sizeof (double));
+
   /* call parallel sort */
   SC_GLOBAL_PRODUCTIONF ("Sorting %ld\n", (long) gtotal);
   sc_psort (mpicomm, ldata, nmemb, sizeof (double), sc_double_compare);
@@ -123,6 +382,64 @@ main (int argc, char **argv)
     sleep (1);
   }
 
+  /* sample sort must agree with the bitonic sort in both output modes */
+  if (gtotal < 100000) {
+    size_t             *nmemb2;
+    double             *sdata;
+    sc_array_t         *rebalanced;
+
+    SC_GLOBAL_PRODUCTION ("Sample sort\n");
+    recvc = SC_ALLOC (int, num_procs);
+    displ = SC_ALLOC (int, num_procs + 1);
+    displ[0] = 0;
+    for (i = 0; i < num_procs; ++i) {
+      recvc[i] = (int) nmemb[i];
+      displ[i + 1] = displ[i] + recvc[i];
+    }
+    gdata = SC_ALLOC (double, gtotal);
+    mpiret = sc_MPI_Allgatherv (ldata, (int) lcount, sc_MPI_DOUBLE,
+                                gdata, recvc, displ, sc_MPI_DOUBLE, mpicomm);
+    SC_CHECK_MPI (mpiret);
+
+    sdata = SC_ALLOC (double, lcount);
+    memcpy (sdata, odata, lcount * sizeof (double));
+    sc_psort_sample (mpicomm, sdata, nmemb, sizeof (double),
+                     sc_double_compare, NULL);
+    for (zz = 0; zz < lcount; ++zz) {
+      SC_CHECK_ABORT (sdata[zz] == gdata[displ[rank] + zz],
+                      "Sample sort failed");
+    }
+
+    nmemb2 = SC_ALLOC (size_t, num_procs);
+    memcpy (nmemb2, nmemb, num_procs * sizeof (size_t));
+    memcpy (sdata, odata, lcount * sizeof (double));
+    rebalanced = sc_array_new (sizeof (double));
+    sc_psort_sample (mpicomm, sdata, nmemb2, sizeof (double),
+                     sc_double_compare, rebalanced);
+    SC_CHECK_ABORT (rebalanced->elem_count == nmemb2[rank],
+                    "Sample sort count");
+    for (k = 0, i = 0; i < num_procs; ++i) {
+      SC_CHECK_ABORT (nmemb2[i] == gtotal / num_procs + (i < (int)
+                                                         (gtotal %
+                                                          num_procs)),
+                      "Sample sort balance");
+      if (i < rank) {
+        k += (int) nmemb2[i];
+      }
+    }
+    for (zz = 0; zz < rebalanced->elem_count; ++zz) {
+      SC_CHECK_ABORT (*(double *) sc_array_index (rebalanced, zz) ==
+                      gdata[k + zz], "Sample sort rebalanced failed");
+    }
+
+    sc_array_destroy (rebalanced);
+    SC_FREE (nmemb2);
+    SC_FREE (sdata);
+    SC_FREE (gdata);
+    SC_FREE (displ);
+    SC_FREE (recvc);
+  }
+
   /* verify result always, if the numbers are not too many */
   if (gtotal < 100000) {
     SC_GLOBAL_PRODUCTION ("Verifying\n");
@@ -154,7 +471,12 @@ main (int argc, char **argv)
     SC_FREE (recvc);
   }
 
+  /* sort by keys, which is cheap enough for any count */
+  test_psort_ext (mpicomm, lcount);
+  test_psort_arrays (mpicomm, lcount);
+
   /* clean up and exit */
+  SC_FREE (odata);
   SC_FREE (ldata);
   SC_FREE (nmemb);
 
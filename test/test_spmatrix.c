@@ -0,0 +1,307 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_spmatrix.h>
+#include <sc_random.h>
+
+#define TEST_SPMATRIX_TOL 1.e-12
+
+/** Triplets of a random sparse matrix with some duplicate positions. */
+typedef struct test_spmatrix_coo
+{
+  size_t              count;
+  int64_t            *rows, *cols;
+  double             *vals;
+}
+test_spmatrix_coo_t;
+
+static void
+test_spmatrix_coo_init (test_spmatrix_coo_t * coo, int64_t m, int64_t n,
+                        size_t count, int seed)
+{
+  size_t              zz;
+  sc_rand_state_t     state = (sc_rand_state_t) seed;
+
+  coo->count = count;
+  coo->rows = SC_ALLOC (int64_t, count);
+  coo->cols = SC_ALLOC (int64_t, count);
+  coo->vals = SC_ALLOC (double, count);
+  for (zz = 0; zz < count; ++zz) {
+    if (zz % 7 == 6) {
+      /* repeat an earlier position */
+      coo->rows[zz] = coo->rows[zz / 2];
+      coo->cols[zz] = coo->cols[zz / 2];
+    }
+    else {
+      coo->rows[zz] = (int64_t) (sc_rand (&state) * m);
+      coo->cols[zz] = (int64_t) (sc_rand (&state) * n);
+    }
+    coo->vals[zz] = sc_rand (&state) - .5;
+  }
+}
+
+static void
+test_spmatrix_coo_reset (test_spmatrix_coo_t * coo)
+{
+  SC_FREE (coo->rows);
+  SC_FREE (coo->cols);
+  SC_FREE (coo->vals);
+}
+
+/** Compute y := alpha * A x + beta * y directly from the triplets. */
+static void
+test_spmatrix_coo_vector (const test_spmatrix_coo_t * coo, double alpha,
+                          const double *x, double beta, double *y,
+                          int64_t m)
+{
+  size_t              zz;
+  int64_t             i;
+
+  for (i = 0; i < m; ++i) {
+    y[i] *= beta;
+  }
+  for (zz = 0; zz < coo->count; ++zz) {
+    y[coo->rows[zz]] += alpha * coo->vals[zz] * x[coo->cols[zz]];
+  }
+}
+
+static int
+test_spmatrix_local (sc_bint_t m, sc_bint_t n, sc_bint_t bs, size_t count)
+{
+  int                 num_failed = 0;
+  size_t              zz;
+  sc_bint_t           i, j, *rows, *cols;
+  double             *x, *y, *yref;
+  test_spmatrix_coo_t coo;
+  sc_spmatrix_t      *A;
+  sc_dmatrix_t       *D, *X, *Y;
+
+  test_spmatrix_coo_init (&coo, m, n, count, (int) (m + 3 * bs));
+  rows = SC_ALLOC (sc_bint_t, count);
+  cols = SC_ALLOC (sc_bint_t, count);
+  for (zz = 0; zz < count; ++zz) {
+    rows[zz] = (sc_bint_t) coo.rows[zz];
+    cols[zz] = (sc_bint_t) coo.cols[zz];
+  }
+  A = sc_spmatrix_new_coo (m, n, bs, count, rows, cols, coo.vals);
+  SC_FREE (rows);
+  SC_FREE (cols);
+  SC_GLOBAL_INFOF ("Sparse matrix %d x %d block size %d with %d blocks"
+                   " uses %llu bytes\n", (int) m, (int) n, (int) bs,
+                   (int) A->nnzb,
+                   (unsigned long long) sc_spmatrix_memory_used (A));
+
+  /* the block columns of each block row ascend */
+  for (i = 0; i < A->mb; ++i) {
+    for (j = A->rowptr[i] + 1; j < A->rowptr[i + 1]; ++j) {
+      if (A->colidx[j - 1] >= A->colidx[j]) {
+        ++num_failed;
+      }
+    }
+  }
+
+  x = SC_ALLOC (double, n);
+  y = SC_ALLOC (double, m);
+  yref = SC_ALLOC (double, m);
+  for (j = 0; j < n; ++j) {
+    x[j] = sin (1. + j);
+  }
+
+  /* products with and without the original y */
+  for (i = 0; i < m; ++i) {
+    y[i] = yref[i] = cos (2. + i);
+  }
+  sc_spmatrix_vector (1.5, A, x, -.5, y);
+  test_spmatrix_coo_vector (&coo, 1.5, x, -.5, yref, m);
+  for (i = 0; i < m; ++i) {
+    num_failed += fabs (y[i] - yref[i]) > TEST_SPMATRIX_TOL;
+  }
+  for (i = 0; i < m; ++i) {
+    y[i] = 0. / (y[i] - y[i] + 0.);       /* NaN must not be read */
+    yref[i] = 0.;
+  }
+  sc_spmatrix_vector (2., A, x, 0., y);
+  test_spmatrix_coo_vector (&coo, 2., x, 0., yref, m);
+  for (i = 0; i < m; ++i) {
+    num_failed += !(fabs (y[i] - yref[i]) <= TEST_SPMATRIX_TOL);
+  }
+
+  /* the columns of a dense product are products with vectors */
+  X = sc_dmatrix_new_aligned (n, 3);
+  Y = sc_dmatrix_new (m, 3);
+  for (j = 0; j < n; ++j) {
+    X->e[j][0] = x[j];
+    X->e[j][1] = -x[j];
+    X->e[j][2] = 1.;
+  }
+  sc_dmatrix_set_value (Y, 1.);
+  sc_spmatrix_multiply (2., A, X, 1., Y);
+  for (i = 0; i < m; ++i) {
+    num_failed += fabs (Y->e[i][0] - (yref[i] + 1.)) > TEST_SPMATRIX_TOL;
+    num_failed += fabs (Y->e[i][1] - (1. - yref[i])) > TEST_SPMATRIX_TOL;
+  }
+
+  if ((long) m * n <= 10000) {
+    /* the dense expansion sums the duplicates in the same order */
+    D = sc_dmatrix_new (m, n);
+    sc_spmatrix_to_dmatrix (A, D);
+    for (zz = 0; zz < count; ++zz) {
+      D->e[coo.rows[zz]][coo.cols[zz]] = 0.;
+    }
+    num_failed += !sc_darray_is_range (D->e[0], (size_t) m * n, 0., 0.);
+    sc_dmatrix_destroy (D);
+  }
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Sparse matrix %d x %d block size %d failed\n",
+                       (int) m, (int) n, (int) bs);
+  }
+
+  sc_dmatrix_destroy (X);
+  sc_dmatrix_destroy (Y);
+  SC_FREE (x);
+  SC_FREE (y);
+  SC_FREE (yref);
+  sc_spmatrix_destroy (A);
+  test_spmatrix_coo_reset (&coo);
+  return num_failed;
+}
+
+static int
+test_spmatrix_dist (sc_MPI_Comm mpicomm, sc_bint_t bs, int64_t nb)
+{
+  int                 num_failed = 0;
+  int                 mpiret, mpisize, mpirank, p;
+  const int64_t       N = nb * bs;
+  int64_t            *row_offsets, *col_offsets, i;
+  size_t              zz, count;
+  double             *x, *yref, *y;
+  test_spmatrix_coo_t coo, local;
+  sc_spmatrix_dist_t *A;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* the rows are partitioned unevenly and the columns evenly */
+  row_offsets = SC_ALLOC (int64_t, mpisize + 1);
+  col_offsets = SC_ALLOC (int64_t, mpisize + 1);
+  for (p = 0; p <= mpisize; ++p) {
+    row_offsets[p] = bs * (nb * p * p / ((int64_t) mpisize * mpisize));
+    col_offsets[p] = bs * (nb * p / mpisize);
+  }
+
+  /* every process creates all triplets and keeps those of its rows */
+  test_spmatrix_coo_init (&coo, N, N, (size_t) (6 * N), 17 + (int) bs);
+  local.rows = SC_ALLOC (int64_t, coo.count);
+  local.cols = SC_ALLOC (int64_t, coo.count);
+  local.vals = SC_ALLOC (double, coo.count);
+  count = 0;
+  for (zz = 0; zz < coo.count; ++zz) {
+    if (row_offsets[mpirank] <= coo.rows[zz] &&
+        coo.rows[zz] < row_offsets[mpirank + 1]) {
+      local.rows[count] = coo.rows[zz];
+      local.cols[count] = coo.cols[zz];
+      local.vals[count++] = coo.vals[zz];
+    }
+  }
+  local.count = count;
+  A = sc_spmatrix_dist_new_coo (mpicomm, bs, row_offsets, col_offsets,
+                                local.count, local.rows, local.cols,
+                                local.vals);
+
+  x = SC_ALLOC (double, N);
+  yref = SC_ALLOC (double, N);
+  y = SC_ALLOC (double, N);
+  for (i = 0; i < N; ++i) {
+    x[i] = sin (3. + i);
+    yref[i] = y[i] = cos (i);
+  }
+  test_spmatrix_coo_vector (&coo, -1., x, 2., yref, N);
+  sc_spmatrix_dist_vector (-1., A, x + col_offsets[mpirank], 2.,
+                           y + row_offsets[mpirank]);
+  for (i = row_offsets[mpirank]; i < row_offsets[mpirank + 1]; ++i) {
+    num_failed += fabs (y[i] - yref[i]) > TEST_SPMATRIX_TOL;
+  }
+
+  /* a second product reuses the exchange */
+  test_spmatrix_coo_vector (&coo, 1., x, 0., yref, N);
+  sc_spmatrix_dist_vector (1., A, x + col_offsets[mpirank], 0.,
+                           y + row_offsets[mpirank]);
+  for (i = row_offsets[mpirank]; i < row_offsets[mpirank + 1]; ++i) {
+    num_failed += fabs (y[i] - yref[i]) > TEST_SPMATRIX_TOL;
+  }
+  SC_LDEBUGF ("Distributed matrix has %d ghost columns\n",
+              (int) sc_spmatrix_dist_num_ghosts (A));
+
+  if (num_failed) {
+    SC_LERRORF ("Distributed matrix block size %d failed\n", (int) bs);
+  }
+
+  SC_FREE (x);
+  SC_FREE (y);
+  SC_FREE (yref);
+  sc_spmatrix_dist_destroy (A);
+  test_spmatrix_coo_reset (&local);
+  test_spmatrix_coo_reset (&coo);
+  SC_FREE (row_offsets);
+  SC_FREE (col_offsets);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0, global_failed;
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm = sc_MPI_COMM_WORLD;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_spmatrix_local (1, 1, 1, 3);
+  num_failed += test_spmatrix_local (0, 5, 1, 0);
+  num_failed += test_spmatrix_local (30, 40, 1, 100);
+  num_failed += test_spmatrix_local (30, 40, 2, 100);
+  num_failed += test_spmatrix_local (33, 27, 3, 200);
+  num_failed += test_spmatrix_local (20000, 20000, 1, 100000);
+  num_failed += test_spmatrix_local (6000, 3000, 3, 40000);
+
+  num_failed += test_spmatrix_dist (mpicomm, 1, 100);
+  num_failed += test_spmatrix_dist (mpicomm, 2, 57);
+
+  mpiret = sc_MPI_Allreduce (&num_failed, &global_failed, 1, sc_MPI_INT,
+                             sc_MPI_SUM, mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (global_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", global_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return global_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_statistics.h>
+
+#define TEST_STATS_NVARS 3
+
+static int
+test_stats_compute (sc_MPI_Comm mpicomm, int nonblocking)
+{
+  int                 mpiret;
+  int                 i, rank, size;
+  int                 failed = 0;
+  double              expected;
+  sc_statinfo_t       stats[TEST_STATS_NVARS];
+  sc_stats_request_t *req;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* every rank contributes its rank and its negative */
+  sc_stats_init (stats + 0, "rank");
+  sc_stats_accumulate (stats + 0, (double) rank);
+  sc_stats_accumulate (stats + 0, (double) -rank);
+
+  /* only the last rank contributes a value larger than the default 0 */
+  sc_stats_init (stats + 1, "last");
+  if (rank == size - 1) {
+    sc_stats_accumulate (stats + 1, 5.);
+  }
+
+  /* a variable without any values */
+  sc_stats_init (stats + 2, "empty");
+
+  if (nonblocking) {
+    req = sc_stats_compute_begin (mpicomm, TEST_STATS_NVARS, stats);
+    sc_stats_compute_end (req);
+  }
+  else {
+    sc_stats_compute (mpicomm, TEST_STATS_NVARS, stats);
+  }
+
+  expected = size * (size - 1) * (2. * size - 1.) / 3.;
+  if (stats[0].count != 2 * size || stats[0].sum_values != 0. ||
+      stats[0].sum_squares != expected ||
+      stats[0].min != (double) (1 - size) || stats[0].max != size - 1. ||
+      stats[0].min_at_rank != size - 1 || stats[0].max_at_rank != size - 1) {
+    SC_GLOBAL_LERROR ("Statistics of rank mismatch\n");
+    ++failed;
+  }
+  if (stats[1].count != 1 || stats[1].min != 5. || stats[1].max != 5. ||
+      stats[1].average != 5. || stats[1].min_at_rank != size - 1) {
+    SC_GLOBAL_LERROR ("Statistics of last rank mismatch\n");
+    ++failed;
+  }
+  if (stats[2].count != 0 || stats[2].average != 0.) {
+    SC_GLOBAL_LERROR ("Statistics of empty variable mismatch\n");
+    ++failed;
+  }
+  if (!nonblocking) {
+    sc_stats_print (sc_package_id, SC_LP_STATISTICS,
+                    TEST_STATS_NVARS, stats, 1, 1);
+  }
+  for (i = 0; i < TEST_STATS_NVARS; ++i) {
+    sc_stats_reset (stats + i, 1);
+  }
+
+  return failed;
+}
+
+static int
+test_statistics_overlap (sc_MPI_Comm mpicomm)
+{
+  int                 i, failed = 0;
+  double              sum = 0.;
+  sc_statistics_t    *stats;
+  sc_stats_request_t *req;
+
+  stats = sc_statistics_new (mpicomm);
+  sc_statistics_add_empty (stats, "one");
+  sc_statistics_accumulate (stats, "one", 1.);
+
+  /* work on something else while the reduction is in progress */
+  req = sc_statistics_compute_begin (stats);
+  for (i = 0; i < 1000; ++i) {
+    sum += i;
+  }
+  sc_statistics_compute_end (req);
+
+  if (((sc_statinfo_t *) sc_array_index (stats->sarray, 0))->average != 1.
+      || sum != 499500.) {
+    SC_GLOBAL_LERROR ("Overlapped statistics mismatch\n");
+    ++failed;
+  }
+  sc_statistics_destroy (stats);
+
+  return failed;
+}
+
+static int
+test_statistics_handle (sc_MPI_Comm mpicomm)
+{
+  int                 i, h, failed = 0;
+  double              values[100];
+  sc_statinfo_t      *sa, *sb;
+  sc_statistics_t    *stats;
+
+  stats = sc_statistics_new (mpicomm);
+  sc_statistics_add_empty (stats, "single");
+  sc_statistics_add_empty (stats, "batch");
+  for (i = 0; i < 100; ++i) {
+    values[i] = (i * 37) % 100 - 50.;
+  }
+
+  /* the same values through the scalar and the batch path */
+  h = sc_statistics_get_handle (stats, "single");
+  for (i = 0; i < 100; ++i) {
+    sc_statistics_accumulate_h (stats, h, values[i]);
+  }
+  h = sc_statistics_get_handle (stats, "batch");
+  sc_statistics_accumulate_n (stats, h, 0, NULL);
+  sc_statistics_accumulate_n (stats, h, 1, values);
+  sc_statistics_accumulate_n (stats, h, 99, values + 1);
+
+  sa = (sc_statinfo_t *) sc_array_index (stats->sarray, 0);
+  sb = (sc_statinfo_t *) sc_array_index (stats->sarray, 1);
+  if (sa->count != 100 || sb->count != 100 ||
+      sa->sum_values != sb->sum_values ||
+      sa->sum_squares != sb->sum_squares ||
+      sa->min != -50. || sb->min != -50. ||
+      sa->max != 49. || sb->max != 49.) {
+    SC_GLOBAL_LERROR ("Statistics handle mismatch\n");
+    ++failed;
+  }
+  sc_statistics_compute (stats);
+  if (sa->average != sb->average || sb->average != -.5) {
+    SC_GLOBAL_LERROR ("Statistics handle average mismatch\n");
+    ++failed;
+  }
+  sc_statistics_destroy (stats);
+
+  return failed;
+}
+
+static int
+test_stats_quantile (const char *what, double q, double v, double expected,
+                     double tol)
+{
+  if (fabs (v - expected) > tol * expected) {
+    SC_GLOBAL_LERRORF ("Quantile %g of %s is %g instead of %g\n",
+                       q, what, v, expected);
+    return 1;
+  }
+  return 0;
+}
+
+static int
+test_statistics_dist (sc_MPI_Comm mpicomm)
+{
+  int                 mpiret;
+  int                 i, rank, size;
+  int                 failed = 0;
+  double              n, p;
+  const double        qs[3] = { .5, .95, .99 };
+  const char         *names[3] = { "linear", "log", "sketch" };
+  sc_statistics_t    *stats;
+  sc_stats_request_t *req;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+  /* the values 1 to 1000 * size are spread over the ranks */
+  n = 1000. * size;
+  stats = sc_statistics_new (mpicomm);
+  sc_statistics_add_empty (stats, names[0]);
+  sc_statistics_add_empty (stats, names[1]);
+  sc_statistics_add_empty (stats, names[2]);
+  sc_statistics_add_empty (stats, "plain");
+  sc_statistics_set_histogram (stats, names[0], 0, 100 * size, 0., n);
+  sc_statistics_set_histogram (stats, names[1], 1, 400, 1., n);
+  sc_statistics_set_sketch (stats, names[2], .01, 256);
+  for (i = 1; i <= 1000; ++i) {
+    p = (double) (i + 1000 * rank);
+    sc_statistics_accumulate (stats, names[0], p);
+    sc_statistics_accumulate (stats, names[1], p);
+    sc_statistics_accumulate (stats, names[2], p);
+    sc_statistics_accumulate (stats, "plain", p);
+  }
+
+  req = sc_statistics_compute_begin (stats);
+  sc_statistics_compute_end (req);
+  for (i = 0; i < 3; ++i) {
+    p = floor (qs[i] * (n - 1.)) + 1.;
+    failed += test_stats_quantile (names[0], qs[i],
+                                   sc_statistics_quantile (stats, names[0],
+                                                           qs[i]), p, .01);
+    failed += test_stats_quantile (names[1], qs[i],
+                                   sc_statistics_quantile (stats, names[1],
+                                                           qs[i]), p, .02);
+    failed += test_stats_quantile (names[2], qs[i],
+                                   sc_statistics_quantile (stats, names[2],
+                                                           qs[i]), p, .02);
+  }
+
+  /* the lowest values of the sketch are collapsed, but bounded below */
+  p = sc_statistics_quantile (stats, names[2], 0.);
+  if (p < 1. || p > n) {
+    SC_GLOBAL_LERROR ("Sketch minimum out of range\n");
+    ++failed;
+  }
+  sc_statistics_print (stats, sc_package_id, SC_LP_STATISTICS, 1, 0);
+  sc_statistics_destroy (stats);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  failed += test_stats_compute (mpicomm, 0);
+  failed += test_stats_compute (mpicomm, 1);
+  failed += test_statistics_overlap (mpicomm);
+  failed += test_statistics_handle (mpicomm);
+  failed += test_statistics_dist (mpicomm);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
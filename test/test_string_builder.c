@@ -0,0 +1,148 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_string.h>
+#include <sc_io.h>
+
+/* compare the builder output for a number against printf */
+static int
+test_string_number (long long i, double d, int decimals)
+{
+  int                 failed = 0;
+  char                expect[BUFSIZ];
+  const char         *content;
+  sc_string_builder_t *sb;
+
+  sb = sc_string_builder_new (8);
+  sc_string_builder_put_int (sb, i);
+  content = sc_string_builder_get_content (sb, NULL);
+  snprintf (expect, BUFSIZ, "%lld", i);
+  if (strcmp (content, expect)) {
+    SC_LERRORF ("Integer %s formatted as %s\n", expect, content);
+    ++failed;
+  }
+
+  sc_string_builder_reset (sb);
+  sc_string_builder_put_double (sb, d, decimals);
+  content = sc_string_builder_get_content (sb, NULL);
+  snprintf (expect, BUFSIZ, "%.*f", decimals, d);
+  if (strcmp (content, expect)) {
+    SC_LERRORF ("Double %s formatted as %s\n", expect, content);
+    ++failed;
+  }
+  sc_string_builder_destroy (sb);
+
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 i, num_failed = 0;
+  size_t              length;
+  char                expect[BUFSIZ];
+  const char         *content;
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  sc_string_builder_t *sb;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* numbers including the extremes and rounding of fractions */
+  num_failed += test_string_number (0, 0., 0);
+  num_failed += test_string_number (7, 2.5e-3, 3);
+  num_failed += test_string_number (-99, -1.25, 1);
+  num_failed += test_string_number (100, 12345.678, 2);
+  num_failed += test_string_number (LLONG_MAX, 0.999, 2);
+  num_failed += test_string_number (LLONG_MIN, -123456.7890123, 6);
+  num_failed += test_string_number (-1234567890123LL, 3.14159265, 8);
+  num_failed += test_string_number (1, 0.1, 17);
+  num_failed += test_string_number (2, 0.125, 2);
+  num_failed += test_string_number (3, 2.675, 2);
+  for (i = 0; i < 1000 && !num_failed; ++i) {
+    num_failed += test_string_number (i * 7919LL, (i - 500) / 64. +
+                                      i * 1e-7, i % 9);
+  }
+
+  /* a string much longer than the chunk size and sc_string_t */
+  sb = sc_string_builder_new (64);
+  for (i = 0; i < 10000; ++i) {
+    sc_string_builder_put_int (sb, i);
+    sc_string_builder_putc (sb, ',');
+    sc_string_builder_putf (sb, "%s%d;", "x", -i);
+    sc_string_builder_puts (sb, i % 100 ? "" : "a longer piece of text\n");
+  }
+  length = sc_string_builder_length (sb);
+  content = sc_string_builder_get_content (sb, NULL);
+  if (strlen (content) != length || strncmp (content, "0,x0;a longer", 13)) {
+    SC_LERROR ("Long string content mismatch\n");
+    ++num_failed;
+  }
+  for (i = 0; i < 10000; i += 997) {
+    snprintf (expect, BUFSIZ, ";%d,x%d;", i, -i);
+    if (i > 0 && i % 100 && strstr (content, expect) == NULL) {
+      SC_LERRORF ("Long string lacks %s\n", expect);
+      ++num_failed;
+    }
+  }
+
+  /* a format result larger than a chunk goes into a chunk of its own */
+  sc_string_builder_reset (sb);
+  sc_string_builder_putf (sb, "%0200d", 5);
+  if (sc_string_builder_length (sb) != 200) {
+    SC_LERROR ("Long format mismatch\n");
+    ++num_failed;
+  }
+
+  /* drain into a buffer sink */
+  buffer = sc_array_new (1);
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  for (i = 0; i < 100; ++i) {
+    sc_string_builder_putn (sb, "0123456789", 10);
+  }
+  if (sc_string_builder_drain (sb, sink) || sc_io_sink_destroy (sink) ||
+      buffer->elem_count != 1200 || sc_string_builder_length (sb) != 0 ||
+      memcmp (buffer->array + 200, "0123456789", 10) ||
+      memcmp (buffer->array + 1190, "0123456789", 10)) {
+    SC_LERROR ("Drained content mismatch\n");
+    ++num_failed;
+  }
+  sc_array_destroy (buffer);
+  sc_string_builder_destroy (sb);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
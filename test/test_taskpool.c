@@ -0,0 +1,163 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_taskpool.h>
+
+#define TEST_TP_N 100000
+
+/* count visits of every index */
+static void
+test_taskpool_body (size_t begin, size_t end, void *user)
+{
+  size_t              i;
+  char               *visits = (char *) user;
+
+  for (i = begin; i < end; ++i) {
+    ++visits[i];
+  }
+}
+
+typedef struct test_fib
+{
+  sc_taskpool_t      *pool;
+  int                 n;
+  long                result;
+}
+test_fib_t;
+
+/* nested task groups: compute Fibonacci numbers recursively */
+static void
+test_taskpool_fib (void *data)
+{
+  test_fib_t         *f = (test_fib_t *) data;
+  test_fib_t          a, b;
+  sc_taskgroup_t      group;
+
+  if (f->n < 2) {
+    f->result = f->n;
+    return;
+  }
+  a.pool = b.pool = f->pool;
+  a.n = f->n - 1;
+  b.n = f->n - 2;
+  sc_taskgroup_init (&group, f->pool);
+  sc_taskgroup_spawn (&group, test_taskpool_fib, &a);
+  test_taskpool_fib (&b);
+  sc_taskgroup_wait (&group);
+  f->result = a.result + b.result;
+}
+
+typedef struct test_nested
+{
+  sc_taskpool_t      *pool;
+  char               *visits;
+}
+test_nested_t;
+
+/* every outer iteration runs an inner parallel loop */
+static void
+test_taskpool_outer (size_t begin, size_t end, void *user)
+{
+  size_t              i;
+  test_nested_t      *nest = (test_nested_t *) user;
+
+  for (i = begin; i < end; ++i) {
+    sc_taskpool_parallel_for (nest->pool, i * 1000, (i + 1) * 1000, 16,
+                              test_taskpool_body, nest->visits);
+  }
+}
+
+static int
+test_taskpool (sc_taskpool_t * pool)
+{
+  int                 num_failed = 0;
+  size_t              i;
+  char               *visits;
+  test_fib_t          fib;
+  test_nested_t       nest;
+
+  visits = SC_ALLOC_ZERO (char, TEST_TP_N);
+  sc_taskpool_parallel_for (pool, 0, TEST_TP_N, 100,
+                            test_taskpool_body, visits);
+  sc_taskpool_parallel_for (pool, 7, 7, 100, test_taskpool_body, visits);
+  sc_taskpool_parallel_for (pool, 0, 5, 0, test_taskpool_body, visits);
+  for (i = 0; i < TEST_TP_N; ++i) {
+    num_failed += visits[i] != (i < 5 ? 2 : 1);
+  }
+
+  nest.pool = pool;
+  nest.visits = visits;
+  sc_taskpool_parallel_for (pool, 0, TEST_TP_N / 1000, 1,
+                            test_taskpool_outer, &nest);
+  for (i = 0; i < TEST_TP_N; ++i) {
+    num_failed += visits[i] != (i < 5 ? 3 : 2);
+  }
+  SC_FREE (visits);
+
+  fib.pool = pool;
+  fib.n = 22;
+  test_taskpool_fib (&fib);
+  num_failed += fib.result != 17711;
+
+  if (num_failed) {
+    SC_LERRORF ("Task pool with %d threads failed %d checks\n",
+                sc_taskpool_num_threads (pool), num_failed);
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+  sc_taskpool_t      *pool;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* without a pool the tasks run in the calling thread */
+  num_failed += test_taskpool (sc_taskpool_default ());
+
+  pool = sc_taskpool_new (3, -1);
+  num_failed += test_taskpool (pool);
+  sc_taskpool_destroy (pool);
+
+  /* the default pool may already run if SC_TASKPOOL_THREADS is set */
+  if (sc_taskpool_default () == NULL && !sc_taskpool_start (2, -1)) {
+    num_failed += sc_taskpool_num_threads (NULL) != 2;
+  }
+  num_failed += test_taskpool (NULL);
+  sc_taskpool_stop ();
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_allgather.h>
+#include <sc_tracer.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/** Count the occurrences of a string in a buffer. */
+static int
+test_count (const char *buffer, const char *pattern)
+{
+  int                 count = 0;
+
+  while ((buffer = strstr (buffer, pattern)) != NULL) {
+    ++count;
+    ++buffer;
+  }
+  return count;
+}
+
+/** Record regions and collectives and check the balance of the output. */
+static int
+test_trace (sc_MPI_Comm mpicomm, size_t max_events, int num_regions)
+{
+  int                 mpiret;
+  int                 rank, size;
+  int                 i, num_begin, num_end, num_threads = 1;
+  int                *data;
+  long                dropped;
+  sc_array_t          buffer;
+  sc_io_sink_t       *sink;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+
+#ifdef SC_ENABLE_OPENMP
+  num_threads = omp_get_max_threads ();
+#endif
+  sc_tracer_start (max_events);
+  data = SC_ALLOC (int, size);
+  data[rank] = rank;
+  sc_allgather (data + rank, 1, sc_MPI_INT, data, 1, sc_MPI_INT, mpicomm);
+  SC_FREE (data);
+
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel private (i)
+#endif
+  {
+    for (i = 0; i < num_regions; ++i) {
+      sc_tracer_begin ("outer");
+      sc_tracer_begin ("inner");
+      sc_tracer_end ("inner");
+      sc_tracer_end ("outer");
+    }
+  }
+
+  /* write the trace into a buffer */
+  sc_array_init (&buffer, 1);
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, &buffer);
+  SC_CHECK_ABORT (sink != NULL, "Tracer sink");
+  SC_CHECK_ABORT (!sc_tracer_write (sink, rank), "Tracer write");
+  SC_CHECK_ABORT (!sc_io_sink_destroy (sink), "Tracer sink destroy");
+  *(char *) sc_array_push (&buffer) = '\0';
+  dropped = sc_tracer_dropped ();
+  sc_tracer_stop ();
+
+  num_begin = test_count (buffer.array, "\"ph\":\"B\"");
+  num_end = test_count (buffer.array, "\"ph\":\"E\"");
+  i = test_count (buffer.array, "\"name\":\"sc_allgather\"") != 2 ||
+    strncmp (buffer.array, "{\"traceEvents\":[", 16);
+  sc_array_reset (&buffer);
+  if (max_events == 0) {
+    max_events = SC_TRACER_EVENTS;
+  }
+  if (num_begin != num_end || i) {
+    SC_LERRORF ("Unbalanced trace: %d begin, %d end\n", num_begin, num_end);
+    return 1;
+  }
+  if ((size_t) (num_begin + num_end) > max_events * num_threads ||
+      (dropped > 0) != (max_events < (size_t) (4 * num_regions + 2))) {
+    SC_LERRORF ("Trace bound: %d events, %ld dropped\n",
+                num_begin + num_end, dropped);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed_tests = 0;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* the inactive tracer records nothing */
+  sc_tracer_begin ("inactive");
+  sc_tracer_end ("inactive");
+  if (sc_tracer_is_active () || sc_tracer_dropped () != 0) {
+    SC_LERROR ("Tracer active without start\n");
+    ++num_failed_tests;
+  }
+
+  num_failed_tests += test_trace (mpicomm, 0, 100);
+  num_failed_tests += test_trace (mpicomm, 50, 100);
+  num_failed_tests += test_trace (mpicomm, 402, 100);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
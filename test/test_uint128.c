@@ -0,0 +1,152 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_uint128.h>
+
+static              uint64_t
+test_rand64 (void)
+{
+  return (uint64_t) rand () << 42 ^ (uint64_t) rand () << 21 ^
+    (uint64_t) rand ();
+}
+
+/** Check the arithmetic against identities and the bit operations. */
+static void
+test_arithmetic (int num_rounds)
+{
+  int                 i, s, cmp;
+  sc_uint128_t        a, b, c, d, one;
+
+  sc_uint128_init (&one, 0, 1);
+  for (i = 0; i < num_rounds; ++i) {
+    sc_uint128_init (&a, test_rand64 (), test_rand64 ());
+    sc_uint128_init (&b, i % 3 ? test_rand64 () : a.high_bits,
+                     i % 5 ? test_rand64 () : ~(uint64_t) 0);
+
+    /* addition and subtraction invert each other */
+    sc_uint128_add (&a, &b, &c);
+    sc_uint128_sub (&c, &b, &d);
+    SC_CHECK_ABORT (sc_uint128_is_equal (&a, &d), "Add and subtract");
+    d = a;
+    sc_uint128_add_inplace (&d, &b);
+    SC_CHECK_ABORT (sc_uint128_is_equal (&c, &d), "Add inplace");
+    sc_uint128_sub_inplace (&d, &a);
+    SC_CHECK_ABORT (sc_uint128_is_equal (&b, &d), "Subtract inplace");
+
+    /* the carry propagates to the high bits */
+    sc_uint128_init (&c, a.high_bits, ~(uint64_t) 0);
+    sc_uint128_add (&c, &one, &d);
+    SC_CHECK_ABORT (d.high_bits == a.high_bits + 1 && d.low_bits == 0,
+                    "Carry");
+
+    /* comparison agrees with subtraction */
+    cmp = sc_uint128_compare (&a, &b);
+    SC_CHECK_ABORT (cmp == -sc_uint128_compare (&b, &a), "Antisymmetry");
+    SC_CHECK_ABORT ((cmp < 0) == sc_uint128_is_less (&a, &b), "Less");
+    SC_CHECK_ABORT ((cmp == 0) == sc_uint128_is_equal (&a, &b), "Equal");
+    SC_CHECK_ABORT (cmp == (a.high_bits != b.high_bits ?
+                            (a.high_bits < b.high_bits ? -1 : 1) :
+                            a.low_bits != b.low_bits ?
+                            (a.low_bits < b.low_bits ? -1 : 1) : 0),
+                    "Compare");
+
+    /* shifts agree with single bits */
+    s = i % 130;
+    sc_uint128_shift_left (&a, s, &c);
+    sc_uint128_shift_right (&c, s, &d);
+    sc_uint128_shift_right (&a, s, &b);
+    for (cmp = 0; cmp < 128; ++cmp) {
+      SC_CHECK_ABORT (sc_uint128_chk_bit (&c, cmp) ==
+                      (cmp >= s && sc_uint128_chk_bit (&a, cmp - s)),
+                      "Shift left");
+      SC_CHECK_ABORT (sc_uint128_chk_bit (&d, cmp) ==
+                      (cmp < 128 - s && sc_uint128_chk_bit (&a, cmp)),
+                      "Shift round trip");
+      SC_CHECK_ABORT (sc_uint128_chk_bit (&b, cmp) ==
+                      (cmp + s < 128 && sc_uint128_chk_bit (&a, cmp + s)),
+                      "Shift right");
+    }
+  }
+}
+
+/** Compare the Morton encoding with bit by bit interleaving. */
+static void
+test_morton (int dim, size_t n)
+{
+  const int           bits = SC_MIN (64, 128 / dim);
+  int                 b, d;
+  size_t              zz;
+  uint64_t           *coords, *decoded, mask;
+  sc_uint128_t       *keys;
+
+  mask = bits >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << bits) - 1;
+  coords = SC_ALLOC (uint64_t, n * dim);
+  decoded = SC_ALLOC (uint64_t, n * dim);
+  keys = SC_ALLOC (sc_uint128_t, n);
+  for (zz = 0; zz < n * dim; ++zz) {
+    coords[zz] = test_rand64 () & mask;
+  }
+  sc_uint128_morton_encode (dim, bits, n, coords, keys);
+  sc_uint128_morton_decode (dim, bits, n, keys, decoded);
+  for (zz = 0; zz < n; ++zz) {
+    for (d = 0; d < dim; ++d) {
+      SC_CHECK_ABORT (coords[zz * dim + d] == decoded[zz * dim + d],
+                      "Morton round trip");
+      for (b = 0; b < bits; ++b) {
+        SC_CHECK_ABORT (sc_uint128_chk_bit (keys + zz, b * dim + d) ==
+                        (int) ((coords[zz * dim + d] >> b) & 1),
+                        "Morton bit");
+      }
+    }
+  }
+  SC_FREE (keys);
+  SC_FREE (decoded);
+  SC_FREE (coords);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 dim;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#ifdef SC_UINT128_NATIVE
+  SC_GLOBAL_INFO ("Using native 128 bit integers\n");
+#endif
+  test_arithmetic (1000);
+  for (dim = 1; dim <= 5; ++dim) {
+    test_morton (dim, 100);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_unique_counter.h>
+#include <sc_random.h>
+
+#define TEST_UC_THREADS 4
+#define TEST_UC_HELD 3000
+#define TEST_UC_ITER 20000
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0;
+  int                 mpiret;
+  int                 t;
+  size_t              zz, total;
+  int                *held[TEST_UC_THREADS], num_held[TEST_UC_THREADS];
+  sc_array_t         *all;
+  sc_unique_counter_mt_t *uc;
+  sc_unique_counter_cache_t caches[TEST_UC_THREADS];
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  uc = sc_unique_counter_mt_new (-5);
+  for (t = 0; t < TEST_UC_THREADS; ++t) {
+    held[t] = SC_ALLOC (int, TEST_UC_HELD);
+    num_held[t] = 0;
+  }
+
+  /* every thread adds and releases values in random order */
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel for num_threads (TEST_UC_THREADS) schedule (static, 1)
+#endif
+  for (t = 0; t < TEST_UC_THREADS; ++t) {
+    int                 i, j;
+    sc_rand_state_t     state = (sc_rand_state_t) t;
+
+    sc_unique_counter_cache_init (&caches[t], uc);
+    for (i = 0; i < TEST_UC_ITER; ++i) {
+      if (num_held[t] < TEST_UC_HELD && sc_rand (&state) < .6) {
+        held[t][num_held[t]++] = sc_unique_counter_cache_add (&caches[t]);
+      }
+      else if (num_held[t] > 0) {
+        j = (int) (sc_rand (&state) * num_held[t]);
+        sc_unique_counter_cache_release (&caches[t], held[t][j]);
+        held[t][j] = held[t][--num_held[t]];
+      }
+    }
+  }
+
+  /* the values held at the same time are distinct */
+  all = sc_array_new (sizeof (int));
+  for (t = 0; t < TEST_UC_THREADS; ++t) {
+    memcpy (sc_array_push_count (all, num_held[t]), held[t],
+            num_held[t] * sizeof (int));
+  }
+  total = all->elem_count;
+  sc_array_sort (all, sc_int_compare);
+  sc_array_uniq (all, sc_int_compare);
+  num_failed += all->elem_count != total;
+  for (zz = 0; zz < all->elem_count; ++zz) {
+    num_failed += *(int *) sc_array_index (all, zz) < -5;
+  }
+  sc_array_destroy (all);
+
+  /* released values are reused, so the range stays compact */
+  SC_GLOBAL_INFOF ("Holding %d values, the factory uses %llu bytes\n",
+                   (int) total, (unsigned long long)
+                   sc_unique_counter_mt_memory_used (uc));
+
+  /* values may be released by other threads than the one adding them */
+#ifdef SC_ENABLE_OPENMP
+#pragma omp parallel for num_threads (TEST_UC_THREADS) schedule (static, 1)
+#endif
+  for (t = 0; t < TEST_UC_THREADS; ++t) {
+    int                 i;
+    const int           o = (t + 1) % TEST_UC_THREADS;
+
+    for (i = 0; i < num_held[o]; ++i) {
+      sc_unique_counter_cache_release (&caches[t], held[o][i]);
+    }
+  }
+  for (t = 0; t < TEST_UC_THREADS; ++t) {
+    sc_unique_counter_cache_reset (&caches[t]);
+    SC_FREE (held[t]);
+  }
+
+  /* a new cache reuses the smallest values first */
+  sc_unique_counter_cache_init (&caches[0], uc);
+  t = sc_unique_counter_cache_add (&caches[0]);
+  num_failed += t > -5 + 63;
+  sc_unique_counter_cache_release (&caches[0], t);
+  sc_unique_counter_cache_reset (&caches[0]);
+  sc_unique_counter_mt_destroy (uc);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
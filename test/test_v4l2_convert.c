@@ -0,0 +1,136 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_v4l2.h>
+
+#define TEST_V4L2_WIDTH 6
+#define TEST_V4L2_HEIGHT 3
+#define TEST_V4L2_STRIDE 8
+#define TEST_V4L2_BPL 16
+
+/* luma of a gray level in BT.601 limited range */
+static int
+test_v4l2_luma (int v)
+{
+  return 16 + ((220 * v + 128) >> 8);
+}
+
+static int
+test_v4l2_convert (sc_v4l2_pixel_t pixel, int num_threads)
+{
+  int                 i, j, v, failed = 0;
+  unsigned char       image[TEST_V4L2_HEIGHT * TEST_V4L2_BPL];
+  float               field[TEST_V4L2_HEIGHT * TEST_V4L2_STRIDE];
+  const unsigned char gray[2][3] = { {0, 0, 0}, {255, 255, 255} };
+  sc_v4l2_colormap_t  cmap;
+
+  /* with a linear gray map, entry i has all components i */
+  sc_v4l2_colormap_init (&cmap, 2, gray);
+
+  for (j = 0; j < TEST_V4L2_HEIGHT; ++j) {
+    for (i = 0; i < TEST_V4L2_STRIDE; ++i) {
+      field[j * TEST_V4L2_STRIDE + i] = (float) (j * 100 + i * 20);
+    }
+  }
+  field[1] = -1e30f;
+  field[2] = 1e30f;
+  field[3] = (float) sqrt (-1.);
+  memset (image, 0xAB, sizeof (image));
+
+  /* map [0, 255] onto the colormap, so most values are their own entry */
+  sc_v4l2_convert_field (pixel, TEST_V4L2_WIDTH, TEST_V4L2_HEIGHT, field,
+                         TEST_V4L2_STRIDE, 0.f, 255.f, &cmap,
+                         (char *) image, TEST_V4L2_BPL, num_threads);
+
+  for (j = 0; j < TEST_V4L2_HEIGHT; ++j) {
+    const unsigned char *row = image + j * TEST_V4L2_BPL;
+
+    for (i = 0; i < TEST_V4L2_WIDTH; ++i) {
+      if (j == 0 && i >= 1 && i <= 3) {
+        /* huge negative, huge positive, and NaN */
+        v = i == 2 ? 255 : 0;
+      }
+      else {
+        v = SC_MIN (j * 100 + i * 20, 255);
+      }
+      if (pixel == SC_V4L2_PIXEL_RGB565) {
+        uint16_t            expect, got;
+
+        expect = (uint16_t) (((v >> 3) << 11) | ((v >> 2) << 5) | (v >> 3));
+        memcpy (&got, row + 2 * i, 2);
+        failed += got != expect;
+      }
+      else {
+        failed += row[2 * i] != test_v4l2_luma (v);
+        failed += row[2 * i + 1] != 128;
+      }
+    }
+
+    /* the padding of each line is untouched */
+    for (i = 2 * TEST_V4L2_WIDTH; i < TEST_V4L2_BPL; ++i) {
+      failed += row[i] != 0xAB;
+    }
+  }
+  if (failed) {
+    SC_LERRORF ("Conversion mismatch for pixel format %d\n", (int) pixel);
+  }
+  return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_failed = 0;
+  sc_v4l2_colormap_t  cmap;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* the default map runs from blue over light gray to red */
+  sc_v4l2_colormap_init (&cmap, 0, NULL);
+  if (cmap.rgb[0][2] <= cmap.rgb[0][0] || cmap.rgb[255][0] <=
+      cmap.rgb[255][2] || cmap.rgb[128][0] < 0xD0 ||
+      cmap.rgb[128][1] < 0xD0 || cmap.rgb[128][2] < 0xD0) {
+    SC_LERROR ("Default colormap mismatch\n");
+    ++num_failed;
+  }
+
+  num_failed += test_v4l2_convert (SC_V4L2_PIXEL_RGB565, 1);
+  num_failed += test_v4l2_convert (SC_V4L2_PIXEL_RGB565, 3);
+  num_failed += test_v4l2_convert (SC_V4L2_PIXEL_YUYV, 1);
+  num_failed += test_v4l2_convert (SC_V4L2_PIXEL_YUYV, 2);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_io.h>
+#include <libb64.h>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define TEST_VTK_BYTES 1000003
+
+#ifdef SC_HAVE_ZLIB
+
+/* decode a VTK compressed data array and compare with the original */
+static int
+test_vtk_check (const char *code, size_t code_length,
+                const char *data, size_t byte_length, size_t blocksize)
+{
+  int                 retval;
+  size_t              iz, num_blocks, header_size, header_code;
+  size_t              decoded, pos, comp_pos;
+  uLongf              plain_length;
+  uint32_t           *header;
+  char               *plain, *comp;
+  base64_encodestate  es;
+  base64_decodestate  ds;
+
+  /* the header is encoded on its own and its length is known */
+  num_blocks = (byte_length + blocksize - 1) / blocksize;
+  header_size = (3 + num_blocks) * sizeof (uint32_t);
+  header = SC_ALLOC_ZERO (uint32_t, 3 + num_blocks);
+  plain = SC_ALLOC (char, SC_MAX (blocksize, 2 * header_size + 5));
+  base64_init_encodestate (&es);
+  header_code = base64_encode_block ((char *) header, header_size, plain,
+                                     &es);
+  header_code += base64_encode_blockend (plain + header_code, &es);
+  SC_CHECK_ABORT (header_code <= code_length, "Header length");
+
+  base64_init_decodestate (&ds);
+  decoded = base64_decode_block (code, header_code, plain, &ds);
+  memcpy (header, plain, SC_MIN (decoded, header_size));
+  if (decoded != header_size || header[0] != (uint32_t) num_blocks ||
+      header[1] != (uint32_t) blocksize) {
+    SC_LERROR ("VTK header mismatch\n");
+    SC_FREE (header);
+    SC_FREE (plain);
+    return 1;
+  }
+
+  /* decode the compressed blocks and inflate them one by one */
+  comp = SC_ALLOC (char, code_length);
+  base64_init_decodestate (&ds);
+  decoded = base64_decode_block (code + header_code,
+                                 code_length - header_code, comp, &ds);
+  retval = 0;
+  for (iz = 0, pos = 0, comp_pos = 0; iz < num_blocks; ++iz) {
+    plain_length = (uLongf) blocksize;
+    if (comp_pos + header[3 + iz] > decoded ||
+        uncompress ((Bytef *) plain, &plain_length,
+                    (const Bytef *) comp + comp_pos,
+                    (uLong) header[3 + iz]) != Z_OK ||
+        plain_length != SC_MIN (blocksize, byte_length - pos) ||
+        memcmp (plain, data + pos, plain_length)) {
+      retval = 1;
+      break;
+    }
+    comp_pos += header[3 + iz];
+    pos += plain_length;
+  }
+  if (retval || pos != byte_length || comp_pos != decoded) {
+    SC_LERRORF ("VTK data mismatch at block %ld\n", (long) iz);
+    retval = 1;
+  }
+  SC_FREE (comp);
+  SC_FREE (header);
+  SC_FREE (plain);
+  return retval;
+}
+
+/* write compressed data to a file and return its contents */
+static char        *
+test_vtk_write (const char *data, size_t byte_length, int level,
+                size_t blocksize, size_t * code_length)
+{
+  int                 retval;
+  long                length;
+  char               *code;
+  FILE               *file;
+
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "Temporary file");
+  if (level == Z_BEST_COMPRESSION && blocksize == 0) {
+    retval = sc_vtk_write_compressed (file, (char *) data, byte_length);
+  }
+  else {
+    retval = sc_vtk_write_compressed_ext (file, (char *) data, byte_length,
+                                          level, blocksize);
+  }
+  SC_CHECK_ABORT (retval == 0, "VTK write");
+  length = ftell (file);
+  SC_CHECK_ABORT (length > 0, "VTK file length");
+  rewind (file);
+  code = SC_ALLOC (char, length);
+  sc_fread (code, 1, (size_t) length, file, "VTK read");
+  fclose (file);
+  *code_length = (size_t) length;
+  return code;
+}
+
+/* the sink functions write the same code as the file functions */
+static int
+test_vtk_sink (const char *data, size_t byte_length, int compressed)
+{
+  int                 retval;
+  long                length;
+  char               *code;
+  sc_array_t         *buffer;
+  sc_io_sink_t       *sink;
+  FILE               *file;
+
+  buffer = sc_array_new (sizeof (char));
+  sink = sc_io_sink_new (SC_IO_TYPE_BUFFER, SC_IO_MODE_WRITE,
+                         SC_IO_ENCODE_NONE, buffer);
+  SC_CHECK_ABORT (sink != NULL, "Sink create");
+  file = tmpfile ();
+  SC_CHECK_ABORT (file != NULL, "Temporary file");
+  if (compressed) {
+    retval = sc_vtk_write_compressed_sink (sink, data, byte_length, 1, 5000);
+    retval = retval || sc_vtk_write_compressed_ext
+      (file, (char *) data, byte_length, 1, 5000);
+  }
+  else {
+    retval = sc_vtk_write_binary_sink (sink, data, byte_length);
+    retval = retval || sc_vtk_write_binary (file, (char *) data,
+                                            byte_length);
+  }
+  retval = sc_io_sink_destroy (sink) || retval;
+  SC_CHECK_ABORT (retval == 0, "VTK write");
+
+  length = ftell (file);
+  rewind (file);
+  code = SC_ALLOC (char, length + 1);
+  sc_fread (code, 1, (size_t) length, file, "VTK read");
+  fclose (file);
+  retval = length != (long) buffer->elem_count ||
+    memcmp (code, buffer->array, (size_t) length) != 0;
+  if (retval) {
+    SC_LERRORF ("VTK sink mismatch for %s data\n",
+                compressed ? "compressed" : "binary");
+  }
+  SC_FREE (code);
+  sc_array_destroy (buffer);
+  return retval;
+}
+
+static int
+test_vtk (const char *data)
+{
+  int                 failed = 0;
+  int                 i;
+  size_t              code_length, ref_length;
+  size_t              byte_length;
+  char               *code, *ref;
+  const int           levels[4] = { 9, 1, -1, 0 };
+  const size_t        blocksizes[4] = { 0, 1 << 12, 1 << 20, 3000 };
+
+  for (i = 0; i < 4; ++i) {
+    byte_length = TEST_VTK_BYTES >> (i % 2);
+    code = test_vtk_write (data, byte_length, levels[i], blocksizes[i],
+                           &code_length);
+    SC_INFOF ("VTK level %d block %ld compresses %ld to %ld bytes\n",
+              levels[i], (long) blocksizes[i], (long) byte_length,
+              (long) code_length);
+    failed |= test_vtk_check (code, code_length, data, byte_length,
+                              blocksizes[i] ? blocksizes[i] : 1 << 15);
+    SC_FREE (code);
+  }
+
+  /* the defaults reproduce the original function exactly */
+  ref = test_vtk_write (data, TEST_VTK_BYTES, 9, 0, &ref_length);
+  code = test_vtk_write (data, TEST_VTK_BYTES, 9, 1 << 15, &code_length);
+  if (ref_length != code_length || memcmp (ref, code, code_length)) {
+    SC_LERROR ("VTK default mismatch\n");
+    failed = 1;
+  }
+  SC_FREE (ref);
+  SC_FREE (code);
+
+  failed |= test_vtk_sink (data, TEST_VTK_BYTES, 0);
+  failed |= test_vtk_sink (data, TEST_VTK_BYTES, 1);
+  failed |= test_vtk_sink (data, 0, 1);
+
+  /* empty data */
+  code = test_vtk_write (data, 0, 1, 0, &code_length);
+  failed |= test_vtk_check (code, code_length, data, 0, 1 << 15);
+  SC_FREE (code);
+
+  return failed;
+}
+
+#endif /* SC_HAVE_ZLIB */
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 failed = 0;
+  size_t              zz;
+  char               *data;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  /* compressible data that is not periodic in the block size */
+  data = SC_ALLOC (char, TEST_VTK_BYTES);
+  for (zz = 0; zz < TEST_VTK_BYTES; ++zz) {
+    data[zz] = (char) ((zz % 61) ^ (zz / 4093) ^ (zz * zz % 7));
+  }
+
+#ifdef SC_HAVE_ZLIB
+  if (sc_is_root ()) {
+    failed = test_vtk (data);
+  }
+#else
+  SC_GLOBAL_INFO ("Configure did not find zlib; skipping test\n");
+#endif
+  SC_FREE (data);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,302 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+
+#include <sc_vtu.h>
+#include <libb64.h>
+
+#define TEST_VTU_PREFIX "sc_test_vtu"
+
+/** A strip of quadrilaterals whose length depends on the rank. */
+typedef struct test_vtu_grid
+{
+  size_t              num_points, num_cells;
+  double             *xyz, *height;
+  int64_t            *connectivity, *offsets;
+  uint8_t            *types;
+  int32_t            *owner;
+}
+test_vtu_grid_t;
+
+static void
+test_vtu_grid_init (test_vtu_grid_t * g, int rank)
+{
+  size_t              zz;
+
+  g->num_cells = (size_t) (rank % 3 + 1);
+  g->num_points = 2 * (g->num_cells + 1);
+  g->xyz = SC_ALLOC (double, 3 * g->num_points);
+  g->height = SC_ALLOC (double, g->num_points);
+  for (zz = 0; zz < g->num_points; ++zz) {
+    g->xyz[3 * zz] = (double) (zz / 2);
+    g->xyz[3 * zz + 1] = (double) (zz % 2);
+    g->xyz[3 * zz + 2] = (double) rank;
+    g->height[zz] = .5 * zz + rank;
+  }
+  g->connectivity = SC_ALLOC (int64_t, 4 * g->num_cells);
+  g->offsets = SC_ALLOC (int64_t, g->num_cells);
+  g->types = SC_ALLOC (uint8_t, g->num_cells);
+  g->owner = SC_ALLOC (int32_t, g->num_cells);
+  for (zz = 0; zz < g->num_cells; ++zz) {
+    g->connectivity[4 * zz] = (int64_t) (2 * zz);
+    g->connectivity[4 * zz + 1] = (int64_t) (2 * zz + 2);
+    g->connectivity[4 * zz + 2] = (int64_t) (2 * zz + 3);
+    g->connectivity[4 * zz + 3] = (int64_t) (2 * zz + 1);
+    g->offsets[zz] = (int64_t) (4 * (zz + 1));
+    g->types[zz] = 9;
+    g->owner[zz] = rank;
+  }
+}
+
+static void
+test_vtu_grid_reset (test_vtu_grid_t * g)
+{
+  SC_FREE (g->xyz);
+  SC_FREE (g->height);
+  SC_FREE (g->connectivity);
+  SC_FREE (g->offsets);
+  SC_FREE (g->types);
+  SC_FREE (g->owner);
+}
+
+/** Read a whole file into a nul-terminated string. */
+static char        *
+test_vtu_slurp (const char *filename, size_t *length)
+{
+  long                size;
+  char               *text;
+  FILE               *file;
+
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORT (file != NULL, "Open written file");
+  SC_CHECK_ABORT (!fseek (file, 0, SEEK_END) && (size = ftell (file)) >= 0,
+                  "Size of written file");
+  rewind (file);
+  text = SC_ALLOC (char, size + 1);
+  SC_CHECK_ABORT (fread (text, 1, (size_t) size, file) == (size_t) size,
+                  "Read written file");
+  text[size] = '\0';
+  SC_CHECK_ABORT (!fclose (file), "Close written file");
+  *length = (size_t) size;
+  return text;
+}
+
+/** Compare the data of a named array with the expected bytes. */
+static int
+test_vtu_check_array (const char *text, size_t length,
+                      sc_vtu_format_t format, const char *name,
+                      const void *expected, size_t bytes)
+{
+  char                pattern[BUFSIZ];
+  const char         *tag, *appended, *code;
+  char               *plain;
+  uint32_t            header;
+  unsigned long long  offset;
+  size_t              code_length;
+  base64_decodestate  state;
+  int                 num_failed = 0;
+
+  snprintf (pattern, BUFSIZ, "Name=\"%s\"", name);
+  if ((tag = strstr (text, pattern)) == NULL) {
+    return 1;
+  }
+  if (format == SC_VTU_FORMAT_APPENDED) {
+    /* the offset counts from the character after the underscore */
+    appended = strstr (text, "<AppendedData encoding=\"raw\">\n_");
+    if (appended == NULL || (tag = strstr (tag, "offset=\"")) == NULL ||
+        sscanf (tag, "offset=\"%llu\"", &offset) != 1) {
+      return 1;
+    }
+    appended += strlen ("<AppendedData encoding=\"raw\">\n_") + offset;
+    if ((size_t) (appended - text) + sizeof (header) + bytes > length) {
+      return 1;
+    }
+    memcpy (&header, appended, sizeof (header));
+    num_failed += header != (uint32_t) bytes;
+    num_failed += memcmp (appended + sizeof (header), expected, bytes) != 0;
+  }
+  else {
+    if ((code = strchr (tag, '>')) == NULL) {
+      return 1;
+    }
+    code += strspn (code + 1, " \n") + 1;
+    code_length = strcspn (code, "\n<");
+    plain = SC_ALLOC (char, code_length + 4);
+    base64_init_decodestate (&state);
+    num_failed += base64_decode_block (code, code_length, plain, &state) !=
+      sizeof (header) + bytes;
+    memcpy (&header, plain, sizeof (header));
+    num_failed += header != (uint32_t) bytes;
+    num_failed += memcmp (plain + sizeof (header), expected, bytes) != 0;
+    SC_FREE (plain);
+  }
+  return num_failed;
+}
+
+static int
+test_vtu_format (sc_MPI_Comm mpicomm, sc_vtu_format_t format)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank, size, q;
+  char                filename[BUFSIZ], pattern[BUFSIZ];
+  char               *text;
+  size_t              length;
+  test_vtu_grid_t     grid;
+  sc_vtu_t           *vtu;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (mpicomm, &size);
+  SC_CHECK_MPI (mpiret);
+  test_vtu_grid_init (&grid, rank);
+
+  vtu = sc_vtu_open (mpicomm, TEST_VTU_PREFIX, format,
+                     grid.num_points, grid.num_cells);
+  SC_CHECK_ABORT (vtu != NULL, "Open VTU piece");
+  num_failed += sc_vtu_write_points (vtu, grid.xyz) != 0;
+  num_failed += sc_vtu_write_cells (vtu, grid.connectivity, grid.offsets,
+                                    grid.types) != 0;
+  num_failed += sc_vtu_write_data (vtu, 0, "height", SC_VTU_FLOAT64, 1,
+                                   grid.height) != 0;
+  num_failed += sc_vtu_write_data (vtu, 1, "owner", SC_VTU_INT32, 1,
+                                   grid.owner) != 0;
+
+  /* point data after cell data is rejected */
+  num_failed += sc_vtu_write_data (vtu, 0, "late", SC_VTU_FLOAT64, 1,
+                                   grid.height) == 0;
+  num_failed += sc_vtu_close (vtu) != 0;
+
+  /* every rank checks its piece */
+  snprintf (filename, BUFSIZ, "%s_%04d.vtu", TEST_VTU_PREFIX, rank);
+  text = test_vtu_slurp (filename, &length);
+  snprintf (pattern, BUFSIZ, "<Piece NumberOfPoints=\"%llu\" "
+            "NumberOfCells=\"%llu\">", (unsigned long long) grid.num_points,
+            (unsigned long long) grid.num_cells);
+  num_failed += strstr (text, pattern) == NULL;
+  num_failed += strstr (text, "late") != NULL;
+  num_failed += (strstr (text, "vtkZLibDataCompressor") != NULL) !=
+    (format == SC_VTU_FORMAT_COMPRESSED);
+  if (format != SC_VTU_FORMAT_COMPRESSED) {
+    num_failed += test_vtu_check_array
+      (text, length, format, "Position", grid.xyz,
+       3 * grid.num_points * sizeof (double));
+    num_failed += test_vtu_check_array
+      (text, length, format, "connectivity", grid.connectivity,
+       4 * grid.num_cells * sizeof (int64_t));
+    num_failed += test_vtu_check_array
+      (text, length, format, "types", grid.types, grid.num_cells);
+    num_failed += test_vtu_check_array
+      (text, length, format, "height", grid.height,
+       grid.num_points * sizeof (double));
+    num_failed += test_vtu_check_array
+      (text, length, format, "owner", grid.owner,
+       grid.num_cells * sizeof (int32_t));
+  }
+  SC_FREE (text);
+  mpiret = sc_MPI_Barrier (mpicomm);
+  SC_CHECK_MPI (mpiret);
+  num_failed += remove (filename) != 0;
+
+  /* the first rank checks the index */
+  if (rank == 0) {
+    text = test_vtu_slurp (TEST_VTU_PREFIX ".pvtu", &length);
+    num_failed += strstr (text, "<PDataArray type=\"Float64\" "
+                          "Name=\"height\" NumberOfComponents=\"1\"/>") ==
+      NULL;
+    num_failed += strstr (text, "<PDataArray type=\"Int32\" "
+                          "Name=\"owner\" NumberOfComponents=\"1\"/>") ==
+      NULL;
+    for (q = 0; q < size; ++q) {
+      snprintf (pattern, BUFSIZ, "<Piece Source=\"%s_%04d.vtu\"/>",
+                TEST_VTU_PREFIX, q);
+      num_failed += strstr (text, pattern) == NULL;
+    }
+    SC_FREE (text);
+    num_failed += remove (TEST_VTU_PREFIX ".pvtu") != 0;
+  }
+
+  test_vtu_grid_reset (&grid);
+  return num_failed;
+}
+
+/** A piece without cells is an error on all ranks. */
+static int
+test_vtu_incomplete (sc_MPI_Comm mpicomm)
+{
+  int                 num_failed = 0;
+  int                 mpiret, rank;
+  char                filename[BUFSIZ];
+  double              xyz[3] = { 0., 0., 0. };
+  sc_vtu_t           *vtu;
+
+  mpiret = sc_MPI_Comm_rank (mpicomm, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  vtu = sc_vtu_open (mpicomm, TEST_VTU_PREFIX, SC_VTU_FORMAT_BINARY,
+                     1, 0);
+  SC_CHECK_ABORT (vtu != NULL, "Open VTU piece");
+  num_failed += sc_vtu_write_cells (vtu, NULL, NULL, NULL) == 0;
+  if (rank == 0) {
+    num_failed += sc_vtu_write_points (vtu, xyz) != 0;
+  }
+  num_failed += sc_vtu_close (vtu) == 0;
+
+  snprintf (filename, BUFSIZ, "%s_%04d.vtu", TEST_VTU_PREFIX, rank);
+  num_failed += remove (filename) != 0;
+  if (rank == 0) {
+    num_failed += remove (TEST_VTU_PREFIX ".pvtu") != 0;
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 num_failed = 0, num_failed_all;
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  num_failed += test_vtu_format (sc_MPI_COMM_WORLD, SC_VTU_FORMAT_BINARY);
+  num_failed += test_vtu_format (sc_MPI_COMM_WORLD, SC_VTU_FORMAT_APPENDED);
+#ifdef SC_HAVE_ZLIB
+  num_failed += test_vtu_format (sc_MPI_COMM_WORLD,
+                                 SC_VTU_FORMAT_COMPRESSED);
+#endif
+  num_failed += test_vtu_incomplete (sc_MPI_COMM_WORLD);
+
+  mpiret = sc_MPI_Allreduce (&num_failed, &num_failed_all, 1, sc_MPI_INT,
+                             sc_MPI_SUM, sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (num_failed_all) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed_all);
+  }
+
+  sc_finalize ();
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed_all ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_warp.h>
+
+/* collect the leaves of the pointer-based tree left to right */
+static void
+test_warp_collect (sc_warp_interval_t * iv, sc_array_t * leaves)
+{
+  if (iv->left == NULL) {
+    *(sc_warp_interval_t **) sc_array_push (leaves) = iv;
+  }
+  else {
+    test_warp_collect (iv->left, leaves);
+    test_warp_collect (iv->right, leaves);
+  }
+}
+
+static int
+test_warp_compare (sc_warp_interval_t * root, sc_warp_tree_t * tree)
+{
+  int                 i, level;
+  int                 num_failed = 0;
+  double              r_low, r_high;
+  sc_array_t         *leaves;
+  sc_warp_interval_t *iv;
+
+  leaves = sc_array_new (sizeof (sc_warp_interval_t *));
+  test_warp_collect (root, leaves);
+  if ((int) leaves->elem_count != sc_warp_tree_num_leaves (tree)) {
+    SC_LERRORF ("Leaf count mismatch %d %d\n", (int) leaves->elem_count,
+                sc_warp_tree_num_leaves (tree));
+    ++num_failed;
+  }
+  else {
+    for (i = 0; i < sc_warp_tree_num_leaves (tree); ++i) {
+      iv = *(sc_warp_interval_t **) sc_array_index_int (leaves, i);
+      sc_warp_tree_leaf (tree, i, &level, &r_low, &r_high);
+      if (iv->level != level || iv->r_low != r_low || iv->r_high != r_high) {
+        SC_LERRORF ("Leaf %d mismatch\n", i);
+        ++num_failed;
+      }
+    }
+  }
+  sc_array_destroy (leaves);
+  return num_failed;
+}
+
+static int
+test_warp_double (const void *v1, const void *v2)
+{
+  const double        d1 = *(const double *) v1;
+  const double        d2 = *(const double *) v2;
+
+  return d1 < d2 ? -1 : d1 > d2 ? 1 : 0;
+}
+
+/* check the located leaves against a linear scan */
+static int
+test_warp_locate (sc_warp_tree_t * tree, size_t num, const double *r)
+{
+  int                 i, n, expect;
+  int                 num_failed = 0;
+  int                *leaves;
+  size_t              iz;
+  double              r_low, r_high;
+
+  leaves = SC_ALLOC (int, num);
+  sc_warp_tree_locate (tree, num, r, leaves);
+  n = sc_warp_tree_num_leaves (tree);
+  for (iz = 0; iz < num; ++iz) {
+    expect = 0;
+    for (i = 1; i < n; ++i) {
+      sc_warp_tree_leaf (tree, i, NULL, &r_low, &r_high);
+      if (r_low <= r[iz]) {
+        expect = i;
+      }
+    }
+    if (leaves[iz] != expect) {
+      SC_LERRORF ("Locate %g gives %d not %d\n", r[iz], leaves[iz], expect);
+      ++num_failed;
+    }
+  }
+  SC_FREE (leaves);
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 round, i, num;
+  int                 num_failed = 0;
+  double              points[64], queries[256];
+  sc_warp_interval_t *root;
+  sc_warp_tree_t     *tree;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  srand (17);
+  root = sc_warp_new (-1., 2.);
+  tree = sc_warp_tree_new (-1., 2.);
+  num_failed += test_warp_compare (root, tree);
+  for (round = 0; round < 6; ++round) {
+    num = 1 + rand () % 64;
+    for (i = 0; i < num; ++i) {
+      points[i] = -1. + 3. * rand () / (double) RAND_MAX;
+    }
+    if (round == 3) {
+      /* reuse existing boundaries to test exact matches */
+      for (i = 0; i < num && i < sc_warp_tree_num_leaves (tree); ++i) {
+        sc_warp_tree_leaf (tree, i, NULL, &points[i], NULL);
+      }
+    }
+    qsort (points, num, sizeof (double), test_warp_double);
+    sc_warp_update (root, num, points, .1 * (round % 3), 4 + round);
+    sc_warp_tree_update (tree, num, points, .1 * (round % 3), 4 + round);
+    num_failed += test_warp_compare (root, tree);
+
+    for (i = 0; i < 256; ++i) {
+      queries[i] = -1.5 + 4. * rand () / (double) RAND_MAX;
+    }
+    num_failed += test_warp_locate (tree, 256, queries);
+    qsort (queries, 256, sizeof (double), test_warp_double);
+    num_failed += test_warp_locate (tree, 256, queries);
+  }
+  SC_GLOBAL_INFOF ("Final tree has %d leaves\n",
+                   sc_warp_tree_num_leaves (tree));
+  sc_warp_tree_print (sc_package_id, SC_LP_DEBUG, tree);
+
+  sc_warp_destroy (root);
+  sc_warp_tree_destroy (tree);
+
+  if (num_failed) {
+    SC_GLOBAL_LERRORF ("Test failed %d times\n", num_failed);
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}